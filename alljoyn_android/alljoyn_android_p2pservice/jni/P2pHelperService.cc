@@ -193,6 +193,7 @@ class P2pService : public BusObject {
 
         onFoundAdvertisedNameMember = p2pIntf->GetMember("OnFoundAdvertisedName");
         onLostAdvertisedNameMember = p2pIntf->GetMember("OnLostAdvertisedName");
+        onLostAdvertisedNamesMember = p2pIntf->GetMember("OnLostAdvertisedNames");
         onLinkEstablishedMember = p2pIntf->GetMember("OnLinkEstablished");
         onLinkErrorMember = p2pIntf->GetMember("OnLinkError");
         onLinkLostMember = p2pIntf->GetMember("OnLinkLost");
@@ -673,6 +674,24 @@ class P2pService : public BusObject {
         return static_cast<int>(status);
     }
 
+    int sendOnLostAdvertisedNames(size_t numNames, const char** names, const char** namePrefixes, const char** guids, const char* device) {
+        MsgArg* entries = new MsgArg[numNames];
+        for (size_t i = 0; i < numNames; ++i) {
+            entries[i].Set("(sss)", names[i], namePrefixes[i], guids[i]);
+        }
+        MsgArg args[2];
+        args[0].Set("a(sss)", numNames, entries);
+        args[1].Set("s", device);
+
+        LOGI("sendOnLostAdvertisedNames(%d names, %s)", static_cast<int>(numNames), device);
+        QStatus status = Signal(NULL, sessionId, *onLostAdvertisedNamesMember, args, 2, 0);
+        if (ER_OK != status) {
+            LOGE("sendOnLostAdvertisedNames: Error sending signal (%s)", QCC_StatusText(status));
+        }
+        delete [] entries;
+        return static_cast<int>(status);
+    }
+
     int sendOnLinkEstablished(int handle, const char*interfaceName) {
         MsgArg args[2];
         args[0].Set("i", handle);
@@ -727,6 +746,7 @@ class P2pService : public BusObject {
     const InterfaceDescription::Member* getInterfaceNameFromHandleMember;
     const InterfaceDescription::Member* onFoundAdvertisedNameMember;
     const InterfaceDescription::Member* onLostAdvertisedNameMember;
+    const InterfaceDescription::Member* onLostAdvertisedNamesMember;
     const InterfaceDescription::Member* onLinkEstablishedMember;
     const InterfaceDescription::Member* onLinkErrorMember;
     const InterfaceDescription::Member* onLinkLostMember;
@@ -791,6 +811,7 @@ JNIEXPORT jboolean JNICALL Java_org_alljoyn_bus_p2p_service_P2pHelperService_jni
 
             p2pIntf->AddSignal("OnFoundAdvertisedName",      "ssss", "name,namePrefix,guid,device");
             p2pIntf->AddSignal("OnLostAdvertisedName",       "ssss", "name,namePrefix,guid,device");
+            p2pIntf->AddSignal("OnLostAdvertisedNames",      "a(sss)s", "names,device");
             p2pIntf->AddSignal("OnLinkEstablished",          "is",    "handle,interfaceName");
             p2pIntf->AddSignal("OnLinkError",                "ii",   "handle,error");
             p2pIntf->AddSignal("OnLinkLost",                 "i",    "handle");
@@ -918,6 +939,52 @@ JNIEXPORT jint JNICALL Java_org_alljoyn_bus_p2p_service_P2pHelperService_jniOnLo
     return static_cast<int>(status);
 }
 
+JNIEXPORT jint JNICALL Java_org_alljoyn_bus_p2p_service_P2pHelperService_jniOnLostAdvertisedNames(JNIEnv* env, jobject jobj, jobjectArray names, jobjectArray namePrefixes, jobjectArray guids, jstring device) {
+    int status = ER_P2P_NOT_CONNECTED;
+
+    if (s_obj) {
+        /*
+         * All of the names a device was advertising cross JNI and the bus in
+         * one call instead of one call per name.
+         */
+        jsize numNames = env->GetArrayLength(names);
+        jstring* jNames = new jstring[numNames];
+        jstring* jNamePrefixes = new jstring[numNames];
+        jstring* jGuids = new jstring[numNames];
+        const char** cNames = new const char*[numNames];
+        const char** cNamePrefixes = new const char*[numNames];
+        const char** cGuids = new const char*[numNames];
+        for (jsize i = 0; i < numNames; ++i) {
+            jNames[i] = static_cast<jstring>(env->GetObjectArrayElement(names, i));
+            jNamePrefixes[i] = static_cast<jstring>(env->GetObjectArrayElement(namePrefixes, i));
+            jGuids[i] = static_cast<jstring>(env->GetObjectArrayElement(guids, i));
+            cNames[i] = env->GetStringUTFChars(jNames[i], NULL);
+            cNamePrefixes[i] = env->GetStringUTFChars(jNamePrefixes[i], NULL);
+            cGuids[i] = env->GetStringUTFChars(jGuids[i], NULL);
+        }
+        const char* cDevice = env->GetStringUTFChars(device, NULL);
+
+        status = s_obj->sendOnLostAdvertisedNames(numNames, cNames, cNamePrefixes, cGuids, cDevice);
+
+        env->ReleaseStringUTFChars(device, cDevice);
+        for (jsize i = 0; i < numNames; ++i) {
+            env->ReleaseStringUTFChars(jNames[i], cNames[i]);
+            env->ReleaseStringUTFChars(jNamePrefixes[i], cNamePrefixes[i]);
+            env->ReleaseStringUTFChars(jGuids[i], cGuids[i]);
+            env->DeleteLocalRef(jNames[i]);
+            env->DeleteLocalRef(jNamePrefixes[i]);
+            env->DeleteLocalRef(jGuids[i]);
+        }
+        delete [] cNames;
+        delete [] cNamePrefixes;
+        delete [] cGuids;
+        delete [] jNames;
+        delete [] jNamePrefixes;
+        delete [] jGuids;
+    }
+    return static_cast<int>(status);
+}
+
 JNIEXPORT jint JNICALL Java_org_alljoyn_bus_p2p_service_P2pHelperService_jniOnLinkEstablished(JNIEnv* env, jobject jobj, jint handle, jstring name) {
     int status = ER_P2P_NOT_CONNECTED;
 
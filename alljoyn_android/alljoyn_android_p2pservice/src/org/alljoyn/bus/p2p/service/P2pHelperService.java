@@ -28,6 +28,7 @@ public class P2pHelperService implements P2pInterface {
     private native void jniOnDestroy(String daemonAddr);
     private native int jniOnFoundAdvertisedName(String name, String namePrefix, String guid, String device);
     private native int jniOnLostAdvertisedName(String name, String namePrefix, String guid, String device);
+    private native int jniOnLostAdvertisedNames(String[] names, String[] namePrefixes, String[] guids, String device);
     private native int jniOnLinkEstablished(int handle, String interfaceName);
     private native int jniOnLinkError(int handle, int error);
     private native int jniOnLinkLost(int handle);
@@ -133,6 +134,17 @@ public class P2pHelperService implements P2pInterface {
         }
     }
 
+    public void OnLostAdvertisedNames(String[] names, String[] namePrefixes, String[] guids, String device) {
+        if (jniConnected) {
+            Log.i(TAG, "OnLostAdvertisedNames(" + names.length + " names, " + device + "): Sending signal");
+            if (0 != jniOnLostAdvertisedNames(names, namePrefixes, guids, device)) {
+                jniFailed();
+            }
+        } else {
+            Log.e(TAG, "OnLostAdvertisedNames() not sent, JNI not available");
+        }
+    }
+
     public void OnLinkEstablished(int handle, String interfaceName) {
         if (jniConnected) {
             Log.i(TAG, "OnLinkEstablished(" + handle + "), interface " + interfaceName);
@@ -102,6 +102,13 @@ public interface P2pInterface {
      */
     public void OnLostAdvertisedName(String name, String namePrefix, String guid, String device);
 
+    /*
+     * This signal communicates the disappearance of all of the service names
+     * previously found on a device at once.  Entry i of each array describes
+     * one lost name.
+     */
+    public void OnLostAdvertisedNames(String[] names, String[] namePrefixes, String[] guids, String device);
+
     /*
      * The AllJoyn dameon begins the process of a session join by calling the
      * EstablishLink method of this interface.  This signal communicates a
@@ -682,12 +682,18 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
         if (services == null || services.isEmpty())
             return;
 
-        Iterator<FoundServiceInfo> itr = services.iterator();
-
-        while (itr.hasNext()) {
-            FoundServiceInfo serviceInfo = itr.next();
-            busInterface.OnLostAdvertisedName(serviceInfo.name, serviceInfo.prefix, serviceInfo.guid, address);
+        // Report all of the names lost with the device in one signal.
+        String[] names = new String[services.size()];
+        String[] namePrefixes = new String[services.size()];
+        String[] guids = new String[services.size()];
+
+        for (int i = 0; i < services.size(); i++) {
+            FoundServiceInfo serviceInfo = services.get(i);
+            names[i] = serviceInfo.name;
+            namePrefixes[i] = serviceInfo.prefix;
+            guids[i] = serviceInfo.guid;
         }
+        busInterface.OnLostAdvertisedNames(names, namePrefixes, guids, address);
     }
 
     public void onPeersAvailable(WifiP2pDeviceList newPeers) {
@@ -742,7 +748,10 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
         }
     }
 
-    synchronized private void updateDeviceServiceList(String name, String prefix, String guid, int timer, String address) {
+    /*
+     * Returns true if the name was newly found or a previously found name was lost.
+     */
+    synchronized private boolean updateDeviceServiceList(String name, String prefix, String guid, int timer, String address) {
         ArrayList<FoundServiceInfo> services;
         FoundServiceInfo serviceInfo;
         boolean isNew = true;
@@ -759,7 +768,7 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
             if (timer != 0)
                 services = new ArrayList<FoundServiceInfo>();
             else
-                return;
+                return false;
         }
 
         Iterator<FoundServiceInfo> itr = services.iterator();
@@ -774,7 +783,7 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
             }
         }
 
-        if (isNew) {
+        if (isNew && timer != 0) {
             serviceInfo = new FoundServiceInfo(name, prefix, guid);
             services.add(serviceInfo);
         }
@@ -782,6 +791,8 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
         //Check
         Log.d(TAG, "Device " + address + " has " + services.size() + " services");
         mDeviceServices.put(address, services);
+
+        return isNew == (timer != 0);
     }
 
     public void onDnsSdTxtRecordAvailable(String fullDomainName, Map<String, String> txtRecordMap, WifiP2pDevice srcDevice) {
@@ -827,13 +838,16 @@ public class P2pManager implements ConnectionInfoListener, DnsSdServiceResponseL
         for (Map.Entry entry : txtRecordMap.entrySet())
             Log.d(TAG, (entry.getKey() + ", " + entry.getValue()));
 
-        updateDeviceServiceList(decName, namePrefix, guid, timer, srcDevice.deviceAddress);
+        // Only tell the daemon about changes, not about records we have already seen.
+        boolean changed = updateDeviceServiceList(decName, namePrefix, guid, timer, srcDevice.deviceAddress);
 
-        if (timer != 0)
-            busInterface.OnFoundAdvertisedName(decName, namePrefix, guid, /*timer,*/ srcDevice.deviceAddress);
-        else {
+        if (timer != 0) {
+            if (changed)
+                busInterface.OnFoundAdvertisedName(decName, namePrefix, guid, /*timer,*/ srcDevice.deviceAddress);
+        } else {
             removeServiceRequestFromList(name);
-            busInterface.OnLostAdvertisedName(decName, namePrefix, guid, srcDevice.deviceAddress);
+            if (changed)
+                busInterface.OnLostAdvertisedName(decName, namePrefix, guid, srcDevice.deviceAddress);
         }
     }
 
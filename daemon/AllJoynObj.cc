@@ -28,8 +28,11 @@
 #include <set>
 #include <vector>
 #include <errno.h>
+#include <string.h>
 
+#include <qcc/atomic.h>
 #include <qcc/Debug.h>
+#include <qcc/Event.h>
 #include <qcc/Logger.h>
 #include <qcc/ManagedObj.h>
 #include <qcc/String.h>
@@ -47,6 +50,7 @@
 #include <alljoyn/ProxyBusObject.h>
 
 #include "DaemonRouter.h"
+#include "DaemonConfig.h"
 #include "AllJoynObj.h"
 #include "TransportList.h"
 #include "BusUtil.h"
@@ -56,6 +60,8 @@
 #include "EndpointHelper.h"
 #include "ns/IpNameService.h"
 #include "AllJoynPeerObj.h"
+#include "RawRelay.h"
+#include "TimerSlack.h"
 
 #define QCC_MODULE "ALLJOYN_OBJ"
 
@@ -65,7 +71,268 @@ using namespace qcc;
 namespace ajn {
 
 void* AllJoynObj::NameMapEntry::truthiness = reinterpret_cast<void*>(true);
-int AllJoynObj::JoinSessionThread::jstCount = 0;
+
+/*
+ * Number of threads handling JoinSession requests from local clients. A join holds its thread
+ * while it connects to the session host and waits for the AttachSession reply so this bounds how
+ * many joins are in progress at once. Further requests wait in the dispatcher's queue.
+ */
+static const uint32_t JOIN_SESSION_CONCURRENCY = 16;
+
+/*
+ * Number of threads handling AttachSession requests from other daemons.
+ */
+static const uint32_t ATTACH_SESSION_CONCURRENCY = 16;
+
+/*
+ * When the session host of a JoinSession has several bus addresses they are raced: each further
+ * address is tried this long after the previous one unless all of the connects in flight have
+ * already failed.
+ */
+static const uint32_t CONNECT_RACE_STAGGER_MS = 250;
+
+/*
+ * Maximum number of connects to the bus addresses of one session host in flight at once.
+ */
+static const size_t CONNECT_RACE_MAX_PARALLEL = 4;
+
+/*
+ * Sharing of the bus-to-bus connections opened by JoinSession is configured with
+ *
+ *   <limit b2b_reuse="messages"/>
+ *   <limit b2b_max_sessions="16"/>
+ *   <limit b2b_idle_linger="5000"/>
+ *
+ * Valid policies are "session" (the default) where a connection is only shared by the members of
+ * one multipoint session and "messages" where every message based session with the same remote
+ * daemon is routed over one of the pooled connections until it carries b2b_max_sessions sessions
+ * (0 means no limit). With b2b_idle_linger a pooled connection is kept open for that many
+ * milliseconds after its last session leaves so that the next join does not have to reconnect.
+ */
+static const uint32_t B2B_MAX_SESSIONS_DEFAULT = 16;
+
+/*
+ * A found name is reported to each discovering endpoint once, until it is lost. Repeated
+ * announcements of the name, or of the same name by another daemon, are not passed on. With
+ *
+ *   <limit found_name_suppress="30000"/>
+ *
+ * a repeat is passed on as a refresh once that many milliseconds have passed since the last report.
+ */
+static const uint32_t FOUND_NAME_SUPPRESS_DEFAULT = 0;
+
+/*
+ * In a large mesh of daemons every daemon peering with every other one does not scale. With
+ *
+ *   <hubs role="leaf">
+ *     <hub>tcp:addr=192.168.1.10,port=9955</hub>
+ *     <hub>tcp:addr=192.168.1.11,port=9955</hub>
+ *   </hubs>
+ *
+ * the daemon keeps bus-to-bus connections open to the listed hubs and routes message based
+ * sessions with daemons it learns of through a hub over that hub's connection. A leaf ("leaf" is
+ * the default role) does not pass the names it learns from one daemon on to the others, the hubs
+ * (role="hub") do that for everyone, usually listing each other as their own hubs. A connection to
+ * a hub that is lost is reopened every HUB_RETRY_MS.
+ */
+static const uint32_t HUB_RETRY_MS = 10000;
+
+/*
+ * Match a well-known name against a FindAdvertisedNameFiltered filter, where '*' matches any run
+ * of characters and '?' any one character.
+ */
+static bool FoundNameMatches(const char* name, const char* filter)
+{
+    const char* star = NULL;
+    const char* resume = NULL;
+    while (*name) {
+        if ((*filter == '?') || ((*filter != '*') && (*filter == *name))) {
+            ++filter;
+            ++name;
+        } else if (*filter == '*') {
+            star = filter++;
+            resume = name;
+        } else if (star) {
+            filter = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*filter == '*') {
+        ++filter;
+    }
+    return *filter == '\0';
+}
+
+class ConnectRace;
+
+/*
+ * One connect of a ConnectRace, run on its own thread since Transport::Connect() blocks.
+ */
+class ConnectAttempt : public qcc::Thread {
+  public:
+    ConnectAttempt(ConnectRace& race, Transport* trans, const String& busAddr, const SessionOpts& opts) :
+        Thread("JoinConnect"), trans(trans), busAddr(busAddr), opts(opts), status(ER_FAIL), race(race) { }
+
+    Transport* trans;      /* Transport to connect with */
+    String busAddr;        /* Bus address to connect to */
+    SessionOpts opts;      /* Session options for the connect */
+    QStatus status;        /* Result of the connect */
+    BusEndpoint ep;        /* Endpoint created by a successful connect */
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg);
+
+  private:
+    ConnectRace& race;
+};
+
+/*
+ * Connects to the first of several bus addresses that accepts the connection. The addresses are
+ * tried in priority order with CONNECT_RACE_STAGGER_MS between them so a dead address costs the
+ * stagger rather than a whole connect timeout. Once one connect succeeds the others are stopped
+ * and any of them that succeeded anyway are released.
+ */
+class ConnectRace {
+  public:
+    ConnectRace() : winner(NULL), finished(0) { }
+
+    ~ConnectRace()
+    {
+        for (size_t i = 0; i < attempts.size(); ++i) {
+            delete attempts[i];
+        }
+    }
+
+    /*
+     * Race connects to the candidates.
+     *
+     * @param candidates  Transports and bus addresses to connect to in priority order.
+     * @param opts        Session options for the connects.
+     *
+     * @return  The successful attempt or NULL if every connect failed.
+     */
+    ConnectAttempt* Run(const vector<pair<Transport*, String> >& candidates, const SessionOpts& opts);
+
+    /*
+     * Called on the attempt's thread when its connect has completed.
+     */
+    void Finished(ConnectAttempt* attempt)
+    {
+        lock.Lock(MUTEX_CONTEXT);
+        ++finished;
+        if ((attempt->status == ER_OK) && !winner) {
+            winner = attempt;
+        }
+        done.SetEvent();
+        lock.Unlock(MUTEX_CONTEXT);
+    }
+
+  private:
+    Mutex lock;                         /* Protects winner and finished */
+    Event done;                         /* Set when an attempt finishes */
+    ConnectAttempt* winner;             /* First attempt to succeed */
+    size_t finished;                    /* Number of attempts that have finished */
+    vector<ConnectAttempt*> attempts;   /* Attempts that have been started */
+};
+
+ThreadReturn STDCALL ConnectAttempt::Run(void* arg)
+{
+    status = trans->Connect(busAddr.c_str(), opts, ep);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("trans->Connect(%s) failed", busAddr.c_str()));
+    }
+    race.Finished(this);
+    return 0;
+}
+
+ConnectAttempt* ConnectRace::Run(const vector<pair<Transport*, String> >& candidates, const SessionOpts& opts)
+{
+    size_t next = 0;
+    while (true) {
+        lock.Lock(MUTEX_CONTEXT);
+        done.ResetEvent();
+        bool haveWinner = (winner != NULL);
+        size_t inFlight = attempts.size() - finished;
+        lock.Unlock(MUTEX_CONTEXT);
+
+        if (haveWinner || ((next == candidates.size()) && (inFlight == 0))) {
+            break;
+        }
+        if ((next < candidates.size()) && (inFlight < CONNECT_RACE_MAX_PARALLEL)) {
+            ConnectAttempt* attempt = new ConnectAttempt(*this, candidates[next].first, candidates[next].second, opts);
+            ++next;
+            lock.Lock(MUTEX_CONTEXT);
+            attempts.push_back(attempt);
+            lock.Unlock(MUTEX_CONTEXT);
+            QStatus status = attempt->Start();
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Failed to start connect to %s", attempt->busAddr.c_str()));
+                attempt->status = status;
+                Finished(attempt);
+                continue;
+            }
+        }
+        uint32_t waitMs = (next < candidates.size()) ? CONNECT_RACE_STAGGER_MS : Event::WAIT_FOREVER;
+        QStatus status = Event::Wait(done, waitMs);
+        if ((status != ER_OK) && (status != ER_TIMEOUT)) {
+            /* Our own thread is being stopped, give up on the race */
+            break;
+        }
+    }
+
+    /* Stop the losers and wait for every attempt to finish */
+    lock.Lock(MUTEX_CONTEXT);
+    ConnectAttempt* result = winner;
+    lock.Unlock(MUTEX_CONTEXT);
+    for (size_t i = 0; i < attempts.size(); ++i) {
+        if (attempts[i] != result) {
+            attempts[i]->Stop();
+        }
+    }
+    for (size_t i = 0; i < attempts.size(); ++i) {
+        attempts[i]->Join();
+        if ((attempts[i] != result) && (attempts[i]->status == ER_OK)) {
+            /* A loser connected anyway so take a reference and drop it to let the connection go */
+            RemoteEndpoint loser = RemoteEndpoint::cast(attempts[i]->ep);
+            if (loser->IsValid()) {
+                loser->IncrementRef();
+                loser->DecrementRef();
+            }
+        }
+    }
+    return result;
+}
+
+/*
+ * Apply the transmit queue settings requested by a session joiner to the bus-to-bus endpoint
+ * carrying the session. The settings may come from a remote joiner and the endpoint may carry
+ * other sessions, so they only apply to the session's own messages and never loosen the
+ * endpoint's daemon configured limits.
+ */
+static void ApplySessionTxQueuePolicy(RemoteEndpoint& b2bEp, SessionId id, const SessionOpts& opts)
+{
+    if ((opts.txQueuePolicy != SessionOpts::TXQUEUE_BLOCK) || opts.txQueueMaxMessages || opts.txQueueMaxBytes) {
+        b2bEp->SetSessionTxQueuePolicy(id, opts.txQueuePolicy, opts.txQueueMaxMessages, opts.txQueueMaxBytes);
+    }
+    if ((opts.txPriority != SessionOpts::TXPRIORITY_INTERACTIVE) || opts.txRateLimit || opts.txMessageTtl) {
+        b2bEp->SetSessionTxShaping(id, opts.txPriority, opts.txRateLimit, opts.txMessageTtl);
+    }
+}
+
+/*
+ * A direct path is a socket handed to a locally attached application so only endpoints that
+ * accept handles and are not other daemons can be given one.
+ */
+static bool CanTakeDirectPath(BusEndpoint& ep)
+{
+    if (!ep->IsValid() || (ep->GetEndpointType() != ENDPOINT_TYPE_REMOTE)) {
+        return false;
+    }
+    RemoteEndpoint rep = RemoteEndpoint::cast(ep);
+    return rep->GetFeatures().handlePassing && !rep->GetFeatures().isBusToBus;
+}
 
 void AllJoynObj::AcquireLocks()
 {
@@ -92,13 +359,30 @@ AllJoynObj::AllJoynObj(Bus& bus, BusController* busController) :
     sessionLostSignal(NULL),
     mpSessionChangedSignal(NULL),
     mpSessionJoinedSignal(NULL),
+    directPathSignal(NULL),
     guid(bus.GetInternal().GetGlobalGUID()),
     exchangeNamesSignal(NULL),
     detachSessionSignal(NULL),
     timer("NameReaper"),
+    joinSessionListener(*this),
+    joinSessionDispatcher("JoinSession", true, JOIN_SESSION_CONCURRENCY),
+    attachSessionDispatcher("AttachSession", true, ATTACH_SESSION_CONCURRENCY),
     isStopping(false),
+    transportOpListener(*this),
+    transportOpsStopping(false),
+    b2bReusePolicy(B2B_REUSE_SAME_SESSION),
+    b2bMaxSessions(B2B_MAX_SESSIONS_DEFAULT),
+    b2bIdleLingerMs(0),
+    b2bPoolReuses(0),
+    b2bPoolConnects(0),
+    b2bPoolSweepPending(false),
+    b2bPoolListener(*this),
+    isLeaf(false),
+    hubListener(*this),
+    foundNameSuppressMs(FOUND_NAME_SUPPRESS_DEFAULT),
     busController(busController)
 {
+    memset(&joinSessionStats, 0, sizeof(joinSessionStats));
 }
 
 AllJoynObj::~AllJoynObj()
@@ -108,6 +392,10 @@ AllJoynObj::~AllJoynObj()
 
     Stop();
     Join();
+
+    for (map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.begin(); it != transportDispatchers.end(); ++it) {
+        delete it->second.timer;
+    }
 }
 
 QStatus AllJoynObj::Init()
@@ -128,18 +416,23 @@ QStatus AllJoynObj::Init()
         { alljoynIntf->GetMember("CancelAdvertiseName"),      static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::CancelAdvertiseName) },
         { alljoynIntf->GetMember("FindAdvertisedName"),       static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::FindAdvertisedName) },
         { alljoynIntf->GetMember("FindAdvertisedNameByTransport"),       static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::FindAdvertisedNameByTransport) },
+        { alljoynIntf->GetMember("FindAdvertisedNameFiltered"),          static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::FindAdvertisedNameFiltered) },
         { alljoynIntf->GetMember("CancelFindAdvertisedName"), static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::CancelFindAdvertisedName) },
         { alljoynIntf->GetMember("CancelFindAdvertisedNameByTransport"), static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::CancelFindAdvertisedNameByTransport) },
         { alljoynIntf->GetMember("BindSessionPort"),          static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::BindSessionPort) },
         { alljoynIntf->GetMember("UnbindSessionPort"),        static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::UnbindSessionPort) },
         { alljoynIntf->GetMember("JoinSession"),              static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::JoinSession) },
+        { alljoynIntf->GetMember("JoinSessions"),             static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::JoinSessions) },
         { alljoynIntf->GetMember("LeaveSession"),             static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::LeaveSession) },
         { alljoynIntf->GetMember("GetSessionFd"),             static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::GetSessionFd) },
         { alljoynIntf->GetMember("SetLinkTimeout"),           static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::SetLinkTimeout) },
         { alljoynIntf->GetMember("AliasUnixUser"),            static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::AliasUnixUser) },
         { alljoynIntf->GetMember("OnAppSuspend"),             static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::OnAppSuspend) },
         { alljoynIntf->GetMember("OnAppResume"),              static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::OnAppResume) },
-        { alljoynIntf->GetMember("CancelSessionlessMessage"), static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::CancelSessionlessMessage) }
+        { alljoynIntf->GetMember("CancelSessionlessMessage"), static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::CancelSessionlessMessage) },
+        { alljoynIntf->GetMember("AddMatches"),               static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::AddMatches) },
+        { alljoynIntf->GetMember("RemoveMatches"),            static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::RemoveMatches) },
+        { alljoynIntf->GetMember("ReplaceMatches"),           static_cast<MessageReceiver::MethodHandler>(&AllJoynObj::ReplaceMatches) }
     };
 
     AddInterface(*alljoynIntf);
@@ -161,6 +454,7 @@ QStatus AllJoynObj::Init()
     }
 
     mpSessionJoinedSignal = busSessionIntf->GetMember("SessionJoined");
+    directPathSignal = busSessionIntf->GetMember("DirectPath");
 
     /* Make this object implement org.alljoyn.Daemon */
     daemonIface = bus.GetInterface(org::alljoyn::Daemon::InterfaceName);
@@ -197,6 +491,17 @@ QStatus AllJoynObj::Init()
         }
     }
 
+    /* Register a signal handler for RuleDigest */
+    if (ER_OK == status) {
+        status = bus.RegisterSignalHandler(this,
+                                           static_cast<MessageReceiver::SignalHandler>(&AllJoynObj::RuleDigestSignalHandler),
+                                           daemonIface->GetMember("RuleDigest"),
+                                           NULL);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to register RuleDigestSignalHandler"));
+        }
+    }
+
     /* Register a signal handler for NameChanged bus-to-bus signal */
     if (ER_OK == status) {
         status = bus.RegisterSignalHandler(this,
@@ -229,11 +534,53 @@ QStatus AllJoynObj::Init()
         status = transList.RegisterListener(this);
     }
 
+    /* Read the bus-to-bus connection pool configuration */
+    DaemonConfig* config = DaemonConfig::Access();
+    qcc::String reuseStr = config->Get("limit@b2b_reuse", "session");
+    if (reuseStr == "messages") {
+        b2bReusePolicy = B2B_REUSE_MESSAGES;
+    } else if (reuseStr != "session") {
+        QCC_LogError(ER_INVALID_DATA, ("Unknown b2b_reuse \"%s\"", reuseStr.c_str()));
+    }
+    b2bMaxSessions = config->Get("limit@b2b_max_sessions", B2B_MAX_SESSIONS_DEFAULT);
+    b2bIdleLingerMs = config->Get("limit@b2b_idle_linger", static_cast<uint32_t>(0));
+    foundNameSuppressMs = config->Get("limit@found_name_suppress", FOUND_NAME_SUPPRESS_DEFAULT);
+
+    /* Read the hub configuration */
+    vector<qcc::String> hubSpecs = config->GetList("hubs/hub");
+    qcc::String roleStr = config->Get("hubs@role", "leaf");
+    if (config->Has("hubs")) {
+        if (roleStr == "leaf") {
+            isLeaf = true;
+        } else if (roleStr != "hub") {
+            QCC_LogError(ER_INVALID_DATA, ("Unknown hubs role \"%s\"", roleStr.c_str()));
+        }
+    }
+    for (size_t i = 0; i < hubSpecs.size(); ++i) {
+        hubLinks[hubSpecs[i]] = RemoteEndpoint();
+    }
+
     /* Start the name reaper */
     if (ER_OK == status) {
         status = timer.Start();
     }
 
+    /* The transports are not started yet so the first connection attempts are made from the timer */
+    if ((ER_OK == status) && !hubLinks.empty()) {
+        QStatus hubStatus = timer.AddAlarm(Alarm(0, &hubListener));
+        if (hubStatus != ER_OK) {
+            QCC_LogError(hubStatus, ("Failed to add hub alarm"));
+        }
+    }
+
+    /* Start the join session dispatchers */
+    if (ER_OK == status) {
+        status = joinSessionDispatcher.Start();
+    }
+    if (ER_OK == status) {
+        status = attachSessionDispatcher.Start();
+    }
+
     if (ER_OK == status) {
         status = bus.RegisterBusObject(*this);
     }
@@ -243,31 +590,436 @@ QStatus AllJoynObj::Init()
 
 QStatus AllJoynObj::Stop()
 {
-    /* Stop any outstanding JoinSessionThreads */
-    joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
+    /* Stop any outstanding join session requests */
+    joinSessionLock.Lock(MUTEX_CONTEXT);
     isStopping = true;
-    vector<JoinSessionThread*>::iterator it = joinSessionThreads.begin();
-    while (it != joinSessionThreads.end()) {
-        (*it)->Stop();
-        ++it;
+    joinSessionLock.Unlock(MUTEX_CONTEXT);
+    joinSessionDispatcher.Stop();
+    attachSessionDispatcher.Stop();
+
+    /* Changes still queued for the transports are dropped */
+    transportOpLock.Lock(MUTEX_CONTEXT);
+    transportOpsStopping = true;
+    for (map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.begin(); it != transportDispatchers.end(); ++it) {
+        it->second.timer->Stop();
     }
-    joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
+    transportOpLock.Unlock(MUTEX_CONTEXT);
     return ER_OK;
 }
 
 QStatus AllJoynObj::Join()
 {
-    /* Wait for any outstanding JoinSessionThreads */
-    joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
-    while (!joinSessionThreads.empty()) {
-        joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
-        qcc::Sleep(50);
-        joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
+    /* Wait for any outstanding join session requests */
+    joinSessionDispatcher.Join();
+    attachSessionDispatcher.Join();
+
+    /* No dispatcher is created once stopping so the map can be walked without the lock */
+    for (map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.begin(); it != transportDispatchers.end(); ++it) {
+        it->second.timer->Join();
     }
-    joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
     return ER_OK;
 }
 
+void AllJoynObj::GetJoinSessionStats(JoinSessionStats& stats)
+{
+    joinSessionLock.Lock(MUTEX_CONTEXT);
+    stats = joinSessionStats;
+    joinSessionLock.Unlock(MUTEX_CONTEXT);
+}
+
+void AllJoynObj::GetB2BPoolStats(B2BPoolStats& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+    AcquireLocks();
+    for (map<qcc::StringMapKey, B2BPoolEntry>::iterator it = b2bPool.begin(); it != b2bPool.end(); ++it) {
+        uint32_t sessions = it->second.ep->GetSessionCount();
+        ++stats.links;
+        if (sessions == 0) {
+            ++stats.idleLinks;
+        }
+        stats.sessions += sessions;
+    }
+    stats.reuses = b2bPoolReuses;
+    stats.connects = b2bPoolConnects;
+    ReleaseLocks();
+}
+
+struct AllJoynObj::TransportOp {
+    enum Type {
+        ENABLE_ADVERTISEMENT,
+        DISABLE_ADVERTISEMENT,
+        ENABLE_DISCOVERY,
+        REFRESH_DISCOVERY,
+        DISABLE_DISCOVERY
+    };
+
+    TransportOp(Type type, Transport* trans, const qcc::String& name, bool flag, TransportOpBatch* batch) :
+        type(type), trans(trans), name(name), flag(flag), batch(batch), queuedAt(GetTimestamp64()) { }
+
+    const char* TypeText() const
+    {
+        static const char* types[] = { "EnableAdvertisement", "DisableAdvertisement", "EnableDiscovery", "RefreshDiscovery", "DisableDiscovery" };
+        return types[type];
+    }
+
+    Type type;
+    Transport* trans;
+    qcc::String name;           /**< Advertised name or name prefix */
+    bool flag;                  /**< quietly for EnableAdvertisement, nameListEmpty for DisableAdvertisement */
+    TransportOpBatch* batch;    /**< The batch this change belongs to or NULL if nothing waits for it */
+    uint64_t queuedAt;
+};
+
+void AllJoynObj::TransportOpListener::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    TransportOp* op = static_cast<TransportOp*>(alarm->GetContext());
+
+    ajObj.transportOpLock.Lock(MUTEX_CONTEXT);
+    --ajObj.transportDispatchers[op->trans].stats.queued;
+    ajObj.transportOpLock.Unlock(MUTEX_CONTEXT);
+
+    if (reason == ER_OK) {
+        ajObj.RunTransportOp(*op);
+    } else if (op->batch) {
+        /* Dropped on shutdown, the request still has to be answered */
+        op->batch->Finished();
+    }
+    delete op;
+}
+
+void AllJoynObj::DispatchTransportOp(TransportOp* op)
+{
+    if (op->batch) {
+        op->batch->lock.Lock(MUTEX_CONTEXT);
+        ++op->batch->pending;
+        op->batch->lock.Unlock(MUTEX_CONTEXT);
+    }
+
+    QStatus status = ER_BUS_STOPPING;
+    transportOpLock.Lock(MUTEX_CONTEXT);
+    if (!transportOpsStopping) {
+        map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.find(op->trans);
+        if (it == transportDispatchers.end()) {
+            TransportDispatcher dispatcher;
+            dispatcher.timer = new Timer(String("Transport-") + op->trans->GetTransportName(), true, 1);
+            dispatcher.stats.transport = op->trans->GetTransportName();
+            dispatcher.stats.queued = 0;
+            dispatcher.stats.count = 0;
+            dispatcher.stats.totalMs = 0;
+            dispatcher.stats.maxMs = 0;
+            dispatcher.stats.maxQueuedMs = 0;
+            status = dispatcher.timer->Start();
+            if (status != ER_OK) {
+                delete dispatcher.timer;
+            } else {
+                it = transportDispatchers.insert(pair<Transport*, TransportDispatcher>(op->trans, dispatcher)).first;
+            }
+        }
+        if (it != transportDispatchers.end()) {
+            /* The dispatcher has a single thread so the changes for a transport are made in order */
+            status = it->second.timer->AddAlarm(Alarm(&transportOpListener, op));
+            if (status == ER_OK) {
+                ++it->second.stats.queued;
+            }
+        }
+    }
+    transportOpLock.Unlock(MUTEX_CONTEXT);
+
+    if (status != ER_OK) {
+        if (status != ER_BUS_STOPPING) {
+            QCC_LogError(status, ("Failed to dispatch %s to %s, making it now", op->TypeText(), op->trans->GetTransportName()));
+        }
+        RunTransportOp(*op);
+        delete op;
+    }
+}
+
+void AllJoynObj::RunTransportOp(TransportOp& op)
+{
+    uint64_t start = GetTimestamp64();
+    QStatus status = ER_OK;
+    switch (op.type) {
+    case TransportOp::ENABLE_ADVERTISEMENT:
+        status = op.trans->EnableAdvertisement(op.name, op.flag);
+        break;
+
+    case TransportOp::DISABLE_ADVERTISEMENT:
+        op.trans->DisableAdvertisement(op.name, op.flag);
+        break;
+
+    case TransportOp::ENABLE_DISCOVERY:
+        op.trans->EnableDiscovery(op.name.c_str());
+        break;
+
+    case TransportOp::REFRESH_DISCOVERY:
+        op.trans->RefreshDiscovery(op.name.c_str());
+        break;
+
+    case TransportOp::DISABLE_DISCOVERY:
+        op.trans->DisableDiscovery(op.name.c_str());
+        break;
+    }
+    uint64_t end = GetTimestamp64();
+    uint32_t elapsedMs = static_cast<uint32_t>(min(end - start, static_cast<uint64_t>(numeric_limits<uint32_t>::max())));
+    uint32_t queuedMs = static_cast<uint32_t>(min(start - op.queuedAt, static_cast<uint64_t>(numeric_limits<uint32_t>::max())));
+    if ((status != ER_OK) && (status != ER_NOT_IMPLEMENTED)) {
+        QCC_LogError(status, ("%s(%s) failed for transport %s", op.TypeText(), op.name.c_str(), op.trans->GetTransportName()));
+    }
+    QCC_DbgPrintf(("%s(%s) on %s took %u ms after waiting %u ms", op.TypeText(), op.name.c_str(), op.trans->GetTransportName(), elapsedMs, queuedMs));
+
+    transportOpLock.Lock(MUTEX_CONTEXT);
+    map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.find(op.trans);
+    if (it != transportDispatchers.end()) {
+        TransportOpStats& stats = it->second.stats;
+        ++stats.count;
+        stats.totalMs += elapsedMs;
+        stats.maxMs = max(stats.maxMs, elapsedMs);
+        stats.maxQueuedMs = max(stats.maxQueuedMs, queuedMs);
+    }
+    transportOpLock.Unlock(MUTEX_CONTEXT);
+
+    if (op.batch) {
+        op.batch->Finished();
+    }
+}
+
+void AllJoynObj::WaitTransportOps(TransportOpBatch& batch)
+{
+    while (true) {
+        batch.lock.Lock(MUTEX_CONTEXT);
+        bool finished = (batch.pending == 0);
+        batch.lock.Unlock(MUTEX_CONTEXT);
+        if (finished) {
+            break;
+        }
+        /* The changes cannot be abandoned since they refer to the batch */
+        QStatus status = Event::Wait(batch.done);
+        if (status == ER_ALERTED_THREAD) {
+            Thread::GetThread()->GetStopEvent().ResetEvent();
+        }
+    }
+}
+
+void AllJoynObj::GetTransportOpStats(std::vector<TransportOpStats>& stats)
+{
+    stats.clear();
+    transportOpLock.Lock(MUTEX_CONTEXT);
+    for (map<Transport*, TransportDispatcher>::iterator it = transportDispatchers.begin(); it != transportDispatchers.end(); ++it) {
+        stats.push_back(it->second.stats);
+    }
+    transportOpLock.Unlock(MUTEX_CONTEXT);
+}
+
+bool AllJoynObj::IsB2BPoolable(SessionPort sessionPort, const SessionOpts& opts) const
+{
+    return (b2bReusePolicy == B2B_REUSE_MESSAGES) &&
+           (opts.traffic == SessionOpts::TRAFFIC_MESSAGES) &&
+           (sessionPort != busController->GetSessionlessObj().GetSessionPort());
+}
+
+RemoteEndpoint AllJoynObj::FindPooledB2B(VirtualEndpoint& sessionHostEp, SessionOpts& opts)
+{
+    RemoteEndpoint best;
+    TransportMask bestMask = 0;
+    size_t bestSessions = 0;
+    TransportList& transList = bus.GetInternal().GetTransportList();
+    for (map<qcc::StringMapKey, B2BPoolEntry>::iterator it = b2bPool.begin(); it != b2bPool.end(); ++it) {
+        RemoteEndpoint& ep = it->second.ep;
+        if (!ep->IsValid() || !sessionHostEp->CanUseRoute(ep)) {
+            continue;
+        }
+        Transport* trans = transList.GetTransport(ep->GetConnectSpec());
+        if (!trans || ((trans->GetTransportMask() & opts.transports) == 0)) {
+            continue;
+        }
+        size_t sessions = ep->GetSessionCount();
+        if ((b2bMaxSessions != 0) && (sessions >= b2bMaxSessions)) {
+            continue;
+        }
+        if (!best->IsValid() || (sessions < bestSessions)) {
+            best = ep;
+            bestMask = trans->GetTransportMask();
+            bestSessions = sessions;
+        }
+    }
+    if (best->IsValid()) {
+        b2bPool[best->GetUniqueName()].idleSince = 0;
+        opts.transports = bestMask;
+        ++b2bPoolReuses;
+    }
+    return best;
+}
+
+void AllJoynObj::AddPooledB2B(RemoteEndpoint& ep)
+{
+    QCC_DbgPrintf(("AllJoynObj::AddPooledB2B(%s)", ep->GetUniqueName().c_str()));
+    if (b2bPool.find(ep->GetUniqueName()) != b2bPool.end()) {
+        return;
+    }
+    b2bPool[ep->GetUniqueName()] = B2BPoolEntry(ep);
+    ++b2bPoolConnects;
+
+    /* The pool holds its own reference so the connection outlives its last session */
+    if (b2bIdleLingerMs) {
+        ep->IncrementRef();
+        if (!b2bPoolSweepPending) {
+            QStatus status = timer.AddAlarm(Alarm(TimerSlack::Coalesce(b2bIdleLingerMs), &b2bPoolListener));
+            if (status == ER_OK) {
+                b2bPoolSweepPending = true;
+            } else if (status != ER_TIMER_EXITING) {
+                QCC_LogError(status, ("Failed to add b2b pool alarm"));
+            }
+        }
+    }
+}
+
+void AllJoynObj::SweepB2BPool()
+{
+    vector<RemoteEndpoint> expired;
+
+    AcquireLocks();
+    uint64_t now = GetTimestamp64();
+    map<qcc::StringMapKey, B2BPoolEntry>::iterator it = b2bPool.begin();
+    while (it != b2bPool.end()) {
+        B2BPoolEntry& entry = it->second;
+        if (entry.ep->GetSessionCount() > 0) {
+            entry.idleSince = 0;
+            ++it;
+        } else if (entry.idleSince == 0) {
+            entry.idleSince = now;
+            ++it;
+        } else if ((now - entry.idleSince) >= b2bIdleLingerMs) {
+            QCC_DbgPrintf(("Releasing idle pooled connection %s", it->first.c_str()));
+            expired.push_back(entry.ep);
+            b2bPool.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    /* An idle connection is released between one and one and a half linger periods after its last session leaves */
+    b2bPoolSweepPending = false;
+    if (!b2bPool.empty()) {
+        uint32_t period = (b2bIdleLingerMs > 1) ? (b2bIdleLingerMs / 2) : 1;
+        QStatus status = timer.AddAlarm(Alarm(TimerSlack::Coalesce(period), &b2bPoolListener));
+        if (status == ER_OK) {
+            b2bPoolSweepPending = true;
+        } else if (status != ER_TIMER_EXITING) {
+            QCC_LogError(status, ("Failed to add b2b pool alarm"));
+        }
+    }
+    ReleaseLocks();
+
+    /* Drop the pool's references without the locks since this may stop the endpoints */
+    for (size_t i = 0; i < expired.size(); ++i) {
+        expired[i]->DecrementRef();
+    }
+}
+
+void AllJoynObj::B2BPoolListener::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    if (reason == ER_OK) {
+        ajObj.SweepB2BPool();
+    }
+}
+
+RemoteEndpoint AllJoynObj::FindHubB2B(VirtualEndpoint& sessionHostEp, SessionOpts& opts)
+{
+    RemoteEndpoint best;
+    TransportMask bestMask = 0;
+    size_t bestSessions = 0;
+    TransportList& transList = bus.GetInternal().GetTransportList();
+    for (map<qcc::String, RemoteEndpoint>::iterator it = hubLinks.begin(); it != hubLinks.end(); ++it) {
+        RemoteEndpoint& ep = it->second;
+        if (!ep->IsValid() || (b2bEndpoints.find(ep->GetUniqueName()) == b2bEndpoints.end()) || !sessionHostEp->CanUseRoute(ep)) {
+            continue;
+        }
+        Transport* trans = transList.GetTransport(ep->GetConnectSpec());
+        if (!trans || ((trans->GetTransportMask() & opts.transports) == 0)) {
+            continue;
+        }
+        size_t sessions = ep->GetSessionCount();
+        if (!best->IsValid() || (sessions < bestSessions)) {
+            best = ep;
+            bestMask = trans->GetTransportMask();
+            bestSessions = sessions;
+        }
+    }
+    if (best->IsValid()) {
+        opts.transports = bestMask;
+    }
+    return best;
+}
+
+void AllJoynObj::ConnectHubs()
+{
+    /* Find the hubs that are not connected, a connection that has gone away is reopened */
+    vector<qcc::String> specs;
+    AcquireLocks();
+    if (isStopping) {
+        ReleaseLocks();
+        return;
+    }
+    for (map<qcc::String, RemoteEndpoint>::iterator it = hubLinks.begin(); it != hubLinks.end(); ++it) {
+        RemoteEndpoint& ep = it->second;
+        if (!ep->IsValid() || (b2bEndpoints.find(ep->GetUniqueName()) == b2bEndpoints.end())) {
+            ep = RemoteEndpoint();
+            specs.push_back(it->first);
+        }
+    }
+    ReleaseLocks();
+
+    /* Connect without the locks since the new bus-to-bus endpoint registers itself with us */
+    TransportList& transList = bus.GetInternal().GetTransportList();
+    for (size_t i = 0; i < specs.size(); ++i) {
+        Transport* trans = transList.GetTransport(specs[i]);
+        if (!trans) {
+            QCC_LogError(ER_BUS_TRANSPORT_NOT_AVAILABLE, ("No transport for hub %s", specs[i].c_str()));
+            continue;
+        }
+        SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+        BusEndpoint ep;
+        QStatus status = trans->Connect(specs[i].c_str(), opts, ep);
+        if (status != ER_OK) {
+            QCC_DbgPrintf(("Failed to connect to hub %s: %s", specs[i].c_str(), QCC_StatusText(status)));
+            continue;
+        }
+        /* The link holds its own reference so it stays open without sessions */
+        RemoteEndpoint b2bEp = RemoteEndpoint::cast(ep);
+        b2bEp->IncrementRef();
+        AcquireLocks();
+        hubLinks[specs[i]] = b2bEp;
+        ReleaseLocks();
+        QCC_DbgPrintf(("Connected to hub %s as %s", specs[i].c_str(), b2bEp->GetUniqueName().c_str()));
+    }
+
+    QStatus status = timer.AddAlarm(Alarm(TimerSlack::Coalesce(HUB_RETRY_MS), &hubListener));
+    if ((status != ER_OK) && (status != ER_TIMER_EXITING)) {
+        QCC_LogError(status, ("Failed to add hub alarm"));
+    }
+}
+
+void AllJoynObj::HubListener::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    if (reason == ER_OK) {
+        ajObj.ConnectHubs();
+    }
+}
+
+void AllJoynObj::RecordJoinStage(JoinSessionStage stage, uint64_t startMs)
+{
+    uint64_t elapsed = GetTimestamp64() - startMs;
+    uint32_t elapsedMs = (elapsed > numeric_limits<uint32_t>::max()) ? numeric_limits<uint32_t>::max() : static_cast<uint32_t>(elapsed);
+    joinSessionLock.Lock(MUTEX_CONTEXT);
+    JoinStageLatency& latency = joinSessionStats.stages[stage];
+    ++latency.count;
+    latency.totalMs += elapsedMs;
+    if (elapsedMs > latency.maxMs) {
+        latency.maxMs = elapsedMs;
+    }
+    joinSessionLock.Unlock(MUTEX_CONTEXT);
+}
+
 void AllJoynObj::ObjectRegistered(void)
 {
     QStatus status;
@@ -440,7 +1192,7 @@ void AllJoynObj::UnbindSessionPort(const InterfaceDescription::Member* member, M
     SessionMapType::iterator it = SessionMapLowerBound(sender, 0);
     while ((it != sessionMap.end()) && (it->first.first == sender) && (it->first.second == 0)) {
         if (it->second.sessionPort == sessionPort) {
-            sessionMap.erase(it);
+            SessionMapErase(it);
             replyCode = ALLJOYN_UNBINDSESSIONPORT_REPLY_SUCCESS;
             break;
         }
@@ -460,45 +1212,86 @@ void AllJoynObj::UnbindSessionPort(const InterfaceDescription::Member* member, M
     }
 }
 
-ThreadReturn STDCALL AllJoynObj::JoinSessionThread::Run(void* arg)
+AllJoynObj::JoinSessionRequest::~JoinSessionRequest()
+{
+    /* The last group of a JoinSessions batch to finish sends the reply, even if other groups were dropped */
+    if (batch && (DecrementAndFetch(&batch->pending) == 0)) {
+        ajObj.ReplyJoinSessions(*batch);
+        delete batch;
+    }
+}
+
+void AllJoynObj::JoinSessionRequest::Run()
 {
-    if (isJoin) {
-        QCC_DbgTrace(("JoinSessionThread::RunJoin()"));
-        return RunJoin();
+    ajObj.RecordJoinStage(JOIN_STAGE_QUEUED, queuedAt);
+    if (batch) {
+        /*
+         * Joins in a group go to the same daemon so running them one after another lets each
+         * join after the first reuse the bus-to-bus connection opened by the first.
+         */
+        QCC_DbgTrace(("JoinSessionRequest::RunJoin() x %u", joins.size()));
+        for (size_t i = 0; i < joins.size(); ++i) {
+            const MsgArg& join = batch->joins[joins[i]];
+            RunJoin(join.v_struct.members, batch->results[joins[i]]);
+        }
+    } else if (isJoin) {
+        QCC_DbgTrace(("JoinSessionRequest::RunJoin()"));
+        size_t numArgs;
+        const MsgArg* args;
+        msg->GetArgs(numArgs, args);
+        JoinResult result;
+        RunJoin(args, result);
+
+        /* Reply to request */
+        MsgArg replyArgs[3];
+        replyArgs[0].Set("u", result.replyCode);
+        replyArgs[1].Set("u", result.id);
+        SetSessionOpts(result.optsOut, replyArgs[2]);
+        uint64_t replyStart = GetTimestamp64();
+        QStatus status = ajObj.MethodReply(msg, replyArgs, ArraySize(replyArgs));
+        ajObj.RecordJoinStage(JOIN_STAGE_REPLY, replyStart);
+        QCC_DbgPrintf(("AllJoynObj::JoinSession(%d) returned (%d,%u) (status=%s)", result.sessionPort, result.replyCode, result.id, QCC_StatusText(status)));
+        if (status == ER_OK) {
+            ajObj.SendJoinSignals(msg->GetSender(), result);
+        } else {
+            QCC_LogError(status, ("Failed to respond to org.alljoyn.Bus.JoinSession"));
+        }
     } else {
-        QCC_DbgTrace(("JoinSessionThread::RunAttach()"));
-        return RunAttach();
+        QCC_DbgTrace(("JoinSessionRequest::RunAttach()"));
+        RunAttach();
     }
+    ajObj.RecordJoinStage(JOIN_STAGE_TOTAL, queuedAt);
 }
 
-ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
+void AllJoynObj::JoinSessionRequest::RunJoin(const MsgArg* joinArgs, JoinResult& result)
 {
     uint32_t replyCode = ALLJOYN_JOINSESSION_REPLY_SUCCESS;
     SessionId id = 0;
     SessionOpts optsOut(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, 0);
-    size_t numArgs;
-    const MsgArg* args;
     SessionMapEntry sme;
     String sender = msg->GetSender();
     RemoteEndpoint b2bEp;
     BusEndpoint joinerEp = ajObj.router.FindEndpoint(sender);
 
+    /* A session with a remote host needs the transports */
+    ajObj.bus.StartDeferredTransports();
+
     /* Parse the message args */
-    msg->GetArgs(numArgs, args);
     const char* sessionHost = NULL;
-    SessionPort sessionPort;
+    SessionPort sessionPort = 0;
     SessionOpts optsIn;
-    QStatus status = MsgArg::Get(args, 2, "sq", &sessionHost, &sessionPort);
+    QStatus status = MsgArg::Get(joinArgs, 2, "sq", &sessionHost, &sessionPort);
     BusEndpoint rSessionEp;
+    SocketFd directFds[2] = { -1, -1 };
 
     if (status == ER_OK) {
-        status = GetSessionOpts(args[2], optsIn);
+        status = GetSessionOpts(joinArgs[2], optsIn);
     }
 
     if (status == ER_OK) {
         BusEndpoint srcEp = ajObj.router.FindEndpoint(sender);
         if (srcEp->IsValid()) {
-            status = TransportPermission::FilterTransports(srcEp, sender, optsIn.transports, "JoinSessionThread.Run");
+            status = TransportPermission::FilterTransports(srcEp, sender, optsIn.transports, "JoinSessionRequest.Run");
         }
     }
 
@@ -514,15 +1307,10 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
 
         if (rejectCall) {
             QCC_DbgPrintf(("The sender endpoint is not allowed to call JoinSession()"));
-            replyCode = ALLJOYN_JOINSESSION_REPLY_REJECTED;
-            /* Reply to request */
-            MsgArg replyArgs[3];
-            replyArgs[0].Set("u", replyCode);
-            replyArgs[1].Set("u", id);
-            SetSessionOpts(optsOut, replyArgs[2]);
-            status = ajObj.MethodReply(msg, replyArgs, ArraySize(replyArgs));
-            QCC_DbgPrintf(("AllJoynObj::JoinSession(%d) returned (%d,%u) (status=%s)", sessionPort, replyCode, id, QCC_StatusText(status)));
-            return 0;
+            result.replyCode = ALLJOYN_JOINSESSION_REPLY_REJECTED;
+            result.sessionPort = sessionPort;
+            result.optsOut = optsOut;
+            return;
         }
     }
 
@@ -657,7 +1445,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                             /* Add (local) joiner to list of session members since no AttachSession will be sent */
                             SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, newSessionId);
                             if (smEntry) {
-                                smEntry->memberNames.push_back(sender);
+                                ajObj.SessionMapAddMember(*smEntry, sender);
                                 smEntry->isInitializing = false;
                                 sme = *smEntry;
                             } else {
@@ -674,6 +1462,15 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                             optsOut = sme.opts;
                             optsOut.transports &= optsIn.transports;
                             sme.id = newSessionId;
+
+                            /* Give both ends a direct path if both asked for one and both can receive it */
+                            if ((replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) && sme.opts.isDirect && optsIn.isDirect && !sme.opts.isMultipoint &&
+                                CanTakeDirectPath(joinerEp) && CanTakeDirectPath(rSessionEp)) {
+                                if (SocketPair(directFds) != ER_OK) {
+                                    QCC_LogError(ER_OS_ERROR, ("SocketPair failed, session %u will be routed by the daemon", id));
+                                    directFds[0] = directFds[1] = -1;
+                                }
+                            }
                         }
                     } else if ((sme.opts.traffic != SessionOpts::TRAFFIC_MESSAGES) && !sme.opts.isMultipoint) {
                         /* Create a raw socket pair for the two local session participants */
@@ -684,7 +1481,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                             SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, sme.id);
                             if (smEntry) {
                                 smEntry->fd = fds[0];
-                                smEntry->memberNames.push_back(sender);
+                                ajObj.SessionMapAddMember(*smEntry, sender);
 
                                 /* Create a joiner side entry in sessionMap */
                                 SessionMapEntry sme2 = sme;
@@ -741,7 +1538,29 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                 }
             }
 
+            /* Route over a hub connection if the session host is reachable through a hub */
             String busAddr;
+            if (!b2bEp->IsValid() && (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) && vSessionEp->IsValid() &&
+                (optsIn.traffic == SessionOpts::TRAFFIC_MESSAGES) && (sessionPort != ajObj.busController->GetSessionlessObj().GetSessionPort())) {
+                b2bEp = ajObj.FindHubB2B(vSessionEp, optsIn);
+                if (b2bEp->IsValid()) {
+                    QCC_DbgPrintf(("JoinSession to %s routes through hub %s", sessionHost, b2bEp->GetUniqueName().c_str()));
+                    b2bEp->IncrementRef();
+                    busAddr = b2bEp->GetConnectSpec();
+                }
+            }
+
+            /* Route over a pooled connection to the session host's daemon if one has room */
+            bool poolable = ajObj.IsB2BPoolable(sessionPort, optsIn);
+            if (!b2bEp->IsValid() && (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) && poolable && vSessionEp->IsValid()) {
+                b2bEp = ajObj.FindPooledB2B(vSessionEp, optsIn);
+                if (b2bEp->IsValid()) {
+                    QCC_DbgPrintf(("JoinSession to %s reuses pooled connection %s", sessionHost, b2bEp->GetUniqueName().c_str()));
+                    b2bEp->IncrementRef();
+                    busAddr = b2bEp->GetConnectSpec();
+                }
+            }
+
             if (!b2bEp->IsValid()) {
                 /* Step 1a: If there is a busAddr from advertisement use it to (possibly) create a physical connection */
                 vector<String> busAddrs;
@@ -783,33 +1602,55 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                 }
 
                 if (!busAddrs.empty()) {
-                    /* Try busAddrs in priority order until connect succeeds */
+                    /* Ask the transports that provided the advertisements for endpoints */
+                    vector<pair<Transport*, String> > candidates;
+                    TransportList& transList = ajObj.bus.GetInternal().GetTransportList();
                     for (size_t i = 0; i < busAddrs.size(); ++i) {
-                        /* Ask the transport that provided the advertisement for an endpoint */
-                        TransportList& transList = ajObj.bus.GetInternal().GetTransportList();
                         Transport* trans = transList.GetTransport(busAddrs[i]);
                         if (trans != NULL) {
                             if ((optsIn.transports & trans->GetTransportMask()) == 0) {
-                                QCC_DbgPrintf(("AllJoynObj:JoinSessionThread() skip unpermitted transport(%s)", trans->GetTransportName()));
+                                QCC_DbgPrintf(("AllJoynObj:JoinSessionRequest() skip unpermitted transport(%s)", trans->GetTransportName()));
                                 continue;
                             }
-                            BusEndpoint newEp;
-                            status = trans->Connect(busAddrs[i].c_str(), optsIn, newEp);
-                            if (status == ER_OK) {
-                                b2bEp = RemoteEndpoint::cast(newEp);
-                                if (b2bEp->IsValid()) {
-                                    b2bEp->IncrementRef();
-                                }
-                                busAddr = busAddrs[i];
-                                replyCode = ALLJOYN_JOINSESSION_REPLY_SUCCESS;
-                                optsIn.transports  = trans->GetTransportMask();
-                                break;
-                            } else {
-                                QCC_LogError(status, ("trans->Connect(%s) failed", busAddrs[i].c_str()));
-                                replyCode = ALLJOYN_JOINSESSION_REPLY_CONNECT_FAILED;
-                            }
+                            candidates.push_back(pair<Transport*, String>(trans, busAddrs[i]));
                         }
                     }
+                    Transport* connectedTrans = NULL;
+                    BusEndpoint newEp;
+                    uint64_t connectStart = GetTimestamp64();
+                    if (candidates.size() == 1) {
+                        /* Only one address, so there is nothing to race */
+                        status = candidates[0].first->Connect(candidates[0].second.c_str(), optsIn, newEp);
+                        if (status == ER_OK) {
+                            connectedTrans = candidates[0].first;
+                            busAddr = candidates[0].second;
+                        } else {
+                            QCC_LogError(status, ("trans->Connect(%s) failed", candidates[0].second.c_str()));
+                        }
+                    } else if (!candidates.empty()) {
+                        /* Race the busAddrs in priority order and keep the first connect that succeeds */
+                        ConnectRace race;
+                        ConnectAttempt* winner = race.Run(candidates, optsIn);
+                        status = winner ? ER_OK : ER_FAIL;
+                        if (winner) {
+                            connectedTrans = winner->trans;
+                            busAddr = winner->busAddr;
+                            newEp = winner->ep;
+                        }
+                    }
+                    if (!candidates.empty()) {
+                        ajObj.RecordJoinStage(JOIN_STAGE_CONNECT, connectStart);
+                    }
+                    if (connectedTrans) {
+                        b2bEp = RemoteEndpoint::cast(newEp);
+                        if (b2bEp->IsValid()) {
+                            b2bEp->IncrementRef();
+                        }
+                        replyCode = ALLJOYN_JOINSESSION_REPLY_SUCCESS;
+                        optsIn.transports  = connectedTrans->GetTransportMask();
+                    } else if (!candidates.empty()) {
+                        replyCode = ALLJOYN_JOINSESSION_REPLY_CONNECT_FAILED;
+                    }
                 } else {
                     /* No advertisment or existing route to session creator */
                     replyCode = ALLJOYN_JOINSESSION_REPLY_NO_SESSION;
@@ -819,6 +1660,11 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                     replyCode = ALLJOYN_JOINSESSION_REPLY_UNREACHABLE;
                 }
                 ajObj.AcquireLocks();
+
+                /* Later joins may share the new connection */
+                if (poolable && b2bEp->IsValid() && (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS)) {
+                    ajObj.AddPooledB2B(b2bEp);
+                }
             }
 
             /* Step 2: Wait for the new b2b endpoint to have a virtual ep for nextController */
@@ -852,9 +1698,11 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
             if (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) {
                 const String nextControllerName = b2bEp->GetRemoteName();
                 ajObj.ReleaseLocks();
+                uint64_t attachStart = GetTimestamp64();
                 status = ajObj.SendAttachSession(sessionPort, sender.c_str(), sessionHost, sessionHost, b2bEp,
                                                  nextControllerName.c_str(), 0, busAddr.c_str(), optsIn, replyCode,
                                                  id, optsOut, membersArg);
+                ajObj.RecordJoinStage(JOIN_STAGE_ATTACH, attachStart);
                 if (status != ER_OK) {
                     QCC_LogError(status, ("AttachSession to %s failed", nextControllerName.c_str()));
                     replyCode = ALLJOYN_JOINSESSION_REPLY_FAILED;
@@ -876,6 +1724,8 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                     if (status != ER_OK) {
                         replyCode = ALLJOYN_JOINSESSION_REPLY_FAILED;
                         QCC_LogError(status, ("AddSessionRoute(%u, %s, NULL, %s, %s, %s) failed", id, sender.c_str(), vSessionEp->GetUniqueName().c_str(), b2bEp->GetUniqueName().c_str(), b2bEp->IsValid() ? "NULL" : "opts"));
+                    } else if (b2bEp->IsValid()) {
+                        ApplySessionTxQueuePolicy(b2bEp, id, optsIn);
                     }
                 } else {
                     replyCode = ALLJOYN_JOINSESSION_REPLY_FAILED;
@@ -967,6 +1817,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                     const String nextControllerName = memberB2BEp->GetRemoteName();
                     uint32_t tReplyCode;
                     ajObj.ReleaseLocks();
+                    uint64_t attachStart = GetTimestamp64();
                     status = ajObj.SendAttachSession(sessionPort,
                                                      sender.c_str(),
                                                      sessionHost,
@@ -980,6 +1831,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                                                      tId,
                                                      tOpts,
                                                      tMembersArg);
+                    ajObj.RecordJoinStage(JOIN_STAGE_ATTACH, attachStart);
                     ajObj.AcquireLocks();
                     if (status != ER_OK) {
                         QCC_LogError(status, ("Failed to attach session %u to %s", id, member.c_str()));
@@ -1001,7 +1853,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                 /* Add joiner to any local member's sessionMap entry  since no AttachSession is sent */
                 SessionMapEntry* smEntry = ajObj.SessionMapFind(member, id);
                 if (smEntry) {
-                    smEntry->memberNames.push_back(sender);
+                    ajObj.SessionMapAddMember(*smEntry, sender);
                 }
                 /* Multipoint session member is local to this daemon. Send MPSessionChanged */
                 if (optsOut.isMultipoint) {
@@ -1021,104 +1873,202 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
     }
     ajObj.ReleaseLocks();
 
-    /* Reply to request */
-    MsgArg replyArgs[3];
-    replyArgs[0].Set("u", replyCode);
-    replyArgs[1].Set("u", id);
-    SetSessionOpts(optsOut, replyArgs[2]);
-    status = ajObj.MethodReply(msg, replyArgs, ArraySize(replyArgs));
-    QCC_DbgPrintf(("AllJoynObj::JoinSession(%d) returned (%d,%u) (status=%s)", sessionPort, replyCode, id, QCC_StatusText(status)));
+    /*
+     * Hand out the direct path before the reply and before SessionJoined so that neither end
+     * sends a session message before it has its end of the path.
+     */
+    if (directFds[0] != -1) {
+        if (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) {
+            String creatorName = rSessionEp->GetUniqueName();
+            QStatus dpStatus = ajObj.SendDirectPath(id, sender.c_str(), directFds[0], creatorName.c_str());
+            if (dpStatus == ER_OK) {
+                dpStatus = ajObj.SendDirectPath(id, creatorName.c_str(), directFds[1], sender.c_str());
+            }
+            optsOut.isDirect = (dpStatus == ER_OK);
+        }
+        /* The signals carry copies of the handles */
+        qcc::Close(directFds[0]);
+        qcc::Close(directFds[1]);
+    } else {
+        optsOut.isDirect = false;
+    }
 
-    /* Log error if reply could not be sent */
-    if (ER_OK != status) {
-        QCC_LogError(status, ("Failed to respond to org.alljoyn.Bus.JoinSession"));
+    result.replyCode = replyCode;
+    result.id = id;
+    result.sessionPort = sessionPort;
+    result.optsOut = optsOut;
+    result.sme = sme;
+    result.localHost = rSessionEp->IsValid();
+}
+
+void AllJoynObj::SendJoinSignals(const qcc::String& sender, const JoinResult& result)
+{
+    if (result.replyCode != ALLJOYN_JOINSESSION_REPLY_SUCCESS) {
+        return;
     }
 
     /* Send SessionJoined to creator if creator is local since RunAttach does not run in this case */
-    if ((status == ER_OK) && (replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) && rSessionEp->IsValid()) {
-        ajObj.SendSessionJoined(sme.sessionPort, sme.id, sender.c_str(), sme.endpointName.c_str());
+    const SessionMapEntry& sme = result.sme;
+    if (result.localHost) {
+        SendSessionJoined(sme.sessionPort, sme.id, sender.c_str(), sme.endpointName.c_str());
         /* If session is multipoint, send MPSessionChanged to sessionHost */
         if (sme.opts.isMultipoint) {
-            ajObj.SendMPSessionChanged(sme.id, sender.c_str(), true, sme.endpointName.c_str());
+            SendMPSessionChanged(sme.id, sender.c_str(), true, sme.endpointName.c_str());
         }
     }
 
     /* Send a series of MPSessionChanged to "catch up" the new joiner */
-    if ((replyCode == ALLJOYN_JOINSESSION_REPLY_SUCCESS) && optsOut.isMultipoint) {
-        ajObj.AcquireLocks();
-        SessionMapEntry* smEntry = ajObj.SessionMapFind(sender, id);
+    if (result.optsOut.isMultipoint) {
+        SessionId id = result.id;
+        AcquireLocks();
+        SessionMapEntry* smEntry = SessionMapFind(sender, id);
         if (smEntry) {
             String sessionHost = smEntry->sessionHost;
             vector<String> memberVector = smEntry->memberNames;
-            ajObj.ReleaseLocks();
-            ajObj.SendMPSessionChanged(id, sessionHost.c_str(), true, sender.c_str());
+            ReleaseLocks();
+            SendMPSessionChanged(id, sessionHost.c_str(), true, sender.c_str());
             vector<String>::const_iterator mit = memberVector.begin();
             while (mit != memberVector.end()) {
                 if (sender != *mit) {
-                    ajObj.SendMPSessionChanged(id, mit->c_str(), true, sender.c_str());
+                    SendMPSessionChanged(id, mit->c_str(), true, sender.c_str());
                 }
                 mit++;
             }
         } else {
-            ajObj.ReleaseLocks();
+            ReleaseLocks();
         }
     }
+}
 
-    return 0;
+void AllJoynObj::JoinSessionListener::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    JoinSessionRequest* req = static_cast<JoinSessionRequest*>(alarm->GetContext());
+
+    ajObj.joinSessionLock.Lock(MUTEX_CONTEXT);
+    --ajObj.joinSessionStats.queued;
+    ajObj.joinSessionLock.Unlock(MUTEX_CONTEXT);
+
+    /* Requests still queued when the dispatcher is stopped are dropped */
+    if (reason == ER_OK) {
+        ajObj.joinSessionLock.Lock(MUTEX_CONTEXT);
+        ++ajObj.joinSessionStats.active;
+        ajObj.joinSessionLock.Unlock(MUTEX_CONTEXT);
+
+        req->Run();
+
+        ajObj.joinSessionLock.Lock(MUTEX_CONTEXT);
+        --ajObj.joinSessionStats.active;
+        ajObj.joinSessionLock.Unlock(MUTEX_CONTEXT);
+    }
+    delete req;
 }
 
-void AllJoynObj::JoinSessionThread::ThreadExit(Thread* thread)
+void AllJoynObj::DispatchJoinSession(Message& msg, bool isJoin)
 {
-    ajObj.joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
-    vector<JoinSessionThread*>::iterator it = ajObj.joinSessionThreads.begin();
-    JoinSessionThread* deleteMe = NULL;
-    while (it != ajObj.joinSessionThreads.end()) {
-        if (*it == thread) {
-            deleteMe = *it;
-            ajObj.joinSessionThreads.erase(it);
-            break;
+    DispatchJoinSession(new JoinSessionRequest(*this, msg, isJoin));
+}
+
+void AllJoynObj::DispatchJoinSession(JoinSessionRequest* req)
+{
+    QStatus status = ER_BUS_STOPPING;
+    joinSessionLock.Lock(MUTEX_CONTEXT);
+    if (!isStopping) {
+        Timer& dispatcher = req->IsJoin() ? joinSessionDispatcher : attachSessionDispatcher;
+        status = dispatcher.AddAlarm(Alarm(&joinSessionListener, req));
+        if (status == ER_OK) {
+            ++joinSessionStats.queued;
+        } else {
+            QCC_LogError(status, ("%s: Failed to dispatch request", req->IsJoin() ? "Join" : "Attach"));
         }
-        ++it;
     }
-    ajObj.joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
-    if (deleteMe) {
-        deleteMe->Join();
-        delete deleteMe;
-    } else {
-        QCC_LogError(ER_FAIL, ("Internal error: JoinSessionThread not found on list"));
+    joinSessionLock.Unlock(MUTEX_CONTEXT);
+
+    /* Deleting the last request of a batch replies to it so that must not happen under the lock */
+    if (status != ER_OK) {
+        delete req;
+    }
+}
+
+void AllJoynObj::JoinSession(const InterfaceDescription::Member* member, Message& msg)
+{
+    /* Handle JoinSession on a dispatcher thread since JoinSession can block waiting for NameOwnerChanged */
+    DispatchJoinSession(msg, true);
+}
+
+void AllJoynObj::JoinSessions(const InterfaceDescription::Member* member, Message& msg)
+{
+    size_t numJoins = 0;
+    const MsgArg* joins = NULL;
+    QStatus status = msg->GetArgs("a(sq" SESSIONOPTS_SIG ")", &numJoins, &joins);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Bad arguments to org.alljoyn.Bus.JoinSessions"));
+        MethodReply(msg, status);
+        return;
+    }
+    QCC_DbgTrace(("AllJoynObj::JoinSessions(%u)", numJoins));
+
+    /*
+     * Group the joins by the daemon that the session host is attached to, that is the unique
+     * name up to the '.'. Each group runs as one request so joins to the same daemon reuse one
+     * bus-to-bus connection while joins to different daemons run in parallel.
+     */
+    JoinSessionBatch* batch = new JoinSessionBatch(msg, joins, numJoins);
+    map<String, JoinSessionRequest*> groups;
+    for (size_t i = 0; i < numJoins; ++i) {
+        String key = joins[i].v_struct.members[0].v_string.str;
+        if (!key.empty() && (key[0] == ':')) {
+            key = key.substr(0, key.find_first_of('.'));
+        }
+        JoinSessionRequest*& req = groups[key];
+        if (!req) {
+            req = new JoinSessionRequest(*this, batch);
+        }
+        req->AddJoin(i);
+    }
+
+    if (groups.empty()) {
+        ReplyJoinSessions(*batch);
+        delete batch;
+        return;
+    }
+    batch->pending = groups.size();
+    for (map<String, JoinSessionRequest*>::iterator it = groups.begin(); it != groups.end(); ++it) {
+        DispatchJoinSession(it->second);
     }
 }
 
-void AllJoynObj::JoinSession(const InterfaceDescription::Member* member, Message& msg)
+void AllJoynObj::ReplyJoinSessions(JoinSessionBatch& batch)
 {
-    /* Handle JoinSession on another thread since JoinThread can block waiting for NameOwnerChanged */
-    joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
-    if (!isStopping) {
-        JoinSessionThread* jst = new JoinSessionThread(*this, msg, true);
-        QStatus status = jst->Start(NULL, jst);
-        if (status == ER_OK) {
-            joinSessionThreads.push_back(jst);
-        } else {
-            QCC_LogError(status, ("Join: Failed to start JoinSessionThread"));
-        }
+    vector<MsgArg> results(batch.results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const JoinResult& result = batch.results[i];
+        MsgArg optsArg;
+        SetSessionOpts(result.optsOut, optsArg);
+        results[i].Set("(uu*)", result.replyCode, result.id, &optsArg);
+        results[i].Stabilize();
+    }
+    MsgArg replyArg;
+    replyArg.Set("a(uu" SESSIONOPTS_SIG ")", results.size(), results.empty() ? NULL : &results[0]);
+
+    uint64_t replyStart = GetTimestamp64();
+    QStatus status = MethodReply(batch.msg, &replyArg, 1);
+    RecordJoinStage(JOIN_STAGE_REPLY, replyStart);
+    QCC_DbgPrintf(("AllJoynObj::JoinSessions(%u) replied (status=%s)", results.size(), QCC_StatusText(status)));
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to respond to org.alljoyn.Bus.JoinSessions"));
+        return;
+    }
+
+    String sender = batch.msg->GetSender();
+    for (size_t i = 0; i < batch.results.size(); ++i) {
+        SendJoinSignals(sender, batch.results[i]);
     }
-    joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
 }
 
 void AllJoynObj::AttachSession(const InterfaceDescription::Member* member, Message& msg)
 {
-    /* Handle AttachSession on another thread since AttachSession can block when connecting through an intermediate node */
-    joinSessionThreadsLock.Lock(MUTEX_CONTEXT);
-    if (!isStopping) {
-        JoinSessionThread* jst = new JoinSessionThread(*this, msg, false);
-        QStatus status = jst->Start(NULL, jst);
-        if (status == ER_OK) {
-            joinSessionThreads.push_back(jst);
-        } else {
-            QCC_LogError(status, ("Attach: Failed to start JoinSessionThread"));
-        }
-    }
-    joinSessionThreadsLock.Unlock(MUTEX_CONTEXT);
+    /* Handle AttachSession on a dispatcher thread since AttachSession can block when connecting through an intermediate node */
+    DispatchJoinSession(msg, false);
 }
 
 void AllJoynObj::LeaveSession(const InterfaceDescription::Member* member, Message& msg)
@@ -1179,7 +2129,7 @@ void AllJoynObj::LeaveSession(const InterfaceDescription::Member* member, Messag
     }
 }
 
-qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
+void AllJoynObj::JoinSessionRequest::RunAttach()
 {
     SessionId id = 0;
     String creatorName;
@@ -1354,7 +2304,7 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
                         SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, sme.id);
                         /* Update sessionMap */
                         if (smEntry) {
-                            smEntry->memberNames.push_back(srcStr);
+                            ajObj.SessionMapAddMember(*smEntry, srcStr);
                             id = smEntry->id;
                             destIsLocal = true;
                             creatorName = creatorEp->GetUniqueName();
@@ -1370,6 +2320,8 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
                                 status = ajObj.router.AddSessionRoute(id, destEp, NULL, busEndpoint, srcB2BEp);
                                 if (ER_OK != status) {
                                     QCC_LogError(status, ("AddSessionRoute(%u, %s, NULL, %s, %s) failed", id, dest, srcEp->GetUniqueName().c_str(), srcB2BEp->GetUniqueName().c_str()));
+                                } else {
+                                    ApplySessionTxQueuePolicy(srcB2BEp, id, optsIn);
                                 }
                             }
 
@@ -1411,7 +2363,9 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
                 } else {
                     ajObj.ReleaseLocks();
                     BusEndpoint ep;
+                    uint64_t connectStart = GetTimestamp64();
                     status = trans->Connect(busAddr, optsIn, ep);
+                    ajObj.RecordJoinStage(JOIN_STAGE_CONNECT, connectStart);
                     ajObj.AcquireLocks();
                     if (status == ER_OK) {
                         b2bEp = RemoteEndpoint::cast(ep);
@@ -1435,8 +2389,10 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
 
                 /* Send AttachSession */
                 ajObj.ReleaseLocks();
+                uint64_t attachStart = GetTimestamp64();
                 status = ajObj.SendAttachSession(sessionPort, src, sessionHost, dest, b2bEp, nextControllerName.c_str(),
                                                  msg->GetSessionId(), busAddr, optsIn, replyCode, tempId, tempOpts, replyArgs[3]);
+                ajObj.RecordJoinStage(JOIN_STAGE_ATTACH, attachStart);
                 ajObj.AcquireLocks();
 
                 /* If successful, add bi-directional session routes */
@@ -1520,6 +2476,7 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
     /* Obtain the srcB2BEp */
     BusEndpoint tempEp = ajObj.router.FindEndpoint(srcB2BStr);
     srcB2BEp = RemoteEndpoint::cast(tempEp);
+    uint64_t replyStart = GetTimestamp64();
     if (srcB2BEp->IsValid()) {
         ajObj.ReleaseLocks();
         status = msg->ReplyMsg(msg, replyArgs, ArraySize(replyArgs));
@@ -1530,6 +2487,7 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
         ajObj.ReleaseLocks();
         status = ajObj.MethodReply(msg, replyArgs, ArraySize(replyArgs));
     }
+    ajObj.RecordJoinStage(JOIN_STAGE_REPLY, replyStart);
     /* Send SessionJoined to creator */
     if (sendSessionJoined) {
         ajObj.SendSessionJoined(sme.sessionPort, sme.id, srcStr.c_str(), sme.endpointName.c_str());
@@ -1568,7 +2526,10 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
                 }
             }
         } else {
-            /* Indirect raw route (middle-man). Create a pump to copy raw data between endpoints */
+            /*
+             * Indirect raw route (middle-man). Relay the raw data between endpoints in the kernel
+             * where we can, otherwise create a pump to copy it through user space.
+             */
             QStatus tStatus;
             SocketFd srcB2bFd, b2bFd;
             ajObj.ReleaseLocks();
@@ -1577,12 +2538,16 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
 
             ajObj.AcquireLocks();
             status = (status == ER_OK) ? tStatus : status;
-            if (status == ER_OK) {
+            String threadNameStr = id;
+            threadNameStr.append("-pump");
+            bool relayed = false;
+            if ((status == ER_OK) && RawRelay::IsSupported()) {
+                relayed = (RawRelay::Start(srcB2bFd, b2bFd, threadNameStr) == ER_OK);
+            }
+            if ((status == ER_OK) && !relayed) {
                 SocketStream* ss1 = new SocketStream(srcB2bFd);
                 SocketStream* ss2 = new SocketStream(b2bFd);
                 size_t chunkSize = 4096;
-                String threadNameStr = id;
-                threadNameStr.append("-pump");
                 const char* threadName = threadNameStr.c_str();
                 bool isManaged = true;
                 ManagedObj<StreamPump> pump(ss1, ss2, chunkSize, threadName, isManaged);
@@ -1616,8 +2581,6 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
     }
 
     QCC_DbgPrintf(("AllJoynObj::AttachSession(%d) returned (%d,%u) (status=%s)", sessionPort, replyCode, id, QCC_StatusText(status)));
-
-    return 0;
 }
 
 void AllJoynObj::SetAdvNameAlias(const String& guid, const TransportMask mask, const String& advName)
@@ -1646,13 +2609,15 @@ void AllJoynObj::RemoveSessionRefs(const char* epName, SessionId id)
     vector<pair<String, SessionId> > changedSessionMembers;
     vector<SessionMapEntry> sessionsLost;
 
-    SessionMapType::iterator it = sessionMap.begin();
-    /* Look through sessionMap for entries matching id */
-    while (it != sessionMap.end()) {
-        if (it->first.second == id) {
+    /* Look through the sessionMap entries matching id */
+    set<pair<String, SessionId> > keys;
+    SessionMapKeysForId(id, keys);
+    for (set<pair<String, SessionId> >::const_iterator kit = keys.begin(); kit != keys.end(); ++kit) {
+        SessionMapType::iterator it = sessionMap.lower_bound(*kit);
+        while ((it != sessionMap.end()) && (it->first == *kit)) {
             if (it->first.first == epNameStr) {
                 /* Exact key matches are removed */
-                sessionMap.erase(it++);
+                SessionMapErase(it++);
             } else {
                 if (endpoint == router.FindEndpoint(it->second.sessionHost)) {
                     /* Modify entry to remove matching sessionHost */
@@ -1679,7 +2644,7 @@ void AllJoynObj::RemoveSessionRefs(const char* epName, SessionId id)
                     SessionMapEntry tsme = it->second;
                     pair<String, SessionId> key = it->first;
                     if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
+                        SessionMapErase(it++);
                     } else {
                         ++it;
                     }
@@ -1688,10 +2653,10 @@ void AllJoynObj::RemoveSessionRefs(const char* epName, SessionId id)
                     ++it;
                 }
             }
-        } else {
-            ++it;
         }
     }
+    /* epName is no longer part of any entry for id */
+    sessionNameIndex.erase(pair<String, SessionId>(epNameStr, id));
     ReleaseLocks();
 
     /* Send MPSessionChanged for each changed session involving alias */
@@ -1729,20 +2694,24 @@ void AllJoynObj::RemoveSessionRefs(const String& vepName, const String& b2bEpNam
 
     vector<pair<String, SessionId> > changedSessionMembers;
     vector<SessionMapEntry> sessionsLost;
-    SessionMapType::iterator it = sessionMap.begin();
-    while (it != sessionMap.end()) {
+
+    /* Examine sessions with ids that are affected by removal of vep through b2bep */
+    set<SessionId> ids;
+    vep->GetSessionIdsForB2B(b2bEp, ids);
+    set<pair<String, SessionId> > keys;
+    for (set<SessionId>::const_iterator iit = ids.begin(); iit != ids.end(); ++iit) {
         int count;
-        /* Skip binding reservations */
-        if (it->first.second == 0) {
-            ++it;
-            continue;
-        }
-        /* Examine sessions with ids that are affected by removal of vep through b2bep */
         /* Only sessions that route through a single (matching) b2bEp are affected */
-        if ((vep->GetBusToBusEndpoint(it->first.second, &count) == b2bEp) && (count == 1)) {
+        if ((vep->GetBusToBusEndpoint(*iit, &count) == b2bEp) && (count == 1)) {
+            SessionMapKeysForId(*iit, keys);
+        }
+    }
+    for (set<pair<String, SessionId> >::const_iterator kit = keys.begin(); kit != keys.end(); ++kit) {
+        SessionMapType::iterator it = sessionMap.lower_bound(*kit);
+        while ((it != sessionMap.end()) && (it->first == *kit)) {
             if (it->first.first == vepName) {
                 /* Key matches can be removed from sessionMap */
-                sessionMap.erase(it++);
+                SessionMapErase(it++);
             } else {
                 if (BusEndpoint::cast(vep) == router.FindEndpoint(it->second.sessionHost)) {
                     /* If the session's sessionHost is vep, then clear it out of the session */
@@ -1769,7 +2738,7 @@ void AllJoynObj::RemoveSessionRefs(const String& vepName, const String& b2bEpNam
                     SessionMapEntry tsme = it->second;
                     pair<String, SessionId> key = it->first;
                     if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
+                        SessionMapErase(it++);
                     } else {
                         ++it;
                     }
@@ -1778,9 +2747,9 @@ void AllJoynObj::RemoveSessionRefs(const String& vepName, const String& b2bEpNam
                     ++it;
                 }
             }
-        } else {
-            ++it;
         }
+        /* vep is no longer part of any entry for this id */
+        sessionNameIndex.erase(pair<String, SessionId>(vepName, kit->second));
     }
     ReleaseLocks();
 
@@ -1944,6 +2913,26 @@ QStatus AllJoynObj::SendSessionJoined(SessionPort sessionPort,
     return status;
 }
 
+QStatus AllJoynObj::SendDirectPath(SessionId sessionId,
+                                   const char* peerName,
+                                   qcc::SocketFd fd,
+                                   const char* destName)
+{
+    MsgArg args[3];
+    args[0].Set("u", sessionId);
+    args[1].Set("s", peerName);
+    args[2].Set("h", fd);
+
+    QCC_DbgPrintf(("SendDirectPath(%u, %s) to %s", sessionId, peerName, destName));
+
+    AllJoynPeerObj* peerObj = bus.GetInternal().GetLocalEndpoint()->GetPeerObj();
+    QStatus status = peerObj->Signal(destName, 0, *directPathSignal, args, ArraySize(args));
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to send DirectPath to %s", destName));
+    }
+    return status;
+}
+
 QStatus AllJoynObj::SendAcceptSession(SessionPort sessionPort,
                                       SessionId sessionId,
                                       const char* creatorName,
@@ -2182,12 +3171,76 @@ void AllJoynObj::SessionMapInsert(SessionMapEntry& sme)
 {
     pair<String, SessionId> key(sme.endpointName, sme.id);
     sessionMap.insert(pair<pair<String, SessionId>, SessionMapEntry>(key, sme));
+    sessionIdIndex.insert(pair<SessionId, String>(sme.id, sme.endpointName));
+    if (sme.id != 0) {
+        if (!sme.sessionHost.empty()) {
+            sessionNameIndex.insert(pair<String, SessionId>(sme.sessionHost, sme.id));
+        }
+        for (size_t i = 0; i < sme.memberNames.size(); ++i) {
+            sessionNameIndex.insert(pair<String, SessionId>(sme.memberNames[i], sme.id));
+        }
+    }
 }
 
 void AllJoynObj::SessionMapErase(SessionMapEntry& sme)
 {
     pair<String, SessionId> key(sme.endpointName, sme.id);
-    sessionMap.erase(key);
+    SessionMapType::iterator it = sessionMap.lower_bound(key);
+    while ((it != sessionMap.end()) && (it->first == key)) {
+        SessionMapErase(it++);
+    }
+}
+
+void AllJoynObj::SessionMapErase(SessionMapType::iterator it)
+{
+    const pair<String, SessionId> key = it->first;
+    vector<String> names = it->second.memberNames;
+    names.push_back(it->second.sessionHost);
+    sessionMap.erase(it);
+
+    if (sessionMap.find(key) == sessionMap.end()) {
+        sessionIdIndex.erase(pair<SessionId, String>(key.second, key.first));
+    }
+    if (key.second == 0) {
+        return;
+    }
+
+    /* Drop name index pairs that no remaining entry of the session refers to */
+    set<pair<String, SessionId> > keys;
+    SessionMapKeysForId(key.second, keys);
+    for (size_t i = 0; i < names.size(); ++i) {
+        bool referenced = false;
+        set<pair<String, SessionId> >::const_iterator kit = keys.begin();
+        while (!referenced && (kit != keys.end())) {
+            SessionMapType::const_iterator sit = sessionMap.lower_bound(*kit);
+            while (!referenced && (sit != sessionMap.end()) && (sit->first == *kit)) {
+                referenced = (sit->second.sessionHost == names[i]) ||
+                             (find(sit->second.memberNames.begin(), sit->second.memberNames.end(), names[i]) != sit->second.memberNames.end());
+                ++sit;
+            }
+            ++kit;
+        }
+        if (!referenced) {
+            sessionNameIndex.erase(pair<String, SessionId>(names[i], key.second));
+        }
+    }
+}
+
+void AllJoynObj::SessionMapAddMember(SessionMapEntry& sme, const qcc::String& member)
+{
+    sme.memberNames.push_back(member);
+    if (sme.id != 0) {
+        sessionNameIndex.insert(pair<String, SessionId>(member, sme.id));
+    }
+}
+
+void AllJoynObj::SessionMapKeysForId(SessionId id, set<pair<String, SessionId> >& keys)
+{
+    set<pair<SessionId, String> >::const_iterator it = sessionIdIndex.lower_bound(pair<SessionId, String>(id, String()));
+    while ((it != sessionIdIndex.end()) && (it->first == id)) {
+        keys.insert(pair<String, SessionId>(it->second, id));
+        ++it;
+    }
 }
 
 void AllJoynObj::SetLinkTimeout(const InterfaceDescription::Member* member, Message& msg)
@@ -2350,6 +3403,9 @@ void AllJoynObj::AdvertiseName(const InterfaceDescription::Member* member, Messa
     TransportMask transports = 0;
     bool quietly = false;
 
+    /* Advertising needs the transports and name services */
+    bus.StartDeferredTransports();
+
     /* Get AdvertiseName args */
     msg->GetArgs(numArgs, args);
     QStatus status = MsgArg::Get(args, numArgs, "sq", &advertiseName, &transports);
@@ -2363,6 +3419,7 @@ void AllJoynObj::AdvertiseName(const InterfaceDescription::Member* member, Messa
     /* Get the sender name */
     qcc::String sender = msg->GetSender();
     BusEndpoint srcEp = router.FindEndpoint(sender);
+    TransportOpBatch batch;
 
     if (ALLJOYN_ADVERTISENAME_REPLY_SUCCESS == replyCode) {
         if (PermissionMgr::GetDaemonBusCallPolicy(srcEp) == PermissionMgr::STDBUSCALL_SHOULD_REJECT) {
@@ -2418,22 +3475,19 @@ void AllJoynObj::AdvertiseName(const InterfaceDescription::Member* member, Messa
                     it->second.first |= transports;
                 }
 
-                /* Advertise on transports specified */
+                /* Advertise on transports specified, all at once, the reply waits for the slowest */
                 TransportList& transList = bus.GetInternal().GetTransportList();
-                status = ER_BUS_BAD_SESSION_OPTS;
                 for (size_t i = 0; i < transList.GetNumTransports(); ++i) {
                     Transport* trans = transList.GetTransport(i);
                     if (trans && trans->IsBusToBus() && (trans->GetTransportMask() & transports)) {
-                        status = trans->EnableAdvertisement(advertiseNameStr, quietly);
-                        if ((status != ER_OK) && (status != ER_NOT_IMPLEMENTED)) {
-                            QCC_LogError(status, ("EnableAdvertisment failed for transport %s - mask=0x%x", trans->GetTransportName(), transports));
-                        }
+                        DispatchTransportOp(new TransportOp(TransportOp::ENABLE_ADVERTISEMENT, trans, advertiseNameStr, quietly, &batch));
                     } else if (!trans) {
                         QCC_LogError(ER_BUS_TRANSPORT_NOT_AVAILABLE, ("NULL transport pointer found in transportList"));
                     }
                 }
             }
             ReleaseLocks();
+            WaitTransportOps(batch);
         } else {
             replyCode = ALLJOYN_ADVERTISENAME_REPLY_FAILED;
         }
@@ -2541,7 +3595,8 @@ QStatus AllJoynObj::ProcCancelAdvertise(const qcc::String& sender, const qcc::St
         for (size_t i = 0; i < transList.GetNumTransports(); ++i) {
             Transport* trans = transList.GetTransport(i);
             if (trans && (trans->GetTransportMask() & cancelMask)) {
-                trans->DisableAdvertisement(advertiseName, advertiseMap.empty());
+                /* Queued behind any enable still in progress so the transport sees them in order */
+                DispatchTransportOp(new TransportOp(TransportOp::DISABLE_ADVERTISEMENT, trans, advertiseName, advertiseMap.empty(), NULL));
             } else if (!trans) {
                 QCC_LogError(ER_BUS_TRANSPORT_NOT_AVAILABLE, ("NULL transport pointer found in transportList"));
             }
@@ -2572,7 +3627,40 @@ void AllJoynObj::FindAdvertisedNameByTransport(const InterfaceDescription::Membe
     ProcFindAdvertisedName(msg, false);
 }
 
-void AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
+void AllJoynObj::FindAdvertisedNameFiltered(const InterfaceDescription::Member* member, Message& msg)
+{
+    size_t numArgs;
+    const MsgArg* args;
+    msg->GetArgs(numArgs, args);
+    size_t numFilters = 0;
+    const MsgArg* filterArgs = NULL;
+    QStatus status = args[2].Get("as", &numFilters, &filterArgs);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Fail to parse msg parameters"));
+        MsgArg replyArg("u", ALLJOYN_FINDADVERTISEDNAME_REPLY_FAILED);
+        MethodReply(msg, &replyArg, 1);
+        return;
+    }
+
+    /* Install the filters first so the names already found are filtered too */
+    pair<String, String> key(args[0].v_string.str, msg->GetSender());
+    foundNameLock.Lock(MUTEX_CONTEXT);
+    Discoverer& discoverer = discoverers[key];
+    discoverer.filters.clear();
+    for (size_t i = 0; i < numFilters; ++i) {
+        discoverer.filters.push_back(filterArgs[i].v_string.str);
+    }
+    foundNameLock.Unlock(MUTEX_CONTEXT);
+
+    uint32_t replyCode = ProcFindAdvertisedName(msg, false);
+    if ((replyCode != ALLJOYN_FINDADVERTISEDNAME_REPLY_SUCCESS) && (replyCode != ALLJOYN_FINDADVERTISEDNAME_REPLY_ALREADY_DISCOVERING)) {
+        foundNameLock.Lock(MUTEX_CONTEXT);
+        discoverers.erase(key);
+        foundNameLock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+uint32_t AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
 {
     uint32_t replyCode = ALLJOYN_FINDADVERTISEDNAME_REPLY_SUCCESS;
     size_t numArgs;
@@ -2583,13 +3671,16 @@ void AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
     TransportMask enableMask = 0;
     TransportMask origMask = 0;
 
+    /* Discovery needs the transports and name services */
+    bus.StartDeferredTransports();
+
     /* Get the name prefix */
     msg->GetArgs(numArgs, args);
     if (isAnyTrans) {
         status = MsgArg::Get(args, numArgs, "s", &nprefix);
         transports = TRANSPORT_ANY;
     } else {
-        status = MsgArg::Get(args, numArgs, "sq", &nprefix, &transports);
+        status = MsgArg::Get(args, 2, "sq", &nprefix, &transports);
     }
 
     QCC_DbgTrace(("AllJoynObj::FindAdvertisedNameProc(%s)", nprefix));
@@ -2600,6 +3691,7 @@ void AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
 
     qcc::String namePrefix = nprefix;
     qcc::String sender = msg->GetSender();
+    TransportOpBatch batch;
 
     AcquireLocks();
     BusEndpoint srcEp = router.FindEndpoint(sender);
@@ -2639,24 +3731,37 @@ void AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
         if (!foundEntry) {
             discoverMap.insert(std::make_pair(namePrefix, std::make_pair(transports, sender)));
         }
+        foundNameLock.Lock(MUTEX_CONTEXT);
+        discoverers[pair<String, String>(namePrefix, sender)];
+        foundNameLock.Unlock(MUTEX_CONTEXT);
     }
     /* Find out the transports on which discovery needs to be enabled for this name.
      * i.e. The ones that are set in the requested transport mask and not set in the origMask.
      */
     enableMask = transports & ~origMask;
     if (ALLJOYN_FINDADVERTISEDNAME_REPLY_SUCCESS == replyCode) {
-        /* Find name on all remote transports */
+        /*
+         * Find name on all remote transports.  Transports that were already
+         * discovering this prefix have their matches in nameMap, which are
+         * reported below without waiting for the network; ask those
+         * transports to refresh them in the background.
+         */
+        TransportMask refreshMask = transports & origMask;
         TransportList& transList = bus.GetInternal().GetTransportList();
         for (size_t i = 0; i < transList.GetNumTransports(); ++i) {
             Transport* trans = transList.GetTransport(i);
             if (trans && (trans->GetTransportMask() & enableMask)) {
-                trans->EnableDiscovery(namePrefix.c_str());
+                DispatchTransportOp(new TransportOp(TransportOp::ENABLE_DISCOVERY, trans, namePrefix, false, &batch));
+            } else if (trans && (trans->GetTransportMask() & refreshMask)) {
+                /* Nothing waits for a refresh */
+                DispatchTransportOp(new TransportOp(TransportOp::REFRESH_DISCOVERY, trans, namePrefix, false, NULL));
             } else if (!trans) {
                 QCC_LogError(ER_BUS_TRANSPORT_NOT_AVAILABLE, ("NULL transport pointer found in transportList"));
             }
         }
     }
     ReleaseLocks();
+    WaitTransportOps(batch);
 
     /* Reply to request */
     MsgArg replyArg("u", replyCode);
@@ -2696,6 +3801,7 @@ void AllJoynObj::ProcFindAdvertisedName(Message& msg, bool isAnyTrans)
         }
         ReleaseLocks();
     }
+    return replyCode;
 }
 
 void AllJoynObj::CancelFindAdvertisedName(const InterfaceDescription::Member* member, Message& msg)
@@ -2762,6 +3868,10 @@ QStatus AllJoynObj::ProcCancelFindName(const qcc::String& sender, const qcc::Str
             it->second.first &= ~transports;
             if (it->second.first == 0) {
                 discoverMap.erase(it++);
+                /* Forget the filters and what was reported so a later find starts afresh */
+                foundNameLock.Lock(MUTEX_CONTEXT);
+                discoverers.erase(pair<String, String>(namePrefix, sender));
+                foundNameLock.Unlock(MUTEX_CONTEXT);
                 continue;
             }
         }
@@ -2779,7 +3889,8 @@ QStatus AllJoynObj::ProcCancelFindName(const qcc::String& sender, const qcc::Str
         for (size_t i = 0; i < transList.GetNumTransports(); ++i) {
             Transport* trans =  transList.GetTransport(i);
             if (trans && (trans->GetTransportMask() & cancelMask)) {
-                trans->DisableDiscovery(namePrefix.c_str());
+                /* Queued behind any enable still in progress so the transport sees them in order */
+                DispatchTransportOp(new TransportOp(TransportOp::DISABLE_DISCOVERY, trans, namePrefix, false, NULL));
             }
         }
     } else if (!foundFinder) {
@@ -2827,15 +3938,26 @@ void AllJoynObj::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
      */
     b2bEndpoints.erase(endpoint->GetUniqueName());
 
+    /* The connection is going away so any reference held by the pool does not need releasing */
+    b2bPool.erase(endpoint->GetUniqueName());
+
+    /* Only the virtual endpoints that were added through this bus-to-bus endpoint can route through it */
+    vector<String> vepNames;
+    set<pair<String, String> >::iterator bvit = b2bVirtualEndpoints.lower_bound(pair<String, String>(b2bEpName, String()));
+    while ((bvit != b2bVirtualEndpoints.end()) && (bvit->first == b2bEpName)) {
+        vepNames.push_back(bvit->second);
+        virtualEndpointB2Bs.erase(pair<String, String>(bvit->second, b2bEpName));
+        b2bVirtualEndpoints.erase(bvit++);
+    }
+
     /* Remove any virtual endpoints associated with a removed bus-to-bus endpoint */
-    map<qcc::String, VirtualEndpoint>::iterator it = virtualEndpoints.begin();
-    while (it != virtualEndpoints.end()) {
-        String vepName = it->first;
+    for (size_t i = 0; i < vepNames.size(); ++i) {
+        const String& vepName = vepNames[i];
+        map<qcc::String, VirtualEndpoint>::iterator it = virtualEndpoints.find(vepName);
         /* Check if this virtual endpoint has a route through this bus-to-bus endpoint.
          * If not, no cleanup is required for this virtual endpoint.
          */
-        if (!it->second->CanUseRoute(endpoint)) {
-            it = virtualEndpoints.upper_bound(vepName);
+        if ((it == virtualEndpoints.end()) || !it->second->CanUseRoute(endpoint)) {
             continue;
         }
         /* Clean sessionMap and report lost sessions */
@@ -2851,7 +3973,6 @@ void AllJoynObj::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
         it = virtualEndpoints.find(vepName);
         if (it == virtualEndpoints.end()) {
             /* If the virtual endpoint was lost, continue to the next virtual endpoint */
-            it = virtualEndpoints.upper_bound(vepName);
             continue;
         }
 
@@ -2860,8 +3981,8 @@ void AllJoynObj::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
             /* The last b2b endpoint was removed from this vep. */
             String exitingEpName = it->second->GetUniqueName();
 
-            /* Let directly connected daemons know that this virtual endpoint is gone. */
-            map<qcc::StringMapKey, RemoteEndpoint>::iterator it2 = b2bEndpoints.begin();
+            /* Let directly connected daemons know that this virtual endpoint is gone, a leaf never told them of it */
+            map<qcc::StringMapKey, RemoteEndpoint>::iterator it2 = isLeaf ? b2bEndpoints.end() : b2bEndpoints.begin();
             const qcc::GUID128& otherSideGuid = endpoint->GetRemoteGUID();
             while ((it2 != b2bEndpoints.end()) && (it != virtualEndpoints.end())) {
                 if ((it2->second != endpoint) && (it2->second->GetRemoteGUID() != otherSideGuid)) {
@@ -2906,15 +4027,10 @@ void AllJoynObj::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
 
             /* Remove virtual endpoint with no more b2b eps */
             if (it != virtualEndpoints.end()) {
-                String vepName = it->first;
                 ReleaseLocks();
                 RemoveVirtualEndpoint(vepName);
                 AcquireLocks();
-                it = virtualEndpoints.upper_bound(vepName);
             }
-
-        } else {
-            ++it;
         }
     }
 
@@ -2932,40 +4048,62 @@ QStatus AllJoynObj::ExchangeNames(RemoteEndpoint& endpoint)
     AcquireLocks();
     router.GetUniqueNamesAndAliases(names);
 
+    /* Send all endpoint info except for endpoints related to destination */
+    vector<pair<qcc::String, vector<qcc::String> > >::iterator it = names.begin();
+    while (it != names.end()) {
+        BusEndpoint ep = router.FindEndpoint(it->first);
+        bool isVirtual = ep->IsValid() && (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL);
+        if (ep->IsValid() && (!isVirtual || (!isLeaf && VirtualEndpoint::cast(ep)->CanRouteWithout(endpoint->GetRemoteGUID())))) {
+            ++it;
+        } else {
+            it = names.erase(it);
+        }
+    }
+    Message exchangeMsg(bus);
+    status = ComposeExchangeNames(names, exchangeMsg);
+    if (ER_OK == status) {
+        ReleaseLocks();
+        status = endpoint->PushMessage(exchangeMsg);
+        AcquireLocks();
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to send ExchangeName signal"));
+    }
+    ReleaseLocks();
+    return status;
+}
+
+QStatus AllJoynObj::ComposeExchangeNames(const vector<pair<qcc::String, vector<qcc::String> > >& names, Message& exchangeMsg)
+{
     MsgArg argArray(ALLJOYN_ARRAY);
     MsgArg* entries = new MsgArg[names.size()];
     size_t numEntries = 0;
     vector<pair<qcc::String, vector<qcc::String> > >::const_iterator it = names.begin();
 
-    /* Send all endpoint info except for endpoints related to destination */
     while (it != names.end()) {
-        BusEndpoint ep = router.FindEndpoint(it->first);
-        if ((ep->IsValid() && ((ep->GetEndpointType() != ENDPOINT_TYPE_VIRTUAL) || VirtualEndpoint::cast(ep)->CanRouteWithout(endpoint->GetRemoteGUID())))) {
-            MsgArg* aliasNames = new MsgArg[it->second.size()];
-            vector<qcc::String>::const_iterator ait = it->second.begin();
-            size_t numAliases = 0;
-            while (ait != it->second.end()) {
-                /* Send exportable endpoints */
-                aliasNames[numAliases++].Set("s", ait->c_str());
-                ++ait;
-            }
-            if (0 < numAliases) {
-                entries[numEntries].Set("(sa*)", it->first.c_str(), numAliases, aliasNames);
-                /*
-                 * Set ownwership flag so entries array destructor will free inner message args.
-                 */
-                entries[numEntries].SetOwnershipFlags(MsgArg::OwnsArgs, true);
-            } else {
-                entries[numEntries].Set("(sas)", it->first.c_str(), 0, NULL);
-                delete[] aliasNames;
-            }
-            ++numEntries;
+        MsgArg* aliasNames = new MsgArg[it->second.size()];
+        vector<qcc::String>::const_iterator ait = it->second.begin();
+        size_t numAliases = 0;
+        while (ait != it->second.end()) {
+            /* Send exportable endpoints */
+            aliasNames[numAliases++].Set("s", ait->c_str());
+            ++ait;
         }
+        if (0 < numAliases) {
+            entries[numEntries].Set("(sa*)", it->first.c_str(), numAliases, aliasNames);
+            /*
+             * Set ownwership flag so entries array destructor will free inner message args.
+             */
+            entries[numEntries].SetOwnershipFlags(MsgArg::OwnsArgs, true);
+        } else {
+            entries[numEntries].Set("(sas)", it->first.c_str(), 0, NULL);
+            delete[] aliasNames;
+        }
+        ++numEntries;
         ++it;
     }
-    status = argArray.Set("a(sas)", numEntries, entries);
+    QStatus status = argArray.Set("a(sas)", numEntries, entries);
     if (ER_OK == status) {
-        Message exchangeMsg(bus);
         status = exchangeMsg->SignalMsg("a(sas)",
                                         org::alljoyn::Daemon::WellKnownName,
                                         0,
@@ -2976,16 +4114,7 @@ QStatus AllJoynObj::ExchangeNames(RemoteEndpoint& endpoint)
                                         1,
                                         0,
                                         0);
-        if (ER_OK == status) {
-            ReleaseLocks();
-            status = endpoint->PushMessage(exchangeMsg);
-            AcquireLocks();
-        }
-    }
-    if (status != ER_OK) {
-        QCC_LogError(status, ("Failed to send ExchangeName signal"));
     }
-    ReleaseLocks();
 
     /*
      * This will also free the inner MsgArgs.
@@ -2994,11 +4123,54 @@ QStatus AllJoynObj::ExchangeNames(RemoteEndpoint& endpoint)
     return status;
 }
 
+QStatus AllJoynObj::SendRuleDigest(RemoteEndpoint& endpoint, const RuleDigest& digest)
+{
+    QCC_DbgTrace(("AllJoynObj::SendRuleDigest(endpoint = %s)", endpoint->GetUniqueName().c_str()));
+
+    MsgArg args[2];
+    digest.Get(args);
+    Message digestMsg(bus);
+    QStatus status = digestMsg->SignalMsg("bay",
+                                          org::alljoyn::Daemon::WellKnownName,
+                                          0,
+                                          org::alljoyn::Daemon::ObjectPath,
+                                          org::alljoyn::Daemon::InterfaceName,
+                                          "RuleDigest",
+                                          args,
+                                          ArraySize(args),
+                                          0,
+                                          0);
+    if (ER_OK == status) {
+        status = endpoint->PushMessage(digestMsg);
+    }
+    if (ER_OK != status) {
+        QCC_LogError(status, ("Failed to send RuleDigest signal"));
+    }
+    return status;
+}
+
+void AllJoynObj::RuleDigestSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg)
+{
+    QCC_DbgTrace(("AllJoynObj::RuleDigestSignalHandler(msg sender = \"%s\")", msg->GetSender()));
+
+    size_t numArgs;
+    const MsgArg* args;
+    msg->GetArgs(numArgs, args);
+    RuleDigest digest;
+    QStatus status = (numArgs == 2) ? digest.Set(args) : ER_BUS_BAD_SIGNATURE;
+    if (ER_OK == status) {
+        router.SetRuleDigest(msg->GetRcvEndpointName(), digest);
+    } else {
+        QCC_LogError(status, ("Invalid RuleDigest signal from %s", msg->GetSender()));
+    }
+}
+
 void AllJoynObj::ExchangeNamesSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg)
 {
     QCC_DbgTrace(("AllJoynObj::ExchangeNamesSignalHandler(msg sender = \"%s\")", msg->GetSender()));
 
-    bool madeChanges = false;
+    /* Only the names and aliases that were new to this daemon are propagated */
+    map<qcc::String, vector<qcc::String> > changedNames;
     size_t numArgs;
     const MsgArg* args;
     msg->GetArgs(numArgs, args);
@@ -3047,7 +4219,7 @@ void AllJoynObj::ExchangeNamesSignalHandler(const InterfaceDescription::Member*
                     }
 
                     if (madeChange) {
-                        madeChanges = true;
+                        changedNames.insert(pair<qcc::String, vector<qcc::String> >(uniqueName, vector<qcc::String>()));
                     }
 
                     /* Add virtual aliases (remote well-known names) */
@@ -3065,7 +4237,7 @@ void AllJoynObj::ExchangeNamesSignalHandler(const InterfaceDescription::Member*
                                 break;
                             }
                             if (madeChange) {
-                                madeChanges = true;
+                                changedNames[uniqueName].push_back(aliasItems[j].v_string.str);
                             }
                         }
                     }
@@ -3085,20 +4257,29 @@ void AllJoynObj::ExchangeNamesSignalHandler(const InterfaceDescription::Member*
     }
     ReleaseLocks();
 
-    /* If there were changes, forward message to all directly connected controllers except the one that
-     * sent us this ExchangeNames
+    /* If there were changes, forward them to all directly connected controllers except the one that
+     * sent us this ExchangeNames. A daemon that connects later gets the complete list from ExchangeNames().
      */
-    if (madeChanges) {
+    Message deltaMsg(bus);
+    if (!changedNames.empty()) {
+        vector<pair<qcc::String, vector<qcc::String> > > delta(changedNames.begin(), changedNames.end());
+        QStatus status = ComposeExchangeNames(delta, deltaMsg);
+        if (ER_OK != status) {
+            QCC_LogError(status, ("Failed to compose ExchangeNames delta"));
+            changedNames.clear();
+        }
+    }
+    if (!changedNames.empty() && !isLeaf) {
         AcquireLocks();
         map<qcc::StringMapKey, RemoteEndpoint>::const_iterator bit = b2bEndpoints.find(msg->GetRcvEndpointName());
         map<qcc::StringMapKey, RemoteEndpoint>::iterator it = b2bEndpoints.begin();
         while (it != b2bEndpoints.end()) {
             if ((bit == b2bEndpoints.end()) || (bit->second->GetRemoteGUID() != it->second->GetRemoteGUID())) {
-                QCC_DbgPrintf(("Propagating ExchangeName signal to %s", it->second->GetUniqueName().c_str()));
+                QCC_DbgPrintf(("Propagating %u ExchangeName changes to %s", static_cast<unsigned int>(changedNames.size()), it->second->GetUniqueName().c_str()));
                 StringMapKey key = it->first;
                 RemoteEndpoint ep = it->second;
                 ReleaseLocks();
-                QStatus status = ep->PushMessage(msg);
+                QStatus status = ep->PushMessage(deltaMsg);
                 if (ER_OK != status) {
                     QCC_LogError(status, ("Failed to forward ExchangeNames to %s", ep->GetUniqueName().c_str()));
                 }
@@ -3193,7 +4374,7 @@ void AllJoynObj::NameChangedSignalHandler(const InterfaceDescription::Member* me
         ReleaseLocks();
     }
 
-    if (madeChanges) {
+    if (madeChanges && !isLeaf) {
         /* Forward message to all directly connected controllers except the one that sent us this NameChanged */
         AcquireLocks();
         map<qcc::StringMapKey, RemoteEndpoint>::const_iterator bit = b2bEndpoints.find(msg->GetRcvEndpointName());
@@ -3249,6 +4430,8 @@ void AllJoynObj::AddVirtualEndpoint(const qcc::String& uniqueName, const String&
     }
 
     if (busToBusEndpoint->IsValid()) {
+        b2bVirtualEndpoints.insert(pair<String, String>(b2bEpName, uniqueName));
+        virtualEndpointB2Bs.insert(pair<String, String>(uniqueName, b2bEpName));
         VirtualEndpoint vep;
         if (it == virtualEndpoints.end()) {
             vep = VirtualEndpoint(uniqueName, busToBusEndpoint);
@@ -3287,6 +4470,11 @@ void AllJoynObj::RemoveVirtualEndpoint(const String& vepName)
     if (it != virtualEndpoints.end()) {
         VirtualEndpoint vep = it->second;
         virtualEndpoints.erase(it);
+        set<pair<String, String> >::iterator vbit = virtualEndpointB2Bs.lower_bound(pair<String, String>(vepName, String()));
+        while ((vbit != virtualEndpointB2Bs.end()) && (vbit->first == vepName)) {
+            b2bVirtualEndpoints.erase(pair<String, String>(vbit->second, vepName));
+            virtualEndpointB2Bs.erase(vbit++);
+        }
         ReleaseLocks();
     } else {
         ReleaseLocks();
@@ -3333,67 +4521,83 @@ void AllJoynObj::NameOwnerChanged(const qcc::String& alias, const qcc::String* o
         AcquireLocks();
         vector<pair<String, SessionId> > changedSessionMembers;
         vector<SessionMapEntry> sessionsLost;
-        SessionMapType::iterator it = sessionMap.begin();
-        while (it != sessionMap.end()) {
-            if (it->first.first == alias) {
-                /* If endpoint has gone then just delete the session map entry */
-                sessionMap.erase(it++);
-            } else if (it->first.second != 0) {
-                /* Remove member entries from existing sessions */
-                if (it->second.sessionHost == alias) {
-                    if (it->second.opts.isMultipoint) {
-                        changedSessionMembers.push_back(it->first);
-                    }
-                    it->second.sessionHost.clear();
-                } else {
-                    vector<String>::iterator mit = it->second.memberNames.begin();
-                    while (mit != it->second.memberNames.end()) {
-                        if (*mit == alias) {
-                            it->second.memberNames.erase(mit);
-                            if (it->second.opts.isMultipoint) {
-                                changedSessionMembers.push_back(it->first);
+
+        /* Only the entries of alias and the sessions it is a host or member of are affected */
+        set<pair<String, SessionId> > keys;
+        SessionMapType::iterator it = SessionMapLowerBound(alias, 0);
+        while ((it != sessionMap.end()) && (it->first.first == alias)) {
+            keys.insert(it->first);
+            ++it;
+        }
+        set<pair<String, SessionId> >::iterator nit = sessionNameIndex.lower_bound(pair<String, SessionId>(alias, 0));
+        while ((nit != sessionNameIndex.end()) && (nit->first == alias)) {
+            SessionMapKeysForId(nit->second, keys);
+            sessionNameIndex.erase(nit++);
+        }
+
+        for (set<pair<String, SessionId> >::const_iterator kit = keys.begin(); kit != keys.end(); ++kit) {
+            it = sessionMap.lower_bound(*kit);
+            while ((it != sessionMap.end()) && (it->first == *kit)) {
+                if (it->first.first == alias) {
+                    /* If endpoint has gone then just delete the session map entry */
+                    SessionMapErase(it++);
+                } else if (it->first.second != 0) {
+                    /* Remove member entries from existing sessions */
+                    if (it->second.sessionHost == alias) {
+                        if (it->second.opts.isMultipoint) {
+                            changedSessionMembers.push_back(it->first);
+                        }
+                        it->second.sessionHost.clear();
+                    } else {
+                        vector<String>::iterator mit = it->second.memberNames.begin();
+                        while (mit != it->second.memberNames.end()) {
+                            if (*mit == alias) {
+                                it->second.memberNames.erase(mit);
+                                if (it->second.opts.isMultipoint) {
+                                    changedSessionMembers.push_back(it->first);
+                                }
+                                break;
                             }
-                            break;
+                            ++mit;
                         }
-                        ++mit;
                     }
-                }
-                /*
-                 * Remove empty session entry.
-                 * Preserve raw sessions until GetSessionFd is called.
-                 */
-                /*
-                 * If the session is point-to-point and the memberNames are empty.
-                 * if the sessionHost is not empty (implied) and there are no member names send
-                 * the  sessionLost signal as long as the session is not a raw session
-                 */
-                bool noMemberSingleHost = it->second.memberNames.empty();
-                /*
-                 * If the session is a Multipoint session it will list its own unique
-                 * name in the list of memberNames. If There is only one name in the
-                 * memberNames list and there is no session host it is safe to send
-                 * the session lost signal as long as the session does not contain a
-                 * raw session.
-                 */
-                bool singleMemberNoHost = ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty());
-                /*
-                 * as long as the file descriptor is -1 this is not a raw session
-                 */
-                bool noRawSession = (it->second.fd == -1);
-                if ((noMemberSingleHost || singleMemberNoHost) && noRawSession) {
-                    SessionMapEntry tsme = it->second;
-                    pair<String, SessionId> key = it->first;
-                    if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
+                    /*
+                     * Remove empty session entry.
+                     * Preserve raw sessions until GetSessionFd is called.
+                     */
+                    /*
+                     * If the session is point-to-point and the memberNames are empty.
+                     * if the sessionHost is not empty (implied) and there are no member names send
+                     * the  sessionLost signal as long as the session is not a raw session
+                     */
+                    bool noMemberSingleHost = it->second.memberNames.empty();
+                    /*
+                     * If the session is a Multipoint session it will list its own unique
+                     * name in the list of memberNames. If There is only one name in the
+                     * memberNames list and there is no session host it is safe to send
+                     * the session lost signal as long as the session does not contain a
+                     * raw session.
+                     */
+                    bool singleMemberNoHost = ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty());
+                    /*
+                     * as long as the file descriptor is -1 this is not a raw session
+                     */
+                    bool noRawSession = (it->second.fd == -1);
+                    if ((noMemberSingleHost || singleMemberNoHost) && noRawSession) {
+                        SessionMapEntry tsme = it->second;
+                        pair<String, SessionId> key = it->first;
+                        if (!it->second.isInitializing) {
+                            SessionMapErase(it++);
+                        } else {
+                            ++it;
+                        }
+                        sessionsLost.push_back(tsme);
                     } else {
                         ++it;
                     }
-                    sessionsLost.push_back(tsme);
                 } else {
                     ++it;
                 }
-            } else {
-                ++it;
             }
         }
         ReleaseLocks();
@@ -3583,6 +4787,8 @@ void AllJoynObj::FoundNames(const qcc::String& busAddr,
                     /* Don't schedule an alarm which will never expire or multiple timers for the same set */
                     if (notimers && (ttl != numeric_limits<uint8_t>::max())) {
                         NameMapEntry& nme = it->second;
+                        AllJoynObj* pObj = this;
+                        nme.alarm = Alarm(TimerSlack::Coalesce(ttl * 1000), pObj, NameMapEntry::truthiness);
                         QStatus status = timer.AddAlarm(nme.alarm);
                         if (ER_OK != status && ER_TIMER_EXITING != status) {
                             QCC_LogError(status, ("Failed to add alarm"));
@@ -3614,7 +4820,7 @@ void AllJoynObj::FoundNames(const qcc::String& busAddr,
                         nme.timestamp = GetTimestamp64();
 
                         /* need to move the alarm ttl seconds into the future. */
-                        const uint32_t timeout = ttl * 1000;
+                        const uint32_t timeout = TimerSlack::Coalesce(ttl * 1000);
                         AllJoynObj* pObj = this;
                         Alarm newAlarm(timeout, pObj, NameMapEntry::truthiness);
                         QStatus status = timer.ReplaceAlarm(nme.alarm, newAlarm, false);
@@ -3695,6 +4901,34 @@ QStatus AllJoynObj::SendFoundAdvertisedName(const String& dest,
 {
     QCC_DbgTrace(("AllJoynObj::SendFoundAdvertisedName(%s, %s, 0x%x, %s)", dest.c_str(), name.c_str(), transport, namePrefix.c_str()));
 
+    /* A discoverer that has just cancelled has no entry, the signal is sent as before */
+    bool wanted = true;
+    foundNameLock.Lock(MUTEX_CONTEXT);
+    map<pair<String, String>, Discoverer>::iterator dit = discoverers.find(pair<String, String>(namePrefix, dest));
+    if (dit != discoverers.end()) {
+        Discoverer& discoverer = dit->second;
+        wanted = discoverer.filters.empty();
+        for (size_t i = 0; !wanted && (i < discoverer.filters.size()); ++i) {
+            wanted = FoundNameMatches(name.c_str(), discoverer.filters[i].c_str());
+        }
+    }
+    if (wanted && (dit != discoverers.end())) {
+        uint64_t now = GetTimestamp64();
+        pair<map<pair<String, TransportMask>, uint64_t>::iterator, bool> ins = dit->second.found.insert(make_pair(make_pair(name, transport), now));
+        if (!ins.second) {
+            if (!foundNameSuppressMs || ((now - ins.first->second) < foundNameSuppressMs)) {
+                wanted = false;
+            } else {
+                ins.first->second = now;
+            }
+        }
+    }
+    foundNameLock.Unlock(MUTEX_CONTEXT);
+    if (!wanted) {
+        QCC_DbgPrintf(("FoundAdvertisedName(%s) to %s suppressed", name.c_str(), dest.c_str()));
+        return ER_OK;
+    }
+
     MsgArg args[3];
     args[0].Set("s", name.c_str());
     args[1].Set("q", transport);
@@ -3722,6 +4956,24 @@ QStatus AllJoynObj::SendLostAdvertisedName(const String& name, TransportMask tra
     }
     ReleaseLocks();
 
+    /* A name that comes back after this is new again */
+    foundNameLock.Lock(MUTEX_CONTEXT);
+    for (size_t i = 0; i < sigVec.size(); ++i) {
+        map<pair<String, String>, Discoverer>::iterator dit = discoverers.find(sigVec[i]);
+        if (dit != discoverers.end()) {
+            map<pair<String, TransportMask>, uint64_t>& found = dit->second.found;
+            map<pair<String, TransportMask>, uint64_t>::iterator fit = found.lower_bound(make_pair(name, static_cast<TransportMask>(0)));
+            while ((fit != found.end()) && (fit->first.first == name)) {
+                if (fit->first.second & transport) {
+                    found.erase(fit++);
+                } else {
+                    ++fit;
+                }
+            }
+        }
+    }
+    foundNameLock.Unlock(MUTEX_CONTEXT);
+
     /* Send the signals now that we aren't holding the lock */
     vector<pair<String, String> >::const_iterator it = sigVec.begin();
     while (it != sigVec.end()) {
@@ -3812,6 +5064,102 @@ void AllJoynObj::CancelSessionlessMessage(const InterfaceDescription::Member* me
     }
 }
 
+void AllJoynObj::AddMatches(const InterfaceDescription::Member* member, Message& msg)
+{
+    ChangeMatches(msg, true);
+}
+
+void AllJoynObj::RemoveMatches(const InterfaceDescription::Member* member, Message& msg)
+{
+    ChangeMatches(msg, false);
+}
+
+void AllJoynObj::ChangeMatches(Message& msg, bool add)
+{
+    const char* method = add ? "AddMatches" : "RemoveMatches";
+    size_t numRules = 0;
+    const MsgArg* ruleArgs = NULL;
+    QStatus status = msg->GetArgs("as", &numRules, &ruleArgs);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Bad arguments to org.alljoyn.Bus.%s", method));
+        MethodReply(msg, status);
+        return;
+    }
+    QCC_DbgTrace(("AllJoynObj::%s(%u)", method, numRules));
+
+    /* Rules that do not parse are reported but do not stop the others */
+    vector<QStatus> parsed(numRules);
+    vector<Rule> rules;
+    vector<size_t> ruleIndex;
+    for (size_t i = 0; i < numRules; ++i) {
+        Rule rule(ruleArgs[i].v_string.str, &parsed[i]);
+        if (parsed[i] == ER_OK) {
+            rules.push_back(rule);
+            ruleIndex.push_back(i);
+        }
+    }
+
+    vector<QStatus> results;
+    router.LockNameTable();
+    BusEndpoint ep = router.FindEndpoint(msg->GetSender());
+    if (ep->IsValid()) {
+        if (add) {
+            router.AddRules(ep, rules, results);
+        } else {
+            router.RemoveRules(ep, rules, results);
+        }
+    } else {
+        results.assign(rules.size(), ER_BUS_NO_ENDPOINT);
+    }
+    router.UnlockNameTable();
+
+    vector<uint32_t> statuses(parsed.begin(), parsed.end());
+    for (size_t i = 0; i < results.size(); ++i) {
+        statuses[ruleIndex[i]] = results[i];
+    }
+    MsgArg replyArg;
+    replyArg.Set("au", statuses.size(), statuses.empty() ? NULL : &statuses[0]);
+    status = MethodReply(msg, &replyArg, 1);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to respond to org.alljoyn.Bus.%s", method));
+    }
+}
+
+void AllJoynObj::ReplaceMatches(const InterfaceDescription::Member* member, Message& msg)
+{
+    size_t numRules = 0;
+    const MsgArg* ruleArgs = NULL;
+    QStatus status = msg->GetArgs("as", &numRules, &ruleArgs);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Bad arguments to org.alljoyn.Bus.ReplaceMatches"));
+        MethodReply(msg, status);
+        return;
+    }
+    QCC_DbgTrace(("AllJoynObj::ReplaceMatches(%u)", numRules));
+
+    /* The rule set is replaced as a whole so one bad rule leaves the old set in place */
+    vector<Rule> rules;
+    rules.reserve(numRules);
+    for (size_t i = 0; (status == ER_OK) && (i < numRules); ++i) {
+        rules.push_back(Rule(ruleArgs[i].v_string.str, &status));
+    }
+    if (status == ER_OK) {
+        router.LockNameTable();
+        BusEndpoint ep = router.FindEndpoint(msg->GetSender());
+        status = ep->IsValid() ? router.ReplaceRules(ep, rules) : ER_BUS_NO_ENDPOINT;
+        router.UnlockNameTable();
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("AllJoynObj::ReplaceMatches failed"));
+    }
+
+    MsgArg replyArg("u", static_cast<uint32_t>(status));
+    status = MethodReply(msg, &replyArg, 1);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to respond to org.alljoyn.Bus.ReplaceMatches"));
+    }
+}
+
 
 void AllJoynObj::BusConnectionLost(const qcc::String& busAddr)
 {
@@ -25,16 +25,20 @@
 #include <qcc/platform.h>
 #include <vector>
 #include <map>
+#include <set>
 
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 #include <qcc/StringMapKey.h>
 #include <qcc/Thread.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
 #include <qcc/time.h>
 #include <qcc/SocketTypes.h>
 #include <qcc/Timer.h>
 #include <qcc/GUID.h>
 
+#include <alljoyn/AllJoynStd.h>
 #include <alljoyn/BusObject.h>
 #include <alljoyn/Message.h>
 
@@ -44,6 +48,7 @@
 #include "Transport.h"
 #include "VirtualEndpoint.h"
 #include "PermissionMgr.h"
+#include "RuleDigest.h"
 
 namespace ajn {
 
@@ -58,6 +63,68 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
     friend class _RemoteEndpoint;
 
   public:
+    /**
+     * Stages of handling a JoinSession or AttachSession request.
+     */
+    enum JoinSessionStage {
+        JOIN_STAGE_QUEUED = 0,   /**< Waiting for a dispatcher thread */
+        JOIN_STAGE_CONNECT,      /**< Connecting to the session host's daemon */
+        JOIN_STAGE_ATTACH,       /**< Waiting for AttachSession replies */
+        JOIN_STAGE_REPLY,        /**< Sending the reply */
+        JOIN_STAGE_TOTAL,        /**< The whole request, including time spent queued */
+        JOIN_STAGE_COUNT
+    };
+
+    /**
+     * Latency of one JoinSessionStage.
+     */
+    struct JoinStageLatency {
+        uint32_t count;          /**< Number of times the stage was completed */
+        uint64_t totalMs;        /**< Total time spent in the stage */
+        uint32_t maxMs;          /**< Longest time spent in the stage */
+    };
+
+    /**
+     * Counters for JoinSession and AttachSession requests.
+     */
+    struct JoinSessionStats {
+        uint32_t queued;         /**< Requests waiting for a dispatcher thread */
+        uint32_t active;         /**< Requests currently being handled */
+        JoinStageLatency stages[JOIN_STAGE_COUNT];  /**< Latency of each stage, indexed by JoinSessionStage */
+    };
+
+    /**
+     * When JoinSession may route a new session over an existing bus-to-bus connection.
+     */
+    enum B2BReusePolicy {
+        B2B_REUSE_SAME_SESSION = 0,  /**< Only members joining the same multipoint session share a connection */
+        B2B_REUSE_MESSAGES           /**< Message based sessions with the same remote daemon share pooled connections */
+    };
+
+    /**
+     * Occupancy of the pool of bus-to-bus connections opened by JoinSession.
+     */
+    struct B2BPoolStats {
+        uint32_t links;          /**< Connections in the pool */
+        uint32_t idleLinks;      /**< Connections in the pool that carry no session */
+        uint32_t sessions;       /**< Sessions carried by connections in the pool */
+        uint32_t reuses;         /**< Joins that were routed over a pooled connection */
+        uint32_t connects;       /**< Joins that opened a connection for the pool */
+    };
+
+    /**
+     * Time taken by one transport to carry out the advertisement and discovery changes
+     * dispatched to it.
+     */
+    struct TransportOpStats {
+        qcc::String transport;   /**< Name of the transport */
+        uint32_t queued;         /**< Changes waiting for the transport */
+        uint32_t count;          /**< Changes carried out */
+        uint64_t totalMs;        /**< Total time spent in the transport */
+        uint32_t maxMs;          /**< Longest time spent in the transport */
+        uint32_t maxQueuedMs;    /**< Longest time a change waited behind earlier changes */
+    };
+
     /**
      * Constructor
      *
@@ -98,6 +165,28 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void ObjectRegistered(void);
 
+    /**
+     * Get the JoinSession and AttachSession counters.
+     *
+     * @param stats  Returns the counters.
+     */
+    void GetJoinSessionStats(JoinSessionStats& stats);
+
+    /**
+     * Get the occupancy of the bus-to-bus connection pool.
+     *
+     * @param stats  Returns the occupancy counters.
+     */
+    void GetB2BPoolStats(B2BPoolStats& stats);
+
+    /**
+     * Get the timing of the advertisement and discovery changes of each transport that has
+     * been asked to make any.
+     *
+     * @param stats  Returns one entry per transport.
+     */
+    void GetTransportOpStats(std::vector<TransportOpStats>& stats);
+
     /**
      * Respond to a bus request to bind a SessionPort.
      *
@@ -146,6 +235,22 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void JoinSession(const InterfaceDescription::Member* member, Message& msg);
 
+    /**
+     * Respond to a bus request to join several sessions with one call.
+     *
+     * The input Message (METHOD_CALL) is expected to contain the following parameters:
+     *   joins        array of struct   The sessionHost, sessionPort and opts of each join,
+     *                                  as for JoinSession.
+     *
+     * The output Message (METHOD_REPLY) contains the following parameters:
+     *   results      array of struct   The resultCode, sessionId and opts of each join in
+     *                                  the order of the joins, as for JoinSession.
+     *
+     * @param member  Member.
+     * @param msg     The incoming message.
+     */
+    void JoinSessions(const InterfaceDescription::Member* member, Message& msg);
+
     /**
      * Respond to a bus request to leave a previously joined or created session.
      *
@@ -219,6 +324,22 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void FindAdvertisedNameByTransport(const InterfaceDescription::Member* member, Message& msg);
 
+    /**
+     * Respond to a bus request to discover names, limited by filters, over a set of transports.
+     *
+     * The input Message (METHOD_CALL) is expected to contain the following parameters:
+     *   namePrefix   string   Well-known name prefix.
+     *   transports   uint16   The transports to discover over.
+     *   filters      string[] Well-known names or wildcard patterns that found names must match.
+     *
+     * The output Message (METHOD_REPLY) contains the following parameters:
+     *   resultCode   uint32   A ALLJOYN_FINDADVERTISEDNAME_* reply code (see AllJoynStd.h).
+     *
+     * @param member  Member.
+     * @param msg     The incoming message.
+     */
+    void FindAdvertisedNameFiltered(const InterfaceDescription::Member* member, Message& msg);
+
     /**
      * Respond to a bus request to cancel a previous (successful) FindName request.
      *
@@ -352,6 +473,49 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void CancelSessionlessMessage(const InterfaceDescription::Member* member, Message& msg);
 
+    /**
+     * Respond to a bus request to add several match rules with one call.
+     *
+     * The input Message (METHOD_CALL) is expected to contain the following parameters:
+     *   rules      array of string   The match rules, as for org.freedesktop.DBus.AddMatch.
+     *
+     * The output Message (METHOD_REPLY) contains the following parameters:
+     *   statuses   array of uint32   The QStatus of each rule in the order of the rules.
+     *
+     * @param member  Member.
+     * @param msg     The incoming message.
+     */
+    void AddMatches(const InterfaceDescription::Member* member, Message& msg);
+
+    /**
+     * Respond to a bus request to remove several match rules with one call.
+     *
+     * The input Message (METHOD_CALL) is expected to contain the following parameters:
+     *   rules      array of string   The match rules, as for org.freedesktop.DBus.RemoveMatch.
+     *
+     * The output Message (METHOD_REPLY) contains the following parameters:
+     *   statuses   array of uint32   The QStatus of each rule in the order of the rules.
+     *
+     * @param member  Member.
+     * @param msg     The incoming message.
+     */
+    void RemoveMatches(const InterfaceDescription::Member* member, Message& msg);
+
+    /**
+     * Respond to a bus request to replace all of the sender's match rules. Nothing is changed
+     * unless every rule can be parsed.
+     *
+     * The input Message (METHOD_CALL) is expected to contain the following parameters:
+     *   rules      array of string   The new match rules, which may be empty.
+     *
+     * The output Message (METHOD_REPLY) contains the following parameters:
+     *   status     uint32            ER_OK or the QStatus of the failure.
+     *
+     * @param member  Member.
+     * @param msg     The incoming message.
+     */
+    void ReplaceMatches(const InterfaceDescription::Member* member, Message& msg);
+
     /**
      * Add a new Bus-to-bus endpoint.
      *
@@ -367,6 +531,16 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void RemoveBusToBusEndpoint(RemoteEndpoint& endpoint);
 
+    /**
+     * Tell the daemon at the other end of a bus-to-bus endpoint which global broadcast signals
+     * are wanted behind this daemon.
+     *
+     * @param endpoint  Bus-to-bus endpoint to send the RuleDigest signal on.
+     * @param digest    The digest of the match rules reachable without going through endpoint.
+     * @return  ER_OK if successful.
+     */
+    QStatus SendRuleDigest(RemoteEndpoint& endpoint, const RuleDigest& digest);
+
     /**
      * Respond to a remote daemon request to attach a session through this daemon.
      *
@@ -412,6 +586,15 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void ExchangeNamesSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
 
+    /**
+     * Process incoming RuleDigest signals from remote daemons.
+     *
+     * @param member        Interface member for signal
+     * @param sourcePath    object path sending the signal.
+     * @param msg           The signal message.
+     */
+    void RuleDigestSignalHandler(const InterfaceDescription::Member* member, const char* sourcePath, Message& msg);
+
     /**
      * Process incoming NameChanged signals from remote daemons.
      *
@@ -478,6 +661,7 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
     const InterfaceDescription::Member* sessionLostSignal; /**< org.alljoyn.Bus.SessionLost signal */
     const InterfaceDescription::Member* mpSessionChangedSignal;  /**< org.alljoyn.Bus.MPSessionChanged signal */
     const InterfaceDescription::Member* mpSessionJoinedSignal;  /**< org.alljoyn.Bus.JoinSession signal */
+    const InterfaceDescription::Member* directPathSignal;  /**< org.alljoyn.Bus.Peer.Session.DirectPath signal */
 
     /** Map of open connectSpecs to local endpoint name(s) that require the connection. */
     std::multimap<qcc::String, qcc::String> connectMap;
@@ -488,6 +672,17 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
     /** Map of active discovery names to requesting local endpoint's permitted transport mask(s) and name(s) */
     std::multimap<qcc::String, std::pair<TransportMask, qcc::String> > discoverMap;
 
+    /** What has been reported to one local endpoint discovering one name prefix */
+    struct Discoverer {
+        std::vector<qcc::String> filters;                                 /**< Names or wildcard patterns to report, empty for all */
+        std::map<std::pair<qcc::String, TransportMask>, uint64_t> found;  /**< When each found name was last reported */
+    };
+
+    /** Map of (name prefix, local endpoint name) to discoverer state (protected by foundNameLock) */
+    std::map<std::pair<qcc::String, qcc::String>, Discoverer> discoverers;
+    qcc::Mutex foundNameLock;        /**< Protects discoverers, never held while calling out */
+    uint32_t foundNameSuppressMs;    /**< Repeats of a found name are dropped for this long, 0 for as long as it is not lost */
+
     /** Map of discovered bus names (protected by discoverMapLock) */
     struct NameMapEntry {
         qcc::String busAddr;
@@ -534,6 +729,16 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
 
     SessionMapType sessionMap;  /**< Map (endpointName,sessionId) to session info */
 
+    /*
+     * Secondary indexes of sessionMap so that the entries touched when an endpoint leaves can be
+     * found without walking the whole map. sessionIdIndex holds the key of every entry ordered by
+     * session id. sessionNameIndex holds the sessionHost and memberNames of every entry with a
+     * non-zero id. It may hold pairs for members that have since been removed from an entry;
+     * users must check the entries they find.
+     */
+    std::set<std::pair<SessionId, qcc::String> > sessionIdIndex;    /**< (sessionId,endpointName) of each sessionMap entry */
+    std::set<std::pair<qcc::String, SessionId> > sessionNameIndex;  /**< (host or member name,sessionId) of sessionMap entries */
+
     /*
      * Helper function to get session map interator
      */
@@ -554,6 +759,21 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void SessionMapErase(SessionMapEntry& sme);
 
+    /**
+     * Helper function to erase a single sesssion map entry
+     */
+    void SessionMapErase(SessionMapType::iterator it);
+
+    /**
+     * Helper function to add a member to a session map entry
+     */
+    void SessionMapAddMember(SessionMapEntry& sme, const qcc::String& member);
+
+    /**
+     * Helper function to get the keys of the session map entries with a session id
+     */
+    void SessionMapKeysForId(SessionId id, std::set<std::pair<qcc::String, SessionId> >& keys);
+
     const qcc::GUID128& guid;                                  /**< Global GUID of this daemon */
 
     const InterfaceDescription::Member* exchangeNamesSignal;   /**< org.alljoyn.Daemon.ExchangeNames signal member */
@@ -561,11 +781,19 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
 
     std::map<qcc::String, VirtualEndpoint> virtualEndpoints;   /**< Map of endpoints that reside behind a connected AllJoyn daemon */
 
+    /*
+     * Index of the virtual endpoints routed through each bus-to-bus endpoint, kept in both
+     * directions. Pairs are added by AddVirtualEndpoint() and only removed when either endpoint
+     * goes away so a pair may outlive the route; users must check CanUseRoute().
+     */
+    std::set<std::pair<qcc::String, qcc::String> > b2bVirtualEndpoints;  /**< (b2bEpName,vepName) pairs */
+    std::set<std::pair<qcc::String, qcc::String> > virtualEndpointB2Bs;  /**< (vepName,b2bEpName) pairs */
+
     std::map<qcc::StringMapKey, RemoteEndpoint> b2bEndpoints;  /**< Map of bus-to-bus endpoints that are connected to external daemons */
 
     std::multimap<qcc::String, std::pair<qcc::String, TransportMask> > advAliasMap;  /**< Map remote daemon guid/transport to advertised name alias */
 
-    qcc::Timer timer;           /**< Timer object for reaping expired names */
+    qcc::Timer timer;           /**< Timer object for reaping expired names and idle pooled connections */
 
     /**
      * Name reaper timeout alarm handler.
@@ -574,33 +802,298 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
 
-    /** JoinSessionThread handles a JoinSession request from a local client on a separate thread */
-    class JoinSessionThread : public qcc::Thread, public qcc::ThreadListener {
+    /** The outcome of one join, kept until the reply that carries it has been sent */
+    struct JoinResult {
+        uint32_t replyCode;      /**< ALLJOYN_JOINSESSION_* reply code */
+        SessionId id;            /**< The session joined */
+        SessionPort sessionPort; /**< The port that was joined */
+        SessionOpts optsOut;     /**< Final session options */
+        SessionMapEntry sme;     /**< The session host's entry when the host is attached to this daemon */
+        bool localHost;          /**< True if the host is attached to this daemon */
+        JoinResult() : replyCode(ALLJOYN_JOINSESSION_REPLY_FAILED), id(0), sessionPort(0), localHost(false) { }
+    };
+
+    /** A JoinSessions request whose joins are shared out among several JoinSessionRequests */
+    struct JoinSessionBatch {
+        Message msg;                       /**< The request */
+        const MsgArg* joins;               /**< The joins, held by msg */
+        std::vector<JoinResult> results;   /**< The result of each join */
+        volatile int32_t pending;          /**< JoinSessionRequests that have not finished */
+        JoinSessionBatch(const Message& msg, const MsgArg* joins, size_t numJoins) :
+            msg(msg), joins(joins), results(numJoins), pending(0) { }
+    };
+
+    /**
+     * JoinSessionRequest handles a JoinSession or AttachSession request, or a group of the joins
+     * of a JoinSessions request, on a dispatcher thread.
+     */
+    class JoinSessionRequest {
       public:
-        JoinSessionThread(AllJoynObj& ajObj, const Message& msg, bool isJoin) :
-            qcc::Thread(qcc::String("JoinS-") + qcc::U32ToString(qcc::IncrementAndFetch(&jstCount))),
+        JoinSessionRequest(AllJoynObj& ajObj, const Message& msg, bool isJoin) :
             ajObj(ajObj),
             msg(msg),
-            isJoin(isJoin) { }
+            isJoin(isJoin),
+            batch(NULL),
+            queuedAt(qcc::GetTimestamp64()) { }
 
-        void ThreadExit(Thread* thread);
+        JoinSessionRequest(AllJoynObj& ajObj, JoinSessionBatch* batch) :
+            ajObj(ajObj),
+            msg(batch->msg),
+            isJoin(true),
+            batch(batch),
+            queuedAt(qcc::GetTimestamp64()) { }
 
-      protected:
-        qcc::ThreadReturn STDCALL Run(void* arg);
+        ~JoinSessionRequest();
+
+        void Run();
+
+        bool IsJoin() const { return isJoin; }
+
+        /** Add a join of the batch, by index, to the ones run by this request */
+        void AddJoin(size_t index) { joins.push_back(index); }
 
       private:
-        static int jstCount;
-        qcc::ThreadReturn STDCALL RunJoin();
-        qcc::ThreadReturn STDCALL RunAttach();
+        void RunJoin(const MsgArg* joinArgs, JoinResult& result);
+        void RunAttach();
 
         AllJoynObj& ajObj;
         Message msg;
         bool isJoin;
+        JoinSessionBatch* batch;
+        std::vector<size_t> joins;
+        uint64_t queuedAt;
     };
 
-    std::vector<JoinSessionThread*> joinSessionThreads;  /**< List of outstanding join session requests */
-    qcc::Mutex joinSessionThreadsLock;                   /**< Lock that protects joinSessionThreads */
+    /** Runs JoinSessionRequests that are triggered on joinSessionDispatcher and attachSessionDispatcher */
+    class JoinSessionListener : public qcc::AlarmListener {
+      public:
+        JoinSessionListener(AllJoynObj& ajObj) : ajObj(ajObj) { }
+
+      private:
+        void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+        AllJoynObj& ajObj;
+    };
+
+    /**
+     * Queue a JoinSession or AttachSession request for a dispatcher thread.
+     *
+     * @param msg     The request.
+     * @param isJoin  True for JoinSession, false for AttachSession.
+     */
+    void DispatchJoinSession(Message& msg, bool isJoin);
+
+    /**
+     * Queue a JoinSessionRequest for a dispatcher thread. The request is deleted if it cannot be queued.
+     *
+     * @param req  The request.
+     */
+    void DispatchJoinSession(JoinSessionRequest* req);
+
+    /**
+     * Reply to a JoinSessions request once all of its joins have finished, then send the
+     * signals that follow each successful join.
+     *
+     * @param batch  The finished request.
+     */
+    void ReplyJoinSessions(JoinSessionBatch& batch);
+
+    /**
+     * Parse the rules of an AddMatches or RemoveMatches request and apply them for the sender.
+     *
+     * @param msg     The incoming message.
+     * @param add     true to add the rules, false to remove them.
+     */
+    void ChangeMatches(Message& msg, bool add);
+
+    /**
+     * Send the SessionJoined and MPSessionChanged signals that follow the reply to a successful join.
+     *
+     * @param sender  The joiner.
+     * @param result  The outcome of the join.
+     */
+    void SendJoinSignals(const qcc::String& sender, const JoinResult& result);
+
+    /**
+     * Record the time spent in a stage of a JoinSession or AttachSession request.
+     *
+     * @param stage    The stage.
+     * @param startMs  Timestamp taken with qcc::GetTimestamp64() when the stage began.
+     */
+    void RecordJoinStage(JoinSessionStage stage, uint64_t startMs);
+
+    /*
+     * Joins from local clients and attaches from remote daemons are dispatched separately so a
+     * burst of joins waiting on remote attaches cannot starve the attaches other daemons send us.
+     */
+    JoinSessionListener joinSessionListener;             /**< Runs queued join session requests */
+    qcc::Timer joinSessionDispatcher;                    /**< Threads that run JoinSession requests */
+    qcc::Timer attachSessionDispatcher;                  /**< Threads that run AttachSession requests */
+    JoinSessionStats joinSessionStats;                   /**< JoinSession and AttachSession counters */
+    qcc::Mutex joinSessionLock;                          /**< Lock that protects joinSessionStats and isStopping */
     bool isStopping;                                     /**< True while waiting for threads to exit */
+
+    /** An advertisement or discovery change for one transport */
+    struct TransportOp;
+
+    /** Changes made for one AdvertiseName or FindAdvertisedName request */
+    struct TransportOpBatch {
+        qcc::Mutex lock;         /**< Lock that protects pending */
+        uint32_t pending;        /**< Changes that have not finished */
+        qcc::Event done;         /**< Set when the last change finishes */
+        TransportOpBatch() : pending(0) { }
+
+        /** Count a change as finished. The event is set with the lock held since the waiter frees the batch once it sees no changes pending. */
+        void Finished()
+        {
+            lock.Lock(MUTEX_CONTEXT);
+            if (--pending == 0) {
+                done.SetEvent();
+            }
+            lock.Unlock(MUTEX_CONTEXT);
+        }
+    };
+
+    /** Runs TransportOps that are triggered on the dispatcher of their transport */
+    class TransportOpListener : public qcc::AlarmListener {
+      public:
+        TransportOpListener(AllJoynObj& ajObj) : ajObj(ajObj) { }
+
+      private:
+        void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+        AllJoynObj& ajObj;
+    };
+
+    /** The thread that makes the changes of one transport, in the order they were dispatched */
+    struct TransportDispatcher {
+        qcc::Timer* timer;
+        TransportOpStats stats;
+    };
+
+    /**
+     * Queue a change for the dispatcher of its transport. Changes are queued with the locks held
+     * so they reach each transport in the order the advertise and discover maps were changed,
+     * but they are made without the locks so a slow transport does not hold up the others. If
+     * the dispatcher cannot take the change it is made on the calling thread.
+     *
+     * @param op  The change, which is deleted once made.
+     */
+    void DispatchTransportOp(TransportOp* op);
+
+    /**
+     * Make a change and record how long the transport took.
+     *
+     * @param op  The change.
+     */
+    void RunTransportOp(TransportOp& op);
+
+    /**
+     * Wait for every change of a batch to finish. Must not be called with the locks held.
+     *
+     * @param batch  The batch.
+     */
+    void WaitTransportOps(TransportOpBatch& batch);
+
+    /** Dispatchers are created the first time a transport is asked to make a change */
+    std::map<Transport*, TransportDispatcher> transportDispatchers;
+    TransportOpListener transportOpListener;             /**< Runs queued transport changes */
+    qcc::Mutex transportOpLock;                          /**< Lock that protects transportDispatchers and transportOpsStopping */
+    bool transportOpsStopping;                           /**< True once the dispatchers have been stopped */
+
+    /** A bus-to-bus connection opened by JoinSession that later joins may share */
+    struct B2BPoolEntry {
+        RemoteEndpoint ep;       /**< The connection */
+        uint64_t idleSince;      /**< When the connection was first seen carrying no session (0 while in use) */
+        B2BPoolEntry() : idleSince(0) { }
+        B2BPoolEntry(const RemoteEndpoint& ep) : ep(ep), idleSince(0) { }
+    };
+
+    /** Releases idle pooled connections when triggered on timer */
+    class B2BPoolListener : public qcc::AlarmListener {
+      public:
+        B2BPoolListener(AllJoynObj& ajObj) : ajObj(ajObj) { }
+
+      private:
+        void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+        AllJoynObj& ajObj;
+    };
+
+    /**
+     * Check whether a session may be routed over a pooled bus-to-bus connection. Raw sessions
+     * take over the connection's socket and sessionless sessions identify themselves by the
+     * connection's session id, so neither can share one.
+     *
+     * @param sessionPort  The port being joined.
+     * @param opts         Options requested by the joiner.
+     * @return  true iff the session may use the pool.
+     */
+    bool IsB2BPoolable(SessionPort sessionPort, const SessionOpts& opts) const;
+
+    /**
+     * Find the least occupied pooled connection that routes to a session host.
+     * Must be called with the AllJoynObj locks held.
+     *
+     * @param sessionHostEp  Virtual endpoint of the session host.
+     * @param opts           [IN/OUT] Options requested by the joiner. The transports are narrowed to
+     *                       the transport of the returned connection.
+     * @return  The connection or an invalid endpoint if none can carry another session.
+     */
+    RemoteEndpoint FindPooledB2B(VirtualEndpoint& sessionHostEp, SessionOpts& opts);
+
+    /**
+     * Add a connection opened by JoinSession to the pool.
+     * Must be called with the AllJoynObj locks held.
+     *
+     * @param ep  The connection.
+     */
+    void AddPooledB2B(RemoteEndpoint& ep);
+
+    /**
+     * Release pooled connections that have carried no session for b2bIdleLingerMs.
+     */
+    void SweepB2BPool();
+
+    B2BReusePolicy b2bReusePolicy;                       /**< When JoinSession shares bus-to-bus connections */
+    uint32_t b2bMaxSessions;                             /**< Maximum sessions per pooled connection (0 means no limit) */
+    uint32_t b2bIdleLingerMs;                            /**< How long an idle pooled connection is kept open (0 closes it at once) */
+    std::map<qcc::StringMapKey, B2BPoolEntry> b2bPool;   /**< Pooled connections by unique name (protected by the AllJoynObj locks) */
+    uint32_t b2bPoolReuses;                              /**< Joins that were routed over a pooled connection */
+    uint32_t b2bPoolConnects;                            /**< Joins that opened a connection for the pool */
+    bool b2bPoolSweepPending;                            /**< True while a SweepB2BPool() alarm is scheduled */
+    B2BPoolListener b2bPoolListener;                     /**< Runs SweepB2BPool() */
+
+    /** Opens the connections to the hubs when triggered on timer */
+    class HubListener : public qcc::AlarmListener {
+      public:
+        HubListener(AllJoynObj& ajObj) : ajObj(ajObj) { }
+
+      private:
+        void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+        AllJoynObj& ajObj;
+    };
+
+    /**
+     * Find the least occupied hub connection that routes to a session host.
+     * Must be called with the AllJoynObj locks held.
+     *
+     * @param sessionHostEp  Virtual endpoint of the session host.
+     * @param opts           [IN/OUT] Options requested by the joiner. The transports are narrowed to
+     *                       the transport of the returned connection.
+     * @return  The connection or an invalid endpoint if no hub routes to the session host.
+     */
+    RemoteEndpoint FindHubB2B(VirtualEndpoint& sessionHostEp, SessionOpts& opts);
+
+    /**
+     * Open the connections to the configured hubs that are not open.
+     */
+    void ConnectHubs();
+
+    bool isLeaf;                                         /**< True if names are not passed on between bus-to-bus endpoints */
+    std::map<qcc::String, RemoteEndpoint> hubLinks;      /**< Connections by hub connect spec (protected by the AllJoynObj locks) */
+    HubListener hubListener;                             /**< Runs ConnectHubs() */
     BusController* busController;                        /**< BusController that created this BusObject */
 
     /**
@@ -614,7 +1107,8 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
     void ReleaseLocks();
 
     /**
-     * Utility function used to send a single FoundName signal.
+     * Utility function used to send a single FoundName signal. Names excluded by the filters of
+     * the destination, or already reported to it within foundNameSuppressMs, are not sent.
      *
      * @param dest        Unique name of destination.
      * @param name        Well-known name that was found.
@@ -698,6 +1192,19 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
                               const char* joinerName,
                               const char* creatorName);
 
+    /**
+     * Utility method used to send one end of a direct path to a session member.
+     *
+     * @param sessionId   Session carried by the direct path.
+     * @param peerName    Unique name of the member at the other end of the path.
+     * @param fd          This member's end of the socket pair.
+     * @param destName    Unique name of the member receiving the path.
+     */
+    QStatus SendDirectPath(SessionId sessionId,
+                           const char* peerName,
+                           qcc::SocketFd fd,
+                           const char* destName);
+
     /**
      * Utility method used to send SessionLost signal to locally attached endpoint.
      *
@@ -770,6 +1277,15 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     QStatus ExchangeNames(RemoteEndpoint& endpoint);
 
+    /**
+     * Compose an ExchangeNames signal.
+     *
+     * @param names        Unique names and the aliases of each to put in the signal.
+     * @param exchangeMsg  [OUT] The signal.
+     * @return  ER_OK if successful.
+     */
+    QStatus ComposeExchangeNames(const std::vector<std::pair<qcc::String, std::vector<qcc::String> > >& names, Message& exchangeMsg);
+
     /**
      * Process a request to cancel advertising a name from a given (locally-connected) endpoint.
      *
@@ -795,8 +1311,9 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      *
      * @param msg                  The incoming message
      * @param isAnyTrans           True if to use transports included in TRANSPORT_ANY; if false the information of transport bits are part of the message
+     * @return  The ALLJOYN_FINDADVERTISEDNAME_* reply code sent.
      */
-    void ProcFindAdvertisedName(Message& msg, bool isAnyTrans);
+    uint32_t ProcFindAdvertisedName(Message& msg, bool isAnyTrans);
 
     /**
      * Handle a request to cancel the discovery a name prefix by a set of transports
@@ -35,6 +35,7 @@
 
 #include "BTController.h"
 #include "BTEndpoint.h"
+#include "DaemonConfig.h"
 
 #define QCC_MODULE "ALLJOYN_BTC"
 
@@ -60,8 +61,18 @@ static const uint32_t DEFAULT_MAX_CONNECTIONS =  3; /* Gotta allow 1 connection
 static const uint32_t LOST_DEVICE_TIMEOUT = 60000;    /* 60 seconds */
 static const uint32_t LOST_DEVICE_TIMEOUT_EXT = 5000; /* 5 seconds */
 
+static const uint32_t NODE_CACHE_MAX_AGE_DEFAULT = 24 * 60 * 60; /* 1 day */
+
 static const uint32_t BLACKLIST_TIME = (60 * 60 * 1000); /* 1 hour */
 
+/*
+ * Updating delegations may change the SDP record and EIR data which are slow
+ * radio operations.  Name changes are held off for a short time so that a
+ * burst of them (e.g. an app advertising several names at startup) results in
+ * a single update.
+ */
+static const uint32_t DELEGATION_UPDATE_HOLDOFF = 100; /* 100 ms */
+
 namespace ajn {
 
 struct InterfaceDesc {
@@ -185,9 +196,14 @@ BTController::BTController(BusAttachment& bus, BluetoothDeviceInterface& bt) :
     listening(false),
     devAvailable(false),
     foundNodeDB(true),
+    nodeCacheFile(DaemonConfig::Access()->Get("bt_node_cache/property@file", "")),
+    nodeCacheMaxAge(DaemonConfig::Access()->Get("bt_node_cache/property@max_age", NODE_CACHE_MAX_AGE_DEFAULT)),
+    nodeCacheLoaded(false),
     advertise(*this),
     find(*this),
     dispatcher("BTC-Dispatcher"),
+    delegationUpdatePending(false),
+    delegationUpdatesSaved(0),
     incompleteConnections(0)
 {
     while (masterUUIDRev == bt::INVALID_UUIDREV) {
@@ -264,6 +280,8 @@ BTController::~BTController()
     if (master) {
         delete master;
     }
+
+    SaveNodeCache();
 }
 
 
@@ -478,7 +496,7 @@ void BTController::ProcessDeviceChange(const BDAddress& adBdAddr,
 
                         // Gotta add the new blacklist entry to ignore addresses set.
                         find.dirty = true;
-                        DispatchOperation(new UpdateDelegationsDispatchInfo());
+                        ScheduleUpdateDelegations();
                     }
                     lock.Unlock(MUTEX_CONTEXT);
                     return;
@@ -577,6 +595,7 @@ void BTController::ProcessDeviceChange(const BDAddress& adBdAddr,
 
         if (distributeChanges) {
             DistributeAdvertisedNameChanges(&added, &removed);
+            SaveNodeCache();
         }
     } else {
         MsgArg args[SIG_FOUND_DEV_SIZE];
@@ -1069,7 +1088,7 @@ QStatus BTController::DoNameOp(const qcc::String& name,
             }
 #endif
 
-            DispatchOperation(new UpdateDelegationsDispatchInfo());
+            ScheduleUpdateDelegations(DELEGATION_UPDATE_HOLDOFF);
 
         } else {
             QCC_DbgPrintf(("Sending %s to our master: %s (%s)", signal.name.c_str(), master->GetServiceName().c_str(), masterNode->ToString().c_str()));
@@ -1170,7 +1189,7 @@ void BTController::HandleNameSignal(const InterfaceDescription::Member* member,
             lock.Unlock(MUTEX_CONTEXT);
 
             if (isMaster) {
-                DispatchOperation(new UpdateDelegationsDispatchInfo());
+                ScheduleUpdateDelegations(DELEGATION_UPDATE_HOLDOFF);
 
                 if (findOp) {
                     if (addName && (node->FindNamesSize() == 1)) {
@@ -1495,7 +1514,7 @@ void BTController::HandleSetState(const InterfaceDescription::Member* member, Me
     if (connectingNode == joinSessionNode) {
         JoinSessionNodeComplete();  // Also triggers UpdateDelegations if we stay the master.
     } else if (updateDelegations) {
-        DispatchOperation(new UpdateDelegationsDispatchInfo());
+        ScheduleUpdateDelegations();
     }
 
     lock.Unlock(MUTEX_CONTEXT);
@@ -1679,6 +1698,8 @@ void BTController::DeferredBTDeviceAvailable(bool on)
      */
     self->SetEIRCapable(bt.IsEIRCapable());
 
+    BTNodeDB cachedNodes;
+
     if (on && !devAvailable) {
         BTBusAddress listenAddr;
         devAvailable = true;
@@ -1697,6 +1718,7 @@ void BTController::DeferredBTDeviceAvailable(bool on)
                 //DispatchOperation(new UpdateDelegationsDispatchInfo());
                 UpdateDelegations(advertise);
                 UpdateDelegations(find);
+                LoadNodeCache(cachedNodes);
             }
         } else {
             QCC_LogError(status, ("Failed to start listening for incoming connections"));
@@ -1740,6 +1762,58 @@ void BTController::DeferredBTDeviceAvailable(bool on)
     }
 
     lock.Unlock(MUTEX_CONTEXT);
+
+    if (cachedNodes.Size() > 0) {
+        DistributeAdvertisedNameChanges(&cachedNodes, NULL);
+    }
+}
+
+
+void BTController::LoadNodeCache(BTNodeDB& loaded)
+{
+    if (nodeCacheLoaded || nodeCacheFile.empty()) {
+        return;
+    }
+    nodeCacheLoaded = true;
+
+    BTNodeDB cache;
+    if (cache.Load(nodeCacheFile, nodeCacheMaxAge) != ER_OK) {
+        return;
+    }
+
+    Timespec now;
+    GetTimeNow(&now);
+    uint64_t expireTime = now.GetAbsoluteMillis() + LOST_DEVICE_TIMEOUT;
+
+    foundNodeDB.Lock(MUTEX_CONTEXT);
+    for (BTNodeDB::const_iterator it = cache.Begin(); it != cache.End(); ++it) {
+        const BTNodeInfo& node = *it;
+        const BTBusAddress& addr = node->GetBusAddress();
+        if ((addr == self->GetBusAddress()) ||
+            nodeDB.FindNode(addr)->IsValid() ||
+            foundNodeDB.FindNode(addr)->IsValid()) {
+            continue;
+        }
+        node->SetExpireTime(expireTime);
+        foundNodeDB.AddNode(node);
+        if (node->AdvertiseNamesEmpty()) {
+            continue;
+        }
+        loaded.AddNode(node);
+    }
+    foundNodeDB.DumpTable("foundNodeDB - Added nodes from the node cache");
+    foundNodeDB.Unlock(MUTEX_CONTEXT);
+
+    QCC_DbgPrintf(("Warm start with %u cached nodes with names", loaded.Size()));
+    ResetExpireNameAlarm();
+}
+
+
+void BTController::SaveNodeCache()
+{
+    if (!nodeCacheFile.empty() && nodeCacheLoaded) {
+        foundNodeDB.Save(nodeCacheFile);
+    }
 }
 
 
@@ -2261,12 +2335,24 @@ void BTController::DistributeAdvertisedNameChanges(const BTNodeDB* newAdInfo,
         }
         nodeDB.Unlock(MUTEX_CONTEXT);
 
-        for (set<BTNodeInfo>::const_iterator it = destNodesOld.begin(); it != destNodesOld.end(); ++it) {
-            SendFoundNamesChange(*it, *oldAdInfo, true);
+        /*
+         * Every minion gets the same list of changes so only marshal each
+         * list once no matter how many minions there are.
+         */
+        if (!destNodesOld.empty()) {
+            vector<MsgArg> nodeList;
+            FillFoundNodesMsgArgs(nodeList, *oldAdInfo);
+            for (set<BTNodeInfo>::const_iterator it = destNodesOld.begin(); it != destNodesOld.end(); ++it) {
+                SendFoundNamesChange(*it, nodeList, true);
+            }
         }
 
-        for (set<BTNodeInfo>::const_iterator it = destNodesNew.begin(); it != destNodesNew.end(); ++it) {
-            SendFoundNamesChange(*it, *newAdInfo, false);
+        if (!destNodesNew.empty()) {
+            vector<MsgArg> nodeList;
+            FillFoundNodesMsgArgs(nodeList, *newAdInfo);
+            for (set<BTNodeInfo>::const_iterator it = destNodesNew.begin(); it != destNodesNew.end(); ++it) {
+                SendFoundNamesChange(*it, nodeList, false);
+            }
         }
     }
 
@@ -2308,7 +2394,14 @@ void BTController::SendFoundNamesChange(const BTNodeInfo& destNode,
     vector<MsgArg> nodeList;
 
     FillFoundNodesMsgArgs(nodeList, adInfo);
+    SendFoundNamesChange(destNode, nodeList, lost);
+}
+
 
+void BTController::SendFoundNamesChange(const BTNodeInfo& destNode,
+                                        const vector<MsgArg>& nodeList,
+                                        bool lost)
+{
     MsgArg arg(SIG_FOUND_NAMES, nodeList.size(), nodeList.empty() ? NULL : &nodeList.front());
     QStatus status;
     if (lost) {
@@ -3073,13 +3166,31 @@ void BTController::JoinSessionNodeComplete()
     }
 
     if (IsMaster()) {
-        DispatchOperation(new UpdateDelegationsDispatchInfo());
+        ScheduleUpdateDelegations();
     }
 
     lock.Unlock(MUTEX_CONTEXT);
 }
 
 
+void BTController::ScheduleUpdateDelegations(uint32_t delay)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    if (delegationUpdatePending) {
+        /*
+         * An update that has not run yet will see the current state so this
+         * request can ride along with it.
+         */
+        ++delegationUpdatesSaved;
+        QCC_DbgPrintf(("Coalesced delegation update (%u saved so far)", delegationUpdatesSaved));
+    } else {
+        delegationUpdatePending = true;
+        DispatchOperation(new UpdateDelegationsDispatchInfo(), delay);
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+
 void BTController::AlarmTriggered(const Alarm& alarm, QStatus reason)
 {
     QCC_DbgTrace(("BTController::AlarmTriggered(alarm = <>, reasons = %s)", QCC_StatusText(reason)));
@@ -3091,6 +3202,8 @@ void BTController::AlarmTriggered(const Alarm& alarm, QStatus reason)
         switch (op->operation) {
         case DispatchInfo::UPDATE_DELEGATIONS:
             lock.Lock(MUTEX_CONTEXT);
+            // Requests made from here on need a new update.
+            delegationUpdatePending = false;
             if (incompleteConnections == 0) {
                 QCC_DbgPrintf(("    Updating delegations"));
                 UpdateDelegations(advertise);
@@ -718,6 +718,18 @@ class BTController :
                               const BTNodeDB& adInfo,
                               bool lost);
 
+    /**
+     * Send the FoundNames signal with a list of found node entries that has
+     * already been filled in by FillFoundNodesMsgArgs().
+     *
+     * @param destNode      The minion that should receive the message.
+     * @param nodeList      Found node entries to send.
+     * @param lost          Set to true if names are lost, false otherwise.
+     */
+    void SendFoundNamesChange(const BTNodeInfo& destNode,
+                              const std::vector<MsgArg>& nodeList,
+                              bool lost);
+
     /**
      * Update the internal state information for other nodes based on incoming
      * message args.
@@ -830,6 +842,31 @@ class BTController :
         return alarm;
     }
 
+    /**
+     * Schedule an update of the find and advertise delegations.  Requests
+     * made while an update is already scheduled are folded into that update.
+     *
+     * @param delay     Milliseconds to hold off before updating.
+     */
+    void ScheduleUpdateDelegations(uint32_t delay = 0);
+
+    /**
+     * Add the recently seen nodes from the node cache file to the found
+     * nodes so that their names can be reported and connected to before
+     * they are rediscovered.  They are validated lazily: a node that is
+     * still around is refreshed by its next advertisement without a new SDP
+     * query while its UUID revision is unchanged, and a node that is gone
+     * expires like any other lost node.  Must be called holding lock.
+     *
+     * @param loaded    [OUT] The nodes that were added.
+     */
+    void LoadNodeCache(BTNodeDB& loaded);
+
+    /**
+     * Write the found nodes to the node cache file.
+     */
+    void SaveNodeCache();
+
     void ResetExpireNameAlarm();
     void RemoveExpireNameAlarm() { dispatcher.RemoveAlarm(expireAlarm); }
     void JoinSessionNodeComplete();
@@ -898,6 +935,10 @@ class BTController :
     BTNodeDB nodeDB;
     BTNodeInfo self;
 
+    const qcc::String nodeCacheFile;        // File the found nodes are kept in across restarts, empty if none
+    const uint32_t nodeCacheMaxAge;         // Seconds a cached node may not have been seen and still be used
+    bool nodeCacheLoaded;                   // The node cache file has been read
+
     mutable qcc::Mutex lock;
 
     AdvertiseNameArgInfo advertise;
@@ -908,6 +949,9 @@ class BTController :
 
     BDAddressSet blacklist;
 
+    bool delegationUpdatePending;           // An UPDATE_DELEGATIONS operation is scheduled
+    uint32_t delegationUpdatesSaved;        // Number of delegation updates folded into a scheduled one
+
     volatile int32_t incompleteConnections; // Number of outgoing connections that are being setup
     qcc::Event connectCompleted;
 
@@ -22,11 +22,16 @@
 
 #include <qcc/platform.h>
 
+#include <time.h>
+
 #include <list>
+#include <map>
 #include <set>
 #include <vector>
 
+#include <qcc/FileStream.h>
 #include <qcc/String.h>
+#include <qcc/StringUtil.h>
 
 #include <alljoyn/MsgArg.h>
 
@@ -43,49 +48,11 @@ using namespace qcc;
 namespace ajn {
 
 
-static set<BTNodeInfo>::const_iterator findNode(const set<BTNodeInfo>& nodes, const BTBusAddress& addr)
-{
-    set<BTNodeInfo>::const_iterator it;
-    for (it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->GetBusAddress() == addr) {
-            break;
-        }
-    }
-    return it;
-}
-
-
-static set<BTNodeInfo>::iterator findNode(set<BTNodeInfo>& nodes, const BTBusAddress& addr)
-{
-    set<BTNodeInfo>::iterator it;
-    for (it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->GetBusAddress() == addr) {
-            break;
-        }
-    }
-    return it;
-}
-
-
-static set<BTNodeInfo>::const_iterator findNode(const set<BTNodeInfo>& nodes, const BDAddress& addr)
-{
-    set<BTNodeInfo>::const_iterator it;
-    for (it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->GetBusAddress().addr == addr) {
-            break;
-        }
-    }
-    return it;
-}
-
-
-static set<BTNodeInfo>::const_iterator findNode(const set<BTNodeInfo>& nodes, const String& uniqueName)
+BTNodeDB::AddressIndex::const_iterator BTNodeDB::FindFirst(const BDAddress& addr) const
 {
-    set<BTNodeInfo>::const_iterator it;
-    for (it = nodes.begin(); it != nodes.end(); ++it) {
-        if (!(*it)->GetUniqueName().empty() && ((*it)->GetUniqueName() == uniqueName)) {
-            break;
-        }
+    AddressIndex::const_iterator it = addrIndex.lower_bound(BTBusAddress(addr, 0x0000));
+    if ((it != addrIndex.end()) && !(it->first.addr == addr)) {
+        it = addrIndex.end();
     }
     return it;
 }
@@ -95,9 +62,9 @@ const BTNodeInfo BTNodeDB::FindNode(const BTBusAddress& addr) const
 {
     BTNodeInfo node;
     Lock(MUTEX_CONTEXT);
-    set<BTNodeInfo>::const_iterator it = findNode(nodes, addr);
-    if (it != nodes.end()) {
-        node = *it;
+    AddressIndex::const_iterator it = addrIndex.find(addr);
+    if (it != addrIndex.end()) {
+        node = it->second.node;
     }
     Unlock(MUTEX_CONTEXT);
     return node;
@@ -108,9 +75,9 @@ const BTNodeInfo BTNodeDB::FindNode(const BDAddress& addr) const
 {
     BTNodeInfo node;
     Lock(MUTEX_CONTEXT);
-    set<BTNodeInfo>::const_iterator it = findNode(nodes, addr);
-    if (it != nodes.end()) {
-        node = *it;
+    AddressIndex::const_iterator it = FindFirst(addr);
+    if (it != addrIndex.end()) {
+        node = it->second.node;
     }
     Unlock(MUTEX_CONTEXT);
     return node;
@@ -120,10 +87,33 @@ const BTNodeInfo BTNodeDB::FindNode(const BDAddress& addr) const
 const BTNodeInfo BTNodeDB::FindNode(const String& uniqueName) const
 {
     BTNodeInfo node;
+    if (uniqueName.empty()) {
+        return node;
+    }
     Lock(MUTEX_CONTEXT);
-    set<BTNodeInfo>::const_iterator it = findNode(nodes, uniqueName);
-    if (it != nodes.end()) {
-        node = *it;
+    NameIndex::iterator nit = nameIndex.find(uniqueName);
+    if (nit != nameIndex.end()) {
+        AddressIndex::const_iterator it = addrIndex.find(nit->second);
+        if ((it != addrIndex.end()) && (it->second.node->GetUniqueName() == uniqueName)) {
+            node = it->second.node;
+        } else {
+            nameIndex.erase(nit);
+        }
+    }
+    if (!node->IsValid()) {
+        /*
+         * The unique name may have been set after the node was added. Fall back to a full search
+         * and re-learn the unique names of all the nodes while we are at it.
+         */
+        for (AddressIndex::const_iterator it = addrIndex.begin(); it != addrIndex.end(); ++it) {
+            const String& name = it->second.node->GetUniqueName();
+            if (!name.empty()) {
+                nameIndex[name] = it->first;
+                if (!node->IsValid() && (name == uniqueName)) {
+                    node = it->second.node;
+                }
+            }
+        }
     }
     Unlock(MUTEX_CONTEXT);
     return node;
@@ -173,6 +163,12 @@ void BTNodeDB::AddNode(const BTNodeInfo& node)
 
     // Add to the master set
     nodes.insert(node);
+    IndexedNode entry(node);
+    addrIndex.insert(AddressIndex::value_type(node->GetBusAddress(), entry));
+    expireQueue.insert(ExpireQueue::value_type(entry.queuedExpireTime, node->GetBusAddress()));
+    if (!node->GetUniqueName().empty()) {
+        nameIndex[node->GetUniqueName()] = node->GetBusAddress();
+    }
 
     Unlock(MUTEX_CONTEXT);
 }
@@ -181,16 +177,81 @@ void BTNodeDB::AddNode(const BTNodeInfo& node)
 void BTNodeDB::RemoveNode(const BTNodeInfo& node)
 {
     Lock(MUTEX_CONTEXT);
-    set<BTNodeInfo>::iterator it = findNode(nodes, node->GetBusAddress());
-    if (it != nodes.end()) {
-        // Remove from the master set
-        nodes.erase(it);
+    AddressIndex::iterator it = addrIndex.find(node->GetBusAddress());
+    if (it != addrIndex.end()) {
+        RemoveNode(it);
     }
+    Unlock(MUTEX_CONTEXT);
+}
+
 
+void BTNodeDB::RemoveNode(AddressIndex::iterator it)
+{
+    BTNodeInfo node = it->second.node;
+    expireQueue.erase(ExpireQueue::value_type(it->second.queuedExpireTime, it->first));
+    const String& name = node->GetUniqueName();
+    if (!name.empty()) {
+        NameIndex::iterator nit = nameIndex.find(name);
+        if ((nit != nameIndex.end()) && (nit->second == it->first)) {
+            nameIndex.erase(nit);
+        }
+    }
+    addrIndex.erase(it);
+    // Remove from the master set
+    nodes.erase(node);
+}
+
+
+void BTNodeDB::SetExpireTime(IndexedNode& entry, uint64_t expireTime)
+{
+    const BTBusAddress& addr = entry.node->GetBusAddress();
+    expireQueue.erase(ExpireQueue::value_type(entry.queuedExpireTime, addr));
+    entry.node->SetExpireTime(expireTime);
+    entry.queuedExpireTime = expireTime;
+    expireQueue.insert(ExpireQueue::value_type(expireTime, addr));
+}
+
+
+void BTNodeDB::PopExpiredNodes(BTNodeDB& expiredDB)
+{
+    Lock(MUTEX_CONTEXT);
+    Timespec now;
+    GetTimeNow(&now);
+    uint64_t nowMillis = now.GetAbsoluteMillis();
+    while (!expireQueue.empty() && (expireQueue.begin()->first <= nowMillis)) {
+        AddressIndex::iterator it = addrIndex.find(expireQueue.begin()->second);
+        assert(it != addrIndex.end());
+        BTNodeInfo node = it->second.node;
+        if (node->GetExpireTime() == it->second.queuedExpireTime) {
+            RemoveNode(it);
+            expiredDB.AddNode(node);
+        } else {
+            // The expiration time was changed directly on the node so requeue it.
+            SetExpireTime(it->second, node->GetExpireTime());
+        }
+    }
     Unlock(MUTEX_CONTEXT);
 }
 
 
+uint64_t BTNodeDB::NextNodeExpiration()
+{
+    uint64_t next = numeric_limits<uint64_t>::max();
+    Lock(MUTEX_CONTEXT);
+    while (!expireQueue.empty()) {
+        AddressIndex::iterator it = addrIndex.find(expireQueue.begin()->second);
+        assert(it != addrIndex.end());
+        if (it->second.node->GetExpireTime() == it->second.queuedExpireTime) {
+            next = it->second.queuedExpireTime;
+            break;
+        }
+        SetExpireTime(it->second, it->second.node->GetExpireTime());
+    }
+    Unlock(MUTEX_CONTEXT);
+    return next;
+}
+
+
 void BTNodeDB::Diff(const BTNodeDB& other, BTNodeDB* added, BTNodeDB* removed) const
 {
     Lock(MUTEX_CONTEXT);
@@ -203,19 +264,19 @@ void BTNodeDB::Diff(const BTNodeDB& other, BTNodeDB* added, BTNodeDB* removed) c
     }
 
     const_iterator nodeit;
-    set<BTNodeInfo>::const_iterator addrit;
+    AddressIndex::const_iterator addrit;
 
     // Find removed names/nodes
     if (removed) {
         for (nodeit = Begin(); nodeit != End(); ++nodeit) {
             const BTNodeInfo& node = *nodeit;
-            addrit = findNode(other.nodes, node->GetBusAddress());
-            if (addrit == other.nodes.end()) {
+            addrit = other.addrIndex.find(node->GetBusAddress());
+            if (addrit == other.addrIndex.end()) {
                 removed->AddNode(node);
             } else {
                 BTNodeInfo diffNode = node->Clone();
                 bool include = false;
-                const BTNodeInfo& onode = *addrit;
+                const BTNodeInfo& onode = addrit->second.node;
                 NameSet::const_iterator nameit;
                 NameSet::const_iterator onameit;
                 for (nameit = node->GetAdvertiseNamesBegin(); nameit != node->GetAdvertiseNamesEnd(); ++nameit) {
@@ -237,13 +298,13 @@ void BTNodeDB::Diff(const BTNodeDB& other, BTNodeDB* added, BTNodeDB* removed) c
     if (added) {
         for (nodeit = other.Begin(); nodeit != other.End(); ++nodeit) {
             const BTNodeInfo& onode = *nodeit;
-            addrit = findNode(nodes, onode->GetBusAddress());
-            if (addrit == nodes.end()) {
+            addrit = addrIndex.find(onode->GetBusAddress());
+            if (addrit == addrIndex.end()) {
                 added->AddNode(onode);
             } else {
                 BTNodeInfo diffNode = onode->Clone();
                 bool include = false;
-                const BTNodeInfo& node = *addrit;
+                const BTNodeInfo& node = addrit->second.node;
                 NameSet::const_iterator nameit;
                 NameSet::const_iterator onameit;
                 for (onameit = onode->GetAdvertiseNamesBegin(); onameit != onode->GetAdvertiseNamesEnd(); ++onameit) {
@@ -284,14 +345,14 @@ void BTNodeDB::NodeDiff(const BTNodeDB& other, BTNodeDB* added, BTNodeDB* remove
     }
 
     const_iterator nodeit;
-    set<BTNodeInfo>::const_iterator addrit;
+    AddressIndex::const_iterator addrit;
 
     // Find removed names/nodes
     if (removed) {
         for (nodeit = Begin(); nodeit != End(); ++nodeit) {
             const BTNodeInfo& node = *nodeit;
-            addrit = findNode(other.nodes, node->GetBusAddress());
-            if (addrit == other.nodes.end()) {
+            addrit = other.addrIndex.find(node->GetBusAddress());
+            if (addrit == other.addrIndex.end()) {
                 removed->AddNode(node);
             }
         }
@@ -301,8 +362,8 @@ void BTNodeDB::NodeDiff(const BTNodeDB& other, BTNodeDB* added, BTNodeDB* remove
     if (added) {
         for (nodeit = other.Begin(); nodeit != other.End(); ++nodeit) {
             const BTNodeInfo& onode = *nodeit;
-            addrit = findNode(nodes, onode->GetBusAddress());
-            if (addrit == nodes.end()) {
+            addrit = addrIndex.find(onode->GetBusAddress());
+            if (addrit == addrIndex.end()) {
                 added->AddNode(onode);
             }
         }
@@ -327,10 +388,10 @@ void BTNodeDB::UpdateDB(const BTNodeDB* added, const BTNodeDB* removed, bool rem
         const_iterator rit;
         for (rit = removed->Begin(); rit != removed->End(); ++rit) {
             BTNodeInfo rnode = *rit;
-            set<BTNodeInfo>::const_iterator it = findNode(nodes, rnode->GetBusAddress());
-            if (it != nodes.end()) {
+            AddressIndex::iterator it = addrIndex.find(rnode->GetBusAddress());
+            if (it != addrIndex.end()) {
                 // Remove names from node
-                BTNodeInfo node = *it;
+                BTNodeInfo node = it->second.node;
                 if (&(*node) == &(*rnode)) {
                     // The exact same instance of node is in the removed DB so
                     // just remove the node so that the names don't get
@@ -359,8 +420,8 @@ void BTNodeDB::UpdateDB(const BTNodeDB* added, const BTNodeDB* removed, bool rem
         const_iterator ait;
         for (ait = added->Begin(); ait != added->End(); ++ait) {
             BTNodeInfo anode = *ait;
-            set<BTNodeInfo>::const_iterator it = findNode(nodes, anode->GetBusAddress());
-            if (it == nodes.end()) {
+            AddressIndex::iterator it = addrIndex.find(anode->GetBusAddress());
+            if (it == addrIndex.end()) {
                 // New node
                 BTNodeInfo connNode = FindNode(anode->GetConnectNode()->GetBusAddress());
                 if (connNode->IsValid()) {
@@ -370,7 +431,7 @@ void BTNodeDB::UpdateDB(const BTNodeDB* added, const BTNodeDB* removed, bool rem
                 AddNode(anode);
             } else {
                 // Add names to existing node
-                BTNodeInfo node = *it;
+                BTNodeInfo node = it->second.node;
                 NameSet::const_iterator anameit;
                 for (anameit = anode->GetAdvertiseNamesBegin(); anameit != anode->GetAdvertiseNamesEnd(); ++anameit) {
                     const String& aname = *anameit;
@@ -386,10 +447,11 @@ void BTNodeDB::UpdateDB(const BTNodeDB* added, const BTNodeDB* removed, bool rem
                 node->SetUUIDRev(anode->GetUUIDRev());
                 if (useExpirations) {
                     // Update the expire time
-                    node->SetExpireTime(anode->GetExpireTime());
+                    SetExpireTime(it->second, anode->GetExpireTime());
                 }
                 if ((node->GetUniqueName() != anode->GetUniqueName()) && !anode->GetUniqueName().empty()) {
                     node->SetUniqueName(anode->GetUniqueName());
+                    nameIndex[node->GetUniqueName()] = it->first;
                 }
             }
         }
@@ -404,11 +466,8 @@ void BTNodeDB::RemoveExpiration()
     if (useExpirations) {
         Lock(MUTEX_CONTEXT);
         uint64_t expireTime = numeric_limits<uint64_t>::max();
-        iterator it = nodes.begin();
-        while (it != nodes.end()) {
-            BTNodeInfo node = *it;
-            node->SetExpireTime(expireTime);
-            ++it;
+        for (AddressIndex::iterator it = addrIndex.begin(); it != addrIndex.end(); ++it) {
+            SetExpireTime(it->second, expireTime);
         }
         Unlock(MUTEX_CONTEXT);
     } else {
@@ -425,11 +484,8 @@ void BTNodeDB::RefreshExpiration(uint32_t expireDelta)
         Timespec now;
         GetTimeNow(&now);
         uint64_t expireTime = now.GetAbsoluteMillis() + expireDelta;
-        iterator it = nodes.begin();
-        while (it != nodes.end()) {
-            BTNodeInfo node = *it;
-            node->SetExpireTime(expireTime);
-            ++it;
+        for (AddressIndex::iterator it = addrIndex.begin(); it != addrIndex.end(); ++it) {
+            SetExpireTime(it->second, expireTime);
         }
         Unlock(MUTEX_CONTEXT);
     } else {
@@ -448,11 +504,12 @@ void BTNodeDB::RefreshExpiration(const BTNodeInfo& connNode, uint32_t expireDelt
         GetTimeNow(&now);
         uint64_t expireTime = now.GetAbsoluteMillis() + expireDelta;
 
-        for (set<BTNodeInfo>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
-            if ((*it)->GetConnectNode() == connNode) {
-                BTNodeInfo node = *it;
-                node->SetExpireTime(expireTime);
+        for (AddressIndex::iterator it = addrIndex.begin(); it != addrIndex.end(); ++it) {
+            BTNodeInfo node = it->second.node;
+            if (node->GetConnectNode() == connNode) {
+                SetExpireTime(it->second, expireTime);
                 node->SetUUIDRev(connNode->GetUUIDRev());
+                node->SetLastSeen(static_cast<uint32_t>(time(NULL)));
             }
         }
 
@@ -464,6 +521,140 @@ void BTNodeDB::RefreshExpiration(const BTNodeInfo& connNode, uint32_t expireDelt
 }
 
 
+/* First line of a node cache file, changed whenever the line format changes */
+static const char* NODE_CACHE_VERSION = "# alljoyn bt node cache 1";
+
+static QStatus ReadLine(FileSource& fs, qcc::String& line)
+{
+    char c;
+    size_t read;
+    QStatus status;
+    line.clear();
+    do {
+        status = fs.PullBytes(&c, 1, read);
+        if ((read == 0) || (status != ER_OK)) {
+            break;
+        }
+        if ((c != '\n') && (c != '\r')) {
+            line += c;
+        }
+    } while (c != '\n');
+
+    return status;
+}
+
+static void SplitFields(const qcc::String& line, vector<qcc::String>& fields)
+{
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t end = line.find_first_of(' ', pos);
+        if (end == qcc::String::npos) {
+            end = line.size();
+        }
+        if (end > pos) {
+            fields.push_back(line.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+}
+
+
+QStatus BTNodeDB::Save(const qcc::String& fileName) const
+{
+    FileSink sink(fileName, FileSink::PRIVATE);
+    if (!sink.IsValid()) {
+        QCC_LogError(ER_FAIL, ("BTNodeDB::Save(): Failed to open %s", fileName.c_str()));
+        return ER_FAIL;
+    }
+
+    qcc::String out(NODE_CACHE_VERSION);
+    out += "\n";
+    Lock(MUTEX_CONTEXT);
+    for (std::set<BTNodeInfo>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const BTNodeInfo& node = *it;
+        const BTBusAddress& connAddr = node->GetConnectNode()->GetBusAddress();
+        out += node->GetBusAddress().addr.ToString() + " " + U32ToString(node->GetBusAddress().psm, 16);
+        out += " " + node->GetGUID().ToString();
+        out += " " + U32ToString(node->GetUUIDRev(), 16);
+        out += node->IsEIRCapable() ? " 1 " : " 0 ";
+        out += U32ToString(node->GetLastSeen());
+        out += " " + connAddr.addr.ToString() + " " + U32ToString(connAddr.psm, 16);
+        for (NameSet::const_iterator nit = node->GetAdvertiseNamesBegin(); nit != node->GetAdvertiseNamesEnd(); ++nit) {
+            out += " " + *nit;
+        }
+        out += "\n";
+    }
+    Unlock(MUTEX_CONTEXT);
+
+    size_t pushed;
+    sink.Lock(true);
+    QStatus status = sink.PushBytes(out.data(), out.size(), pushed);
+    sink.Unlock();
+    if ((status == ER_OK) && (pushed != out.size())) {
+        status = ER_FAIL;
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("BTNodeDB::Save(): Failed to write %s", fileName.c_str()));
+    }
+    return status;
+}
+
+
+QStatus BTNodeDB::Load(const qcc::String& fileName, uint32_t maxAge)
+{
+    FileSource source(fileName);
+    if (!source.IsValid()) {
+        QCC_DbgPrintf(("BTNodeDB::Load(): No node cache in %s", fileName.c_str()));
+        return ER_FAIL;
+    }
+
+    qcc::String line;
+    source.Lock(true);
+    QStatus status = ReadLine(source, line);
+    if ((status != ER_OK) || (line != NODE_CACHE_VERSION)) {
+        source.Unlock();
+        QCC_DbgPrintf(("BTNodeDB::Load(): Ignoring %s with unknown format", fileName.c_str()));
+        return ER_FAIL;
+    }
+
+    uint32_t now = static_cast<uint32_t>(time(NULL));
+    std::map<BTBusAddress, BTNodeInfo> loaded;
+    std::map<BTBusAddress, BTBusAddress> connAddrs;
+    while ((ReadLine(source, line) == ER_OK) && !line.empty()) {
+        vector<qcc::String> fields;
+        SplitFields(line, fields);
+        if (fields.size() < 8) {
+            continue;
+        }
+        BTBusAddress addr(BDAddress(fields[0]), static_cast<uint16_t>(StringToU32(fields[1], 16, bt::INVALID_PSM)));
+        BTBusAddress connAddr(BDAddress(fields[6]), static_cast<uint16_t>(StringToU32(fields[7], 16, bt::INVALID_PSM)));
+        uint32_t lastSeen = StringToU32(fields[5], 10, 0);
+        if (!addr.IsValid() || !connAddr.IsValid() || !GUID128::IsGUID(fields[2]) || (lastSeen > now) || ((now - lastSeen) > maxAge)) {
+            continue;
+        }
+        BTNodeInfo node(addr, qcc::String(), GUID128(fields[2]));
+        node->SetUUIDRev(StringToU32(fields[3], 16, bt::INVALID_UUIDREV));
+        node->SetEIRCapable(fields[4] == "1");
+        node->SetLastSeen(lastSeen);
+        for (size_t i = 8; i < fields.size(); ++i) {
+            node->AddAdvertiseName(fields[i]);
+        }
+        loaded[addr] = node;
+        connAddrs[addr] = connAddr;
+    }
+    source.Unlock();
+
+    for (std::map<BTBusAddress, BTNodeInfo>::iterator it = loaded.begin(); it != loaded.end(); ++it) {
+        std::map<BTBusAddress, BTNodeInfo>::iterator cit = loaded.find(connAddrs[it->first]);
+        if (cit != loaded.end()) {
+            it->second->SetConnectNode(cit->second);
+            AddNode(it->second);
+        }
+    }
+    return ER_OK;
+}
+
+
 void BTNodeDB::NodeSessionLost(SessionId sessionID)
 {
     Lock(MUTEX_CONTEXT);
@@ -486,9 +677,9 @@ void BTNodeDB::NodeSessionLost(SessionId sessionID)
 void BTNodeDB::UpdateNodeSessionID(SessionId sessionID, const BTNodeInfo& node)
 {
     Lock(MUTEX_CONTEXT);
-    set<BTNodeInfo>::const_iterator it = findNode(nodes, node->GetBusAddress());
-    if (it != nodes.end()) {
-        BTNodeInfo lnode = *it;
+    AddressIndex::const_iterator it = addrIndex.find(node->GetBusAddress());
+    if (it != addrIndex.end()) {
+        BTNodeInfo lnode = it->second.node;
 
         lnode->SetSessionID(sessionID);
         lnode->SetSessionState(_BTNodeInfo::SESSION_UP);
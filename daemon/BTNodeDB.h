@@ -24,7 +24,9 @@
 #include <qcc/platform.h>
 
 #include <limits>
+#include <map>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include <qcc/ManagedObj.h>
@@ -33,6 +35,8 @@
 #include <qcc/StringUtil.h>
 #include <qcc/time.h>
 
+#include <qcc/STLContainer.h>
+
 #include "BDAddress.h"
 #include "BTBusAddress.h"
 #include "BTNodeInfo.h"
@@ -218,37 +222,45 @@ class BTNodeDB {
         Unlock(MUTEX_CONTEXT);
     }
 
-    void PopExpiredNodes(BTNodeDB& expiredDB)
-    {
-        Lock(MUTEX_CONTEXT);
-        qcc::Timespec now;
-        qcc::GetTimeNow(&now);
-        std::set<BTNodeInfo>::iterator it = nodes.begin();
-        while (it != nodes.end()) {
-            BTNodeInfo node = *it;
-            if (node->GetExpireTime() <= now.GetAbsoluteMillis()) {
-                nodes.erase(node);
-                expiredDB.AddNode(node);
-                it = nodes.begin();
-            } else {
-                ++it;
-            }
-        }
-        Unlock(MUTEX_CONTEXT);
-    }
+    /**
+     * Move all nodes whose expiration time has passed to another DB.
+     *
+     * @param expiredDB     DB to move the expired nodes to.
+     */
+    void PopExpiredNodes(BTNodeDB& expiredDB);
 
-    uint64_t NextNodeExpiration()
-    {
-        uint64_t next = std::numeric_limits<uint64_t>::max();
-        for (std::set<BTNodeInfo>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
-            BTNodeInfo node = *it;
-            if (node->GetExpireTime() < next) {
-                next = node->GetExpireTime();
-            }
-        }
-        return next;
-    }
+    /**
+     * Get the earliest expiration time of any node in the DB.
+     *
+     * @return  Absolute expiration time in milliseconds or numeric_limits<uint64_t>::max() if
+     *          no node expires.
+     */
+    uint64_t NextNodeExpiration();
+
+
+    /**
+     * Write the nodes to a file so a restarted daemon does not have to
+     * rediscover them, see Load().  One line is written per node holding its
+     * bus address, GUID, UUID revision, EIR capability, last seen time,
+     * connect address and advertised names.
+     *
+     * @param fileName  File to write.
+     *
+     * @return  ER_OK if the file was written.
+     */
+    QStatus Save(const qcc::String& fileName) const;
 
+    /**
+     * Add the nodes written by Save() that were seen recently.  Nodes are
+     * connected to through the connect node they were saved with.  Nodes
+     * whose connect node is missing from the file are dropped.
+     *
+     * @param fileName  File to read.
+     * @param maxAge    Nodes last seen more than this many seconds ago are ignored.
+     *
+     * @return  ER_OK if the file was read, even if no node was recent enough.
+     */
+    QStatus Load(const qcc::String& fileName, uint32_t maxAge);
 
     void NodeSessionLost(SessionId sessionID);
     void UpdateNodeSessionID(SessionId sessionID, const BTNodeInfo& node);
@@ -295,7 +307,15 @@ class BTNodeDB {
     /**
      * Clear out the DB.
      */
-    void Clear() { nodes.clear(); }
+    void Clear()
+    {
+        Lock(MUTEX_CONTEXT);
+        nodes.clear();
+        addrIndex.clear();
+        nameIndex.clear();
+        expireQueue.clear();
+        Unlock(MUTEX_CONTEXT);
+    }
 
 #ifndef NDEBUG
     void DumpTable(const char* info) const;
@@ -309,7 +329,53 @@ class BTNodeDB {
     BTNodeDB(const BTNodeDB& other) : useExpirations(false) { }
     BTNodeDB& operator=(const BTNodeDB& other) { return *this; }
 
+    /**
+     * Address index entry. The expiration time the node was queued with is kept so the queue
+     * entry can be found again if the node's expiration time is changed behind our back.
+     */
+    struct IndexedNode {
+        BTNodeInfo node;
+        uint64_t queuedExpireTime;
+        IndexedNode(const BTNodeInfo& node) : node(node), queuedExpireTime(node->GetExpireTime()) { }
+    };
+
+    /** Bus address index. The bus address of a node never changes while it is in the DB. */
+    typedef std::map<BTBusAddress, IndexedNode> AddressIndex;
+
+    /** Expiration queue ordered by expiration time */
+    typedef std::set<std::pair<uint64_t, BTBusAddress> > ExpireQueue;
+
+    struct Hash {
+        inline size_t operator()(const qcc::String& s) const {
+            return qcc::hash_string(s.c_str());
+        }
+    };
+
+    /**
+     * Unique name index. Unique names can be set on nodes that are already in the DB so entries
+     * are only hints that are checked before use and repaired when they turn out to be stale.
+     */
+    typedef std::unordered_map<qcc::String, BTBusAddress, Hash> NameIndex;
+
+    /**
+     * Find the index entry for a Bluetooth device address with the lowest PSM.
+     */
+    AddressIndex::const_iterator FindFirst(const BDAddress& addr) const;
+
+    /**
+     * Change the expiration time of a node in the DB and requeue it.
+     */
+    void SetExpireTime(IndexedNode& entry, uint64_t expireTime);
+
+    /**
+     * Remove a node from the DB given its index entry.
+     */
+    void RemoveNode(AddressIndex::iterator it);
+
     std::set<BTNodeInfo> nodes;     /**< The node DB storage. */
+    AddressIndex addrIndex;         /**< Nodes by bus address. */
+    mutable NameIndex nameIndex;    /**< Bus addresses by unique name. */
+    ExpireQueue expireQueue;        /**< Nodes by expiration time. */
 
     mutable qcc::Mutex lock;        /**< Mutext to protect the DB. */
 
@@ -78,6 +78,7 @@ class _BTNodeInfo {
         connectProxyNode(NULL),
         uuidRev(bt::INVALID_UUIDREV),
         expireTime(std::numeric_limits<uint64_t>::max()),
+        lastSeen(0),
         eirCapable(false),
         connectionCount(0),
         sessionID(0),
@@ -97,6 +98,7 @@ class _BTNodeInfo {
         connectProxyNode(NULL),
         uuidRev(bt::INVALID_UUIDREV),
         expireTime(std::numeric_limits<uint64_t>::max()),
+        lastSeen(0),
         eirCapable(false),
         connectionCount(0),
         sessionID(0),
@@ -117,6 +119,7 @@ class _BTNodeInfo {
         connectProxyNode(NULL),
         uuidRev(bt::INVALID_UUIDREV),
         expireTime(std::numeric_limits<uint64_t>::max()),
+        lastSeen(0),
         eirCapable(false),
         connectionCount(0),
         sessionID(0),
@@ -138,6 +141,7 @@ class _BTNodeInfo {
         connectProxyNode(NULL),
         uuidRev(bt::INVALID_UUIDREV),
         expireTime(std::numeric_limits<uint64_t>::max()),
+        lastSeen(0),
         eirCapable(false),
         connectionCount(0),
         sessionID(0),
@@ -461,6 +465,20 @@ class _BTNodeInfo {
         this->expireTime = expireTime;
     }
 
+    /**
+     * Get the wall clock time the node's advertisement was last seen.
+     *
+     * @return  Seconds since the epoch, 0 if the node has not been seen.
+     */
+    uint32_t GetLastSeen() const { return lastSeen; }
+
+    /**
+     * Set the wall clock time the node's advertisement was last seen.
+     *
+     * @param lastSeen  Seconds since the epoch
+     */
+    void SetLastSeen(uint32_t lastSeen) { this->lastSeen = lastSeen; }
+
     /**
      * Indicate if the node is EIR capable or not.
      *
@@ -586,6 +604,7 @@ class _BTNodeInfo {
         }
         clone->uuidRev = uuidRev;
         clone->expireTime = expireTime;
+        clone->lastSeen = lastSeen;
         clone->eirCapable = eirCapable;
         clone->connectionCount = connectionCount;
         clone->sessionID = sessionID;
@@ -679,6 +698,7 @@ class _BTNodeInfo {
     NameSet findNames;              /**< Set of find names. */
     uint32_t uuidRev;               /**< UUID revision of the advertisement this node was found in. */
     uint64_t expireTime;            /**< Time when advertised information is considered stale. */
+    uint32_t lastSeen;              /**< Wall clock time in seconds the advertisement was last seen. */
     bool eirCapable;                /**< Indicates if device is EIR capable or not. */
     uint16_t connectionCount;       /**< Number of connections with this node. */
     SessionId sessionID;            /**< BT controller session ID. */
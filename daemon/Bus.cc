@@ -22,12 +22,19 @@
 #include <qcc/platform.h>
 #include <qcc/Debug.h>
 #include <qcc/String.h>
+#include <qcc/StringUtil.h>
 
 #include <assert.h>
 
 #include "Bus.h"
+#include "DaemonConfig.h"
 #include "DaemonRouter.h"
+#include "LatencyHistogram.h"
+#include "MemoryAccounting.h"
+#include "ThreadScheduling.h"
+#include "TimerSlack.h"
 #include "TransportList.h"
+#include "ValidationCache.h"
 
 #define QCC_MODULE "ALLJOYN_DAEMON"
 
@@ -42,9 +49,109 @@ using namespace std;
 const uint32_t EP_CONCURRENCY = 4;
 
 Bus::Bus(const char* applicationName, TransportFactoryContainer& factories, const char* listenSpecs) :
-    BusAttachment(new Internal(applicationName, *this, factories, new DaemonRouter, true, listenSpecs, EP_CONCURRENCY), EP_CONCURRENCY)
+    BusAttachment(new Internal(applicationName, *this, factories, new DaemonRouter, true, listenSpecs, EP_CONCURRENCY), EP_CONCURRENCY),
+    deferred(false)
 {
     GetInternal().GetRouter().SetGlobalGUID(GetInternal().GetGlobalGUID());
+    /*
+     * Bound the number of header compression rules a long-running daemon accumulates, for example:
+     *
+     *   <limit max_compression_rules="4096"/>
+     *
+     * A value of 0 removes the limit.
+     */
+    uint32_t maxRules = DaemonConfig::Access()->Get("limit@max_compression_rules", ALLJOYN_MAX_COMPRESSION_RULES_DEFAULT);
+    GetInternal().GetCompressionRules()->SetMaxRules(maxRules);
+    /*
+     * Record message routing latency histograms, off by default because it adds clock reads to
+     * the message path:
+     *
+     *   <limit latency_stats="1"/>
+     */
+    LatencyStats::Enable(DaemonConfig::Access()->Get("limit@latency_stats", 0) != 0);
+    /*
+     * Account the memory held by the sessionless signal store, compression rules, packets, name
+     * table and transmit queues. Off by default and only read at startup:
+     *
+     *   <limit memory_accounting="1"/>
+     */
+    MemoryAccounting::Enable(DaemonConfig::Access()->Get("limit@memory_accounting", 0) != 0);
+    /*
+     * Validate every header name and body signature of every message instead of remembering the
+     * ones each endpoint has already sent, and check that body strings are UTF-8:
+     *
+     *   <limit pedantic_validation="1"/>
+     */
+    ValidationCache::SetPedantic(DaemonConfig::Access()->Get("limit@pedantic_validation", 0) != 0);
+    /*
+     * Let housekeeping timers (name and sessionless signal expiry, idle link probes, pooled
+     * connection reaping, hub retries and the name service tick) fire up to this many
+     * milliseconds late so their wakeups coalesce, for example:
+     *
+     *   <limit timer_slack="1000"/>
+     */
+    TimerSlack::Set(DaemonConfig::Access()->Get("limit@timer_slack", 0));
+    /*
+     * Run the endpoint dispatcher, IODispatch and PacketEngine threads with a real-time policy
+     * ("fifo" or "rr") and priority, restricted to the cpus in a hexadecimal mask, and lock the
+     * daemon into memory, for example:
+     *
+     *   <limit dispatch_scheduling="fifo" dispatch_priority="50" dispatch_cpus="0xc" lock_memory="1"/>
+     */
+    qcc::String schedStr = DaemonConfig::Access()->Get("limit@dispatch_scheduling", "default");
+    qcc::String cpuStr = DaemonConfig::Access()->Get("limit@dispatch_cpus", "0");
+    if ((cpuStr.size() > 2) && (cpuStr[0] == '0') && ((cpuStr[1] == 'x') || (cpuStr[1] == 'X'))) {
+        cpuStr.erase(0, 2);
+    }
+    uint64_t cpuMask = StringToU64(cpuStr, 16, 0);
+    bool lockMemory = (DaemonConfig::Access()->Get("limit@lock_memory", 0) != 0);
+    ThreadScheduling::Policy policy = ThreadScheduling::POLICY_DEFAULT;
+    if (schedStr == "fifo") {
+        policy = ThreadScheduling::POLICY_FIFO;
+    } else if (schedStr == "rr") {
+        policy = ThreadScheduling::POLICY_RR;
+    } else if (schedStr != "default") {
+        QCC_LogError(ER_BAD_ARG_1, ("Unknown dispatch_scheduling \"%s\", using default", schedStr.c_str()));
+    }
+    if ((policy != ThreadScheduling::POLICY_DEFAULT) || (cpuMask != 0) || lockMemory) {
+        QStatus status = ThreadScheduling::Set(policy, DaemonConfig::Access()->Get("limit@dispatch_priority", 1), cpuMask, lockMemory);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to set dispatch thread scheduling"));
+        }
+    }
+    /*
+     * Only start the local transport when the bus starts, the other transports, and the name
+     * services they use, are started by the first advertise, find or join. Intended for the
+     * bundled daemon where most applications only ever talk to local peers:
+     *
+     *   <limit deferred_transports="1"/>
+     */
+    if (DaemonConfig::Access()->Get("limit@deferred_transports", 0) != 0) {
+        GetInternal().GetTransportList().DeferTransportStart();
+        deferred = true;
+    }
+}
+
+QStatus Bus::StartDeferredTransports()
+{
+    QStatus status = ER_OK;
+    if (deferred) {
+        deferredLock.Lock(MUTEX_CONTEXT);
+        if (deferred) {
+            QCC_DbgHLPrintf(("Starting deferred transports"));
+            status = GetInternal().GetTransportList().StartTransports();
+            if ((status == ER_OK) && !deferredSpecs.empty()) {
+                status = StartListenSpecs(deferredSpecs);
+            }
+            /* Cleared last so other callers do not proceed until the transports are listening */
+            deferred = false;
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Failed to start deferred transports"));
+            }
+        }
+        deferredLock.Unlock(MUTEX_CONTEXT);
+    }
+    return status;
 }
 
 QStatus Bus::StartListen(const qcc::String& listenSpec, bool& listening)
@@ -76,33 +183,48 @@ QStatus Bus::StartListen(const qcc::String& listenSpec, bool& listening)
 }
 
 QStatus Bus::StartListen(const char* listenSpecs)
+{
+    if (!IsStarted()) {
+        QCC_LogError(ER_BUS_BUS_NOT_STARTED, ("BusAttachment::StartListen failed"));
+        return ER_BUS_BUS_NOT_STARTED;
+    }
+    deferredLock.Lock(MUTEX_CONTEXT);
+    if (deferred) {
+        /* Remember the specs until the transports are started */
+        if (!deferredSpecs.empty()) {
+            deferredSpecs += ';';
+        }
+        deferredSpecs += listenSpecs;
+        deferredLock.Unlock(MUTEX_CONTEXT);
+        return ER_OK;
+    }
+    deferredLock.Unlock(MUTEX_CONTEXT);
+    return StartListenSpecs(listenSpecs);
+}
+
+QStatus Bus::StartListenSpecs(const qcc::String& specs)
 {
     QStatus status(ER_OK);
-    qcc::String specs = listenSpecs;
     bool listening = false;
+    size_t pos = 0;
 
-    if (!IsStarted()) {
-        status = ER_BUS_BUS_NOT_STARTED;
-    } else {
-        size_t pos = 0;
-        while (qcc::String::npos != pos) {
-            size_t endPos = specs.find_first_of(';', pos);
-            qcc::String spec((qcc::String::npos == endPos) ? specs.substr(pos) : specs.substr(pos, endPos - pos));
-            QStatus s(StartListen(spec, listening));
-            if (status == ER_OK) {
-                status = s;
-            }
-
-            pos = ((qcc::String::npos == endPos) || (specs.size() <= endPos + 1)) ? qcc::String::npos : endPos + 1;
-        }
-        /*
-         * BusAttachment needs to be listening on at least one transport
-         */
-        if (listening) {
-            status = ER_OK;
-        } else {
-            status = ER_BUS_NO_TRANSPORTS;
+    while (qcc::String::npos != pos) {
+        size_t endPos = specs.find_first_of(';', pos);
+        qcc::String spec((qcc::String::npos == endPos) ? specs.substr(pos) : specs.substr(pos, endPos - pos));
+        QStatus s(StartListen(spec, listening));
+        if (status == ER_OK) {
+            status = s;
         }
+
+        pos = ((qcc::String::npos == endPos) || (specs.size() <= endPos + 1)) ? qcc::String::npos : endPos + 1;
+    }
+    /*
+     * BusAttachment needs to be listening on at least one transport
+     */
+    if (listening) {
+        status = ER_OK;
+    } else {
+        status = ER_BUS_NO_TRANSPORTS;
     }
     if (status != ER_OK) {
         QCC_LogError(status, ("BusAttachment::StartListen failed"));
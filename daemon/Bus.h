@@ -31,6 +31,7 @@
 #include <set>
 
 #include <qcc/String.h>
+#include <qcc/Mutex.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/BusListener.h>
@@ -75,6 +76,17 @@ class Bus : public BusAttachment, public NameListener {
      */
     QStatus StartListen(const char* listenSpecs);
 
+    /**
+     * Start the transports and listen on the listen specs that were deferred because the bus was
+     * configured with <limit deferred_transports="1"/>. Called before the first operation that
+     * needs a transport other than the local transport. Does nothing if there is nothing deferred.
+     *
+     * @return
+     *      - ER_OK if successful
+     *      - An error status otherwise
+     */
+    QStatus StartDeferredTransports();
+
     /**
      * Stop listening for incomming AllJoyn connections on a given transport address.
      *
@@ -148,9 +160,24 @@ class Bus : public BusAttachment, public NameListener {
      */
     QStatus StartListen(const qcc::String& listenSpec, bool& listening);
 
+    /**
+     * Listen on a semicolon separated list of transport specs.
+     *
+     * @param specs     The listen specs.
+     *
+     * @return
+     *      - ER_OK if listening on at least one of the specs
+     *      - ER_BUS_NO_TRANSPORTS otherwise
+     */
+    QStatus StartListenSpecs(const qcc::String& specs);
+
     qcc::String localAddrs;      ///< Bus Addresses locally accessable
     qcc::String externalAddrs;   ///< Bus Addresses externall accessable
 
+    volatile bool deferred;      ///< True while the transport start and listen are deferred
+    qcc::String deferredSpecs;   ///< Listen specs to listen on once the transports are started
+    qcc::Mutex deferredLock;     ///< Serializes starting the deferred transports
+
     std::set<BusListener*> busListeners;
 };
 
@@ -35,6 +35,9 @@
 #include "AllJoynObj.h"
 #include "AllJoynDebugObj.h"
 #include "SessionlessObj.h"
+#ifndef NDEBUG
+#include "StatsDebug.h"
+#endif
 #include "ProtectedAuthListener.h"
 
 namespace ajn {
@@ -106,8 +109,14 @@ class BusController {
     /**
      * Attempt to start a service to handle the message received.
      *
+     * This is called from the routing path, so it must not wait for the service to start.
+     * The daemon has no service launcher: the ServiceDB and servicehelper sources are not built.
+     * Auto-start therefore fails straight away and the sender gets ServiceUnknown.
+     *
      * @param msg       The message received.
      * @param sendingEP The endpoint the message was received on
+     *
+     * @return ER_NOT_IMPLEMENTED
      */
     QStatus StartService(Message& msg, BusEndpoint sendingEP) {
         return ER_NOT_IMPLEMENTED;
@@ -176,6 +185,9 @@ class BusController {
 #ifndef NDEBUG
     /** Bus object responsible for org.alljoyn.Debug */
     debug::AllJoynDebugObj alljoynDebugObj;
+
+    /** Publishes the router and endpoint counters on org.alljoyn.Bus.Debug.Stats */
+    debug::StatsDebugObj statsDebugObj;
 #endif
 
     /** Event to wait on while initialization completes */
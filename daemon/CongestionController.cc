@@ -0,0 +1,200 @@
+/**
+ * @file
+ * CongestionController implementations used by PacketEngine.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <math.h>
+
+#include <qcc/Debug.h>
+#include <qcc/time.h>
+
+#include "CongestionController.h"
+
+#define QCC_MODULE "PACKET"
+
+using namespace qcc;
+
+namespace ajn {
+
+/* CUBIC scaling constant (RFC 8312 section 5) */
+static const double CUBIC_C = 0.4;
+
+/* CUBIC multiplicative decrease factor */
+static const double CUBIC_BETA = 0.7;
+
+/* Round trip time assumed until the first sample arrives */
+static const uint32_t CUBIC_INITIAL_RTT_MS = 100;
+
+CongestionControlType CongestionControlFromString(const qcc::String& name, CongestionControlType def)
+{
+    if (name == "reno") {
+        return CONGESTION_CONTROL_RENO;
+    } else if (name == "cubic") {
+        return CONGESTION_CONTROL_CUBIC;
+    }
+    if (!name.empty()) {
+        QCC_LogError(ER_INVALID_DATA, ("Unknown congestion control \"%s\"", name.c_str()));
+    }
+    return def;
+}
+
+CongestionController* CongestionController::Create(CongestionControlType type, uint16_t maxWindow)
+{
+    if (type == CONGESTION_CONTROL_CUBIC) {
+        return new CubicCongestionController(maxWindow);
+    }
+    return new RenoCongestionController(maxWindow);
+}
+
+uint64_t CongestionController::Now() const
+{
+    return GetTimestamp64();
+}
+
+void CongestionController::SetMaxWindow(uint16_t maxWindow)
+{
+    this->maxWindow = maxWindow;
+    if (window > maxWindow) {
+        window = maxWindow;
+    }
+    if (slowStartThresh > maxWindow) {
+        slowStartThresh = maxWindow;
+    }
+}
+
+void RenoCongestionController::OnAck(uint16_t ackedPackets, uint32_t rttMs)
+{
+    while (ackedPackets && (window < maxWindow)) {
+        if ((window < slowStartThresh) || (consecutiveAcks >= window)) {
+            ++window;
+            consecutiveAcks = 0;
+        } else {
+            consecutiveAcks++;
+        }
+        --ackedPackets;
+    }
+}
+
+void RenoCongestionController::OnRetransmit()
+{
+    if (window > 1) {
+        window = window >> 1;
+        slowStartThresh = (window > 2) ? window : 2;
+    }
+}
+
+CubicCongestionController::CubicCongestionController(uint16_t maxWindow) :
+    CongestionController(maxWindow),
+    cwnd(1.0),
+    wMax(0.0),
+    k(0.0),
+    epochStart(0),
+    lastReduction(0),
+    srttMs(0)
+{
+}
+
+void CubicCongestionController::SetWindow(double w)
+{
+    if (w < 1.0) {
+        w = 1.0;
+    } else if (w > maxWindow) {
+        w = maxWindow;
+    }
+    cwnd = w;
+    window = static_cast<uint16_t>(w);
+}
+
+void CubicCongestionController::SetMaxWindow(uint16_t maxWindow)
+{
+    CongestionController::SetMaxWindow(maxWindow);
+    SetWindow(cwnd);
+}
+
+void CubicCongestionController::OnAck(uint16_t ackedPackets, uint32_t rttMs)
+{
+    if (rttMs) {
+        srttMs = srttMs ? ((7 * srttMs + rttMs) / 8) : rttMs;
+    }
+    if (ackedPackets == 0) {
+        return;
+    }
+
+    /* Slow start is the same as Reno */
+    if (cwnd < slowStartThresh) {
+        SetWindow(cwnd + ackedPackets);
+        return;
+    }
+
+    uint64_t now = Now();
+    if (epochStart == 0) {
+        epochStart = now;
+        if (cwnd < wMax) {
+            k = pow((wMax - cwnd) / CUBIC_C, 1.0 / 3.0);
+        } else {
+            k = 0.0;
+            wMax = cwnd;
+        }
+    }
+
+    /* The window the cubic function wants one round trip from now */
+    uint32_t rtt = srttMs ? srttMs : CUBIC_INITIAL_RTT_MS;
+    double t = static_cast<double>(now - epochStart + rtt) / 1000.0;
+    double target = CUBIC_C * (t - k) * (t - k) * (t - k) + wMax;
+
+    /* Never grow more slowly than Reno would have over the same period */
+    double renoWindow = wMax * CUBIC_BETA + (3.0 * (1.0 - CUBIC_BETA) / (1.0 + CUBIC_BETA)) * (static_cast<double>(now - epochStart) / rtt);
+    if (target < renoWindow) {
+        target = renoWindow;
+    }
+
+    /* Grow at most (target - cwnd) / cwnd per acked packet */
+    if (target > cwnd) {
+        SetWindow(cwnd + ((target - cwnd) / cwnd) * ackedPackets);
+    } else {
+        SetWindow(cwnd + (0.01 / cwnd) * ackedPackets);
+    }
+}
+
+void CubicCongestionController::OnRetransmit()
+{
+    uint64_t now = Now();
+    uint32_t rtt = srttMs ? srttMs : CUBIC_INITIAL_RTT_MS;
+
+    /* Losses within one round trip of a reduction are part of the same congestion event */
+    if (lastReduction && ((now - lastReduction) < rtt)) {
+        return;
+    }
+    lastReduction = now;
+
+    /* Fast convergence: release bandwidth if the loss happened below the previous maximum */
+    if (cwnd < wMax) {
+        wMax = cwnd * (1.0 + CUBIC_BETA) / 2.0;
+    } else {
+        wMax = cwnd;
+    }
+    SetWindow(cwnd * CUBIC_BETA);
+    slowStartThresh = (window > 2) ? window : 2;
+    epochStart = 0;
+    QCC_DbgPrintf(("CUBIC window reduced to %d (wMax=%d)", window, static_cast<int>(wMax)));
+}
+
+}
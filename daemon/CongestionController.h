@@ -0,0 +1,182 @@
+/**
+ * @file
+ * CongestionController implementations used by PacketEngine to size the transmit window
+ * of a channel.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_CONGESTIONCONTROLLER_H
+#define _ALLJOYN_CONGESTIONCONTROLLER_H
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+
+namespace ajn {
+
+/**
+ * Congestion control algorithms that can be selected for a PacketEngine channel.
+ */
+enum CongestionControlType {
+    CONGESTION_CONTROL_RENO = 0,   /**< Additive increase, halve the window on every retransmit (the original scheme) */
+    CONGESTION_CONTROL_CUBIC = 1   /**< CUBIC window growth, reduce once per round trip on loss */
+};
+
+/**
+ * Parse the name of a congestion control algorithm ("reno" or "cubic").
+ *
+ * @param name   The name.
+ * @param def    Value returned if the name is not recognized.
+ *
+ * @return  The congestion control type.
+ */
+CongestionControlType CongestionControlFromString(const qcc::String& name, CongestionControlType def);
+
+/**
+ * A CongestionController decides how many unacknowledged packets a channel may have in flight.
+ * Controllers are not thread-safe, the caller holds the channel's tx lock.
+ */
+class CongestionController {
+  public:
+
+    /**
+     * Create a congestion controller.
+     *
+     * @param type        The algorithm.
+     * @param maxWindow   The channel's window size, the congestion window never exceeds it.
+     *
+     * @return  A new controller, the caller must delete it.
+     */
+    static CongestionController* Create(CongestionControlType type, uint16_t maxWindow);
+
+    /** Destructor */
+    virtual ~CongestionController() { }
+
+    /**
+     * Get the algorithm implemented by this controller.
+     *
+     * @return  The congestion control type.
+     */
+    virtual CongestionControlType GetType() const = 0;
+
+    /**
+     * Called when an ack is received.
+     *
+     * @param ackedPackets   Number of packets newly acknowledged by the ack.
+     * @param rttMs          Round trip time sample in milliseconds or 0 if the ack has no valid sample.
+     */
+    virtual void OnAck(uint16_t ackedPackets, uint32_t rttMs) = 0;
+
+    /**
+     * Called when a packet has to be retransmitted.
+     */
+    virtual void OnRetransmit() = 0;
+
+    /**
+     * Get the congestion window.
+     *
+     * @return  Maximum number of unexpired packets in flight.
+     */
+    uint16_t GetWindow() const { return window; }
+
+    /**
+     * Get the slow start threshold.
+     *
+     * @return  The slow start threshold.
+     */
+    uint16_t GetSlowStartThresh() const { return slowStartThresh; }
+
+    /**
+     * Determine if the controller is past slow start. Acks can be delayed once it is.
+     *
+     * @return  true if the congestion window is above the slow start threshold.
+     */
+    bool IsPastSlowStart() const { return window > slowStartThresh; }
+
+    /**
+     * Change the channel's window size. Called when the window size is (re)negotiated.
+     *
+     * @param maxWindow   The new channel window size.
+     */
+    virtual void SetMaxWindow(uint16_t maxWindow);
+
+  protected:
+
+    CongestionController(uint16_t maxWindow) : window(1), slowStartThresh(maxWindow), maxWindow(maxWindow) { }
+
+    /**
+     * Get the time used for time based window growth. Tests override this to run on a
+     * simulated clock.
+     *
+     * @return  Timestamp in milliseconds.
+     */
+    virtual uint64_t Now() const;
+
+    uint16_t window;            /**< Congestion window in packets */
+    uint16_t slowStartThresh;   /**< Slow start threshold in packets */
+    uint16_t maxWindow;         /**< Channel window size */
+};
+
+/**
+ * The original PacketEngine scheme: slow start followed by additive increase and halving of
+ * the window on each retransmit.
+ */
+class RenoCongestionController : public CongestionController {
+  public:
+    RenoCongestionController(uint16_t maxWindow) : CongestionController(maxWindow), consecutiveAcks(0) { }
+
+    CongestionControlType GetType() const { return CONGESTION_CONTROL_RENO; }
+
+    void OnAck(uint16_t ackedPackets, uint32_t rttMs);
+
+    void OnRetransmit();
+
+  private:
+    uint16_t consecutiveAcks;
+};
+
+/**
+ * CUBIC window growth (RFC 8312). After a loss the window grows as a cubic function of the time
+ * since the loss so it quickly returns to the window at which the loss happened and then probes
+ * carefully beyond it. The window is reduced at most once per round trip so a burst of losses on
+ * a lossy wireless link does not collapse the window.
+ */
+class CubicCongestionController : public CongestionController {
+  public:
+    CubicCongestionController(uint16_t maxWindow);
+
+    CongestionControlType GetType() const { return CONGESTION_CONTROL_CUBIC; }
+
+    void OnAck(uint16_t ackedPackets, uint32_t rttMs);
+
+    void OnRetransmit();
+
+    void SetMaxWindow(uint16_t maxWindow);
+
+  private:
+    double cwnd;             /**< Fractional congestion window */
+    double wMax;             /**< Window at the last reduction */
+    double k;                /**< Time in seconds for the cubic function to return to wMax */
+    uint64_t epochStart;     /**< Timestamp (ms) at which the current growth epoch began, 0 if none */
+    uint64_t lastReduction;  /**< Timestamp (ms) of the last window reduction */
+    uint32_t srttMs;         /**< Smoothed round trip time in milliseconds */
+
+    void SetWindow(double w);
+};
+
+}
+
+#endif
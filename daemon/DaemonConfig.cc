@@ -55,14 +55,14 @@ DaemonConfig* DaemonConfig::Load(qcc::Source& configSrc)
     }
     XmlParseContext xmlParseCtx(configSrc);
 
-    if (singleton->config) {
-        delete singleton->config;
-        singleton->config = NULL;
-    }
-
     QStatus status = XmlElement::Parse(xmlParseCtx);
     if (status == ER_OK) {
+        delete singleton->config;
         singleton->config = xmlParseCtx.DetachRoot();
+        singleton->UpdateSnapshot();
+    } else if (singleton->config) {
+        QCC_LogError(status, ("Cannot parse configuration, keeping the previous one"));
+        return NULL;
     } else {
         delete singleton;
         singleton = NULL;
@@ -76,6 +76,46 @@ DaemonConfig* DaemonConfig::Load(const char* configXml)
     return Load(src);
 }
 
+DaemonConfig* DaemonConfig::Load(const Entry* entries, size_t numEntries)
+{
+    if (!singleton) {
+        singleton = new DaemonConfig();
+    }
+    delete singleton->config;
+
+    XmlElement* root = new XmlElement("busconfig");
+    for (size_t i = 0; i < numEntries; ++i) {
+        const Entry& entry = entries[i];
+        String path = entry.path;
+        XmlElement* parent = root;
+        size_t pos = 0;
+        size_t endPos;
+        /* Find or create the enclosing elements */
+        while ((endPos = path.find_first_of('/', pos)) != String::npos) {
+            String tag = path.substr(pos, endPos - pos);
+            XmlElement* child = NULL;
+            const vector<XmlElement*>& children = parent->GetChildren();
+            for (size_t c = 0; c < children.size(); ++c) {
+                if (children[c]->GetName() == tag) {
+                    child = children[c];
+                    break;
+                }
+            }
+            parent = child ? child : &parent->CreateChild(tag);
+            pos = endPos + 1;
+        }
+        XmlElement& elem = parent->CreateChild(path.substr(pos));
+        if (entry.attribute) {
+            elem.AddAttribute(entry.attribute, entry.value);
+        } else if (entry.value) {
+            elem.SetContent(entry.value);
+        }
+    }
+    singleton->config = root;
+    singleton->UpdateSnapshot();
+    return singleton;
+}
+
 uint32_t DaemonConfig::Get(const char* key, uint32_t defaultVal)
 {
     return StringToU32(Get(key), 10, defaultVal);
@@ -111,3 +151,37 @@ bool DaemonConfig::Has(const char* key)
     String path = key;
     return config ? !config->GetPath(path).empty() : false;
 }
+
+DaemonConfig::Snapshot DaemonConfig::GetSnapshot() const
+{
+    snapshotLock.Lock(MUTEX_CONTEXT);
+    Snapshot s = snapshot;
+    snapshotLock.Unlock(MUTEX_CONTEXT);
+    return s;
+}
+
+void DaemonConfig::Resolve(Value& value, const char* key)
+{
+    /* A string is a number if it converts to the same value whatever the value for bad strings is */
+    qcc::String str = Get(key);
+    value.value = StringToU32(str, 10, 0);
+    value.isSet = !str.empty() && (value.value == StringToU32(str, 10, 1));
+}
+
+void DaemonConfig::UpdateSnapshot()
+{
+    Snapshot s;
+    Resolve(s.authTimeout, "limit@auth_timeout");
+    Resolve(s.maxIncompleteConnections, "limit@max_incomplete_connections");
+    Resolve(s.maxCompletedConnections, "limit@max_completed_connections");
+    Resolve(s.udpMaxIncompleteConnections, "udp/limit@max_incomplete_connections");
+    Resolve(s.udpMaxCompletedConnections, "udp/limit@max_completed_connections");
+    Resolve(s.iceMaxIncompleteConnections, "ice/limit@max_incomplete_connections");
+    Resolve(s.iceMaxCompletedConnections, "ice/limit@max_completed_connections");
+    Resolve(s.icePacingInterval, "ice/limit@pacing_interval");
+    Resolve(s.iceAggressiveNomination, "ice/limit@aggressive_nomination");
+
+    snapshotLock.Lock(MUTEX_CONTEXT);
+    snapshot = s;
+    snapshotLock.Unlock(MUTEX_CONTEXT);
+}
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <qcc/platform.h>
+#include <qcc/Mutex.h>
 #include <qcc/XmlElement.h>
 #include <qcc/String.h>
 
@@ -37,6 +38,54 @@ class DaemonConfig {
 
   public:
 
+    /**
+     * One element of a precompiled configuration. The path names the element with its enclosing
+     * tags separated by '/'. Enclosing tags are shared between entries, the last tag is always a
+     * new element, so a list of entries builds the same tree as the equivalent XML.
+     */
+    struct Entry {
+        const char* path;       /**< Path to the element, the outermost tag is implicit */
+        const char* attribute;  /**< Attribute to set or NULL to set the element content */
+        const char* value;      /**< Attribute value or element content */
+    };
+
+    /**
+     * A numeric configuration value resolved when the configuration was loaded.
+     */
+    class Value {
+      public:
+        Value() : isSet(false), value(0) { }
+
+        /**
+         * @param defaultVal  The value to use if the key is not present or is not a number
+         *
+         * @return  The configured value or defaultVal.
+         */
+        uint32_t Get(uint32_t defaultVal) const { return isSet ? value : defaultVal; }
+
+      private:
+        friend class DaemonConfig;
+        bool isSet;
+        uint32_t value;
+    };
+
+    /**
+     * The values read on hot paths, resolved once each time a configuration is loaded so that
+     * reading them does not walk the XML or parse strings. Defaults are left to the readers since
+     * they differ between transports.
+     */
+    struct Snapshot {
+        Value authTimeout;                    /**< limit@auth_timeout */
+        Value maxIncompleteConnections;       /**< limit@max_incomplete_connections */
+        Value maxCompletedConnections;        /**< limit@max_completed_connections */
+        Value udpMaxIncompleteConnections;    /**< udp/limit@max_incomplete_connections */
+        Value udpMaxCompletedConnections;     /**< udp/limit@max_completed_connections */
+        Value iceMaxIncompleteConnections;    /**< ice/limit@max_incomplete_connections */
+        Value iceMaxCompletedConnections;     /**< ice/limit@max_completed_connections */
+        Value icePacingInterval;              /**< ice/limit@pacing_interval */
+        Value iceAggressiveNomination;        /**< ice/limit@aggressive_nomination */
+    };
+
     /**
      * Load a configuration creating the singleton if needed.
      *
@@ -45,12 +94,24 @@ class DaemonConfig {
     static DaemonConfig* Load(const char* configXml);
 
     /**
-     * Load a configuration creating the singleton if needed.
+     * Load a configuration creating the singleton if needed. If the xml cannot be parsed when a
+     * configuration is reloaded the previous configuration stays in effect.
      *
      * @param configXml  A source containing the configuration xml
+     *
+     * @return  The singleton or NULL if the xml cannot be parsed.
      */
     static DaemonConfig* Load(qcc::Source& configSrc);
 
+    /**
+     * Load a precompiled configuration creating the singleton if needed. This avoids parsing XML
+     * for configurations that are built into the daemon.
+     *
+     * @param entries     The configuration entries
+     * @param numEntries  The number of entries
+     */
+    static DaemonConfig* Load(const Entry* entries, size_t numEntries);
+
     /**
      * Return the configuration singleton
      */
@@ -105,6 +166,12 @@ class DaemonConfig {
      */
     bool Has(const char* key);
 
+    /**
+     * Get the values of the most recently loaded configuration. The copy is taken under a lock
+     * so it never mixes values of two loads, and it is not changed by a later reload.
+     */
+    Snapshot GetSnapshot() const;
+
   private:
 
     DaemonConfig();
@@ -121,8 +188,18 @@ class DaemonConfig {
 
     ~DaemonConfig();
 
+    /** Resolve a value of the loaded configuration */
+    void Resolve(Value& value, const char* key);
+
+    /** Resolve the snapshot of the loaded configuration and swap it in */
+    void UpdateSnapshot();
+
     qcc::XmlElement* config;
 
+    Snapshot snapshot;
+
+    mutable qcc::Mutex snapshotLock;
+
     static DaemonConfig* singleton;
 
 };
@@ -23,9 +23,18 @@
 #include <qcc/platform.h>
 
 #include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
 
 #include <qcc/Debug.h>
 #include <qcc/Logger.h>
+#include <qcc/Mutex.h>
 #include <qcc/String.h>
 #include <qcc/Util.h>
 #include <qcc/atomic.h>
@@ -38,6 +47,7 @@
 #include "DaemonRouter.h"
 #include "EndpointHelper.h"
 #include "DaemonConfig.h"
+#include "LogRateLimit.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -47,30 +57,255 @@ using namespace qcc;
 
 namespace ajn {
 
+/*
+ * Broadcasts copy their recipients out from under the locks and deliver without them. Each thread
+ * keeps the vector it copies into so that a broadcast does not allocate once the vector has grown
+ * to fit. Delivering can broadcast again on the same thread, the nested broadcast then finds no
+ * cached vector and uses one of its own.
+ */
+struct BroadcastRecipients {
+    std::vector<BusEndpoint> endpoints;
+};
+
+/* Recipient vectors bigger than this are not kept so one huge broadcast does not pin the memory */
+static const size_t MAX_CACHED_RECIPIENTS = 1024;
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/* Called on thread exit to release the thread's recipient vector */
+static void ReleaseBroadcastRecipients(void* arg)
+{
+    delete reinterpret_cast<BroadcastRecipients*>(arg);
+}
+
+static pthread_key_t recipientsKey;
+static bool recipientsKeyValid = (pthread_key_create(&recipientsKey, ReleaseBroadcastRecipients) == 0);
+
+static BroadcastRecipients* TakeBroadcastRecipients()
+{
+    BroadcastRecipients* recipients = NULL;
+    if (recipientsKeyValid) {
+        recipients = reinterpret_cast<BroadcastRecipients*>(pthread_getspecific(recipientsKey));
+        if (recipients) {
+            pthread_setspecific(recipientsKey, NULL);
+        }
+    }
+    return recipients ? recipients : new BroadcastRecipients;
+}
+
+static void GiveBroadcastRecipients(BroadcastRecipients* recipients)
+{
+    /* Drop the endpoint references but keep the storage */
+    recipients->endpoints.clear();
+    if (recipientsKeyValid && (recipients->endpoints.capacity() <= MAX_CACHED_RECIPIENTS) &&
+        !pthread_getspecific(recipientsKey) && (pthread_setspecific(recipientsKey, recipients) == 0)) {
+        return;
+    }
+    delete recipients;
+}
+
+#else
+
+/* Per-thread recipient vectors are only implemented for posix, other platforms allocate per broadcast */
+static BroadcastRecipients* TakeBroadcastRecipients()
+{
+    return new BroadcastRecipients;
+}
+
+static void GiveBroadcastRecipients(BroadcastRecipients* recipients)
+{
+    delete recipients;
+}
+
+#endif
+
+/* Holds the calling thread's recipient vector for the duration of one broadcast */
+class BroadcastScope {
+  public:
+    BroadcastScope() : recipients(TakeBroadcastRecipients()) { }
+    ~BroadcastScope() { GiveBroadcastRecipients(recipients); }
+    std::vector<BusEndpoint>& Endpoints() { return recipients->endpoints; }
+
+  private:
+    BroadcastScope(const BroadcastScope& other);
+    BroadcastScope& operator=(const BroadcastScope& other);
+
+    BroadcastRecipients* recipients;
+};
+
+/* A resolved unicast route, valid while both generations it was resolved under are current */
+struct RouteCacheEntry {
+    uint32_t nameGeneration;
+    uint32_t sessionGeneration;
+    SessionId sessionId;
+    qcc::String destination;
+    BusEndpoint destEp;
+    RemoteEndpoint b2bEp;
+
+    RouteCacheEntry() : nameGeneration(0), sessionGeneration(0), sessionId(0) { }
+};
+
+/* Number of routes each thread remembers, a route is replaced by the next one that hashes to its slot */
+static const size_t ROUTE_CACHE_SIZE = 64;
+
+struct RouteCache {
+    qcc::Mutex lock;    /**< Only contended while ForgetRoutes() clears an entry */
+    RouteCacheEntry entries[ROUTE_CACHE_SIZE];
+};
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/*
+ * Messages are routed on the routing workers, and on the threads of local senders, all of which
+ * live far longer than the endpoints they route to. The caches are registered so that an
+ * endpoint's entries can be dropped when it is unregistered rather than pinning it until its slot
+ * happens to be reused.
+ */
+static qcc::Mutex routeCachesLock;
+static std::vector<RouteCache*> routeCaches;
+
+static void ReleaseRouteCache(void* arg)
+{
+    RouteCache* cache = reinterpret_cast<RouteCache*>(arg);
+    routeCachesLock.Lock(MUTEX_CONTEXT);
+    routeCaches.erase(std::remove(routeCaches.begin(), routeCaches.end(), cache), routeCaches.end());
+    routeCachesLock.Unlock(MUTEX_CONTEXT);
+    delete cache;
+}
+
+static pthread_key_t routeCacheKey;
+static bool routeCacheKeyValid = (pthread_key_create(&routeCacheKey, ReleaseRouteCache) == 0);
+
+static RouteCache* GetRouteCache()
+{
+    if (!routeCacheKeyValid) {
+        return NULL;
+    }
+    RouteCache* cache = reinterpret_cast<RouteCache*>(pthread_getspecific(routeCacheKey));
+    if (!cache) {
+        cache = new RouteCache;
+        if (pthread_setspecific(routeCacheKey, cache) != 0) {
+            delete cache;
+            cache = NULL;
+        } else {
+            routeCachesLock.Lock(MUTEX_CONTEXT);
+            routeCaches.push_back(cache);
+            routeCachesLock.Unlock(MUTEX_CONTEXT);
+        }
+    }
+    return cache;
+}
+
+/* Drop every cached route that holds a reference to ep */
+static void ForgetRoutes(BusEndpoint& ep)
+{
+    /* The references are released after the locks since that may destroy the endpoint */
+    std::vector<BusEndpoint> released;
+    routeCachesLock.Lock(MUTEX_CONTEXT);
+    for (size_t i = 0; i < routeCaches.size(); ++i) {
+        RouteCache* cache = routeCaches[i];
+        cache->lock.Lock(MUTEX_CONTEXT);
+        for (size_t j = 0; j < ROUTE_CACHE_SIZE; ++j) {
+            RouteCacheEntry& entry = cache->entries[j];
+            if ((entry.destEp == ep) || (entry.b2bEp == ep)) {
+                released.push_back(entry.destEp);
+                released.push_back(BusEndpoint::cast(entry.b2bEp));
+                entry = RouteCacheEntry();
+            }
+        }
+        cache->lock.Unlock(MUTEX_CONTEXT);
+    }
+    routeCachesLock.Unlock(MUTEX_CONTEXT);
+}
+
+#else
+
+/* Route caching is only implemented for posix, other platforms resolve every message */
+static RouteCache* GetRouteCache()
+{
+    return NULL;
+}
 
-DaemonRouter::DaemonRouter() : ruleTable(), nameTable(), busController(NULL)
+static void ForgetRoutes(BusEndpoint& ep)
 {
 }
 
+#endif
+
+DaemonRouter::DaemonRouter() : ruleTable(), nameTable(), busController(NULL),
+    messagesRouted(0), deliveries(0), broadcasts(0), noRoute(0), pushFailures(0), maxFanOut(0),
+    sessionRouteGeneration(0)
+{
+    ::memset(&retiredStats, 0, sizeof(retiredStats));
+}
+
 DaemonRouter::~DaemonRouter()
 {
 }
 
-static inline QStatus SendThroughEndpoint(Message& msg, BusEndpoint& ep, SessionId sessionId)
+QStatus DaemonRouter::SendThroughEndpoint(Message& msg, BusEndpoint& ep, SessionId sessionId, RemoteEndpoint* b2bEp)
 {
     QStatus status;
+    IncrementAndFetch(&deliveries);
     if ((sessionId != 0) && (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
-        status = VirtualEndpoint::cast(ep)->PushMessage(msg, sessionId);
+        status = (b2bEp && (*b2bEp)->IsValid()) ? (*b2bEp)->PushMessage(msg) : ER_BUS_NO_ROUTE;
+        if (status != ER_OK) {
+            status = VirtualEndpoint::cast(ep)->PushMessage(msg, sessionId);
+        }
     } else {
         status = ep->PushMessage(msg);
     }
     // if the bus is stopping or the endpoint is closing we don't expect to be able to send
     if ((status != ER_OK) && (status != ER_BUS_ENDPOINT_CLOSING) && (status != ER_BUS_STOPPING)) {
-        QCC_LogError(status, ("SendThroughEndpoint(dest=%s, ep=%s, id=%u) failed", msg->GetDestination(), ep->GetUniqueName().c_str(), sessionId));
+        QCC_LogErrorRateLimited(status, ("SendThroughEndpoint(dest=%s, ep=%s, id=%u) failed", msg->GetDestination(), ep->GetUniqueName().c_str(), sessionId));
+    }
+    if (status != ER_OK) {
+        IncrementAndFetch(&pushFailures);
     }
     return status;
 }
 
+void DaemonRouter::ResolveUnicast(const char* destination, SessionId sessionId, BusEndpoint& destEp, RemoteEndpoint& b2bEp)
+{
+    /* Read the generations before resolving so a change made while resolving invalidates the entry */
+    uint32_t nameGeneration = nameTable.GetRouteGeneration();
+    uint32_t sessionGeneration = static_cast<uint32_t>(sessionRouteGeneration);
+    RouteCache* cache = GetRouteCache();
+    RouteCacheEntry* entry = NULL;
+    if (cache) {
+        entry = &cache->entries[(qcc::hash_string(destination) ^ sessionId) % ROUTE_CACHE_SIZE];
+        cache->lock.Lock(MUTEX_CONTEXT);
+        if ((entry->nameGeneration == nameGeneration) && (entry->sessionGeneration == sessionGeneration) &&
+            (entry->sessionId == sessionId) && (entry->destination == destination) && entry->destEp->IsValid()) {
+            destEp = entry->destEp;
+            b2bEp = entry->b2bEp;
+            cache->lock.Unlock(MUTEX_CONTEXT);
+            return;
+        }
+        cache->lock.Unlock(MUTEX_CONTEXT);
+    }
+
+    /* FindEndpoint does not need the name table lock so unicast routing never waits for name changes */
+    destEp = nameTable.FindEndpoint(destination);
+    b2bEp = RemoteEndpoint();
+    if (destEp->IsValid() && (sessionId != 0) && (destEp->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
+        b2bEp = VirtualEndpoint::cast(destEp)->GetBusToBusEndpoint(sessionId);
+    }
+    if (entry && destEp->IsValid()) {
+        /* The entry being replaced may hold the last reference to an endpoint, let it go unlocked */
+        RouteCacheEntry replaced;
+        cache->lock.Lock(MUTEX_CONTEXT);
+        replaced = *entry;
+        entry->nameGeneration = nameGeneration;
+        entry->sessionGeneration = sessionGeneration;
+        entry->sessionId = sessionId;
+        entry->destination = destination;
+        entry->destEp = destEp;
+        entry->b2bEp = b2bEp;
+        cache->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
 QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
 {
     /*
@@ -79,6 +314,7 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
     if (!localEndpoint->IsValid()) {
         return ER_BUS_ENDPOINT_CLOSING;
     }
+    IncrementAndFetch(&messagesRouted);
 
     QStatus status = ER_OK;
     BusEndpoint sender = origSender;
@@ -116,8 +352,9 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
 
     bool destinationEmpty = destination[0] == '\0';
     if (!destinationEmpty) {
-        nameTable.Lock();
-        BusEndpoint destEndpoint = nameTable.FindEndpoint(destination);
+        BusEndpoint destEndpoint;
+        RemoteEndpoint destB2bEp;
+        ResolveUnicast(destination, sessionId, destEndpoint, destB2bEp);
         if (destEndpoint->IsValid()) {
             /* If this message is coming from a bus-to-bus ep, make sure the receiver is willing to receive it */
             if (!((sender->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) && !destEndpoint->AllowRemoteMessages())) {
@@ -135,9 +372,7 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                     BusEndpoint busEndpoint = BusEndpoint::cast(localEndpoint);
                     PushMessage(msg, busEndpoint);
                 } else {
-                    nameTable.Unlock();
-                    status = SendThroughEndpoint(msg, destEndpoint, sessionId);
-                    nameTable.Lock();
+                    status = SendThroughEndpoint(msg, destEndpoint, sessionId, &destB2bEp);
                 }
             } else {
                 QCC_DbgPrintf(("Blocking message from %s to %s (serial=%d) because receiver does not allow remote messages",
@@ -155,11 +390,9 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
             }
             // if the bus is stopping or the endpoint is closing we can't push the message
             if ((ER_OK != status) && (ER_BUS_ENDPOINT_CLOSING != status) && (status != ER_BUS_STOPPING)) {
-                QCC_LogError(status, ("BusEndpoint::PushMessage failed"));
+                QCC_LogErrorRateLimited(status, ("BusEndpoint::PushMessage failed"));
             }
-            nameTable.Unlock();
         } else {
-            nameTable.Unlock();
             if ((msg->GetFlags() & ALLJOYN_FLAG_AUTO_START) &&
                 (sender->GetEndpointType() != ENDPOINT_TYPE_BUS2BUS) &&
                 (sender->GetEndpointType() != ENDPOINT_TYPE_NULL)) {
@@ -169,8 +402,9 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                 status = ER_BUS_NO_ROUTE;
             }
             if (status != ER_OK) {
+                IncrementAndFetch(&noRoute);
                 if (replyExpected) {
-                    QCC_LogError(status, ("Returning error %s no route to %s", msg->Description().c_str(), destination));
+                    QCC_LogErrorRateLimited(status, ("Returning error %s no route to %s", msg->Description().c_str(), destination));
                     /* Need to let the sender know its reply message cannot be passed on. */
                     qcc::String description("Unknown bus name: ");
                     description += destination;
@@ -188,7 +422,7 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                     if (ER_BUS_NO_ROUTE == status) {
                         QCC_DbgHLPrintf(("Discarding %s no route to %s:%d : %s", msg->Description().c_str(), destination, sessionId, QCC_StatusText(status)));
                     } else {
-                        QCC_LogError(status, ("Discarding %s no route to %s:%d", msg->Description().c_str(), destination, sessionId));
+                        QCC_LogErrorRateLimited(status, ("Discarding %s no route to %s:%d", msg->Description().c_str(), destination, sessionId));
                     }
                 }
             }
@@ -198,33 +432,36 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
          * The message has an empty destination field and no session is specified so this is a
          * regular broadcast message.
          */
+        IncrementAndFetch(&broadcasts);
+        uint32_t fanOut = 0;
+        BroadcastScope scope;
+        std::vector<BusEndpoint>& recipients = scope.Endpoints();
         nameTable.Lock();
         ruleTable.Lock();
-        RuleIterator it = ruleTable.Begin();
-        while (it != ruleTable.End()) {
-            if (it->second.IsMatch(msg)) {
-                BusEndpoint dest = it->first;
-                QCC_DbgPrintf(("Routing %s (%d) to %s", msg->Description().c_str(), msg->GetCallSerial(), dest->GetUniqueName().c_str()));
-                /*
-                 * If the message originated locally or the destination allows remote messages
-                 * forward the message, otherwise silently ignore it.
-                 */
-                if (!((sender->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) && !dest->AllowRemoteMessages())) {
-                    ruleTable.Unlock();
-                    nameTable.Unlock();
-                    QStatus tStatus = SendThroughEndpoint(msg, dest, sessionId);
-                    status = (status == ER_OK) ? tStatus : status;
-                    nameTable.Lock();
-                    ruleTable.Lock();
+        ruleTable.FindMatchingEndpoints(msg, recipients);
+        /*
+         * If the message originated locally or the destination allows remote messages
+         * forward the message, otherwise silently ignore it.
+         */
+        if (sender->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) {
+            size_t numAllowed = 0;
+            for (size_t i = 0; i < recipients.size(); ++i) {
+                if (recipients[i]->AllowRemoteMessages()) {
+                    recipients[numAllowed++] = recipients[i];
                 }
-                it = ruleTable.AdvanceToNextEndpoint(dest);
-            } else {
-                ++it;
             }
+            recipients.resize(numAllowed);
         }
         ruleTable.Unlock();
         nameTable.Unlock();
 
+        for (size_t i = 0; i < recipients.size(); ++i) {
+            QCC_DbgPrintf(("Routing %s (%d) to %s", msg->Description().c_str(), msg->GetCallSerial(), recipients[i]->GetUniqueName().c_str()));
+            QStatus tStatus = SendThroughEndpoint(msg, recipients[i], sessionId);
+            status = (status == ER_OK) ? tStatus : status;
+            ++fanOut;
+        }
+
         if (msg->IsSessionless()) {
             /* Give "locally generated" sessionless message to SessionlessObj */
             if (sender->GetEndpointType() != ENDPOINT_TYPE_BUS2BUS) {
@@ -260,24 +497,36 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                 }
             }
 
-            /* Route global broadcast to all bus-to-bus endpoints that aren't the sender of the message */
+            /*
+             * Route global broadcast to all bus-to-bus endpoints that aren't the sender of the message.
+             * Signals that are not sent on a session only go to daemons that may have someone who wants
+             * them. The daemons' own signals are always sent.
+             */
+            bool useDigests = (sessionId == 0) && (::strcmp(org::alljoyn::Daemon::InterfaceName, msg->GetInterface()) != 0);
+            recipients.clear();
             m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-            set<RemoteEndpoint>::iterator it = m_b2bEndpoints.begin();
-            while (it != m_b2bEndpoints.end()) {
+            for (set<RemoteEndpoint>::iterator it = m_b2bEndpoints.begin(); it != m_b2bEndpoints.end(); ++it) {
                 RemoteEndpoint ep = *it;
-                if ((ep != origSender) && ((sessionId == 0) || ep->GetSessionId() == sessionId)) {
-                    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
-                    BusEndpoint busEndpoint = BusEndpoint::cast(ep);
-                    QStatus tStatus = SendThroughEndpoint(msg, busEndpoint, sessionId);
-                    status = (status == ER_OK) ? tStatus : status;
-                    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-                    it = m_b2bEndpoints.lower_bound(ep);
-                }
-                if (it != m_b2bEndpoints.end()) {
-                    ++it;
+                if ((ep != origSender) && ((sessionId == 0) || (ep->GetSessionId() == sessionId) || ep->RoutesSession(sessionId))) {
+                    if (useDigests) {
+                        map<RemoteEndpoint, B2BDigests>::const_iterator dit = m_b2bDigests.find(ep);
+                        if ((dit != m_b2bDigests.end()) && !dit->second.received.Matches(msg->GetInterface(), msg->GetMemberName())) {
+                            continue;
+                        }
+                    }
+                    recipients.push_back(BusEndpoint::cast(ep));
                 }
             }
             m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+
+            for (size_t i = 0; i < recipients.size(); ++i) {
+                QStatus tStatus = SendThroughEndpoint(msg, recipients[i], sessionId);
+                status = (status == ER_OK) ? tStatus : status;
+                ++fanOut;
+            }
+        }
+        if (fanOut > maxFanOut) {
+            maxFanOut = fanOut;
         }
 
     } else {
@@ -285,45 +534,61 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
          * The message has an empty destination field and a session id was specified so this is a
          * session multicast message.
          */
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        RemoteEndpoint lastB2b;
-        /* We need to obtain the first entry in the sessionCastSet that has the id equal to 'sessionId'
-         * and the src equal to 'msg->GetSender()'.
-         * Note: sce.id has been set to sessionId - 1. Since the src is compared first, and session Ids
-         * are integers, upper_bound will return the iterator to the first element with the desired or
-         * greater src(if not present) and desired or greater id in most cases.
-         */
-        SessionCastEntry sce(sessionId - 1, msg->GetSender());
-        set<SessionCastEntry>::iterator sit = sessionCastSet.upper_bound(sce);
+        IncrementAndFetch(&broadcasts);
+        uint32_t fanOut = 0;
+        BroadcastScope scope;
+        std::vector<BusEndpoint>& recipients = scope.Endpoints();
         bool foundDest = false;
 
-        /* In other cases, it may return the iterator to an element that has the desired src and
-         * (sessionId - 1). In that case iterate, until the id is less than the desired one.
+        /*
+         * Collect the destinations under the lock and deliver after releasing it so the lock is
+         * taken once per message rather than once per destination.
          */
-        while ((sit != sessionCastSet.end()) && (sit->src == sce.src) && (sit->id < sessionId)) {
-            sit++;
-        }
-
-        while ((sit != sessionCastSet.end()) && (sit->id == sessionId) && (sit->src == sce.src)) {
-            if (sit->b2bEp != lastB2b) {
-                foundDest = true;
-                lastB2b = sit->b2bEp;
-                SessionCastEntry entry = *sit;
-                BusEndpoint ep = sit->destEp;
-                sessionCastSetLock.Unlock(MUTEX_CONTEXT);
-                QStatus tStatus = SendThroughEndpoint(msg, ep, sessionId);
-                status = (status == ER_OK) ? tStatus : status;
-                sessionCastSetLock.Lock(MUTEX_CONTEXT);
-                sit = sessionCastSet.lower_bound(entry);
-            }
-            if (sit != sessionCastSet.end()) {
+        sessionCastLock.Lock(MUTEX_CONTEXT);
+        unordered_map<SessionId, SessionCastRoutes>::const_iterator mit = sessionCastMap.find(sessionId);
+        if (mit != sessionCastMap.end()) {
+            const qcc::String& src = msg->GetSender();
+            const SessionCastRoutes& routes = mit->second;
+            SessionCastRoutes::const_iterator sit = lower_bound(routes.begin(), routes.end(), src, SessionCastSrcLess());
+            RemoteEndpoint lastB2b;
+            /*
+             * A remote daemon expands the message to all of its own members, so each remote daemon
+             * needs one copy however many members it has and however many links they joined over.
+             */
+            std::vector<qcc::GUID128> sentTo;
+            while ((sit != routes.end()) && (sit->src == src)) {
+                if (sit->b2bEp != lastB2b) {
+                    foundDest = true;
+                    lastB2b = sit->b2bEp;
+                    bool daemonHasCopy = false;
+                    if (lastB2b->IsValid()) {
+                        const qcc::GUID128& guid = lastB2b->GetRemoteGUID();
+                        daemonHasCopy = find(sentTo.begin(), sentTo.end(), guid) != sentTo.end();
+                        if (!daemonHasCopy) {
+                            sentTo.push_back(guid);
+                        }
+                    }
+                    if (!daemonHasCopy) {
+                        recipients.push_back(sit->destEp);
+                    }
+                }
                 ++sit;
             }
         }
+        sessionCastLock.Unlock(MUTEX_CONTEXT);
+
+        for (std::vector<BusEndpoint>::iterator rit = recipients.begin(); rit != recipients.end(); ++rit) {
+            QStatus tStatus = SendThroughEndpoint(msg, *rit, sessionId);
+            status = (status == ER_OK) ? tStatus : status;
+            ++fanOut;
+        }
         if (!foundDest) {
+            IncrementAndFetch(&noRoute);
             status = ER_BUS_NO_ROUTE;
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        if (fanOut > maxFanOut) {
+            maxFanOut = fanOut;
+        }
     }
 
     return status;
@@ -358,6 +623,7 @@ QStatus DaemonRouter::AddRule(BusEndpoint& endpoint, Rule& rule)
     /* Allow busController to examine this rule */
     if (status == ER_OK) {
         busController->AddRule(endpoint->GetUniqueName(), rule);
+        UpdateRuleDigests();
     }
 
     return status;
@@ -369,10 +635,158 @@ QStatus DaemonRouter::RemoveRule(BusEndpoint& endpoint, Rule& rule)
 
     /* Allow busController to examine rule being removed */
     busController->RemoveRule(endpoint->GetUniqueName(), rule);
+    UpdateRuleDigests();
+
+    return status;
+}
+
+void DaemonRouter::AddRules(BusEndpoint& endpoint, std::vector<Rule>& rules, std::vector<QStatus>& results)
+{
+    qcc::String epName = endpoint->GetUniqueName();
+    bool added = false;
+    results.resize(rules.size());
+    for (size_t i = 0; i < rules.size(); ++i) {
+        results[i] = ruleTable.AddRule(endpoint, rules[i]);
+        if (results[i] == ER_OK) {
+            busController->AddRule(epName, rules[i]);
+            added = true;
+        }
+    }
+    if (added) {
+        UpdateRuleDigests();
+    }
+}
+
+void DaemonRouter::RemoveRules(BusEndpoint& endpoint, std::vector<Rule>& rules, std::vector<QStatus>& results)
+{
+    qcc::String epName = endpoint->GetUniqueName();
+    results.resize(rules.size());
+    for (size_t i = 0; i < rules.size(); ++i) {
+        results[i] = ruleTable.RemoveRule(endpoint, rules[i]);
+        busController->RemoveRule(epName, rules[i]);
+    }
+    if (!rules.empty()) {
+        UpdateRuleDigests();
+    }
+}
+
+QStatus DaemonRouter::ReplaceRules(BusEndpoint& endpoint, std::vector<Rule>& rules)
+{
+    QStatus status = ER_OK;
+    vector<Rule> oldRules;
+
+    /* Holding the table lock keeps routing from seeing the endpoint with only part of its rules */
+    ruleTable.Lock();
+    for (RuleIterator it = ruleTable.FindRulesForEndpoint(endpoint); (it != ruleTable.End()) && (it->first == endpoint); ++it) {
+        oldRules.push_back(it->second);
+    }
+    ruleTable.RemoveAllRules(endpoint);
+    for (size_t i = 0; (status == ER_OK) && (i < rules.size()); ++i) {
+        status = ruleTable.AddRule(endpoint, rules[i]);
+    }
+    ruleTable.Unlock();
+
+    /*
+     * The busController counts rules, so telling it about the new rules before the old ones go
+     * away keeps a rule that is in both sets from dropping to zero in between.
+     */
+    qcc::String epName = endpoint->GetUniqueName();
+    for (size_t i = 0; i < rules.size(); ++i) {
+        busController->AddRule(epName, rules[i]);
+    }
+    for (size_t i = 0; i < oldRules.size(); ++i) {
+        busController->RemoveRule(epName, oldRules[i]);
+    }
+    UpdateRuleDigests();
 
     return status;
 }
 
+void DaemonRouter::SetRuleDigest(const qcc::String& b2bName, const RuleDigest& digest)
+{
+    bool found = false;
+    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    for (map<RemoteEndpoint, B2BDigests>::iterator it = m_b2bDigests.begin(); it != m_b2bDigests.end(); ++it) {
+        if (it->first->GetUniqueName() == b2bName) {
+            it->second.received = digest;
+            found = true;
+            break;
+        }
+    }
+    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+
+    /* What the other daemon wants has to be passed on to the daemons behind this one */
+    if (found) {
+        UpdateRuleDigests();
+    }
+}
+
+void DaemonRouter::UpdateRuleDigests()
+{
+    /*
+     * The digest sent to a daemon must cover everyone it can reach through this daemon, that is
+     * the local rules and whatever the daemons at the other bus-to-bus endpoints want. Links to
+     * the daemon itself are left out so a digest is not echoed back to where it came from.
+     */
+    m_digestUpdateLock.Lock(MUTEX_CONTEXT);
+    RuleDigest local;
+    ruleTable.GetDigest(local);
+
+    vector<pair<RemoteEndpoint, RuleDigest> > updates;
+    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    for (map<RemoteEndpoint, B2BDigests>::iterator it = m_b2bDigests.begin(); it != m_b2bDigests.end(); ++it) {
+        RemoteEndpoint ep = it->first;
+        RuleDigest digest = local;
+        for (map<RemoteEndpoint, B2BDigests>::const_iterator oit = m_b2bDigests.begin(); oit != m_b2bDigests.end(); ++oit) {
+            RemoteEndpoint other = oit->first;
+            if (!(other->GetRemoteGUID() == ep->GetRemoteGUID())) {
+                digest.Merge(oit->second.received);
+            }
+        }
+        if (!it->second.sentValid || (digest != it->second.sent)) {
+            it->second.sent = digest;
+            it->second.sentValid = true;
+            updates.push_back(make_pair(ep, digest));
+        }
+    }
+    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+
+    /* Sending may block on a full transmit queue so no router locks are held */
+    for (size_t i = 0; i < updates.size(); ++i) {
+        busController->GetAllJoynObj().SendRuleDigest(updates[i].first, updates[i].second);
+    }
+    m_digestUpdateLock.Unlock(MUTEX_CONTEXT);
+}
+
+/*
+ * Configure the transmit queue of a remote endpoint from the daemon configuration. For example:
+ *
+ *   <limit tx_queue_messages="64"/>
+ *   <limit tx_queue_bytes="1048576"/>
+ *   <limit tx_queue_policy="drop-oldest-signal"/>
+ *
+ * Valid policies are "block" (the default), "drop-oldest-signal", "drop-newest" and "disconnect".
+ */
+static void ConfigureTxQueue(RemoteEndpoint& endpoint)
+{
+    DaemonConfig* config = DaemonConfig::Access();
+    uint32_t maxMessages = config->Get("limit@tx_queue_messages", static_cast<uint32_t>(0));
+    uint32_t maxBytes = config->Get("limit@tx_queue_bytes", static_cast<uint32_t>(0));
+    qcc::String policyStr = config->Get("limit@tx_queue_policy", "block");
+
+    SessionOpts::TxQueuePolicy policy = SessionOpts::TXQUEUE_BLOCK;
+    if (policyStr == "drop-oldest-signal") {
+        policy = SessionOpts::TXQUEUE_DROP_OLDEST_SIGNAL;
+    } else if (policyStr == "drop-newest") {
+        policy = SessionOpts::TXQUEUE_DROP_NEWEST;
+    } else if (policyStr == "disconnect") {
+        policy = SessionOpts::TXQUEUE_DISCONNECT;
+    } else if (policyStr != "block") {
+        QCC_LogError(ER_INVALID_DATA, ("Unknown tx_queue_policy \"%s\"", policyStr.c_str()));
+    }
+    endpoint->SetTxQueuePolicy(policy, maxMessages, maxBytes);
+}
+
 QStatus DaemonRouter::RegisterEndpoint(BusEndpoint& endpoint)
 {
     QCC_DbgTrace(("DaemonRouter::RegisterEndpoint(%s, %d)", endpoint->GetUniqueName().c_str(), endpoint->GetEndpointType()));
@@ -383,6 +797,12 @@ QStatus DaemonRouter::RegisterEndpoint(BusEndpoint& endpoint)
         localEndpoint = LocalEndpoint::cast(endpoint);
     }
 
+    /* Apply the configured transmit queue limits to remote endpoints */
+    if ((endpoint->GetEndpointType() == ENDPOINT_TYPE_REMOTE) || (endpoint->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS)) {
+        RemoteEndpoint remoteEndpoint = RemoteEndpoint::cast(endpoint);
+        ConfigureTxQueue(remoteEndpoint);
+    }
+
     if (endpoint->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) {
         /* AllJoynObj is in charge of managing bus-to-bus endpoints and their names */
         RemoteEndpoint busToBusEndpoint = RemoteEndpoint::cast(endpoint);
@@ -391,7 +811,11 @@ QStatus DaemonRouter::RegisterEndpoint(BusEndpoint& endpoint)
         /* Add to list of bus-to-bus endpoints */
         m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
         m_b2bEndpoints.insert(busToBusEndpoint);
+        m_b2bDigests[busToBusEndpoint] = B2BDigests();
         m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+
+        /* Tell the new daemon which broadcasts are wanted on this side */
+        UpdateRuleDigests();
     } else {
         /* Bus-to-client endpoints appear directly on the bus */
         nameTable.AddUniqueName(endpoint);
@@ -414,6 +838,15 @@ void DaemonRouter::UnregisterEndpoint(const qcc::String& epName, EndpointType ep
     BusEndpoint endpoint = FindEndpoint(epName);
     nameTable.Unlock();
 
+    /* Keep the counters of departing endpoints in the daemon-wide totals */
+    if ((ENDPOINT_TYPE_REMOTE == endpoint->GetEndpointType()) || (ENDPOINT_TYPE_BUS2BUS == endpoint->GetEndpointType())) {
+        _RemoteEndpoint::Stats stats;
+        RemoteEndpoint::cast(endpoint)->GetStats(stats);
+        statsLock.Lock(MUTEX_CONTEXT);
+        AddEndpointStats(retiredStats, stats);
+        statsLock.Unlock(MUTEX_CONTEXT);
+    }
+
     if (ENDPOINT_TYPE_BUS2BUS == endpoint->GetEndpointType()) {
         /* Inform bus controller of bus-to-bus endpoint removal */
         RemoteEndpoint busToBusEndpoint = RemoteEndpoint::cast(endpoint);
@@ -431,25 +864,42 @@ void DaemonRouter::UnregisterEndpoint(const qcc::String& epName, EndpointType ep
             }
             ++it;
         }
+        m_b2bDigests.erase(busToBusEndpoint);
         m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
 
-        /* Remove entries from sessionCastSet with same b2bEp */
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        set<SessionCastEntry>::iterator sit = sessionCastSet.begin();
-        while (sit != sessionCastSet.end()) {
-            set<SessionCastEntry>::iterator doomed = sit;
-            ++sit;
-            if (doomed->b2bEp == endpoint) {
-                sessionCastSet.erase(doomed);
+        /* The other daemons no longer reach what the departed one wanted */
+        UpdateRuleDigests();
+
+        /* Remove entries from sessionCastMap with same b2bEp */
+        sessionCastLock.Lock(MUTEX_CONTEXT);
+        unordered_map<SessionId, SessionCastRoutes>::iterator mit = sessionCastMap.begin();
+        while (mit != sessionCastMap.end()) {
+            SessionCastRoutes& routes = mit->second;
+            SessionCastRoutes::iterator sit = routes.begin();
+            while (sit != routes.end()) {
+                if (sit->b2bEp == endpoint) {
+                    sit = routes.erase(sit);
+                } else {
+                    ++sit;
+                }
+            }
+            if (routes.empty()) {
+                sessionCastMap.erase(mit++);
+            } else {
+                ++mit;
             }
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        sessionCastLock.Unlock(MUTEX_CONTEXT);
+        IncrementAndFetch(&sessionRouteGeneration);
     } else {
         /* Remove any session routes */
         RemoveSessionRoutes(endpoint->GetUniqueName().c_str(), 0);
         /* Remove endpoint from names and rules */
         nameTable.RemoveUniqueName(endpoint->GetUniqueName());
         RemoveAllRules(endpoint);
+        if (!(endpoint == localEndpoint)) {
+            UpdateRuleDigests();
+        }
         PermissionMgr::CleanPermissionCache(endpoint);
     }
     /*
@@ -459,6 +909,65 @@ void DaemonRouter::UnregisterEndpoint(const qcc::String& epName, EndpointType ep
         localEndpoint->Invalidate();
         localEndpoint = LocalEndpoint();
     }
+
+    /* Cached routes must not keep the departed endpoint alive */
+    if (endpoint->IsValid()) {
+        ForgetRoutes(endpoint);
+    }
+}
+
+void DaemonRouter::GetStats(Stats& stats)
+{
+    stats.messagesRouted = static_cast<uint32_t>(messagesRouted);
+    stats.deliveries = static_cast<uint32_t>(deliveries);
+    stats.broadcasts = static_cast<uint32_t>(broadcasts);
+    stats.maxFanOut = maxFanOut;
+    stats.noRoute = static_cast<uint32_t>(noRoute);
+    stats.pushFailures = static_cast<uint32_t>(pushFailures);
+    ruleTable.Lock();
+    stats.ruleEvaluations = ruleTable.GetEvaluations();
+    ruleTable.Unlock();
+}
+
+void DaemonRouter::AddEndpointStats(_RemoteEndpoint::Stats& totals, const _RemoteEndpoint::Stats& stats)
+{
+    totals.rxMessages += stats.rxMessages;
+    totals.rxBytes += stats.rxBytes;
+    totals.txMessages += stats.txMessages;
+    totals.txBytes += stats.txBytes;
+    totals.txQueueHighWater = (std::max)(totals.txQueueHighWater, stats.txQueueHighWater);
+    totals.txDrops += stats.txDrops;
+    totals.idleTimeouts += stats.idleTimeouts;
+}
+
+void DaemonRouter::GetEndpointStats(vector<pair<qcc::String, _RemoteEndpoint::Stats> >& epStats, _RemoteEndpoint::Stats& totals)
+{
+    vector<RemoteEndpoint> endpoints;
+
+    /* Collect the endpoints first so no router locks are held while the counters are read */
+    vector<pair<qcc::String, vector<qcc::String> > > names;
+    nameTable.GetUniqueNamesAndAliases(names);
+    for (size_t i = 0; i < names.size(); ++i) {
+        RemoteEndpoint ep;
+        if (FindEndpoint(names[i].first, ep)) {
+            endpoints.push_back(ep);
+        }
+    }
+    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    endpoints.insert(endpoints.end(), m_b2bEndpoints.begin(), m_b2bEndpoints.end());
+    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+
+    statsLock.Lock(MUTEX_CONTEXT);
+    totals = retiredStats;
+    statsLock.Unlock(MUTEX_CONTEXT);
+
+    epStats.reserve(epStats.size() + endpoints.size());
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        _RemoteEndpoint::Stats stats;
+        endpoints[i]->GetStats(stats);
+        AddEndpointStats(totals, stats);
+        epStats.push_back(pair<qcc::String, _RemoteEndpoint::Stats>(endpoints[i]->GetUniqueName(), stats));
+    }
 }
 
 QStatus DaemonRouter::AddSessionRoute(SessionId id, BusEndpoint& srcEp, RemoteEndpoint* srcB2bEp, BusEndpoint& destEp, RemoteEndpoint& destB2bEp, SessionOpts* optsHint)
@@ -505,17 +1014,17 @@ QStatus DaemonRouter::AddSessionRoute(SessionId id, BusEndpoint& srcEp, RemoteEn
 
     /* Add sessionCast entries */
     if (status == ER_OK) {
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        SessionCastEntry entry(id, srcEp->GetUniqueName(), destB2bEp, destEp);
-        sessionCastSet.insert(entry);
+        sessionCastLock.Lock(MUTEX_CONTEXT);
+        AddSessionCastEntry(SessionCastEntry(id, srcEp->GetUniqueName(), destB2bEp, destEp));
         if (srcB2bEp) {
-            sessionCastSet.insert(SessionCastEntry(id, destEp->GetUniqueName(), *srcB2bEp, srcEp));
+            AddSessionCastEntry(SessionCastEntry(id, destEp->GetUniqueName(), *srcB2bEp, srcEp));
         } else {
             RemoteEndpoint none;
-            sessionCastSet.insert(SessionCastEntry(id, destEp->GetUniqueName(), none, srcEp));
+            AddSessionCastEntry(SessionCastEntry(id, destEp->GetUniqueName(), none, srcEp));
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        sessionCastLock.Unlock(MUTEX_CONTEXT);
     }
+    IncrementAndFetch(&sessionRouteGeneration);
     return status;
 }
 
@@ -539,24 +1048,47 @@ QStatus DaemonRouter::RemoveSessionRoute(SessionId id, BusEndpoint& srcEp, BusEn
         srcB2bEp = vSrcEp->GetBusToBusEndpoint(id);
         vSrcEp->RemoveSessionRef(id);
     }
+    /* Forget any transmit shaping the session set on the links that carried it */
+    if (destB2bEp->IsValid()) {
+        destB2bEp->SetSessionTxShaping(id, SessionOpts::TXPRIORITY_INTERACTIVE, 0, 0);
+    }
+    if (srcB2bEp->IsValid()) {
+        srcB2bEp->SetSessionTxShaping(id, SessionOpts::TXPRIORITY_INTERACTIVE, 0, 0);
+    }
 
-    /* Remove entries from sessionCastSet */
+    /* Remove entries from sessionCastMap */
     if (status == ER_OK) {
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        SessionCastEntry entry(id, srcEp->GetUniqueName(), destB2bEp, destEp);
-        set<SessionCastEntry>::iterator it = sessionCastSet.find(entry);
-        if (it != sessionCastSet.end()) {
-            sessionCastSet.erase(it);
-        }
+        sessionCastLock.Lock(MUTEX_CONTEXT);
+        RemoveSessionCastEntry(SessionCastEntry(id, srcEp->GetUniqueName(), destB2bEp, destEp));
+        RemoveSessionCastEntry(SessionCastEntry(id, destEp->GetUniqueName(), srcB2bEp, srcEp));
+        sessionCastLock.Unlock(MUTEX_CONTEXT);
+    }
+    IncrementAndFetch(&sessionRouteGeneration);
+    return status;
+}
 
-        SessionCastEntry entry2(id, destEp->GetUniqueName(), srcB2bEp, srcEp);
-        set<SessionCastEntry>::iterator it2 = sessionCastSet.find(entry2);
-        if (it2 != sessionCastSet.end()) {
-            sessionCastSet.erase(it2);
+void DaemonRouter::AddSessionCastEntry(const SessionCastEntry& entry)
+{
+    SessionCastRoutes& routes = sessionCastMap[entry.id];
+    SessionCastRoutes::iterator it = lower_bound(routes.begin(), routes.end(), entry);
+    if ((it == routes.end()) || !(*it == entry)) {
+        routes.insert(it, entry);
+    }
+}
+
+void DaemonRouter::RemoveSessionCastEntry(const SessionCastEntry& entry)
+{
+    unordered_map<SessionId, SessionCastRoutes>::iterator mit = sessionCastMap.find(entry.id);
+    if (mit != sessionCastMap.end()) {
+        SessionCastRoutes& routes = mit->second;
+        SessionCastRoutes::iterator it = lower_bound(routes.begin(), routes.end(), entry);
+        if ((it != routes.end()) && (*it == entry)) {
+            routes.erase(it);
+            if (routes.empty()) {
+                sessionCastMap.erase(mit);
+            }
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
     }
-    return status;
 }
 
 void DaemonRouter::RemoveSessionRoutes(const char* src, SessionId id)
@@ -564,20 +1096,34 @@ void DaemonRouter::RemoveSessionRoutes(const char* src, SessionId id)
     String srcStr = src;
     BusEndpoint ep = FindEndpoint(srcStr);
 
-    sessionCastSetLock.Lock(MUTEX_CONTEXT);
-    set<SessionCastEntry>::const_iterator it = sessionCastSet.begin();
-    while (it != sessionCastSet.end()) {
-        if (((it->id == id) || (id == 0)) && ((it->src == src) || (it->destEp == ep))) {
-            if ((it->id != 0) && (it->destEp->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
-                BusEndpoint destEp = it->destEp;
-                VirtualEndpoint::cast(destEp)->RemoveSessionRef(it->id);
+    sessionCastLock.Lock(MUTEX_CONTEXT);
+    /* A specific session is a single hash lookup, id 0 means every session */
+    unordered_map<SessionId, SessionCastRoutes>::iterator mit = (id == 0) ? sessionCastMap.begin() : sessionCastMap.find(id);
+    while (mit != sessionCastMap.end()) {
+        SessionCastRoutes& routes = mit->second;
+        SessionCastRoutes::iterator it = routes.begin();
+        while (it != routes.end()) {
+            if ((it->src == src) || (it->destEp == ep)) {
+                if ((it->id != 0) && (it->destEp->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
+                    BusEndpoint destEp = it->destEp;
+                    VirtualEndpoint::cast(destEp)->RemoveSessionRef(it->id);
+                }
+                it = routes.erase(it);
+            } else {
+                ++it;
             }
-            sessionCastSet.erase(it++);
+        }
+        if (routes.empty()) {
+            sessionCastMap.erase(mit++);
         } else {
-            ++it;
+            ++mit;
+        }
+        if (id != 0) {
+            break;
         }
     }
-    sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+    sessionCastLock.Unlock(MUTEX_CONTEXT);
+    IncrementAndFetch(&sessionRouteGeneration);
 }
 
 }
@@ -24,7 +24,11 @@
 
 #include <qcc/platform.h>
 
+#include <map>
+#include <vector>
+
 #include <qcc/Thread.h>
+#include <qcc/STLContainer.h>
 
 #include "Transport.h"
 
@@ -33,6 +37,7 @@
 #include "LocalTransport.h"
 #include "Router.h"
 #include "NameTable.h"
+#include "RuleDigest.h"
 #include "RuleTable.h"
 
 namespace ajn {
@@ -212,6 +217,36 @@ class DaemonRouter : public Router {
      */
     QStatus RemoveRule(BusEndpoint& endpoint, Rule& rule);
 
+    /**
+     * Add several rules for an endpoint. The rule digests sent to other daemons are only
+     * updated once for the whole batch.
+     *
+     * @param endpoint       The endpoint that the rules apply to.
+     * @param rules          Rules for endpoint.
+     * @param[out] results   The status of each rule, in the order of rules.
+     */
+    void AddRules(BusEndpoint& endpoint, std::vector<Rule>& rules, std::vector<QStatus>& results);
+
+    /**
+     * Remove several rules for an endpoint. The rule digests sent to other daemons are only
+     * updated once for the whole batch.
+     *
+     * @param endpoint       Endpoint that the rules apply to.
+     * @param rules          Rules to remove.
+     * @param[out] results   The status of each rule, in the order of rules.
+     */
+    void RemoveRules(BusEndpoint& endpoint, std::vector<Rule>& rules, std::vector<QStatus>& results);
+
+    /**
+     * Replace all of the rules for an endpoint. No message is routed against a mix of the old
+     * and the new rules.
+     *
+     * @param endpoint    Endpoint whose rules are replaced.
+     * @param rules       The new rules, which may be empty.
+     * @return ER_OK if successful;
+     */
+    QStatus ReplaceRules(BusEndpoint& endpoint, std::vector<Rule>& rules);
+
     /**
      * Remove all rules for a given endpoint.
      *
@@ -220,6 +255,15 @@ class DaemonRouter : public Router {
      */
     QStatus RemoveAllRules(BusEndpoint& endpoint) { return ruleTable.RemoveAllRules(endpoint); }
 
+    /**
+     * Record which global broadcast signals the daemon at the other end of a bus-to-bus endpoint
+     * wants. Until a daemon sends its digest every global broadcast is forwarded to it.
+     *
+     * @param b2bName   Unique name of the bus-to-bus endpoint the digest was received on.
+     * @param digest    The digest received.
+     */
+    void SetRuleDigest(const qcc::String& b2bName, const RuleDigest& digest);
+
     /**
      * Route an incoming Message Bus Message from an endpoint.
      *
@@ -351,16 +395,92 @@ class DaemonRouter : public Router {
      */
     void RemoveSessionRoutes(const char* uniqueName, SessionId id);
 
+    /**
+     * Daemon-wide routing counters. Counters are maintained without locks and may wrap.
+     */
+    struct Stats {
+        uint32_t messagesRouted;   /**< Messages pushed to the router */
+        uint32_t deliveries;       /**< Messages pushed to destination endpoints */
+        uint32_t broadcasts;       /**< Broadcast and session multicast messages routed */
+        uint32_t maxFanOut;        /**< Most endpoints a single broadcast or multicast message was pushed to */
+        uint32_t ruleEvaluations;  /**< Match rules evaluated against broadcast messages */
+        uint32_t noRoute;          /**< Messages discarded or returned because there was no route to the destination */
+        uint32_t pushFailures;     /**< Destination endpoints that failed to accept a message */
+    };
+
+    /**
+     * Get the routing counters.
+     *
+     * @param[out] stats   The counters.
+     */
+    void GetStats(Stats& stats);
+
+    /**
+     * Get the traffic counters of the remote and bus-to-bus endpoints.
+     *
+     * @param[out] epStats   The counters of each connected endpoint paired with its unique name.
+     * @param[out] totals    The counters summed over every endpoint since the router was created
+     *                       including endpoints that have disconnected. txQueueHighWater is the
+     *                       maximum over all endpoints.
+     */
+    void GetEndpointStats(std::vector<std::pair<qcc::String, _RemoteEndpoint::Stats> >& epStats, _RemoteEndpoint::Stats& totals);
+
   private:
+
+    /**
+     * Push a message to a destination endpoint.
+     *
+     * @param msg        The message.
+     * @param ep         The destination endpoint.
+     * @param sessionId  The session the message is sent on.
+     * @param b2bEp      Bus-to-bus endpoint to try first if ep is virtual, the other routes
+     *                   of ep are tried if it fails.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus SendThroughEndpoint(Message& msg, BusEndpoint& ep, SessionId sessionId, RemoteEndpoint* b2bEp = NULL);
+
+    /**
+     * Resolve the destination of a unicast message. Routes are cached per thread and reused
+     * until the name table route generation or sessionRouteGeneration changes. The cached
+     * routes of an endpoint are dropped when it is unregistered.
+     *
+     * @param destination  The destination bus name.
+     * @param sessionId    The session the message is sent on.
+     * @param destEp       [OUT] The destination endpoint, invalid if there is no route.
+     * @param b2bEp        [OUT] The bus-to-bus endpoint for the session if destEp is virtual.
+     */
+    void ResolveUnicast(const char* destination, SessionId sessionId, BusEndpoint& destEp, RemoteEndpoint& b2bEp);
+
+    /**
+     * Send each bus-to-bus endpoint the digest of the rules of the local endpoints combined with
+     * the digests received from the other daemons, if it differs from the digest last sent to it.
+     */
+    void UpdateRuleDigests();
+
+    /** Add the counters of a remote endpoint to the totals, caller must hold statsLock */
+    static void AddEndpointStats(_RemoteEndpoint::Stats& totals, const _RemoteEndpoint::Stats& stats);
+
     LocalEndpoint localEndpoint;    /**< The local endpoint */
     RuleTable ruleTable;            /**< Routing rule table */
     NameTable nameTable;            /**< BusName to transport lookupl table */
     BusController* busController;   /**< The bus controller used with this router */
 
     std::set<RemoteEndpoint> m_b2bEndpoints; /**< Collection of Bus-to-bus endpoints */
-    qcc::Mutex m_b2bEndpointsLock;           /**< Lock that protects m_b2bEndpoints */
+    qcc::Mutex m_b2bEndpointsLock;           /**< Lock that protects m_b2bEndpoints and m_b2bDigests */
+
+    /** Rule digests exchanged over a bus-to-bus endpoint */
+    struct B2BDigests {
+        RuleDigest received;     /**< Signals wanted behind the other daemon, everything until it reports */
+        RuleDigest sent;         /**< Digest last sent to the other daemon */
+        bool sentValid;          /**< False until a digest has been sent */
+
+        B2BDigests() : sentValid(false) { received.SetMatchAll(); }
+    };
+    std::map<RemoteEndpoint, B2BDigests> m_b2bDigests; /**< Digests of each of m_b2bEndpoints */
+    qcc::Mutex m_digestUpdateLock;                     /**< Keeps concurrent digest updates from being sent out of order */
 
-    /** Session multicast destination map */
+    /** Session multicast destination */
     struct SessionCastEntry {
         SessionId id;
         qcc::String src;
@@ -374,9 +494,7 @@ class DaemonRouter : public Router {
             id(id), src(src), b2bEp(b2bEp), destEp(destEp) { }
 
         bool operator<(const SessionCastEntry& other) const {
-            /* The order of comparison of src and id has been reversed, so that upper_bound can be
-             * used with (desiredID -1) to obtain the first entry that has the desired src and id.
-             */
+            /* Entries with the same src are adjacent, and within a src entries with the same b2bEp */
             return (src < other.src) || ((src == other.src) && ((id < other.id) || ((id == other.id) && ((b2bEp < other.b2bEp) || ((b2bEp == other.b2bEp) && (destEp < other.destEp))))));
 
         }
@@ -386,8 +504,32 @@ class DaemonRouter : public Router {
         }
     };
 
-    std::set<SessionCastEntry> sessionCastSet; /**< Session multicast set */
-    qcc::Mutex sessionCastSetLock;             /**< Lock that protects sessionCastSet */
+    /** Orders SessionCastEntries by src alone, used to find the first entry of a sender */
+    struct SessionCastSrcLess {
+        bool operator()(const SessionCastEntry& entry, const qcc::String& src) const { return entry.src < src; }
+    };
+
+    /** The destinations of one session, sorted so that one sender's entries can be found by binary search */
+    typedef std::vector<SessionCastEntry> SessionCastRoutes;
+
+    /** Add an entry to sessionCastMap unless it is already there, caller must hold sessionCastLock */
+    void AddSessionCastEntry(const SessionCastEntry& entry);
+
+    /** Remove an entry from sessionCastMap, caller must hold sessionCastLock */
+    void RemoveSessionCastEntry(const SessionCastEntry& entry);
+
+    std::unordered_map<SessionId, SessionCastRoutes> sessionCastMap; /**< Session multicast destinations hashed by session id */
+    qcc::Mutex sessionCastLock;                /**< Lock that protects sessionCastMap */
+
+    volatile int32_t messagesRouted;           /**< Messages pushed to the router (atomically incremented) */
+    volatile int32_t deliveries;               /**< Messages pushed to destination endpoints (atomically incremented) */
+    volatile int32_t broadcasts;               /**< Broadcast and multicast messages routed (atomically incremented) */
+    volatile int32_t noRoute;                  /**< Messages with no route (atomically incremented) */
+    volatile int32_t pushFailures;             /**< Failed pushes to destination endpoints (atomically incremented) */
+    uint32_t maxFanOut;                        /**< Largest fan-out seen, updates may race so this is approximate */
+    volatile int32_t sessionRouteGeneration;   /**< Bumped after every session route or bus-to-bus endpoint change */
+    _RemoteEndpoint::Stats retiredStats;       /**< Summed counters of the endpoints that have been unregistered */
+    qcc::Mutex statsLock;                      /**< Lock that protects retiredStats */
 };
 
 }
@@ -155,7 +155,7 @@ class DaemonTransport : public Transport, public _RemoteEndpoint::EndpointListen
      */
     void EndpointExit(RemoteEndpoint& endpoint);
 
-  private:
+  protected:
     BusAttachment& bus;                       /**< The message bus for this transport */
     bool stopping;                            /**< True if Stop() has been called but endpoints still exist */
     std::list<RemoteEndpoint> endpointList;   /**< List of active endpoints */
@@ -30,6 +30,7 @@
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 
+#include "MemoryAccounting.h"
 #include "NameTable.h"
 #include "VirtualEndpoint.h"
 #include "EndpointHelper.h"
@@ -64,6 +65,7 @@ void NameTable::AddUniqueName(BusEndpoint& endpoint)
     QCC_DbgPrintf(("Add unique name %s", uniqueName.c_str()));
     lock.Lock(MUTEX_CONTEXT);
     uniqueNames[uniqueName] = endpoint;
+    UpdateRoute(uniqueName);
     lock.Unlock(MUTEX_CONTEXT);
 
     /* Notify listeners */
@@ -123,6 +125,7 @@ void NameTable::RemoveUniqueName(const qcc::String& uniqueName)
 
         if (it != uniqueNames.end()) {
             uniqueNames.erase(it);
+            UpdateRoute(uniqueName);
             QCC_DbgPrintf(("Removed ep=%s from name table", uniqueName.c_str()));
         }
 
@@ -187,6 +190,9 @@ QStatus NameTable::AddAlias(const qcc::String& aliasName,
                 origOwner = &vit->second->GetUniqueName();
             }
         }
+        if (newOwner) {
+            UpdateRoute(aliasName);
+        }
         lock.Unlock(MUTEX_CONTEXT);
 
         if (listener) {
@@ -227,7 +233,7 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
             /* Remove primary */
             if (queue.size() > 1) {
                 queue.pop_front();
-                BusEndpoint ep = FindEndpoint(queue[0].endpointName);
+                BusEndpoint ep = FindEndpointLocked(queue[0].endpointName);
                 if (ep->IsValid()) {
                     newOwner = queue[0].endpointName;
                 }
@@ -242,6 +248,7 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
             }
             oldOwner = ownerName;
             disposition = DBUS_RELEASE_NAME_REPLY_RELEASED;
+            UpdateRoute(aliasNameCopy);
         } else {
             /* Alias is not owned by ownerName */
             disposition = DBUS_RELEASE_NAME_REPLY_NOT_OWNER;
@@ -261,10 +268,23 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
 }
 
 BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
+{
+    HashedName key(busName);
+    size_t shard = key.hash % NUM_ROUTE_SHARDS;
+
+    /* Only take a reference to the current snapshot while holding the route lock */
+    routeLocks[shard].Lock(MUTEX_CONTEXT);
+    RouteSnapshot snapshot = routes[shard];
+    routeLocks[shard].Unlock(MUTEX_CONTEXT);
+
+    RouteMap::const_iterator it = snapshot->find(key);
+    return (it != snapshot->end()) ? it->second : BusEndpoint();
+}
+
+BusEndpoint NameTable::FindEndpointLocked(const qcc::String& busName) const
 {
     BusEndpoint ep;
 
-    lock.Lock(MUTEX_CONTEXT);
     if (busName[0] == ':') {
         unordered_map<qcc::String, BusEndpoint, Hash, Equal>::const_iterator it = uniqueNames.find(busName);
         if (it != uniqueNames.end()) {
@@ -274,7 +294,7 @@ BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
         unordered_map<qcc::String, deque<NameQueueEntry>, Hash, Equal>::const_iterator it = aliasNames.find(busName);
         if (it != aliasNames.end()) {
             assert(!it->second.empty());
-            ep = FindEndpoint(it->second[0].endpointName);
+            ep = FindEndpointLocked(it->second[0].endpointName);
         }
         /* Fallback to virtual (remote) aliases if a suitable local one cannot be found */
         if (!ep->IsValid()) {
@@ -285,10 +305,41 @@ BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
             }
         }
     }
-    lock.Unlock(MUTEX_CONTEXT);
     return ep;
 }
 
+void NameTable::UpdateRoute(const qcc::String& busName)
+{
+    HashedName key(busName);
+    size_t shard = key.hash % NUM_ROUTE_SHARDS;
+    BusEndpoint ep = FindEndpointLocked(busName);
+
+    /*
+     * Copy on write. Readers that already hold the old snapshot keep using it. The routes are only
+     * replaced with lock held so it is safe to read routes[shard] here without its route lock.
+     */
+    RouteSnapshot updated(*routes[shard]);
+    size_t before = updated->size();
+    if (ep->IsValid()) {
+        (*updated)[key] = ep;
+    } else {
+        updated->erase(key);
+    }
+    if (MemoryAccounting::IsEnabled() && (updated->size() != before)) {
+        /* Every routed name is held once in the name tables and once in the routes */
+        size_t bytes = 2 * (sizeof(qcc::String) + busName.size() + 1 + sizeof(BusEndpoint)) + sizeof(size_t);
+        if (updated->size() > before) {
+            MemoryAccounting::Allocated(MemoryAccounting::MEM_NAME_TABLE, bytes);
+        } else {
+            MemoryAccounting::Released(MemoryAccounting::MEM_NAME_TABLE, bytes);
+        }
+    }
+    routeLocks[shard].Lock(MUTEX_CONTEXT);
+    routes[shard] = updated;
+    routeLocks[shard].Unlock(MUTEX_CONTEXT);
+    IncrementAndFetch(&routeGeneration);
+}
+
 void NameTable::GetBusNames(vector<qcc::String>& names) const
 {
     lock.Lock(MUTEX_CONTEXT);
@@ -320,7 +371,7 @@ void NameTable::GetUniqueNamesAndAliases(vector<pair<qcc::String, vector<qcc::St
     unordered_map<qcc::String, deque<NameQueueEntry>, Hash, Equal>::const_iterator ait = aliasNames.begin();
     while (ait != aliasNames.end()) {
         if (!ait->second.empty()) {
-            BusEndpoint ep = FindEndpoint(ait->second.front().endpointName);
+            BusEndpoint ep = FindEndpointLocked(ait->second.front().endpointName);
             if (ep->IsValid()) {
                 epMap.insert(pair<BusEndpoint, qcc::String>(ep, ait->first));
             }
@@ -380,7 +431,7 @@ void NameTable::GetQueuedNames(const qcc::String& busName, std::vector<qcc::Stri
 void NameTable::RemoveVirtualAliases(const qcc::String& epName)
 {
     lock.Lock(MUTEX_CONTEXT);
-    BusEndpoint tempEp = FindEndpoint(epName);
+    BusEndpoint tempEp = FindEndpointLocked(epName);
     VirtualEndpoint ep = VirtualEndpoint::cast(tempEp);
 
     QCC_DbgTrace(("NameTable::RemoveVirtualAliases(%s)", ep->IsValid() ? ep->GetUniqueName().c_str() : "<none>"));
@@ -391,6 +442,7 @@ void NameTable::RemoveVirtualAliases(const qcc::String& epName)
             if (vit->second == ep) {
                 String alias = vit->first.c_str();
                 virtualAliasNames.erase(vit++);
+                UpdateRoute(alias);
                 if (aliasNames.find(alias) == aliasNames.end()) {
                     lock.Unlock(MUTEX_CONTEXT);
                     CallListeners(alias, &epName, NULL);
@@ -448,6 +500,8 @@ bool NameTable::SetVirtualAlias(const qcc::String& alias,
         virtualAliasNames.erase(StringMapKey(alias));
     }
 
+    UpdateRoute(alias);
+
     String oldName = oldOwner->IsValid() ? oldOwner->GetUniqueName() : "";
     String newName = newOwner ? (*newOwner)->GetUniqueName() : "";
 
@@ -30,6 +30,7 @@
 
 #include <qcc/Mutex.h>
 #include <qcc/Environ.h>
+#include <qcc/ManagedObj.h>
 #include <qcc/String.h>
 #include <qcc/StringMapKey.h>
 
@@ -67,7 +68,7 @@ class NameTable {
     /**
      * Constructor
      */
-    NameTable() : uniqueId(0), uniquePrefix(":1.") { }
+    NameTable() : uniqueId(0), uniquePrefix(":1."), routeGeneration(0) { }
 
     /**
      * Set the GUID of the bus.
@@ -172,12 +173,22 @@ class NameTable {
 
     /**
      * Find an endpoint for a given unique or alias bus name.
+     * This does not take the name table lock. Lookups are served from a read-only snapshot that is
+     * replaced whenever the owner of a name changes so routing is not held up by name table updates.
      *
      * @param busName   Name of bus.
      * @return  Returns the endpoint if it was found or an invalid endpoint if not found
      */
     BusEndpoint FindEndpoint(const qcc::String& busName) const;
 
+    /**
+     * Get the route generation. It changes after every change to the endpoint a name resolves
+     * to, so a route cached together with the generation is current while the generation is.
+     *
+     * @return  The current route generation.
+     */
+    uint32_t GetRouteGeneration() const { return static_cast<uint32_t>(routeGeneration); }
+
     /**
      * Get all bus names from name table.
      *
@@ -202,6 +213,7 @@ class NameTable {
 
     /**
      * Lock table.
+     * Holding the lock keeps the table from changing. It is not needed for FindEndpoint().
      */
     void Lock() { lock.Lock(MUTEX_CONTEXT); }
 
@@ -231,16 +243,65 @@ class NameTable {
         }
     };
 
+    /**
+     * Bus name with a precomputed hash
+     */
+    struct HashedName {
+        qcc::String name;
+        size_t hash;
+        HashedName(const qcc::String& name) : name(name), hash(qcc::hash_string(name.c_str())) { }
+    };
+
+    struct HashedNameHash {
+        inline size_t operator()(const HashedName& n) const {
+            return n.hash;
+        }
+    };
+
+    struct HashedNameEqual {
+        inline bool operator()(const HashedName& n1, const HashedName& n2) const {
+            return (n1.hash == n2.hash) && (n1.name == n2.name);
+        }
+    };
+
+    /** Resolved mapping from every unique, alias and virtual alias name to its endpoint */
+    typedef std::unordered_map<HashedName, BusEndpoint, HashedNameHash, HashedNameEqual> RouteMap;
+
+    /** Reference counted snapshot of a RouteMap. A snapshot is never modified once published. */
+    typedef qcc::ManagedObj<RouteMap> RouteSnapshot;
+
+    /** Number of route snapshots. An update only copies the snapshot the name hashes to. */
+    static const size_t NUM_ROUTE_SHARDS = 16;
+
     mutable qcc::Mutex lock;                                             /**< Lock protecting name tables */
+    mutable qcc::Mutex routeLocks[NUM_ROUTE_SHARDS];                     /**< Locks protecting the routes pointers (not their contents) */
+    RouteSnapshot routes[NUM_ROUTE_SHARDS];                              /**< Route snapshots used by FindEndpoint */
     std::unordered_map<qcc::String, BusEndpoint, Hash, Equal> uniqueNames;   /**< Unique name table */
     std::unordered_map<qcc::String, std::deque<NameQueueEntry>, Hash, Equal> aliasNames;  /**< Alias name table */
     uint32_t uniqueId;
     qcc::String uniquePrefix;
+    volatile int32_t routeGeneration;                                  /**< Bumped after every route snapshot update */
 
     typedef qcc::ManagedObj<NameListener*> ProtectedNameListener;
     std::set<ProtectedNameListener> listeners;                         /**< Listeners regsitered with name table */
     std::map<qcc::StringMapKey, VirtualEndpoint> virtualAliasNames;    /**< map of virtual aliases to virtual endpts */
 
+    /**
+     * Find an endpoint from the name tables. Must be called with lock held.
+     *
+     * @param busName   Name of bus.
+     * @return  Returns the endpoint if it was found or an invalid endpoint if not found
+     */
+    BusEndpoint FindEndpointLocked(const qcc::String& busName) const;
+
+    /**
+     * Publish a new route snapshot for a name whose owner may have changed.
+     * Must be called with lock held.
+     *
+     * @param busName   Unique or well-known bus name.
+     */
+    void UpdateRoute(const qcc::String& busName);
+
     /**
      * Helper used to call the listners
      *
@@ -28,6 +28,7 @@
 #include <qcc/Util.h>
 #include <qcc/time.h>
 
+#include "MemoryAccounting.h"
 #include "Packet.h"
 #include "PacketStream.h"
 
@@ -63,6 +64,74 @@ namespace ajn {
 
 const size_t Packet::payloadOffset = PAYLOAD_OFFSET;
 
+/*
+ * Slicing-by-8 implementation of the packet CRC. The tables are derived from CRC16_Compute()
+ * so the result is bit for bit what peers using CRC16_Compute() expect. If CRC16_Compute()
+ * turns out not to be a reflected table driven CRC the self test fails and CRC16_Compute()
+ * is used instead.
+ */
+class PacketCrc {
+  public:
+    PacketCrc() : useTables(false)
+    {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint8_t byte = static_cast<uint8_t>(b);
+            uint16_t crc = 0;
+            CRC16_Compute(&byte, 1, &crc);
+            tables[0][b] = crc;
+        }
+        for (size_t k = 1; k < 8; ++k) {
+            for (uint32_t b = 0; b < 256; ++b) {
+                tables[k][b] = (tables[k - 1][b] >> 8) ^ tables[0][tables[k - 1][b] & 0xFF];
+            }
+        }
+        /* Compare against CRC16_Compute() over every length and alignment up to 64 bytes */
+        uint8_t test[72];
+        for (size_t i = 0; i < sizeof(test); ++i) {
+            test[i] = static_cast<uint8_t>((i * 167) + 13);
+        }
+        useTables = true;
+        for (size_t len = 0; useTables && (len <= 64); ++len) {
+            for (size_t off = 0; off < 8; ++off) {
+                uint16_t expected = 0x1D0F;
+                uint16_t actual = 0x1D0F;
+                CRC16_Compute(test + off, len, &expected);
+                Compute(test + off, len, &actual);
+                if (expected != actual) {
+                    useTables = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    void Compute(const uint8_t* buf, size_t len, uint16_t* runningCrc) const
+    {
+        if (!useTables) {
+            CRC16_Compute(buf, len, runningCrc);
+            return;
+        }
+        uint16_t crc = *runningCrc;
+        while (len >= 8) {
+            crc = tables[7][buf[0] ^ (crc & 0xFF)] ^ tables[6][buf[1] ^ (crc >> 8)] ^
+                  tables[5][buf[2]] ^ tables[4][buf[3]] ^ tables[3][buf[4]] ^
+                  tables[2][buf[5]] ^ tables[1][buf[6]] ^ tables[0][buf[7]];
+            buf += 8;
+            len -= 8;
+        }
+        while (len--) {
+            crc = (crc >> 8) ^ tables[0][(crc ^ *buf++) & 0xFF];
+        }
+        *runningCrc = crc;
+    }
+
+  private:
+    uint16_t tables[8][256];
+    bool useTables;
+};
+
+static const PacketCrc packetCrc;
+
 Packet::Packet(size_t _mtu) :
     chanId(0),
     seqNum(0),
@@ -79,6 +148,7 @@ Packet::Packet(size_t _mtu) :
     crc16(0),
     version(0)
 {
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_PACKETS, sizeof(Packet) + mtu);
 }
 
 Packet::Packet(const Packet& other) :
@@ -97,6 +167,7 @@ Packet::Packet(const Packet& other) :
     crc16(other.crc16),
     version(other.version)
 {
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_PACKETS, sizeof(Packet) + mtu);
 }
 
 Packet& Packet::operator=(const Packet& other)
@@ -109,6 +180,8 @@ Packet& Packet::operator=(const Packet& other)
         payloadLen = other.payloadLen;
         payload = other.payload;
         if (mtu != other.mtu) {
+            MemoryAccounting::Released(MemoryAccounting::MEM_PACKETS, sizeof(Packet) + mtu);
+            MemoryAccounting::Allocated(MemoryAccounting::MEM_PACKETS, sizeof(Packet) + other.mtu);
             delete buffer;
             buffer = new uint32_t[(other.mtu + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
         }
@@ -125,6 +198,7 @@ Packet& Packet::operator=(const Packet& other)
 
 Packet::~Packet()
 {
+    MemoryAccounting::Released(MemoryAccounting::MEM_PACKETS, sizeof(Packet) + mtu);
     delete[] buffer;
 }
 
@@ -148,6 +222,16 @@ QStatus Packet::Unmarshal(PacketSource& source)
     /* Get bytes from source */
     size_t actBytes;
     QStatus status = source.PullPacketBytes(buffer, mtu, actBytes, sender, 3000);
+    if (status != ER_OK) {
+        actBytes = 0;
+    }
+    QStatus parseStatus = Unmarshal(source, actBytes);
+    return (status == ER_OK) ? parseStatus : status;
+}
+
+QStatus Packet::Unmarshal(PacketSource& source, size_t actBytes)
+{
+    QStatus status = ER_OK;
     uint8_t* tBuf = reinterpret_cast<uint8_t*>(buffer);
 
     if (actBytes < PAYLOAD_OFFSET) {
@@ -155,12 +239,14 @@ QStatus Packet::Unmarshal(PacketSource& source)
     }
 
     if (status == ER_OK) {
-        /* Crc check */
-        uint16_t crc = 0;
-        uint16_t packetCrc = letoh16(*reinterpret_cast<uint16_t*>(tBuf + CRC_OFFSET));
-        CRC16_Compute(tBuf, CRC_OFFSET, &crc);
-        CRC16_Compute(tBuf + PAYLOAD_OFFSET, actBytes - PAYLOAD_OFFSET, &crc);
-        status = (crc == packetCrc) ? ER_OK : ER_PACKET_BAD_CRC;
+        /* Crc check (skipped if the sender omitted the crc and the source guarantees integrity) */
+        if (!(tBuf[FLAGS_OFFSET] & PACKET_FLAG_NO_CRC) || !source.HasIntegrity()) {
+            uint16_t crc = 0;
+            uint16_t rxCrc = letoh16(*reinterpret_cast<uint16_t*>(tBuf + CRC_OFFSET));
+            packetCrc.Compute(tBuf, CRC_OFFSET, &crc);
+            packetCrc.Compute(tBuf + PAYLOAD_OFFSET, actBytes - PAYLOAD_OFFSET, &crc);
+            status = (crc == rxCrc) ? ER_OK : ER_PACKET_BAD_CRC;
+        }
     }
 
     if (status == ER_OK) {
@@ -213,9 +299,11 @@ void Packet::Marshal()
         ::memmove(tBuf + PAYLOAD_OFFSET, payload, payloadLen);
     }
     uint16_t crc = 0;
-    CRC16_Compute(tBuf, CRC_OFFSET, &crc);
-    if (payloadLen) {
-        CRC16_Compute(tBuf + PAYLOAD_OFFSET, payloadLen, &crc);
+    if (!(flags & PACKET_FLAG_NO_CRC)) {
+        packetCrc.Compute(tBuf, CRC_OFFSET, &crc);
+        if (payloadLen) {
+            packetCrc.Compute(tBuf + PAYLOAD_OFFSET, payloadLen, &crc);
+        }
     }
     *reinterpret_cast<uint16_t*>(tBuf + CRC_OFFSET) = htole16(crc);
 }
@@ -34,6 +34,13 @@ namespace ajn {
 #define PACKET_FLAG_EOM        0x04     /* Packet is the end of a potentially multi-packet message (data only) */
 #define PACKET_FLAG_DELAY_ACK  0x08     /* Data packet may be acked by the receiver in a delayed manner */
 #define PACKET_FLAG_FLOW_OFF   0x10     /* Transmitter is XOFF (and will be expecting XON) */
+#define PACKET_FLAG_NO_CRC     0x20     /* Packet has no CRC (only sent on channels that negotiated PACKET_OPTION_NO_CRC) */
+#define PACKET_FLAG_EXPIRED    0x40     /* Payload was dropped because its message expired (only sent on channels that negotiated PACKET_OPTION_PARTIAL_RELIABILITY) */
+
+/* Channel options negotiated by CONNECT_REQ and CONNECT_RSP (optional trailing payload word) */
+#define PACKET_OPTION_NO_CRC   0x01     /* Data packets may omit the CRC because the PacketStream guarantees integrity */
+#define PACKET_OPTION_PARTIAL_RELIABILITY 0x02 /* Sent packets of expired messages are retransmitted without payload */
+#define PACKET_OPTION_RX_CREDIT 0x04    /* Acks end with the receive window edge and the receiver answers flow off with acks instead of XON */
 
 /* Control packet command types (payload offset = 0, size = BYTE) */
 #define PACKET_COMMAND_CONNECT_REQ         0x01
@@ -105,6 +112,16 @@ class Packet {
      */
     QStatus Unmarshal(PacketSource& source);
 
+    /**
+     * Unmarshal a packet that has already been pulled into the buffer member.
+     * Used when several packets are pulled from a source at once.
+     *
+     * @param source       Source the packet was pulled from.
+     * @param actualBytes  Number of bytes pulled into the buffer.
+     * @return ER_OK if successful.
+     */
+    QStatus Unmarshal(PacketSource& source, size_t actualBytes);
+
     /**
      * Marshal packet state into serialized form.
      * After calling this method, the packet's object state will be serialized into the buffer member.
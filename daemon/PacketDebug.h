@@ -0,0 +1,124 @@
+/**
+ * @file
+ * Debug interface (org.alljoyn.Bus.Debug.PacketPool) for getting PacketPool statistics.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_PACKETDEBUGOBJ_H
+#define _ALLJOYN_PACKETDEBUGOBJ_H
+
+// Include contents in debug builds only.
+#ifndef NDEBUG
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include "AllJoynDebugObj.h"
+#include "PacketPool.h"
+
+
+namespace ajn {
+
+namespace debug {
+
+/**
+ * Debug addon that publishes the counters of a PacketPool as read-only properties.
+ *
+ * @cond ALLJOYN_DEV
+ *
+ * This is implemented entirely in the header file so it is easily excluded from release
+ * builds by conditionally including it.
+ *
+ * @endcond
+ */
+class PacketDebugObj : public AllJoynDebugObjAddon {
+  public:
+    class PacketDebugProperties : public AllJoynDebugObj::Properties {
+      public:
+        PacketDebugProperties(PacketPool& pool) : pool(pool) { }
+
+        QStatus Get(const char* propName, MsgArg& val) const
+        {
+            PacketPool::Stats stats;
+            pool.GetStats(stats);
+            uint32_t v;
+            if (::strcmp(propName, "UsedCount") == 0) {
+                v = stats.usedCount;
+            } else if (::strcmp(propName, "FreeCount") == 0) {
+                v = stats.freeCount;
+            } else if (::strcmp(propName, "Hits") == 0) {
+                v = stats.hits;
+            } else if (::strcmp(propName, "Misses") == 0) {
+                v = stats.misses;
+            } else if (::strcmp(propName, "Allocs") == 0) {
+                v = stats.allocs;
+            } else if (::strcmp(propName, "Trims") == 0) {
+                v = stats.trims;
+            } else {
+                return ER_BUS_NO_SUCH_PROPERTY;
+            }
+            return val.Set("u", v);
+        }
+
+        QStatus Set(const char* propName, MsgArg& val)
+        {
+            MsgArg unused;
+            if (Get(propName, unused) == ER_OK) {
+                return ER_BUS_PROPERTY_ACCESS_DENIED;
+            }
+            return ER_BUS_NO_SUCH_PROPERTY;
+        }
+
+        void GetProperyInfo(const AllJoynDebugObj::Properties::Info*& info, size_t& infoSize)
+        {
+            static const AllJoynDebugObj::Properties::Info ourInfo[] = {
+                { "UsedCount", "u", PROP_ACCESS_READ },
+                { "FreeCount", "u", PROP_ACCESS_READ },
+                { "Hits",      "u", PROP_ACCESS_READ },
+                { "Misses",    "u", PROP_ACCESS_READ },
+                { "Allocs",    "u", PROP_ACCESS_READ },
+                { "Trims",     "u", PROP_ACCESS_READ },
+            };
+            info = ourInfo;
+            infoSize = ArraySize(ourInfo);
+        }
+
+      private:
+        PacketPool& pool;
+    };
+
+    PacketDebugObj(PacketPool& pool) : properties(pool)
+    {
+        AllJoynDebugObj* dbg = AllJoynDebugObj::GetAllJoynDebugObj();
+        dbg->AddDebugInterface(this,
+                               "org.alljoyn.Bus.Debug.PacketPool",
+                               NULL, 0,
+                               properties);
+    }
+
+  private:
+    PacketDebugProperties properties;
+};
+
+
+
+} // namespace debug
+} // namespace ajn
+
+#endif
+#endif
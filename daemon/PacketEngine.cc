@@ -25,8 +25,10 @@
 #include <limits>
 
 #include <qcc/Crypto.h>
+#include <qcc/StringUtil.h>
 #include <qcc/Util.h>
 #include "PacketEngine.h"
+#include "ThreadScheduling.h"
 
 #if defined(QCC_OS_DARWIN)
 
@@ -71,7 +73,7 @@ struct ConnectReqAlarmContext : public AlarmContext {
     void* context;
     PacketDest dest;
     uint32_t retries;
-    uint32_t connReq[3];
+    uint32_t connReq[4];
     ConnectReqAlarmContext(uint32_t chanId, const PacketDest& dest, void* context) :
         AlarmContext(AlarmContext::CONTEXT_CONNECT_REQ, chanId), context(context), dest(dest), retries(0) { }
 };
@@ -79,7 +81,7 @@ struct ConnectReqAlarmContext : public AlarmContext {
 struct ConnectRspAlarmContext : public AlarmContext {
     PacketDest dest;
     uint32_t retries;
-    uint32_t connRsp[4];
+    uint32_t connRsp[5];
     ConnectRspAlarmContext(uint32_t chanId, const PacketDest& dest) :
         AlarmContext(AlarmContext::CONTEXT_CONNECT_RSP, chanId), dest(dest), retries(0) { }
 };
@@ -113,36 +115,44 @@ struct ClosingAlarmContext : public AlarmContext {
 
 static uint32_t GetValidWindowSize(uint32_t inWinSize)
 {
-    uint32_t allowedSize = 0x400;  /* max allowed window size is 1k packets */
+    uint32_t allowedSize = MAX_WINDOW_SIZE;
     while (allowedSize > inWinSize) {
         allowedSize = allowedSize >> 1;
     }
     return allowedSize;
 }
 
-PacketEngine::PacketEngine(const qcc::String& name, uint32_t maxWindowSize) :
+/* Channel options this engine can use on packetStream */
+static uint32_t GetLocalOptions(const PacketStream& packetStream)
+{
+    return (packetStream.HasIntegrity() ? PACKET_OPTION_NO_CRC : 0) | PACKET_OPTION_PARTIAL_RELIABILITY | PACKET_OPTION_RX_CREDIT;
+}
+
+PacketEngine::PacketEngine(const qcc::String& name, uint32_t maxWindowSize, uint32_t numShards) :
     name(name),
     rxPacketThread(name),
-    txPacketThread(name),
     timer("PacketEngineTimer"),
-    maxWindowSize(maxWindowSize),
+    maxWindowSize(GetValidWindowSize(maxWindowSize)),
+    defaultCongestionControl(CONGESTION_CONTROL_RENO),
     isRunning(false),
     rxPacketThreadReload(false)
 {
-    QCC_DbgTrace(("PacketEngine::PacketEngine(%p)", this));
-
-    /* Check that window size is a power of 2 */
-#ifndef NDEBUG
-    int setBits = 0;
-    uint32_t t = maxWindowSize;
-    while (t) {
-        if (t & 0x01) {
-            ++setBits;
+    QCC_DbgTrace(("PacketEngine::PacketEngine(%p, numShards=%u)", this, numShards));
+
+    /* With a single shard received packets are handled directly by the rx thread */
+    numShards = ::max(numShards, (uint32_t)1);
+    for (uint32_t i = 0; i < numShards; ++i) {
+        channelShards.push_back(new ChannelShard());
+        txPacketThreads.push_back(new TxPacketThread(name, i));
+        if (numShards > 1) {
+            rxWorkers.push_back(new RxPacketThread(name, i));
         }
-        t = t >> 1;
     }
-    assert(setBits == 1);
-#endif
+
+    /* Window size must be a power of 2 no larger than MAX_WINDOW_SIZE */
+    if (this->maxWindowSize != maxWindowSize) {
+        QCC_LogError(ER_PACKET_BAD_PARAMETER, ("Invalid window size %u, using %u", maxWindowSize, this->maxWindowSize));
+    }
 }
 
 PacketEngine::~PacketEngine()
@@ -151,16 +161,44 @@ PacketEngine::~PacketEngine()
     rxPacketThreadReload = true;
     Stop();
     Join();
+
+    /* Fail messages still queued on open channels while no engine lock is held */
+    for (size_t i = 0; i < channelShards.size(); ++i) {
+        map<uint32_t, ChannelInfo>& channelInfos = channelShards[i]->channelInfos;
+        for (map<uint32_t, ChannelInfo>::iterator it = channelInfos.begin(); it != channelInfos.end(); ++it) {
+            std::vector<ChannelInfo::TxPendingMessage> completed;
+            FailPendingMessages(it->second, completed);
+            CompletePendingMessages(it->second, completed);
+        }
+    }
+
+    /* Channels must be destroyed before the threads and the pool they reference */
+    for (size_t i = 0; i < channelShards.size(); ++i) {
+        delete channelShards[i];
+    }
+    for (size_t i = 0; i < rxWorkers.size(); ++i) {
+        delete rxWorkers[i];
+    }
+    for (size_t i = 0; i < txPacketThreads.size(); ++i) {
+        delete txPacketThreads[i];
+    }
 }
 
 QStatus PacketEngine::Start(uint32_t mtu) {
     QCC_DbgTrace(("PacketEngine::Start()"));
     isRunning = true;
     QStatus status = pool.Start(mtu);
-    QStatus tStatus = rxPacketThread.Start(this);
-    status = (status == ER_OK) ? tStatus : status;
-    tStatus = txPacketThread.Start(this);
+    QStatus tStatus;
+    for (size_t i = 0; i < rxWorkers.size(); ++i) {
+        tStatus = rxWorkers[i]->Start(this);
+        status = (status == ER_OK) ? tStatus : status;
+    }
+    tStatus = rxPacketThread.Start(this);
     status = (status == ER_OK) ? tStatus : status;
+    for (size_t i = 0; i < txPacketThreads.size(); ++i) {
+        tStatus = txPacketThreads[i]->Start(this);
+        status = (status == ER_OK) ? tStatus : status;
+    }
     tStatus = timer.Start();
     status = (status == ER_OK) ? tStatus : status;
     isRunning = (status == ER_OK);
@@ -170,10 +208,17 @@ QStatus PacketEngine::Start(uint32_t mtu) {
 QStatus PacketEngine::Stop() {
     QCC_DbgTrace(("PacketEngine::Stop()"));
     QStatus status = timer.Stop();
-    QStatus tStatus = txPacketThread.Stop();
-    status = (status == ER_OK) ? tStatus : status;
+    QStatus tStatus;
+    for (size_t i = 0; i < txPacketThreads.size(); ++i) {
+        tStatus = txPacketThreads[i]->Stop();
+        status = (status == ER_OK) ? tStatus : status;
+    }
     tStatus = rxPacketThread.Stop();
     status = (status == ER_OK) ? tStatus : status;
+    for (size_t i = 0; i < rxWorkers.size(); ++i) {
+        tStatus = rxWorkers[i]->Stop();
+        status = (status == ER_OK) ? tStatus : status;
+    }
     tStatus = pool.Stop();
     isRunning = false;
     return (status == ER_OK) ? tStatus : status;
@@ -183,8 +228,15 @@ QStatus PacketEngine::Join() {
     QCC_DbgTrace(("PacketEngine::Join()"));
 
     QStatus status = rxPacketThread.Join();
-    QStatus tStatus = txPacketThread.Join();
-    status = (status == ER_OK) ? tStatus : status;
+    QStatus tStatus;
+    for (size_t i = 0; i < rxWorkers.size(); ++i) {
+        tStatus = rxWorkers[i]->Join();
+        status = (status == ER_OK) ? tStatus : status;
+    }
+    for (size_t i = 0; i < txPacketThreads.size(); ++i) {
+        tStatus = txPacketThreads[i]->Join();
+        status = (status == ER_OK) ? tStatus : status;
+    }
     tStatus = timer.Join();
     return (status == ER_OK) ? tStatus : status;
 }
@@ -241,7 +293,8 @@ QStatus PacketEngine::RemovePacketStream(PacketStream& pktStream)
     return status;
 }
 
-QStatus PacketEngine::Connect(const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener, void* context)
+QStatus PacketEngine::Connect(const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener, void* context,
+                              CongestionControlType congestionControl)
 {
     QCC_DbgTrace(("PacketEngine::Connect(%s)", ToString(packetStream, dest).c_str()));
 
@@ -257,9 +310,10 @@ QStatus PacketEngine::Connect(const PacketDest& dest, PacketStream& packetStream
     cctx->connReq[0] = htole32(PACKET_COMMAND_CONNECT_REQ);
     cctx->connReq[1] = htole32(PACKET_ENGINE_VERSION);
     cctx->connReq[2] = htole32(maxWindowSize);
+    cctx->connReq[3] = htole32(GetLocalOptions(packetStream));
 
     /* Create a channel info */
-    ChannelInfo* ci = CreateChannelInfo(chanId, dest, packetStream, listener, maxWindowSize);
+    ChannelInfo* ci = CreateChannelInfo(chanId, dest, packetStream, listener, maxWindowSize, congestionControl);
     if (ci) {
         /* Put an entry on the callback timer */
         uint32_t zero = 0;
@@ -291,6 +345,7 @@ void PacketEngine::CloseChannel(ChannelInfo& ci)
     QCC_DbgTrace(("PacketEngine::CloseChannel(id=0x%x)", ci.id));
 
     /* Return early if disconnect already in progress */
+    std::vector<ChannelInfo::TxPendingMessage> completed;
     ci.txLock.Lock();
     DisconnectReqAlarmContext* ctx = static_cast<DisconnectReqAlarmContext*>(ci.disconnectReqAlarm->GetContext());
     if (ctx) {
@@ -317,6 +372,85 @@ void PacketEngine::CloseChannel(ChannelInfo& ci)
         QCC_LogError(status, ("PacketEngine::CloseChannel failed. Deleting chan=0x%x", ci.id));
         ci.state = ChannelInfo::CLOSED;
     }
+
+    /* Queued messages can no longer be sent. Fail them now rather than when the channel is destroyed */
+    FillTxWindow(ci, completed);
+    ci.txLock.Unlock();
+    CompletePendingMessages(ci, completed);
+}
+
+void PacketEngine::FillTxWindow(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed)
+{
+    if (ci.txPendingQueue.empty()) {
+        return;
+    }
+
+    bool closed = (ci.state == ChannelInfo::CLOSING) || (ci.state == ChannelInfo::CLOSED) || (ci.state == ChannelInfo::ABORTED);
+    uint64_t now = GetTimestamp64();
+    while (!ci.txPendingQueue.empty()) {
+        ChannelInfo::TxPendingMessage& msg = ci.txPendingQueue.front();
+        if (closed || (!msg.packets.empty() && (msg.packets[0]->expireTs < now))) {
+            /* Treat a ttl expiration as a successfully sent message (same as PushBytes) */
+            msg.status = closed ? ER_SOCK_OTHER_END_CLOSED : ER_OK;
+            for (size_t i = 0; i < msg.packets.size(); ++i) {
+                pool.ReturnPacket(msg.packets[i]);
+            }
+        } else {
+            /* Only move the message if there is room for ALL of it */
+            uint16_t delta = ci.txFill - ci.txDrain;
+            if (delta > ci.windowSize) {
+                delta += ci.windowSize;
+            }
+            uint16_t room = ci.windowSize - delta - 1;
+            if (room < msg.packets.size()) {
+                break;
+            }
+            for (size_t i = 0; i < msg.packets.size(); ++i) {
+                Packet* p = msg.packets[i];
+                p->seqNum = ci.txFill;
+                ci.txPackets[ci.txFill % ci.windowSize] = p;
+                ci.txFill++;
+            }
+            msg.status = ER_OK;
+        }
+        ci.txPendingPackets -= msg.packets.size();
+        msg.packets.clear();
+        completed.push_back(msg);
+        ci.txPendingQueue.pop_front();
+    }
+
+    /* Wake up PushBytes callers that waited for the queue to empty */
+    if (ci.txPendingQueue.empty()) {
+        ci.sinkEvent.SetEvent();
+    }
+}
+
+void PacketEngine::CompletePendingMessages(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed)
+{
+    for (size_t i = 0; i < completed.size(); ++i) {
+        ChannelInfo::TxPendingMessage& msg = completed[i];
+        if (msg.listener) {
+            msg.listener->PushBytesComplete(ci.stream, msg.numBytes, msg.status, msg.context);
+        }
+    }
+    completed.clear();
+}
+
+void PacketEngine::FailPendingMessages(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed)
+{
+    ci.txLock.Lock();
+    while (!ci.txPendingQueue.empty()) {
+        ChannelInfo::TxPendingMessage& msg = ci.txPendingQueue.front();
+        for (size_t i = 0; i < msg.packets.size(); ++i) {
+            pool.ReturnPacket(msg.packets[i]);
+        }
+        msg.packets.clear();
+        msg.status = ER_SOCK_OTHER_END_CLOSED;
+        completed.push_back(msg);
+        ci.txPendingQueue.pop_front();
+    }
+    ci.txPendingPackets = 0;
+    ci.sinkEvent.SetEvent();
     ci.txLock.Unlock();
 }
 
@@ -350,7 +484,7 @@ QStatus PacketEngine::DeliverControlMsg(PacketEngine::ChannelInfo& ci, const voi
     ci.txLock.Lock();
     ci.txControlQueue.push_back(p);
     ci.txLock.Unlock();
-    QStatus status = txPacketThread.Alert();
+    QStatus status = txPacketThreads[GetShard(ci.id)]->Alert();
     return status;
 }
 
@@ -478,12 +612,16 @@ void PacketEngine::AlarmTriggered(const Alarm& alarm, QStatus reason)
              * latest Xon alarm that has been setup. */
             if (cctx->xoffSeqNum == ci->rxFlowSeqNum) {
                 if (++cctx->retries < XON_RETRIES) {
-                    /* Rearm the timer and resend the XON */
-                    cctx->xon[1] = htole32(ci->rxAck);
-                    cctx->xon[2] = htole32(ci->rxDrain);
-                    status = DeliverControlMsg(*ci, cctx->xon, sizeof(cctx->xon), ci->rxFlowSeqNum);
-                    if (status != ER_OK) {
-                        QCC_LogError(status, ("Failed to send XON"));
+                    /* Rearm the timer and resend the XON (or the window update on credit channels) */
+                    if (ci->options & PACKET_OPTION_RX_CREDIT) {
+                        SendAckNow(*ci, ci->rxAdvancedSeqNum);
+                    } else {
+                        cctx->xon[1] = htole32(ci->rxAck);
+                        cctx->xon[2] = htole32(ci->rxDrain);
+                        status = DeliverControlMsg(*ci, cctx->xon, sizeof(cctx->xon), ci->rxFlowSeqNum);
+                        if (status != ER_OK) {
+                            QCC_LogError(status, ("Failed to send XON"));
+                        }
                     }
 
                     uint32_t nextTime = GetRetryMs(*ci, cctx->retries);
@@ -492,6 +630,13 @@ void PacketEngine::AlarmTriggered(const Alarm& alarm, QStatus reason)
                     ci->xOnAlarm = Alarm(nextTime, packetEngineListener, ctx, zero);
                     status = timer.AddAlarm(ci->xOnAlarm);
                     //printf("rx(%d): xon retry=%d rxD=0x%x, next=%d\n", (GetTimestamp() / 100) % 100000, cctx->retries + 1, ci->rxDrain, nextTime);
+                } else if (ci->options & PACKET_OPTION_RX_CREDIT) {
+                    /* Window updates are not acknowledged, the transmitter may simply have nothing left to send */
+                    QCC_DbgPrintf(("PacketEngine: cid=0x%x window update retries exhausted", ci->id));
+                    delete cctx;
+                    cctx = NULL;
+                    ci->xOnAlarm = Alarm();
+                    status = ER_OK;
                 }
             } else {
                 QCC_DbgPrintf(("PacketEngine: cid=0x%x Not retrying stale XON", ci->id));
@@ -552,7 +697,7 @@ void PacketEngine::AlarmTriggered(const Alarm& alarm, QStatus reason)
 }
 
 PacketEngine::ChannelInfo::ChannelInfo(PacketEngine& engine, uint32_t id, const PacketDest& dest, PacketStream& packetStream,
-                                       PacketEngineListener& listener, uint16_t windowSize) :
+                                       PacketEngineListener& listener, uint16_t windowSize, CongestionControlType congestionControl) :
     engine(engine),
     id(id),
     state(OPENING),
@@ -582,15 +727,22 @@ PacketEngine::ChannelInfo::ChannelInfo(PacketEngine& engine, uint32_t id, const
     txDrain(0),
     remoteRxDrain(0),
     xOffSeqNum(0),
+    txCreditSeqNum(windowSize - 1),
     txControlQueue(),
+    txPendingQueue(),
+    txPendingPackets(0),
     txRttMean(0),
     txRttMeanVar(0),
     txRttInit(false),
-    txCongestionWindow(1),
-    txSlowStartThresh(windowSize),
-    txConsecutiveAcks(0),
+    txCongestion(CongestionController::Create(congestionControl, windowSize)),
+    txWindowLimit(windowSize),
+    txMinRtt(0),
+    txMinRttTs(0),
+    txRateTs(0),
+    txRateAcked(0),
     txLastMarshalSeqNum(numeric_limits<uint16_t>::max()),
     protocolVersion(0),
+    options(0),
     windowSize(windowSize),
     wasOpen(false)
 {
@@ -607,8 +759,8 @@ PacketEngine::ChannelInfo::ChannelInfo(PacketEngine& engine, uint32_t id, const
     rxMask = new uint32_t[rxMaskSize / sizeof(uint32_t)];
     ::memset(rxMask, 0, rxMaskSize);
 
-    /* create ack response buffer */
-    ackResp = new uint32_t[3 + rxMaskSize / sizeof(uint32_t)];
+    /* create ack response buffer (with room for the credit word) */
+    ackResp = new uint32_t[4 + rxMaskSize / sizeof(uint32_t)];
 
     /* Initialize sink Event */
     sinkEvent.SetEvent();
@@ -644,15 +796,22 @@ PacketEngine::ChannelInfo::ChannelInfo(const ChannelInfo& other) :
     txDrain(other.txDrain),
     remoteRxDrain(other.remoteRxDrain),
     xOffSeqNum(other.xOffSeqNum),
+    txCreditSeqNum(other.txCreditSeqNum),
     txControlQueue(),
+    txPendingQueue(),
+    txPendingPackets(0),
     txRttMean(other.txRttMean),
     txRttMeanVar(other.txRttMeanVar),
     txRttInit(other.txRttInit),
-    txCongestionWindow(other.txCongestionWindow),
-    txSlowStartThresh(other.txSlowStartThresh),
-    txConsecutiveAcks(other.txConsecutiveAcks),
+    txCongestion(CongestionController::Create(other.txCongestion->GetType(), other.windowSize)),
+    txWindowLimit(other.windowSize),
+    txMinRtt(0),
+    txMinRttTs(0),
+    txRateTs(0),
+    txRateAcked(0),
     txLastMarshalSeqNum(other.txLastMarshalSeqNum),
     protocolVersion(other.protocolVersion),
+    options(other.options),
     windowSize(other.windowSize),
     wasOpen(other.wasOpen)
 {
@@ -669,8 +828,8 @@ PacketEngine::ChannelInfo::ChannelInfo(const ChannelInfo& other) :
     rxMask = new uint32_t[rxMaskSize / sizeof(uint32_t)];
     ::memset(rxMask, 0, rxMaskSize - (rxMaskSize % sizeof(uint32_t)));
 
-    /* create ack response buffer */
-    ackResp = new uint32_t[3 + rxMaskSize / sizeof(uint32_t)];
+    /* create ack response buffer (with room for the credit word) */
+    ackResp = new uint32_t[4 + rxMaskSize / sizeof(uint32_t)];
 
     /* Initialize sink Event */
     sinkEvent.SetEvent();
@@ -719,26 +878,93 @@ PacketEngine::ChannelInfo::~ChannelInfo()
         delete ac;
     }
 
+    /*
+     * Pending messages were completed by whoever removed this channel (ReleaseChannelInfo or
+     * ~PacketEngine). Only a copy that never owned a queue gets here with one, so just free it.
+     */
     txLock.Lock();
     while (!txControlQueue.empty()) {
         engine.pool.ReturnPacket(txControlQueue.front());
         txControlQueue.pop_front();
     }
+    while (!txPendingQueue.empty()) {
+        TxPendingMessage& msg = txPendingQueue.front();
+        for (size_t i = 0; i < msg.packets.size(); ++i) {
+            engine.pool.ReturnPacket(msg.packets[i]);
+        }
+        txPendingQueue.pop_front();
+    }
+    txPendingPackets = 0;
     txLock.Unlock();
 
     delete ackAlarmContext;
+    delete txCongestion;
     delete[] rxPackets;
     delete[] txPackets;
     delete[] rxMask;
     delete[] ackResp;
 }
 
+void PacketEngine::ChannelInfo::TuneTxWindow(uint16_t ackedPackets, uint32_t rttMs)
+{
+    uint64_t now = GetTimestamp64();
+
+    /* Track the minimum RTT, re-measuring it periodically in case the route changed */
+    if (rttMs && ((txMinRtt == 0) || (rttMs < txMinRtt) || ((now - txMinRttTs) > WINDOW_TUNE_MIN_RTT_TTL))) {
+        txMinRtt = rttMs;
+        txMinRttTs = now;
+    }
+    if (txMinRtt == 0) {
+        return;
+    }
+
+    /* Measure the delivery rate over intervals of at least one RTT */
+    if (txRateTs == 0) {
+        txRateTs = now;
+        txRateAcked = 0;
+        return;
+    }
+    txRateAcked += ackedPackets;
+    uint64_t elapsed = now - txRateTs;
+    if (elapsed < ::max(txMinRtt, (uint32_t)ACK_DELAY_MS)) {
+        return;
+    }
+
+    /*
+     * Allow twice the bandwidth-delay product in flight. The headroom lets the window keep up
+     * when the rate increases since the delivery rate can't be measured above what was sent.
+     */
+    uint64_t bdp = (static_cast<uint64_t>(txRateAcked) * txMinRtt) / elapsed;
+    uint64_t limit = ::max(2 * bdp, (uint64_t)MIN_TUNED_WINDOW_SIZE);
+    uint16_t newLimit = static_cast<uint16_t>(::min(limit, (uint64_t)windowSize));
+    if (newLimit != txWindowLimit) {
+        QCC_DbgPrintf(("Tuning tx window of %s from %d to %d (minRtt=%u, bdp=%u)", engine.ToString(packetStream, dest).c_str(),
+                       txWindowLimit, newLimit, txMinRtt, static_cast<uint32_t>(bdp)));
+        txWindowLimit = newLimit;
+        txCongestion->SetMaxWindow(txWindowLimit);
+    }
+    txRateTs = now;
+    txRateAcked = 0;
+}
+
+void PacketEngine::ChannelInfo::ResetTxWindow()
+{
+    txWindowLimit = windowSize;
+    txCongestion->SetMaxWindow(windowSize);
+    txRateTs = 0;
+    txRateAcked = 0;
+    txCreditSeqNum = remoteRxDrain + windowSize - 1;
+}
+
 PacketEngine::ChannelInfo* PacketEngine::CreateChannelInfo(uint32_t chanId, const PacketDest& dest, PacketStream& packetStream,
-                                                           PacketEngineListener& listener, uint16_t windowSize)
+                                                           PacketEngineListener& listener, uint16_t windowSize,
+                                                           CongestionControlType congestionControl)
 {
     ChannelInfo* ret = NULL;
+    ChannelShard& shard = *channelShards[GetShard(chanId)];
     channelInfoLock.Lock();
-    if (channelInfos.find(chanId) == channelInfos.end()) {
+    shard.lock.Lock();
+    if (shard.channelInfos.find(chanId) == shard.channelInfos.end()) {
         /* Make sure packetStream is still on the list while holding channelInfos lock */
         bool found = false;
         map<Event*, pair<PacketStream*, PacketEngineListener*> >::iterator it = packetStreams.begin();
@@ -752,10 +978,11 @@ PacketEngine::ChannelInfo* PacketEngine::CreateChannelInfo(uint32_t chanId, cons
 
         /* Add ChannelInfo if packetStream was valid */
         if (found) {
-            ret = &(channelInfos.insert(pair<uint32_t, ChannelInfo>(chanId, ChannelInfo(*this, chanId, dest, packetStream, listener, windowSize))).first->second);
+            ret = &(shard.channelInfos.insert(pair<uint32_t, ChannelInfo>(chanId, ChannelInfo(*this, chanId, dest, packetStream, listener, windowSize, congestionControl))).first->second);
             ret->useCount = 1;
         }
     }
+    shard.lock.Unlock();
     channelInfoLock.Unlock();
     return ret;
 }
@@ -763,32 +990,45 @@ PacketEngine::ChannelInfo* PacketEngine::CreateChannelInfo(uint32_t chanId, cons
 PacketEngine::ChannelInfo* PacketEngine::AcquireChannelInfo(uint32_t chanId)
 {
     ChannelInfo* ret = NULL;
-    channelInfoLock.Lock();
-    map<uint32_t, ChannelInfo>::iterator it = channelInfos.find(chanId);
-    if (it != channelInfos.end()) {
+    ChannelShard& shard = *channelShards[GetShard(chanId)];
+    shard.lock.Lock();
+    map<uint32_t, ChannelInfo>::iterator it = shard.channelInfos.find(chanId);
+    if (it != shard.channelInfos.end()) {
         ret = &(it->second);
         ret->useCount++;
     }
-    channelInfoLock.Unlock();
+    shard.lock.Unlock();
     return ret;
 }
 
 PacketEngine::ChannelInfo* PacketEngine::AcquireNextChannelInfo(PacketEngine::ChannelInfo* inCi)
+{
+    /* Walk the shards in order, continuing with the shard of inCi */
+    uint32_t shard = inCi ? GetShard(inCi->id) : 0;
+    ChannelInfo* ret = AcquireNextChannelInfo(shard, inCi);
+    while (!ret && (++shard < channelShards.size())) {
+        ret = AcquireNextChannelInfo(shard, NULL);
+    }
+    return ret;
+}
+
+PacketEngine::ChannelInfo* PacketEngine::AcquireNextChannelInfo(uint32_t shardIdx, PacketEngine::ChannelInfo* inCi)
 {
     ChannelInfo* ret = NULL;
-    channelInfoLock.Lock();
-    map<uint32_t, ChannelInfo>::iterator it = channelInfos.begin();
+    ChannelShard& shard = *channelShards[shardIdx];
+    shard.lock.Lock();
+    map<uint32_t, ChannelInfo>::iterator it = shard.channelInfos.begin();
     if (inCi) {
-        it = channelInfos.find(inCi->id);
-        if (it != channelInfos.end()) {
+        it = shard.channelInfos.find(inCi->id);
+        if (it != shard.channelInfos.end()) {
             ++it;
         }
     }
-    if (it != channelInfos.end()) {
+    if (it != shard.channelInfos.end()) {
         ret = &(it->second);
         ret->useCount++;
     }
-    channelInfoLock.Unlock();
+    shard.lock.Unlock();
     if (inCi) {
         ReleaseChannelInfo(*inCi);
     }
@@ -797,20 +1037,30 @@ PacketEngine::ChannelInfo* PacketEngine::AcquireNextChannelInfo(PacketEngine::Ch
 
 void PacketEngine::ReleaseChannelInfo(ChannelInfo& ci)
 {
-    channelInfoLock.Lock();
+    ChannelShard& shard = *channelShards[GetShard(ci.id)];
+    shard.lock.Lock();
     if ((--ci.useCount == 0) && (ci.state == ChannelInfo::CLOSED)) {
         PacketEngineStream stream = ci.stream;
         PacketEngineListener& listener = ci.listener;
         PacketDest dest = ci.dest;
 
+        /* Collect queued messages so the destructor does not have to call their listeners */
+        std::vector<ChannelInfo::TxPendingMessage> completed;
+        FailPendingMessages(ci, completed);
+
         /* Erase entry in channelInfos */
-        channelInfos.erase(ci.id);
+        shard.channelInfos.erase(ci.id);
 
-        /* Notify disconnect cb (Must be done without holding channelInfoLock) */
-        channelInfoLock.Unlock();
+        /* Notify the listeners and disconnect cb (Must be done without holding the shard lock) */
+        shard.lock.Unlock();
+        for (size_t i = 0; i < completed.size(); ++i) {
+            if (completed[i].listener) {
+                completed[i].listener->PushBytesComplete(stream, completed[i].numBytes, completed[i].status, completed[i].context);
+            }
+        }
         listener.PacketEngineDisconnectCB(*this, stream, dest);
     } else {
-        channelInfoLock.Unlock();
+        shard.lock.Unlock();
     }
 }
 
@@ -850,8 +1100,14 @@ void PacketEngine::SendAckNow(ChannelInfo& ci, uint16_t seqNum)
     for (size_t i = 0; i < (ci.rxMaskSize / sizeof(uint32_t)); ++i) {
         ci.ackResp[3 + i] = htole32(ci.rxMask[i]);
     }
+    size_t ackLen = 3 * sizeof(uint32_t) + ci.rxMaskSize;
+    if (ci.options & PACKET_OPTION_RX_CREDIT) {
+        /* The credit is the last word since the two ends may use rx masks of different sizes */
+        ci.ackResp[ackLen / sizeof(uint32_t)] = htole32(static_cast<uint16_t>(ci.rxDrain + ci.windowSize - 1));
+        ackLen += sizeof(uint32_t);
+    }
     ci.rxLock.Unlock();
-    QStatus status = DeliverControlMsg(ci, ci.ackResp, 3 * sizeof(uint32_t) + ci.rxMaskSize, seqNum);
+    QStatus status = DeliverControlMsg(ci, ci.ackResp, ackLen, seqNum);
     if (status != ER_OK) {
         QCC_LogError(status, ("SendAckNow failed"));
     }
@@ -893,17 +1149,99 @@ void PacketEngine::SendXOn(ChannelInfo& ci)
     ci.rxLock.Unlock();
 }
 
-PacketEngine::RxPacketThread::RxPacketThread(const qcc::String& engineName) : Thread(engineName + "-rx"), engine(NULL)
+void PacketEngine::SendWindowUpdate(ChannelInfo& ci)
+{
+    QCC_DbgTrace(("PacketEngine::SendWindowUpdate(chan=0x%x, rxFill=0x%x, rxDrain=0x%x, rxAck=0x%x, rxFlowSeqNum=0x%x)", ci.id, ci.rxFill, ci.rxDrain, ci.rxAck, ci.rxFlowSeqNum));
+    ci.rxLock.Lock();
+
+    /* The alarm is shared with XON since a channel only ever uses one of them */
+    XOnAlarmContext* cctx = new XOnAlarmContext(ci.id, ci.rxFlowSeqNum);
+    uint32_t zero = 0;
+    uint32_t timeout = GetRetryMs(ci, ++cctx->retries);
+    qcc::AlarmListener* packetEngineListener = this;
+    ci.xOnAlarm = Alarm(timeout, packetEngineListener, cctx, zero);
+    QStatus status = timer.AddAlarm(ci.xOnAlarm);
+    if (status == ER_OK) {
+        SendAckNow(ci, ci.rxAdvancedSeqNum);
+    } else {
+        QCC_LogError(status, ("PacketEngine::SendWindowUpdate failed"));
+        delete cctx;
+        ci.xOnAlarm = Alarm();
+    }
+
+    ci.rxLock.Unlock();
+}
+
+PacketEngine::RxPacketThread::RxPacketThread(const qcc::String& engineName) : Thread(engineName + "-rx"), engine(NULL), isWorker(false)
+{
+}
+
+PacketEngine::RxPacketThread::RxPacketThread(const qcc::String& engineName, uint32_t shard) :
+    Thread(engineName + "-rx" + U32ToString(shard)), engine(NULL), isWorker(true)
+{
+}
+
+void PacketEngine::RxPacketThread::QueuePacket(Packet* p)
 {
+    queueLock.Lock();
+    queue.push_back(p);
+    queueEvent.SetEvent();
+    queueLock.Unlock();
 }
 
 qcc::ThreadReturn STDCALL PacketEngine::RxPacketThread::Run(void* arg)
 {
     engine = reinterpret_cast<PacketEngine*>(arg);
+    return isWorker ? RunWorker() : RunReceiver();
+}
+
+qcc::ThreadReturn PacketEngine::RxPacketThread::RunWorker()
+{
+    std::deque<Packet*> packets;
+    while (!IsStopping()) {
+        ThreadScheduling::Apply();
+        QStatus status = Event::Wait(queueEvent);
+        if (status == ER_ALERTED_THREAD) {
+            GetStopEvent().ResetEvent();
+        } else if (status != ER_OK) {
+            break;
+        }
+        queueLock.Lock();
+        packets.swap(queue);
+        queueEvent.ResetEvent();
+        queueLock.Unlock();
+        while (!packets.empty()) {
+            HandlePacket(packets.front(), NULL, NULL);
+            packets.pop_front();
+        }
+    }
+    /* Drop packets that were never handled */
+    queueLock.Lock();
+    while (!queue.empty()) {
+        engine->pool.ReturnPacket(queue.front());
+        queue.pop_front();
+    }
+    queueLock.Unlock();
+    return (qcc::ThreadReturn) 0;
+}
+
+void PacketEngine::RxPacketThread::HandlePacket(Packet* p, PacketStream* packetStream, PacketEngineListener* listener)
+{
+    if (p->flags & PACKET_FLAG_CONTROL) {
+        HandleControlPacket(p, packetStream, listener);
+    } else {
+        HandleDataPacket(p);
+    }
+}
+
+qcc::ThreadReturn PacketEngine::RxPacketThread::RunReceiver()
+{
     vector<Event*> checkEvents, sigEvents;
+    Packet* rxBatch[RX_BATCH_SIZE] = { NULL };
     QStatus status = ER_OK;
     Event& stopEvent = GetStopEvent();
     while (!IsStopping() && (status == ER_OK)) {
+        ThreadScheduling::Apply();
         checkEvents.clear();
         sigEvents.clear();
         checkEvents.push_back(&stopEvent);
@@ -923,21 +1261,54 @@ qcc::ThreadReturn STDCALL PacketEngine::RxPacketThread::Run(void* arg)
                 if (it != engine->packetStreams.end()) {
                     PacketStream& stream = *(it->second.first);
                     PacketEngineListener& listener = *(it->second.second);
-                    Packet* p = engine->pool.GetPacket();
-                    status = p->Unmarshal(stream);
+
+                    /* Pull as many packets as the stream will give us in one go */
+                    void* bufs[RX_BATCH_SIZE];
+                    size_t actBytes[RX_BATCH_SIZE];
+                    PacketDest senders[RX_BATCH_SIZE];
+                    for (size_t i = 0; i < RX_BATCH_SIZE; ++i) {
+                        if (!rxBatch[i]) {
+                            rxBatch[i] = engine->pool.GetPacket();
+                        }
+                        bufs[i] = rxBatch[i]->buffer;
+                    }
+                    size_t numPulled = 0;
+                    status = stream.PullPacketBatch(bufs, engine->pool.GetMTU(), actBytes, senders, RX_BATCH_SIZE, numPulled, 3000);
+                    if (status != ER_OK) {
+                        /* Failed to pull from the stream. This is not fatal */
+                        QCC_DbgPrintf(("PacketStream::PullPacketBatch failed with %s", QCC_StatusText(status)));
+                        numPulled = 0;
+                        status = ER_OK;
+                    }
+                    Packet* pulled[RX_BATCH_SIZE];
+                    size_t numValid = 0;
+                    for (size_t i = 0; i < numPulled; ++i) {
+                        Packet* p = rxBatch[i];
+                        rxBatch[i] = NULL;
+                        p->SetSender(senders[i]);
+                        QStatus pStatus = p->Unmarshal(stream, actBytes[i]);
+                        if (pStatus == ER_OK) {
+                            pulled[numValid++] = p;
+                        } else {
+                            /* Failed to unmarshal a single packet. This is not fatal */
+                            QCC_DbgPrintf(("Packet::Unmarshal failed with %s", QCC_StatusText(pStatus)));
+                            engine->pool.ReturnPacket(p);
+                        }
+                    }
                     engine->channelInfoLock.Unlock();
-                    if (status == ER_OK) {
-                        /* Handle control or data packet */
-                        if (p->flags & PACKET_FLAG_CONTROL) {
-                            HandleControlPacket(p, stream, listener);
+                    for (size_t i = 0; i < numValid; ++i) {
+                        Packet* p = pulled[i];
+                        /*
+                         * Connect requests create the channel and need the packet stream so they are
+                         * handled here. Everything else is handed to the worker for the channel's shard
+                         * which preserves the order of the packets of each channel.
+                         */
+                        bool isConnectReq = (p->flags & PACKET_FLAG_CONTROL) && (letoh32(p->payload[0]) == PACKET_COMMAND_CONNECT_REQ);
+                        if (engine->rxWorkers.empty() || isConnectReq) {
+                            HandlePacket(p, &stream, &listener);
                         } else {
-                            HandleDataPacket(p);
+                            engine->rxWorkers[engine->GetShard(p->chanId)]->QueuePacket(p);
                         }
-                    } else {
-                        /* Failed to unmarshal a single packet. This is not fatal */
-                        QCC_DbgPrintf(("Packet::Unmarshal failed with %s", QCC_StatusText(status)));
-                        engine->pool.ReturnPacket(p);
-                        status = ER_OK;
                     }
                 } else {
                     engine->channelInfoLock.Unlock();
@@ -949,18 +1320,25 @@ qcc::ThreadReturn STDCALL PacketEngine::RxPacketThread::Run(void* arg)
             }
         }
     }
+    for (size_t i = 0; i < RX_BATCH_SIZE; ++i) {
+        if (rxBatch[i]) {
+            engine->pool.ReturnPacket(rxBatch[i]);
+        }
+    }
     if (status != ER_STOPPING_THREAD) {
         QCC_DbgPrintf(("RxPacketThread::Run() exiting with %s", QCC_StatusText(status)));
     }
     return (qcc::ThreadReturn) status;
 }
 
-void PacketEngine::RxPacketThread::HandleControlPacket(Packet* p, PacketStream& packetStream, PacketEngineListener& listener)
+void PacketEngine::RxPacketThread::HandleControlPacket(Packet* p, PacketStream* packetStream, PacketEngineListener* listener)
 {
     uint32_t cmd = letoh32(p->payload[0]);
     switch (cmd) {
     case PACKET_COMMAND_CONNECT_REQ:
-        HandleConnectReq(p, packetStream, listener);
+        if (packetStream && listener) {
+            HandleConnectReq(p, *packetStream, *listener);
+        }
         break;
 
     case PACKET_COMMAND_CONNECT_RSP:
@@ -1013,6 +1391,17 @@ void PacketEngine::RxPacketThread::HandleDataPacket(Packet* p)
                 /* Received in-range packet */
                 ci->rxPackets[idx] = p;
 
+                /* A packet beyond the flow off packet shows that the window update was received */
+                if ((ci->options & PACKET_OPTION_RX_CREDIT) && !ci->rxFlowOff && (seqNum != ci->rxFlowSeqNum) &&
+                    IN_WINDOW(uint16_t, ci->rxFlowSeqNum, ci->windowSize, seqNum)) {
+                    XOnAlarmContext* cctx = static_cast<XOnAlarmContext*>(ci->xOnAlarm->GetContext());
+                    if (cctx) {
+                        engine->timer.RemoveAlarm(ci->xOnAlarm);
+                        ci->xOnAlarm = Alarm();
+                        delete cctx;
+                    }
+                }
+
                 /* Monitor flow off */
                 if (p->flags & PACKET_FLAG_FLOW_OFF) {
                     ci->rxFlowOff = true;
@@ -1022,7 +1411,11 @@ void PacketEngine::RxPacketThread::HandleDataPacket(Packet* p)
                     /* Flow on is triggered if packet that caused flow off is not at end of rcv window or if rcv buf is empty */
                     if ((ci->rxDrain == ci->rxAck) || IN_WINDOW(uint16_t, ci->rxDrain, ci->windowSize - 2 - XON_THRESHOLD, ci->rxFlowSeqNum)) {
                         ci->rxFlowOff = false;
-                        engine->SendXOn(*ci);
+                        if (ci->options & PACKET_OPTION_RX_CREDIT) {
+                            engine->SendWindowUpdate(*ci);
+                        } else {
+                            engine->SendXOn(*ci);
+                        }
                     }
                 }
 
@@ -1160,7 +1553,8 @@ void PacketEngine::RxPacketThread::HandleConnectReq(Packet* p, PacketStream& pac
     /* Make sure that this connect request doesn't already have a channel */
     uint32_t reqProtoVersion = letoh32(p->payload[1]);
     uint32_t reqWindowSize = letoh32(p->payload[2]);
-    ChannelInfo* ci = engine->CreateChannelInfo(p->chanId, p->GetSender(), packetStream, listener, GetValidWindowSize(::min(engine->maxWindowSize, reqWindowSize)));
+    ChannelInfo* ci = engine->CreateChannelInfo(p->chanId, p->GetSender(), packetStream, listener, GetValidWindowSize(::min(engine->maxWindowSize, reqWindowSize)),
+                                                engine->defaultCongestionControl);
     if (ci) {
         /* Ask listener for to accept/reject */
         bool accepted = ci->listener.PacketEngineAcceptCB(*engine, ci->stream, ci->dest);
@@ -1169,12 +1563,17 @@ void PacketEngine::RxPacketThread::HandleConnectReq(Packet* p, PacketStream& pac
         /* Update protocol version for this channel */
         ci->protocolVersion = ::min(reqProtoVersion, (uint32_t)PACKET_ENGINE_VERSION);
 
+        /* Options are only used if both sides support them, older engines don't send the options word */
+        uint32_t reqOptions = (p->payloadLen >= (4 * sizeof(uint32_t))) ? letoh32(p->payload[3]) : 0;
+        ci->options = reqOptions & GetLocalOptions(packetStream);
+
         /* Create the connect response */
         ConnectRspAlarmContext* cctx = new ConnectRspAlarmContext(ci->id, ci->dest);
         cctx->connRsp[0] = htole32(PACKET_COMMAND_CONNECT_RSP);
         cctx->connRsp[1] = htole32(ci->protocolVersion);
         cctx->connRsp[2] = htole32(accepted ? ER_OK : ER_BUS_CONNECTION_REJECTED);
         cctx->connRsp[3] = htole32(ci->windowSize);
+        cctx->connRsp[4] = htole32(ci->options);
 
         /* Put an entry on the callback timer */
         uint32_t timeout = CONNECT_RETRY_TIMEOUT;
@@ -1207,6 +1606,7 @@ void PacketEngine::RxPacketThread::HandleConnectRsp(Packet* p)
     QStatus status = ER_OK;
     QStatus rspStatus = static_cast<QStatus>(letoh32(p->payload[2]));
     uint32_t reqWindowSize = letoh32(p->payload[3]);
+    uint32_t rspOptions = (p->payloadLen >= (5 * sizeof(uint32_t))) ? letoh32(p->payload[4]) : 0;
 
     /* Channel for this connectRsp should already exist and should be in OPENING state */
     ChannelInfo* ci = engine->AcquireChannelInfo(p->chanId);
@@ -1226,13 +1626,19 @@ void PacketEngine::RxPacketThread::HandleConnectRsp(Packet* p)
                     rspStatus = ER_FAIL;
                 }
                 /* Validate window size */
-                if (reqWindowSize > engine->maxWindowSize) {
+                if ((reqWindowSize > engine->maxWindowSize) || (GetValidWindowSize(reqWindowSize) != reqWindowSize)) {
                     rspStatus = ER_PACKET_BAD_PARAMETER;
                     QCC_LogError(ER_FAIL, ("Invalid WindowSize (%d) received in ConnectRsp from %s", reqWindowSize, engine->ToString(ci->packetStream, ci->dest).c_str()));
                 }
                 /* Update channelInfo and call the user's callback */
                 ci->state = (rspStatus == ER_OK) ? ChannelInfo::OPEN : ChannelInfo::CLOSING;
-                ci->windowSize = reqWindowSize;
+                if (rspStatus == ER_OK) {
+                    ci->windowSize = reqWindowSize;
+                    ci->txLock.Lock();
+                    ci->options = rspOptions & GetLocalOptions(ci->packetStream);
+                    ci->ResetTxWindow();
+                    ci->txLock.Unlock();
+                }
                 ci->wasOpen = (ci->state == ChannelInfo::OPEN);
                 ci->listener.PacketEngineConnectCB(*engine, rspStatus, &ci->stream, ci->dest, ctx->context);
 
@@ -1338,6 +1744,7 @@ void PacketEngine::RxPacketThread::HandleAck(Packet* controlPacket)
         uint16_t remoteRxDrain = letoh32(controlPacket->payload[2]);
         uint16_t delta = remoteRxAck - remoteRxDrain;
         uint16_t ackedPackets = 0;
+        uint32_t rttMs = 0;
 
         if (delta >= ci->windowSize) {
             delta += ci->windowSize;
@@ -1348,6 +1755,14 @@ void PacketEngine::RxPacketThread::HandleAck(Packet* controlPacket)
 
             ci->remoteRxDrain = remoteRxDrain;
 
+            /* The send credit only moves forward so a reordered ack cannot shrink it */
+            if ((ci->options & PACKET_OPTION_RX_CREDIT) && (controlPacket->payloadLen >= (4 * sizeof(uint32_t)))) {
+                uint16_t credit = letoh32(controlPacket->payload[(controlPacket->payloadLen / sizeof(uint32_t)) - 1]);
+                if (IN_WINDOW(uint16_t, ci->txCreditSeqNum, ci->windowSize, credit)) {
+                    ci->txCreditSeqNum = credit;
+                }
+            }
+
             /* Find and validate the packet that this ack refers to */
             Packet*& p = ci->txPackets[controlPacket->seqNum % ci->windowSize];
             if (p && (p->seqNum == controlPacket->seqNum)) {
@@ -1359,7 +1774,8 @@ void PacketEngine::RxPacketThread::HandleAck(Packet* controlPacket)
                  */
                 if (p->sendAttempts == 1) {
                     uint64_t now = GetTimestamp64();
-                    int32_t rtt = static_cast<int32_t>((now - p->sendTs + 1) << 10);
+                    rttMs = static_cast<uint32_t>(now - p->sendTs + 1);
+                    int32_t rtt = static_cast<int32_t>(rttMs << 10);
                     if (ci->txRttInit) {
                         int32_t err = (rtt - ci->txRttMean);
                         ci->txRttMean = ci->txRttMean + (err >> 3);
@@ -1416,17 +1832,13 @@ void PacketEngine::RxPacketThread::HandleAck(Packet* controlPacket)
             }
 
             /* Receiving ack indicates no/reduced congestion. Increase window */
-            while (ackedPackets && (ci->txCongestionWindow < ci->windowSize)) {
-                if ((ci->txCongestionWindow < ci->txSlowStartThresh) || (ci->txConsecutiveAcks >= ci->txCongestionWindow)) {
-                    ++ci->txCongestionWindow;
-                    ci->txConsecutiveAcks = 0;
-                    QCC_DbgPrintf(("Increasing congestion window of %s to %d", engine->ToString(ci->packetStream, ci->dest).c_str(), ci->txCongestionWindow));
-                } else {
-                    ci->txConsecutiveAcks++;
-                }
-                ackedPackets--;
+            uint16_t oldWindow = ci->txCongestion->GetWindow();
+            ci->txCongestion->OnAck(ackedPackets, rttMs);
+            ci->TuneTxWindow(ackedPackets, rttMs);
+            if (ci->txCongestion->GetWindow() != oldWindow) {
+                QCC_DbgPrintf(("Increasing congestion window of %s to %d", engine->ToString(ci->packetStream, ci->dest).c_str(), ci->txCongestion->GetWindow()));
             }
-            engine->txPacketThread.Alert();
+            engine->AlertTx(ci->id);
         } else {
             QCC_DbgPrintf(("Invalid ack window: seqNum=0x%x, drain=0x%x, ack=0x%x", controlPacket->seqNum, ci->remoteRxDrain, remoteRxAck));
         }
@@ -1482,7 +1894,7 @@ void PacketEngine::RxPacketThread::HandleXOn(Packet* controlPacket)
             }
 
             ci->txLock.Unlock();
-            engine->txPacketThread.Alert();
+            engine->AlertTx(ci->id);
         } else {
             ci->txLock.Unlock();
         }
@@ -1523,15 +1935,18 @@ void PacketEngine::RxPacketThread::HandleXOnAck(Packet* controlPacket)
     }
 }
 
-PacketEngine::TxPacketThread::TxPacketThread(const qcc::String& engineName) : Thread(engineName + "-tx"), engine(NULL)
+PacketEngine::TxPacketThread::TxPacketThread(const qcc::String& engineName, uint32_t shard) :
+    Thread(engineName + "-tx" + U32ToString(shard)), engine(NULL), shard(shard)
 {
 }
 
 qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
 {
     uint32_t waitMs = Event::WAIT_FOREVER;
+    std::vector<ChannelInfo::TxPendingMessage> completed;
     engine = reinterpret_cast<PacketEngine*>(arg);
     while (!IsStopping()) {
+        ThreadScheduling::Apply();
         QStatus status = ER_OK;
         if (waitMs > 0) {
             /* Wait for waitTs - now  milliseconds */
@@ -1548,7 +1963,7 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
         if (!IsStopping() && (status == ER_OK)) {
             /* Iterate over tx queue and send, resend or expire */
             ChannelInfo* ci = NULL;
-            while ((ci = engine->AcquireNextChannelInfo(ci)) != NULL) {
+            while ((ci = engine->AcquireNextChannelInfo(shard, ci)) != NULL) {
                 ci->txLock.Lock();
                 /* Send all control messages */
                 while (!ci->txControlQueue.empty()) {
@@ -1565,11 +1980,17 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                     }
                     engine->pool.ReturnPacket(p);
                 }
+                /* Move messages queued by PushBytesAsync into the tx window */
+                engine->FillTxWindow(*ci, completed);
                 /* Walk from [txDrain, min(txFill,congestion_window,remoteRxDrain+window)) and (re)send any user packets */
                 if (ci && ci->state == ChannelInfo::OPEN) {
                     uint16_t nonExpiredPackets = 0;
                     uint16_t drain = ci->txDrain;
-                    while ((drain != ci->txFill) && IN_WINDOW(uint16_t, ci->remoteRxDrain, ci->windowSize - 1, drain) && (nonExpiredPackets < ci->txCongestionWindow)) {
+                    Packet* batch[TX_BATCH_SIZE];
+                    size_t batchCount = 0;
+                    /* Credit channels send up to the window edge advertised by the receiver's acks */
+                    uint16_t remoteRxDrain = (ci->options & PACKET_OPTION_RX_CREDIT) ? static_cast<uint16_t>(ci->txCreditSeqNum - (ci->windowSize - 1)) : ci->remoteRxDrain;
+                    while ((drain != ci->txFill) && IN_WINDOW(uint16_t, remoteRxDrain, ci->windowSize - 1, drain) && (nonExpiredPackets < ci->txCongestion->GetWindow())) {
                         Packet*& p = ci->txPackets[drain % ci->windowSize];
                         if (p) {
                             uint64_t now = GetTimestamp64();
@@ -1580,7 +2001,17 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                              *     or
                              *  c) packet has expired but is needed to trigger XOFF
                              */
-                            uint16_t xOffSeqNum = ci->remoteRxDrain + ci->windowSize - 2;
+                            uint16_t xOffSeqNum = remoteRxDrain + ci->windowSize - 2;
+                            /*
+                             * A packet of an expired message that has already been sent must still be
+                             * acknowledged to keep the window moving, but if the receiver supports it
+                             * the retransmissions no longer carry the payload that is now useless.
+                             */
+                            if ((ci->options & PACKET_OPTION_PARTIAL_RELIABILITY) && (p->sendAttempts >= 1) && (p->expireTs <= now) && !(p->flags & PACKET_FLAG_EXPIRED)) {
+                                p->flags |= PACKET_FLAG_EXPIRED;
+                                p->payloadLen = 0;
+                                p->Marshal();
+                            }
                             if (((p->expireTs > now) || (p->sendAttempts >= 1) || (p->seqNum == xOffSeqNum) || (drain == (ci->txFill - 1))) && (p->sendAttempts <= MAX_PACKET_SEND_ATTEMPTS)) {
                                 ++nonExpiredPackets;
                                 uint32_t retryMs = engine->GetRetryMs(*ci, p->sendAttempts);
@@ -1589,7 +2020,7 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                                     ++p->sendAttempts;
                                     /* Marshal if this is the first send attempt */
                                     if (p->sendAttempts == 1) {
-                                        if (ci->txCongestionWindow > ci->txSlowStartThresh) {
+                                        if (ci->txCongestion->IsPastSlowStart()) {
                                             p->flags |= PACKET_FLAG_DELAY_ACK;
                                         }
                                         uint16_t gap = p->seqNum - ci->txLastMarshalSeqNum - 1;
@@ -1597,7 +2028,9 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                                             gap = numeric_limits<uint16_t>::max();
                                         }
                                         p->gap = gap;
-                                        p->Marshal();
+                                        if (ci->options & PACKET_OPTION_NO_CRC) {
+                                            p->flags |= PACKET_FLAG_NO_CRC;
+                                        }
                                         ci->txLastMarshalSeqNum = p->seqNum;
                                         needMarshal = true;
                                     }
@@ -1616,25 +2049,15 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                                     if (needMarshal) {
                                         p->Marshal();
                                     }
-                                    status = ci->packetStream.PushPacketBytes(p->buffer, p->payloadLen + Packet::payloadOffset, ci->dest);
-                                    //printf("tx(%d): s=0x%x, len=%d, gap=%d, retry=%d txFill=0x%x, txDrain=0x%x, drain=0x%x, retryMs=%d, actMs=%d, xoff=%s\n", (GetTimestamp() / 100) % 100000, p->seqNum, (int) p->payloadLen, p->gap, p->sendAttempts, ci->txFill, ci->txDrain, drain, retryMs, (int) (now - p->sendTs), (p->flags & PACKET_FLAG_FLOW_OFF) ? "off" : "nc");
-                                    QCC_DbgPrintf(("TxPacketThread sent seqNum=0x%x to %s (try=%d, gap=%d, drain=0x%x) %s", p->seqNum, engine->ToString(ci->packetStream, ci->dest).c_str(), p->sendAttempts, p->gap, drain, QCC_StatusText(status)));
-                                    if (status == ER_OK) {
-                                        /* Update sendTs and update (next) wait time */
-                                        p->sendTs = GetTimestamp64();
-                                        waitMs = ::min(waitMs, engine->GetRetryMs(*ci, p->sendAttempts));
-                                    } else {
-                                        /* Return packet and close this channel */
-                                        QCC_LogError(status, ("TxPacketThread: PushPacketBytes(%s) failed. Closing channel", engine->ToString(ci->packetStream, ci->dest).c_str()));
-                                        ci->state = ChannelInfo::CLOSED;
-                                        status = ER_OK;
+                                    /* Packets stay in txPackets while txLock is held so they can be sent as a batch */
+                                    batch[batchCount++] = p;
+                                    if ((batchCount == TX_BATCH_SIZE) && (FlushBatch(*ci, batch, batchCount, waitMs) != ER_OK)) {
                                         break;
                                     }
                                     /* Adjust congestion window down (by factor of 2) if this was a retry */
-                                    if ((p->sendAttempts > 1) && (ci->txCongestionWindow > 1)) {
-                                        ci->txCongestionWindow = ci->txCongestionWindow >> 1;
-                                        ci->txSlowStartThresh = ::max(ci->txCongestionWindow, (uint16_t)2);
-                                        QCC_DbgPrintf(("Decreasing congestion window of %s to %d (ssThresh=%d)", engine->ToString(ci->packetStream, ci->dest).c_str(), ci->txCongestionWindow, ci->txSlowStartThresh));
+                                    if ((p->sendAttempts > 1) && (ci->txCongestion->GetWindow() > 1)) {
+                                        ci->txCongestion->OnRetransmit();
+                                        QCC_DbgPrintf(("Decreasing congestion window of %s to %d (ssThresh=%d)", engine->ToString(ci->packetStream, ci->dest).c_str(), ci->txCongestion->GetWindow(), ci->txCongestion->GetSlowStartThresh()));
                                     }
                                 } else {
                                     /* Calcualte next retry time */
@@ -1650,9 +2073,15 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
                         }
                         ++drain;
                     }
-                    //printf("tx(%d): while exited d=0x%x, tD=0x%x, tF=0x%x, rrD=0x%x, nep=%d, cw=%d\n", (GetTimestamp() / 100) % 100000, drain, ci->txDrain, ci->txFill, ci->remoteRxDrain, nonExpiredPackets, ci->txCongestionWindow);
+                    if (batchCount) {
+                        FlushBatch(*ci, batch, batchCount, waitMs);
+                    }
+                    //printf("tx(%d): while exited d=0x%x, tD=0x%x, tF=0x%x, rrD=0x%x, nep=%d, cw=%d\n", (GetTimestamp() / 100) % 100000, drain, ci->txDrain, ci->txFill, ci->remoteRxDrain, nonExpiredPackets, ci->txCongestion->GetWindow());
                 }
                 ci->txLock.Unlock();
+                if (!completed.empty()) {
+                    engine->CompletePendingMessages(*ci, completed);
+                }
             }
         }
         if ((status != ER_OK) && (status != ER_STOPPING_THREAD)) {
@@ -1662,19 +2091,47 @@ qcc::ThreadReturn STDCALL PacketEngine::TxPacketThread::Run(void* arg)
     return (qcc::ThreadReturn) 0;
 }
 
+QStatus PacketEngine::TxPacketThread::FlushBatch(ChannelInfo& ci, Packet** batch, size_t& count, uint32_t& waitMs)
+{
+    const void* bufs[TX_BATCH_SIZE];
+    size_t lens[TX_BATCH_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        bufs[i] = batch[i]->buffer;
+        lens[i] = batch[i]->payloadLen + Packet::payloadOffset;
+    }
+    size_t numPushed = 0;
+    QStatus status = ci.packetStream.PushPacketBatch(bufs, lens, count, ci.dest, numPushed);
+    uint64_t now = GetTimestamp64();
+    for (size_t i = 0; i < numPushed; ++i) {
+        Packet* p = batch[i];
+        QCC_DbgPrintf(("TxPacketThread sent seqNum=0x%x to %s (try=%d, gap=%d)", p->seqNum, engine->ToString(ci.packetStream, ci.dest).c_str(), p->sendAttempts, p->gap));
+        /* Update sendTs and update (next) wait time */
+        p->sendTs = now;
+        waitMs = ::min(waitMs, engine->GetRetryMs(ci, p->sendAttempts));
+    }
+    if (status != ER_OK) {
+        /* Close this channel */
+        QCC_LogError(status, ("TxPacketThread: PushPacketBatch(%s) failed. Closing channel", engine->ToString(ci.packetStream, ci.dest).c_str()));
+        ci.state = ChannelInfo::CLOSED;
+    }
+    count = 0;
+    return status;
+}
+
 PacketStream* PacketEngine::GetPacketStream(const PacketEngineStream& stream)
 {
     PacketStream* ret = NULL;
-    channelInfoLock.Lock();
-    map<uint32_t, ChannelInfo>::iterator it = channelInfos.begin();
-    while (it != channelInfos.end()) {
+    ChannelShard& shard = *channelShards[GetShard(stream.chanId)];
+    shard.lock.Lock();
+    map<uint32_t, ChannelInfo>::iterator it = shard.channelInfos.begin();
+    while (it != shard.channelInfos.end()) {
         if (&(it->second.stream) == &stream) {
             ret = &(it->second.packetStream);
             break;
         }
         ++it;
     }
-    channelInfoLock.Unlock();
+    shard.lock.Unlock();
     return ret;
 }
 
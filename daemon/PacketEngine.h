@@ -24,6 +24,7 @@
 #include <qcc/platform.h>
 #include <map>
 #include <deque>
+#include <vector>
 
 #include <qcc/Stream.h>
 #include <qcc/SocketStream.h>
@@ -35,6 +36,7 @@
 #include "PacketStream.h"
 #include "PacketPool.h"
 #include "PacketEngineStream.h"
+#include "CongestionController.h"
 
 /**
  * Inside window calculation.
@@ -57,6 +59,12 @@
 #define ACK_DELAY_MS              10         /**<  Ms of delay before sending acks */
 #define XON_THRESHOLD             4          /**<  Min number of empty slots in rx buffer necessary to send XON */
 #define CLOSING_TIMEOUT           4000       /**< Max num of ms to wait for channel to stay in CLOSING state before being forced to CLOSED */
+#define MAX_WINDOW_SIZE           0x400      /**< Largest window size that can be negotiated (the rx mask of an ack must fit in one packet) */
+#define MIN_TUNED_WINDOW_SIZE     16         /**< Auto-tuning never limits the tx window below this number of packets */
+#define WINDOW_TUNE_MIN_RTT_TTL   10000      /**< MS after which the minimum RTT used for window auto-tuning is re-measured */
+#define RX_BATCH_SIZE             16         /**< Max number of packets pulled from a PacketStream at once */
+#define TX_BATCH_SIZE             16         /**< Max number of data packets of a channel pushed to a PacketStream at once */
+#define TX_PENDING_WINDOWS        4          /**< Max number of windows worth of packets queued by PushBytesAsync per channel */
 
 namespace ajn {
 
@@ -100,7 +108,7 @@ class PacketEngine : public qcc::AlarmListener {
 
         /* ChannelInfo constructor */
         ChannelInfo(PacketEngine& engine, uint32_t id, const PacketDest& dest, PacketStream& packetStream,
-                    PacketEngineListener& listener, uint16_t windowSize);
+                    PacketEngineListener& listener, uint16_t windowSize, CongestionControlType congestionControl);
 
         /**
          * Copy constructor.
@@ -114,6 +122,30 @@ class PacketEngine : public qcc::AlarmListener {
         /* Destructor */
         ~ChannelInfo();
 
+        /** A message queued by PacketEngineStream::PushBytesAsync */
+        struct TxPendingMessage {
+            std::vector<Packet*> packets;          /**< Packets of the message, seqNum is assigned when moved to the tx window */
+            size_t numBytes;                       /**< Size of the message */
+            PacketEngineStreamListener* listener;  /**< Listener to notify or NULL */
+            void* context;                         /**< Listener context */
+            QStatus status;                        /**< Completion status */
+        };
+
+        /**
+         * Auto-tune the limit on the tx window from the measured bandwidth-delay product.
+         * The limit never exceeds the negotiated window size. Must be called with txLock held.
+         *
+         * @param ackedPackets   Number of packets newly acknowledged.
+         * @param rttMs          Round trip time sample in milliseconds or 0 if there is no sample.
+         */
+        void TuneTxWindow(uint16_t ackedPackets, uint32_t rttMs);
+
+        /**
+         * Reset the window auto-tuning and the send credit after the window size has been
+         * (re)negotiated. Must be called with txLock held.
+         */
+        void ResetTxWindow();
+
         PacketEngine& engine;
         uint32_t id;
         State state;
@@ -148,18 +180,25 @@ class PacketEngine : public qcc::AlarmListener {
         uint16_t txFill, txDrain;
         uint16_t remoteRxDrain;
         uint16_t xOffSeqNum;
+        uint16_t txCreditSeqNum;
         std::deque<Packet*> txControlQueue;
+        std::deque<TxPendingMessage> txPendingQueue;
+        size_t txPendingPackets;
         int32_t txRttMean;
         int32_t txRttMeanVar;
         bool txRttInit;
         uint32_t* ackResp;
-        uint16_t txCongestionWindow;
-        uint16_t txSlowStartThresh;
-        uint16_t txConsecutiveAcks;
+        CongestionController* txCongestion;
+        uint16_t txWindowLimit;
+        uint32_t txMinRtt;
+        uint64_t txMinRttTs;
+        uint64_t txRateTs;
+        uint32_t txRateAcked;
         uint16_t txLastMarshalSeqNum;
         qcc::Mutex txLock;
 
         uint32_t protocolVersion;
+        uint32_t options;
         uint16_t windowSize;
         bool wasOpen;
 
@@ -168,17 +207,42 @@ class PacketEngine : public qcc::AlarmListener {
         ChannelInfo& operator=(const ChannelInfo& other);
     };
 
+    /**
+     * The channels are sharded by channel id. Each shard has its own lock, its own TX thread
+     * and (when there is more than one shard) its own RX worker thread so that every packet of
+     * a channel is handled by the same threads in order.
+     */
+    struct ChannelShard {
+        qcc::Mutex lock;                              /**< Protects channelInfos and the useCounts of its entries */
+        std::map<uint32_t, ChannelInfo> channelInfos; /**< Channels in this shard keyed by channel id */
+    };
+
     class RxPacketThread : public qcc::Thread {
       public:
+        /** Construct the thread that receives packets from the PacketStreams */
         RxPacketThread(const qcc::String& engineName);
 
+        /** Construct a worker thread that handles received packets for one channel shard */
+        RxPacketThread(const qcc::String& engineName, uint32_t shard);
+
+        /** Queue a received packet to be handled by this worker thread */
+        void QueuePacket(Packet* p);
+
       protected:
         qcc::ThreadReturn STDCALL Run(void* arg);
 
       private:
         PacketEngine* engine;
+        bool isWorker;
+        qcc::Mutex queueLock;
+        std::deque<Packet*> queue;
+        qcc::Event queueEvent;
+
+        qcc::ThreadReturn RunReceiver();
+        qcc::ThreadReturn RunWorker();
 
-        void HandleControlPacket(Packet* p, PacketStream& packetStream, PacketEngineListener& listener);
+        void HandlePacket(Packet* p, PacketStream* packetStream, PacketEngineListener* listener);
+        void HandleControlPacket(Packet* p, PacketStream* packetStream, PacketEngineListener* listener);
         void HandleDataPacket(Packet* p);
 
         void HandleConnectReq(Packet* p, PacketStream& packetStream, PacketEngineListener& listener);
@@ -196,20 +260,73 @@ class PacketEngine : public qcc::AlarmListener {
 
     class TxPacketThread : public qcc::Thread {
       public:
-        TxPacketThread(const qcc::String& engineName);
+        TxPacketThread(const qcc::String& engineName, uint32_t shard);
 
       protected:
         qcc::ThreadReturn STDCALL Run(void* arg);
 
       private:
+        /**
+         * Push the batched data packets of a channel to its PacketStream. Must be called with
+         * the channel's txLock held. The channel is closed if the push fails.
+         *
+         * @param ci        The channel.
+         * @param batch     The packets to push.
+         * @param count     [IN/OUT] Number of packets in the batch, 0 on return.
+         * @param waitMs    [IN/OUT] Time until the next retry is due.
+         * @return ER_OK if all packets were pushed.
+         */
+        QStatus FlushBatch(ChannelInfo& ci, Packet** batch, size_t& count, uint32_t& waitMs);
+
         PacketEngine* engine;
+        uint32_t shard;
     };
 
     void CloseChannel(ChannelInfo& ci);
 
+    /**
+     * Move queued messages into the tx window while there is room for them. Expired messages
+     * are dropped and, if the channel is no longer usable, all queued messages fail.
+     * Must be called with the channel's txLock held.
+     *
+     * @param ci          The channel.
+     * @param completed   [OUT] Messages that left the queue. Their listeners must be called with
+     *                    CompletePendingMessages after txLock is released.
+     */
+    void FillTxWindow(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed);
+
+    /**
+     * Notify the listeners of messages that left the pending queue.
+     * Must be called without holding the channel's txLock.
+     *
+     * @param ci          The channel.
+     * @param completed   Messages returned by FillTxWindow.
+     */
+    void CompletePendingMessages(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed);
+
+    /**
+     * Fail every message still queued on a channel that is going away.
+     * Takes the channel's txLock. The listeners are not called here since this runs with engine
+     * locks held, they must be called with CompletePendingMessages once those are released.
+     *
+     * @param ci          The channel.
+     * @param completed   [OUT] Messages that were removed from the queue.
+     */
+    void FailPendingMessages(ChannelInfo& ci, std::vector<ChannelInfo::TxPendingMessage>& completed);
+
   public:
 
-    PacketEngine(const qcc::String& name, uint32_t maxWindowSize = 128);
+    /**
+     * Construct a PacketEngine.
+     *
+     * @param name            Name of the engine (used for thread names).
+     * @param maxWindowSize   Maximum number of unacknowledged packets per channel (power of 2, at most
+     *                        MAX_WINDOW_SIZE). The window of each channel is negotiated down to the
+     *                        smaller of the two engines' maximum and the number of packets actually
+     *                        in flight is then auto-tuned to the channel's bandwidth-delay product.
+     * @param numShards       Number of channel shards, each serviced by its own TX and RX worker threads.
+     */
+    PacketEngine(const qcc::String& name, uint32_t maxWindowSize = 128, uint32_t numShards = 1);
 
     virtual ~PacketEngine();
 
@@ -223,7 +340,25 @@ class PacketEngine : public qcc::AlarmListener {
 
     QStatus RemovePacketStream(PacketStream& packetStream);
 
-    QStatus Connect(const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener, void* context);
+    /**
+     * Open a channel to a remote PacketEngine.
+     *
+     * @param dest                Destination of the channel.
+     * @param packetStream        PacketStream used to reach the destination.
+     * @param listener            Listener for the connect callback.
+     * @param context             Context passed to the connect callback.
+     * @param congestionControl   Congestion control algorithm used to send on the channel.
+     */
+    QStatus Connect(const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener, void* context,
+                    CongestionControlType congestionControl = CONGESTION_CONTROL_RENO);
+
+    /**
+     * Set the congestion control algorithm used to send on channels opened by remote PacketEngines.
+     * Only channels accepted after the call are affected.
+     *
+     * @param congestionControl   Congestion control algorithm.
+     */
+    void SetDefaultCongestionControl(CongestionControlType congestionControl) { defaultCongestionControl = congestionControl; }
 
     PacketStream* GetPacketStream(const PacketEngineStream& stream);
 
@@ -243,26 +378,45 @@ class PacketEngine : public qcc::AlarmListener {
 
     void SendXOn(ChannelInfo& ci);
 
+    /**
+     * Tell the transmitter of a PACKET_OPTION_RX_CREDIT channel that the receive window has reopened.
+     * The ack is resent on the XON retry schedule until a packet beyond the flow off packet arrives.
+     *
+     * @param ci   The channel.
+     */
+    void SendWindowUpdate(ChannelInfo& ci);
+
+    PacketPool& GetPacketPool() { return pool; }
+
   private:
 
     qcc::String name;
     PacketPool pool;
     RxPacketThread rxPacketThread;
-    TxPacketThread txPacketThread;
+    std::vector<RxPacketThread*> rxWorkers;
+    std::vector<TxPacketThread*> txPacketThreads;
     std::map<qcc::Event*, std::pair<PacketStream*, PacketEngineListener*> > packetStreams;
     qcc::Timer timer;
     qcc::Mutex channelInfoLock;
-    std::map<uint32_t, ChannelInfo> channelInfos;
+    std::vector<ChannelShard*> channelShards;
     uint32_t maxWindowSize;
+    CongestionControlType defaultCongestionControl;
     bool isRunning;
     bool rxPacketThreadReload;
 
-    ChannelInfo* CreateChannelInfo(uint32_t chanId, const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener, uint16_t windowSize);
+    ChannelInfo* CreateChannelInfo(uint32_t chanId, const PacketDest& dest, PacketStream& packetStream, PacketEngineListener& listener,
+                                   uint16_t windowSize, CongestionControlType congestionControl);
 
     ChannelInfo* AcquireChannelInfo(uint32_t chanId);
 
     ChannelInfo* AcquireNextChannelInfo(ChannelInfo* inCi);
 
+    ChannelInfo* AcquireNextChannelInfo(uint32_t shard, ChannelInfo* inCi);
+
+    uint32_t GetShard(uint32_t chanId) const { return chanId % channelShards.size(); }
+
+    void AlertTx(uint32_t chanId) { txPacketThreads[GetShard(chanId)]->Alert(); }
+
     void ReleaseChannelInfo(ChannelInfo& ci);
 
     void SendAck(ChannelInfo& ci, uint16_t seqNum, bool allowDelay);
@@ -129,6 +129,14 @@ QStatus PacketEngineStream::PullBytes(void* buf, size_t reqBytes, size_t& actual
         } else {
             if (p->flags & PACKET_FLAG_BOM) {
                 inExpiredMsg = (p->expireTs < now);
+                /* The message is also dropped if the sender gave up on any part of it */
+                for (uint16_t d = drain; !inExpiredMsg && (d != ci->rxFill); ++d) {
+                    Packet* mp = ci->rxPackets[d % ci->windowSize];
+                    inExpiredMsg = !mp || (mp->flags & PACKET_FLAG_EXPIRED);
+                    if (mp && (mp->flags & PACKET_FLAG_EOM)) {
+                        break;
+                    }
+                }
                 if (inExpiredMsg) {
                     engine->pool.ReturnPacket(p);
                     p = NULL;
@@ -148,8 +156,12 @@ QStatus PacketEngineStream::PullBytes(void* buf, size_t reqBytes, size_t& actual
         /* Flow on is triggered if packet that caused flow off is not at very last position in rcv window or if rcv buf is empty */
         if (ci->rxFlowOff && ((ci->rxDrain == ci->rxAck) || IN_WINDOW(uint16_t, ci->rxDrain, ci->windowSize - 2 - XON_THRESHOLD, ci->rxFlowSeqNum))) {
             ci->rxFlowOff = false;
-            engine->SendXOn(*ci);
-            engine->txPacketThread.Alert();
+            if (ci->options & PACKET_OPTION_RX_CREDIT) {
+                engine->SendWindowUpdate(*ci);
+            } else {
+                engine->SendXOn(*ci);
+            }
+            engine->AlertTx(chanId);
         }
     }
 
@@ -191,8 +203,12 @@ QStatus PacketEngineStream::PullBytes(void* buf, size_t reqBytes, size_t& actual
     /* Flow on is triggered if packet that caused flow off is not at very last position in rcv window or if rcv buf is empty */
     if (ci->rxFlowOff && ((ci->rxDrain == ci->rxAck) || IN_WINDOW(uint16_t, ci->rxDrain, ci->windowSize - 2 - XON_THRESHOLD, ci->rxFlowSeqNum))) {
         ci->rxFlowOff = false;
-        engine->SendXOn(*ci);
-        engine->txPacketThread.Alert();
+        if (ci->options & PACKET_OPTION_RX_CREDIT) {
+            engine->SendWindowUpdate(*ci);
+        } else {
+            engine->SendXOn(*ci);
+        }
+        engine->AlertTx(chanId);
     }
     ci->rxLock.Unlock();
     engine->ReleaseChannelInfo(*ci);
@@ -232,7 +248,8 @@ QStatus PacketEngineStream::PushBytes(const void* buf, size_t numBytes, size_t&
             delta += ci->windowSize;
         }
         uint16_t room = ci->windowSize - delta - 1;
-        if (room < numPackets) {
+        /* Messages queued by PushBytesAsync go first */
+        if ((room < numPackets) || !ci->txPendingQueue.empty()) {
             sinkEvent->ResetEvent();
             ci->txLock.Unlock();
             uint32_t waitMs = (ttl != 0) ? ::min(ttl, sendTimeout) : sendTimeout;
@@ -273,7 +290,7 @@ QStatus PacketEngineStream::PushBytes(const void* buf, size_t numBytes, size_t&
         isFirst = false;
     }
     if (status == ER_OK) {
-        engine->txPacketThread.Alert();
+        engine->AlertTx(chanId);
     }
     ci->txLock.Unlock();
     engine->ReleaseChannelInfo(*ci);
@@ -281,4 +298,68 @@ QStatus PacketEngineStream::PushBytes(const void* buf, size_t numBytes, size_t&
     return status;
 }
 
+QStatus PacketEngineStream::PushBytesAsync(const void* buf, size_t numBytes, uint32_t ttl, PacketEngineStreamListener* listener, void* context)
+{
+    QCC_DbgTrace(("PacketEngineStream::PushBytesAsync(<>, numBytes=%d, ttl=%d, <>, <>)", numBytes, ttl));
+
+    PacketEngine::ChannelInfo* ci = engine->AcquireChannelInfo(chanId);
+    if (!ci) {
+        return ER_SOCK_OTHER_END_CLOSED;
+    }
+
+    if (ci->state == PacketEngine::ChannelInfo::CLOSED || ci->state == PacketEngine::ChannelInfo::ABORTED) {
+        engine->ReleaseChannelInfo(*ci);
+        return ER_SOCK_OTHER_END_CLOSED;
+    }
+
+    /* Check size of caller's message */
+    size_t maxPayload = ::min(ci->packetStream.GetSinkMTU(), (size_t)engine->pool.GetMTU()) - Packet::payloadOffset;
+    size_t numPackets = (numBytes + maxPayload - 1) / maxPayload;
+    if (numPackets >= ci->windowSize) {
+        engine->ReleaseChannelInfo(*ci);
+        return ER_PACKET_TOO_LARGE;
+    }
+
+    /* Copy the message into packets without holding txLock. Sequence numbers are assigned by the TX thread */
+    PacketEngine::ChannelInfo::TxPendingMessage msg;
+    msg.numBytes = numBytes;
+    msg.listener = listener;
+    msg.context = context;
+    msg.status = ER_OK;
+    msg.packets.reserve(numPackets);
+    uint64_t expireTs = (ttl == 0) ? numeric_limits<uint64_t>::max() : GetTimestamp64() + ttl;
+    size_t numQueued = 0;
+    while (numQueued < numBytes) {
+        Packet* p = engine->pool.GetPacket();
+        size_t pLen = ::min(maxPayload, numBytes - numQueued);
+        p->SetPayload(reinterpret_cast<const uint8_t*>(buf) + numQueued, pLen);
+        p->chanId = ci->id;
+        p->flags = (numQueued == 0) ? PACKET_FLAG_BOM : 0;
+        p->flags |= (numBytes - numQueued) <= maxPayload ? PACKET_FLAG_EOM : 0;
+        p->expireTs = expireTs;
+        msg.packets.push_back(p);
+        numQueued += pLen;
+    }
+
+    QStatus status = ER_OK;
+    ci->txLock.Lock();
+    if ((ci->txPendingPackets + numPackets) > (static_cast<size_t>(TX_PENDING_WINDOWS) * ci->windowSize)) {
+        status = ER_WOULDBLOCK;
+    } else {
+        ci->txPendingQueue.push_back(msg);
+        ci->txPendingPackets += numPackets;
+        engine->AlertTx(chanId);
+    }
+    ci->txLock.Unlock();
+
+    if (status != ER_OK) {
+        for (size_t i = 0; i < msg.packets.size(); ++i) {
+            engine->pool.ReturnPacket(msg.packets[i]);
+        }
+    }
+    engine->ReleaseChannelInfo(*ci);
+
+    return status;
+}
+
 }
@@ -29,6 +29,29 @@ namespace ajn {
 
 /* Forward Declaration */
 class PacketEngine;
+class PacketEngineStream;
+
+/**
+ * PacketEngineStreamListener is notified when a message queued with
+ * PacketEngineStream::PushBytesAsync leaves the pending queue.
+ */
+class PacketEngineStreamListener {
+  public:
+    virtual ~PacketEngineStreamListener() { }
+
+    /**
+     * Called from a PacketEngine TX thread (or the thread that closes the channel) once the
+     * message has been moved into the channel's tx window, has expired or cannot be sent.
+     * The callback must not call PushBytes on the same stream.
+     *
+     * @param stream     The stream the message was queued on.
+     * @param numBytes   Size of the message.
+     * @param status     ER_OK if the message was moved into the tx window or expired before it could be.
+     *                   ER_SOCK_OTHER_END_CLOSED if the channel closed first.
+     * @param context    Context passed to PushBytesAsync.
+     */
+    virtual void PushBytesComplete(PacketEngineStream& stream, size_t numBytes, QStatus status, void* context) = 0;
+};
 
 /**
  * Stream is a virtual class that defines a standard interface for a streaming source and sink.
@@ -96,6 +119,23 @@ class PacketEngineStream : public qcc::Stream {
         return PushBytes(buf, numBytes, numSent, 0);
     }
 
+    /**
+     * Queue a whole message for transmission without waiting for room in the tx window.
+     * The message is copied into packets before this call returns. The PacketEngine's TX thread
+     * moves queued messages into the tx window, in order, as the window opens up and then calls
+     * listener. Messages pushed with PushBytes are sent after all previously queued messages.
+     *
+     * @param buf          Message to send.
+     * @param numBytes     Size of the message.
+     * @param ttl          Time-to-live in ms or 0 for infinite ttl.
+     * @param listener     Listener to notify when the message leaves the queue or NULL.
+     * @param context      Context passed to the listener.
+     * @return   ER_OK if the message was queued.
+     *           ER_PACKET_TOO_LARGE if the message does not fit in the tx window.
+     *           ER_WOULDBLOCK if too many packets are already queued.
+     */
+    QStatus PushBytesAsync(const void* buf, size_t numBytes, uint32_t ttl, PacketEngineStreamListener* listener, void* context);
+
     /**
      * Get the Event that indicates when data can be pushed to sink.
      *
@@ -19,8 +19,12 @@
  *    limitations under the License.
  ******************************************************************************/
 #include <qcc/platform.h>
+#include <qcc/atomic.h>
+#include <qcc/Debug.h>
 #include <qcc/Mutex.h>
 
+#include <algorithm>
+
 #include "PacketPool.h"
 
 using namespace std;
@@ -30,8 +34,21 @@ using namespace qcc;
 
 namespace ajn {
 
-PacketPool::PacketPool() : mtu(0), usedCount(0)
+PacketPool::PacketPool() :
+    mtu(0),
+    shared(new Shared),
+    highWaterMark(DEFAULT_HIGH_WATER_MARK),
+    usedCount(0),
+    hits(0),
+    misses(0),
+    allocs(0),
+    trims(0)
 {
+    shared->pool = this;
+    shared->refs = 1;
+#if defined(QCC_OS_GROUP_POSIX)
+    shared->magazineKeyValid = (pthread_key_create(&shared->magazineKey, ReleaseMagazine) == 0);
+#endif
 }
 
 QStatus PacketPool::Start(size_t mtu)
@@ -47,6 +64,21 @@ QStatus PacketPool::Stop()
 
 PacketPool::~PacketPool()
 {
+    /*
+     * A thread may be exiting right now and about to release its magazine, so the magazines
+     * and the key stay until their threads have exited. Only their packets are freed here.
+     */
+    shared->lock.Lock();
+    shared->pool = NULL;
+    for (size_t i = 0; i < shared->magazines.size(); ++i) {
+        Magazine* m = shared->magazines[i];
+        while (m->count) {
+            delete m->packets[--m->count];
+        }
+    }
+    ReleaseShared(shared);
+    shared = NULL;
+
     lock.Lock();
     std::vector<Packet*>::iterator it = freeList.begin();
     for (; it != freeList.end(); ++it) {
@@ -57,19 +89,137 @@ PacketPool::~PacketPool()
     lock.Unlock();
 }
 
+#if defined(QCC_OS_GROUP_POSIX)
+
+PacketPool::Magazine* PacketPool::GetMagazine()
+{
+    if (!shared->magazineKeyValid) {
+        return NULL;
+    }
+    Magazine* m = reinterpret_cast<Magazine*>(pthread_getspecific(shared->magazineKey));
+    if (!m) {
+        m = new Magazine;
+        m->shared = shared;
+        m->count = 0;
+        if (pthread_setspecific(shared->magazineKey, m) == 0) {
+            shared->lock.Lock();
+            shared->magazines.push_back(m);
+            ++shared->refs;
+            shared->lock.Unlock();
+        } else {
+            delete m;
+            m = NULL;
+        }
+    }
+    return m;
+}
+
+#else
+
+/* Magazines are only implemented for posix, other platforms only use the shared free list */
+PacketPool::Magazine* PacketPool::GetMagazine()
+{
+    return NULL;
+}
+
+#endif
+
+void PacketPool::ReleaseShared(Shared* shared)
+{
+    bool last = (--shared->refs == 0);
+    shared->lock.Unlock();
+    if (last) {
+#if defined(QCC_OS_GROUP_POSIX)
+        /* Callable from the key's own destructor, which is where the last magazine usually goes */
+        if (shared->magazineKeyValid) {
+            pthread_key_delete(shared->magazineKey);
+        }
+#endif
+        delete shared;
+    }
+}
+
+void PacketPool::ReleaseMagazine(void* arg)
+{
+    /* Called on thread exit to hand the thread's free packets back to the shared free list */
+    Magazine* m = reinterpret_cast<Magazine*>(arg);
+    Shared* shared = m->shared;
+    shared->lock.Lock();
+    PacketPool* pool = shared->pool;
+    if (pool) {
+        pool->lock.Lock();
+        while (m->count) {
+            pool->PushFree(m->packets[--m->count]);
+        }
+        pool->lock.Unlock();
+    }
+    std::vector<Magazine*>::iterator it = std::find(shared->magazines.begin(), shared->magazines.end(), m);
+    if (it != shared->magazines.end()) {
+        shared->magazines.erase(it);
+    }
+    delete m;
+    ReleaseShared(shared);
+}
+
+void PacketPool::PushFree(Packet* p)
+{
+    if ((freeList.size() >= highWaterMark) || ((freeList.size() * 2) > static_cast<size_t>(usedCount))) {
+        IncrementAndFetch(&trims);
+        delete p;
+    } else {
+        freeList.push_back(p);
+    }
+}
+
+void PacketPool::SetHighWaterMark(size_t highWaterMark)
+{
+    lock.Lock();
+    this->highWaterMark = highWaterMark;
+    while (freeList.size() > highWaterMark) {
+        IncrementAndFetch(&trims);
+        delete freeList.back();
+        freeList.pop_back();
+    }
+    lock.Unlock();
+}
+
+void PacketPool::GetStats(Stats& stats)
+{
+    lock.Lock();
+    stats.freeCount = static_cast<uint32_t>(freeList.size());
+    lock.Unlock();
+    stats.usedCount = static_cast<uint32_t>(usedCount);
+    stats.hits = static_cast<uint32_t>(hits);
+    stats.misses = static_cast<uint32_t>(misses);
+    stats.allocs = static_cast<uint32_t>(allocs);
+    stats.trims = static_cast<uint32_t>(trims);
+}
+
 Packet* PacketPool::GetPacket() {
     Packet* p = NULL;
 #ifdef PACKET_LEAK_DEBUG
     p = new Packet(mtu);
 #else
+    IncrementAndFetch(&usedCount);
+    Magazine* m = GetMagazine();
+    if (m && m->count) {
+        IncrementAndFetch(&hits);
+        return m->packets[--m->count];
+    }
+    IncrementAndFetch(&misses);
     lock.Lock();
-    usedCount++;
     if (freeList.size() > 0) {
         p = freeList.back();
         freeList.pop_back();
+        /* Refill half the magazine so the next few requests don't need the lock */
+        while (m && (m->count < (MAGAZINE_SIZE / 2)) && (freeList.size() > 0)) {
+            m->packets[m->count++] = freeList.back();
+            freeList.pop_back();
+        }
         lock.Unlock();
     } else {
         lock.Unlock();
+        IncrementAndFetch(&allocs);
         p = new Packet(mtu);
     }
 #endif
@@ -80,16 +230,24 @@ void PacketPool::ReturnPacket(Packet* p) {
 #ifdef PACKET_LEAK_DEBUG
     delete p;
 #else
+    DecrementAndFetch(&usedCount);
+    p->Clean();
+    Magazine* m = GetMagazine();
+    if (m && (m->count < MAGAZINE_SIZE)) {
+        m->packets[m->count++] = p;
+        return;
+    }
     lock.Lock();
-    --usedCount;
-    if ((freeList.size() * 2) > usedCount) {
-        lock.Unlock();
-        delete p;
+    /* Flush half the magazine so the next few returns don't need the lock */
+    while (m && (m->count > (MAGAZINE_SIZE / 2))) {
+        PushFree(m->packets[--m->count]);
+    }
+    if (m) {
+        m->packets[m->count++] = p;
     } else {
-        p->Clean();
-        freeList.push_back(p);
-        lock.Unlock();
+        PushFree(p);
     }
+    lock.Unlock();
 #endif
 }
 
@@ -23,14 +23,50 @@
 
 #include <qcc/platform.h>
 
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
 #include <vector>
 
+#include <qcc/Mutex.h>
+
 #include "Packet.h"
 
 namespace ajn {
 
+/**
+ * PacketPool recycles Packets. Each thread keeps a small magazine of free packets that it
+ * can get and return packets from without locking. Magazines are refilled from and flushed
+ * to a shared free list in batches. The shared free list is trimmed back to the heap when it
+ * grows past the high water mark or past half the number of packets in use.
+ *
+ * A thread's magazine is released when the thread exits, which may be after the pool is gone or
+ * while it is being destroyed. Magazines therefore refer to a reference counted record of the pool
+ * that lives until the pool and every magazine have let go of it. Destroying the pool frees the
+ * packets in all magazines; the magazines themselves are freed as their threads exit.
+ */
 class PacketPool {
   public:
+
+    /** Number of free packets held by each thread's magazine */
+    static const size_t MAGAZINE_SIZE = 16;
+
+    /** Default for the maximum number of packets held on the shared free list */
+    static const size_t DEFAULT_HIGH_WATER_MARK = 1024;
+
+    /**
+     * Pool counters. Counters are maintained without locks and may wrap.
+     */
+    struct Stats {
+        uint32_t usedCount;   /**< Number of packets currently in use */
+        uint32_t freeCount;   /**< Number of packets on the shared free list (excludes magazines) */
+        uint32_t hits;        /**< GetPacket() calls satisfied from the calling thread's magazine */
+        uint32_t misses;      /**< GetPacket() calls that had to go to the shared free list or the heap */
+        uint32_t allocs;      /**< Packets allocated from the heap */
+        uint32_t trims;       /**< Free packets returned to the heap */
+    };
+
     PacketPool();
 
     QStatus Start(size_t mtu);
@@ -45,11 +81,66 @@ class PacketPool {
 
     uint32_t GetMTU() const { return mtu; }
 
+    /**
+     * Set the maximum number of free packets held on the shared free list.
+     *
+     * @param highWaterMark   Maximum number of free packets.
+     */
+    void SetHighWaterMark(size_t highWaterMark);
+
+    /**
+     * Get the pool counters.
+     *
+     * @param stats   [OUT] The counters.
+     */
+    void GetStats(Stats& stats);
+
   private:
+
+    struct Shared;
+
+    struct Magazine {
+        Shared* shared;
+        size_t count;
+        Packet* packets[MAGAZINE_SIZE];
+    };
+
+    /** The part of the pool the magazines use, outlives the pool while any magazine exists */
+    struct Shared {
+        qcc::Mutex lock;                   /**< Protects the members below and the packets in the magazines on release */
+        PacketPool* pool;                  /**< The pool, NULL once it has been destroyed */
+        std::vector<Magazine*> magazines;  /**< Magazines of threads that have not exited */
+        size_t refs;                       /**< One for the pool and one per magazine */
+#if defined(QCC_OS_GROUP_POSIX)
+        pthread_key_t magazineKey;
+        bool magazineKeyValid;
+#endif
+    };
+
+    /** Drop a reference to shared, which must be locked, and free it if it was the last */
+    static void ReleaseShared(Shared* shared);
+
+    /* Copy constructor and assignment are not allowed */
+    PacketPool(const PacketPool& other);
+    PacketPool& operator=(const PacketPool& other);
+
+    Magazine* GetMagazine();
+
+    static void ReleaseMagazine(void* arg);
+
+    /* Push a free packet onto the shared free list or delete it, must be called with lock held */
+    void PushFree(Packet* p);
+
     size_t mtu;
     qcc::Mutex lock;
     std::vector<Packet*> freeList;
-    size_t usedCount;
+    Shared* shared;
+    size_t highWaterMark;
+    volatile int32_t usedCount;
+    volatile int32_t hits;
+    volatile int32_t misses;
+    volatile int32_t allocs;
+    volatile int32_t trims;
 };
 
 }
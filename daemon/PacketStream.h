@@ -64,6 +64,33 @@ class PacketSource {
      */
     virtual QStatus PullPacketBytes(void* buf, size_t reqBytes, size_t& actualBytes, PacketDest& sender, uint32_t timeout = qcc::Event::WAIT_FOREVER) = 0;
 
+    /**
+     * Pull up to numPackets packets from the source at once.
+     * The default implementation pulls a single packet with PullPacketBytes().
+     *
+     * @param bufs         Buffers to store the pulled packets, one per packet.
+     * @param reqBytes     Size of each buffer.
+     * @param actualBytes  [OUT] Number of bytes stored in each buffer.
+     * @param senders      [OUT] Sender of each packet.
+     * @param numPackets   Number of buffers.
+     * @param numPulled    [OUT] Number of packets pulled.
+     * @param timeout      Time to wait for the first packet.
+     * @return   ER_OK if at least one packet was pulled. Otherwise an error.
+     */
+    virtual QStatus PullPacketBatch(void* const* bufs, size_t reqBytes, size_t* actualBytes, PacketDest* senders,
+                                    size_t numPackets, size_t& numPulled, uint32_t timeout = qcc::Event::WAIT_FOREVER)
+    {
+        numPulled = 0;
+        QStatus status = ER_OK;
+        if (numPackets > 0) {
+            status = PullPacketBytes(bufs[0], reqBytes, actualBytes[0], senders[0], timeout);
+            if (status == ER_OK) {
+                numPulled = 1;
+            }
+        }
+        return status;
+    }
+
     /**
      * Get the Event indicating that data is available when signaled.
      *
@@ -77,6 +104,15 @@ class PacketSource {
      * @return MTU of PacketSource
      */
     virtual size_t GetSourceMTU() = 0;
+
+    /**
+     * Determine if the PacketSource guarantees the integrity of the packets it delivers
+     * (for example because they are authenticated by DTLS). Packets from such a source do
+     * not need to be protected by a CRC.
+     *
+     * @return true if the source guarantees packet integrity.
+     */
+    virtual bool HasIntegrity() const { return false; }
 };
 
 /**
@@ -98,6 +134,30 @@ class PacketSink {
      */
     virtual QStatus PushPacketBytes(const void* buf, size_t numBytes, PacketDest& dest) = 0;
 
+    /**
+     * Push several packets to the same destination at once.
+     * The default implementation pushes them one at a time with PushPacketBytes().
+     *
+     * @param bufs         Packets to push.
+     * @param numBytes     Size of each packet. (Each must be less that or equal to MTU of PacketSink.)
+     * @param numPackets   Number of packets.
+     * @param dest         Destination for the packets.
+     * @param numPushed    [OUT] Number of packets pushed, the packets are pushed in order.
+     * @return   ER_OK if all packets were pushed. Otherwise the error that stopped the push.
+     */
+    virtual QStatus PushPacketBatch(const void* const* bufs, const size_t* numBytes, size_t numPackets, PacketDest& dest, size_t& numPushed)
+    {
+        QStatus status = ER_OK;
+        numPushed = 0;
+        while ((status == ER_OK) && (numPushed < numPackets)) {
+            status = PushPacketBytes(bufs[numPushed], numBytes[numPushed], dest);
+            if (status == ER_OK) {
+                ++numPushed;
+            }
+        }
+        return status;
+    }
+
     /**
      * Get the Event that indicates when data can be pushed to sink.
      *
@@ -18,19 +18,111 @@
  *    See the License for the specific language governing permissions and
  *    limitations under the License.
  ******************************************************************************/
+#include <map>
+
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+
 #include "PermissionMgr.h"
 #include <alljoyn/AllJoynStd.h>
 #include "RemoteEndpoint.h"
 #include <DaemonConfig.h>
 #define QCC_MODULE "PERMISSION_MGR"
 
+using namespace std;
+using namespace qcc;
+
 namespace ajn {
 
-PermissionMgr::DaemonBusCallPolicy PermissionMgr::GetDaemonBusCallPolicy(BusEndpoint sender)
+/*
+ * Permission decisions only depend on the endpoint and the permission policy so they are cached
+ * per endpoint until the endpoint goes away or the policy changes.
+ */
+struct PermissionCacheEntry {
+    bool hasPolicy;                                /**< true if policy is valid */
+    PermissionMgr::DaemonBusCallPolicy policy;     /**< Cached daemon bus call policy */
+    TransportMask checkedTransports;               /**< Transports that have been checked */
+    TransportMask allowedTransports;               /**< Checked transports the endpoint may use */
+
+    PermissionCacheEntry() : hasPolicy(false), policy(PermissionMgr::STDBUSCALL_ALLOW_ACCESS_SERVICE_ANY), checkedTransports(0), allowedTransports(0) { }
+};
+
+class PermissionCache {
+  public:
+    PermissionCache() : restrictLoaded(false), restrictUntrusted(true) { }
+
+    Mutex lock;
+    map<String, PermissionCacheEntry> entries;   /**< Cached decisions indexed by endpoint unique name */
+    bool restrictLoaded;                         /**< true if restrictUntrusted has been read from the config */
+    bool restrictUntrusted;                      /**< Value of property@restrict_untrusted_clients */
+};
+
+static PermissionCache& GetPermissionCache()
+{
+    static PermissionCache cache;
+    return cache;
+}
+
+void PermissionMgr::ResetPermissionCache()
 {
-    static bool enableRestrict = (DaemonConfig::Access())->Get("property@restrict_untrusted_clients", "true") == "true";
+    PermissionCache& cache = GetPermissionCache();
+    cache.lock.Lock(MUTEX_CONTEXT);
+    cache.entries.clear();
+    cache.restrictLoaded = false;
+    cache.lock.Unlock(MUTEX_CONTEXT);
+}
 
+bool PermissionMgr::GetCachedTransports(BusEndpoint& endpoint, TransportMask transports, TransportMask& allowed)
+{
+    bool found = false;
+    PermissionCache& cache = GetPermissionCache();
+    cache.lock.Lock(MUTEX_CONTEXT);
+    map<String, PermissionCacheEntry>::const_iterator it = cache.entries.find(endpoint->GetUniqueName());
+    if ((it != cache.entries.end()) && ((it->second.checkedTransports & transports) == transports)) {
+        allowed = it->second.allowedTransports & transports;
+        found = true;
+    }
+    cache.lock.Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
+void PermissionMgr::CacheTransports(BusEndpoint& endpoint, TransportMask checked, TransportMask allowed)
+{
+    PermissionCache& cache = GetPermissionCache();
+    cache.lock.Lock(MUTEX_CONTEXT);
+    PermissionCacheEntry& entry = cache.entries[endpoint->GetUniqueName()];
+    entry.checkedTransports |= checked;
+    entry.allowedTransports = (entry.allowedTransports & ~checked) | (allowed & checked);
+    cache.lock.Unlock(MUTEX_CONTEXT);
+}
+
+void PermissionMgr::RemoveCachedDecisions(BusEndpoint& endpoint)
+{
+    PermissionCache& cache = GetPermissionCache();
+    cache.lock.Lock(MUTEX_CONTEXT);
+    cache.entries.erase(endpoint->GetUniqueName());
+    cache.lock.Unlock(MUTEX_CONTEXT);
+}
+
+PermissionMgr::DaemonBusCallPolicy PermissionMgr::GetDaemonBusCallPolicy(BusEndpoint sender)
+{
     QCC_DbgTrace(("PermissionMgr::GetDaemonBusCallPolicy(send=%s)", sender->GetUniqueName().c_str()));
+
+    PermissionCache& cache = GetPermissionCache();
+    cache.lock.Lock(MUTEX_CONTEXT);
+    if (!cache.restrictLoaded) {
+        cache.restrictUntrusted = (DaemonConfig::Access())->Get("property@restrict_untrusted_clients", "true") == "true";
+        cache.restrictLoaded = true;
+    }
+    bool enableRestrict = cache.restrictUntrusted;
+    map<String, PermissionCacheEntry>::const_iterator it = cache.entries.find(sender->GetUniqueName());
+    if ((it != cache.entries.end()) && it->second.hasPolicy) {
+        DaemonBusCallPolicy cached = it->second.policy;
+        cache.lock.Unlock(MUTEX_CONTEXT);
+        return cached;
+    }
+    cache.lock.Unlock(MUTEX_CONTEXT);
+
     DaemonBusCallPolicy policy = STDBUSCALL_ALLOW_ACCESS_SERVICE_ANY;
     if (enableRestrict) {
         if (sender->GetEndpointType() == ENDPOINT_TYPE_NULL || sender->GetEndpointType() == ENDPOINT_TYPE_LOCAL) {
@@ -38,7 +130,7 @@ PermissionMgr::DaemonBusCallPolicy PermissionMgr::GetDaemonBusCallPolicy(BusEndp
         } else if (sender->GetEndpointType() == ENDPOINT_TYPE_REMOTE) {
             RemoteEndpoint rEndpoint = RemoteEndpoint::cast(sender);
             QCC_DbgPrintf(("This is a RemoteEndpoint. ConnSpec = %s", rEndpoint->GetConnectSpec().c_str()));
-            if ((rEndpoint->GetConnectSpec() == "unix") || (rEndpoint->GetConnectSpec() == "localhost")) {
+            if ((rEndpoint->GetConnectSpec() == "unix") || (rEndpoint->GetConnectSpec() == "localhost") || (rEndpoint->GetConnectSpec() == "shm")) {
                 policy = STDBUSCALL_ALLOW_ACCESS_SERVICE_ANY;
             } else if (rEndpoint->GetConnectSpec() == "tcp") {
                 if (!rEndpoint->IsTrusted()) {
@@ -58,6 +150,15 @@ PermissionMgr::DaemonBusCallPolicy PermissionMgr::GetDaemonBusCallPolicy(BusEndp
             QCC_LogError(ER_FAIL, ("Unexpected endponit type(%d)", sender->GetEndpointType()));
         }
     }
+
+    /* Endpoints that are gone or have no unique name yet are not cached */
+    if (sender->IsValid() && !sender->GetUniqueName().empty()) {
+        cache.lock.Lock(MUTEX_CONTEXT);
+        PermissionCacheEntry& entry = cache.entries[sender->GetUniqueName()];
+        entry.policy = policy;
+        entry.hasPolicy = true;
+        cache.lock.Unlock(MUTEX_CONTEXT);
+    }
     return policy;
 }
 
@@ -69,6 +69,35 @@ class PermissionMgr {
      */
     static DaemonBusCallPolicy GetDaemonBusCallPolicy(BusEndpoint sender);
 
+    /**
+     * Forget the permission decisions cached for all endpoints. This must be called whenever the
+     * permission policy changes, for example when the daemon configuration is reloaded.
+     */
+    static void ResetPermissionCache();
+
+    /**
+     * Look up the cached transport permissions of an endpoint.
+     * @param   endpoint    The endpoint.
+     * @param   transports  The transports to look up.
+     * @param   allowed     [OUT] The subset of transports the endpoint may use.
+     * @return  true if a decision is cached for each of the transports.
+     */
+    static bool GetCachedTransports(BusEndpoint& endpoint, TransportMask transports, TransportMask& allowed);
+
+    /**
+     * Cache the transport permissions of an endpoint.
+     * @param   endpoint    The endpoint.
+     * @param   checked     The transports that were checked.
+     * @param   allowed     The subset of the checked transports the endpoint may use.
+     */
+    static void CacheTransports(BusEndpoint& endpoint, TransportMask checked, TransportMask allowed);
+
+    /**
+     * Remove the decisions cached for an endpoint.
+     * @param   endpoint    The endpoint.
+     */
+    static void RemoveCachedDecisions(BusEndpoint& endpoint);
+
 };
 
 } // namespace ajn
@@ -0,0 +1,249 @@
+/**
+ * @file
+ * RawRelay copies the bytes of a raw session between two sockets inside the kernel.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#if defined(QCC_OS_LINUX)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+#include <qcc/Debug.h>
+#include <qcc/Socket.h>
+#include <qcc/String.h>
+
+#include "RawRelay.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+
+namespace ajn {
+
+#if defined(QCC_OS_LINUX) && defined(SPLICE_F_MOVE)
+
+/*
+ * One direction of the relay. Bytes are spliced from the source socket into the pipe and from
+ * the pipe into the sink socket; "pending" counts the bytes sitting in the pipe between the two.
+ */
+struct RelayDirection {
+    int src;
+    int sink;
+    int pipeFds[2];
+    size_t pending;
+    bool eof;
+};
+
+struct RelayState {
+    qcc::String name;
+    size_t chunkSize;
+    int fds[2];
+    RelayDirection dir[2];
+};
+
+static void CloseRelay(RelayState* state)
+{
+    for (size_t i = 0; i < 2; ++i) {
+        close(state->dir[i].pipeFds[0]);
+        close(state->dir[i].pipeFds[1]);
+        qcc::Close(state->fds[i]);
+    }
+    delete state;
+}
+
+/*
+ * Move what we can in one direction. Both sockets are non-blocking so a slow receiver on one
+ * side never stalls the other direction. Returns false if the relay must be torn down.
+ */
+static bool Pump(RelayState* state, RelayDirection& d, short srcEvents, short sinkEvents)
+{
+    if (!d.eof && (d.pending == 0) && (srcEvents & (POLLIN | POLLHUP | POLLERR))) {
+        ssize_t n = splice(d.src, NULL, d.pipeFds[1], NULL, state->chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            d.pending = n;
+        } else if (n == 0) {
+            d.eof = true;
+        } else if ((errno != EAGAIN) && (errno != EINTR)) {
+            QCC_DbgPrintf(("RawRelay %s: splice from %d failed: %s", state->name.c_str(), d.src, strerror(errno)));
+            return false;
+        }
+    }
+    if ((d.pending > 0) && (sinkEvents & (POLLOUT | POLLHUP | POLLERR))) {
+        ssize_t n = splice(d.pipeFds[0], NULL, d.sink, NULL, d.pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            d.pending -= n;
+        } else if ((n < 0) && (errno != EAGAIN) && (errno != EINTR)) {
+            QCC_DbgPrintf(("RawRelay %s: splice to %d failed: %s", state->name.c_str(), d.sink, strerror(errno)));
+            return false;
+        }
+    }
+    /* Pass the half-close on once everything before it has been delivered */
+    if (d.eof && (d.pending == 0) && (d.src != -1)) {
+        shutdown(d.sink, SHUT_WR);
+        d.src = -1;
+    }
+    return true;
+}
+
+static void* RelayRun(void* arg)
+{
+    RelayState* state = reinterpret_cast<RelayState*>(arg);
+
+    /* A peer that goes away mid-write must show up as EPIPE, not take the daemon down */
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    QCC_DbgPrintf(("RawRelay %s: relaying between %d and %d", state->name.c_str(), state->fds[0], state->fds[1]));
+
+    while ((state->dir[0].src != -1) || (state->dir[1].src != -1) || state->dir[0].pending || state->dir[1].pending) {
+        struct pollfd pfds[2];
+        for (size_t i = 0; i < 2; ++i) {
+            RelayDirection& in = state->dir[i];
+            RelayDirection& out = state->dir[1 - i];
+            pfds[i].fd = state->fds[i];
+            pfds[i].events = 0;
+            pfds[i].revents = 0;
+            if ((in.src != -1) && (in.pending == 0)) {
+                pfds[i].events |= POLLIN;
+            }
+            if (out.pending > 0) {
+                pfds[i].events |= POLLOUT;
+            }
+        }
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            QCC_LogError(ER_OS_ERROR, ("RawRelay %s: poll failed: %s", state->name.c_str(), strerror(errno)));
+            break;
+        }
+        if (!Pump(state, state->dir[0], pfds[0].revents, pfds[1].revents) ||
+            !Pump(state, state->dir[1], pfds[1].revents, pfds[0].revents)) {
+            break;
+        }
+    }
+
+    QCC_DbgPrintf(("RawRelay %s: exiting", state->name.c_str()));
+    CloseRelay(state);
+    return NULL;
+}
+
+bool RawRelay::IsSupported()
+{
+    return true;
+}
+
+QStatus RawRelay::Start(SocketFd fd1, SocketFd fd2, const qcc::String& name, size_t chunkSize)
+{
+    RelayState* state = new RelayState;
+    state->name = name;
+    state->chunkSize = chunkSize ? chunkSize : DEFAULT_CHUNK_SIZE;
+    state->fds[0] = fd1;
+    state->fds[1] = fd2;
+    for (size_t i = 0; i < 2; ++i) {
+        RelayDirection& d = state->dir[i];
+        d.src = state->fds[i];
+        d.sink = state->fds[1 - i];
+        d.pending = 0;
+        d.eof = false;
+        d.pipeFds[0] = d.pipeFds[1] = -1;
+    }
+
+    QStatus status = ER_OK;
+    for (size_t i = 0; (status == ER_OK) && (i < 2); ++i) {
+        if (pipe2(state->dir[i].pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            status = ER_OS_ERROR;
+            QCC_LogError(status, ("RawRelay::Start(): pipe2 failed: %s", strerror(errno)));
+        } else {
+#if defined(F_SETPIPE_SZ)
+            /* A pipe per direction only ever holds one chunk, sizing it to match saves a wakeup per chunk */
+            fcntl(state->dir[i].pipeFds[0], F_SETPIPE_SZ, (int)state->chunkSize);
+#endif
+        }
+    }
+
+    int flags[2] = { -1, -1 };
+    if (status == ER_OK) {
+        for (size_t i = 0; i < 2; ++i) {
+            flags[i] = fcntl(state->fds[i], F_GETFL);
+            if ((flags[i] == -1) || (fcntl(state->fds[i], F_SETFL, flags[i] | O_NONBLOCK) == -1)) {
+                status = ER_OS_ERROR;
+                QCC_LogError(status, ("RawRelay::Start(): fcntl on %d failed: %s", state->fds[i], strerror(errno)));
+                break;
+            }
+        }
+    }
+
+    if (status == ER_OK) {
+        pthread_attr_t attr;
+        pthread_t tid;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int ret = pthread_create(&tid, &attr, RelayRun, state);
+        pthread_attr_destroy(&attr);
+        if (ret != 0) {
+            status = ER_OS_ERROR;
+            QCC_LogError(status, ("RawRelay::Start(): pthread_create failed: %s", strerror(ret)));
+        }
+    }
+
+    if (status != ER_OK) {
+        /* The caller keeps the sockets so put them back the way they were */
+        for (size_t i = 0; i < 2; ++i) {
+            if (flags[i] != -1) {
+                fcntl(state->fds[i], F_SETFL, flags[i]);
+            }
+            if (state->dir[i].pipeFds[0] != -1) {
+                close(state->dir[i].pipeFds[0]);
+                close(state->dir[i].pipeFds[1]);
+            }
+        }
+        delete state;
+    }
+    return status;
+}
+
+#else
+
+bool RawRelay::IsSupported()
+{
+    return false;
+}
+
+QStatus RawRelay::Start(SocketFd fd1, SocketFd fd2, const qcc::String& name, size_t chunkSize)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+#endif
+
+} // namespace ajn
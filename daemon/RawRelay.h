@@ -0,0 +1,80 @@
+#ifndef _ALLJOYN_RAWRELAY_H
+#define _ALLJOYN_RAWRELAY_H
+/**
+ * @file
+ * RawRelay copies the bytes of a raw session between two sockets inside the kernel.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include RawRelay.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/Socket.h>
+#include <qcc/String.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * RawRelay joins two connected stream sockets so that whatever is read from one is written to
+ * the other, in both directions, until both sides have closed. On Linux the bytes are moved with
+ * splice() through a pipe per direction so they never enter user space. Each relay runs on its
+ * own detached thread and closes both sockets when it exits.
+ *
+ * Where splice() is not available Start() returns ER_NOT_IMPLEMENTED and leaves the sockets
+ * untouched so the caller can fall back to a qcc::StreamPump.
+ */
+class RawRelay {
+  public:
+
+    /**
+     * Default number of bytes moved by one splice() call.
+     */
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * Returns true if kernel relaying is supported on this platform.
+     */
+    static bool IsSupported();
+
+    /**
+     * Start relaying between two sockets. On success the relay owns both sockets; on failure
+     * neither socket has been modified or closed.
+     *
+     * @param fd1        One end of the relay.
+     * @param fd2        The other end of the relay.
+     * @param name       Name used when logging about the relay.
+     * @param chunkSize  Maximum number of bytes moved by one splice() call.
+     *
+     * @return
+     *      - ER_OK if the relay thread was started.
+     *      - ER_NOT_IMPLEMENTED if kernel relaying is not supported on this platform.
+     *      - ER_OS_ERROR if the pipes or the thread could not be created.
+     */
+    static QStatus Start(qcc::SocketFd fd1, qcc::SocketFd fd2, const qcc::String& name, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+  private:
+    RawRelay();
+};
+
+} // namespace ajn
+
+#endif // _ALLJOYN_RAWRELAY_H
@@ -0,0 +1,142 @@
+/**
+ * @file
+ * RuleDigest is a compact summary of the signals a daemon's clients have match rules for.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <algorithm>
+
+#include <qcc/String.h>
+
+#include <alljoyn/MsgArg.h>
+
+#include "RuleDigest.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+/*
+ * FNV-1a run with two offset bases, the NUM_HASHES bit positions of a key are generated from the
+ * two hashes by double hashing.
+ */
+static const uint32_t FNV_BASIS = 2166136261U;
+static const uint32_t ALT_BASIS = 0x5BD1E995U;
+
+static uint32_t Hash(const qcc::String& key, uint32_t basis)
+{
+    uint32_t h = basis;
+    const char* str = key.c_str();
+    for (size_t i = 0; i < key.size(); ++i) {
+        h ^= static_cast<uint8_t>(str[i]);
+        h *= 16777619;
+    }
+    return h;
+}
+
+void RuleDigest::Clear()
+{
+    fill(bits.begin(), bits.end(), 0);
+    matchAll = false;
+}
+
+void RuleDigest::AddKey(const qcc::String& key)
+{
+    uint32_t h1 = Hash(key, FNV_BASIS);
+    uint32_t h2 = Hash(key, ALT_BASIS) | 1;
+    for (size_t i = 0; i < NUM_HASHES; ++i) {
+        uint32_t bit = (h1 + i * h2) % NUM_BITS;
+        bits[bit >> 3] |= (1 << (bit & 7));
+    }
+}
+
+bool RuleDigest::HasKey(const qcc::String& key) const
+{
+    uint32_t h1 = Hash(key, FNV_BASIS);
+    uint32_t h2 = Hash(key, ALT_BASIS) | 1;
+    for (size_t i = 0; i < NUM_HASHES; ++i) {
+        uint32_t bit = (h1 + i * h2) % NUM_BITS;
+        if (!(bits[bit >> 3] & (1 << (bit & 7)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RuleDigest::Add(const qcc::String& iface, const qcc::String& member)
+{
+    if (iface.empty()) {
+        matchAll = true;
+    } else if (member.empty()) {
+        AddKey(iface);
+    } else {
+        AddKey(iface + "." + member);
+    }
+}
+
+void RuleDigest::Merge(const RuleDigest& other)
+{
+    matchAll = matchAll || other.matchAll;
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] |= other.bits[i];
+    }
+}
+
+bool RuleDigest::Matches(const char* iface, const char* member) const
+{
+    if (matchAll || !iface || !member) {
+        return true;
+    }
+    qcc::String key(iface);
+    return HasKey(key) || HasKey(key + "." + member);
+}
+
+void RuleDigest::Get(MsgArg args[2]) const
+{
+    args[0].Set("b", matchAll);
+    args[1].Set("ay", bits.size(), &bits[0]);
+}
+
+QStatus RuleDigest::Set(const MsgArg args[2])
+{
+    bool all;
+    size_t numBytes;
+    uint8_t* bytes;
+    QStatus status = args[0].Get("b", &all);
+    if (status == ER_OK) {
+        status = args[1].Get("ay", &numBytes, &bytes);
+    }
+    if (status == ER_OK) {
+        matchAll = all || (numBytes != bits.size());
+        if (numBytes == bits.size()) {
+            copy(bytes, bytes + numBytes, bits.begin());
+        } else {
+            fill(bits.begin(), bits.end(), 0);
+        }
+    }
+    return status;
+}
+
+}
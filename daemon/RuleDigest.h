@@ -0,0 +1,131 @@
+/**
+ * @file
+ * RuleDigest is a compact summary of the signals a daemon's clients have match rules for.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_RULEDIGEST_H
+#define _ALLJOYN_RULEDIGEST_H
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/String.h>
+
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * A Bloom filter over the interfaces, and interface and member pairs, named by match rules.
+ * Daemons send each other the digest of the rules behind them so a global broadcast signal is
+ * only forwarded over a bus-to-bus link if someone on the far side may want it. A digest can
+ * report false matches but never misses one. Rules that do not name an interface match every
+ * signal so they make the digest match everything.
+ */
+class RuleDigest {
+  public:
+
+    /**
+     * Number of bits in the filter.
+     */
+    static const size_t NUM_BITS = 1024;
+
+    /**
+     * Number of bits set for each key.
+     */
+    static const size_t NUM_HASHES = 3;
+
+    /**
+     * Create a digest that matches nothing.
+     */
+    RuleDigest() : bits(NUM_BITS / 8, 0), matchAll(false) { }
+
+    /**
+     * Make the digest match nothing.
+     */
+    void Clear();
+
+    /**
+     * Make the digest match every signal.
+     */
+    void SetMatchAll() { matchAll = true; }
+
+    /**
+     * Add a rule's interface and member to the digest.
+     *
+     * @param iface   Interface named by the rule, empty matches every signal.
+     * @param member  Member named by the rule, empty matches every member of iface.
+     */
+    void Add(const qcc::String& iface, const qcc::String& member);
+
+    /**
+     * Add everything another digest matches to this one.
+     *
+     * @param other  The other digest.
+     */
+    void Merge(const RuleDigest& other);
+
+    /**
+     * Check whether a signal may be wanted.
+     *
+     * @param iface   Interface of the signal.
+     * @param member  Member of the signal.
+     *
+     * @return  false only if no rule added to the digest matches the signal.
+     */
+    bool Matches(const char* iface, const char* member) const;
+
+    /**
+     * Get the digest as the arguments of the org.alljoyn.Daemon.RuleDigest signal.
+     *
+     * @param args  [OUT] Two args, a boolean that is true if the digest matches everything and the
+     *              filter bits.
+     */
+    void Get(MsgArg args[2]) const;
+
+    /**
+     * Set the digest from the arguments of an org.alljoyn.Daemon.RuleDigest signal. A filter of
+     * an unexpected size makes the digest match everything.
+     *
+     * @param args  The two signal arguments.
+     *
+     * @return  ER_OK if the arguments have the right types.
+     */
+    QStatus Set(const MsgArg args[2]);
+
+    bool operator==(const RuleDigest& other) const { return (matchAll == other.matchAll) && (bits == other.bits); }
+    bool operator!=(const RuleDigest& other) const { return !(*this == other); }
+
+  private:
+
+    /**
+     * Set or test the bits of a key.
+     */
+    void AddKey(const qcc::String& key);
+    bool HasKey(const qcc::String& key) const;
+
+    std::vector<uint8_t> bits;   /**< The filter */
+    bool matchAll;               /**< True if the digest matches every signal */
+};
+
+}
+
+#endif
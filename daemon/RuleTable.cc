@@ -21,12 +21,17 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 
 #include "RuleTable.h"
 
 #include <qcc/Debug.h>
 #include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
 #include <alljoyn/Message.h>
 
 #define QCC_MODULE "ALLJOYN"
@@ -91,9 +96,19 @@ Rule::Rule(const char* ruleSpec, QStatus* outStatus) : type(MESSAGE_INVALID), se
         } else if (0 == strncmp("sessionless", pos, 11)) {
             sessionless = ((begQuotePos[0] == 't') || (begQuotePos[0] == 'T')) ? SESSIONLESS_TRUE : SESSIONLESS_FALSE;
         } else if (0 == strncmp("arg", pos, 3)) {
-            status = ER_NOT_IMPLEMENTED;
-            QCC_LogError(status, ("arg keys are not supported in ruleSpec \"%s\"", ruleSpec));
-            break;
+            qcc::String key(pos, eqPos - 1 - pos);
+            qcc::String value(begQuotePos, endQuotePos - begQuotePos);
+            char* numEnd = NULL;
+            unsigned long argN = ((key.size() > 3) && isdigit(key[3])) ? strtoul(key.c_str() + 3, &numEnd, 10) : MAX_ARG_INDEX + 1;
+            if (key == "arg0namespace") {
+                arg0namespace = value;
+            } else if ((argN <= MAX_ARG_INDEX) && (*numEnd == '\0')) {
+                args[static_cast<uint32_t>(argN)] = value;
+            } else {
+                status = ER_NOT_IMPLEMENTED;
+                QCC_LogError(status, ("Unsupported arg key in ruleSpec \"%s\"", ruleSpec));
+                break;
+            }
         } else {
             status = ER_FAIL;
             QCC_LogError(status, ("Invalid key in ruleSpec \"%s\"", ruleSpec));
@@ -101,12 +116,63 @@ Rule::Rule(const char* ruleSpec, QStatus* outStatus) : type(MESSAGE_INVALID), se
         }
         pos = endPos + 1;
     }
+    FindAtoms();
     if (outStatus) {
         *outStatus = status;
     }
 }
 
-bool Rule::IsMatch(const Message& msg)
+void Rule::FindAtoms()
+{
+    /* Interning would let any client grow the atom table, which is never shrunk, with AddMatch */
+    ifaceAtom = AtomTable::Find(iface.c_str());
+    memberAtom = AtomTable::Find(member.c_str());
+    pathAtom = AtomTable::Find(path.c_str());
+}
+
+/*
+ * Match a rule field against a header field. A rule string without an atom is compared as a
+ * string since the header field may have been interned after the rule was added.
+ */
+static bool FieldMatches(Atom atom, const qcc::String& str, const HeaderFields& hdrFields, AllJoynFieldType fieldId, const char* value)
+{
+    if (atom == ATOM_NONE) {
+        return true;
+    }
+    if (atom == ATOM_UNKNOWN) {
+        return strcmp(str.c_str(), value) == 0;
+    }
+    return atom == AtomTable::GetHeaderAtom(hdrFields, fieldId);
+}
+
+const qcc::String* RuleArgs::Get(uint32_t argN)
+{
+    if (!loaded) {
+        loaded = true;
+        /*
+         * The message is shared with the endpoints it is being routed to and unmarshaling is not
+         * thread-safe so the arguments are taken from a copy. The daemon holds no keys for
+         * encrypted bodies.
+         */
+        if (!msg->IsEncrypted() && (msg->GetSignature()[0] != '\0')) {
+            Message clone(msg, true);
+            if (clone->UnmarshalArgs("*") == ER_OK) {
+                size_t numArgs;
+                const MsgArg* argList;
+                clone->GetArgs(numArgs, argList);
+                for (size_t i = 0; i < numArgs; ++i) {
+                    if (argList[i].typeId == ALLJOYN_STRING) {
+                        strs[i] = qcc::String(argList[i].v_string.str, argList[i].v_string.len);
+                    }
+                }
+            }
+        }
+    }
+    std::map<uint32_t, qcc::String>::const_iterator it = strs.find(argN);
+    return (it == strs.end()) ? NULL : &it->second;
+}
+
+bool Rule::IsMatch(const Message& msg, RuleArgs* msgArgs)
 {
     /* The fields of a rule (if specified) are logically anded together */
     if ((type != MESSAGE_INVALID) && (type != msg->GetType())) {
@@ -115,13 +181,14 @@ bool Rule::IsMatch(const Message& msg)
     if (!sender.empty() && (0 != strcmp(sender.c_str(), msg->GetSender()))) {
         return false;
     }
-    if (!iface.empty() && (0 != strcmp(iface.c_str(), msg->GetInterface()))) {
+    const HeaderFields& hdrFields = msg->GetHeaderFields();
+    if (!FieldMatches(ifaceAtom, iface, hdrFields, ALLJOYN_HDR_FIELD_INTERFACE, msg->GetInterface())) {
         return false;
     }
-    if (!member.empty() && (0 != strcmp(member.c_str(), msg->GetMemberName()))) {
+    if (!FieldMatches(memberAtom, member, hdrFields, ALLJOYN_HDR_FIELD_MEMBER, msg->GetMemberName())) {
         return false;
     }
-    if (!path.empty() && (0 != strcmp(path.c_str(), msg->GetObjectPath()))) {
+    if (!FieldMatches(pathAtom, path, hdrFields, ALLJOYN_HDR_FIELD_PATH, msg->GetObjectPath())) {
         return false;
     }
     if (!destination.empty() && (0 != strcmp(destination.c_str(), msg->GetDestination()))) {
@@ -132,20 +199,228 @@ bool Rule::IsMatch(const Message& msg)
         return false;
     }
 
-    // @@ TODO Arg matches are not handled
+    /* Argument matches need the body so they are checked last */
+    if (args.empty() && arg0namespace.empty()) {
+        return true;
+    }
+    RuleArgs ownArgs(msg);
+    if (!msgArgs) {
+        msgArgs = &ownArgs;
+    }
+    for (std::map<uint32_t, qcc::String>::const_iterator it = args.begin(); it != args.end(); ++it) {
+        const qcc::String* arg = msgArgs->Get(it->first);
+        if (!arg || (*arg != it->second)) {
+            return false;
+        }
+    }
+    if (!arg0namespace.empty()) {
+        /* The namespace itself or any name below it, "a.b" is in "a" but "ab" is not */
+        const qcc::String* arg = msgArgs->Get(0);
+        if (!arg || (arg->compare(0, arg0namespace.size(), arg0namespace) != 0) ||
+            ((arg->size() > arg0namespace.size()) && ((*arg)[arg0namespace.size()] != '.'))) {
+            return false;
+        }
+    }
     return true;
 }
 
 qcc::String Rule::ToString() const
 {
-    return "s:" + sender + " i:" + iface + " m:" + member + " p:" + path + " d:" + destination;
+    qcc::String str = "s:" + sender + " i:" + iface + " m:" + member + " p:" + path + " d:" + destination;
+    for (std::map<uint32_t, qcc::String>::const_iterator it = args.begin(); it != args.end(); ++it) {
+        str += " arg" + U32ToString(it->first) + ":" + it->second;
+    }
+    if (!arg0namespace.empty()) {
+        str += " arg0ns:" + arg0namespace;
+    }
+    return str;
+}
+
+qcc::String Rule::ToMatchString(bool withArgs) const
+{
+    qcc::String str;
+    switch (type) {
+    case MESSAGE_SIGNAL:      str = "type='signal'"; break;
+    case MESSAGE_METHOD_CALL: str = "type='method_call'"; break;
+    case MESSAGE_METHOD_RET:  str = "type='method_return'"; break;
+    case MESSAGE_ERROR:       str = "type='error'"; break;
+    default: break;
+    }
+    const char* keys[] = { "sender", "interface", "member", "path", "destination" };
+    const qcc::String* vals[] = { &sender, &iface, &member, &path, &destination };
+    for (size_t i = 0; i < ArraySize(keys); ++i) {
+        if (!vals[i]->empty()) {
+            if (!str.empty()) {
+                str.append(',');
+            }
+            str += qcc::String(keys[i]) + "='" + *vals[i] + "'";
+        }
+    }
+    if (sessionless != SESSIONLESS_NOT_SPECIFIED) {
+        if (!str.empty()) {
+            str.append(',');
+        }
+        str += (sessionless == SESSIONLESS_TRUE) ? "sessionless='t'" : "sessionless='f'";
+    }
+    if (withArgs) {
+        for (std::map<uint32_t, qcc::String>::const_iterator it = args.begin(); it != args.end(); ++it) {
+            if (!str.empty()) {
+                str.append(',');
+            }
+            str += "arg" + U32ToString(it->first) + "='" + it->second + "'";
+        }
+        if (!arg0namespace.empty()) {
+            if (!str.empty()) {
+                str.append(',');
+            }
+            str += "arg0namespace='" + arg0namespace + "'";
+        }
+    }
+    return str;
+}
+
+RuleTable::RuleBucket& RuleTable::GetBucket(const Rule& rule)
+{
+    if (rule.ifaceAtom == ATOM_NONE) {
+        return wildcardRules;
+    }
+    /* No message interface resolves to ATOM_UNKNOWN once it is interned so these go by name */
+    if (rule.ifaceAtom == ATOM_UNKNOWN) {
+        return unknownIfaceIndex[qcc::StringMapKey(rule.iface)];
+    }
+    InterfaceBucket& ifaceBucket = ifaceIndex[rule.ifaceAtom];
+    if ((rule.memberAtom == ATOM_NONE) || (rule.memberAtom == ATOM_UNKNOWN)) {
+        return ifaceBucket.anyMember;
+    }
+    return ifaceBucket.members[rule.memberAtom];
+}
+
+void RuleTable::UnindexRule(RuleIterator it)
+{
+    RuleBucket& bucket = GetBucket(it->second);
+    std::pair<RuleBucket::iterator, RuleBucket::iterator> range = bucket.equal_range(it->first);
+    while (range.first != range.second) {
+        if (range.first->second == it) {
+            bucket.erase(range.first);
+            break;
+        }
+        ++range.first;
+    }
+    /* Don't let empty buckets accumulate as endpoints come and go */
+    if (it->second.ifaceAtom == ATOM_UNKNOWN) {
+        if (bucket.empty()) {
+            unknownIfaceIndex.erase(qcc::StringMapKey(it->second.iface));
+        }
+    } else if (it->second.ifaceAtom != ATOM_NONE) {
+        std::map<Atom, InterfaceBucket>::iterator iit = ifaceIndex.find(it->second.ifaceAtom);
+        if ((it->second.memberAtom != ATOM_NONE) && (it->second.memberAtom != ATOM_UNKNOWN) && bucket.empty()) {
+            iit->second.members.erase(it->second.memberAtom);
+        }
+        if (iit->second.anyMember.empty() && iit->second.members.empty()) {
+            ifaceIndex.erase(iit);
+        }
+    }
+}
+
+void RuleTable::MatchBucket(RuleBucket& bucket, const Message& msg, RuleArgs& msgArgs, std::vector<BusEndpoint>& matches)
+{
+    RuleBucket::iterator it = bucket.begin();
+    while (it != bucket.end()) {
+        ++evaluations;
+        if (it->second->second.IsMatch(msg, &msgArgs)) {
+            matches.push_back(it->first);
+            /* One matching rule is enough for this endpoint */
+            it = bucket.upper_bound(it->first);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RuleTable::FindMatchingEndpoints(const Message& msg, std::vector<BusEndpoint>& matches)
+{
+    matches.clear();
+    /* Shared by all of the buckets so the body is unmarshaled at most once per message */
+    RuleArgs msgArgs(msg);
+    MatchBucket(wildcardRules, msg, msgArgs, matches);
+
+    const HeaderFields& hdrFields = msg->GetHeaderFields();
+    Atom iface = AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_INTERFACE);
+    if (iface == ATOM_NONE) {
+        /* Buckets list each endpoint once so a single bucket needs no merging */
+        return;
+    }
+    size_t fromWildcards = matches.size();
+    if (iface != ATOM_UNKNOWN) {
+        std::map<Atom, InterfaceBucket>::iterator iit = ifaceIndex.find(iface);
+        if (iit != ifaceIndex.end()) {
+            MatchBucket(iit->second.anyMember, msg, msgArgs, matches);
+            std::map<Atom, RuleBucket>::iterator mit = iit->second.members.find(AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_MEMBER));
+            if (mit != iit->second.members.end()) {
+                MatchBucket(mit->second, msg, msgArgs, matches);
+            }
+        }
+    }
+    /* The interface may have been interned since these rules were added so check them either way */
+    if (!unknownIfaceIndex.empty()) {
+        std::map<qcc::StringMapKey, RuleBucket>::iterator uit = unknownIfaceIndex.find(qcc::StringMapKey(msg->GetInterface()));
+        if (uit != unknownIfaceIndex.end()) {
+            MatchBucket(uit->second, msg, msgArgs, matches);
+        }
+    }
+    /* An endpoint may have matching rules in more than one bucket */
+    if (fromWildcards != matches.size()) {
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    }
+}
+
+void RuleTable::AddToDigest(BusEndpoint& endpoint, const Rule& rule)
+{
+    /* Only signals that arrive from other daemons are filtered by the digest */
+    if (((rule.type != MESSAGE_INVALID) && (rule.type != MESSAGE_SIGNAL)) || !endpoint->AllowRemoteMessages()) {
+        return;
+    }
+    DigestKey key(rule.iface, rule.member);
+    if (++digestKeys[key] == 1) {
+        digest.Add(key.first, key.second);
+    }
+}
+
+void RuleTable::RemoveFromDigest(BusEndpoint& endpoint, const Rule& rule)
+{
+    if (((rule.type != MESSAGE_INVALID) && (rule.type != MESSAGE_SIGNAL)) || !endpoint->AllowRemoteMessages()) {
+        return;
+    }
+    /* Bits cannot be cleared from a Bloom filter so the digest is rebuilt the next time it is needed */
+    std::map<DigestKey, uint32_t>::iterator it = digestKeys.find(DigestKey(rule.iface, rule.member));
+    if ((it != digestKeys.end()) && (--it->second == 0)) {
+        digestKeys.erase(it);
+        digestStale = true;
+    }
+}
+
+void RuleTable::GetDigest(RuleDigest& digest)
+{
+    Lock();
+    if (digestStale) {
+        this->digest.Clear();
+        for (std::map<DigestKey, uint32_t>::const_iterator it = digestKeys.begin(); it != digestKeys.end(); ++it) {
+            this->digest.Add(it->first.first, it->first.second);
+        }
+        digestStale = false;
+    }
+    digest = this->digest;
+    Unlock();
 }
 
 QStatus RuleTable::AddRule(BusEndpoint& endpoint, const Rule& rule)
 {
     QCC_DbgPrintf(("AddRule for endpoint %s\n  %s", endpoint->GetUniqueName().c_str(), rule.ToString().c_str()));
     Lock();
-    rules.insert(std::pair<BusEndpoint, Rule>(endpoint, rule));
+    RuleIterator it = rules.insert(std::pair<BusEndpoint, Rule>(endpoint, rule));
+    GetBucket(rule).insert(std::pair<BusEndpoint, RuleIterator>(endpoint, it));
+    AddToDigest(endpoint, rule);
     Unlock();
     return ER_OK;
 }
@@ -154,10 +429,11 @@ QStatus RuleTable::RemoveRule(BusEndpoint& endpoint, Rule& rule)
 {
     Lock();
 
-    //std::pair<std::multimap<BusEndpoint, Rule>::const_iterator, RuleIterator> range = rules.equal_range(endpoint);
     std::pair<RuleIterator, RuleIterator> range = rules.equal_range(endpoint);
     while (range.first != range.second) {
         if (range.first->second == rule) {
+            RemoveFromDigest(endpoint, range.first->second);
+            UnindexRule(range.first);
             rules.erase(range.first);
             break;
         }
@@ -172,6 +448,10 @@ QStatus RuleTable::RemoveAllRules(BusEndpoint& endpoint)
     Lock();
     std::pair<RuleIterator, RuleIterator> range = rules.equal_range(endpoint);
     if (range.first != rules.end()) {
+        for (RuleIterator it = range.first; it != range.second; ++it) {
+            RemoveFromDigest(endpoint, it->second);
+            UnindexRule(it);
+        }
         rules.erase(range.first, range.second);
     }
     Unlock();
@@ -27,18 +27,52 @@
 #include <qcc/platform.h>
 
 #include <map>
+#include <set>
+#include <vector>
 
 #include <qcc/String.h>
+#include <qcc/StringMapKey.h>
 #include <qcc/Mutex.h>
 
 #include <alljoyn/Message.h>
 
+#include "AtomTable.h"
 #include "BusEndpoint.h"
+#include "RuleDigest.h"
 
 #include <alljoyn/Status.h>
 
 namespace ajn {
 
+/**
+ * The string arguments of a message for comparing with argument match rules. The body is
+ * only unmarshaled when the first rule that needs it is evaluated, and only once however
+ * many argument matching rules the message is compared with.
+ */
+class RuleArgs {
+  public:
+    /**
+     * Constructor
+     *
+     * @param msg   The message whose arguments are matched.
+     */
+    RuleArgs(const Message& msg) : msg(msg), loaded(false) { }
+
+    /**
+     * Get a string argument of the message.
+     *
+     * @param argN   Index of the argument.
+     * @return  The argument or NULL if the message has no such argument, the argument is not a
+     *          string or the body cannot be read by the daemon (for example it is encrypted).
+     */
+    const qcc::String* Get(uint32_t argN);
+
+  private:
+    Message msg;                               /**< The message */
+    bool loaded;                               /**< True once strs has been filled in */
+    std::map<uint32_t, qcc::String> strs;      /**< The string arguments of msg keyed by index */
+};
+
 /**
  * Rule defines a message bus routing rule.
  */
@@ -65,17 +99,33 @@ struct Rule {
     /** true iff Rule specifies a filter for sessionless signals */
     enum {SESSIONLESS_NOT_SPECIFIED, SESSIONLESS_FALSE, SESSIONLESS_TRUE} sessionless;
 
-    /** Map of argument matches */
-    // @@ TODO
+    /**
+     * Atoms for iface, member and path (ATOM_NONE if not specified). Rules come from remote
+     * clients so the strings are only looked up, a string that has not been interned locally
+     * is ATOM_UNKNOWN and matched by string.
+     */
+    Atom ifaceAtom;
+    Atom memberAtom;
+    Atom pathAtom;
+
+    /** Values that the string arguments argN must equal keyed by N */
+    std::map<uint32_t, qcc::String> args;
+
+    /** Bus name namespace that string argument 0 must be in or empty for any */
+    qcc::String arg0namespace;
+
+    /** Highest N accepted for an argN key */
+    static const uint32_t MAX_ARG_INDEX = 63;
 
     /** Equality comparison */
     bool operator==(const Rule& o) const {
         return (type == o.type) && (sender == o.sender) && (iface == o.iface) &&
-               (member == o.member) && (path == o.path) && (destination == o.destination);
+               (member == o.member) && (path == o.path) && (destination == o.destination) &&
+               (args == o.args) && (arg0namespace == o.arg0namespace);
     }
 
     /** Constructor */
-    Rule() : type(MESSAGE_INVALID) { }
+    Rule() : type(MESSAGE_INVALID), ifaceAtom(ATOM_NONE), memberAtom(ATOM_NONE), pathAtom(ATOM_NONE) { }
 
     /**
      * Construct a rule from a rule string.
@@ -84,24 +134,43 @@ struct Rule {
      *                  This format of this string is specified in the DBUS spec.
      *                  AllJoyn has added the following additional parameters:
      *                     sessionless  - Valid values are "true" and "false"
+     *                  Of the argument keys only argN (string equality) and arg0namespace
+     *                  are supported, argNpath is rejected with ER_NOT_IMPLEMENTED.
      *
      * @param status    ER_OK if ruleStr was successfully parsed.
      */
     Rule(const char* ruleStr, QStatus* status = NULL);
 
+    /**
+     * Look up the atoms again after iface, member or path have been changed.
+     */
+    void FindAtoms();
+
     /**
      * Return true if messages matches rule.
      *
-     * @param msg   Message to compare with rule.
+     * @param msg       Message to compare with rule.
+     * @param msgArgs   The arguments of msg to share between several rules or NULL to
+     *                  unmarshal them just for this rule if it has argument matches.
      * @return  true if this rule matches the message.
      */
-    bool IsMatch(const Message& msg);
+    bool IsMatch(const Message& msg, RuleArgs* msgArgs = NULL);
 
     /**
      * String representation of a rule
      */
     qcc::String ToString() const;
 
+    /**
+     * Get the rule in the match rule syntax accepted by Rule(const char*).
+     *
+     * @param withArgs  false to leave out the argument matches. The rule that results matches
+     *                  at least the messages this rule matches and can be parsed by daemons
+     *                  that do not support argument matches.
+     * @return  The match rule string.
+     */
+    qcc::String ToMatchString(bool withArgs = true) const;
+
 };
 
 
@@ -115,6 +184,11 @@ typedef std::multimap<BusEndpoint, Rule>::iterator RuleIterator;
 class RuleTable {
   public:
 
+    /**
+     * Constructor
+     */
+    RuleTable() : evaluations(0), digestStale(false) { }
+
     /**
      * Add a rule for an endpoint.
      *
@@ -202,9 +276,71 @@ class RuleTable {
         return ret;
     }
 
+    /**
+     * Find the endpoints that have at least one rule matching a message.
+     * Only the rules indexed under the message's interface and member (plus the
+     * wildcard rules) are evaluated so the cost is proportional to the number of
+     * candidate rules rather than to the size of the rule table.
+     * Caller should obtain lock before calling this method.
+     *
+     * @param msg       Message to match against the rules.
+     * @param matches   [OUT] Endpoints that have a rule matching msg, sorted and each listed once.
+     *                  Existing entries are discarded.
+     */
+    void FindMatchingEndpoints(const Message& msg, std::vector<BusEndpoint>& matches);
+
+    /**
+     * Get the number of rules evaluated by FindMatchingEndpoints(). The count may wrap.
+     * Caller should obtain lock before calling this method.
+     *
+     * @return  The number of rule evaluations.
+     */
+    uint32_t GetEvaluations() const { return evaluations; }
+
+    /**
+     * Get the digest of the signals asked for by the rules of endpoints that accept messages from
+     * other daemons. The digest is kept up to date as rules are added and removed.
+     *
+     * @param digest   [OUT] The digest.
+     */
+    void GetDigest(RuleDigest& digest);
+
   private:
+
+    /** Interface and member of the rules counted in the digest */
+    typedef std::pair<qcc::String, qcc::String> DigestKey;
+
+    /** Count a rule that is being added to or removed from the table in the digest. Caller must hold lock */
+    void AddToDigest(BusEndpoint& endpoint, const Rule& rule);
+    void RemoveFromDigest(BusEndpoint& endpoint, const Rule& rule);
+
+    /** Rules in an index bucket keyed by the endpoint that owns them */
+    typedef std::multimap<BusEndpoint, RuleIterator> RuleBucket;
+
+    /** Index bucket for all rules that specify a given interface */
+    struct InterfaceBucket {
+        RuleBucket anyMember;                           /**< Rules on this interface with no member specified */
+        std::map<Atom, RuleBucket> members;             /**< Rules on this interface keyed by member atom */
+    };
+
+    /** Return the index bucket for a rule (creating it if needed) */
+    RuleBucket& GetBucket(const Rule& rule);
+
+    /** Remove a rule from the index. Caller must hold lock */
+    void UnindexRule(RuleIterator it);
+
+    /** Evaluate a bucket and add matching endpoints to matches */
+    void MatchBucket(RuleBucket& bucket, const Message& msg, RuleArgs& msgArgs, std::vector<BusEndpoint>& matches);
+
     qcc::Mutex lock;                            /**< Lock protecting rule table */
     std::multimap<BusEndpoint, Rule> rules;    /**< Rule table */
+    std::map<Atom, InterfaceBucket> ifaceIndex; /**< Index of rules that specify an interface */
+    std::map<qcc::StringMapKey, RuleBucket> unknownIfaceIndex;  /**< Rules on interfaces without an atom keyed by interface name */
+    RuleBucket wildcardRules;                   /**< Rules that do not specify an interface */
+    uint32_t evaluations;                       /**< Number of rules evaluated by FindMatchingEndpoints() */
+    std::map<DigestKey, uint32_t> digestKeys;   /**< Number of rules counted in the digest for each interface and member */
+    RuleDigest digest;                          /**< Digest of digestKeys */
+    bool digestStale;                           /**< True if a key was removed from digestKeys since digest was built */
 };
 
 }
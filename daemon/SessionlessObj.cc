@@ -26,6 +26,11 @@
 
 #include "SessionlessObj.h"
 #include "BusController.h"
+#include "DaemonConfig.h"
+#include "MemoryAccounting.h"
+#include "TimerSlack.h"
+#include "TxQueue.h"
+#include "ns/IpNameService.h"
 
 #define QCC_MODULE "SESSIONLESS"
 
@@ -34,6 +39,12 @@ using namespace qcc;
 
 /** Constants */
 #define MAX_JOINSESSION_RETRIES 3
+#define SESSIONLESS_MAX_BYTES_DEFAULT (4 * 1024 * 1024)  /**< Default limit on the size of stored sessionless signals */
+#define SESSIONLESS_MAX_AGE_DEFAULT   0                  /**< Default limit on the age (ms) of stored sessionless signals */
+#define SESSIONLESS_CATCHUP_BATCH     64                 /**< Number of stored signals sent per catch-up batch */
+#define SESSIONLESS_FETCH_COALESCE_MS 250                /**< Change id bumps within this time of a fetch are fetched together */
+#define SESSIONLESS_MULTICAST_BYTES_DEFAULT 0            /**< Default limit on the size of multicast sessionless signals */
+#define SESSIONLESS_DATAGRAM_VERSION  1                  /**< First octet of a multicast sessionless signal */
 
 /**
  * Inside window calculation.
@@ -57,6 +68,17 @@ using namespace qcc;
 
 namespace ajn {
 
+/** Return true if msg matches at least one of the rules */
+static bool MatchesAnyRule(std::vector<Rule>& rules, const Message& msg)
+{
+    for (std::vector<Rule>::iterator it = rules.begin(); it != rules.end(); ++it) {
+        if (it->IsMatch(msg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /** Constants */
 #define SESSIONLESS_SESSION_PORT 100
 
@@ -74,9 +96,15 @@ SessionlessObj::SessionlessObj(Bus& bus, BusController* busController) :
     sessionlessIface(NULL),
     requestSignalsSignal(NULL),
     requestRangeSignal(NULL),
+    requestRangeMatchSignal(NULL),
     timer("sessionless"),
     messageMap(),
-    ruleCountMap(),
+    changeIdIndex(),
+    storedBytes(0),
+    maxStoredBytes(0),
+    maxStoredAge(0),
+    maxMulticastBytes(0),
+    ruleMap(),
     changeIdMap(),
     lock(),
     nextChangeId(0),
@@ -94,10 +122,37 @@ SessionlessObj::SessionlessObj(Bus& bus, BusController* busController) :
     advPrefix.append('x');
     advPrefix.append(bus.GetGlobalGUIDShortString());
     advPrefix.append(".x");
+
+    /*
+     * Bound the memory used by stored sessionless signals, for example:
+     *
+     *   <limit sessionless_bytes="4194304"/>
+     *   <limit sessionless_age="3600000"/>
+     *
+     * The oldest signals are evicted first. A value of 0 removes the limit.
+     */
+    DaemonConfig* config = DaemonConfig::Access();
+    maxStoredBytes = config->Get("limit@sessionless_bytes", SESSIONLESS_MAX_BYTES_DEFAULT);
+    maxStoredAge = config->Get("limit@sessionless_age", SESSIONLESS_MAX_AGE_DEFAULT);
+
+    /*
+     * Signals up to this size are also multicast over the name service sockets so the daemons that
+     * already follow this one get them without a session, for example:
+     *
+     *   <limit sessionless_multicast_bytes="512"/>
+     *
+     * A value of 0 disables the fast path.
+     */
+    maxMulticastBytes = config->Get("limit@sessionless_multicast_bytes", SESSIONLESS_MULTICAST_BYTES_DEFAULT);
 }
 
 SessionlessObj::~SessionlessObj()
 {
+    /* Stop receiving multicast signals */
+    if (maxMulticastBytes) {
+        IpNameService::Instance().SetDatagramCallback(NULL);
+    }
+
     /* Unbind session port */
     bus.UnbindSessionPort(sessionPort);
 
@@ -123,6 +178,7 @@ QStatus SessionlessObj::Init()
     }
     intf->AddSignal("RequestSignals", "u", NULL, 0);
     intf->AddSignal("RequestRange", "uu", NULL, 0);
+    intf->AddSignal("RequestRangeMatch", "uuas", NULL, 0);
     intf->Activate();
 
     /* Make this object implement org.alljoyn.Sessionless */
@@ -138,6 +194,8 @@ QStatus SessionlessObj::Init()
     assert(requestSignalsSignal);
     requestRangeSignal = sessionlessIntf->GetMember("RequestRange");
     assert(requestRangeSignal);
+    requestRangeMatchSignal = sessionlessIntf->GetMember("RequestRangeMatch");
+    assert(requestRangeMatchSignal);
 
     /* Register a signal handler for requestSignals */
     status = bus.RegisterSignalHandler(this,
@@ -157,6 +215,15 @@ QStatus SessionlessObj::Init()
         QCC_LogError(status, ("Failed to register RequestRange signal handler"));
     }
 
+    /* Register a signal handler for requestRangeMatch */
+    status = bus.RegisterSignalHandler(this,
+                                       static_cast<MessageReceiver::SignalHandler>(&SessionlessObj::RequestRangeMatchSignalHandler),
+                                       requestRangeMatchSignal,
+                                       NULL);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to register RequestRangeMatch signal handler"));
+    }
+
     /* Register signal handler for FoundAdvertisedName */
     /* (If we werent in the daemon, we could just use BusListener, but it doesnt work without the full BusAttachment implementation */
     const InterfaceDescription* ajIntf = bus.GetInterface(org::alljoyn::Bus::InterfaceName);
@@ -189,6 +256,12 @@ QStatus SessionlessObj::Init()
         status = timer.Start();
     }
 
+    /* Receive the signals other daemons multicast */
+    if ((status == ER_OK) && maxMulticastBytes) {
+        IpNameService::Instance().SetDatagramCallback(new CallbackImpl<SessionlessObj, void, const uint8_t*, size_t>
+                                                          (this, &SessionlessObj::DatagramReceived));
+    }
+
     /* Bind the session port and establish self as port listener */
     if (status == ER_OK) {
         status = bus.BindSessionPort(sessionPort, sessionOpts, *this);
@@ -252,9 +325,8 @@ void SessionlessObj::AddRule(const qcc::String& epName, Rule& rule)
 
     if (rule.sessionless == Rule::SESSIONLESS_TRUE) {
         lock.Lock();
-        map<String, uint32_t>::iterator it = ruleCountMap.find(epName);
-        if (it == ruleCountMap.end()) {
-            ruleCountMap.insert(pair<String, int>(epName, 1));
+        if (ruleMap.find(epName) == ruleMap.end()) {
+            ruleMap.insert(pair<String, Rule>(epName, rule));
             /*
              * Since this is the first addMatch that specifies sessionless='t'
              * from this client, we need to re-receive previous signals for
@@ -267,7 +339,7 @@ void SessionlessObj::AddRule(const qcc::String& epName, Rule& rule)
                 lock.Lock();
             }
         } else {
-            it->second++;
+            ruleMap.insert(pair<String, Rule>(epName, rule));
         }
 
         if (!isDiscoveryStarted) {
@@ -289,14 +361,16 @@ void SessionlessObj::RemoveRule(const qcc::String& epName, Rule& rule)
 
     if (rule.sessionless == Rule::SESSIONLESS_TRUE) {
         lock.Lock();
-        map<String, uint32_t>::iterator it = ruleCountMap.find(epName);
-        if (it != ruleCountMap.end()) {
-            if (--it->second == 0) {
-                ruleCountMap.erase(it);
+        multimap<String, Rule>::iterator it = ruleMap.lower_bound(epName);
+        while ((it != ruleMap.end()) && (it->first == epName)) {
+            if (it->second == rule) {
+                ruleMap.erase(it);
+                break;
             }
+            ++it;
         }
 
-        if (isDiscoveryStarted && ruleCountMap.empty()) {
+        if (isDiscoveryStarted && ruleMap.empty()) {
             bus.EnableConcurrentCallbacks();
             QStatus status = bus.CancelFindAdvertisedNameByTransport(findPrefix.c_str(), TRANSPORT_ANY & ~TRANSPORT_ICE & ~TRANSPORT_LOCAL);
             if (status != ER_OK) {
@@ -320,13 +394,11 @@ QStatus SessionlessObj::PushMessage(Message& msg)
     /* Put the message in the map and kick the worker */
     MessageMapKey key(msg->GetSender(), msg->GetInterface(), msg->GetMemberName(), msg->GetObjectPath());
     lock.Lock();
-    pair<uint32_t, Message> val(nextChangeId++, msg);
-    map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.find(key);
-    if (it == messageMap.end()) {
-        messageMap.insert(pair<MessageMapKey, pair<uint32_t, Message> >(key, val));
-    } else {
-        it->second = val;
+    StoreMessage(key, msg);
+    if (maxMulticastBytes) {
+        MulticastMessage(msg, nextChangeId - 1);
     }
+    EnforceByteLimit();
     lock.Unlock();
     uint32_t zero = 0;
     SessionlessObj* slObj = this;
@@ -382,13 +454,13 @@ QStatus SessionlessObj::CancelMessage(const qcc::String& sender, uint32_t serial
 
     lock.Lock();
     MessageMapKey key(sender.c_str(), "", "", "");
-    map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.lower_bound(key);
-    while ((it != messageMap.end()) && (sender == it->second.second->GetSender())) {
-        if (it->second.second->GetCallSerial() == serialNum) {
-            if (!it->second.second->IsExpired()) {
+    MessageMap::iterator it = messageMap.lower_bound(key);
+    while ((it != messageMap.end()) && (sender == it->second.msg->GetSender())) {
+        if (it->second.msg->GetCallSerial() == serialNum) {
+            if (!it->second.msg->IsExpired()) {
                 status = ER_OK;
             }
-            messageMap.erase(it);
+            EraseMessage(it);
             messageErased = true;
             break;
         }
@@ -478,19 +550,16 @@ void SessionlessObj::NameOwnerChanged(const String& name,
 {
     QCC_DbgTrace(("SessionlessObj::NameOwnerChanged(%s, %s, %s)", name.c_str(), oldOwner ? oldOwner->c_str() : "(null)", newOwner ? newOwner->c_str() : "(null)"));
 
-    /* Remove entries from ruleCountMap for names exiting from the bus */
+    /* Remove entries from ruleMap for names exiting from the bus */
     if (oldOwner && !newOwner) {
         lock.Lock();
-        map<String, uint32_t>::iterator it = ruleCountMap.find(name);
-        if (it != ruleCountMap.end()) {
-            ruleCountMap.erase(it);
-        }
+        ruleMap.erase(name);
 
         /* Remove stored sessionless messages sent by toldOwner */
         MessageMapKey key(oldOwner->c_str(), "", "", "");
-        map<MessageMapKey, pair<uint32_t, Message> >::iterator mit = messageMap.lower_bound(key);
-        while ((mit != messageMap.end()) && (::strcmp(oldOwner->c_str(), mit->second.second->GetSender()) == 0)) {
-            messageMap.erase(mit++);
+        MessageMap::iterator mit = messageMap.lower_bound(key);
+        while ((mit != messageMap.end()) && (::strcmp(oldOwner->c_str(), mit->second.msg->GetSender()) == 0)) {
+            EraseMessage(mit++);
         }
         /* Alert the advertiser worker if messageMap is empty */
         if (messageMap.empty()) {
@@ -512,7 +581,7 @@ void SessionlessObj::NameOwnerChanged(const String& name,
         }
 
         /* Stop discovery if nobody is looking for sessionless signals */
-        if (isDiscoveryStarted && ruleCountMap.empty()) {
+        if (isDiscoveryStarted && ruleMap.empty()) {
             QStatus status = bus.CancelFindAdvertisedNameByTransport(findPrefix.c_str(), TRANSPORT_ANY & ~TRANSPORT_ICE & ~TRANSPORT_LOCAL);
             if (status != ER_OK) {
                 QCC_LogError(status, ("CancelFindAdvertisedNameByTransport failed"));
@@ -567,7 +636,46 @@ QStatus SessionlessObj::HandleFoundAdvertisedName(const char* name, TransportMas
     map<String, ChangeIdEntry>::iterator it = changeIdMap.find(guid);
     bool updateChangeIdMap = (it == changeIdMap.end()) || IS_GREATER(uint32_t, changeId, it->second.changeId);
     if (updateChangeIdMap || catchUp) {
-        if ((it == changeIdMap.end()) || !it->second.inProgress) {
+        uint64_t now = GetTimestamp64();
+        /* Protocol version of an existing bus-to-bus connection to the advertiser, 0 if there is none */
+        uint32_t b2bVersion = catchUp ? 0 : GetHostProtocolVersion(name, 0);
+        if (!catchUp && (it != changeIdMap.end()) && !it->second.inProgress && ((now - it->second.lastFetchTs) < SESSIONLESS_FETCH_COALESCE_MS)) {
+            /* Fetched from this daemon very recently, fetch this and any further bumps together a little later */
+            it->second.advName = name;
+            it->second.transport = transport;
+            if (!it->second.fetchScheduled) {
+                it->second.fetchScheduled = true;
+                uint32_t delay = static_cast<uint32_t>(SESSIONLESS_FETCH_COALESCE_MS - (now - it->second.lastFetchTs));
+                SessionlessObj* slObj = this;
+                status = timer.AddAlarm(Alarm(delay, slObj, this));
+            }
+        } else if (b2bVersion && ((it == changeIdMap.end()) || !it->second.inProgress)) {
+            /* There is already a bus-to-bus connection to this daemon so fetch over it without joining a session */
+            uint32_t requestChangeId = (it == changeIdMap.end()) ? 0 : it->second.changeId + 1;
+            bool matchCapable = (b2bVersion >= 7);
+            std::vector<String> rules;
+            if (matchCapable) {
+                GetMatchRules("", rules);
+            }
+            if (it == changeIdMap.end()) {
+                it = changeIdMap.insert(pair<String, ChangeIdEntry>(guid, ChangeIdEntry(name, transport, numeric_limits<uint32_t>::max(), false, 0))).first;
+            }
+            uint32_t prevChangeId = it->second.changeId;
+            it->second.advName = name;
+            it->second.transport = transport;
+            it->second.changeId = changeId;
+            it->second.lastFetchTs = now;
+            lock.Unlock();
+            status = SendSignalRequest(name, 0, requestChangeId, matchCapable, rules);
+            lock.Lock();
+            if (status != ER_OK) {
+                /* Let the next advertisement retry */
+                it = changeIdMap.find(guid);
+                if ((it != changeIdMap.end()) && (it->second.changeId == changeId)) {
+                    it->second.changeId = prevChangeId;
+                }
+            }
+        } else if ((it == changeIdMap.end()) || !it->second.inProgress) {
             /* Attempt to join session with advertised name */
             SessionOpts opts = sessionOpts;
             opts.transports = transport;
@@ -575,7 +683,8 @@ QStatus SessionlessObj::HandleFoundAdvertisedName(const char* name, TransportMas
             status = bus.JoinSessionAsync(name, sessionPort, this, opts, this, reinterpret_cast<void*>(ctx));
             if (status == ER_OK) {
                 if (it == changeIdMap.end()) {
-                    changeIdMap.insert(pair<String, ChangeIdEntry>(guid, ChangeIdEntry(name, transport, numeric_limits<uint32_t>::max(), true, 0)));
+                    it = changeIdMap.insert(pair<String, ChangeIdEntry>(guid, ChangeIdEntry(name, transport, numeric_limits<uint32_t>::max(), true, 0))).first;
+                    it->second.lastFetchTs = now;
                 } else {
                     if (!catchUp) {
                         it->second.advName = name;
@@ -583,6 +692,7 @@ QStatus SessionlessObj::HandleFoundAdvertisedName(const char* name, TransportMas
                     it->second.inProgress = true;
                     it->second.retries = 0;
                     it->second.transport = transport;
+                    it->second.lastFetchTs = now;
                 }
             } else {
                 QCC_LogError(status, ("JoinSessionAsync failed"));
@@ -672,7 +782,38 @@ void SessionlessObj::RequestRangeSignalHandler(const InterfaceDescription::Membe
     }
 }
 
-void SessionlessObj::HandleRangeRequest(const char* sender, SessionId sessionId, uint32_t fromChangeId, uint32_t toChangeId)
+void SessionlessObj::RequestRangeMatchSignalHandler(const InterfaceDescription::Member* member,
+                                                    const char* sourcePath,
+                                                    Message& msg)
+{
+    QCC_DbgTrace(("SessionlessObj::RequestRangeMatchHandler(%s, %s, ...)", member->name.c_str(), sourcePath));
+    uint32_t fromId, toId;
+    const MsgArg* ruleArgs;
+    size_t numRules;
+    QStatus status = msg->GetArgs("uuas", &fromId, &toId, &numRules, &ruleArgs);
+    if (status == ER_OK) {
+        std::vector<Rule> rules;
+        rules.reserve(numRules);
+        for (size_t i = 0; (status == ER_OK) && (i < numRules); ++i) {
+            const char* ruleStr;
+            status = ruleArgs[i].Get("s", &ruleStr);
+            if (status == ER_OK) {
+                rules.push_back(Rule(ruleStr, &status));
+            }
+        }
+        if (status == ER_OK) {
+            HandleRangeRequest(msg->GetSender(), msg->GetSessionId(), fromId, toId, &rules);
+        } else {
+            /* Fall back to sending the whole range rather than dropping signals the requester wants */
+            QCC_LogError(status, ("Invalid match rule in RequestRangeMatch from %s", msg->GetSender()));
+            HandleRangeRequest(msg->GetSender(), msg->GetSessionId(), fromId, toId);
+        }
+    } else {
+        QCC_LogError(status, ("Message::GetArgs failed"));
+    }
+}
+
+void SessionlessObj::HandleRangeRequest(const char* sender, SessionId sessionId, uint32_t fromChangeId, uint32_t toChangeId, std::vector<Rule>* rules)
 {
     QStatus status = ER_OK;
     bool messageErased = false;
@@ -681,43 +822,42 @@ void SessionlessObj::HandleRangeRequest(const char* sender, SessionId sessionId,
     /* Enable concurrency since PushMessage could block */
     bus.EnableConcurrentCallbacks();
 
-    /* Send all messages in messageMap in range [fromChangeId, toChangeId) */
-    lock.Lock();
-    map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.begin();
-    uint32_t rangeLen = toChangeId - fromChangeId;
-    while (it != messageMap.end()) {
-        if (IN_WINDOW(uint32_t, fromChangeId, rangeLen, it->second.first)) {
-            MessageMapKey key = it->first;
-            if (it->second.second->IsExpired()) {
-                /* Remove expired message without sending */
-                messageMap.erase(++it);
+    router.LockNameTable();
+    BusEndpoint ep = router.FindEndpoint(sender);
+    router.UnlockNameTable();
+
+    /*
+     * Send the messages in range [fromChangeId, toChangeId) in batches so the requester can start
+     * processing the first signals while later ones are still being collected. Expired messages
+     * are removed without sending.
+     */
+    std::vector<MessageMapKey> keys;
+    std::vector<Message> msgs;
+    keys.reserve(SESSIONLESS_CATCHUP_BATCH);
+    msgs.reserve(SESSIONLESS_CATCHUP_BATCH);
+    while (ep->IsValid() && (fromChangeId != toChangeId)) {
+        lock.Lock();
+        GetChangeIdRange(fromChangeId, toChangeId, keys, SESSIONLESS_CATCHUP_BATCH);
+        for (std::vector<MessageMapKey>::const_iterator kit = keys.begin(); kit != keys.end(); ++kit) {
+            MessageMap::iterator it = messageMap.find(*kit);
+            if (it->second.msg->IsExpired()) {
+                EraseMessage(it);
                 messageErased = true;
-            } else {
-                /* Send message */
-                lock.Unlock();
-                router.LockNameTable();
-                BusEndpoint ep = router.FindEndpoint(sender);
-                if (ep->IsValid()) {
-                    router.UnlockNameTable();
-                    if (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL) {
-                        status = VirtualEndpoint::cast(ep)->PushMessage(it->second.second, sessionId);
-                    } else {
-                        status = ep->PushMessage(it->second.second);
-                    }
-                } else {
-                    router.UnlockNameTable();
-                }
-                lock.Lock();
-                it = messageMap.upper_bound(key);
+            } else if (!rules || MatchesAnyRule(*rules, it->second.msg)) {
+                msgs.push_back(it->second.msg);
             }
+        }
+        lock.Unlock();
+
+        if (!msgs.empty()) {
+            status = PushCatchupBatch(ep, sessionId, msgs);
             if (status != ER_OK) {
-                QCC_LogError(status, ("Failed to push sessionless signal to %s", sender));
+                QCC_LogError(status, ("Failed to push sessionless signals to %s", sender));
+                break;
             }
-        } else {
-            ++it;
+            msgs.clear();
         }
     }
-    lock.Unlock();
 
     /* Alert the advertiser worker */
     if (messageErased) {
@@ -742,20 +882,33 @@ void SessionlessObj::AlarmTriggered(const Alarm& alarm, QStatus reason)
 
     QStatus status;
 
+    /* Alarms with a context are deferred fetches, the others run the advertiser worker */
+    if (alarm->GetContext()) {
+        if (reason == ER_OK) {
+            DoDeferredFetches();
+        }
+        return;
+    }
+
     if (reason == ER_OK) {
         uint32_t tilExpire = ::numeric_limits<uint32_t>::max();
         uint32_t expire;
         uint32_t maxChangeId = 0;
         bool mapIsEmpty = true;
 
-        /* Purge the messageMap of expired messages */
+        /* Purge the messageMap of expired messages and messages that exceed the age limit */
         lock.Lock();
-        map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.begin();
+        uint64_t now = GetTimestamp64();
+        MessageMap::iterator it = messageMap.begin();
         while (it != messageMap.end()) {
-            if (it->second.second->IsExpired(&expire)) {
-                messageMap.erase(it++);
+            uint64_t age = now - it->second.storeTs;
+            if (it->second.msg->IsExpired(&expire) || (maxStoredAge && (age >= maxStoredAge))) {
+                EraseMessage(it++);
             } else {
-                maxChangeId = max(maxChangeId, it->second.first);
+                if (maxStoredAge) {
+                    expire = min(expire, static_cast<uint32_t>(maxStoredAge - age));
+                }
+                maxChangeId = max(maxChangeId, it->second.changeId);
                 tilExpire = min(tilExpire, expire);
                 mapIsEmpty = false;
                 ++it;
@@ -803,7 +956,7 @@ void SessionlessObj::AlarmTriggered(const Alarm& alarm, QStatus reason)
         /* Rearm alarm */
         if (tilExpire != ::numeric_limits<uint32_t>::max()) {
             SessionlessObj* slObj = this;
-            timer.AddAlarm(Alarm(tilExpire, slObj));
+            timer.AddAlarm(Alarm(TimerSlack::Coalesce(tilExpire), slObj));
         }
     }
 }
@@ -838,28 +991,28 @@ void SessionlessObj::JoinSessionCB(QStatus status, SessionId id, const SessionOp
 
         /* Check to see if there are any pending catch ups */
         uint32_t requestChangeId = cit->second.changeId + 1;
+        uint32_t hostVersion = (status == ER_OK) ? GetHostProtocolVersion(ctx1->second, id) : 0;
+        bool matchCapable = (hostVersion >= 7);
+        std::vector<String> rules;
         if (status == ER_OK) {
             if (cit->second.catchupList.empty()) {
                 /* No catchups pending. Update changeIdMap */
                 cit->second.changeId = ctx1->first;
                 cit->second.inProgress = false;
+                /* Only ask for the signals that local rules select if the host can filter them */
+                if (matchCapable) {
+                    GetMatchRules("", rules);
+                }
             } else {
                 /* Check to see if session host is capable of handling RequestSignalRange */
-                bool rangeCapable = false;
-                BusEndpoint ep = router.FindEndpoint(ctx1->second);
-                router.LockNameTable();
-                if (ep->IsValid() && (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
-                    RemoteEndpoint rep = VirtualEndpoint::cast(ep)->GetBusToBusEndpoint(id);
-                    if (rep->IsValid()) {
-                        rangeCapable = (rep->GetRemoteProtocolVersion() >= 6);
-                    }
-                }
-                router.UnlockNameTable();
-                if (rangeCapable) {
+                if (hostVersion >= 6) {
                     /* Handle head of catchup list */
                     isCatchup = true;
                     catchup = cit->second.catchupList.front();
                     cit->second.catchupList.pop();
+                    if (matchCapable) {
+                        GetMatchRules(catchup.sender, rules);
+                    }
                 } else {
                     /* This session cant be used for catchup because remote side doesn't support it */
                     /* Just clear the catchupList and move on as if it was the non-catchup case */
@@ -900,11 +1053,21 @@ void SessionlessObj::JoinSessionCB(QStatus status, SessionId id, const SessionOp
                 /* Put catchup on catchupMap */
                 catchupMap[id] = catchup;
 
-                MsgArg args[2];
+                std::vector<const char*> ruleStrs;
+                for (std::vector<String>::const_iterator rit = rules.begin(); rit != rules.end(); ++rit) {
+                    ruleStrs.push_back(rit->c_str());
+                }
+                MsgArg args[3];
                 args[0].Set("u", catchup.changeId);
                 args[1].Set("u", requestChangeId);
-                QCC_DbgPrintf(("Sending RequestRange (from=%d, to=%d) to %s\n", catchup.changeId, requestChangeId, advName.c_str()));
-                status = Signal(advName.c_str(), id, *requestRangeSignal, args, ArraySize(args));
+                if (matchCapable) {
+                    args[2].Set("as", ruleStrs.size(), ruleStrs.empty() ? NULL : &ruleStrs[0]);
+                    QCC_DbgPrintf(("Sending RequestRangeMatch (from=%d, to=%d, rules=%d) to %s\n", catchup.changeId, requestChangeId, ruleStrs.size(), advName.c_str()));
+                    status = Signal(advName.c_str(), id, *requestRangeMatchSignal, args, ArraySize(args));
+                } else {
+                    QCC_DbgPrintf(("Sending RequestRange (from=%d, to=%d) to %s\n", catchup.changeId, requestChangeId, advName.c_str()));
+                    status = Signal(advName.c_str(), id, *requestRangeSignal, args, 2);
+                }
                 if (status != ER_OK) {
                     catchupMap.erase(id);
                     QCC_LogError(status, ("RequestRange to %s failed", advName.c_str()));
@@ -915,13 +1078,7 @@ void SessionlessObj::JoinSessionCB(QStatus status, SessionId id, const SessionOp
                     }
                 }
             } else {
-                MsgArg args[1];
-                args[0].Set("u", requestChangeId);
-                QCC_DbgPrintf(("Sending RequestSignals (changeId=%d) to %s\n", requestChangeId, advName.c_str()));
-                status = Signal(advName.c_str(), id, *requestSignalsSignal, args, ArraySize(args));
-                if (status != ER_OK) {
-                    QCC_LogError(status, ("Failed to send RequestSignals to %s", advName.c_str()));
-                }
+                status = SendSignalRequest(advName, id, requestChangeId, matchCapable, rules);
             }
         }
     } else {
@@ -932,4 +1089,275 @@ void SessionlessObj::JoinSessionCB(QStatus status, SessionId id, const SessionOp
     delete ctx1;
 }
 
+void SessionlessObj::StoreMessage(const MessageMapKey& key, const Message& msg)
+{
+    MessageMap::iterator it = messageMap.find(key);
+    if (it != messageMap.end()) {
+        EraseMessage(it);
+    }
+    uint32_t changeId = nextChangeId++;
+    StoredMessage stored(changeId, msg, TxQueue::MessageBytes(msg), GetTimestamp64());
+    messageMap.insert(pair<MessageMapKey, StoredMessage>(key, stored));
+    changeIdIndex.insert(pair<uint32_t, MessageMapKey>(changeId, key));
+    storedBytes += stored.bytes;
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_SESSIONLESS, stored.bytes + sizeof(StoredMessage) + sizeof(MessageMapKey) + sizeof(_Message));
+}
+
+void SessionlessObj::EraseMessage(MessageMap::iterator it)
+{
+    changeIdIndex.erase(it->second.changeId);
+    storedBytes -= it->second.bytes;
+    MemoryAccounting::Released(MemoryAccounting::MEM_SESSIONLESS, it->second.bytes + sizeof(StoredMessage) + sizeof(MessageMapKey) + sizeof(_Message));
+    messageMap.erase(it);
+}
+
+bool SessionlessObj::EnforceByteLimit()
+{
+    bool evicted = false;
+    while (maxStoredBytes && (storedBytes > maxStoredBytes) && (messageMap.size() > 1)) {
+        /* All stored change ids precede nextChangeId so any at or above it were assigned before a wrap-around */
+        std::map<uint32_t, MessageMapKey>::iterator iit = changeIdIndex.lower_bound(nextChangeId);
+        if (iit == changeIdIndex.end()) {
+            iit = changeIdIndex.begin();
+        }
+        MessageMap::iterator it = messageMap.find(iit->second);
+        QCC_DbgPrintf(("Evicting sessionless signal %s (changeId=%u)", it->second.msg->Description().c_str(), it->second.changeId));
+        EraseMessage(it);
+        evicted = true;
+    }
+    return evicted;
+}
+
+QStatus SessionlessObj::PushCatchupBatch(BusEndpoint& ep, SessionId sessionId, std::vector<Message>& msgs)
+{
+    /* Hand the whole batch to the bus-to-bus or client endpoint so it can be coalesced into fewer writes */
+    RemoteEndpoint rep;
+    if (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL) {
+        rep = VirtualEndpoint::cast(ep)->GetBusToBusEndpoint(sessionId);
+    } else if ((ep->GetEndpointType() == ENDPOINT_TYPE_REMOTE) || (ep->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS)) {
+        rep = RemoteEndpoint::cast(ep);
+    }
+    size_t numPushed = 0;
+    QStatus status = ER_OK;
+    if (rep->IsValid()) {
+        status = rep->PushMessages(&msgs[0], msgs.size(), numPushed);
+        if (status == ER_OK) {
+            return status;
+        }
+    }
+    /* Fall back to pushing the rest one at a time through the endpoint's own routing */
+    for (status = ER_OK; (status == ER_OK) && (numPushed < msgs.size()); ++numPushed) {
+        if (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL) {
+            status = VirtualEndpoint::cast(ep)->PushMessage(msgs[numPushed], sessionId);
+        } else {
+            status = ep->PushMessage(msgs[numPushed]);
+        }
+    }
+    return status;
+}
+
+void SessionlessObj::GetChangeIdRange(uint32_t& fromChangeId, uint32_t toChangeId, std::vector<MessageMapKey>& keys, size_t maxKeys)
+{
+    keys.clear();
+    if (fromChangeId == toChangeId) {
+        return;
+    }
+    /* A range that wraps around is [fromChangeId, max] followed by [0, toChangeId) */
+    bool wraps = toChangeId < fromChangeId;
+    std::map<uint32_t, MessageMapKey>::const_iterator it = changeIdIndex.lower_bound(fromChangeId);
+    while (keys.size() < maxKeys) {
+        if (it == changeIdIndex.end()) {
+            if (!wraps) {
+                break;
+            }
+            it = changeIdIndex.begin();
+            wraps = false;
+            continue;
+        }
+        if (!wraps && (it->first >= toChangeId)) {
+            break;
+        }
+        keys.push_back(it->second);
+        fromChangeId = it->first + 1;
+        ++it;
+    }
+    if (keys.size() < maxKeys) {
+        fromChangeId = toChangeId;
+    }
+}
+
+uint32_t SessionlessObj::GetHostProtocolVersion(const qcc::String& name, SessionId sessionId)
+{
+    uint32_t version = 0;
+    router.LockNameTable();
+    BusEndpoint ep = router.FindEndpoint(name);
+    if (ep->IsValid() && (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
+        RemoteEndpoint rep = VirtualEndpoint::cast(ep)->GetBusToBusEndpoint(sessionId);
+        if (rep->IsValid()) {
+            version = rep->GetRemoteProtocolVersion();
+        }
+    }
+    router.UnlockNameTable();
+    return version;
+}
+
+void SessionlessObj::GetMatchRules(const qcc::String& epName, std::vector<qcc::String>& rules)
+{
+    std::set<qcc::String> unique;
+    multimap<String, Rule>::const_iterator it = epName.empty() ? ruleMap.begin() : ruleMap.lower_bound(epName);
+    while ((it != ruleMap.end()) && (epName.empty() || (it->first == epName))) {
+        /* Daemons that predate argument matches reject them, the local rule table still applies them */
+        unique.insert(it->second.ToMatchString(false));
+        ++it;
+    }
+    rules.assign(unique.begin(), unique.end());
+}
+
+QStatus SessionlessObj::SendSignalRequest(const qcc::String& advName, SessionId sessionId, uint32_t requestChangeId,
+                                          bool matchCapable, const std::vector<qcc::String>& rules)
+{
+    QStatus status;
+    if (matchCapable) {
+        /* Same range as RequestSignals: [changeId, changeId + max(uint32)/2) */
+        std::vector<const char*> ruleStrs;
+        for (std::vector<String>::const_iterator rit = rules.begin(); rit != rules.end(); ++rit) {
+            ruleStrs.push_back(rit->c_str());
+        }
+        MsgArg args[3];
+        args[0].Set("u", requestChangeId);
+        args[1].Set("u", requestChangeId + (numeric_limits<uint32_t>::max() >> 1));
+        args[2].Set("as", ruleStrs.size(), ruleStrs.empty() ? NULL : &ruleStrs[0]);
+        QCC_DbgPrintf(("Sending RequestRangeMatch (changeId=%d, rules=%d) to %s\n", requestChangeId, ruleStrs.size(), advName.c_str()));
+        status = Signal(advName.c_str(), sessionId, *requestRangeMatchSignal, args, ArraySize(args));
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to send RequestRangeMatch to %s", advName.c_str()));
+        }
+    } else {
+        MsgArg args[1];
+        args[0].Set("u", requestChangeId);
+        QCC_DbgPrintf(("Sending RequestSignals (changeId=%d) to %s\n", requestChangeId, advName.c_str()));
+        status = Signal(advName.c_str(), sessionId, *requestSignalsSignal, args, ArraySize(args));
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to send RequestSignals to %s", advName.c_str()));
+        }
+    }
+    return status;
+}
+
+void SessionlessObj::DoDeferredFetches()
+{
+    std::vector<pair<String, TransportMask> > fetches;
+    uint64_t now = GetTimestamp64();
+    lock.Lock();
+    for (map<String, ChangeIdEntry>::iterator it = changeIdMap.begin(); it != changeIdMap.end(); ++it) {
+        if (it->second.fetchScheduled && ((now - it->second.lastFetchTs) >= SESSIONLESS_FETCH_COALESCE_MS)) {
+            it->second.fetchScheduled = false;
+            fetches.push_back(pair<String, TransportMask>(it->second.advName, it->second.transport));
+        }
+    }
+    lock.Unlock();
+
+    for (std::vector<pair<String, TransportMask> >::const_iterator fit = fetches.begin(); fit != fetches.end(); ++fit) {
+        HandleFoundAdvertisedName(fit->first.c_str(), fit->second, false);
+    }
+}
+
+void SessionlessObj::MulticastMessage(const Message& msg, uint32_t changeId)
+{
+    /* A receiver without a connection to this daemon has no way to expand a compressed header */
+    size_t msgBytes = TxQueue::MessageBytes(msg);
+    if ((msgBytes > maxMulticastBytes) || (msg->GetFlags() & ALLJOYN_FLAG_COMPRESSED)) {
+        return;
+    }
+
+    /* Version, guid length, guid, change id (big endian) and the marshaled signal */
+    String guid = bus.GetGlobalGUIDShortString();
+    size_t len = 2 + guid.size() + 4 + msgBytes;
+    if (len > IpNameService::DATAGRAM_MAX) {
+        return;
+    }
+    std::vector<uint8_t> buf;
+    buf.reserve(len);
+    buf.push_back(SESSIONLESS_DATAGRAM_VERSION);
+    buf.push_back(static_cast<uint8_t>(guid.size()));
+    buf.insert(buf.end(), reinterpret_cast<const uint8_t*>(guid.c_str()), reinterpret_cast<const uint8_t*>(guid.c_str()) + guid.size());
+    buf.push_back(static_cast<uint8_t>(changeId >> 24));
+    buf.push_back(static_cast<uint8_t>(changeId >> 16));
+    buf.push_back(static_cast<uint8_t>(changeId >> 8));
+    buf.push_back(static_cast<uint8_t>(changeId));
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(msg->msgBuf);
+    buf.insert(buf.end(), bytes, bytes + msgBytes);
+
+    QStatus status = IpNameService::Instance().SendDatagram(TRANSPORT_ANY & ~TRANSPORT_ICE & ~TRANSPORT_LOCAL, &buf[0], buf.size());
+    if (status != ER_OK) {
+        QCC_DbgPrintf(("Not multicasting sessionless signal (changeId=%u): %s", changeId, QCC_StatusText(status)));
+    }
+}
+
+void SessionlessObj::DatagramReceived(const uint8_t* buf, size_t len)
+{
+    if ((len < 2) || (buf[0] != SESSIONLESS_DATAGRAM_VERSION) || (buf[1] == 0) || (len < (2u + buf[1] + 4u))) {
+        return;
+    }
+    String guid(reinterpret_cast<const char*>(buf + 2), buf[1]);
+    if (guid == bus.GetGlobalGUIDShortString()) {
+        /* Our own signal looped back */
+        return;
+    }
+    const uint8_t* pos = buf + 2 + buf[1];
+    uint32_t changeId = (static_cast<uint32_t>(pos[0]) << 24) | (static_cast<uint32_t>(pos[1]) << 16) |
+                        (static_cast<uint32_t>(pos[2]) << 8) | static_cast<uint32_t>(pos[3]);
+    pos += 4;
+
+    /* There is no endpoint the signal arrived on so it is unmarshaled without one */
+    Message msg(bus);
+    RemoteEndpoint noEndpoint;
+    QStatus status = msg->LoadBytes(pos, len - (pos - buf));
+    if (status == ER_OK) {
+        status = msg->Unmarshal(noEndpoint, false);
+    }
+    if ((status == ER_OK) && ((msg->GetType() != MESSAGE_SIGNAL) || !msg->IsSessionless())) {
+        status = ER_BUS_BAD_HEADER_FIELD;
+    }
+    if (status != ER_OK) {
+        QCC_DbgPrintf(("Dropping multicast sessionless signal from %s: %s", guid.c_str(), QCC_StatusText(status)));
+        return;
+    }
+
+    /*
+     * Only take the signal that directly follows the last change id fetched from the sender, and
+     * only while no fetch from it can be outstanding, since that fetch may bring the same signal.
+     * Anything else, including the signal after a lost datagram, is left for the advertisement that
+     * follows it, which fetches from the last change id onwards over a session.
+     */
+    std::set<String> epNames;
+    uint64_t now = GetTimestamp64();
+    lock.Lock();
+    map<String, ChangeIdEntry>::iterator it = changeIdMap.find(guid);
+    if ((it != changeIdMap.end()) && !it->second.inProgress && !it->second.fetchScheduled && it->second.catchupList.empty() &&
+        ((now - it->second.lastFetchTs) >= SESSIONLESS_FETCH_COALESCE_MS) && (changeId == static_cast<uint32_t>(it->second.changeId + 1))) {
+        it->second.changeId = changeId;
+        for (multimap<String, Rule>::iterator rit = ruleMap.begin(); rit != ruleMap.end(); ++rit) {
+            if (rit->second.IsMatch(msg)) {
+                epNames.insert(rit->first);
+            }
+        }
+    } else {
+        QCC_DbgPrintf(("Leaving multicast sessionless signal from %s (changeId=%u) to the next fetch", guid.c_str(), changeId));
+    }
+    lock.Unlock();
+
+    for (std::set<String>::const_iterator eit = epNames.begin(); eit != epNames.end(); ++eit) {
+        router.LockNameTable();
+        BusEndpoint ep = router.FindEndpoint(*eit);
+        router.UnlockNameTable();
+        if (ep->IsValid() && ep->AllowRemoteMessages()) {
+            status = ep->PushMessage(msg);
+            if (status != ER_OK) {
+                QCC_LogError(status, ("PushMessage to %s failed", eit->c_str()));
+            }
+        }
+    }
+}
+
 }
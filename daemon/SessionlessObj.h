@@ -26,6 +26,7 @@
 #include <map>
 #include <set>
 #include <queue>
+#include <vector>
 
 #include <qcc/String.h>
 #include <qcc/Timer.h>
@@ -93,6 +94,13 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
      */
     void ObjectRegistered(void);
 
+    /**
+     * Get the SessionPort that remote daemons join to fetch sessionless messages.
+     *
+     * @return  The sessionless session port.
+     */
+    SessionPort GetSessionPort() const { return sessionPort; }
+
     /**
      * Add a rule for an endpoint.
      *
@@ -202,6 +210,17 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
                                    const char* sourcePath,
                                    Message& msg);
 
+    /**
+     * Process incoming RequestRangeMatch signals from remote daemons.
+     *
+     * @param member        Interface member for signal
+     * @param sourcePath    object path sending the signal.
+     * @param msg           The signal message.
+     */
+    void RequestRangeMatchSignalHandler(const InterfaceDescription::Member* member,
+                                        const char* sourcePath,
+                                        Message& msg);
+
     /**
      * Trigger (re)reception of sessionless signals from a single or from all
      * remote daemons.
@@ -231,8 +250,64 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
      * @param sessionId Session id
      * @param fromId    Beginning of changeId range (inclusive)
      * @param toId      End of changeId range (exclusive)
+     * @param rules     If non-NULL only the signals that match one of these rules are emitted
+     */
+    void HandleRangeRequest(const char* sender, SessionId sessionId, uint32_t fromId, uint32_t toId, std::vector<Rule>* rules = NULL);
+
+    /**
+     * Get the daemon-to-daemon protocol version of the host of a sessionless session.
+     *
+     * @param name      Name of the session host.
+     * @param sessionId Session id
+     * @return  The protocol version or 0 if it is not known.
+     */
+    uint32_t GetHostProtocolVersion(const qcc::String& name, SessionId sessionId);
+
+    /**
+     * Ask a remote daemon for the sessionless signals from requestChangeId onwards.
+     *
+     * @param advName           Sessionless name advertised by the remote daemon.
+     * @param sessionId         Session to send the request over or 0 to use an existing bus-to-bus connection.
+     * @param requestChangeId   First change id wanted.
+     * @param matchCapable      true if the remote daemon understands RequestRangeMatch.
+     * @param rules             Match rules to send with RequestRangeMatch.
+     * @return  ER_OK if the request was sent.
+     */
+    QStatus SendSignalRequest(const qcc::String& advName, SessionId sessionId, uint32_t requestChangeId,
+                              bool matchCapable, const std::vector<qcc::String>& rules);
+
+    /**
+     * Start the fetches that were deferred to coalesce change id bumps.
      */
-    void HandleRangeRequest(const char* sender, SessionId sessionId, uint32_t fromId, uint32_t toId);
+    void DoDeferredFetches();
+
+    /**
+     * Multicast a newly stored sessionless signal to the daemons that follow this one if it is
+     * small enough for the fast path. Must be called with lock held so signals go out in change id
+     * order.
+     *
+     * @param msg       The signal.
+     * @param changeId  The change id assigned to the signal.
+     */
+    void MulticastMessage(const Message& msg, uint32_t changeId);
+
+    /**
+     * Receive a sessionless signal multicast by another daemon. The signal is only delivered if it
+     * directly follows the last change id fetched from that daemon. Otherwise it is dropped and the
+     * next advertisement fetches it, along with whatever was lost, over a session.
+     *
+     * @param buf   The datagram.
+     * @param len   The length of the datagram.
+     */
+    void DatagramReceived(const uint8_t* buf, size_t len);
+
+    /**
+     * Get the match rules of the local sessionless rules. Must be called with lock held.
+     *
+     * @param epName    Unique name of the endpoint whose rules are wanted or empty for all endpoints.
+     * @param[out] rules Deduplicated match rule strings.
+     */
+    void GetMatchRules(const qcc::String& epName, std::vector<qcc::String>& rules);
 
     /**
      * Internal helper for FoundAdvertisedName.
@@ -258,6 +333,7 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
 
     const InterfaceDescription::Member* requestSignalsSignal;   /**< org.alljoyn.Sessionless.RequestSignal signal */
     const InterfaceDescription::Member* requestRangeSignal;     /**< org.alljoyn.Sessionless.RequestRange signal */
+    const InterfaceDescription::Member* requestRangeMatchSignal;  /**< org.alljoyn.Sessionless.RequestRangeMatch signal */
 
     qcc::Timer timer;                     /**< Timer object for reaping expired names */
 
@@ -276,11 +352,72 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
         }
     };
 
+    /** A stored sessionless message */
+    struct StoredMessage {
+        StoredMessage(uint32_t changeId, const Message& msg, size_t bytes, uint64_t storeTs) :
+            changeId(changeId), msg(msg), bytes(bytes), storeTs(storeTs) { }
+        uint32_t changeId;    /**< Change id assigned when the message was stored */
+        Message msg;          /**< The message */
+        size_t bytes;         /**< Marshaled size of the message */
+        uint64_t storeTs;     /**< Timestamp (ms) at which the message was stored */
+    };
+
+    typedef std::map<MessageMapKey, StoredMessage> MessageMap;
+
     /** Storage for sessionless messages waiting to be delivered */
-    std::map<MessageMapKey, std::pair<uint32_t, Message> > messageMap;
+    MessageMap messageMap;
+
+    /** Index of messageMap by change id so catch-up only visits the requested range */
+    std::map<uint32_t, MessageMapKey> changeIdIndex;
+
+    size_t storedBytes;       /**< Total marshaled size of the messages in messageMap */
+    size_t maxStoredBytes;    /**< Limit on storedBytes, 0 for no limit */
+    uint32_t maxStoredAge;    /**< Messages older than this (ms) are evicted, 0 for no limit */
+    size_t maxMulticastBytes; /**< Largest signal (marshaled size) that is also multicast, 0 to never multicast */
+
+    /**
+     * Store a message, replacing any message with the same key. Must be called with lock held.
+     */
+    void StoreMessage(const MessageMapKey& key, const Message& msg);
+
+    /**
+     * Remove a stored message. Must be called with lock held.
+     *
+     * @param it   The message to remove. Invalidated by the call.
+     */
+    void EraseMessage(MessageMap::iterator it);
+
+    /**
+     * Evict the oldest messages until the byte limit is met. Must be called with lock held.
+     *
+     * @return  true if any message was evicted.
+     */
+    bool EnforceByteLimit();
+
+    /**
+     * Get the keys of the stored messages with change ids in [fromChangeId, toChangeId), in change
+     * id order. Must be called with lock held.
+     *
+     * @param[in,out] fromChangeId  Beginning of changeId range (inclusive). Advanced past the last
+     *                              change id returned, or set to toChangeId if the range is exhausted.
+     * @param toChangeId            End of changeId range (exclusive)
+     * @param[out] keys             The keys of the messages in the range.
+     * @param maxKeys               Maximum number of keys to return.
+     */
+    void GetChangeIdRange(uint32_t& fromChangeId, uint32_t toChangeId, std::vector<MessageMapKey>& keys, size_t maxKeys);
+
+    /**
+     * Send a batch of sessionless signals to the endpoint that requested them.
+     *
+     * @param ep          The endpoint of the requester.
+     * @param sessionId   The session the signals are sent over.
+     * @param msgs        The signals.
+     * @return  ER_OK if all the signals were sent.
+     */
+    QStatus PushCatchupBatch(BusEndpoint& ep, SessionId sessionId, std::vector<Message>& msgs);
 
-    /** Count the number of rules (per endpoint) that specify sesionless=TRUE */
-    std::map<qcc::String, uint32_t> ruleCountMap;
+    /** The rules (per endpoint) that specify sessionless=TRUE */
+    std::multimap<qcc::String, Rule> ruleMap;
 
     /** CatchupState is used to track individual local clients that are behind the state of the server for a particular remote host */
     struct CatchupState {
@@ -298,13 +435,16 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
     struct ChangeIdEntry {
       public:
         ChangeIdEntry(const char* advName, TransportMask transport, uint32_t changeId, bool inProgress, uint32_t retries) :
-            advName(advName), transport(transport), changeId(changeId), inProgress(inProgress), retries(retries), catchupList() { }
+            advName(advName), transport(transport), changeId(changeId), inProgress(inProgress), retries(retries), catchupList(),
+            lastFetchTs(0), fetchScheduled(false) { }
         qcc::String advName;
         TransportMask transport;
         uint32_t changeId;
         bool inProgress;
         uint32_t retries;
         std::queue<CatchupState> catchupList;
+        uint64_t lastFetchTs;       /**< Timestamp (ms) of the last fetch from this daemon */
+        bool fetchScheduled;        /**< True if a deferred fetch is scheduled */
     };
     /** Map remote guid to ChangeIdEntry */
     std::map<qcc::String, ChangeIdEntry> changeIdMap;
@@ -0,0 +1,359 @@
+/**
+ * @file
+ * Debug interface (org.alljoyn.Bus.Debug.Stats) for getting daemon-wide and per-endpoint counters.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_STATSDEBUGOBJ_H
+#define _ALLJOYN_STATSDEBUGOBJ_H
+
+// Include contents in debug builds only.
+#ifndef NDEBUG
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "AllJoynDebugObj.h"
+#include "DaemonRouter.h"
+#include "RemoteEndpoint.h"
+#include "HandlerProfile.h"
+#include "LatencyHistogram.h"
+#include "MemoryAccounting.h"
+#include "MessageTrace.h"
+#include "MessageCapture.h"
+
+
+namespace ajn {
+
+namespace debug {
+
+/**
+ * Debug addon that publishes the router counters, the remote endpoint traffic counters summed
+ * over the life of the daemon, the counters of each connected remote endpoint and the message
+ * routing latency histograms as read-only properties. Reading the Trace property takes a
+ * snapshot of the message trace ring. Latency and trace recording can be switched on and off
+ * with the read-write LatencyRecording and TraceRecording properties. Setting the Capture
+ * property to a file name starts capturing received messages to that file and setting it to an
+ * empty string stops. The Handlers property profiles the method and signal handlers of the
+ * daemon's own bus objects while the read-write HandlerProfiling property is true. The Memory
+ * property is empty unless memory accounting was enabled at startup.
+ *
+ * @cond ALLJOYN_DEV
+ *
+ * This is implemented entirely in the header file so it is easily excluded from release
+ * builds by conditionally including it.
+ *
+ * @endcond
+ */
+class StatsDebugObj : public AllJoynDebugObjAddon {
+  public:
+    class StatsDebugProperties : public AllJoynDebugObj::Properties {
+      public:
+        StatsDebugProperties(DaemonRouter& router, HandlerProfile& handlers) : router(router), handlers(handlers) { }
+
+        QStatus Get(const char* propName, MsgArg& val) const
+        {
+            if (::strcmp(propName, "Endpoints") == 0) {
+                return GetEndpoints(val);
+            } else if (::strcmp(propName, "Latency") == 0) {
+                return GetLatency(val);
+            } else if (::strcmp(propName, "LatencyRecording") == 0) {
+                return val.Set("b", LatencyStats::IsEnabled());
+            } else if (::strcmp(propName, "Trace") == 0) {
+                return GetTrace(val);
+            } else if (::strcmp(propName, "TraceRecording") == 0) {
+                return val.Set("b", MessageTrace::IsEnabled());
+            } else if (::strcmp(propName, "Capture") == 0) {
+                QStatus status = val.Set("s", MessageCapture::GetFileName().c_str());
+                val.Stabilize();
+                return status;
+            } else if (::strcmp(propName, "Handlers") == 0) {
+                return GetHandlers(val);
+            } else if (::strcmp(propName, "HandlerProfiling") == 0) {
+                return val.Set("b", handlers.IsEnabled());
+            } else if (::strcmp(propName, "Memory") == 0) {
+                return GetMemory(val);
+            }
+
+            DaemonRouter::Stats stats;
+            router.GetStats(stats);
+            uint32_t handshakes;
+            uint32_t failures;
+            _RemoteEndpoint::GetAuthStats(handshakes, failures);
+            uint32_t v;
+            if (::strcmp(propName, "MessagesRouted") == 0) {
+                v = stats.messagesRouted;
+            } else if (::strcmp(propName, "Deliveries") == 0) {
+                v = stats.deliveries;
+            } else if (::strcmp(propName, "Broadcasts") == 0) {
+                v = stats.broadcasts;
+            } else if (::strcmp(propName, "MaxFanOut") == 0) {
+                v = stats.maxFanOut;
+            } else if (::strcmp(propName, "RuleEvaluations") == 0) {
+                v = stats.ruleEvaluations;
+            } else if (::strcmp(propName, "NoRoute") == 0) {
+                v = stats.noRoute;
+            } else if (::strcmp(propName, "PushFailures") == 0) {
+                v = stats.pushFailures;
+            } else if (::strcmp(propName, "AuthHandshakes") == 0) {
+                v = handshakes;
+            } else if (::strcmp(propName, "AuthFailures") == 0) {
+                v = failures;
+            } else {
+                std::vector<std::pair<qcc::String, _RemoteEndpoint::Stats> > epStats;
+                _RemoteEndpoint::Stats totals;
+                router.GetEndpointStats(epStats, totals);
+                if (::strcmp(propName, "RxMessages") == 0) {
+                    v = totals.rxMessages;
+                } else if (::strcmp(propName, "RxBytes") == 0) {
+                    v = totals.rxBytes;
+                } else if (::strcmp(propName, "TxMessages") == 0) {
+                    v = totals.txMessages;
+                } else if (::strcmp(propName, "TxBytes") == 0) {
+                    v = totals.txBytes;
+                } else if (::strcmp(propName, "TxQueueHighWater") == 0) {
+                    v = totals.txQueueHighWater;
+                } else if (::strcmp(propName, "TxDrops") == 0) {
+                    v = totals.txDrops;
+                } else if (::strcmp(propName, "IdleTimeouts") == 0) {
+                    v = totals.idleTimeouts;
+                } else {
+                    return ER_BUS_NO_SUCH_PROPERTY;
+                }
+            }
+            return val.Set("u", v);
+        }
+
+        QStatus Set(const char* propName, MsgArg& val)
+        {
+            if (::strcmp(propName, "LatencyRecording") == 0) {
+                bool enable;
+                QStatus status = val.Get("b", &enable);
+                if (status == ER_OK) {
+                    LatencyStats::Enable(enable);
+                }
+                return status;
+            } else if (::strcmp(propName, "TraceRecording") == 0) {
+                bool enable;
+                QStatus status = val.Get("b", &enable);
+                if (status == ER_OK) {
+                    MessageTrace::Enable(enable);
+                }
+                return status;
+            } else if (::strcmp(propName, "Capture") == 0) {
+                const char* fileName;
+                QStatus status = val.Get("s", &fileName);
+                if (status == ER_OK) {
+                    if (*fileName) {
+                        status = MessageCapture::Start(fileName);
+                    } else {
+                        MessageCapture::Stop();
+                    }
+                }
+                return status;
+            } else if (::strcmp(propName, "HandlerProfiling") == 0) {
+                bool enable;
+                QStatus status = val.Get("b", &enable);
+                if (status == ER_OK) {
+                    handlers.Enable(enable);
+                }
+                return status;
+            }
+            const AllJoynDebugObj::Properties::Info* info;
+            size_t infoSize;
+            GetProperyInfo(info, infoSize);
+            for (size_t i = 0; i < infoSize; ++i) {
+                if (::strcmp(propName, info[i].name) == 0) {
+                    return ER_BUS_PROPERTY_ACCESS_DENIED;
+                }
+            }
+            return ER_BUS_NO_SUCH_PROPERTY;
+        }
+
+        void GetProperyInfo(const AllJoynDebugObj::Properties::Info*& info, size_t& infoSize)
+        {
+            static const AllJoynDebugObj::Properties::Info ourInfo[] = {
+                { "MessagesRouted",   "u",           PROP_ACCESS_READ },
+                { "Deliveries",       "u",           PROP_ACCESS_READ },
+                { "Broadcasts",       "u",           PROP_ACCESS_READ },
+                { "MaxFanOut",        "u",           PROP_ACCESS_READ },
+                { "RuleEvaluations",  "u",           PROP_ACCESS_READ },
+                { "NoRoute",          "u",           PROP_ACCESS_READ },
+                { "PushFailures",     "u",           PROP_ACCESS_READ },
+                { "AuthHandshakes",   "u",           PROP_ACCESS_READ },
+                { "AuthFailures",     "u",           PROP_ACCESS_READ },
+                { "RxMessages",       "u",           PROP_ACCESS_READ },
+                { "RxBytes",          "u",           PROP_ACCESS_READ },
+                { "TxMessages",       "u",           PROP_ACCESS_READ },
+                { "TxBytes",          "u",           PROP_ACCESS_READ },
+                { "TxQueueHighWater", "u",           PROP_ACCESS_READ },
+                { "TxDrops",          "u",           PROP_ACCESS_READ },
+                { "IdleTimeouts",     "u",           PROP_ACCESS_READ },
+                { "Endpoints",        "a(suuuuuuu)", PROP_ACCESS_READ },
+                { "Latency",          "a(ssuuuuu)",  PROP_ACCESS_READ },
+                { "LatencyRecording", "b",           PROP_ACCESS_RW },
+                { "Trace",            "a(tuuuuyy)",  PROP_ACCESS_READ },
+                { "TraceRecording",   "b",           PROP_ACCESS_RW },
+                { "Capture",          "s",           PROP_ACCESS_RW },
+                { "Handlers",         "a(ssutuuuuuu)", PROP_ACCESS_READ },
+                { "HandlerProfiling", "b",           PROP_ACCESS_RW },
+                { "Memory",           "a(sxxi)",     PROP_ACCESS_READ },
+            };
+            info = ourInfo;
+            infoSize = ArraySize(ourInfo);
+        }
+
+      private:
+
+        /*
+         * Each element is the unique name followed by rxMessages, rxBytes, txMessages, txBytes,
+         * txQueueHighWater, txDrops and idleTimeouts.
+         */
+        QStatus GetEndpoints(MsgArg& val) const
+        {
+            std::vector<std::pair<qcc::String, _RemoteEndpoint::Stats> > epStats;
+            _RemoteEndpoint::Stats totals;
+            router.GetEndpointStats(epStats, totals);
+
+            std::vector<MsgArg> elements(epStats.size());
+            for (size_t i = 0; i < epStats.size(); ++i) {
+                const _RemoteEndpoint::Stats& s = epStats[i].second;
+                elements[i].Set("(suuuuuuu)", epStats[i].first.c_str(),
+                                s.rxMessages, s.rxBytes, s.txMessages, s.txBytes,
+                                s.txQueueHighWater, s.txDrops, s.idleTimeouts);
+            }
+            return SetArray(val, "a(suuuuuuu)", elements);
+        }
+
+        /*
+         * Each element is the stage and kind of endpoint followed by the count, the median, 90th
+         * and 99th percentiles and the maximum in microseconds.
+         */
+        QStatus GetLatency(MsgArg& val) const
+        {
+            std::vector<MsgArg> elements(LatencyStats::NUM_STAGES * LatencyStats::NUM_ENDPOINT_CLASSES);
+            for (int s = 0; s < LatencyStats::NUM_STAGES; ++s) {
+                for (int c = 0; c < LatencyStats::NUM_ENDPOINT_CLASSES; ++c) {
+                    LatencyStats::Stage stage = static_cast<LatencyStats::Stage>(s);
+                    LatencyStats::EndpointClass epClass = static_cast<LatencyStats::EndpointClass>(c);
+                    const LatencyHistogram& h = LatencyStats::Get(stage, epClass);
+                    elements[s * LatencyStats::NUM_ENDPOINT_CLASSES + c].Set("(ssuuuuu)", LatencyStats::StageText(stage), LatencyStats::EndpointClassText(epClass),
+                                                                            h.GetCount(), h.GetPercentile(500), h.GetPercentile(900), h.GetPercentile(990), h.GetMax());
+                }
+            }
+            return SetArray(val, "a(ssuuuuu)", elements);
+        }
+
+        /*
+         * Each element is a MessageTrace::Event: timestamp, serial, sender, destination, endpoint,
+         * message type and stage.
+         */
+        QStatus GetTrace(MsgArg& val) const
+        {
+            std::vector<MessageTrace::Event> events;
+            MessageTrace::Snapshot(events);
+
+            std::vector<MsgArg> elements(events.size());
+            for (size_t i = 0; i < events.size(); ++i) {
+                const MessageTrace::Event& ev = events[i];
+                elements[i].Set("(tuuuuyy)", ev.timestamp, ev.serial, ev.sender, ev.destination, ev.endpoint, ev.type, ev.stage);
+            }
+            return SetArray(val, "a(tuuuuyy)", elements);
+        }
+
+        /*
+         * Each element is the interface and member followed by the handler calls, the total
+         * handler time, the median, 99th percentile and maximum handler time and the median, 99th
+         * percentile and maximum queueing delay in microseconds.
+         */
+        QStatus GetHandlers(MsgArg& val) const
+        {
+            std::vector<HandlerProfile::Stats> stats;
+            handlers.Get(stats);
+
+            std::vector<MsgArg> elements(stats.size());
+            for (size_t i = 0; i < stats.size(); ++i) {
+                const HandlerProfile::Stats& s = stats[i];
+                elements[i].Set("(ssutuuuuuu)", s.iface.c_str(), s.member.c_str(), s.calls, s.handlerUsecs,
+                                s.handlerP50, s.handlerP99, s.handlerMax, s.queueP50, s.queueP99, s.queueMax);
+            }
+            return SetArray(val, "a(ssutuuuuuu)", elements);
+        }
+
+        /*
+         * Each element is the subsystem followed by the bytes it holds, its peak bytes and the
+         * number of objects it holds.
+         */
+        QStatus GetMemory(MsgArg& val) const
+        {
+            std::vector<MsgArg> elements(MemoryAccounting::IsEnabled() ? MemoryAccounting::NUM_SUBSYSTEMS : 0);
+            for (size_t s = 0; s < elements.size(); ++s) {
+                MemoryAccounting::Subsystem subsystem = static_cast<MemoryAccounting::Subsystem>(s);
+                MemoryAccounting::Usage u;
+                MemoryAccounting::Get(subsystem, u);
+                elements[s].Set("(sxxi)", MemoryAccounting::SubsystemText(subsystem), u.bytes, u.peakBytes, u.objects);
+            }
+            return SetArray(val, "a(sxxi)", elements);
+        }
+
+        /*
+         * Hand elements built in place over to val without cloning them. Only the strings the
+         * elements reference are copied when val is stabilized.
+         */
+        static QStatus SetArray(MsgArg& val, const char* signature, std::vector<MsgArg>& elements)
+        {
+            MsgArg* owned = elements.empty() ? NULL : new MsgArg[elements.size()];
+            for (size_t i = 0; i < elements.size(); ++i) {
+                owned[i].Swap(elements[i]);
+            }
+            QStatus status = val.Set(signature, elements.size(), owned);
+            if (status == ER_OK) {
+                val.SetOwnershipFlags(MsgArg::OwnsArgs);
+                val.Stabilize();
+            } else {
+                delete [] owned;
+            }
+            return status;
+        }
+
+        DaemonRouter& router;
+        HandlerProfile& handlers;
+    };
+
+    StatsDebugObj(DaemonRouter& router, HandlerProfile& handlers) : properties(router, handlers)
+    {
+        AllJoynDebugObj* dbg = AllJoynDebugObj::GetAllJoynDebugObj();
+        dbg->AddDebugInterface(this,
+                               "org.alljoyn.Bus.Debug.Stats",
+                               NULL, 0,
+                               properties);
+    }
+
+  private:
+    StatsDebugProperties properties;
+};
+
+
+
+} // namespace debug
+} // namespace ajn
+
+#endif
+#endif
@@ -19,6 +19,8 @@
  *    limitations under the License.
  ******************************************************************************/
 
+#include <stdlib.h>
+
 #include <qcc/platform.h>
 #include <qcc/IPAddress.h>
 #include <qcc/Socket.h>
@@ -38,8 +40,13 @@
 #include "DaemonConfig.h"
 #include "DaemonRouter.h"
 #include "ns/IpNameService.h"
+#include "ScatterGatherList.h"
 #include "TCPTransport.h"
 
+#if defined(QCC_OS_GROUP_WINDOWS)
+#include "IocpStream.h"
+#endif
+
 /*
  * How the transport fits into the system
  * ======================================
@@ -282,33 +289,47 @@
  * that an endpoint is not brought up immediately, but an authentication step
  * must be performed.  The server accept loop starts this process by placing the
  * new TCPEndpoint on an authList, or list of authenticating endpoints.
- * It then calls the endpoint Authenticate() method which spins up an
- * authentication thread and returns immediately.  This process transfers the
- * responsibility for the connection and its resources to the authentication
- * thread.  Authentication can succeed, fail, or take to long and be aborted.
- *
- * If authentication succeeds, the authentication thread calls back into the
- * TCPTransport's Authenticated() method.  Along with indicating that
- * authentication has completed successfully, this transfers ownership of the
- * TCPEndpoint back to the TCPTransport from the authentication
- * thread.  At this time, the TCPEndpoint is Start()ed which spins up
+ * It then calls the endpoint Authenticate() method which marks the endpoint
+ * as authenticating and returns immediately.  Authentication does not get a
+ * thread of its own.  The server accept loop waits on the streams of the
+ * authenticating endpoints along with the listen sockets, and each time one
+ * of those streams becomes readable it calls the endpoint AuthStep() method.
+ * AuthStep() consumes whatever part of the handshake has arrived without
+ * blocking and returns, so any number of connections can be authenticating
+ * at once on the one accept loop thread.  The exception is a daemon with an
+ * AuthListener installed: the ALLJOYN_PIN_KEYX mechanism calls the listener
+ * during the handshake and the listener may block, so those connections
+ * are authenticated with blocking calls on a thread of their own, as every
+ * connection used to be.  Authentication can succeed, fail, or take to long
+ * and be aborted.
+ *
+ * If authentication succeeds, AuthStep() calls back into the TCPTransport's
+ * Authenticated() method.  This moves the TCPEndpoint from the authList to
+ * the endpointList.  At this time, the TCPEndpoint is Start()ed which spins up
  * the transmit and receive threads and enables Message routing across the
  * transport.
  *
- * If the authentication fails, the authentication thread simply sets a the
- * TCPEndpoint state to FAILED and exits.  The server accept loop looks at
- * authenticating endpoints (those on the authList)each time through its loop.
- * If an endpoint has failed authentication, and its thread has actually gone
- * away (or more precisely is at least going away in such a way that it will
- * never touch the endpoint data structure again).  This means that the endpoint
- * can be deleted.
+ * If the authentication fails, AuthStep() simply sets the TCPEndpoint state
+ * to FAILED.  Whenever a handshake ends, or the RX and TX threads of an
+ * endpoint exit, the endpoint is queued for the server accept loop with
+ * QueueReap().  Each time through its loop the accept loop looks at the
+ * queued endpoints only, so the cost does not grow with the number of
+ * connections.  If an endpoint has failed authentication it abandons the
+ * handshake via AuthJoin() and the endpoint can be deleted.
  *
  * If the authentication takes "too long" we assume that a denial of service
- * attack in in progress.  We call AuthStop() on such an endpoint which will most
- * likely induce a failure (unless we happen to call abort just as the endpoint
- * actually finishes the authentication which is highly unlikely but okay).
- * This AuthStop() will cause the endpoint to be scavenged using the above mechanism
- * the next time through the accept loop.
+ * attack in in progress.  Every authenticating endpoint has an entry in a
+ * timing wheel and the accept loop never waits past the next expiry.  We
+ * call AuthStop() on an endpoint whose entry expires which fails the
+ * authentication, and the endpoint is scavenged using the above mechanism.
+ *
+ * When many devices reconnect at once the one accept loop can become the
+ * bottleneck.  On Linux the "tcp/property@acceptors" configuration item asks
+ * for extra accept loops.  Each one runs on its own thread with its own listen
+ * socket bound to the same address and port with SO_REUSEPORT, and the kernel
+ * spreads incoming connections across the sockets.  An acceptor steps the
+ * handshakes of the connections it accepted.  The server accept loop remains
+ * the only place handshakes are timed out and the authList is scavenged.
  *
  * A daemon transport can accept incoming connections, and it can make outgoing
  * connections to another daemon.  This case is simpler than the accept case
@@ -339,7 +360,7 @@
  * succeeds, the endpoint is Start()ed which will spin up the rx and tx threads that
  * start Message routing across the link.  The endpoint is left on the endpoint list
  * in this case.  If authentication fails, the endpoint is removed from the active
- * list.  This is thread-safe since there is no authentication thread running because
+ * list.  This is thread-safe since the accept loop never steps an active endpoint because
  * the authentication was done in the context of the thread calling Connect() which
  * is the one deleting the endpoint; and no rx or tx thread is spun up if the
  * authentication fails.
@@ -396,6 +417,12 @@ namespace ajn {
  */
 const char* TCPTransport::TransportName = "tcp";
 
+/*
+ * Resolution of the auth timeout wheel.  Auth timeouts are tens of seconds so
+ * they may be a little late without anybody noticing.
+ */
+static const uint32_t AUTH_WHEEL_TICK_MS = 100;
+
 /**
  * Default router advertisement prefix.
  */
@@ -408,32 +435,32 @@ const char* const TCPTransport::ALLJOYN_DEFAULT_ROUTER_ADVERTISEMENT_PREFIX = "o
 class _TCPEndpoint : public _RemoteEndpoint {
   public:
     /**
-     * There are three threads that can be running around in this data
-     * structure.  An auth thread is run before the endpoint is started in order
-     * to handle the security stuff that must be taken care of before messages
-     * can start passing.  This enum reflects the states of the authentication
+     * The authentication process is run before the endpoint is started in
+     * order to handle the security stuff that must be taken care of before
+     * messages can start passing.  It is driven a step at a time by the server
+     * accept loop.  This enum reflects the states of the authentication
      * process and the state can be found in m_authState.  Once authentication
-     * is complete, the auth thread must go away, but it must also be joined,
-     * which is indicated by the AUTH_DONE state.  The other threads are the
-     * endpoint RX and TX threads, which are dealt with by the EndpointState.
+     * is complete, the handshake state must be released, which is indicated by
+     * the AUTH_DONE state.  The endpoint RX and TX threads are dealt with by
+     * the EndpointState.
      */
     enum AuthState {
         AUTH_ILLEGAL = 0,
-        AUTH_INITIALIZED,    /**< This endpoint structure has been allocated but no auth thread has been run */
-        AUTH_AUTHENTICATING, /**< We have spun up an authentication thread and it has begun running our user function */
-        AUTH_FAILED,         /**< The authentication has failed and the authentication thread is exiting immidiately */
+        AUTH_INITIALIZED,    /**< This endpoint structure has been allocated but authentication has not begun */
+        AUTH_AUTHENTICATING, /**< The server accept loop is stepping the authentication handshake */
+        AUTH_FAILED,         /**< The authentication has failed and the handshake will not be stepped again */
         AUTH_SUCCEEDED,      /**< The auth process (Establish) has succeeded and the connection is ready to be started */
-        AUTH_DONE,           /**< The auth thread has been successfully shut down and joined */
+        AUTH_DONE,           /**< The handshake state has been released */
     };
 
     /**
-     * There are three threads that can be running around in this data
-     * structure.  Two threads, and RX thread and a TX thread are used to pump
-     * messages through an endpoint.  These threads cannot be run until the
+     * Two threads, and RX thread and a TX thread are used to pump messages
+     * through an endpoint.  These threads cannot be run until the
      * authentication process has completed.  This enum reflects the states of
-     * the endpoint RX and TX threads and can be found in m_epState.  The auth
-     * thread is dealt with by the AuthState enum above.  These threads must be
-     * joined when they exit, which is indicated by the EP_DONE state.
+     * the endpoint RX and TX threads and can be found in m_epState.  The
+     * authentication process is dealt with by the AuthState enum above.  These
+     * threads must be joined when they exit, which is indicated by the EP_DONE
+     * state.
      */
     enum EndpointState {
         EP_ILLEGAL = 0,
@@ -472,19 +499,72 @@ class _TCPEndpoint : public _RemoteEndpoint {
         m_authState(AUTH_INITIALIZED),
         m_epState(EP_INITIALIZED),
         m_tStart(qcc::Timespec(0)),
-        m_authThread(this),
+        m_gotNulByte(false),
         m_stream(sock),
         m_ipAddr(ipAddr),
         m_port(port),
-        m_wasSuddenDisconnect(!incoming) { }
+        m_wasSuddenDisconnect(!incoming),
+        m_authThread(NULL),
+        m_blockingAuth(false),
+        m_listenerAuthThread(this)
+    {
+        m_authTimeout.endpoint = this;
+        /* Coalesce queued messages into vectored socket writes */
+        SetVectoredTx(true);
+    }
 
     virtual ~_TCPEndpoint() { }
 
+    QStatus PushBytesV(const qcc::IOVec* iov, size_t numIOVec, size_t& numSent)
+    {
+#if defined(QCC_OS_GROUP_WINDOWS)
+        /* One overlapped send issued directly from the message buffers */
+        return m_stream.PushBytesV(iov, numIOVec, numSent);
+#else
+        qcc::ScatterGatherList sg;
+        for (size_t i = 0; i < numIOVec; ++i) {
+            sg.AddBuffer(static_cast<const void*>(iov[i].buf), iov[i].len);
+            sg.IncDataSize(iov[i].len);
+        }
+        return qcc::SendSG(m_stream.GetSocketFd(), sg, numSent);
+#endif
+    }
+
     void SetStartTime(qcc::Timespec tStart) { m_tStart = tStart; }
     qcc::Timespec GetStartTime(void) { return m_tStart; }
+    void SetAuthThread(qcc::Thread* thread) { m_authThread = thread; }
+    qcc::Thread* GetAuthThread(void) { return m_authThread; }
+
+    /**
+     * True if the handshake runs on a thread of its own rather than being
+     * stepped by an accept loop.  See Authenticate().
+     */
+    bool IsBlockingAuth(void) { return m_blockingAuth; }
+
+    /**
+     * The entry of the transport's auth timeout wheel for this endpoint.  It
+     * is scheduled exactly while the endpoint is on the authList.
+     */
+    struct AuthTimeout : public TimingWheel::Entry {
+        _TCPEndpoint* endpoint;
+    };
+    AuthTimeout& GetAuthTimeout(void) { return m_authTimeout; }
+
+    /**
+     * Only clients are redirected, bus-to-bus connections are how the daemons
+     * of a pool reach each other.
+     */
+    qcc::String RedirectionAddress()
+    {
+        return GetFeatures().isBusToBus ? qcc::String() : m_transport->RedirectionAddress();
+    }
+
     QStatus Authenticate(void);
+    void AuthStep(void);
     void AuthStop(void);
     void AuthJoin(void);
+    qcc::Event& GetSourceEvent(void) { return m_stream.GetSourceEvent(); }
+    qcc::SocketFd GetSocketFd(void) { return m_stream.GetSocketFd(); }
     const qcc::IPAddress& GetIPAddress() { return m_ipAddr; }
     uint16_t GetPort() { return m_port; }
 
@@ -562,22 +642,14 @@ class _TCPEndpoint : public _RemoteEndpoint {
         return status;
     }
 
-    /*
-     * Return true if the auth thread is STARTED, RUNNING or STOPPING.  A true
-     * response means the authentication thread is in a state that indicates
-     * a possibility it might touch the endpoint data structure.  This means
-     * don't delete the endpoint if this method returns true.  This method
-     * indicates nothing about endpoint rx and tx thread state.
-     */
-    bool IsAuthThreadRunning(void)
-    {
-        return m_authThread.IsRunning();
-    }
-
   private:
-    class AuthThread : public qcc::Thread {
+    /**
+     * Runs the whole handshake with blocking calls for connections whose
+     * authentication may call out to an AuthListener.
+     */
+    class ListenerAuthThread : public qcc::Thread {
       public:
-        AuthThread(_TCPEndpoint* ep) : Thread("auth"), m_endpoint(ep)  { }
+        ListenerAuthThread(_TCPEndpoint* ep) : Thread("auth"), m_endpoint(ep)  { }
       private:
         virtual qcc::ThreadReturn STDCALL Run(void* arg);
 
@@ -589,213 +661,277 @@ class _TCPEndpoint : public _RemoteEndpoint {
     volatile AuthState m_authState;   /**< The state of the endpoint authentication process */
     volatile EndpointState m_epState; /**< The state of the endpoint authentication process */
     qcc::Timespec m_tStart;           /**< Timestamp indicating when the authentication process started */
-    AuthThread m_authThread;          /**< Thread used to do blocking calls during startup */
+    bool m_gotNulByte;                /**< True once the leading nul byte of the handshake has been read */
+#if defined(QCC_OS_GROUP_WINDOWS)
+    IocpStream m_stream;              /**< Stream used by authentication code, completed on the I/O completion port */
+#else
     qcc::SocketStream m_stream;       /**< Stream used by authentication code */
+#endif
     qcc::IPAddress m_ipAddr;          /**< Remote IP address. */
     uint16_t m_port;                  /**< Remote port. */
     bool m_wasSuddenDisconnect;       /**< If true, assumption is that any disconnect is unexpected due to lower level error */
+    qcc::Thread* m_authThread;        /**< The accept loop that steps the handshake, only ever compared */
+    qcc::Mutex m_authLock;            /**< Keeps the handshake from being released while it is being stepped */
+    AuthTimeout m_authTimeout;        /**< Auth timeout wheel entry */
+    bool m_blockingAuth;              /**< True if m_listenerAuthThread runs the handshake */
+    ListenerAuthThread m_listenerAuthThread; /**< Thread used for handshakes that may call the AuthListener */
+
+    void DoAuthStep(void);
+    void DoBlockingAuth(void);
 };
 
 QStatus _TCPEndpoint::Authenticate(void)
 {
     QCC_DbgTrace(("TCPEndpoint::Authenticate()"));
-    /*
-     * Start the authentication thread.
+
+    /* Initialized the features for this endpoint */
+    GetFeatures().isBusToBus = false;
+    GetFeatures().handlePassing = false;
+
+    /* Since the TCPTransport allows untrusted clients, it must implement UntrustedClientStart and
+     * UntrustedClientExit.
+     * As a part of Establish, the endpoint can call the Transport's UntrustedClientStart method if
+     * it is an untrusted client, so the transport MUST call SetListener before calling Establish
+     * Note: This is only required on the accepting end i.e. for incoming endpoints.
      */
-    QStatus status = m_authThread.Start(this);
-    if (status != ER_OK) {
-        m_authState = AUTH_FAILED;
+    SetListener(m_transport);
+
+    /*
+     * ALLJOYN_PIN_KEYX asks the AuthListener for credentials from inside the
+     * SASL exchange and the listener is free to block, for example while a
+     * user types in a PIN.  That must not happen on an accept loop that is
+     * stepping every other handshake, so when a listener is installed the
+     * handshake gets a thread of its own and runs with blocking calls.  The
+     * number of such threads is bounded by max_incomplete_connections.
+     */
+    DaemonRouter& router = reinterpret_cast<DaemonRouter&>(m_transport->m_bus.GetInternal().GetRouter());
+    if (router.GetBusController()->GetAuthListener()) {
+        m_blockingAuth = true;
+        m_authState = AUTH_AUTHENTICATING;
+        QStatus status = m_listenerAuthThread.Start(this);
+        if (status != ER_OK) {
+            m_authState = AUTH_FAILED;
+        }
+        return status;
     }
-    return status;
+
+    /*
+     * There is no thread to start.  The server accept loop will call
+     * AuthStep() whenever our stream becomes readable.
+     */
+    m_authState = AUTH_AUTHENTICATING;
+    return ER_OK;
 }
 
-void _TCPEndpoint::AuthStop(void)
+void* _TCPEndpoint::ListenerAuthThread::Run(void* arg)
 {
-    QCC_DbgTrace(("TCPEndpoint::AuthStop()"));
+    QCC_DbgTrace(("TCPEndpoint::ListenerAuthThread::Run()"));
+
+    m_endpoint->DoBlockingAuth();
 
     /*
-     * Ask the auth thread to stop executing.  The only ways out of the thread
-     * run function will set the state to either AUTH_SUCCEEDED or AUTH_FAILED.
-     * There is a very small chance that we will send a stop to the thread after
-     * it has successfully authenticated, but we expect that this will result in
-     * an AUTH_FAILED state for the vast majority of cases.  In this case, we
-     * notice that the thread failed the next time through the main server run
-     * loop, join the thread via AuthJoin below and delete the endpoint.  Note
-     * that this is a lazy cleanup of the endpoint.
+     * The handshake has ended one way or the other.  The server accept loop
+     * will Join() us via AuthJoin() when it releases the endpoint, which does
+     * not block since the next thing we do is exit.
      */
-    m_authThread.Stop();
+    m_endpoint->m_transport->QueueReap(TCPEndpoint::wrap(m_endpoint));
+    return (void*)ER_OK;
 }
 
-void _TCPEndpoint::AuthJoin(void)
+void _TCPEndpoint::DoBlockingAuth(void)
 {
-    QCC_DbgTrace(("TCPEndpoint::AuthJoin()"));
-
     /*
-     * Join the auth thread to stop executing.  All threads must be joined in
-     * order to communicate their return status.  The auth thread is no exception.
-     * This is done in a lazy fashion from the main server accept loop, where we
-     * cleanup every time through the loop.
+     * This is the handshake of DoAuthStep() run to completion with blocking
+     * calls.  Only this thread writes the state variable until it is final.
+     * AuthStop() stops the thread, which makes the blocked reads return an
+     * error that pops out here as an authentication failure.
      */
-    m_authThread.Join();
+    uint8_t byte;
+    size_t nbytes;
+    QStatus status = m_stream.PullBytes(&byte, 1, nbytes);
+    if ((status != ER_OK) || (nbytes != 1) || (byte != 0)) {
+        QCC_LogError(status, ("Failed to read first byte from stream"));
+        m_authState = AUTH_FAILED;
+        return;
+    }
+
+    qcc::String authName;
+    qcc::String redirection;
+    DaemonRouter& router = reinterpret_cast<DaemonRouter&>(m_transport->m_bus.GetInternal().GetRouter());
+    AuthListener* authListener = router.GetBusController()->GetAuthListener();
+    status = Establish(authListener ? "ALLJOYN_PIN_KEYX ANONYMOUS" : "ANONYMOUS", authName, redirection, authListener);
+    if (status == ER_BUS_ENDPOINT_REDIRECTED) {
+        QCC_DbgHLPrintf(("TCPEndpoint::DoBlockingAuth(): Client redirected"));
+        m_authState = AUTH_FAILED;
+        return;
+    }
+    if ((status != ER_OK) || m_listenerAuthThread.IsStopping()) {
+        QCC_LogError(status, ("Failed to establish TCP endpoint"));
+        m_authState = AUTH_FAILED;
+        return;
+    }
+
+    TCPEndpoint tcpEp = TCPEndpoint::wrap(this);
+    m_transport->Authenticated(tcpEp);
+
+    QCC_DbgTrace(("TCPEndpoint::DoBlockingAuth(): Authenticated"));
+
+    m_authState = AUTH_SUCCEEDED;
 }
 
-void* _TCPEndpoint::AuthThread::Run(void* arg)
+void _TCPEndpoint::AuthStep(void)
 {
-    QCC_DbgTrace(("TCPEndpoint::AuthThread::Run()"));
+    QCC_DbgTrace(("TCPEndpoint::AuthStep()"));
 
-    m_endpoint->m_authState = AUTH_AUTHENTICATING;
+    /*
+     * The connection may have been accepted by an acceptor thread, in which
+     * case the server accept loop can scavenge it while that thread is in the
+     * middle of a step.  The lock makes AuthJoin() wait for the step to end.
+     */
+    m_authLock.Lock(MUTEX_CONTEXT);
+    DoAuthStep();
+    AuthState authState = m_authState;
+    m_authLock.Unlock(MUTEX_CONTEXT);
+
+    /* A handshake that has ended has to be released by the server accept loop */
+    if (authState != AUTH_AUTHENTICATING) {
+        m_transport->QueueReap(TCPEndpoint::wrap(this));
+    }
+}
 
+void _TCPEndpoint::DoAuthStep(void)
+{
     /*
-     * We're running an authentication process here and we are cooperating with
-     * the main server thread.  This thread is running in an object that is
-     * allocated on the heap, and the server is managing these objects so we
-     * need to coordinate getting all of this cleaned up.
-     *
-     * There is a state variable that only we write.  The server thread only
-     * reads this variable, so there are no data sharing issues.  If there is an
-     * authentication failure, this thread sets that state variable to
-     * AUTH_FAILED and then exits.  The server holds a list of currently
-     * authenticating connections and will look for AUTH_FAILED connections when
-     * it runs its Accept loop.  If it finds one, it will AuthJoin() this
-     * thread.  Since we set AUTH_FAILED immediately before exiting, there will
-     * be no problem having the server block waiting for the Join() to complete.
-     * We fail authentication here and let the server clean up after us, lazily.
-     *
-     * If we succeed in the authentication process, we set the state variable
-     * to AUTH_SUCEEDED and then call back into the server telling it that we are
-     * up and running.  It needs to take us off of the list of authenticating
-     * connections and put us on the list of running connections.  This thread
-     * will quickly go away and will be replaced by the RX and TX threads of
-     * the running RemoteEndpoint.
-     *
-     * If we are running an authentication process, we are probably ultimately
-     * blocked on a socket.  We expect that if the server is asked to shut
-     * down, it will run through its list of authenticating connections and
-     * AuthStop() each one.  That will cause a thread Stop() which should unblock
-     * all of the reads and return an error which will eventually pop out here
-     * with an authentication failure.
+     * We're running a step of an authentication process here on the accept
+     * loop thread that accepted the connection.  That thread is the only one
+     * that steps the handshake and the server accept loop is the only one that
+     * scavenges the authList so the state variable only goes from
+     * AUTH_AUTHENTICATING to a final state.  Nothing we do here may
+     * block since every other authenticating connection is waiting for us.
+     * When the data we need has not arrived yet we simply return and will be
+     * called again once the stream is readable.
      *
-     * Finally, if the server decides we've spent too much time here and we are
-     * actually a denial of service attack, it can close us down by doing an
-     * AuthStop() on the authenticating endpoint.  This will do a thread Stop()
-     * on the auth thread of the endpoint which will pop out of here as an
-     * authentication failure as well.  The only ways out of this method must be
-     * with state = AUTH_FAILED or state = AUTH_SUCCEEDED.
-     */
-    uint8_t byte;
-    size_t nbytes;
+     * If there is an authentication failure, we set the state variable to
+     * AUTH_FAILED and the accept loop cleans up the connection the next time
+     * through.  If we succeed in the authentication process, we call back into
+     * the server telling it that we are up and running and set the state to
+     * AUTH_SUCCEEDED.  The only ways out of the handshake must be with
+     * state = AUTH_FAILED or state = AUTH_SUCCEEDED.
+     */
+    if (m_authState != AUTH_AUTHENTICATING) {
+        return;
+    }
+
+    QStatus status = ER_OK;
 
     /*
      * Eat the first byte of the stream.  This is required to be zero by the
      * DBus protocol.  It is used in the Unix socket implementation to carry
-     * out-of-band capabilities, but is discarded here.  We do this here since
-     * it involves a read that can block.
-     */
-    QStatus status = m_endpoint->m_stream.PullBytes(&byte, 1, nbytes);
-    if ((status != ER_OK) || (nbytes != 1) || (byte != 0)) {
-        QCC_LogError(status, ("Failed to read first byte from stream"));
-
-        /*
-         * Management of the resources used by the authentication thread is done
-         * in one place, by the server Accept loop.  The authentication thread
-         * writes its state into the connection and the server Accept loop reads
-         * this state.  As soon as we set this state to AUTH_FAILED, we are
-         * telling the Accept loop that we are done with the conn data
-         * structure.  That thread is then free to do anything it wants with the
-         * connection, including deleting it, so we are not allowed to touch
-         * conn after setting this state.
-         *
-         * In addition to releasing responsibility for the conn data structure,
-         * when we set the state to AUTH_SUCCEEDED we are telling the server
-         * accept loop that we are exiting now and so it can Join() on us (the
-         * authentication thread) without being worried about blocking since the
-         * next thing we do is exit.
-         */
-        m_endpoint->m_authState = AUTH_FAILED;
-        return (void*)ER_FAIL;
+     * out-of-band capabilities, but is discarded here.
+     */
+    if (!m_gotNulByte) {
+        uint8_t byte;
+        size_t nbytes;
+        status = m_stream.PullBytes(&byte, 1, nbytes, 0);
+        if ((status == ER_TIMEOUT) || (status == ER_WOULDBLOCK)) {
+            return;
+        }
+        if ((status != ER_OK) || (nbytes != 1) || (byte != 0)) {
+            QCC_LogError(status, ("Failed to read first byte from stream"));
+            m_authState = AUTH_FAILED;
+            return;
+        }
+        m_gotNulByte = true;
     }
 
-    /* Initialized the features for this endpoint */
-    m_endpoint->GetFeatures().isBusToBus = false;
-    m_endpoint->GetFeatures().isBusToBus = false;
-    m_endpoint->GetFeatures().handlePassing = false;
-
-    /* Run the actual connection authentication code. */
+    /* Run the next step of the actual connection authentication code. */
     qcc::String authName;
-    qcc::String redirection;
-    DaemonRouter& router = reinterpret_cast<DaemonRouter&>(m_endpoint->m_transport->m_bus.GetInternal().GetRouter());
+    DaemonRouter& router = reinterpret_cast<DaemonRouter&>(m_transport->m_bus.GetInternal().GetRouter());
     AuthListener* authListener = router.GetBusController()->GetAuthListener();
-    /* Since the TCPTransport allows untrusted clients, it must implement UntrustedClientStart and
-     * UntrustedClientExit.
-     * As a part of Establish, the endpoint can call the Transport's UntrustedClientStart method if
-     * it is an untrusted client, so the transport MUST call m_endpoint->SetListener before calling Establish
-     * Note: This is only required on the accepting end i.e. for incoming endpoints.
-     */
-    m_endpoint->SetListener(m_endpoint->m_transport);
     if (authListener) {
-        status = m_endpoint->Establish("ALLJOYN_PIN_KEYX ANONYMOUS", authName, redirection, authListener);
+        status = EstablishNonBlocking("ALLJOYN_PIN_KEYX ANONYMOUS", authName, authListener);
     } else {
-        status = m_endpoint->Establish("ANONYMOUS", authName, redirection, authListener);
+        status = EstablishNonBlocking("ANONYMOUS", authName, authListener);
+    }
+    if (status == ER_WOULDBLOCK) {
+        return;
+    }
+    if (status == ER_BUS_ENDPOINT_REDIRECTED) {
+        QCC_DbgHLPrintf(("TCPEndpoint::AuthStep(): Client redirected"));
+        m_authState = AUTH_FAILED;
+        return;
     }
     if (status != ER_OK) {
         QCC_LogError(status, ("Failed to establish TCP endpoint"));
-
-        /*
-         * Management of the resources used by the authentication thread is done
-         * in one place, by the server Accept loop.  The authentication thread
-         * writes its state into the connection and the server Accept loop reads
-         * this state.  As soon as we set this state to AUTH_FAILED, we are
-         * telling the Accept loop that we are done with the conn data
-         * structure.  That thread is then free to do anything it wants with the
-         * connection, including deleting it, so we are not allowed to touch
-         * conn after setting this state.
-         *
-         * In addition to releasing responsibility for the conn data structure,
-         * when we set the state to AUTH_SUCCEEDED we are telling the server
-         * accept loop that we are exiting now and so it can Join() on us (the
-         * authentication thread) without being worried about blocking since the
-         * next thing we do is exit.
-         */
-        m_endpoint->m_authState = AUTH_FAILED;
-        return (void*)status;
+        m_authState = AUTH_FAILED;
+        return;
     }
 
     /*
      * Tell the transport that the authentication has succeeded and that it can
      * now bring the connection up.
      */
-    TCPEndpoint tcpEp = TCPEndpoint::wrap(m_endpoint);
-    m_endpoint->m_transport->Authenticated(tcpEp);
+    TCPEndpoint tcpEp = TCPEndpoint::wrap(this);
+    m_transport->Authenticated(tcpEp);
 
-    QCC_DbgTrace(("TCPEndpoint::AuthThread::Run(): Returning"));
+    QCC_DbgTrace(("TCPEndpoint::AuthStep(): Authenticated"));
+
+    m_authState = AUTH_SUCCEEDED;
+}
+
+void _TCPEndpoint::AuthStop(void)
+{
+    QCC_DbgTrace(("TCPEndpoint::AuthStop()"));
 
     /*
-     * We are now done with the authentication process.  We have succeeded doing
-     * the authentication and we may or may not have succeeded in starting the
-     * endpoint TX and RX threads depending on what happened down in
-     * Authenticated().  What concerns us here is that we are done with this
-     * thread (the authentication thread) and we are about to exit.  Before
-     * exiting, we must tell server accept loop that we are done with this data
-     * structure.  As soon as we set this state to AUTH_SUCCEEDED that thread is
-     * then free to do anything it wants with the connection, including deleting
-     * it, so we are not allowed to touch conn after setting this state.
+     * Fail an authentication that has not finished yet.  The handshake will
+     * not be stepped again and the main server run loop will notice the
+     * AUTH_FAILED state the next time through, release the handshake via
+     * AuthJoin below and delete the endpoint.  Note that this is a lazy
+     * cleanup of the endpoint.
      *
-     * In addition to releasing responsibility for the conn data structure, when
-     * we set the state to AUTH_SUCCEEDED we are telling the server accept loop
-     * that we are exiting now and so it can Join() the authentication thread
-     * without being worried about blocking since the next thing we do is exit.
+     * A handshake with a thread of its own sets its final state itself, so
+     * we only ask that thread to stop.  Its reads fail and it exits with
+     * AUTH_FAILED (unless it happens to be just finishing, which is okay).
      */
-    m_endpoint->m_authState = AUTH_SUCCEEDED;
-    return (void*)status;
+    if (m_blockingAuth) {
+        m_listenerAuthThread.Stop();
+        return;
+    }
+    if (m_authState == AUTH_AUTHENTICATING) {
+        m_authState = AUTH_FAILED;
+    }
+}
+
+void _TCPEndpoint::AuthJoin(void)
+{
+    QCC_DbgTrace(("TCPEndpoint::AuthJoin()"));
+
+    /*
+     * Release any handshake that is still in progress.  The handshake holds a
+     * reference to this endpoint so it must be released before the endpoint
+     * can go away.  This is done in a lazy fashion from the main server accept
+     * loop, where we cleanup every time through the loop.  A handshake with a
+     * thread of its own is released by joining that thread.
+     */
+    if (m_blockingAuth) {
+        m_listenerAuthThread.Join();
+        return;
+    }
+    m_authLock.Lock(MUTEX_CONTEXT);
+    AbortEstablish();
+    m_authLock.Unlock(MUTEX_CONTEXT);
 }
 
 TCPTransport::TCPTransport(BusAttachment& bus)
     : Thread("TCPTransport"), m_bus(bus), m_stopping(false), m_listener(0),
+    m_authWheel(GetTimestamp64(), AUTH_WHEEL_TICK_MS), m_authTimeoutMs(ALLJOYN_AUTH_TIMEOUT_DEFAULT),
     m_foundCallback(m_listener),
     m_isAdvertising(false), m_isDiscovering(false), m_isListening(false),
     m_isNsEnabled(false), m_reload(false),
     m_listenPort(0), m_nsReleaseCount(0),
-    m_maxUntrustedClients(0), m_numUntrustedClients(0)
+    m_maxUntrustedClients(0), m_numUntrustedClients(0),
+    m_redirectNext(0), m_redirectMaxConnections(0), m_redirectMaxQueueDepth(0), m_redirectMaxLoad(0)
 {
     QCC_DbgTrace(("TCPTransport::TCPTransport()"));
     /*
@@ -823,7 +959,7 @@ void TCPTransport::Authenticated(TCPEndpoint& conn)
     }
     /*
      * If Authenticated() is being called, it is as a result of the
-     * authentication thread telling us that it has succeeded.  What we need to
+     * authentication handshake telling us that it has succeeded.  What we need to
      * do here is to try and Start() the endpoint which will spin up its TX and
      * RX threads and register the endpoint with the daemon router.  As soon as
      * we call Start(), we are transferring responsibility for error reporting
@@ -835,7 +971,17 @@ void TCPTransport::Authenticated(TCPEndpoint& conn)
     m_endpointListLock.Lock(MUTEX_CONTEXT);
 
     set<TCPEndpoint>::iterator i = find(m_authList.begin(), m_authList.end(), conn);
-    assert(i != m_authList.end() && "TCPTransport::Authenticated(): Conn not on m_authList");
+
+    /*
+     * A connection stepped by an acceptor thread may have been timed out and
+     * scavenged by the server accept loop while its last step was running.
+     * Nobody is waiting for it any more so it is simply dropped.
+     */
+    if (i == m_authList.end()) {
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        QCC_DbgHLPrintf(("TCPTransport::Authenticated(): Conn was scavenged while authenticating"));
+        return;
+    }
 
     /*
      * Note here that we have not yet marked the authState as AUTH_SUCCEEDED so
@@ -843,6 +989,7 @@ void TCPTransport::Authenticated(TCPEndpoint& conn)
      * and the endpoint can be on the endpointList and not the authList.
      */
     m_authList.erase(i);
+    m_authWheel.Remove(conn->GetAuthTimeout());
     m_endpointList.insert(conn);
 
     m_endpointListLock.Unlock(MUTEX_CONTEXT);
@@ -908,6 +1055,17 @@ QStatus TCPTransport::Start()
 
     m_stopping = false;
 
+    /*
+     * When this daemon gets too busy, new clients are sent on to the next
+     * daemon of the redirection pool in turn.
+     */
+    DaemonConfig* config = DaemonConfig::Access();
+    m_redirectPool = config->GetList("tcp/redirect");
+    m_redirectNext = 0;
+    m_redirectMaxConnections = config->Get("tcp/property@redirect_connections", ALLJOYN_TCP_REDIRECT_THRESHOLD_DEFAULT);
+    m_redirectMaxQueueDepth = config->Get("tcp/property@redirect_queue_depth", ALLJOYN_TCP_REDIRECT_THRESHOLD_DEFAULT);
+    m_redirectMaxLoad = config->Get("tcp/property@redirect_load", ALLJOYN_TCP_REDIRECT_THRESHOLD_DEFAULT);
+
     /*
      * Get the guid from the bus attachment which will act as the globally unique
      * ID of the daemon.
@@ -972,6 +1130,15 @@ QStatus TCPTransport::Stop(void)
         return status;
     }
 
+    /*
+     * Ask any extra accept loops to shut down too, they are joined in Join().
+     */
+    m_listenFdsLock.Lock(MUTEX_CONTEXT);
+    for (list<Acceptor*>::iterator i = m_acceptors.begin(); i != m_acceptors.end(); ++i) {
+        (*i)->Stop();
+    }
+    m_listenFdsLock.Unlock(MUTEX_CONTEXT);
+
     m_endpointListLock.Lock(MUTEX_CONTEXT);
 
     /*
@@ -987,11 +1154,11 @@ QStatus TCPTransport::Stop(void)
     }
 
     /*
-     * Ask any authenticating endpoints to shut down and exit their threads.  By its
-     * presence on the m_authList, we know that the endpoint is authenticating and
-     * the authentication thread has responsibility for dealing with the endpoint
-     * data structure.  We call Stop() to stop that thread from running.  The
-     * endpoint Rx and Tx threads will not be running yet.
+     * Ask any authenticating endpoints to give up.  By its presence on the
+     * m_authList, we know that the endpoint is authenticating and the server
+     * accept loop has responsibility for stepping the handshake.  We call
+     * AuthStop() to fail the handshake.  The endpoint Rx and Tx threads will
+     * not be running yet.
      */
     for (set<TCPEndpoint>::iterator i = m_authList.begin(); i != m_authList.end(); ++i) {
         TCPEndpoint ep = *i;
@@ -1043,6 +1210,12 @@ QStatus TCPTransport::Join(void)
         IpNameService::Instance().Release();
     }
 
+    /*
+     * The extra accept loops must be gone before we release the handshakes
+     * below since they may still be stepping some of them.
+     */
+    StopAcceptors(NULL);
+
     /*
      * A required call to Stop() that needs to happen before this Join will ask
      * all of the endpoints to stop; and will also cause any authenticating
@@ -1050,21 +1223,24 @@ QStatus TCPTransport::Join(void)
      * running in those endpoints actually stop running.
      *
      * Since Stop() is a request to stop, and this is what has ultimately been
-     * done to both authentication threads and Rx and Tx threads, it is possible
-     * that a thread is actually running after the call to Stop().  If that
-     * thead happens to be an authenticating endpoint, it is possible that an
-     * authentication actually completes after Stop() is called.  This will move
-     * a connection from the m_authList to the m_endpointList, so we need to
-     * make sure we wait for all of the connections on the m_authList to go away
-     * before we look for the connections on the m_endpointlist.
+     * done to both the server accept loop and Rx and Tx threads, it is possible
+     * that a thread is actually running after the call to Stop().  If the
+     * server accept loop happens to be stepping an authenticating endpoint, it
+     * is possible that an authentication actually completes after Stop() is
+     * called.  This will move a connection from the m_authList to the
+     * m_endpointList, so we need to make sure we deal with all of the
+     * connections on the m_authList before we look for the connections on the
+     * m_endpointlist.
      */
     m_endpointListLock.Lock(MUTEX_CONTEXT);
 
     /*
-     * Any authenticating endpoints have been asked to shut down and exit their
-     * authentication threads in a previously required Stop().  We need to
-     * Join() all of these auth threads here.
+     * Any authenticating endpoints have been failed in a previously required
+     * Stop() and the server accept loop has exited, so nothing will step them
+     * again.  We need to release all of their handshakes here.
      */
+    vector<TimingWheel::Entry*> unscheduled;
+    m_authWheel.RemoveAll(unscheduled);
     set<TCPEndpoint>::iterator it = m_authList.begin();
     while (it != m_authList.end()) {
         TCPEndpoint ep = *it;
@@ -1080,7 +1256,7 @@ QStatus TCPTransport::Join(void)
      * Any running endpoints have been asked it their threads in a previously
      * required Stop().  We need to Join() all of thesse threads here.  This
      * Join() will wait on the endpoint rx and tx threads to exit as opposed to
-     * the joining of the auth thread we did above.
+     * the releasing of the handshakes we did above.
      */
     it = m_endpointList.begin();
     while (it != m_endpointList.end()) {
@@ -1094,6 +1270,11 @@ QStatus TCPTransport::Join(void)
 
     m_endpointListLock.Unlock(MUTEX_CONTEXT);
 
+    /* Everything has been cleaned up so the queued endpoints need no more attention */
+    m_reapLock.Lock(MUTEX_CONTEXT);
+    m_reapQueue.clear();
+    m_reapLock.Unlock(MUTEX_CONTEXT);
+
     m_stopping = false;
     return ER_OK;
 }
@@ -1350,175 +1531,202 @@ void TCPTransport::EndpointExit(RemoteEndpoint& ep)
     /*
      * Wake up the server accept loop so that it deals with our passing immediately.
      */
+    QueueReap(tep);
+}
+
+void TCPTransport::QueueReap(const TCPEndpoint& ep)
+{
+    m_reapLock.Lock(MUTEX_CONTEXT);
+    m_reapQueue.push_back(ep);
+    m_reapLock.Unlock(MUTEX_CONTEXT);
     Alert();
 }
 
-void TCPTransport::ManageEndpoints(Timespec tTimeout)
+void TCPTransport::ManageEndpoints()
 {
-    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    vector<TCPEndpoint> reap;
 
     /*
-     * Run through the list of connections on the authList and cleanup
-     * any that are no longer running or are taking too long to authenticate
-     * (we assume a denial of service attack in this case).
+     * Stop the authentication of connections that are taking too long to
+     * authenticate (we assume a denial of service attack in this case).  The
+     * wheel only hands back the ones whose time is up.
      */
-    set<TCPEndpoint>::iterator i = m_authList.begin();
-    while (i != m_authList.end()) {
-        TCPEndpoint ep = *i;
-        _TCPEndpoint::AuthState authState = ep->GetAuthState();
+    vector<TimingWheel::Entry*> expired;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_authWheel.Advance(GetTimestamp64(), expired);
+    for (vector<TimingWheel::Entry*>::iterator i = expired.begin(); i != expired.end(); ++i) {
+        TCPEndpoint ep = TCPEndpoint::wrap(static_cast<_TCPEndpoint::AuthTimeout*>(*i)->endpoint);
+        QCC_DbgHLPrintf(("TCPTransport::ManageEndpoints(): Scavenging slow authenticator"));
+        ep->AuthStop();
+        reap.push_back(ep);
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    m_reapLock.Lock(MUTEX_CONTEXT);
+    reap.insert(reap.end(), m_reapQueue.begin(), m_reapQueue.end());
+    m_reapQueue.clear();
+    m_reapLock.Unlock(MUTEX_CONTEXT);
+
+    for (vector<TCPEndpoint>::iterator i = reap.begin(); i != reap.end(); ++i) {
+        ReapEndpoint(*i);
+    }
+}
 
-        if (authState == _TCPEndpoint::AUTH_FAILED) {
+void TCPTransport::ReapEndpoint(TCPEndpoint& ep)
+{
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+
+    /*
+     * An endpoint may be queued more than once, or after it has gone, so we
+     * look it up rather than assuming where it is.
+     */
+    set<TCPEndpoint>::iterator i = m_authList.find(ep);
+    if (i != m_authList.end()) {
+        if (ep->GetAuthState() == _TCPEndpoint::AUTH_FAILED) {
             /*
-             * The endpoint has failed authentication and the auth thread is
-             * gone or is going away.  Since it has failed there is no way this
-             * endpoint is going to be started so we can get rid of it as soon
-             * as we Join() the (failed) authentication thread.
+             * The endpoint has failed authentication.  Since it has failed
+             * there is no way this endpoint is going to be started so we can
+             * get rid of it as soon as we release the (failed) handshake.
              */
-            QCC_DbgHLPrintf(("TCPTransport::ManageEndpoints(): Scavenging failed authenticator"));
+            QCC_DbgHLPrintf(("TCPTransport::ReapEndpoint(): Scavenging failed authenticator"));
             m_authList.erase(i);
+            m_authWheel.Remove(ep->GetAuthTimeout());
             m_endpointListLock.Unlock(MUTEX_CONTEXT);
             ep->AuthJoin();
-            m_endpointListLock.Lock(MUTEX_CONTEXT);
-            i = m_authList.upper_bound(ep);
-            continue;
+            return;
         }
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
 
-        Timespec tNow;
-        GetTimeNow(&tNow);
-
-        if (ep->GetStartTime() + tTimeout < tNow) {
-            /*
-             * This endpoint is taking too long to authenticate.  Stop the
-             * authentication process.  The auth thread is still running, so we
-             * can't just delete the connection, we need to let it stop in its
-             * own time.  What that thread will do is to set AUTH_FAILED and
-             * exit.  we will then clean it up the next time through this loop.
-             * In the hope that the thread can exit and we can catch its exit
-             * here and now, we take our thread off the OS ready list (Sleep)
-             * and let the other thread run before looping back.
-             */
-            QCC_DbgHLPrintf(("TCPTransport::ManageEndpoints(): Scavenging slow authenticator"));
-            ep->AuthStop();
-            qcc::Sleep(1);
-        }
-        ++i;
+    /*
+     * We are only managing passive connections here, or active connections
+     * that are done and are explicitly ready to be cleaned up.
+     */
+    i = m_endpointList.find(ep);
+    if ((i == m_endpointList.end()) || (ep->GetSideState() == _TCPEndpoint::SIDE_ACTIVE)) {
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        return;
     }
 
     /*
-     * We've handled the authList, so now run through the list of connections on
-     * the endpointList and cleanup any that are no longer running or Join()
-     * authentication threads that have successfully completed.
+     * Authenticated() has moved the endpoint over but its final step has not
+     * returned yet.  The step queues the endpoint again once it has.
      */
-    i = m_endpointList.begin();
-    while (i != m_endpointList.end()) {
-        TCPEndpoint ep = *i;
+    if (ep->GetAuthState() == _TCPEndpoint::AUTH_AUTHENTICATING) {
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
 
+    if (ep->GetAuthState() == _TCPEndpoint::AUTH_SUCCEEDED) {
         /*
-         * We are only managing passive connections here, or active connections
-         * that are done and are explicitly ready to be cleaned up.
+         * The endpoint has succeeded authentication.  Take this
+         * opportunity to release the handshake.  Since the handshake is
+         * never stepped after setting AUTH_SUCCEEEDED, we can safely change
+         * the state here since we now own the conn.  We do this through a
+         * method call to enable this single special case where we are
+         * allowed to set the state.
          */
-        _TCPEndpoint::SideState sideState = ep->GetSideState();
-        if (sideState == _TCPEndpoint::SIDE_ACTIVE) {
-            ++i;
-            continue;
-        }
-
-        _TCPEndpoint::AuthState authState = ep->GetAuthState();
-        _TCPEndpoint::EndpointState endpointState = ep->GetEpState();
-
-        if (authState == _TCPEndpoint::AUTH_SUCCEEDED) {
-            /*
-             * The endpoint has succeeded authentication and the auth thread is
-             * gone or is going away.  Take this opportunity to join the auth
-             * thread.  Since the auth thread promised not to touch the state
-             * after setting AUTH_SUCCEEEDED, we can safely change the state
-             * here since we now own the conn.  We do this through a method call
-             * to enable this single special case where we are allowed to set
-             * the state.
-             */
-            QCC_DbgHLPrintf(("TCPTransport::ManageEndpoints(): Scavenging failed authenticator"));
+        QCC_DbgHLPrintf(("TCPTransport::ReapEndpoint(): Releasing handshake of authenticated endpoint"));
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        ep->AuthJoin();
+        ep->SetAuthDone();
+        m_endpointListLock.Lock(MUTEX_CONTEXT);
+        i = m_endpointList.find(ep);
+        if (i == m_endpointList.end()) {
             m_endpointListLock.Unlock(MUTEX_CONTEXT);
-            ep->AuthJoin();
-            ep->SetAuthDone();
-            m_endpointListLock.Lock(MUTEX_CONTEXT);
-            i = m_endpointList.upper_bound(ep);
-            continue;
+            return;
         }
+    }
 
-        /*
-         * There are two possibilities for the disposition of the RX and
-         * TX threads.  First, they were never successfully started.  In
-         * this case, the epState will be EP_FAILED.  If we find this, we
-         * can just remove the useless endpoint from the list and delete
-         * it.  Since the threads were never started, they must not be
-         * joined.
-         */
-        if (endpointState == _TCPEndpoint::EP_FAILED) {
-            m_endpointList.erase(i);
-            i = m_endpointList.upper_bound(ep);
-            continue;
-        }
+    _TCPEndpoint::EndpointState endpointState = ep->GetEpState();
 
-        /*
-         * The second possibility for the disposition of the RX and
-         * TX threads is that they were successfully started but
-         * have been stopped for some reason, either because of a
-         * Disconnect() or a network error.  In this case, the
-         * epState will be EP_STOPPING, which was set in the
-         * EndpointExit function.  If we find this, we need to Join
-         * the endpoint threads, remove the endpoint from the
-         * endpoint list and delete it.  Note that we are calling
-         * the endpoint Join() to join the TX and RX threads and not
-         * the endpoint AuthJoin() to join the auth thread.
-         */
-        if (endpointState == _TCPEndpoint::EP_STOPPING) {
-            m_endpointList.erase(i);
-            m_endpointListLock.Unlock(MUTEX_CONTEXT);
-            ep->Join();
-            m_endpointListLock.Lock(MUTEX_CONTEXT);
-            i = m_endpointList.upper_bound(ep);
-            continue;
-        }
-        ++i;
+    /*
+     * There are two possibilities for the disposition of the RX and TX
+     * threads.  First, they were never successfully started.  In this case,
+     * the epState will be EP_FAILED.  If we find this, we can just remove the
+     * useless endpoint from the list and delete it.  Since the threads were
+     * never started, they must not be joined.
+     */
+    if (endpointState == _TCPEndpoint::EP_FAILED) {
+        m_endpointList.erase(i);
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
+
+    /*
+     * The second possibility for the disposition of the RX and TX threads is
+     * that they were successfully started but have been stopped for some
+     * reason, either because of a Disconnect() or a network error.  In this
+     * case, the epState will be EP_STOPPING, which was set in the EndpointExit
+     * function, which also queued the endpoint for us.  If we find this, we
+     * need to Join the endpoint threads, remove the endpoint from the endpoint
+     * list and delete it.  Note that we are calling the endpoint Join() to
+     * join the TX and RX threads and not the endpoint AuthJoin() to release
+     * the handshake.
+     */
+    if (endpointState == _TCPEndpoint::EP_STOPPING) {
+        m_endpointList.erase(i);
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        ep->Join();
+        return;
     }
     m_endpointListLock.Unlock(MUTEX_CONTEXT);
 }
 
-void* TCPTransport::Run(void* arg)
+/*
+ * We need to find the defaults for our connection limits.  These limits
+ * can be specified in the configuration database with corresponding limits
+ * used for DBus.  If any of those are present, we use them, otherwise we
+ * provide some hopefully reasonable defaults.  They come from the resolved
+ * configuration snapshot, which is cheap enough to read every time through
+ * an accept loop, so a reloaded configuration applies to the next connection.
+ */
+static void GetConnectionLimits(uint32_t& authTimeoutMs, uint32_t& maxAuth, uint32_t& maxConn)
 {
-    QCC_DbgTrace(("TCPTransport::Run()"));
+    DaemonConfig::Snapshot limits = DaemonConfig::Access()->GetSnapshot();
 
     /*
-     * We need to find the defaults for our connection limits.  These limits
-     * can be specified in the configuration database with corresponding limits
-     * used for DBus.  If any of those are present, we use them, otherwise we
-     * provide some hopefully reasonable defaults.
-     */
-    DaemonConfig* config = DaemonConfig::Access();
-
-    /*
-     * tTimeout is the maximum amount of time we allow incoming connections to
+     * authTimeoutMs is the maximum amount of time we allow incoming connections to
      * mess about while they should be authenticating.  If they take longer
      * than this time, we feel free to disconnect them as deniers of service.
      */
-    Timespec tTimeout = config->Get("limit@auth_timeout", ALLJOYN_AUTH_TIMEOUT_DEFAULT);
+    authTimeoutMs = limits.authTimeout.Get(ALLJOYN_AUTH_TIMEOUT_DEFAULT);
 
     /*
      * maxAuth is the maximum number of incoming connections that can be in
      * the process of authenticating.  If starting to authenticate a new
      * connection would mean exceeding this number, we drop the new connection.
      */
-    uint32_t maxAuth = config->Get("limit@max_incomplete_connections", ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_TCP_DEFAULT);
+    maxAuth = limits.maxIncompleteConnections.Get(ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_TCP_DEFAULT);
 
     /*
      * maxConn is the maximum number of active connections possible over the
      * TCP transport.  If starting to process a new connection would mean
      * exceeding this number, we drop the new connection.
      */
-    uint32_t maxConn = config->Get("limit@max_completed_connections", ALLJOYN_MAX_COMPLETED_CONNECTIONS_TCP_DEFAULT);
+    maxConn = limits.maxCompletedConnections.Get(ALLJOYN_MAX_COMPLETED_CONNECTIONS_TCP_DEFAULT);
+}
+
+void* TCPTransport::Run(void* arg)
+{
+    QCC_DbgTrace(("TCPTransport::Run()"));
+
+    uint32_t authTimeoutMs;
+    uint32_t maxAuth;
+    uint32_t maxConn;
+    GetConnectionLimits(authTimeoutMs, maxAuth, maxConn);
+    m_authTimeoutMs = authTimeoutMs;
 
     QStatus status = ER_OK;
 
+    /*
+     * Where the platform has one, the sockets of authenticating connections
+     * are watched with a kqueue rather than handed to every wait.
+     */
+    ReadySet readySet;
+    ReadySet* authSet = (ReadySet::IsSupported() && (readySet.Init() == ER_OK)) ? &readySet : NULL;
+
     while (!IsStopping()) {
 
         /*
@@ -1555,23 +1763,55 @@ void* TCPTransport::Run(void* arg)
         }
         m_listenFdsLock.Unlock(MUTEX_CONTEXT);
 
+        /*
+         * We also wait on the streams of the connections that are in the
+         * middle of authenticating so we can step their handshakes as their
+         * data arrives.  These events belong to the streams, so we remember
+         * which ones they are in order to not delete them below.
+         */
+        map<void*, TCPEndpoint> authEvents;
+        GetAuthEvents(this, authSet, authEvents, checkEvents);
+
         /*
          * We have our list of events, so now wait for something to happen
-         * on that list (or get alerted).
+         * on that list (or get alerted), but no longer than it takes the
+         * next authenticating connection to time out.
          */
+        uint32_t waitMs = Event::WAIT_FOREVER;
+        uint64_t when;
+        m_endpointListLock.Lock(MUTEX_CONTEXT);
+        if (m_authWheel.NextExpiry(when)) {
+            uint64_t now = GetTimestamp64();
+            waitMs = (when > now) ? static_cast<uint32_t>(when - now) : 0;
+        }
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
         signaledEvents.clear();
 
-        status = Event::Wait(checkEvents, signaledEvents);
+        status = Event::Wait(checkEvents, signaledEvents, waitMs);
+        if (ER_TIMEOUT == status) {
+            status = ER_OK;
+        }
         if (ER_OK != status) {
             QCC_LogError(status, ("Event::Wait failed"));
             break;
         }
 
         /*
-         * We're back from our Wait() so one of three things has happened.  Our
-         * thread has been asked to Stop(), our thread has been Alert()ed, or
-         * one of the socketFds we are listening on for connecte events has
-         * becomed signalled.
+         * In order to rationalize management of resources, we manage the
+         * various lists in one place on one thread.  This thread is a
+         * convenient victim, so we do it here.
+         */
+        ManageEndpoints();
+
+        GetConnectionLimits(authTimeoutMs, maxAuth, maxConn);
+        m_authTimeoutMs = authTimeoutMs;
+
+        /*
+         * We're back from our Wait() so one of four things has happened.  Our
+         * thread has been asked to Stop(), our thread has been Alert()ed, one
+         * of the socketFds we are listening on for connecte events has becomed
+         * signalled, or an authenticating connection has more data for us.
          *
          * If we have been asked to Stop(), or our thread has been Alert()ed,
          * the stopEvent will be on the list of signalled events.  The
@@ -1580,13 +1820,6 @@ void* TCPTransport::Run(void* arg)
          * on a given address and port has been queued up for us.
          */
         for (vector<Event*>::iterator i = signaledEvents.begin(); i != signaledEvents.end(); ++i) {
-            /*
-             * In order to rationalize management of resources, we manage the
-             * various lists in one place on one thread.  This thread is a
-             * convenient victim, so we do it here.
-             */
-            ManageEndpoints(tTimeout);
-
             /*
              * Reset an existing Alert() or Stop().  If it's an alert, we
              * will deal with looking for the incoming listen requests at
@@ -1599,76 +1832,21 @@ void* TCPTransport::Run(void* arg)
             }
 
             /*
-             * Since the current event is not the stop event, it must reflect at
-             * least one of the SocketFds we are waiting on for incoming
-             * connections.  Go ahead and Accept() the new connection on the
-             * current SocketFd.
+             * An authenticating connection has data for us, so run as much of
+             * its handshake as we can without blocking.  AuthStep() ignores
+             * connections that ManageEndpoints() has just failed.
              */
-            IPAddress remoteAddr;
-            uint16_t remotePort;
-            SocketFd newSock;
-
-            while (true) {
-                status = Accept((*i)->GetFD(), remoteAddr, remotePort, newSock);
-                if (status != ER_OK) {
-                    break;
-                }
-
-                QCC_DbgHLPrintf(("TCPTransport::Run(): Accepting connection newSock=%d", newSock));
-
-                QCC_DbgPrintf(("TCPTransport::Run(): maxAuth == %d", maxAuth));
-                QCC_DbgPrintf(("TCPTransport::Run(): maxConn == %d", maxConn));
-                QCC_DbgPrintf(("TCPTransport::Run(): mAuthList.size() == %d", m_authList.size()));
-                QCC_DbgPrintf(("TCPTransport::Run(): mEndpointList.size() == %d", m_endpointList.size()));
-                assert(m_authList.size() + m_endpointList.size() <= maxConn);
-
-                /*
-                 * Do we have a slot available for a new connection?  If so, use
-                 * it.
-                 */
-                m_endpointListLock.Lock(MUTEX_CONTEXT);
-                if ((m_authList.size() < maxAuth) && (m_authList.size() + m_endpointList.size() < maxConn)) {
-                    static const bool truthiness = true;
-                    TCPTransport* ptr = this;
-                    TCPEndpoint conn(ptr, m_bus, truthiness, TCPTransport::TransportName, newSock, remoteAddr, remotePort);
-                    conn->SetPassive();
-                    Timespec tNow;
-                    GetTimeNow(&tNow);
-                    conn->SetStartTime(tNow);
-                    /*
-                     * By putting the connection on the m_authList, we are
-                     * transferring responsibility for the connection to the
-                     * Authentication thread.  Therefore, we must check that the
-                     * thread actually started running to ensure the handoff
-                     * worked.  If it didn't we need to deal with the connection
-                     * here.  Since there are no threads running we can just
-                     * pitch the connection.
-                     */
-                    std::pair<std::set<TCPEndpoint>::iterator, bool> ins = m_authList.insert(conn);
-                    status = conn->Authenticate();
-                    if (status != ER_OK) {
-                        m_authList.erase(ins.first);
-                    }
-                    m_endpointListLock.Unlock(MUTEX_CONTEXT);
-                } else {
-                    m_endpointListLock.Unlock(MUTEX_CONTEXT);
-                    qcc::Shutdown(newSock);
-                    qcc::Close(newSock);
-                    status = ER_AUTH_FAIL;
-                    QCC_LogError(status, ("TCPTransport::Run(): No slot for new connection"));
-                }
+            if (StepAuthentications(*i, authSet, authEvents)) {
+                continue;
             }
 
             /*
-             * Accept returns ER_WOULDBLOCK when all of the incoming connections have been handled
+             * Since the current event is not the stop event, it must reflect at
+             * least one of the SocketFds we are waiting on for incoming
+             * connections.  Go ahead and Accept() the new connection on the
+             * current SocketFd.
              */
-            if (ER_WOULDBLOCK == status) {
-                status = ER_OK;
-            }
-
-            if (status != ER_OK) {
-                QCC_LogError(status, ("TCPTransport::Run(): Error accepting new connection. Ignoring..."));
-            }
+            status = AcceptConnections((*i)->GetFD(), this, maxAuth, maxConn);
         }
 
         /*
@@ -1677,7 +1855,7 @@ void* TCPTransport::Run(void* arg)
          * created on this iteration.
          */
         for (vector<Event*>::iterator i = checkEvents.begin(); i != checkEvents.end(); ++i) {
-            if (*i != &stopEvent) {
+            if ((*i != &stopEvent) && (!authSet || (*i != &authSet->GetEvent())) && (authEvents.find(*i) == authEvents.end())) {
                 delete *i;
             }
         }
@@ -1704,6 +1882,207 @@ void* TCPTransport::Run(void* arg)
     return (void*) status;
 }
 
+void TCPTransport::GetAuthEvents(qcc::Thread* acceptor, ReadySet* readySet, map<void*, TCPEndpoint>& authEvents, vector<Event*>& checkEvents)
+{
+    vector<ReadySet::Entry> entries;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    for (set<TCPEndpoint>::iterator i = m_authList.begin(); i != m_authList.end(); ++i) {
+        TCPEndpoint ep = *i;
+        if ((ep->GetAuthThread() == acceptor) && !ep->IsBlockingAuth() && (ep->GetAuthState() == _TCPEndpoint::AUTH_AUTHENTICATING)) {
+            if (readySet) {
+                void* key = &(*ep);
+                authEvents[key] = ep;
+                entries.push_back(ReadySet::Entry(ep->GetSocketFd(), key, ep->GetStartTime().GetAbsoluteMillis()));
+            } else {
+                Event* ev = &ep->GetSourceEvent();
+                authEvents[ev] = ep;
+                checkEvents.push_back(ev);
+            }
+        }
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    if (readySet) {
+        readySet->Update(entries);
+        checkEvents.push_back(&readySet->GetEvent());
+    }
+}
+
+bool TCPTransport::StepAuthentications(Event* signaled, ReadySet* readySet, map<void*, TCPEndpoint>& authEvents)
+{
+    if (readySet && (signaled == &readySet->GetEvent())) {
+        vector<void*> keys;
+        readySet->GetReady(keys);
+        for (vector<void*>::iterator k = keys.begin(); k != keys.end(); ++k) {
+            map<void*, TCPEndpoint>::iterator ait = authEvents.find(*k);
+            if (ait != authEvents.end()) {
+                ait->second->AuthStep();
+            }
+        }
+        return true;
+    }
+    map<void*, TCPEndpoint>::iterator ait = authEvents.find(signaled);
+    if (ait != authEvents.end()) {
+        ait->second->AuthStep();
+        return true;
+    }
+    return false;
+}
+
+QStatus TCPTransport::AcceptConnections(qcc::SocketFd listenFd, qcc::Thread* acceptor, uint32_t maxAuth, uint32_t maxConn)
+{
+    QStatus status;
+    IPAddress remoteAddr;
+    uint16_t remotePort;
+    SocketFd newSock;
+
+    while (true) {
+        status = Accept(listenFd, remoteAddr, remotePort, newSock);
+        if (status != ER_OK) {
+            break;
+        }
+
+        QCC_DbgHLPrintf(("TCPTransport::AcceptConnections(): Accepting connection newSock=%d", newSock));
+
+        QCC_DbgPrintf(("TCPTransport::AcceptConnections(): maxAuth == %d", maxAuth));
+        QCC_DbgPrintf(("TCPTransport::AcceptConnections(): maxConn == %d", maxConn));
+        QCC_DbgPrintf(("TCPTransport::AcceptConnections(): mAuthList.size() == %d", m_authList.size()));
+        QCC_DbgPrintf(("TCPTransport::AcceptConnections(): mEndpointList.size() == %d", m_endpointList.size()));
+        assert(m_authList.size() + m_endpointList.size() <= maxConn);
+
+        /*
+         * Do we have a slot available for a new connection?  If so, use
+         * it.
+         */
+        m_endpointListLock.Lock(MUTEX_CONTEXT);
+        if ((m_authList.size() < maxAuth) && (m_authList.size() + m_endpointList.size() < maxConn)) {
+            static const bool truthiness = true;
+            TCPTransport* ptr = this;
+            TCPEndpoint conn(ptr, m_bus, truthiness, TCPTransport::TransportName, newSock, remoteAddr, remotePort);
+            conn->SetPassive();
+            conn->SetAuthThread(acceptor);
+            Timespec tNow;
+            GetTimeNow(&tNow);
+            conn->SetStartTime(tNow);
+            /*
+             * By putting the connection on the m_authList, we are
+             * arranging for its handshake to be stepped by the accept
+             * loop that accepted it.  We must still check that the
+             * authentication actually began.  If it didn't we need to
+             * deal with the connection here.  Since there are no
+             * threads running we can just pitch the connection.
+             */
+            std::pair<std::set<TCPEndpoint>::iterator, bool> ins = m_authList.insert(conn);
+            status = conn->Authenticate();
+            if (status == ER_OK) {
+                m_authWheel.Insert(conn->GetAuthTimeout(), GetTimestamp64() + m_authTimeoutMs);
+            } else {
+                m_authList.erase(ins.first);
+            }
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        } else {
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            qcc::Shutdown(newSock);
+            qcc::Close(newSock);
+            status = ER_AUTH_FAIL;
+            QCC_LogError(status, ("TCPTransport::AcceptConnections(): No slot for new connection"));
+        }
+    }
+
+    /*
+     * Accept returns ER_WOULDBLOCK when all of the incoming connections have been handled
+     */
+    if (ER_WOULDBLOCK == status) {
+        status = ER_OK;
+    }
+
+    if (status != ER_OK) {
+        QCC_LogError(status, ("TCPTransport::AcceptConnections(): Error accepting new connection. Ignoring..."));
+    }
+
+    /* The server accept loop may need to wait less now that there are new auth timeouts */
+    if (acceptor != this) {
+        Alert();
+    }
+
+    return status;
+}
+
+TCPTransport::Acceptor::Acceptor(TCPTransport* transport, const qcc::String& normSpec, qcc::SocketFd listenFd)
+    : Thread("TCPAcceptor"), m_transport(transport), m_normSpec(normSpec), m_listenFd(listenFd)
+{
+}
+
+TCPTransport::Acceptor::~Acceptor()
+{
+    Stop();
+    Join();
+    qcc::Shutdown(m_listenFd);
+    qcc::Close(m_listenFd);
+}
+
+void* TCPTransport::Acceptor::Run(void* arg)
+{
+    QCC_DbgTrace(("TCPTransport::Acceptor::Run()"));
+
+    /* The same limits as the server accept loop, see TCPTransport::Run() */
+    uint32_t authTimeoutMs;
+    uint32_t maxAuth;
+    uint32_t maxConn;
+
+    Event listenEvent(m_listenFd, Event::IO_READ, false);
+    QStatus status = ER_OK;
+
+    ReadySet readySet;
+    ReadySet* authSet = (ReadySet::IsSupported() && (readySet.Init() == ER_OK)) ? &readySet : NULL;
+
+    while (!IsStopping()) {
+        vector<Event*> checkEvents, signaledEvents;
+        checkEvents.push_back(&stopEvent);
+        checkEvents.push_back(&listenEvent);
+        map<void*, TCPEndpoint> authEvents;
+        m_transport->GetAuthEvents(this, authSet, authEvents, checkEvents);
+
+        status = Event::Wait(checkEvents, signaledEvents);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::Acceptor::Run(): Event::Wait failed"));
+            break;
+        }
+
+        GetConnectionLimits(authTimeoutMs, maxAuth, maxConn);
+
+        /* Handshakes that end are queued for the server accept loop by AuthStep() */
+        for (vector<Event*>::iterator i = signaledEvents.begin(); i != signaledEvents.end(); ++i) {
+            if (*i == &stopEvent) {
+                stopEvent.ResetEvent();
+            } else if (*i == &listenEvent) {
+                m_transport->AcceptConnections(m_listenFd, this, maxAuth, maxConn);
+            } else {
+                m_transport->StepAuthentications(*i, authSet, authEvents);
+            }
+        }
+    }
+
+    /* Nobody will step our handshakes any more so fail them for the server accept loop to release */
+    m_transport->StopAuthentications(this);
+
+    QCC_DbgPrintf(("TCPTransport::Acceptor::Run is exiting status=%s", QCC_StatusText(status)));
+    return (void*) status;
+}
+
+void TCPTransport::StopAuthentications(qcc::Thread* acceptor)
+{
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    for (set<TCPEndpoint>::iterator i = m_authList.begin(); i != m_authList.end(); ++i) {
+        TCPEndpoint ep = *i;
+        if (ep->GetAuthThread() == acceptor) {
+            ep->AuthStop();
+            QueueReap(ep);
+        }
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+}
+
 /*
  * The purpose of this code is really to ensure that we don't have any listeners
  * active on Android systems if we have no ongoing advertisements.  This is to
@@ -3191,6 +3570,21 @@ QStatus TCPTransport::DoStartListen(qcc::String& normSpec)
         qcc::Close(listenFd);
         return status;
     }
+    /*
+     * Extra accept loops bind their own sockets to the same address and port,
+     * which requires SO_REUSEPORT on every one of them, this one included.
+     */
+    uint32_t numAcceptors = DaemonConfig::Access()->Get("tcp/property@acceptors", ALLJOYN_TCP_ACCEPTORS_DEFAULT);
+#if !defined(QCC_OS_LINUX)
+    numAcceptors = 1;
+#endif
+    if (numAcceptors > 1) {
+        status = qcc::SetReusePort(listenFd, true);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::DoStartListen(): SetReusePort() failed, using one accept loop"));
+            numAcceptors = 1;
+        }
+    }
     /*
      * We call accept in a loop so we need the listenFd to non-blocking
      */
@@ -3232,6 +3626,7 @@ QStatus TCPTransport::DoStartListen(qcc::String& normSpec)
         if (status == ER_OK) {
             QCC_DbgPrintf(("TCPTransport::DoStartListen(): Listening on %s/%d", argMap["r4addr"].c_str(), listenPort));
             m_listenFds.push_back(pair<qcc::String, SocketFd>(normSpec, listenFd));
+            StartAcceptors(normSpec, listenAddr, listenPort, numAcceptors - 1);
         } else {
             QCC_LogError(status, ("TCPTransport::DoStartListen(): Listen failed"));
         }
@@ -3296,6 +3691,69 @@ QStatus TCPTransport::DoStartListen(qcc::String& normSpec)
     return status;
 }
 
+void TCPTransport::StartAcceptors(const qcc::String& normSpec, const qcc::IPAddress& listenAddr, uint16_t listenPort, uint32_t count)
+{
+    /*
+     * Failing to start an acceptor is not fatal, the connections it would have
+     * taken go to the sockets that are listening.
+     */
+    for (uint32_t n = 0; n < count; ++n) {
+        SocketFd fd = -1;
+        QStatus status = Socket(QCC_AF_INET, QCC_SOCK_STREAM, fd);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::StartAcceptors(): Socket() failed"));
+            return;
+        }
+        status = qcc::SetReusePort(fd, true);
+        if (status == ER_OK) {
+            status = qcc::SetBlocking(fd, false);
+        }
+        if (status == ER_OK) {
+            status = Bind(fd, listenAddr, listenPort);
+        }
+        if (status == ER_OK) {
+            status = qcc::Listen(fd, MAX_LISTEN_CONNECTIONS);
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::StartAcceptors(): Failed to listen on %s/%d", listenAddr.ToString().c_str(), listenPort));
+            qcc::Close(fd);
+            return;
+        }
+        Acceptor* acceptor = new Acceptor(this, normSpec, fd);
+        status = acceptor->Start();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::StartAcceptors(): Failed to start acceptor"));
+            delete acceptor;
+            return;
+        }
+        m_acceptors.push_back(acceptor);
+    }
+    if (count) {
+        QCC_DbgPrintf(("TCPTransport::StartAcceptors(): %d extra accept loops on %s", m_acceptors.size(), normSpec.c_str()));
+    }
+}
+
+void TCPTransport::StopAcceptors(const qcc::String* normSpec)
+{
+    /* Acceptors are joined without the lock since their exit takes m_endpointListLock */
+    list<Acceptor*> stopped;
+    m_listenFdsLock.Lock(MUTEX_CONTEXT);
+    list<Acceptor*>::iterator i = m_acceptors.begin();
+    while (i != m_acceptors.end()) {
+        if (!normSpec || ((*i)->GetListenSpec() == *normSpec)) {
+            (*i)->Stop();
+            stopped.push_back(*i);
+            i = m_acceptors.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    m_listenFdsLock.Unlock(MUTEX_CONTEXT);
+    for (i = stopped.begin(); i != stopped.end(); ++i) {
+        delete *i;
+    }
+}
+
 void TCPTransport::UntrustedClientExit() {
 
     /* An untrusted client has exited, update the counts and re-enable the advertisement if necessary. */
@@ -3336,6 +3794,54 @@ QStatus TCPTransport::UntrustedClientStart() {
     return status;
 }
 
+qcc::String TCPTransport::RedirectionAddress()
+{
+    if (m_redirectPool.empty()) {
+        return qcc::String();
+    }
+
+    /*
+     * The connection being authenticated is already on the authList so it is
+     * not counted.  The transmit queue depths are read without the endpoint
+     * locks and may be slightly stale, which is fine for a load estimate.
+     */
+    bool overloaded = false;
+    qcc::String redirection;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    uint32_t numConn = static_cast<uint32_t>(m_endpointList.size());
+    if (m_redirectMaxConnections && (numConn >= m_redirectMaxConnections)) {
+        QCC_DbgPrintf(("TCPTransport::RedirectionAddress(): %u connections", numConn));
+        overloaded = true;
+    }
+    if (!overloaded && m_redirectMaxQueueDepth) {
+        uint32_t depth = 0;
+        for (set<TCPEndpoint>::iterator i = m_endpointList.begin(); i != m_endpointList.end(); ++i) {
+            _RemoteEndpoint::Stats stats;
+            (*i)->GetStats(stats);
+            depth += stats.txQueueDepth;
+        }
+        if (depth >= m_redirectMaxQueueDepth) {
+            QCC_DbgPrintf(("TCPTransport::RedirectionAddress(): %u messages queued", depth));
+            overloaded = true;
+        }
+    }
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_DARWIN)
+    if (!overloaded && m_redirectMaxLoad) {
+        double load;
+        if ((getloadavg(&load, 1) == 1) && ((load * 100) >= m_redirectMaxLoad)) {
+            QCC_DbgPrintf(("TCPTransport::RedirectionAddress(): load average %.2f", load));
+            overloaded = true;
+        }
+    }
+#endif
+    if (overloaded) {
+        redirection = m_redirectPool[m_redirectNext];
+        m_redirectNext = (m_redirectNext + 1) % m_redirectPool.size();
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+    return redirection;
+}
+
 QStatus TCPTransport::StopListen(const char* listenSpec)
 {
     QCC_DbgPrintf(("TCPTransport::StopListen()"));
@@ -3474,6 +3980,7 @@ void TCPTransport::DoStopListen(qcc::String& normSpec)
 
         qcc::Shutdown(stopFd);
         qcc::Close(stopFd);
+        StopAcceptors(&normSpec);
     }
 }
 
@@ -3571,6 +4078,34 @@ void TCPTransport::EnableDiscovery(const char* namePrefix)
     QueueEnableDiscovery(namePrefix);
 }
 
+void TCPTransport::RefreshDiscovery(const char* namePrefix)
+{
+    QCC_DbgPrintf(("TCPTransport::RefreshDiscovery()"));
+
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("TCPTransport::RefreshDiscovery(): Not running or stopping; exiting"));
+        return;
+    }
+
+    /*
+     * A refresh doesn't change the list of names we are discovering so it
+     * doesn't need to go through the listen machine; but the machine owns
+     * the state that says whether the name service is ready to send, so we
+     * take its lock while we look.
+     */
+    m_listenRequestsLock.Lock(MUTEX_CONTEXT);
+    if (m_isDiscovering && m_isNsEnabled) {
+        qcc::String starred = namePrefix;
+        starred.append('*');
+
+        QStatus status = IpNameService::Instance().FindAdvertisedName(TRANSPORT_TCP, starred);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("TCPTransport::RefreshDiscovery(): Failed to refresh discovery with multicast NS \"%s\"", starred.c_str()));
+        }
+    }
+    m_listenRequestsLock.Unlock(MUTEX_CONTEXT);
+}
+
 void TCPTransport::QueueEnableDiscovery(const char* namePrefix)
 {
     QCC_DbgPrintf(("TCPTransport::QueueEnableDiscovery()"));
@@ -29,6 +29,7 @@
 
 #include <list>
 #include <queue>
+#include <vector>
 #include <alljoyn/Status.h>
 
 #include <qcc/platform.h>
@@ -42,7 +43,9 @@
 #include <alljoyn/TransportMask.h>
 
 #include "Transport.h"
+#include "ReadySet.h"
 #include "RemoteEndpoint.h"
+#include "TimingWheel.h"
 
 #include "ns/IpNameService.h"
 
@@ -198,6 +201,13 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     void EnableDiscovery(const char* namePrefix);
 
+    /**
+     * @internal
+     * @brief Ask about busses matching a prefix that is already being
+     * discovered.
+     */
+    void RefreshDiscovery(const char* namePrefix);
+
     /**
      * @internal
      * @brief Stop discovering busses.
@@ -295,6 +305,11 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
     std::set<TCPEndpoint> m_endpointList;                          /**< List of active endpoints */
     std::set<Thread*> m_activeEndpointsThreadList;                 /**< List of threads starting up active endpoints */
     qcc::Mutex m_endpointListLock;                                 /**< Mutex that protects the endpoint and auth lists */
+    TimingWheel m_authWheel;                                       /**< Auth timeouts of the authList, protected by m_endpointListLock */
+    uint32_t m_authTimeoutMs;                                      /**< How long a connection may take to authenticate */
+
+    std::vector<TCPEndpoint> m_reapQueue;                          /**< Endpoints whose state changed since the last ManageEndpoints() */
+    qcc::Mutex m_reapLock;                                         /**< Mutex that protects m_reapQueue, no other lock is taken while holding it */
 
     std::list<std::pair<qcc::String, qcc::SocketFd> > m_listenFds; /**< File descriptors the transport is listening on */
     qcc::Mutex m_listenFdsLock;                                    /**< Mutex that protects m_listenFds */
@@ -338,8 +353,29 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
     /**
      * @internal
      * @brief Manage the list of endpoints for the transport.
+     *
+     * Only the endpoints whose handshake timed out or that were queued by
+     * QueueReap() are looked at, the lists are never swept.
      */
-    void ManageEndpoints(qcc::Timespec tTimeout);
+    void ManageEndpoints();
+
+    /**
+     * @internal
+     * @brief Ask the server accept loop to look at an endpoint whose auth or
+     * endpoint state has changed.
+     *
+     * @param ep  The endpoint.
+     */
+    void QueueReap(const TCPEndpoint& ep);
+
+    /**
+     * @internal
+     * @brief Release whatever an endpoint no longer needs and remove it from
+     * the lists once it is done.
+     *
+     * @param ep  The endpoint.
+     */
+    void ReapEndpoint(TCPEndpoint& ep);
 
     /**
      * @internal
@@ -349,6 +385,107 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     qcc::ThreadReturn STDCALL Run(void* arg);
 
+    /**
+     * @internal
+     * @brief An extra accept loop on its own SO_REUSEPORT listen socket.
+     *
+     * An acceptor steps the handshakes of the connections it accepts just as
+     * the server accept loop does for its own.  The server accept loop still
+     * does all of the scavenging of the authList and times out the slow
+     * handshakes.
+     */
+    class Acceptor : public qcc::Thread {
+      public:
+        Acceptor(TCPTransport* transport, const qcc::String& normSpec, qcc::SocketFd listenFd);
+        ~Acceptor();
+
+        /** The listen spec this acceptor accepts connections for */
+        const qcc::String& GetListenSpec() const { return m_normSpec; }
+
+      private:
+        Acceptor(const Acceptor& other);
+        Acceptor& operator =(const Acceptor& other);
+
+        qcc::ThreadReturn STDCALL Run(void* arg);
+
+        TCPTransport* m_transport;   /**< The transport the connections are accepted for */
+        qcc::String m_normSpec;      /**< The listen spec of the socket */
+        qcc::SocketFd m_listenFd;    /**< The listen socket, owned by the acceptor */
+    };
+
+    std::list<Acceptor*> m_acceptors;                              /**< Extra accept loops, protected by m_listenFdsLock */
+
+    /**
+     * @internal
+     * @brief Collect the stream events of the authenticating connections an
+     * accept loop steps.
+     *
+     * If the accept loop has a ReadySet the sockets of the connections are
+     * registered with it instead and only its event is appended, so the cost
+     * of a wait does not grow with the number of authenticating connections.
+     *
+     * @param acceptor     The thread of the accept loop.
+     * @param readySet     The accept loop's ReadySet or NULL.
+     * @param authEvents   [OUT] Map from stream event, or ReadySet key, to connection.
+     * @param checkEvents  [OUT] The events to wait on are appended here.
+     */
+    void GetAuthEvents(qcc::Thread* acceptor, ReadySet* readySet, std::map<void*, TCPEndpoint>& authEvents, std::vector<qcc::Event*>& checkEvents);
+
+    /**
+     * @internal
+     * @brief Step the handshakes of the authenticating connections a
+     * signaled event belongs to.
+     *
+     * @param signaled     An event returned by the accept loop's wait.
+     * @param readySet     The accept loop's ReadySet or NULL.
+     * @param authEvents   The map filled in by GetAuthEvents().
+     *
+     * @return  true if the event belonged to authenticating connections.
+     */
+    bool StepAuthentications(qcc::Event* signaled, ReadySet* readySet, std::map<void*, TCPEndpoint>& authEvents);
+
+    /**
+     * @internal
+     * @brief Accept all pending connections on a listen socket and begin
+     * their authentication.
+     *
+     * @param listenFd  The listen socket.
+     * @param acceptor  The thread of the accept loop that will step the handshakes.
+     * @param maxAuth   The maximum number of authenticating connections.
+     * @param maxConn   The maximum number of connections.
+     *
+     * @return ER_OK unless accepting failed.
+     */
+    QStatus AcceptConnections(qcc::SocketFd listenFd, qcc::Thread* acceptor, uint32_t maxAuth, uint32_t maxConn);
+
+    /**
+     * @internal
+     * @brief Fail the handshakes an acceptor was stepping when it exits.
+     *
+     * @param acceptor  The thread of the exiting acceptor.
+     */
+    void StopAuthentications(qcc::Thread* acceptor);
+
+    /**
+     * @internal
+     * @brief Start extra accept loops for a listen spec.  Must be called with
+     * m_listenFdsLock held.
+     *
+     * @param normSpec    The normalized listen spec.
+     * @param listenAddr  The address the primary listen socket is bound to.
+     * @param listenPort  The port the primary listen socket is bound to.
+     * @param count       The number of extra accept loops.
+     */
+    void StartAcceptors(const qcc::String& normSpec, const qcc::IPAddress& listenAddr, uint16_t listenPort, uint32_t count);
+
+    /**
+     * @internal
+     * @brief Stop and delete the extra accept loops of a listen spec.
+     *
+     * @param normSpec  The normalized listen spec or NULL for all of them.
+     */
+    void StopAcceptors(const qcc::String* normSpec);
+
     /**
      * @internal
      * @brief Queue a StartListen request for the server accept loop
@@ -531,6 +668,31 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     static const uint32_t ALLJOYN_MAX_UNTRUSTED_CLIENTS_DEFAULT = 0;
 
+    /**
+     * @brief The default number of accept loops per listen spec.
+     *
+     * To override this value, set the property "tcp/property@acceptors".  With
+     * more than one, each extra accept loop gets its own listen socket bound to
+     * the same address and port with SO_REUSEPORT, so the kernel spreads
+     * incoming connections and their handshakes across threads.  This is only
+     * done on Linux, which load balances such sockets.
+     */
+    static const uint32_t ALLJOYN_TCP_ACCEPTORS_DEFAULT = 1;
+
+    /**
+     * @brief The default load thresholds above which new clients are
+     * redirected to another daemon.
+     *
+     * Redirection only happens if the configuration lists peer daemons to
+     * redirect to as "tcp/redirect" connect specs.  The thresholds are set by
+     * "tcp/property@redirect_connections" (accepted connections),
+     * "tcp/property@redirect_queue_depth" (messages waiting in the transmit
+     * queues of all accepted connections) and "tcp/property@redirect_load"
+     * (one minute load average times 100, only where the platform reports
+     * it).  A threshold of zero is never reached.
+     */
+    static const uint32_t ALLJOYN_TCP_REDIRECT_THRESHOLD_DEFAULT = 0;
+
     /**
      * @brief The default value for the router advertisement prefix that untrusted thin clients
      * will use for the discovery of the daemon.
@@ -644,6 +806,21 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
     void DisableDiscoveryInstance(ListenRequest& listenRequest);
     void UntrustedClientExit();
     QStatus UntrustedClientStart();
+
+    /**
+     * Pick the daemon a new client should be redirected to.
+     *
+     * @return  The connect spec of the next daemon of the redirection pool if
+     *          this daemon is over one of its load thresholds, otherwise an
+     *          empty string.
+     */
+    qcc::String RedirectionAddress();
+
+    std::vector<qcc::String> m_redirectPool; /**< Connect specs of the daemons new clients are redirected to */
+    size_t m_redirectNext;                   /**< Index of the next daemon of m_redirectPool, protected by m_endpointListLock */
+    uint32_t m_redirectMaxConnections;       /**< Accepted connections at which clients are redirected */
+    uint32_t m_redirectMaxQueueDepth;        /**< Queued transmit messages at which clients are redirected */
+    uint32_t m_redirectMaxLoad;              /**< Load average times 100 at which clients are redirected */
     bool m_isAdvertising;
     bool m_isDiscovering;
     bool m_isListening;
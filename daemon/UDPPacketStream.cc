@@ -24,6 +24,14 @@
 #include <errno.h>
 #include <assert.h>
 
+#if defined(QCC_OS_LINUX)
+#include <algorithm>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+
 #include <qcc/Event.h>
 #include <qcc/Debug.h>
 #include <qcc/StringUtil.h>
@@ -43,7 +51,8 @@ UDPPacketStream::UDPPacketStream(const char* ifaceName, uint16_t port) :
     mtu(0),
     sock(-1),
     sourceEvent(&Event::neverSet),
-    sinkEvent(&Event::alwaysSet)
+    sinkEvent(&Event::alwaysSet),
+    gso(false)
 {
     QCC_DbgPrintf(("UDPPacketStream::UDPPacketStream(ifaceName='ifaceName', port=%u)", ifaceName, port));
 
@@ -66,7 +75,8 @@ UDPPacketStream::UDPPacketStream(const qcc::IPAddress& addr, uint16_t port) :
     mtu(1472),
     sock(-1),
     sourceEvent(&Event::neverSet),
-    sinkEvent(&Event::alwaysSet)
+    sinkEvent(&Event::alwaysSet),
+    gso(false)
 {
     QCC_DbgPrintf(("UDPPacketStream::UDPPacketStream(addr='%s', port=%u)", ipAddr.ToString().c_str(), port));
 
@@ -88,7 +98,8 @@ UDPPacketStream::UDPPacketStream(const qcc::IPAddress& addr, uint16_t port, size
     mtu(mtu),
     sock(-1),
     sourceEvent(&Event::neverSet),
-    sinkEvent(&Event::alwaysSet)
+    sinkEvent(&Event::alwaysSet),
+    gso(false)
 {
     QCC_DbgPrintf(("UDPPacketStream::UDPPacketStream(addr='%s', port=%u, mtu=%lu)", ipAddr.ToString().c_str(), port, mtu));
 }
@@ -200,6 +211,173 @@ QStatus UDPPacketStream::PullPacketBytes(void* buf, size_t reqBytes, size_t& act
     return status;
 }
 
+#if defined(QCC_OS_LINUX)
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+/* Maximum number of messages handed to one recvmmsg()/sendmmsg() call */
+static const size_t MAX_MMSG_BATCH = 64;
+
+/* Kernel limits for a single UDP GSO send */
+static const size_t MAX_GSO_SEGMENTS = 64;
+static const size_t MAX_GSO_BYTES = 65507;
+
+static socklen_t PacketDestToSockaddr(const PacketDest& dest, struct sockaddr_storage& addr)
+{
+    IPAddress ipAddr(dest.ip, dest.addrSize);
+    ::memset(&addr, 0, sizeof(addr));
+    if (ipAddr.IsIPv4()) {
+        struct sockaddr_in* sa = reinterpret_cast<struct sockaddr_in*>(&addr);
+        sa->sin_family = AF_INET;
+        sa->sin_port = htons(dest.port);
+        sa->sin_addr.s_addr = htonl(ipAddr.GetIPv4AddressCPUOrder());
+        return sizeof(struct sockaddr_in);
+    } else {
+        struct sockaddr_in6* sa = reinterpret_cast<struct sockaddr_in6*>(&addr);
+        sa->sin6_family = AF_INET6;
+        sa->sin6_port = htons(dest.port);
+        ipAddr.RenderIPv6Binary(sa->sin6_addr.s6_addr, sizeof(sa->sin6_addr.s6_addr));
+        return sizeof(struct sockaddr_in6);
+    }
+}
+
+static void SockaddrToPacketDest(const struct sockaddr_storage& addr, PacketDest& dest)
+{
+    IPAddress ipAddr;
+    uint16_t port = 0;
+    if (addr.ss_family == AF_INET) {
+        const struct sockaddr_in* sa = reinterpret_cast<const struct sockaddr_in*>(&addr);
+        ipAddr = IPAddress(reinterpret_cast<const uint8_t*>(&sa->sin_addr), IPAddress::IPv4_SIZE);
+        port = ntohs(sa->sin_port);
+    } else {
+        const struct sockaddr_in6* sa = reinterpret_cast<const struct sockaddr_in6*>(&addr);
+        ipAddr = IPAddress(sa->sin6_addr.s6_addr, IPAddress::IPv6_SIZE);
+        port = ntohs(sa->sin6_port);
+    }
+    ipAddr.RenderIPBinary(dest.ip, IPAddress::IPv6_SIZE);
+    dest.addrSize = ipAddr.Size();
+    dest.port = port;
+}
+
+QStatus UDPPacketStream::PullPacketBatch(void* const* bufs, size_t reqBytes, size_t* actualBytes, PacketDest* senders,
+                                         size_t numPackets, size_t& numPulled, uint32_t timeout)
+{
+    assert(reqBytes >= mtu);
+    numPulled = 0;
+    numPackets = std::min(numPackets, MAX_MMSG_BATCH);
+    if (numPackets == 0) {
+        return ER_OK;
+    }
+
+    struct mmsghdr msgs[MAX_MMSG_BATCH];
+    struct iovec iovs[MAX_MMSG_BATCH];
+    struct sockaddr_storage addrs[MAX_MMSG_BATCH];
+    ::memset(msgs, 0, numPackets * sizeof(msgs[0]));
+    for (size_t i = 0; i < numPackets; ++i) {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = reqBytes;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    }
+
+    /* The caller waits on the source event so there is normally at least one packet to read */
+    int ret = ::recvmmsg(sock, msgs, numPackets, MSG_DONTWAIT, NULL);
+    if (ret < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return ER_WOULDBLOCK;
+        }
+        QStatus status = ER_OS_ERROR;
+        QCC_LogError(status, ("recvmmsg failed: %s", ::strerror(errno)));
+        return status;
+    }
+    for (int i = 0; i < ret; ++i) {
+        actualBytes[i] = msgs[i].msg_len;
+        SockaddrToPacketDest(addrs[i], senders[i]);
+    }
+    numPulled = ret;
+    return ER_OK;
+}
+
+QStatus UDPPacketStream::PushPacketBatch(const void* const* bufs, const size_t* numBytes, size_t numPackets, PacketDest& dest, size_t& numPushed)
+{
+    numPushed = 0;
+
+    struct sockaddr_storage addr;
+    socklen_t addrLen = PacketDestToSockaddr(dest, addr);
+
+    struct mmsghdr msgs[MAX_MMSG_BATCH];
+    struct iovec iovs[MAX_MMSG_BATCH];
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } ctrl[MAX_MMSG_BATCH];
+
+    while (numPushed < numPackets) {
+        /*
+         * Build messages for up to MAX_MMSG_BATCH packets. Without GSO each message is one
+         * packet. With GSO each message is a run of packets of the same size (the last one may
+         * be shorter) that the kernel splits back into one datagram per packet.
+         */
+        size_t numMsgs = 0;
+        size_t iov = 0;
+        size_t next = numPushed;
+        while ((iov < MAX_MMSG_BATCH) && (next < numPackets)) {
+            struct msghdr& hdr = msgs[numMsgs].msg_hdr;
+            ::memset(&msgs[numMsgs], 0, sizeof(msgs[numMsgs]));
+            hdr.msg_name = &addr;
+            hdr.msg_namelen = addrLen;
+            hdr.msg_iov = &iovs[iov];
+            size_t segSize = numBytes[next];
+            size_t total = 0;
+            do {
+                assert(numBytes[next] <= mtu);
+                iovs[iov].iov_base = const_cast<void*>(bufs[next]);
+                iovs[iov].iov_len = numBytes[next];
+                total += numBytes[next];
+                ++hdr.msg_iovlen;
+                ++iov;
+                ++next;
+            } while (gso && (iov < MAX_MMSG_BATCH) && (next < numPackets) && (hdr.msg_iovlen < MAX_GSO_SEGMENTS) &&
+                     (numBytes[next - 1] == segSize) && (numBytes[next] <= segSize) && ((total + numBytes[next]) <= MAX_GSO_BYTES));
+
+            if (hdr.msg_iovlen > 1) {
+                struct cmsghdr* cm = reinterpret_cast<struct cmsghdr*>(ctrl[numMsgs].buf);
+                hdr.msg_control = ctrl[numMsgs].buf;
+                hdr.msg_controllen = sizeof(ctrl[numMsgs].buf);
+                cm->cmsg_level = SOL_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t gsoSize = static_cast<uint16_t>(segSize);
+                ::memcpy(CMSG_DATA(cm), &gsoSize, sizeof(gsoSize));
+            }
+            ++numMsgs;
+        }
+
+        int ret = ::sendmmsg(sock, msgs, numMsgs, 0);
+        if (ret <= 0) {
+            if (gso && ((errno == EIO) || (errno == EINVAL) || (errno == ENOPROTOOPT))) {
+                /* No GSO support in the kernel or the driver, fall back to one datagram per packet */
+                QCC_DbgPrintf(("UDP GSO not supported (%s), disabling", ::strerror(errno)));
+                gso = false;
+                continue;
+            }
+            QStatus status = ER_OS_ERROR;
+            QCC_LogError(status, ("sendmmsg failed: %s (%d)", ::strerror(errno), errno));
+            return status;
+        }
+        for (int m = 0; m < ret; ++m) {
+            numPushed += msgs[m].msg_hdr.msg_iovlen;
+        }
+    }
+    return ER_OK;
+}
+
+#endif
+
 String UDPPacketStream::ToString(const PacketDest& dest) const
 {
     IPAddress ipAddr(dest.ip, dest.addrSize);
@@ -86,6 +86,15 @@ class UDPPacketStream : public PacketStream {
      */
     QStatus PullPacketBytes(void* buf, size_t reqBytes, size_t& actualBytes, PacketDest& sender, uint32_t timeout = qcc::Event::WAIT_FOREVER);
 
+#if defined(QCC_OS_LINUX)
+    /**
+     * Pull up to numPackets packets with a single recvmmsg() call.
+     * @see PacketSource::PullPacketBatch
+     */
+    QStatus PullPacketBatch(void* const* bufs, size_t reqBytes, size_t* actualBytes, PacketDest* senders,
+                            size_t numPackets, size_t& numPulled, uint32_t timeout = qcc::Event::WAIT_FOREVER);
+#endif
+
     /**
      * Get the Event indicating that data is available when signaled.
      *
@@ -109,6 +118,23 @@ class UDPPacketStream : public PacketStream {
      */
     QStatus PushPacketBytes(const void* buf, size_t numBytes, PacketDest& dest);
 
+#if defined(QCC_OS_LINUX)
+    /**
+     * Push several packets with a single sendmmsg() call. Runs of equally sized packets are
+     * handed to the kernel as one UDP GSO send when GSO is enabled.
+     * @see PacketSink::PushPacketBatch
+     */
+    QStatus PushPacketBatch(const void* const* bufs, const size_t* numBytes, size_t numPackets, PacketDest& dest, size_t& numPushed);
+#endif
+
+    /**
+     * Enable or disable UDP generic segmentation offload for batched sends (Linux only).
+     * GSO is turned off again automatically if the kernel does not support it.
+     *
+     * @param enable   true to enable GSO.
+     */
+    void SetGso(bool enable) { gso = enable; }
+
     /**
      * Get the Event that indicates when data can be pushed to sink.
      *
@@ -140,6 +166,7 @@ class UDPPacketStream : public PacketStream {
     qcc::SocketFd sock;
     qcc::Event* sourceEvent;
     qcc::Event* sinkEvent;
+    bool gso;
 };
 
 }  /* namespace */
@@ -0,0 +1,1201 @@
+/**
+ * @file
+ * UDPTransport is an implementation of Transport for daemons talking over
+ * PacketEngine on plain UDP.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/atomic.h>
+#include <qcc/IfConfig.h>
+#include <qcc/IPAddress.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/TransportMask.h>
+#include <alljoyn/Session.h>
+
+#include "BusInternal.h"
+#include "RemoteEndpoint.h"
+#include "Router.h"
+#include "DaemonConfig.h"
+#include "ns/IpNameService.h"
+#include "PacketEngine.h"
+#include "UDPPacketStream.h"
+#include "UDPTransport.h"
+
+#define QCC_MODULE "UDP"
+
+using namespace std;
+using namespace qcc;
+
+/* Port bound by a listen spec that does not name one */
+static const uint16_t UDP_PORT_DEFAULT = 9956;
+
+/* Largest datagram sent, so that a packet fits an Ethernet frame without IP fragmentation */
+static const size_t UDP_PACKET_MTU = 1472;
+
+/* Maximum time in milliseconds that Connect() waits for the PacketEngine channel to come up */
+static const uint32_t UDP_CONNECT_TIMEOUT = 10000;
+
+const uint32_t UDP_LINK_TIMEOUT_PROBE_ATTEMPTS       = 1;
+const uint32_t UDP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY = 10;
+const uint32_t UDP_LINK_TIMEOUT_MIN_LINK_TIMEOUT     = 40;
+
+/* Congestion control used on PacketEngine channels unless configured otherwise ("reno" or "cubic") */
+static const char* CONGESTION_CONTROL_DEFAULT = "reno";
+
+/*
+ * The default interfaces for the name service to use.  The wildcard character
+ * means to listen and transmit over all interfaces that are up with any IP
+ * address they happen to have.
+ */
+static const char* INTERFACES_DEFAULT = "*";
+
+namespace ajn {
+
+/**
+ * Name of transport used in transport specs.
+ */
+const char* UDPTransport::TransportName = "udp";
+
+/*
+ * An endpoint class to handle the details of authenticating a connection in a
+ * way that avoids denial of service attacks.  The states and their handling
+ * follow the DaemonICEEndpoint, which runs over the same PacketEngine.
+ */
+class _UDPEndpoint : public _RemoteEndpoint {
+  public:
+
+    /**
+     * The states of the authentication process, see _DaemonICEEndpoint.
+     */
+    enum AuthState {
+        AUTH_ILLEGAL = 0,
+        AUTH_INITIALIZED,    /**< This endpoint structure has been allocated but no auth thread has been run */
+        AUTH_AUTHENTICATING, /**< We have spun up an authentication thread and it has begun running our user function */
+        AUTH_FAILED,         /**< The authentication has failed and the authentication thread is exiting immidiately */
+        AUTH_SUCCEEDED,      /**< The auth process (Establish) has succeeded and the connection is ready to be started */
+        AUTH_DONE,           /**< The auth thread has been successfully shut down and joined */
+    };
+
+    /**
+     * The states of the endpoint RX and TX threads, see _DaemonICEEndpoint.
+     */
+    enum EndpointState {
+        EP_ILLEGAL = 0,
+        EP_INITIALIZED,      /**< This endpoint structure has been allocated but not used */
+        EP_FAILED,           /**< Starting the RX and TX threads has failed and this endpoint is not usable */
+        EP_STARTED,          /**< The RX and TX threads have been started (they work as a unit) */
+        EP_STOPPING,         /**< The RX and TX threads are stopping (have run ThreadExit) but have not been joined */
+        EP_DONE              /**< The RX and TX threads have been shut down and joined */
+    };
+
+    /**
+     * Whether the connection was created by Connect() or accepted from a remote PacketEngine.
+     */
+    enum SideState {
+        SIDE_ILLEGAL = 0,
+        SIDE_INITIALIZED,    /**< This endpoint structure has been allocated but don't know if active or passive yet */
+        SIDE_ACTIVE,         /**< This endpoint is the active side of a connection */
+        SIDE_PASSIVE         /**< This endpoint is the passive side of a connection */
+    };
+
+    _UDPEndpoint(UDPTransport* transport,
+                 BusAttachment& bus,
+                 bool incoming,
+                 const String connectSpec) :
+        _RemoteEndpoint(bus, incoming, connectSpec, &m_stream, "udp"),
+        m_transport(transport),
+        m_sideState(SIDE_INITIALIZED),
+        m_authState(AUTH_INITIALIZED),
+        m_epState(EP_INITIALIZED),
+        m_tStart(Timespec(0)),
+        m_authThread(this),
+        m_stream(),
+        m_wasSuddenDisconnect(!incoming),
+        m_isConnected(false),
+        m_packetEngineReturnStatus(ER_OK)
+    {
+        /* The packet engine reassembles whole messages so reads go from packets into msgBuf */
+        SetReadAhead(false);
+    }
+
+    ~_UDPEndpoint()
+    {
+        if (m_isConnected) {
+            /* Attempt graceful disconnect with other side if still connected */
+            m_transport->m_packetEngine.Disconnect(m_stream);
+        }
+    }
+
+    void SetStartTime(Timespec tStart) { m_tStart = tStart; }
+    Timespec GetStartTime(void) { return m_tStart; }
+    QStatus Authenticate(void);
+    void AuthStop(void) { m_authThread.Stop(); }
+    void AuthJoin(void) { m_authThread.Join(); }
+
+    SideState GetSideState(void) { return m_sideState; }
+    void SetActive(void) { m_sideState = SIDE_ACTIVE; }
+    void SetPassive(void) { m_sideState = SIDE_PASSIVE; }
+
+    AuthState GetAuthState(void) { return m_authState; }
+    void SetAuthDone(void) { m_authState = AUTH_DONE; }
+    void SetAuthenticating(void) { m_authState = AUTH_AUTHENTICATING; }
+
+    EndpointState GetEpState(void) { return m_epState; }
+    void SetEpFailed(void) { m_epState = EP_FAILED; }
+    void SetEpStarted(void) { m_epState = EP_STARTED; }
+
+    void SetEpStopping(void)
+    {
+        assert(m_epState == EP_STARTED);
+        m_epState = EP_STOPPING;
+    }
+
+    void SetStream(const PacketEngineStream& stream) { m_stream = stream; _RemoteEndpoint::SetStream(&m_stream); }
+
+    bool IsSuddenDisconnect() { return m_wasSuddenDisconnect; }
+    void SetSuddenDisconnect(bool val) { m_wasSuddenDisconnect = val; }
+
+    QStatus SetLinkTimeout(uint32_t& linkTimeout)
+    {
+        QStatus status = ER_OK;
+        if (linkTimeout > 0) {
+            uint32_t to = max(linkTimeout, UDP_LINK_TIMEOUT_MIN_LINK_TIMEOUT);
+            to -= UDP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * UDP_LINK_TIMEOUT_PROBE_ATTEMPTS;
+            status = _RemoteEndpoint::SetLinkTimeout(to, UDP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY, UDP_LINK_TIMEOUT_PROBE_ATTEMPTS);
+            if ((status == ER_OK) && (to > 0)) {
+                linkTimeout = to + UDP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * UDP_LINK_TIMEOUT_PROBE_ATTEMPTS;
+            }
+        } else {
+            _RemoteEndpoint::SetLinkTimeout(0, 0, 0);
+        }
+        return status;
+    }
+
+  private:
+
+    friend class UDPTransport;
+
+    QStatus PacketEngineConnect(PacketStream& pktStream, const IPAddress& addr, uint16_t port, uint32_t timeout);
+
+    class AuthThread : public qcc::Thread {
+      public:
+        AuthThread(_UDPEndpoint* ep) : Thread("auth"), m_endpoint(ep) { }
+      private:
+        virtual qcc::ThreadReturn STDCALL Run(void* arg);
+
+        _UDPEndpoint* m_endpoint;
+    };
+
+    /** Record the end of the authentication and wake the transport to clean up after it */
+    void SetAuthResult(AuthState state);
+
+    UDPTransport* m_transport;          /**< The transport holding the connection */
+    volatile SideState m_sideState;     /**< Is this an active or passive connection */
+    volatile AuthState m_authState;     /**< The state of the endpoint authentication process */
+    volatile EndpointState m_epState;   /**< The state of the endpoint RX and TX threads */
+    Timespec m_tStart;                  /**< Timestamp indicating when the authentication process started */
+    AuthThread m_authThread;            /**< Thread used to do blocking calls during startup */
+    PacketEngineStream m_stream;        /**< Stream used by authentication code */
+    bool m_wasSuddenDisconnect;         /**< If true, assumption is that any disconnect is unexpected due to lower level error */
+    bool m_isConnected;                 /**< true iff endpoint is connected to a remote side */
+    qcc::Event m_connectEvent;          /**< Set by PacketEngineConnectCB, which may run after the connect timed out */
+    QStatus m_packetEngineReturnStatus; /**< Status returned from PacketEngine */
+};
+
+QStatus _UDPEndpoint::Authenticate(void)
+{
+    QCC_DbgTrace(("UDPEndpoint::Authenticate()"));
+    QStatus status = m_authThread.Start(this);
+    if (status != ER_OK) {
+        m_transport->m_endpointListLock.Lock(MUTEX_CONTEXT);
+        m_authState = AUTH_FAILED;
+        m_transport->m_endpointListLock.Unlock(MUTEX_CONTEXT);
+    }
+    return status;
+}
+
+void _UDPEndpoint::SetAuthResult(AuthState state)
+{
+    /*
+     * As soon as the state is AUTH_FAILED or AUTH_SUCCEEDED the transport Run
+     * thread owns the endpoint and may join the auth thread and delete the
+     * endpoint, so the endpoint is not touched after this point.
+     */
+    UDPTransport* transport = m_transport;
+    transport->m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_authState = state;
+    transport->m_endpointListLock.Unlock(MUTEX_CONTEXT);
+    transport->m_wakeRun.SetEvent();
+}
+
+void* _UDPEndpoint::AuthThread::Run(void* arg)
+{
+    QCC_DbgTrace(("UDPEndpoint::AuthThread::Run()"));
+
+    m_endpoint->m_transport->m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_endpoint->m_authState = AUTH_AUTHENTICATING;
+    m_endpoint->m_transport->m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * Eat the first byte of the stream.  This is required to be zero by the
+     * DBus protocol.  It is used in the Unix socket implementation to carry
+     * out-of-band capabilities, but is discarded here.
+     */
+    uint8_t byte = 'x';
+    size_t nbytes = 0;
+    QStatus status = m_endpoint->m_stream.PullBytes(&byte, 1, nbytes);
+    if ((status != ER_OK) || (nbytes != 1) || (byte != 0)) {
+        QCC_LogError(status, ("Failed to read first byte from stream (byte=%x, nbytes=%d)", (int) byte, (int) nbytes));
+        m_endpoint->SetAuthResult(AUTH_FAILED);
+        return (void*)ER_FAIL;
+    }
+
+    /* Initialized the features for this endpoint */
+    m_endpoint->GetFeatures().isBusToBus = false;
+    m_endpoint->GetFeatures().handlePassing = false;
+    m_endpoint->GetFeatures().bodyCompression = true;
+
+    /* Run the actual connection authentication code. */
+    qcc::String authName;
+    qcc::String redirection;
+    status = m_endpoint->Establish("ANONYMOUS", authName, redirection);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to establish UDP endpoint"));
+        m_endpoint->SetAuthResult(AUTH_FAILED);
+        return (void*)status;
+    }
+
+    /*
+     * Tell the transport that the authentication has succeeded and that it can
+     * now bring the connection up.
+     */
+    UDPEndpoint udpEp = UDPEndpoint::wrap(m_endpoint);
+    m_endpoint->m_transport->Authenticated(udpEp);
+
+    m_endpoint->SetAuthResult(AUTH_SUCCEEDED);
+    return (void*)status;
+}
+
+QStatus _UDPEndpoint::PacketEngineConnect(PacketStream& pktStream, const IPAddress& addr, uint16_t port, uint32_t timeout)
+{
+    QCC_DbgTrace(("UDPEndpoint::PacketEngineConnect()"));
+
+    /*
+     * Pass a pointer to the managed endpoint as context, to ensure that the
+     * endpoint is not deleted before PacketEngineConnectCB returns.
+     */
+    UDPEndpoint* ep = new UDPEndpoint(UDPEndpoint::wrap(this));
+    QStatus status = m_transport->m_packetEngine.Connect(GetPacketDest(addr, port), pktStream, *m_transport, ep,
+                                                         m_transport->GetCongestionControl());
+    if (status != ER_OK) {
+        QCC_LogError(status, ("%s: Failed PacketEngine::Connect()", __FUNCTION__));
+        delete ep;
+        return status;
+    }
+
+    vector<Event*> checkEvents, signaledEvents;
+    checkEvents.push_back(&((Thread::GetThread())->GetStopEvent()));
+    checkEvents.push_back(&m_connectEvent);
+
+    status = Event::Wait(checkEvents, signaledEvents, timeout);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("%s: Timed-out or failed wait for PacketEngineConnectCB", __FUNCTION__));
+        return status;
+    }
+    for (vector<Event*>::iterator i = signaledEvents.begin(); i != signaledEvents.end(); ++i) {
+        if (*i == &((Thread::GetThread())->GetStopEvent())) {
+            return ER_STOPPING_THREAD;
+        }
+    }
+
+    if (m_packetEngineReturnStatus != ER_OK) {
+        status = m_packetEngineReturnStatus;
+        QCC_LogError(status, ("%s: PacketEngineConnectCB returned a failure", __FUNCTION__));
+        return status;
+    }
+
+    /*
+     * Every connection, irrespective of transport, starts with a single zero
+     * byte.  This is so that the Unix-domain socket transport used by DBus can
+     * pass SCM_RIGHTS out-of-band when that byte is sent.
+     */
+    char sendData = '\0';
+    size_t sent;
+    status = m_stream.PushBytes((void*)&sendData, 1, sent);
+    if ((ER_OK != status) || (sent != 1)) {
+        status = ER_FAIL;
+        QCC_LogError(status, ("%s: Sending of nul byte failed", __FUNCTION__));
+    }
+    return status;
+}
+
+UDPTransport::UDPTransport(BusAttachment& bus) :
+    Thread("UDPTransport"),
+    m_bus(bus),
+    m_stopping(false),
+    m_listener(0),
+    m_foundCallback(m_listener),
+    m_nsReleaseCount(1),
+    m_packetEngine("udp_packet_engine",
+                   DaemonConfig::Access()->Get("udp/limit@packet_engine_window", ALLJOYN_PACKET_ENGINE_WINDOW_UDP_DEFAULT),
+                   DaemonConfig::Access()->Get("udp/limit@packet_engine_shards", ALLJOYN_PACKET_ENGINE_SHARDS_UDP_DEFAULT)),
+    m_listenStream(NULL),
+    m_listening(false)
+{
+    /*
+     * We know we are daemon code, so we'd better be running with a daemon
+     * router.  This is assumed elsewhere.
+     */
+    assert(m_bus.GetInternal().GetRouter().IsDaemon());
+
+    m_packetEngine.GetPacketPool().SetHighWaterMark(DaemonConfig::Access()->Get("udp/limit@packet_pool_high_water", ALLJOYN_PACKET_POOL_HIGH_WATER_UDP_DEFAULT));
+    m_packetEngine.SetDefaultCongestionControl(GetCongestionControl());
+}
+
+UDPTransport::~UDPTransport()
+{
+    QCC_DbgTrace(("UDPTransport::~UDPTransport()"));
+    Stop();
+    Join();
+}
+
+CongestionControlType UDPTransport::GetCongestionControl()
+{
+    qcc::String name = DaemonConfig::Access()->Get("udp/property@congestion_control", CONGESTION_CONTROL_DEFAULT);
+    return CongestionControlFromString(name, CONGESTION_CONTROL_RENO);
+}
+
+QStatus UDPTransport::Start()
+{
+    QCC_DbgTrace(("UDPTransport::Start()"));
+
+    m_stopping = false;
+
+    if (IsRunning()) {
+        QCC_LogError(ER_BUS_BUS_ALREADY_STARTED, ("UDPTransport::Start(): Already started"));
+        return ER_BUS_BUS_ALREADY_STARTED;
+    }
+
+    QStatus status = m_packetEngine.Start(UDP_PACKET_MTU);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Start(): PacketEngine::Start failed"));
+        return status;
+    }
+
+    /*
+     * UDP is an IP protocol, so we share the IP name service with the TCP
+     * transport.  Acquire() bumps its reference count and starts it if
+     * required; Join() releases it exactly once.
+     */
+    m_nsReleaseCount = 0;
+    IpNameService::Instance().Acquire(m_bus.GetInternal().GetGlobalGUID().ToString());
+    IpNameService::Instance().SetCallback(TRANSPORT_UDP,
+                                          new CallbackImpl<FoundCallback, void, const qcc::String&, const qcc::String&, std::vector<qcc::String>&, uint8_t>
+                                              (&m_foundCallback, &FoundCallback::Found));
+
+    return Thread::Start();
+}
+
+QStatus UDPTransport::Stop(void)
+{
+    QCC_DbgTrace(("UDPTransport::Stop()"));
+
+    /*
+     * It is legal to call Stop() more than once, so it must be possible to
+     * call Stop() on a stopped transport.
+     */
+    m_stopping = true;
+
+    IpNameService::Instance().SetCallback(TRANSPORT_UDP, NULL);
+
+    QStatus status = Thread::Stop();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Stop(): Failed to Stop() UDPTransport Run thread"));
+    }
+
+    /*
+     * Ask authenticating endpoints to give up and running endpoints to shut
+     * down.  Both are joined and deleted in Join().
+     */
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    for (set<UDPEndpoint>::iterator i = m_authList.begin(); i != m_authList.end(); ++i) {
+        UDPEndpoint ep = *i;
+        ep->AuthStop();
+    }
+    for (set<UDPEndpoint>::iterator i = m_endpointList.begin(); i != m_endpointList.end(); ++i) {
+        UDPEndpoint ep = *i;
+        ep->Stop();
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    return ER_OK;
+}
+
+QStatus UDPTransport::Join(void)
+{
+    QCC_DbgTrace(("UDPTransport::Join()"));
+
+    QStatus status = Thread::Join();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Join(): Failed to Join() UDPTransport thread"));
+        return status;
+    }
+
+    /*
+     * An authentication may complete after Stop() and move its endpoint to
+     * the endpoint list, so the auth list is drained first.
+     */
+    set<UDPEndpoint> toDelete;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    set<UDPEndpoint>::iterator it = m_authList.begin();
+    while (it != m_authList.end()) {
+        UDPEndpoint ep = *it;
+        m_authList.erase(it);
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        ep->AuthJoin();
+        toDelete.insert(ep);
+        m_endpointListLock.Lock(MUTEX_CONTEXT);
+        it = m_authList.upper_bound(ep);
+    }
+    it = m_endpointList.begin();
+    while (it != m_endpointList.end()) {
+        UDPEndpoint ep = *it;
+        m_endpointList.erase(it);
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        ep->Join();
+        toDelete.insert(ep);
+        m_endpointListLock.Lock(MUTEX_CONTEXT);
+        it = m_endpointList.upper_bound(ep);
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+    toDelete.clear();
+
+    CloseListenStream();
+
+    int32_t count = qcc::IncrementAndFetch(&m_nsReleaseCount);
+    if (count == 1) {
+        IpNameService::Instance().Release();
+    }
+
+    m_stopping = false;
+    return ER_OK;
+}
+
+void UDPTransport::CloseListenStream()
+{
+    m_listenLock.Lock(MUTEX_CONTEXT);
+    UDPPacketStream* stream = m_listenStream;
+    m_listenStream = NULL;
+    m_listenSpec.clear();
+    m_listening = false;
+    m_listenLock.Unlock(MUTEX_CONTEXT);
+
+    if (stream) {
+        IpNameService::Instance().Enable(TRANSPORT_UDP, 0, 0, 0, 0, false, false, false, false);
+        m_packetEngine.RemovePacketStream(*stream);
+        stream->Stop();
+        delete stream;
+    }
+}
+
+void UDPTransport::Authenticated(UDPEndpoint& conn)
+{
+    QCC_DbgTrace(("UDPTransport::Authenticated()"));
+
+    if (m_stopping == true) {
+        return;
+    }
+
+    /*
+     * Move the connection to the endpoint list before starting it, since a
+     * failed start is reported through EndpointExit which expects to find
+     * it there.
+     */
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    set<UDPEndpoint>::iterator i = m_authList.find(conn);
+    assert(i != m_authList.end() && "UDPTransport::Authenticated(): Conn not on m_authList");
+    m_authList.erase(i);
+    m_endpointList.insert(conn);
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    conn->SetListener(this);
+    QStatus status = conn->Start();
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Authenticated(): Failed to start UDP endpoint"));
+        conn->SetEpFailed();
+    } else {
+        conn->SetEpStarted();
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+}
+
+void UDPTransport::ManageEndpoints(Timespec tTimeout)
+{
+    set<UDPEndpoint> toDelete;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+
+    /*
+     * Clean up failed authenticators and stop those taking too long to
+     * authenticate (we assume a denial of service attack in this case).
+     */
+    set<UDPEndpoint>::iterator i = m_authList.begin();
+    while (i != m_authList.end()) {
+        UDPEndpoint ep = *i;
+        if (ep->GetAuthState() == _UDPEndpoint::AUTH_FAILED) {
+            QCC_DbgHLPrintf(("UDPTransport::ManageEndpoints(): Scavenging failed authenticator"));
+            m_authList.erase(i);
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            ep->AuthJoin();
+            toDelete.insert(ep);
+            m_endpointListLock.Lock(MUTEX_CONTEXT);
+            i = m_authList.upper_bound(ep);
+            continue;
+        }
+
+        Timespec tNow;
+        GetTimeNow(&tNow);
+        if (ep->GetStartTime() + tTimeout < tNow) {
+            QCC_DbgHLPrintf(("UDPTransport::ManageEndpoints(): Scavenging slow authenticator"));
+            ep->AuthStop();
+        }
+        ++i;
+    }
+
+    /*
+     * Join the auth threads that completed and remove the endpoints whose RX
+     * and TX threads failed to start or have stopped.
+     */
+    i = m_endpointList.begin();
+    while (i != m_endpointList.end()) {
+        UDPEndpoint ep = *i;
+        _UDPEndpoint::EndpointState endpointState = ep->GetEpState();
+
+        if (ep->GetAuthState() == _UDPEndpoint::AUTH_SUCCEEDED) {
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            ep->AuthJoin();
+            ep->SetAuthDone();
+            m_endpointListLock.Lock(MUTEX_CONTEXT);
+            i = m_endpointList.upper_bound(ep);
+            continue;
+        }
+
+        if (endpointState == _UDPEndpoint::EP_FAILED) {
+            QCC_DbgHLPrintf(("UDPTransport::ManageEndpoints(): Handle failed endpoint"));
+            m_endpointList.erase(i);
+            toDelete.insert(ep);
+            i = m_endpointList.upper_bound(ep);
+            continue;
+        }
+
+        if (endpointState == _UDPEndpoint::EP_STOPPING) {
+            QCC_DbgHLPrintf(("UDPTransport::ManageEndpoints(): Handle stopping endpoint"));
+            m_endpointList.erase(i);
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            ep->Join();
+            toDelete.insert(ep);
+            m_endpointListLock.Lock(MUTEX_CONTEXT);
+            i = m_endpointList.upper_bound(ep);
+            continue;
+        }
+        ++i;
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    /* The last references go away here, outside of the lock, which disconnects the channels */
+    toDelete.clear();
+}
+
+void* UDPTransport::Run(void* arg)
+{
+    QCC_DbgTrace(("UDPTransport::Run()"));
+
+    Timespec tTimeout = DaemonConfig::Access()->Get("limit@auth_timeout", ALLJOYN_AUTH_TIMEOUT_DEFAULT);
+
+    vector<Event*> checkEvents, signaledEvents;
+    checkEvents.push_back(&stopEvent);
+    checkEvents.push_back(&m_wakeRun);
+
+    QStatus status = ER_OK;
+    while (!IsStopping()) {
+        /* Wake up periodically so that slow authenticators are noticed */
+        status = Event::Wait(checkEvents, signaledEvents, ALLJOYN_AUTH_TIMEOUT_DEFAULT / 10);
+        if ((status != ER_OK) && (status != ER_TIMEOUT)) {
+            QCC_LogError(status, ("UDPTransport::Run(): Event::Wait failed"));
+            break;
+        }
+
+        for (vector<Event*>::iterator i = signaledEvents.begin(); i != signaledEvents.end(); ++i) {
+            if (*i == &stopEvent) {
+                stopEvent.ResetEvent();
+            } else if (*i == &m_wakeRun) {
+                m_wakeRun.ResetEvent();
+            }
+        }
+        signaledEvents.clear();
+
+        ManageEndpoints(tTimeout);
+    }
+
+    QCC_DbgPrintf(("UDPTransport::Run is exiting status=%s", QCC_StatusText(status)));
+    return (void*) status;
+}
+
+QStatus UDPTransport::GetListenAddresses(const SessionOpts& opts, std::vector<qcc::String>& busAddrs) const
+{
+    QCC_DbgTrace(("UDPTransport::GetListenAddresses()"));
+
+    /* PacketEngine streams carry messages, raw sessions need a socket of their own */
+    if ((opts.traffic != SessionOpts::TRAFFIC_MESSAGES) || !(opts.transports & GetTransportMask())) {
+        return ER_OK;
+    }
+
+    uint16_t reliableIPv4Port, reliableIPv6Port, unreliableIPv4Port, unreliableIPv6Port;
+    IpNameService::Instance().Enabled(TRANSPORT_UDP, reliableIPv4Port, reliableIPv6Port, unreliableIPv4Port, unreliableIPv6Port);
+    if (unreliableIPv4Port == 0) {
+        /* Not listening */
+        return ER_OK;
+    }
+
+    std::vector<qcc::IfConfigEntry> entries;
+    QStatus status = qcc::IfConfig(entries);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::GetListenAddresses(): IfConfig() failed"));
+        return status;
+    }
+
+    qcc::String interfaces = DaemonConfig::Access()->Get("ip_name_service/property@interfaces", INTERFACES_DEFAULT);
+    bool haveWildcard = (interfaces.find("*") != qcc::String::npos);
+    interfaces = "," + interfaces + ",";
+
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        if ((entries[i].m_flags & (qcc::IfConfigEntry::UP | qcc::IfConfigEntry::LOOPBACK)) != qcc::IfConfigEntry::UP) {
+            continue;
+        }
+        if (!haveWildcard && (interfaces.find("," + entries[i].m_name + ",") == qcc::String::npos)) {
+            continue;
+        }
+        if (!entries[i].m_addr.empty() && (entries[i].m_family == QCC_AF_INET)) {
+            busAddrs.push_back("udp:u4addr=" + entries[i].m_addr + ",u4port=" + U32ToString(unreliableIPv4Port));
+        }
+    }
+    return ER_OK;
+}
+
+void UDPTransport::PacketEngineConnectCB(PacketEngine& engine,
+                                         QStatus status,
+                                         const PacketEngineStream* stream,
+                                         const PacketDest& dest,
+                                         void* context)
+{
+    QCC_DbgTrace(("UDPTransport::PacketEngineConnectCB(status=%s, context=%p)", QCC_StatusText(status), context));
+
+    UDPEndpoint* temp = static_cast<UDPEndpoint*>(context);
+    if (status == ER_OK) {
+        (*temp)->SetStream(*stream);
+        (*temp)->m_isConnected = true;
+    } else {
+        QCC_LogError(status, ("%s(ep=%p) Connect failed", __FUNCTION__, &(**temp)));
+    }
+    (*temp)->m_packetEngineReturnStatus = status;
+    (*temp)->m_connectEvent.SetEvent();
+
+    /* The following delete causes the references on the managed endpoint to be decremented */
+    delete temp;
+}
+
+bool UDPTransport::PacketEngineAcceptCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest)
+{
+    QCC_DbgTrace(("%s(stream=%p)", __FUNCTION__, &stream));
+
+    if (IsRunning() == false || m_stopping == true || m_listening == false) {
+        QCC_DbgPrintf(("%s: Not listening; rejecting", __FUNCTION__));
+        return false;
+    }
+
+    DaemonConfig::Snapshot limits = DaemonConfig::Access()->GetSnapshot();
+    uint32_t maxAuth = limits.udpMaxIncompleteConnections.Get(ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_UDP_DEFAULT);
+    uint32_t maxConn = limits.udpMaxCompletedConnections.Get(ALLJOYN_MAX_COMPLETED_CONNECTIONS_UDP_DEFAULT);
+
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    if ((m_authList.size() >= maxAuth) || ((m_authList.size() + m_endpointList.size()) >= maxConn)) {
+        m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        QCC_LogError(ER_FAIL, ("%s: No slot for new connection", __FUNCTION__));
+        return false;
+    }
+
+    UDPEndpoint conn = UDPEndpoint(this, m_bus, true, "");
+    conn->SetStream(stream);
+    conn->SetPassive();
+    Timespec tNow;
+    GetTimeNow(&tNow);
+    conn->SetStartTime(tNow);
+
+    /*
+     * By putting the connection on the m_authList, we are transferring
+     * responsibility for the connection to the authentication thread.  If
+     * it does not start, ManageEndpoints() finds it failed and pitches it.
+     */
+    m_authList.insert(conn);
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    QStatus status = conn->Authenticate();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("%s: Authentication failed for endpoint", __FUNCTION__));
+        m_wakeRun.SetEvent();
+    }
+    return status == ER_OK;
+}
+
+void UDPTransport::PacketEngineDisconnectCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest)
+{
+    QCC_DbgTrace(("%s(stream=%p)", __FUNCTION__, &stream));
+
+    /* Find the endpoint that uses stream and stop it, ManageEndpoints() cleans it up */
+    bool foundEp = false;
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    for (set<UDPEndpoint>::iterator it = m_endpointList.begin(); !foundEp && (it != m_endpointList.end()); ++it) {
+        UDPEndpoint ep = *it;
+        if (ep->m_stream == stream) {
+            ep->m_isConnected = false;
+            ep->Stop();
+            foundEp = true;
+        }
+    }
+    for (set<UDPEndpoint>::iterator it = m_authList.begin(); !foundEp && (it != m_authList.end()); ++it) {
+        UDPEndpoint ep = *it;
+        if (ep->m_stream == stream) {
+            ep->m_isConnected = false;
+            ep->AuthStop();
+            foundEp = true;
+        }
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    if (foundEp) {
+        m_wakeRun.SetEvent();
+    }
+}
+
+void UDPTransport::EndpointExit(RemoteEndpoint& ep)
+{
+    QCC_DbgTrace(("UDPTransport::EndpointExit()"));
+
+    UDPEndpoint tep = UDPEndpoint::cast(ep);
+
+    /*
+     * We need to notify upper level code if the disconnect is due to an event
+     * from the network rather than a Disconnect() from higher level code.
+     */
+    if (m_listener && tep->IsSuddenDisconnect()) {
+        m_listener->BusConnectionLost(tep->GetConnectSpec());
+    }
+
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    tep->SetEpStopping();
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    m_wakeRun.SetEvent();
+}
+
+QStatus UDPTransport::NormalizeListenSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const
+{
+    QStatus status = ParseArguments(TransportName, inSpec, argMap);
+    if (status != ER_OK) {
+        return status;
+    }
+
+    IPAddress addr;
+    map<qcc::String, qcc::String>::iterator i = argMap.find("u4addr");
+    if (i == argMap.end()) {
+        argMap["u4addr"] = "0.0.0.0";
+        addr = IPAddress("0.0.0.0");
+    } else {
+        status = addr.SetAddress(i->second, false);
+        if ((status != ER_OK) || !addr.IsIPv4()) {
+            QCC_LogError(ER_BUS_BAD_TRANSPORT_ARGS, ("UDPTransport::NormalizeListenSpec(): Bad IPv4 address \"%s\"", i->second.c_str()));
+            return ER_BUS_BAD_TRANSPORT_ARGS;
+        }
+        i->second = addr.ToString();
+    }
+
+    i = argMap.find("u4port");
+    if (i == argMap.end()) {
+        argMap["u4port"] = U32ToString(UDP_PORT_DEFAULT);
+    } else {
+        uint32_t port = StringToU32(i->second, 10, 0x10000);
+        if (port > 0xffff) {
+            QCC_LogError(ER_BUS_BAD_TRANSPORT_ARGS, ("UDPTransport::NormalizeListenSpec(): Bad port \"%s\"", i->second.c_str()));
+            return ER_BUS_BAD_TRANSPORT_ARGS;
+        }
+        i->second = U32ToString(port);
+    }
+
+    outSpec = qcc::String(TransportName) + ":u4addr=" + argMap["u4addr"] + ",u4port=" + argMap["u4port"];
+    return ER_OK;
+}
+
+QStatus UDPTransport::NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const
+{
+    QStatus status = ParseArguments(TransportName, inSpec, argMap);
+    if (status != ER_OK) {
+        return status;
+    }
+
+    map<qcc::String, qcc::String>::iterator a = argMap.find("u4addr");
+    map<qcc::String, qcc::String>::iterator p = argMap.find("u4port");
+    if ((a == argMap.end()) || (p == argMap.end())) {
+        QCC_LogError(ER_BUS_BAD_TRANSPORT_ARGS, ("UDPTransport::NormalizeTransportSpec(): u4addr and u4port are required"));
+        return ER_BUS_BAD_TRANSPORT_ARGS;
+    }
+
+    IPAddress addr;
+    status = addr.SetAddress(a->second, false);
+    if ((status != ER_OK) || !addr.IsIPv4()) {
+        QCC_LogError(ER_BUS_BAD_TRANSPORT_ARGS, ("UDPTransport::NormalizeTransportSpec(): Bad IPv4 address \"%s\"", a->second.c_str()));
+        return ER_BUS_BAD_TRANSPORT_ARGS;
+    }
+    a->second = addr.ToString();
+
+    uint32_t port = StringToU32(p->second, 10, 0);
+    if ((port == 0) || (port > 0xffff)) {
+        QCC_LogError(ER_BUS_BAD_TRANSPORT_ARGS, ("UDPTransport::NormalizeTransportSpec(): Bad port \"%s\"", p->second.c_str()));
+        return ER_BUS_BAD_TRANSPORT_ARGS;
+    }
+    p->second = U32ToString(port);
+
+    outSpec = qcc::String(TransportName) + ":u4addr=" + a->second + ",u4port=" + p->second;
+    return ER_OK;
+}
+
+QStatus UDPTransport::Connect(const char* connectSpec, const SessionOpts& opts, BusEndpoint& newEp)
+{
+    QCC_DbgHLPrintf(("UDPTransport::Connect(): %s", connectSpec));
+
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::Connect(): Not running or stopping; exiting"));
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+
+    qcc::String normSpec;
+    map<qcc::String, qcc::String> argMap;
+    QStatus status = NormalizeTransportSpec(connectSpec, normSpec, argMap);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Connect(): Invalid UDP connect spec \"%s\"", connectSpec));
+        return status;
+    }
+
+    /*
+     * Outgoing channels are opened from the listen socket so that the remote
+     * side sees the same address it learned from our advertisements.  The
+     * socket stays open until the transport is joined.
+     */
+    m_listenLock.Lock(MUTEX_CONTEXT);
+    UDPPacketStream* pktStream = m_listenStream;
+    m_listenLock.Unlock(MUTEX_CONTEXT);
+    if (!pktStream) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_AVAILABLE, ("UDPTransport::Connect(): No UDP listen spec configured"));
+        return ER_BUS_TRANSPORT_NOT_AVAILABLE;
+    }
+
+    UDPEndpoint udpEp = UDPEndpoint(this, m_bus, false, normSpec);
+    status = udpEp->PacketEngineConnect(*pktStream, IPAddress(argMap["u4addr"]),
+                                        static_cast<uint16_t>(StringToU32(argMap["u4port"])), UDP_CONNECT_TIMEOUT);
+    if (status != ER_OK) {
+        return ER_BUS_CONNECT_FAILED;
+    }
+
+    /*
+     * On the active side of a connection, we don't need an authentication
+     * thread to run since we have the caller thread.  We do have to put the
+     * endpoint on the endpoint list to be assured that errors get logged.
+     */
+    udpEp->SetActive();
+    udpEp->SetAuthenticating();
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_endpointList.insert(udpEp);
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    /* Initialized the features for this endpoint */
+    udpEp->GetFeatures().isBusToBus = true;
+    udpEp->GetFeatures().allowRemote = m_bus.GetInternal().AllowRemoteMessages();
+    udpEp->GetFeatures().handlePassing = false;
+    udpEp->GetFeatures().bodyCompression = true;
+
+    qcc::String authName;
+    qcc::String redirection;
+    status = udpEp->Establish("ANONYMOUS", authName, redirection);
+    if (status == ER_OK) {
+        udpEp->SetListener(this);
+        status = udpEp->Start();
+    }
+
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    if (status == ER_OK) {
+        udpEp->SetEpStarted();
+    } else {
+        udpEp->SetEpFailed();
+    }
+    udpEp->SetAuthDone();
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Connect(): Failed to establish UDP endpoint"));
+        udpEp->Invalidate();
+        m_wakeRun.SetEvent();
+        return status;
+    }
+
+    newEp = BusEndpoint::cast(udpEp);
+    return ER_OK;
+}
+
+QStatus UDPTransport::Disconnect(const char* connectSpec)
+{
+    QCC_DbgHLPrintf(("UDPTransport::Disconnect(): %s", connectSpec));
+
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::Disconnect(): Not running or stopping; exiting"));
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+
+    qcc::String normSpec;
+    map<qcc::String, qcc::String> argMap;
+    QStatus status = NormalizeTransportSpec(connectSpec, normSpec, argMap);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::Disconnect(): Invalid UDP connect spec \"%s\"", connectSpec));
+        return status;
+    }
+
+    /*
+     * Stopping the endpoint causes its threads to exit and our EndpointExit()
+     * to be called, after which the Run thread deletes it.
+     */
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    for (set<UDPEndpoint>::iterator i = m_endpointList.begin(); i != m_endpointList.end(); ++i) {
+        if ((*i)->GetConnectSpec() == normSpec) {
+            UDPEndpoint ep = *i;
+            ep->SetSuddenDisconnect(false);
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            return ep->Stop();
+        }
+    }
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+    return ER_BUS_BAD_TRANSPORT_ARGS;
+}
+
+QStatus UDPTransport::StartListen(const char* listenSpec)
+{
+    QCC_DbgPrintf(("UDPTransport::StartListen(%s)", listenSpec));
+
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::StartListen(): Not running or stopping; exiting"));
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+
+    qcc::String normSpec;
+    map<qcc::String, qcc::String> argMap;
+    QStatus status = NormalizeListenSpec(listenSpec, normSpec, argMap);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::StartListen(): Invalid listen spec \"%s\"", listenSpec));
+        return status;
+    }
+
+    /*
+     * A single socket carries every channel of the transport.  It is kept
+     * across StopListen() since outgoing connections use it as well, so
+     * listening again is only possible on the same spec.
+     */
+    m_listenLock.Lock(MUTEX_CONTEXT);
+    if (m_listenStream && (m_listening || (normSpec != m_listenSpec))) {
+        m_listenLock.Unlock(MUTEX_CONTEXT);
+        QCC_LogError(ER_BUS_ALREADY_LISTENING, ("UDPTransport::StartListen(): Already listening on %s", m_listenSpec.c_str()));
+        return ER_BUS_ALREADY_LISTENING;
+    }
+    if (!m_listenStream) {
+        UDPPacketStream* stream = new UDPPacketStream(IPAddress(argMap["u4addr"]), static_cast<uint16_t>(StringToU32(argMap["u4port"])), UDP_PACKET_MTU);
+        status = stream->Start();
+        if (status == ER_OK) {
+            status = m_packetEngine.AddPacketStream(*stream, *this);
+            if (status != ER_OK) {
+                stream->Stop();
+            }
+        }
+        if (status != ER_OK) {
+            m_listenLock.Unlock(MUTEX_CONTEXT);
+            QCC_LogError(status, ("UDPTransport::StartListen(): Failed to open UDP socket for %s", normSpec.c_str()));
+            delete stream;
+            return status;
+        }
+        m_listenStream = stream;
+        m_listenSpec = normSpec;
+    }
+    m_listening = true;
+    uint16_t port = m_listenStream->GetPort();
+    m_listenLock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * Tell the name service which interfaces to advertise over and the port
+     * to put into the unreliable IPv4 endpoint of our answers.
+     */
+    qcc::String interfaces = DaemonConfig::Access()->Get("ip_name_service/property@interfaces", INTERFACES_DEFAULT);
+    while (interfaces.size()) {
+        qcc::String currentInterface;
+        size_t i = interfaces.find(",");
+        if (i != qcc::String::npos) {
+            currentInterface = interfaces.substr(0, i);
+            interfaces = interfaces.substr(i + 1, interfaces.size() - i - 1);
+        } else {
+            currentInterface = interfaces;
+            interfaces.clear();
+        }
+        status = IpNameService::Instance().OpenInterface(TRANSPORT_UDP, currentInterface);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("UDPTransport::StartListen(): OpenInterface() failed for %s", currentInterface.c_str()));
+        }
+    }
+    IpNameService::Instance().Enable(TRANSPORT_UDP, 0, 0, port, 0, false, false, true, false);
+
+    return ER_OK;
+}
+
+QStatus UDPTransport::StopListen(const char* listenSpec)
+{
+    QCC_DbgPrintf(("UDPTransport::StopListen(%s)", listenSpec));
+
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::StopListen(): Not running or stopping; exiting"));
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+
+    qcc::String normSpec;
+    map<qcc::String, qcc::String> argMap;
+    QStatus status = NormalizeListenSpec(listenSpec, normSpec, argMap);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::StopListen(): Invalid listen spec \"%s\"", listenSpec));
+        return status;
+    }
+
+    m_listenLock.Lock(MUTEX_CONTEXT);
+    if (!m_listening || (normSpec != m_listenSpec)) {
+        m_listenLock.Unlock(MUTEX_CONTEXT);
+        return ER_BUS_BAD_TRANSPORT_ARGS;
+    }
+    m_listening = false;
+    m_listenLock.Unlock(MUTEX_CONTEXT);
+
+    /* Stop answering for this transport; existing connections are not affected */
+    IpNameService::Instance().Enable(TRANSPORT_UDP, 0, 0, 0, 0, false, false, false, false);
+    return ER_OK;
+}
+
+void UDPTransport::EnableDiscovery(const char* namePrefix)
+{
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::EnableDiscovery(): Not running or stopping; exiting"));
+        return;
+    }
+
+    /* Discover every specific instance of the name, see TCPTransport::EnableDiscoveryInstance() */
+    qcc::String starred = namePrefix;
+    starred.append('*');
+
+    QStatus status = IpNameService::Instance().FindAdvertisedName(TRANSPORT_UDP, starred);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::EnableDiscovery(): Failed to begin discovery of \"%s\"", starred.c_str()));
+    }
+}
+
+void UDPTransport::DisableDiscovery(const char* namePrefix)
+{
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::DisableDiscovery(): Not running or stopping; exiting"));
+        return;
+    }
+
+    qcc::String starred = namePrefix;
+    starred.append('*');
+
+    QStatus status = IpNameService::Instance().CancelFindAdvertisedName(TRANSPORT_UDP, starred);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::DisableDiscovery(): Failed to end discovery of \"%s\"", starred.c_str()));
+    }
+}
+
+QStatus UDPTransport::EnableAdvertisement(const qcc::String& advertiseName, bool quietly)
+{
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::EnableAdvertisement(): Not running or stopping; exiting"));
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+
+    QStatus status = IpNameService::Instance().AdvertiseName(TRANSPORT_UDP, advertiseName, quietly);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::EnableAdvertisement(): Failed to advertise \"%s\"", advertiseName.c_str()));
+    }
+    return status;
+}
+
+void UDPTransport::DisableAdvertisement(const qcc::String& advertiseName, bool nameListEmpty)
+{
+    if (IsRunning() == false || m_stopping == true) {
+        QCC_LogError(ER_BUS_TRANSPORT_NOT_STARTED, ("UDPTransport::DisableAdvertisement(): Not running or stopping; exiting"));
+        return;
+    }
+
+    QStatus status = IpNameService::Instance().CancelAdvertiseName(TRANSPORT_UDP, advertiseName);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("UDPTransport::DisableAdvertisement(): Failed to stop advertising \"%s\"", advertiseName.c_str()));
+    }
+}
+
+void UDPTransport::FoundCallback::Found(const qcc::String& busAddr, const qcc::String& guid,
+                                        std::vector<qcc::String>& nameList, uint8_t timer)
+{
+    QCC_DbgPrintf(("UDPTransport::FoundCallback::Found(): busAddr = \"%s\"", busAddr.c_str()));
+
+    /*
+     * The name service hands us every endpoint of the answer, e.g.
+     * "r4addr=192.168.1.1,r4port=9955,u4addr=192.168.1.1,u4port=9956".  Only
+     * the unreliable IPv4 endpoint is of use to this transport.
+     */
+    std::map<qcc::String, qcc::String> argMap;
+    qcc::String spec = qcc::String(TransportName) + ":" + busAddr;
+    if (Transport::ParseArguments(TransportName, spec.c_str(), argMap) != ER_OK) {
+        return;
+    }
+    std::map<qcc::String, qcc::String>::iterator a = argMap.find("u4addr");
+    std::map<qcc::String, qcc::String>::iterator p = argMap.find("u4port");
+    if ((a == argMap.end()) || (p == argMap.end())) {
+        QCC_DbgPrintf(("UDPTransport::FoundCallback::Found(): No u4addr or u4port in busaddr."));
+        return;
+    }
+
+    qcc::String newBusAddr = qcc::String(TransportName) + ":u4addr=" + a->second + ",u4port=" + p->second;
+    if (m_listener) {
+        QCC_DbgPrintf(("UDPTransport::FoundCallback::Found(): FoundNames(): %s", newBusAddr.c_str()));
+        m_listener->FoundNames(newBusAddr, guid, TRANSPORT_UDP, &nameList, timer);
+    }
+}
+
+} // namespace ajn
@@ -0,0 +1,400 @@
+/**
+ * @file
+ * UDPTransport is a specialization of class Transport for daemons talking over
+ * PacketEngine on plain UDP.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef _ALLJOYN_UDPTRANSPORT_H
+#define _ALLJOYN_UDPTRANSPORT_H
+
+#ifndef __cplusplus
+#error Only include UDPTransport.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <set>
+#include <vector>
+
+#include <qcc/String.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <qcc/time.h>
+
+#include <alljoyn/TransportMask.h>
+
+#include "Transport.h"
+#include "RemoteEndpoint.h"
+#include "PacketEngine.h"
+#include "UDPPacketStream.h"
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+class _UDPEndpoint;
+typedef qcc::ManagedObj<_UDPEndpoint> UDPEndpoint;
+
+/**
+ * @brief A class for UDP Transports used in daemons.
+ *
+ * UDPTransport carries bus-to-bus message sessions over a PacketEngine channel
+ * on a single UDP socket per listen spec, without the candidate gathering and
+ * rendezvous server of the ICE transport.  It is meant for peers on the same
+ * LAN segment: names are advertised and discovered through the IP name service
+ * with the TRANSPORT_UDP mask, which carries the unreliable IPv4 endpoint
+ * ("u4addr", "u4port") of the listener.  The PacketEngine provides ordering,
+ * retransmission and congestion control.
+ *
+ * The transport is only active if a listen spec such as
+ * "udp:u4addr=0.0.0.0,u4port=9956" is configured.
+ */
+class UDPTransport : public Transport, public _RemoteEndpoint::EndpointListener, public qcc::Thread, public PacketEngineListener {
+    friend class _UDPEndpoint;
+
+  public:
+    /**
+     * Create a UDP based transport for use by daemons.
+     *
+     * @param bus The BusAttachment associated with this endpoint
+     */
+    UDPTransport(BusAttachment& bus);
+
+    /**
+     * Destructor
+     */
+    virtual ~UDPTransport();
+
+    /**
+     * Start the transport and associate it with a router.
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus Start();
+
+    /**
+     * Stop the transport.
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus Stop();
+
+    /**
+     * Pend the caller until the transport stops.
+     *
+     * @return
+     *      - ER_OK if successful
+     *      - an error status otherwise.
+     */
+    QStatus Join();
+
+    /**
+     * Determine if this transport is running. Running means Start() has been called.
+     *
+     * @return  Returns true if the transport is running.
+     */
+    bool IsRunning() { return Thread::IsRunning(); }
+
+    /**
+     * @internal
+     * @brief Normalize a transport specification.
+     *
+     * Given a transport specification, convert it into a form which is guaranteed to
+     * have a one-to-one relationship with a connection instance.
+     *
+     * @param inSpec    Input transport connect spec.
+     * @param outSpec   Output transport connect spec.
+     * @param argMap    Parsed parameter map.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const;
+
+    /**
+     * Connect to a specified remote AllJoyn/DBus address.
+     *
+     * @param connectSpec    Transport specific key/value args used to configure the client-side endpoint.
+     *                       The form of this string is @c "udp:u4addr=<addr>,u4port=<port>"
+     * @param opts           Requested sessions opts.
+     * @param newep          [OUT] Endpoint created as a result of successful connect.
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus Connect(const char* connectSpec, const SessionOpts& opts, BusEndpoint& newep);
+
+    /**
+     * Disconnect from a specified AllJoyn/DBus address.
+     *
+     * @param connectSpec    The connectSpec used in Connect.
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus Disconnect(const char* connectSpec);
+
+    /**
+     * Start listening for incomming connections on a specified bus address.
+     *
+     * @param listenSpec  Transport specific key/value arguments that specify the physical interface to listen on.
+     *                    - Valid transport is @c "udp". All others ignored.
+     *                    - Valid keys are:
+     *                        - @c u4addr = IPv4 address to bind, defaults to INADDR_ANY.
+     *                        - @c u4port = UDP port to bind, defaults to 9956.
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus StartListen(const char* listenSpec);
+
+    /**
+     * @brief Stop listening for incoming connections on a specified bus address.
+     *
+     * This method cancels a StartListen request. Therefore, the listenSpec must
+     * match previous call to StartListen().
+     *
+     * @param listenSpec  The listenSpec used in StartListen.
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus StopListen(const char* listenSpec);
+
+    /**
+     * Set a listener for transport related events.  There can only be one
+     * listener set at a time. Setting a listener implicitly removes any
+     * previously set listener.
+     *
+     * @param listener  Listener for transport related events.
+     */
+    void SetListener(TransportListener* listener) { m_listener = listener; }
+
+    /**
+     * Indicates whether this transport is used for client-to-bus or bus-to-bus connections.
+     *
+     * @return  Always returns true, UDP is a bus-to-bus transport.
+     */
+    bool IsBusToBus() const { return true; }
+
+    /**
+     * @internal
+     * @brief Start discovering busses.
+     */
+    void EnableDiscovery(const char* namePrefix);
+
+    /**
+     * @internal
+     * @brief Stop discovering busses to connect to.
+     */
+    void DisableDiscovery(const char* namePrefix);
+
+    /**
+     * Start advertising a well-known name with the given quality of service.
+     *
+     * @param advertiseName   Well-known name to add to list of advertised names.
+     * @param quietly         Advertise the name quietly
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus EnableAdvertisement(const qcc::String& advertiseName, bool quietly);
+
+    /**
+     * Stop advertising a well-known name with a given quality of service.
+     *
+     * @param advertiseName   Well-known name to remove from list of advertised names.
+     * @param nameListEmpty   Indicates whether advertise name list is completely empty (safe to disable OTA advertising).
+     */
+    void DisableAdvertisement(const qcc::String& advertiseName, bool nameListEmpty);
+
+    /**
+     * Returns the name of this transport
+     */
+    const char* GetTransportName() const { return TransportName; }
+
+    /**
+     * Get the transport mask for this transport
+     *
+     * @return the TransportMask for this transport.
+     */
+    TransportMask GetTransportMask() const { return TRANSPORT_UDP; }
+
+    /**
+     * Get a list of the possible listen specs of the current Transport for a
+     * given set of session options.
+     *
+     * Only message sessions are carried, so nothing is added for raw sessions.
+     * Otherwise one "udp:u4addr=...,u4port=..." address is added for every
+     * IPv4 address of an up, non-loopback interface.
+     *
+     * @param opts Session options describing the desired characteristics of
+     *             an underlying session
+     * @param busAddrs A vector of String to which bus addresses corresponding
+     *                 to IFF_UP interfaces matching the desired characteristics
+     *                 are added.
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus GetListenAddresses(const SessionOpts& opts, std::vector<qcc::String>& busAddrs) const;
+
+    /**
+     * Callback for UDPEndpoint exit.
+     *
+     * @param endpoint   UDPEndpoint instance that has exited.
+     */
+    void EndpointExit(RemoteEndpoint& endpoint);
+
+    /**
+     * PacketEngineAccept callback
+     */
+    bool PacketEngineAcceptCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest);
+
+    /**
+     * PacketEngineConnect callback
+     */
+    void PacketEngineConnectCB(PacketEngine& engine, QStatus status, const PacketEngineStream* stream, const PacketDest& dest, void* context);
+
+    /**
+     * PacketEngineDisconnect callback
+     */
+    void PacketEngineDisconnectCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest);
+
+    /**
+     * Name of transport used in transport specs.
+     */
+    static const char* TransportName;
+
+  private:
+    UDPTransport(const UDPTransport& other);
+    UDPTransport& operator =(const UDPTransport& other);
+
+    /**
+     * Parse a listen spec, filling in the defaults for missing keys.
+     */
+    QStatus NormalizeListenSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const;
+
+    void* Run(void* arg);
+
+    /**
+     * Called by the auth thread of a passive endpoint once Establish() has succeeded.
+     */
+    void Authenticated(UDPEndpoint& conn);
+
+    /**
+     * Reap failed or slow authenticators and stopped endpoints.
+     */
+    void ManageEndpoints(qcc::Timespec tTimeout);
+
+    /**
+     * Remove the listen stream from the PacketEngine and delete it.
+     */
+    void CloseListenStream();
+
+    /**
+     * Read the congestion control algorithm for PacketEngine channels from
+     * "udp/property@congestion_control".
+     */
+    static CongestionControlType GetCongestionControl();
+
+    /**
+     * Called by the IP name service when it hears about names advertised over UDP.
+     */
+    class FoundCallback {
+      public:
+        FoundCallback(TransportListener*& listener) : m_listener(listener) { }
+        void Found(const qcc::String& busAddr, const qcc::String& guid, std::vector<qcc::String>& nameList, uint8_t timer);
+      private:
+        TransportListener*& m_listener;
+    };
+
+    BusAttachment& m_bus;                          /**< The message bus for this transport */
+    bool m_stopping;                               /**< True if Stop() has been called but endpoints still exist */
+    TransportListener* m_listener;                 /**< Registered TransportListener */
+    FoundCallback m_foundCallback;                 /**< Called by the name service when it finds a remote name */
+    int32_t m_nsReleaseCount;                      /**< Number of times Release() was called on the name service */
+    std::set<UDPEndpoint> m_authList;              /**< Set of authenticating endpoints */
+    std::set<UDPEndpoint> m_endpointList;          /**< Set of active endpoints */
+    qcc::Mutex m_endpointListLock;                 /**< Mutex that protects the endpoint and auth lists */
+    qcc::Event m_wakeRun;                          /**< Wakes the Run thread to manage the endpoint lists */
+    PacketEngine m_packetEngine;                   /**< Packet engine carrying every connection of this transport */
+    qcc::Mutex m_listenLock;                       /**< Protects the members below */
+    UDPPacketStream* m_listenStream;               /**< The socket shared by incoming and outgoing connections */
+    qcc::String m_listenSpec;                      /**< Normalized listen spec of m_listenStream */
+    bool m_listening;                              /**< True between StartListen() and StopListen() */
+
+    /**
+     * @brief The default timeout for in-process authentications.
+     *
+     * This value can be overridden in the config file by setting "auth_timeout".
+     */
+    static const uint32_t ALLJOYN_AUTH_TIMEOUT_DEFAULT = 30000;
+
+    /**
+     * @brief The default value for the maximum number of authenticating
+     * connections.
+     *
+     * To override this value, change the limit,
+     * "udp/limit@max_incomplete_connections".
+     */
+    static const uint32_t ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_UDP_DEFAULT = 10;
+
+    /**
+     * @brief The default value for the maximum number of UDP connections
+     * (remote endpoints).
+     *
+     * To override this value, change the limit,
+     * "udp/limit@max_completed_connections".
+     */
+    static const uint32_t ALLJOYN_MAX_COMPLETED_CONNECTIONS_UDP_DEFAULT = 50;
+
+    /**
+     * @brief The default maximum PacketEngine window size in packets.
+     *
+     * Must be a power of 2 no larger than 1024. To override this value,
+     * change the limit, "udp/limit@packet_engine_window".
+     */
+    static const uint32_t ALLJOYN_PACKET_ENGINE_WINDOW_UDP_DEFAULT = 128;
+
+    /**
+     * @brief The default number of PacketEngine channel shards.
+     *
+     * To override this value, change the limit, "udp/limit@packet_engine_shards".
+     */
+    static const uint32_t ALLJOYN_PACKET_ENGINE_SHARDS_UDP_DEFAULT = 1;
+
+    /**
+     * @brief The default maximum number of free packets kept by the PacketEngine
+     * packet pool.
+     *
+     * To override this value, change the limit, "udp/limit@packet_pool_high_water".
+     */
+    static const uint32_t ALLJOYN_PACKET_POOL_HIGH_WATER_UDP_DEFAULT = 1024;
+};
+
+} // namespace ajn
+
+#endif // _ALLJOYN_UDPTRANSPORT_H
@@ -152,6 +152,7 @@ bool _VirtualEndpoint::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
         if (it->second == endpoint) {
             /* A non-zero session means that the b2b has one less ref */
             if (it->first != 0) {
+                it->second->RemoveSessionRoute(it->first);
                 it->second->DecrementRef();
             }
             m_b2bEndpoints.erase(it++);
@@ -215,6 +216,7 @@ QStatus _VirtualEndpoint::AddSessionRef(SessionId id, RemoteEndpoint& b2bEp)
     if (canUse) {
         /* Increment b2bEp ref */
         b2bEp->IncrementRef();
+        b2bEp->AddSessionRoute(id);
         /* Map sessionId to b2bEp */
         m_b2bEndpoints.insert(pair<SessionId, RemoteEndpoint>(id, b2bEp));
         m_hasRefs = true;
@@ -270,6 +272,7 @@ void _VirtualEndpoint::RemoveSessionRef(SessionId id)
     m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
     multimap<SessionId, RemoteEndpoint>::iterator it = m_b2bEndpoints.find(id);
     if (it != m_b2bEndpoints.end()) {
+        it->second->RemoveSessionRoute(id);
         it->second->DecrementRef();
         m_b2bEndpoints.erase(it);
     } else {
@@ -140,6 +140,7 @@ QStatus P2PHelperInterface::Init(BusAttachment* bus)
 
             m_interface->AddSignal("OnFoundAdvertisedName",      "ssss", "name,namePrefix,guid,device");
             m_interface->AddSignal("OnLostAdvertisedName",       "ssss", "name,namePrefix,guid,device");
+            m_interface->AddSignal("OnLostAdvertisedNames",      "a(sss)s", "names,device");
             m_interface->AddSignal("OnLinkEstablished",          "is",   "handle,interface");
             m_interface->AddSignal("OnLinkError",                "ii",   "handle,error");
             m_interface->AddSignal("OnLinkLost",                 "i",    "handle");
@@ -215,6 +216,18 @@ QStatus P2PHelperInterface::UnregisterSignalHandlers(void)
         }
     }
 
+    member = m_interface->GetMember("OnLostAdvertisedNames");
+    if (member) {
+        status =  m_bus->UnregisterSignalHandler(m_listenerInternal,
+                                                 static_cast<MessageReceiver::SignalHandler>(&P2PHelperListenerInternal::OnLostAdvertisedNames),
+                                                 member,
+                                                 NULL);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("P2PHelperInterface::UnregisterSignalHandlers(): Error calling UnregisterSignalHandler()"));
+            return status;
+        }
+    }
+
     member = m_interface->GetMember("OnLinkEstablished");
     if (member) {
         status =  m_bus->UnregisterSignalHandler(m_listenerInternal,
@@ -282,6 +295,18 @@ QStatus P2PHelperInterface::RegisterSignalHandlers(void)
         return status;
     }
 
+    member = m_interface->GetMember("OnLostAdvertisedNames");
+    assert(member && "P2PHelperInterface::Init(): GetMember(\"OnLostAdvertisedNames\") failed");
+    status =  m_bus->RegisterSignalHandler(m_listenerInternal,
+                                           static_cast<MessageReceiver::SignalHandler>(&P2PHelperListenerInternal::OnLostAdvertisedNames),
+                                           member,
+                                           NULL);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("P2PHelperInterface::RegisterSignalHandlers(): Error calling RegisterSignalHandler()"));
+        assert(0);
+        return status;
+    }
+
     member = m_interface->GetMember("OnLinkEstablished");
     assert(member && "P2PHelperInterface::Init(): GetMember(\"OnLinkEstablished\") failed");
     status =  m_bus->RegisterSignalHandler(m_listenerInternal,
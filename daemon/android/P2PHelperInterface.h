@@ -143,6 +143,35 @@ class P2PHelperInterface : public MessageReceiver {
 
         }
 
+        /*
+         * When a device goes away the P2P Helper Service sends all of the names
+         * it was advertising in one signal instead of one signal per name.
+         */
+        void OnLostAdvertisedNames(const InterfaceDescription::Member* member, const char* sourcePath, Message& message)
+        {
+            QCC_DbgPrintf(("P2PHelperListenerInternal::OnLostAdvertisedNames()"));
+            if (message->GetType() == MESSAGE_SIGNAL && m_parent && m_parent->m_listener) {
+                size_t numNames = 0;
+                const MsgArg* names = NULL;
+                message->GetArg(0)->Get("a(sss)", &numNames, &names);
+                qcc::String device(message->GetArg(1)->v_string.str);
+
+                for (size_t i = 0; i < numNames; ++i) {
+                    const char* cName;
+                    const char* cNamePrefix;
+                    const char* cGuid;
+                    if (names[i].Get("(sss)", &cName, &cNamePrefix, &cGuid) == ER_OK) {
+                        qcc::String name(cName);
+                        qcc::String namePrefix(cNamePrefix);
+                        qcc::String guid(cGuid);
+                        m_parent->m_listener->OnLostAdvertisedName(name, namePrefix, guid, device);
+                    }
+                }
+            } else {
+                QCC_DbgPrintf(("P2PHelperListenerInternal::OnLostAdvertisedNames(): Discard."));
+            }
+        }
+
         void OnLinkEstablished(const InterfaceDescription::Member* member, const char* sourcePath, Message& message)
         {
             QCC_DbgPrintf(("P2PHelperListenerInternal::OnLinkEstablished()"));
@@ -196,6 +196,25 @@ QStatus P2PNameServiceImpl::CancelFindAdvertisedName(TransportMask transportMask
         return ER_FAIL;
     }
 
+    /*
+     * Forget the names found under this prefix so that they are passed on
+     * again if someone starts looking for them again.
+     */
+    qcc::String namePrefix = wkn;
+    if (!namePrefix.empty() && namePrefix[namePrefix.size() - 1] == '*') {
+        namePrefix.erase(namePrefix.size() - 1);
+    }
+    for (std::map<qcc::StringMapKey, std::map<qcc::String, qcc::String> >::iterator i = m_names.begin(); i != m_names.end(); ++i) {
+        std::map<qcc::String, qcc::String>::iterator j = i->second.begin();
+        while (j != i->second.end()) {
+            if (j->second == namePrefix) {
+                i->second.erase(j++);
+            } else {
+                ++j;
+            }
+        }
+    }
+
     assert(m_p2pHelperInterface && "P2PNameServiceImpl::CancelAdvertisedName(): No m_p2pHelperInterface");
     return m_p2pHelperInterface->CancelFindAdvertisedNameAsync(wkn);
 }
@@ -261,6 +280,17 @@ void P2PNameServiceImpl::OnFoundAdvertisedName(qcc::String& name, qcc::String& n
 
     m_devices[guid] = device;
 
+    /*
+     * The P2P Helper Service tells us about a name every time it sees the
+     * service record again.  Only a name that is new for this guid is news.
+     */
+    std::map<qcc::String, qcc::String>& names = m_names[guid];
+    if (names.find(name) != names.end()) {
+        QCC_DbgPrintf(("P2PNameServiceImpl::OnFoundAdvertisedName(): Already know \"%s\"", name.c_str()));
+        return;
+    }
+    names[name] = namePrefix;
+
     if (m_callback == 0) {
         QCC_DbgPrintf(("P2PNameServiceImpl::OnFoundAdvertisedName(): No callback"));
     } else {
@@ -273,13 +303,24 @@ void P2PNameServiceImpl::OnLostAdvertisedName(qcc::String& name, qcc::String& na
 {
     QCC_DbgPrintf(("P2PNameServiceImpl::OnLostAdvertisedName()"));
 
-    QCC_DbgPrintf(("P2PNameServiceImpl::OnLostAdvertisedName(): Device \"%s\" lost.  Daemon of GUID \"%s\" is gone",
-                   device.c_str(), guid.c_str()));
-
+    /*
+     * Only pass on the loss of a name we passed on as found.  The daemon
+     * stays reachable through its device as long as it has names left.
+     */
+    std::map<qcc::StringMapKey, std::map<qcc::String, qcc::String> >::iterator n = m_names.find(guid);
+    if (n == m_names.end() || n->second.erase(name) == 0) {
+        QCC_DbgPrintf(("P2PNameServiceImpl::OnLostAdvertisedName(): Never found \"%s\"", name.c_str()));
+        return;
+    }
 
-    std::map<qcc::StringMapKey, qcc::String>::iterator i = m_devices.find(guid);
-    if (i != m_devices.end()) {
-        m_devices.erase(i);
+    if (n->second.empty()) {
+        QCC_DbgPrintf(("P2PNameServiceImpl::OnLostAdvertisedName(): Device \"%s\" lost.  Daemon of GUID \"%s\" is gone",
+                       device.c_str(), guid.c_str()));
+        m_names.erase(n);
+        std::map<qcc::StringMapKey, qcc::String>::iterator i = m_devices.find(guid);
+        if (i != m_devices.end()) {
+            m_devices.erase(i);
+        }
     }
 
     if (m_callback == 0) {
@@ -423,6 +423,14 @@ class P2PNameServiceImpl {
     BusAttachment* m_bus;                       /**< The AllJoyn bus attachment that we use to talk to the P2P Helper Service */
 
     std::map<qcc::StringMapKey, qcc::String> m_devices;  /**< map of guids to advertising devices */
+
+    /**
+     * The names we have passed on as found, and the name prefix each was
+     * found under, for each guid.  The P2P Helper Service repeats found
+     * events for names we already know, so we use this to only pass on
+     * changes.
+     */
+    std::map<qcc::StringMapKey, std::map<qcc::String, qcc::String> > m_names;
 };
 
 } // namespace ajn
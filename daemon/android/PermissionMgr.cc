@@ -38,6 +38,18 @@ QStatus TransportPermission::FilterTransports(BusEndpoint& srcEp, const qcc::Str
     QCC_DbgPrintf(("TransportPermission::FilterTransports() callerName(%s)", callerName));
     QStatus status = ER_OK;
     if (srcEp->IsValid()) {
+        /* Decisions already made for this endpoint are taken from the cache */
+        const TransportMask checked = TRANSPORT_BLUETOOTH | TRANSPORT_WLAN | TRANSPORT_ICE;
+        TransportMask allowedMask;
+        if (PermissionMgr::GetCachedTransports(srcEp, transports & checked, allowedMask)) {
+            TransportMask denied = (transports & checked) & ~allowedMask;
+            if (denied) {
+                QCC_LogError(ER_ALLJOYN_ACCESS_PERMISSION_WARNING, ("AllJoynObj::%s() WARNING: No permission to use transports 0x%x", (callerName == NULL) ? "" : callerName, denied));
+                transports &= ~denied;
+            }
+            return (transports == 0) ? ER_BUS_NO_TRANSPORTS : ER_OK;
+        }
+        TransportMask requested = transports & checked;
         if (transports & TRANSPORT_BLUETOOTH) {
             bool allowed = PermissionDB::GetDB().IsBluetoothAllowed(srcEp->GetUserId());
             if (!allowed) {
@@ -59,6 +71,7 @@ QStatus TransportPermission::FilterTransports(BusEndpoint& srcEp, const qcc::Str
                 QCC_LogError(ER_ALLJOYN_ACCESS_PERMISSION_WARNING, ("AllJoynObj::%s() WARNING: No permission to use Wifi for ICE", ((callerName == NULL) ? "" : callerName)));
             }
         }
+        PermissionMgr::CacheTransports(srcEp, requested, transports & requested);
         if (transports == 0) {
             status = ER_BUS_NO_TRANSPORTS;
         }
@@ -89,6 +102,9 @@ uint32_t PermissionMgr::AddAliasUnixUser(BusEndpoint& srcEp, qcc::String& sender
     if (replyCode == ALLJOYN_ALIASUNIXUSER_REPLY_SUCCESS) {
         if (PermissionDB::GetDB().AddAliasUnixUser(origUID, aliasUID) != ER_OK) {
             replyCode = ALLJOYN_ALIASUNIXUSER_REPLY_FAILED;
+        } else {
+            /* Endpoints running as the alias now get the permissions of the original user */
+            ResetPermissionCache();
         }
     }
     return replyCode;
@@ -97,6 +113,7 @@ uint32_t PermissionMgr::AddAliasUnixUser(BusEndpoint& srcEp, qcc::String& sender
 QStatus PermissionMgr::CleanPermissionCache(BusEndpoint& endpoint)
 {
     QCC_DbgHLPrintf(("PermissionMgr::CleanPermissionCache()"));
+    RemoveCachedDecisions(endpoint);
     return PermissionDB::GetDB().RemovePermissionCache(endpoint);
 }
 
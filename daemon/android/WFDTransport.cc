@@ -27,6 +27,7 @@
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 #include <qcc/IfConfig.h>
+#include <qcc/time.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/TransportMask.h>
@@ -375,6 +376,7 @@ void* _WFDEndpoint::AuthThread::Run(void* arg)
     ep->GetFeatures().isBusToBus = false;
     ep->GetFeatures().isBusToBus = false;
     ep->GetFeatures().handlePassing = false;
+    ep->GetFeatures().bodyCompression = true;
 
     qcc::String authName;
     qcc::String redirection;
@@ -438,6 +440,7 @@ void* _WFDEndpoint::AuthThread::Run(void* arg)
 
 WFDTransport::WFDTransport(BusAttachment& bus)
     : Thread("WFDTransport"), m_bus(bus), m_stopping(false), m_listener(0),
+    m_groupLinger(ALLJOYN_WFD_GROUP_LINGER_DEFAULT), m_connecting(0), m_lingerDeadline(0),
     m_isAdvertising(false), m_isDiscovering(false), m_isListening(false), m_isNsEnabled(false),
     m_listenPort(0), m_p2pNsAcquired(false), m_p2pCmAcquired(false), m_ipNsAcquired(false)
 {
@@ -1067,8 +1070,17 @@ void WFDTransport::ManageEndpoints(Timespec tTimeout)
      * level (layer four) connection lost messages are routed up from the kernel
      * through TCP directly here.  This means that the ordering of the events
      * EndpointExit() and OnLinkLost() is not deterministic at all.
+     *
+     * If a linger time is configured and we are still a STA in a group, we
+     * leave the group up so that a following Connect() to the same device can
+     * reuse it.  ManageGroup() tears it down if it stays idle for too long.
      */
-    if (endpointCleaned && m_endpointList.empty() && m_authList.empty()) {
+    if (endpointCleaned && m_endpointList.empty() && m_authList.empty() && m_groupLinger && P2PConMan::Instance().IsConnectedSTA()) {
+        QCC_DbgPrintf(("WFDTransport::ManageEndpoints(): Last endpoint gone, leaving STA group up for %d ms", m_groupLinger));
+        m_groupLock.Lock(MUTEX_CONTEXT);
+        m_lingerDeadline = GetTimestamp64() + m_groupLinger;
+        m_groupLock.Unlock(MUTEX_CONTEXT);
+    } else if (endpointCleaned && m_endpointList.empty() && m_authList.empty()) {
         QCC_DbgPrintf(("WFDTransport::ManageEndpoints(): DestroyTemporaryNetwork()"));
         QStatus status = P2PConMan::Instance().DestroyTemporaryNetwork();
         if (status != ER_OK) {
@@ -1087,6 +1099,93 @@ void WFDTransport::ManageEndpoints(Timespec tTimeout)
     m_endpointListLock.Unlock(MUTEX_CONTEXT);
 }
 
+uint32_t WFDTransport::ManageGroup(void)
+{
+    QCC_DbgTrace(("WFDTransport::ManageGroup()"));
+
+    if (m_groupLinger == 0) {
+        return Event::WAIT_FOREVER;
+    }
+
+    /*
+     * A group is idle if no endpoints are using it and no Connect() is
+     * about to.  Connect() does its own group formation, so we stay out of
+     * its way and only deal with idle groups here.
+     */
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_groupLock.Lock(MUTEX_CONTEXT);
+    bool idle = m_endpointList.empty() && m_authList.empty() && m_connecting == 0;
+    qcc::String guid = m_prewarmGuid;
+    m_prewarmGuid.clear();
+    if (!idle) {
+        m_lingerDeadline = 0;
+    }
+    uint64_t deadline = m_lingerDeadline;
+    m_groupLock.Unlock(MUTEX_CONTEXT);
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    if (!idle) {
+        return Event::WAIT_FOREVER;
+    }
+
+    uint64_t now = GetTimestamp64();
+    if (deadline && now >= deadline) {
+        QCC_DbgPrintf(("WFDTransport::ManageGroup(): Idle STA group lingered for %d ms.  DestroyTemporaryNetwork()", m_groupLinger));
+        QStatus status = P2PConMan::Instance().DestroyTemporaryNetwork();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("WFDTransport::ManageGroup(): Unable to destroy temporary network"));
+        }
+
+        /*
+         * Just as in ManageEndpoints(), if we are a service we need to go back
+         * to the ready state.
+         */
+        if (m_isAdvertising) {
+            qcc::String localDevice("");
+            status = P2PConMan::Instance().CreateTemporaryNetwork(localDevice, P2PConMan::DEVICE_SHOULD_BE_GO);
+            if (status != ER_OK) {
+                QCC_LogError(status, ("WFDTransport::ManageGroup(): Unable to recreate temporary network (SHOULD_BE_GO)"));
+            }
+        }
+        deadline = 0;
+    }
+
+    /*
+     * We only pre-warm if nothing else wants the radio.  A service must stay
+     * ready to be a GO, and an existing group means we are already busy.  The
+     * device may have been lost since we heard about it, in which case the
+     * name service no longer knows it and we just drop the request.
+     */
+    qcc::String device;
+    if (!guid.empty() && deadline == 0 && !m_isAdvertising && !P2PConMan::Instance().IsConnected() &&
+        P2PNameService::Instance().GetDeviceForGuid(guid, device) == ER_OK) {
+        QCC_DbgPrintf(("WFDTransport::ManageGroup(): Pre-warming group with device \"%s\"", device.c_str()));
+        QStatus status = P2PConMan::Instance().CreateTemporaryNetwork(device, P2PConMan::DEVICE_SHOULD_BE_STA);
+        if (status == ER_OK) {
+            deadline = GetTimestamp64() + m_groupLinger;
+        } else {
+            QCC_LogError(status, ("WFDTransport::ManageGroup(): Unable to pre-warm group with device \"%s\"", device.c_str()));
+        }
+    }
+
+    /*
+     * A Connect() may have started while we were forming groups, in which
+     * case it now owns the group and the deadline no longer applies.
+     */
+    m_groupLock.Lock(MUTEX_CONTEXT);
+    if (m_connecting) {
+        deadline = 0;
+    }
+    m_lingerDeadline = deadline;
+    m_groupLock.Unlock(MUTEX_CONTEXT);
+
+    if (deadline == 0) {
+        return Event::WAIT_FOREVER;
+    }
+    now = GetTimestamp64();
+    return deadline > now ? static_cast<uint32_t>(deadline - now) : 0;
+}
+
 void* WFDTransport::Run(void* arg)
 {
     QCC_DbgTrace(("WFDTransport::Run()"));
@@ -1120,7 +1219,14 @@ void* WFDTransport::Run(void* arg)
      */
     uint32_t maxConn = config->Get("limit@max_completed_connections", ALLJOYN_MAX_COMPLETED_CONNECTIONS_WFD_DEFAULT);
 
+    /*
+     * m_groupLinger is how long we keep an idle STA group up and also turns
+     * on pre-warming of groups with devices we discover.
+     */
+    m_groupLinger = config->Get("limit@wfd_group_linger", ALLJOYN_WFD_GROUP_LINGER_DEFAULT);
+
     QStatus status = ER_OK;
+    uint32_t waitMs = Event::WAIT_FOREVER;
 
     while (!IsStopping()) {
         /*
@@ -1140,11 +1246,15 @@ void* WFDTransport::Run(void* arg)
 
         /*
          * We have our list of events, so now wait for something to happen
-         * on that list (or get alerted).
+         * on that list (or get alerted).  If an idle group is lingering we
+         * only wait until it is due to be torn down.
          */
         signaledEvents.clear();
 
-        status = Event::Wait(checkEvents, signaledEvents);
+        status = Event::Wait(checkEvents, signaledEvents, waitMs);
+        if (ER_TIMEOUT == status) {
+            status = ER_OK;
+        }
         if (ER_OK != status) {
             QCC_LogError(status, ("Event::Wait failed"));
             break;
@@ -1284,6 +1394,12 @@ void* WFDTransport::Run(void* arg)
          * UDP listeners.
          */
         RunListenMachine();
+
+        /*
+         * Pre-warm and linger management for Wi-Fi Direct groups is also done
+         * here so that it is serialized with the endpoint management above.
+         */
+        waitMs = ManageGroup();
     }
 
     /*
@@ -2263,6 +2379,40 @@ QStatus WFDTransport::Connect(const char* connectSpec, const SessionOpts& opts,
 {
     QCC_DbgTrace(("WFDTransport::Connect(): %s", connectSpec));
 
+    /*
+     * While a Connect() is in progress any lingering or pre-warmed group
+     * belongs to it, so ManageGroup() must leave it alone.
+     */
+    m_groupLock.Lock(MUTEX_CONTEXT);
+    ++m_connecting;
+    m_lingerDeadline = 0;
+    m_groupLock.Unlock(MUTEX_CONTEXT);
+
+    QStatus status = DoConnect(connectSpec, opts, newep);
+
+    /*
+     * If we failed and left a STA group up with nobody using it, start the
+     * linger clock on it just as if its last endpoint had gone away.
+     */
+    m_endpointListLock.Lock(MUTEX_CONTEXT);
+    m_groupLock.Lock(MUTEX_CONTEXT);
+    --m_connecting;
+    if (status != ER_OK && m_groupLinger && m_connecting == 0 && m_endpointList.empty() && m_authList.empty() &&
+        P2PConMan::Instance().IsConnectedSTA()) {
+        m_lingerDeadline = GetTimestamp64() + m_groupLinger;
+    }
+    m_groupLock.Unlock(MUTEX_CONTEXT);
+    m_endpointListLock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * Let the server accept loop pick up the new linger state.
+     */
+    Alert();
+    return status;
+}
+
+QStatus WFDTransport::DoConnect(const char* connectSpec, const SessionOpts& opts, BusEndpoint& newep)
+{
     QStatus status;
     bool isConnected = false;
 
@@ -2528,6 +2678,23 @@ QStatus WFDTransport::Connect(const char* connectSpec, const SessionOpts& opts,
 
         QCC_DbgPrintf(("WFDTransport::Connect(): Device \"%s\" corresponds to GUID \"%s\"", device.c_str(), guid.c_str()));
 
+        /*
+         * A STA group that is only up because it is lingering or was
+         * pre-warmed has no endpoints using it.  If it is with some other
+         * device it must not turn this into a forbidden second STA connection
+         * (case three below), we just give it up and proceed as if we were
+         * completely disconnected (case one).
+         */
+        if (connected && !ourGroupOwner && m_groupLinger && P2PConMan::Instance().IsConnectedSTA()) {
+            m_endpointListLock.Lock(MUTEX_CONTEXT);
+            bool idle = m_endpointList.empty() && m_authList.empty();
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+            if (idle) {
+                QCC_DbgPrintf(("WFDTransport::Connect(): Giving up idle STA group for device \"%s\"", device.c_str()));
+                connected = false;
+            }
+        }
+
         /*
          * case 1: !connected && !ourGroupOwner:  completely disconnected.
          * case 2: !connected &&  ourGroupOwner:  disconnected but connected to the desired group owner is impossible
@@ -2933,6 +3100,7 @@ QStatus WFDTransport::Connect(const char* connectSpec, const SessionOpts& opts,
         conn->GetFeatures().isBusToBus = true;
         conn->GetFeatures().allowRemote = m_bus.GetInternal().AllowRemoteMessages();
         conn->GetFeatures().handlePassing = false;
+        conn->GetFeatures().bodyCompression = true;
 
         qcc::String authName;
         qcc::String redirection;
@@ -3800,6 +3968,27 @@ void WFDTransport::P2PNameServiceCallback(const qcc::String& guid, qcc::String&
 
         m_listener->FoundNames(connectSpec, guid, TRANSPORT_WFD, &wkns, timer);
     }
+
+    /*
+     * The P2P name service only tells us about names we are looking for, so
+     * a found name is a good hint that a JoinSession() to its daemon will
+     * follow.  If pre-warming is enabled we ask the server accept loop to
+     * form the group now, since that takes seconds and we are called on the
+     * name service thread.  Only the first daemon found is pre-warmed, we
+     * can only be a STA in one group at a time.
+     */
+    if (m_groupLinger) {
+        m_groupLock.Lock(MUTEX_CONTEXT);
+        if (timer == 0) {
+            if (m_prewarmGuid == guid) {
+                m_prewarmGuid.clear();
+            }
+        } else if (m_prewarmGuid.empty()) {
+            m_prewarmGuid = guid;
+            Alert();
+        }
+        m_groupLock.Unlock(MUTEX_CONTEXT);
+    }
 }
 
 void WFDTransport::P2PConManNameCallback(const qcc::String& busAddr, const qcc::String& guid, std::vector<qcc::String>& nameList, uint8_t timer)
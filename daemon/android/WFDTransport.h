@@ -340,12 +340,34 @@ class WFDTransport : public Transport, public _RemoteEndpoint::EndpointListener,
     std::queue<ListenRequest> m_listenRequests;                    /**< Queue of StartListen and StopListen requests */
     qcc::Mutex m_listenRequestsLock;                               /**< Mutex that protects m_listenRequests */
 
+    uint32_t m_groupLinger;                                        /**< Time in ms an idle STA group is kept up, 0 disables pre-warming and linger */
+    uint32_t m_connecting;                                         /**< Number of Connect() calls in progress */
+    uint64_t m_lingerDeadline;                                     /**< When an idle STA group is torn down, 0 if there is none */
+    qcc::String m_prewarmGuid;                                     /**< GUID of a discovered daemon to form a group with ahead of Connect() */
+    qcc::Mutex m_groupLock;                                        /**< Mutex that protects the pre-warm and linger state */
+
     /**
      * @internal
      * @brief Manage the list of endpoints for the transport.
      */
     void ManageEndpoints(qcc::Timespec tTimeout);
 
+    /**
+     * @internal
+     * @brief Form a pending pre-warm group and tear down an idle STA group
+     * whose linger time has expired.  Called from the server accept loop.
+     *
+     * @return The number of ms until the next linger deadline, or
+     *         qcc::Event::WAIT_FOREVER if there is none.
+     */
+    uint32_t ManageGroup(void);
+
+    /**
+     * @internal
+     * @brief Does the work of Connect() once it has been counted as in progress.
+     */
+    QStatus DoConnect(const char* connectSpec, const SessionOpts& opts, BusEndpoint& newep);
+
     /**
      * @internal
      * @brief Thread entry point.
@@ -515,6 +537,21 @@ class WFDTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     static const uint32_t ALLJOYN_MAX_COMPLETED_CONNECTIONS_WFD_DEFAULT = 50;
 
+    /**
+     * @brief The default time in milliseconds that a Wi-Fi Direct group we
+     * joined as a STA is kept up after its last endpoint goes away.
+     *
+     * Forming a group takes seconds, so keeping an idle group around lets a
+     * following JoinSession() to the same device skip that step.  The same
+     * setting enables pre-warming: when the P2P name service finds a name we
+     * are looking for and we are neither advertising nor connected, we form
+     * the group with the advertising device before anyone asks us to
+     * Connect().  An idle group holds the radio in STA mode and silences our
+     * own P2P advertisements, so both are off by default.  To enable them, set
+     * the limit "wfd_group_linger".
+     */
+    static const uint32_t ALLJOYN_WFD_GROUP_LINGER_DEFAULT = 0;
+
     /*
      * The Android Compatibility Test Suite (CTS) is used by Google to enforce a
      * common idea of what it means to be Android.  One of their tests is to
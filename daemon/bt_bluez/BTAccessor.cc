@@ -104,6 +104,13 @@ namespace ajn {
 #define EXPIRE_DEVICE_TIME 15000
 #define EXPIRE_DEVICE_TIME_EXT 5000
 
+/*
+ * Maximum number of found devices the topology manager may be getting SDP
+ * information from at the same time.  All probes go through the default
+ * adapter so this is the per-adapter limit.
+ */
+#define MAX_CONCURRENT_PROBES 3
+
 static const char alljoynUUIDBase[] = ALLJOYN_BT_UUID_BASE;
 #define ALLJOYN_BT_UUID_REV_SIZE (sizeof("12345678") - 1)
 #define ALLJOYN_BT_UUID_BASE_SIZE (sizeof(alljoynUUIDBase) - 1)
@@ -171,6 +178,7 @@ BTTransport::BTAccessor::BTAccessor(BTTransport* transport,
     transport(transport),
     recordHandle(0),
     timer("BT-Dispatcher"),
+    probeTimer("BT-Prober", false, MAX_CONCURRENT_PROBES),
     bluetoothAvailable(false),
     discoverable(false),
     discoveryCtrl(0),
@@ -254,6 +262,7 @@ BTTransport::BTAccessor::BTAccessor(BTTransport* transport,
     bzBus.RegisterBusListener(*this);
 
     timer.Start();
+    probeTimer.Start();
 }
 
 
@@ -1179,6 +1188,11 @@ void BTTransport::BTAccessor::AlarmTriggered(const Alarm& alarm, QStatus reason)
             transport->DeviceChange(static_cast<DeviceDispatchInfo*>(op)->addr,
                                     static_cast<DeviceDispatchInfo*>(op)->uuidRev,
                                     static_cast<DeviceDispatchInfo*>(op)->eirCapable);
+
+            deviceLock.Lock(MUTEX_CONTEXT);
+            activeProbes.erase(static_cast<DeviceDispatchInfo*>(op)->addr);
+            StartProbes();
+            deviceLock.Unlock(MUTEX_CONTEXT);
             break;
 
         case DispatchInfo::EXPIRE_DEVICE_FOUND:
@@ -1357,7 +1371,7 @@ void BTTransport::BTAccessor::DeviceFoundSignalHandler(const InterfaceDescriptio
                 if (newDevice || ((foundInfo.uuidRev != uuidRev) && (uuidRev != bt::INVALID_UUIDREV))) {
                     // Newly found device or changed advertisments, so inform the topology manager.
                     foundInfo.uuidRev = uuidRev;
-                    DispatchOperation(new DeviceDispatchInfo(DispatchInfo::DEVICE_FOUND, addr, uuidRev, eirCapable));
+                    QueueProbe(addr, uuidRev, eirCapable);
                 }
             }
 
@@ -1457,7 +1471,7 @@ void BTTransport::BTAccessor::ExpireFoundDevices(bool all)
 
         if (fimit != foundDevices.end()) {
             if (fimit->second.uuidRev == bt::INVALID_UUIDREV) {
-                DispatchOperation(new DeviceDispatchInfo(DispatchInfo::DEVICE_FOUND, it->second, bt::INVALID_UUIDREV, false));
+                QueueProbe(it->second, bt::INVALID_UUIDREV, false);
             }
             foundDevices.erase(fimit);
         }
@@ -1471,6 +1485,58 @@ void BTTransport::BTAccessor::ExpireFoundDevices(bool all)
 }
 
 
+void BTTransport::BTAccessor::QueueProbe(const BDAddress& addr, uint32_t uuidRev, bool eirCapable)
+{
+    // Must be called with deviceLock held.
+    Timespec now;
+    GetTimeNow(&now);
+
+    /*
+     * A device that is seen again before it has been probed just has its
+     * information refreshed rather than being queued twice.
+     */
+    ProbeInfo& probe = pendingProbes[addr];
+    probe.uuidRev = uuidRev;
+    probe.eirCapable = eirCapable;
+    probe.lastSeen = now.GetAbsoluteMillis();
+
+    StartProbes();
+}
+
+
+void BTTransport::BTAccessor::StartProbes()
+{
+    // Must be called with deviceLock held.
+    while (activeProbes.size() < MAX_CONCURRENT_PROBES) {
+        /*
+         * Devices seen most recently are the most likely to still be in
+         * range so they are probed first.  A device that is already being
+         * probed waits for that probe to finish.
+         */
+        ProbeInfoMap::iterator next = pendingProbes.end();
+        for (ProbeInfoMap::iterator it = pendingProbes.begin(); it != pendingProbes.end(); ++it) {
+            if ((activeProbes.find(it->first) == activeProbes.end()) &&
+                ((next == pendingProbes.end()) || (it->second.lastSeen > next->second.lastSeen))) {
+                next = it;
+            }
+        }
+        if (next == pendingProbes.end()) {
+            break;
+        }
+
+        QCC_DbgPrintf(("Probing %s (%u pending, %u active)",
+                       next->first.ToString().c_str(), pendingProbes.size() - 1, activeProbes.size() + 1));
+        activeProbes.insert(next->first);
+        DeviceDispatchInfo* op = new DeviceDispatchInfo(DispatchInfo::DEVICE_FOUND, next->first,
+                                                        next->second.uuidRev, next->second.eirCapable);
+        pendingProbes.erase(next);
+
+        Alarm alarm(0u, this, (void*)op);
+        probeTimer.AddAlarm(alarm);
+    }
+}
+
+
 QStatus BTTransport::BTAccessor::GetDeviceInfo(const BDAddress& addr,
                                                uint32_t* uuidRev,
                                                BTBusAddress* connAddr,
@@ -250,6 +250,8 @@ class BTTransport::BTAccessor : public MessageReceiver, public qcc::AlarmListene
                                 size_t listSize,
                                 uint32_t& uuidRev);
     void ExpireFoundDevices(bool all);
+    void QueueProbe(const BDAddress& addr, uint32_t uuidRev, bool eirCapable);
+    void StartProbes();
     static QStatus ProcessSDPXML(qcc::XmlParseContext& xmlctx,
                                  uint32_t* uuidRev,
                                  BDAddress* connAddr,
@@ -329,6 +331,19 @@ class BTTransport::BTAccessor : public MessageReceiver, public qcc::AlarmListene
     typedef std::map<BDAddress, FoundInfo> FoundInfoMap;
     typedef std::multimap<uint64_t, BDAddress> FoundInfoExpireMap;
 
+    class ProbeInfo {
+      public:
+        ProbeInfo() :
+            uuidRev(bt::INVALID_UUIDREV),
+            eirCapable(false),
+            lastSeen(0)
+        { }
+        uint32_t uuidRev;
+        bool eirCapable;
+        uint64_t lastSeen;
+    };
+    typedef std::map<BDAddress, ProbeInfo> ProbeInfoMap;
+
     struct DispatchInfo {
         typedef enum {
             STOP_DISCOVERY,
@@ -389,6 +404,9 @@ class BTTransport::BTAccessor : public MessageReceiver, public qcc::AlarmListene
     FoundInfoMap foundDevices;  // Map of found AllJoyn devices w/ UUID-Rev and expire time.
     FoundInfoExpireMap foundExpirations;
     qcc::Timer timer;
+    ProbeInfoMap pendingProbes;      // Found devices waiting for the topology manager to probe them.
+    std::set<BDAddress> activeProbes;  // Found devices the topology manager is probing now.
+    qcc::Timer probeTimer;
     qcc::Alarm expireAlarm;
     qcc::Alarm stopAdAlarm;
     BDAddressSet ignoreAddrs;
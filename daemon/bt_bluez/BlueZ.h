@@ -44,6 +44,9 @@
 
 #define L2CAP_LM_MASTER 0x1
 
+#define L2CAP_MODE_BASIC 0x00
+#define L2CAP_MODE_ERTM  0x03
+
 #define HCI_FILTER 2
 
 #define HCI_LM_MASTER 0x1
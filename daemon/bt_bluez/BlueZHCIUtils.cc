@@ -45,6 +45,7 @@ namespace bluez {
 
 
 const static uint16_t L2capDefaultMtu = (1 * 1021) + 1011; // 2 x 3DH5
+const static uint16_t L2capMaxMtu = 0xffff;                 // Largest MTU L2CAP can negotiate
 
 /*
  * Compose the first two bytes of an HCI command from the OGF and OCF
@@ -55,6 +56,13 @@ const static uint16_t L2capDefaultMtu = (1 * 1021) + 1011; // 2 x 3DH5
 
 /*
  * Set the L2CAP mtu to something better than the BT 1.0 default value.
+ *
+ * We ask for the largest MTU L2CAP allows in Enhanced Retransmission Mode so
+ * that a message goes out in as few SDUs (and send calls) as possible.  The
+ * peer's MTU still limits what we end up with.  If the kernel won't do ERTM or
+ * the large MTU we fall back to basic mode with the conservative MTU we have
+ * always used.  Streaming mode is not an option since it may drop SDUs and the
+ * endpoint needs a reliable byte stream.
  */
 void ConfigL2capMTU(SocketFd sockFd)
 {
@@ -71,14 +79,25 @@ void ConfigL2capMTU(SocketFd sockFd)
     optLen = sizeof(opts);
     ret = getsockopt(sockFd, SOL_L2CAP, L2CAP_OPTIONS, &opts, &optLen);
     if (ret != -1) {
-        opts.imtu = L2capDefaultMtu;
-        opts.omtu = L2capDefaultMtu;
-        ret = setsockopt(sockFd, SOL_L2CAP, L2CAP_OPTIONS, &opts, optLen);
+        struct l2cap_options ertmOpts = opts;
+        ertmOpts.imtu = L2capMaxMtu;
+        ertmOpts.omtu = L2capMaxMtu;
+        ertmOpts.mode = L2CAP_MODE_ERTM;
+        ret = setsockopt(sockFd, SOL_L2CAP, L2CAP_OPTIONS, &ertmOpts, optLen);
+        if (ret != -1) {
+            opts = ertmOpts;
+        } else {
+            QCC_DbgPrintf(("ERTM with large MTU not available (%d - %s), using basic mode", errno, strerror(errno)));
+            opts.imtu = L2capDefaultMtu;
+            opts.omtu = L2capDefaultMtu;
+            opts.mode = L2CAP_MODE_BASIC;
+            ret = setsockopt(sockFd, SOL_L2CAP, L2CAP_OPTIONS, &opts, optLen);
+        }
         if (ret == -1) {
             QCC_LogError(ER_OS_ERROR, ("Failed to set in/out MTU for L2CAP socket (%d - %s)", errno, strerror(errno)));
         } else {
             outMtu = opts.omtu;
-            QCC_DbgPrintf(("Set L2CAP mtu to %d", opts.omtu));
+            QCC_DbgPrintf(("Set L2CAP mtu to %d (mode %d)", opts.omtu, opts.mode));
         }
     } else {
         QCC_LogError(ER_OS_ERROR, ("Failed to get in/out MTU for L2CAP socket (%d - %s)", errno, strerror(errno)));
@@ -28,6 +28,7 @@
 #include <qcc/Socket.h>
 #include <qcc/SocketStream.h>
 #include <qcc/String.h>
+#include <qcc/time.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/ProxyBusObject.h>
@@ -53,7 +54,10 @@ BTSocketStream::BTSocketStream(SocketFd sock) :
     SocketStream(sock),
     buffer(NULL),
     offset(0),
-    fill(0)
+    fill(0),
+    startTime(GetTimestamp64()),
+    rxBytes(0),
+    txBytes(0)
 {
     struct l2cap_options opts;
     socklen_t optlen = sizeof(opts);
@@ -68,6 +72,30 @@ BTSocketStream::BTSocketStream(SocketFd sock) :
         outMtu = opts.omtu;
     }
     buffer = new uint8_t[inMtu];
+    QCC_DbgPrintf(("BTSocketStream: in MTU %u, out MTU %u", (uint32_t)inMtu, (uint32_t)outMtu));
+}
+
+
+BTSocketStream::~BTSocketStream()
+{
+    ReportThroughput();
+    if (buffer) {
+        delete[] buffer;
+    }
+}
+
+
+void BTSocketStream::ReportThroughput() const
+{
+    uint64_t elapsed = GetTimestamp64() - startTime;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    QCC_DbgHLPrintf(("BT link (MTU in %u/out %u): rx %llu bytes (%u B/s), tx %llu bytes (%u B/s) over %u ms",
+                     (uint32_t)inMtu, (uint32_t)outMtu,
+                     rxBytes, (uint32_t)(rxBytes * 1000 / elapsed),
+                     txBytes, (uint32_t)(txBytes * 1000 / elapsed),
+                     (uint32_t)elapsed));
 }
 
 
@@ -104,6 +132,9 @@ QStatus BTSocketStream::PullBytes(void* buf, size_t reqBytes, size_t& actualByte
             offset = actualBytes;
         }
     }
+    if (status == ER_OK) {
+        rxBytes += actualBytes;
+    }
     return status;
 }
 
@@ -131,6 +162,8 @@ QStatus BTSocketStream::PushBytes(const void* buf, size_t numBytes, size_t& numS
 
     if (status != ER_OK) {
         QCC_LogError(status, ("Failed to send data over BT for 20 seconds (errno: %d - %s)", errno, strerror(errno)));
+    } else {
+        txBytes += numSent;
     }
 
     return status;
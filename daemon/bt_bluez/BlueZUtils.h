@@ -48,16 +48,22 @@ typedef qcc::ManagedObj<std::vector<qcc::String> > AdvertisedNamesList;
 class BTSocketStream : public qcc::SocketStream {
   public:
     BTSocketStream(qcc::SocketFd sock);
-    ~BTSocketStream() { if (buffer) delete[] buffer; }
+    ~BTSocketStream();
     QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = qcc::Event::WAIT_FOREVER);
     QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent);
 
+    /** Print the MTUs and the throughput achieved so far on this link */
+    void ReportThroughput() const;
+
   private:
     uint8_t* buffer;
     size_t inMtu;
     size_t outMtu;
     size_t offset;
     size_t fill;
+    uint64_t startTime;   /**< When the link was set up, in ms */
+    uint64_t rxBytes;     /**< Bytes received over the link */
+    uint64_t txBytes;     /**< Bytes sent over the link */
 };
 
 
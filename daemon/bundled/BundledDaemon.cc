@@ -31,6 +31,8 @@
 #include <qcc/Mutex.h>
 #include <qcc/Thread.h>
 #include <qcc/FileStream.h>
+#include <qcc/Util.h>
+#include <qcc/time.h>
 
 #include <alljoyn/BusAttachment.h>
 
@@ -41,6 +43,7 @@
 #include "DaemonConfig.h"
 #include "Transport.h"
 #include "TCPTransport.h"
+#include "UDPTransport.h"
 #include "NullTransport.h"
 #include "PasswordManager.h"
 
@@ -62,44 +65,45 @@ using namespace qcc;
 using namespace std;
 using namespace ajn;
 
-static const char bundledConfig[] =
-    "<busconfig>"
-    "  <type>alljoyn_bundled</type>"
-    "  <listen>tcp:r4addr=0.0.0.0,r4port=0</listen>"
+/*
+ * The default bundled daemon configuration is precompiled so starting the bundled daemon does not
+ * have to parse XML. Each entry corresponds to an element of the <busconfig> XML, for example
+ * { "limit", "auth_timeout", "5000" } is <limit auth_timeout="5000"/>.
+ *
+ * With deferred_transports the transports, other than the null transport the application connects
+ * over, are not started until the application first advertises, discovers or joins a session.
+ */
+static const DaemonConfig::Entry bundledConfig[] = {
+    { "type",                             NULL,                          "alljoyn_bundled" },
+    { "listen",                           NULL,                          "tcp:r4addr=0.0.0.0,r4port=0" },
 #if defined(QCC_OS_ANDROID)
-//    "  <listen>wfd:r4addr=0.0.0.0,r4port=9956</listen>"
+//    { "listen",                           NULL,                          "wfd:r4addr=0.0.0.0,r4port=9956" },
 #endif
-    "  <limit auth_timeout=\"5000\"/>"
-    "  <limit max_incomplete_connections=\"4\"/>"
-    "  <limit max_completed_connections=\"16\"/>"
-    "  <limit max_untrusted_clients=\"0\"/>"
-    "  <property restrict_untrusted_clients=\"true\"/>"
-    "  <ip_name_service>"
-    "    <property interfaces=\"*\"/>"
-    "    <property disable_directed_broadcast=\"false\"/>"
-    "    <property enable_ipv4=\"true\"/>"
-    "    <property enable_ipv6=\"true\"/>"
-    "  </ip_name_service>"
-    "  <tcp>"
-//    "    <property router_advertisement_prefix=\"org.alljoyn.BusNode.\"/>"
-    "  </tcp>"
+    { "limit",                            "auth_timeout",                "5000" },
+    { "limit",                            "max_incomplete_connections",  "4" },
+    { "limit",                            "max_completed_connections",   "16" },
+    { "limit",                            "max_untrusted_clients",       "0" },
+    { "limit",                            "deferred_transports",         "1" },
+    { "property",                         "restrict_untrusted_clients",  "true" },
+    { "ip_name_service/property",         "interfaces",                  "*" },
+    { "ip_name_service/property",         "disable_directed_broadcast",  "false" },
+    { "ip_name_service/property",         "enable_ipv4",                 "true" },
+    { "ip_name_service/property",         "enable_ipv6",                 "true" },
+    { "tcp",                              NULL,                          NULL },
+//    { "tcp/property",                     "router_advertisement_prefix", "org.alljoyn.BusNode." },
 #if defined(QCC_OS_ANDROID) || defined(QCC_OS_LINUX) || defined(QCC_OS_DARWIN) || defined(QCC_OS_WINRT)
-    "  <listen>ice:</listen>"
-    "  <ice>"
-    "    <limit max_incomplete_connections=\"16\"/>"
-    "    <limit max_completed_connections=\"64\"/>"
-    "  </ice>"
-    "  <ice_discovery_manager>"
-    "    <property interfaces=\"*\"/>"
-    "    <property server=\"rdvs.alljoyn.org\"/>"
-    "    <property protocol=\"HTTPS\"/>"
-    "    <property enable_ipv6=\"false\"/>"
-    "  </ice_discovery_manager>"
+    { "listen",                           NULL,                          "ice:" },
+    { "ice/limit",                        "max_incomplete_connections",  "16" },
+    { "ice/limit",                        "max_completed_connections",   "64" },
+    { "ice_discovery_manager/property",   "interfaces",                  "*" },
+    { "ice_discovery_manager/property",   "server",                      "rdvs.alljoyn.org" },
+    { "ice_discovery_manager/property",   "protocol",                    "HTTPS" },
+    { "ice_discovery_manager/property",   "enable_ipv6",                 "false" },
 #endif
 #if defined(QCC_OS_WINRT)
-//    "  <listen>proximity:addr=0::0,port=0,family=ipv6</listen>"
+//    { "listen",                           NULL,                          "proximity:addr=0::0,port=0,family=ipv6" },
 #endif
-    "</busconfig>";
+};
 
 
 class ClientAuthListener : public AuthListener {
@@ -253,6 +257,7 @@ BundledDaemon::~BundledDaemon()
 QStatus BundledDaemon::Start(NullTransport* nullTransport)
 {
     QStatus status = ER_OK;
+    uint64_t startTime = GetTimestamp64();
 
     QCC_DbgHLPrintf(("Using BundledDaemon"));
 
@@ -303,7 +308,7 @@ QStatus BundledDaemon::Start(NullTransport* nullTransport)
         }
 #endif
         if (!config) {
-            config = DaemonConfig::Load(bundledConfig);
+            config = DaemonConfig::Load(bundledConfig, ArraySize(bundledConfig));
         }
         if (!config) {
             status = ER_BUS_BAD_XML;
@@ -320,6 +325,7 @@ QStatus BundledDaemon::Start(NullTransport* nullTransport)
          */
         if (!transportsInitialized) {
             Add(new TransportFactory<TCPTransport>(TCPTransport::TransportName, false));
+            Add(new TransportFactory<UDPTransport>(UDPTransport::TransportName, false));
 #if defined(QCC_OS_ANDROID) || defined(QCC_OS_LINUX) || defined(QCC_OS_DARWIN) || defined(QCC_OS_WINRT)
             Add(new TransportFactory<DaemonICETransport>(DaemonICETransport::TransportName, false));
 #endif
@@ -360,6 +366,7 @@ QStatus BundledDaemon::Start(NullTransport* nullTransport)
 
     lock.Unlock(MUTEX_CONTEXT);
 
+    QCC_DbgHLPrintf(("Bundled daemon ready in %u ms", static_cast<uint32_t>(GetTimestamp64() - startTime)));
     return ER_OK;
 
 ErrorExit:
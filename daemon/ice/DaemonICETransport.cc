@@ -58,6 +58,9 @@ const uint32_t ICE_LINK_TIMEOUT_PROBE_RESPONSE_DELAY = 10;
 const uint32_t ICE_LINK_TIMEOUT_MIN_LINK_TIMEOUT     = 40;
 const uint32_t PACKET_ENGINE_ACCEPT_TIMEOUT_MS       = 5000;
 
+/* Congestion control used on PacketEngine channels unless configured otherwise ("reno" or "cubic") */
+static const char* CONGESTION_CONTROL_DEFAULT = "reno";
+
 namespace ajn {
 
 
@@ -141,6 +144,8 @@ class _DaemonICEEndpoint : public _RemoteEndpoint {
         m_wasSuddenDisconnect(!incoming),
         m_isConnected(false)
     {
+        /* The packet engine reassembles whole messages so reads go from packets into msgBuf */
+        SetReadAhead(false);
     }
 
     ~_DaemonICEEndpoint()
@@ -397,6 +402,7 @@ void* _DaemonICEEndpoint::AuthThread::Run(void* arg)
     /* Initialized the features for this endpoint */
     m_endpoint->GetFeatures().isBusToBus = false;
     m_endpoint->GetFeatures().handlePassing = false;
+    m_endpoint->GetFeatures().bodyCompression = true;
 
     /* Run the actual connection authentication code. */
     qcc::String authName;
@@ -477,7 +483,10 @@ QStatus _DaemonICEEndpoint::PacketEngineConnect(const IPAddress& addr, uint16_t
     /* Pass a pointer to the managed endpoint as context, to ensure that the endpoint is not
      * deleted before the PacketEndineConnectCB returns.
      */
-    status = m_transport->m_packetEngine.Connect(packDest, m_icePktStream, *m_transport, ep);
+    CongestionControlType congestionControl = m_icePktStream.IsLocalTurn() ?
+                                              m_transport->GetCongestionControl("ice/property@congestion_control_relayed") :
+                                              m_transport->GetCongestionControl("ice/property@congestion_control");
+    status = m_transport->m_packetEngine.Connect(packDest, m_icePktStream, *m_transport, ep, congestionControl);
     if (status != ER_OK) {
         QCC_LogError(status, ("%s: Failed PacketEngine::Connect()", __FUNCTION__));
         return status;
@@ -533,7 +542,12 @@ DaemonICETransport::DaemonICETransport(BusAttachment& bus) :
     m_iceManager(),
     m_stopping(false),
     m_listener(0),
-    m_packetEngine("ice_packet_engine"),
+    m_packetEngine("ice_packet_engine",
+                   DaemonConfig::Access()->Get("ice/limit@packet_engine_window", ALLJOYN_PACKET_ENGINE_WINDOW_ICE_DEFAULT),
+                   DaemonConfig::Access()->Get("ice/limit@packet_engine_shards", ALLJOYN_PACKET_ENGINE_SHARDS_ICE_DEFAULT)),
+#ifndef NDEBUG
+    m_packetDebug(m_packetEngine.GetPacketPool()),
+#endif
     m_iceCallback(m_listener, this),
     daemonICETransportTimer("ICETransTimer", true)
 {
@@ -543,10 +557,21 @@ DaemonICETransport::DaemonICETransport(BusAttachment& bus) :
      */
     assert(m_bus.GetInternal().GetRouter().IsDaemon());
 
+    m_packetEngine.GetPacketPool().SetHighWaterMark(DaemonConfig::Access()->Get("ice/limit@packet_pool_high_water", ALLJOYN_PACKET_POOL_HIGH_WATER_ICE_DEFAULT));
+
+    /* Channels opened by the remote side use the congestion control configured for direct links */
+    m_packetEngine.SetDefaultCongestionControl(GetCongestionControl("ice/property@congestion_control"));
+
     /* Start the daemonICETransportTimer which is used to handle all the alarms */
     daemonICETransportTimer.Start();
 }
 
+CongestionControlType DaemonICETransport::GetCongestionControl(const char* key)
+{
+    qcc::String name = DaemonConfig::Access()->Get(key, CONGESTION_CONTROL_DEFAULT);
+    return CongestionControlFromString(name, CONGESTION_CONTROL_RENO);
+}
+
 DaemonICETransport::~DaemonICETransport()
 {
     QCC_DbgTrace(("DaemonICETransport::~DaemonICETransport()"));
@@ -1024,17 +1049,48 @@ void DaemonICETransport::SendSTUNKeepAliveAndTURNRefreshRequest(ICEPacketStream&
                 QCC_LogError(status, ("Failed to send TURN refresh for icePktStream=%p", &icePktStream));
             }
         }
+
+        /* Bind the TURN channel on the first keepalive and refresh it before the peer permission expires */
+        if ((now - icePktStream.GetChannelRefreshTimestamp()) >= icePktStream.GetChannelRefreshPeriod()) {
+            QStatus chanStatus = icePktStream.SendChannelBind(now);
+            if (chanStatus != ER_OK) {
+                QCC_LogError(chanStatus, ("Failed to send TURN ChannelBind for icePktStream=%p", &icePktStream));
+            }
+        }
     }
+}
 
-    /* Reload the alarm */
-    uint32_t zero = 0;
-    uint32_t period = icePktStream.GetStunKeepAlivePeriod();
-    AlarmContext* ctx = new AlarmContext(&icePktStream);
-    qcc::AlarmListener* transportListener = this;
-    Alarm keepAliveAlarm(period, transportListener, ctx, zero);
-    status = daemonICETransportTimer.AddAlarm(keepAliveAlarm);
-    if (status != ER_OK) {
-        QCC_LogError(status, ("DaemonICEEndpoint::SendSTUNKeepAliveAndTURNRefreshRequest(): Unable to add KeepAliveAlarm to daemonICETransportTimer"));
+void DaemonICETransport::SendKeepAlivesAndTURNRefreshes(void)
+{
+    QCC_DbgTrace(("DaemonICETransport::SendKeepAlivesAndTURNRefreshes()"));
+
+    uint64_t now = GetTimestamp64();
+    vector<ICEPacketStream*> dueStreams;
+
+    /*
+     * Collect the streams whose keepalive is due and hold a reference on each so
+     * that nothing is sent while holding pktStreamMapLock.
+     */
+    pktStreamMapLock.Lock(MUTEX_CONTEXT);
+    for (PacketStreamMap::iterator it = pktStreamMap.begin(); it != pktStreamMap.end(); ++it) {
+        ICEPacketStream& pktStream = it->second.first;
+        ICEPacketStreamInfo& pktStreamInfo = it->second.second;
+
+        /* If we are using the local and remote host candidate, we need not send NAT keepalives or TURN refreshes */
+        if (!pktStream.HasSocket() || pktStreamInfo.IsDisconnected() || (pktStream.IsLocalHost() && pktStream.IsRemoteHost())) {
+            continue;
+        }
+        if ((now - pktStreamInfo.keepAliveTimestamp) >= pktStream.GetStunKeepAlivePeriod()) {
+            pktStreamInfo.keepAliveTimestamp = now;
+            pktStreamInfo.refCount++;
+            dueStreams.push_back(&pktStream);
+        }
+    }
+    pktStreamMapLock.Unlock(MUTEX_CONTEXT);
+
+    for (vector<ICEPacketStream*>::iterator it = dueStreams.begin(); it != dueStreams.end(); ++it) {
+        SendSTUNKeepAliveAndTURNRefreshRequest(**it);
+        ReleaseICEPacketStream(**it);
     }
 }
 
@@ -1152,7 +1208,8 @@ ThreadReturn STDCALL DaemonICETransport::AllocateICESessionThread::Run(void* arg
 
     /* Gather ICE candidates */
     status = transportObj->m_iceManager.AllocateSession(true, true, transportObj->m_dm->GetEnableIPv6(), &iceListener, iceSession, stunInfo,
-                                                        onDemandAddress, persistentAddress);
+                                                        onDemandAddress, persistentAddress,
+                                                        DaemonConfig::Access()->GetSnapshot().icePacingInterval.Get(ALLJOYN_PACING_INTERVAL_ICE_DEFAULT));
 
     if (status != ER_OK) {
         QCC_LogError(status, ("DaemonICETransport::AllocateICESessionThread::Run(): AllocateSession failed"));
@@ -1305,24 +1362,8 @@ ThreadReturn STDCALL DaemonICETransport::AllocateICESessionThread::Run(void* arg
                                                                         pktStream->SetTimeoutAlarm(Alarm(PACKET_ENGINE_ACCEPT_TIMEOUT_MS, transportObj, ctx, zero));
                                                                         status = transportObj->daemonICETransportTimer.AddAlarm(pktStream->GetTimeoutAlarm());
 
-                                                                        if (status == ER_OK) {
-                                                                            /* If we are using the local and remote host candidate, we need not send
-                                                                             * NAT keepalives or TURN refreshes */
-                                                                            if ((!pktStream->IsLocalHost()) || (!pktStream->IsRemoteHost())) {
-                                                                                /* Arm the keep-alive/TURN refresh timer (immediate fire) */
-                                                                                uint32_t zero = 0;
-                                                                                AlarmContext* ctx = new AlarmContext(pktStream);
-                                                                                status = transportObj->daemonICETransportTimer.AddAlarm(Alarm(zero, transportObj, ctx, zero));
-
-                                                                                if (status == ER_OK) {
-                                                                                    QCC_DbgPrintf(("%s: Successfully added the NAT keep alive alarm to daemonICETransportTimer", __FUNCTION__));
-                                                                                } else {
-                                                                                    /* We need not remove the PacketEngine Accept Timeout alarm from daemonICETransportTimer. It will get
-                                                                                     * cleared in the AlarmTriggered() whenever it fires */
-                                                                                    QCC_LogError(status, ("%s: Adding the NAT keep alive alarm to daemonICETransportTimer failed", __FUNCTION__));
-                                                                                }
-                                                                            }
-                                                                        } else {
+                                                                        /* NAT keepalives and TURN refreshes are sent by the transport wide keepalive sweep */
+                                                                        if (status != ER_OK) {
                                                                             QCC_LogError(status, ("%s: Adding the PacketEngine Accept Timeout alarm to daemonICETransportTimer failed", __FUNCTION__));
                                                                         }
                                                                     } else {
@@ -1627,28 +1668,28 @@ void* DaemonICETransport::Run(void* arg)
      * used for DBus.  If any of those are present, we use them, otherwise we
      * provide some hopefully reasonable defaults.
      */
-    DaemonConfig* config = DaemonConfig::Access();
+    DaemonConfig::Snapshot limits = DaemonConfig::Access()->GetSnapshot();
 
     /*
      * tTimeout is the maximum amount of time we allow incoming connections to
      * mess about while they should be authenticating.  If they take longer
      * than this time, we feel free to disconnect them as deniers of service.
      */
-    Timespec tTimeout = config->Get("limit@auth_timeout", ALLJOYN_AUTH_TIMEOUT_DEFAULT);
+    Timespec tTimeout = limits.authTimeout.Get(ALLJOYN_AUTH_TIMEOUT_DEFAULT);
 
     /*
      * maxAuth is the maximum number of incoming connections that can be in
      * the process of authenticating.  If starting to authenticate a new
      * connection would mean exceeding this number, we drop the new connection.
      */
-    uint32_t maxAuth = config->Get("ice/limit@max_incomplete_connections", ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_ICE_DEFAULT);
+    uint32_t maxAuth = limits.iceMaxIncompleteConnections.Get(ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_ICE_DEFAULT);
 
     /*
      * maxConn is the maximum number of active connections possible over the
      * ICE transport.  If starting to process a new connection would mean
      * exceeding this number, we drop the new connection.
      */
-    uint32_t maxConn = config->Get("ice/limit@max_completed_connections", ALLJOYN_MAX_COMPLETED_CONNECTIONS_ICE_DEFAULT);
+    uint32_t maxConn = limits.iceMaxCompletedConnections.Get(ALLJOYN_MAX_COMPLETED_CONNECTIONS_ICE_DEFAULT);
 
     QStatus status = ER_OK;
 
@@ -1668,6 +1709,11 @@ void* DaemonICETransport::Run(void* arg)
     Alarm runAlarm(period, pTransport, ctx, zero);
     status = daemonICETransportTimer.AddAlarm(runAlarm);
 
+    /* One alarm sends the NAT keep alives and TURN refreshes for all ICEPacketStreams */
+    AlarmContext* sweepCtx = new AlarmContext(AlarmContext::CONTEXT_KEEPALIVE_SWEEP);
+    Alarm sweepAlarm(DAEMON_ICE_TRANSPORT_KEEPALIVE_SWEEP_INTERVAL, pTransport, sweepCtx, zero);
+    daemonICETransportTimer.AddAlarm(sweepAlarm);
+
     while (!IsStopping()) {
         /*
          * We require that the discovery manager be created and started before the
@@ -1940,7 +1986,8 @@ QStatus DaemonICETransport::Connect(const char* connectSpec, const SessionOpts&
 
             /* Gather ICE candidates */
             status = m_iceManager.AllocateSession(true, false, m_dm->GetEnableIPv6(), &iceListener, iceSession, stunInfo,
-                                                  onDemandAddress, persistentAddress);
+                                                  onDemandAddress, persistentAddress,
+                                                  DaemonConfig::Access()->GetSnapshot().icePacingInterval.Get(ALLJOYN_PACING_INTERVAL_ICE_DEFAULT));
             if (status == ER_OK) {
                 if (IsICEConnectTimedOut(timeout)) {
                     /* Do not worry about releasing the packetStream here in the event
@@ -2005,7 +2052,8 @@ QStatus DaemonICETransport::Connect(const char* connectSpec, const SessionOpts&
                                                     QCC_DbgPrintf(("DaemonICETransport::Connect(): Starting ICE Checks"));
 
                                                     /* Start the ICE Checks*/
-                                                    status = iceSession->StartChecks(peerCandidates, false, ice_frag, ice_pwd);
+                                                    bool aggressive = (DaemonConfig::Access()->GetSnapshot().iceAggressiveNomination.Get(ALLJOYN_AGGRESSIVE_NOMINATION_ICE_DEFAULT) != 0);
+                                                    status = iceSession->StartChecks(peerCandidates, aggressive, ice_frag, ice_pwd);
 
                                                     QCC_DbgPrintf(("DaemonICETransport::Connect(): StartChecks status = 0x%x", status));
 
@@ -2070,22 +2118,8 @@ QStatus DaemonICETransport::Connect(const char* connectSpec, const SessionOpts&
                                                                         /* Make the packetEngine listen on icePktStream */
                                                                         status = m_packetEngine.AddPacketStream(*pktStream, *this);
 
-                                                                        if (status == ER_OK) {
-                                                                            /* If we are using the local and remote host candidate, we need not send NAT keepalives or TURN refreshes */
-                                                                            if ((!pktStream->IsLocalHost()) || (!pktStream->IsRemoteHost())) {
-                                                                                /* Arm the keep-alive (immediate fire) */
-                                                                                uint32_t zero = 0;
-                                                                                qcc::AlarmListener* transportListener = this;
-                                                                                AlarmContext* ctx = new AlarmContext(pktStream);
-                                                                                status = daemonICETransportTimer.AddAlarm(Alarm(zero, transportListener, ctx, zero));
-
-                                                                                if (status == ER_OK) {
-                                                                                    QCC_DbgPrintf(("%s: Successfully added NAT keepalive alarm to daemonICETransportTimer", __FUNCTION__));
-                                                                                } else {
-                                                                                    QCC_LogError(status, ("%s: Adding NAT keepalive alarm to daemonICETransportTimer failed", __FUNCTION__));
-                                                                                }
-                                                                            }
-                                                                        } else {
+                                                                        /* NAT keepalives and TURN refreshes are sent by the transport wide keepalive sweep */
+                                                                        if (status != ER_OK) {
                                                                             QCC_LogError(status, ("ICEPacketStream.AddPacketStream failed"));
                                                                         }
 
@@ -2200,6 +2234,7 @@ QStatus DaemonICETransport::Connect(const char* connectSpec, const SessionOpts&
                 iceEp->GetFeatures().isBusToBus = true;
                 iceEp->GetFeatures().allowRemote = m_bus.GetInternal().AllowRemoteMessages();
                 iceEp->GetFeatures().handlePassing = false;
+                iceEp->GetFeatures().bodyCompression = true;
 
                 String authName;
                 String redirection;
@@ -2762,16 +2797,6 @@ void DaemonICETransport::AlarmTriggered(const Alarm& alarm, QStatus reason)
                 /* We have to release the packet stream here to negate the effect of acquiring the ICEPacketStream in
                  * the AllocateICESessionThread::Run() */
                 ReleaseICEPacketStream(*ps);
-
-            } else {
-                /*
-                 * We need to send a NAT keep alive or TURN refresh only if the alarm has not
-                 * been triggered during a shutdown.
-                 */
-                if (reason == ER_OK) {
-                    /* Send NAT keep alive and/or turn refresh */
-                    SendSTUNKeepAliveAndTURNRefreshRequest(*ps);
-                }
             }
 
             /* Release the ICEPacketStream here to negate the effect of AcquireICEPacketStreamByPointer at the start of this
@@ -2780,11 +2805,32 @@ void DaemonICETransport::AlarmTriggered(const Alarm& alarm, QStatus reason)
 
         } else {
             /* Cant find pktStream */
-            QCC_DbgPrintf(("DaemonICETransport::AlarmTriggered: PktStream=%p was not found. keepalive/refresh timer disabled for this pktStream", ps));
+            QCC_DbgPrintf(("DaemonICETransport::AlarmTriggered: PktStream=%p was not found", ps));
         }
         break;
     }
 
+    case AlarmContext::CONTEXT_KEEPALIVE_SWEEP:
+    {
+        /*
+         * We need to send NAT keep alives or TURN refreshes only if the alarm has not
+         * been triggered during a shutdown.
+         */
+        if (reason == ER_OK) {
+            SendKeepAlivesAndTURNRefreshes();
+
+            /* Reload the alarm */
+            uint32_t zero = 0;
+            AlarmContext* alarmCtx = new AlarmContext(AlarmContext::CONTEXT_KEEPALIVE_SWEEP);
+            uint32_t period = DAEMON_ICE_TRANSPORT_KEEPALIVE_SWEEP_INTERVAL;
+            DaemonICETransport* pTransport = this;
+            Alarm sweepAlarm(period, pTransport, alarmCtx, zero);
+            daemonICETransportTimer.AddAlarm(sweepAlarm);
+        }
+
+        break;
+    }
+
     case AlarmContext::CONTEXT_SCHEDULE_RUN:
     {
         /*
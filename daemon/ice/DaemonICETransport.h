@@ -47,6 +47,9 @@
 #include "PacketEngine.h"
 #include "TokenRefreshListener.h"
 #include "ICEPacketStream.h"
+#ifndef NDEBUG
+#include "PacketDebug.h"
+#endif
 
 using namespace qcc;
 
@@ -430,11 +433,14 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
 
         enum ContextType {
             CONTEXT_NAT_KEEPALIVE,
-            CONTEXT_SCHEDULE_RUN
+            CONTEXT_SCHEDULE_RUN,
+            CONTEXT_KEEPALIVE_SWEEP
         };
 
         AlarmContext() : contextType(CONTEXT_SCHEDULE_RUN) { }
 
+        AlarmContext(ContextType type) : contextType(type), pktStream(NULL) { }
+
         AlarmContext(ICEPacketStream* stream) : contextType(CONTEXT_NAT_KEEPALIVE), pktStream(stream) { }
 
         ~AlarmContext() { }
@@ -493,6 +499,16 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
     DaemonICETransport(const DaemonICETransport& other);
     DaemonICETransport& operator =(const DaemonICETransport& other);
 
+    /**
+     * Read the congestion control algorithm for PacketEngine channels from the daemon config.
+     *
+     * @param key   Config key, "ice/property@congestion_control" for direct links or
+     *              "ice/property@congestion_control_relayed" for links relayed through a TURN server.
+     *
+     * @return  The configured algorithm, Reno if the key is absent or not recognized.
+     */
+    static CongestionControlType GetCongestionControl(const char* key);
+
     BusAttachment& m_bus;                                          /**< The message bus for this transport */
     DiscoveryManager* m_dm;                                        /**< The Discovery Manager used for discovery */
     ICEManager m_iceManager;                                       /**< The ICE Manager used for managing ICE operations */
@@ -508,6 +524,10 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
     /* Instance of the packet engine associated with the ICE transport*/
     PacketEngine m_packetEngine;
 
+#ifndef NDEBUG
+    debug::PacketDebugObj m_packetDebug;    /**< Publishes the packet pool counters on org.alljoyn.Bus.Debug.PacketPool */
+#endif
+
     Mutex m_IncomingICESessionsLock; /**< Mutex that protects IncomingICESessions */
 
     /*
@@ -610,6 +630,11 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
      */
     void SendSTUNKeepAliveAndTURNRefreshRequest(ICEPacketStream& icePacketStream);
 
+    /**
+     * Send the NAT keep-alives and TURN refreshes that are due on all ICEPacketStreams.
+     */
+    void SendKeepAlivesAndTURNRefreshes(void);
+
     void ReleaseICEPacketStream(const ICEPacketStream& icePktStream);
 
     void StopAllEndpoints(bool isSuddenDisconnect = false);
@@ -658,6 +683,57 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
      */
     static const uint32_t ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_ICE_DEFAULT = 10;
 
+    /**
+     * @brief The default number of PacketEngine channel shards.
+     *
+     * Each shard has its own TX thread and RX worker thread. To override this
+     * value, change the limit, "ice/limit@packet_engine_shards".
+     */
+    static const uint32_t ALLJOYN_PACKET_ENGINE_SHARDS_ICE_DEFAULT = 1;
+
+    /**
+     * @brief The default maximum PacketEngine window size in packets.
+     *
+     * The window of each channel is negotiated down to what the remote side
+     * supports and the number of packets in flight is auto-tuned below it, so
+     * a large value only costs memory. Must be a power of 2 no larger than
+     * 1024. To override this value, change the limit,
+     * "ice/limit@packet_engine_window".
+     */
+    static const uint32_t ALLJOYN_PACKET_ENGINE_WINDOW_ICE_DEFAULT = 128;
+
+    /**
+     * @brief The default maximum number of free packets kept by the PacketEngine
+     * packet pool.
+     *
+     * Free packets beyond this number are returned to the heap. To override this
+     * value, change the limit, "ice/limit@packet_pool_high_water".
+     */
+    static const uint32_t ALLJOYN_PACKET_POOL_HIGH_WATER_ICE_DEFAULT = 1024;
+
+    /**
+     * @brief The default interval (Ta) in milliseconds between consecutive
+     * STUN transactions of an ICE session.
+     *
+     * This paces both candidate gathering and connectivity checks.  ICE
+     * recommends 500 ms for non-RTP media but that makes a check list of a few
+     * pairs take seconds to get through, so we default to a much shorter
+     * interval.  Values below 20 ms are raised to 20 ms.  To override this
+     * value, change the limit, "ice/limit@pacing_interval".
+     */
+    static const uint32_t ALLJOYN_PACING_INTERVAL_ICE_DEFAULT = 50;
+
+    /**
+     * @brief The default nomination mode used when we are the controlling
+     * agent.
+     *
+     * With aggressive nomination every check carries USE-CANDIDATE, so the
+     * first pair that succeeds is selected without a second round of checks.
+     * To override this value, set the limit, "ice/limit@aggressive_nomination"
+     * to 1 (aggressive) or 0 (regular).
+     */
+    static const uint32_t ALLJOYN_AGGRESSIVE_NOMINATION_ICE_DEFAULT = 0;
+
     /**
      * @brief The default value for the maximum number of ICE connections
      * (remote endpoints).
@@ -683,6 +759,12 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
     // TODO: PPN - May need to tweak this value
     static const uint32_t DAEMON_ICE_TRANSPORT_RUN_SCHEDULING_INTERVAL = 5000;
 
+    /**
+     * @brief The interval at which the ICEPacketStreams are checked for due NAT
+     * keep-alives and TURN refreshes.
+     */
+    static const uint32_t DAEMON_ICE_TRANSPORT_KEEPALIVE_SWEEP_INTERVAL = 1000;
+
     /* Timer used to handle the alarms */
     Timer daemonICETransportTimer;
 
@@ -715,21 +797,24 @@ class DaemonICETransport : public Transport, public _RemoteEndpoint::EndpointLis
         /* Timestamp recorded at the start of a disconnect procedure on the ICEPacketStream */
         uint64_t disconnectingTimestamp;
 
+        /* Timestamp of the last NAT keep-alive sent on the ICEPacketStream */
+        uint64_t keepAliveTimestamp;
+
         /* Pointer to the AllocateICESessionThread that created the packetStream corresponding to this
          * entry */
         AllocateICESessionThread* allocateICESessionThreadPtr;
 
         /* Default constructor */
-        _ICEPacketStreamInfo() : refCount(0), connState(ICE_PACKET_STREAM_DISCONNECTED), disconnectingTimestamp(0), allocateICESessionThreadPtr(NULL) { }
+        _ICEPacketStreamInfo() : refCount(0), connState(ICE_PACKET_STREAM_DISCONNECTED), disconnectingTimestamp(0), keepAliveTimestamp(0), allocateICESessionThreadPtr(NULL) { }
 
         /* Destructor */
         ~_ICEPacketStreamInfo() { }
 
         /* Parameterized constructor */
-        _ICEPacketStreamInfo(uint32_t count, ICEPacketStreamConnectionState state) : refCount(count), connState(state), disconnectingTimestamp(0), allocateICESessionThreadPtr(NULL) { }
+        _ICEPacketStreamInfo(uint32_t count, ICEPacketStreamConnectionState state) : refCount(count), connState(state), disconnectingTimestamp(0), keepAliveTimestamp(0), allocateICESessionThreadPtr(NULL) { }
 
         /* Parameterized constructor */
-        _ICEPacketStreamInfo(uint32_t count, ICEPacketStreamConnectionState state, AllocateICESessionThread* threadPtr) : refCount(count), connState(state), disconnectingTimestamp(0), allocateICESessionThreadPtr(threadPtr) { }
+        _ICEPacketStreamInfo(uint32_t count, ICEPacketStreamConnectionState state, AllocateICESessionThread* threadPtr) : refCount(count), connState(state), disconnectingTimestamp(0), keepAliveTimestamp(0), allocateICESessionThreadPtr(threadPtr) { }
 
         /* Returns true if the ICEPacketStream connection status is connected */
         bool IsConnected(void) { return(connState == ICE_PACKET_STREAM_CONNECTED); }
@@ -106,11 +106,13 @@ DiscoveryManager::DiscoveryManager(BusAttachment& bus) :
     OnDemandMessageSentTimeStamp(0),
     SentMessageOverOnDemandConnection(false),
     LastSentUpdateMessage(INVALID_MESSAGE),
+    MergedMessageCount(0),
     GETMessage(GET_MESSAGE, HttpConnection::METHOD_GET),
     RendezvousSessionDeleteMessage(RENDEZVOUS_SESSION_DELETE, HttpConnection::METHOD_DELETE),
     SCRAMAuthModule(),
     ProximityScanner(NULL),
     ClientAuthenticationFailed(false),
+    ResumeUnsupportedFlag(false),
     DiscoveryManagerTimer("DiscoveryManagerTimer"),
     InterfaceUpdateAlarm(NULL),
     SentFirstGETMessage(false),
@@ -236,11 +238,13 @@ DiscoveryManager::DiscoveryManager(const DiscoveryManager& other) :
     OnDemandMessageSentTimeStamp(other.OnDemandMessageSentTimeStamp),
     SentMessageOverOnDemandConnection(other.SentMessageOverOnDemandConnection),
     LastSentUpdateMessage(other.LastSentUpdateMessage),
+    MergedMessageCount(other.MergedMessageCount),
     GETMessage(other.GETMessage),
     RendezvousSessionDeleteMessage(other.RendezvousSessionDeleteMessage),
     SCRAMAuthModule(),
     ProximityScanner(NULL),
     ClientAuthenticationFailed(other.ClientAuthenticationFailed),
+    ResumeUnsupportedFlag(other.ResumeUnsupportedFlag),
     DiscoveryManagerTimer("DiscoveryManagerTimer"),
     InterfaceUpdateAlarm(NULL),
     SentFirstGETMessage(other.SentFirstGETMessage),
@@ -290,10 +294,12 @@ DiscoveryManager& DiscoveryManager::operator=(const DiscoveryManager& other)
         OnDemandMessageSentTimeStamp = other.OnDemandMessageSentTimeStamp;
         SentMessageOverOnDemandConnection = other.SentMessageOverOnDemandConnection;
         LastSentUpdateMessage = other.LastSentUpdateMessage;
+        MergedMessageCount = other.MergedMessageCount;
         GETMessage = other.GETMessage;
         RendezvousSessionDeleteMessage = other.RendezvousSessionDeleteMessage;
         ProximityScanner = NULL;
         ClientAuthenticationFailed = other.ClientAuthenticationFailed;
+        ResumeUnsupportedFlag = other.ResumeUnsupportedFlag;
         InterfaceUpdateAlarm = NULL;
         SentFirstGETMessage = other.SentFirstGETMessage;
         UseHTTP = other.UseHTTP;
@@ -1186,6 +1192,15 @@ void* DiscoveryManager::Run(void* arg)
                             }
                             SentMessageOverOnDemandConnection = false;
 
+                            /* If we still hold the PeerID from an earlier login, the Rendezvous Session is resumed with it
+                             * instead of logging in again. The discovery state was reset on the disconnect so all of it
+                             * is replayed. Should the Server have expired the session, it answers with a 401 and we fall
+                             * back to the client login procedure */
+                            if ((!PeerID.empty()) && (!ClientAuthenticationRequiredFlag)) {
+                                RendezvousSessionActiveFlag = false;
+                                UpdateInformationOnServerFlag = true;
+                            }
+
                             Connection->ResetOnDemandConnectionChanged();
 
                             if (OnDemandResponseEvent != NULL) {
@@ -1686,55 +1701,67 @@ void* DiscoveryManager::Run(void* arg)
 
                     QCC_DbgPrintf(("DiscoveryManager::Run(): OnDemandResponseEvent fired\n"));
 
-                    HttpConnection::HTTPResponse response;
+                    bool fetchNext;
+                    do {
+                        HttpConnection::HTTPResponse response;
 
-                    /* Fetch the response */
-                    status = Connection->FetchResponse(true, response);
+                        /* Fetch the response */
+                        status = Connection->FetchResponse(true, response);
 
-                    if (status == ER_OK) {
+                        if (status == ER_OK) {
 
-                        HandleOnDemandConnectionResponse(response);
+                            HandleOnDemandConnectionResponse(response);
 
-                    } else {
+                        } else {
 
-                        /* Something has gone wrong. So we disconnect. */
-                        Disconnect();
+                            /* Something has gone wrong. So we disconnect. */
+                            Disconnect();
 
 #ifdef ENABLE_PROXIMITY_FRAMEWORK
-                        if (ProximityScanner) {
-                            /* Stop the proximity scan before start to rule out any race conditions */
-                            ProximityScanner->StopScan();
-                        }
+                            if (ProximityScanner) {
+                                /* Stop the proximity scan before start to rule out any race conditions */
+                                ProximityScanner->StopScan();
+                            }
 #endif
 
-                    }
+                        }
+
+                        /* A response that arrived along with this one is already buffered and does not fire the event again */
+                        fetchNext = (status == ER_OK) && Connection && Connection->HasBufferedResponse(true);
+                    } while (fetchNext);
 
                 } else if ((Connection->IsPersistentConnUp()) && (*i == PersistentResponseEvent)) {
 
                     QCC_DbgPrintf(("DiscoveryManager::Run(): PersistentResponseEvent fired\n"));
 
-                    HttpConnection::HTTPResponse response;
+                    bool fetchNext;
+                    do {
+                        HttpConnection::HTTPResponse response;
 
-                    /* Fetch the response */
-                    status = Connection->FetchResponse(false, response);
+                        /* Fetch the response */
+                        status = Connection->FetchResponse(false, response);
 
-                    if (status == ER_OK) {
+                        if (status == ER_OK) {
 
-                        HandlePersistentConnectionResponse(response);
+                            HandlePersistentConnectionResponse(response);
 
-                    } else {
+                        } else {
 
-                        /* Something has gone wrong. So we disconnect. */
-                        Disconnect();
+                            /* Something has gone wrong. So we disconnect. */
+                            Disconnect();
 
 #ifdef ENABLE_PROXIMITY_FRAMEWORK
-                        if (ProximityScanner) {
-                            /* Stop the proximity scan before start to rule out any race conditions */
-                            ProximityScanner->StopScan();
-                        }
+                            if (ProximityScanner) {
+                                /* Stop the proximity scan before start to rule out any race conditions */
+                                ProximityScanner->StopScan();
+                            }
 #endif
 
-                    }
+                        }
+
+                        /* A response that arrived along with this one is already buffered and does not fire the event again */
+                        fetchNext = (status == ER_OK) && Connection && Connection->HasBufferedResponse(false);
+                    } while (fetchNext);
                 }
             }
         }
@@ -1755,7 +1782,40 @@ void DiscoveryManager::QueueMessage(InterfaceMessage& message)
 
     if (message.messageType != INVALID_MESSAGE) {
 
-        OutboundMessageQueue.push_back(message.Clone());
+        //
+        // Advertisement, Search and Proximity messages carry the complete current
+        // list rather than a change to it, so a newer one makes any that are still
+        // waiting to be sent redundant. The new message takes the place of the oldest
+        // queued one so that it goes out no later than that one would have, and in a
+        // single request.
+        //
+        list<InterfaceMessage*>::iterator slot = OutboundMessageQueue.end();
+        if ((message.messageType == ADVERTISEMENT) ||
+            (message.messageType == SEARCH) ||
+            (message.messageType == PROXIMITY)) {
+            for (list<InterfaceMessage*>::iterator i = OutboundMessageQueue.begin(); i != OutboundMessageQueue.end();) {
+                if ((*i)->messageType == message.messageType) {
+                    delete *i;
+                    if (slot == OutboundMessageQueue.end()) {
+                        *i = NULL;
+                        slot = i++;
+                    } else {
+                        OutboundMessageQueue.erase(i++);
+                    }
+                    ++MergedMessageCount;
+                } else {
+                    ++i;
+                }
+            }
+        }
+
+        if (slot != OutboundMessageQueue.end()) {
+            QCC_DbgPrintf(("DiscoveryManager::QueueMessage: Merged with a queued %s message (%u merged so far)\n",
+                           (PrintMessageType(message.messageType)).c_str(), MergedMessageCount));
+            *slot = message.Clone();
+        } else {
+            OutboundMessageQueue.push_back(message.Clone());
+        }
         QCC_DbgPrintf(("DiscoveryManager::QueueMessage: Set the wake event\n"));
         WakeEvent.SetEvent();
     }
@@ -2228,7 +2288,7 @@ QStatus DiscoveryManager::HandleAddressCandidatesResponse(AddressCandidatesRespo
     return status;
 }
 
-QStatus DiscoveryManager::HandlePersistentMessageResponse(Json::Value payload)
+QStatus DiscoveryManager::HandlePersistentMessageResponse(Json::Value& payload)
 {
     QCC_DbgPrintf(("DiscoveryManager::HandlePersistentMessageResponse()\n"));
     QStatus status = ER_OK;
@@ -2465,6 +2525,10 @@ String DiscoveryManager::PrintMessageType(MessageType type) {
         retStr = String("TOKEN_REFRESH");
         break;
 
+    case RESUME:
+        retStr = String("RESUME");
+        break;
+
     case INVALID_MESSAGE:
     default:
         break;
@@ -2608,7 +2672,7 @@ QStatus DiscoveryManager::UpdateInformationOnServer(MessageType messageType, boo
     return status;
 }
 
-QStatus DiscoveryManager::HandleOnDemandMessageResponse(Json::Value payload)
+QStatus DiscoveryManager::HandleOnDemandMessageResponse(Json::Value& payload)
 {
     QStatus status = ER_OK;
 
@@ -2654,6 +2718,17 @@ QStatus DiscoveryManager::HandleOnDemandMessageResponse(Json::Value payload)
                 QCC_DbgPrintf(("DiscoveryManager::HandleOnDemandMessageResponse(): Updated last sent proximity lists with the contents of the temp sent proximity lists"));
                 break;
 
+            case RESUME:
+                // The resume message carried all of the advertisements, searches and proximity information
+                DiscoveryManagerMutex.Lock(MUTEX_CONTEXT);
+                lastSentAdvertiseList = tempSentAdvertiseList;
+                lastSentSearchList = tempSentSearchList;
+                lastSentBSSIDList = tempSentBSSIDList;
+                lastSentBTMACList = tempSentBTMACList;
+                DiscoveryManagerMutex.Unlock(MUTEX_CONTEXT);
+                QCC_DbgPrintf(("DiscoveryManager::HandleOnDemandMessageResponse(): Updated all last sent lists after resuming the session"));
+                break;
+
             case GET_MESSAGE:
             case CLIENT_LOGIN:
             case TOKEN_REFRESH:
@@ -2779,6 +2854,19 @@ void DiscoveryManager::HandleOnDemandConnectionResponse(HttpConnection::HTTPResp
             ClientAuthenticationRequiredFlag = true;
         }
 
+    } else if (LastOnDemandMessageSent && (LastOnDemandMessageSent->messageType == RESUME) &&
+               ((response.statusCode == HttpConnection::HTTP_STATUS_NOT_FOUND) ||
+                (response.statusCode == HttpConnection::HTTP_STATUS_METH_NOT_ALLOW) ||
+                (response.statusCode == HttpConnection::HTTP_STATUS_NOT_IMPLEMENTED))) {
+
+        QCC_DbgPrintf(("DiscoveryManager::HandleOnDemandConnectionResponse(): Server does not support session resume"));
+
+        /* Replay the information using the individual messages instead */
+        ResumeUnsupportedFlag = true;
+        RendezvousSessionActiveFlag = false;
+        UpdateInformationOnServerFlag = true;
+        LastSentUpdateMessage = INVALID_MESSAGE;
+
     } else {
 
         status = ER_RENDEZVOUS_SERVER_UNRECOVERABLE_ERROR;
@@ -2890,6 +2978,35 @@ void DiscoveryManager::HandleUnsuccessfulClientAuthentication(SASLError error)
 #endif
 }
 
+QStatus DiscoveryManager::SendResumeMessage(void)
+{
+    QCC_DbgPrintf(("DiscoveryManager::SendResumeMessage()"));
+
+    ResumeMessage resumeMsg;
+
+    /* The compose functions leave the temp sent lists untouched if there is nothing to send, but
+     * the resume message replaces everything on the Server so they need to reflect that */
+    tempSentAdvertiseList.clear();
+    tempSentSearchList.clear();
+    tempSentBSSIDList.clear();
+    tempSentBTMACList.clear();
+
+    ComposeAdvertisementorSearch(true, resumeMsg.advertisement);
+    ComposeAdvertisementorSearch(false, resumeMsg.search);
+    ComposeProximityMessage(resumeMsg.proximity);
+    resumeMsg.proximityPresent = (resumeMsg.proximity.messageType != INVALID_MESSAGE);
+
+    QStatus status = SendMessage(resumeMsg);
+
+    if (status == ER_OK) {
+        QCC_DbgPrintf(("DiscoveryManager::SendResumeMessage(): Successfully sent the Session Resume Message to the Server"));
+    } else {
+        QCC_LogError(status, ("DiscoveryManager::SendResumeMessage(): Unable to send the Session Resume Message to the Server"));
+    }
+
+    return status;
+}
+
 QStatus DiscoveryManager::HandleUpdatesToServer(void)
 {
     QCC_DbgPrintf(("DiscoveryManager::HandleUpdatesToServer(): LastSentUpdateMessage(%s) RendezvousSessionActiveFlag(%d)",
@@ -2898,6 +3015,21 @@ QStatus DiscoveryManager::HandleUpdatesToServer(void)
     MessageType currentMessageType = INVALID_MESSAGE;
     QStatus status = ER_OK;
 
+    /* Send all of the information in one request if the Server supports it */
+    if ((LastSentUpdateMessage == INVALID_MESSAGE) && (!ResumeUnsupportedFlag)) {
+        status = SendResumeMessage();
+
+        if (status == ER_OK) {
+            /* Queued advertisements and searches are superseded by the resume message. Proximity
+             * messages are purged by the caller */
+            PurgeOutboundMessageQueue(ADVERTISEMENT);
+            PurgeOutboundMessageQueue(SEARCH);
+            LastSentUpdateMessage = PROXIMITY;
+        }
+
+        return status;
+    }
+
     if (LastSentUpdateMessage == INVALID_MESSAGE) {
         currentMessageType = ADVERTISEMENT;
     } else if (LastSentUpdateMessage == ADVERTISEMENT) {
@@ -2946,7 +3078,7 @@ void DiscoveryManager::HandleSuccessfulClientAuthentication(ClientLoginFinalResp
     SetTKeepAlive(response.configData.Tkeepalive);
 }
 
-QStatus DiscoveryManager::HandleClientLoginResponse(Json::Value payload)
+QStatus DiscoveryManager::HandleClientLoginResponse(Json::Value& payload)
 {
     QStatus status = ER_OK;
 
@@ -3014,7 +3146,7 @@ QStatus DiscoveryManager::HandleClientLoginResponse(Json::Value payload)
     return status;
 }
 
-QStatus DiscoveryManager::HandleTokenRefreshResponse(Json::Value payload)
+QStatus DiscoveryManager::HandleTokenRefreshResponse(Json::Value& payload)
 {
     QStatus status = ER_OK;
 
@@ -3197,6 +3329,19 @@ QStatus DiscoveryManager::PrepareOutgoingMessage(InterfaceMessage& message, Stri
                                   "sending Daemon Registration message"));
             return status;
         }
+    } else if (message.messageType == RESUME) {
+        /* Session Resume Message is sent only using POST HTTP method */
+        if (message.httpMethod == HttpConnection::METHOD_POST) {
+            uri = GetResumeUri(PeerID);
+            ResumeMessage& resumeMsg = static_cast<ResumeMessage&>(message);
+            content = GenerateJSONResume(resumeMsg);
+            contentPresent = true;
+        } else {
+            status = ER_INVALID_HTTP_METHOD_USED_FOR_RENDEZVOUS_SERVER_INTERFACE_MESSAGE;
+            QCC_LogError(status, ("DiscoveryManager::PrepareOutgoingMessage(): HTTP Methods other than POST cannot be used for "
+                                  "sending Session Resume message"));
+            return status;
+        }
     } else if (message.messageType == TOKEN_REFRESH) {
         /* Token Refresh Message is sent only using GET HTTP method */
         if (message.httpMethod == HttpConnection::METHOD_GET) {
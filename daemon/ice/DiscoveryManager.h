@@ -405,7 +405,7 @@ class DiscoveryManager : public Thread, public AlarmListener {
      *
      * Ensure that the function invoking this function locks the DiscoveryManagerMutex.
      */
-    QStatus HandleOnDemandMessageResponse(Json::Value payload);
+    QStatus HandleOnDemandMessageResponse(Json::Value& payload);
 
     /**
      * @internal
@@ -463,7 +463,7 @@ class DiscoveryManager : public Thread, public AlarmListener {
      *
      * Ensure that the function invoking this function locks the DiscoveryManagerMutex.
      */
-    QStatus HandleClientLoginResponse(Json::Value payload);
+    QStatus HandleClientLoginResponse(Json::Value& payload);
 
     /**
      * @internal
@@ -471,7 +471,7 @@ class DiscoveryManager : public Thread, public AlarmListener {
      *
      * Ensure that the function invoking this function locks the DiscoveryManagerMutex.
      */
-    QStatus HandleTokenRefreshResponse(Json::Value payload);
+    QStatus HandleTokenRefreshResponse(Json::Value& payload);
 
     /**
      * Main thread entry point.
@@ -536,7 +536,7 @@ class DiscoveryManager : public Thread, public AlarmListener {
      * @internal
      * @brief Handle the response received over the Persistent connection.
      */
-    QStatus HandlePersistentMessageResponse(Json::Value payload);
+    QStatus HandlePersistentMessageResponse(Json::Value& payload);
 
     /**
      * @internal
@@ -572,6 +572,15 @@ class DiscoveryManager : public Thread, public AlarmListener {
      */
     QStatus SendDaemonRegistrationMessage(void);
 
+    /**
+     * @internal
+     * @brief Send a Session Resume Message carrying all the current advertisements, searches
+     * and proximity information to the Server
+     *
+     * Ensure that the function invoking this function locks the DiscoveryManagerMutex.
+     */
+    QStatus SendResumeMessage(void);
+
     /**
      * @internal
      * @brief Update the interfaces and connect to the Rendezvous Server
@@ -1096,6 +1105,13 @@ class DiscoveryManager : public Thread, public AlarmListener {
      */
     MessageType LastSentUpdateMessage;
 
+    /**
+     * @internal
+     * @brief Number of queued Advertisement/Search/Proximity messages that were
+     * superseded by a newer message of the same type before being sent
+     */
+    uint32_t MergedMessageCount;
+
     /**
      * @internal
      * @brief A list of messages queued for transmission out to the
@@ -1120,6 +1136,11 @@ class DiscoveryManager : public Thread, public AlarmListener {
      * list has changed */
     bool ClientAuthenticationFailed;
 
+    /* Boolean indicating that the Server rejected the Session Resume Message. If this is set the
+     * information on the Server is updated using individual Advertisement, Search and Proximity
+     * messages */
+    bool ResumeUnsupportedFlag;
+
     /* Timer used to handle the alarms */
     Timer DiscoveryManagerTimer;
 
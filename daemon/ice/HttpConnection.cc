@@ -21,6 +21,8 @@
  *    limitations under the License.
  ******************************************************************************/
 
+#include <ctype.h>
+#include <string.h>
 #include <map>
 #include <string>
 #include <vector>
@@ -61,45 +63,232 @@ static String urlEncode(String str)
     return outStr;
 }
 
-static QStatus getLine(Source* source, String& str) {
+/*
+ * Header names are case-insensitive
+ */
+static bool headerNameEquals(const String& name, const char* expected)
+{
+    size_t len = strlen(expected);
+    if (name.size() != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        if (tolower(name[i]) != tolower(expected[i])) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    char c;
-    QStatus status = ER_OK;
-    size_t received;
+/*
+ * Check if a comma separated header value such as "Transfer-Encoding: gzip, chunked" has a token
+ */
+static bool headerHasToken(const String& value, const char* token)
+{
+    size_t pos = 0;
+    while (pos <= value.size()) {
+        size_t comma = value.find(',', pos);
+        if (comma == String::npos) {
+            comma = value.size();
+        }
+        if (headerNameEquals(Trim(value.substr(pos, comma - pos)), token)) {
+            return true;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
 
+static const String* findHeader(const std::map<String, String>& headers, const char* name)
+{
+    std::map<String, String>::const_iterator it;
+    for (it = headers.begin(); it != headers.end(); ++it) {
+        if (headerNameEquals(it->first, name)) {
+            return &it->second;
+        }
+    }
+    return NULL;
+}
+
+QStatus HttpResponseSource::Fill(uint32_t timeout)
+{
+    size_t received = 0;
+    bufPos = bufEnd = 0;
+    QStatus status = source->PullBytes(buffer, BUFFER_SIZE, received, timeout);
+    if ((ER_OK == status) && (0 == received)) {
+        status = ER_NONE;
+    }
+    if (ER_OK == status) {
+        bufEnd = received;
+    }
+    return status;
+}
+
+QStatus HttpResponseSource::ReadLine(String& line, uint32_t timeout)
+{
+    QStatus status = ER_OK;
+    line.clear();
     while (ER_OK == status) {
-        status = source->PullBytes(&c, 1, received);
-        if ((ER_OK == status) && (1 == received)) {
-            if ('\r' == c) {
-                continue;
-            } else if ('\n' == c) {
-                break;
-            } else {
-                str.push_back(c);
+        if (bufPos == bufEnd) {
+            status = Fill(timeout);
+            continue;
+        }
+        const uint8_t* start = buffer + bufPos;
+        const uint8_t* nl = static_cast<const uint8_t*>(memchr(start, '\n', bufEnd - bufPos));
+        size_t len = nl ? (nl - start) : (bufEnd - bufPos);
+        if ((line.size() + len) > MAX_LINE_LENGTH) {
+            status = ER_FAIL;
+            QCC_LogError(status, ("HttpResponseSource::ReadLine(): Line is longer than %u bytes", static_cast<uint32_t>(MAX_LINE_LENGTH)));
+            break;
+        }
+        line.append(reinterpret_cast<const char*>(start), len);
+        bufPos += len;
+        if (nl) {
+            ++bufPos;
+            if (!line.empty() && (line[line.size() - 1] == '\r')) {
+                line.erase(line.size() - 1, 1);
             }
+            break;
         }
     }
+    return status;
+}
 
+QStatus HttpResponseSource::PullRaw(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    QStatus status = ER_OK;
+    actualBytes = 0;
+    if (bufPos == bufEnd) {
+        /* Large reads go straight to the caller's buffer rather than through ours */
+        if (reqBytes >= BUFFER_SIZE) {
+            status = source->PullBytes(buf, reqBytes, actualBytes, timeout);
+            if ((ER_OK == status) && (0 == actualBytes)) {
+                status = ER_NONE;
+            }
+            return status;
+        }
+        status = Fill(timeout);
+    }
+    if (ER_OK == status) {
+        actualBytes = min(reqBytes, bufEnd - bufPos);
+        memcpy(buf, buffer + bufPos, actualBytes);
+        bufPos += actualBytes;
+    }
     return status;
 }
 
 QStatus HttpResponseSource::PullBytes(void*buf, size_t reqBytes, size_t& actualBytes,  uint32_t timeout)
 {
-    QStatus status = ER_NONE;
+    QStatus status = ER_OK;
+    actualBytes = 0;
+
+    while ((ER_OK == status) && (0 == actualBytes)) {
+        switch (framing) {
+        case BODY_NONE:
+            return ER_NONE;
+
+        case BODY_LENGTH:
+            if (bytesRead == contentLength) {
+                EndBody();
+                return ER_NONE;
+            }
+            status = PullRaw(buf, min(reqBytes, contentLength - bytesRead), actualBytes, timeout);
+            break;
+
+        case BODY_UNTIL_CLOSE:
+            status = PullRaw(buf, reqBytes, actualBytes, timeout);
+            if (ER_NONE == status) {
+                EndBody();
+            }
+            break;
+
+        case BODY_CHUNKED:
+        {
+            String line;
+            switch (chunkState) {
+            case CHUNK_SIZE:
+                status = ReadLine(line, timeout);
+                if (ER_OK == status) {
+                    /* Chunk extensions follow a ';' and are ignored */
+                    size_t semi = line.find(';');
+                    String size = Trim((semi == String::npos) ? line : line.substr(0, semi));
+                    chunkRemaining = StringToU32(size, 16, 0xFFFFFFFF);
+                    if (size.empty() || (chunkRemaining == 0xFFFFFFFF)) {
+                        status = ER_FAIL;
+                        QCC_LogError(status, ("HttpResponseSource::PullBytes(): Bad chunk size \"%s\"", line.c_str()));
+                    } else {
+                        chunkState = (chunkRemaining == 0) ? CHUNK_TRAILER : CHUNK_DATA;
+                    }
+                }
+                break;
+
+            case CHUNK_DATA:
+                status = PullRaw(buf, min(reqBytes, chunkRemaining), actualBytes, timeout);
+                if (ER_OK == status) {
+                    chunkRemaining -= actualBytes;
+                    if (chunkRemaining == 0) {
+                        chunkState = CHUNK_END;
+                    }
+                }
+                break;
+
+            case CHUNK_END:
+                status = ReadLine(line, timeout);
+                if ((ER_OK == status) && !line.empty()) {
+                    status = ER_FAIL;
+                    QCC_LogError(status, ("HttpResponseSource::PullBytes(): Chunk data is not followed by CRLF"));
+                }
+                chunkState = CHUNK_SIZE;
+                break;
 
-    size_t rb = min(reqBytes, contentLength - bytesRead);
-    status = source->PullBytes(buf, rb, actualBytes);
+            case CHUNK_TRAILER:
+                status = ReadLine(line, timeout);
+                if ((ER_OK == status) && line.empty()) {
+                    EndBody();
+                    return ER_NONE;
+                }
+                break;
+            }
+            break;
+        }
+        }
+    }
     if (ER_OK == status) {
         bytesRead += actualBytes;
+    } else if (ER_NONE == status) {
+        /* The connection closed part way through a body that had an expected end */
+        if (framing != BODY_NONE) {
+            status = ER_FAIL;
+            QCC_LogError(status, ("HttpResponseSource::PullBytes(): Connection closed before the end of the response body"));
+            EndBody();
+        }
+    } else {
+        EndBody();
     }
     return status;
 }
 
+void HttpResponseSource::StartBody(BodyFraming framing, size_t contentLength)
+{
+    this->framing = framing;
+    this->contentLength = contentLength;
+    bytesRead = 0;
+    chunkState = CHUNK_SIZE;
+    chunkRemaining = 0;
+    if ((framing == BODY_LENGTH) && (contentLength == 0)) {
+        this->framing = BODY_NONE;
+    }
+}
+
 void HttpResponseSource::Reset(Source& source)
 {
     this->source = &source;
+    bufPos = bufEnd = 0;
+    framing = BODY_NONE;
     contentLength = 0;
     bytesRead = 0;
+    chunkState = CHUNK_SIZE;
+    chunkRemaining = 0;
 }
 
 HttpConnection::~HttpConnection()
@@ -120,15 +309,13 @@ void HttpConnection::Clear(void)
     requestHeaders.clear();
     responseHeaders.clear();
 
-    /* Dump any remaining chars in response stream */
+    /* Dump the rest of the current response body so the next response starts on a line boundary */
     if (stream) {
         QStatus status = ER_OK;
-        size_t contentLength = httpSource.GetContentLength();
-        while ((ER_OK == status) && (contentLength > httpSource.GetBytesRead())) {
+        while (ER_OK == status) {
             uint8_t buf[256];
-            size_t reqBytes = min(sizeof(buf) / sizeof(buf[0]), contentLength - httpSource.GetBytesRead());
             size_t actual;
-            status = httpSource.PullBytes(buf, reqBytes, actual);
+            status = httpSource.PullBytes(buf, sizeof(buf), actual);
         }
     }
 }
@@ -311,6 +498,12 @@ QStatus HttpConnection::Send(void)
 
     QCC_DbgPrintf(("Sending HTTP Request: %s size %d", outStr.c_str(), outStr.size()));
 
+    /* The server closes the connection after a response that was not keep-alive */
+    if (!stream || !keepAlive) {
+        QCC_LogError(ER_FAIL, ("HttpConnection::Send(): Connection is closed or closing"));
+        return ER_FAIL;
+    }
+
     status = stream->PushBytes((void*)outStr.c_str(), outStr.size(), sentBytes);
     if ((ER_OK == status) && (sentBytes != outStr.size())) {
         status = ER_WRITE_ERROR;
@@ -333,99 +526,160 @@ QStatus HttpConnection::GetStatusCode(HttpStatus& httpStatus)
 void HttpConnection::Close()
 {
     if (stream) {
+        httpSource.Reset(Source::nullSource);
         delete stream;
         stream = NULL;
     }
+    keepAlive = true;
 }
 
 QStatus HttpConnection::ParseResponse(HTTPResponse& response)
 {
     if (!stream) {
-        return ER_FAIL;
         QCC_LogError(ER_FAIL, ("HttpConnection::ParseResponse(): steam is NULL"));
-    } else {
-        QStatus status = ER_OK;
-
-        httpSource.Reset(*stream);
+        return ER_FAIL;
+    }
 
-        /* Get HTTP response status line.*/
-        String statusLine;
-        status = getLine(stream, statusLine);
+    QStatus status = ER_OK;
+    String statusLine;
+    uint32_t code = 0;
+    bool http10 = false;
+
+    /* Skip the rest of a body the previous caller did not read */
+    if (!httpSource.IsBodyComplete()) {
+        uint8_t buf[256];
+        size_t actual;
+        while (ER_OK == (status = httpSource.PullBytes(buf, sizeof(buf), actual))) {
+        }
+        status = (ER_NONE == status) ? ER_OK : status;
+    }
 
+    /*
+     * Get the HTTP response status line and headers. Interim 1xx responses carry no body and are
+     * followed by the real response.
+     */
+    while (ER_OK == status) {
+        responseHeaders.clear();
+        status = httpSource.ReadLine(statusLine);
         if (ER_OK == status) {
             size_t pos = statusLine.find(' ');
-            if (pos != String::npos) {
-                uint32_t s = StringToU32(statusLine.substr(pos + 1).c_str(), 10, 0);
-                status = CheckHTTPResponseStatus(httpStatus, s);
-                if (ER_OK != status) {
-                    QCC_LogError(status, ("HttpConnection::ParseResponse(): Unrecognized HTTP Status code received in response"));
-                } else {
-                    response.statusCode = httpStatus;
-                    /* Get response headers */
-                    while (1) {
-                        String line;
-                        status = getLine(stream, line);
-
-                        if (ER_OK == status) {
-                            if (line.empty()) {
-                                break;
-                            } else {
-                                size_t pos = line.find(':');
-                                if ((0 != pos) && (pos != String::npos)) {
-                                    responseHeaders[Trim(line.substr(0, pos))] = Trim(line.substr(pos + 1));
-                                }
-                            }
-                        } else {
-                            break;
-                        }
-                    }
-
-                    if (ER_OK == status) {
-                        /* Setup response stream */
-                        httpSource.SetContentLength(StringToU32(responseHeaders["Content-Length"], 10, 0));
-
-                        /*We need to parse the payload only if we have a payload in the response*/
-                        if (httpSource.GetContentLength() != 0) {
-                            char* buf = (char*)malloc(httpSource.GetContentLength() + 1);
-                            size_t reqBytes = httpSource.GetContentLength();
-                            size_t actual;
-                            status = httpSource.PullBytes(buf, reqBytes, actual);
-
-                            if ((ER_OK == status) && (httpSource.GetContentLength() == actual)) {
-                                buf[actual] = '\0';
-                                string responseStr = string(buf);
-
-                                // Parse the payload using the JSON parser only of the HTTP status code received is
-                                // HTTP_STATUS_OK.
-                                if (httpStatus == HTTP_STATUS_OK) {
-                                    Json::Reader reader;
-                                    if (!reader.parse(responseStr, response.payload)) {
-                                        status = ER_FAIL;
-                                        QCC_LogError(status, ("HttpConnection::ParseResponse(): JSON payload parsing failed"));
-                                    } else {
-                                        response.payloadPresent = true;
-                                    }
-                                }
-                            } else {
-                                status = ER_FAIL;
-                                QCC_LogError(status, ("HttpConnection::ParseResponse(): Payload parsing failed"));
-                            }
-                            free(buf);
-                        } else {
-                            QCC_DbgPrintf(("HttpConnection::ParseResponse(): Received a response with no payload"));
-                        }
+            if (pos == String::npos) {
+                status = ER_FAIL;
+                QCC_LogError(status, ("HttpConnection::ParseResponse(): Bad status line \"%s\"", statusLine.c_str()));
+                break;
+            }
+            http10 = (statusLine.substr(0, pos) == "HTTP/1.0");
+            code = StringToU32(statusLine.substr(pos + 1, 3), 10, 0);
+        }
+        String lastName;
+        while (ER_OK == status) {
+            String line;
+            status = httpSource.ReadLine(line);
+            if ((ER_OK != status) || line.empty()) {
+                break;
+            }
+            if (((line[0] == ' ') || (line[0] == '\t')) && !lastName.empty()) {
+                /* Obsolete line folding continues the previous header */
+                responseHeaders[lastName] += String(" ") + Trim(line);
+            } else {
+                size_t pos = line.find(':');
+                if ((0 != pos) && (pos != String::npos)) {
+                    lastName = Trim(line.substr(0, pos));
+                    String value = Trim(line.substr(pos + 1));
+                    /* Repeated headers are combined into one comma separated value */
+                    std::map<String, String>::iterator it = responseHeaders.find(lastName);
+                    if (it == responseHeaders.end()) {
+                        responseHeaders[lastName] = value;
+                    } else {
+                        it->second += String(", ") + value;
                     }
                 }
             }
         }
+        if ((ER_OK != status) || (code < 100) || (code >= 200)) {
+            break;
+        }
+        QCC_DbgPrintf(("HttpConnection::ParseResponse(): Skipping interim response %u", code));
+    }
 
-        /* Cleanup socket on error*/
+    if (ER_OK == status) {
+        status = CheckHTTPResponseStatus(httpStatus, code);
         if (ER_OK != status) {
-            Close();
+            QCC_LogError(status, ("HttpConnection::ParseResponse(): Unrecognized HTTP Status code received in response"));
         }
+    }
 
-        return status;
+    if (ER_OK == status) {
+        response.statusCode = httpStatus;
+
+        /* Connections are persistent unless the server says otherwise */
+        const String* connection = findHeader(responseHeaders, "Connection");
+        if (http10) {
+            keepAlive = connection && headerHasToken(*connection, "keep-alive");
+        } else {
+            keepAlive = !(connection && headerHasToken(*connection, "close"));
+        }
+
+        /* Find the end of the body as RFC 2616 section 4.4 describes */
+        const String* transferEncoding = findHeader(responseHeaders, "Transfer-Encoding");
+        const String* contentLength = findHeader(responseHeaders, "Content-Length");
+        if ((code == 204) || (code == 304)) {
+            httpSource.StartBody(HttpResponseSource::BODY_NONE);
+        } else if (transferEncoding && headerHasToken(*transferEncoding, "chunked")) {
+            httpSource.StartBody(HttpResponseSource::BODY_CHUNKED);
+        } else if (contentLength) {
+            httpSource.StartBody(HttpResponseSource::BODY_LENGTH, StringToU32(*contentLength, 10, 0));
+        } else {
+            httpSource.StartBody(HttpResponseSource::BODY_UNTIL_CLOSE);
+            keepAlive = false;
+        }
+
+        /* Read the whole body, the payload is a single JSON document */
+        std::vector<char> body;
+        if (httpSource.GetContentLength()) {
+            body.reserve(httpSource.GetContentLength() + 1);
+        }
+        while (ER_OK == status) {
+            char buf[HttpResponseSource::BUFFER_SIZE];
+            size_t actual;
+            status = httpSource.PullBytes(buf, sizeof(buf), actual);
+            if (ER_OK == status) {
+                body.insert(body.end(), buf, buf + actual);
+            }
+        }
+        if (ER_NONE == status) {
+            status = ER_OK;
+        } else {
+            QCC_LogError(status, ("HttpConnection::ParseResponse(): Payload parsing failed"));
+        }
+
+        // Parse the payload using the JSON parser only if the HTTP status code received is
+        // HTTP_STATUS_OK. The payload is parsed in place rather than copied into a string
+        // first and the server never sends comments so they are not collected.
+        if ((ER_OK == status) && !body.empty()) {
+            if (httpStatus == HTTP_STATUS_OK) {
+                Json::Reader reader;
+                if (!reader.parse(&body[0], &body[0] + body.size(), response.payload, false)) {
+                    status = ER_FAIL;
+                    QCC_LogError(status, ("HttpConnection::ParseResponse(): JSON payload parsing failed"));
+                } else {
+                    response.payloadPresent = true;
+                }
+            }
+        } else if (ER_OK == status) {
+            QCC_DbgPrintf(("HttpConnection::ParseResponse(): Received a response with no payload"));
+        }
+    }
+
+    /*
+     * Cleanup socket on error. A connection the server is going to close is left open so the
+     * caller sees the close on the socket, Send() refuses to use it in the meantime.
+     */
+    if (ER_OK != status) {
+        Close();
     }
+
+    return status;
 }
 
 QStatus HttpConnection::CheckHTTPResponseStatus(HttpStatus& verifiedStatus, uint32_t status) {
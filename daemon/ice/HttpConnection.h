@@ -1,7 +1,7 @@
 /**
  * @file
  *
- * Extremely simple HTTP/1.0 implementation.
+ * Simple HTTP/1.1 client implementation.
  *
  */
 
@@ -36,67 +36,149 @@
 using namespace qcc;
 
 /**
- * HttpResponseSource is a Source wrapper that keeps track of the number of bytes read
- * from the stream. This behaviour is needed for persistent connecitons in order to
- * demark the end of one response from the beginning of the next one.
+ * HttpResponseSource is a buffered reader for the HTTP/1.1 responses received on one connection.
+ * It reads from the raw source in large blocks, hands out the status line and headers one line at
+ * a time and then delivers the body, removing the chunked transfer coding if the response uses it.
+ * Because it tracks where each body ends, bytes that belong to the next response on a persistent
+ * connection stay buffered for the next call to ReadLine().
  */
 class HttpResponseSource : public Source {
   public:
 
+    /**
+     * How the end of a response body is found
+     */
+    typedef enum {
+        BODY_NONE,          /**< The response has no body */
+        BODY_LENGTH,        /**< The body is Content-Length bytes long */
+        BODY_CHUNKED,       /**< The body uses the chunked transfer coding */
+        BODY_UNTIL_CLOSE    /**< The body ends when the server closes the connection */
+    } BodyFraming;
+
+    /**
+     * Size of the read buffer. This is larger than any rendezvous server response header.
+     */
+    static const size_t BUFFER_SIZE = 4096;
+
+    /**
+     * Longest status or header line that is accepted.
+     */
+    static const size_t MAX_LINE_LENGTH = 8192;
+
     /**
      * Construct an HttpResponseSource wrapper.
      *
      * @param source  Raw source of HTTP response data.
      **/
-    HttpResponseSource(Source& source = Source::nullSource) : source(&source), contentLength(0), bytesRead(0) { }
+    HttpResponseSource(Source& source = Source::nullSource) :
+        source(&source), bufPos(0), bufEnd(0), framing(BODY_NONE), contentLength(0), bytesRead(0),
+        chunkState(CHUNK_SIZE), chunkRemaining(0) { }
 
     /**
-     * Retrieve bytes from source.
+     * Retrieve bytes of the current response body. Chunked bodies are returned decoded.
      *
      * @param buf          Buffer to store pulled bytes
      * @param reqBytes     Number of bytes requested to be pulled from source.
      * @param actualBytes  Actual number of bytes retrieved from source.
-     * @return   OI_OK if successful. ER_NONE if source is exhausted. Otherwise an error.
+     * @return   ER_OK if successful. ER_NONE if the body is complete. Otherwise an error.
      */
     QStatus PullBytes(void*buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = Event::WAIT_FOREVER);
 
     /**
-     * Get the Event indicating that data is available when signaled.
+     * Read a status or header line. The line terminator is removed.
+     *
+     * @param line     [OUT] The line.
+     * @param timeout  Time to wait for data.
+     * @return   ER_OK if a line was read, ER_NONE if the connection was closed, otherwise an error.
+     */
+    QStatus ReadLine(String& line, uint32_t timeout = Event::WAIT_FOREVER);
+
+    /**
+     * Get the Event indicating that data is available when signaled. Data that is already
+     * buffered does not signal this event, see HasBufferedData().
      *
      * @return Event that is signaled when data is available.
      */
     Event&  GetSourceEvent() { return source->GetSourceEvent(); }
 
     /**
-     * Get total length of response stream.
-     * @return Number of bytes in response stream.
+     * Check if bytes received after the end of the last response are waiting in the buffer.
+     *
+     * @return true if ReadLine() can return data without reading from the source.
      */
-    size_t GetContentLength(void) { return contentLength; }
+    bool HasBufferedData() const { return bufPos < bufEnd; }
 
     /**
-     * Get the number of bytes already read from source.
-     * @return Number of bytes already read from source.
+     * Start delivering the body of a response whose headers have been read.
+     *
+     * @param framing        How the end of the body is found.
+     * @param contentLength  Number of bytes in the body for BODY_LENGTH.
      */
-    size_t GetBytesRead(void) { return bytesRead; }
+    void StartBody(BodyFraming framing, size_t contentLength = 0);
 
     /**
-     * Set the content length.
+     * Check if the whole body of the current response has been read.
      *
-     * @param contentLength   Total number of content bytes in the response.
+     * @return true if the body is complete.
+     */
+    bool IsBodyComplete() const { return framing == BODY_NONE; }
+
+    /**
+     * Get total length of the body. For bodies without a Content-Length this is the number of
+     * bytes read so far.
+     * @return Number of bytes in response stream.
      */
-    void SetContentLength(uint32_t contentLength) { this->contentLength = contentLength; }
+    size_t GetContentLength(void) { return (framing == BODY_LENGTH) ? contentLength : bytesRead; }
 
     /**
-     * Reset this response source in preparation for reuse.
+     * Get the number of body bytes already read.
+     * @return Number of bytes already read from source.
+     */
+    size_t GetBytesRead(void) { return bytesRead; }
+
+    /**
+     * Reset this response source for a new connection. Any buffered data is discarded.
      *
      * @param source   Raw source.
      */
     void Reset(Source& source);
 
   private:
-    Source* source;     /**< Underlying HTTP(s) source */
-    size_t contentLength;    /**< Number of bytes in response stream */
-    size_t bytesRead;        /**< Number of bytes already read from stream */
+
+    /**
+     * Steps of decoding a chunked body
+     */
+    typedef enum {
+        CHUNK_SIZE,      /**< Expecting a chunk size line */
+        CHUNK_DATA,      /**< Reading chunk data */
+        CHUNK_END,       /**< Expecting the CRLF that ends the chunk data */
+        CHUNK_TRAILER    /**< Reading trailer lines after the last chunk */
+    } ChunkState;
+
+    /**
+     * Read more data from the source into an empty buffer.
+     */
+    QStatus Fill(uint32_t timeout);
+
+    /**
+     * Copy up to reqBytes of raw body data, reading from the source if the buffer is empty.
+     */
+    QStatus PullRaw(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout);
+
+    /**
+     * The body of the current response has been fully read.
+     */
+    void EndBody() { framing = BODY_NONE; }
+
+    Source* source;                 /**< Underlying HTTP(s) source */
+    uint8_t buffer[BUFFER_SIZE];    /**< Data read from the source but not yet consumed */
+    size_t bufPos;                  /**< Offset of the first unconsumed byte in buffer */
+    size_t bufEnd;                  /**< Offset past the last valid byte in buffer */
+    BodyFraming framing;            /**< Framing of the body being read, BODY_NONE when there is none */
+    size_t contentLength;           /**< Number of bytes in the body for BODY_LENGTH */
+    size_t bytesRead;               /**< Number of (decoded) body bytes already read */
+    ChunkState chunkState;          /**< Progress through a chunked body */
+    size_t chunkRemaining;          /**< Bytes left in the current chunk */
 };
 
 /**
@@ -213,6 +295,7 @@ class HttpConnection {
         port(0),
         protocol(PROTO_HTTP),
         httpStatus(HTTP_STATUS_INVALID),
+        keepAlive(true),
         isMultipartForm(false),
         isApplicationJson(false)
     {
@@ -382,6 +465,14 @@ class HttpConnection {
         return (httpSource.GetContentLength() == 0);
     }
 
+    /**
+     * Check if another response has already been received and buffered. Such a response does not
+     * signal the source event again so it must be parsed without waiting.
+     *
+     * @return true if ParseResponse() can be called again without waiting for the source event.
+     */
+    bool HasBufferedResponse(void) { return (stream != NULL) && keepAlive && httpSource.IsBodyComplete() && httpSource.HasBufferedData(); }
+
     /** Returns the IPAddress of the local interface over which the HTTP connection exists */
     IPAddress GetLocalInterfaceAddress(void) { return localIPAddress; };
 
@@ -397,6 +488,7 @@ class HttpConnection {
         port(other.port),
         protocol(other.protocol),
         httpStatus(other.httpStatus),
+        keepAlive(other.keepAlive),
         isMultipartForm(other.isMultipartForm),
         isApplicationJson(other.isApplicationJson)
     {
@@ -440,6 +532,7 @@ class HttpConnection {
     String urlPath;                           /**< File path portion of request URL */
     String query;                             /**< Query string portion of request URL */
     HttpStatus httpStatus;                    /**< Status returned from HTTP server */
+    bool keepAlive;                           /**< false if the server closes the connection after the response */
     String requestBody;                       /**< Request body (used for POST) */
     bool isMultipartForm;                     /**< true iff request is a multipart form post */
     bool isApplicationJson;                   /**< true iff request is a application/json format */
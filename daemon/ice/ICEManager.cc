@@ -24,6 +24,8 @@
 #include <list>
 #include <qcc/Mutex.h>
 #include <qcc/Debug.h>
+#include <qcc/StringUtil.h>
+#include <qcc/time.h>
 #include <ICESession.h>
 #include <ICESessionListener.h>
 #include <ICEManager.h>
@@ -61,12 +63,13 @@ QStatus ICEManager::AllocateSession(bool addHostCandidates,
                                     ICESession*& session,
                                     STUNServerInfo stunInfo,
                                     IPAddress onDemandAddress,
-                                    IPAddress persistentAddress)
+                                    IPAddress persistentAddress,
+                                    uint32_t pacingIntervalMsecs)
 {
     QStatus status = ER_OK;
 
-    session = new ICESession(addHostCandidates, addRelayedCandidates, listener,
-                             stunInfo, onDemandAddress, persistentAddress, enableIpv6);
+    session = new ICESession(this, addHostCandidates, addRelayedCandidates, listener,
+                             stunInfo, onDemandAddress, persistentAddress, enableIpv6, pacingIntervalMsecs);
 
     status = session->Init();
 
@@ -105,4 +108,39 @@ QStatus ICEManager::DeallocateSession(ICESession*& session)
     return status;
 }
 
+
+bool ICEManager::IsServerUnreachable(const IPAddress& local, const IPEndpoint& server)
+{
+    ServerPathKey key(local.ToString(), server.addr.ToString() + ":" + U32ToString(server.port));
+    bool unreachable = false;
+
+    unreachableLock.Lock();
+    std::map<ServerPathKey, uint32_t>::iterator it = unreachableServers.find(key);
+    if (it != unreachableServers.end()) {
+        if ((GetTimestamp() - it->second) < UNREACHABLE_SERVER_CACHE_TIME_IN_MILLISECS) {
+            unreachable = true;
+        } else {
+            // Stale, let the next session find out for itself.
+            unreachableServers.erase(it);
+        }
+    }
+    unreachableLock.Unlock();
+
+    return unreachable;
+}
+
+
+void ICEManager::SetServerReachable(const IPAddress& local, const IPEndpoint& server, bool reachable)
+{
+    ServerPathKey key(local.ToString(), server.addr.ToString() + ":" + U32ToString(server.port));
+
+    unreachableLock.Lock();
+    if (reachable) {
+        unreachableServers.erase(key);
+    } else {
+        unreachableServers[key] = GetTimestamp();
+    }
+    unreachableLock.Unlock();
+}
+
 } //namespace ajn
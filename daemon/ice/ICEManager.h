@@ -23,6 +23,8 @@
  ******************************************************************************/
 
 #include <list>
+#include <map>
+#include <qcc/IPAddress.h>
 #include <qcc/Mutex.h>
 #include "ICESession.h"
 #include "ICESessionListener.h"
@@ -83,6 +85,9 @@ class ICEManager {
      *
      * @param persistentAddress     IP address of the interface over which the persistent connection
      *                                                          has been set up with the Rendezvous Server.
+     *
+     * @param pacingIntervalMsecs   Interval (Ta) between consecutive STUN transactions for gathering
+     *                              and connectivity checks. Values below 20 ms are raised to 20 ms.
      */
     QStatus AllocateSession(bool addHostCandidates,
                             bool addRelayedCandidates,
@@ -91,7 +96,8 @@ class ICEManager {
                             ICESession*& session,
                             STUNServerInfo stunInfo,
                             IPAddress onDemandAddress,
-                            IPAddress persistentAddress);
+                            IPAddress persistentAddress,
+                            uint32_t pacingIntervalMsecs = ICE_DEFAULT_PACING_INTERVAL_IN_MILLISECS);
 
 
     /**
@@ -102,12 +108,43 @@ class ICEManager {
      */
     QStatus DeallocateSession(ICESession*& session);
 
+    /**
+     * Check whether a recent gathering attempt from a local interface got no
+     * answer at all from a STUN/TURN server.
+     *
+     * @param local     Local interface address.
+     * @param server    STUN/TURN server the interface gathers from.
+     *
+     * @return  true if sessions should skip gathering from this interface.
+     */
+    bool IsServerUnreachable(const IPAddress& local, const IPEndpoint& server);
+
+    /**
+     * Record the outcome of gathering from a local interface.  An interface
+     * that got no answer is skipped by all sessions for
+     * UNREACHABLE_SERVER_CACHE_TIME_IN_MILLISECS.
+     *
+     * @param local      Local interface address.
+     * @param server     STUN/TURN server the interface gathered from.
+     * @param reachable  true if the server answered.
+     */
+    void SetServerReachable(const IPAddress& local, const IPEndpoint& server, bool reachable);
+
   private:
 
+    static const uint32_t UNREACHABLE_SERVER_CACHE_TIME_IN_MILLISECS = 60000;
+
+    /** Local interface and server address of a gathering attempt */
+    typedef std::pair<String, String> ServerPathKey;
+
     list<ICESession*> sessions;     ///< List of allocated ICESessions.
 
     Mutex lock;                    ///< Synchronizes multiple threads
 
+    std::map<ServerPathKey, uint32_t> unreachableServers;  ///< When each unreachable path was recorded
+
+    Mutex unreachableLock;         ///< Synchronizes access to unreachableServers
+
     /** Private copy constructor */
     ICEManager(const ICEManager&);
 
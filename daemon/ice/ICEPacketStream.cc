@@ -65,6 +65,10 @@ ICEPacketStream::ICEPacketStream(ICESession& iceSession, Stun& stun, const ICECa
     turnRefreshPeriod((selectedPair.local->GetAllocationLifetimeSeconds() - ajn::TURN_REFRESH_WARNING_PERIOD_SECS) * 1000),
     turnRefreshTimestamp(0),
     stunKeepAlivePeriod(iceSession.GetSTUNKeepAlivePeriod()),
+    channelNumber(ajn::TURN_CHANNEL_NUMBER),
+    channelBound(false),
+    channelRefreshTimestamp(0),
+    channelBindTid(),
     rxRenderBuf(new uint8_t[maxPacketStreamMtu]),
     txRenderBuf(new uint8_t[maxPacketStreamMtu])
 {
@@ -117,6 +121,10 @@ ICEPacketStream::ICEPacketStream() :
     turnRefreshPeriod(0),
     turnRefreshTimestamp(0),
     stunKeepAlivePeriod(0),
+    channelNumber(ajn::TURN_CHANNEL_NUMBER),
+    channelBound(false),
+    channelRefreshTimestamp(0),
+    channelBindTid(),
     rxRenderBuf(NULL),
     txRenderBuf(NULL)
 {
@@ -146,7 +154,11 @@ ICEPacketStream::ICEPacketStream(const ICEPacketStream& other) :
     turnUsername(other.turnUsername),
     turnRefreshPeriod(other.turnRefreshPeriod),
     turnRefreshTimestamp(other.turnRefreshTimestamp),
-    stunKeepAlivePeriod(other.stunKeepAlivePeriod)
+    stunKeepAlivePeriod(other.stunKeepAlivePeriod),
+    channelNumber(other.channelNumber),
+    channelBound(other.channelBound),
+    channelRefreshTimestamp(other.channelRefreshTimestamp),
+    channelBindTid(other.channelBindTid)
 {
     if (other.sock == SOCKET_ERROR) {
         sock = SOCKET_ERROR;
@@ -198,6 +210,10 @@ ICEPacketStream& ICEPacketStream::operator=(const ICEPacketStream& other)
         turnRefreshPeriod = other.turnRefreshPeriod;
         turnRefreshTimestamp = other.turnRefreshTimestamp;
         stunKeepAlivePeriod = other.stunKeepAlivePeriod;
+        channelNumber = other.channelNumber;
+        channelBound = other.channelBound;
+        channelRefreshTimestamp = other.channelRefreshTimestamp;
+        channelBindTid = other.channelBindTid;
 
         if (sock != SOCKET_ERROR) {
             Close(sock);
@@ -295,7 +311,23 @@ QStatus ICEPacketStream::PushPacketBytes(const void* buf, size_t numBytes, Packe
         }
     } else {
         sendLock.Lock();
-        if (usingTurn) {
+        if (usingTurn && channelBound) {
+            /*
+             * Once the channel is bound the TURN server relays ChannelData to the peer so
+             * there is no need for a Send indication and its attributes.
+             */
+            uint8_t header[TURN_CHANNEL_DATA_HEADER_SIZE];
+            header[0] = static_cast<uint8_t>(channelNumber >> 8);
+            header[1] = static_cast<uint8_t>(channelNumber);
+            header[2] = static_cast<uint8_t>(numBytes >> 8);
+            header[3] = static_cast<uint8_t>(numBytes);
+
+            ScatterGatherList sgList;
+            sgList.AddBuffer(header, sizeof(header));
+            sgList.AddBuffer(buf, numBytes);
+            sgList.SetDataSize(sizeof(header) + numBytes);
+            status = SendToSG(sock, relayServerAddress, relayServerPort, sgList, sent);
+        } else if (usingTurn) {
             ScatterGatherList sgList;
             status = ComposeStunMessage(buf, numBytes, sgList);
             if (status == ER_OK) {
@@ -359,7 +391,11 @@ QStatus ICEPacketStream::PullPacketBytes(void* buf, size_t reqBytes, size_t& act
         sender.port = tmpPort;
 
         if (usingTurn) {
-            status = StripStunOverhead(actualBytes, buf, reqBytes, actualBytes);
+            if ((actualBytes >= TURN_CHANNEL_DATA_HEADER_SIZE) && ((rxRenderBuf[0] & 0xC0) == 0x40)) {
+                status = StripChannelDataHeader(actualBytes, buf, reqBytes, actualBytes);
+            } else {
+                status = StripStunOverhead(actualBytes, buf, reqBytes, actualBytes);
+            }
         }
     } else {
         QCC_LogError(status, ("recvfrom failed: %s", ::strerror(errno)));
@@ -524,6 +560,102 @@ QStatus ICEPacketStream::SendTURNRefresh(uint64_t time)
     return status;
 }
 
+QStatus ICEPacketStream::SendChannelBind(uint64_t time)
+{
+    QCC_DbgTrace(("ICEPacketStream::SendChannelBind()"));
+
+    QStatus status = ER_OK;
+
+    StunMessage msg(STUN_MSG_REQUEST_CLASS, STUN_MSG_CHANNEL_BIND_METHOD, reinterpret_cast<const uint8_t*>(hmacKey.c_str()), hmacKey.size());
+
+    status = msg.AddAttribute(new StunAttributeUsername(turnUsername));
+
+    if (status == ER_OK) {
+        status = msg.AddAttribute(new StunAttributeChannelNumber(channelNumber));
+    }
+    if (status == ER_OK) {
+        status = msg.AddAttribute(new StunAttributeXorPeerAddress(msg, remoteMappedAddress, remoteMappedPort));
+    }
+    if (status == ER_OK) {
+        status = msg.AddAttribute(new StunAttributeMessageIntegrity(msg));
+    }
+    if (status == ER_OK) {
+        status = msg.AddAttribute(new StunAttributeFingerprint(msg));
+    }
+    if (status == ER_OK) {
+        size_t renderSize = msg.RenderSize();
+        assert(renderSize <= maxPacketStreamMtu);
+        ScatterGatherList msgSG;
+        size_t sent;
+
+        sendLock.Lock();
+        uint8_t* _txRenderBuf = txRenderBuf;
+        status = msg.RenderBinary(_txRenderBuf, renderSize, msgSG);
+
+        if (status == ER_OK) {
+            status = SendToSG(sock, relayServerAddress, relayServerPort, msgSG, sent);
+            QCC_DbgPrintf(("ICEPacketStream::SendChannelBind(): Sent ChannelBind for channel 0x%04x", channelNumber));
+
+            // Only the answer to the latest request updates the channel state
+            msg.GetTransactionID(channelBindTid);
+            channelRefreshTimestamp = time;
+        } else {
+            QCC_LogError(status, ("ICEPacketStream::SendChannelBind(): Failed to send ChannelBind"));
+        }
+
+        sendLock.Unlock();
+    }
+
+    return status;
+}
+
+void ICEPacketStream::HandleChannelBindResponse(size_t rcvdBytes, StunMsgTypeClass msgClass)
+{
+    size_t keyLen  = hmacKey.size();
+    uint8_t* dummyHmac = new uint8_t[keyLen];
+    StunMessage msg("", dummyHmac, keyLen);
+
+    size_t _rcvdBytes = rcvdBytes;
+    const uint8_t* _rxRenderBuf = rxRenderBuf;
+    QStatus status = msg.Parse(_rxRenderBuf, _rcvdBytes);
+    if (status == ER_OK) {
+        StunTransactionID tid;
+        msg.GetTransactionID(tid);
+
+        sendLock.Lock();
+        if (tid == channelBindTid) {
+            /*
+             * A failed refresh means the server no longer relays ChannelData for us so
+             * fall back to Send indications until a later ChannelBind succeeds.
+             */
+            channelBound = (msgClass == STUN_MSG_RESPONSE_CLASS);
+            QCC_DbgPrintf(("%s: TURN channel 0x%04x is %s", __FUNCTION__, channelNumber, channelBound ? "bound" : "not bound"));
+        }
+        sendLock.Unlock();
+    }
+    delete [] dummyHmac;
+}
+
+QStatus ICEPacketStream::StripChannelDataHeader(size_t rcvdBytes, void* dataBuf, size_t dataBufLen, size_t& actualBytes)
+{
+    QCC_DbgTrace(("ICEPacketStream::StripChannelDataHeader()"));
+
+    uint16_t rcvdChannel = (static_cast<uint16_t>(rxRenderBuf[0]) << 8) | rxRenderBuf[1];
+    size_t dataLen = (static_cast<size_t>(rxRenderBuf[2]) << 8) | rxRenderBuf[3];
+
+    /* ChannelData over UDP may be padded to a multiple of 4 bytes so only the length field is trusted */
+    if ((rcvdChannel != channelNumber) || (dataLen > (rcvdBytes - TURN_CHANNEL_DATA_HEADER_SIZE))) {
+        actualBytes = 0;
+        QCC_LogError(ER_FAIL, ("ICEPacketStream::StripChannelDataHeader(): Invalid ChannelData (channel=0x%04x, len=%d, rcvd=%d)", rcvdChannel, dataLen, rcvdBytes));
+        return ER_FAIL;
+    }
+
+    assert(dataBufLen >= dataLen);
+    actualBytes = (dataBufLen <= dataLen) ? dataBufLen : dataLen;
+    ::memcpy(dataBuf, rxRenderBuf + TURN_CHANNEL_DATA_HEADER_SIZE, actualBytes);
+    return ER_OK;
+}
+
 QStatus ICEPacketStream::StripStunOverhead(size_t rcvdBytes, void* dataBuf, size_t dataBufLen, size_t& actualBytes)
 {
     QCC_DbgTrace(("ICEPacketStream::StripStunOverhead()"));
@@ -605,8 +737,11 @@ QStatus ICEPacketStream::StripStunOverhead(size_t rcvdBytes, void* dataBuf, size
 
             if (StunMessage::IsTypeOK(rawMsgType)) {
                 QCC_DbgPrintf(("%s: StunMessage::IsTypeOK() successful", __FUNCTION__));
-                // Check to ensure that we have indeed received a STUN response
-                if (StunMessage::ExtractMessageClass(rawMsgType) == STUN_MSG_RESPONSE_CLASS) {
+                if (StunMessage::ExtractMessageMethod(rawMsgType) == STUN_MSG_CHANNEL_BIND_METHOD) {
+                    QCC_DbgPrintf(("%s: Received a ChannelBind answer", __FUNCTION__));
+                    HandleChannelBindResponse(rcvdBytes, StunMessage::ExtractMessageClass(rawMsgType));
+                } else if (StunMessage::ExtractMessageClass(rawMsgType) == STUN_MSG_RESPONSE_CLASS) {
+                    // We have received a STUN response for a NAT keepalive or TURN refresh
                     QCC_DbgPrintf(("%s: Received a STUN response message", __FUNCTION__));
 
                     // Parse message and extract Lifetime attribute contents.
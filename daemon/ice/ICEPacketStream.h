@@ -45,6 +45,16 @@ static const uint32_t MAX_ICE_INTERFACE_MTU = 1472;
  */
 static const uint32_t STUN_OVERHEAD_SIZE = 200;
 
+/*
+ * TURN channel that relayed data is sent on once it has been bound (RFC 5766 section 11)
+ */
+static const uint16_t TURN_CHANNEL_NUMBER = 0x4000;
+
+/*
+ * Size of the ChannelData header (channel number and length)
+ */
+static const uint32_t TURN_CHANNEL_DATA_HEADER_SIZE = 4;
+
 /**
  * ICEPacketStream is a UDP based implementation of the PacketStream interface.
  */
@@ -248,6 +258,36 @@ class ICEPacketStream : public PacketStream {
      */
     QStatus SendTURNRefresh(uint64_t time);
 
+    /**
+     * Return the period at which the TURN channel binding must be refreshed.
+     * A ChannelBind also refreshes the permission for the peer which expires
+     * sooner than the channel itself so the permission lifetime is used.
+     *
+     * @return TURN channel refresh period in milliseconds.
+     */
+    uint32_t GetChannelRefreshPeriod() const { return (ajn::TURN_PERMISSION_REFRESH_PERIOD_SECS - ajn::TURN_REFRESH_WARNING_PERIOD_SECS) * 1000; }
+
+    /**
+     * Return the timestamp of the last TURN ChannelBind request.
+     *
+     * @return time of last ChannelBind request.
+     */
+    uint64_t GetChannelRefreshTimestamp() const { return channelRefreshTimestamp; }
+
+    /**
+     * Return true iff the TURN server has confirmed the channel binding and
+     * relayed data is sent as ChannelData rather than Send indications.
+     * @return true iff the TURN channel is bound.
+     */
+    bool IsChannelBound() const { return channelBound; }
+
+    /**
+     * Compose and send a TURN ChannelBind request that binds (or refreshes)
+     * the channel to the remote peer.
+     * @param time  64-bit timestamp.
+     */
+    QStatus SendChannelBind(uint64_t time);
+
 
   private:
     qcc::IPAddress ipAddress;
@@ -278,6 +318,10 @@ class ICEPacketStream : public PacketStream {
     uint32_t turnRefreshPeriod;
     uint64_t turnRefreshTimestamp;
     uint32_t stunKeepAlivePeriod;
+    uint16_t channelNumber;
+    volatile bool channelBound;
+    uint64_t channelRefreshTimestamp;
+    StunTransactionID channelBindTid;
     Mutex sendLock;
     uint8_t* rxRenderBuf;
     uint8_t* txRenderBuf;
@@ -294,6 +338,16 @@ class ICEPacketStream : public PacketStream {
      * Strip STUN overhead from a received message.
      */
     QStatus StripStunOverhead(size_t rcvdBytes, void* dataBuf, size_t dataBufLen, size_t& actualBytes);
+
+    /**
+     * Strip the ChannelData header from a received message.
+     */
+    QStatus StripChannelDataHeader(size_t rcvdBytes, void* dataBuf, size_t dataBufLen, size_t& actualBytes);
+
+    /**
+     * Handle the TURN server's answer to a ChannelBind request.
+     */
+    void HandleChannelBindResponse(size_t rcvdBytes, StunMsgTypeClass msgClass);
 };
 
 }  /* namespace */
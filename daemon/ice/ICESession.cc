@@ -452,8 +452,6 @@ void ICESession::StunTurnPacingWork(void)
     // Note: we enter this method holding the object lock!!!
     // Therefore ensure that we are holding it when we exit.
 
-    uint32_t pacingIntervalMsecs = 500;
-
     Thread* thisThread = Thread::GetThread();
     while (!terminating && !thisThread->IsStopping()) {
         // If any requests are to be sent, enqueue them. Check for timeouts.
@@ -785,6 +783,10 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
     bool anyCandidatesFailedRetries = false;
 #endif
     bool errorFound = false;
+    size_t unfinished = 0;
+    list<StunActivity*> unanswered;   // Sent at least once but no response yet
+    bool gathering = (ICEGatheringCandidates == GetState());
+    IPEndpoint server = (addRelayedCandidates && TurnServerAvailable) ? TurnServer : StunServer;
 
     stream_const_iterator streamIt;
     for (streamIt = streamList.begin(); streamIt != streamList.end(); ++streamIt) {
@@ -827,9 +829,26 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
 
                     switch (retransmit.GetState()) {
                     case Retransmit::AwaitingTransmitSlot:
+                        if (gathering && (retransmit.GetAttempts() == 0) &&
+                            manager->IsServerUnreachable((*stunActivityIt)->candidate->GetBase().addr, server)) {
+                            // Another session recently got no answer from this interface.
+                            // Offer just the host candidate rather than waiting out all the retries again.
+                            QCC_DbgPrintf(("Skipping gathering from %s", (*stunActivityIt)->candidate->GetBase().addr.ToString().c_str()));
+                            retransmit.SetState(Retransmit::NoResponseToAllRetries);
+                            break;
+                        }
+                        if (retransmit.GetAttempts() > 0) {
+                            unanswered.push_back(*stunActivityIt);
+                        }
+                        foundList.push_back(*stunActivityIt);
+                        allCandidatesGathered = false;
+                        ++unfinished;
+                        break;
+
                     case Retransmit::ReceivedAuthenticateResponse:
                         foundList.push_back(*stunActivityIt);
                         allCandidatesGathered = false;
+                        ++unfinished;
                         break;
 
                     case Retransmit::AwaitingResponse:
@@ -840,9 +859,12 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
                                 retransmit.SetState(Retransmit::AwaitingTransmitSlot);
                                 foundList.push_back(*stunActivityIt);
                                 allCandidatesGathered = false;
+                                unanswered.push_back(*stunActivityIt);
+                                ++unfinished;
                             } else {
                                 // We are done with attempting to reach the server on this candidate.
                                 retransmit.SetState(Retransmit::NoResponseToAllRetries);
+                                manager->SetServerReachable((*stunActivityIt)->candidate->GetBase().addr, server, false);
 #ifdef AGGRESSIVE_FAIL_GATHERING
                                 anyCandidatesFailedRetries = true;
                                 SetErrorCode(ER_ICE_SERVER_NO_RESPONSE);
@@ -851,6 +873,8 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
                         } else {
                             // We haven't timed out yet. Give this guy a chance.
                             allCandidatesGathered = false;
+                            unanswered.push_back(*stunActivityIt);
+                            ++unfinished;
                         }
                         break;
 
@@ -868,6 +892,13 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
 
                     case Retransmit::ReceivedSuccessResponse:
                         // All done gathering for this local interface.
+                        if (!candidatesGathered) {
+                            candidatesGathered = true;
+                            candidatesGatheredTime = GetTimestamp();
+                        }
+                        if (gathering) {
+                            manager->SetServerReachable((*stunActivityIt)->candidate->GetBase().addr, server, true);
+                        }
                         break;
 
                     case Retransmit::Error:
@@ -887,6 +918,25 @@ void ICESession::GetAllReadyStunActivities(list<StunActivity*>& foundList)
         }
     }
 
+#ifndef AGGRESSIVE_FAIL_GATHERING
+    // The server is reachable from at least one interface.  Interfaces that
+    // have been trying for longer than the grace period are unlikely to ever
+    // get an answer, so stop waiting on them and go with what we have.  Any
+    // interface that has not been given a chance to send yet is waited on.
+    if (!errorFound && !allCandidatesGathered && candidatesGathered &&
+        (unanswered.size() == unfinished) &&
+        ((GetTimestamp() - candidatesGatheredTime) >= ICE_GATHERING_GRACE_PERIOD_IN_MILLISECS)) {
+        list<StunActivity*>::iterator it;
+        for (it = unanswered.begin(); it != unanswered.end(); ++it) {
+            QCC_DbgPrintf(("Giving up on gathering from %s", (*it)->candidate->GetBase().addr.ToString().c_str()));
+            (*it)->retransmit.SetState(Retransmit::NoResponseToAllRetries);
+            manager->SetServerReachable((*it)->candidate->GetBase().addr, server, false);
+            foundList.remove(*it);
+        }
+        allCandidatesGathered = true;
+    }
+#endif
+
 #ifdef AGGRESSIVE_FAIL_GATHERING
     // Consider any failure to contact the STUN/TURN server
     // (including all retries) by a host candidate to be fatal.
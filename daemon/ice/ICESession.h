@@ -31,6 +31,7 @@
  *    limitations under the License.
  ******************************************************************************/
 
+#include <algorithm>
 #include <vector>
 #include <qcc/Thread.h>
 #include <qcc/Mutex.h>
@@ -56,6 +57,8 @@ class ICESession;
 
 namespace ajn {
 
+class ICEManager;
+
 void Tokenize(const String& str,
               vector<String>& tokens,
               const char* delimiters = " ");
@@ -85,6 +88,17 @@ static const uint32_t TURN_REFRESH_WARNING_PERIOD_SECS = 15;
 // Interval at which to send the NAT keepalives
 static const uint32_t STUN_KEEP_ALIVE_INTERVAL_IN_MILLISECS = 15000;
 
+// per draft-ietf-mmusic-ice-19 Section 16, the default pacing interval (Ta) for
+// non-RTP media and the smallest pacing interval that may be configured.
+static const uint32_t ICE_DEFAULT_PACING_INTERVAL_IN_MILLISECS = 500;
+static const uint32_t ICE_MIN_PACING_INTERVAL_IN_MILLISECS = 20;
+
+// Once one local interface has gathered its candidates, interfaces that have
+// not heard from the STUN/TURN server within this time are given up on (their
+// host candidates are still offered) rather than holding up gathering until
+// all of their retries are exhausted.
+static const uint32_t ICE_GATHERING_GRACE_PERIOD_IN_MILLISECS = 1000;
+
 const uint8_t REQUESTED_TRANSPORT_TYPE_UDP = 17;
 const uint8_t REQUESTED_TRANSPORT_TYPE_TCP = 6;
 
@@ -160,6 +174,13 @@ class ICESession {
 
     uint16_t GetActiveCheckListCount(void);
 
+    /**
+     * Get the interval (Ta) between consecutive STUN transactions sent for this session.
+     *
+     * @return  The pacing interval in milliseconds.
+     */
+    uint32_t GetPacingInterval(void) const { return pacingIntervalMsecs; }
+
     void DeterminePeerReflexiveFoundation(IPAddress addr,
                                           SocketType transportProtocol,
                                           String& foundation);
@@ -293,6 +314,8 @@ class ICESession {
     /// const_iterator typedef.
     typedef vector<ICEStream*>::const_iterator stream_const_iterator;
 
+    ICEManager* manager;
+
     ICESessionListener* sessionListener;
 
     bool addHostCandidates;
@@ -307,6 +330,12 @@ class ICESession {
 
     bool useAggressiveNomination;
 
+    uint32_t pacingIntervalMsecs;
+
+    bool candidatesGathered;            // At least one host candidate completed gathering
+
+    uint32_t candidatesGatheredTime;    // When the first host candidate completed gathering
+
     uint16_t foundationID;
 
     bool checksStarted;
@@ -324,13 +353,15 @@ class ICESession {
     NetworkInterface networkInterface;
 
     // Private ctor, used only by friend ICEManager
-    ICESession(bool addHostCandidates,
+    ICESession(ICEManager* manager,
+               bool addHostCandidates,
                bool addRelayedCandidates,
                ICESessionListener* listener,
                STUNServerInfo stunInfo,
                IPAddress onDemandAddress,
                IPAddress persistentAddress,
-               bool enableIPv6) :
+               bool enableIPv6,
+               uint32_t pacingIntervalMsecs) :
         hmacKeyLen(0),
         TurnServerAvailable(false),
         terminating(false),
@@ -339,6 +370,7 @@ class ICESession {
         remoteShortTermHmacKey(NULL),
         remoteShortTermHmacKeyLength(0),
         sessionState(ICEUninitialized),
+        manager(manager),
         sessionListener(listener),
         addHostCandidates(addHostCandidates),
         addRelayedCandidates(addRelayedCandidates),
@@ -346,6 +378,9 @@ class ICESession {
         errorCode(ER_OK),
         isControllingAgent(false),
         useAggressiveNomination(false),
+        pacingIntervalMsecs(std::max(pacingIntervalMsecs, ICE_MIN_PACING_INTERVAL_IN_MILLISECS)),
+        candidatesGathered(false),
+        candidatesGatheredTime(0),
         foundationID(0),
         checksStarted(false),
         listenerNotifiedOnSuccessOrFailure(false),
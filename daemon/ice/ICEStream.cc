@@ -459,7 +459,7 @@ void ICEStream::SetTerminate(void)
 void ICEStream::CheckListDispatcher(void)
 {
     uint32_t activeCheckListCount;
-    uint32_t pacingIntervalMsecs = 500;
+    uint32_t pacingIntervalMsecs = session->GetPacingInterval();
 
     session->Lock();
 
@@ -134,6 +134,7 @@ ProximityScanEngine::ProximityScanEngine(DiscoveryManager*dm) : mainTimer("Proxi
     //request_scan = false;
     request_scan = true;
     no_scan_results_count = 0;
+    scanDelay = SCAN_DELAY;
     discoveryManager = dm;
     proximityScanner = new ProximityScanner(bus);
     finalMap.clear();
@@ -175,6 +176,9 @@ void ProximityScanEngine::ProcessScanResults() {
         QCC_LogError(ER_FAIL, ("proximityScanner == NULL "));
     }
 
+    bool resultsChanged = (proximityScanner->scanResults != lastScanResults);
+    lastScanResults = proximityScanner->scanResults;
+
     bssid_lock.Lock(MUTEX_CONTEXT);
     for (it = proximityScanner->scanResults.begin(); it != proximityScanner->scanResults.end(); it++) {
         //hit = hysteresisMap.find(it->first);
@@ -212,12 +216,14 @@ void ProximityScanEngine::ProcessScanResults() {
     // if count has reached zero remove it from the final AND hysteresis map in that order since you need the key from hysteresis
     //          Update final map .. Indicate with a boolean that there has been a change in the final map
     QCC_DbgPrintf(("Decrementing counts in Hysteresis Map "));
+    bool dropPending = false;
     bssid_lock.Lock(MUTEX_CONTEXT);
     hit = hysteresisMap.begin();
     while (hit != hysteresisMap.end()) {
         it = proximityScanner->scanResults.find(hit->first);
         if (it == proximityScanner->scanResults.end()) {
             hit->second = hit->second - 1;
+            dropPending = true;
             QCC_DbgPrintf(("Value of <%s,%s> = %d after decrementing", hit->first.first.c_str(), hit->first.second.c_str(), hit->second));
             if (hit->second == 0) {
                 wifiapDroppped = true;
@@ -232,6 +238,19 @@ void ProximityScanEngine::ProcessScanResults() {
         }
     }
     bssid_lock.Unlock(MUTEX_CONTEXT);
+
+    //
+    // Back off the scan interval while the scan results stay the same. Go back to
+    // scanning at the base rate as soon as they change, and stay there while entries
+    // are counting down to be dropped so that the hysteresis keeps its timing
+    //
+    if (resultsChanged || dropPending) {
+        scanDelay = SCAN_DELAY;
+    } else {
+        scanDelay = ::min(scanDelay * 2, MAX_SCAN_DELAY);
+    }
+    QCC_DbgPrintf(("Next scan in %u ms", (uint32_t)scanDelay));
+
 //  We send an update in two conditions:
 //	1. We reached Tadd count == 4 and the scan results are being returned with some results (non-empty)
 //	2. Something was dropped from the final map
@@ -245,19 +264,31 @@ void ProximityScanEngine::ProcessScanResults() {
 
     if ((tadd_count == TADD_COUNT && wifiON) || wifiapDroppped || request_scan) {
         // Form the proximity message if needed by checking for the boolean set in the above two cases
-        // and Queue it if there is a change
+        // and Queue it if there is a change. The Rendezvous Server already has the final map we last
+        // queued so there is nothing to send if it has not changed since.
+
+        bssid_lock.Lock(MUTEX_CONTEXT);
+        bool changed = (finalMap != sentMap);
+        if (changed) {
+            sentMap = finalMap;
+        }
+        bssid_lock.Unlock(MUTEX_CONTEXT);
 
-        list<String> bssids;
-        list<String> macIds;
+        if (changed) {
+            list<String> bssids;
+            list<String> macIds;
 
-        bssids.clear();
-        macIds.clear();
+            bssids.clear();
+            macIds.clear();
 
-        ProximityMessage proximityMsg = GetScanResults(bssids, macIds);
-        QCC_DbgPrintf(("=-=-=-=-=-=-=-=-=-=-=-= Queuing Proximity Message =-=-=-=-=-=-=-=-=-=-=-="));
-        PrintFinalMap();
+            ProximityMessage proximityMsg = GetScanResults(bssids, macIds);
+            QCC_DbgPrintf(("=-=-=-=-=-=-=-=-=-=-=-= Queuing Proximity Message =-=-=-=-=-=-=-=-=-=-=-="));
+            PrintFinalMap();
 
-        discoveryManager->QueueProximityMessage(proximityMsg, bssids, macIds);
+            discoveryManager->QueueProximityMessage(proximityMsg, bssids, macIds);
+        } else {
+            QCC_DbgPrintf(("Final Map unchanged since last queued, not queuing Proximity Message"));
+        }
 
         wifiapDroppped = false;
         //wifiapAdded = false;
@@ -304,7 +335,8 @@ void ProximityScanEngine::AlarmTriggered(const Alarm& alarm, QStatus reason)
             uint64_t start = GetTimestamp64();
             proximityScanner->Scan(request_scan);
             ProcessScanResults();
-            uint32_t delay = ::max((uint64_t)0, SCAN_DELAY - (GetTimestamp64() - start));
+            uint64_t elapsed = GetTimestamp64() - start;
+            uint32_t delay = (elapsed < scanDelay) ? (uint32_t)(scanDelay - elapsed) : 0;
             if (delay > 0) {
                 //Add alarm with delay time to our main timer
                 QCC_DbgPrintf(("Adding Alarm "));
@@ -327,6 +359,9 @@ void ProximityScanEngine::StopScan() {
 
     hysteresisMap.clear();
     finalMap.clear();
+    sentMap.clear();
+    lastScanResults.clear();
+    scanDelay = SCAN_DELAY;
     //isFirstScanComplete = false;
     wifiapDroppped = false;
     //wifiapAdded = false;
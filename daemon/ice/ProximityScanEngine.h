@@ -41,6 +41,7 @@
 #define TDROP_COUNT 4
 
 const uint64_t SCAN_DELAY = 15000;
+const uint64_t MAX_SCAN_DELAY = 120000;
 const int START_COUNT = 4;
 //class ProximityScanner;
 
@@ -96,6 +97,8 @@ class ProximityScanEngine : public qcc::AlarmListener, public qcc::Thread {
 
     std::map<std::pair<qcc::String, qcc::String>, int>   hysteresisMap; /* Map used to keep track of BSSIDs for adding/removal from the final list */
     std::map<std::pair<qcc::String, qcc::String>, bool>  finalMap; /* The Map holding the final set sent to the Rendezvous */
+    std::map<std::pair<qcc::String, qcc::String>, bool>  sentMap; /* The final Map as it was when last queued to the Rendezvous */
+    std::map<std::pair<qcc::String, qcc::String>, bool>  lastScanResults; /* The results of the previous scan */
 
     qcc::Mutex bssid_lock;                                      /* Mutex for initial_bssid and final_bssid */
 
@@ -104,6 +107,8 @@ class ProximityScanEngine : public qcc::AlarmListener, public qcc::Thread {
     int tadd_count;                                             /* tadd = 4 * tscan */
     int no_scan_results_count;
 
+    uint64_t scanDelay;                                         /* Time between scans, doubles up to MAX_SCAN_DELAY while results are stable */
+
     DiscoveryManager* discoveryManager;                         /* Pointer to the instance of DiscoveryManager that calls ProximityScanner */
 
     ProximityScanner* proximityScanner;                         /* Object that implements the platform specific Scan function */
@@ -187,6 +187,18 @@ class RendezvousServerConnection {
      */
     QStatus FetchResponse(bool isOnDemandConnection, HttpConnection::HTTPResponse& response);
 
+    /**
+     * @internal
+     * @brief Function indicating if a response has already been received and buffered on a
+     * connection. Such a response can be fetched without waiting for the source event.
+     */
+    bool HasBufferedResponse(bool isOnDemandConnection)
+    {
+        HttpConnection* connection = isOnDemandConnection ? onDemandConn : persistentConn;
+        bool isUp = isOnDemandConnection ? onDemandIsConnected : persistentIsConnected;
+        return isUp && connection && connection->HasBufferedResponse();
+    };
+
     /**
      * @internal
      * @brief Reset the persistentConnectionChanged flag
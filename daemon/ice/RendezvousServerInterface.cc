@@ -206,7 +206,7 @@ String GenerateJSONAdvertisement(AdvertiseMessage message)
 
     advMsg[ads] = adsObj;
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(advMsg).c_str();
 
     QCC_DbgPrintf(("GenerateJSONAdvertisement():%s", retStr.c_str()));
@@ -253,7 +253,7 @@ String GenerateJSONSearch(SearchMessage message)
 
     searchMsg[search] = searchObj;
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(searchMsg).c_str();
 
     QCC_DbgPrintf(("GenerateJSONSearch():%s", retStr.c_str()));
@@ -316,7 +316,7 @@ String GenerateJSONProximity(ProximityMessage message)
 
     proxMsg[proximity] = proxMsgObj;
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(proxMsg).c_str();
 
     QCC_DbgPrintf(("GenerateJSONProximity():%s", retStr.c_str()));
@@ -380,7 +380,7 @@ String GenerateJSONCandidates(ICECandidatesMessage message)
 
     addCandMsg[candidates] = candidatesObj;
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(addCandMsg).c_str();
 
     QCC_DbgPrintf(("GenerateJSONCandidates():%s", retStr.c_str()));
@@ -391,7 +391,7 @@ String GenerateJSONCandidates(ICECandidatesMessage message)
 /**
  * Worker function used to parse a generic response
  */
-QStatus ParseGenericResponse(Json::Value receivedResponse, GenericResponse& parsedResponse)
+QStatus ParseGenericResponse(Json::Value& receivedResponse, GenericResponse& parsedResponse)
 {
     QStatus status = ER_OK;
 
@@ -415,7 +415,7 @@ QStatus ParseGenericResponse(Json::Value receivedResponse, GenericResponse& pars
 /**
  * Worker function used to parse a refresh token response
  */
-QStatus ParseTokenRefreshResponse(Json::Value receivedResponse, TokenRefreshResponse& parsedResponse)
+QStatus ParseTokenRefreshResponse(Json::Value& receivedResponse, TokenRefreshResponse& parsedResponse)
 {
     QStatus status = ER_OK;
 
@@ -550,7 +550,7 @@ void PrintMessageResponse(Response msg)
 /**
  * Worker function used to parse a message response
  */
-QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& parsedResponse)
+QStatus ParseMessagesResponse(Json::Value& receivedResponse, ResponseMessage& parsedResponse)
 {
     QStatus status = ER_OK;
 
@@ -591,25 +591,25 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
         status = ER_FAIL;
         QCC_LogError(status, ("ParseMessagesResponse(): Message is empty"));
     } else if (receivedResponse.isMember(msgs)) {
-        Json::Value msgsObj = receivedResponse[msgs];
+        Json::Value& msgsObj = receivedResponse[msgs];
         if (msgsObj.isArray()) {
             if (!msgsObj.empty()) {
                 for (Json::UInt j = 0; j < msgsObj.size(); j++) {
-                    Json::Value msgsObjArrayMember = msgsObj[j];
+                    Json::Value& msgsObjArrayMember = msgsObj[j];
 
                     if (msgsObjArrayMember[type] == "match") {
                         QCC_DbgPrintf(("ParseMessagesResponse(): [%d] Match Message", j));
 
                         if (msgsObjArrayMember.isMember(match)) {
 
-                            Json::Value matchObj = msgsObjArrayMember[match];
+                            Json::Value& matchObj = msgsObjArrayMember[match];
 
                             if (matchObj.isMember(searchedService)) {
                                 if (matchObj.isMember(service)) {
                                     if (matchObj.isMember(peerAddr)) {
                                         if (matchObj.isMember(STUNInfo)) {
 
-                                            Json::Value STUNInfoObj = matchObj[STUNInfo];
+                                            Json::Value& STUNInfoObj = matchObj[STUNInfo];
 
                                             if (STUNInfoObj.isMember(address)) {
                                                 if (STUNInfoObj.isMember(acct)) {
@@ -639,7 +639,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
                                                             SearchMatch->STUNInfo.recvTime = GetTimestamp64();
 
                                                             if (STUNInfoObj.isMember(relay)) {
-                                                                Json::Value relayObj = STUNInfoObj[relay];
+                                                                Json::Value& relayObj = STUNInfoObj[relay];
 
                                                                 if (relayObj.isMember(address)) {
                                                                     if (relayObj.isMember(port)) {
@@ -709,7 +709,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
                         QCC_DbgPrintf(("ParseMessagesResponse(): [%d] Address Candidates Message", j));
 
                         if (msgsObjArrayMember.isMember(addressCandidates)) {
-                            Json::Value addressCandidatesObj = msgsObjArrayMember[addressCandidates];
+                            Json::Value& addressCandidatesObj = msgsObjArrayMember[addressCandidates];
 
                             ICECandidates tempCandidateMsg;
 
@@ -723,13 +723,13 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
                                         AddressCandidates->ice_pwd = String(addressCandidatesObj[ice_pwd].asCString());
 
                                         if (addressCandidatesObj.isMember(candidates)) {
-                                            Json::Value candidatesObj = addressCandidatesObj[candidates];
+                                            Json::Value& candidatesObj = addressCandidatesObj[candidates];
 
                                             if (candidatesObj.isArray()) {
                                                 if (!candidatesObj.empty()) {
                                                     for (Json::UInt k = 0; k < candidatesObj.size(); k++) {
 
-                                                        Json::Value candidatesObjArrayMember = candidatesObj[k];
+                                                        Json::Value& candidatesObjArrayMember = candidatesObj[k];
 
                                                         if (candidatesObjArrayMember.isMember(type)) {
                                                             if (candidatesObjArrayMember.isMember(foundation)) {
@@ -805,7 +805,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
 
                                                     if (!AddressCandidates->candidates.empty()) {
                                                         if (addressCandidatesObj.isMember(STUNInfo)) {
-                                                            Json::Value STUNInfoObj = addressCandidatesObj[STUNInfo];
+                                                            Json::Value& STUNInfoObj = addressCandidatesObj[STUNInfo];
 
                                                             if (STUNInfoObj.isMember(address)) {
                                                                 if (STUNInfoObj.isMember(acct)) {
@@ -835,7 +835,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
 
                                                                             if (STUNInfoObj.isMember(relay)) {
 
-                                                                                Json::Value relayObj = STUNInfoObj[relay];
+                                                                                Json::Value& relayObj = STUNInfoObj[relay];
 
                                                                                 if (relayObj.isMember(address)) {
                                                                                     if (relayObj.isMember(port)) {
@@ -916,7 +916,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
                         QCC_DbgPrintf(("ParseMessagesResponse(): [%d] Match Revoked Message", j));
 
                         if (msgsObjArrayMember.isMember(matchRevoked)) {
-                            Json::Value revokeObj = msgsObjArrayMember[matchRevoked];
+                            Json::Value& revokeObj = msgsObjArrayMember[matchRevoked];
 
                             if (revokeObj.isMember(peerAddr)) {
                                 tempMsg.type = MATCH_REVOKED_RESPONSE;
@@ -935,7 +935,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
 
                                 if ((!revokeObj.isMember(deleteAll)) || (!MatchRevoked->deleteAll)) {
                                     if (revokeObj.isMember(services)) {
-                                        Json::Value servicesObj = revokeObj[services];
+                                        Json::Value& servicesObj = revokeObj[services];
 
                                         if (servicesObj.isArray()) {
                                             if (!servicesObj.empty()) {
@@ -968,7 +968,7 @@ QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& par
                         QCC_DbgPrintf(("ParseMessagesResponse(): [%d] Start ICE Checks Message", j));
 
                         if (msgsObjArrayMember.isMember(startICEChecks)) {
-                            Json::Value startICEChecksObj = msgsObjArrayMember[startICEChecks];
+                            Json::Value& startICEChecksObj = msgsObjArrayMember[startICEChecks];
 
                             if (startICEChecksObj.isMember(peerAddr)) {
                                 tempMsg.type = START_ICE_CHECKS_RESPONSE;
@@ -1052,7 +1052,7 @@ String GenerateJSONClientLoginRequest(ClientLoginRequest request)
     clientLoginRequest[mechanism] = GetSASLAuthMechanismString(request.mechanism).c_str();
     clientLoginRequest[message] = request.message.c_str();
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(clientLoginRequest).c_str();
 
     QCC_DbgPrintf(("GenerateJSONClientLoginRequest():%s", retStr.c_str()));
@@ -1064,7 +1064,7 @@ String GenerateJSONClientLoginRequest(ClientLoginRequest request)
 /**
  * Worker function used to parse the client login first response
  */
-QStatus ParseClientLoginFirstResponse(Json::Value receivedResponse, ClientLoginFirstResponse& parsedResponse)
+QStatus ParseClientLoginFirstResponse(Json::Value& receivedResponse, ClientLoginFirstResponse& parsedResponse)
 {
     QStatus status = ER_OK;
 
@@ -1088,7 +1088,7 @@ QStatus ParseClientLoginFirstResponse(Json::Value receivedResponse, ClientLoginF
 /**
  * Worker function used to parse a client login final response
  */
-QStatus ParseClientLoginFinalResponse(Json::Value receivedResponse, ClientLoginFinalResponse& parsedResponse)
+QStatus ParseClientLoginFinalResponse(Json::Value& receivedResponse, ClientLoginFinalResponse& parsedResponse)
 {
     QStatus status = ER_OK;
 
@@ -1116,7 +1116,7 @@ QStatus ParseClientLoginFinalResponse(Json::Value receivedResponse, ClientLoginF
                     parsedResponse.SetpeerAddr(String(receivedResponse[peerAddr].asCString()));
                     QCC_DbgPrintf(("ParseClientLoginFinalResponse(): peerAddr = %s", receivedResponse[peerAddr].asCString()));
 
-                    Json::Value configDataObj = receivedResponse[configData];
+                    Json::Value& configDataObj = receivedResponse[configData];
 
                     if (configDataObj.isMember(Tkeepalive)) {
 
@@ -1500,7 +1500,7 @@ String GenerateJSONDaemonRegistrationMessage(DaemonRegistrationMessage message)
     daemonRegMsg[osType] = GetOSTypeString(message.osType).c_str();
     daemonRegMsg[osVersion] = message.osVersion.c_str();
 
-    Json::StyledWriter writer;
+    Json::FastWriter writer;
     String retStr = writer.write(daemonRegMsg).c_str();
 
     QCC_DbgPrintf(("GenerateJSONDaemonRegistrationMessage():%s", retStr.c_str()));
@@ -1508,6 +1508,25 @@ String GenerateJSONDaemonRegistrationMessage(DaemonRegistrationMessage message)
     return retStr;
 }
 
+/**
+ * Worker function used to generate a Session Resume Message in
+ * the JSON format.
+ */
+String GenerateJSONResume(ResumeMessage message)
+{
+    /* The resume message nests the regular advertisement, search and proximity messages */
+    String retStr = String("{\"advertisement\":") + GenerateJSONAdvertisement(message.advertisement);
+    retStr += String(",\"search\":") + GenerateJSONSearch(message.search);
+    if (message.proximityPresent) {
+        retStr += String(",\"proximity\":") + GenerateJSONProximity(message.proximity);
+    }
+    retStr += "}";
+
+    QCC_DbgPrintf(("GenerateJSONResume():%s", retStr.c_str()));
+
+    return retStr;
+}
+
 /**
  * Returns the Advertisement message URI.
  */
@@ -1600,4 +1619,14 @@ String GetTokenRefreshUri(String peerID)
     return(String(buffer));
 }
 
+/**
+ * Returns the Session Resume URI.
+ */
+String GetResumeUri(String peerID)
+{
+    char buffer[500];
+    sprintf(buffer, ResumeUri.c_str(), peerID.c_str());
+    return(String(buffer));
+}
+
 }
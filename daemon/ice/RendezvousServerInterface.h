@@ -106,6 +106,11 @@ const String DaemonRegistrationUri = RendezvousServerAddress + RendezvousProtoco
  */
 const String TokenRefreshUri = RendezvousServerAddress + RendezvousProtocolVersion + String("/peer/%s/token");
 
+/**
+ * The Session Resume URI.
+ */
+const String ResumeUri = RendezvousServerAddress + RendezvousProtocolVersion + String("/peer/%s/resume");
+
 /* Buffer time to subtract from the token expiry time specified by the Rendezvous Server so that we try to get new tokens
  * before the old tokens actually expire at the Server */
 const uint32_t TURN_TOKEN_EXPIRY_TIME_BUFFER_IN_SECONDS = 60;
@@ -126,7 +131,8 @@ enum MessageType {
     GET_MESSAGE,                      /*GET Message*/
     CLIENT_LOGIN,                     /*Client Login Message*/
     DAEMON_REGISTRATION,              /*Daemon Registration Message*/
-    TOKEN_REFRESH                     /*Token refresh Message*/
+    TOKEN_REFRESH,                    /*Token refresh Message*/
+    RESUME                            /*Session resume Message*/
 };
 
 /**
@@ -1482,6 +1488,49 @@ class TokenRefreshMessage : public InterfaceMessage {
     TokenRefreshListener* tokenRefreshListener;
 };
 
+/**
+ * The structure defining the Session Resume Message. It carries the complete
+ * advertisement, search and proximity state of the daemon so that a Rendezvous
+ * Session can be restored with a single request after a reconnect.
+ */
+class ResumeMessage : public InterfaceMessage {
+
+  public:
+
+    /** Constructor */
+    ResumeMessage() :
+        InterfaceMessage(RESUME, HttpConnection::METHOD_POST),
+        proximityPresent(false)
+    {
+    }
+
+    /** Clone */
+    InterfaceMessage* Clone()
+    {
+        return new ResumeMessage(*this);
+    }
+
+    /**
+     * The current advertisements. An empty list withdraws all advertisements.
+     */
+    AdvertiseMessage advertisement;
+
+    /**
+     * The current searches. An empty list withdraws all searches.
+     */
+    SearchMessage search;
+
+    /**
+     * Boolean indicating if valid proximity information is present.
+     */
+    bool proximityPresent;
+
+    /**
+     * The current proximity information.
+     */
+    ProximityMessage proximity;
+};
+
 /**
  * Worker function used to generate the enum value corresponding
  * to the ICE candidate type.
@@ -1539,12 +1588,12 @@ String GenerateJSONCandidates(ICECandidatesMessage message);
 /**
  * Worker function used to parse a generic response
  */
-QStatus ParseGenericResponse(Json::Value receivedResponse, GenericResponse& parsedResponse);
+QStatus ParseGenericResponse(Json::Value& receivedResponse, GenericResponse& parsedResponse);
 
 /**
  * Worker function used to parse a refresh token response
  */
-QStatus ParseTokenRefreshResponse(Json::Value receivedResponse, TokenRefreshResponse& parsedResponse);
+QStatus ParseTokenRefreshResponse(Json::Value& receivedResponse, TokenRefreshResponse& parsedResponse);
 
 /**
  * Worker function used to print a parsed response
@@ -1554,7 +1603,7 @@ void PrintMessageResponse(Response response);
 /**
  * Worker function used to parse a messages response
  */
-QStatus ParseMessagesResponse(Json::Value receivedResponse, ResponseMessage& parsedResponse);
+QStatus ParseMessagesResponse(Json::Value& receivedResponse, ResponseMessage& parsedResponse);
 
 /**
  * Worker function used to generate the string corresponding
@@ -1568,15 +1617,21 @@ String GetSASLAuthMechanismString(SASLAuthenticationMechanism authMechanism);
  */
 String GenerateJSONClientLoginRequest(ClientLoginRequest request);
 
+/**
+ * Worker function used to generate a Session Resume Message in
+ * the JSON format.
+ */
+String GenerateJSONResume(ResumeMessage message);
+
 /**
  * Worker function used to parse the client login first response
  */
-QStatus ParseClientLoginFirstResponse(Json::Value receivedResponse, ClientLoginFirstResponse& parsedResponse);
+QStatus ParseClientLoginFirstResponse(Json::Value& receivedResponse, ClientLoginFirstResponse& parsedResponse);
 
 /**
  * Worker function used to parse the client login final response
  */
-QStatus ParseClientLoginFinalResponse(Json::Value receivedResponse, ClientLoginFinalResponse& parsedResponse);
+QStatus ParseClientLoginFinalResponse(Json::Value& receivedResponse, ClientLoginFinalResponse& parsedResponse);
 
 /**
  * Worker function used to generate the enum corresponding
@@ -1667,6 +1722,11 @@ String GetDaemonRegistrationUri(String peerID);
  */
 String GetTokenRefreshUri(String peerID);
 
+/**
+ * Returns the Session Resume URI.
+ */
+String GetResumeUri(String peerID);
+
 }
 
 #endif /* RENDEZVOUSSERVERINTERFACE_H_ */
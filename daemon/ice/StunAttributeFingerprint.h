@@ -44,6 +44,7 @@ class StunMessage;
 class StunAttributeFingerprint : public StunAttribute {
   private:
     static const uint32_t CRC_TABLE[256];   ///< CRC look up table.
+    static const uint32_t CRC_SLICE_TABLE[3][256];   ///< CRC look up tables for 4 octets at a time.
     const StunMessage& message;   ///< Reference to containing message.
     uint32_t fingerprint;         ///< CRC-32 value (XOR'd w/ 0x5354554e) for containing message.
     static const uint32_t MAGIC_XOR = 0x5354554e;    ///< Magic XOR value (see RFC 5389 sec. 15.5).
@@ -21,6 +21,9 @@
  ******************************************************************************/
 
 #include <qcc/platform.h>
+
+#include <algorithm>
+
 #include <qcc/Crypto.h>
 #include <StunAttributeBase.h>
 #include <StunAttributeMessageIntegrity.h>
@@ -122,8 +125,8 @@ QStatus StunAttributeMessageIntegrity::RenderBinary(uint8_t*& buf, size_t& bufSi
     uint16_t fakeLen;
     uint8_t lengthBuf[2];
     StunMessage::const_iterator attr;
-    ScatterGatherList miSG;
     ScatterGatherList::const_iterator sgIter;
+    size_t pos;
     Crypto_SHA1 sha1;
     QStatus status;
 
@@ -139,26 +142,42 @@ QStatus StunAttributeMessageIntegrity::RenderBinary(uint8_t*& buf, size_t& bufSi
     lengthBuf[0] = static_cast<uint8_t>(fakeLen >> 8);
     lengthBuf[1] = static_cast<uint8_t>(fakeLen & 0xff);
 
-    miSG = sg;
-
-    QCC_DbgPrintf(("Computing SHA1 over %u bytes (fakeLen = %u).", miSG.DataSize(), fakeLen));
+    QCC_DbgPrintf(("Computing SHA1 over %u bytes (fakeLen = %u).", sg.DataSize(), fakeLen));
     QCC_DbgLocalData(message.hmacKey, message.hmacKeyLen);
 
 
     sha1.Init(message.hmacKey, message.hmacKeyLen);
 
-    // Do the first 4 octets manually for the faked length.
-    sha1.Update(reinterpret_cast<uint8_t*>(miSG.Begin()->buf), sizeof(uint16_t));
-    QCC_DbgLocalData(miSG.Begin()->buf, sizeof(uint16_t));
-    miSG.TrimFromBegining(sizeof(uint16_t));
-
-    sha1.Update(lengthBuf, sizeof(lengthBuf));
-    QCC_DbgLocalData(lengthBuf, sizeof(lengthBuf));
-    miSG.TrimFromBegining(sizeof(lengthBuf));
-
-    for (sgIter = miSG.Begin(); sgIter != miSG.End(); ++sgIter) {
-        sha1.Update(reinterpret_cast<uint8_t*>(sgIter->buf), sgIter->len);
-        QCC_DbgLocalData(sgIter->buf, sgIter->len);
+    // Walk the rendered buffers in place rather than copying and trimming
+    // the scatter-gather list.  The message type octets are hashed as is,
+    // the real length octets are replaced by the faked length and the rest
+    // of the message is hashed as is.
+    pos = 0;
+    for (sgIter = sg.Begin(); sgIter != sg.End(); ++sgIter) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(sgIter->buf);
+        size_t len = sgIter->len;
+
+        while (len > 0) {
+            size_t n;
+            if (pos < sizeof(uint16_t)) {
+                n = std::min(len, sizeof(uint16_t) - pos);
+                sha1.Update(data, n);
+                QCC_DbgLocalData(data, n);
+                if ((pos + n) == sizeof(uint16_t)) {
+                    sha1.Update(lengthBuf, sizeof(lengthBuf));
+                    QCC_DbgLocalData(lengthBuf, sizeof(lengthBuf));
+                }
+            } else if (pos < (sizeof(uint16_t) + sizeof(lengthBuf))) {
+                n = std::min(len, (sizeof(uint16_t) + sizeof(lengthBuf)) - pos);
+            } else {
+                n = len;
+                sha1.Update(data, n);
+                QCC_DbgLocalData(data, n);
+            }
+            data += n;
+            len -= n;
+            pos += n;
+        }
     }
 
     status = StunAttribute::RenderBinary(buf, bufSize, sg);
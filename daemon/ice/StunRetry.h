@@ -168,6 +168,8 @@ class Retransmit {
 
     void IncrementAttempts();
 
+    uint8_t GetAttempts(void) const { return sendAttempt; }
+
     void RecordKeepaliveTime(void);
 
     // Make it appear this has been waiting for longest time
@@ -35,6 +35,8 @@
 
 namespace ajn {
 
+const size_t IpNameService::DATAGRAM_MAX = IpNameServiceImpl::DATAGRAM_MAX;
+
 IpNameService::IpNameService()
     : m_constructed(false), m_destroyed(false), m_refCount(0), m_pimpl(NULL)
 {
@@ -292,6 +294,36 @@ void IpNameService::SetCallback(TransportMask transportMask,
     m_pimpl->SetCallback(transportMask, cb);
 }
 
+void IpNameService::SetDatagramCallback(Callback<void, const uint8_t*, size_t>* cb)
+{
+    //
+    // If the entry gate has been closed, we do not allow a SetDatagramCallback
+    // to actually set anything.  As with SetCallback(), the private
+    // implementation has already cleared any callback before the gate closed.
+    //
+    if (m_destroyed) {
+        return;
+    }
+
+    ASSERT_STATE("SetDatagramCallback");
+    m_pimpl->SetDatagramCallback(cb);
+}
+
+QStatus IpNameService::SendDatagram(TransportMask transportMask, const uint8_t* buf, size_t len)
+{
+    //
+    // If the entry gate has been closed, we do not allow a SendDatagram to
+    // actually send anything.  The singleton is going away and so we assume we
+    // are running __run_exit_handlers() so main() has returned.
+    //
+    if (m_destroyed) {
+        return ER_OK;
+    }
+
+    ASSERT_STATE("SendDatagram");
+    return m_pimpl->SendDatagram(transportMask, buf, len);
+}
+
 QStatus IpNameService::CreateVirtualInterface(const qcc::IfConfigEntry& entry)
 {
     //
@@ -453,6 +485,16 @@ QStatus IpNameService::FindAdvertisedName(TransportMask transportMask, const qcc
     return m_pimpl->FindAdvertisedName(transportMask, prefix);
 }
 
+void IpNameService::RequestFastDiscovery(uint32_t durationMs)
+{
+    if (m_destroyed) {
+        return;
+    }
+
+    ASSERT_STATE("RequestFastDiscovery");
+    m_pimpl->RequestFastDiscovery(durationMs);
+}
+
 QStatus IpNameService::CancelFindAdvertisedName(TransportMask transportMask, const qcc::String& prefix)
 {
     return ER_OK;
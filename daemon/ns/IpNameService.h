@@ -77,6 +77,11 @@ class IpNameServiceImpl;
 class IpNameService {
   public:
 
+    /**
+     * @brief The largest payload that can be sent with SendDatagram().
+     */
+    static const size_t DATAGRAM_MAX;
+
     /**
      * @brief Return a reference to the IpNameService singleton.
      */
@@ -145,6 +150,36 @@ class IpNameService {
     void SetCallback(TransportMask transportMask,
                      Callback<void, const qcc::String&, const qcc::String&, std::vector<qcc::String>&, uint8_t>* cb);
 
+    /**
+     * @brief Set the callback function that is called with the payload of each
+     *     datagram received over the name service multicast groups.
+     *
+     * Our own datagrams are looped back too, so the receiver must recognize
+     * and drop those it sent itself.
+     *
+     * @param cb The callback method that will be called with each received
+     *     datagram, or NULL to stop notifications.
+     */
+    void SetDatagramCallback(Callback<void, const uint8_t*, size_t>* cb);
+
+    /**
+     * @brief Multicast an opaque datagram over the network interfaces opened by
+     * the specified transports.
+     *
+     * Datagrams are sent once and never retransmitted, and daemons that do not
+     * understand them ignore them, so any loss must be handled by the sender
+     * and receiver of the datagrams.
+     *
+     * @param transportMask A bitmask containing the transports whose opened
+     *     interfaces the datagram is sent out on.
+     * @param buf The payload to send.
+     * @param len The length of the payload, at most DATAGRAM_MAX octets.
+     *
+     * @return ER_OK if the datagram was queued, ER_PACKET_TOO_LARGE if it is
+     *     too long, or ER_FAIL if the name service is not running.
+     */
+    QStatus SendDatagram(TransportMask transportMask, const uint8_t* buf, size_t len);
+
     /**
      * @brief Creat a virtual network interface. In normal cases WiFi-Direct
      * creates a soft-AP for a temporary network. In some OSs like WinRT, there is
@@ -350,6 +385,14 @@ class IpNameService {
      */
     QStatus FindAdvertisedName(TransportMask transportMask, const qcc::String& prefix);
 
+    /**
+     * @brief Retry discovery requests made in the next durationMs milliseconds
+     * on the short fast discovery schedule rather than the normal back-off.
+     *
+     * @param durationMs How long fast discovery should stay in effect.
+     */
+    void RequestFastDiscovery(uint32_t durationMs);
+
     /**
      * @brief Stop discovering well-known names starting with the specified
      * prefix over the network interfaces opened by the specified transport.
@@ -32,6 +32,16 @@
 #include <iphlpapi.h>
 #endif
 
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+#define IPNS_NETLINK_MONITOR 1
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
 #include <qcc/Debug.h>
 #include <qcc/Event.h>
 #include <qcc/Socket.h>
@@ -42,6 +52,7 @@
 #include <DaemonConfig.h>
 
 #include "IpNameServiceImpl.h"
+#include "TimerSlack.h"
 
 #define QCC_MODULE "IPNS"
 
@@ -339,6 +350,14 @@ const uint16_t IpNameServiceImpl::BROADCAST_PORT = IpNameServiceImpl::MULTICAST_
 //
 const char* IpNameServiceImpl::IPV6_ALLJOYN_MULTICAST_GROUP = "ff02::13a";
 
+//
+// Datagrams sent with SendDatagram() share the name service sockets, groups
+// and port, but carry this message version in the low nibble of the version
+// octet.  Header::Deserialize() only accepts message versions zero and one, so
+// name services that predate datagrams quietly drop them.
+//
+static const uint8_t DATAGRAM_MSG_VERSION = 0xf;
+
 //
 // Simple pattern matching function that supports '*' and '?' only.  Returns a
 // bool in the sense of "a difference between the string and pattern exists."
@@ -445,13 +464,52 @@ bool IpNameServiceImplWildcardMatch(qcc::String str, qcc::String pat)
     return true;
 }
 
+//
+// Find out if any of a sorted set of names matches a who-has pattern.  The
+// overwhelmingly common patterns are an exact name and a prefix followed by a
+// single trailing wildcard; those are answered with a binary search of the
+// set.  Anything else is left to IpNameServiceImplWildcardMatch() one name at
+// a time.  Note that, unlike IpNameServiceImplWildcardMatch(), this returns
+// true if there is a match.
+//
+bool IpNameServiceImplAnyMatch(const std::set<qcc::String>& names, const qcc::String& pat)
+{
+    if (names.empty() || pat.size() == 0) {
+        return false;
+    }
+
+    size_t wildcard = pat.find_first_of('*');
+    bool noQuestionMark = (pat.find_first_of('?') == qcc::String::npos);
+
+    if (noQuestionMark && wildcard == qcc::String::npos) {
+        return names.find(pat) != names.end();
+    }
+
+    if (noQuestionMark && wildcard == pat.size() - 1) {
+        qcc::String prefix = pat.substr(0, wildcard);
+        std::set<qcc::String>::const_iterator i = names.lower_bound(prefix);
+        return i != names.end() && (*i).compare(0, prefix.size(), prefix) == 0;
+    }
+
+    for (std::set<qcc::String>::const_iterator i = names.begin(); i != names.end(); ++i) {
+        if (IpNameServiceImplWildcardMatch(*i, pat) == false) {
+            return true;
+        }
+    }
+    return false;
+}
+
 IpNameServiceImpl::IpNameServiceImpl()
     : Thread("IpNameServiceImpl"), m_state(IMPL_SHUTDOWN), m_isProcSuspending(false),
-    m_terminal(false), m_protect_callback(false), m_timer(0), m_tDuration(DEFAULT_DURATION),
+    m_terminal(false), m_protect_callback(false), m_timer(0), m_deltaTimer(0), m_tDuration(DEFAULT_DURATION),
     m_tRetransmit(RETRANSMIT_TIME), m_tQuestion(QUESTION_TIME),
     m_modulus(QUESTION_MODULUS), m_retries(NUMBER_RETRIES),
+    m_retryIntervalMs(RETRY_INTERVAL_INITIAL_MS), m_retryIntervalMaxMs(RETRY_INTERVAL * 1000),
+    m_retryJitterPercent(RETRY_JITTER_PERCENT), m_fastRetries(FAST_DISCOVERY_RETRIES),
+    m_fastIntervalMs(FAST_DISCOVERY_INTERVAL_MS), m_fastDiscoveryStartupMs(FAST_DISCOVERY_STARTUP_MS),
+    m_fastDiscoveryUntil(0), m_answerHoldoffMs(ANSWER_HOLDOFF_MS), m_answerHoldoffMaxMs(ANSWER_HOLDOFF_MAX_MS),
     m_loopback(false), m_enableIPv4(false), m_enableIPv6(false),
-    m_wakeEvent(), m_forceLazyUpdate(false),
+    m_wakeEvent(), m_forceLazyUpdate(false), m_monitorSockFd(-1), m_monitorEvent(NULL),
     m_enabled(false), m_doEnable(false), m_doDisable(false),
     m_ipv4QuietSockFd(-1), m_ipv6QuietSockFd(-1)
 {
@@ -459,6 +517,7 @@ IpNameServiceImpl::IpNameServiceImpl()
 
     memset(&m_any[0], 0, sizeof(m_any));
     memset(&m_callback[0], 0, sizeof(m_callback));
+    m_datagramCallback = NULL;
 
     memset(&m_enabledReliableIPv4[0], 0, sizeof(m_enabledReliableIPv4));
     memset(&m_enabledUnreliableIPv4[0], 0, sizeof(m_enabledUnreliableIPv4));
@@ -469,6 +528,11 @@ IpNameServiceImpl::IpNameServiceImpl()
     memset(&m_unreliableIPv4Port[0], 0, sizeof(m_unreliableIPv4Port));
     memset(&m_reliableIPv6Port[0], 0, sizeof(m_reliableIPv6Port));
     memset(&m_unreliableIPv6Port[0], 0, sizeof(m_unreliableIPv6Port));
+
+    memset(&m_retransmitCacheValid[0], 0, sizeof(m_retransmitCacheValid));
+
+    memset(&m_answerHoldoff[0], 0, sizeof(m_answerHoldoff));
+    memset(&m_lastAnswer[0], 0, sizeof(m_lastAnswer));
 }
 
 QStatus IpNameServiceImpl::Init(const qcc::String& guid, bool loopback)
@@ -496,6 +560,22 @@ QStatus IpNameServiceImpl::Init(const qcc::String& guid, bool loopback)
     m_enableIPv6 = config->Get("ip_name_service/property@enable_ipv6", "true") == "true";
     m_broadcast = config->Get("ip_name_service/property@disable_directed_broadcast", "false") == "false";
 
+    //
+    // The retry schedule of who-has questions and the holdoff of is-at
+    // answers trade discovery latency against multicast traffic, which
+    // depends very much on the network, so they can be tuned.  Intervals are
+    // in milliseconds.
+    //
+    m_retries = config->Get("ip_name_service/property@retries", NUMBER_RETRIES);
+    m_retryIntervalMs = config->Get("ip_name_service/property@retry_interval", RETRY_INTERVAL_INITIAL_MS);
+    m_retryIntervalMaxMs = config->Get("ip_name_service/property@retry_interval_max", RETRY_INTERVAL * 1000);
+    m_retryJitterPercent = std::min(config->Get("ip_name_service/property@retry_jitter", RETRY_JITTER_PERCENT), static_cast<uint32_t>(100));
+    m_fastRetries = config->Get("ip_name_service/property@fast_discovery_retries", FAST_DISCOVERY_RETRIES);
+    m_fastIntervalMs = config->Get("ip_name_service/property@fast_discovery_interval", FAST_DISCOVERY_INTERVAL_MS);
+    m_fastDiscoveryStartupMs = config->Get("ip_name_service/property@fast_discovery_startup", FAST_DISCOVERY_STARTUP_MS);
+    m_answerHoldoffMs = config->Get("ip_name_service/property@answer_holdoff", ANSWER_HOLDOFF_MS);
+    m_answerHoldoffMaxMs = std::max(config->Get("ip_name_service/property@answer_holdoff_max", ANSWER_HOLDOFF_MAX_MS), m_answerHoldoffMs);
+
     //
     // Override the broadcast bit so we never actually use it (it didn't actually
     // work any better than multicast as it happens).
@@ -566,6 +646,9 @@ IpNameServiceImpl::~IpNameServiceImpl()
         m_requestedInterfaces[i].clear();
     }
 
+    delete m_datagramCallback;
+    m_datagramCallback = NULL;
+
     //
     // If we opened a socket to send quiet responses (unicast, not over the
     // multicast channel) we need to close it.
@@ -887,56 +970,151 @@ void IpNameServiceImpl::ClearLiveInterfaces(void)
     m_mutex.Lock();
 
     for (uint32_t i = 0; i < m_liveInterfaces.size(); ++i) {
-        if (m_liveInterfaces[i].m_sockFd == -1) {
-            continue;
-        }
-
         QCC_DbgPrintf(("IpNameServiceImpl::ClearLiveInterfaces(): clear interface %d", i));
+        CloseLiveInterface(m_liveInterfaces[i]);
+    }
 
-        //
-        // If the multicast bit is set, we have done an IGMP join.  In this
-        // case, we must arrange an IGMP drop via the appropriate socket option
-        // (via the qcc absraction layer). Android doesn't bother to compile its
-        // kernel with CONFIG_IP_MULTICAST set.  This doesn't mean that there is
-        // no multicast code in the Android kernel, it means there is no IGMP
-        // code in the kernel.  What this means to us is that even through we
-        // are doing an IP_DROP_MEMBERSHIP request, which is ultimately an IGMP
-        // operation, the request will filter through the IP code before being
-        // ignored and will do useful things in the kernel even though
-        // CONFIG_IP_MULTICAST was not set for the Android build -- i.e., we
-        // have to do it anyway.
-        //
-        if (m_liveInterfaces[i].m_flags & qcc::IfConfigEntry::MULTICAST) {
-            if (m_liveInterfaces[i].m_address.IsIPv4()) {
+    QCC_DbgPrintf(("IpNameServiceImpl::ClearLiveInterfaces(): Clear interfaces"));
+    m_liveInterfaces.clear();
+
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+
+    QCC_DbgPrintf(("IpNameServiceImpl::ClearLiveInterfaces(): Done"));
+}
+
+void IpNameServiceImpl::CloseLiveInterface(LiveInterface& live)
+{
+    if (live.m_sockFd == -1) {
+        return;
+    }
+
+    //
+    // If the multicast bit is set, we have done an IGMP join.  In this
+    // case, we must arrange an IGMP drop via the appropriate socket option
+    // (via the qcc absraction layer). Android doesn't bother to compile its
+    // kernel with CONFIG_IP_MULTICAST set.  This doesn't mean that there is
+    // no multicast code in the Android kernel, it means there is no IGMP
+    // code in the kernel.  What this means to us is that even through we
+    // are doing an IP_DROP_MEMBERSHIP request, which is ultimately an IGMP
+    // operation, the request will filter through the IP code before being
+    // ignored and will do useful things in the kernel even though
+    // CONFIG_IP_MULTICAST was not set for the Android build -- i.e., we
+    // have to do it anyway.
+    //
+    if (live.m_flags & qcc::IfConfigEntry::MULTICAST) {
+        if (live.m_address.IsIPv4()) {
 #if 1
-                qcc::LeaveMulticastGroup(m_liveInterfaces[i].m_sockFd, qcc::QCC_AF_INET, IPV4_ALLJOYN_MULTICAST_GROUP, m_liveInterfaces[i].m_interfaceName);
+            qcc::LeaveMulticastGroup(live.m_sockFd, qcc::QCC_AF_INET, IPV4_ALLJOYN_MULTICAST_GROUP, live.m_interfaceName);
 #endif
-            } else if (m_liveInterfaces[i].m_address.IsIPv6()) {
-                qcc::LeaveMulticastGroup(m_liveInterfaces[i].m_sockFd, qcc::QCC_AF_INET6, IPV6_ALLJOYN_MULTICAST_GROUP, m_liveInterfaces[i].m_interfaceName);
-            }
+        } else if (live.m_address.IsIPv6()) {
+            qcc::LeaveMulticastGroup(live.m_sockFd, qcc::QCC_AF_INET6, IPV6_ALLJOYN_MULTICAST_GROUP, live.m_interfaceName);
         }
+    }
 
-        //
-        // Always delete the event before closing the socket because the event
-        // is monitoring the socket state and therefore has a reference to the
-        // socket.  One the socket is closed the FD can be reused and our event
-        // can end up monitoring the wrong socket and interfere with the correct
-        // operation of other unrelated event/socket pairs.
-        //
-        delete m_liveInterfaces[i].m_event;
-        m_liveInterfaces[i].m_event = NULL;
+    //
+    // Always delete the event before closing the socket because the event
+    // is monitoring the socket state and therefore has a reference to the
+    // socket.  One the socket is closed the FD can be reused and our event
+    // can end up monitoring the wrong socket and interfere with the correct
+    // operation of other unrelated event/socket pairs.
+    //
+    delete live.m_event;
+    live.m_event = NULL;
 
-        qcc::Close(m_liveInterfaces[i].m_sockFd);
-        m_liveInterfaces[i].m_sockFd = -1;
+    qcc::Close(live.m_sockFd);
+    live.m_sockFd = -1;
+}
+
+void IpNameServiceImpl::OpenInterfaceMonitor(void)
+{
+#if defined(IPNS_NETLINK_MONITOR)
+    //
+    // On Linux (and so Android) the kernel multicasts link and address
+    // changes to anyone listening on a routing netlink socket.  Listening
+    // there lets us take a new or changed interface live as soon as it
+    // appears instead of waiting for the next periodic lazy update.
+    //
+    int fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (fd < 0) {
+        QCC_LogError(ER_OS_ERROR, ("IpNameServiceImpl::OpenInterfaceMonitor(): socket() failed: %d - %s",
+                                   qcc::GetLastError(), qcc::GetLastErrorString().c_str()));
+        return;
     }
 
-    QCC_DbgPrintf(("IpNameServiceImpl::ClearLiveInterfaces(): Clear interfaces"));
-    m_liveInterfaces.clear();
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
 
-    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
-    m_mutex.Unlock();
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+        QCC_LogError(ER_OS_ERROR, ("IpNameServiceImpl::OpenInterfaceMonitor(): bind() failed: %d - %s",
+                                   qcc::GetLastError(), qcc::GetLastErrorString().c_str()));
+        close(fd);
+        return;
+    }
 
-    QCC_DbgPrintf(("IpNameServiceImpl::ClearLiveInterfaces(): Done"));
+    m_monitorSockFd = fd;
+    m_monitorEvent = new qcc::Event(fd, qcc::Event::IO_READ, false);
+#endif
+}
+
+void IpNameServiceImpl::CloseInterfaceMonitor(void)
+{
+    if (m_monitorSockFd == -1) {
+        return;
+    }
+
+    delete m_monitorEvent;
+    m_monitorEvent = NULL;
+
+    qcc::Close(m_monitorSockFd);
+    m_monitorSockFd = -1;
+}
+
+bool IpNameServiceImpl::ReadInterfaceMonitor(void)
+{
+    bool changed = false;
+
+#if defined(IPNS_NETLINK_MONITOR)
+    uint8_t buffer[4096];
+
+    for (;;) {
+        int len = recv(m_monitorSockFd, buffer, sizeof(buffer), 0);
+        if (len < 0) {
+            //
+            // ENOBUFS means the kernel dropped notifications because we
+            // didn't keep up.  We don't know what they said, so assume the
+            // worst and keep reading.
+            //
+            if (errno == ENOBUFS) {
+                changed = true;
+                continue;
+            }
+            break;
+        }
+        if (len == 0) {
+            break;
+        }
+
+        for (struct nlmsghdr* nh = reinterpret_cast<struct nlmsghdr*>(buffer); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            switch (nh->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                changed = true;
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+#endif
+
+    return changed;
 }
 
 //
@@ -974,7 +1152,17 @@ void IpNameServiceImpl::LazyUpdateInterfaces(void)
     // IGMP packets every 30 seconds we take the conservative approach and tear
     // down all of our sockets and restart them every time through.
     //
-    ClearLiveInterfaces();
+    // The exception is when we have an interface monitor.  Then the system
+    // tells us when an interface goes down or changes address; since the
+    // join survives on the platforms that have one, we only need to touch the
+    // interfaces whose configuration actually changed.  Live interfaces that
+    // still match an IfConfig entry exactly are kept, and the rest are torn
+    // down once we've walked the entries.
+    //
+    if (m_monitorSockFd == -1) {
+        ClearLiveInterfaces();
+    }
+    std::vector<bool> keep(m_liveInterfaces.size(), false);
 
     //
     // If m_enable is false, we need to make sure that no packets are sent
@@ -985,11 +1173,13 @@ void IpNameServiceImpl::LazyUpdateInterfaces(void)
     //
     if (m_enabled == false) {
         QCC_DbgPrintf(("IpNameServiceImpl::LazyUpdateInterfaces(): Communication with the outside world is forbidden"));
+        ClearLiveInterfaces();
         return;
     }
 
     if (m_isProcSuspending) {
         QCC_DbgPrintf(("IpNameServiceImpl::LazyUpdateInterfaces(): The process is suspending. Stop communicating with the outside world"));
+        ClearLiveInterfaces();
         return;
     }
     //
@@ -1003,6 +1193,7 @@ void IpNameServiceImpl::LazyUpdateInterfaces(void)
     QStatus status = qcc::IfConfig(entries);
     if (status != ER_OK) {
         QCC_LogError(status, ("LazyUpdateInterfaces: IfConfig() failed"));
+        ClearLiveInterfaces();
         return;
     }
 
@@ -1175,6 +1366,30 @@ void IpNameServiceImpl::LazyUpdateInterfaces(void)
             continue;
         }
 
+        //
+        // If we already have this interface live with exactly the same
+        // configuration, there's nothing to do for it.
+        //
+        bool alreadyLive = false;
+        for (uint32_t j = 0; j < keep.size(); ++j) {
+            LiveInterface& live = m_liveInterfaces[j];
+            if (live.m_sockFd != -1 &&
+                live.m_interfaceName == entries[i].m_name &&
+                live.m_interfaceAddr == qcc::IPAddress(entries[i].m_addr) &&
+                live.m_prefixlen == entries[i].m_prefixlen &&
+                live.m_flags == entries[i].m_flags &&
+                live.m_mtu == entries[i].m_mtu &&
+                live.m_index == entries[i].m_index) {
+                QCC_DbgPrintf(("IpNameServiceImpl::LazyUpdateInterfaces(): Interface %s is already live", entries[i].m_name.c_str()));
+                keep[j] = true;
+                alreadyLive = true;
+                break;
+            }
+        }
+        if (alreadyLive) {
+            continue;
+        }
+
         //
         // We've decided the interface in question is interesting and we want to
         // use it to send and receive name service messages.  Now we need to
@@ -1340,6 +1555,19 @@ void IpNameServiceImpl::LazyUpdateInterfaces(void)
         //
         m_liveInterfaces.push_back(live);
     }
+
+    //
+    // Anything that was live before and didn't turn up again has gone away or
+    // changed, so tear it down.  New interfaces were added after the first
+    // keep.size() entries, so working backward leaves the indices valid.
+    //
+    for (uint32_t j = keep.size(); j > 0; --j) {
+        if (keep[j - 1] == false) {
+            QCC_DbgPrintf(("IpNameServiceImpl::LazyUpdateInterfaces(): Interface %s is no longer live", m_liveInterfaces[j - 1].m_interfaceName.c_str()));
+            CloseLiveInterface(m_liveInterfaces[j - 1]);
+            m_liveInterfaces.erase(m_liveInterfaces.begin() + (j - 1));
+        }
+    }
 }
 
 QStatus IpNameServiceImpl::Enable(TransportMask transportMask,
@@ -1412,7 +1640,8 @@ QStatus IpNameServiceImpl::Enable(TransportMask transportMask,
     m_reliableIPv4Port[i] = reliableIPv4Port;
     m_unreliableIPv4Port[i] = unreliableIPv4Port;
     m_reliableIPv6Port[i] = reliableIPv6Port;
-    m_unreliableIPv6Port[i] = reliableIPv6Port;
+    m_unreliableIPv6Port[i] = unreliableIPv6Port;
+    m_retransmitCacheValid[i] = false;
 
     m_enabledReliableIPv4[i] = enableReliableIPv4;
     m_enabledUnreliableIPv4[i] = enableUnreliableIPv4;
@@ -1544,7 +1773,7 @@ QStatus IpNameServiceImpl::FindAdvertisedName(TransportMask transportMask, const
         //
         // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
         m_mutex.Lock();
-        m_retry.push_back(header);
+        ScheduleRetry(header);
         // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
         m_mutex.Unlock();
 
@@ -1579,7 +1808,7 @@ QStatus IpNameServiceImpl::FindAdvertisedName(TransportMask transportMask, const
         //
         // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
         m_mutex.Lock();
-        m_retry.push_back(header);
+        ScheduleRetry(header);
         // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
         m_mutex.Unlock();
 
@@ -1601,6 +1830,7 @@ void IpNameServiceImpl::SetCriticalParameters(
 {
     m_tDuration = tDuration;
     m_tRetransmit = tRetransmit;
+    memset(&m_retransmitCacheValid[0], 0, sizeof(m_retransmitCacheValid));
     m_tQuestion = tQuestion;
     m_modulus = modulus;
     m_retries = retries;
@@ -1665,8 +1895,74 @@ void IpNameServiceImpl::ClearCallbacks(void)
         delete goner;
     }
 
+    Callback<void, const uint8_t*, size_t>* datagramGoner = m_datagramCallback;
+    m_datagramCallback = NULL;
+    delete datagramGoner;
+
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+}
+
+QStatus IpNameServiceImpl::SetDatagramCallback(Callback<void, const uint8_t*, size_t>* cb)
+{
+    QCC_DbgPrintf(("IpNameServiceImpl::SetDatagramCallback()"));
+
+    // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
+    m_mutex.Lock();
+    // Wait till the callback is in use.
+    while (m_protect_callback) {
+        m_mutex.Unlock();
+        qcc::Sleep(2);
+        m_mutex.Lock();
+    }
+
+    Callback<void, const uint8_t*, size_t>* goner = m_datagramCallback;
+    m_datagramCallback = NULL;
+    delete goner;
+    m_datagramCallback = cb;
+
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+
+    return ER_OK;
+}
+
+QStatus IpNameServiceImpl::SendDatagram(TransportMask transportMask, const uint8_t* buf, size_t len)
+{
+    // Maximum number of datagrams that can be queued.
+    static const size_t MAX_DATAGRAMS = 50;
+    QCC_DbgPrintf(("IpNameServiceImpl::SendDatagram(0x%x, %d)", transportMask, len));
+
+    if (len > DATAGRAM_MAX) {
+        QCC_LogError(ER_PACKET_TOO_LARGE, ("IpNameServiceImpl::SendDatagram(): Datagram (%d bytes) is longer than DATAGRAM_MAX (%d bytes)",
+                                           len, DATAGRAM_MAX));
+        return ER_PACKET_TOO_LARGE;
+    }
+
+    // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
+    m_mutex.Lock();
+    if (m_state != IMPL_RUNNING) {
+        m_mutex.Unlock();
+        QCC_DbgPrintf(("IpNameServiceImpl::SendDatagram(): Not running"));
+        return ER_FAIL;
+    }
+    if (m_outboundDatagrams.size() > MAX_DATAGRAMS) {
+        m_mutex.Unlock();
+        QCC_DbgPrintf(("IpNameServiceImpl::SendDatagram(): Too many datagrams queued"));
+        return ER_FAIL;
+    }
+
+    m_outboundDatagrams.push_back(OutboundDatagram());
+    OutboundDatagram& datagram = m_outboundDatagrams.back();
+    datagram.m_transportMask = transportMask;
+    datagram.m_bytes.reserve(len + 1);
+    datagram.m_bytes.push_back(static_cast<uint8_t>((1 << 4) | DATAGRAM_MSG_VERSION));
+    datagram.m_bytes.insert(datagram.m_bytes.end(), buf, buf + len);
+    m_wakeEvent.SetEvent();
     // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
     m_mutex.Unlock();
+
+    return ER_OK;
 }
 
 size_t IpNameServiceImpl::NumAdvertisements(TransportMask transportMask)
@@ -1739,6 +2035,7 @@ QStatus IpNameServiceImpl::AdvertiseName(TransportMask transportMask, vector<qcc
             list<qcc::String>::iterator j = find(m_advertised_quietly[transportIndex].begin(), m_advertised_quietly[transportIndex].end(), wkn[i]);
             if (j == m_advertised_quietly[transportIndex].end()) {
                 m_advertised_quietly[transportIndex].push_back(wkn[i]);
+                m_advertisedQuietlyIndex[transportIndex].insert(wkn[i]);
             } else {
                 //
                 // Nothing has changed, so don't bother.
@@ -1770,6 +2067,7 @@ QStatus IpNameServiceImpl::AdvertiseName(TransportMask transportMask, vector<qcc
             list<qcc::String>::iterator j = find(m_advertised[transportIndex].begin(), m_advertised[transportIndex].end(), wkn[i]);
             if (j == m_advertised[transportIndex].end()) {
                 m_advertised[transportIndex].push_back(wkn[i]);
+                m_advertisedIndex[transportIndex].insert(wkn[i]);
             } else {
                 //
                 // Nothing has changed, so don't bother.
@@ -1789,6 +2087,10 @@ QStatus IpNameServiceImpl::AdvertiseName(TransportMask transportMask, vector<qcc
         //
         m_advertised[transportIndex].sort();
 
+        for (uint32_t i = 0; i < wkn.size(); ++i) {
+            NoteAdvertisedChange(transportIndex, wkn[i], true);
+        }
+
         //
         // If the advertisement retransmission timer is cleared, then set us
         // up to retransmit.  This has to be done with the mutex locked since
@@ -2063,12 +2365,15 @@ QStatus IpNameServiceImpl::CancelAdvertiseName(TransportMask transportMask, vect
         list<qcc::String>::iterator j = find(m_advertised[transportIndex].begin(), m_advertised[transportIndex].end(), wkn[i]);
         if (j != m_advertised[transportIndex].end()) {
             m_advertised[transportIndex].erase(j);
+            m_advertisedIndex[transportIndex].erase(wkn[i]);
+            NoteAdvertisedChange(transportIndex, wkn[i], false);
             changed = true;
         }
 
         list<qcc::String>::iterator k = find(m_advertised_quietly[transportIndex].begin(), m_advertised_quietly[transportIndex].end(), wkn[i]);
         if (k != m_advertised_quietly[transportIndex].end()) {
             m_advertised_quietly[transportIndex].erase(k);
+            m_advertisedQuietlyIndex[transportIndex].erase(wkn[i]);
         }
     }
 
@@ -3310,6 +3615,53 @@ void IpNameServiceImpl::SendOutboundMessages(void)
     }
 }
 
+void IpNameServiceImpl::SendOutboundDatagrams(void)
+{
+    QCC_DbgPrintf(("IpNameServiceImpl::SendOutboundDatagrams()"));
+
+    //
+    // Send any datagrams we have queued for transmission.  We expect to be
+    // called with the mutex locked.  Datagrams are small and their whole point
+    // is getting to the listeners quickly, so unlike name service messages
+    // they are not throttled.  They only go out over the IANA multicast
+    // groups; there are no subnet directed broadcasts or legacy groups.
+    //
+    while (m_outboundDatagrams.size() && m_state == IMPL_RUNNING) {
+        OutboundDatagram& datagram = m_outboundDatagrams.front();
+
+        for (uint32_t i = 0; i < m_liveInterfaces.size(); ++i) {
+            if (m_liveInterfaces[i].m_sockFd == -1 || (m_liveInterfaces[i].m_flags & qcc::IfConfigEntry::MULTICAST) == 0) {
+                continue;
+            }
+
+            //
+            // The datagram goes out on an interface if any of its transports
+            // has the interface opened.
+            //
+            bool interfaceApproved = false;
+            for (uint32_t index = 0; index < N_TRANSPORTS && interfaceApproved == false; ++index) {
+                if ((datagram.m_transportMask & (1 << index)) && InterfaceRequested(index, i)) {
+                    interfaceApproved = true;
+                }
+            }
+            if (interfaceApproved == false) {
+                continue;
+            }
+
+            qcc::IPAddress group(m_liveInterfaces[i].m_address.IsIPv4() ? IPV4_ALLJOYN_MULTICAST_GROUP : IPV6_ALLJOYN_MULTICAST_GROUP);
+            QCC_DbgHLPrintf(("IpNameServiceImpl::SendOutboundDatagrams(): Sending to \"%s\" over \"%s\"",
+                             group.ToString().c_str(), m_liveInterfaces[i].m_interfaceName.c_str()));
+            size_t sent;
+            QStatus status = qcc::SendTo(m_liveInterfaces[i].m_sockFd, group, MULTICAST_PORT, &datagram.m_bytes[0], datagram.m_bytes.size(), sent);
+            if (status != ER_OK) {
+                QCC_LogError(status, ("IpNameServiceImpl::SendOutboundDatagrams(): Error sending to \"%s\"", group.ToString().c_str()));
+            }
+        }
+
+        m_outboundDatagrams.pop_front();
+    }
+}
+
 void* IpNameServiceImpl::Run(void* arg)
 {
     QCC_DbgPrintf(("IpNameServiceImpl::Run()"));
@@ -3340,16 +3692,20 @@ void* IpNameServiceImpl::Run(void* arg)
     uint8_t* buffer = new uint8_t[bufsize];
 
     //
-    // Instantiate an event that fires after one second, and once per second
-    // thereafter.  Used to drive protocol maintenance functions, especially
-    // dealing with interface state changes.
+    // Instantiate an event that fires after about one second, and once per
+    // second thereafter.  Used to drive protocol maintenance functions,
+    // especially dealing with interface state changes.  The first tick is
+    // lined up with the daemon's other housekeeping timers (see TimerSlack)
+    // so the periodic wakeups are shared.
     //
     const uint32_t MS_PER_SEC = 1000;
-    qcc::Event timerEvent(MS_PER_SEC, MS_PER_SEC);
+    qcc::Event timerEvent(TimerSlack::Coalesce(MS_PER_SEC), MS_PER_SEC);
 
     qcc::Timespec tNow, tLastLazyUpdate;
     GetTimeNow(&tLastLazyUpdate);
 
+    OpenInterfaceMonitor();
+
     while (m_state == IMPL_RUNNING || m_terminal) {
         //
         // If we are shutting down, we need to make sure that we send out the
@@ -3426,6 +3782,10 @@ void* IpNameServiceImpl::Run(void* arg)
         //     3) If LAZY_UPDATE_MAX_INTERVAL has elapsed since the last lazy
         //        update, we need to update.
         //
+        // If we have an interface monitor, a link or address change reported
+        // by the system sets m_forceLazyUpdate, so we react to a new network
+        // within one trip around this loop rather than on the next interval.
+        //
         if (m_forceLazyUpdate ||
             (m_outbound.size() && tLastLazyUpdate + qcc::Timespec(LAZY_UPDATE_MIN_INTERVAL * MS_PER_SEC) < tNow) ||
             (tLastLazyUpdate + qcc::Timespec(LAZY_UPDATE_MAX_INTERVAL * MS_PER_SEC) < tNow)) {
@@ -3436,7 +3796,16 @@ void* IpNameServiceImpl::Run(void* arg)
             m_forceLazyUpdate = false;
         }
 
+        //
+        // Retry any Locate requests that are due to ensure that those requests
+        // actually make it out on the wire.  Retries are scheduled on a
+        // millisecond back-off, so we also find out how long we can sleep
+        // before the next one is due.
+        //
+        uint32_t retryWaitMs = Retry();
+
         SendOutboundMessages();
+        SendOutboundDatagrams();
 
         //
         // We've emptied the outbound messages, so we're done if we are shutting
@@ -3467,6 +3836,9 @@ void* IpNameServiceImpl::Run(void* arg)
         checkEvents.push_back(&stopEvent);
         checkEvents.push_back(&timerEvent);
         checkEvents.push_back(&m_wakeEvent);
+        if (m_monitorEvent) {
+            checkEvents.push_back(m_monitorEvent);
+        }
 
         //
         // We also need to wait on events from all of the sockets that
@@ -3491,7 +3863,7 @@ void* IpNameServiceImpl::Run(void* arg)
         // Wait for something to happen.  if we get an error, there's not
         // much we can do about it but bail.
         //
-        QStatus status = qcc::Event::Wait(checkEvents, signaledEvents);
+        QStatus status = qcc::Event::Wait(checkEvents, signaledEvents, retryWaitMs);
         if (status != ER_OK && status != ER_TIMEOUT) {
             QCC_LogError(status, ("IpNameServiceImpl::Run(): Event::Wait(): Failed"));
             break;
@@ -3557,6 +3929,20 @@ void* IpNameServiceImpl::Run(void* arg)
                 // it.
                 //
                 m_wakeEvent.ResetEvent();
+            } else if (*i == m_monitorEvent) {
+                //
+                // The system is telling us about link or address changes.
+                // Drain the notifications and, if anything relevant changed,
+                // ask for a lazy update the next time through the loop.
+                //
+                if (ReadInterfaceMonitor()) {
+                    QCC_DbgPrintf(("IpNameServiceImpl::Run(): Interface change reported"));
+                    // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
+                    m_mutex.Lock();
+                    m_forceLazyUpdate = true;
+                    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+                    m_mutex.Unlock();
+                }
             } else {
                 QCC_DbgPrintf(("IpNameServiceImpl::Run(): Socket event fired"));
                 //
@@ -3607,37 +3993,72 @@ void* IpNameServiceImpl::Run(void* arg)
         }
     }
 
+    CloseInterfaceMonitor();
+
     delete [] buffer;
     return 0;
 }
 
-void IpNameServiceImpl::Retry(void)
+uint32_t IpNameServiceImpl::Jitter(uint32_t intervalMs)
 {
-    static uint32_t tick = 0;
+    uint32_t spread = intervalMs * m_retryJitterPercent / 100;
+    if (spread == 0) {
+        return intervalMs;
+    }
+    return intervalMs - spread + (rand() % (2 * spread + 1));
+}
 
+void IpNameServiceImpl::ScheduleRetry(Header& header)
+{
     //
-    // tick holds 136 years of ticks at one per second, so we don't worry about
-    // rolling over.
+    // Locate requests made while fast discovery is in effect start out with a
+    // short interval and a few more retries, so that a name that is out there
+    // is found within a second or so even if the first question or its
+    // answer collided with something on the air.  Both schedules back off
+    // exponentially so neither sustains a high multicast rate.
     //
-    ++tick;
+    bool fast = m_fastDiscoveryUntil && qcc::GetTimestamp64() < m_fastDiscoveryUntil;
+    uint32_t limit = fast ? std::max(m_fastRetries, m_retries) : m_retries;
+    uint32_t interval = fast ? m_fastIntervalMs : m_retryIntervalMs;
+
+    if (limit == 0) {
+        return;
+    }
+
+    header.SetRetries(0);
+    header.SetRetrySchedule(limit, interval);
+    header.SetRetryTick(qcc::GetTimestamp() + Jitter(interval));
+    m_retry.push_back(header);
+    m_wakeEvent.SetEvent();
+}
+
+void IpNameServiceImpl::RequestFastDiscovery(uint32_t durationMs)
+{
+    QCC_DbgHLPrintf(("IpNameServiceImpl::RequestFastDiscovery(%d)", durationMs));
+
+    // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
+    m_mutex.Lock();
+    uint64_t until = qcc::GetTimestamp64() + durationMs;
+    if (until > m_fastDiscoveryUntil) {
+        m_fastDiscoveryUntil = until;
+    }
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+}
+
+uint32_t IpNameServiceImpl::Retry(void)
+{
+    uint32_t now = qcc::GetTimestamp();
+    uint32_t next = qcc::Event::WAIT_FOREVER;
 
     //
-    // use Meyers' idiom to keep iterators sane.
+    // use Meyers' idiom to keep iterators sane.  Retry ticks are millisecond
+    // timestamps, so compare them by difference to survive the wrap.
     //
     for (list<Header>::iterator i = m_retry.begin(); (m_state == IMPL_RUNNING) && (i != m_retry.end());) {
-        uint32_t retryTick = (*i).GetRetryTick();
-
-        //
-        // If this is the first time we've seen this entry, set the first
-        // retry time.
-        //
-        if (retryTick == 0) {
-            (*i).SetRetryTick(tick + RETRY_INTERVAL);
-            ++i;
-            continue;
-        }
+        int32_t remaining = static_cast<int32_t>((*i).GetRetryTick() - now);
 
-        if (tick >= retryTick) {
+        if (remaining <= 0) {
             //
             // Send the message out over the multicast link (again).
             //
@@ -3646,17 +4067,25 @@ void IpNameServiceImpl::Retry(void)
             uint32_t count = (*i).GetRetries();
             ++count;
 
-            if (count == m_retries) {
+            if (count >= (*i).GetRetryLimit()) {
                 m_retry.erase(i++);
-            } else {
-                (*i).SetRetries(count);
-                (*i).SetRetryTick(tick + RETRY_INTERVAL);
-                ++i;
+                continue;
             }
-        } else {
-            ++i;
+
+            uint32_t interval = std::min((*i).GetRetryInterval() * 2, m_retryIntervalMaxMs);
+            (*i).SetRetries(count);
+            (*i).SetRetrySchedule((*i).GetRetryLimit(), interval);
+            remaining = Jitter(interval);
+            (*i).SetRetryTick(now + remaining);
+        }
+
+        if (static_cast<uint32_t>(remaining) < next) {
+            next = remaining;
         }
+        ++i;
     }
+
+    return next;
 }
 
 void IpNameServiceImpl::Retransmit(uint32_t transportIndex, bool exiting, bool quietly, const qcc::IPEndpoint& destination)
@@ -3706,218 +4135,116 @@ void IpNameServiceImpl::Retransmit(uint32_t transportIndex, bool exiting, bool q
     // of message.  Since the version is located in the message header, this
     // means two messages.
     //
-    // Put together and send response packets for version zero, but only if the
-    // transport index corresponds to TRANSPORT_TCP since that was the only
-    // possibility in version zero and keeping in mind that we aren't going to
-    // send version zero messages over our newly defined "quiet" mechanism.
+    // Version zero packets are only sent if the transport index corresponds to
+    // TRANSPORT_TCP since that was the only possibility in version zero, and
+    // we aren't going to send version zero messages over our newly defined
+    // "quiet" mechanism.
+    //
+    // Note that the number of packets that can go out in any given amount of
+    // time is effectively throttled in SendOutboundMessages() by a random
+    // delay.  A user can consume all available resources here by flooding us
+    // with advertisements but she will only be shooting herself in the foot.
     //
-    if (transportIndex == IndexFromBit(TRANSPORT_TCP) && quietly == false) {
+    bool sendVersionZero = (transportIndex == IndexFromBit(TRANSPORT_TCP)) && (quietly == false);
+
+    if (quietly == false && exiting == false) {
         //
-        // Keep track of how many messages we actually send in order to get all of
-        // the advertisements out.
+        // The periodic retransmission of the actively advertised names sends
+        // the same messages every time until something about them changes, so
+        // pack them once and keep them around.  The interface addresses are
+        // written in per interface on the way out, so the cached messages
+        // don't depend on which interfaces are live.
         //
-        uint32_t nSent = 0;
+        if (m_retransmitCacheValid[transportIndex] == false) {
+            QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Packing advertised names for transportIndex %d", transportIndex));
+            m_retransmitCache[transportIndex].clear();
+            if (sendVersionZero) {
+                PackIsAt(transportIndex, 0, m_advertised[transportIndex], NULL, m_tDuration, true, m_retransmitCache[transportIndex]);
+            }
+            PackIsAt(transportIndex, 1, m_advertised[transportIndex], NULL, m_tDuration, true, m_retransmitCache[transportIndex]);
+            m_retransmitCacheValid[transportIndex] = true;
+        }
 
+        for (list<Header>::iterator i = m_retransmitCache[transportIndex].begin(); i != m_retransmitCache[transportIndex].end(); ++i) {
+            QueueProtocolMessage(*i);
+        }
+    } else {
         //
-        // The header will tie the whole protocol message together.  By setting the
-        // timer, we are asking for everyone who hears the message to remember the
+        // The header timer asks everyone who hears the message to remember the
         // advertisements for that number of seconds.  If we are exiting, then we
         // set the timer to zero, which means that the name is no longer valid.
+        // Since we want to allow passive observers to hear our responses, quiet
+        // responses carry the actively advertised names as well as the quiet ones.
         //
-        Header header;
-
-        //
-        // We understand all messages from version zero to version one, and we
-        // are sending a version zero message.  The whole point of sending a
-        // version zero message is that can be understood by down-level code
-        // so we can't use the new versioning scheme.
-        //
-        header.SetVersion(0, 0);
-
-        header.SetTimer(exiting ? 0 : m_tDuration);
-
-        IsAt isAt;
-        isAt.SetVersion(0, 0);
-
-        //
-        // We don't actually send the transport mask in version zero packets
-        // but we make a note to ourselves to let us know on behalf of what
-        // transport we will be sending.
-        //
-        isAt.SetTransportMask(MaskFromIndex(transportIndex));
-
-        //
-        // The Complete Flag tells the other side that the message it recieves
-        // contains the complete list of well-known names advertised by the
-        // source.  We don't know that we fit them all in yet, so this must be
-        // initialized to false.
-        //
-        isAt.SetCompleteFlag(false);
-
-        //
-        // We have to use some sneaky way to tell an in-the know version one
-        // client that the packet is from a version one client and that is
-        // through the setting of the UDP flag.  TCP transports are the only
-        // possibility for version zero packets and it always sets the TCP
-        // flag, of course.
-        //
-        isAt.SetTcpFlag(true);
-        isAt.SetUdpFlag(true);
-
-        isAt.SetGuid(m_guid);
-
-        //
-        // The only possibility in version zero is that the port is the IPv4
-        // reliable port.
-        //
-        isAt.SetPort(m_reliableIPv4Port[transportIndex]);
-
-        QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Loop through advertised names"));
-
-        //
-        // Loop through the list of names we are advertising, constructing as many
-        // protocol messages as it takes to get our list of advertisements out.
-        //
-        // Note that the number of packets that can go out in any given amount of
-        // time is effectively throttled in SendProtocolMessage() by a random delay.
-        // A user can consume all available resources here by flooding us with
-        // advertisements but she will only be shooting herself in the foot.
-        //
-        for (list<qcc::String>::iterator i = m_advertised[transportIndex].begin(); i != m_advertised[transportIndex].end(); ++i) {
-            QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Accumulating \"%s\"", (*i).c_str()));
-
-            //
-            // It is possible that we have accumulated more advertisements than will
-            // fit in a UDP IpNameServiceImpl packet.  A name service is-at message is going
-            // to consist of a header and its answer section, which is made from an
-            // IsAt object.  We first ask both of these objects to return their size
-            // so we know how much space is committed already.  Note that we ask the
-            // header for its max possible size since the header may be modified to
-            // add actual IPv4 and IPv6 addresses when it is sent.
-            //
-            size_t currentSize = header.GetSerializedSize() + isAt.GetSerializedSize();
-
-            //
-            // This isn't terribly elegant, but we don't know the IP address(es)
-            // over which the message will be sent.  These are added in the loop
-            // that actually does the packet sends, with the interface addresses
-            // dynamically added onto the message.  We have no clue here if an IPv4
-            // or IPv6 or both flavors of address will exist on a given interface,
-            // nor how many interfaces there are.  All we can do here is to assume
-            // the worst case for the size (both exist) and add the 20 bytes (four
-            // for IPv4, sixteen for IPv6) that the addresses may consume in the
-            // final packet.
-            //
-            currentSize += 20;
-
-            //
-            // We cheat a little in order to avoid a string copy and use our
-            // knowledge that names are stored as a byte count followed by the
-            // string bytes.  If the current name won't fit into the currently
-            // assembled message, we need to flush the current message and start
-            // again.
-            //
-            if (currentSize + 1 + (*i).size() > NS_MESSAGE_MAX) {
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message is full"));
-                //
-                // The current message cannot hold another name.  We need to send it
-                // out before continuing.
-                //
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Sending partial list"));
-                header.AddAnswer(isAt);
-
-                if (quietly) {
-                    header.SetDestination(destination);
-                } else {
-                    header.ClearDestination();
-                }
-
-                QueueProtocolMessage(header);
-                ++nSent;
+        uint32_t timer = exiting ? 0 : m_tDuration;
+        list<Header> messages;
+        if (sendVersionZero) {
+            PackIsAt(transportIndex, 0, m_advertised[transportIndex], NULL, timer, true, messages);
+        }
+        PackIsAt(transportIndex, 1, m_advertised[transportIndex], quietly ? &m_advertised_quietly[transportIndex] : NULL, timer, true, messages);
 
-                //
-                // The full message is now on the way out.  Now, we remove all of
-                // the entries in the IsAt object, reset the header, which clears
-                // out the existing is-at, and start accumulating new names again.
-                //
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Resetting current list"));
-                header.Reset();
-                isAt.Reset();
-                isAt.AddName(*i);
+        for (list<Header>::iterator i = messages.begin(); i != messages.end(); ++i) {
+            uint32_t nsVersion, msgVersion;
+            i->GetVersion(nsVersion, msgVersion);
+            if (quietly && msgVersion != 0) {
+                i->SetDestination(destination);
             } else {
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message has room.  Adding \"%s\"", (*i).c_str()));
-                isAt.AddName(*i);
+                i->ClearDestination();
             }
+            QueueProtocolMessage(*i);
         }
+    }
 
-        //
-        // We most likely have a partially full message waiting to go out.  If we
-        // haven't sent a message, then the one message holds all of the names that
-        // are being advertised.  In this case, we set the complete flag to indicate
-        // that this packet describes the full extent of advertised well known
-        // names.
-        //
-        if (nSent == 0) {
-            QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Single complete message "));
-            isAt.SetCompleteFlag(true);
-        }
-
-        QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Sending final version zero message "));
-        header.AddAnswer(isAt);
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+}
 
-        header.ClearDestination();
-        QueueProtocolMessage(header);
-    }
+void IpNameServiceImpl::PackIsAt(uint32_t transportIndex, uint32_t version,
+                                 const list<qcc::String>& names, const list<qcc::String>* quietNames,
+                                 uint32_t timer, bool complete, list<Header>& messages)
+{
+    Header header;
 
     //
-    // Put together and send response packets for version one.
+    // We understand all messages from version zero to version one.  The
+    // whole point of sending a version zero message is that can be understood
+    // by down-level code so we can't use the new versioning scheme.
     //
-    {
-        //
-        // Keep track of how many messages we actually send in order to get all of
-        // the advertisements out.
-        //
-        uint32_t nSent = 0;
-
-        //
-        // The header will tie the whole protocol message together.  By setting the
-        // timer, we are asking for everyone who hears the message to remember the
-        // advertisements for that number of seconds.  If we are exiting, then we
-        // set the timer to zero, which means that the name is no longer valid.
-        //
-        Header header;
-
-        //
-        // We understand all messages from version zero to version one, and we
-        // are sending a version one message;
-        //
-        header.SetVersion(1, 1);
+    header.SetVersion(version, version);
+    header.SetTimer(timer);
 
-        header.SetTimer(exiting ? 0 : m_tDuration);
+    IsAt isAt;
+    isAt.SetVersion(version, version);
 
-        //
-        // The underlying protocol is capable of identifying both TCP and UDP
-        // services.  Right now, the only possibility is TCP.
-        //
-        IsAt isAt;
+    //
+    // We don't actually send the transport mask in version zero packets but
+    // we make a note to ourselves to let us know on behalf of what transport
+    // we will be sending.
+    //
+    isAt.SetTransportMask(MaskFromIndex(transportIndex));
 
-        //
-        // We understand all messages from version zero to version one, and we
-        // are sending a version one message;
-        //
-        isAt.SetVersion(1, 1);
+    //
+    // We don't know if this is going to be a complete and final list yet.
+    //
+    isAt.SetCompleteFlag(false);
 
+    if (version == 0) {
         //
-        // We don't know if this is going to be a complete and final list yet,
-        // but we do know which transport we are doing this on behalf of.
+        // We have to use some sneaky way to tell an in-the know version one
+        // client that the packet is from a version one client and that is
+        // through the setting of the UDP flag.  TCP transports are the only
+        // possibility for version zero packets and it always sets the TCP
+        // flag, of course.  The only possibility in version zero is that the
+        // port is the IPv4 reliable port.
         //
-        isAt.SetCompleteFlag(false);
-        isAt.SetTransportMask(MaskFromIndex(transportIndex));
-
+        isAt.SetTcpFlag(true);
+        isAt.SetUdpFlag(true);
+        isAt.SetPort(m_reliableIPv4Port[transportIndex]);
+    } else {
         //
-        // Version one allows us to provide four possible endpoints.  The address
-        // will be rewritten on the way out with the address of the appropriate
-        // interface.
+        // Version one allows us to provide four possible endpoints.  The
+        // address will be rewritten on the way out with the address of the
+        // appropriate interface.
         //
         if (m_reliableIPv4Port[transportIndex]) {
             isAt.SetReliableIPv4("", m_reliableIPv4Port[transportIndex]);
@@ -3931,145 +4258,107 @@ void IpNameServiceImpl::Retransmit(uint32_t transportIndex, bool exiting, bool q
         if (m_unreliableIPv6Port[transportIndex]) {
             isAt.SetUnreliableIPv6("", m_unreliableIPv6Port[transportIndex]);
         }
+    }
 
-        isAt.SetGuid(m_guid);
-
-        QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Loop through advertised names"));
-
-        //
-        // Loop through the list of names we are advertising, constructing as many
-        // protocol messages as it takes to get our list of advertisements out.
-        //
-        // Note that the number of packets that can go out in any given amount of
-        // time is effectively throttled in SendProtocolMessage() by a random delay.
-        // A user can consume all available resources here by flooding us with
-        // advertisements but she will only be shooting herself in the foot.
-        //
-        for (list<qcc::String>::iterator i = m_advertised[transportIndex].begin(); i != m_advertised[transportIndex].end(); ++i) {
-            QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Accumulating \"%s\"", (*i).c_str()));
-
-            //
-            // It is possible that we have accumulated more advertisements than will
-            // fit in a UDP IpNameServiceImpl packet.  A name service is-at message is going
-            // to consist of a header and its answer section, which is made from an
-            // IsAt object.  We first ask both of these objects to return their size
-            // so we know how much space is committed already.  Note that we ask the
-            // header for its max possible size since the header may be modified to
-            // add actual IPv4 and IPv6 addresses when it is sent.
-            //
-            size_t currentSize = header.GetSerializedSize() + isAt.GetSerializedSize();
+    isAt.SetGuid(m_guid);
 
-            //
-            // This isn't terribly elegant, but we don't know the IP address(es)
-            // over which the message will be sent.  These are added in the loop
-            // that actually does the packet sends, with the interface addresses
-            // dynamically added onto the message.  We have no clue here if an IPv4
-            // or IPv6 or both flavors of address will exist on a given interface,
-            // nor how many interfaces there are.  All we can do here is to assume
-            // the worst case for the size (both exist) and add the 20 bytes (four
-            // for IPv4, sixteen for IPv6) that the addresses may consume in the
-            // final packet.
-            //
-            currentSize += 20;
+    //
+    // Work out the size of a message without any names once, rather than
+    // re-serializing the growing message for every name.  We know that names
+    // are stored as a byte count followed by the string bytes.  We don't know
+    // the IP address(es) over which the message will be sent, so we assume the
+    // worst case (both exist) and add the 20 bytes (four for IPv4, sixteen for
+    // IPv6) that the addresses may consume in the final packet.
+    //
+    const size_t emptySize = header.GetSerializedSize() + isAt.GetSerializedSize() + 20;
+    size_t currentSize = emptySize;
+    uint32_t nSent = 0;
 
+    const list<qcc::String>* lists[2] = { &names, quietNames };
+    for (uint32_t l = 0; l < 2; ++l) {
+        if (lists[l] == NULL) {
+            continue;
+        }
+        for (list<qcc::String>::const_iterator i = lists[l]->begin(); i != lists[l]->end(); ++i) {
             //
-            // We cheat a little in order to avoid a string copy and use our
-            // knowledge that names are stored as a byte count followed by the
-            // string bytes.  If the current name won't fit into the currently
-            // assembled message, we need to flush the current message and start
-            // again.
+            // If the current name won't fit into the currently assembled
+            // message, we need to flush the current message and start again.
             //
-            if (currentSize + 1 + (*i).size() > NS_MESSAGE_MAX) {
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message is full"));
-                //
-                // The current message cannot hold another name.  We need to send it
-                // out before continuing.
-                //
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Sending partial list"));
+            if ((currentSize + 1 + (*i).size() > NS_MESSAGE_MAX) && isAt.GetNumberNames()) {
+                QCC_DbgPrintf(("IpNameServiceImpl::PackIsAt(): Message is full"));
                 header.AddAnswer(isAt);
-
-                if (quietly) {
-                    header.SetDestination(destination);
-                } else {
-                    header.ClearDestination();
-                }
-
-                QueueProtocolMessage(header);
+                messages.push_back(header);
                 ++nSent;
 
-                //
-                // The full message is now on the way out.  Now, we remove all of
-                // the entries in the IsAt object, reset the header, which clears
-                // out the existing is-at, and start accumulating new names again.
-                //
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Resetting current list"));
                 header.Reset();
                 isAt.Reset();
-                isAt.AddName(*i);
-            } else {
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message has room.  Adding \"%s\"", (*i).c_str()));
-                isAt.AddName(*i);
+                currentSize = emptySize;
             }
+            isAt.AddName(*i);
+            currentSize += 1 + (*i).size();
         }
+    }
+
+    //
+    // If we haven't sent a message, then the one message holds all of the
+    // names.  If those are all of the names being advertised we set the
+    // complete flag to indicate that this packet describes the full extent of
+    // advertised well known names.
+    //
+    if (complete && nSent == 0) {
+        isAt.SetCompleteFlag(true);
+    }
+
+    header.AddAnswer(isAt);
+    messages.push_back(header);
+}
 
-        if (quietly) {
-            for (list<qcc::String>::iterator i = m_advertised_quietly[transportIndex].begin(); i != m_advertised_quietly[transportIndex].end(); ++i) {
-                QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Accumulating (quiet) \"%s\"", (*i).c_str()));
+void IpNameServiceImpl::NoteAdvertisedChange(uint32_t transportIndex, const qcc::String& name, bool added)
+{
+    list<qcc::String>& from = added ? m_deltaRemoved[transportIndex] : m_deltaAdded[transportIndex];
+    list<qcc::String>& to = added ? m_deltaAdded[transportIndex] : m_deltaRemoved[transportIndex];
 
-                size_t currentSize = header.GetSerializedSize() + isAt.GetSerializedSize();
-                currentSize += 20;
+    from.remove(name);
+    if (find(to.begin(), to.end(), name) == to.end()) {
+        to.push_back(name);
+    }
 
-                if (currentSize + 1 + (*i).size() > NS_MESSAGE_MAX) {
-                    QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message is full"));
-                    QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Sending partial list"));
-                    header.AddAnswer(isAt);
+    m_retransmitCacheValid[transportIndex] = false;
 
-                    if (quietly) {
-                        header.SetDestination(destination);
-                    } else {
-                        header.ClearDestination();
-                    }
+    if (m_deltaTimer == 0) {
+        m_deltaTimer = DELTA_RETRANSMIT_TIME;
+    }
+}
 
-                    QueueProtocolMessage(header);
-                    ++nSent;
+void IpNameServiceImpl::RetransmitDeltas(void)
+{
+    for (uint32_t index = 0; index < N_TRANSPORTS; ++index) {
+        bool sendVersionZero = (index == IndexFromBit(TRANSPORT_TCP));
+        list<Header> messages;
 
-                    QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Resetting current list"));
-                    header.Reset();
-                    isAt.Reset();
-                    isAt.AddName(*i);
-                } else {
-                    QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Message has room.  Adding (quiet) \"%s\"", (*i).c_str()));
-                    isAt.AddName(*i);
-                }
+        if (m_deltaAdded[index].size()) {
+            if (sendVersionZero) {
+                PackIsAt(index, 0, m_deltaAdded[index], NULL, m_tDuration, false, messages);
             }
+            PackIsAt(index, 1, m_deltaAdded[index], NULL, m_tDuration, false, messages);
+            m_deltaAdded[index].clear();
         }
 
         //
-        // We most likely have a partially full message waiting to go out.  If we
-        // haven't sent a message, then the one message holds all of the names that
-        // are being advertised.  In this case, we set the complete flag to indicate
-        // that this packet describes the full extent of advertised well known
-        // names.
+        // A timer of zero tells the receivers the names are no longer valid.
         //
-        if (nSent == 0) {
-            QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Single complete message "));
-            isAt.SetCompleteFlag(true);
+        if (m_deltaRemoved[index].size()) {
+            if (sendVersionZero) {
+                PackIsAt(index, 0, m_deltaRemoved[index], NULL, 0, false, messages);
+            }
+            PackIsAt(index, 1, m_deltaRemoved[index], NULL, 0, false, messages);
+            m_deltaRemoved[index].clear();
         }
 
-        QCC_DbgPrintf(("IpNameServiceImpl::Retransmit(): Sending final message "));
-        header.AddAnswer(isAt);
-
-        if (quietly) {
-            header.SetDestination(destination);
-        } else {
-            header.ClearDestination();
+        for (list<Header>::iterator i = messages.begin(); i != messages.end(); ++i) {
+            QueueProtocolMessage(*i);
         }
-
-        QueueProtocolMessage(header);
     }
-
-    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
-    m_mutex.Unlock();
 }
 
 void IpNameServiceImpl::DoPeriodicMaintenance(void)
@@ -4080,12 +4369,6 @@ void IpNameServiceImpl::DoPeriodicMaintenance(void)
     // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
     m_mutex.Lock();
 
-    //
-    // Retry all Locate requests to ensure that those requests actually make
-    // it out on the wire.
-    //
-    Retry();
-
     //
     // If we have something exported, we will have a retransmit timer value
     // set.  If not, this value will be zero and there's nothing to be done.
@@ -4101,6 +4384,18 @@ void IpNameServiceImpl::DoPeriodicMaintenance(void)
         }
     }
 
+    //
+    // Names that were added or removed a little while ago go out a second
+    // time so that a single lost announcement doesn't leave remote daemons
+    // stale until the next full retransmission.
+    //
+    if (m_deltaTimer) {
+        if (--m_deltaTimer == 0) {
+            QCC_DbgPrintf(("IpNameServiceImpl::DoPeriodicMaintenance(): RetransmitDeltas()"));
+            RetransmitDeltas();
+        }
+    }
+
     // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
     m_mutex.Unlock();
 }
@@ -4162,42 +4457,17 @@ void IpNameServiceImpl::HandleProtocolQuestion(WhoHas whoHas, const qcc::IPEndpo
             }
 
             //
-            // check to see if this name on the list of names we actively advertise.
+            // Check to see if this name matches any of the names we actively
+            // or quietly advertise.
             //
-            for (list<qcc::String>::iterator j = m_advertised[index].begin(); j != m_advertised[index].end(); ++j) {
-
-                //
-                // The requested name comes in from the WhoHas message and we
-                // allow wildcards there.
-                //
-                if (IpNameServiceImplWildcardMatch((*j), wkn)) {
-                    QCC_DbgPrintf(("IpNameServiceImpl::HandleProtocolQuestion(): request for %s does not match my %s",
-                                   wkn.c_str(), (*j).c_str()));
-                    continue;
-                } else {
-                    respond = true;
-                    break;
-                }
+            if (IpNameServiceImplAnyMatch(m_advertisedIndex[index], wkn)) {
+                respond = true;
             }
 
-            //
-            // Check to see if this name on the list of names we quietly advertise.
-            //
-            for (list<qcc::String>::iterator j = m_advertised_quietly[index].begin(); j != m_advertised_quietly[index].end(); ++j) {
-
-                //
-                // The requested name comes in from the WhoHas message and we
-                // allow wildcards there.
-                //
-                if (IpNameServiceImplWildcardMatch((*j), wkn)) {
-                    QCC_DbgPrintf(("IpNameServiceImpl::HandleProtocolQuestion(): request for %s does not match my %s",
-                                   wkn.c_str(), (*j).c_str()));
-                    continue;
-                } else {
-                    respond = true;
-                    respondQuietly = true;
-                    break;
-                }
+            if (IpNameServiceImplAnyMatch(m_advertisedQuietlyIndex[index], wkn)) {
+                respond = true;
+                respondQuietly = true;
+                break;
             }
         }
 
@@ -4205,6 +4475,31 @@ void IpNameServiceImpl::HandleProtocolQuestion(WhoHas whoHas, const qcc::IPEndpo
         // Since any response we send must include all of the advertisements we
         // are exporting; this just means to retransmit all of our advertisements.
         //
+        //
+        // Many daemons starting up together, or one in fast discovery, can ask
+        // about our names several times a second.  Everyone hears a multicast
+        // answer, so if we multicast one very recently we hold off and let
+        // the holdoff grow while the questions keep coming.  Quiet answers go
+        // to the one daemon that asked, so they are never held off.
+        //
+        if (respond && respondQuietly == false && m_answerHoldoffMs) {
+            uint64_t now = qcc::GetTimestamp64();
+            uint64_t since = now - m_lastAnswer[index];
+            if (m_answerHoldoff[index] == 0) {
+                m_answerHoldoff[index] = m_answerHoldoffMs;
+            }
+            if (m_lastAnswer[index] && since < m_answerHoldoff[index]) {
+                QCC_DbgPrintf(("IpNameServiceImpl::HandleProtocolQuestion(): Holding off answer for transport %d", index));
+                m_answerHoldoff[index] = std::min(m_answerHoldoff[index] * 2, m_answerHoldoffMaxMs);
+                respond = false;
+            } else {
+                if (since >= 2 * m_answerHoldoff[index]) {
+                    m_answerHoldoff[index] = m_answerHoldoffMs;
+                }
+                m_lastAnswer[index] = now;
+            }
+        }
+
         if (respond) {
             // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
             m_mutex.Unlock();
@@ -4561,6 +4856,15 @@ void IpNameServiceImpl::HandleProtocolMessage(uint8_t const* buffer, uint32_t nb
     }
 #endif
 
+    //
+    // Datagrams share our sockets but are not name service messages, so pull
+    // them out before trying to find a header.
+    //
+    if (nbytes && (buffer[0] & 0xf) == DATAGRAM_MSG_VERSION) {
+        HandleDatagram(buffer, nbytes, endpoint);
+        return;
+    }
+
     Header header;
     size_t bytesRead = header.Deserialize(buffer, nbytes);
     if (bytesRead != nbytes) {
@@ -4610,6 +4914,25 @@ void IpNameServiceImpl::HandleProtocolMessage(uint8_t const* buffer, uint32_t nb
     }
 }
 
+void IpNameServiceImpl::HandleDatagram(uint8_t const* buffer, uint32_t nbytes, const qcc::IPEndpoint& endpoint)
+{
+    QCC_DbgPrintf(("IpNameServiceImpl::HandleDatagram(%d, %s)", nbytes, endpoint.ToString().c_str()));
+
+    // printf("%s: m_mutex.Lock()\n", __FUNCTION__);
+    m_mutex.Lock();
+    if (m_datagramCallback && nbytes > 1) {
+        m_protect_callback = true;
+        m_mutex.Unlock();
+
+        (*m_datagramCallback)(buffer + 1, nbytes - 1);
+
+        m_mutex.Lock();
+        m_protect_callback = false;
+    }
+    // printf("%s: m_mutex.Unlock()\n", __FUNCTION__);
+    m_mutex.Unlock();
+}
+
 QStatus IpNameServiceImpl::Start()
 {
     QCC_DbgPrintf(("IpNameServiceImpl::Start()"));
@@ -4617,6 +4940,7 @@ QStatus IpNameServiceImpl::Start()
     m_mutex.Lock();
     assert(IsRunning() == false);
     m_state = IMPL_RUNNING;
+    m_fastDiscoveryUntil = m_fastDiscoveryStartupMs ? qcc::GetTimestamp64() + m_fastDiscoveryStartupMs : 0;
     QCC_DbgPrintf(("IpNameServiceImpl::Start(): Starting thread"));
     QStatus status = Thread::Start(this);
     QCC_DbgPrintf(("IpNameServiceImpl::Start(): Started"));
@@ -28,6 +28,7 @@
 
 #include <vector>
 #include <list>
+#include <set>
 
 #include <qcc/String.h>
 #include <qcc/Thread.h>
@@ -82,15 +83,22 @@ class IpNameServiceImpl : public qcc::Thread {
 
     /**
      * @brief The time at which an advertising daemon will retransmit its
-     * advertisements.  The advertising daemon should retransmit three
-     * times during a default advertisement lifetime.  The 2/3 is really
-     * two thirds.  This means that when the countdown time reaches two thirds
-     * of the default duration value, one third of the time has expired and we
-     * will retransmit.  This, in turn, means we retransmit twice before a
-     * remote daemon times out an entry since the timer is set to back to
-     * DEFAULT_DURATION after every retransmission.  Units are seconds.
+     * complete list of advertisements.  When the countdown time reaches one
+     * half of the default duration value, half of the time has expired and we
+     * will retransmit.  This means we retransmit once before a remote daemon
+     * times out an entry since the timer is set to back to DEFAULT_DURATION
+     * after every retransmission.  Changes to the list are not left to this
+     * full refresh; they are announced immediately and again after
+     * DELTA_RETRANSMIT_TIME.  Units are seconds.
      */
-    static const uint32_t RETRANSMIT_TIME = (DEFAULT_DURATION * 2 / 3);
+    static const uint32_t RETRANSMIT_TIME = (DEFAULT_DURATION / 2);
+
+    /**
+     * @brief The time after a change to the advertised names at which the
+     * names added and removed since the change are announced a second time,
+     * in case the first announcement was lost.  Units are seconds.
+     */
+    static const uint32_t DELTA_RETRANSMIT_TIME = 5;
 
     /**
      * @brief The time at which a daemon using an advertisement begins to think
@@ -120,14 +128,50 @@ class IpNameServiceImpl : public qcc::Thread {
      * for the next successful retransmission of exported names, we resend
      * each Locate request this many times.
      */
-    static const uint32_t NUMBER_RETRIES = 2;
+    static const uint32_t NUMBER_RETRIES = 3;
 
     /**
-     * The time value indicating the time between Locate retries.  Units are
-     * seconds.
+     * The time value indicating the maximum time between Locate retries.  Units
+     * are seconds.
      */
     static const uint32_t RETRY_INTERVAL = 5;
 
+    /**
+     * The time between a Locate request and its first retry.  The interval
+     * doubles with every retry up to RETRY_INTERVAL.  Units are milliseconds.
+     */
+    static const uint32_t RETRY_INTERVAL_INITIAL_MS = 1000;
+
+    /**
+     * The amount by which retry intervals are randomly
+     * lengthened or shortened so that daemons that start together don't keep
+     * colliding on the air.  Units are percent of the interval.
+     */
+    static const uint32_t RETRY_JITTER_PERCENT = 25;
+
+    /**
+     * The number of retries and the time before the first retry of Locate
+     * requests made while fast discovery is in effect.  Units are milliseconds.
+     */
+    static const uint32_t FAST_DISCOVERY_RETRIES = 5;
+    static const uint32_t FAST_DISCOVERY_INTERVAL_MS = 200;
+
+    /**
+     * How long fast discovery is in effect after the name service starts, to
+     * cover the Locate requests an application makes when it starts up.  Units
+     * are milliseconds.
+     */
+    static const uint32_t FAST_DISCOVERY_STARTUP_MS = 5000;
+
+    /**
+     * When who-has questions for our names arrive closer together than this we
+     * only multicast an answer to the first; the others will have heard it.
+     * The holdoff doubles while questions keep arriving inside it, up to
+     * ANSWER_HOLDOFF_MAX_MS.  Units are milliseconds.
+     */
+    static const uint32_t ANSWER_HOLDOFF_MS = 100;
+    static const uint32_t ANSWER_HOLDOFF_MAX_MS = 1600;
+
     /**
      * The modulus indicating the minimum time between interface lazy updates.
      * Units are seconds.
@@ -173,6 +217,13 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     static const size_t NS_MESSAGE_MAX = (1454);
 
+    /**
+     * @brief The largest payload that can be sent with SendDatagram().  One
+     * octet of the name service message is taken by the version octet that
+     * marks the message as a datagram.
+     */
+    static const size_t DATAGRAM_MAX = NS_MESSAGE_MAX - 1;
+
     /**
      * @brief Which protocol is of interest.  When making discovery calls, the
      * client must choose whether it is interested in IPv4 or IPv6 addresses.
@@ -237,6 +288,20 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     QStatus Join();
 
+    /**
+     * @brief Use the fast discovery retry schedule for Locate requests made in
+     * the next durationMs milliseconds.
+     *
+     * Fast discovery retries who-has questions several times within the first
+     * second or so, which is what an application wants when it starts up and
+     * has nothing to show its user yet.  It is not meant to be left on; the
+     * request lapses on its own and later Locate requests revert to the normal
+     * back-off.
+     *
+     * @param durationMs How long fast discovery should stay in effect.
+     */
+    void RequestFastDiscovery(uint32_t durationMs);
+
     /**
      * @brief Provide parameters to define the general operation of the protocol.
      *
@@ -626,6 +691,41 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     void ClearCallbacks(void);
 
+    /**
+     * @brief Set the callback function that is called with the payload of each
+     * datagram received over the name service multicast groups.
+     *
+     * Datagrams are sent with SendDatagram() by this name service or by any
+     * other name service on the link, including a copy of our own datagrams
+     * looped back by the network stack, so the receiver must recognize and
+     * drop those it sent itself.  As with the found callback, the callback is
+     * made on the name service thread.
+     *
+     * @param[in] cb The Callback pointer, or NULL to stop notifications.
+     *
+     * @return Status of the operation.  Returns ER_OK on success.
+     */
+    QStatus SetDatagramCallback(Callback<void, const uint8_t*, size_t>* cb);
+
+    /**
+     * @brief Multicast an opaque datagram over the interfaces opened by the
+     * specified transports.
+     *
+     * Datagrams carry a version octet that older name services reject, so
+     * they are silently ignored by daemons that do not understand them. They
+     * are sent at most once on each interface and are never retransmitted, so
+     * any loss must be detected and handled by the user of the datagrams.
+     *
+     * @param transportMask A bitmask containing the transports whose opened
+     *     interfaces the datagram is sent out on.
+     * @param buf The payload to send.
+     * @param len The length of the payload, at most DATAGRAM_MAX octets.
+     *
+     * @return Status of the operation.  Returns ER_OK if the datagram was
+     *     queued for sending.
+     */
+    QStatus SendDatagram(TransportMask transportMask, const uint8_t* buf, size_t len);
+
     /**
      * @brief Advertise an AllJoyn daemon service.
      *
@@ -936,6 +1036,13 @@ class IpNameServiceImpl : public qcc::Thread {
         Header& header,
         uint32_t interfaceIndex);
 
+    /**
+     * @internal
+     * @brief Send the queued datagrams out on the multicast groups of the live
+     * interfaces requested by their transports.
+     */
+    void SendOutboundDatagrams(void);
+
     /**
      * @internal
      * @brief Is the interface specified by the liveIndex an interface requested
@@ -1008,12 +1115,23 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     void HandleProtocolAnswer(IsAt isAt, uint32_t timer, const qcc::IPEndpoint& address);
 
+    /**
+     * @internal
+     * @brief Pass a received datagram on to the datagram callback.
+     */
+    void HandleDatagram(uint8_t const* buffer, uint32_t nbytes, const qcc::IPEndpoint& endpoint);
+
     /**
      * One possible callback for each of the corresponding transport masks in a
      * sixteen-bit word.
      */
     Callback<void, const qcc::String&, const qcc::String&, std::vector<qcc::String>&, uint8_t>* m_callback[N_TRANSPORTS];
 
+    /**
+     * The callback for received datagrams.
+     */
+    Callback<void, const uint8_t*, size_t>* m_datagramCallback;
+
     /**
      * @internal @brief A vector of list of all of the names that the various
      * transports have actively advertised.
@@ -1026,6 +1144,14 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     std::list<qcc::String> m_advertised_quietly[N_TRANSPORTS];
 
+    /**
+     * @internal @brief Ordered indices of m_advertised and
+     * m_advertised_quietly used to answer who-has questions with a binary
+     * search instead of a walk over the lists.  Kept in step with the lists.
+     */
+    std::set<qcc::String> m_advertisedIndex[N_TRANSPORTS];
+    std::set<qcc::String> m_advertisedQuietlyIndex[N_TRANSPORTS];
+
     /**
      * @internal
      * @brief The daemon GUID string of the daemon assoicated with this instance
@@ -1140,6 +1266,76 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     void Retransmit(uint32_t index, bool exiting, bool quietly, const qcc::IPEndpoint& destination);
 
+    /**
+     * @internal
+     * @brief Pack a list of names into as few is-at messages as will hold
+     * them.
+     *
+     * @param transportIndex The transport the names are advertised on.
+     * @param version        The message version (0 or 1) to build.
+     * @param names          The names.
+     * @param quietNames     Further names to append or NULL.
+     * @param timer          The timer to put in the message headers.
+     * @param complete       True if the names are the whole list for the
+     *                       transport, in which case a single resulting
+     *                       message is flagged as complete.
+     * @param messages       [OUT] The messages are appended here.
+     */
+    void PackIsAt(uint32_t transportIndex, uint32_t version,
+                  const std::list<qcc::String>& names, const std::list<qcc::String>* quietNames,
+                  uint32_t timer, bool complete, std::list<Header>& messages);
+
+    /**
+     * @internal
+     * @brief Record that an actively advertised name was added or removed
+     * so it goes out again in the next delta retransmission.  Must be called
+     * with m_mutex held.
+     */
+    void NoteAdvertisedChange(uint32_t transportIndex, const qcc::String& name, bool added);
+
+    /**
+     * @internal
+     * @brief Retransmit the names added and removed since the last delta
+     * retransmission.  Must be called with m_mutex held.
+     */
+    void RetransmitDeltas(void);
+
+    /**
+     * @internal
+     * @brief The packed is-at messages for the periodic retransmission of
+     * each transport's actively advertised names.  Only valid if the
+     * corresponding entry of m_retransmitCacheValid is true.
+     */
+    std::list<Header> m_retransmitCache[N_TRANSPORTS];
+
+    /**
+     * @internal
+     * @brief False when the names, ports, GUID or duration of a transport
+     * have changed since its m_retransmitCache entry was built.
+     */
+    bool m_retransmitCacheValid[N_TRANSPORTS];
+
+    /**
+     * @internal
+     * @brief Actively advertised names added since the last delta
+     * retransmission.
+     */
+    std::list<qcc::String> m_deltaAdded[N_TRANSPORTS];
+
+    /**
+     * @internal
+     * @brief Actively advertised names removed since the last delta
+     * retransmission.
+     */
+    std::list<qcc::String> m_deltaRemoved[N_TRANSPORTS];
+
+    /**
+     * @internal
+     * @brief The time remaining before the pending delta retransmission, or
+     * zero if there is none.
+     */
+    uint32_t m_deltaTimer;
+
     /**
      * @internal
      * @brief Vector of name service messages reflecting recent locate
@@ -1151,9 +1347,27 @@ class IpNameServiceImpl : public qcc::Thread {
 
     /**
      * @internal
-     * @brief Retry locate requests.
+     * @brief Retry locate requests that are due.
+     *
+     * @return The number of milliseconds until the next retry is due, or
+     *         qcc::Event::WAIT_FOREVER if there are none.
+     */
+    uint32_t Retry(void);
+
+    /**
+     * @internal
+     * @brief Put a locate request on the retry list with the first retry at
+     * the start of the current retry schedule.  Must be called with m_mutex
+     * held.
      */
-    void Retry(void);
+    void ScheduleRetry(Header& header);
+
+    /**
+     * @internal
+     * @brief Randomly lengthen or shorten an interval by up to
+     * m_retryJitterPercent.
+     */
+    uint32_t Jitter(uint32_t intervalMs);
 
     uint32_t m_tDuration;
     uint32_t m_tRetransmit;
@@ -1161,6 +1375,36 @@ class IpNameServiceImpl : public qcc::Thread {
     uint32_t m_modulus;
     uint32_t m_retries;
 
+    /**
+     * @internal
+     * @brief The retry schedule: the first interval, the maximum interval
+     * and the jitter applied to each.
+     */
+    uint32_t m_retryIntervalMs;
+    uint32_t m_retryIntervalMaxMs;
+    uint32_t m_retryJitterPercent;
+
+    /**
+     * @internal
+     * @brief The fast discovery retry schedule and the timestamp until which
+     * it is in effect.
+     */
+    uint32_t m_fastRetries;
+    uint32_t m_fastIntervalMs;
+    uint32_t m_fastDiscoveryStartupMs;
+    uint64_t m_fastDiscoveryUntil;
+
+    /**
+     * @internal
+     * @brief The initial and maximum answer holdoff, and for each transport
+     * the current holdoff and the time we last multicast an answer to a
+     * who-has question.
+     */
+    uint32_t m_answerHoldoffMs;
+    uint32_t m_answerHoldoffMaxMs;
+    uint32_t m_answerHoldoff[N_TRANSPORTS];
+    uint64_t m_lastAnswer[N_TRANSPORTS];
+
     /**
      * @internal
      * @brief Listen to our own advertisements if true.
@@ -1216,6 +1460,20 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     bool m_forceLazyUpdate;
 
+    /**
+     * @internal
+     * @brief A socket over which the routing subsystem tells us about link
+     * and address changes, or -1 if the platform has no such mechanism and
+     * we rely on periodic lazy updates alone.
+     */
+    qcc::SocketFd m_monitorSockFd;
+
+    /**
+     * @internal
+     * @brief The event we use to get read notifications on m_monitorSockFd.
+     */
+    qcc::Event* m_monitorEvent;
+
     /**
      * @internal
      * @brief A list of name service messages queued for transmission out on
@@ -1223,6 +1481,23 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     std::list<Header> m_outbound;
 
+    /**
+     * @internal
+     * @brief A datagram waiting to be sent, with the transports that decide
+     * the interfaces it goes out on.
+     */
+    struct OutboundDatagram {
+        TransportMask m_transportMask;
+        std::vector<uint8_t> m_bytes;
+    };
+
+    /**
+     * @internal
+     * @brief A list of datagrams queued for transmission out on the multicast
+     * group.
+     */
+    std::list<OutboundDatagram> m_outboundDatagrams;
+
 #if defined(QCC_OS_GROUP_WINDOWS)
     /**
      * @internal @brief A socket to hold to keep winsock initialized
@@ -1238,6 +1513,34 @@ class IpNameServiceImpl : public qcc::Thread {
      */
     void ClearLiveInterfaces(void);
 
+    /**
+     * @internal
+     * @brief Tear down the socket of a single live interface.  Must be
+     * called with m_mutex held.
+     */
+    void CloseLiveInterface(LiveInterface& live);
+
+    /**
+     * @internal
+     * @brief Start listening for link and address changes if the platform
+     * can tell us about them.
+     */
+    void OpenInterfaceMonitor(void);
+
+    /**
+     * @internal
+     * @brief Stop listening for link and address changes.
+     */
+    void CloseInterfaceMonitor(void);
+
+    /**
+     * @internal
+     * @brief Read all pending notifications from the interface monitor.
+     *
+     * @return true if any of them reported a link or address change.
+     */
+    bool ReadInterfaceMonitor(void);
+
     /**
      * @internal
      * @brief Make sure that we have socket open to talk and listen to as many
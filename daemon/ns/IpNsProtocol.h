@@ -1648,6 +1648,36 @@ class Header : public ProtocolElement {
      */
     uint32_t GetRetries(void) { return m_retries; }
 
+    /**
+     * @internal
+     * @brief Set the number of times this header is to be retried and the
+     * interval before its next retry.  This is not a perfect place for this
+     * information, but it is a very convenient place.  This information is not
+     * part of the wire protocol.
+     *
+     * @param limit The number of times the header is to be retried.
+     * @param intervalMs The interval in milliseconds before the next retry.
+     */
+    void SetRetrySchedule(uint32_t limit, uint32_t intervalMs) { m_retryLimit = limit; m_retryInterval = intervalMs; }
+
+    /**
+     * @internal
+     * @brief Get the number of times this header is to be retried.  This
+     * information is not part of the wire protocol.
+     *
+     * @return The number of times the header is to be retried.
+     */
+    uint32_t GetRetryLimit(void) { return m_retryLimit; }
+
+    /**
+     * @internal
+     * @brief Get the interval before the next retry of this header.  This
+     * information is not part of the wire protocol.
+     *
+     * @return The interval in milliseconds.
+     */
+    uint32_t GetRetryInterval(void) { return m_retryInterval; }
+
     /**
      * @internal
      * @brief Get the tick value representing the last time this header was sent
@@ -1933,6 +1963,8 @@ class Header : public ProtocolElement {
     qcc::IPEndpoint m_destination;
     bool m_destinationSet;
     uint32_t m_retries;
+    uint32_t m_retryLimit;
+    uint32_t m_retryInterval;
     uint32_t m_tick;
     std::vector<WhoHas> m_questions;
     std::vector<IsAt> m_answers;
@@ -0,0 +1,166 @@
+/**
+ * @file
+ * DaemonShmTransport accepts local client connections that are carried by shared memory rings
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <algorithm>
+
+#include <qcc/platform.h>
+#include <qcc/Socket.h>
+#include <qcc/SocketStream.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/BusAttachment.h>
+
+#include "BusInternal.h"
+#include "RemoteEndpoint.h"
+#include "ShmStream.h"
+#include "DaemonShmTransport.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+const char* DaemonShmTransport::TransportName = "shm";
+
+static const uint32_t OFFER_TIMEOUT = 5000;  /**< Times out the offer to avoid denial of service attack */
+
+void* DaemonShmTransport::Run(void* arg)
+{
+    SocketFd listenFd = (SocketFd)(ptrdiff_t)arg;
+    QStatus status = ER_OK;
+
+    Event listenEvent(listenFd, Event::IO_READ, false);
+
+    while (!IsStopping()) {
+        status = Event::Wait(listenEvent);
+        if (status != ER_OK) {
+            if (status != ER_STOPPING_THREAD) {
+                QCC_LogError(status, ("Event::Wait failed"));
+            }
+            break;
+        }
+        SocketFd newSock;
+
+        status = Accept(listenFd, newSock);
+
+        uint32_t uid = -1;
+        uint32_t gid = -1;
+        uint32_t pid = -1;
+        Stream* stream = NULL;
+        bool isShm = false;
+
+        /*
+         * The offer also carries the client's credentials. If we decline the rings the
+         * connection continues on the socket just like a unix transport connection.
+         */
+        if (status == ER_OK) {
+            ShmStream* shm = new ShmStream(newSock);
+            status = shm->Accept(uid, gid, pid, OFFER_TIMEOUT);
+            if (status == ER_OK) {
+                stream = shm;
+                isShm = true;
+            } else if (status == ER_BUS_TRANSPORT_NOT_AVAILABLE) {
+                stream = new SocketStream(shm->DetachSocket());
+                delete shm;
+                status = ER_OK;
+            } else {
+                delete shm;
+            }
+        }
+
+        if (status == ER_OK) {
+            qcc::String authName;
+            qcc::String redirection;
+            static const bool truthiness = true;
+            ShmEndpoint conn = ShmEndpoint(bus, truthiness, DaemonShmTransport::TransportName, stream, isShm, DaemonShmTransport::TransportName);
+            conn->SetUserId(uid);
+            conn->SetGroupId(gid);
+            conn->SetProcessId(pid);
+
+            /* Initialized the features for this endpoint */
+            conn->GetFeatures().isBusToBus = false;
+            conn->GetFeatures().allowRemote = false;
+            conn->GetFeatures().handlePassing = true;
+
+            endpointListLock.Lock(MUTEX_CONTEXT);
+            endpointList.push_back(RemoteEndpoint::cast(conn));
+            endpointListLock.Unlock(MUTEX_CONTEXT);
+            status = conn->Establish("EXTERNAL", authName, redirection);
+            if (status == ER_OK) {
+                /* Handle passing is negotiated along with the version but the rings cannot carry handles */
+                if (isShm) {
+                    conn->GetFeatures().handlePassing = false;
+                }
+                conn->SetListener(this);
+                status = conn->Start();
+            }
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Error starting RemoteEndpoint"));
+                endpointListLock.Lock(MUTEX_CONTEXT);
+                list<RemoteEndpoint>::iterator ei = find(endpointList.begin(), endpointList.end(), RemoteEndpoint::cast(conn));
+                if (ei != endpointList.end()) {
+                    endpointList.erase(ei);
+                }
+                endpointListLock.Unlock(MUTEX_CONTEXT);
+            }
+        } else if (ER_WOULDBLOCK == status || ER_READ_ERROR == status) {
+            status = ER_OK;
+        }
+
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Error accepting new connection. Ignoring..."));
+        }
+
+    }
+
+    qcc::Close(listenFd);
+
+    QCC_DbgPrintf(("DaemonShmTransport::Run is exiting status=%s\n", QCC_StatusText(status)));
+    return (void*) status;
+}
+
+QStatus DaemonShmTransport::NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, map<qcc::String, qcc::String>& argMap) const
+{
+    QStatus status = ParseArguments(DaemonShmTransport::TransportName, inSpec, argMap);
+    qcc::String path = Trim(argMap["path"]);
+    qcc::String abstract = Trim(argMap["abstract"]);
+    if (status == ER_OK) {
+        outSpec = "shm:";
+        if (!path.empty()) {
+            outSpec.append("path=");
+            outSpec.append(path);
+            argMap["_spec"] = path;
+        } else if (!abstract.empty()) {
+            outSpec.append("abstract=");
+            outSpec.append(abstract);
+            argMap["_spec"] = qcc::String("@") + abstract;
+        } else {
+            status = ER_BUS_BAD_TRANSPORT_ARGS;
+        }
+    }
+
+    return status;
+}
+
+} // namespace ajn
@@ -0,0 +1,89 @@
+/**
+ * @file
+ * DaemonShmTransport accepts local client connections that are carried by shared memory rings
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef _ALLJOYN_DAEMONSHMTRANSPORT_H
+#define _ALLJOYN_DAEMONSHMTRANSPORT_H
+
+#ifndef __cplusplus
+#error Only include DaemonShmTransport.h in C++ code.
+#endif
+
+#include <alljoyn/Status.h>
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+
+#include "DaemonTransport.h"
+
+namespace ajn {
+
+/**
+ * DaemonShmTransport listens on an AF_UNIX socket like DaemonTransport. Each client that connects
+ * offers a pair of shared memory rings, see ShmStream. Valid offers are accepted and the
+ * connection is then carried by the rings; otherwise the connection falls back to the socket.
+ *
+ * Listen specs take the same form as for the unix transport, e.g. "shm:abstract=alljoyn-shm".
+ */
+class DaemonShmTransport : public DaemonTransport {
+
+  public:
+    /**
+     * Create a transport to receive shared memory connections from AllJoyn applications.
+     *
+     * @param bus  The bus associated with this transport.
+     */
+    DaemonShmTransport(BusAttachment& bus) : DaemonTransport(bus) { }
+
+    /**
+     * Normalize a transport specification.
+     *
+     * @param inSpec    Input transport connect spec.
+     * @param outSpec   Output transport connect spec.
+     * @param argMap    Parsed parameter map.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const;
+
+    /**
+     * Returns the name of this transport
+     */
+    const char* GetTransportName() const { return TransportName; }
+
+    /**
+     * Name of transport used in transport specs.
+     */
+    static const char* TransportName;
+
+  private:
+
+    /**
+     * @internal
+     * @brief Thread entry point, accepts connections and negotiates the shared memory.
+     *
+     * @param arg  Thread entry arg.
+     */
+    qcc::ThreadReturn STDCALL Run(void* arg);
+};
+
+} // namespace ajn
+
+#endif // _ALLJOYN_DAEMONSHMTRANSPORT_H
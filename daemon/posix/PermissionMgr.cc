@@ -37,6 +37,7 @@ uint32_t PermissionMgr::AddAliasUnixUser(BusEndpoint& srcEp, qcc::String& sender
 
 QStatus PermissionMgr::CleanPermissionCache(BusEndpoint& endpoint)
 {
+    RemoveCachedDecisions(endpoint);
     return ER_OK;
 }
 
@@ -50,7 +50,9 @@
 #include "Transport.h"
 #include "TCPTransport.h"
 #include "DaemonTransport.h"
+#include "DaemonShmTransport.h"
 #include "DaemonICETransport.h"
+#include "UDPTransport.h"
 
 #if defined(QCC_OS_ANDROID)
 //#include "android/WFDTransport.h"
@@ -65,6 +67,9 @@
 #include "Bus.h"
 #include "BusController.h"
 #include "DaemonConfig.h"
+#include "LatencyHistogram.h"
+#include "MemoryAccounting.h"
+#include "PermissionMgr.h"
 
 #if !defined(DAEMON_LIB)
 
@@ -95,6 +100,7 @@ using namespace std;
 
 static volatile sig_atomic_t reload;
 static volatile sig_atomic_t quit;
+static volatile sig_atomic_t dumpStats;
 
 /*
  * Simple config to allow all messages with PolicyDB tied into DaemonRouter and
@@ -107,6 +113,7 @@ static const char
     internalConfig[] =
     "<busconfig>"
     "  <listen>unix:abstract=alljoyn</listen>"
+    "  <listen>shm:abstract=alljoyn-shm</listen>"
     "  <listen>launchd:env=DBUS_LAUNCHD_SESSION_BUS_SOCKET</listen>"
     "  <listen>bluetooth:</listen>"
     "  <listen>tcp:r4addr=0.0.0.0,r4port=9955</listen>"
@@ -159,6 +166,10 @@ void SignalHandler(int sig) {
     case SIGTERM:
         quit = 1;
         break;
+
+    case SIGUSR1:
+        dumpStats = 1;
+        break;
     }
 }
 
@@ -174,7 +185,7 @@ class OptParse {
 
     OptParse(int argc, char** argv) :
         argc(argc), argv(argv), fork(false), noFork(false), noBT(false), noTCP(
-            false), noICE(false), noWFD(false), noLaunchd(false), noSwitchUser(false),
+            false), noICE(false), noUDP(false), noWFD(false), noLaunchd(false), noSwitchUser(false),
         printAddressFd(-1), printPidFd(-1), session(false), system(
             false), internal(false), configService(false),
         verbosity(LOG_WARNING) {
@@ -200,6 +211,9 @@ class OptParse {
     bool GetNoICE() const {
         return noICE;
     }
+    bool GetNoUDP() const {
+        return noUDP;
+    }
     bool GetNoWFD() const {
         return noWFD;
     }
@@ -235,6 +249,7 @@ class OptParse {
     bool noBT;
     bool noTCP;
     bool noICE;
+    bool noUDP;
     bool noWFD;
     bool noLaunchd;
     bool noSwitchUser;
@@ -261,8 +276,8 @@ void OptParse::PrintUsage() {
 #endif
         "]\n"
         "%*s [--print-address[=DESCRIPTOR]] [--print-pid[=DESCRIPTOR]]\n"
-        "%*s [--fork | --nofork] [--no-bt] [--no-tcp] [--no-ice] [--no-wfd] [--no-launchd]\n"
-        "%*s  [--no-switch-user] [--verbosity=LEVEL] [--version]\n\n"
+        "%*s [--fork | --nofork] [--no-bt] [--no-tcp] [--no-ice] [--no-udp] [--no-wfd]\n"
+        "%*s  [--no-launchd] [--no-switch-user] [--verbosity=LEVEL] [--version]\n\n"
         "    --session\n"
         "        Use the standard configuration for the per-login-session message bus.\n\n"
         "    --system\n"
@@ -290,6 +305,8 @@ void OptParse::PrintUsage() {
         "        Disable the TCP transport (override config file setting).\n\n"
         "    --no-ice\n"
         "        Disable the ICE transport (override config file setting).\n\n"
+        "    --no-udp\n"
+        "        Disable the UDP transport (override config file setting).\n\n"
         "    --no-wfd\n"
         "        Disable the Wifi-Direct transport (override config file setting).\n\n"
         "    --no-launchd\n"
@@ -425,6 +442,8 @@ OptParse::ParseResultCode OptParse::ParseResult()
             noTCP = true;
         } else if (arg.compare("--no-ice") == 0) {
             noICE = true;
+        } else if (arg.compare("--no-udp") == 0) {
+            noUDP = true;
         } else if (arg.compare("--no-wfd") == 0) {
             noWFD = true;
         } else if (arg.compare("--no-launchd") == 0) {
@@ -488,6 +507,7 @@ int daemon(OptParse& opts) {
     sigaction(SIGHUP, &act, &oldact);
     sigaction(SIGINT, &act, &oldact);
     sigaction(SIGTERM, &act, &oldact);
+    sigaction(SIGUSR1, &act, &oldact);
 
     /*
      * Extract the listen specs
@@ -523,6 +543,9 @@ int daemon(OptParse& opts) {
         } else if (addrStr.compare(0, sizeof("ice:") - 1, "ice:") == 0) {
             skip = opts.GetNoICE();
 
+        } else if (addrStr.compare(0, sizeof("udp:") - 1, "udp:") == 0) {
+            skip = opts.GetNoUDP();
+
         } else if (addrStr.compare(0, sizeof("wfd:") - 1, "wfd:") == 0) {
             skip = opts.GetNoWFD();
 
@@ -557,7 +580,9 @@ int daemon(OptParse& opts) {
 
     TransportFactoryContainer cntr;
     cntr.Add(new TransportFactory<DaemonTransport>(DaemonTransport::TransportName, false));
+    cntr.Add(new TransportFactory<DaemonShmTransport>(DaemonShmTransport::TransportName, false));
     cntr.Add(new TransportFactory<TCPTransport>(TCPTransport::TransportName, false));
+    cntr.Add(new TransportFactory<UDPTransport>(UDPTransport::TransportName, false));
 #if defined(QCC_OS_DARWIN)
 #warning BT transport factory needs to be implemented for Darwin
 #else
@@ -631,17 +656,27 @@ int daemon(OptParse& opts) {
     sigdelset(&waitmask, SIGHUP);
     sigdelset(&waitmask, SIGINT);
     sigdelset(&waitmask, SIGTERM);
+    sigdelset(&waitmask, SIGUSR1);
 
     quit = 0;
 
     while (!quit) {
         reload = 0;
+        dumpStats = 0;
         sigsuspend(&waitmask);
+        if (dumpStats) {
+            Log(LOG_INFO, "Message routing latency (%s):\n%s", LatencyStats::IsEnabled() ? "recording" : "not recording",
+                LatencyStats::ToString().c_str());
+            if (MemoryAccounting::IsEnabled()) {
+                Log(LOG_INFO, "Memory accounting:\n%s", MemoryAccounting::ToString().c_str());
+            }
+        }
         if (reload && !opts.GetInternalConfig()) {
             Log(LOG_INFO, "Reloading config files.\n");
             FileSource fs(opts.GetConfigFile());
             if (fs.IsValid()) {
                 config = DaemonConfig::Load(fs);
+                PermissionMgr::ResetPermissionCache();
             }
         }
     }
@@ -0,0 +1,755 @@
+/**
+ * @file
+ * PacketEngine benchmark over an emulated lossy link
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <alljoyn/version.h>
+
+#include "CongestionController.h"
+#include "PacketEngine.h"
+#include "PacketStream.h"
+
+#define QCC_MODULE "PACKET"
+
+using namespace qcc;
+using namespace std;
+using namespace ajn;
+
+static volatile sig_atomic_t g_interrupt = false;
+
+static void SigIntHandler(int sig)
+{
+    g_interrupt = true;
+}
+
+static uint64_t NowMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/** Impairments applied by the emulated link, in each direction */
+struct LinkConfig {
+    double loss;            /**< Probability that a packet is dropped */
+    double reorder;         /**< Probability that a packet is held back so later packets overtake it */
+    uint32_t delayUs;       /**< One way propagation delay */
+    uint32_t jitterUs;      /**< Random extra delay, uniform in [0, jitterUs] */
+    uint64_t bandwidth;     /**< Bottleneck bandwidth in bits per second, 0 for unlimited */
+    uint32_t queuePackets;  /**< Bottleneck queue in MTU sized packets, packets are tail dropped when it is full */
+    size_t mtu;             /**< MTU of the link */
+};
+
+/** Counters kept by one direction of the link */
+struct LinkCounters {
+    uint32_t sent;
+    uint32_t lost;
+    uint32_t queueDrops;
+    uint32_t reordered;
+};
+
+class LossyLink;
+
+/**
+ * One end of a LossyLink. Packets pushed into the sink are handed to the link, packets the link
+ * delivers become available from the source.
+ */
+class EmulatedPacketStream : public PacketStream {
+  public:
+    EmulatedPacketStream(LossyLink& link, int side, uint16_t port) : link(link), side(side)
+    {
+        local = GetPacketDest("127.0.0.1", port);
+        sinkEvent.SetEvent();
+    }
+
+    ~EmulatedPacketStream();
+
+    QStatus Start() { return ER_OK; }
+
+    QStatus Stop() { return ER_OK; }
+
+    QStatus PullPacketBytes(void* buf, size_t reqBytes, size_t& actualBytes, PacketDest& sender, uint32_t timeout = Event::WAIT_FOREVER)
+    {
+        size_t numPulled;
+        void* const bufs[1] = { buf };
+        return PullPacketBatch(bufs, reqBytes, &actualBytes, &sender, 1, numPulled, timeout);
+    }
+
+    QStatus PullPacketBatch(void* const* bufs, size_t reqBytes, size_t* actualBytes, PacketDest* senders,
+                            size_t numPackets, size_t& numPulled, uint32_t timeout = Event::WAIT_FOREVER)
+    {
+        numPulled = 0;
+        lock.Lock();
+        while (ready.empty()) {
+            sourceEvent.ResetEvent();
+            lock.Unlock();
+            QStatus status = Event::Wait(sourceEvent, timeout);
+            if (status != ER_OK) {
+                return status;
+            }
+            lock.Lock();
+        }
+        while (!ready.empty() && (numPulled < numPackets)) {
+            vector<uint8_t>* p = ready.front();
+            ready.pop_front();
+            actualBytes[numPulled] = ::min(reqBytes, p->size());
+            memcpy(bufs[numPulled], &(*p)[0], actualBytes[numPulled]);
+            senders[numPulled] = peer;
+            ++numPulled;
+            delete p;
+        }
+        if (ready.empty()) {
+            sourceEvent.ResetEvent();
+        }
+        lock.Unlock();
+        return ER_OK;
+    }
+
+    Event& GetSourceEvent() { return sourceEvent; }
+
+    size_t GetSourceMTU();
+
+    QStatus PushPacketBytes(const void* buf, size_t numBytes, PacketDest& dest);
+
+    /** The link never blocks the sender, a full bottleneck queue drops packets instead */
+    Event& GetSinkEvent() { return sinkEvent; }
+
+    size_t GetSinkMTU() { return GetSourceMTU(); }
+
+    String ToString(const PacketDest& dest) const
+    {
+        IPAddress ipAddr(dest.ip, dest.addrSize);
+        return ipAddr.ToString() + " (" + U32ToString(dest.port) + ")";
+    }
+
+    const PacketDest& GetDest() const { return local; }
+
+    /** Called by the link when a packet arrives at this end */
+    void Deliver(vector<uint8_t>* p)
+    {
+        lock.Lock();
+        ready.push_back(p);
+        sourceEvent.SetEvent();
+        lock.Unlock();
+    }
+
+    void SetPeer(const PacketDest& dest) { peer = dest; }
+
+  private:
+    LossyLink& link;
+    int side;
+    PacketDest local;
+    PacketDest peer;
+    Mutex lock;
+    deque<vector<uint8_t>*> ready;
+    Event sourceEvent;
+    Event sinkEvent;
+};
+
+/**
+ * A point to point link between two EmulatedPacketStreams. Each direction has a bottleneck of
+ * limited bandwidth with a finite queue followed by a propagation delay with jitter, random loss
+ * and reordering. A thread per direction delivers packets when they are due.
+ */
+class LossyLink {
+  public:
+    LossyLink(const LinkConfig& config, uint32_t seed) : config(config)
+    {
+        for (int d = 0; d < 2; ++d) {
+            dir[d].rng = (static_cast<uint64_t>(seed) << 1) + d + 0x9E3779B97F4A7C15ULL;
+            dir[d].linkFree = 0;
+            memset(&dir[d].counters, 0, sizeof(dir[d].counters));
+            dir[d].thread = new DeliveryThread(*this, d);
+        }
+        ends[0] = new EmulatedPacketStream(*this, 0, 9001);
+        ends[1] = new EmulatedPacketStream(*this, 1, 9002);
+        ends[0]->SetPeer(ends[1]->GetDest());
+        ends[1]->SetPeer(ends[0]->GetDest());
+    }
+
+    ~LossyLink()
+    {
+        Stop();
+        for (int d = 0; d < 2; ++d) {
+            delete dir[d].thread;
+            while (!dir[d].inFlight.empty()) {
+                delete dir[d].inFlight.begin()->second;
+                dir[d].inFlight.erase(dir[d].inFlight.begin());
+            }
+            delete ends[d];
+        }
+    }
+
+    void Start()
+    {
+        for (int d = 0; d < 2; ++d) {
+            dir[d].thread->Start();
+        }
+    }
+
+    void Stop()
+    {
+        for (int d = 0; d < 2; ++d) {
+            dir[d].thread->Stop();
+            dir[d].thread->Join();
+        }
+    }
+
+    EmulatedPacketStream& GetEnd(int side) { return *ends[side]; }
+
+    const LinkConfig& GetConfig() const { return config; }
+
+    LinkCounters GetCounters(int side)
+    {
+        lock.Lock();
+        LinkCounters c = dir[side].counters;
+        lock.Unlock();
+        return c;
+    }
+
+    /** Send a packet from one end of the link towards the other */
+    void Send(int side, const void* buf, size_t numBytes)
+    {
+        Direction& d = dir[side];
+        uint64_t now = NowMicros();
+        lock.Lock();
+        ++d.counters.sent;
+        if (config.bandwidth) {
+            /* The bottleneck is busy until linkFree, everything up to then is queued */
+            uint64_t serializeUs = (static_cast<uint64_t>(numBytes) * 8 * 1000000) / config.bandwidth;
+            uint64_t mtuUs = (static_cast<uint64_t>(config.mtu) * 8 * 1000000) / config.bandwidth;
+            uint64_t start = ::max(now, d.linkFree);
+            if ((start - now) > config.queuePackets * mtuUs) {
+                ++d.counters.queueDrops;
+                lock.Unlock();
+                return;
+            }
+            d.linkFree = start + serializeUs;
+            now = d.linkFree;
+        }
+        if (Random(d) < config.loss) {
+            ++d.counters.lost;
+            lock.Unlock();
+            return;
+        }
+        uint64_t deliverAt = now + config.delayUs;
+        if (config.jitterUs) {
+            deliverAt += static_cast<uint64_t>(Random(d) * config.jitterUs);
+        }
+        if (Random(d) < config.reorder) {
+            /* Hold the packet back long enough for the packets behind it to overtake */
+            deliverAt += ::max(config.delayUs / 2, static_cast<uint32_t>(2000));
+            ++d.counters.reordered;
+        }
+        const uint8_t* b = static_cast<const uint8_t*>(buf);
+        d.inFlight.insert(pair<uint64_t, vector<uint8_t>*>(deliverAt, new vector<uint8_t>(b, b + numBytes)));
+        lock.Unlock();
+        d.thread->Alert();
+    }
+
+  private:
+    class DeliveryThread;
+    friend class DeliveryThread;
+
+    class DeliveryThread : public Thread {
+      public:
+        DeliveryThread(LossyLink& link, int side) : Thread("LossyLink"), link(link), side(side) { }
+
+      private:
+        ThreadReturn STDCALL Run(void* arg)
+        {
+            Direction& d = link.dir[side];
+            EmulatedPacketStream& to = *link.ends[1 - side];
+            Event& stopEvent = GetStopEvent();
+            while (!IsStopping()) {
+                uint32_t waitMs = Event::WAIT_FOREVER;
+                uint64_t now = NowMicros();
+                link.lock.Lock();
+                while (!d.inFlight.empty() && (d.inFlight.begin()->first <= now)) {
+                    to.Deliver(d.inFlight.begin()->second);
+                    d.inFlight.erase(d.inFlight.begin());
+                }
+                if (!d.inFlight.empty()) {
+                    waitMs = static_cast<uint32_t>((d.inFlight.begin()->first - now + 999) / 1000);
+                }
+                link.lock.Unlock();
+                QStatus status = Event::Wait(stopEvent, waitMs);
+                if (status == ER_ALERTED_THREAD) {
+                    stopEvent.ResetEvent();
+                }
+            }
+            return 0;
+        }
+
+        LossyLink& link;
+        int side;
+    };
+
+    struct Direction {
+        multimap<uint64_t, vector<uint8_t>*> inFlight;  /**< Packets keyed by delivery time */
+        uint64_t linkFree;                              /**< Time at which the bottleneck finishes sending its queue */
+        uint64_t rng;
+        LinkCounters counters;
+        DeliveryThread* thread;
+    };
+
+    /* xorshift64* so runs are reproducible for a given seed */
+    static double Random(Direction& d)
+    {
+        d.rng ^= d.rng >> 12;
+        d.rng ^= d.rng << 25;
+        d.rng ^= d.rng >> 27;
+        return static_cast<double>((d.rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+    }
+
+    LinkConfig config;
+    Mutex lock;
+    Direction dir[2];
+    EmulatedPacketStream* ends[2];
+};
+
+EmulatedPacketStream::~EmulatedPacketStream()
+{
+    while (!ready.empty()) {
+        delete ready.front();
+        ready.pop_front();
+    }
+}
+
+size_t EmulatedPacketStream::GetSourceMTU()
+{
+    return link.GetConfig().mtu;
+}
+
+QStatus EmulatedPacketStream::PushPacketBytes(const void* buf, size_t numBytes, PacketDest& dest)
+{
+    if (numBytes > GetSinkMTU()) {
+        return ER_PACKET_TOO_LARGE;
+    }
+    link.Send(side, buf, numBytes);
+    return ER_OK;
+}
+
+/** Connects two PacketEngines and keeps track of the resulting streams */
+class BenchListener : public PacketEngineListener {
+  public:
+    void PacketEngineConnectCB(PacketEngine& engine, QStatus status, const PacketEngineStream* stream, const PacketDest& dest, void* context)
+    {
+        connectStatus = status;
+        if (status == ER_OK) {
+            txStream = *stream;
+        }
+        connected.SetEvent();
+    }
+
+    bool PacketEngineAcceptCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest)
+    {
+        rxStream = stream;
+        accepted.SetEvent();
+        return true;
+    }
+
+    void PacketEngineDisconnectCB(PacketEngine& engine, const PacketEngineStream& stream, const PacketDest& dest)
+    {
+        disconnected.SetEvent();
+    }
+
+    QStatus connectStatus;
+    PacketEngineStream txStream;
+    PacketEngineStream rxStream;
+    Event connected;
+    Event accepted;
+    Event disconnected;
+};
+
+/** Settings of a single run */
+struct RunConfig {
+    uint32_t windowSize;
+    CongestionControlType congestion;
+    size_t msgSize;
+    uint32_t count;
+    uint32_t rate;       /**< Messages per second, 0 to send as fast as the window allows */
+    uint32_t seed;
+};
+
+/** Results of a single run */
+struct RunResult {
+    uint32_t received;
+    uint64_t elapsedUs;
+    vector<uint32_t> latencies;
+    LinkCounters data;
+    LinkCounters acks;
+};
+
+/** Receives the benchmark messages and records their latency */
+class ReceiverThread : public Thread {
+  public:
+    ReceiverThread(PacketEngineStream& stream, const RunConfig& config, RunResult& result) :
+        Thread("PacketBenchRx"), stream(stream), config(config), result(result), lastRx(0) { }
+
+    uint64_t GetLastRx() const { return lastRx; }
+
+  private:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        vector<uint8_t> buf(config.msgSize);
+        while (!IsStopping() && (result.received < config.count)) {
+            size_t actual = 0;
+            QStatus status = stream.PullBytes(&buf[0], buf.size(), actual, 500);
+            if (status == ER_TIMEOUT) {
+                continue;
+            } else if (status != ER_OK) {
+                QCC_LogError(status, ("PullBytes failed"));
+                break;
+            }
+            if (actual >= sizeof(uint64_t)) {
+                uint64_t sentAt;
+                memcpy(&sentAt, &buf[0], sizeof(sentAt));
+                lastRx = NowMicros();
+                result.latencies.push_back(static_cast<uint32_t>(lastRx - sentAt));
+                ++result.received;
+            }
+        }
+        return 0;
+    }
+
+    PacketEngineStream& stream;
+    const RunConfig& config;
+    RunResult& result;
+    volatile uint64_t lastRx;
+};
+
+static QStatus RunOnce(const LinkConfig& linkConfig, const RunConfig& config, uint32_t idleTimeoutMs, RunResult& result)
+{
+    result.received = 0;
+    result.elapsedUs = 0;
+    memset(&result.data, 0, sizeof(result.data));
+    memset(&result.acks, 0, sizeof(result.acks));
+
+    LossyLink link(linkConfig, config.seed);
+    PacketEngine txEngine("tx", config.windowSize);
+    PacketEngine rxEngine("rx", config.windowSize);
+    BenchListener listener;
+    rxEngine.SetDefaultCongestionControl(config.congestion);
+
+    link.Start();
+    QStatus status = txEngine.AddPacketStream(link.GetEnd(0), listener);
+    if (status == ER_OK) {
+        status = rxEngine.AddPacketStream(link.GetEnd(1), listener);
+    }
+    if (status == ER_OK) {
+        status = txEngine.Start(linkConfig.mtu);
+    }
+    if (status == ER_OK) {
+        status = rxEngine.Start(linkConfig.mtu);
+    }
+    if (status == ER_OK) {
+        status = txEngine.Connect(link.GetEnd(1).GetDest(), link.GetEnd(0), listener, NULL, config.congestion);
+    }
+    if (status == ER_OK) {
+        status = Event::Wait(listener.connected, 30000);
+        if (status == ER_OK) {
+            status = listener.connectStatus;
+        }
+    }
+    if (status == ER_OK) {
+        status = Event::Wait(listener.accepted, 5000);
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to open a channel over the emulated link"));
+        txEngine.Stop();
+        rxEngine.Stop();
+        txEngine.Join();
+        rxEngine.Join();
+        return status;
+    }
+
+    result.latencies.reserve(config.count);
+    ReceiverThread receiver(listener.rxStream, config, result);
+    receiver.Start();
+
+    vector<uint8_t> msg(config.msgSize);
+    for (size_t i = 0; i < msg.size(); ++i) {
+        msg[i] = 'A' + (i % 52);
+    }
+    uint64_t start = NowMicros();
+    for (uint32_t i = 0; !g_interrupt && (status == ER_OK) && (i < config.count); ++i) {
+        if (config.rate) {
+            uint64_t due = start + (static_cast<uint64_t>(i) * 1000000) / config.rate;
+            uint64_t now = NowMicros();
+            if (due > now) {
+                qcc::Sleep(static_cast<uint32_t>((due - now) / 1000));
+            }
+        }
+        uint64_t now = NowMicros();
+        memcpy(&msg[0], &now, sizeof(now));
+        size_t sent = 0;
+        status = listener.txStream.PushBytes(&msg[0], msg.size(), sent);
+        if ((status == ER_OK) && (sent != msg.size())) {
+            status = ER_FAIL;
+        }
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("PushBytes failed"));
+    }
+
+    /* Wait for the receiver to catch up, give up if nothing arrives for a while */
+    uint64_t lastProgress = NowMicros();
+    uint32_t lastReceived = result.received;
+    while (!g_interrupt && (result.received < config.count)) {
+        qcc::Sleep(10);
+        if (result.received != lastReceived) {
+            lastReceived = result.received;
+            lastProgress = NowMicros();
+        } else if ((NowMicros() - lastProgress) > idleTimeoutMs * 1000ULL) {
+            break;
+        }
+    }
+    receiver.Stop();
+    receiver.Join();
+    result.elapsedUs = (receiver.GetLastRx() > start) ? (receiver.GetLastRx() - start) : 0;
+    result.data = link.GetCounters(0);
+    result.acks = link.GetCounters(1);
+
+    txEngine.Disconnect(listener.txStream);
+    Event::Wait(listener.disconnected, DISCONNECT_TIMEOUT);
+    txEngine.Stop();
+    rxEngine.Stop();
+    txEngine.Join();
+    rxEngine.Join();
+    link.Stop();
+    return (result.received == config.count) ? ER_OK : ER_TIMEOUT;
+}
+
+static uint32_t Percentile(const vector<uint32_t>& sorted, uint32_t permille)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = (sorted.size() * permille + 999) / 1000;
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+static void Report(FILE* out, bool json, bool first, const LinkConfig& link, const RunConfig& config, RunResult& result)
+{
+    sort(result.latencies.begin(), result.latencies.end());
+    double goodput = result.elapsedUs ? (static_cast<double>(result.received) * config.msgSize * 8 * 1000000) / result.elapsedUs : 0;
+    const char* cc = (config.congestion == CONGESTION_CONTROL_CUBIC) ? "cubic" : "reno";
+    if (json) {
+        fprintf(out, "%s  {\"window\": %u, \"congestion\": \"%s\", \"loss\": %.4f, \"reorder\": %.4f, \"delay_us\": %u, \"jitter_us\": %u, "
+                "\"bandwidth_bps\": %llu, \"size\": %u, \"sent\": %u, \"received\": %u, \"goodput_bps\": %.0f, "
+                "\"p50_us\": %u, \"p90_us\": %u, \"p99_us\": %u, \"p999_us\": %u, \"max_us\": %u, "
+                "\"data_packets\": %u, \"data_lost\": %u, \"data_queue_drops\": %u, \"ack_packets\": %u}",
+                first ? "" : ",\n", config.windowSize, cc, link.loss, link.reorder, link.delayUs, link.jitterUs,
+                (unsigned long long)link.bandwidth, (unsigned)config.msgSize, config.count, result.received, goodput,
+                Percentile(result.latencies, 500), Percentile(result.latencies, 900), Percentile(result.latencies, 990),
+                Percentile(result.latencies, 999), result.latencies.empty() ? 0 : result.latencies.back(),
+                result.data.sent, result.data.lost, result.data.queueDrops, result.acks.sent);
+    } else {
+        if (first) {
+            fprintf(out, "window,congestion,loss,reorder,delay_us,jitter_us,bandwidth_bps,size,sent,received,goodput_bps,"
+                    "p50_us,p90_us,p99_us,p999_us,max_us,data_packets,data_lost,data_queue_drops,ack_packets\n");
+        }
+        fprintf(out, "%u,%s,%.4f,%.4f,%u,%u,%llu,%u,%u,%u,%.0f,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                config.windowSize, cc, link.loss, link.reorder, link.delayUs, link.jitterUs,
+                (unsigned long long)link.bandwidth, (unsigned)config.msgSize, config.count, result.received, goodput,
+                Percentile(result.latencies, 500), Percentile(result.latencies, 900), Percentile(result.latencies, 990),
+                Percentile(result.latencies, 999), result.latencies.empty() ? 0 : result.latencies.back(),
+                result.data.sent, result.data.lost, result.data.queueDrops, result.acks.sent);
+    }
+    fflush(out);
+}
+
+/** Parse a comma separated list of numbers */
+static vector<uint32_t> ParseList(const char* arg)
+{
+    vector<uint32_t> list;
+    String s(arg);
+    size_t pos = 0;
+    while (pos != String::npos) {
+        size_t comma = s.find_first_of(',', pos);
+        String tok = s.substr(pos, (comma == String::npos) ? String::npos : (comma - pos));
+        list.push_back(StringToU32(tok, 10, 0));
+        pos = (comma == String::npos) ? String::npos : comma + 1;
+    }
+    return list;
+}
+
+static void usage(void)
+{
+    printf("Usage: packetbench [-h] [-l #] [-r #] [-d #] [-j #] [-b #] [-q #] [-m #] [-w #[,#...]] [-c reno|cubic|all]\n"
+           "                   [-s #] [-n #] [-R #] [-S #] [-f csv|json] [-o <file>]\n\n");
+    printf("Options:\n");
+    printf("   -h                 - Print this help message\n");
+    printf("   -l #               - Packet loss probability in each direction (default 0.01)\n");
+    printf("   -r #               - Reorder probability in each direction (default 0)\n");
+    printf("   -d #               - One way delay in ms (default 20)\n");
+    printf("   -j #               - Jitter in ms (default 0)\n");
+    printf("   -b #               - Bottleneck bandwidth in kbit/s, 0 for unlimited (default 10000)\n");
+    printf("   -q #               - Bottleneck queue size in packets (default 64)\n");
+    printf("   -m #               - Link MTU (default 1472)\n");
+    printf("   -w #[,#...]        - Window sizes to test (default 32,128,512)\n");
+    printf("   -c reno|cubic|all  - Congestion control to test (default all)\n");
+    printf("   -s #               - Message size in bytes (default 1000)\n");
+    printf("   -n #               - Messages per run (default 5000)\n");
+    printf("   -R #               - Send rate in messages per second, 0 to saturate the link (default 0)\n");
+    printf("   -S #               - Random seed (default 1)\n");
+    printf("   -f csv|json        - Output format (default csv)\n");
+    printf("   -o <file>          - Write results to a file instead of stdout\n");
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    LinkConfig link;
+    link.loss = 0.01;
+    link.reorder = 0.0;
+    link.delayUs = 20000;
+    link.jitterUs = 0;
+    link.bandwidth = 10000000;
+    link.queuePackets = 64;
+    link.mtu = 1472;
+
+    RunConfig config;
+    config.msgSize = 1000;
+    config.count = 5000;
+    config.rate = 0;
+    config.seed = 1;
+    vector<uint32_t> windows;
+    windows.push_back(32);
+    windows.push_back(128);
+    windows.push_back(512);
+    vector<CongestionControlType> congestion;
+    congestion.push_back(CONGESTION_CONTROL_RENO);
+    congestion.push_back(CONGESTION_CONTROL_CUBIC);
+    bool json = false;
+    FILE* out = stdout;
+
+    /* Install SIGINT handler */
+    signal(SIGINT, SigIntHandler);
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        const char* opt = argv[i];
+        if (::strcmp("-h", opt) == 0) {
+            usage();
+            exit(0);
+        }
+        if (++i == argc) {
+            printf("option %s requires a parameter\n", opt);
+            usage();
+            exit(1);
+        }
+        if (::strcmp("-l", opt) == 0) {
+            link.loss = strtod(argv[i], NULL);
+        } else if (::strcmp("-r", opt) == 0) {
+            link.reorder = strtod(argv[i], NULL);
+        } else if (::strcmp("-d", opt) == 0) {
+            link.delayUs = static_cast<uint32_t>(strtod(argv[i], NULL) * 1000);
+        } else if (::strcmp("-j", opt) == 0) {
+            link.jitterUs = static_cast<uint32_t>(strtod(argv[i], NULL) * 1000);
+        } else if (::strcmp("-b", opt) == 0) {
+            link.bandwidth = static_cast<uint64_t>(StringToU32(argv[i], 10, 0)) * 1000;
+        } else if (::strcmp("-q", opt) == 0) {
+            link.queuePackets = StringToU32(argv[i], 10, 64);
+        } else if (::strcmp("-m", opt) == 0) {
+            link.mtu = StringToU32(argv[i], 10, 1472);
+        } else if (::strcmp("-w", opt) == 0) {
+            windows = ParseList(argv[i]);
+        } else if (::strcmp("-c", opt) == 0) {
+            congestion.clear();
+            if (::strcmp("all", argv[i]) == 0) {
+                congestion.push_back(CONGESTION_CONTROL_RENO);
+                congestion.push_back(CONGESTION_CONTROL_CUBIC);
+            } else {
+                congestion.push_back(CongestionControlFromString(argv[i], CONGESTION_CONTROL_RENO));
+            }
+        } else if (::strcmp("-s", opt) == 0) {
+            config.msgSize = ::max(StringToU32(argv[i], 10, 1000), static_cast<uint32_t>(sizeof(uint64_t)));
+        } else if (::strcmp("-n", opt) == 0) {
+            config.count = StringToU32(argv[i], 10, 5000);
+        } else if (::strcmp("-R", opt) == 0) {
+            config.rate = StringToU32(argv[i], 10, 0);
+        } else if (::strcmp("-S", opt) == 0) {
+            config.seed = StringToU32(argv[i], 10, 1);
+        } else if (::strcmp("-f", opt) == 0) {
+            json = (::strcmp("json", argv[i]) == 0);
+        } else if (::strcmp("-o", opt) == 0) {
+            out = fopen(argv[i], "w");
+            if (!out) {
+                printf("Failed to open %s for writing\n", argv[i]);
+                exit(1);
+            }
+        } else {
+            printf("Unknown option %s\n", opt);
+            usage();
+            exit(1);
+        }
+    }
+
+    fprintf(stderr, "AllJoyn Library version: %s\n", ajn::GetVersion());
+    fprintf(stderr, "AllJoyn Library build info: %s\n", ajn::GetBuildInfo());
+
+    if (json) {
+        fprintf(out, "[\n");
+    }
+    bool first = true;
+    QStatus status = ER_OK;
+    for (size_t w = 0; !g_interrupt && (w < windows.size()); ++w) {
+        for (size_t c = 0; !g_interrupt && (c < congestion.size()); ++c) {
+            config.windowSize = windows[w];
+            config.congestion = congestion[c];
+            RunResult result;
+            QStatus runStatus = RunOnce(link, config, 10000, result);
+            if (runStatus != ER_OK) {
+                fprintf(stderr, "window=%u congestion=%s: %s (%u of %u messages received)\n", config.windowSize,
+                        (config.congestion == CONGESTION_CONTROL_CUBIC) ? "cubic" : "reno", QCC_StatusText(runStatus),
+                        result.received, config.count);
+                status = runStatus;
+            }
+            Report(out, json, first, link, config, result);
+            first = false;
+        }
+    }
+    if (json) {
+        fprintf(out, "\n]\n");
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return (int) status;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file
+ * IocpStream is a socket stream whose reads and writes complete on an I/O completion port.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+// Do not change the order of these includes; they are order dependent.
+#include <Winsock2.h>
+#include <Mswsock.h>
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Socket.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+
+#include "IocpStream.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "NETWORK"
+
+using namespace std;
+using namespace qcc;
+
+namespace qcc {
+extern String StrError();
+}
+
+namespace ajn {
+
+/* Upper limit on ALLJOYN_IOCP_THREADS */
+static const uint32_t MAX_IOCP_THREADS = 32;
+
+/* Buffers of a vectored send that are passed to WSASend without allocating */
+static const size_t MAX_AUTO_BUFS = 16;
+
+/**
+ * Thread that collects completions from the port and hands them to their streams.
+ */
+class IocpThread : public Thread {
+  public:
+    IocpThread(HANDLE port) : Thread("iocp"), port(port) { }
+
+  private:
+    ThreadReturn STDCALL Run(void* arg);
+
+    HANDLE port;
+};
+
+/*
+ * The completion port and its threads are shared by every IocpStream. They are created with
+ * the first stream and torn down with the last one.
+ */
+static Mutex portLock;
+static HANDLE port = NULL;
+static uint32_t portRefs = 0;
+static vector<IocpThread*> portThreads;
+
+static HANDLE AcquirePort()
+{
+    portLock.Lock(MUTEX_CONTEXT);
+    if (portRefs++ == 0) {
+        port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+        if (port == NULL) {
+            QCC_LogError(ER_OS_ERROR, ("CreateIoCompletionPort failed: %d", GetLastError()));
+        } else {
+            uint32_t numThreads = StringToU32(Environ::GetAppEnviron()->Find("ALLJOYN_IOCP_THREADS"), 0, 2);
+            numThreads = (std::min)((std::max)(numThreads, (uint32_t)1), MAX_IOCP_THREADS);
+            for (uint32_t i = 0; i < numThreads; ++i) {
+                IocpThread* thread = new IocpThread(port);
+                QStatus status = thread->Start();
+                if (status != ER_OK) {
+                    QCC_LogError(status, ("Failed to start completion port thread"));
+                    delete thread;
+                    break;
+                }
+                portThreads.push_back(thread);
+            }
+        }
+    }
+    HANDLE p = port;
+    portLock.Unlock(MUTEX_CONTEXT);
+    return p;
+}
+
+static void ReleasePort()
+{
+    portLock.Lock(MUTEX_CONTEXT);
+    if (--portRefs == 0) {
+        /* A completion without an OVERLAPPED tells one thread to exit */
+        for (size_t i = 0; i < portThreads.size(); ++i) {
+            PostQueuedCompletionStatus(port, 0, 0, NULL);
+        }
+        for (size_t i = 0; i < portThreads.size(); ++i) {
+            portThreads[i]->Join();
+            delete portThreads[i];
+        }
+        portThreads.clear();
+        if (port) {
+            CloseHandle(port);
+            port = NULL;
+        }
+    }
+    portLock.Unlock(MUTEX_CONTEXT);
+}
+
+ThreadReturn STDCALL IocpThread::Run(void* arg)
+{
+    while (true) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = NULL;
+        BOOL ok = GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, INFINITE);
+        if (!overlapped) {
+            if (!ok) {
+                QCC_LogError(ER_OS_ERROR, ("GetQueuedCompletionStatus failed: %d", GetLastError()));
+            }
+            break;
+        }
+        QStatus status = ER_OK;
+        if (!ok) {
+            DWORD err = GetLastError();
+            if ((err == ERROR_NETNAME_DELETED) || (err == ERROR_CONNECTION_ABORTED) || (err == ERROR_OPERATION_ABORTED)) {
+                status = ER_SOCK_OTHER_END_CLOSED;
+            } else {
+                status = ER_OS_ERROR;
+                QCC_DbgHLPrintf(("Overlapped socket operation failed: %d", err));
+            }
+        }
+        reinterpret_cast<IocpStream*>(key)->Completed(overlapped, status, bytes);
+    }
+    return 0;
+}
+
+IocpStream::IocpStream(SocketFd sock) :
+    sock(sock),
+    associated(false),
+    outstanding(0),
+    rxBuf(new uint8_t[RX_BUF_SIZE]),
+    rxHead(0),
+    rxTail(0),
+    rxPending(false),
+    rxStatus(ER_OK),
+    txFirst(NULL),
+    txPending(false),
+    txDone(false),
+    txSent(0),
+    txStatus(ER_OK),
+    sendTimeout(Event::WAIT_FOREVER)
+{
+    sinkEvent.SetEvent();
+    idleEvent.SetEvent();
+    HANDLE p = AcquirePort();
+    if (p && CreateIoCompletionPort(reinterpret_cast<HANDLE>(sock), p, reinterpret_cast<ULONG_PTR>(this), 0)) {
+        associated = true;
+        lock.Lock(MUTEX_CONTEXT);
+        PostRecv();
+        lock.Unlock(MUTEX_CONTEXT);
+    } else {
+        rxStatus = ER_OS_ERROR;
+        sourceEvent.SetEvent();
+        QCC_LogError(rxStatus, ("Failed to associate socket %d with the completion port", sock));
+    }
+}
+
+IocpStream::~IocpStream()
+{
+    Close();
+    /* Closing the socket aborts the outstanding operations but their completions still arrive */
+    while (true) {
+        lock.Lock(MUTEX_CONTEXT);
+        bool idle = (outstanding == 0);
+        lock.Unlock(MUTEX_CONTEXT);
+        if (idle) {
+            break;
+        }
+        Event::Wait(idleEvent, 100);
+    }
+    delete [] rxBuf;
+    ReleasePort();
+}
+
+void IocpStream::Close()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    if (sock != INVALID_SOCKET_FD) {
+        qcc::Close(sock);
+        sock = INVALID_SOCKET_FD;
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+void IocpStream::PostRecv()
+{
+    rxHead = 0;
+    rxTail = 0;
+    if (sock == INVALID_SOCKET_FD) {
+        rxStatus = ER_SOCK_OTHER_END_CLOSED;
+        sourceEvent.SetEvent();
+        return;
+    }
+    WSABUF buf;
+    buf.buf = reinterpret_cast<char*>(rxBuf);
+    buf.len = RX_BUF_SIZE;
+    DWORD flags = 0;
+    memset(&rxOverlapped, 0, sizeof(rxOverlapped));
+    /* Even a receive that completes at once is reported through the port */
+    if ((WSARecv(static_cast<SOCKET>(sock), &buf, 1, NULL, &flags, &rxOverlapped, NULL) == SOCKET_ERROR) && (WSAGetLastError() != WSA_IO_PENDING)) {
+        rxStatus = ER_OS_ERROR;
+        QCC_LogError(rxStatus, ("WSARecv: %s", StrError().c_str()));
+        sourceEvent.SetEvent();
+    } else {
+        rxPending = true;
+        ++outstanding;
+        idleEvent.ResetEvent();
+    }
+}
+
+void IocpStream::Completed(OVERLAPPED* overlapped, QStatus status, size_t bytes)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    if (overlapped == &rxOverlapped) {
+        rxPending = false;
+        if (status != ER_OK) {
+            rxStatus = status;
+        } else if (bytes == 0) {
+            rxStatus = ER_SOCK_OTHER_END_CLOSED;
+        } else {
+            rxTail = bytes;
+        }
+        sourceEvent.SetEvent();
+    } else {
+        txPending = false;
+        txDone = true;
+        txSent = bytes;
+        txStatus = status;
+        sinkEvent.SetEvent();
+    }
+    if (--outstanding == 0) {
+        idleEvent.SetEvent();
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus IocpStream::PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    actualBytes = 0;
+    if (reqBytes == 0) {
+        return ER_OK;
+    }
+    lock.Lock(MUTEX_CONTEXT);
+    while ((rxHead == rxTail) && (rxStatus == ER_OK)) {
+        if (!rxPending) {
+            PostRecv();
+            continue;
+        }
+        lock.Unlock(MUTEX_CONTEXT);
+        if (timeout == 0) {
+            return ER_TIMEOUT;
+        }
+        QStatus status = Event::Wait(sourceEvent, timeout);
+        if (status != ER_OK) {
+            return status;
+        }
+        lock.Lock(MUTEX_CONTEXT);
+    }
+    QStatus status = ER_OK;
+    if (rxHead < rxTail) {
+        actualBytes = (std::min)(reqBytes, rxTail - rxHead);
+        memcpy(buf, rxBuf + rxHead, actualBytes);
+        rxHead += actualBytes;
+        if (rxHead == rxTail) {
+            sourceEvent.ResetEvent();
+            PostRecv();
+        }
+    } else {
+        status = rxStatus;
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+QStatus IocpStream::Send(const WSABUF* bufs, size_t numBufs, size_t& numSent)
+{
+    numSent = 0;
+    lock.Lock(MUTEX_CONTEXT);
+    if (!txPending && !txDone) {
+        if (sock == INVALID_SOCKET_FD) {
+            lock.Unlock(MUTEX_CONTEXT);
+            return ER_SOCK_OTHER_END_CLOSED;
+        }
+        memset(&txOverlapped, 0, sizeof(txOverlapped));
+        if ((WSASend(static_cast<SOCKET>(sock), const_cast<WSABUF*>(bufs), static_cast<DWORD>(numBufs), NULL, 0, &txOverlapped, NULL) == SOCKET_ERROR) &&
+            (WSAGetLastError() != WSA_IO_PENDING)) {
+            lock.Unlock(MUTEX_CONTEXT);
+            QCC_LogError(ER_OS_ERROR, ("WSASend: %s", StrError().c_str()));
+            return ER_OS_ERROR;
+        }
+        txFirst = bufs[0].buf;
+        txPending = true;
+        ++outstanding;
+        idleEvent.ResetEvent();
+        sinkEvent.ResetEvent();
+    } else if (txFirst != bufs[0].buf) {
+        /* The send in progress was issued from the caller's buffers so they must not change */
+        lock.Unlock(MUTEX_CONTEXT);
+        QCC_LogError(ER_FAIL, ("IocpStream::Send(): buffers changed while a send was in progress"));
+        return ER_FAIL;
+    }
+    while (txPending) {
+        lock.Unlock(MUTEX_CONTEXT);
+        if (sendTimeout == 0) {
+            return ER_TIMEOUT;
+        }
+        QStatus status = Event::Wait(sinkEvent, sendTimeout);
+        if (status != ER_OK) {
+            return status;
+        }
+        lock.Lock(MUTEX_CONTEXT);
+    }
+    txDone = false;
+    txFirst = NULL;
+    numSent = txSent;
+    QStatus status = txStatus;
+    lock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+QStatus IocpStream::PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+{
+    if (numBytes == 0) {
+        numSent = 0;
+        return ER_OK;
+    }
+    WSABUF wsaBuf;
+    wsaBuf.buf = reinterpret_cast<char*>(const_cast<void*>(buf));
+    wsaBuf.len = static_cast<ULONG>(numBytes);
+    return Send(&wsaBuf, 1, numSent);
+}
+
+QStatus IocpStream::PushBytesV(const IOVec* iov, size_t numIOVec, size_t& numSent)
+{
+    if (numIOVec == 0) {
+        numSent = 0;
+        return ER_OK;
+    }
+    WSABUF bufsAuto[MAX_AUTO_BUFS];
+    WSABUF* bufs = (numIOVec <= MAX_AUTO_BUFS) ? bufsAuto : new WSABUF[numIOVec];
+    for (size_t i = 0; i < numIOVec; ++i) {
+        bufs[i].buf = reinterpret_cast<char*>(const_cast<void*>(static_cast<const void*>(iov[i].buf)));
+        bufs[i].len = static_cast<ULONG>(iov[i].len);
+    }
+    QStatus status = Send(bufs, numIOVec, numSent);
+    if (bufs != bufsAuto) {
+        delete [] bufs;
+    }
+    return (status == ER_TIMEOUT) ? ER_WOULDBLOCK : status;
+}
+
+}
@@ -0,0 +1,158 @@
+#ifndef _ALLJOYN_IOCPSTREAM_H
+#define _ALLJOYN_IOCPSTREAM_H
+/**
+ * @file
+ * IocpStream is a socket stream whose reads and writes complete on an I/O completion port.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include IocpStream.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+// Do not change the order of these includes; they are order dependent.
+#include <Winsock2.h>
+#include <Mswsock.h>
+
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Socket.h>
+#include <qcc/Stream.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * IocpStream carries a connected TCP socket. Instead of waiting for the socket to become
+ * readable or writable it keeps one overlapped receive and at most one overlapped send
+ * outstanding. Their completions are collected by a small pool of threads shared by every
+ * IocpStream in the process, so the socket handles never take part in a wait and the number of
+ * connections is not bounded by the number of handles one wait can watch.
+ *
+ * Received bytes are buffered in the stream and the source event is set while the buffer holds
+ * data or the connection has ended. Sends are issued directly from the caller's buffers and report
+ * ER_WOULDBLOCK (or block up to the send timeout) until their completion arrives. The caller must
+ * then present the same unsent bytes again, exactly as it would after a partial write, and is told
+ * how many of them were sent. The remote endpoint write path already behaves this way since the
+ * message being written stays in place until all of it has been sent.
+ *
+ * The number of completion threads is read from the ALLJOYN_IOCP_THREADS environment variable and
+ * defaults to two.
+ */
+class IocpStream : public qcc::Stream {
+  public:
+
+    /** Size of the receive buffer of each stream */
+    static const size_t RX_BUF_SIZE = 16 * 1024;
+
+    /**
+     * Constructor
+     *
+     * @param sock   A connected socket. The stream owns the socket.
+     */
+    IocpStream(qcc::SocketFd sock);
+
+    /**
+     * Destructor. Waits for the outstanding operations, which may reference the caller's send
+     * buffers, to complete.
+     */
+    virtual ~IocpStream();
+
+    /**
+     * Get the socket carried by this stream.
+     */
+    qcc::SocketFd GetSocketFd() { return sock; }
+
+    /* qcc::Source */
+    QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = qcc::Event::WAIT_FOREVER);
+    qcc::Event& GetSourceEvent() { return sourceEvent; }
+
+    /* qcc::Sink */
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent);
+    qcc::Event& GetSinkEvent() { return sinkEvent; }
+    void SetSendTimeout(uint32_t sendTimeout) { this->sendTimeout = sendTimeout; }
+
+    /**
+     * Send several buffers with one overlapped send.
+     *
+     * @param iov        The buffers.
+     * @param numIOVec   Number of buffers in iov.
+     * @param numSent    Returns the number of bytes sent.
+     *
+     * @return  ER_OK if bytes were sent, ER_WOULDBLOCK if the send has not completed yet.
+     */
+    QStatus PushBytesV(const qcc::IOVec* iov, size_t numIOVec, size_t& numSent);
+
+    /* qcc::Stream */
+    void Close();
+
+    /**
+     * Called by a completion thread when an operation of this stream completed.
+     *
+     * @param overlapped  The operation.
+     * @param status      ER_OK or the error the operation failed with.
+     * @param bytes       Number of bytes transferred.
+     */
+    void Completed(OVERLAPPED* overlapped, QStatus status, size_t bytes);
+
+  private:
+
+    /* Not copyable */
+    IocpStream(const IocpStream& other);
+    IocpStream& operator=(const IocpStream& other);
+
+    /**
+     * Issue the next receive. Must be called holding lock.
+     */
+    void PostRecv();
+
+    /**
+     * Issue a send or collect the result of the one in progress, waiting up to the send timeout.
+     */
+    QStatus Send(const WSABUF* bufs, size_t numBufs, size_t& numSent);
+
+    qcc::SocketFd sock;          /**< The socket */
+    bool associated;             /**< True once the socket is associated with the completion port */
+    qcc::Mutex lock;             /**< Protects the state below */
+    qcc::Event sourceEvent;      /**< Set while received bytes are buffered or the connection has ended */
+    qcc::Event sinkEvent;        /**< Set while no send is in progress */
+    qcc::Event idleEvent;        /**< Set while no operation is outstanding */
+    uint32_t outstanding;        /**< Number of operations the completion port still has to report */
+
+    OVERLAPPED rxOverlapped;     /**< The outstanding receive */
+    uint8_t* rxBuf;              /**< Received bytes not yet pulled */
+    size_t rxHead;               /**< Offset of the first byte not yet pulled */
+    size_t rxTail;               /**< Offset past the last received byte */
+    bool rxPending;              /**< True while a receive is outstanding */
+    QStatus rxStatus;            /**< Sticky end of stream or receive error */
+
+    OVERLAPPED txOverlapped;     /**< The outstanding send */
+    const void* txFirst;         /**< Start of the first buffer of the outstanding send */
+    bool txPending;              /**< True while a send is outstanding */
+    bool txDone;                 /**< True if the send completed but its result has not been collected */
+    size_t txSent;               /**< Bytes sent by the completed send */
+    QStatus txStatus;            /**< Result of the completed send */
+    uint32_t sendTimeout;        /**< Send timeout in milliseconds */
+};
+
+}
+
+#endif
@@ -28,6 +28,9 @@
 #include <qcc/IfConfig.h>
 #include <qcc/winrt/utility.h>
 
+#include <robuffer.h>
+#include <wrl/client.h>
+
 #include "ns/IpNameService.h"
 #include "ProximityNameService.h"
 #include "ppltasks.h"
@@ -111,6 +114,7 @@ ProximityNameService::ProximityNameService(const qcc::String& guid) :
     m_currentP2PLink.dataReader = nullptr;
     m_currentP2PLink.dataWriter = nullptr;
     m_currentP2PLink.socketClosed = true;
+    m_currentP2PLink.pendingMsgBytes = 0;
     GUID128 id(guid);
     m_sguid = id.ToShortString();
 }
@@ -175,8 +179,7 @@ void ProximityNameService::ConnectionRequestedEventHandler(Platform::Object ^ se
                              m_currentP2PLink.socket = resultTask.get();
                              m_currentP2PLink.socketClosed = false;
                              m_currentP2PLink.state = PROXIM_CONNECTED;
-                             m_currentP2PLink.dataReader = ref new DataReader(m_currentP2PLink.socket->InputStream);
-                             m_currentP2PLink.dataWriter = ref new DataWriter(m_currentP2PLink.socket->OutputStream);
+                             OpenLinkStreams();
                              StartReader();
                              qcc::String loAddrStr = PlatformToMultibyteString(m_currentP2PLink.socket->Information->LocalAddress->CanonicalName);
                              size_t pos = loAddrStr.find_first_of('%');
@@ -541,8 +544,7 @@ QStatus ProximityNameService::EstasblishProximityConnection(qcc::String guidStr)
             m_currentP2PLink.localIp = rAddrStr;
             m_currentP2PLink.state = PROXIM_CONNECTED;
             m_currentP2PLink.socketClosed = false;
-            m_currentP2PLink.dataReader = ref new DataReader(m_currentP2PLink.socket->InputStream);
-            m_currentP2PLink.dataWriter = ref new DataWriter(m_currentP2PLink.socket->OutputStream);
+            OpenLinkStreams();
 
             IfConfigEntry wfdEntry;
             wfdEntry.m_name = "win-wfd";
@@ -650,45 +652,33 @@ Platform::String ^ ProximityNameService::EncodeWknAdvertisement()
     return platformStr;
 }
 
+void ProximityNameService::OpenLinkStreams()
+{
+    m_currentP2PLink.dataReader = ref new DataReader(m_currentP2PLink.socket->InputStream);
+    /*
+     * A load completes with whatever has arrived and the reader may fetch more than was asked for,
+     * so the link is read in large chunks that usually hold several protocol messages.
+     */
+    m_currentP2PLink.dataReader->InputStreamOptions = InputStreamOptions::Partial | InputStreamOptions::ReadAhead;
+    m_currentP2PLink.dataWriter = ref new DataWriter(m_currentP2PLink.socket->OutputStream);
+    m_currentP2PLink.pendingMsgBytes = 0;
+}
+
 void ProximityNameService::StartReader()
 {
     QCC_DbgPrintf(("ProximityNameService::StartReader()"));
-    Concurrency::task<unsigned int> loadTask(m_currentP2PLink.dataReader->LoadAsync(sizeof(unsigned int)));
-    loadTask.then([this](Concurrency::task<unsigned int> stringBytesTask)
+    Concurrency::task<unsigned int> loadTask(m_currentP2PLink.dataReader->LoadAsync(READ_AHEAD_BYTES));
+    loadTask.then([this](Concurrency::task<unsigned int> resultTask)
                   {
                       try{
-                          unsigned int bytesRead = stringBytesTask.get();
+                          unsigned int bytesRead = resultTask.get();
                           if (bytesRead > 0) {
-                              unsigned int nbytes = (unsigned int)m_currentP2PLink.dataReader->ReadUInt32();
-                              Concurrency::task<unsigned int> loadStringTask(m_currentP2PLink.dataReader->LoadAsync(nbytes));
-                              loadStringTask.then([this, nbytes](Concurrency::task<unsigned int> resultTask) {
-                                                      try{
-                                                          unsigned int bytesRead = resultTask.get();
-                                                          if (bytesRead > 0) {
-                                                              Platform::Array<unsigned char> ^ buffer = ref new Platform::Array<unsigned char>(nbytes);
-                                                              m_currentP2PLink.dataReader->ReadBytes(buffer);
-                                                              qcc::String addrStr = PlatformToMultibyteString(m_currentP2PLink.socket->Information->RemoteAddress->CanonicalName);
-                                                              size_t pos = addrStr.find_first_of('%');
-                                                              if (qcc::String::npos != pos) {
-                                                                  addrStr = addrStr.substr(0, pos);
-                                                              }
-                                                              qcc::IPAddress address(addrStr);
-#if DO_P2P_NAME_ADVERTISE
-                                                              HandleProtocolMessage(buffer->Data, nbytes, address);
-#endif
-                                                              StartReader();
-                                                          } else {
-                                                              qcc::String err = "The remote side closed the socket";
-                                                              SocketError(err);
-                                                          }
-                                                      }catch (Exception ^ e) {
-                                                          if (!m_currentP2PLink.socketClosed) {
-                                                              qcc::String err = "Failed to read from socket: ";
-                                                              err += PlatformToMultibyteString(e->Message).c_str();
-                                                              SocketError(err);
-                                                          }
-                                                      }
-                                                  });
+                              if (ConsumeMessages()) {
+                                  StartReader();
+                              } else {
+                                  qcc::String err = "The remote side sent an oversized message";
+                                  SocketError(err);
+                              }
                           } else {
                               qcc::String err = "The remote side closed the socket";
                               SocketError(err);
@@ -703,6 +693,51 @@ void ProximityNameService::StartReader()
                   });
 }
 
+bool ProximityNameService::ConsumeMessages()
+{
+    DataReader ^ reader = m_currentP2PLink.dataReader;
+    qcc::String addrStr = PlatformToMultibyteString(m_currentP2PLink.socket->Information->RemoteAddress->CanonicalName);
+    size_t pos = addrStr.find_first_of('%');
+    if (qcc::String::npos != pos) {
+        addrStr = addrStr.substr(0, pos);
+    }
+    qcc::IPAddress address(addrStr);
+
+    /* A message that has only partly arrived stays in the reader until the next load completes */
+    while (true) {
+        if (m_currentP2PLink.pendingMsgBytes == 0) {
+            if (reader->UnconsumedBufferLength < sizeof(uint32_t)) {
+                break;
+            }
+            m_currentP2PLink.pendingMsgBytes = reader->ReadUInt32();
+            if (m_currentP2PLink.pendingMsgBytes > MAX_MESSAGE_BYTES) {
+                return false;
+            }
+            if (m_currentP2PLink.pendingMsgBytes == 0) {
+                continue;
+            }
+        }
+        uint32_t nbytes = m_currentP2PLink.pendingMsgBytes;
+        if (reader->UnconsumedBufferLength < nbytes) {
+            break;
+        }
+        m_currentP2PLink.pendingMsgBytes = 0;
+        /* Hand the reader's buffer to the parser as it is instead of copying it into an array */
+        IBuffer ^ buffer = reader->ReadBuffer(nbytes);
+        Microsoft::WRL::ComPtr<IBufferByteAccess> byteAccess;
+        reinterpret_cast<IInspectable*>(buffer)->QueryInterface(IID_PPV_ARGS(&byteAccess));
+        uint8_t* data = NULL;
+        if (!byteAccess || FAILED(byteAccess->Buffer(&data))) {
+            QCC_LogError(ER_FAIL, ("ProximityNameService::ConsumeMessages(): cannot access buffer"));
+            continue;
+        }
+#if DO_P2P_NAME_ADVERTISE
+        HandleProtocolMessage(data, nbytes, address);
+#endif
+    }
+    return true;
+}
+
 void ProximityNameService::SocketError(qcc::String& errMsg)
 {
     QCC_LogError(ER_FAIL, ("ProximityNameService::SocketError (%s)", errMsg.c_str()));
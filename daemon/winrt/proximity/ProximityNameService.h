@@ -61,6 +61,8 @@ ref class ProximityNameService sealed {
     static const uint32_t TRANSMIT_INTERVAL = 16 * 1000;     /**< The default interval of transmitting well-known name advertisement */
     static const uint32_t DEFAULT_DURATION = (20);           /**< The default lifetime of a found well-known name */
     static const uint32_t DEFAULT_PREASSOCIATION_TTL = 40;   /**< The default ttl used for the well-known names found during service pre-association. */
+    static const uint32_t READ_AHEAD_BYTES = 64 * 1024;      /**< The number of bytes each read on the proximity connection asks for */
+    static const uint32_t MAX_MESSAGE_BYTES = 64 * 1024;     /**< The largest protocol message accepted from a peer */
 
     enum ProximState {
         PROXIM_DISCONNECTED,                                 /**< Not connected to a peer */
@@ -81,6 +83,7 @@ ref class ProximityNameService sealed {
         Windows::Storage::Streams::DataReader ^ dataReader;     /**< The data reader associated with the current proximity stream socket connection */
         Windows::Storage::Streams::DataWriter ^ dataWriter;     /**< The data writer associated with the current proximity stream socket connection */
         bool socketClosed;                                      /**< Indicate whether the StreamSocket corresponds to the current P2P connection is closed */
+        uint32_t pendingMsgBytes;                               /**< Length of the protocol message whose length prefix has been read but whose body has not */
     };
 
     /**
@@ -161,10 +164,19 @@ ref class ProximityNameService sealed {
      * Reset the current proximity connection and start PeerFinder
      */
     void RestartPeerFinder();
+    /**
+     * Create the data reader and writer of a newly established proximity connection
+     */
+    void OpenLinkStreams();
     /**
      * Start the loop to read data over the created proximity connection
      */
     void StartReader();
+    /**
+     * Handle every complete protocol message buffered by the data reader
+     * @return false if a peer sent a message that is too large
+     */
+    bool ConsumeMessages();
     /**
      * Handle errors of the proximity stream socket
      */
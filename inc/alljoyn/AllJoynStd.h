@@ -32,7 +32,16 @@
 #define QCC_MODULE  "ALLJOYN"
 
 /** Daemon-to-daemon protocol version number */
-#define ALLJOYN_PROTOCOL_VERSION  6
+#define ALLJOYN_PROTOCOL_VERSION  7
+
+/**
+ * Reply signature of org.alljoyn.Bus.Introspectable.IntrospectCompact. The reply carries the same
+ * information as a shallow introspection XML document: the names of the child objects followed by
+ * an array of interfaces. Each interface is (name, annotations, members, properties) where a member
+ * is (type, name, signature, returnSignature, argNames, annotations) and a property is (name,
+ * signature, access, annotations).
+ */
+#define ALLJOYN_COMPACT_INTROSPECTION_SIG  "asa(sa{ss}a(ysssa{ss})a(ssya{ss}))"
 
 namespace ajn {
 
@@ -61,6 +70,11 @@ namespace Session {
 extern const char* InterfaceName;                      /**<Interface name */
 }
 }
+
+/** Interface definitions for org.alljoyn.Bus.Introspectable */
+namespace Introspectable {
+extern const char* InterfaceName;                      /**< Interface name */
+}
 }
 
 /** Interface definitions for org.alljoyn.Daemon */
@@ -157,6 +171,22 @@ QStatus CreateInterfaces(BusAttachment& bus);          /**< Create the org.alljo
 #define ALLJOYN_JOINSESSION_REPLY_FAILED              10   /**< JoinSession reply: Failed for unknown reason */
 // @}
 
+/**
+ * @name org.alljoyn.Bus.JoinSessions
+ *  Interface: org.alljoyn.Bus
+ *  Method: ARRAY(UINT32 status, UINT32 sessionId, SessionOpts outOpts) JoinSessions(ARRAY(String sessionHost, SessionPort sessionPort, SessionOptions inOpts))
+ *
+ * Join several sessions with one call. Joins to session hosts attached to the same daemon run one
+ * after another so they share a connection to that daemon; other joins run in parallel.
+ *
+ * In params:
+ *  joins    - The sessionHost, sessionPort and inOpts of each join, as for JoinSession.
+ *
+ * Out params:
+ *  results  - The status, sessionId and outOpts of each join, in the order of the joins. Status
+ *             is one of the ALLJOYN_JOINSESSION_REPLY_* values.
+ */
+
 /**
  * @anchor LeaveSessionReplyAnchor
  * @name org.alljoyn.Bus.LeaveSession
@@ -231,6 +261,19 @@ QStatus CreateInterfaces(BusAttachment& bus);          /**< Create the org.alljo
 #define ALLJOYN_FINDADVERTISEDNAME_REPLY_FAILED                 3   /**< FindAdvertisedName reply: Failed */
 // @}
 
+/**
+ * @name org.alljoyn.Bus.FindAdvertisedNameFiltered
+ *  Interface: org.alljoyn.Bus
+ *  Method: FindAdvertisedNameFiltered(String wellKnownNamePrefix, UINT16 transports, ARRAY(String) filters)
+ *
+ *  As org.alljoyn.Bus.FindAdvertisedNameByTransport but only names that match one of the filters are reported
+ *  to the caller. A filter is either an exact well-known name or a pattern where '*' matches any run of
+ *  characters and '?' matches any one character. An empty array removes the filters. Calling it again for the
+ *  same prefix replaces the filters.
+ *
+ *  Returns one of the ALLJOYN_FINDADVERTISEDNAME_REPLY_* status codes.
+ */
+
 /**
  * @name org.alljoyn.Bus.CancelFindAdvertisedName
  *  Interface: org.alljoyn.Bus
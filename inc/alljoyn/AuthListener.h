@@ -331,6 +331,24 @@ class AuthListener {
      */
     static QStatus VerifyCredentialsResponse(void* authContext, bool accept);
 
+    /**
+     * Optional method that lets an authentication mechanism remember credentials that
+     * VerifyCredentials() accepted. It is called after each accepted verification. While the
+     * credentials are remembered, the same credentials presented again are accepted without calling
+     * VerifyCredentials() again. Currently only ALLJOYN_RSA_KEYX uses this, for certificate chains.
+     * The peer must still prove it holds the private key on every authentication. Only return
+     * non-zero if accepting the credentials does not depend on the peer name. Call
+     * BusAttachment::ClearVerifiedCredentials() to forget remembered credentials, for example when
+     * a certificate is revoked.
+     *
+     * @param authMechanism  The name of the authentication mechanism that verified the credentials.
+     * @param credentials    The credentials that were accepted.
+     *
+     * @return  The number of seconds the credentials may be remembered or 0 (the default) to
+     *          verify the credentials every time.
+     */
+    virtual uint32_t VerifiedCredentialsLifetime(const char* authMechanism, const Credentials& credentials) { return 0; }
+
     /**
      * Optional method that if implemented allows an application to monitor security violations. This
      * function is called when an attempt to decrypt an encrypted messages failed or when an unencrypted
@@ -85,6 +85,20 @@ class BusAttachment : public MessageReceiver {
         virtual void SetLinkTimeoutCB(QStatus status, uint32_t timeout, void* context) = 0;
     };
 
+    /**
+     * One of the sessions to join with JoinSessionsAsync().
+     */
+    struct JoinRequest {
+        const char* sessionHost;     /**< Bus name of attachment that is hosting the session to be joined */
+        SessionPort sessionPort;     /**< SessionPort of sessionHost to be joined */
+        SessionListener* listener;   /**< Optional listener called when session related events occur. May be NULL. */
+        SessionOpts opts;            /**< Session options */
+        void* context;               /**< User defined context which will be passed as-is to the callback for this join */
+
+        /** Constructor */
+        JoinRequest() : sessionHost(NULL), sessionPort(0), listener(NULL), context(NULL) { }
+    };
+
     /**
      * Construct a BusAttachment.
      *
@@ -180,6 +194,131 @@ class BusAttachment : public MessageReceiver {
      */
     void EnableConcurrentCallbacks();
 
+    /**
+     * Enable or disable caching of introspection data. When enabled the introspection XML returned
+     * by a remote object is cached by bus name and object path, and ProxyBusObject::IntrospectRemoteObject()
+     * uses the cached XML for other proxies to the same object instead of calling the remote object
+     * again. Cached data for a bus name is discarded when the name changes owner. Applications
+     * whose remote objects add or remove child objects after they have been introspected should
+     * leave the cache disabled. The cache is disabled by default.
+     *
+     * @param enable   true to enable the introspection cache, false to disable and empty it.
+     */
+    void EnableIntrospectionCache(bool enable);
+
+    /**
+     * Enable or disable batching of outgoing signals. When enabled, small signals sent to the same
+     * destination and session are held back for up to maxDelay milliseconds and sent to the daemon
+     * together in a single message, which the daemon unpacks before routing them. This reduces the
+     * per-signal cost for applications that emit many small signals at a high rate. Signals that are
+     * encrypted, sessionless, carry handles or have a time-to-live are always sent on their own,
+     * and any other message sends the pending batch first so messages keep the order in which they
+     * were sent. Signals are only batched if the daemon supports it. Batching is disabled by default
+     * and has no effect when the bus attachment uses a bundled daemon.
+     *
+     * @param maxDelay  Longest time in milliseconds a signal may wait for a batch. Zero disables
+     *                  batching and sends any pending batch.
+     * @param maxBytes  Maximum number of bytes of signals in one batch, zero for the default of 16kB.
+     */
+    void EnableSignalBatching(uint32_t maxDelay, size_t maxBytes = 0);
+
+    /**
+     * Enable or disable profiling of the method and signal handlers registered with this bus
+     * attachment. When enabled, the number of calls, the time each handler ran and the time the
+     * message waited for a dispatcher thread before its handler was called are recorded for each
+     * interface member. A slow handler holds up the messages queued behind it, which shows as
+     * queueing delay on the other members. Profiling is disabled by default.
+     *
+     * @param enable   true to enable profiling, false to disable it. What has been recorded is kept.
+     * @param reset    true to clear what has been recorded.
+     */
+    void EnableHandlerProfiling(bool enable, bool reset = false);
+
+    /**
+     * Let synchronous method calls spin for their reply for a while before blocking. A calling
+     * thread that blocks has to be woken up by the thread that receives the reply, which can take
+     * longer than the round trip of a call to a bundled daemon or an object on the same bus
+     * attachment. Spinning trades processor time for that latency so it only pays off when replies
+     * usually arrive within the spin time. Spinning is disabled by default.
+     *
+     * @param spinTime  Longest time in microseconds to spin, zero to always block.
+     */
+    void EnableMethodCallSpin(uint32_t spinTime);
+
+    /** Scheduling policies for SetDispatchScheduling() */
+    typedef enum {
+        SCHEDULING_DEFAULT = 0,   /**< Time sharing at default priority */
+        SCHEDULING_FIFO = 1,      /**< Real-time first in first out (SCHED_FIFO) */
+        SCHEDULING_RR = 2         /**< Real-time round robin (SCHED_RR) */
+    } SchedulingPolicy;
+
+    /**
+     * Set the scheduling of the threads that deliver messages: the threads that call the method
+     * and signal handlers and the threads that read and write the connections to the daemon and
+     * to other peers. A real-time policy and a small set of reserved cpus bound the time a
+     * message waits behind other work on a loaded machine. The setting applies to every bus
+     * attachment in the process, a thread picks it up the next time it wakes. Real-time policies
+     * need privileges (CAP_SYS_NICE or an RLIMIT_RTPRIO allowance), threads that cannot be changed
+     * log an error and keep their scheduling. Only supported on POSIX platforms, cpu affinity only
+     * on Linux and Android.
+     *
+     * @param policy      The scheduling policy.
+     * @param priority    Real-time priority (1 to 99 on Linux), ignored for SCHEDULING_DEFAULT.
+     * @param cpuMask     Bit n set allows the threads to run on cpu n, zero for any cpu.
+     * @param lockMemory  true to lock all current and future memory of the process so that
+     *                    message delivery never waits for a page fault.
+     *
+     * @return
+     *      - #ER_OK if successful.
+     *      - #ER_BAD_ARG_2 if the priority is out of range for the policy.
+     *      - #ER_NOT_IMPLEMENTED if the platform does not support the request.
+     *      - #ER_OS_ERROR if the memory could not be locked, the scheduling is still set.
+     */
+    QStatus SetDispatchScheduling(SchedulingPolicy policy, int priority, uint64_t cpuMask = 0, bool lockMemory = false);
+
+    /**
+     * Get the handler profile recorded since profiling was enabled.
+     *
+     * @return  One line per interface member with its call count, total handler time, handler time
+     *          percentiles and queueing delay percentiles in microseconds, the members with the most
+     *          handler time first.
+     */
+    qcc::String GetHandlerProfile() const;
+
+    /**
+     * Keep a local copy of the owners of the bus names that start with a prefix so they can be
+     * looked up with GetCachedNameOwner() without a call to the daemon. The cache is filled with
+     * one ListNames call and a batch of GetNameOwner calls, and is then kept up to date from the
+     * NameOwnerChanged signals the daemon sends. Use ":" as the prefix to cache unique names.
+     * The cache is emptied when the bus attachment disconnects.
+     *
+     * @param prefix  Bus name prefix, for example "org.alljoyn.sample."
+     *
+     * @return
+     *      - #ER_OK if the names were cached or the prefix was already cached.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - An error status otherwise
+     */
+    QStatus AddNameOwnerCache(const char* prefix);
+
+    /**
+     * Stop caching the owners of the bus names that start with a prefix.
+     *
+     * @param prefix  Bus name prefix passed to AddNameOwnerCache().
+     */
+    void RemoveNameOwnerCache(const char* prefix);
+
+    /**
+     * Look up the owner of a bus name in the name owner cache.
+     *
+     * @param name        The bus name.
+     * @param[out] owner  The unique name of the owner, empty if the name has no owner.
+     *
+     * @return  true if the name is covered by a prefix passed to AddNameOwnerCache(), false if the
+     *          caller must ask the daemon.
+     */
+    bool GetCachedNameOwner(const char* name, qcc::String& owner);
+
     /**
      * Create an interface description with a given name.
      *
@@ -245,6 +384,26 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus CreateInterface(const char* name, InterfaceDescription*& iface, bool secure = false);
 
+    /**
+     * Add a statically defined interface to this bus attachment. The interface description is
+     * built from the table the first time any bus attachment in the process adds it and is then
+     * shared, already activated, by every bus attachment that adds the same table. Shared
+     * interfaces cannot be changed or deleted and are freed once the last bus attachment that
+     * added them is destroyed.
+     *
+     * @param table  The interface definition. The table must not change for as long as any bus
+     *               attachment has it.
+     * @param[out] iface
+     *      - The shared interface description
+     *      - NULL if cannot be created.
+     *
+     * @return
+     *      - #ER_OK if creation was successful.
+     *      - #ER_BUS_IFACE_ALREADY_EXISTS if an interface with the same name already exists
+     *      - An error status if the table does not describe a valid interface.
+     */
+    QStatus CreateInterface(const InterfaceDescription::StaticInterface& table, const InterfaceDescription*& iface);
+
     /**
      * Initialize one more interface descriptions from an XML string in DBus introspection format.
      * The root tag of the XML can be a \<node\> or a stand alone \<interface\> tag. To initialize more
@@ -718,6 +877,22 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus RegisterBusObject(BusObject& obj);
 
+    /**
+     * Register a batch of BusObjects, such as a whole object tree, at once. This is much faster
+     * than registering the objects one at a time: the objects are registered parents first, so
+     * parents in the batch never need placeholders, under one acquisition of the object lock and
+     * the ObjectRegistered() callbacks of the whole batch are made together.
+     *
+     * @param objects      The BusObjects to be registered, in any order.
+     * @param numObjects   The number of objects.
+     * @return
+     *      - #ER_OK if successful.
+     *      - #ER_BUS_BAD_OBJ_PATH if any object has a bad object path, no object is registered
+     *      - Another error if an object failed to register, objects with paths that sort before
+     *        it remain registered
+     */
+    QStatus RegisterBusObjects(BusObject** objects, size_t numObjects);
+
     /**
      * Unregister a BusObject
      *
@@ -1021,6 +1196,13 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus ClearKeys(const qcc::String& guid);
 
+    /**
+     * Forget the credentials that authentication mechanisms remembered because
+     * AuthListener::VerifiedCredentialsLifetime() allowed it. Credentials presented after this are
+     * verified again by AuthListener::VerifyCredentials(). Call this when a certificate is revoked.
+     */
+    void ClearVerifiedCredentials();
+
     /**
      * Set the expiration time on keys associated with a specific remote peer as identified by its
      * peer GUID. The peer GUID associated with a bus name can be obtained by calling GetPeerGUID().
@@ -1173,6 +1355,54 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus RemoveMatch(const char* rule);
 
+    /**
+     * Add several DBus match rules with one org.alljoyn.Bus.AddMatches method call to the local
+     * daemon. Each rule is added or fails on its own. If the local daemon predates AddMatches the
+     * rules are added with one AddMatch call each.
+     *
+     * @param[in]  rules      Match rules to be added (see DBus specification for format of these strings).
+     * @param[in]  numRules   Number of rules.
+     * @param[out] statuses   Optional array of numRules that receives the status of each rule.
+     *
+     * @return
+     *      - #ER_OK if every rule was added.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - The status of the first rule that failed, or of the method call itself.
+     */
+    QStatus AddMatches(const char** rules, size_t numRules, QStatus* statuses = NULL);
+
+    /**
+     * Remove several DBus match rules with one org.alljoyn.Bus.RemoveMatches method call to the
+     * local daemon. If the local daemon predates RemoveMatches the rules are removed with one
+     * RemoveMatch call each.
+     *
+     * @param[in]  rules      Match rules to be removed (see DBus specification for format of these strings).
+     * @param[in]  numRules   Number of rules.
+     * @param[out] statuses   Optional array of numRules that receives the status of each rule.
+     *
+     * @return
+     *      - #ER_OK if every rule was removed.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - The status of the first rule that failed, or of the method call itself.
+     */
+    QStatus RemoveMatches(const char** rules, size_t numRules, QStatus* statuses = NULL);
+
+    /**
+     * Replace all of the DBus match rules of this bus attachment, including those added with
+     * AddMatch(), in one step. Messages are never routed against part of the old and part of the
+     * new rules, and the old rules stay in place if any of the new ones is malformed.
+     *
+     * @param[in]  rules      The new match rules.
+     * @param[in]  numRules   Number of rules, 0 removes every rule.
+     *
+     * @return
+     *      - #ER_OK if the rules were replaced.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - #ER_BUS_REPLY_IS_ERROR_MESSAGE if the local daemon predates ReplaceMatches.
+     *      - Other error status codes indicating a failure.
+     */
+    QStatus ReplaceMatches(const char** rules, size_t numRules);
+
     /**
      * Advertise the existence of a well-known name to other (possibly disconnected) AllJoyn daemons.
      *
@@ -1307,6 +1537,29 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus FindAdvertisedNameByTransport(const char* namePrefix, TransportMask transports);
 
+    /**
+     * Register interest in a well-known name prefix over specified transports, but only be told
+     * about the names that match one of a set of filters.
+     *
+     * This method is a shortcut/helper that issues an org.alljoyn.Bus.FindAdvertisedNameFiltered method
+     * call to the local daemon and interprets the response. Calling it again for the same prefix
+     * replaces the filters. If the local daemon predates filtering this behaves like
+     * FindAdvertisedNameByTransport().
+     *
+     * @param[in]  namePrefix    Well-known name prefix that application is interested in receiving
+     *                           BusListener::FoundAdvertisedName notifications about.
+     * @param[in]  transports    Transports over which to do well-known name discovery
+     * @param[in]  filters       Well-known names, or patterns where '*' matches any run of characters
+     *                           and '?' any one character, that found names must match.
+     * @param[in]  numFilters    Number of entries in filters. 0 reports every name with the prefix.
+     *
+     * @return
+     *      - #ER_OK iff daemon response was received and discovery was successfully started.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - Other error status codes indicating a failure.
+     */
+    QStatus FindAdvertisedNameFiltered(const char* namePrefix, TransportMask transports, const char** filters, size_t numFilters);
+
     /**
      * Cancel interest in a well-known name prefix that was previously
      * registered with FindAdvertisedName. This cancels well-known name discovery over transports
@@ -1502,6 +1755,27 @@ class BusAttachment : public MessageReceiver {
                              BusAttachment::JoinSessionAsyncCB* callback,
                              void* context = NULL);
 
+    /**
+     * Join several sessions, for example all of the names reported by FoundAdvertisedName, with
+     * one org.alljoyn.Bus.JoinSessions method call to the local daemon. The daemon runs joins to
+     * hosts behind the same remote daemon over one connection and the other joins in parallel.
+     *
+     * This call executes asynchronously. When the response is received the callback is called
+     * once for each join, in the order of the requests, with the context of that join. If the
+     * local daemon predates JoinSessions each join is sent as a separate JoinSession call.
+     *
+     * @param[in]  requests         The sessions to join. The array may be freed once this returns.
+     * @param[in]  numRequests      Number of entries in requests.
+     * @param[in]  callback         Called when the response for each join is received.
+     *
+     * @return
+     *      - #ER_OK iff method call to local daemon was successful.
+     *      - #ER_BUS_NOT_CONNECTED if a connection has not been made with a local bus.
+     *      - #ER_BUS_BAD_BUS_NAME if a sessionHost is not a legal bus name.
+     *      - Other error status codes indicating a failure.
+     */
+    QStatus JoinSessionsAsync(const JoinRequest* requests, size_t numRequests, BusAttachment::JoinSessionAsyncCB* callback);
+
     /**
      * Set the SessionListener for an existing sessionId.
      *
@@ -1795,6 +2069,11 @@ class BusAttachment : public MessageReceiver {
      */
     void WaitStopInternal();
 
+    /**
+     * Send an AddMatches or RemoveMatches method call, see AddMatches() and RemoveMatches().
+     */
+    QStatus ChangeMatches(const char* method, const char** rules, size_t numRules, QStatus* statuses);
+
     /**
      * Try connect to the daemon with the spec.
      */
@@ -1810,6 +2089,11 @@ class BusAttachment : public MessageReceiver {
      */
     QStatus GetJoinSessionResponse(Message& reply, SessionId& sessionId, SessionOpts& opts);
 
+    /**
+     * Validate the status, sessionId and opts returned for one join by JoinSession or JoinSessions
+     */
+    QStatus GetJoinSessionResult(const MsgArg* replyArgs, SessionId& sessionId, SessionOpts& opts);
+
     qcc::String connectSpec;  /**< The connect spec used to connect to the bus */
     bool isStarted;           /**< Indicates if the bus has been started */
     bool isStopping;          /**< Indicates Stop has been called */
@@ -41,8 +41,58 @@ namespace ajn {
 /** @internal Forward references */
 class BusAttachment;
 class MethodTable;
+class BusObject;
 /// @endcond
 
+/**
+ * A SignalTemplate is used to emit the same signal repeatedly. The header of the signal
+ * (path, interface, member, destination, sender, signature and session) is marshaled on the
+ * first emit and reused for subsequent emits, so only the serial number and the body are
+ * marshaled each time. The header is rebuilt automatically if the bus attachment's unique
+ * name changes or the template is used with a different bus object.
+ *
+ * A SignalTemplate is not thread-safe, each thread that emits the signal should have its own.
+ * Signals with a time to live or with ALLJOYN_FLAG_COMPRESSED set are always fully marshaled.
+ */
+class SignalTemplate {
+
+    friend class BusObject;
+    friend class _Message;
+
+  public:
+
+    /**
+     * Constructor
+     *
+     * @param signal           Interface member of the signal that will be emitted.
+     * @param destination      The unique or well-known bus name or the signal recipient (NULL for broadcast signals)
+     * @param sessionId        The session the signal is for or 0.
+     * @param flags            Logical OR of the message flags for the signal, see BusObject::Signal().
+     */
+    SignalTemplate(const InterfaceDescription::Member& signal, const char* destination = NULL, SessionId sessionId = 0, uint8_t flags = 0);
+
+    /** Destructor */
+    ~SignalTemplate() { delete [] hdr; }
+
+  private:
+
+    const InterfaceDescription::Member& signal;   ///< The signal this template is for
+    qcc::String destination;                      ///< The destination or empty for broadcast signals
+    SessionId sessionId;                          ///< The session the signal is for
+    uint8_t flags;                                ///< Message flags for the signal
+
+    const BusObject* owner;                       ///< The bus object the current header was marshaled for
+    qcc::String sender;                           ///< The sender the current header was marshaled for
+    char endian;                                  ///< The endianess the current header was marshaled in
+    uint64_t* hdr;                                ///< The marshaled header or NULL
+    size_t hdrLen;                                ///< Length of the marshaled header in bytes
+    HeaderFields hdrFields;                       ///< The header fields, strings point into hdr
+
+    /* Private copy constructor and assignment operator to prevent copying */
+    SignalTemplate(const SignalTemplate& other);
+    SignalTemplate& operator=(const SignalTemplate& other);
+};
+
 /**
  * Message Bus Object base class
  */
@@ -166,6 +216,23 @@ class BusObject : public MessageReceiver {
      */
     void EmitPropChanged(const char* ifcName, const char* propName, MsgArg& val, SessionId id);
 
+    /**
+     * Coalesce the PropertiesChanged signals sent by EmitPropChanged(). While a window is set the
+     * changes are queued and the changes made within one window to properties of the same
+     * interface and session are sent as a single PropertiesChanged signal when the window
+     * expires. Only the last value of a property that changes more than once is sent.
+     *
+     * @param windowMs  Coalescing window in milliseconds. 0 (the default) sends a signal for each
+     *                  change and also sends any queued changes immediately.
+     */
+    void SetPropChangedCoalescing(uint32_t windowMs);
+
+    /**
+     * Immediately send the PropertiesChanged signals for any changes queued by
+     * EmitPropChanged() while coalescing.
+     */
+    void FlushPropChanged();
+
     /**
      * Get a reference to the underlying BusAttachment
      *
@@ -247,6 +314,25 @@ class BusObject : public MessageReceiver {
                    uint8_t flags = 0,
                    Message* msg = NULL);
 
+    /**
+     * Emit a signal described by a SignalTemplate. This is equivalent to calling the Signal()
+     * method above with the destination, session and flags of the template but avoids marshaling
+     * the header for every emit.
+     *
+     * @param signalTemplate   The template for the signal being emitted.
+     * @param args             The arguments for the signal (can be NULL)
+     * @param numArgs          The number of arguments
+     * @param msg              [OUT] If non-null, the sent signal message is returned to the caller.
+     * @return
+     *      - #ER_OK if successful
+     *      - #ER_BUS_OBJECT_NOT_REGISTERED if bus object has not yet been registered
+     *      - An error status otherwise
+     */
+    QStatus Signal(SignalTemplate& signalTemplate,
+                   const MsgArg* args = NULL,
+                   size_t numArgs = 0,
+                   Message* msg = NULL);
+
     /**
      * Remove sessionless message sent from this object from local daemon's
      * store/forward cache.
@@ -265,6 +351,27 @@ class BusObject : public MessageReceiver {
      */
     QStatus CancelSessionlessMessage(const Message& msg) { return CancelSessionlessMessage(msg->GetCallSerial()); }
 
+    /**
+     * Request that remote method calls to this object are delivered to its method handlers one
+     * at a time and in the order they were received, independently of the method and signal
+     * handlers of other objects. Calls to other objects are not held up while a handler of this
+     * object is running, so unrelated objects can handle method calls in parallel, up to the
+     * concurrency the BusAttachment was created with.
+     *
+     * By default, all handlers are serialized on the BusAttachment unless a handler calls
+     * BusAttachment::EnableConcurrentCallbacks().
+     *
+     * @param serialize   true to serialize method calls per object.
+     */
+    void SetSerializedMethodCalls(bool serialize);
+
+    /**
+     * Indicate whether method calls to this object are serialized per object.
+     *
+     * @return true if SetSerializedMethodCalls(true) was called on this object.
+     */
+    bool HasSerializedMethodCalls() const;
+
   protected:
 
     /**
@@ -587,6 +694,19 @@ class BusObject : public MessageReceiver {
      */
     virtual void Introspect(const InterfaceDescription::Member* member, Message& msg);
 
+    /**
+     * Default handler for a bus attempt to read the object's introspection data as message
+     * arguments rather than XML.
+     * @remark
+     * A derived class that overrides GenerateIntrospection() to customize the introspection XML
+     * should also override this function so peers that prefer the compact form see the same
+     * description. If overridden the custom handler must compose an appropriate reply message.
+     *
+     * @param member   Identifies the @c org.alljoyn.Bus.Introspectable.IntrospectCompact method.
+     * @param msg      The Introspectable.IntrospectCompact request.
+     */
+    virtual void IntrospectCompact(const InterfaceDescription::Member* member, Message& msg);
+
     /**
      * This method can be overridden to provide access to the context registered in the AddMethodHandler() call.
      *
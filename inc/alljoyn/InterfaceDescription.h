@@ -73,6 +73,7 @@ class InterfaceDescription {
 
     friend class BusAttachment;
     friend class XmlHelper;
+    friend class StaticInterfaceTable;
 
   public:
 
@@ -238,6 +239,54 @@ class InterfaceDescription {
         bool operator==(const Property& o) const;
     };
 
+    /**
+     * A member of a statically defined interface. The fields are the arguments to AddMember().
+     */
+    struct StaticMember {
+        AllJoynMessageType type;       /**< #MESSAGE_METHOD_CALL or #MESSAGE_SIGNAL */
+        const char* name;              /**< %Member name */
+        const char* inputSig;          /**< Signature of input parameters or NULL for none */
+        const char* outSig;            /**< Signature of output parameters or NULL for none */
+        const char* argNames;          /**< Comma separated list of arg names or NULL */
+        uint8_t annotation;            /**< Annotation flags */
+        const char* accessPerms;       /**< Required permissions to invoke this call or NULL */
+    };
+
+    /**
+     * A property of a statically defined interface. The fields are the arguments to AddProperty().
+     */
+    struct StaticProperty {
+        const char* name;              /**< %Property name */
+        const char* signature;         /**< %Property type */
+        uint8_t access;                /**< #PROP_ACCESS_READ, #PROP_ACCESS_WRITE, or #PROP_ACCESS_RW */
+    };
+
+    /**
+     * A statically defined interface. Tables of this type are plain aggregates so they can be
+     * written out as constant data, for example by a code generator working from introspection
+     * XML, and need no code to run at startup:
+     *
+     *     @code
+     *     static const InterfaceDescription::StaticMember members[] = {
+     *         { MESSAGE_METHOD_CALL, "Ping", "s", "s", "in,out", 0, NULL },
+     *         { MESSAGE_SIGNAL,      "Chirp", "s", NULL, "msg", 0, NULL }
+     *     };
+     *     static const InterfaceDescription::StaticInterface table = {
+     *         "org.alljoyn.Example", false, members, sizeof(members) / sizeof(members[0]), NULL, 0
+     *     };
+     *     @endcode
+     *
+     * See BusAttachment::CreateInterface(const StaticInterface&, const InterfaceDescription*&).
+     */
+    struct StaticInterface {
+        const char* name;                     /**< Fully qualified interface name */
+        bool secure;                          /**< true if the interface is secure */
+        const StaticMember* members;          /**< The members of the interface */
+        size_t numMembers;                    /**< Number of entries in members */
+        const StaticProperty* properties;     /**< The properties of the interface, may be NULL */
+        size_t numProperties;                 /**< Number of entries in properties */
+    };
+
     /**
      * Add a member to the interface.
      *
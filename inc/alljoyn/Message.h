@@ -36,6 +36,14 @@
 namespace ajn {
 
 static const size_t ALLJOYN_MAX_NAME_LEN   =     255;  /*!<  The maximum length of certain bus names */
+
+/*
+ * A message is always routed, authorized and (if encrypted) authenticated as a whole so every
+ * message, including its body, must fit in a single buffer. Data that is larger than
+ * ALLJOYN_MAX_ARRAY_LEN, for example a firmware image, should be streamed over a raw session
+ * (SessionOpts::TRAFFIC_RAW_RELIABLE) using the socket returned by BusAttachment::GetSessionFd()
+ * rather than split across many method calls.
+ */
 static const size_t ALLJOYN_MAX_ARRAY_LEN  =  131072;  /*!<  DBus limits array length to 2^26. AllJoyn limits it to 2^17 */
 static const size_t ALLJOYN_MAX_PACKET_LEN =  (ALLJOYN_MAX_ARRAY_LEN + 4096);  /*!<  DBus limits packet length to 2^27. AllJoyn limits it further to 2^17 + 4096 to allow for 2^17 payload */
 
@@ -56,6 +64,8 @@ static const uint8_t ALLJOYN_FLAG_NO_REPLY_EXPECTED  = 0x01;
 static const uint8_t ALLJOYN_FLAG_AUTO_START         = 0x02;
 /** Allow messages from remote hosts (valid only in Hello message) */
 static const uint8_t ALLJOYN_FLAG_ALLOW_REMOTE_MSG   = 0x04;
+/** Body is compressed (valid only on bus-to-bus links that negotiated body compression) */
+static const uint8_t ALLJOYN_FLAG_BODY_COMPRESSED    = 0x08;
 /** Sessionless message  */
 static const uint8_t ALLJOYN_FLAG_SESSIONLESS        = 0x10;
 /** Global (bus-to-bus) broadcast */
@@ -121,6 +131,13 @@ class HeaderFields {
      */
     MsgArg field[ALLJOYN_HDR_FIELD_UNKNOWN];
 
+    /**
+     * @internal
+     * Interned atoms for the path, interface and member header fields. An entry is zero if
+     * the atom has not been computed for the current value of the field.
+     */
+    uint32_t atoms[ALLJOYN_HDR_FIELD_UNKNOWN];
+
     /**
      * Table to identify which header fields can be compressed.
      */
@@ -141,7 +158,14 @@ class HeaderFields {
     qcc::String ToString(size_t indent =  0) const;
 
     /** Default constructor */
-    HeaderFields() { }
+    HeaderFields() { ClearAtoms(); }
+
+    /** @internal Invalidate the interned atoms, must be called whenever a header field is changed */
+    void ClearAtoms() {
+        for (size_t i = 0; i < ALLJOYN_HDR_FIELD_UNKNOWN; ++i) {
+            atoms[i] = 0;
+        }
+    }
 
     /** Copy constructor */
     HeaderFields(const HeaderFields& other);
@@ -157,6 +181,10 @@ class HeaderFields {
 class _Message;
 class _RemoteEndpoint;
 class BusAttachment;
+class BusObject;
+class MsgArgArena;
+class SignalTemplate;
+class ValidationCache;
 
 /**
  * @cond ALLJOYN_DEV
@@ -183,12 +211,16 @@ class _Message {
     friend class ProxyBusObject;
     friend class EndpointAuth;
     friend class _RemoteEndpoint;
+    friend class TxQueue;
     friend class _LocalEndpoint;
     friend class _NullEndpoint;
     friend class DaemonRouter;
     friend class AllJoynObj;
     friend class DeferredMsg;
     friend class AllJoynPeerObj;
+    friend class SignalBatcher;
+    friend class SessionlessObj;
+    friend class MessageCapture;
 
   public:
     /**
@@ -746,6 +778,26 @@ class _Message {
                       uint8_t flags,
                       uint16_t timeToLive);
 
+    /**
+     * @internal
+     * Compose a signal message using the header saved in a signal template. The header is
+     * marshaled and saved in the template the first time or if it is out of date.
+     *
+     * @param signalTemplate  The template for the signal.
+     * @param sender          The bus object sending the signal.
+     * @param objPath         The object path of the sender.
+     * @param args            The signal argument list (can be NULL)
+     * @param numArgs         The number of arguments
+     * @return
+     *      - #ER_OK if successful
+     *      - An error status otherwise
+     */
+    QStatus SignalMsg(SignalTemplate& signalTemplate,
+                      const BusObject* sender,
+                      const qcc::String& objPath,
+                      const MsgArg* args,
+                      size_t numArgs);
+
 
     /**
      * @internal
@@ -790,6 +842,19 @@ class _Message {
      */
     QStatus ReadNonBlocking(RemoteEndpoint& endpoint, bool checkSender, bool pedantic = true);
 
+    /**
+     * @internal
+     * Load a complete marshaled message from a buffer instead of reading it from an endpoint. The
+     * message must then be unmarshaled with Unmarshal() just like a message that was read.
+     *
+     * @param buf   The marshaled message.
+     * @param len   The length of the marshaled message, this must match the lengths in its header.
+     * @return
+     *      - #ER_OK if successful
+     *      - #ER_BUS_BAD_HEADER_LEN or #ER_BUS_BAD_BODY_LEN if the lengths are inconsistent
+     */
+    QStatus LoadBytes(const uint8_t* buf, size_t len);
+
     /**
      * @internal
      * Unmarshals a message from a remote endpoint. Only the message header is unmarshaled at this
@@ -821,21 +886,28 @@ class _Message {
      * Deliver a marshaled message to a remote endpoint. Non-blocking
      *
      * @param endpoint   Endpoint to receive marshaled message.
+     * @param linkTtl    Time-to-live in milliseconds the message's session gives it on the link
+     *                   or 0. The shorter of this and the message's own time-to-live is passed
+     *                   to the sink.
      * @return
      *      - #ER_OK if successful
      *      - An error status otherwise
      */
-    QStatus DeliverNonBlocking(RemoteEndpoint& endpoint);
+    QStatus DeliverNonBlocking(RemoteEndpoint& endpoint, uint32_t linkTtl = 0);
     /**
      * @internal
      * Marshal the message again with the new sender name if one was provided.
      *
-     * @param senderName  Option sender name to replace the current sender name in the message.
+     * @param senderName    Option sender name to replace the current sender name in the message.
+     * @param changedField  The only header field that has changed since the message was marshaled
+     *                      or ALLJOYN_HDR_FIELD_UNKNOWN if that is not known. If a sender name is
+     *                      provided this is ALLJOYN_HDR_FIELD_SENDER. The other header fields are
+     *                      copied rather than marshaled again when possible.
      * @return
      *      - #ER_OK if successful
      *      - An error status otherwise
      */
-    QStatus ReMarshal(const char* senderName = NULL);
+    QStatus ReMarshal(const char* senderName = NULL, uint32_t changedField = ALLJOYN_HDR_FIELD_UNKNOWN);
 
     /**
      * @internal
@@ -924,11 +996,17 @@ class _Message {
 
     bool endianSwap;             ///< true if endianness will be swapped.
 
+    bool sigVerified;            ///< true while parsing values whose signature has already been checked.
+
+    int32_t verifiedArgs;        ///< Number of complete types in the body signature if it is known to be valid, otherwise -1.
+
     MessageHeader msgHeader;     ///< Current message header.
     uint8_t* _msgBuf;            ///< Pointer to the current msg buffer.
     uint64_t* msgBuf;            ///< Pointer to the current msg buffer (8 byte aligned pointer into _msgBuf).
     MsgArg* msgArgs;             ///< Pointer to the unmarshaled arguments.
     uint8_t numMsgArgs;          ///< Number of message args (signature cannot be longer than 255 chars).
+    MsgArgArena* argArena;       ///< Holds the MsgArgs nested inside the unmarshaled message args.
+    bool parsingBody;            ///< true while unmarshaling the body, nested MsgArgs come from argArena.
 
     size_t bufSize;              ///< The current allocated size of the msg buffer.
     uint8_t* bufEOD;             ///< End of data currently in buffer.
@@ -937,6 +1015,7 @@ class _Message {
 
     uint16_t ttl;                ///< Time to live (units of seconds for sessionless. MS for everything else)
     uint32_t timestamp;          ///< Timestamp (local time) for messages with a ttl (time to live).
+    uint64_t rxTimestamp;        ///< Latency clock time at which the daemon unmarshaled this message, 0 if not recorded.
 
     qcc::String replySignature;  ///< Expected reply signature for a method call
 
@@ -963,13 +1042,25 @@ class _Message {
      */
     HeaderFields hdrFields;
 
+    /**
+     * Make sure this message has exclusive use of its buffer before the buffer is modified.
+     * Copies of a message share the same buffer until one of them needs to change it.
+     *
+     * @param copyLen  The number of bytes from the start of the message that need to be copied if
+     *                 the buffer is shared, the default copies all of it. Callers that are about to
+     *                 overwrite the rest of the buffer pass a shorter length to skip that copy.
+     */
+    void MakeBufWritable(size_t copyLen = (size_t)-1);
+
     /* Internal methods unmarshal side */
 
     void ClearHeader();
+    void ClearArgs();
     QStatus ParseValue(MsgArg* arg, const char*& sigPtr, bool arrayElem = false);
     QStatus ParseStruct(MsgArg* arg, const char*& sigPtr);
     QStatus ParseDictEntry(MsgArg* arg, const char*& sigPtr);
     QStatus ParseArray(MsgArg* arg, const char*& sigPtr);
+    QStatus ParseFixedStructArray(MsgArg* arg, const char* elemSig, size_t elemSigLen, uint32_t len, size_t structSize, uint32_t numMembers);
     QStatus ParseSignature(MsgArg* arg);
     QStatus ParseVariant(MsgArg* arg);
 
@@ -978,17 +1069,42 @@ class _Message {
      * is successfully unmarshaled.
      *
      * @param pedantic   Perform more detailed checks on the header fields.
+     * @param cache      Values already checked on the endpoint the message was received on or
+     *                   NULL to check every value.
      *
      * @return
      *      - #ER_OK if the header fields are valid
      *      - an error indicating why it is not.
      */
-    QStatus HeaderChecks(bool pedantic);
+    QStatus HeaderChecks(bool pedantic, ValidationCache* cache = NULL);
+
+    /**
+     * Replace a compressed body received on a bus-to-bus link by the expanded body.
+     *
+     * @return
+     *      - #ER_OK if the body was expanded
+     *      - #ER_BUS_BAD_BODY_LEN if the compressed body is corrupt
+     */
+    QStatus ExpandBody();
 
     /* Internal methods marshal side */
 
     QStatus EncryptMessage();
 
+    /**
+     * Check if the body is worth compressing for a bus-to-bus link that negotiated body
+     * compression. Encrypted bodies and small bodies are not.
+     */
+    bool IsBodyCompressible() const;
+
+    /**
+     * Replace the body by a compressed copy. The original buffer is left untouched since it may
+     * be shared with copies of this message that are delivered to other endpoints.
+     *
+     * @return  true if the body was compressed, false if it did not shrink enough to be worth it.
+     */
+    bool CompressBody();
+
     QStatus MarshalMessage(const qcc::String& signature,
                            const qcc::String& destination,
                            AllJoynMessageType msgType,
@@ -998,7 +1114,9 @@ class _Message {
                            SessionId sessionId);
 
     QStatus MarshalArgs(const MsgArg* arg, size_t numArgs);
+    void MarshalHeaderField(uint32_t fieldId);
     void MarshalHeaderFields();
+    bool ReMarshalHeaderField(uint32_t fieldId);
     size_t ComputeHeaderLen();
 
     /**
@@ -1012,6 +1130,65 @@ class _Message {
     QStatus PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic = true, uint32_t timeout = 0);
 };
 
+/**
+ * The arguments of a received message kept valid beyond the message handler without copying
+ * them.
+ *
+ * Strings and scalar arrays in unmarshaled arguments point directly into the received message
+ * buffer. A RetainedArgs holds a reference to the message, and through it to the buffer, so
+ * the arguments stay valid for as long as any copy of the RetainedArgs exists. Copying a
+ * RetainedArgs only copies the reference so it is cheap to hand to another thread.  Calling
+ * MsgArg::Stabilize() is only needed if the arguments must outlive the message itself.
+ *
+ * The arguments are read-only and the message must not be unmarshaled again while it is
+ * retained.
+ */
+class RetainedArgs {
+  public:
+
+    /**
+     * Retain the arguments of a message.
+     *
+     * @param msg   The message, it must have been unmarshaled.
+     */
+    RetainedArgs(const Message& msg) : msg(msg), numArgs(0), args(NULL) { this->msg->GetArgs(numArgs, args); }
+
+    /**
+     * Get the number of arguments.
+     *
+     * @return  The number of arguments.
+     */
+    size_t GetNumArgs() const { return numArgs; }
+
+    /**
+     * Get the arguments.
+     *
+     * @return  The arguments or NULL if there are none.
+     */
+    const MsgArg* GetArgs() const { return args; }
+
+    /**
+     * Get one argument.
+     *
+     * @param argN  The index of the argument to get.
+     *
+     * @return  The argument or NULL if there is no such argument.
+     */
+    const MsgArg* GetArg(size_t argN = 0) const { return (argN < numArgs) ? &args[argN] : NULL; }
+
+    /**
+     * Get the message the arguments belong to.
+     *
+     * @return  The message.
+     */
+    const Message& GetMessage() const { return msg; }
+
+  private:
+    Message msg;            /**< The reference that keeps the message buffer alive */
+    size_t numArgs;         /**< Number of arguments */
+    const MsgArg* args;     /**< The message's arguments */
+};
+
 }
 
 #endif
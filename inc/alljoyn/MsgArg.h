@@ -30,6 +30,13 @@
 #include <stdarg.h>
 #include <alljoyn/Status.h>
 
+/**
+ * Defined if the compiler supports rvalue references so MsgArgs can be moved rather than copied.
+ */
+#if !defined(ALLJOYN_HAS_MOVE_SEMANTICS) && ((__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1600)))
+#define ALLJOYN_HAS_MOVE_SEMANTICS 1
+#endif
+
 namespace ajn {
 
 /**
@@ -228,6 +235,8 @@ typedef struct {
  * additional memory is allocated for an #ALLJOYN_STRING that references an existing const char*.
  * If a MsgArg is assigned the destination receives a copy of the contents of the source. The
  * Stabilize() methods can also be called to explicitly force contents of the MsgArg to be copied.
+ * Swap() and, where the compiler supports it, move construction and move assignment transfer the
+ * contents of a MsgArg without copying the data it already owns.
  */
 class MsgArg {
     friend class _Message;
@@ -348,6 +357,46 @@ class MsgArg {
      */
     MsgArg(const MsgArg& other) : typeId(ALLJOYN_INVALID) { Clone(*this, other); }
 
+#if defined(ALLJOYN_HAS_MOVE_SEMANTICS)
+    /**
+     * Move constructor. The data and nested MsgArgs owned by the source are transferred and the
+     * source is left invalid. Like a copy the result is stable, anything the source referenced
+     * but did not own is copied. Copying can allocate so the move may throw, containers such
+     * as std::vector therefore still copy their elements when they grow.
+     *
+     * @param other  The source MsgArg for the move
+     */
+    MsgArg(MsgArg&& other) : typeId(ALLJOYN_INVALID), flags(0) {
+        v_invalid.unused[0] = v_invalid.unused[1] = v_invalid.unused[2] = NULL;
+        Swap(other);
+        Stabilize();
+    }
+
+    /**
+     * Move assignment operator. See the move constructor.
+     *
+     * @param other  The source MsgArg for the move
+     *
+     * @return  The assigned MsgArg
+     */
+    MsgArg& operator=(MsgArg&& other) {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+            Stabilize();
+        }
+        return *this;
+    }
+#endif
+
+    /**
+     * Exchange the contents of two MsgArgs, including the ownership of the data and nested
+     * MsgArgs they reference. Nothing is copied.
+     *
+     * @param other  The MsgArg to exchange contents with
+     */
+    void Swap(MsgArg& other);
+
     /**
      * Destructor
      */
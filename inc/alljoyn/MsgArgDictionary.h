@@ -0,0 +1,167 @@
+#ifndef _ALLJOYN_MSGARGDICTIONARY_H
+#define _ALLJOYN_MSGARGDICTIONARY_H
+/**
+ * @file
+ * This file defines an indexed view for looking up the entries of a dictionary MsgArg by key.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MsgArgDictionary.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/MsgArgs.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * A view of a dictionary MsgArg (an array of dictionary entries such as the a{sv} returned by
+ * ProxyBusObject::GetAllProperties) that finds entries by key in constant time. MsgArg::GetElement()
+ * parses the element signature and walks the array on every call, a view hashes the keys the
+ * first time it is used and afterwards only looks up one slot of the hash table per key.
+ *
+ * The view references the entries of the dictionary rather than copying them so the dictionary
+ * must not be changed or freed while the view is in use. Keys may be strings, object paths,
+ * signatures or integers (including booleans); dictionaries with double keys are not indexed and
+ * report ER_BUS_SIGNATURE_MISMATCH. If a key appears more than once the first entry is found, as
+ * with GetElement(). Like MsgArg a view is not thread-safe.
+ *
+ *     @code
+ *     MsgArg props;
+ *     proxy.GetAllProperties("org.example.Device", props);
+ *     MsgArgDictionary dict(props);
+ *     uint32_t version;
+ *     qcc::String name;
+ *     if ((dict.Get("Version", version) == ER_OK) && (dict.Get("Name", name) == ER_OK)) {
+ *         ...
+ *     }
+ *     @endcode
+ */
+class MsgArgDictionary {
+  public:
+
+    /**
+     * Create a view of a dictionary. The dictionary is not indexed until the first lookup.
+     *
+     * @param dict   The dictionary, which must outlive the view.
+     */
+    MsgArgDictionary(const MsgArg& dict);
+
+    /**
+     * Check that the MsgArg is a dictionary that can be indexed.
+     *
+     * @return
+     *      - #ER_OK if it is.
+     *      - #ER_BUS_NOT_A_DICTIONARY if the MsgArg is not an array of dictionary entries.
+     *      - #ER_BUS_SIGNATURE_MISMATCH if the keys cannot be indexed.
+     */
+    QStatus GetStatus() const;
+
+    /**
+     * @return  The number of entries in the dictionary.
+     */
+    size_t Size() const { return IsDictionary() ? dict.v_array.GetNumElements() : 0; }
+
+    /**
+     * Find the value for a string, object path or signature key.
+     *
+     * @param key   The key.
+     *
+     * @return  The value of the entry, with any variants resolved away, or NULL if there is no
+     *          such entry or the dictionary does not have keys of this kind.
+     */
+    const MsgArg* Find(const char* key) const;
+
+    /**
+     * Find the value for an integer or boolean key. Signed keys are sign extended, so the key -1
+     * finds the entry whose int32 key is -1.
+     *
+     * @param key   The key.
+     *
+     * @return  The value of the entry, with any variants resolved away, or NULL if there is no
+     *          such entry or the dictionary does not have keys of this kind.
+     */
+    const MsgArg* FindInteger(int64_t key) const;
+
+    /**
+     * Get the value for a string, object path or signature key as a C++ type, see MsgArgType.
+     *
+     * @param key       The key.
+     * @param[out] val  The value.
+     *
+     * @return
+     *      - #ER_OK if the value was returned.
+     *      - #ER_BUS_ELEMENT_NOT_FOUND if the key was not found in the dictionary.
+     *      - #ER_BUS_SIGNATURE_MISMATCH if the value is not of type T.
+     *      - The error from GetStatus() if the dictionary cannot be indexed.
+     */
+    template <typename T>
+    QStatus Get(const char* key, T& val) const { return Unpack(Find(key), val); }
+
+    /**
+     * Get the value for an integer or boolean key as a C++ type, see MsgArgType.
+     *
+     * @param key       The key.
+     * @param[out] val  The value.
+     *
+     * @return  As for Get().
+     */
+    template <typename T>
+    QStatus GetInteger(int64_t key, T& val) const { return Unpack(FindInteger(key), val); }
+
+  private:
+
+    /**
+     * Assignment operator is private.
+     */
+    MsgArgDictionary& operator=(const MsgArgDictionary& other);
+
+    bool IsDictionary() const { return (dict.typeId == ALLJOYN_ARRAY) && dict.v_array.GetElemSig() && (dict.v_array.GetElemSig()[0] == '{'); }
+
+    /** Build the hash table if it has not been built yet */
+    void Index() const;
+
+    /** Return the slot for a key, str and len for string keys or num for integer keys. The slot holds the index of the entry plus one or 0 if it is empty */
+    size_t FindSlot(uint32_t hash, const char* str, size_t len, uint64_t num) const;
+
+    template <typename T>
+    QStatus Unpack(const MsgArg* val, T& out) const
+    {
+        if (!val) {
+            QStatus status = GetStatus();
+            return (status == ER_OK) ? ER_BUS_ELEMENT_NOT_FOUND : status;
+        }
+        return MsgArgType<T>::Unpack(*val, out);
+    }
+
+    const MsgArg& dict;                   /**< The dictionary */
+    char keyType;                         /**< Signature character of the keys */
+    mutable bool indexed;                 /**< True once slots has been built */
+    mutable std::vector<uint32_t> slots;  /**< Open addressing hash table of entry index plus one */
+};
+
+}
+
+#endif
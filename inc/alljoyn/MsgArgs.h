@@ -0,0 +1,530 @@
+#ifndef _ALLJOYN_MSGARGS_H
+#define _ALLJOYN_MSGARGS_H
+/**
+ * @file
+ * This file defines typed helpers for packing C++ values into MsgArgs and unpacking them again.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MsgArgs.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * Maps a C++ type onto an AllJoyn type. Only the specializations below are defined so packing or
+ * unpacking a type that has no AllJoyn equivalent fails to compile.
+ *
+ * Each specialization provides:
+ *  - AppendSignature(sig) which appends the signature of the type to sig.
+ *  - Pack(arg, val) which sets arg to val without parsing a signature.
+ *  - Unpack(arg, val) which checks the type of arg and copies its value to val.
+ *  - IsScalar which is non-zero if a std::vector of the type maps onto a scalar array.
+ */
+template <typename T>
+struct MsgArgType;
+
+/**
+ * @internal
+ * Specializations for the scalar types. Vectors of these types are packed as scalar arrays that
+ * reference the vector's storage.
+ */
+#define ALLJOYN_SCALAR_ARG_TYPE(T, TYPE_ID, MEMBER)                                               \
+    template <>                                                                                   \
+    struct MsgArgType<T> {                                                                        \
+        enum { IsScalar = 1 };                                                                    \
+        static void AppendSignature(qcc::String& sig) { sig += static_cast<char>(TYPE_ID); }      \
+        static QStatus Pack(MsgArg& arg, T val)                                                   \
+        {                                                                                         \
+            arg.Clear();                                                                          \
+            arg.typeId = TYPE_ID;                                                                 \
+            arg.MEMBER = val;                                                                     \
+            return ER_OK;                                                                         \
+        }                                                                                         \
+        static QStatus Unpack(const MsgArg& arg, T& val)                                          \
+        {                                                                                         \
+            if (arg.typeId != TYPE_ID) {                                                          \
+                return ER_BUS_SIGNATURE_MISMATCH;                                                 \
+            }                                                                                     \
+            val = arg.MEMBER;                                                                     \
+            return ER_OK;                                                                         \
+        }                                                                                         \
+        static QStatus PackVector(MsgArg& arg, const std::vector<T>& vec)                         \
+        {                                                                                         \
+            arg.Clear();                                                                          \
+            arg.typeId = static_cast<AllJoynTypeId>((TYPE_ID << 8) | ALLJOYN_ARRAY);              \
+            arg.v_scalarArray.numElements = vec.size();                                           \
+            arg.v_scalarArray.MEMBER = vec.empty() ? NULL : &vec[0];                              \
+            return ER_OK;                                                                         \
+        }                                                                                         \
+        static QStatus UnpackVector(const MsgArg& arg, std::vector<T>& vec)                       \
+        {                                                                                         \
+            if (arg.typeId != static_cast<AllJoynTypeId>((TYPE_ID << 8) | ALLJOYN_ARRAY)) {       \
+                return ER_BUS_SIGNATURE_MISMATCH;                                                 \
+            }                                                                                     \
+            const T* elems = arg.v_scalarArray.MEMBER;                                            \
+            vec.assign(elems, elems + arg.v_scalarArray.numElements);                             \
+            return ER_OK;                                                                         \
+        }                                                                                         \
+    }
+
+ALLJOYN_SCALAR_ARG_TYPE(uint8_t, ALLJOYN_BYTE, v_byte);
+ALLJOYN_SCALAR_ARG_TYPE(int16_t, ALLJOYN_INT16, v_int16);
+ALLJOYN_SCALAR_ARG_TYPE(uint16_t, ALLJOYN_UINT16, v_uint16);
+ALLJOYN_SCALAR_ARG_TYPE(int32_t, ALLJOYN_INT32, v_int32);
+ALLJOYN_SCALAR_ARG_TYPE(uint32_t, ALLJOYN_UINT32, v_uint32);
+ALLJOYN_SCALAR_ARG_TYPE(int64_t, ALLJOYN_INT64, v_int64);
+ALLJOYN_SCALAR_ARG_TYPE(uint64_t, ALLJOYN_UINT64, v_uint64);
+ALLJOYN_SCALAR_ARG_TYPE(double, ALLJOYN_DOUBLE, v_double);
+
+#undef ALLJOYN_SCALAR_ARG_TYPE
+
+/**
+ * Booleans. std::vector<bool> does not store an array of bool so vectors of booleans are copied
+ * when they are packed.
+ */
+template <>
+struct MsgArgType<bool> {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += 'b'; }
+    static QStatus Pack(MsgArg& arg, bool val)
+    {
+        arg.Clear();
+        arg.typeId = ALLJOYN_BOOLEAN;
+        arg.v_bool = val;
+        return ER_OK;
+    }
+    static QStatus Unpack(const MsgArg& arg, bool& val)
+    {
+        if (arg.typeId != ALLJOYN_BOOLEAN) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        val = arg.v_bool;
+        return ER_OK;
+    }
+};
+
+template <>
+struct MsgArgType<std::vector<bool> > {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += "ab"; }
+    static QStatus Pack(MsgArg& arg, const std::vector<bool>& vec)
+    {
+        arg.Clear();
+        bool* elems = vec.empty() ? NULL : new bool[vec.size()];
+        for (size_t i = 0; i < vec.size(); ++i) {
+            elems[i] = vec[i];
+        }
+        arg.typeId = ALLJOYN_BOOLEAN_ARRAY;
+        arg.v_scalarArray.numElements = vec.size();
+        arg.v_scalarArray.v_bool = elems;
+        arg.SetOwnershipFlags(MsgArg::OwnsData);
+        return ER_OK;
+    }
+    static QStatus Unpack(const MsgArg& arg, std::vector<bool>& vec)
+    {
+        if (arg.typeId != ALLJOYN_BOOLEAN_ARRAY) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        vec.assign(arg.v_scalarArray.v_bool, arg.v_scalarArray.v_bool + arg.v_scalarArray.numElements);
+        return ER_OK;
+    }
+};
+
+/**
+ * Strings. A packed string references the caller's string which must not change or go away until
+ * the MsgArg has been marshaled or stabilized.
+ */
+template <>
+struct MsgArgType<qcc::String> {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += 's'; }
+    static QStatus Pack(MsgArg& arg, const qcc::String& val)
+    {
+        arg.Clear();
+        arg.typeId = ALLJOYN_STRING;
+        arg.v_string.str = val.c_str();
+        arg.v_string.len = val.size();
+        return ER_OK;
+    }
+    static QStatus Unpack(const MsgArg& arg, qcc::String& val)
+    {
+        if (arg.typeId != ALLJOYN_STRING) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        val = qcc::String(arg.v_string.str, arg.v_string.len);
+        return ER_OK;
+    }
+};
+
+template <>
+struct MsgArgType<std::string> {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += 's'; }
+    static QStatus Pack(MsgArg& arg, const std::string& val)
+    {
+        arg.Clear();
+        arg.typeId = ALLJOYN_STRING;
+        arg.v_string.str = val.c_str();
+        arg.v_string.len = val.size();
+        return ER_OK;
+    }
+    static QStatus Unpack(const MsgArg& arg, std::string& val)
+    {
+        if (arg.typeId != ALLJOYN_STRING) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        val.assign(arg.v_string.str, arg.v_string.len);
+        return ER_OK;
+    }
+};
+
+/**
+ * Unpacking a const char* returns a pointer into the MsgArg.
+ */
+template <>
+struct MsgArgType<const char*> {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += 's'; }
+    static QStatus Pack(MsgArg& arg, const char* val)
+    {
+        if (!val) {
+            return ER_BAD_ARG_2;
+        }
+        arg.Clear();
+        arg.typeId = ALLJOYN_STRING;
+        arg.v_string.str = val;
+        arg.v_string.len = strlen(val);
+        return ER_OK;
+    }
+    static QStatus Unpack(const MsgArg& arg, const char*& val)
+    {
+        if (arg.typeId != ALLJOYN_STRING) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        val = arg.v_string.str;
+        return ER_OK;
+    }
+};
+
+/**
+ * @internal
+ * Vectors of non-scalar types are packed as arrays of MsgArgs owned by the array.
+ */
+template <typename T, int IsScalar>
+struct MsgArgVector {
+    static QStatus Pack(MsgArg& arg, const std::vector<T>& vec)
+    {
+        qcc::String elemSig;
+        MsgArgType<T>::AppendSignature(elemSig);
+        MsgArg* elems = vec.empty() ? NULL : new MsgArg[vec.size()];
+        QStatus status = ER_OK;
+        for (size_t i = 0; (status == ER_OK) && (i < vec.size()); ++i) {
+            status = MsgArgType<T>::Pack(elems[i], vec[i]);
+        }
+        arg.Clear();
+        if (status == ER_OK) {
+            arg.typeId = ALLJOYN_ARRAY;
+            status = arg.v_array.SetElements(elemSig.c_str(), vec.size(), elems);
+        }
+        if (status == ER_OK) {
+            arg.SetOwnershipFlags(MsgArg::OwnsArgs);
+        } else {
+            arg.Clear();
+            delete [] elems;
+        }
+        return status;
+    }
+    static QStatus Unpack(const MsgArg& arg, std::vector<T>& vec)
+    {
+        if (arg.typeId != ALLJOYN_ARRAY) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        /* Checking the element signature catches mismatches in arrays that are empty */
+        qcc::String elemSig;
+        MsgArgType<T>::AppendSignature(elemSig);
+        if (elemSig != arg.v_array.GetElemSig()) {
+            return ER_BUS_SIGNATURE_MISMATCH;
+        }
+        size_t numElems = arg.v_array.GetNumElements();
+        const MsgArg* elems = arg.v_array.GetElements();
+        vec.resize(numElems);
+        QStatus status = ER_OK;
+        for (size_t i = 0; (status == ER_OK) && (i < numElems); ++i) {
+            status = MsgArgType<T>::Unpack(elems[i], vec[i]);
+        }
+        return status;
+    }
+};
+
+/**
+ * @internal
+ * Vectors of scalar types are packed as scalar arrays.
+ */
+template <typename T>
+struct MsgArgVector<T, 1> {
+    static QStatus Pack(MsgArg& arg, const std::vector<T>& vec) { return MsgArgType<T>::PackVector(arg, vec); }
+    static QStatus Unpack(const MsgArg& arg, std::vector<T>& vec) { return MsgArgType<T>::UnpackVector(arg, vec); }
+};
+
+/**
+ * Arrays of any supported type.
+ */
+template <typename T>
+struct MsgArgType<std::vector<T> > {
+    enum { IsScalar = 0 };
+    static void AppendSignature(qcc::String& sig) { sig += 'a'; MsgArgType<T>::AppendSignature(sig); }
+    static QStatus Pack(MsgArg& arg, const std::vector<T>& vec) { return MsgArgVector<T, MsgArgType<T>::IsScalar>::Pack(arg, vec); }
+    static QStatus Unpack(const MsgArg& arg, std::vector<T>& vec) { return MsgArgVector<T, MsgArgType<T>::IsScalar>::Unpack(arg, vec); }
+};
+
+/**
+ * Typed alternatives to MsgArg::Set() and MsgArg::Get(). The AllJoyn types are derived from the
+ * C++ types at compile time so no signature is parsed and no varargs are walked, and passing a
+ * value of the wrong type is a compile error rather than a runtime failure. For example
+ *
+ *     @code
+ *     MsgArg args[3];
+ *     size_t numArgs = 3;
+ *     std::vector<double> readings;
+ *     QStatus status = MsgArgs::Pack(args, numArgs, int32_t(7), qcc::String("sensor"), readings);
+ *     @endcode
+ *
+ * sets args to the same values as MsgArg::Set(args, numArgs, "isad", ...) would, and
+ * MsgArgs::Signature<int32_t, qcc::String, std::vector<double> >() returns "isad".
+ *
+ * Like MsgArg::Set(), packed MsgArgs reference strings and scalar vectors rather than copying
+ * them so those values must not change until the args have been marshaled or stabilized.
+ */
+class MsgArgs {
+
+  public:
+
+    /**
+     * Compute the AllJoyn signature for a list of C++ types.
+     *
+     * @return  The signature, e.g. "isad" for int32_t, qcc::String, std::vector<double>.
+     */
+    template <typename A1>
+    static qcc::String Signature()
+    {
+        qcc::String sig;
+        MsgArgType<A1>::AppendSignature(sig);
+        return sig;
+    }
+
+    template <typename A1, typename A2>
+    static qcc::String Signature()
+    {
+        qcc::String sig = Signature<A1>();
+        MsgArgType<A2>::AppendSignature(sig);
+        return sig;
+    }
+
+    template <typename A1, typename A2, typename A3>
+    static qcc::String Signature()
+    {
+        qcc::String sig = Signature<A1, A2>();
+        MsgArgType<A3>::AppendSignature(sig);
+        return sig;
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4>
+    static qcc::String Signature()
+    {
+        qcc::String sig = Signature<A1, A2, A3>();
+        MsgArgType<A4>::AppendSignature(sig);
+        return sig;
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4, typename A5>
+    static qcc::String Signature()
+    {
+        qcc::String sig = Signature<A1, A2, A3, A4>();
+        MsgArgType<A5>::AppendSignature(sig);
+        return sig;
+    }
+
+    /**
+     * Set a single MsgArg from a C++ value.
+     *
+     * @param arg  The MsgArg to set.
+     * @param a1   The value.
+     *
+     * @return  ER_OK if the arg was set.
+     */
+    template <typename A1>
+    static QStatus Pack(MsgArg& arg, const A1& a1) { return MsgArgType<A1>::Pack(arg, a1); }
+
+    /**
+     * Set an array of MsgArgs from C++ values, one MsgArg per value.
+     *
+     * @param args     The MsgArgs to set.
+     * @param numArgs  [IN,OUT] The number of MsgArgs available on input, the number set on output.
+     * @param a1...    The values.
+     *
+     * @return
+     *      - #ER_OK if the args were set.
+     *      - #ER_BUS_TRUNCATED if there are fewer args than values.
+     *      - An error status otherwise.
+     */
+    template <typename A1>
+    static QStatus Pack(MsgArg* args, size_t& numArgs, const A1& a1)
+    {
+        if (numArgs < 1) {
+            return ER_BUS_TRUNCATED;
+        }
+        return PackN(args, numArgs, 1, Pack(args[0], a1));
+    }
+
+    template <typename A1, typename A2>
+    static QStatus Pack(MsgArg* args, size_t& numArgs, const A1& a1, const A2& a2)
+    {
+        if (numArgs < 2) {
+            return ER_BUS_TRUNCATED;
+        }
+        size_t n = 1;
+        QStatus status = Pack(args, n, a1);
+        return PackN(args, numArgs, 2, (status == ER_OK) ? Pack(args[1], a2) : status);
+    }
+
+    template <typename A1, typename A2, typename A3>
+    static QStatus Pack(MsgArg* args, size_t& numArgs, const A1& a1, const A2& a2, const A3& a3)
+    {
+        if (numArgs < 3) {
+            return ER_BUS_TRUNCATED;
+        }
+        size_t n = 2;
+        QStatus status = Pack(args, n, a1, a2);
+        return PackN(args, numArgs, 3, (status == ER_OK) ? Pack(args[2], a3) : status);
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4>
+    static QStatus Pack(MsgArg* args, size_t& numArgs, const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+    {
+        if (numArgs < 4) {
+            return ER_BUS_TRUNCATED;
+        }
+        size_t n = 3;
+        QStatus status = Pack(args, n, a1, a2, a3);
+        return PackN(args, numArgs, 4, (status == ER_OK) ? Pack(args[3], a4) : status);
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4, typename A5>
+    static QStatus Pack(MsgArg* args, size_t& numArgs, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5)
+    {
+        if (numArgs < 5) {
+            return ER_BUS_TRUNCATED;
+        }
+        size_t n = 4;
+        QStatus status = Pack(args, n, a1, a2, a3, a4);
+        return PackN(args, numArgs, 5, (status == ER_OK) ? Pack(args[4], a5) : status);
+    }
+
+    /**
+     * Get a C++ value from a single MsgArg.
+     *
+     * @param arg  The MsgArg to unpack.
+     * @param a1   [OUT] Receives the value.
+     *
+     * @return
+     *      - #ER_OK if the value was unpacked.
+     *      - #ER_BUS_SIGNATURE_MISMATCH if the arg does not have the type of the value.
+     */
+    template <typename A1>
+    static QStatus Unpack(const MsgArg& arg, A1& a1) { return MsgArgType<A1>::Unpack(arg, a1); }
+
+    /**
+     * Get C++ values from an array of MsgArgs, for example the args of a received message.
+     *
+     * @param args     The MsgArgs to unpack.
+     * @param numArgs  The number of MsgArgs, this must match the number of values.
+     * @param a1...    [OUT] Receive the values.
+     *
+     * @return
+     *      - #ER_OK if the values were unpacked.
+     *      - #ER_BUS_SIGNATURE_MISMATCH if the args do not match the types of the values.
+     */
+    template <typename A1>
+    static QStatus Unpack(const MsgArg* args, size_t numArgs, A1& a1)
+    {
+        return (numArgs == 1) ? Unpack(args[0], a1) : ER_BUS_SIGNATURE_MISMATCH;
+    }
+
+    template <typename A1, typename A2>
+    static QStatus Unpack(const MsgArg* args, size_t numArgs, A1& a1, A2& a2)
+    {
+        QStatus status = (numArgs == 2) ? Unpack(args[0], a1) : ER_BUS_SIGNATURE_MISMATCH;
+        return (status == ER_OK) ? Unpack(args[1], a2) : status;
+    }
+
+    template <typename A1, typename A2, typename A3>
+    static QStatus Unpack(const MsgArg* args, size_t numArgs, A1& a1, A2& a2, A3& a3)
+    {
+        QStatus status = (numArgs == 3) ? Unpack(args, 2, a1, a2) : ER_BUS_SIGNATURE_MISMATCH;
+        return (status == ER_OK) ? Unpack(args[2], a3) : status;
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4>
+    static QStatus Unpack(const MsgArg* args, size_t numArgs, A1& a1, A2& a2, A3& a3, A4& a4)
+    {
+        QStatus status = (numArgs == 4) ? Unpack(args, 3, a1, a2, a3) : ER_BUS_SIGNATURE_MISMATCH;
+        return (status == ER_OK) ? Unpack(args[3], a4) : status;
+    }
+
+    template <typename A1, typename A2, typename A3, typename A4, typename A5>
+    static QStatus Unpack(const MsgArg* args, size_t numArgs, A1& a1, A2& a2, A3& a3, A4& a4, A5& a5)
+    {
+        QStatus status = (numArgs == 5) ? Unpack(args, 4, a1, a2, a3, a4) : ER_BUS_SIGNATURE_MISMATCH;
+        return (status == ER_OK) ? Unpack(args[4], a5) : status;
+    }
+
+  private:
+
+    /*
+     * Report how many args were set. On failure no args are reported as set.
+     */
+    static QStatus PackN(MsgArg* args, size_t& numArgs, size_t n, QStatus status)
+    {
+        if (status == ER_OK) {
+            numArgs = n;
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                args[i].Clear();
+            }
+            numArgs = 0;
+        }
+        return status;
+    }
+};
+
+}
+
+#endif
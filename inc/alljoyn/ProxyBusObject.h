@@ -287,6 +287,24 @@ class ProxyBusObject : public MessageReceiver {
      */
     QStatus GetAllProperties(const char* iface, MsgArg& values, uint32_t timeout = DefaultCallTimeout) const;
 
+    /**
+     * Get several properties from an interface on the remote object. The Get requests are sent
+     * back-to-back so this takes one round trip rather than one per property.
+     *
+     * @param iface          Name of interface to retrieve the properties from.
+     * @param properties     The names of the properties to get.
+     * @param[out] values    Property values, one per property name.
+     * @param[out] statuses  Optional status for each property, the same as GetProperty() would return (can be NULL).
+     * @param numProperties  The number of properties.
+     * @param timeout        Timeout specified in milliseconds to wait for the replies
+     *
+     * @return
+     *      - #ER_OK if all of the properties were obtained.
+     *      - #ER_BUS_OBJECT_NO_SUCH_INTERFACE if the no such interface on this remote object.
+     *      - The status for the first property that could not be obtained otherwise.
+     */
+    QStatus GetProperties(const char* iface, const char** properties, MsgArg* values, QStatus* statuses, size_t numProperties, uint32_t timeout = DefaultCallTimeout) const;
+
     /**
      * Make an asynchronous request to get all properties from an interface on the remote object.
      *
@@ -309,6 +327,30 @@ class ProxyBusObject : public MessageReceiver {
                                   void* context,
                                   uint32_t timeout = DefaultCallTimeout);
 
+    /**
+     * Answer GetProperty() and GetAllProperties() calls for an interface from a local cache. The
+     * cache is filled with one GetAll call and kept up to date from the PropertiesChanged signals
+     * emitted by the remote object, so only properties annotated with
+     * org.freedesktop.DBus.Property.EmitsChangedSignal are cached. Other properties are still read
+     * from the remote object.
+     *
+     * @param iface    Name of the interface whose properties are cached.
+     * @param timeout  Timeout specified in milliseconds to wait for the GetAll reply
+     *
+     * @return
+     *      - #ER_OK if the cache was filled or was already enabled.
+     *      - #ER_BUS_OBJECT_NO_SUCH_INTERFACE if the no such interface on this remote object.
+     *      - An error status otherwise
+     */
+    QStatus EnablePropertyCache(const char* iface, uint32_t timeout = DefaultCallTimeout);
+
+    /**
+     * Stop caching the properties of an interface and discard the cached values.
+     *
+     * @param iface  Name of the interface whose properties were cached.
+     */
+    void DisablePropertyCache(const char* iface);
+
     /**
      * Set a property on an interface on the remote object.
      *
@@ -327,6 +369,24 @@ class ProxyBusObject : public MessageReceiver {
      */
     QStatus SetProperty(const char* iface, const char* property, MsgArg& value, uint32_t timeout = DefaultCallTimeout) const;
 
+    /**
+     * Set several properties on an interface on the remote object. The Set requests are sent
+     * back-to-back so this takes one round trip rather than one per property.
+     *
+     * @param iface          Remote object's interface on which the properties are defined.
+     * @param properties     The names of the properties to set.
+     * @param values         The values to set, one per property name.
+     * @param[out] statuses  Optional status for each property, the same as SetProperty() would return (can be NULL).
+     * @param numProperties  The number of properties.
+     * @param timeout        Timeout specified in milliseconds to wait for the replies
+     *
+     * @return
+     *      - #ER_OK if all of the properties were set
+     *      - #ER_BUS_OBJECT_NO_SUCH_INTERFACE if the specified interfaces does not exist on the remote object.
+     *      - The status for the first property that could not be set otherwise.
+     */
+    QStatus SetProperties(const char* iface, const char** properties, MsgArg* values, QStatus* statuses, size_t numProperties, uint32_t timeout = DefaultCallTimeout) const;
+
     /**
      * Make an asynchronous request to set a property on an interface on the remote object.
      * A callback function reports the success or failure of ther operation.
@@ -761,6 +821,47 @@ class ProxyBusObject : public MessageReceiver {
         return MethodCallAsync(method, NULL, NULL, args, numArgs, NULL, 0, flags |= ALLJOYN_FLAG_NO_REPLY_EXPECTED);
     }
 
+    /**
+     * A method call that is made as part of a batch by MethodCallBatch().
+     */
+    struct BatchedCall {
+        const InterfaceDescription::Member* method; /**< Method being invoked */
+        const MsgArg* args;                         /**< The arguments for the method call (can be NULL) */
+        size_t numArgs;                             /**< The number of arguments */
+        uint8_t flags;                              /**< Logical OR of the message flags for this method call */
+        QStatus status;                             /**< [OUT] Status of this method call, the same as MethodCall() would return */
+        Message replyMsg;                           /**< [OUT] The reply message received for this method call */
+
+        /**
+         * Constructor
+         *
+         * @param bus      The bus the method call is made on.
+         * @param method   Method being invoked.
+         * @param args     The arguments for the method call (can be NULL)
+         * @param numArgs  The number of arguments
+         * @param flags    Logical OR of the message flags for this method call.
+         */
+        BatchedCall(BusAttachment& bus, const InterfaceDescription::Member& method, const MsgArg* args = NULL, size_t numArgs = 0, uint8_t flags = 0) :
+            method(&method), args(args), numArgs(numArgs), flags(flags), status(ER_OK), replyMsg(bus) { }
+    };
+
+    /**
+     * Make a batch of method calls from this object. All of the method calls are marshaled and
+     * sent without waiting for replies and this call returns once every method call has been
+     * replied to or has timed out. This saves a round trip per call compared to making the same
+     * calls one at a time with MethodCall().
+     *
+     * @param calls     The method calls to make. The status and replyMsg of each entry is set when
+     *                  this call returns.
+     * @param numCalls  The number of method calls
+     * @param timeout   Timeout specified in milliseconds to wait for the reply to each method call
+     *
+     * @return
+     *      - #ER_OK if every method call succeeded and every reply message type is #MESSAGE_METHOD_RET
+     *      - The status of the first method call that failed otherwise
+     */
+    QStatus MethodCallBatch(BatchedCall* calls, size_t numCalls, uint32_t timeout = DefaultCallTimeout) const;
+
     /**
      * Make an asynchronous method call from this object
      *
@@ -931,12 +1032,37 @@ class ProxyBusObject : public MessageReceiver {
      */
     void SyncReplyHandler(Message& msg, void* context);
 
+    /**
+     * @internal
+     * Method return handler used to process batched method calls.
+     *
+     * @param msg     Method return message
+     * @param context Opaque context passed from method_call to method_return
+     */
+    void BatchReplyHandler(Message& msg, void* context);
+
     /**
      * @internal
      * Introspection method_reply handler. (Internal use only)
      */
     void IntrospectMethodCB(Message& message, void* context);
 
+    /**
+     * @internal
+     * Compact introspection method_reply handler. (Internal use only)
+     */
+    void IntrospectCompactMethodCB(Message& message, void* context);
+
+    /**
+     * @internal
+     * Update this proxy object from a reply to org.alljoyn.Bus.Introspectable.IntrospectCompact.
+     *
+     * @param reply  The method reply.
+     *
+     * @return ER_OK if the reply was successfully parsed.
+     */
+    QStatus ParseCompact(Message& reply);
+
     /**
      * @internal
      * GetProperty method_reply handler. (Internal use only)
@@ -955,6 +1081,36 @@ class ProxyBusObject : public MessageReceiver {
      */
     void SetPropMethodCB(Message& message, void* context);
 
+    /**
+     * @internal
+     * PropertiesChanged signal handler that keeps the property cache up to date. (Internal use only)
+     */
+    void PropertiesChangedHandler(const InterfaceDescription::Member* member, const char* srcPath, Message& msg);
+
+    /**
+     * @internal
+     * Look up a property in the property cache.
+     *
+     * @return  true if the property was found in the cache.
+     */
+    bool GetCachedProperty(const char* iface, const char* property, MsgArg& value) const;
+
+    /**
+     * @internal
+     * Store or discard a property value in the property cache if caching is enabled for the interface.
+     *
+     * @param value  The property value or NULL to discard the cached value.
+     */
+    void CacheProperty(const char* iface, const char* property, const MsgArg* value) const;
+
+    /**
+     * @internal
+     * Build the reply to GetAllProperties() from the property cache.
+     *
+     * @return  true if every readable property of the interface was found in the cache.
+     */
+    bool GetCachedProperties(const InterfaceDescription* ifc, MsgArg& values) const;
+
     /**
      * @internal
      * Set the B2B endpoint to use for all communication with remote object.
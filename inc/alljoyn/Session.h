@@ -74,6 +74,57 @@ class SessionOpts {
     /** Allowed Transports  */
     TransportMask transports;
 
+    /**@name Transmit queue */
+    // {@
+    /**
+     * Policy applied by the daemon to this session's messages when the transmit queue of an
+     * endpoint carrying the session is full or the session reached its own limits. The
+     * limits and policy only govern the session's messages; the endpoint as a whole keeps the
+     * daemon's configured limits, which are also the most a session can ask for. A session
+     * sharing an endpoint with other sessions cannot disconnect it, TXQUEUE_DISCONNECT drops
+     * the session's newest message instead.
+     */
+    typedef enum {
+        TXQUEUE_BLOCK              = 0x00,   /**< Block the sender until there is room in the queue */
+        TXQUEUE_DROP_OLDEST_SIGNAL = 0x01,   /**< Discard the oldest queued signal to make room */
+        TXQUEUE_DROP_NEWEST        = 0x02,   /**< Discard the message being queued */
+        TXQUEUE_DISCONNECT         = 0x03    /**< Disconnect the slow consumer */
+    } TxQueuePolicy;
+    TxQueuePolicy txQueuePolicy;   /**< Policy applied when the transmit queue is full */
+    uint32_t txQueueMaxMessages;   /**< Most of this session's messages queued on an endpoint (0 means daemon default) */
+    uint32_t txQueueMaxBytes;      /**< Most bytes of this session's messages queued on an endpoint (0 means daemon default) */
+
+    /**
+     * Priority of this session's messages when they share a bus-to-bus link with other traffic.
+     * Messages of one priority are always sent in order; daemon link maintenance goes ahead of
+     * both.
+     */
+    typedef enum {
+        TXPRIORITY_INTERACTIVE = 0x00,   /**< Sent ahead of bulk traffic */
+        TXPRIORITY_BULK        = 0x01    /**< Sent only when no other traffic is waiting */
+    } TxPriority;
+    TxPriority txPriority;         /**< Transmit priority of the session */
+    uint32_t txRateLimit;          /**< Maximum rate in bytes per second the session may send over a bus-to-bus link (0 means no limit) */
+
+    /**
+     * Time-to-live in milliseconds of the session's messages on a bus-to-bus link that sends
+     * messages as packets (the ICE transport). A message that has not been delivered when its
+     * time-to-live runs out is dropped rather than retransmitted, so later messages are not held
+     * back behind it. Messages with a shorter time-to-live of their own keep it. 0 means the
+     * session's messages are delivered reliably unless they set a time-to-live themselves.
+     */
+    uint32_t txMessageTtl;
+    // @}
+
+    /**
+     * Request a direct path for a point-to-point message session between two attachments
+     * connected to the same daemon. When both the session creator and the joiner ask for it the
+     * daemon hands each of them one end of a socket pair and session messages then bypass the
+     * daemon. The daemon still handles joining, leaving and session loss. Messages are not
+     * subject to the daemon's policy checks while they travel on the direct path.
+     */
+    bool isDirect;
+
     /**
      * Construct a SessionOpts with specific parameters.
      *
@@ -122,7 +173,14 @@ class SessionOpts {
         traffic(traffic),
         isMultipoint(isMultipoint),
         proximity(proximity),
-        transports(transports)
+        transports(transports),
+        txQueuePolicy(TXQUEUE_BLOCK),
+        txQueueMaxMessages(0),
+        txQueueMaxBytes(0),
+        txPriority(TXPRIORITY_INTERACTIVE),
+        txRateLimit(0),
+        txMessageTtl(0),
+        isDirect(false)
     { }
 
     /**
@@ -132,7 +190,8 @@ class SessionOpts {
      * cpp/Chat/Chat/MainPage.xaml.cpp @n
      * csharp/chat/chat/MainPage.xaml.cs @n
      */
-    SessionOpts() : traffic(TRAFFIC_MESSAGES), isMultipoint(false), proximity(PROXIMITY_ANY), transports(TRANSPORT_ANY) { }
+    SessionOpts() : traffic(TRAFFIC_MESSAGES), isMultipoint(false), proximity(PROXIMITY_ANY), transports(TRANSPORT_ANY),
+        txQueuePolicy(TXQUEUE_BLOCK), txQueueMaxMessages(0), txQueueMaxBytes(0), txPriority(TXPRIORITY_INTERACTIVE), txRateLimit(0), txMessageTtl(0), isDirect(false) { }
 
     /**
      * Determine whether this SessionOpts is compatible with the SessionOpts offered by other
@@ -142,7 +201,8 @@ class SessionOpts {
      *  - traffic type
      *  - proximity type
      *
-     * Note that multipoint support is not a condition of compatibility
+     * Note that multipoint support and the transmit queue settings are not conditions of
+     * compatibility
      *
      * @param other  Options to be compared against this one.
      * @return true iff this SessionOpts can use the option set offered by other.
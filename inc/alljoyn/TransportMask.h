@@ -38,6 +38,7 @@ const TransportMask TRANSPORT_WWAN      = 0x0008;   /**< Wireless wide-area netw
 const TransportMask TRANSPORT_LAN       = 0x0010;   /**< Wired local-area network transport */
 const TransportMask TRANSPORT_ICE       = 0x0020;   /**< Transport using ICE protocol */
 const TransportMask TRANSPORT_WFD       = 0x0080;   /**< Transport using Wi-Fi Direct transport */
+const TransportMask TRANSPORT_UDP       = 0x0100;   /**< Transport using PacketEngine over UDP */
 
 /**
  * A constant indicating that any transport is acceptable.
@@ -23,6 +23,10 @@
 
 #include <string.h>
 
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
 #include <qcc/Debug.h>
 #include <qcc/Crypto.h>
 #include <qcc/KeyBlob.h>
@@ -41,6 +45,98 @@ namespace ajn {
 
 const size_t Crypto::MACLength = 8;
 
+/*
+ * Expanding the AES key schedule costs about as much as encrypting a short message so each thread
+ * keeps the ciphers for the few keys it used most recently. A message is encrypted or decrypted on
+ * the thread that is marshaling or unmarshaling it so the cached ciphers are never shared.
+ */
+static const size_t NUM_CACHED_CIPHERS = 4;
+
+struct CipherCache {
+    struct Entry {
+        uint8_t key[Crypto_AES::AES128_SIZE];
+        Crypto_AES* aes;
+    } entries[NUM_CACHED_CIPHERS];
+
+    CipherCache() { memset(entries, 0, sizeof(entries)); }
+
+    ~CipherCache()
+    {
+        for (size_t i = 0; i < NUM_CACHED_CIPHERS; ++i) {
+            delete entries[i].aes;
+        }
+        memset(entries, 0, sizeof(entries));
+    }
+
+    /* Returns the cipher for a key moving it to the front, the least recently used entry is evicted on a miss */
+    Crypto_AES* Get(const KeyBlob& keyBlob)
+    {
+        size_t i;
+        for (i = 0; i < NUM_CACHED_CIPHERS; ++i) {
+            if (entries[i].aes && (memcmp(entries[i].key, keyBlob.GetData(), sizeof(entries[i].key)) == 0)) {
+                break;
+            }
+        }
+        if (i == NUM_CACHED_CIPHERS) {
+            --i;
+            delete entries[i].aes;
+            memcpy(entries[i].key, keyBlob.GetData(), sizeof(entries[i].key));
+            entries[i].aes = new Crypto_AES(keyBlob, Crypto_AES::CCM);
+        }
+        Entry hit = entries[i];
+        memmove(&entries[1], &entries[0], i * sizeof(Entry));
+        entries[0] = hit;
+        return hit.aes;
+    }
+};
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/* Called on thread exit to delete the thread's cached ciphers */
+static void ReleaseCipherCache(void* arg)
+{
+    delete reinterpret_cast<CipherCache*>(arg);
+}
+
+static pthread_key_t cipherKey;
+static bool cipherKeyValid = (pthread_key_create(&cipherKey, ReleaseCipherCache) == 0);
+
+static CipherCache* GetCipherCache()
+{
+    if (!cipherKeyValid) {
+        return NULL;
+    }
+    CipherCache* cache = reinterpret_cast<CipherCache*>(pthread_getspecific(cipherKey));
+    if (!cache) {
+        cache = new CipherCache;
+        if (pthread_setspecific(cipherKey, cache) != 0) {
+            delete cache;
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+#else
+
+/* Per-thread cipher caches are only implemented for posix, other platforms expand the key for every message */
+static CipherCache* GetCipherCache()
+{
+    return NULL;
+}
+
+#endif
+
+/*
+ * Returns the cached cipher for a key or NULL if there is no cache or the key is not a 128 bit AES
+ * key in which case the caller must construct a cipher for the message.
+ */
+static Crypto_AES* GetCachedCipher(const KeyBlob& keyBlob)
+{
+    CipherCache* cache = (keyBlob.GetSize() == Crypto_AES::AES128_SIZE) ? GetCipherCache() : NULL;
+    return cache ? cache->Get(keyBlob) : NULL;
+}
+
 static qcc::String ConcatenateCompressedFields(uint8_t* hdr, size_t hdrLen, const HeaderFields& hdrFields)
 {
     qcc::String result((char*)hdr, hdrLen, 256);
@@ -82,13 +178,14 @@ static qcc::String ConcatenateCompressedFields(uint8_t* hdr, size_t hdrLen, cons
     return result;
 }
 
-QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
+QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen, const uint8_t* srcBody)
 {
     QStatus status;
     switch (keyBlob.GetType()) {
     case KeyBlob::AES:
     {
         uint8_t* body = msgBuf + hdrLen;
+        const uint8_t* src = srcBody ? srcBody : body;
         uint8_t nd[5];
         uint32_t serial = message.GetCallSerial();
 
@@ -102,17 +199,22 @@ QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
         QCC_DbgHLPrintf(("Encrypt key:   %s", BytesToHexString(keyBlob.GetData(), keyBlob.GetSize()).c_str()));
         QCC_DbgHLPrintf(("        nonce: %s", BytesToHexString(nonce.GetData(), nonce.GetSize()).c_str()));
 
-        Crypto_AES aes(keyBlob, Crypto_AES::CCM);
+        Crypto_AES* uncached = NULL;
+        Crypto_AES* aes = GetCachedCipher(keyBlob);
+        if (!aes) {
+            aes = uncached = new Crypto_AES(keyBlob, Crypto_AES::CCM);
+        }
         if (message.GetFlags() & ALLJOYN_FLAG_COMPRESSED) {
             /*
              * To prevent an attack where the attacker sends a bogus expansion rule we
              * authenticate the compressed headers even though we won't be sending them.
              */
             qcc::String extHdr = ConcatenateCompressedFields(msgBuf, hdrLen, message.GetHeaderFields());
-            status = aes.Encrypt_CCM(body, body, bodyLen, nonce, extHdr.data(), extHdr.size(), MACLength);
+            status = aes->Encrypt_CCM(src, body, bodyLen, nonce, extHdr.data(), extHdr.size(), MACLength);
         } else {
-            status = aes.Encrypt_CCM(body, body, bodyLen, nonce, msgBuf, hdrLen, MACLength);
+            status = aes->Encrypt_CCM(src, body, bodyLen, nonce, msgBuf, hdrLen, MACLength);
         }
+        delete uncached;
     }
     break;
 
@@ -124,13 +226,14 @@ QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
     return status;
 }
 
-QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
+QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen, const uint8_t* srcBody)
 {
     QStatus status;
     switch (keyBlob.GetType()) {
     case KeyBlob::AES:
     {
         uint8_t* body = msgBuf + hdrLen;
+        const uint8_t* src = srcBody ? srcBody : body;
         uint8_t nd[5];
         uint32_t serial = message.GetCallSerial();
 
@@ -144,17 +247,22 @@ QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
         QCC_DbgHLPrintf(("Decrypt key:   %s", BytesToHexString(keyBlob.GetData(), keyBlob.GetSize()).c_str()));
         QCC_DbgHLPrintf(("        nonce: %s", BytesToHexString(nonce.GetData(), nonce.GetSize()).c_str()));
 
-        Crypto_AES aes(keyBlob, Crypto_AES::CCM);
+        Crypto_AES* uncached = NULL;
+        Crypto_AES* aes = GetCachedCipher(keyBlob);
+        if (!aes) {
+            aes = uncached = new Crypto_AES(keyBlob, Crypto_AES::CCM);
+        }
         if (message.GetFlags() & ALLJOYN_FLAG_COMPRESSED) {
             /*
              * To prevent an attack where the attacker sends a bogus expansion rule we
              * authenticate the compressed headers even though we won't be sending them.
              */
             qcc::String extHdr = ConcatenateCompressedFields(msgBuf, hdrLen, message.GetHeaderFields());
-            status = aes.Decrypt_CCM(body, body, bodyLen, nonce, extHdr.data(), extHdr.size(), MACLength);
+            status = aes->Decrypt_CCM(src, body, bodyLen, nonce, extHdr.data(), extHdr.size(), MACLength);
         } else {
-            status = aes.Decrypt_CCM(body, body, bodyLen, nonce, msgBuf, hdrLen, MACLength);
+            status = aes->Decrypt_CCM(src, body, bodyLen, nonce, msgBuf, hdrLen, MACLength);
         }
+        delete uncached;
     }
     break;
 
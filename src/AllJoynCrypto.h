@@ -53,12 +53,14 @@ class Crypto {
      * @param hdrLen          The length of the header part of the message that will not be encrypted.
      * @param bodyLen[in/out] On input the size of the plaintext body, on output the size of the
      *                        encrypted body.
+     * @param srcBody         If not NULL the plaintext body is read from here instead of from
+     *                        msgBuf so the body does not need to be copied into msgBuf first.
      *
      * @return - ER_OK if the data was succesfully encrypted.
      *         - ER_BUS_KEYBLOB_OP_INVALID if the key blob cannot be used for encryption.
      *         - Other errors if the arguments are invalid.
      */
-    static QStatus Encrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
+    static QStatus Encrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen, const uint8_t* srcBody = NULL);
 
     /**
      * Decrypt and authenticate marshaled message inplace using the key blob provided and the
@@ -70,12 +72,14 @@ class Crypto {
      * @param hdrLen          The length of the non-encrypted header part of the message.
      * @param bodyLen[in/out] On input the size of the crypttext body, on output the size of the
      *                        decrypted body.
+     * @param srcBody         If not NULL the crypttext body is read from here instead of from
+     *                        msgBuf so the body does not need to be copied into msgBuf first.
      *
      * @return - ER_OK if the data was succesfully decrypted.
      *         - ER_BUS_KEYBLOB_OP_INVALID if the key blob cannot be used for decryption.
      *         - Other errors if the arguments are invalid.
      */
-    static QStatus Decrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
+    static QStatus Decrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen, const uint8_t* srcBody = NULL);
 
     /**
      * Compute a SHA1 hash over the header fields and return the result in a key blob.
@@ -23,6 +23,7 @@
 #include <qcc/platform.h>
 
 #include <assert.h>
+#include <string.h>
 
 #include <qcc/Debug.h>
 #include <qcc/String.h>
@@ -46,6 +47,7 @@
 #include "SASLEngine.h"
 #include "AllJoynCrypto.h"
 #include "BusInternal.h"
+#include "AtomTable.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -68,6 +70,14 @@ static const uint32_t MAX_AUTH_VERSION = 0x0001;
 
 static const uint32_t PREFERRED_AUTH_VERSION = (MAX_AUTH_VERSION << 16) | MIN_KEYGEN_VERSION;
 
+/*
+ * Number of dispatcher threads. An authentication holds a thread for several round trips to the
+ * remote peer so this bounds how many peers can be authenticated at once. Authentications of the
+ * same peer are serialized by the peer state's auth event so extra threads only help independent
+ * peers.
+ */
+static const uint32_t PEER_OBJ_CONCURRENCY = 8;
+
 static bool IsCompatibleVersion(uint32_t version)
 {
     uint16_t authV = version >> 16;
@@ -119,8 +129,11 @@ static void SetRights(PeerState& peerState, bool mutual, bool challenger)
 AllJoynPeerObj::AllJoynPeerObj(BusAttachment& bus) :
     BusObject(bus, org::alljoyn::Bus::Peer::ObjectPath, false),
     AlarmListener(),
-    dispatcher("PeerObjDispatcher", true, 3)
+    dispatcher("PeerObjDispatcher", true, PEER_OBJ_CONCURRENCY),
+    accepting(false),
+    dispatcherStarted(false)
 {
+    memset(&authStats, 0, sizeof(authStats));
     /* Add org.alljoyn.Bus.Peer.HeaderCompression interface */
     {
         const InterfaceDescription* ifc = bus.GetInterface(org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName);
@@ -159,14 +172,27 @@ QStatus AllJoynPeerObj::Start()
 {
     assert(bus);
     bus->RegisterBusListener(*this);
-    dispatcher.Start();
+    /*
+     * The dispatcher threads are not started until the first request is dispatched. Most
+     * applications never authenticate or receive a compressed header so there is no point
+     * paying for the threads at startup.
+     */
+    lock.Lock(MUTEX_CONTEXT);
+    accepting = true;
+    lock.Unlock(MUTEX_CONTEXT);
     return ER_OK;
 }
 
 QStatus AllJoynPeerObj::Stop()
 {
     assert(bus);
-    dispatcher.Stop();
+    lock.Lock(MUTEX_CONTEXT);
+    accepting = false;
+    bool started = dispatcherStarted;
+    lock.Unlock(MUTEX_CONTEXT);
+    if (started) {
+        dispatcher.Stop();
+    }
     bus->UnregisterBusListener(*this);
     return ER_OK;
 }
@@ -182,7 +208,13 @@ QStatus AllJoynPeerObj::Join()
     conversations.clear();
     lock.Unlock(MUTEX_CONTEXT);
 
-    dispatcher.Join();
+    lock.Lock(MUTEX_CONTEXT);
+    bool started = dispatcherStarted;
+    dispatcherStarted = false;
+    lock.Unlock(MUTEX_CONTEXT);
+    if (started) {
+        dispatcher.Join();
+    }
     return ER_OK;
 }
 
@@ -224,21 +256,23 @@ QStatus AllJoynPeerObj::RequestHeaderExpansion(Message& msg, RemoteEndpoint& sen
 {
     bool expansionPending = false;
     uint32_t token = msg->GetCompressionToken();
+    const qcc::String& receivedFrom = sender->GetRemoteName();
 
     assert(bus);
     //assert(sender == bus.GetInternal().GetRouter().FindEndpoint(msg->GetRcvEndpointName()));
 
     lock.Lock(MUTEX_CONTEXT);
     /*
-     * First check if there are any other messages waiting for the same expansion rule.
+     * First check if there are any other messages from the same peer waiting for the same expansion rule.
      */
-    for (std::deque<Message>::iterator iter = msgsPendingExpansion.begin(); iter != msgsPendingExpansion.end(); ++iter) {
+    std::deque<Message>& pending = msgsPendingExpansion[receivedFrom];
+    for (std::deque<Message>::iterator iter = pending.begin(); iter != pending.end(); ++iter) {
         if ((*iter)->GetCompressionToken() == token) {
             expansionPending = true;
             break;
         }
     }
-    msgsPendingExpansion.push_back(msg);
+    pending.push_back(msg);
     lock.Unlock(MUTEX_CONTEXT);
     /*
      * If there is already an expansion request for this message we don't need another one.
@@ -246,7 +280,7 @@ QStatus AllJoynPeerObj::RequestHeaderExpansion(Message& msg, RemoteEndpoint& sen
     if (expansionPending) {
         return ER_OK;
     } else {
-        return DispatchRequest(msg, EXPAND_HEADER, sender->GetRemoteName());
+        return DispatchRequest(msg, EXPAND_HEADER, receivedFrom);
     }
 }
 
@@ -255,15 +289,22 @@ QStatus AllJoynPeerObj::RequestAuthentication(Message& msg)
     return DispatchRequest(msg, AUTHENTICATE_PEER);
 }
 
-bool AllJoynPeerObj::RemoveCompressedMessage(Message& msg, uint32_t token)
+bool AllJoynPeerObj::RemoveCompressedMessage(Message& msg, const qcc::String& receivedFrom, uint32_t token)
 {
     lock.Lock(MUTEX_CONTEXT);
-    for (std::deque<Message>::iterator iter = msgsPendingExpansion.begin(); iter != msgsPendingExpansion.end(); ++iter) {
-        if ((*iter)->GetCompressionToken() == token) {
-            msg = *iter;
-            msgsPendingExpansion.erase(iter);
-            lock.Unlock(MUTEX_CONTEXT);
-            return true;
+    std::map<qcc::String, std::deque<Message> >::iterator pit = msgsPendingExpansion.find(receivedFrom);
+    if (pit != msgsPendingExpansion.end()) {
+        std::deque<Message>& pending = pit->second;
+        for (std::deque<Message>::iterator iter = pending.begin(); iter != pending.end(); ++iter) {
+            if ((*iter)->GetCompressionToken() == token) {
+                msg = *iter;
+                pending.erase(iter);
+                if (pending.empty()) {
+                    msgsPendingExpansion.erase(pit);
+                }
+                lock.Unlock(MUTEX_CONTEXT);
+                return true;
+            }
         }
     }
     lock.Unlock(MUTEX_CONTEXT);
@@ -277,43 +318,83 @@ bool AllJoynPeerObj::RemoveCompressedMessage(Message& msg, uint32_t token)
  */
 #define EXPANSION_TIMEOUT   1000
 
+/* Context for an expansion request that is waiting for a reply */
+struct ExpansionContext {
+    uint32_t token;
+    qcc::String receivedFrom;
+    ExpansionContext(uint32_t token, const qcc::String& receivedFrom) : token(token), receivedFrom(receivedFrom) { }
+};
+
 void AllJoynPeerObj::ExpandHeader(Message& msg, const qcc::String& receivedFrom)
 {
     assert(bus);
     QStatus status = ER_OK;
     uint32_t token = msg->GetCompressionToken();
 
-    const HeaderFields* expFields = bus->GetInternal().GetCompressionRules()->GetExpansion(token);
-    if (!expFields) {
-        Message replyMsg(*bus);
-        MsgArg arg("u", token);
+    HeaderFields expFields;
+    if (bus->GetInternal().GetCompressionRules()->GetExpansion(token, expFields)) {
         /*
-         * The endpoint the message was received on knows the expansion rule for the token we just received.
+         * The expansion rule arrived while the request was queued.
          */
-        ProxyBusObject remotePeerObj(*bus, receivedFrom.c_str(), org::alljoyn::Bus::Peer::ObjectPath, 0);
-        const InterfaceDescription* ifc = bus->GetInterface(org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName);
-        if (ifc == NULL) {
-            status = ER_BUS_NO_SUCH_INTERFACE;
-        }
-        if (status == ER_OK) {
-            remotePeerObj.AddInterface(*ifc);
-            status = remotePeerObj.MethodCall(*(ifc->GetMember("GetExpansion")), &arg, 1, replyMsg, EXPANSION_TIMEOUT);
-        }
-        if (status == ER_OK) {
-            status = replyMsg->AddExpansionRule(token, replyMsg->GetArg(0));
-            if (status == ER_OK) {
-                expFields = bus->GetInternal().GetCompressionRules()->GetExpansion(token);
-                if (!expFields) {
-                    status = ER_BUS_HDR_EXPANSION_INVALID;
-                }
-            }
+        ResumeCompressedMessages(receivedFrom, token, ER_OK);
+        return;
+    }
+    MsgArg arg("u", token);
+    /*
+     * The endpoint the message was received on knows the expansion rule for the token we just
+     * received. The request is asynchronous so the dispatcher is not held up while we wait for the
+     * peer to respond; the messages stay queued until ExpansionReply() is called.
+     */
+    ProxyBusObject remotePeerObj(*bus, receivedFrom.c_str(), org::alljoyn::Bus::Peer::ObjectPath, 0);
+    const InterfaceDescription* ifc = bus->GetInterface(org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName);
+    if (ifc == NULL) {
+        status = ER_BUS_NO_SUCH_INTERFACE;
+    }
+    if (status == ER_OK) {
+        ExpansionContext* ctx = new ExpansionContext(token, receivedFrom);
+        remotePeerObj.AddInterface(*ifc);
+        status = remotePeerObj.MethodCallAsync(*(ifc->GetMember("GetExpansion")),
+                                               this,
+                                               static_cast<MessageReceiver::ReplyHandler>(&AllJoynPeerObj::ExpansionReply),
+                                               &arg, 1,
+                                               ctx,
+                                               EXPANSION_TIMEOUT);
+        if (status != ER_OK) {
+            delete ctx;
         }
     }
+    if (status != ER_OK) {
+        ResumeCompressedMessages(receivedFrom, token, status);
+    }
+}
+
+void AllJoynPeerObj::ExpansionReply(Message& replyMsg, void* context)
+{
+    ExpansionContext* ctx = reinterpret_cast<ExpansionContext*>(context);
+    QStatus status = ER_OK;
+
+    if (replyMsg->GetType() == MESSAGE_METHOD_RET) {
+        status = replyMsg->AddExpansionRule(ctx->token, replyMsg->GetArg(0));
+    } else {
+        status = ER_BUS_REPLY_IS_ERROR_MESSAGE;
+    }
+    ResumeCompressedMessages(ctx->receivedFrom, ctx->token, status);
+    delete ctx;
+}
+
+void AllJoynPeerObj::ResumeCompressedMessages(const qcc::String& receivedFrom, uint32_t token, QStatus status)
+{
+    Message msg(*bus);
+    HeaderFields expFields;
+
+    if ((status == ER_OK) && !bus->GetInternal().GetCompressionRules()->GetExpansion(token, expFields)) {
+        status = ER_BUS_HDR_EXPANSION_INVALID;
+    }
     /*
      * Clean up if we can't expand the messages.
      */
     if (status != ER_OK) {
-        while (RemoveCompressedMessage(msg, token)) {
+        while (RemoveCompressedMessage(msg, receivedFrom, token)) {
             QCC_LogError(status, ("Failed to expand message %s", msg->Description().c_str()));
         }
         return;
@@ -323,7 +404,7 @@ void AllJoynPeerObj::ExpandHeader(Message& msg, const qcc::String& receivedFrom)
      * we will be expanding different headers at the same time so we are really just removing the
      * front message from the list.
      */
-    while (RemoveCompressedMessage(msg, token)) {
+    while (RemoveCompressedMessage(msg, receivedFrom, token)) {
         Router& router = bus->GetInternal().GetRouter();
         BusEndpoint sender = router.FindEndpoint(msg->GetRcvEndpointName());
         if (sender->IsValid()) {
@@ -332,9 +413,10 @@ void AllJoynPeerObj::ExpandHeader(Message& msg, const qcc::String& receivedFrom)
              */
             for (size_t id = 0; id < ArraySize(msg->hdrFields.field); id++) {
                 if (HeaderFields::Compressible[id] && (msg->hdrFields.field[id].typeId == ALLJOYN_INVALID)) {
-                    msg->hdrFields.field[id] = expFields->field[id];
+                    msg->hdrFields.field[id] = expFields.field[id];
                 }
             }
+            AtomTable::SetHeaderAtoms(msg->hdrFields);
             /*
              * Initialize ttl from the message header.
              */
@@ -479,6 +561,15 @@ QStatus AllJoynPeerObj::KeyGen(PeerState& peerState, String seed, qcc::String& v
     uint8_t keyGenVersion = peerState->GetAuthVersion() & 0xFF;
 
     status = keyStore.GetKey(peerState->GetGuid(), masterSecret, peerState->authorizations);
+    /*
+     * The master secret is what lets a reconnecting peer skip the authentication conversation. If
+     * the key store is shared another application may have authenticated this peer since we last
+     * loaded it so reload before giving up. Without this a responder would force the initiator
+     * into a full authentication even though the initiator found the master secret.
+     */
+    if ((status == ER_BUS_KEY_UNAVAILABLE) && keyStore.IsShared() && (keyStore.Reload() == ER_OK)) {
+        status = keyStore.GetKey(peerState->GetGuid(), masterSecret, peerState->authorizations);
+    }
     if ((status == ER_OK) && masterSecret.HasExpired()) {
         status = ER_BUS_KEY_EXPIRED;
     }
@@ -832,6 +923,9 @@ QStatus AllJoynPeerObj::AuthenticatePeer(AllJoynMessageType msgType, const qcc::
      */
     qcc::Event authEvent;
     peerState->SetAuthEvent(&authEvent);
+    if (++authStats.active > authStats.maxActive) {
+        authStats.maxActive = authStats.active;
+    }
     lock.Unlock(MUTEX_CONTEXT);
 
     KeyStore& keyStore = bus->GetInternal().GetKeyStore();
@@ -978,6 +1072,12 @@ QStatus AllJoynPeerObj::AuthenticatePeer(AllJoynMessageType msgType, const qcc::
      */
     lock.Lock(MUTEX_CONTEXT);
     peerState->SetAuthEvent(NULL);
+    --authStats.active;
+    if (status == ER_OK) {
+        ++authStats.succeeded;
+    } else {
+        ++authStats.failed;
+    }
     while (authEvent.GetNumBlockedThreads() > 0) {
         authEvent.SetEvent();
         qcc::Sleep(10);
@@ -993,17 +1093,33 @@ QStatus AllJoynPeerObj::AuthenticatePeerAsync(const qcc::String& busName)
     return DispatchRequest(invalidMsg, SECURE_CONNECTION, busName);
 }
 
+void AllJoynPeerObj::GetAuthStats(AuthStats& stats)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    stats = authStats;
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
 QStatus AllJoynPeerObj::DispatchRequest(Message& msg, RequestType reqType, const qcc::String data)
 {
     QStatus status;
     QCC_DbgHLPrintf(("DispatchRequest %s", msg->Description().c_str()));
     lock.Lock(MUTEX_CONTEXT);
-    if (dispatcher.IsRunning()) {
+    if (accepting && !dispatcherStarted) {
+        status = dispatcher.Start();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to start peer object dispatcher"));
+        }
+        dispatcherStarted = true;
+    }
+    if (accepting && dispatcher.IsRunning()) {
         Request* req = new Request(msg, reqType, data);
         qcc::AlarmListener* alljoynPeerListener = this;
         status = dispatcher.AddAlarm(Alarm(alljoynPeerListener, req));
         if (status != ER_OK) {
             delete req;
+        } else if ((reqType == AUTHENTICATE_PEER) || (reqType == SECURE_CONNECTION)) {
+            ++authStats.queued;
         }
     } else {
         status = ER_BUS_STOPPING;
@@ -1020,6 +1136,12 @@ void AllJoynPeerObj::AlarmTriggered(const Alarm& alarm, QStatus reason)
     QCC_DbgHLPrintf(("AllJoynPeerObj::AlarmTriggered"));
     Request* req = static_cast<Request*>(alarm->GetContext());
 
+    if ((req->reqType == AUTHENTICATE_PEER) || (req->reqType == SECURE_CONNECTION)) {
+        lock.Lock(MUTEX_CONTEXT);
+        --authStats.queued;
+        lock.Unlock(MUTEX_CONTEXT);
+    }
+
     switch (req->reqType) {
     case AUTHENTICATE_PEER:
         /*
@@ -56,6 +56,17 @@ class BusAttachment;
 class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmListener {
   public:
 
+    /**
+     * Counters for authentications initiated by this peer.
+     */
+    struct AuthStats {
+        uint32_t queued;      /**< Authentication requests waiting for a dispatcher thread */
+        uint32_t active;      /**< Authentication conversations currently in progress */
+        uint32_t maxActive;   /**< Highest number of authentication conversations in progress at once */
+        uint32_t succeeded;   /**< Authentication conversations that completed successfully */
+        uint32_t failed;      /**< Authentication conversations that failed */
+    };
+
     /**
      * Constructor
      *
@@ -121,6 +132,12 @@ class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmLi
      */
     bool AuthenticationEnabled() { return !peerAuthMechanisms.empty(); }
 
+    /**
+     * Forget the credentials the authentication listener allowed authentication mechanisms to
+     * remember.
+     */
+    void ClearVerifiedCredentials() { peerAuthListener.ClearVerified(); }
+
     /**
      * Force re-authentication for the specified peer.
      */
@@ -156,6 +173,13 @@ class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmLi
      */
     QStatus AuthenticatePeerAsync(const qcc::String& busName);
 
+    /**
+     * Get a snapshot of the authentication counters.
+     *
+     * @param stats  Returns the counters.
+     */
+    void GetAuthStats(AuthStats& stats);
+
     /**
      * Reports a security failure. This would normally be due to stale or expired keys.
      *
@@ -273,12 +297,32 @@ class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmLi
     void AuthAdvance(Message& msg);
 
     /**
-     * Process a message to advance an authentication conversation.
+     * Request the expansion rule for a compressed message from the peer that sent it. The request
+     * is made asynchronously, the messages waiting for the rule are resumed by ExpansionReply().
      *
-     * @param msg  The auth challenge message
+     * @param msg              A compressed message
+     * @param sendingEndpoint  The remote name of the endpoint the message was received on
      */
     void ExpandHeader(Message& msg, const qcc::String& sendingEndpoint);
 
+    /**
+     * Reply handler for the GetExpansion method call made by ExpandHeader().
+     *
+     * @param replyMsg  The reply message
+     * @param context   The ExpansionContext of the request
+     */
+    void ExpansionReply(Message& replyMsg, void* context);
+
+    /**
+     * Expand and route, or discard on failure, the queued messages from a peer that are waiting
+     * for the expansion rule of a compression token.
+     *
+     * @param receivedFrom  The remote name of the endpoint the messages were received on
+     * @param token         The compression token
+     * @param status        ER_OK if the expansion rule was obtained, otherwise the reason it wasn't
+     */
+    void ResumeCompressedMessages(const qcc::String& receivedFrom, uint32_t token, QStatus status);
+
     /**
      * Session key generation algorithm.
      *
@@ -334,15 +378,16 @@ class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmLi
     QStatus DispatchRequest(Message& msg, AllJoynPeerObj::RequestType reqType, const qcc::String data = "");
 
     /**
-     * Get the next compressed message from the msgsPendingExpansion queue that has the specified
-     * compression token. The message is removed from the list.
+     * Get the next compressed message received from a peer from the msgsPendingExpansion queue
+     * that has the specified compression token. The message is removed from the list.
      *
-     * @param msg       Message that was removed.
-     * @param token     The compression token
+     * @param msg           Message that was removed.
+     * @param receivedFrom  The remote name of the endpoint the message was received on
+     * @param token         The compression token
      *
      * @return  Returns true if a message was removed and returned.
      */
-    bool RemoveCompressedMessage(Message& msg, uint32_t token);
+    bool RemoveCompressedMessage(Message& msg, const qcc::String& receivedFrom, uint32_t token);
 
     /**
      * The peer-to-peer authentication mechanisms available to this object
@@ -362,14 +407,23 @@ class AllJoynPeerObj : public BusObject, public BusListener, public qcc::AlarmLi
     /** Short term lock to protect the peer object. */
     qcc::Mutex lock;
 
-    /** Dispatcher for handling peer object requests */
+    /** Dispatcher for handling peer object requests, started on first use */
     qcc::Timer dispatcher;
 
+    /** True between Start() and Stop(), protected by lock */
+    bool accepting;
+
+    /** True once the dispatcher threads have been started, protected by lock */
+    bool dispatcherStarted;
+
+    /** Authentication counters, protected by lock */
+    AuthStats authStats;
+
     /** Queue of encrypted messages waiting for an authentication to complete */
     std::deque<Message> msgsPendingAuth;
 
-    /** Queue of compressed messages waiting for an expansion rule to be supplied */
-    std::deque<Message> msgsPendingExpansion;
+    /** Queues, per sending peer, of compressed messages waiting for an expansion rule to be supplied */
+    std::map<qcc::String, std::deque<Message> > msgsPendingExpansion;
 };
 
 }
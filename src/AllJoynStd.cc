@@ -22,6 +22,7 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 #include <qcc/Debug.h>
+#include <qcc/Util.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/AllJoynStd.h>
@@ -56,113 +57,108 @@ const char* org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName = "org.all
 const char* org::alljoyn::Bus::Peer::Authentication::InterfaceName = "org.alljoyn.Bus.Peer.Authentication";
 const char* org::alljoyn::Bus::Peer::Session::InterfaceName = "org.alljoyn.Bus.Peer.Session";
 
+/** org.alljoyn.Bus.Introspectable interface definitions */
+const char* org::alljoyn::Bus::Introspectable::InterfaceName = "org.alljoyn.Bus.Introspectable";
 
-QStatus org::alljoyn::CreateInterfaces(BusAttachment& bus)
-{
-    QStatus status;
-    {
-        /* Create the org.alljoyn.Bus interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Bus::InterfaceName, ifc);
-
-        if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create interface \"%s\"", org::alljoyn::Bus::InterfaceName));
-            return status;
-        }
-        ifc->AddMethod("BusHello",                 "su",                "ssu",               "GUIDC,protoVerC,GUIDS,uniqueName,protoVerS", 0);
-        ifc->AddMethod("BindSessionPort",          "q" SESSIONOPTS_SIG,  "uq",                "portIn,opts,disposition,portOut",           0);
-        ifc->AddMethod("UnbindSessionPort",        "q",                 "u",                 "port,disposition",                           0);
-        ifc->AddMethod("JoinSession",              "sq" SESSIONOPTS_SIG, "uu" SESSIONOPTS_SIG, "sessionHost,port,opts,disp,sessionId,opts",  0);
-        ifc->AddMethod("LeaveSession",             "u",                 "u",                 "sessionId,disposition",                      0);
-        ifc->AddMethod("AdvertiseName",            "sq",                "u",                 "name,transports,disposition",                0);
-        ifc->AddMethod("CancelAdvertiseName",      "sq",                "u",                 "name,transports,disposition",                0);
-        ifc->AddMethod("FindAdvertisedName",       "s",                 "u",                 "name,disposition",                           0);
-        ifc->AddMethod("FindAdvertisedNameByTransport",       "sq",                "u",                 "name,transports,disposition",                0);
-        ifc->AddMethod("CancelFindAdvertisedName", "s",                 "u",                 "name,disposition",                           0);
-        ifc->AddMethod("CancelFindAdvertisedNameByTransport", "sq",                "u",                 "name,transports,disposition",                0);
-        ifc->AddMethod("GetSessionFd",             "u",                 "h",                 "sessionId,handle",                           0);
-        ifc->AddMethod("SetLinkTimeout",           "uu",                "uu",                "sessionId,inLinkTO,disposition,outLinkTO",   0);
-        ifc->AddMethod("AliasUnixUser",            "u",                 "u",                 "aliasUID, disposition",                      0);
-        ifc->AddMethod("OnAppSuspend",             "",                  "u",                 "disposition",                                0);
-        ifc->AddMethod("OnAppResume",              "",                  "u",                 "disposition",                                0);
-        ifc->AddMethod("CancelSessionlessMessage", "u",                 "u",                 "serialNum,disposition",                      0);
-
-        ifc->AddSignal("FoundAdvertisedName",      "sqs",              "name,transport,prefix",                        0);
-        ifc->AddSignal("LostAdvertisedName",       "sqs",              "name,transport,prefix",                        0);
-        ifc->AddSignal("SessionLost",              "u",                "sessionId",                                    0);
-        ifc->AddSignal("MPSessionChanged",         "usb",              "sessionId,name,isAdded",                       0);
-
-        ifc->Activate();
-    }
 
-    {
-        /* Create the org.alljoyn.Daemon interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Daemon::InterfaceName, ifc);
-
-        if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create interface \"%s\"", org::alljoyn::Daemon::InterfaceName));
-            return status;
-        }
-        ifc->AddMethod("AttachSession",  "qsssss" SESSIONOPTS_SIG, "uu" SESSIONOPTS_SIG "as", "port,joiner,creator,dest,b2b,busAddr,optsIn,status,id,optsOut,members", 0);
-        ifc->AddMethod("GetSessionInfo", "sq" SESSIONOPTS_SIG, "as", "creator,port,opts,busAddrs", 0);
-        ifc->AddSignal("DetachSession",  "us",     "sessionId,joiner",       0);
-        ifc->AddSignal("ExchangeNames",  "a(sas)", "uniqueName,aliases",     0);
-        ifc->AddSignal("NameChanged",    "sss",    "name,oldOwner,newOwner", 0);
-        ifc->AddSignal("ProbeReq",       "",       "",                       0);
-        ifc->AddSignal("ProbeAck",       "",       "",                       0);
-        ifc->Activate();
-    }
-    {
-        /* Create the org.alljoyn.Daemon.Debug interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Daemon::Debug::InterfaceName, ifc);
+/*
+ * The AllJoyn interfaces are the same for every bus attachment so their descriptions are built
+ * once per process from these tables and shared.
+ */
+static const InterfaceDescription::StaticMember busMembers[] = {
+    { MESSAGE_METHOD_CALL, "BusHello",                 "su",                "ssu",               "GUIDC,protoVerC,GUIDS,uniqueName,protoVerS", 0, NULL },
+    { MESSAGE_METHOD_CALL, "BindSessionPort",          "q" SESSIONOPTS_SIG,  "uq",                "portIn,opts,disposition,portOut",           0, NULL },
+    { MESSAGE_METHOD_CALL, "UnbindSessionPort",        "q",                 "u",                 "port,disposition",                           0, NULL },
+    { MESSAGE_METHOD_CALL, "JoinSession",              "sq" SESSIONOPTS_SIG, "uu" SESSIONOPTS_SIG, "sessionHost,port,opts,disp,sessionId,opts",  0, NULL },
+    { MESSAGE_METHOD_CALL, "JoinSessions",             "a(sq" SESSIONOPTS_SIG ")", "a(uu" SESSIONOPTS_SIG ")", "joins,results",      0, NULL },
+    { MESSAGE_METHOD_CALL, "LeaveSession",             "u",                 "u",                 "sessionId,disposition",                      0, NULL },
+    { MESSAGE_METHOD_CALL, "AdvertiseName",            "sq",                "u",                 "name,transports,disposition",                0, NULL },
+    { MESSAGE_METHOD_CALL, "CancelAdvertiseName",      "sq",                "u",                 "name,transports,disposition",                0, NULL },
+    { MESSAGE_METHOD_CALL, "FindAdvertisedName",       "s",                 "u",                 "name,disposition",                           0, NULL },
+    { MESSAGE_METHOD_CALL, "FindAdvertisedNameByTransport",       "sq",                "u",                 "name,transports,disposition",                0, NULL },
+    { MESSAGE_METHOD_CALL, "FindAdvertisedNameFiltered",          "sqas",              "u",                 "name,transports,filters,disposition",        0, NULL },
+    { MESSAGE_METHOD_CALL, "CancelFindAdvertisedName", "s",                 "u",                 "name,disposition",                           0, NULL },
+    { MESSAGE_METHOD_CALL, "CancelFindAdvertisedNameByTransport", "sq",                "u",                 "name,transports,disposition",                0, NULL },
+    { MESSAGE_METHOD_CALL, "GetSessionFd",             "u",                 "h",                 "sessionId,handle",                           0, NULL },
+    { MESSAGE_METHOD_CALL, "SetLinkTimeout",           "uu",                "uu",                "sessionId,inLinkTO,disposition,outLinkTO",   0, NULL },
+    { MESSAGE_METHOD_CALL, "AliasUnixUser",            "u",                 "u",                 "aliasUID, disposition",                      0, NULL },
+    { MESSAGE_METHOD_CALL, "OnAppSuspend",             "",                  "u",                 "disposition",                                0, NULL },
+    { MESSAGE_METHOD_CALL, "OnAppResume",              "",                  "u",                 "disposition",                                0, NULL },
+    { MESSAGE_METHOD_CALL, "CancelSessionlessMessage", "u",                 "u",                 "serialNum,disposition",                      0, NULL },
+    { MESSAGE_METHOD_CALL, "AddMatches",               "as",                "au",                "rules,statuses",                             0, NULL },
+    { MESSAGE_METHOD_CALL, "RemoveMatches",            "as",                "au",                "rules,statuses",                             0, NULL },
+    { MESSAGE_METHOD_CALL, "ReplaceMatches",           "as",                "u",                 "rules,status",                               0, NULL },
+
+    { MESSAGE_SIGNAL,      "FoundAdvertisedName",      "sqs",               NULL,                "name,transport,prefix",                      0, NULL },
+    { MESSAGE_SIGNAL,      "LostAdvertisedName",       "sqs",               NULL,                "name,transport,prefix",                      0, NULL },
+    { MESSAGE_SIGNAL,      "SessionLost",              "u",                 NULL,                "sessionId",                                  0, NULL },
+    { MESSAGE_SIGNAL,      "MPSessionChanged",         "usb",               NULL,                "sessionId,name,isAdded",                     0, NULL }
+};
+
+static const InterfaceDescription::StaticMember daemonMembers[] = {
+    { MESSAGE_METHOD_CALL, "AttachSession",  "qsssss" SESSIONOPTS_SIG, "uu" SESSIONOPTS_SIG "as", "port,joiner,creator,dest,b2b,busAddr,optsIn,status,id,optsOut,members", 0, NULL },
+    { MESSAGE_METHOD_CALL, "GetSessionInfo", "sq" SESSIONOPTS_SIG, "as", "creator,port,opts,busAddrs", 0, NULL },
+    { MESSAGE_SIGNAL,      "DetachSession",  "us",     NULL, "sessionId,joiner",       0, NULL },
+    { MESSAGE_SIGNAL,      "ExchangeNames",  "a(sas)", NULL, "uniqueName,aliases",     0, NULL },
+    { MESSAGE_SIGNAL,      "NameChanged",    "sss",    NULL, "name,oldOwner,newOwner", 0, NULL },
+    { MESSAGE_SIGNAL,      "ProbeReq",       "",       NULL, "",                       0, NULL },
+    { MESSAGE_SIGNAL,      "ProbeAck",       "",       NULL, "",                       0, NULL },
+    { MESSAGE_SIGNAL,      "RuleDigest",     "bay",    NULL, "matchAll,filter",        0, NULL }
+};
+
+static const InterfaceDescription::StaticMember debugMembers[] = {
+    { MESSAGE_METHOD_CALL, "SetDebugLevel", "su", NULL, "module,level", 0, NULL }
+};
+
+static const InterfaceDescription::StaticMember headerCompressionMembers[] = {
+    { MESSAGE_METHOD_CALL, "GetExpansion", "u", "a(yv)", "token,headerFields", 0, NULL }
+};
+
+static const InterfaceDescription::StaticMember authenticationMembers[] = {
+    { MESSAGE_METHOD_CALL, "ExchangeGuids",     "su",  "su", "localGuid,localVersion,remoteGuid,remoteVersion",     0, NULL },
+    { MESSAGE_METHOD_CALL, "GenSessionKey",     "sss", "ss", "localGuid,remoteGuid,localNonce,remoteNonce,verifier", 0, NULL },
+    { MESSAGE_METHOD_CALL, "ExchangeGroupKeys", "ay",  "ay", "localKeyMatter,remoteKeyMatter",                      0, NULL },
+    { MESSAGE_METHOD_CALL, "AuthChallenge",     "s",   "s",  "challenge,response",                                  0, NULL }
+};
+
+static const InterfaceDescription::StaticProperty authenticationProperties[] = {
+    { "Mechanisms", "s", PROP_ACCESS_READ },
+    { "Version",    "u", PROP_ACCESS_READ }
+};
+
+static const InterfaceDescription::StaticMember sessionMembers[] = {
+    { MESSAGE_METHOD_CALL, "AcceptSession", "qus" SESSIONOPTS_SIG, "b", "port,id,src,opts,accepted", 0, NULL },
+    { MESSAGE_SIGNAL,      "SessionJoined", "qus", NULL, "port,id,src", 0, NULL },
+    { MESSAGE_SIGNAL,      "DirectPath",    "ush", NULL, "id,peer,fd",  0, NULL }
+};
+
+static const InterfaceDescription::StaticMember introspectableMembers[] = {
+    { MESSAGE_METHOD_CALL, "IntrospectCompact", NULL, ALLJOYN_COMPACT_INTROSPECTION_SIG, "children,interfaces", 0, NULL }
+};
+
+#define MEMBERS(m) m, sizeof(m) / sizeof(m[0])
+
+static const InterfaceDescription::StaticInterface alljoynInterfaces[] = {
+    { "org.alljoyn.Bus",                        false, MEMBERS(busMembers),               NULL, 0 },
+    { "org.alljoyn.Daemon",                     false, MEMBERS(daemonMembers),            NULL, 0 },
+    { "org.alljoyn.Debug",                      false, MEMBERS(debugMembers),             NULL, 0 },
+    { "org.alljoyn.Bus.Peer.HeaderCompression", false, MEMBERS(headerCompressionMembers), NULL, 0 },
+    { "org.alljoyn.Bus.Peer.Authentication",    false, MEMBERS(authenticationMembers),    MEMBERS(authenticationProperties) },
+    { "org.alljoyn.Bus.Peer.Session",           false, MEMBERS(sessionMembers),           NULL, 0 },
+    { "org.alljoyn.Bus.Introspectable",         false, MEMBERS(introspectableMembers),    NULL, 0 }
+};
+
+#undef MEMBERS
 
+QStatus org::alljoyn::CreateInterfaces(BusAttachment& bus)
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; (status == ER_OK) && (i < ArraySize(alljoynInterfaces)); ++i) {
+        const InterfaceDescription* ifc = NULL;
+        status = bus.CreateInterface(alljoynInterfaces[i], ifc);
         if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create interface \"%s\"", org::alljoyn::Daemon::Debug::InterfaceName));
-            return status;
-        }
-        ifc->AddMethod("SetDebugLevel",  "su", NULL, "module,level", 0);
-        ifc->Activate();
-    }
-    {
-        /* Create the org.alljoyn.Bus.Peer.HeaderCompression interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName, ifc);
-        if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create %s interface", org::alljoyn::Bus::Peer::HeaderCompression::InterfaceName));
-            return status;
-        }
-        ifc->AddMethod("GetExpansion", "u", "a(yv)", "token,headerFields");
-        ifc->Activate();
-    }
-    {
-        /* Create the org.alljoyn.Bus.Peer.Authentication interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Bus::Peer::Authentication::InterfaceName, ifc);
-        if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create %s interface", org::alljoyn::Bus::Peer::Authentication::InterfaceName));
-            return status;
-        }
-        ifc->AddMethod("ExchangeGuids",     "su",  "su", "localGuid,localVersion,remoteGuid,remoteVersion");
-        ifc->AddMethod("GenSessionKey",     "sss", "ss", "localGuid,remoteGuid,localNonce,remoteNonce,verifier");
-        ifc->AddMethod("ExchangeGroupKeys", "ay",  "ay", "localKeyMatter,remoteKeyMatter");
-        ifc->AddMethod("AuthChallenge",     "s",   "s",  "challenge,response");
-        ifc->AddProperty("Mechanisms",  "s", PROP_ACCESS_READ);
-        ifc->AddProperty("Version",     "u", PROP_ACCESS_READ);
-        ifc->Activate();
-    }
-    {
-        /* Create the org.alljoyn.Bus.Peer.Session interface */
-        InterfaceDescription* ifc = NULL;
-        status = bus.CreateInterface(org::alljoyn::Bus::Peer::Session::InterfaceName, ifc);
-        if (ER_OK != status) {
-            QCC_LogError(status, ("Failed to create %s interface", org::alljoyn::Bus::Peer::Session::InterfaceName));
-            return status;
+            QCC_LogError(status, ("Failed to create interface \"%s\"", alljoynInterfaces[i].name));
         }
-        ifc->AddMethod("AcceptSession", "qus" SESSIONOPTS_SIG, "b", "port,id,src,opts,accepted");
-        ifc->AddSignal("SessionJoined", "qus", "port,id,src");
-        ifc->Activate();
     }
     return status;
 }
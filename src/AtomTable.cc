@@ -0,0 +1,222 @@
+/**
+ * @file
+ *
+ * This file implements the AtomTable class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
+#include <qcc/atomic.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/StringMapKey.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+#include <qcc/STLContainer.h>
+
+#include "AtomTable.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+struct AtomHash {
+    inline size_t operator()(const qcc::StringMapKey& k) const {
+        return qcc::hash_string(k.c_str());
+    }
+};
+
+struct AtomEqual {
+    inline bool operator()(const qcc::StringMapKey& k1, const qcc::StringMapKey& k2) const {
+        return strcmp(k1.c_str(), k2.c_str()) == 0;
+    }
+};
+
+typedef unordered_map<qcc::StringMapKey, Atom, AtomHash, AtomEqual> AtomMap;
+
+static qcc::Mutex atomLock;
+static AtomMap atomMap;
+static Atom nextAtom = ATOM_NONE + 1;
+
+/* Bumped whenever a string is added to atomMap */
+static volatile int32_t atomGeneration = 0;
+
+/*
+ * Each thread remembers the atoms of the strings it looked up most recently so marshaling and
+ * unmarshaling does not take atomLock for every message. An atom never changes once a string is
+ * interned so only cached ATOM_UNKNOWN results go stale, they are dropped when the generation
+ * changes. The cache is direct mapped so strings received from remote peers cannot grow it.
+ */
+static const size_t NUM_CACHED_ATOMS = 64;
+
+struct AtomCache {
+    struct Entry {
+        qcc::String str;
+        Atom atom;
+        Entry() : atom(ATOM_NONE) { }
+    } entries[NUM_CACHED_ATOMS];
+    int32_t generation;
+
+    AtomCache() : generation(0) { }
+
+    void Flush(int32_t gen)
+    {
+        for (size_t i = 0; i < NUM_CACHED_ATOMS; ++i) {
+            if (entries[i].atom == ATOM_UNKNOWN) {
+                entries[i].str.clear();
+                entries[i].atom = ATOM_NONE;
+            }
+        }
+        generation = gen;
+    }
+};
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/* Called on thread exit to release the thread's cached atoms */
+static void ReleaseAtomCache(void* arg)
+{
+    delete reinterpret_cast<AtomCache*>(arg);
+}
+
+static pthread_key_t atomCacheKey;
+static bool atomCacheKeyValid = (pthread_key_create(&atomCacheKey, ReleaseAtomCache) == 0);
+
+static AtomCache* GetAtomCache()
+{
+    if (!atomCacheKeyValid) {
+        return NULL;
+    }
+    AtomCache* cache = reinterpret_cast<AtomCache*>(pthread_getspecific(atomCacheKey));
+    if (!cache) {
+        cache = new AtomCache;
+        if (pthread_setspecific(atomCacheKey, cache) != 0) {
+            delete cache;
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+#else
+
+/* Per-thread atom caches are only implemented for posix, other platforms always use the table */
+static AtomCache* GetAtomCache()
+{
+    return NULL;
+}
+
+#endif
+
+Atom AtomTable::Intern(const char* str)
+{
+    if (!str || !*str) {
+        return ATOM_NONE;
+    }
+    Atom atom;
+    atomLock.Lock(MUTEX_CONTEXT);
+    AtomMap::iterator it = atomMap.find(qcc::StringMapKey(str));
+    if (it == atomMap.end()) {
+        atom = nextAtom++;
+        atomMap.insert(pair<qcc::StringMapKey, Atom>(qcc::StringMapKey(qcc::String(str)), atom));
+        IncrementAndFetch(&atomGeneration);
+    } else {
+        atom = it->second;
+    }
+    atomLock.Unlock(MUTEX_CONTEXT);
+    return atom;
+}
+
+Atom AtomTable::Find(const char* str)
+{
+    if (!str || !*str) {
+        return ATOM_NONE;
+    }
+    /*
+     * The generation must be read before the table is so a string interned while it is being
+     * looked up leaves the cached ATOM_UNKNOWN tagged with an older generation.
+     */
+    int32_t gen = atomGeneration;
+    AtomCache* cache = GetAtomCache();
+    AtomCache::Entry* entry = NULL;
+    if (cache) {
+        if (cache->generation != gen) {
+            cache->Flush(gen);
+        }
+        entry = &cache->entries[qcc::hash_string(str) % NUM_CACHED_ATOMS];
+        if ((entry->atom != ATOM_NONE) && (strcmp(entry->str.c_str(), str) == 0)) {
+            return entry->atom;
+        }
+    }
+
+    Atom atom = ATOM_UNKNOWN;
+    atomLock.Lock(MUTEX_CONTEXT);
+    AtomMap::const_iterator it = atomMap.find(qcc::StringMapKey(str));
+    if (it != atomMap.end()) {
+        atom = it->second;
+    }
+    atomLock.Unlock(MUTEX_CONTEXT);
+
+    if (entry) {
+        entry->str = str;
+        entry->atom = atom;
+    }
+    return atom;
+}
+
+Atom AtomTable::GetHeaderAtom(const HeaderFields& hdrFields, AllJoynFieldType fieldId)
+{
+    const MsgArg& field = hdrFields.field[fieldId];
+    if (field.typeId == ALLJOYN_INVALID) {
+        return ATOM_NONE;
+    }
+    /*
+     * A string that was not interned when the atoms were cached may have been interned since,
+     * for example by a handler registered after the message arrived, so look it up again.
+     */
+    Atom cached = hdrFields.atoms[fieldId];
+    if ((cached != ATOM_NONE) && (cached != ATOM_UNKNOWN)) {
+        return cached;
+    }
+    /*
+     * The object path and string members of the MsgArg union have the same layout.
+     */
+    return Find(field.v_string.str);
+}
+
+void AtomTable::SetHeaderAtoms(HeaderFields& hdrFields)
+{
+    static const AllJoynFieldType fields[] = { ALLJOYN_HDR_FIELD_PATH, ALLJOYN_HDR_FIELD_INTERFACE, ALLJOYN_HDR_FIELD_MEMBER };
+    for (size_t i = 0; i < ArraySize(fields); ++i) {
+        const MsgArg& field = hdrFields.field[fields[i]];
+        hdrFields.atoms[fields[i]] = (field.typeId == ALLJOYN_INVALID) ? ATOM_NONE : Find(field.v_string.str);
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+#ifndef _ALLJOYN_ATOMTABLE_H
+#define _ALLJOYN_ATOMTABLE_H
+/**
+ * @file
+ * AtomTable is a process-wide table of interned strings (atoms) used to turn
+ * comparisons of interface names, member names and object paths into
+ * integer comparisons on the message routing and dispatch paths.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include AtomTable.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <alljoyn/Message.h>
+
+namespace ajn {
+
+/**
+ * An interned string. Two non-zero atoms are equal iff the strings they were
+ * interned from are equal.
+ */
+typedef uint32_t Atom;
+
+/**
+ * Atom for a NULL or empty string.
+ */
+static const Atom ATOM_NONE = 0;
+
+/**
+ * Atom returned by AtomTable::Find() for a non-empty string that has never been
+ * interned. It never compares equal to an atom returned by AtomTable::Intern().
+ */
+static const Atom ATOM_UNKNOWN = 0xFFFFFFFF;
+
+/**
+ * AtomTable is a thread-safe, process-wide table of interned strings. Atoms are
+ * never released so only strings that are registered locally (match rules,
+ * signal handlers, method handlers) should be interned. Strings received in
+ * messages are looked up with Find() which never grows the table. Find() is
+ * served from a small per-thread cache so the message paths rarely take the
+ * table lock.
+ */
+class AtomTable {
+  public:
+
+    /**
+     * Intern a string, adding it to the table if it is not already present.
+     *
+     * @param str   The string to intern.
+     *
+     * @return  The atom for str or ATOM_NONE if str is NULL or empty.
+     */
+    static Atom Intern(const char* str);
+
+    /**
+     * Intern a string, adding it to the table if it is not already present.
+     *
+     * @param str   The string to intern.
+     *
+     * @return  The atom for str or ATOM_NONE if str is empty.
+     */
+    static Atom Intern(const qcc::String& str) { return Intern(str.c_str()); }
+
+    /**
+     * Look up the atom for a string without adding it to the table.
+     *
+     * @param str   The string to look up.
+     *
+     * @return  - The atom for str
+     *          - ATOM_NONE if str is NULL or empty
+     *          - ATOM_UNKNOWN if str has never been interned.
+     */
+    static Atom Find(const char* str);
+
+    /**
+     * Get the atom for a path, interface or member header field of a message.
+     * The atom cached in the header fields is used if there is one, otherwise the
+     * field value is looked up in the table. A cached ATOM_UNKNOWN is looked up again
+     * since the string may have been interned after the atoms were cached.
+     *
+     * @param hdrFields   The message header fields.
+     * @param fieldId     ALLJOYN_HDR_FIELD_PATH, ALLJOYN_HDR_FIELD_INTERFACE or ALLJOYN_HDR_FIELD_MEMBER.
+     *
+     * @return  The atom for the header field (see Find()).
+     */
+    static Atom GetHeaderAtom(const HeaderFields& hdrFields, AllJoynFieldType fieldId);
+
+    /**
+     * Cache the atoms for the path, interface and member header fields.
+     *
+     * @param hdrFields   The message header fields to update.
+     */
+    static void SetHeaderAtoms(HeaderFields& hdrFields);
+};
+
+}
+
+#endif
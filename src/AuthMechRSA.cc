@@ -214,6 +214,31 @@ QStatus AuthMechRSA::Init(AuthRole authRole, const qcc::String& authPeer)
     return status;
 }
 
+bool AuthMechRSA::VerifyCertChain()
+{
+    uint8_t digest[Crypto_SHA1::DIGEST_SIZE];
+    Crypto_SHA1 sha1;
+    sha1.Init();
+    sha1.Update(remote.certChain);
+    sha1.GetDigest(digest);
+    qcc::String chainDigest((const char*)digest, sizeof(digest));
+    /*
+     * A chain the app accepted recently is accepted again without asking. The peer still has to
+     * prove it holds the private key for the certificate in the rest of the conversation.
+     */
+    if (listener.IsVerified(GetName(), chainDigest)) {
+        QCC_DbgHLPrintf(("Cert chain from %s was verified earlier", authPeer.c_str()));
+        return true;
+    }
+    AuthListener::Credentials creds;
+    creds.SetCertChain(remote.certChain.c_str());
+    if (!listener.VerifyCredentials(GetName(), authPeer.c_str(), creds)) {
+        return false;
+    }
+    listener.AddVerified(GetName(), chainDigest, creds);
+    return true;
+}
+
 void AuthMechRSA::ComputeMS(KeyBlob& pms)
 {
     qcc::String seed;
@@ -303,12 +328,8 @@ qcc::String AuthMechRSA::Response(const qcc::String& challenge,
         /*
          * Call up to app to accept or reject the cert chain
          */
-        if (status == ER_OK) {
-            AuthListener::Credentials creds;
-            creds.SetCertChain(remote.certChain.c_str());
-            if (!listener.VerifyCredentials(GetName(), authPeer.c_str(), creds)) {
-                status = ER_AUTH_FAIL;
-            }
+        if ((status == ER_OK) && !VerifyCertChain()) {
+            status = ER_AUTH_FAIL;
         }
         if (status == ER_OK) {
             /*
@@ -415,12 +436,8 @@ qcc::String AuthMechRSA::Challenge(const qcc::String& response,
         /*
          * Call up to app to accept or reject the cert chain
          */
-        if (status == ER_OK) {
-            AuthListener::Credentials creds;
-            creds.SetCertChain(remote.certChain.c_str());
-            if (!listener.VerifyCredentials(GetName(), authPeer.c_str(), creds)) {
-                status = ER_AUTH_FAIL;
-            }
+        if ((status == ER_OK) && !VerifyCertChain()) {
+            status = ER_AUTH_FAIL;
         }
         if (status == ER_OK) {
             challenge = local.certChain;
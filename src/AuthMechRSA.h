@@ -132,6 +132,14 @@ class AuthMechRSA : public AuthMechanism, qcc::Crypto_RSA::PassphraseListener {
      */
     AuthMechRSA(KeyStore& keyStore, ProtectedAuthListener& listener);
 
+    /**
+     * Have the app accept or reject the remote cert chain unless it accepted the same chain
+     * recently.
+     *
+     * @return  true if the cert chain is accepted.
+     */
+    bool VerifyCertChain();
+
     /**
      * Compute the master secret.
      */
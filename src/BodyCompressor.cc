@@ -0,0 +1,198 @@
+/**
+ * @file
+ * Fast LZ compression of message bodies sent over bus-to-bus links.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include "BodyCompressor.h"
+
+namespace ajn {
+
+static const size_t MIN_MATCH = 4;          /**< Shortest match that is encoded */
+static const size_t LAST_LITERALS = 5;      /**< The last bytes of the input are always literals */
+static const size_t MATCH_LIMIT = 12;       /**< No match may start this close to the end of the input */
+static const size_t MAX_OFFSET = 0xFFFF;    /**< Offsets are encoded in 16 bits */
+static const size_t HASH_BITS = 11;         /**< Size of the match finder hash table */
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t Hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+ * Lengths that do not fit in the 4 bits of the token are continued in bytes of 255
+ */
+static inline void WriteLength(uint8_t*& op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+}
+
+static inline bool ReadLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& len)
+{
+    uint8_t b;
+    do {
+        if (ip >= ipEnd) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+/*
+ * Emits a run of literals followed by a match, a match length of zero emits the final literals.
+ */
+static bool EmitSequence(uint8_t*& op, const uint8_t* opEnd, const uint8_t* lit, size_t litLen, size_t offset, size_t matchLen)
+{
+    size_t need = 1 + litLen + (litLen / 255) + 1;
+    if (matchLen) {
+        need += 2 + (matchLen / 255) + 1;
+    }
+    if (need > static_cast<size_t>(opEnd - op)) {
+        return false;
+    }
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>(((litLen < 15) ? litLen : 15) << 4);
+    if (litLen >= 15) {
+        WriteLength(op, litLen - 15);
+    }
+    memcpy(op, lit, litLen);
+    op += litLen;
+    if (matchLen) {
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        matchLen -= MIN_MATCH;
+        *token |= static_cast<uint8_t>((matchLen < 15) ? matchLen : 15);
+        if (matchLen >= 15) {
+            WriteLength(op, matchLen - 15);
+        }
+    }
+    return true;
+}
+
+size_t BodyCompressor::Compress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen)
+{
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + srcLen;
+    uint8_t* op = dst;
+    const uint8_t* opEnd = dst + dstLen;
+
+    if (srcLen > MATCH_LIMIT) {
+        uint32_t table[1 << HASH_BITS];
+        memset(table, 0, sizeof(table));
+        const uint8_t* ipLimit = end - MATCH_LIMIT;
+        const uint8_t* matchEnd = end - LAST_LITERALS;
+        while (ip < ipLimit) {
+            uint32_t seq = Read32(ip);
+            uint32_t h = Hash(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+            size_t offset = ip - ref;
+            if ((ref < ip) && (offset <= MAX_OFFSET) && (Read32(ref) == seq)) {
+                const uint8_t* mp = ip + MIN_MATCH;
+                ref += MIN_MATCH;
+                while ((mp < matchEnd) && (*mp == *ref)) {
+                    ++mp;
+                    ++ref;
+                }
+                if (!EmitSequence(op, opEnd, anchor, ip - anchor, offset, mp - ip)) {
+                    return 0;
+                }
+                ip = mp;
+                anchor = ip;
+            } else {
+                ++ip;
+            }
+        }
+    }
+    if (!EmitSequence(op, opEnd, anchor, end - anchor, 0, 0)) {
+        return 0;
+    }
+    return op - dst;
+}
+
+bool BodyCompressor::Expand(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen)
+{
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcLen;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + dstLen;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+        size_t litLen = token >> 4;
+        if ((litLen == 15) && !ReadLength(ip, ipEnd, litLen)) {
+            return false;
+        }
+        if ((litLen > static_cast<size_t>(ipEnd - ip)) || (litLen > static_cast<size_t>(opEnd - op))) {
+            return false;
+        }
+        memcpy(op, ip, litLen);
+        op += litLen;
+        ip += litLen;
+        /*
+         * The final sequence has no match
+         */
+        if (ip == ipEnd) {
+            break;
+        }
+        if ((ipEnd - ip) < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if ((offset == 0) || (offset > static_cast<size_t>(op - dst))) {
+            return false;
+        }
+        size_t matchLen = token & 15;
+        if ((matchLen == 15) && !ReadLength(ip, ipEnd, matchLen)) {
+            return false;
+        }
+        matchLen += MIN_MATCH;
+        if (matchLen > static_cast<size_t>(opEnd - op)) {
+            return false;
+        }
+        /*
+         * Matches may overlap the bytes they produce so copy a byte at a time
+         */
+        const uint8_t* ref = op - offset;
+        while (matchLen--) {
+            *op++ = *ref++;
+        }
+    }
+    return op == opEnd;
+}
+
+}
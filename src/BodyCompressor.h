@@ -0,0 +1,75 @@
+#ifndef _ALLJOYN_BODYCOMPRESSOR_H
+#define _ALLJOYN_BODYCOMPRESSOR_H
+/**
+ * @file
+ * Fast LZ compression of message bodies sent over bus-to-bus links.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include BodyCompressor.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+namespace ajn {
+
+/**
+ * BodyCompressor implements a greedy single pass compressor that produces the LZ4 block format
+ * and the matching decompressor. It trades compression ratio for speed so it can be used on
+ * every message sent over a slow link without becoming the bottleneck. There is no framing, the
+ * caller must carry the uncompressed length.
+ */
+class BodyCompressor {
+
+  public:
+
+    /**
+     * Bodies smaller than this are not worth compressing.
+     */
+    static const size_t THRESHOLD = 256;
+
+    /**
+     * Compress a buffer.
+     *
+     * @param src     The data to compress.
+     * @param srcLen  The number of bytes to compress.
+     * @param dst     Buffer for the compressed data.
+     * @param dstLen  The size of dst.
+     *
+     * @return  The length of the compressed data or 0 if it does not fit in dstLen bytes.
+     */
+    static size_t Compress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen);
+
+    /**
+     * Expand data compressed by Compress(). The compressed data is untrusted so this fails
+     * rather than reading or writing outside of either buffer.
+     *
+     * @param src     The compressed data.
+     * @param srcLen  The length of the compressed data.
+     * @param dst     Buffer for the expanded data.
+     * @param dstLen  The expected length of the expanded data.
+     *
+     * @return  true if src expanded to exactly dstLen bytes.
+     */
+    static bool Expand(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen);
+};
+
+}
+
+#endif
@@ -33,6 +33,7 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/BusListener.h>
@@ -58,7 +59,13 @@
 #include "AllJoynPeerObj.h"
 #include "XmlHelper.h"
 #include "ClientTransport.h"
+#include "ClientShmTransport.h"
 #include "NullTransport.h"
+#include "LatencyHistogram.h"
+#include "StartupProfile.h"
+#include "SignalBatcher.h"
+#include "StaticInterfaceTable.h"
+#include "ThreadScheduling.h"
 
 #if defined(QCC_OS_ANDROID)
 #include "android/WFDTransport.h"
@@ -87,6 +94,21 @@ struct JoinSessionAsyncCBContext {
     { }
 };
 
+struct JoinSessionsAsyncCBContext {
+    BusAttachment::JoinSessionAsyncCB* callback;
+    std::vector<BusAttachment::JoinRequest> requests;
+    std::vector<qcc::String> sessionHosts;    /* Copies of the session hosts of requests */
+
+    JoinSessionsAsyncCBContext(BusAttachment::JoinSessionAsyncCB* callback, const BusAttachment::JoinRequest* requests, size_t numRequests) :
+        callback(callback),
+        requests(requests, requests + numRequests)
+    {
+        for (size_t i = 0; i < numRequests; ++i) {
+            sessionHosts.push_back(requests[i].sessionHost);
+        }
+    }
+};
+
 struct SetLinkTimeoutAsyncCBContext {
     BusAttachment::SetLinkTimeoutAsyncCB* callback;
     void* context;
@@ -114,6 +136,7 @@ BusAttachment::Internal::Internal(const char* appName,
     listeners(),
     m_ioDispatch("iodisp", 128),
     transportList(bus, factories, &m_ioDispatch, concurrency),
+    routingPool("routing"),
     keyStore(application),
     authManager(keyStore),
     globalGuid(qcc::GUID128()),
@@ -123,7 +146,9 @@ BusAttachment::Internal::Internal(const char* appName,
     allowRemoteMessages(allowRemoteMessages),
     listenAddresses(listenAddresses ? listenAddresses : ""),
     stopLock(),
-    stopCount(0)
+    stopCount(0),
+    introspectionCacheEnabled(false),
+    syncReplySpin(0)
 {
     /*
      * Bus needs a pointer to this internal object.
@@ -133,6 +158,7 @@ BusAttachment::Internal::Internal(const char* appName,
     /*
      * Create the standard interfaces
      */
+    uint64_t phaseStart = GetLatencyClock();
     QStatus status = org::freedesktop::DBus::CreateInterfaces(bus);
     if (ER_OK != status) {
         QCC_LogError(status, ("Cannot create %s interface", org::freedesktop::DBus::InterfaceName));
@@ -141,6 +167,7 @@ BusAttachment::Internal::Internal(const char* appName,
     if (ER_OK != status) {
         QCC_LogError(status, ("Cannot create %s interface", org::alljoyn::Bus::InterfaceName));
     }
+    startupProfile.Record(StartupProfile::INTERFACES, phaseStart);
     /* Register bus client authentication mechanisms */
     authManager.RegisterMechanism(AuthMechPIN::Factory, AuthMechPIN::AuthName());
     authManager.RegisterMechanism(AuthMechExternal::Factory, AuthMechExternal::AuthName());
@@ -153,8 +180,16 @@ BusAttachment::Internal::~Internal()
      * Make sure that all threads that might possibly access this object have been joined.
      */
     transportList.Join();
+    routingPool.Stop();
+    routingPool.Join();
     delete router;
     router = NULL;
+
+    std::map<qcc::StringMapKey, const InterfaceDescription*>::iterator it;
+    for (it = sharedIfaces.begin(); it != sharedIfaces.end(); ++it) {
+        StaticInterfaceTable::Release(it->second);
+    }
+    sharedIfaces.clear();
 }
 
 /*
@@ -174,6 +209,9 @@ static class ClientTransportFactoryContainer : public TransportFactoryContainer
             if (ClientTransport::IsAvailable()) {
                 Add(new TransportFactory<ClientTransport>(ClientTransport::TransportName, true));
             }
+            if (ClientShmTransport::IsAvailable()) {
+                Add(new TransportFactory<ClientShmTransport>(ClientShmTransport::TransportName, true));
+            }
             if (NullTransport::IsAvailable()) {
                 Add(new TransportFactory<NullTransport>(NullTransport::TransportName, true));
             }
@@ -341,7 +379,9 @@ QStatus BusAttachment::Start()
     isStarted = true;
 
     /* Start the transports */
+    uint64_t phaseStart = GetLatencyClock();
     status = busInternal->transportList.Start(busInternal->GetListenAddresses());
+    busInternal->startupProfile.Record(StartupProfile::TRANSPORTS, phaseStart);
 
     if ((status == ER_OK) && isStopping) {
         status = ER_BUS_STOPPING;
@@ -417,6 +457,8 @@ QStatus BusAttachment::Connect(const char* connectSpec)
         status = ER_BUS_ALREADY_CONNECTED;
     } else {
         this->connectSpec = connectSpec;
+        uint64_t connectStart = GetLatencyClock();
+        uint64_t phaseStart = connectStart;
         status = TryConnect(connectSpec);
         /*
          * Try using the null transport to connect to a bundled daemon if there is one
@@ -430,8 +472,10 @@ QStatus BusAttachment::Connect(const char* connectSpec)
                 }
             }
         }
+        busInternal->startupProfile.Record(StartupProfile::CONNECT, phaseStart);
         /* If this is a client (non-daemon) bus attachment, then register signal handlers for BusListener */
         if ((ER_OK == status) && !isDaemon) {
+            phaseStart = GetLatencyClock();
             const InterfaceDescription* iface = GetInterface(org::freedesktop::DBus::InterfaceName);
             assert(iface);
             status = RegisterSignalHandler(busInternal,
@@ -444,6 +488,8 @@ QStatus BusAttachment::Connect(const char* connectSpec)
                 MsgArg arg("s", "type='signal',interface='org.freedesktop.DBus'");
                 const ProxyBusObject& dbusObj = this->GetDBusProxyObj();
                 status = dbusObj.MethodCall(org::freedesktop::DBus::InterfaceName, "AddMatch", &arg, 1, reply);
+                /* The time to the first method call is what a short-lived client actually waits for */
+                busInternal->startupProfile.RecordFirstMethodCall(connectStart);
             }
 
             /* Register org.alljoyn.Bus signal handler */
@@ -497,10 +543,13 @@ QStatus BusAttachment::Connect(const char* connectSpec)
                     trans->Disconnect(connectSpec);
                 }
             }
+            busInternal->startupProfile.Record(StartupProfile::SIGNAL_HANDLERS, phaseStart);
         }
     }
     if (ER_OK != status) {
         QCC_LogError(status, ("BusAttachment::Connect failed"));
+    } else {
+        QCC_DbgHLPrintf(("BusAttachment startup %s", busInternal->startupProfile.ToString().c_str()));
     }
     return status;
 }
@@ -615,6 +664,7 @@ QStatus BusAttachment::StopInternal(bool blockUntilStopped)
         if (ER_OK != status) {
             QCC_LogError(status, ("TransportList::Stop() failed"));
         }
+        busInternal->routingPool.Stop();
 
         /* Stop the threads currently waiting for join to complete */
         busInternal->joinLock.Lock();
@@ -664,6 +714,7 @@ void BusAttachment::WaitStopInternal()
          */
         if (isStarted) {
             busInternal->transportList.Join();
+            busInternal->routingPool.Join();
 
             /* Clear peer state */
             busInternal->peerStateTable.Clear();
@@ -692,6 +743,23 @@ QStatus BusAttachment::CreateInterface(const char* name, InterfaceDescription*&
     return ER_OK;
 }
 
+QStatus BusAttachment::CreateInterface(const InterfaceDescription::StaticInterface& table, const InterfaceDescription*& iface)
+{
+    iface = NULL;
+    if (!table.name) {
+        return ER_BAD_ARG_1;
+    }
+    if ((NULL != GetInterface(table.name)) ||
+        (busInternal->ifaceDescriptions.find(StringMapKey(table.name)) != busInternal->ifaceDescriptions.end())) {
+        return ER_BUS_IFACE_ALREADY_EXISTS;
+    }
+    QStatus status = StaticInterfaceTable::Acquire(table, iface);
+    if (status == ER_OK) {
+        busInternal->sharedIfaces[StringMapKey(String(table.name))] = iface;
+    }
+    return status;
+}
+
 QStatus BusAttachment::DeleteInterface(InterfaceDescription& iface)
 {
     /* Get the (hopefully) unactivated interface */
@@ -716,6 +784,13 @@ size_t BusAttachment::GetInterfaces(const InterfaceDescription** ifaces, size_t
             ++count;
         }
     }
+    map<qcc::StringMapKey, const InterfaceDescription*>::const_iterator sit;
+    for (sit = busInternal->sharedIfaces.begin(); sit != busInternal->sharedIfaces.end(); sit++) {
+        if (ifaces && (count < numIfaces)) {
+            ifaces[count] = sit->second;
+        }
+        ++count;
+    }
     return count;
 }
 
@@ -724,9 +799,12 @@ const InterfaceDescription* BusAttachment::GetInterface(const char* name) const
     map<StringMapKey, InterfaceDescription>::const_iterator it = busInternal->ifaceDescriptions.find(StringMapKey(name));
     if ((it != busInternal->ifaceDescriptions.end()) && it->second.isActivated) {
         return &(it->second);
-    } else {
-        return NULL;
     }
+    map<StringMapKey, const InterfaceDescription*>::const_iterator sit = busInternal->sharedIfaces.find(StringMapKey(name));
+    if (sit != busInternal->sharedIfaces.end()) {
+        return sit->second;
+    }
+    return NULL;
 }
 
 QStatus BusAttachment::RegisterKeyStoreListener(KeyStoreListener& listener)
@@ -809,6 +887,11 @@ QStatus BusAttachment::RegisterBusObject(BusObject& obj) {
     return busInternal->localEndpoint->RegisterBusObject(obj);
 }
 
+QStatus BusAttachment::RegisterBusObjects(BusObject** objects, size_t numObjects)
+{
+    return busInternal->localEndpoint->RegisterBusObjects(objects, numObjects);
+}
+
 void BusAttachment::UnregisterBusObject(BusObject& object)
 {
     busInternal->localEndpoint->UnregisterBusObject(object);
@@ -1048,6 +1131,155 @@ QStatus BusAttachment::FindAdvertisedName(const char* namePrefix)
     return status;
 }
 
+/*
+ * A daemon that predates a method of org.alljoyn.Bus, such as JoinSessions, does not know it.
+ */
+static bool DaemonMethodMissing(const char* errorName)
+{
+    return errorName &&
+           ((strcmp("org.alljoyn.Bus.ER_BUS_OBJECT_NO_SUCH_MEMBER", errorName) == 0) ||
+            (strcmp("org.alljoyn.Bus.ER_BUS_INTERFACE_NO_SUCH_MEMBER", errorName) == 0));
+}
+
+QStatus BusAttachment::AddMatches(const char** rules, size_t numRules, QStatus* statuses)
+{
+    return ChangeMatches("AddMatches", rules, numRules, statuses);
+}
+
+QStatus BusAttachment::RemoveMatches(const char** rules, size_t numRules, QStatus* statuses)
+{
+    return ChangeMatches("RemoveMatches", rules, numRules, statuses);
+}
+
+QStatus BusAttachment::ChangeMatches(const char* method, const char** rules, size_t numRules, QStatus* statuses)
+{
+    if (!IsConnected()) {
+        return ER_BUS_NOT_CONNECTED;
+    }
+
+    if (!rules && numRules) {
+        return ER_BAD_ARG_1;
+    }
+
+    Message reply(*this);
+    MsgArg arg;
+    arg.Set("as", numRules, rules);
+
+    bool add = (strcmp(method, "AddMatches") == 0);
+    const ProxyBusObject& alljoynObj = this->GetAllJoynProxyObj();
+    QStatus status = alljoynObj.MethodCall(org::alljoyn::Bus::InterfaceName, method, &arg, 1, reply);
+    if (ER_OK == status) {
+        size_t numResults;
+        uint32_t* results;
+        status = reply->GetArgs("au", &numResults, &results);
+        if ((ER_OK == status) && (numResults != numRules)) {
+            status = ER_BUS_BAD_VALUE;
+        }
+        if (ER_OK == status) {
+            for (size_t i = 0; i < numRules; ++i) {
+                QStatus ruleStatus = static_cast<QStatus>(results[i]);
+                if (statuses) {
+                    statuses[i] = ruleStatus;
+                }
+                if (ER_OK == status) {
+                    status = ruleStatus;
+                }
+            }
+        }
+    } else if ((ER_BUS_REPLY_IS_ERROR_MESSAGE == status) && DaemonMethodMissing(reply->GetErrorName())) {
+        QCC_DbgPrintf(("%s.%s is not supported, sending one rule at a time", org::alljoyn::Bus::InterfaceName, method));
+        status = ER_OK;
+        for (size_t i = 0; i < numRules; ++i) {
+            QStatus ruleStatus = add ? AddMatch(rules[i]) : RemoveMatch(rules[i]);
+            if (statuses) {
+                statuses[i] = ruleStatus;
+            }
+            if (ER_OK == status) {
+                status = ruleStatus;
+            }
+        }
+    } else {
+        QCC_LogError(status, ("%s.%s returned ERROR_MESSAGE (error=%s)", org::alljoyn::Bus::InterfaceName, method, reply->GetErrorDescription().c_str()));
+    }
+    return status;
+}
+
+QStatus BusAttachment::ReplaceMatches(const char** rules, size_t numRules)
+{
+    if (!IsConnected()) {
+        return ER_BUS_NOT_CONNECTED;
+    }
+
+    if (!rules && numRules) {
+        return ER_BAD_ARG_1;
+    }
+
+    Message reply(*this);
+    MsgArg arg;
+    arg.Set("as", numRules, rules);
+
+    const ProxyBusObject& alljoynObj = this->GetAllJoynProxyObj();
+    QStatus status = alljoynObj.MethodCall(org::alljoyn::Bus::InterfaceName, "ReplaceMatches", &arg, 1, reply);
+    if (ER_OK == status) {
+        uint32_t result;
+        status = reply->GetArgs("u", &result);
+        if (ER_OK == status) {
+            status = static_cast<QStatus>(result);
+        }
+    } else {
+        QCC_LogError(status, ("%s.ReplaceMatches returned ERROR_MESSAGE (error=%s)", org::alljoyn::Bus::InterfaceName, reply->GetErrorDescription().c_str()));
+    }
+    return status;
+}
+
+QStatus BusAttachment::FindAdvertisedNameFiltered(const char* namePrefix, TransportMask transports, const char** filters, size_t numFilters)
+{
+    if (!IsConnected()) {
+        return ER_BUS_NOT_CONNECTED;
+    }
+
+    if (!namePrefix) {
+        return ER_BAD_ARG_1;
+    }
+
+    Message reply(*this);
+    MsgArg args[3];
+    size_t numArgs = ArraySize(args);
+
+    MsgArg::Set(args, numArgs, "sqas", namePrefix, transports, numFilters, filters);
+
+    const ProxyBusObject& alljoynObj = this->GetAllJoynProxyObj();
+    QStatus status = alljoynObj.MethodCall(org::alljoyn::Bus::InterfaceName, "FindAdvertisedNameFiltered", args, numArgs, reply);
+    if (ER_OK == status) {
+        uint32_t disposition;
+        status = reply->GetArgs("u", &disposition);
+        if (ER_OK == status) {
+            switch (disposition) {
+            case ALLJOYN_FINDADVERTISEDNAME_REPLY_SUCCESS:
+                break;
+
+            case ALLJOYN_FINDADVERTISEDNAME_REPLY_ALREADY_DISCOVERING:
+                status = ER_ALLJOYN_FINDADVERTISEDNAME_REPLY_ALREADY_DISCOVERING;
+                break;
+
+            case ALLJOYN_FINDADVERTISEDNAME_REPLY_FAILED:
+                status = ER_ALLJOYN_FINDADVERTISEDNAME_REPLY_FAILED;
+                break;
+
+            default:
+                status = ER_BUS_UNEXPECTED_DISPOSITION;
+                break;
+            }
+        }
+    } else if ((ER_BUS_REPLY_IS_ERROR_MESSAGE == status) && DaemonMethodMissing(reply->GetErrorName())) {
+        /* The daemon cannot filter, the listener sees every name with the prefix */
+        status = FindAdvertisedNameByTransport(namePrefix, transports);
+    } else {
+        QCC_LogError(status, ("%s.FindAdvertisedNameFiltered returned ERROR_MESSAGE (error=%s)", org::alljoyn::Bus::InterfaceName, reply->GetErrorDescription().c_str()));
+    }
+    return status;
+}
+
 QStatus BusAttachment::FindAdvertisedNameByTransport(const char* namePrefix, TransportMask transports)
 {
     if (!IsConnected()) {
@@ -1489,13 +1721,104 @@ void BusAttachment::Internal::JoinSessionAsyncCB(Message& reply, void* context)
     delete ctx;
 }
 
+QStatus BusAttachment::JoinSessionsAsync(const JoinRequest* requests, size_t numRequests, BusAttachment::JoinSessionAsyncCB* callback)
+{
+    if (!IsConnected()) {
+        return ER_BUS_NOT_CONNECTED;
+    }
+    for (size_t i = 0; i < numRequests; ++i) {
+        if (!IsLegalBusName(requests[i].sessionHost)) {
+            return ER_BUS_BAD_BUS_NAME;
+        }
+    }
+
+    vector<MsgArg> joins(numRequests);
+    for (size_t i = 0; i < numRequests; ++i) {
+        MsgArg optsArg;
+        SetSessionOpts(requests[i].opts, optsArg);
+        joins[i].Set("(sq*)", requests[i].sessionHost, requests[i].sessionPort, &optsArg);
+        joins[i].Stabilize();
+    }
+    MsgArg arg;
+    arg.Set("a(sq" SESSIONOPTS_SIG ")", joins.size(), joins.empty() ? NULL : &joins[0]);
+
+    const ProxyBusObject& alljoynObj = this->GetAllJoynProxyObj();
+    JoinSessionsAsyncCBContext* cbCtx = new JoinSessionsAsyncCBContext(callback, requests, numRequests);
+
+    QStatus status = alljoynObj.MethodCallAsync(org::alljoyn::Bus::InterfaceName,
+                                                "JoinSessions",
+                                                busInternal,
+                                                static_cast<MessageReceiver::ReplyHandler>(&BusAttachment::Internal::JoinSessionsAsyncCB),
+                                                &arg,
+                                                1,
+                                                cbCtx,
+                                                90000);
+    if (status != ER_OK) {
+        delete cbCtx;
+    }
+    return status;
+}
+
+void BusAttachment::Internal::JoinSessionsAsyncCB(Message& reply, void* context)
+{
+    JoinSessionsAsyncCBContext* ctx = reinterpret_cast<JoinSessionsAsyncCBContext*>(context);
+    std::vector<BusAttachment::JoinRequest>& requests = ctx->requests;
+
+    QStatus status = ER_FAIL;
+    size_t numResults = 0;
+    const MsgArg* results = NULL;
+    if (reply->GetType() == MESSAGE_METHOD_RET) {
+        status = reply->GetArgs("a(uu" SESSIONOPTS_SIG ")", &numResults, &results);
+        if ((status == ER_OK) && (numResults != requests.size())) {
+            status = ER_BUS_BAD_VALUE;
+        }
+    } else if (reply->GetType() == MESSAGE_ERROR) {
+        if (DaemonMethodMissing(reply->GetErrorName())) {
+            /* Fall back to one JoinSession call per request */
+            QCC_DbgPrintf(("%s.JoinSessions is not supported, joining one session at a time", org::alljoyn::Bus::InterfaceName));
+            for (size_t i = 0; i < requests.size(); ++i) {
+                const BusAttachment::JoinRequest& req = requests[i];
+                status = bus.JoinSessionAsync(ctx->sessionHosts[i].c_str(), req.sessionPort, req.listener, req.opts, ctx->callback, req.context);
+                if (status != ER_OK) {
+                    ctx->callback->JoinSessionCB(status, 0, req.opts, req.context);
+                }
+            }
+            delete ctx;
+            return;
+        }
+        status = ER_BUS_REPLY_IS_ERROR_MESSAGE;
+        QCC_LogError(status, ("%s.JoinSessions returned ERROR_MESSAGE (error=%s)", org::alljoyn::Bus::InterfaceName, reply->GetErrorDescription().c_str()));
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        QStatus joinStatus = status;
+        SessionId sessionId = 0;
+        SessionOpts opts;
+        if (joinStatus == ER_OK) {
+            joinStatus = bus.GetJoinSessionResult(results[i].v_struct.members, sessionId, opts);
+        }
+        if (requests[i].listener && (joinStatus == ER_OK)) {
+            sessionListenersLock.Lock(MUTEX_CONTEXT);
+            sessionListeners[sessionId] = ProtectedSessionListener(requests[i].listener);
+            sessionListenersLock.Unlock(MUTEX_CONTEXT);
+        }
+        ctx->callback->JoinSessionCB(joinStatus, sessionId, opts, requests[i].context);
+    }
+    delete ctx;
+}
+
 QStatus BusAttachment::GetJoinSessionResponse(Message& reply, SessionId& sessionId, SessionOpts& opts)
 {
-    QStatus status = ER_OK;
     const MsgArg* replyArgs;
     size_t na;
     reply->GetArgs(na, replyArgs);
     assert(na == 3);
+    return GetJoinSessionResult(replyArgs, sessionId, opts);
+}
+
+QStatus BusAttachment::GetJoinSessionResult(const MsgArg* replyArgs, SessionId& sessionId, SessionOpts& opts)
+{
+    QStatus status = ER_OK;
     uint32_t disposition = replyArgs[0].v_uint32;
     sessionId = replyArgs[1].v_uint32;
     status = GetSessionOpts(replyArgs[2], opts);
@@ -1663,6 +1986,11 @@ QStatus BusAttachment::LeaveSession(const SessionId& sessionId)
         QCC_LogError(status, ("%s.LeaveSession returned ERROR_MESSAGE (error=%s)", org::alljoyn::Bus::InterfaceName, reply->GetErrorDescription().c_str()));
     }
 
+    /* Close the session's direct path, if it has one */
+    if (!busInternal->GetRouter().IsDaemon()) {
+        static_cast<ClientRouter&>(busInternal->GetRouter()).RemoveDirectPath(sessionId);
+    }
+
     /*
      * Remove sessionListener and wait for callbacks to complete.
      * Do this regardless of whether LeaveSession succeeds or fails.
@@ -1816,6 +2144,12 @@ QStatus BusAttachment::SetLinkTimeout(SessionId sessionId, uint32_t& linkTimeout
 
 void BusAttachment::Internal::NonLocalEndpointDisconnected()
 {
+    /* Name owners are not tracked while disconnected so the cache cannot be trusted afterwards */
+    nameOwnerLock.Lock(MUTEX_CONTEXT);
+    nameOwnerPrefixes.clear();
+    nameOwners.clear();
+    nameOwnerLock.Unlock(MUTEX_CONTEXT);
+
     listenersLock.Lock(MUTEX_CONTEXT);
     ListenerSet::iterator it = listeners.begin();
     while (it != listeners.end()) {
@@ -1833,6 +2167,269 @@ void BusAttachment::EnableConcurrentCallbacks()
     busInternal->localEndpoint->EnableReentrancy();
 }
 
+void BusAttachment::EnableHandlerProfiling(bool enable, bool reset)
+{
+    HandlerProfile& profile = busInternal->localEndpoint->GetHandlerProfile();
+    if (reset) {
+        profile.Reset();
+    }
+    profile.Enable(enable);
+}
+
+qcc::String BusAttachment::GetHandlerProfile() const
+{
+    return busInternal->localEndpoint->GetHandlerProfile().ToString();
+}
+
+/* Upper bound on the number of objects in the introspection cache */
+static const size_t MAX_CACHED_INTROSPECTIONS = 1024;
+
+void BusAttachment::EnableIntrospectionCache(bool enable)
+{
+    busInternal->introspectionLock.Lock(MUTEX_CONTEXT);
+    busInternal->introspectionCacheEnabled = enable;
+    if (!enable) {
+        busInternal->introspectionCache.clear();
+    }
+    busInternal->introspectionLock.Unlock(MUTEX_CONTEXT);
+}
+
+void BusAttachment::EnableMethodCallSpin(uint32_t spinTime)
+{
+    busInternal->syncReplySpin = spinTime;
+}
+
+QStatus BusAttachment::SetDispatchScheduling(SchedulingPolicy policy, int priority, uint64_t cpuMask, bool lockMemory)
+{
+    ThreadScheduling::Policy p;
+    switch (policy) {
+    case SCHEDULING_DEFAULT: p = ThreadScheduling::POLICY_DEFAULT; break;
+    case SCHEDULING_FIFO:    p = ThreadScheduling::POLICY_FIFO; break;
+    case SCHEDULING_RR:      p = ThreadScheduling::POLICY_RR; break;
+    default:                 return ER_BAD_ARG_1;
+    }
+    return ThreadScheduling::Set(p, priority, cpuMask, lockMemory);
+}
+
+void BusAttachment::EnableSignalBatching(uint32_t maxDelay, size_t maxBytes)
+{
+    SignalBatcher* batcher = busInternal->localEndpoint->GetSignalBatcher();
+    if (batcher) {
+        batcher->SetLatencyBudget(maxDelay, maxBytes);
+    }
+}
+
+QStatus BusAttachment::AddNameOwnerCache(const char* prefix)
+{
+    if (!IsConnected()) {
+        return ER_BUS_NOT_CONNECTED;
+    }
+    qcc::String pfx(prefix);
+    busInternal->nameOwnerLock.Lock(MUTEX_CONTEXT);
+    bool added = busInternal->nameOwnerPrefixes.insert(std::make_pair(pfx, false)).second;
+    busInternal->nameOwnerLock.Unlock(MUTEX_CONTEXT);
+    if (!added) {
+        return ER_OK;
+    }
+
+    /*
+     * Names that change owner while the cache is being filled are recorded by the signal handler
+     * and take precedence over the replies below which may be older.
+     */
+    const ProxyBusObject& dbusObj = GetDBusProxyObj();
+    Message reply(*this);
+    QStatus status = dbusObj.MethodCall(org::freedesktop::DBus::InterfaceName, "ListNames", NULL, 0, reply);
+    std::vector<qcc::String> names;
+    std::vector<ProxyBusObject::BatchedCall> calls;
+    std::vector<MsgArg> args;
+    if (status == ER_OK) {
+        size_t numNames;
+        const MsgArg* nameArgs;
+        status = reply->GetArg(0)->Get("as", &numNames, &nameArgs);
+        for (size_t i = 0; (status == ER_OK) && (i < numNames); ++i) {
+            qcc::String name = nameArgs[i].v_string.str;
+            if (name.compare(0, pfx.size(), pfx) == 0) {
+                names.push_back(name);
+            }
+        }
+    }
+    if ((status == ER_OK) && !names.empty()) {
+        const InterfaceDescription::Member* getNameOwner = GetInterface(org::freedesktop::DBus::InterfaceName)->GetMember("GetNameOwner");
+        args.resize(names.size());
+        calls.reserve(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            args[i].Set("s", names[i].c_str());
+            calls.push_back(ProxyBusObject::BatchedCall(*this, *getNameOwner, &args[i], 1));
+        }
+        /* A name released since ListNames fails its own call, that is not an error for the cache */
+        dbusObj.MethodCallBatch(&calls[0], calls.size());
+    }
+
+    busInternal->nameOwnerLock.Lock(MUTEX_CONTEXT);
+    std::map<qcc::String, bool>::iterator it = busInternal->nameOwnerPrefixes.find(pfx);
+    if (it != busInternal->nameOwnerPrefixes.end()) {
+        if (status == ER_OK) {
+            for (size_t i = 0; i < calls.size(); ++i) {
+                if (calls[i].status == ER_OK) {
+                    busInternal->nameOwners.insert(std::make_pair(names[i], qcc::String(calls[i].replyMsg->GetArg(0)->v_string.str)));
+                }
+            }
+            it->second = true;
+        } else {
+            busInternal->nameOwnerPrefixes.erase(it);
+        }
+        busInternal->PruneNameOwners();
+    }
+    busInternal->nameOwnerLock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+void BusAttachment::RemoveNameOwnerCache(const char* prefix)
+{
+    busInternal->nameOwnerLock.Lock(MUTEX_CONTEXT);
+    if (busInternal->nameOwnerPrefixes.erase(prefix)) {
+        busInternal->PruneNameOwners();
+    }
+    busInternal->nameOwnerLock.Unlock(MUTEX_CONTEXT);
+}
+
+bool BusAttachment::GetCachedNameOwner(const char* name, qcc::String& owner)
+{
+    qcc::String busName(name);
+    bool filling = false;
+    busInternal->nameOwnerLock.Lock(MUTEX_CONTEXT);
+    bool cached = busInternal->NameOwnerCached(busName, filling) && !filling;
+    if (cached) {
+        Internal::NameOwnerMap::const_iterator it = busInternal->nameOwners.find(busName);
+        owner = (it == busInternal->nameOwners.end()) ? qcc::String() : it->second;
+    }
+    busInternal->nameOwnerLock.Unlock(MUTEX_CONTEXT);
+    return cached;
+}
+
+bool BusAttachment::Internal::NameOwnerCached(const qcc::String& name, bool& filling) const
+{
+    bool cached = false;
+    filling = false;
+    for (std::map<qcc::String, bool>::const_iterator it = nameOwnerPrefixes.begin(); it != nameOwnerPrefixes.end(); ++it) {
+        if (name.compare(0, it->first.size(), it->first) == 0) {
+            cached = true;
+            filling |= !it->second;
+        }
+    }
+    return cached;
+}
+
+void BusAttachment::Internal::PruneNameOwners()
+{
+    NameOwnerMap::iterator it = nameOwners.begin();
+    while (it != nameOwners.end()) {
+        bool filling;
+        if (!NameOwnerCached(it->first, filling) || (it->second.empty() && !filling)) {
+            nameOwners.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BusAttachment::Internal::UpdateNameOwner(const qcc::String& name, const qcc::String& newOwner)
+{
+    bool filling;
+    nameOwnerLock.Lock(MUTEX_CONTEXT);
+    if (NameOwnerCached(name, filling)) {
+        if (newOwner.empty() && !filling) {
+            nameOwners.erase(name);
+        } else {
+            nameOwners[name] = newOwner;
+        }
+    }
+    nameOwnerLock.Unlock(MUTEX_CONTEXT);
+}
+
+bool BusAttachment::Internal::GetCachedIntrospection(const qcc::String& busName, const qcc::String& path, qcc::String& xml)
+{
+    bool found = false;
+    introspectionLock.Lock(MUTEX_CONTEXT);
+    if (introspectionCacheEnabled) {
+        IntrospectionCache::const_iterator it = introspectionCache.find(std::make_pair(busName, path));
+        if (it != introspectionCache.end()) {
+            xml = it->second;
+            found = true;
+        }
+    }
+    introspectionLock.Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
+void BusAttachment::Internal::CacheIntrospection(const qcc::String& busName, const qcc::String& path, const qcc::String& xml)
+{
+    introspectionLock.Lock(MUTEX_CONTEXT);
+    if (introspectionCacheEnabled) {
+        /* Start over rather than track usage, a full cache means the application has moved on */
+        if (introspectionCache.size() >= MAX_CACHED_INTROSPECTIONS) {
+            introspectionCache.clear();
+        }
+        introspectionCache[std::make_pair(busName, path)] = xml;
+    }
+    introspectionLock.Unlock(MUTEX_CONTEXT);
+}
+
+void BusAttachment::Internal::FlushIntrospection(const qcc::String& busName)
+{
+    introspectionLock.Lock(MUTEX_CONTEXT);
+    IntrospectionCache::iterator it = introspectionCache.lower_bound(std::make_pair(busName, qcc::String()));
+    while ((it != introspectionCache.end()) && (it->first.first == busName)) {
+        introspectionCache.erase(it++);
+    }
+    noCompactIntrospection.erase(busName);
+    introspectionLock.Unlock(MUTEX_CONTEXT);
+}
+
+bool BusAttachment::Internal::SupportsCompactIntrospection(const qcc::String& busName)
+{
+    introspectionLock.Lock(MUTEX_CONTEXT);
+    bool supported = (noCompactIntrospection.find(busName) == noCompactIntrospection.end());
+    introspectionLock.Unlock(MUTEX_CONTEXT);
+    return supported;
+}
+
+void BusAttachment::Internal::NoCompactIntrospection(const qcc::String& busName)
+{
+    introspectionLock.Lock(MUTEX_CONTEXT);
+    /* Names are only removed when their owner changes so keep the set bounded */
+    if (noCompactIntrospection.size() >= MAX_CACHED_INTROSPECTIONS) {
+        noCompactIntrospection.clear();
+    }
+    noCompactIntrospection.insert(busName);
+    introspectionLock.Unlock(MUTEX_CONTEXT);
+}
+
+/* Upper bound on the number of bus addresses remembered for pipelined establishment */
+static const size_t MAX_PIPELINED_ESTABLISH_SPECS = 256;
+
+bool BusAttachment::Internal::GetPipelinedEstablish(const qcc::String& connectSpec, bool& supported)
+{
+    pipelinedEstablishLock.Lock(MUTEX_CONTEXT);
+    std::map<qcc::String, bool>::const_iterator it = pipelinedEstablish.find(connectSpec);
+    bool known = (it != pipelinedEstablish.end());
+    if (known) {
+        supported = it->second;
+    }
+    pipelinedEstablishLock.Unlock(MUTEX_CONTEXT);
+    return known;
+}
+
+void BusAttachment::Internal::SetPipelinedEstablish(const qcc::String& connectSpec, bool supported)
+{
+    pipelinedEstablishLock.Lock(MUTEX_CONTEXT);
+    if (pipelinedEstablish.size() >= MAX_PIPELINED_ESTABLISH_SPECS) {
+        pipelinedEstablish.clear();
+    }
+    pipelinedEstablish[connectSpec] = supported;
+    pipelinedEstablishLock.Unlock(MUTEX_CONTEXT);
+}
+
 void BusAttachment::Internal::AllJoynSignalHandler(const InterfaceDescription::Member* member,
                                                    const char* srcPath,
                                                    Message& msg)
@@ -1886,6 +2483,12 @@ void BusAttachment::Internal::AllJoynSignalHandler(const InterfaceDescription::M
                 sessionListenersLock.Unlock(MUTEX_CONTEXT);
             }
         } else if (0 == strcmp("NameOwnerChanged", msg->GetMemberName())) {
+            /* Objects introspected through the name or its previous owner may have gone away */
+            FlushIntrospection(args[0].v_string.str);
+            if (0 < args[1].v_string.len) {
+                FlushIntrospection(args[1].v_string.str);
+            }
+            UpdateNameOwner(args[0].v_string.str, args[2].v_string.str);
             listenersLock.Lock(MUTEX_CONTEXT);
             ListenerSet::iterator it = listeners.begin();
             while (it != listeners.end()) {
@@ -2057,6 +2660,14 @@ QStatus BusAttachment::ReloadKeyStore()
     return busInternal->keyStore.Reload();
 }
 
+void BusAttachment::ClearVerifiedCredentials()
+{
+    AllJoynPeerObj* peerObj = busInternal->localEndpoint->GetPeerObj();
+    if (peerObj) {
+        peerObj->ClearVerifiedCredentials();
+    }
+}
+
 QStatus BusAttachment::ClearKeys(const qcc::String& guid)
 {
     if (!qcc::GUID128::IsGUID(guid)) {
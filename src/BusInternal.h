@@ -32,17 +32,23 @@
 #include <qcc/atomic.h>
 #include <qcc/ManagedObj.h>
 #include <qcc/IODispatch.h>
+#include <qcc/Stream.h>
+#include <qcc/STLContainer.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/InterfaceDescription.h>
 
 #include "AuthManager.h"
 #include "ClientRouter.h"
+#include "IODispatchPool.h"
+#include "LinkMonitor.h"
+#include "RoutingPool.h"
 #include "KeyStore.h"
 #include "PeerState.h"
 #include "Transport.h"
 #include "TransportList.h"
 #include "CompressionRules.h"
+#include "StartupProfile.h"
 
 #include <alljoyn/Status.h>
 
@@ -125,11 +131,34 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
     const Router& GetRouter(void) const { return *router; }
 
     /**
-     * Get the iodispatch.
+     * Get the iodispatch that services a stream.
+     *
+     * @param stream   The stream.
      *
      * @return  The iodispatch
      */
-    qcc::IODispatch& GetIODispatch(void) { return m_ioDispatch; }
+    qcc::IODispatch& GetIODispatch(const qcc::Stream* stream) { return m_ioDispatch.Get(stream); }
+
+    /**
+     * Get the pool of iodispatch event loops.
+     *
+     * @return  The iodispatch pool
+     */
+    IODispatchPool& GetIODispatchPool(void) { return m_ioDispatch; }
+
+    /**
+     * Get the link timeout monitor shared by all remote endpoints.
+     *
+     * @return  The link monitor
+     */
+    LinkMonitor& GetLinkMonitor(void) { return linkMonitor; }
+
+    /**
+     * Get the workers that route messages received on the remote endpoints.
+     *
+     * @return  The routing pool.
+     */
+    RoutingPool& GetRoutingPool(void) { return routingPool; }
     /**
      * Get the header compression rules
      *
@@ -228,6 +257,11 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
      */
     void JoinSessionAsyncCB(Message& message, void* context);
 
+    /**
+     * JoinSessionsAsync method_reply handler.
+     */
+    void JoinSessionsAsyncCB(Message& message, void* context);
+
     /**
      * SetLinkTimeoutAsync method_reply handler.
      */
@@ -244,6 +278,83 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
         return router->PushMessage(msg, busEndpoint);
     }
 
+    /**
+     * Look up cached introspection XML for a remote object.
+     *
+     * @param busName  The bus name the object was introspected through.
+     * @param path     The object path.
+     * @param xml      [OUT] Returns the cached introspection XML.
+     *
+     * @return  true if the introspection cache is enabled and has an entry for the object.
+     */
+    bool GetCachedIntrospection(const qcc::String& busName, const qcc::String& path, qcc::String& xml);
+
+    /**
+     * Add the introspection XML for a remote object to the cache if the cache is enabled.
+     *
+     * @param busName  The bus name the object was introspected through.
+     * @param path     The object path.
+     * @param xml      The introspection XML.
+     */
+    void CacheIntrospection(const qcc::String& busName, const qcc::String& path, const qcc::String& xml);
+
+    /**
+     * Discard the cached introspection XML for all objects of a bus name.
+     *
+     * @param busName  The bus name.
+     */
+    void FlushIntrospection(const qcc::String& busName);
+
+    /**
+     * Check if a bus name might implement org.alljoyn.Bus.Introspectable.
+     *
+     * @param busName  The bus name.
+     *
+     * @return  false if an earlier IntrospectCompact call to the bus name failed.
+     */
+    bool SupportsCompactIntrospection(const qcc::String& busName);
+
+    /**
+     * Remember that a bus name does not implement org.alljoyn.Bus.Introspectable so later
+     * introspection goes straight to XML. Forgotten when the name owner changes.
+     *
+     * @param busName  The bus name.
+     */
+    void NoCompactIntrospection(const qcc::String& busName);
+
+    /**
+     * Check what an earlier connection to a bus address found out about pipelined establishment.
+     *
+     * @param connectSpec  The bus address.
+     * @param supported    [OUT] true if the daemon at the address accepts a pipelined establish.
+     *
+     * @return  false if no connection to the address has been established yet.
+     */
+    bool GetPipelinedEstablish(const qcc::String& connectSpec, bool& supported);
+
+    /**
+     * Remember whether the daemon at a bus address accepts a pipelined establish.
+     *
+     * @param connectSpec  The bus address.
+     * @param supported    true if the daemon agreed to pipelining.
+     */
+    void SetPipelinedEstablish(const qcc::String& connectSpec, bool supported);
+
+    /**
+     * Update the name owner cache from a NameOwnerChanged signal.
+     *
+     * @param name      The bus name.
+     * @param newOwner  The new owner of the name, empty if the name no longer has an owner.
+     */
+    void UpdateNameOwner(const qcc::String& name, const qcc::String& newOwner);
+
+    /**
+     * Get the time taken by each startup phase of this bus attachment.
+     *
+     * @return  The startup profile.
+     */
+    const StartupProfile& GetStartupProfile() const { return startupProfile; }
+
   private:
 
     /**
@@ -268,6 +379,34 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
      */
     void JoinSessionCB(QStatus status, SessionId sessionId, const SessionOpts& opts, void* context);
 
+    /**
+     * Check which name owner cache prefixes cover a bus name. Must be called holding nameOwnerLock.
+     *
+     * @param name     The bus name.
+     * @param filling  [OUT] true if a covering prefix is still being filled.
+     *
+     * @return  true if a prefix covers the name.
+     */
+    bool NameOwnerCached(const qcc::String& name, bool& filling) const;
+
+    /**
+     * Discard cached names that are no longer covered or that were only kept while filling.
+     * Must be called holding nameOwnerLock.
+     */
+    void PruneNameOwners();
+
+    struct NameHash {
+        inline size_t operator()(const qcc::String& s) const {
+            return qcc::hash_string(s.c_str());
+        }
+    };
+
+    struct NameEqual {
+        inline bool operator()(const qcc::String& s1, const qcc::String& s2) const {
+            return s1 == s2;
+        }
+    };
+
     qcc::String application;              /* Name of the that owns the BusAttachment application */
     BusAttachment& bus;                   /* Reference back to the bus attachment that owns this state */
 
@@ -276,8 +415,10 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
     typedef qcc::ManagedObj<BusListener*> ProtectedBusListener;
     typedef std::set<ProtectedBusListener> ListenerSet;
     ListenerSet listeners;               /* List of registered BusListeners */
-    qcc::IODispatch m_ioDispatch;         /* iodispatch for this bus */
+    LinkMonitor linkMonitor;              /* Link timeouts of the remote endpoints */
+    IODispatchPool m_ioDispatch;          /* iodispatch event loops for this bus */
     TransportList transportList;          /* List of active transports */
+    RoutingPool routingPool;              /* Routes messages received on the remote endpoints */
     KeyStore keyStore;                    /* The key store for the bus attachment */
     AuthManager authManager;              /* The authentication manager for the bus attachment */
     qcc::GUID128 globalGuid;              /* Global GUID for this BusAttachment */
@@ -287,6 +428,7 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
     LocalEndpoint localEndpoint;          /* The local endpoint */
     CompressionRules compressionRules;    /* Rules for compresssing and decompressing headers */
     std::map<qcc::StringMapKey, InterfaceDescription> ifaceDescriptions;
+    std::map<qcc::StringMapKey, const InterfaceDescription*> sharedIfaces;  /* Interfaces added from static tables */
 
     bool allowRemoteMessages;             /* true iff endpoints of this attachment can receive messages from remote devices */
     qcc::String listenAddresses;          /* The set of bus addresses that this bus can listen on. (empty for clients) */
@@ -311,6 +453,24 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
 
     std::map<qcc::Thread*, JoinContext> joinThreads;  /* List of threads waiting to join */
     qcc::Mutex joinLock;                              /* Mutex that protects joinThreads */
+
+    typedef std::map<std::pair<qcc::String, qcc::String>, qcc::String> IntrospectionCache;
+    IntrospectionCache introspectionCache;            /* Introspection XML by bus name and object path */
+    bool introspectionCacheEnabled;                   /* true if introspection XML is being cached */
+    std::set<qcc::String> noCompactIntrospection;    /* Bus names that only support introspection XML */
+    qcc::Mutex introspectionLock;                     /* Mutex that protects introspectionCache and noCompactIntrospection */
+
+    std::map<qcc::String, bool> pipelinedEstablish;   /* Bus addresses and whether their daemon accepts a pipelined establish */
+    qcc::Mutex pipelinedEstablishLock;                /* Mutex that protects pipelinedEstablish */
+
+    std::map<qcc::String, bool> nameOwnerPrefixes;    /* Cached bus name prefixes, true once the initial fill is done */
+    typedef std::unordered_map<qcc::String, qcc::String, NameHash, NameEqual> NameOwnerMap;
+    NameOwnerMap nameOwners;                          /* Owner by bus name, an empty owner marks a name released while filling */
+    qcc::Mutex nameOwnerLock;                         /* Mutex that protects nameOwnerPrefixes and nameOwners */
+
+    StartupProfile startupProfile;                    /* Time taken by each startup phase */
+
+    volatile uint32_t syncReplySpin;                  /* Microseconds a synchronous method call spins for its reply before blocking */
 };
 
 }
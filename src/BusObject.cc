@@ -25,6 +25,7 @@
 #include <assert.h>
 
 #include <map>
+#include <set>
 #include <vector>
 
 #include <qcc/Debug.h>
@@ -32,6 +33,7 @@
 #include <qcc/String.h>
 #include <qcc/ScopedMutexLock.h>
 #include <qcc/Mutex.h>
+#include <qcc/Timer.h>
 #include <alljoyn/DBusStd.h>
 #include <alljoyn/AllJoynStd.h>
 #include <alljoyn/BusObject.h>
@@ -58,6 +60,23 @@ typedef struct {
     void* context;
 } MethodContext;
 
+/** Sends the PropertiesChanged signals queued while coalescing when the window expires */
+class PropChangedAlarmListener : public qcc::AlarmListener {
+  public:
+    PropChangedAlarmListener(BusObject* obj) : obj(obj) { }
+
+  private:
+    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason) { obj->FlushPropChanged(); }
+
+    BusObject* obj;
+};
+
+/** Property changes queued for one coalesced PropertiesChanged signal */
+struct PendingPropChanges {
+    map<qcc::String, MsgArg> changed;
+    set<qcc::String> invalidated;
+};
+
 struct BusObject::Components {
     /** The interfaces this object implements */
     vector<const InterfaceDescription*> ifaces;
@@ -71,6 +90,55 @@ struct BusObject::Components {
 
     /** counter to prevent this BusObject being deleted if it is being used by another thread. */
     int32_t inUseCounter;
+
+    /** true if method calls to this object are dispatched one at a time independently of other objects */
+    bool serializedMethodCalls;
+
+    /** Cached result of a shallow GenerateIntrospection() */
+    qcc::String introspection;
+
+    /** Indent the cached introspection was generated with */
+    size_t introspectionIndent;
+
+    /** true if introspection is up to date with the interfaces and children of the object */
+    bool introspectionValid;
+
+    /** lock to protect the cached introspection */
+    qcc::Mutex introspectionLock;
+
+    /** Property changes waiting to be sent, by interface name and session */
+    map<pair<qcc::String, SessionId>, PendingPropChanges> pendingPropChanges;
+
+    /** Coalescing window for PropertiesChanged signals in milliseconds, 0 if not coalescing */
+    uint32_t propChangedWindow;
+
+    /** Alarm that sends the pending property changes */
+    qcc::Alarm propChangedAlarm;
+
+    /** true if propChangedAlarm is scheduled */
+    bool propChangedAlarmSet;
+
+    /** true if propChangedAlarm has ever been scheduled */
+    bool propChangedAlarmUsed;
+
+    /** Listener for propChangedAlarm */
+    PropChangedAlarmListener propChangedListener;
+
+    /** lock to protect the pending property changes */
+    qcc::Mutex propChangedLock;
+
+    Components(BusObject* obj) :
+        inUseCounter(0), serializedMethodCalls(false), introspectionIndent(0), introspectionValid(false),
+        propChangedWindow(0), propChangedAlarmSet(false), propChangedAlarmUsed(false), propChangedListener(obj) { }
+
+    /** Called whenever the interfaces or children of the object change */
+    void InvalidateIntrospection()
+    {
+        introspectionLock.Lock(MUTEX_CONTEXT);
+        introspectionValid = false;
+        introspection.clear();
+        introspectionLock.Unlock(MUTEX_CONTEXT);
+    }
 };
 
 /*
@@ -115,6 +183,22 @@ qcc::String BusObject::GetName()
 
 qcc::String BusObject::GenerateIntrospection(bool deep, size_t indent) const
 {
+    /*
+     * The shallow introspection only depends on the names of the children and on the interfaces
+     * which can't change once activated so it is generated once and reused until a child or
+     * interface is added or removed. Deep introspection includes the children's introspection
+     * which may be overridden so it is always generated.
+     */
+    if (!deep) {
+        components->introspectionLock.Lock(MUTEX_CONTEXT);
+        if (components->introspectionValid && (components->introspectionIndent == indent)) {
+            qcc::String xml = components->introspection;
+            components->introspectionLock.Unlock(MUTEX_CONTEXT);
+            return xml;
+        }
+        components->introspectionLock.Unlock(MUTEX_CONTEXT);
+    }
+
     qcc::String in(indent, ' ');
     qcc::String xml;
 
@@ -136,6 +220,13 @@ qcc::String BusObject::GenerateIntrospection(bool deep, size_t indent) const
             xml += (*itIf++)->Introspect(indent);
         }
     }
+    if (!deep) {
+        components->introspectionLock.Lock(MUTEX_CONTEXT);
+        components->introspection = xml;
+        components->introspectionIndent = indent;
+        components->introspectionValid = true;
+        components->introspectionLock.Unlock(MUTEX_CONTEXT);
+    }
     return xml;
 }
 
@@ -191,6 +282,40 @@ void BusObject::EmitPropChanged(const char* ifcName, const char* propName, MsgAr
 
     qcc::String emitsChanged;
     if (ifc && ifc->GetPropertyAnnotation(propName, org::freedesktop::DBus::AnnotateEmitsChanged, emitsChanged)) {
+        bool invalidates = (emitsChanged == "invalidates");
+        if (invalidates || (emitsChanged == "true")) {
+            /* Queue the change if coalescing, a later change to the same property replaces this one */
+            bool queued = false;
+            bool flush = false;
+            components->propChangedLock.Lock(MUTEX_CONTEXT);
+            if (components->propChangedWindow) {
+                PendingPropChanges& pending = components->pendingPropChanges[make_pair(qcc::String(ifcName), id)];
+                if (invalidates) {
+                    pending.changed.erase(propName);
+                    pending.invalidated.insert(propName);
+                } else {
+                    pending.invalidated.erase(propName);
+                    pending.changed[propName] = val;
+                }
+                queued = true;
+                if (!components->propChangedAlarmSet) {
+                    components->propChangedAlarm = Alarm(components->propChangedWindow, &components->propChangedListener, NULL, 0);
+                    if (bus->GetInternal().GetLocalEndpoint()->AddAlarm(components->propChangedAlarm) == ER_OK) {
+                        components->propChangedAlarmSet = true;
+                        components->propChangedAlarmUsed = true;
+                    } else {
+                        flush = true;
+                    }
+                }
+            }
+            components->propChangedLock.Unlock(MUTEX_CONTEXT);
+            if (flush) {
+                FlushPropChanged();
+            }
+            if (queued) {
+                return;
+            }
+        }
         if (emitsChanged == "true") {
             const InterfaceDescription* bus_ifc = bus->GetInterface(org::freedesktop::DBus::InterfaceName);
             const InterfaceDescription::Member* propChanged = (bus_ifc ? bus_ifc->GetMember("PropertiesChanged") : NULL);
@@ -220,6 +345,49 @@ void BusObject::EmitPropChanged(const char* ifcName, const char* propName, MsgAr
 }
 
 
+void BusObject::SetPropChangedCoalescing(uint32_t windowMs)
+{
+    components->propChangedLock.Lock(MUTEX_CONTEXT);
+    components->propChangedWindow = windowMs;
+    components->propChangedLock.Unlock(MUTEX_CONTEXT);
+    if (windowMs == 0) {
+        FlushPropChanged();
+    }
+}
+
+void BusObject::FlushPropChanged()
+{
+    map<pair<qcc::String, SessionId>, PendingPropChanges> pending;
+    components->propChangedLock.Lock(MUTEX_CONTEXT);
+    pending.swap(components->pendingPropChanges);
+    components->propChangedAlarmSet = false;
+    components->propChangedLock.Unlock(MUTEX_CONTEXT);
+
+    if (pending.empty() || !bus) {
+        return;
+    }
+    const InterfaceDescription* bus_ifc = bus->GetInterface(org::freedesktop::DBus::InterfaceName);
+    const InterfaceDescription::Member* propChanged = (bus_ifc ? bus_ifc->GetMember("PropertiesChanged") : NULL);
+    if (NULL == propChanged) {
+        return;
+    }
+    /* One signal per interface and session listing every property that changed in the window */
+    map<pair<qcc::String, SessionId>, PendingPropChanges>::iterator it;
+    for (it = pending.begin(); it != pending.end(); ++it) {
+        vector<MsgArg> changed(it->second.changed.size());
+        size_t i = 0;
+        for (map<qcc::String, MsgArg>::iterator cit = it->second.changed.begin(); cit != it->second.changed.end(); ++cit) {
+            changed[i++].Set("{sv}", cit->first.c_str(), &cit->second);
+        }
+        vector<qcc::String> invalidated(it->second.invalidated.begin(), it->second.invalidated.end());
+        MsgArg args[3];
+        args[0].Set("s", it->first.first.c_str());
+        args[1].Set("a{sv}", changed.size(), changed.empty() ? NULL : &changed[0]);
+        args[2].Set("a$", invalidated.size(), invalidated.empty() ? NULL : &invalidated[0]);
+        Signal(NULL, it->first.second, *propChanged, args, ArraySize(args));
+    }
+}
+
 void BusObject::SetProp(const InterfaceDescription::Member* member, Message& msg)
 {
     QStatus status = ER_BUS_NO_SUCH_PROPERTY;
@@ -334,6 +502,88 @@ void BusObject::Introspect(const InterfaceDescription::Member* member, Message&
     }
 }
 
+/*
+ * Returns the annotations of an interface, member or property as an array of {ss} dictionary
+ * entries. The entries own copies of the strings.
+ */
+template <typename _Annotated>
+static MsgArg* CompactAnnotations(const _Annotated& annotated, size_t& numEntries)
+{
+    numEntries = annotated.GetAnnotations();
+    if (numEntries == 0) {
+        return NULL;
+    }
+    qcc::String* names = new qcc::String[numEntries];
+    qcc::String* values = new qcc::String[numEntries];
+    annotated.GetAnnotations(names, values, numEntries);
+    MsgArg* entries = new MsgArg[numEntries];
+    for (size_t i = 0; i < numEntries; ++i) {
+        entries[i].Set("{ss}", names[i].c_str(), values[i].c_str());
+        entries[i].Stabilize();
+    }
+    delete [] names;
+    delete [] values;
+    return entries;
+}
+
+void BusObject::IntrospectCompact(const InterfaceDescription::Member* member, Message& msg)
+{
+    /* Same content as the shallow introspection XML generated by GenerateIntrospection() */
+    vector<qcc::String> childNames;
+    for (size_t i = 0; i < components->children.size(); ++i) {
+        childNames.push_back(components->children[i]->GetName());
+    }
+    size_t numIfaces = isPlaceholder ? 0 : components->ifaces.size();
+    MsgArg* ifaces = numIfaces ? new MsgArg[numIfaces] : NULL;
+    for (size_t i = 0; i < numIfaces; ++i) {
+        const InterfaceDescription* iface = components->ifaces[i];
+        size_t numAnnotations;
+        MsgArg* annotations = CompactAnnotations(*iface, numAnnotations);
+
+        size_t numMembers = iface->GetMembers();
+        MsgArg* members = numMembers ? new MsgArg[numMembers] : NULL;
+        if (numMembers) {
+            const InterfaceDescription::Member** ifaceMembers = new const InterfaceDescription::Member *[numMembers];
+            iface->GetMembers(ifaceMembers, numMembers);
+            for (size_t m = 0; m < numMembers; ++m) {
+                const InterfaceDescription::Member* mem = ifaceMembers[m];
+                size_t numMemberAnnotations;
+                MsgArg* memberAnnotations = CompactAnnotations(*mem, numMemberAnnotations);
+                members[m].Set("(ysssa{ss})", (uint8_t)mem->memberType, mem->name.c_str(), mem->signature.c_str(),
+                               mem->returnSignature.c_str(), mem->argNames.c_str(), numMemberAnnotations, memberAnnotations);
+            }
+            delete [] ifaceMembers;
+        }
+
+        size_t numProps = iface->GetProperties();
+        MsgArg* props = numProps ? new MsgArg[numProps] : NULL;
+        if (numProps) {
+            const InterfaceDescription::Property** ifaceProps = new const InterfaceDescription::Property *[numProps];
+            iface->GetProperties(ifaceProps, numProps);
+            for (size_t p = 0; p < numProps; ++p) {
+                const InterfaceDescription::Property* prop = ifaceProps[p];
+                size_t numPropAnnotations;
+                MsgArg* propAnnotations = CompactAnnotations(*prop, numPropAnnotations);
+                props[p].Set("(ssya{ss})", prop->name.c_str(), prop->signature.c_str(), prop->access, numPropAnnotations, propAnnotations);
+            }
+            delete [] ifaceProps;
+        }
+        ifaces[i].Set("(sa{ss}a(ysssa{ss})a(ssya{ss}))", iface->GetName(), numAnnotations, annotations, numMembers, members, numProps, props);
+    }
+
+    MsgArg args[2];
+    args[0].Set("a$", childNames.size(), childNames.empty() ? NULL : &childNames[0]);
+    args[1].Set("a(sa{ss}a(ysssa{ss})a(ssya{ss}))", numIfaces, ifaces);
+    /*
+     * Set ownership of the MsgArgs so they will be automatically freed.
+     */
+    args[1].SetOwnershipFlags(MsgArg::OwnsArgs, true /*deep*/);
+    QStatus status = MethodReply(msg, args, ArraySize(args));
+    if (status != ER_OK) {
+        QCC_DbgPrintf(("IntrospectCompact %s", QCC_StatusText(status)));
+    }
+}
+
 QStatus BusObject::AddMethodHandler(const InterfaceDescription::Member* member, MessageReceiver::MethodHandler handler, void* handlerContext)
 {
     if (!member) {
@@ -410,6 +660,7 @@ QStatus BusObject::AddInterface(const InterfaceDescription& iface)
 
     /* Add the new interface */
     components->ifaces.push_back(&iface);
+    components->InvalidateIntrospection();
 
 
 ExitAddInterface:
@@ -429,10 +680,15 @@ QStatus BusObject::DoRegistration(BusAttachment& busAttachment)
     const InterfaceDescription* introspectable = bus->GetInterface(org::freedesktop::DBus::Introspectable::InterfaceName);
     assert(introspectable);
     components->ifaces.push_back(introspectable);
+    const InterfaceDescription* compactIntrospectable = bus->GetInterface(org::alljoyn::Bus::Introspectable::InterfaceName);
+    assert(compactIntrospectable);
+    components->ifaces.push_back(compactIntrospectable);
+    components->InvalidateIntrospection();
 
     /* Add the standard method handlers */
     const MethodEntry methodEntries[] = {
-        { introspectable->GetMember("Introspect"),    static_cast<MessageReceiver::MethodHandler>(&BusObject::Introspect) }
+        { introspectable->GetMember("Introspect"),    static_cast<MessageReceiver::MethodHandler>(&BusObject::Introspect) },
+        { compactIntrospectable->GetMember("IntrospectCompact"), static_cast<MessageReceiver::MethodHandler>(&BusObject::IntrospectCompact) }
     };
 
     /* If any of the interfaces has properties make sure the Properties interface and its method handlers are registered. */
@@ -444,6 +700,7 @@ QStatus BusObject::DoRegistration(BusAttachment& busAttachment)
             const InterfaceDescription* propIntf = bus->GetInterface(org::freedesktop::DBus::Properties::InterfaceName);
             assert(propIntf);
             components->ifaces.push_back(propIntf);
+            components->InvalidateIntrospection();
 
             /* Attach the handlers */
             const MethodEntry propHandlerList[] = {
@@ -509,6 +766,49 @@ QStatus BusObject::Signal(const char* destination,
     return status;
 }
 
+SignalTemplate::SignalTemplate(const InterfaceDescription::Member& signal, const char* destination, SessionId sessionId, uint8_t flags) :
+    signal(signal),
+    destination(destination ? destination : ""),
+    sessionId(sessionId),
+    flags(flags),
+    owner(NULL),
+    endian(0),
+    hdr(NULL),
+    hdrLen(0)
+{
+    /*
+     * If the interface is secure the signal must be encrypted.
+     */
+    if (signal.iface->IsSecure()) {
+        this->flags |= ALLJOYN_FLAG_ENCRYPTED;
+    }
+}
+
+QStatus BusObject::Signal(SignalTemplate& signalTemplate,
+                          const MsgArg* args,
+                          size_t numArgs,
+                          Message* outMsg)
+{
+    /* Protect against calling Signal before object is registered */
+    if (!bus) {
+        return ER_BUS_OBJECT_NOT_REGISTERED;
+    }
+    if ((signalTemplate.flags & ALLJOYN_FLAG_ENCRYPTED) && !bus->IsPeerSecurityEnabled()) {
+        return ER_BUS_SECURITY_NOT_ENABLED;
+    }
+
+    Message msg(*bus);
+    QStatus status = msg->SignalMsg(signalTemplate, this, path, args, numArgs);
+    if (status == ER_OK) {
+        BusEndpoint bep = BusEndpoint::cast(bus->GetInternal().GetLocalEndpoint());
+        status = bus->GetInternal().GetRouter().PushMessage(msg, bep);
+        if ((status == ER_OK) && outMsg) {
+            *outMsg = msg;
+        }
+    }
+    return status;
+}
+
 QStatus BusObject::CancelSessionlessMessage(uint32_t serialNum)
 {
     if (!bus) {
@@ -620,6 +920,7 @@ void BusObject::AddChild(BusObject& child)
     QCC_DbgPrintf(("AddChild %s to object with path = \"%s\"", child.GetPath(), GetPath()));
     child.parent = this;
     components->children.push_back(&child);
+    components->InvalidateIntrospection();
 }
 
 QStatus BusObject::RemoveChild(BusObject& child)
@@ -632,6 +933,7 @@ QStatus BusObject::RemoveChild(BusObject& child)
         child.parent = NULL;
         QCC_DbgPrintf(("RemoveChild %s from object with path = \"%s\"", child.GetPath(), GetPath()));
         components->children.erase(it);
+        components->InvalidateIntrospection();
         status = ER_OK;
     }
     return status;
@@ -644,6 +946,7 @@ BusObject* BusObject::RemoveChild()
     if (sz > 0) {
         BusObject* child = components->children[sz - 1];
         components->children.pop_back();
+        components->InvalidateIntrospection();
         QCC_DbgPrintf(("RemoveChild %s from object with path = \"%s\"", child->GetPath(), GetPath()));
         child->parent = NULL;
         return child;
@@ -657,6 +960,7 @@ void BusObject::Replace(BusObject& object)
     //ScopedMutexLock(bus.GetInternal().GetLocalEndpoint().objectsLock, MUTEX_CONTEXT);
     QCC_DbgPrintf(("Replacing object with path = \"%s\"", GetPath()));
     object.components->children = components->children;
+    object.components->InvalidateIntrospection();
     vector<BusObject*>::iterator it = object.components->children.begin();
     while (it != object.components->children.end()) {
         (*it++)->parent = &object;
@@ -666,12 +970,14 @@ void BusObject::Replace(BusObject& object)
         while (pit != parent->components->children.end()) {
             if ((*pit) == this) {
                 parent->components->children.erase(pit);
+                parent->components->InvalidateIntrospection();
                 break;
             }
             ++pit;
         }
     }
     components->children.clear();
+    components->InvalidateIntrospection();
 }
 
 void BusObject::InUseIncrement() {
@@ -688,24 +994,32 @@ void BusObject::InUseDecrement() {
 
 BusObject::BusObject(BusAttachment& bus, const char* path, bool isPlaceholder) :
     bus(&bus),
-    components(new Components),
+    components(new Components(this)),
     path(path),
     parent(NULL),
     isRegistered(false),
     isPlaceholder(isPlaceholder)
 {
-    components->inUseCounter = 0;
 }
 
 BusObject::BusObject(const char* path, bool isPlaceholder) :
     bus(0),
-    components(new Components),
+    components(new Components(this)),
     path(path),
     parent(NULL),
     isRegistered(false),
     isPlaceholder(isPlaceholder)
 {
-    components->inUseCounter = 0;
+}
+
+void BusObject::SetSerializedMethodCalls(bool serialize)
+{
+    components->serializedMethodCalls = serialize;
+}
+
+bool BusObject::HasSerializedMethodCalls() const
+{
+    return components->serializedMethodCalls;
 }
 
 BusObject::~BusObject()
@@ -725,6 +1039,10 @@ BusObject::~BusObject()
     if (bus && parent) {
         bus->GetInternal().GetLocalEndpoint()->UnregisterBusObject(*this);
     }
+    /* Pending property changes are dropped, make sure the alarm isn't running */
+    if (bus && components->propChangedAlarmUsed) {
+        bus->GetInternal().GetLocalEndpoint()->RemoveAlarm(components->propChangedAlarm);
+    }
     delete components;
 }
 
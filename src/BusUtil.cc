@@ -25,6 +25,7 @@
 #include <qcc/platform.h>
 
 #include <ctype.h>
+#include <string.h>
 
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
@@ -168,6 +169,72 @@ bool IsLegalMemberName(const char* str)
 }
 
 
+bool IsLegalUTF8(const char* str, size_t len)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(str);
+    const uint8_t* end = p + len;
+
+    while (p < end) {
+        /*
+         * Skip over ASCII a word at a time. A word is all ASCII with no nul if no byte has the
+         * top bit set and no byte is zero.
+         */
+        while ((end - p) >= 8) {
+            uint64_t w;
+            memcpy(&w, p, sizeof(w));
+            const uint64_t lowBits = ~static_cast<uint64_t>(0) / 0xFF;   /* 0x0101010101010101 */
+            const uint64_t highBits = lowBits * 0x80;                     /* 0x8080808080808080 */
+            if ((w & highBits) || ((w - lowBits) & ~w & highBits)) {
+                break;
+            }
+            p += 8;
+        }
+        if (p == end) {
+            break;
+        }
+        uint8_t c = *p++;
+        if (c < 0x80) {
+            if (c == 0) {
+                return false;
+            }
+            continue;
+        }
+        uint32_t cp;
+        size_t extra;
+        uint32_t min;
+        if ((c & 0xE0) == 0xC0) {
+            cp = c & 0x1F;
+            extra = 1;
+            min = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            cp = c & 0x0F;
+            extra = 2;
+            min = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            cp = c & 0x07;
+            extra = 3;
+            min = 0x10000;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(end - p) < extra) {
+            return false;
+        }
+        for (size_t i = 0; i < extra; ++i) {
+            c = *p++;
+            if ((c & 0xC0) != 0x80) {
+                return false;
+            }
+            cp = (cp << 6) | (c & 0x3F);
+        }
+        if ((cp < min) || (cp > 0x10FFFF) || ((cp >= 0xD800) && (cp <= 0xDFFF))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
 qcc::String BusNameFromObjPath(const char* str)
 {
     qcc::String path;
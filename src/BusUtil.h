@@ -115,6 +115,19 @@ bool IsLegalErrorName(const char* str);
  */
 bool IsLegalMemberName(const char* str);
 
+/**
+ * Checks if a string is well-formed UTF-8 as required for D-Bus strings.
+ *
+ * Overlong encodings, surrogates, code points above U+10FFFF and embedded nul characters
+ * are all rejected. Runs of ASCII characters are checked eight bytes at a time.
+ *
+ * @param str  The string to check
+ * @param len  The length of the string in bytes not including the terminating nul
+ *
+ * @return true if the string is well-formed UTF-8
+ */
+bool IsLegalUTF8(const char* str, size_t len);
+
 /**
  * Generate a well-known bus name from an object path.
  *
@@ -23,9 +23,12 @@
 #include <qcc/platform.h>
 
 #include <qcc/Debug.h>
+#include <qcc/Socket.h>
+#include <qcc/SocketStream.h>
 #include <qcc/Util.h>
 #include <qcc/String.h>
 
+#include <alljoyn/AllJoynStd.h>
 #include <alljoyn/Status.h>
 
 #include "Transport.h"
@@ -33,6 +36,7 @@
 #include "LocalTransport.h"
 #include "ClientRouter.h"
 #include "BusInternal.h"
+#include "SignalBatcher.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -41,18 +45,108 @@ using namespace qcc;
 
 namespace ajn {
 
+static const char* DirectPathTransportName = "direct";
+
+class _DirectEndpoint;
+typedef qcc::ManagedObj<_DirectEndpoint> DirectEndpoint;
+
+/*
+ * One end of a socket pair created by the daemon. No authentication takes place on a direct
+ * path, the daemon has already authenticated both ends.
+ */
+class _DirectEndpoint : public _RemoteEndpoint {
+  public:
+    _DirectEndpoint(BusAttachment& bus, SocketFd sock) :
+        _RemoteEndpoint(bus, false, DirectPathTransportName, &stream, DirectPathTransportName),
+        stream(sock)
+    {
+    }
+
+    virtual ~_DirectEndpoint() { }
+
+  private:
+    SocketStream stream;
+};
+
+static bool IsDirectPathSignal(const Message& msg)
+{
+    return (msg->GetType() == MESSAGE_SIGNAL) &&
+           (0 == strcmp(msg->GetInterface(), org::alljoyn::Bus::Peer::Session::InterfaceName)) &&
+           (0 == strcmp(msg->GetMemberName(), "DirectPath"));
+}
+
+static bool IsSessionLostSignal(const Message& msg)
+{
+    return (msg->GetType() == MESSAGE_SIGNAL) &&
+           (0 == strcmp(msg->GetInterface(), org::alljoyn::Bus::InterfaceName)) &&
+           (0 == strcmp(msg->GetMemberName(), "SessionLost"));
+}
+
 QStatus ClientRouter::PushMessage(Message& msg, BusEndpoint& sender)
 {
     QStatus status = ER_OK;
 
     if (!localEndpoint->IsValid() || !nonLocalEndpoint->IsValid() || !sender->IsValid()) {
         status = ER_BUS_NO_ENDPOINT;
-    } else {
-        if (sender == BusEndpoint::cast(localEndpoint)) {
-            localEndpoint->UpdateSerialNumber(msg);
+    } else if (sender == BusEndpoint::cast(localEndpoint)) {
+        localEndpoint->UpdateSerialNumber(msg);
+        BusEndpoint ep = nonLocalEndpoint;
+        SessionId id = msg->GetSessionId();
+        if (id != 0) {
+            /* Session messages addressed to the other member take the direct path if there is one */
+            directPathLock.Lock(MUTEX_CONTEXT);
+            map<SessionId, DirectPath>::iterator it = directPaths.find(id);
+            if ((it != directPaths.end()) && (msg->GetDestination()[0] == '\0' || it->second.peerName == msg->GetDestination())) {
+                ep = BusEndpoint::cast(it->second.endpoint);
+            }
+            directPathLock.Unlock(MUTEX_CONTEXT);
+        }
+        SignalBatcher* batcher = localEndpoint->GetSignalBatcher();
+        if (batcher && batcher->IsEnabled()) {
+            /*
+             * Signals to the daemon may be held back for a batch. Anything else, including
+             * messages on a direct path, first sends the pending batch so it keeps its place.
+             */
+            if (ep == nonLocalEndpoint) {
+                RemoteEndpoint rep = RemoteEndpoint::cast(nonLocalEndpoint);
+                if (batcher->Add(msg, rep)) {
+                    return ER_OK;
+                }
+            } else {
+                batcher->Flush();
+            }
+        }
+        status = ep->PushMessage(msg);
+        if ((status != ER_OK) && (ep != nonLocalEndpoint)) {
+            /* The direct path is closing or already gone, fall back to the daemon */
             status = nonLocalEndpoint->PushMessage(msg);
+        }
+    } else if (sender == nonLocalEndpoint) {
+        /*
+         * Direct paths are installed on the receive thread so the path is in place before the
+         * JoinSession reply or the SessionJoined signal that follow it are dispatched.
+         */
+        if (IsDirectPathSignal(msg) && (RemoteEndpoint::cast(nonLocalEndpoint)->GetRemoteName() == msg->GetSender())) {
+            AddDirectPath(msg);
         } else {
+            if (IsSessionLostSignal(msg) && (RemoteEndpoint::cast(nonLocalEndpoint)->GetRemoteName() == msg->GetSender())) {
+                uint32_t id;
+                if (msg->UnmarshalArgs("u") == ER_OK && msg->GetArgs("u", &id) == ER_OK) {
+                    RemoveDirectPath(id);
+                }
+            }
+            status = localEndpoint->PushMessage(msg);
+        }
+    } else {
+        /* Only the other session member may send on a direct path */
+        directPathLock.Lock(MUTEX_CONTEXT);
+        map<SessionId, DirectPath>::iterator it = FindDirectPath(sender);
+        bool accept = (it == directPaths.end()) || ((it->second.peerName == msg->GetSender()) && (it->first == msg->GetSessionId()));
+        directPathLock.Unlock(MUTEX_CONTEXT);
+        if (accept) {
             status = localEndpoint->PushMessage(msg);
+        } else {
+            QCC_DbgHLPrintf(("ClientRouter::PushMessage discarding %s received on a direct path", msg->Description().c_str()));
         }
     }
 
@@ -69,6 +163,16 @@ QStatus ClientRouter::RegisterEndpoint(BusEndpoint& endpoint)
 
     QCC_DbgHLPrintf(("ClientRouter::RegisterEndpoint"));
 
+    /* Direct paths are tracked in the direct path map and never replace the daemon connection */
+    if (!isLocal) {
+        directPathLock.Lock(MUTEX_CONTEXT);
+        bool isDirect = FindDirectPath(endpoint) != directPaths.end();
+        directPathLock.Unlock(MUTEX_CONTEXT);
+        if (isDirect) {
+            return ER_OK;
+        }
+    }
+
     /* Keep track of local and (at least one) non-local endpoint */
     if (isLocal) {
         localEndpoint = LocalEndpoint::cast(endpoint);
@@ -100,10 +204,99 @@ void ClientRouter::UnregisterEndpoint(const String& epName, EndpointType epType)
         localEndpoint->GetBus().GetInternal().NonLocalEndpointDisconnected();
         nonLocalEndpoint->Invalidate();
         nonLocalEndpoint = BusEndpoint();
+
+        /* Sessions do not outlive the connection to the daemon */
+        directPathLock.Lock(MUTEX_CONTEXT);
+        while (!directPaths.empty()) {
+            RemoteEndpoint ep = directPaths.begin()->second.endpoint;
+            directPaths.erase(directPaths.begin());
+            ep->Stop();
+        }
+        directPathLock.Unlock(MUTEX_CONTEXT);
     }
 
 }
 
+void ClientRouter::AddDirectPath(Message& msg)
+{
+    uint32_t id;
+    const char* peerName;
+    SocketFd fd;
+    QStatus status = msg->UnmarshalArgs("ush");
+    if (status == ER_OK) {
+        status = msg->GetArgs("ush", &id, &peerName, &fd);
+    }
+    /* The message owns the handle so take a copy of it */
+    SocketFd sock = -1;
+    if (status == ER_OK) {
+        status = SocketDup(fd, sock);
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("ClientRouter::AddDirectPath(): Bad DirectPath signal"));
+        return;
+    }
+
+    DirectEndpoint dep = DirectEndpoint(localEndpoint->GetBus(), sock);
+    RemoteEndpoint ep = RemoteEndpoint::cast(dep);
+    ep->GetFeatures().isBusToBus = false;
+    ep->GetFeatures().allowRemote = localEndpoint->GetBus().GetInternal().AllowRemoteMessages();
+    ep->GetFeatures().handlePassing = false;
+    ep->SetListener(this);
+
+    directPathLock.Lock(MUTEX_CONTEXT);
+    map<SessionId, DirectPath>::iterator it = directPaths.find(id);
+    if (it != directPaths.end()) {
+        it->second.endpoint->Stop();
+        directPaths.erase(it);
+    }
+    DirectPath& path = directPaths[id];
+    path.peerName = peerName;
+    path.endpoint = ep;
+    directPathLock.Unlock(MUTEX_CONTEXT);
+
+    status = ep->Start();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("ClientRouter::AddDirectPath(): Failed to start direct path for session %u", id));
+        RemoveDirectPath(id);
+    } else {
+        QCC_DbgHLPrintf(("ClientRouter::AddDirectPath(): Session %u has a direct path to %s", id, peerName));
+    }
+}
+
+void ClientRouter::RemoveDirectPath(SessionId sessionId)
+{
+    directPathLock.Lock(MUTEX_CONTEXT);
+    map<SessionId, DirectPath>::iterator it = directPaths.find(sessionId);
+    if (it != directPaths.end()) {
+        RemoteEndpoint ep = it->second.endpoint;
+        directPaths.erase(it);
+        directPathLock.Unlock(MUTEX_CONTEXT);
+        ep->Stop();
+    } else {
+        directPathLock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+void ClientRouter::EndpointExit(RemoteEndpoint& ep)
+{
+    directPathLock.Lock(MUTEX_CONTEXT);
+    map<SessionId, DirectPath>::iterator it = FindDirectPath(BusEndpoint::cast(ep));
+    if (it != directPaths.end()) {
+        QCC_DbgHLPrintf(("ClientRouter::EndpointExit(): Direct path for session %u closed", it->first));
+        directPaths.erase(it);
+    }
+    directPathLock.Unlock(MUTEX_CONTEXT);
+}
+
+map<SessionId, ClientRouter::DirectPath>::iterator ClientRouter::FindDirectPath(const BusEndpoint& ep)
+{
+    map<SessionId, DirectPath>::iterator it = directPaths.begin();
+    while ((it != directPaths.end()) && (BusEndpoint::cast(it->second.endpoint) != ep)) {
+        ++it;
+    }
+    return it;
+}
+
 BusEndpoint ClientRouter::FindEndpoint(const qcc::String& busname)
 {
     return nonLocalEndpoint;
@@ -112,6 +305,13 @@ BusEndpoint ClientRouter::FindEndpoint(const qcc::String& busname)
 ClientRouter::~ClientRouter()
 {
     QCC_DbgHLPrintf(("ClientRouter::~ClientRouter()"));
+
+    directPathLock.Lock(MUTEX_CONTEXT);
+    for (map<SessionId, DirectPath>::iterator it = directPaths.begin(); it != directPaths.end(); ++it) {
+        it->second.endpoint->Stop();
+    }
+    directPaths.clear();
+    directPathLock.Unlock(MUTEX_CONTEXT);
 }
 
 
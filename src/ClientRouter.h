@@ -24,12 +24,17 @@
 
 #include <qcc/platform.h>
 
+#include <map>
+
+#include <qcc/Mutex.h>
 #include <qcc/Thread.h>
 #include <qcc/String.h>
 
 #include "Router.h"
 #include "LocalTransport.h"
+#include "RemoteEndpoint.h"
 
+#include <alljoyn/Session.h>
 #include <alljoyn/Status.h>
 
 namespace ajn {
@@ -38,7 +43,7 @@ namespace ajn {
  * %ClientRouter is responsible for routing Bus messages between a single remote
  * endpoint and a single local endpoint
  */
-class ClientRouter : public Router {
+class ClientRouter : public Router, public _RemoteEndpoint::EndpointListener {
     friend class _LocalEndpoint;
 
   public:
@@ -117,15 +122,56 @@ class ClientRouter : public Router {
      */
     void SetGlobalGUID(const qcc::GUID128& guid) { }
 
+    /**
+     * Tear down the direct path for a session, if there is one. Messages for the session are
+     * routed through the daemon from then on.
+     *
+     * @param sessionId  The session that is being left.
+     */
+    void RemoveDirectPath(SessionId sessionId);
+
+    /**
+     * Called when a direct path endpoint exits.
+     *
+     * @param ep   Endpoint that is exiting.
+     */
+    void EndpointExit(RemoteEndpoint& ep);
+
     /**
      * Destructor
      */
     ~ClientRouter();
 
   private:
+
+    /**
+     * A socket connected straight to the other member of a local point-to-point session. The
+     * daemon hands one out with the DirectPath signal when both members asked for it.
+     */
+    struct DirectPath {
+        qcc::String peerName;      /**< Unique name of the other session member */
+        RemoteEndpoint endpoint;   /**< Endpoint carrying the session's messages */
+    };
+
+    /**
+     * Install the direct path carried by a DirectPath signal from the daemon.
+     *
+     * @param msg  The DirectPath signal.
+     */
+    void AddDirectPath(Message& msg);
+
+    /**
+     * Find the direct path carried by an endpoint.
+     * The direct path lock must be held.
+     */
+    std::map<SessionId, DirectPath>::iterator FindDirectPath(const BusEndpoint& ep);
+
     LocalEndpoint localEndpoint;   /**< Local endpoint */
     BusEndpoint nonLocalEndpoint;  /**< Last non-local enpoint to register */
 
+    std::map<SessionId, DirectPath> directPaths;  /**< Direct paths indexed by session */
+    qcc::Mutex directPathLock;                    /**< Protects directPaths */
+
 };
 
 }
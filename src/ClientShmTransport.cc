@@ -0,0 +1,164 @@
+/**
+ * @file
+ * ClientShmTransport connects a client to the daemon through shared memory rings
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/Socket.h>
+#include <qcc/SocketStream.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/BusAttachment.h>
+
+#include "BusInternal.h"
+#include "RemoteEndpoint.h"
+#include "ShmStream.h"
+#include "ClientShmTransport.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+/*
+ * The name of this transport
+ */
+const char* ClientShmTransport::TransportName = "shm";
+
+static const uint32_t OFFER_TIMEOUT = 5000;  /**< How long to wait for the daemon to answer the offer */
+
+bool ClientShmTransport::IsAvailable()
+{
+    return ShmStream::IsSupported();
+}
+
+QStatus ClientShmTransport::NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, map<qcc::String, qcc::String>& argMap) const
+{
+    QStatus status = ParseArguments(TransportName, inSpec, argMap);
+    if (status != ER_OK) {
+        return status;
+    }
+
+    qcc::String path = Trim(argMap["path"]);
+    qcc::String abstract = Trim(argMap["abstract"]);
+    outSpec = "shm:";
+    if (!path.empty()) {
+        outSpec.append("path=");
+        outSpec.append(path);
+        argMap["_spec"] = path;
+    } else if (!abstract.empty()) {
+        outSpec.append("abstract=");
+        outSpec.append(abstract);
+        argMap["_spec"] = qcc::String("@") + abstract;
+    } else {
+        status = ER_BUS_BAD_TRANSPORT_ARGS;
+    }
+    /* The ring size does not identify the connection so it is not part of the normalized spec */
+    return status;
+}
+
+QStatus ClientShmTransport::Connect(const char* connectArgs, const SessionOpts& opts, BusEndpoint& newep)
+{
+    if (!m_running) {
+        return ER_BUS_TRANSPORT_NOT_STARTED;
+    }
+    if (m_endpoint->IsValid()) {
+        return ER_BUS_ALREADY_CONNECTED;
+    }
+
+    qcc::String normSpec;
+    map<qcc::String, qcc::String> argMap;
+    QStatus status = NormalizeTransportSpec(connectArgs, normSpec, argMap);
+    if (ER_OK != status) {
+        QCC_LogError(status, ("ClientShmTransport::Connect(): Invalid shm connect spec \"%s\"", connectArgs));
+        return status;
+    }
+    uint32_t ringSize = StringToU32(Trim(argMap["ring"]), 0, ShmStream::DEFAULT_RING_SIZE);
+
+    SocketFd sockFd = -1;
+    status = Socket(QCC_AF_UNIX, QCC_SOCK_STREAM, sockFd);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("ClientShmTransport(): socket Create() failed"));
+        return status;
+    }
+    qcc::String& spec = argMap["_spec"];
+    status = qcc::Connect(sockFd, spec.c_str());
+    if (status != ER_OK) {
+        QCC_LogError(status, ("ClientShmTransport(): socket Connect(%d, %s) failed", sockFd, spec.c_str()));
+        qcc::Close(sockFd);
+        return status;
+    }
+
+    /*
+     * If the daemon declines the rings the socket is still good, carry on over it like the unix
+     * transport does. The offer already carried our credentials.
+     */
+    ShmStream* shm = new ShmStream(sockFd);
+    Stream* stream = shm;
+    bool isShm = true;
+    status = shm->Offer(ringSize, OFFER_TIMEOUT);
+    if (status == ER_BUS_TRANSPORT_NOT_AVAILABLE) {
+        stream = new SocketStream(shm->DetachSocket());
+        delete shm;
+        isShm = false;
+        status = ER_OK;
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("ClientShmTransport::Connect(): Shared memory offer failed"));
+        delete shm;
+        return status;
+    }
+
+    static const bool falsiness = false;
+    ShmEndpoint ep = ShmEndpoint(m_bus, falsiness, normSpec, stream, isShm, TransportName);
+
+    /* Initialized the features for this endpoint */
+    ep->GetFeatures().isBusToBus = false;
+    ep->GetFeatures().allowRemote = m_bus.GetInternal().AllowRemoteMessages();
+    ep->GetFeatures().handlePassing = true;
+
+    qcc::String authName;
+    qcc::String redirection;
+    status = ep->Establish("EXTERNAL", authName, redirection);
+    if (status == ER_OK) {
+        /* Handle passing is negotiated along with the version but the rings cannot carry handles */
+        if (isShm) {
+            ep->GetFeatures().handlePassing = false;
+        }
+        ep->SetListener(this);
+        status = ep->Start();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("ClientShmTransport::Connect(): Start ShmEndpoint failed"));
+        }
+    }
+    if (status != ER_OK) {
+        ep->Invalidate();
+    } else {
+        QCC_DbgHLPrintf(("ClientShmTransport::Connect(): Connected to %s over %s", normSpec.c_str(), isShm ? "shared memory" : "socket"));
+        newep = BusEndpoint::cast(ep);
+        m_endpoint = RemoteEndpoint::cast(ep);
+    }
+
+    return status;
+}
+
+} // namespace ajn
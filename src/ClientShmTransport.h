@@ -0,0 +1,99 @@
+/**
+ * @file
+ * ClientShmTransport connects a client to the daemon through shared memory rings
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef _ALLJOYN_CLIENTSHMTRANSPORT_H
+#define _ALLJOYN_CLIENTSHMTRANSPORT_H
+
+#ifndef __cplusplus
+#error Only include ClientShmTransport.h in C++ code.
+#endif
+
+#include <alljoyn/Status.h>
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+
+#include "ClientTransport.h"
+
+namespace ajn {
+
+/**
+ * @brief A client transport that moves messages to and from the daemon through a pair of
+ * shared memory rings.
+ *
+ * The connect spec names the daemon's shm listen socket the same way a unix connect spec does,
+ * for example "shm:abstract=alljoyn-shm". An optional "ring" argument sets the size of each
+ * ring in bytes. If the daemon declines the shared memory the connection carries on over the
+ * socket exactly like a unix transport connection.
+ */
+class ClientShmTransport : public ClientTransport {
+
+  public:
+    /**
+     * Create a shared memory transport for use by clients and services.
+     *
+     * @param bus The BusAttachment associated with this endpoint
+     */
+    ClientShmTransport(BusAttachment& bus) : ClientTransport(bus) { }
+
+    /**
+     * Normalize a transport specification.
+     *
+     * @param inSpec    Input transport connect spec.
+     * @param outSpec   Output transport connect spec.
+     * @param argMap    Parsed parameter map.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus NormalizeTransportSpec(const char* inSpec, qcc::String& outSpec, std::map<qcc::String, qcc::String>& argMap) const;
+
+    /**
+     * Connect to the daemon and offer it a shared memory connection.
+     *
+     * @param connectSpec    The form of this string is @c "shm:abstract=<name>[,ring=<bytes>]"
+     *                       or @c "shm:path=<path>[,ring=<bytes>]".
+     * @param opts           Requested sessions opts.
+     * @param newep          [OUT] Endpoint created as a result of successful connect.
+     * @return
+     *      - ER_OK if successful.
+     *      - an error status otherwise.
+     */
+    QStatus Connect(const char* connectSpec, const SessionOpts& opts, BusEndpoint& newep);
+
+    /**
+     * Returns the name of this transport
+     */
+    const char* GetTransportName() const { return TransportName; }
+
+    /**
+     * Name of transport used in transport specs.
+     */
+    static const char* TransportName;
+
+    /**
+     * Returns true if shared memory connections are supported on this platform.
+     */
+    static bool IsAvailable();
+};
+
+} // namespace ajn
+
+#endif // _ALLJOYN_CLIENTSHMTRANSPORT_H
@@ -43,7 +43,7 @@ using namespace qcc;
 
 namespace ajn {
 
-ClientTransport::ClientTransport(BusAttachment& bus) : m_bus(bus), m_listener(0)
+ClientTransport::ClientTransport(BusAttachment& bus) : m_bus(bus), m_running(false), m_listener(0)
 {
 }
 
@@ -96,7 +96,7 @@ QStatus ClientTransport::Disconnect(const char* connectSpec)
      */
     qcc::String normSpec;
     map<qcc::String, qcc::String> argMap;
-    QStatus status = ClientTransport::NormalizeTransportSpec(connectSpec, normSpec, argMap);
+    QStatus status = NormalizeTransportSpec(connectSpec, normSpec, argMap);
     if (ER_OK != status) {
         QCC_LogError(status, ("ClientTransport::Disconnect(): Invalid connect spec \"%s\"", connectSpec));
     } else {
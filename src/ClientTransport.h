@@ -174,11 +174,13 @@ class ClientTransport : public Transport, public _RemoteEndpoint::EndpointListen
      */
     void EndpointExit(RemoteEndpoint& endpoint);
 
-  private:
+  protected:
     BusAttachment& m_bus;           /**< The message bus for this transport */
     bool m_running;                 /**< True after Start() has been called, before Stop() */
-    TransportListener* m_listener;  /**< Registered TransportListener */
     RemoteEndpoint m_endpoint;      /**< The active endpoint */
+
+  private:
+    TransportListener* m_listener;  /**< Registered TransportListener */
 };
 
 } // namespace ajn
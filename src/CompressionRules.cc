@@ -21,6 +21,8 @@
 
 #include <qcc/platform.h>
 
+#include <string.h>
+
 #include <qcc/Util.h>
 #include <qcc/Mutex.h>
 #include <qcc/Debug.h>
@@ -31,6 +33,7 @@
 
 #include "Adler32.h"
 #include "CompressionRules.h"
+#include "MemoryAccounting.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -39,8 +42,49 @@ using namespace std;
 
 namespace ajn {
 
-void _CompressionRules::Add(const HeaderFields& hdrFields, uint32_t token)
+/*
+ * Estimate of the memory held by a rule: the expansion, its entries in tokenMap, fieldMap and
+ * lruList and the strings of the compressible fields.
+ */
+static size_t RuleBytes(const HeaderFields& fields)
+{
+    size_t bytes = sizeof(HeaderFields) + 2 * sizeof(uint32_t) + 8 * sizeof(void*);
+    for (size_t i = 0; i < ArraySize(fields.field); i++) {
+        const MsgArg& f = fields.field[i];
+        if (HeaderFields::Compressible[i] && ((f.typeId == ALLJOYN_STRING) || (f.typeId == ALLJOYN_OBJECT_PATH))) {
+            bytes += f.v_string.len + 1;
+        } else if (HeaderFields::Compressible[i] && (f.typeId == ALLJOYN_SIGNATURE)) {
+            bytes += f.v_signature.len + 1;
+        }
+    }
+    return bytes;
+}
+
+_CompressionRules::_CompressionRules() :
+    maxRules(ALLJOYN_MAX_COMPRESSION_RULES_DEFAULT),
+    listener(NULL)
 {
+    ::memset(&stats, 0, sizeof(stats));
+}
+
+void _CompressionRules::Add(const HeaderFields& hdrFields, uint32_t token, std::vector<uint32_t>& evicted)
+{
+    /*
+     * A token can only have one expansion.
+     */
+    if (tokenMap.count(token)) {
+        Remove(token);
+    }
+    /*
+     * Evict least recently used rules to make room.
+     */
+    while (maxRules && (tokenMap.size() >= maxRules)) {
+        uint32_t lruToken = lruList.back();
+        QCC_DbgHLPrintf(("Evicting compression/expansion rule %u", lruToken));
+        Remove(lruToken);
+        evicted.push_back(lruToken);
+        stats.evictions++;
+    }
     HeaderFields* expFields = new HeaderFields;
     /*
      * Copy compressible fields.
@@ -53,57 +97,169 @@ void _CompressionRules::Add(const HeaderFields& hdrFields, uint32_t token)
     /*
      * Add forward and reverse mapping.
      */
-    tokenMap[token] = expFields;
+    lruList.push_front(token);
+    Rule& rule = tokenMap[token];
+    rule.fields = expFields;
+    rule.lruPos = lruList.begin();
+    rule.bytes = RuleBytes(*expFields);
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_COMPRESSION_RULES, rule.bytes);
     fieldMap[expFields] = token;
     QCC_DbgHLPrintf(("Added compression/expansion rule %u <-->\n%s", token, expFields->ToString().c_str()));
 }
 
+void _CompressionRules::Remove(uint32_t token)
+{
+    map<uint32_t, Rule>::iterator iter = tokenMap.find(token);
+    if (iter != tokenMap.end()) {
+        const HeaderFields* expFields = iter->second.fields;
+        unordered_map<const HeaderFields*, uint32_t, HdrFieldHash, HdrFieldsEq>::iterator fit = fieldMap.find(expFields);
+        if ((fit != fieldMap.end()) && (fit->second == token)) {
+            fieldMap.erase(fit);
+        }
+        lruList.erase(iter->second.lruPos);
+        MemoryAccounting::Released(MemoryAccounting::MEM_COMPRESSION_RULES, iter->second.bytes);
+        tokenMap.erase(iter);
+        delete expFields;
+    }
+}
+
+const HeaderFields* _CompressionRules::Touch(uint32_t token)
+{
+    map<uint32_t, Rule>::iterator iter = tokenMap.find(token);
+    if (iter == tokenMap.end()) {
+        return NULL;
+    }
+    lruList.splice(lruList.begin(), lruList, iter->second.lruPos);
+    return iter->second.fields;
+}
+
+void _CompressionRules::NotifyEvicted(const std::vector<uint32_t>& evicted)
+{
+    if (!evicted.empty()) {
+        lock.Lock(MUTEX_CONTEXT);
+        CompressionRulesListener* l = listener;
+        lock.Unlock(MUTEX_CONTEXT);
+        for (size_t i = 0; l && (i < evicted.size()); ++i) {
+            l->CompressionRuleEvicted(evicted[i]);
+        }
+    }
+}
+
 void _CompressionRules::AddExpansion(const HeaderFields& hdrFields, uint32_t token)
 {
     if (token) {
+        std::vector<uint32_t> evicted;
         lock.Lock(MUTEX_CONTEXT);
         if (fieldMap.count(&hdrFields) == 0) {
-            Add(hdrFields, token);
+            Add(hdrFields, token, evicted);
         }
         lock.Unlock(MUTEX_CONTEXT);
+        NotifyEvicted(evicted);
     }
 }
 
 uint32_t _CompressionRules::GetToken(const HeaderFields& hdrFields)
 {
     uint32_t token;
+    std::vector<uint32_t> evicted;
     lock.Lock(MUTEX_CONTEXT);
     unordered_map<const HeaderFields*, uint32_t, HdrFieldHash, HdrFieldsEq>::iterator iter = fieldMap.find(&hdrFields);
     if (iter != fieldMap.end()) {
         token = iter->second;
+        Touch(token);
+        stats.tokenHits++;
     } else {
         /*
          * Allocate a random token (check it isn't zero and not in use)
          */
-        do { token = Rand32(); } while (token && GetExpansion(token));
-        Add(hdrFields, token);
+        do { token = Rand32(); } while (!token || tokenMap.count(token));
+        Add(hdrFields, token, evicted);
+        stats.tokenMisses++;
     }
     lock.Unlock(MUTEX_CONTEXT);
+    NotifyEvicted(evicted);
     return token;
 }
 
-const HeaderFields* _CompressionRules::GetExpansion(uint32_t token)
+bool _CompressionRules::GetExpansion(uint32_t token, HeaderFields& expFields)
 {
-    const HeaderFields* expansion = NULL;
+    bool found = false;
     if (token) {
         lock.Lock(MUTEX_CONTEXT);
-        map<uint32_t, const HeaderFields*>::iterator iter = tokenMap.find(token);
-        expansion = (iter != tokenMap.end()) ? iter->second : NULL;
+        const HeaderFields* expansion = Touch(token);
+        if (expansion) {
+            expFields = *expansion;
+            found = true;
+            stats.expansionHits++;
+        } else {
+            stats.expansionMisses++;
+        }
         lock.Unlock(MUTEX_CONTEXT);
     }
-    return expansion;
+    return found;
+}
+
+bool _CompressionRules::Expand(uint32_t token, HeaderFields& hdrFields)
+{
+    bool found = false;
+    if (token) {
+        lock.Lock(MUTEX_CONTEXT);
+        const HeaderFields* expansion = Touch(token);
+        if (expansion) {
+            /*
+             * Don't overwrite headers we received in the message.
+             */
+            for (size_t id = 0; id < ArraySize(hdrFields.field); id++) {
+                if (HeaderFields::Compressible[id] && (hdrFields.field[id].typeId == ALLJOYN_INVALID)) {
+                    hdrFields.field[id] = expansion->field[id];
+                }
+            }
+            found = true;
+            stats.expansionHits++;
+        } else {
+            stats.expansionMisses++;
+        }
+        lock.Unlock(MUTEX_CONTEXT);
+    }
+    return found;
+}
+
+void _CompressionRules::SetMaxRules(size_t maxRules)
+{
+    std::vector<uint32_t> evicted;
+    lock.Lock(MUTEX_CONTEXT);
+    this->maxRules = maxRules;
+    while (maxRules && (tokenMap.size() > maxRules)) {
+        uint32_t lruToken = lruList.back();
+        Remove(lruToken);
+        evicted.push_back(lruToken);
+        stats.evictions++;
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    NotifyEvicted(evicted);
+}
+
+void _CompressionRules::SetListener(CompressionRulesListener* listener)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    this->listener = listener;
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+void _CompressionRules::GetStats(Stats& stats)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    stats = this->stats;
+    stats.numRules = static_cast<uint32_t>(tokenMap.size());
+    lock.Unlock(MUTEX_CONTEXT);
 }
 
 _CompressionRules::~_CompressionRules()
 {
-    map<uint32_t, const ajn::HeaderFields*>::iterator iter = tokenMap.begin();
+    map<uint32_t, Rule>::iterator iter = tokenMap.begin();
     while (iter != tokenMap.end()) {
-        delete iter->second;
+        MemoryAccounting::Released(MemoryAccounting::MEM_COMPRESSION_RULES, iter->second.bytes);
+        delete iter->second.fields;
         iter++;
     }
 }
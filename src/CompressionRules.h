@@ -35,7 +35,9 @@
 #include <alljoyn/Status.h>
 
 #include <qcc/STLContainer.h>
+#include <list>
 #include <map>
+#include <vector>
 
 namespace ajn {
 
@@ -44,6 +46,27 @@ namespace ajn {
  */
 class _CompressionRules;
 
+/**
+ * Default maximum number of compression/expansion rules kept by _CompressionRules.
+ */
+#define ALLJOYN_MAX_COMPRESSION_RULES_DEFAULT 2048
+
+/**
+ * CompressionRulesListener is notified when a rule is evicted from the compression rules.
+ */
+class CompressionRulesListener {
+  public:
+    virtual ~CompressionRulesListener() { }
+
+    /**
+     * Called when the least recently used rule is evicted to make room for a new rule. This is
+     * called without holding any compression rules lock.
+     *
+     * @param token   The compression token of the evicted rule.
+     */
+    virtual void CompressionRuleEvicted(uint32_t token) = 0;
+};
+
 /**
  * CompressionRules is a reference counted (managed) class to allow it to be shared between multiple
  * bus attachments.
@@ -59,6 +82,23 @@ class _CompressionRules {
 
   public:
 
+    /**
+     * Compression rules statistics.
+     */
+    struct Stats {
+        uint32_t numRules;          /**< Number of rules currently held */
+        uint32_t tokenHits;         /**< GetToken() calls that found an existing token */
+        uint32_t tokenMisses;       /**< GetToken() calls that allocated a new token */
+        uint32_t expansionHits;     /**< Expansion lookups that found the token */
+        uint32_t expansionMisses;   /**< Expansion lookups that did not find the token */
+        uint32_t evictions;         /**< Rules evicted because the table was full */
+    };
+
+    /**
+     * Constructor
+     */
+    _CompressionRules();
+
     /**
      * Add a new expansion rule to the expansion table. This is an expansion that was received from
      * a remote peer. Note that 0 is an invalid token value.
@@ -83,11 +123,46 @@ class _CompressionRules {
      * Perform the lookup of the expansion given a compression token. Note that token must
      * be non-zero.
      *
-     * @param token  The compression token to lookup.
+     * @param token      The compression token to lookup.
+     * @param expFields  [OUT] A copy of the expansion. The copy remains valid if the rule is evicted.
      *
-     * @return  The expansion for the compression token or NULL if there is no such expansion.
+     * @return  true if there is an expansion for the compression token.
      */
-    const HeaderFields* GetExpansion(uint32_t token);
+    bool GetExpansion(uint32_t token, HeaderFields& expFields);
+
+    /**
+     * Expand the compressed header fields of a message. Compressible fields that are not already
+     * set in hdrFields are filled in from the expansion for token.
+     *
+     * @param token      The compression token.
+     * @param hdrFields  The header fields to expand.
+     *
+     * @return  true if there is an expansion for the token.
+     */
+    bool Expand(uint32_t token, HeaderFields& hdrFields);
+
+    /**
+     * Set the maximum number of rules. When the limit is reached the least recently used rule is
+     * evicted. A remote peer can fetch the expansion of an evicted token it received earlier only
+     * while the rule is still held, so the limit must be large enough for the working set.
+     *
+     * @param maxRules   Maximum number of rules or 0 for no limit.
+     */
+    void SetMaxRules(size_t maxRules);
+
+    /**
+     * Set the listener that is notified of evictions.
+     *
+     * @param listener   The listener or NULL.
+     */
+    void SetListener(CompressionRulesListener* listener);
+
+    /**
+     * Get the compression rules statistics.
+     *
+     * @param stats   [OUT] The statistics.
+     */
+    void GetStats(Stats& stats);
 
     /**
      * Destructor
@@ -97,9 +172,28 @@ class _CompressionRules {
   private:
 
     /**
-     * Add a compression/expansion rule.
+     * Add a compression/expansion rule. Must be called with lock held.
+     *
+     * @param hdrFields  The header fields to add.
+     * @param token      The compression token for the header fields.
+     * @param evicted    [OUT] Tokens of rules evicted to make room.
+     */
+    void Add(const HeaderFields& hdrFields, uint32_t token, std::vector<uint32_t>& evicted);
+
+    /**
+     * Remove a rule. Must be called with lock held.
      */
-    void Add(const HeaderFields& hdrFields, uint32_t token);
+    void Remove(uint32_t token);
+
+    /**
+     * Look up a rule and mark it as most recently used. Must be called with lock held.
+     */
+    const HeaderFields* Touch(uint32_t token);
+
+    /**
+     * Notify the listener of evicted rules. Must be called without holding lock.
+     */
+    void NotifyEvicted(const std::vector<uint32_t>& evicted);
 
     /**
      * Mutex to protect compression rules maps
@@ -129,7 +223,21 @@ class _CompressionRules {
     /*
      * The header expansion mapping from compression token to header fields
      */
-    std::map<uint32_t, const ajn::HeaderFields*> tokenMap;
+    struct Rule {
+        const ajn::HeaderFields* fields;        /**< The expansion */
+        std::list<uint32_t>::iterator lruPos;   /**< Position of the token in lruList */
+        size_t bytes;                           /**< Memory accounted for the rule */
+    };
+    std::map<uint32_t, Rule> tokenMap;
+
+    /*
+     * Tokens ordered from most to least recently used
+     */
+    std::list<uint32_t> lruList;
+
+    size_t maxRules;                      /**< Maximum number of rules, 0 for no limit */
+    CompressionRulesListener* listener;   /**< Eviction listener */
+    Stats stats;                          /**< Statistics (numRules is computed on demand) */
 
 };
 
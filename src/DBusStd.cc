@@ -23,6 +23,7 @@
 
 #include <qcc/platform.h>
 #include <qcc/Debug.h>
+#include <qcc/Util.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/DBusStd.h>
@@ -56,80 +57,73 @@ const char* org::freedesktop::DBus::Introspectable::IntrospectDocType =
     ">\n";
 
 
-QStatus org::freedesktop::DBus::CreateInterfaces(BusAttachment& bus) {
-
-    InterfaceDescription* intf = NULL;
-    QStatus status = bus.CreateInterface(org::freedesktop::DBus::InterfaceName, intf);
-    if ((ER_OK != status) || !intf) {
-        if (ER_OK == status) status = ER_FAIL;
-        QCC_LogError(status, ("Failed to create interface \"%s\"", org::freedesktop::DBus::InterfaceName));
-        return status;
-    }
-
-    intf->AddMethod("Hello",                               NULL,    "s",  NULL,         0);
-    intf->AddMethod("ListNames",                           NULL,    "as", "names",      0);
-    intf->AddMethod("ListActivatableNames",                NULL,    "as", "names",      0);
-    intf->AddMethod("RequestName",                         "su",    "u",  NULL,         0);
-    intf->AddMethod("ReleaseName",                         "s",     "u",  NULL,         0);
-    intf->AddMethod("NameHasOwner",                        "s",     "b",  NULL,         0);
-    intf->AddMethod("StartServiceByName",                  "su",    "u",  NULL,         0);
-    intf->AddMethod("GetNameOwner",                        "s",     "s",  "name,owner", 0);
-    intf->AddMethod("GetConnectionUnixUser",               "s",     "u",  NULL,         0);
-    intf->AddMethod("GetConnectionUnixProcessID",          "s",     "u",  NULL,         0);
-    intf->AddMethod("AddMatch",                            "s",     NULL, NULL,         0);
-    intf->AddMethod("RemoveMatch",                         "s",     NULL, NULL,         0);
-    intf->AddMethod("GetId",                               NULL,    "s",  NULL,         0);
-
-    intf->AddMethod("UpdateActivationEnvironment",         "a{ss}", NULL, "environment", 0);
-    intf->AddMethod("ListQueuedOwners",                    "s",     "as", "name,names", 0);
-    intf->AddMethod("GetAdtAuditSessionData",              "s",     "ay", NULL,         0);
-    intf->AddMethod("GetConnectionSELinuxSecurityContext", "s",     "ay", NULL,         0);
-    intf->AddMethod("ReloadConfig",                        NULL,    NULL, NULL,         0);
-
-    intf->AddSignal("NameOwnerChanged",                    "sss",   NULL,               0);
-    intf->AddSignal("NameLost",                            "s",     NULL,               0);
-    intf->AddSignal("NameAcquired",                        "s",     NULL,               0);
-    intf->AddSignal("PropertiesChanged",                   "sa{sv}as",    NULL,               0);
-
-    intf->Activate();
-
-    /* Create the org.freedesktop.DBus.Introspectable interface */
-    InterfaceDescription* introspectIntf = NULL;
-    status = bus.CreateInterface(org::freedesktop::DBus::Introspectable::InterfaceName, introspectIntf);
-    if ((ER_OK != status) || !introspectIntf) {
-        if (ER_OK == status) status = ER_FAIL;
-        QCC_LogError(status, ("Failed to create interface \"%s\"", org::freedesktop::DBus::Introspectable::InterfaceName));
-        return status;
-    }
+/*
+ * The standard DBus interfaces are the same for every bus attachment so their descriptions are
+ * built once per process from these tables and shared.
+ */
+static const InterfaceDescription::StaticMember dbusMembers[] = {
+    { MESSAGE_METHOD_CALL, "Hello",                               NULL,    "s",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "ListNames",                           NULL,    "as", "names",       0, NULL },
+    { MESSAGE_METHOD_CALL, "ListActivatableNames",                NULL,    "as", "names",       0, NULL },
+    { MESSAGE_METHOD_CALL, "RequestName",                         "su",    "u",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "ReleaseName",                         "s",     "u",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "NameHasOwner",                        "s",     "b",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "StartServiceByName",                  "su",    "u",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "GetNameOwner",                        "s",     "s",  "name,owner",  0, NULL },
+    { MESSAGE_METHOD_CALL, "GetConnectionUnixUser",               "s",     "u",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "GetConnectionUnixProcessID",          "s",     "u",  NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "AddMatch",                            "s",     NULL, NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "RemoveMatch",                         "s",     NULL, NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "GetId",                               NULL,    "s",  NULL,          0, NULL },
+
+    { MESSAGE_METHOD_CALL, "UpdateActivationEnvironment",         "a{ss}", NULL, "environment", 0, NULL },
+    { MESSAGE_METHOD_CALL, "ListQueuedOwners",                    "s",     "as", "name,names",  0, NULL },
+    { MESSAGE_METHOD_CALL, "GetAdtAuditSessionData",              "s",     "ay", NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "GetConnectionSELinuxSecurityContext", "s",     "ay", NULL,          0, NULL },
+    { MESSAGE_METHOD_CALL, "ReloadConfig",                        NULL,    NULL, NULL,          0, NULL },
+
+    { MESSAGE_SIGNAL,      "NameOwnerChanged",                    "sss",      NULL, NULL,       0, NULL },
+    { MESSAGE_SIGNAL,      "NameLost",                            "s",        NULL, NULL,       0, NULL },
+    { MESSAGE_SIGNAL,      "NameAcquired",                        "s",        NULL, NULL,       0, NULL },
+    { MESSAGE_SIGNAL,      "PropertiesChanged",                   "sa{sv}as", NULL, NULL,       0, NULL }
+};
+
+static const InterfaceDescription::StaticMember introspectMembers[] = {
+    { MESSAGE_METHOD_CALL, "Introspect", NULL, "s", "data", 0, NULL }
+};
+
+static const InterfaceDescription::StaticMember peerMembers[] = {
+    { MESSAGE_METHOD_CALL, "Ping",         NULL, NULL, NULL,        0, NULL },
+    { MESSAGE_METHOD_CALL, "GetMachineId", NULL, "s",  "machineid", 0, NULL }
+};
+
+static const InterfaceDescription::StaticMember propsMembers[] = {
+    { MESSAGE_METHOD_CALL, "Get",    "ss",  "v",     "interface,propname,value", 0, NULL },
+    { MESSAGE_METHOD_CALL, "Set",    "ssv", NULL,    "interface,propname,value", 0, NULL },
+    { MESSAGE_METHOD_CALL, "GetAll", "s",   "a{sv}", "interface,props",          0, NULL }
+};
+
+#define MEMBERS(m) m, sizeof(m) / sizeof(m[0])
+
+static const InterfaceDescription::StaticInterface dbusInterfaces[] = {
+    { "org.freedesktop.DBus",                false, MEMBERS(dbusMembers),       NULL, 0 },
+    { "org.freedesktop.DBus.Introspectable", false, MEMBERS(introspectMembers), NULL, 0 },
+    { "org.freedesktop.DBus.Peer",           false, MEMBERS(peerMembers),       NULL, 0 },
+    { "org.freedesktop.DBus.Properties",     false, MEMBERS(propsMembers),      NULL, 0 }
+};
+
+#undef MEMBERS
 
-    introspectIntf->AddMethod("Introspect", NULL, "s", "data", 0);
-    introspectIntf->Activate();
+QStatus org::freedesktop::DBus::CreateInterfaces(BusAttachment& bus) {
 
-    /* Create the org.freedesktop.DBus.Peer interface */
-    InterfaceDescription* peerIntf = NULL;
-    status = bus.CreateInterface(org::freedesktop::DBus::Peer::InterfaceName, peerIntf);
-    if ((ER_OK != status) || !peerIntf) {
-        if (ER_OK == status) status = ER_FAIL;
-        QCC_LogError(status, ("Failed to create interface \"%s\"", org::freedesktop::DBus::Peer::InterfaceName));
-        return status;
+    QStatus status = ER_OK;
+    for (size_t i = 0; (status == ER_OK) && (i < ArraySize(dbusInterfaces)); ++i) {
+        const InterfaceDescription* intf = NULL;
+        status = bus.CreateInterface(dbusInterfaces[i], intf);
+        if (ER_OK != status) {
+            QCC_LogError(status, ("Failed to create interface \"%s\"", dbusInterfaces[i].name));
+        }
     }
-    peerIntf->AddMethod("Ping",         NULL, NULL, NULL, 0);
-    peerIntf->AddMethod("GetMachineId", NULL, "s",  "machineid", 0);
-    peerIntf->Activate();
-
-    /* Create the org.freedesktop.DBus.Properties interface */
-    InterfaceDescription* propsIntf = NULL;
-    status = bus.CreateInterface(org::freedesktop::DBus::Properties::InterfaceName, propsIntf);
-    if ((ER_OK != status) || !propsIntf) {
-        if (ER_OK == status) status = ER_FAIL;
-        QCC_LogError(status, ("Failed to create interface \"%s\"", org::freedesktop::DBus::Peer::InterfaceName));
-        return status;
-    }
-    propsIntf->AddMethod("Get",    "ss",  "v",    "interface,propname,value", 0);
-    propsIntf->AddMethod("Set",    "ssv", NULL,   "interface,propname,value", 0);
-    propsIntf->AddMethod("GetAll", "s",  "a{sv}", "interface,props",          0);
-    propsIntf->Activate();
-
     return status;
 }
 
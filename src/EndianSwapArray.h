@@ -0,0 +1,134 @@
+/**
+ * @file
+ * Byte swapping of arrays of 16, 32 and 64 bit scalars for messages from foreign endian peers.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_ENDIANSWAPARRAY_H
+#define _ALLJOYN_ENDIANSWAPARRAY_H
+
+#ifndef __cplusplus
+#error Only include EndianSwapArray.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/Util.h>
+
+/*
+ * SSE2 is part of the base instruction set on x86-64 and NEON is selected by the compiler flags
+ * on ARM so neither needs a runtime check. Other targets use the scalar loops.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define ALLJOYN_SWAP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define ALLJOYN_SWAP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ajn {
+
+/*
+ * The source and destination may be the same but must not otherwise overlap. Neither needs to be
+ * aligned beyond the alignment of the element type.
+ */
+
+/**
+ * Byte swap an array of 16 bit values.
+ *
+ * @param dest  Destination for the swapped values.
+ * @param src   The values to swap.
+ * @param num   The number of values.
+ */
+inline void EndianSwapArray16(void* dest, const void* src, size_t num)
+{
+    uint16_t* d = (uint16_t*)dest;
+    const uint16_t* s = (const uint16_t*)src;
+#if defined(ALLJOYN_SWAP_SSE2)
+    for (; num >= 8; num -= 8, s += 8, d += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#elif defined(ALLJOYN_SWAP_NEON)
+    for (; num >= 8; num -= 8, s += 8, d += 8) {
+        vst1q_u8((uint8_t*)d, vrev16q_u8(vld1q_u8((const uint8_t*)s)));
+    }
+#endif
+    while (num--) {
+        *d++ = qcc::EndianSwap16(*s++);
+    }
+}
+
+/**
+ * Byte swap an array of 32 bit values.
+ *
+ * @param dest  Destination for the swapped values.
+ * @param src   The values to swap.
+ * @param num   The number of values.
+ */
+inline void EndianSwapArray32(void* dest, const void* src, size_t num)
+{
+    uint32_t* d = (uint32_t*)dest;
+    const uint32_t* s = (const uint32_t*)src;
+#if defined(ALLJOYN_SWAP_SSE2)
+    for (; num >= 4; num -= 4, s += 4, d += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        /* Exchange the 16 bit halves of each value then swap the bytes within each half */
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#elif defined(ALLJOYN_SWAP_NEON)
+    for (; num >= 4; num -= 4, s += 4, d += 4) {
+        vst1q_u8((uint8_t*)d, vrev32q_u8(vld1q_u8((const uint8_t*)s)));
+    }
+#endif
+    while (num--) {
+        *d++ = qcc::EndianSwap32(*s++);
+    }
+}
+
+/**
+ * Byte swap an array of 64 bit values.
+ *
+ * @param dest  Destination for the swapped values.
+ * @param src   The values to swap.
+ * @param num   The number of values.
+ */
+inline void EndianSwapArray64(void* dest, const void* src, size_t num)
+{
+    uint64_t* d = (uint64_t*)dest;
+    const uint64_t* s = (const uint64_t*)src;
+#if defined(ALLJOYN_SWAP_SSE2)
+    for (; num >= 2; num -= 2, s += 2, d += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        /* Reverse the four 16 bit quarters of each value then swap the bytes within each quarter */
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+        _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#elif defined(ALLJOYN_SWAP_NEON)
+    for (; num >= 2; num -= 2, s += 2, d += 2) {
+        vst1q_u8((uint8_t*)d, vrev64q_u8(vld1q_u8((const uint8_t*)s)));
+    }
+#endif
+    while (num--) {
+        *d++ = qcc::EndianSwap64(*s++);
+    }
+}
+
+}
+
+#endif
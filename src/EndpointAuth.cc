@@ -23,6 +23,7 @@
 #include <qcc/platform.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
@@ -59,7 +60,6 @@ QStatus EndpointAuth::Hello(qcc::String& redirection)
 {
     QStatus status;
     Message hello(bus);
-    Message response(bus);
 
     status = hello->HelloMessage(endpoint->GetFeatures().isBusToBus, endpoint->GetFeatures().allowRemote);
     if (status != ER_OK) {
@@ -72,6 +72,13 @@ QStatus EndpointAuth::Hello(qcc::String& redirection)
     if (status != ER_OK) {
         return status;
     }
+    return HelloResponse(hello, redirection);
+}
+
+QStatus EndpointAuth::HelloResponse(Message& hello, qcc::String& redirection)
+{
+    QStatus status;
+    Message response(bus);
 
     status = response->Read(endpoint, false, true, HELLO_RESPONSE_TIMEOUT);
     if (status != ER_OK) {
@@ -151,7 +158,6 @@ static const uint32_t REDIRECT_TIMEOUT = 30 * 1000;
 
 QStatus EndpointAuth::WaitHello(qcc::String& authUsed)
 {
-    qcc::String redirection;
     QStatus status;
     Message hello(bus);
 
@@ -160,6 +166,14 @@ QStatus EndpointAuth::WaitHello(qcc::String& authUsed)
     if (status != ER_OK) {
         return status;
     }
+    return AnswerHello(hello, authUsed);
+}
+
+QStatus EndpointAuth::AnswerHello(Message& hello, qcc::String& authUsed)
+{
+    qcc::String redirection;
+    QStatus status;
+
     status = hello->Unmarshal(endpoint, false);
     if (ER_OK == status) {
         if (hello->GetType() != MESSAGE_METHOD_CALL) {
@@ -264,6 +278,13 @@ QStatus EndpointAuth::WaitHello(qcc::String& authUsed)
             QCC_LogError(status, ("%s", __FUNCTION__));
         }
     }
+    if ((ER_OK == status) && !redirection.empty() && (establishStep != ESTABLISH_START)) {
+        /*
+         * A non-blocking establish must not wait for the other end to close the connection. The
+         * redirection has been sent so the caller simply drops the connection.
+         */
+        return ER_BUS_ENDPOINT_REDIRECTED;
+    }
     if ((ER_OK == status) && !redirection.empty()) {
         /*
          * We expect the other end to shutdown the endpoint socket as soon as it receives the
@@ -294,18 +315,37 @@ static const char AgreeVersion[] = "EXTENSION_AGREE_VERSION";
 
 static const char InformProtocolVersion[] = "INFORM_PROTO_VERSION";
 
+static const char NegotiateBodyCompression[] = "NEGOTIATE_BODY_COMPRESSION";
+static const char AgreeBodyCompression[] = "AGREE_BODY_COMPRESSION";
+
+static const char NegotiateSignalBatch[] = "NEGOTIATE_SIGNAL_BATCH";
+static const char AgreeSignalBatch[] = "AGREE_SIGNAL_BATCH";
+
+static const char NegotiatePipeline[] = "NEGOTIATE_PIPELINE";
+static const char AgreePipeline[] = "AGREE_PIPELINE";
+
 qcc::String EndpointAuth::SASLCallout(SASLEngine& sasl, const qcc::String& extCmd)
 {
     qcc::String rsp;
 
     if (sasl.GetRole() == AuthMechanism::RESPONDER) {
-        // step 1: client receives empty command and replies with "NEGOTIATE_UNIX_FD [<pid>]"
-        if (extCmd.empty() && endpoint->GetFeatures().handlePassing) {
+        // bus-to-bus connections only negotiate body compression, daemons that don't know it reply with an error
+        if (endpoint->GetFeatures().isBusToBus) {
+            if (extCmd.empty() && wantBodyCompression) {
+                rsp = NegotiateBodyCompression;
+            } else if (extCmd.find(AgreeBodyCompression) == 0) {
+                endpoint->GetFeatures().bodyCompression = true;
+            }
+        } else if (extCmd.empty() && endpoint->GetFeatures().handlePassing) {
+            // step 1: client receives empty command and replies with "NEGOTIATE_UNIX_FD [<pid>]"
             rsp = NegotiateUnixFd;
 #ifdef QCC_OS_GROUP_WINDOWS
             rsp += " " + qcc::U32ToString(qcc::GetPid());
 #endif
             endpoint->GetFeatures().handlePassing = false;
+        } else if (extCmd.empty()) {
+            // without handle passing there is no version exchange so go straight to signal batching
+            rsp = NegotiateSignalBatch;
         } else if (extCmd.find(AgreeUnixFd) == 0) {
             // step 3: client receives "AGREE_UNIX_FD [<pid>]" and sets options
             endpoint->GetFeatures().handlePassing = true;
@@ -327,6 +367,20 @@ qcc::String EndpointAuth::SASLCallout(SASLEngine& sasl, const qcc::String& extCm
         } else if (extCmd.find(InformProtocolVersion) == 0) {
             // step 10: Store daemon's protocol version
             remoteProtocolVersion = qcc::StringToU32(extCmd.substr(sizeof(InformProtocolVersion) - 1), 0, 0);
+
+            // step 11: offer signal batching, daemons that don't know it reply with an error
+            rsp = NegotiateSignalBatch;
+        } else if (extCmd.find(AgreeSignalBatch) == 0) {
+            // step 13: the daemon unpacks batch containers
+            endpoint->GetFeatures().signalBatching = true;
+        }
+        if (extCmd.find(AgreePipeline) == 0) {
+            // step 15: the daemon accepts a pipelined establish on later connections to this address
+            pipelineAgreed = true;
+        } else if (rsp.empty() && offerPipeline) {
+            // step 14: whatever the answer to the last extension was, ask about pipelining once
+            rsp = NegotiatePipeline;
+            offerPipeline = false;
         }
     } else {
         // step 2: daemon receives "NEGOTIATE_UNIX_FD [<pid>]", sets options, and replies with "AGREE_UNIX_FD [<pid>]"
@@ -351,6 +405,17 @@ qcc::String EndpointAuth::SASLCallout(SASLEngine& sasl, const qcc::String& extCm
             remoteProtocolVersion = qcc::StringToU32(extCmd.substr(sizeof(InformProtocolVersion) - 1), 0, 0);
             rsp = InformProtocolVersion;
             rsp += " " + qcc::U32ToString(ALLJOYN_PROTOCOL_VERSION);
+        } else if ((extCmd.find(NegotiateBodyCompression) == 0) && wantBodyCompression) {
+            // a bus-to-bus connection asks for body compression, agree if our transport wants it too
+            rsp = AgreeBodyCompression;
+            endpoint->GetFeatures().bodyCompression = true;
+        } else if (extCmd.find(NegotiateSignalBatch) == 0) {
+            // step 12: daemon receives "NEGOTIATE_SIGNAL_BATCH" from a client and agrees to unpack batch containers
+            rsp = AgreeSignalBatch;
+            endpoint->GetFeatures().signalBatching = true;
+        } else if (extCmd.find(NegotiatePipeline) == 0) {
+            // step 14: daemon reads the SASL commands and the hello in order so it copes with them arriving in one flight
+            rsp = AgreePipeline;
         }
     }
     return rsp;
@@ -369,6 +434,12 @@ QStatus EndpointAuth::Establish(const qcc::String& authMechanisms,
 
     QCC_DbgPrintf(("EndpointAuth::Establish authMechanisms=\"%s\"", authMechanisms.c_str()));
 
+    /*
+     * The transport's choice is only an offer until the other side agrees to it
+     */
+    wantBodyCompression = endpoint->GetFeatures().bodyCompression;
+    endpoint->GetFeatures().bodyCompression = false;
+
     if (listener) {
         authListener.Set(listener);
     }
@@ -418,7 +489,26 @@ QStatus EndpointAuth::Establish(const qcc::String& authMechanisms,
          */
         status = WaitHello(authUsed);
     } else {
-        SASLEngine sasl(bus, AuthMechanism::RESPONDER, authMechanisms, NULL, authListener, endpoint->GetFeatures().isBusToBus ? NULL : this);
+        /*
+         * The first connection to an address asks the daemon about pipelining, later ones can
+         * send the whole handshake in one flight if it agreed.
+         */
+        const qcc::String& connectSpec = endpoint->GetConnectSpec();
+        bool pipelined = false;
+        bool known = connectSpec.empty() || bus.GetInternal().GetPipelinedEstablish(connectSpec, pipelined);
+        offerPipeline = !known;
+        if (pipelined && ((authMechanisms == "ANONYMOUS") || (authMechanisms == "EXTERNAL"))) {
+            status = EstablishPipelined(authMechanisms, authUsed, redirection);
+            if ((status == ER_OK) || (status == ER_BUS_ENDPOINT_REDIRECTED)) {
+                bus.GetInternal().SetPipelinedEstablish(connectSpec, pipelineAgreed);
+            } else {
+                QCC_DbgPrintf(("Pipelined establish with %s failed %s", connectSpec.c_str(), QCC_StatusText(status)));
+                bus.GetInternal().SetPipelinedEstablish(connectSpec, false);
+            }
+            goto ExitEstablish;
+        }
+        bool useExtensions = !endpoint->GetFeatures().isBusToBus || wantBodyCompression || offerPipeline;
+        SASLEngine sasl(bus, AuthMechanism::RESPONDER, authMechanisms, NULL, authListener, useExtensions ? this : NULL);
         while (true) {
             status = sasl.Advance(inStr, outStr, state);
             if (status != ER_OK) {
@@ -466,6 +556,9 @@ QStatus EndpointAuth::Establish(const qcc::String& authMechanisms,
          * Send the hello message and wait for a response
          */
         status = Hello(redirection);
+        if ((status == ER_OK) && !known) {
+            bus.GetInternal().SetPipelinedEstablish(connectSpec, pipelineAgreed);
+        }
     }
 
 ExitEstablish:
@@ -477,4 +570,204 @@ ExitEstablish:
     return status;
 }
 
-}
\ No newline at end of file
+QStatus EndpointAuth::EstablishPipelined(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection)
+{
+    QStatus status;
+    size_t numPushed;
+    SASLEngine::AuthState state;
+    qcc::String inStr;
+    qcc::String outStr;
+
+    /*
+     * The extension commands that are otherwise sent one at a time, assuming the daemon agrees to each
+     */
+    std::vector<qcc::String> extCmds;
+    if (endpoint->GetFeatures().isBusToBus) {
+        if (wantBodyCompression) {
+            extCmds.push_back(NegotiateBodyCompression);
+        }
+    } else {
+        if (endpoint->GetFeatures().handlePassing) {
+            qcc::String cmd = NegotiateUnixFd;
+#ifdef QCC_OS_GROUP_WINDOWS
+            cmd += " " + qcc::U32ToString(qcc::GetPid());
+#endif
+            extCmds.push_back(cmd);
+            extCmds.push_back(qcc::String(NegotiateVersion) + " " + qcc::U32ToString(ajn::GetNumericVersion()));
+            extCmds.push_back(qcc::String(InformProtocolVersion) + " " + qcc::U32ToString(ALLJOYN_PROTOCOL_VERSION));
+            endpoint->GetFeatures().handlePassing = false;
+        }
+        extCmds.push_back(NegotiateSignalBatch);
+    }
+    extCmds.push_back(NegotiatePipeline);
+
+    SASLEngine sasl(bus, AuthMechanism::RESPONDER, authMechanisms, NULL, authListener, NULL);
+    status = sasl.Advance(inStr, outStr, state);
+    if (status != ER_OK) {
+        QCC_DbgPrintf(("Client authentication failed %s", QCC_StatusText(status)));
+        return status;
+    }
+    qcc::String flight = outStr;
+    for (size_t i = 0; i < extCmds.size(); ++i) {
+        flight += extCmds[i] + "\r\n";
+    }
+    flight += "BEGIN\r\n";
+
+    Message hello(bus);
+    status = hello->HelloMessage(endpoint->GetFeatures().isBusToBus, endpoint->GetFeatures().allowRemote);
+    if (status != ER_OK) {
+        return status;
+    }
+    flight.append(reinterpret_cast<const char*>(hello->msgBuf), hello->bufEOD - reinterpret_cast<uint8_t*>(hello->msgBuf));
+
+    /*
+     * Send everything in one write so the handshake costs a single round trip
+     */
+    const char* buf = flight.data();
+    size_t len = flight.length();
+    while (len) {
+        status = endpoint->GetSink().PushBytes((void*)buf, len, numPushed);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to write to stream"));
+            return status;
+        }
+        buf += numPushed;
+        len -= numPushed;
+    }
+    QCC_DbgPrintf(("Sent pipelined %s with %u extensions and hello", sasl.GetMechanism().c_str(), static_cast<uint32_t>(extCmds.size())));
+
+    /*
+     * The mechanism must succeed on the first AUTH, the daemon has already been sent BEGIN
+     */
+    status = endpoint->GetSource().GetLine(inStr);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to read from stream"));
+        return status;
+    }
+    status = sasl.Advance(inStr, outStr, state);
+    if ((status == ER_OK) && (state != SASLEngine::ALLJOYN_AUTH_SUCCESS)) {
+        status = ER_AUTH_FAIL;
+    }
+    if (status != ER_OK) {
+        QCC_DbgPrintf(("Client authentication failed %s", QCC_StatusText(status)));
+        return status;
+    }
+    qcc::String id = sasl.GetRemoteId();
+    if (!qcc::GUID128::IsGUID(id)) {
+        QCC_DbgPrintf(("Expected GUID got: %s", id.c_str()));
+        return ER_BUS_ESTABLISH_FAILED;
+    }
+    remoteGUID = qcc::GUID128(id);
+    authUsed = sasl.GetMechanism();
+
+    /*
+     * The daemon answers every extension command in order, an error just leaves that feature off
+     */
+    for (size_t i = 0; i < extCmds.size(); ++i) {
+        inStr.clear();
+        status = endpoint->GetSource().GetLine(inStr);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to read from stream"));
+            return status;
+        }
+        size_t pos = inStr.find("\r\n");
+        if (pos != qcc::String::npos) {
+            inStr.erase(pos);
+        }
+        if (inStr.find("ERROR") == 0) {
+            inStr = "ERROR";
+        }
+        SASLCallout(sasl, inStr);
+    }
+    return HelloResponse(hello, redirection);
+}
+
+QStatus EndpointAuth::EstablishNonBlocking(const qcc::String& authMechanisms, qcc::String& authUsed, AuthListener* listener)
+{
+    QStatus status = ER_OK;
+
+    if (!isAccepting) {
+        return ER_NOT_IMPLEMENTED;
+    }
+    if (establishStep == ESTABLISH_START) {
+        QCC_DbgPrintf(("EndpointAuth::EstablishNonBlocking authMechanisms=\"%s\"", authMechanisms.c_str()));
+        wantBodyCompression = endpoint->GetFeatures().bodyCompression;
+        endpoint->GetFeatures().bodyCompression = false;
+        if (listener) {
+            authListener.Set(listener);
+        }
+        sasl = new SASLEngine(bus, AuthMechanism::CHALLENGER, authMechanisms, NULL, authListener, this);
+        /*
+         * The server's GUID is sent to the client when the authentication succeeds
+         */
+        String guidStr = bus.GetInternal().GetGlobalGUID().ToString();
+        sasl->SetLocalId(guidStr);
+        establishStep = ESTABLISH_SASL;
+    }
+    /*
+     * Consume challenges until the endpoint runs dry. The endpoint may have read ahead so we keep
+     * going until it says it would block rather than relying on the stream becoming readable again.
+     */
+    while (establishStep == ESTABLISH_SASL) {
+        char c;
+        size_t actual;
+        status = endpoint->GetSource().PullBytes(&c, 1, actual, 0);
+        if (status != ER_OK) {
+            if ((status != ER_TIMEOUT) && (status != ER_WOULDBLOCK)) {
+                QCC_LogError(status, ("Failed to read from stream"));
+            }
+            break;
+        }
+        if (actual != 1) {
+            status = ER_FAIL;
+            break;
+        }
+        inLine.push_back(c);
+        if (c != '\n') {
+            continue;
+        }
+        SASLEngine::AuthState state;
+        qcc::String outStr;
+        status = sasl->Advance(inLine, outStr, state);
+        inLine.clear();
+        if (status != ER_OK) {
+            QCC_DbgPrintf(("Server authentication failed %s", QCC_StatusText(status)));
+            break;
+        }
+        if (state == SASLEngine::ALLJOYN_AUTH_SUCCESS) {
+            establishStep = ESTABLISH_HELLO;
+            break;
+        }
+        /*
+         * Send the response
+         */
+        size_t numPushed;
+        status = endpoint->GetSink().PushBytes((void*)(outStr.data()), outStr.length(), numPushed);
+        if (status == ER_OK) {
+            QCC_DbgPrintf(("Sent %s", outStr.c_str()));
+        } else {
+            QCC_LogError(status, ("Failed to write to stream"));
+            break;
+        }
+    }
+    if ((status == ER_OK) && (establishStep == ESTABLISH_HELLO)) {
+        /*
+         * Remember the authentication mechanism that was used
+         */
+        authUsed = sasl->GetMechanism();
+        status = hello->ReadNonBlocking(endpoint, false);
+        if (status == ER_OK) {
+            status = AnswerHello(hello, authUsed);
+        }
+    }
+    if ((status == ER_TIMEOUT) || (status == ER_WOULDBLOCK)) {
+        return ER_WOULDBLOCK;
+    }
+    authListener.Set(NULL);
+
+    QCC_DbgPrintf(("Establish complete %s", QCC_StatusText(status)));
+
+    return status;
+}
+
+}
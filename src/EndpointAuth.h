@@ -59,13 +59,19 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
         endpoint(endpoint),
         uniqueName(bus.GetInternal().GetRouter().GenerateUniqueName()),
         isAccepting(isAcceptor),
-        remoteProtocolVersion(0)
+        remoteProtocolVersion(0),
+        wantBodyCompression(false),
+        offerPipeline(false),
+        pipelineAgreed(false),
+        establishStep(ESTABLISH_START),
+        sasl(NULL),
+        hello(bus)
     { }
 
     /**
      * Destructor
      */
-    ~EndpointAuth() { };
+    ~EndpointAuth() { delete sasl; };
 
     /**
      * Establish a connection.
@@ -83,6 +89,23 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
      */
     QStatus Establish(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection, AuthListener* listener = NULL);
 
+    /**
+     * Establish an incoming connection without blocking. Each call consumes the authentication
+     * data that is available from the endpoint and returns as soon as more is needed so the
+     * caller can resume the handshake when the endpoint's stream is readable again. This is only
+     * supported on the accepting side of a connection.
+     *
+     * @param authMechanisms  The authentication mechanisms to try. Only used by the first call.
+     * @param authUsed        Returns the name of the authentication method that was used to establish the connection.
+     * @param listener        Authentication credentials listener. Only used by the first call.
+     *
+     * @return
+     *      - ER_OK if successful
+     *      - ER_WOULDBLOCK if the handshake is waiting for data from the remote side
+     *      - An error status otherwise
+     */
+    QStatus EstablishNonBlocking(const qcc::String& authMechanisms, qcc::String& authUsed, AuthListener* listener = NULL);
+
     /**
      * Get the unique bus name assigned by the bus for this endpoint.
      *
@@ -131,6 +154,26 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
      */
     qcc::String SASLCallout(SASLEngine& sasl, const qcc::String& extCmd);
 
+    /**
+     * Read and check the response to a hello message that has been sent.
+     *
+     * @param hello        The hello message that was sent.
+     * @param redirection  Returns the redirection address if the daemon redirected the endpoint.
+     */
+    QStatus HelloResponse(Message& hello, qcc::String& redirection);
+
+    /**
+     * Establish an outgoing connection to a daemon that is known to accept a pipelined establish.
+     * The AUTH command, the extension commands, BEGIN and the hello message are sent in one write
+     * and the responses are then read in order. Only used for mechanisms that authenticate without
+     * a challenge.
+     *
+     * @param authMechanisms  The authentication mechanism to use, ANONYMOUS or EXTERNAL.
+     * @param authUsed        Returns the name of the authentication method that was used.
+     * @param redirection     Returns a redirection address for the endpoint.
+     */
+    QStatus EstablishPipelined(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection);
+
     BusAttachment& bus;
     RemoteEndpoint endpoint;
     qcc::String uniqueName;          ///< Unique bus name for endpoint
@@ -140,13 +183,31 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
 
     qcc::GUID128 remoteGUID;            ///< GUID of the remote side (when applicable)
     uint32_t remoteProtocolVersion;     ///< ALLJOYN protocol version of the remote side
+    bool wantBodyCompression;           ///< The local transport offered body compression
+    bool offerPipeline;                 ///< Ask the daemon if it accepts a pipelined establish
+    bool pipelineAgreed;                ///< The daemon agreed to a pipelined establish
 
     ProtectedAuthListener authListener;  ///< Authentication listener
 
+    /**
+     * Progress of a non-blocking establish.
+     */
+    enum EstablishStep {
+        ESTABLISH_START,  ///< Nothing has been received yet
+        ESTABLISH_SASL,   ///< Exchanging SASL commands
+        ESTABLISH_HELLO   ///< Authenticated, waiting for the Hello message
+    };
+
+    EstablishStep establishStep;     ///< Progress of a non-blocking establish
+    SASLEngine* sasl;                ///< SASL engine used by a non-blocking establish
+    qcc::String inLine;              ///< Partial SASL command received by a non-blocking establish
+    Message hello;                   ///< Hello message being read by a non-blocking establish
+
     /* Internal methods */
 
     QStatus Hello(qcc::String& redirection);
     QStatus WaitHello(qcc::String& authUsed);
+    QStatus AnswerHello(Message& hello, qcc::String& authUsed);
 };
 
 }
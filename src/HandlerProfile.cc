@@ -0,0 +1,131 @@
+/**
+ * @file
+ * Call counts and timings of the method and signal handlers called by a local endpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <algorithm>
+
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include "HandlerProfile.h"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+static uint32_t Elapsed(uint64_t start, uint64_t end)
+{
+    uint64_t elapsed = (end > start) ? (end - start) : 0;
+    return (elapsed >= 0xFFFFFFFF) ? 0xFFFFFFFF : static_cast<uint32_t>(elapsed);
+}
+
+void HandlerProfile::Record(const InterfaceDescription::Member* member, uint64_t queuedAt, uint64_t start, uint64_t end)
+{
+    if (!member) {
+        return;
+    }
+    lock.Lock(MUTEX_CONTEXT);
+    map<const InterfaceDescription::Member*, Entry>::iterator it = entries.find(member);
+    if (it == entries.end()) {
+        it = entries.insert(pair<const InterfaceDescription::Member*, Entry>(member, Entry())).first;
+        it->second.iface = member->iface->GetName();
+        it->second.member = member->name;
+        it->second.isSignal = (member->memberType == MESSAGE_SIGNAL);
+        it->second.handlerUsecs = 0;
+    }
+    Entry& entry = it->second;
+    uint32_t usecs = Elapsed(start, end);
+    entry.handlerUsecs += usecs;
+    entry.handler.Record(usecs);
+    if (queuedAt) {
+        entry.queue.Record(Elapsed(queuedAt, start));
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+static bool IfaceMemberLess(const HandlerProfile::Stats& a, const HandlerProfile::Stats& b)
+{
+    return (a.iface < b.iface) || ((a.iface == b.iface) && (a.member < b.member));
+}
+
+void HandlerProfile::Get(vector<Stats>& stats) const
+{
+    stats.clear();
+    lock.Lock(MUTEX_CONTEXT);
+    stats.reserve(entries.size());
+    for (map<const InterfaceDescription::Member*, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        const Entry& entry = it->second;
+        Stats s;
+        s.iface = entry.iface;
+        s.member = entry.member;
+        s.isSignal = entry.isSignal;
+        s.calls = entry.handler.GetCount();
+        s.handlerUsecs = entry.handlerUsecs;
+        s.handlerP50 = entry.handler.GetPercentile(500);
+        s.handlerP99 = entry.handler.GetPercentile(990);
+        s.handlerMax = entry.handler.GetMax();
+        s.queueP50 = entry.queue.GetPercentile(500);
+        s.queueP99 = entry.queue.GetPercentile(990);
+        s.queueMax = entry.queue.GetMax();
+        stats.push_back(s);
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    /* Map order depends on where the members happen to be allocated */
+    sort(stats.begin(), stats.end(), IfaceMemberLess);
+}
+
+void HandlerProfile::Reset()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    entries.clear();
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+static bool HandlerTimeGreater(const HandlerProfile::Stats& a, const HandlerProfile::Stats& b)
+{
+    return a.handlerUsecs > b.handlerUsecs;
+}
+
+qcc::String HandlerProfile::ToString() const
+{
+    vector<Stats> stats;
+    Get(stats);
+    stable_sort(stats.begin(), stats.end(), HandlerTimeGreater);
+
+    qcc::String str;
+    for (vector<Stats>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        str += it->iface + "." + it->member + (it->isSignal ? " (signal)" : "");
+        str += ": calls=" + U32ToString(it->calls);
+        str += " total=" + U64ToString(it->handlerUsecs);
+        str += "us p50=" + U32ToString(it->handlerP50);
+        str += "us p99=" + U32ToString(it->handlerP99);
+        str += "us max=" + U32ToString(it->handlerMax);
+        str += "us queued p50=" + U32ToString(it->queueP50);
+        str += "us p99=" + U32ToString(it->queueP99);
+        str += "us max=" + U32ToString(it->queueMax);
+        str += "us\n";
+    }
+    return str;
+}
+
+}
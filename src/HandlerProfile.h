@@ -0,0 +1,131 @@
+#ifndef _ALLJOYN_HANDLERPROFILE_H
+#define _ALLJOYN_HANDLERPROFILE_H
+/**
+ * @file
+ * Call counts and timings of the method and signal handlers called by a local endpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include HandlerProfile.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <map>
+#include <vector>
+
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+
+#include <alljoyn/InterfaceDescription.h>
+
+#include "LatencyHistogram.h"
+
+namespace ajn {
+
+/**
+ * HandlerProfile keeps, for each interface member, how often its handlers were called, how long
+ * they ran and how long the messages waited for a dispatcher thread first. A slow handler holds
+ * up every message queued behind it so the queueing delay of other members rises with it.
+ * Profiling is disabled by default; when disabled the only cost on the dispatch path is a test
+ * of a flag.
+ */
+class HandlerProfile {
+  public:
+
+    /** The profile of one interface member */
+    struct Stats {
+        qcc::String iface;      /**< Interface name */
+        qcc::String member;     /**< Member name */
+        bool isSignal;          /**< true for a signal, false for a method */
+        uint32_t calls;         /**< Handler calls, a signal with several handlers counts each */
+        uint64_t handlerUsecs;  /**< Total time spent in the handlers */
+        uint32_t handlerP50;    /**< Median handler time in microseconds */
+        uint32_t handlerP99;    /**< 99th percentile handler time in microseconds */
+        uint32_t handlerMax;    /**< Longest handler time in microseconds */
+        uint32_t queueP50;      /**< Median queueing delay in microseconds */
+        uint32_t queueP99;      /**< 99th percentile queueing delay in microseconds */
+        uint32_t queueMax;      /**< Longest queueing delay in microseconds */
+    };
+
+    /**
+     * Constructor
+     */
+    HandlerProfile() : enabled(false) { }
+
+    /**
+     * @return  true if handler calls are being profiled.
+     */
+    bool IsEnabled() const { return enabled; }
+
+    /**
+     * Enable or disable profiling. What has been recorded is kept.
+     *
+     * @param enable   true to profile handler calls.
+     */
+    void Enable(bool enable) { enabled = enable; }
+
+    /**
+     * Record a handler call.
+     *
+     * @param member     The member the handler was called for.
+     * @param queuedAt   Latency clock time at which the message was queued for a dispatcher
+     *                   thread, 0 if it was delivered without being queued.
+     * @param start      Latency clock time at which the handler was called.
+     * @param end        Latency clock time at which the handler returned.
+     */
+    void Record(const InterfaceDescription::Member* member, uint64_t queuedAt, uint64_t start, uint64_t end);
+
+    /**
+     * Get the profile of every member that has been recorded, ordered by interface and member.
+     *
+     * @param[out] stats   The profiles.
+     */
+    void Get(std::vector<Stats>& stats) const;
+
+    /**
+     * Clear everything recorded.
+     */
+    void Reset();
+
+    /**
+     * @return  One line of text per member, the members with the most handler time first.
+     */
+    qcc::String ToString() const;
+
+  private:
+
+    struct Entry {
+        qcc::String iface;
+        qcc::String member;
+        bool isSignal;
+        uint64_t handlerUsecs;
+        LatencyHistogram handler;
+        LatencyHistogram queue;
+    };
+
+    volatile bool enabled;
+    mutable qcc::Mutex lock;
+    /* Keyed by member, activated interfaces and their members live as long as the bus attachment */
+    std::map<const InterfaceDescription::Member*, Entry> entries;
+};
+
+}
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * @file
+ *
+ * This file implements the IODispatchPool class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/StringUtil.h>
+
+#include "IODispatchPool.h"
+#include "ThreadScheduling.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+
+namespace ajn {
+
+/* Upper bound on the number of event loops */
+static const uint32_t MAX_IODISPATCH_THREADS = 64;
+
+/* Lower bound on the number of threads servicing the callbacks of one event loop */
+static const uint32_t MIN_CALLBACK_CONCURRENCY = 8;
+
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+
+static pthread_key_t boundCpuKey;
+static bool boundCpuKeyValid = (pthread_key_create(&boundCpuKey, NULL) == 0);
+
+static void BindThread(size_t shard)
+{
+    if (!boundCpuKeyValid) {
+        return;
+    }
+    /* The key holds the bound cpu + 1 so that 0 means not bound */
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numCpus <= 0) {
+        return;
+    }
+    size_t cpu = shard % static_cast<size_t>(numCpus);
+    if (reinterpret_cast<size_t>(pthread_getspecific(boundCpuKey)) == (cpu + 1)) {
+        return;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) == 0) {
+        QCC_DbgPrintf(("IODispatch callback thread bound to cpu %u", static_cast<uint32_t>(cpu)));
+    } else {
+        QCC_LogError(ER_OS_ERROR, ("Failed to bind IODispatch callback thread to cpu %u", static_cast<uint32_t>(cpu)));
+    }
+    /* Don't retry on failure, the affinity is only a hint */
+    pthread_setspecific(boundCpuKey, reinterpret_cast<void*>(cpu + 1));
+}
+
+#else
+
+static void BindThread(size_t shard)
+{
+}
+
+#endif
+
+IODispatchPool::IODispatchPool(const char* name, uint32_t concurrency) : affinity(false)
+{
+    Environ* env = Environ::GetAppEnviron();
+    uint32_t numLoops = StringToU32(env->Find("ALLJOYN_IODISPATCH_THREADS"), 0, 1);
+    if (numLoops == 0) {
+        numLoops = 1;
+    } else if (numLoops > MAX_IODISPATCH_THREADS) {
+        numLoops = MAX_IODISPATCH_THREADS;
+    }
+    affinity = (StringToU32(env->Find("ALLJOYN_IODISPATCH_AFFINITY"), 0, 0) != 0);
+
+    uint32_t perLoop = concurrency / numLoops;
+    if (perLoop < MIN_CALLBACK_CONCURRENCY) {
+        perLoop = MIN_CALLBACK_CONCURRENCY;
+    }
+    /*
+     * All event loops share a name so the callback threads can be recognized by name no
+     * matter which event loop they belong to.
+     */
+    for (uint32_t i = 0; i < numLoops; ++i) {
+        dispatchers.push_back(new IODispatch(name, (numLoops == 1) ? concurrency : perLoop));
+    }
+    QCC_DbgPrintf(("IODispatchPool %s: %u event loops%s", name, numLoops, affinity ? " with cpu affinity" : ""));
+}
+
+IODispatchPool::~IODispatchPool()
+{
+    for (size_t i = 0; i < dispatchers.size(); ++i) {
+        delete dispatchers[i];
+    }
+}
+
+QStatus IODispatchPool::Start()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < dispatchers.size(); ++i) {
+        QStatus s = dispatchers[i]->Start();
+        if (status == ER_OK) {
+            status = s;
+        }
+    }
+    return status;
+}
+
+QStatus IODispatchPool::Stop()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < dispatchers.size(); ++i) {
+        QStatus s = dispatchers[i]->Stop();
+        if (status == ER_OK) {
+            status = s;
+        }
+    }
+    return status;
+}
+
+QStatus IODispatchPool::Join()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < dispatchers.size(); ++i) {
+        QStatus s = dispatchers[i]->Join();
+        if (status == ER_OK) {
+            status = s;
+        }
+    }
+    return status;
+}
+
+size_t IODispatchPool::Shard(const qcc::Stream* stream) const
+{
+    if (dispatchers.size() == 1) {
+        return 0;
+    }
+    /* Streams are heap allocated so the low bits of the address carry no information */
+    size_t h = reinterpret_cast<size_t>(stream) >> 4;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6dU;
+    h ^= h >> 12;
+    return h % dispatchers.size();
+}
+
+void IODispatchPool::BindCallbackThread(const qcc::Stream* stream)
+{
+    ThreadScheduling::Apply();
+    /* A cpu mask given to ThreadScheduling takes precedence over binding by shard */
+    if (affinity && !ThreadScheduling::HasAffinity()) {
+        BindThread(Shard(stream));
+    }
+}
+
+}
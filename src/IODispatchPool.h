@@ -0,0 +1,123 @@
+#ifndef _ALLJOYN_IODISPATCHPOOL_H
+#define _ALLJOYN_IODISPATCHPOOL_H
+/**
+ * @file
+ * IODispatchPool shards the I/O of a bus attachment's streams over several IODispatch
+ * event loops.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include IODispatchPool.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/IODispatch.h>
+#include <qcc/Stream.h>
+
+#include <vector>
+
+#include <Status.h>
+
+namespace ajn {
+
+/**
+ * IODispatchPool owns one or more IODispatch instances. Each stream is pinned by hash to
+ * one of them for its whole lifetime so all of the stream's callbacks are serviced by the
+ * same event loop while unrelated streams are serviced in parallel.
+ *
+ * The number of event loops is read from the ALLJOYN_IODISPATCH_THREADS environment
+ * variable and defaults to one. If ALLJOYN_IODISPATCH_AFFINITY is set to 1 the threads
+ * servicing each event loop are bound to one CPU (Linux only).
+ */
+class IODispatchPool {
+  public:
+
+    /**
+     * Constructor
+     *
+     * @param name          Name for the IODispatch threads.
+     * @param concurrency   Total number of threads servicing callbacks, divided among the event loops.
+     */
+    IODispatchPool(const char* name, uint32_t concurrency);
+
+    /** Destructor */
+    ~IODispatchPool();
+
+    /**
+     * Start all event loops.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Start();
+
+    /**
+     * Stop all event loops.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Stop();
+
+    /**
+     * Wait for all event loops to stop.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Join();
+
+    /**
+     * Get the event loop that services a stream.
+     *
+     * @param stream   The stream.
+     *
+     * @return  The IODispatch the stream is pinned to.
+     */
+    qcc::IODispatch& Get(const qcc::Stream* stream) { return *dispatchers[Shard(stream)]; }
+
+    /**
+     * Get the number of event loops.
+     *
+     * @return  The number of event loops.
+     */
+    size_t Size() const { return dispatchers.size(); }
+
+    /**
+     * Bind the calling thread to the CPU assigned to the event loop that services a stream.
+     * This is a no-op unless CPU affinity was requested. Called from the stream's callbacks so
+     * the threads the IODispatch uses for the callbacks stay on one CPU. The thread is also given
+     * the scheduling set with ThreadScheduling::Set().
+     *
+     * @param stream   The stream whose callback is running on the calling thread.
+     */
+    void BindCallbackThread(const qcc::Stream* stream);
+
+  private:
+
+    /* Copy constructor and assignment are not allowed */
+    IODispatchPool(const IODispatchPool& other);
+    IODispatchPool& operator=(const IODispatchPool& other);
+
+    size_t Shard(const qcc::Stream* stream) const;
+
+    std::vector<qcc::IODispatch*> dispatchers;  /**< The event loops */
+    bool affinity;                              /**< True if callback threads are bound to a CPU */
+};
+
+}
+
+#endif
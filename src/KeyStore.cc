@@ -32,12 +32,14 @@
 #include <qcc/Util.h>
 #include <qcc/StringSource.h>
 #include <qcc/StringSink.h>
+#include <qcc/StringUtil.h>
 #include <qcc/Thread.h>
 
 #include <alljoyn/KeyStoreListener.h>
 
 #include "PeerState.h"
 #include "KeyStore.h"
+#include "SharedKeyMap.h"
 
 #include <alljoyn/Status.h>
 
@@ -59,6 +61,21 @@ static const uint16_t LowStoreVersion = 0x0102;
  */
 static const uint16_t KeyStoreVersion = 0x0103;
 
+/*
+ * Records in the shared key map are encrypted with the epoch of the map, the slot and its version
+ * as the nonce. Versions restart when the map is reinitialized but the epoch changes with them.
+ * The nonce is longer than the revision used for the key store file so the two never coincide.
+ */
+static KeyBlob SharedMapNonce(uint64_t epoch, uint32_t slot, uint32_t version)
+{
+    uint8_t nonce[13];
+    /* NUM_SLOTS is 256 so the slot fits in a byte, which leaves room for the epoch in a 13 byte CCM nonce */
+    nonce[0] = static_cast<uint8_t>(slot);
+    memcpy(nonce + 1, &version, sizeof(version));
+    memcpy(nonce + 1 + sizeof(version), &epoch, sizeof(epoch));
+    return KeyBlob(nonce, sizeof(nonce), KeyBlob::GENERIC);
+}
+
 
 QStatus KeyStoreListener::PutKeys(KeyStore& keyStore, const qcc::String& source, const qcc::String& password)
 {
@@ -88,6 +105,8 @@ class DefaultKeyStoreListener : public KeyStoreListener {
         }
     }
 
+    const qcc::String& GetFileName() const { return fileName; }
+
     QStatus LoadRequest(KeyStore& keyStore) {
         QStatus status;
         /* Try to load the keystore */
@@ -161,10 +180,13 @@ KeyStore::KeyStore(const qcc::String& application) :
     defaultListener(NULL),
     listener(NULL),
     thisGuid(),
+    loadPending(false),
     keyStoreKey(NULL),
     shared(false),
     stored(NULL),
-    loaded(NULL)
+    loaded(NULL),
+    sharedMap(NULL),
+    sharedChangeCount(0)
 {
 }
 
@@ -194,6 +216,7 @@ KeyStore::~KeyStore()
     delete listener;
     delete keyStoreKey;
     delete keys;
+    delete sharedMap;
 }
 
 QStatus KeyStore::SetListener(KeyStoreListener& listener)
@@ -214,6 +237,27 @@ QStatus KeyStore::SetDefaultListener()
 
 QStatus KeyStore::Reset()
 {
+    lock.Lock(MUTEX_CONTEXT);
+    delete sharedMap;
+    sharedMap = NULL;
+    sharedMapFile.clear();
+    sharedChangeCount = 0;
+    sharedVersions.clear();
+    sharedSlotKeys.clear();
+    lock.Unlock(MUTEX_CONTEXT);
+    loadLock.Lock(MUTEX_CONTEXT);
+    if (loadPending) {
+        /* Never loaded so there is nothing to clear */
+        loadPending = false;
+        loadLock.Unlock(MUTEX_CONTEXT);
+        delete listener;
+        listener = NULL;
+        delete defaultListener;
+        defaultListener = NULL;
+        shared = false;
+        return ER_OK;
+    }
+    loadLock.Unlock(MUTEX_CONTEXT);
     if (storeState != UNAVAILABLE) {
         QStatus status = Clear();
         storeState = UNAVAILABLE;
@@ -230,13 +274,27 @@ QStatus KeyStore::Reset()
 
 QStatus KeyStore::Init(const char* fileName, bool isShared)
 {
-    if (storeState == UNAVAILABLE) {
+    if ((storeState == UNAVAILABLE) && !loadPending) {
         if (listener == NULL) {
-            defaultListener = new DefaultKeyStoreListener(application, fileName);
+            DefaultKeyStoreListener* fileListener = new DefaultKeyStoreListener(application, fileName);
+            /*
+             * Processes sharing the default key store can see each other's changes through a
+             * shared key map next to the key store file instead of reloading the file. All of the
+             * processes sharing the key store must enable it.
+             */
+            if (isShared && (StringToU32(Environ::GetAppEnviron()->Find("ALLJOYN_KEYSTORE_SHARED_MAP"), 0, 0) != 0)) {
+                sharedMapFile = fileListener->GetFileName() + ".shm";
+            }
+            defaultListener = fileListener;
             listener = new ProtectedKeyStoreListener(defaultListener);
         }
         shared = isShared;
-        return Load();
+        /*
+         * Loading the key store means reading and decrypting a file so it is deferred until the
+         * keys are first needed, typically the first authentication.
+         */
+        loadPending = true;
+        return ER_OK;
     } else {
         return ER_FAIL;
     }
@@ -246,6 +304,10 @@ QStatus KeyStore::Store()
 {
     QStatus status = ER_OK;
 
+    /* Nothing can have been modified if the load is still pending */
+    if (loadPending) {
+        return ER_OK;
+    }
     /* Cannot store if never loaded */
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
@@ -253,7 +315,17 @@ QStatus KeyStore::Store()
     /* Don't store if not modified */
     if (storeState == MODIFIED) {
 
+        /*
+         * Only one store at a time. While a store is running other threads wait here and all of
+         * the changes they made before the store pushed the keys were written by it.
+         */
+        storeLock.Lock(MUTEX_CONTEXT);
         lock.Lock(MUTEX_CONTEXT);
+        if (storeState != MODIFIED) {
+            lock.Unlock(MUTEX_CONTEXT);
+            storeLock.Unlock(MUTEX_CONTEXT);
+            return ER_OK;
+        }
         EraseExpiredKeys();
 
         /* Reload to merge keystore changes before storing */
@@ -276,6 +348,7 @@ QStatus KeyStore::Store()
             deletions.clear();
         }
         lock.Unlock(MUTEX_CONTEXT);
+        storeLock.Unlock(MUTEX_CONTEXT);
     }
     return status;
 }
@@ -299,6 +372,174 @@ QStatus KeyStore::Load()
     return status;
 }
 
+QStatus KeyStore::LoadIfPending()
+{
+    QStatus status = ER_OK;
+    if (loadPending) {
+        loadLock.Lock(MUTEX_CONTEXT);
+        if (loadPending) {
+            QCC_DbgHLPrintf(("KeyStore::LoadIfPending loading deferred key store"));
+            status = Load();
+            loadPending = false;
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Failed to load key store"));
+            } else if (!sharedMapFile.empty()) {
+                /*
+                 * The map belongs to the key store GUID, which a new key store only has in memory
+                 * until it is first stored. Store it so other processes derive the same key.
+                 */
+                if (revision == 0) {
+                    Store();
+                }
+                OpenSharedMap();
+            }
+        }
+        loadLock.Unlock(MUTEX_CONTEXT);
+    }
+    return status;
+}
+
+void KeyStore::OpenSharedMap()
+{
+    SharedKeyMap* map = new SharedKeyMap();
+    QStatus status = map->Open(sharedMapFile, thisGuid);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Shared key map %s not available, reloading the key store instead", sharedMapFile.c_str()));
+        delete map;
+        return;
+    }
+    lock.Lock(MUTEX_CONTEXT);
+    sharedMap = map;
+    sharedChangeCount = 0;
+    sharedVersions.assign(SharedKeyMap::NUM_SLOTS, 0);
+    sharedSlotKeys.clear();
+    /* Keys changed since the file was last stored are only in the map */
+    SyncSharedMap();
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+void KeyStore::SyncSharedMap()
+{
+    if (!sharedMap || !sharedMap->IsUsable()) {
+        return;
+    }
+    uint32_t changes = sharedMap->GetChangeCount();
+    if (changes == sharedChangeCount) {
+        return;
+    }
+    /* Taken before copying, writes made while the slots are copied are picked up next time */
+    sharedChangeCount = changes;
+
+    /*
+     * A slot whose key was deleted can be reused for another key. The key it held before is
+     * removed, but it may have been added again to another slot, so all removals are done
+     * before any additions.
+     */
+    std::vector<qcc::GUID128> removed;
+    std::vector<std::pair<qcc::GUID128, KeyRecord> > added;
+    std::vector<uint8_t> record;
+    for (uint32_t slot = 0; slot < SharedKeyMap::NUM_SLOTS; ++slot) {
+        if (sharedMap->GetVersion(slot) == sharedVersions[slot]) {
+            continue;
+        }
+        uint32_t version;
+        qcc::GUID128 guid;
+        bool deleted;
+        QStatus status = sharedMap->ReadSlot(slot, version, guid, deleted, record);
+        if (status == ER_BUS_KEY_UNAVAILABLE) {
+            continue;
+        }
+        if (status != ER_OK) {
+            /* Try this slot again on the next call */
+            QCC_LogError(status, ("Shared key map slot %u is locked", slot));
+            sharedChangeCount = changes - 1;
+            continue;
+        }
+        sharedVersions[slot] = version;
+        std::map<uint32_t, qcc::GUID128>::iterator prev = sharedSlotKeys.find(slot);
+        if ((prev != sharedSlotKeys.end()) && (prev->second != guid)) {
+            removed.push_back(prev->second);
+        }
+        sharedSlotKeys[slot] = guid;
+        if (deleted) {
+            QCC_DbgPrintf(("KeyStore::SyncSharedMap deleting %s", guid.ToString().c_str()));
+            removed.push_back(guid);
+            continue;
+        }
+        size_t len = record.size();
+        KeyBlob nonce = SharedMapNonce(sharedMap->GetEpoch(), slot, version);
+        Crypto_AES aes(*keyStoreKey, Crypto_AES::CCM);
+        status = (len > 16) ? aes.Decrypt_CCM(&record[0], &record[0], len, nonce, NULL, 0, 16) : ER_BUS_CORRUPT_KEYSTORE;
+        KeyRecord keyRec;
+        if (status == ER_OK) {
+            StringSource strSource(&record[0], len);
+            size_t pulled;
+            status = strSource.PullBytes(&keyRec.revision, sizeof(keyRec.revision), pulled);
+            if (status == ER_OK) {
+                status = keyRec.key.Load(strSource);
+            }
+            if (status == ER_OK) {
+                status = strSource.PullBytes(&keyRec.accessRights, sizeof(keyRec.accessRights), pulled);
+            }
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Discarding corrupt shared key map record for %s", guid.ToString().c_str()));
+            continue;
+        }
+        QCC_DbgPrintf(("KeyStore::SyncSharedMap rev:%d %s", keyRec.revision, guid.ToString().c_str()));
+        added.push_back(std::pair<qcc::GUID128, KeyRecord>(guid, keyRec));
+    }
+    for (size_t i = 0; i < removed.size(); ++i) {
+        keys->erase(removed[i]);
+        deletions.erase(removed[i]);
+    }
+    for (size_t i = 0; i < added.size(); ++i) {
+        (*keys)[added[i].first] = added[i].second;
+        deletions.erase(added[i].first);
+    }
+}
+
+void KeyStore::PublishToSharedMap(const qcc::GUID128& guid, KeyRecord* keyRec)
+{
+    if (!sharedMap || !sharedMap->IsUsable()) {
+        return;
+    }
+    StringSink strSink;
+    if (keyRec) {
+        size_t pushed;
+        strSink.PushBytes(&keyRec->revision, sizeof(keyRec->revision), pushed);
+        keyRec->key.Store(strSink);
+        strSink.PushBytes(&keyRec->accessRights, sizeof(keyRec->accessRights), pushed);
+    }
+    /* Copying in under the write lock means no change made by another process is overwritten unseen */
+    sharedMap->LockForWrite();
+    SyncSharedMap();
+    uint32_t slot;
+    QStatus status = sharedMap->FindSlot(guid, slot);
+    if (status == ER_OK) {
+        uint32_t version = sharedMap->GetNextVersion(slot);
+        uint32_t written;
+        if (keyRec) {
+            size_t len = strSink.GetString().size();
+            std::vector<uint8_t> record(len + 16);
+            KeyBlob nonce = SharedMapNonce(sharedMap->GetEpoch(), slot, version);
+            Crypto_AES aes(*keyStoreKey, Crypto_AES::CCM);
+            status = aes.Encrypt_CCM(strSink.GetString().data(), &record[0], len, nonce, NULL, 0, 16);
+            written = (status == ER_OK) ? sharedMap->WriteSlot(slot, guid, &record[0], len) : 0;
+        } else {
+            written = sharedMap->WriteSlot(slot, guid, NULL, 0);
+        }
+        if (written) {
+            sharedVersions[slot] = written;
+            sharedSlotKeys[slot] = guid;
+        }
+    }
+    sharedMap->UnlockForWrite();
+    if (!sharedMap->IsUsable()) {
+        QCC_LogError(ER_RESOURCES, ("Shared key map %s is full, reloading the key store instead", sharedMapFile.c_str()));
+    }
+}
+
 size_t KeyStore::EraseExpiredKeys()
 {
     size_t count = 0;
@@ -452,10 +693,20 @@ ExitPull:
 
 QStatus KeyStore::Clear()
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
     lock.Lock(MUTEX_CONTEXT);
+    if (sharedMap) {
+        std::vector<qcc::GUID128> guids;
+        for (KeyMap::iterator it = keys->begin(); it != keys->end(); ++it) {
+            guids.push_back(it->first);
+        }
+        for (size_t i = 0; i < guids.size(); ++i) {
+            PublishToSharedMap(guids[i], NULL);
+        }
+    }
     keys->clear();
     storeState = MODIFIED;
     revision = 0;
@@ -469,6 +720,13 @@ QStatus KeyStore::Reload()
 {
     QCC_DbgHLPrintf(("KeyStore::Reload"));
 
+    /*
+     * A deferred load reads the current contents so there is nothing more to reload
+     */
+    if (loadPending) {
+        return LoadIfPending();
+    }
+
     /*
      * Cannot reload if the key store has never been loaded
      */
@@ -482,7 +740,15 @@ QStatus KeyStore::Reload()
         return ER_OK;
     }
 
+    /*
+     * With a shared key map only the keys that other processes changed are copied
+     */
     lock.Lock(MUTEX_CONTEXT);
+    if (sharedMap && sharedMap->IsUsable()) {
+        SyncSharedMap();
+        lock.Unlock(MUTEX_CONTEXT);
+        return ER_OK;
+    }
     QStatus status;
     uint32_t currentRevision = revision;
     KeyMap* currentKeys = keys;
@@ -575,9 +841,14 @@ QStatus KeyStore::Push(Sink& sink)
     }
     /*
      * Second two bytes are the key store revision number. The revision number is incremented each
-     * time the key store is stored.
+     * time the key store is stored. With a shared key map the file is not reloaded before it is
+     * stored so our revision may be stale, the map hands out revisions no other process has used.
      */
-    ++revision;
+    if (sharedMap && sharedMap->IsUsable()) {
+        revision = sharedMap->ReserveRevision(revision);
+    } else {
+        ++revision;
+    }
     status = sink.PushBytes(&revision, sizeof(revision), pushed);
     if (status != ER_OK) {
         goto ExitPush;
@@ -627,11 +898,13 @@ ExitPush:
 
 QStatus KeyStore::GetKey(const qcc::GUID128& guid, KeyBlob& key, uint8_t accessRights[4])
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
     QStatus status;
     lock.Lock(MUTEX_CONTEXT);
+    SyncSharedMap();
     QCC_DbgPrintf(("KeyStore::GetKey %s", guid.ToString().c_str()));
     if (keys->find(guid) != keys->end()) {
         KeyRecord& keyRec = (*keys)[guid];
@@ -648,11 +921,13 @@ QStatus KeyStore::GetKey(const qcc::GUID128& guid, KeyBlob& key, uint8_t accessR
 
 bool KeyStore::HasKey(const qcc::GUID128& guid)
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return false;
     }
     bool hasKey;
     lock.Lock(MUTEX_CONTEXT);
+    SyncSharedMap();
     hasKey = keys->count(guid) != 0;
     lock.Unlock(MUTEX_CONTEXT);
     return hasKey;
@@ -660,16 +935,19 @@ bool KeyStore::HasKey(const qcc::GUID128& guid)
 
 QStatus KeyStore::AddKey(const qcc::GUID128& guid, const KeyBlob& key, const uint8_t accessRights[4])
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
     lock.Lock(MUTEX_CONTEXT);
     QCC_DbgPrintf(("KeyStore::AddKey %s", guid.ToString().c_str()));
-    KeyRecord& keyRec = (*keys)[guid];
+    KeyRecord keyRec;
     keyRec.revision = revision + 1;
     keyRec.key = key;
     QCC_DbgPrintf(("AccessRights %1x%1x%1x%1x", accessRights[0], accessRights[1], accessRights[2], accessRights[3]));
     memcpy(&keyRec.accessRights, accessRights, sizeof(uint8_t) * 4);
+    PublishToSharedMap(guid, &keyRec);
+    (*keys)[guid] = keyRec;
     storeState = MODIFIED;
     deletions.erase(guid);
     lock.Unlock(MUTEX_CONTEXT);
@@ -678,11 +956,13 @@ QStatus KeyStore::AddKey(const qcc::GUID128& guid, const KeyBlob& key, const uin
 
 QStatus KeyStore::DelKey(const qcc::GUID128& guid)
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
     lock.Lock(MUTEX_CONTEXT);
     QCC_DbgPrintf(("KeyStore::DelKey %s", guid.ToString().c_str()));
+    PublishToSharedMap(guid, NULL);
     keys->erase(guid);
     storeState = MODIFIED;
     deletions.insert(guid);
@@ -693,14 +973,19 @@ QStatus KeyStore::DelKey(const qcc::GUID128& guid)
 
 QStatus KeyStore::SetKeyExpiration(const qcc::GUID128& guid, const Timespec& expiration)
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
     QStatus status = ER_OK;
     lock.Lock(MUTEX_CONTEXT);
     QCC_DbgPrintf(("KeyStore::SetExpiration %s", guid.ToString().c_str()));
+    SyncSharedMap();
     if (keys->count(guid) != 0) {
-        (*keys)[guid].key.SetExpiration(expiration);
+        KeyRecord keyRec = (*keys)[guid];
+        keyRec.key.SetExpiration(expiration);
+        PublishToSharedMap(guid, &keyRec);
+        (*keys)[guid] = keyRec;
         storeState = MODIFIED;
     } else {
         status = ER_BUS_KEY_UNAVAILABLE;
@@ -714,6 +999,7 @@ QStatus KeyStore::SetKeyExpiration(const qcc::GUID128& guid, const Timespec& exp
 
 QStatus KeyStore::GetKeyExpiration(const qcc::GUID128& guid, Timespec& expiration)
 {
+    LoadIfPending();
     if (storeState == UNAVAILABLE) {
         return ER_BUS_KEYSTORE_NOT_LOADED;
     }
@@ -27,6 +27,7 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include <qcc/platform.h>
 
@@ -46,6 +47,8 @@
 
 namespace ajn {
 
+class SharedKeyMap;
+
 /**
  * The %KeyStore class manages the storing and loading of key blobs from
  * external storage.
@@ -74,14 +77,19 @@ class KeyStore {
     QStatus Init(const char* fileName, bool isShared);
 
     /**
-     * Requests the key store listener to store the contents of the key store
+     * Requests the key store listener to store the contents of the key store. Concurrent calls are
+     * serialized and a call that finds its changes were already written by a store that ran while
+     * it was waiting returns without storing again, so changes made by several threads at once,
+     * for example by concurrent authentications, are written together.
      */
     QStatus Store();
 
     /**
      * Re-read keys from the key store. This is a no-op unless the key store is shared.
      * If the key store is shared the key store is reloaded merging any changes made by
-     * other applications with changes made by the calling application.
+     * other applications with changes made by the calling application. If the shared key map is
+     * enabled (ALLJOYN_KEYSTORE_SHARED_MAP=1) only the keys other applications changed are copied
+     * from the map and the file is not read.
      *
      * @return
      *      - ER_OK if successful
@@ -183,6 +191,7 @@ class KeyStore {
      */
     QStatus GetGuid(qcc::GUID128& guid)
     {
+        LoadIfPending();
         if (storeState == UNAVAILABLE) {
             return ER_BUS_KEY_STORE_NOT_LOADED;
         } else {
@@ -196,7 +205,7 @@ class KeyStore {
      *
      * @return  Returns the hex-encode string for the GUID or an empty string if the key store is not loaded.
      */
-    qcc::String GetGuid() {  return (storeState == UNAVAILABLE) ? "" : thisGuid.ToString(); }
+    qcc::String GetGuid() {  LoadIfPending(); return (storeState == UNAVAILABLE) ? "" : thisGuid.ToString(); }
 
     /**
      * Override the default listener so the application can provide the load and store
@@ -290,6 +299,21 @@ class KeyStore {
      */
     QStatus Load();
 
+    /**
+     * Perform the load deferred by Init() if it has not happened yet
+     */
+    QStatus LoadIfPending();
+
+    /**
+     * Open the shared key map once the key store has been loaded
+     */
+    void OpenSharedMap();
+
+    /**
+     * Copy the keys other processes changed in the shared key map. Must be called holding lock.
+     */
+    void SyncSharedMap();
+
     /**
      * The application that owns this key store. If the key store is shared this will be the name
      * of a suite of applications.
@@ -321,6 +345,15 @@ class KeyStore {
      */
     typedef std::map<qcc::GUID128, KeyRecord> KeyMap;
 
+    /**
+     * Write a key to the shared key map so other processes see it. Must be called holding lock
+     * and before the change is made to keys since other changes are copied in first.
+     *
+     * @param guid    The unique identifier for the key
+     * @param keyRec  The key record, NULL if the key is being deleted
+     */
+    void PublishToSharedMap(const qcc::GUID128& guid, KeyRecord* keyRec);
+
     /**
      * In memory copy of the key store
      */
@@ -351,6 +384,21 @@ class KeyStore {
      */
     qcc::Mutex lock;
 
+    /**
+     * Mutex that serializes calls to Store(), always acquired before lock
+     */
+    qcc::Mutex storeLock;
+
+    /**
+     * Mutex that serializes the deferred load, always acquired before lock
+     */
+    qcc::Mutex loadLock;
+
+    /**
+     * True if Init() has been called but the key store has not been loaded yet
+     */
+    volatile bool loadPending;
+
     /**
      * Key for encrypting/decrypting the key store.
      */
@@ -375,6 +423,31 @@ class KeyStore {
      * Event for synchronizing load requests
      */
     qcc::Event* loaded;
+
+    /**
+     * Name of the shared key map file, empty unless the shared key map was requested
+     */
+    qcc::String sharedMapFile;
+
+    /**
+     * Shared memory through which processes sharing the key store see each other's changes
+     */
+    SharedKeyMap* sharedMap;
+
+    /**
+     * Change count of the shared key map when it was last copied
+     */
+    uint32_t sharedChangeCount;
+
+    /**
+     * Version of each slot of the shared key map when it was last copied
+     */
+    std::vector<uint32_t> sharedVersions;
+
+    /**
+     * The key each slot of the shared key map held when it was last copied
+     */
+    std::map<uint32_t, qcc::GUID128> sharedSlotKeys;
 };
 
 }
@@ -0,0 +1,204 @@
+/**
+ * @file
+ * Latency histograms for the stages a message goes through on its way through a remote endpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#if defined(QCC_OS_GROUP_WINDOWS) || defined(QCC_OS_GROUP_WINRT)
+#include <windows.h>
+#elif defined(QCC_OS_DARWIN)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include <qcc/atomic.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include "LatencyHistogram.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+uint64_t GetLatencyClock()
+{
+    uint64_t usecs;
+#if defined(QCC_OS_GROUP_WINDOWS) || defined(QCC_OS_GROUP_WINRT)
+    static LARGE_INTEGER freq = { 0 };
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    usecs = static_cast<uint64_t>((now.QuadPart / freq.QuadPart) * 1000000 + ((now.QuadPart % freq.QuadPart) * 1000000) / freq.QuadPart);
+#elif defined(QCC_OS_DARWIN)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    usecs = ((mach_absolute_time() * timebase.numer) / timebase.denom) / 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    usecs = static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+    /* 0 means "not recorded" */
+    return usecs ? usecs : 1;
+}
+
+void LatencyHistogram::Reset()
+{
+    for (uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] = 0;
+    }
+    count = 0;
+    maxValue = 0;
+}
+
+uint32_t LatencyHistogram::BucketIndex(uint32_t value)
+{
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    /* Position of the most significant bit, at least 3 because value >= SUB_BUCKETS */
+    uint32_t msb = 0;
+#if defined(__GNUC__)
+    msb = 31 - __builtin_clz(value);
+#else
+    for (uint32_t v = value; v >>= 1;) {
+        ++msb;
+    }
+#endif
+    uint32_t sub = (value >> (msb - 3)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + (msb - 3) * SUB_BUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::BucketUpperBound(uint32_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    uint32_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    uint32_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    uint32_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + ((1u << shift) - 1);
+}
+
+void LatencyHistogram::Record(uint32_t usecs)
+{
+    IncrementAndFetch(&buckets[BucketIndex(usecs)]);
+    IncrementAndFetch(&count);
+    if (usecs > maxValue) {
+        maxValue = usecs;
+    }
+}
+
+uint32_t LatencyHistogram::GetPercentile(uint32_t permille) const
+{
+    uint64_t total = static_cast<uint32_t>(count);
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (total * permille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += static_cast<uint32_t>(buckets[i]);
+        if (seen >= rank) {
+            uint32_t bound = BucketUpperBound(i);
+            return (bound < maxValue) ? bound : maxValue;
+        }
+    }
+    /* Only reached if a concurrent Record() has bumped count before its bucket */
+    return maxValue;
+}
+
+volatile bool LatencyStats::enabled = false;
+
+LatencyHistogram LatencyStats::histograms[LatencyStats::NUM_STAGES][LatencyStats::NUM_ENDPOINT_CLASSES];
+
+void LatencyStats::Record(Stage stage, bool bus2bus, uint64_t start, uint64_t end)
+{
+    if (start == 0) {
+        return;
+    }
+    uint64_t usecs = (end > start) ? (end - start) : 0;
+    histograms[stage][bus2bus ? ENDPOINT_BUS2BUS : ENDPOINT_CLIENT].Record((usecs > 0xFFFFFFFF) ? 0xFFFFFFFF : static_cast<uint32_t>(usecs));
+}
+
+const char* LatencyStats::StageText(Stage stage)
+{
+    switch (stage) {
+    case STAGE_ROUTE:
+        return "route";
+
+    case STAGE_QUEUE:
+        return "queue";
+
+    case STAGE_WRITE:
+        return "write";
+
+    case STAGE_TOTAL:
+        return "total";
+
+    default:
+        return "unknown";
+    }
+}
+
+const char* LatencyStats::EndpointClassText(EndpointClass epClass)
+{
+    return (epClass == ENDPOINT_BUS2BUS) ? "bus2bus" : "client";
+}
+
+void LatencyStats::Reset()
+{
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        for (int c = 0; c < NUM_ENDPOINT_CLASSES; ++c) {
+            histograms[s][c].Reset();
+        }
+    }
+}
+
+qcc::String LatencyStats::ToString()
+{
+    qcc::String str;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        for (int c = 0; c < NUM_ENDPOINT_CLASSES; ++c) {
+            const LatencyHistogram& h = histograms[s][c];
+            str += StageText(static_cast<Stage>(s));
+            str += "/";
+            str += EndpointClassText(static_cast<EndpointClass>(c));
+            str += ": count=" + U32ToString(h.GetCount());
+            str += " p50=" + U32ToString(h.GetPercentile(500));
+            str += "us p90=" + U32ToString(h.GetPercentile(900));
+            str += "us p99=" + U32ToString(h.GetPercentile(990));
+            str += "us max=" + U32ToString(h.GetMax());
+            str += "us\n";
+        }
+    }
+    return str;
+}
+
+}
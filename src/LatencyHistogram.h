@@ -0,0 +1,189 @@
+#ifndef _ALLJOYN_LATENCYHISTOGRAM_H
+#define _ALLJOYN_LATENCYHISTOGRAM_H
+/**
+ * @file
+ * Latency histograms for the stages a message goes through on its way through a remote endpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include LatencyHistogram.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+
+namespace ajn {
+
+/**
+ * Get the current time of the clock used for latency measurements.
+ *
+ * @return  Monotonic time in microseconds. Never 0 so 0 can mean "not recorded".
+ */
+uint64_t GetLatencyClock();
+
+/**
+ * LatencyHistogram counts latencies in log-linear buckets: each power of two range is split
+ * into SUB_BUCKETS equal buckets so a reported percentile is within 1/SUB_BUCKETS of the true
+ * value whatever its magnitude. Recording is lock-free so any number of threads may record into
+ * the same histogram. Reads are not synchronized with recording and may be slightly stale.
+ */
+class LatencyHistogram {
+  public:
+
+    /** Number of buckets each power of two range is split into */
+    static const uint32_t SUB_BUCKETS = 8;
+
+    /** Total number of buckets, enough for any 32 bit latency */
+    static const uint32_t NUM_BUCKETS = SUB_BUCKETS + (32 - 3) * SUB_BUCKETS;
+
+    /**
+     * Constructor
+     */
+    LatencyHistogram() { Reset(); }
+
+    /**
+     * Record a latency.
+     *
+     * @param usecs   Latency in microseconds.
+     */
+    void Record(uint32_t usecs);
+
+    /**
+     * @return  The number of latencies recorded.
+     */
+    uint32_t GetCount() const { return static_cast<uint32_t>(count); }
+
+    /**
+     * @return  The largest latency recorded.
+     */
+    uint32_t GetMax() const { return maxValue; }
+
+    /**
+     * Get a percentile.
+     *
+     * @param permille   The percentile in tenths of a percent, e.g. 990 for the 99th percentile.
+     *
+     * @return  The upper bound of the bucket holding the percentile (never more than GetMax()),
+     *          0 if nothing has been recorded.
+     */
+    uint32_t GetPercentile(uint32_t permille) const;
+
+    /**
+     * Clear all recorded latencies.
+     */
+    void Reset();
+
+  private:
+
+    /** Index of the bucket that counts a value */
+    static uint32_t BucketIndex(uint32_t value);
+
+    /** Largest value counted by a bucket */
+    static uint32_t BucketUpperBound(uint32_t index);
+
+    volatile int32_t buckets[NUM_BUCKETS];   /**< Counts (atomically incremented) */
+    volatile int32_t count;                  /**< Total count (atomically incremented) */
+    uint32_t maxValue;                       /**< Largest value, updates may race so this is approximate */
+};
+
+/**
+ * Daemon-wide latency histograms for each message routing stage, kept separately for client
+ * and bus-to-bus endpoints. Recording is disabled by default; when disabled the only cost on the
+ * message path is a test of a flag.
+ */
+class LatencyStats {
+  public:
+
+    /** Message routing stages */
+    enum Stage {
+        STAGE_ROUTE,  /**< From unmarshal on the receiving endpoint until the router has pushed the message to every destination */
+        STAGE_QUEUE,  /**< Time spent in the transmit queue of the sending endpoint */
+        STAGE_WRITE,  /**< From leaving the transmit queue until the message has been completely written */
+        STAGE_TOTAL,  /**< From unmarshal on the receiving endpoint until completely written by the sending endpoint */
+        NUM_STAGES
+    };
+
+    /** The kinds of endpoint the stages are measured on */
+    enum EndpointClass {
+        ENDPOINT_CLIENT,   /**< Endpoints connecting a client to this daemon */
+        ENDPOINT_BUS2BUS,  /**< Endpoints connecting this daemon to another daemon */
+        NUM_ENDPOINT_CLASSES
+    };
+
+    /**
+     * @return  true if latencies are being recorded.
+     */
+    static bool IsEnabled() { return enabled; }
+
+    /**
+     * Enable or disable recording of latencies.
+     *
+     * @param enable   true to record latencies.
+     */
+    static void Enable(bool enable) { enabled = enable; }
+
+    /**
+     * Record the latency of a stage.
+     *
+     * @param stage    The stage.
+     * @param bus2bus  true if the stage was measured on a bus-to-bus endpoint.
+     * @param start    Latency clock time at which the stage started, nothing is recorded if 0.
+     * @param end      Latency clock time at which the stage ended.
+     */
+    static void Record(Stage stage, bool bus2bus, uint64_t start, uint64_t end);
+
+    /**
+     * Get the histogram for a stage.
+     *
+     * @param stage     The stage.
+     * @param epClass   The kind of endpoint.
+     */
+    static const LatencyHistogram& Get(Stage stage, EndpointClass epClass) { return histograms[stage][epClass]; }
+
+    /**
+     * @return  The name of a stage.
+     */
+    static const char* StageText(Stage stage);
+
+    /**
+     * @return  The name of a kind of endpoint.
+     */
+    static const char* EndpointClassText(EndpointClass epClass);
+
+    /**
+     * Clear all histograms.
+     */
+    static void Reset();
+
+    /**
+     * Format the count, median, 90th and 99th percentiles and maximum of every histogram.
+     *
+     * @return  One line of text per stage and kind of endpoint.
+     */
+    static qcc::String ToString();
+
+  private:
+    static volatile bool enabled;
+    static LatencyHistogram histograms[NUM_STAGES][NUM_ENDPOINT_CLASSES];
+};
+
+}
+
+#endif
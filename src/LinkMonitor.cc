@@ -0,0 +1,151 @@
+/**
+ * @file
+ * LinkMonitor detects remote endpoints that have gone quiet for longer than their link timeout.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/time.h>
+
+#include "LinkMonitor.h"
+#include "RemoteEndpoint.h"
+#include "TimerSlack.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+/*
+ * Link timeouts are in seconds so a coarse tick keeps the wheel small
+ */
+static const uint32_t TICK_MS = 100;
+
+LinkMonitor::LinkMonitor() :
+    wheel(GetTimestamp64(), TICK_MS),
+    timer("linkMonitor", true),
+    alarmTime(0),
+    started(false)
+{
+}
+
+LinkMonitor::~LinkMonitor()
+{
+    timer.Stop();
+    timer.Join();
+    lock.Lock(MUTEX_CONTEXT);
+    vector<TimingWheel::Entry*> removed;
+    wheel.RemoveAll(removed);
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus LinkMonitor::Watch(Link& link, uint32_t interval)
+{
+    QStatus status = ER_OK;
+    lock.Lock(MUTEX_CONTEXT);
+    if (!started) {
+        status = timer.Start();
+        started = (status == ER_OK);
+    }
+    if (status == ER_OK) {
+        link.interval = interval;
+        wheel.Insert(link, GetTimestamp64() + interval);
+        status = Arm();
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+void LinkMonitor::Unwatch(Link& link)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    wheel.Remove(link);
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus LinkMonitor::Arm()
+{
+    QStatus status = ER_OK;
+    uint64_t when;
+    /*
+     * An alarm that is already armed for an earlier time will re-arm for this slot when it fires
+     * so only an earlier expiry needs a new alarm.
+     */
+    if (wheel.NextExpiry(when) && (!alarmTime || (when < alarmTime))) {
+        if (alarmTime) {
+            timer.RemoveAlarm(alarm, false /* don't block if alarm in progress */);
+        }
+        uint64_t now = GetTimestamp64();
+        uint32_t relative = TimerSlack::Coalesce((when > now) ? static_cast<uint32_t>(when - now) : 0);
+        uint32_t zero = 0;
+        AlarmListener* listener = this;
+        alarm = Alarm(relative, listener, NULL, zero);
+        status = timer.AddAlarm(alarm);
+        alarmTime = (status == ER_OK) ? (now + relative) : 0;
+    }
+    return status;
+}
+
+void LinkMonitor::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    if (reason != ER_OK) {
+        return;
+    }
+    vector<TimingWheel::Entry*> expired;
+    vector<RemoteEndpoint> idle;
+
+    lock.Lock(MUTEX_CONTEXT);
+    if (alarm == this->alarm) {
+        alarmTime = 0;
+    }
+    uint64_t now = GetTimestamp64();
+    wheel.Advance(now, expired);
+    /*
+     * A link that received something since it was scheduled is pushed back to a full interval
+     * after its last receive without involving the endpoint. Endpoints unwatch their link before
+     * they are unregistered from the router so the references taken here are always to live
+     * endpoints.
+     */
+    uint32_t timestamp = GetTimestamp();
+    for (vector<TimingWheel::Entry*>::iterator it = expired.begin(); it != expired.end(); ++it) {
+        Link* link = static_cast<Link*>(*it);
+        uint32_t quiet = timestamp - link->lastRx;
+        if (quiet < link->interval) {
+            wheel.Insert(*link, now + (link->interval - quiet));
+        } else {
+            idle.push_back(RemoteEndpoint::wrap(link->endpoint));
+        }
+    }
+    QStatus status = Arm();
+    lock.Unlock(MUTEX_CONTEXT);
+
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to re-arm link monitor alarm"));
+    }
+    for (vector<RemoteEndpoint>::iterator it = idle.begin(); it != idle.end(); ++it) {
+        (*it)->LinkIdle();
+    }
+}
+
+}
@@ -0,0 +1,132 @@
+#ifndef _ALLJOYN_LINKMONITOR_H
+#define _ALLJOYN_LINKMONITOR_H
+/**
+ * @file
+ * LinkMonitor detects remote endpoints that have gone quiet for longer than their link timeout.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include LinkMonitor.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/Mutex.h>
+#include <qcc/Timer.h>
+#include <qcc/time.h>
+
+#include <alljoyn/Status.h>
+
+#include "TimingWheel.h"
+
+namespace ajn {
+
+class _RemoteEndpoint;
+
+/**
+ * LinkMonitor keeps the link timeouts of all of a bus attachment's remote endpoints on one
+ * timing wheel serviced by a single alarm. Receiving a message only records the time so there
+ * is no timer work per message. When a link's timeout expires the monitor checks when the link
+ * last received anything; if that was recent enough the link is simply rescheduled, otherwise
+ * the endpoint is told the link is idle so it can probe it. The cost of idle link maintenance is
+ * therefore proportional to the number of timeouts that expire rather than to the number of
+ * endpoints or messages.
+ */
+class LinkMonitor : public qcc::AlarmListener {
+  public:
+
+    /**
+     * Link timeout state, embedded in the endpoint that owns it.
+     */
+    class Link : public TimingWheel::Entry {
+        friend class LinkMonitor;
+      public:
+        /**
+         * Constructor
+         *
+         * @param endpoint  The endpoint told when this link is idle.
+         */
+        Link(_RemoteEndpoint* endpoint) : endpoint(endpoint), lastRx(0), interval(0) { }
+
+        /**
+         * Record that something was received on the link. This is just a store so it is cheap
+         * enough to be called for every message.
+         */
+        void Alive() { lastRx = qcc::GetTimestamp(); }
+
+      private:
+        _RemoteEndpoint* endpoint;   /**< The endpoint that owns the link */
+        volatile uint32_t lastRx;    /**< Timestamp of the last receive */
+        uint32_t interval;           /**< Milliseconds without a receive that make the link idle */
+    };
+
+    /**
+     * Constructor
+     */
+    LinkMonitor();
+
+    /**
+     * Destructor
+     */
+    ~LinkMonitor();
+
+    /**
+     * Start monitoring a link or change the timeout of a link that is already monitored. The
+     * endpoint's LinkIdle() is called once the link has received nothing for interval
+     * milliseconds, counted from now or from the last receive, whichever is later.
+     *
+     * @param link      The link to monitor.
+     * @param interval  The link timeout in milliseconds.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Watch(Link& link, uint32_t interval);
+
+    /**
+     * Stop monitoring a link. Once this returns LinkIdle() will not be called for the link
+     * unless it is watched again.
+     *
+     * @param link  The link.
+     */
+    void Unwatch(Link& link);
+
+  private:
+
+    /* Copying is not allowed */
+    LinkMonitor(const LinkMonitor& other);
+    LinkMonitor& operator=(const LinkMonitor& other);
+
+    /**
+     * Make sure the alarm is armed for the next slot that holds a link timeout. Must be called
+     * with lock held.
+     */
+    QStatus Arm();
+
+    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+    qcc::Mutex lock;          /**< Protects the wheel and the alarm */
+    TimingWheel wheel;        /**< Link timeouts */
+    qcc::Timer timer;         /**< Services the alarm */
+    qcc::Alarm alarm;         /**< The single alarm that advances wheel */
+    uint64_t alarmTime;       /**< Absolute time the alarm is armed for or 0 if not armed */
+    bool started;             /**< True once the timer has been started */
+};
+
+}
+
+#endif
@@ -22,14 +22,21 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 
+#include <algorithm>
+#include <deque>
 #include <list>
+#include <map>
+#include <vector>
 
 #include <qcc/Debug.h>
+#include <qcc/Event.h>
 #include <qcc/GUID.h>
+#include <qcc/Mutex.h>
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 #include <qcc/Thread.h>
 #include <qcc/atomic.h>
+#include <qcc/time.h>
 
 #include <alljoyn/DBusStd.h>
 #include <alljoyn/AllJoynStd.h>
@@ -39,11 +46,13 @@
 
 #include "LocalTransport.h"
 #include "Router.h"
+#include "AtomTable.h"
 #include "MethodTable.h"
 #include "SignalTable.h"
 #include "AllJoynPeerObj.h"
 #include "BusUtil.h"
 #include "BusInternal.h"
+#include "ThreadScheduling.h"
 
 #define QCC_MODULE "LOCAL_TRANSPORT"
 
@@ -55,23 +64,99 @@ namespace ajn {
 
 static const uint32_t LOCAL_ENDPOINT_CONCURRENCY = 4;
 
+/* Number of messages that may wait for a dispatcher thread before senders are held up */
+static const size_t LOCAL_ENDPOINT_MAX_PENDING = 10;
 
-class _LocalEndpoint::Dispatcher : public qcc::Timer, public qcc::AlarmListener {
+/*
+ * The dispatcher hands received messages to a small pool of threads. Handlers are called one at
+ * a time unless a handler calls EnableReentrancy() to let the other threads run while it blocks.
+ */
+class _LocalEndpoint::Dispatcher {
   public:
-    Dispatcher(_LocalEndpoint* endpoint, uint32_t concurrency = LOCAL_ENDPOINT_CONCURRENCY) : Timer("lepDisp", true, concurrency, true, 10), AlarmListener(), endpoint(endpoint) { }
+    Dispatcher(_LocalEndpoint* endpoint, uint32_t concurrency = LOCAL_ENDPOINT_CONCURRENCY) :
+        endpoint(endpoint), concurrency(concurrency ? concurrency : 1), running(false) { }
+
+    ~Dispatcher();
+
+    QStatus Start();
+    QStatus Stop();
+    QStatus Join();
+
     QStatus DispatchMessage(Message& msg);
 
-    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+    /*
+     * Dispatch a method call to an object that serializes its method calls. Calls to the same
+     * object are delivered in order on one thread at a time without holding up other objects.
+     */
+    QStatus DispatchSerialized(Message& msg);
+
+    /*
+     * Report object registrations on a dispatcher thread.
+     */
+    QStatus DispatchDeferredCallbacks();
+
+    /*
+     * Let the other dispatcher threads run while the calling handler blocks.
+     */
+    void EnableReentrancy();
+
+    /*
+     * Check if the calling thread is a dispatcher thread that has not enabled reentrancy.
+     */
+    bool ThreadHoldsLock();
 
   private:
+
+    /* One unit of work for the dispatcher threads */
+    struct Task {
+        enum Kind {
+            DISPATCH,    /* Deliver msg */
+            SERIALIZED,  /* Deliver the pending calls to the object msg was sent to */
+            CALLBACKS    /* Run the endpoint's deferred callbacks, msg is unused */
+        };
+        Task(Kind kind, const Message& msg) : kind(kind), msg(msg), queuedAt(0) { }
+        Kind kind;
+        Message msg;
+        uint64_t queuedAt;  /* Latency clock time at which the task was queued, 0 unless handlers are profiled */
+    };
+
+    class Worker : public qcc::Thread {
+      public:
+        Worker(Dispatcher* dispatcher) : qcc::Thread("lepDisp"), holdsLock(false), dispatcher(dispatcher) { }
+        bool holdsLock;  /* True while this thread holds the dispatcher's reentrancy lock */
+      protected:
+        qcc::ThreadReturn STDCALL Run(void* arg) { dispatcher->WorkerRun(this); return 0; }
+      private:
+        Dispatcher* dispatcher;
+    };
+
+    QStatus Enqueue(const Task& task);
+    void WorkerRun(Worker* worker);
+    void RunTask(const Task& task);
+    void DeliverSerialized(const qcc::String& path);
+    void DiscardSerialized(const qcc::String& path);
+    Worker* CurrentWorker();
+
     _LocalEndpoint* endpoint;
+    uint32_t concurrency;
+    std::vector<Worker*> workers;
+    qcc::Mutex reentrancyLock;                                /* Held by the thread that is calling a handler */
+
+    qcc::Mutex queueLock;                                     /* Protects queue and running */
+    std::deque<Task> queue;                                   /* Work waiting for a dispatcher thread */
+    qcc::Event workAvailable;                                 /* Set when work is added to an empty queue */
+    qcc::Event spaceAvailable;                                /* Set when the queue drops below its limit */
+    bool running;
+
+    qcc::Mutex serialLock;                                    /* Protects serialQueues */
+    std::map<qcc::String, std::deque<Task> > serialQueues;    /* Pending calls by object path, the front call is being handled */
 };
 
-class _LocalEndpoint::DeferredCallbacks : public qcc::AlarmListener {
+class _LocalEndpoint::DeferredCallbacks {
   public:
     DeferredCallbacks(_LocalEndpoint* ep) : endpoint(ep) { }
 
-    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+    void Run();
 
   private:
     _LocalEndpoint* endpoint;
@@ -109,15 +194,17 @@ bool LocalTransport::IsRunning()
     return !isStoppedEvent.IsSet();
 }
 
-class _LocalEndpoint::ReplyContext {
+/*
+ * A reply context is its own entry in the endpoint's reply wheel.
+ */
+class _LocalEndpoint::ReplyContext : public TimingWheel::Entry {
   public:
     ReplyContext(LocalEndpoint ep,
                  MessageReceiver* receiver,
                  MessageReceiver::ReplyHandler handler,
                  const InterfaceDescription::Member* method,
                  Message& methodCall,
-                 void* context,
-                 uint32_t timeout) :
+                 void* context) :
         ep(ep),
         receiver(receiver),
         handler(handler),
@@ -126,14 +213,6 @@ class _LocalEndpoint::ReplyContext {
         serial(methodCall->msgHeader.serialNum),
         context(context)
     {
-        uint32_t zero = 0;
-        void* tempContext = (void*)this;
-        AlarmListener* listener = ep.unwrap();
-        alarm = Alarm(timeout, listener, tempContext, zero);
-    }
-
-    ~ReplyContext() {
-        ep->replyTimer.RemoveAlarm(alarm, false /* don't block if alarm in progress */);
     }
 
     LocalEndpoint ep;                            /* The endpoint this reply context is associated with */
@@ -143,7 +222,6 @@ class _LocalEndpoint::ReplyContext {
     uint8_t callFlags;                           /* Flags from the method call */
     uint32_t serial;                             /* Serial number for the method reply */
     void* context;                               /* The calling object's context */
-    qcc::Alarm alarm;                            /* Alarm object for handling method call timeouts */
 
   private:
     ReplyContext(const ReplyContext& other);
@@ -160,6 +238,9 @@ _LocalEndpoint::_LocalEndpoint(BusAttachment& bus, uint32_t concurrency) :
     objectsLock(),
     replyMapLock(),
     replyTimer("replyTimer", true),
+    replyWheel(GetTimestamp64()),
+    wheelAlarmTime(0),
+    signalBatcher(new SignalBatcher(bus, replyTimer)),
     dbusObj(NULL),
     alljoynObj(NULL),
     alljoynDebugObj(NULL),
@@ -176,11 +257,16 @@ _LocalEndpoint::~_LocalEndpoint()
     if (bus) {
         running = false;
 
+        delete signalBatcher;
+        signalBatcher = NULL;
+
         /*
          * Delete any stale reply contexts
          */
         replyMapLock.Lock(MUTEX_CONTEXT);
-        for (map<uint32_t, ReplyContext*>::iterator iter = replyMap.begin(); iter != replyMap.end(); ++iter) {
+        vector<TimingWheel::Entry*> unscheduled;
+        replyWheel.RemoveAll(unscheduled);
+        for (unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.begin(); iter != replyMap.end(); ++iter) {
             QCC_DbgHLPrintf(("LocalEndpoint~LocalEndpoint deleting reply handler for serial %u", iter->second->serial));
             delete iter->second;
         }
@@ -299,6 +385,11 @@ QStatus _LocalEndpoint::Stop(void)
     /* Local endpoint not longer running */
     running = false;
 
+    /* Don't leave signals waiting for a batch that will never be sent */
+    if (signalBatcher) {
+        signalBatcher->Flush();
+    }
+
     if (peerObj) {
         peerObj->Stop();
     }
@@ -390,53 +481,291 @@ QStatus _LocalEndpoint::PeerInterface(Message& message)
 }
 
 
-QStatus _LocalEndpoint::Dispatcher::DispatchMessage(Message& msg)
+_LocalEndpoint::Dispatcher::~Dispatcher()
+{
+    Stop();
+    Join();
+}
+
+QStatus _LocalEndpoint::Dispatcher::Start()
 {
-    uint32_t zero = 0;
-    void* context = new Message(msg);
-    qcc::AlarmListener* localEndpointListener = this;
-    Alarm alarm(zero, localEndpointListener, context, zero);
-    QStatus status = AddAlarm(alarm);
+    QStatus status = ER_OK;
+    queueLock.Lock(MUTEX_CONTEXT);
+    if (running || !workers.empty()) {
+        queueLock.Unlock(MUTEX_CONTEXT);
+        return ER_OK;
+    }
+    running = true;
+    for (uint32_t i = 0; (status == ER_OK) && (i < concurrency); ++i) {
+        Worker* worker = new Worker(this);
+        workers.push_back(worker);
+        status = worker->Start();
+    }
+    queueLock.Unlock(MUTEX_CONTEXT);
     if (status != ER_OK) {
-        Message* temp = static_cast<Message*>(context);
-        if (temp) {
-            delete temp;
-        }
+        Stop();
+        Join();
     }
     return status;
 }
 
-void _LocalEndpoint::EnableReentrancy()
+QStatus _LocalEndpoint::Dispatcher::Stop()
 {
-    if (dispatcher) {
-        dispatcher->EnableReentrancy();
+    queueLock.Lock(MUTEX_CONTEXT);
+    running = false;
+    /* Work that has not reached a dispatcher thread is dropped just like an expired alarm */
+    while (!queue.empty()) {
+        if (queue.front().kind == Task::SERIALIZED) {
+            DiscardSerialized(queue.front().msg->GetObjectPath());
+        }
+        queue.pop_front();
+    }
+    workAvailable.SetEvent();
+    spaceAvailable.SetEvent();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->Stop();
     }
+    queueLock.Unlock(MUTEX_CONTEXT);
+    return ER_OK;
 }
 
-bool _LocalEndpoint::IsReentrantCall()
+QStatus _LocalEndpoint::Dispatcher::Join()
 {
-    if (!dispatcher) {
-        return false;
+    /* Join can be called from one of our own handlers during shutdown */
+    queueLock.Lock(MUTEX_CONTEXT);
+    Worker* self = CurrentWorker();
+    std::vector<Worker*> joining = workers;
+    queueLock.Unlock(MUTEX_CONTEXT);
+
+    for (size_t i = 0; i < joining.size(); ++i) {
+        if (joining[i] != self) {
+            joining[i]->Join();
+        }
     }
-    return dispatcher->ThreadHoldsLock();
+    if (!self) {
+        queueLock.Lock(MUTEX_CONTEXT);
+        workers.clear();
+        queueLock.Unlock(MUTEX_CONTEXT);
+        for (size_t i = 0; i < joining.size(); ++i) {
+            delete joining[i];
+        }
+    }
+    return ER_OK;
+}
+
+/* Must be called holding queueLock */
+_LocalEndpoint::Dispatcher::Worker* _LocalEndpoint::Dispatcher::CurrentWorker()
+{
+    qcc::Thread* thread = qcc::Thread::GetThread();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (workers[i] == thread) {
+            return workers[i];
+        }
+    }
+    return NULL;
+}
+
+QStatus _LocalEndpoint::Dispatcher::Enqueue(const Task& task)
+{
+    /*
+     * Senders are held up while the queue is full. Our own threads must never wait here since
+     * they are the ones that drain the queue.
+     */
+    queueLock.Lock(MUTEX_CONTEXT);
+    bool mayWait = (CurrentWorker() == NULL);
+    while (running && mayWait && (queue.size() >= LOCAL_ENDPOINT_MAX_PENDING)) {
+        spaceAvailable.ResetEvent();
+        QStatus status = Event::Wait(spaceAvailable, queueLock);
+        queueLock.Lock(MUTEX_CONTEXT);
+        if ((status != ER_OK) && (status != ER_TIMEOUT)) {
+            /* An alerted sender gives up waiting rather than lose the message */
+            break;
+        }
+    }
+    if (!running) {
+        queueLock.Unlock(MUTEX_CONTEXT);
+        return ER_TIMER_EXITING;
+    }
+    queue.push_back(task);
+    if (endpoint->handlerProfile.IsEnabled()) {
+        queue.back().queuedAt = GetLatencyClock();
+    }
+    if (queue.size() == 1) {
+        workAvailable.SetEvent();
+    }
+    queueLock.Unlock(MUTEX_CONTEXT);
+    return ER_OK;
+}
+
+void _LocalEndpoint::Dispatcher::WorkerRun(Worker* worker)
+{
+    queueLock.Lock(MUTEX_CONTEXT);
+    while (running && !worker->IsStopping()) {
+        if (queue.empty()) {
+            workAvailable.ResetEvent();
+            QStatus status = Event::Wait(workAvailable, queueLock);
+            queueLock.Lock(MUTEX_CONTEXT);
+            if ((status == ER_ALERTED_THREAD) && !worker->IsStopping()) {
+                worker->GetStopEvent().ResetEvent();
+            }
+            continue;
+        }
+        Task task = queue.front();
+        queue.pop_front();
+        if (queue.size() == (LOCAL_ENDPOINT_MAX_PENDING - 1)) {
+            spaceAvailable.SetEvent();
+        }
+        queueLock.Unlock(MUTEX_CONTEXT);
+
+        ThreadScheduling::Apply();
+        reentrancyLock.Lock(MUTEX_CONTEXT);
+        worker->holdsLock = true;
+        RunTask(task);
+        if (worker->holdsLock) {
+            worker->holdsLock = false;
+            reentrancyLock.Unlock(MUTEX_CONTEXT);
+        }
 
+        queueLock.Lock(MUTEX_CONTEXT);
+    }
+    queueLock.Unlock(MUTEX_CONTEXT);
 }
 
-void _LocalEndpoint::Dispatcher::AlarmTriggered(const Alarm& alarm, QStatus reason)
+void _LocalEndpoint::Dispatcher::RunTask(const Task& task)
 {
-    Message* msg = static_cast<Message*>(alarm->GetContext());
-    if (msg) {
-        if (reason == ER_OK) {
-            QStatus status = endpoint->DoPushMessage(*msg);
+    switch (task.kind) {
+    case Task::DISPATCH:
+        {
+            Message msg = task.msg;
+            QStatus status = endpoint->DoPushMessage(msg, task.queuedAt);
             // ER_BUS_STOPPING is a common shutdown error
             if (status != ER_OK && status != ER_BUS_STOPPING) {
                 QCC_LogError(status, ("LocalEndpoint::DoPushMessage failed"));
             }
         }
-        delete msg;
+        break;
+
+    case Task::SERIALIZED:
+        DeliverSerialized(task.msg->GetObjectPath());
+        break;
+
+    case Task::CALLBACKS:
+        if (endpoint->deferredCallbacks) {
+            endpoint->deferredCallbacks->Run();
+        }
+        break;
+    }
+}
+
+void _LocalEndpoint::Dispatcher::EnableReentrancy()
+{
+    queueLock.Lock(MUTEX_CONTEXT);
+    Worker* worker = CurrentWorker();
+    queueLock.Unlock(MUTEX_CONTEXT);
+    /* Only the worker itself changes its holdsLock flag */
+    if (worker && worker->holdsLock) {
+        worker->holdsLock = false;
+        reentrancyLock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+bool _LocalEndpoint::Dispatcher::ThreadHoldsLock()
+{
+    queueLock.Lock(MUTEX_CONTEXT);
+    Worker* worker = CurrentWorker();
+    queueLock.Unlock(MUTEX_CONTEXT);
+    return worker && worker->holdsLock;
+}
+
+QStatus _LocalEndpoint::Dispatcher::DispatchMessage(Message& msg)
+{
+    return Enqueue(Task(Task::DISPATCH, msg));
+}
+
+QStatus _LocalEndpoint::Dispatcher::DispatchDeferredCallbacks()
+{
+    Message msg(*endpoint->bus);
+    return Enqueue(Task(Task::CALLBACKS, msg));
+}
+
+QStatus _LocalEndpoint::Dispatcher::DispatchSerialized(Message& msg)
+{
+    QStatus status = ER_OK;
+    qcc::String path = msg->GetObjectPath();
+
+    serialLock.Lock(MUTEX_CONTEXT);
+    std::deque<Task>& calls = serialQueues[path];
+    calls.push_back(Task(Task::DISPATCH, msg));
+    if (endpoint->handlerProfile.IsEnabled()) {
+        calls.back().queuedAt = GetLatencyClock();
+    }
+    bool first = (calls.size() == 1);
+    serialLock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * If calls are already queued the thread that is handling them will pick this one up. The
+     * serial lock is not held here since Enqueue() may wait for a dispatcher thread.
+     */
+    if (first) {
+        status = Enqueue(Task(Task::SERIALIZED, msg));
+        if (status != ER_OK) {
+            DiscardSerialized(path);
+        }
+    }
+    return status;
+}
+
+void _LocalEndpoint::Dispatcher::DiscardSerialized(const qcc::String& path)
+{
+    serialLock.Lock(MUTEX_CONTEXT);
+    serialQueues.erase(path);
+    serialLock.Unlock(MUTEX_CONTEXT);
+}
+
+void _LocalEndpoint::Dispatcher::DeliverSerialized(const qcc::String& path)
+{
+    /* Don't hold up calls to other objects while this object's calls are handled */
+    EnableReentrancy();
+
+    serialLock.Lock(MUTEX_CONTEXT);
+    std::map<qcc::String, std::deque<Task> >::iterator it = serialQueues.find(path);
+    while ((it != serialQueues.end()) && !it->second.empty()) {
+        Message msg = it->second.front().msg;
+        uint64_t queuedAt = it->second.front().queuedAt;
+        serialLock.Unlock(MUTEX_CONTEXT);
+        QStatus status = endpoint->DoPushMessage(msg, queuedAt);
+        if (status != ER_OK && status != ER_BUS_STOPPING) {
+            QCC_LogError(status, ("LocalEndpoint::DoPushMessage failed"));
+        }
+        serialLock.Lock(MUTEX_CONTEXT);
+        /* Calls may have been queued while the lock was released but the front is still ours */
+        it = serialQueues.find(path);
+        if (it != serialQueues.end()) {
+            it->second.pop_front();
+        }
+    }
+    if (it != serialQueues.end()) {
+        serialQueues.erase(it);
+    }
+    serialLock.Unlock(MUTEX_CONTEXT);
+}
+
+void _LocalEndpoint::EnableReentrancy()
+{
+    if (dispatcher) {
+        dispatcher->EnableReentrancy();
     }
 }
 
+bool _LocalEndpoint::IsReentrantCall()
+{
+    if (!dispatcher) {
+        return false;
+    }
+    return dispatcher->ThreadHoldsLock();
+
+}
+
 QStatus _LocalEndpoint::PushMessage(Message& message)
 {
     QStatus ret;
@@ -446,6 +775,8 @@ QStatus _LocalEndpoint::PushMessage(Message& message)
         /* Determine if the source of this message is local to the process */
         if (ep->GetEndpointType() == ENDPOINT_TYPE_LOCAL) {
             ret = DoPushMessage(message);
+        } else if ((message->GetType() == MESSAGE_METHOD_CALL) && HasSerializedMethodCalls(message->GetObjectPath())) {
+            ret = dispatcher->DispatchSerialized(message);
         } else {
             ret = dispatcher->DispatchMessage(message);
         }
@@ -455,7 +786,7 @@ QStatus _LocalEndpoint::PushMessage(Message& message)
     return ret;
 }
 
-QStatus _LocalEndpoint::DoPushMessage(Message& message)
+QStatus _LocalEndpoint::DoPushMessage(Message& message, uint64_t queuedAt)
 {
     QStatus status = ER_OK;
 
@@ -467,11 +798,11 @@ QStatus _LocalEndpoint::DoPushMessage(Message& message)
 
         switch (message->GetType()) {
         case MESSAGE_METHOD_CALL:
-            status = HandleMethodCall(message);
+            status = HandleMethodCall(message, queuedAt);
             break;
 
         case MESSAGE_SIGNAL:
-            status = HandleSignal(message);
+            status = HandleSignal(message, queuedAt);
             break;
 
         case MESSAGE_METHOD_RET:
@@ -489,19 +820,65 @@ QStatus _LocalEndpoint::DoPushMessage(Message& message)
 
 QStatus _LocalEndpoint::RegisterBusObject(BusObject& object)
 {
-    QStatus status = ER_OK;
+    BusObject* objects[1] = { &object };
+    return RegisterBusObjects(objects, 1);
+}
 
-    const char* objPath = object.GetPath();
+/* Paths sort before the paths of their descendants */
+static bool PathLess(const BusObject* a, const BusObject* b)
+{
+    return strcmp(a->GetPath(), b->GetPath()) < 0;
+}
 
-    QCC_DbgPrintf(("RegisterObject %s", objPath));
+QStatus _LocalEndpoint::RegisterBusObjects(BusObject** objects, size_t numObjects)
+{
+    QStatus status = ER_OK;
 
-    if (!IsLegalObjectPath(objPath)) {
-        status = ER_BUS_BAD_OBJ_PATH;
-        QCC_LogError(status, ("Illegal object path \"%s\" specified", objPath));
-        return status;
+    /* Check all of the paths first so a bad one leaves nothing half registered */
+    for (size_t i = 0; i < numObjects; ++i) {
+        const char* objPath = objects[i]->GetPath();
+        if (!IsLegalObjectPath(objPath)) {
+            status = ER_BUS_BAD_OBJ_PATH;
+            QCC_LogError(status, ("Illegal object path \"%s\" specified", objPath));
+            return status;
+        }
     }
 
+    /*
+     * Registering parents before their children means parents in the batch never get a
+     * placeholder that has to be replaced. The sort is stable so that if a path appears more than
+     * once the last object wins, as it would with one registration at a time.
+     */
+    std::vector<BusObject*> sorted(objects, objects + numObjects);
+    std::stable_sort(sorted.begin(), sorted.end(), PathLess);
+
     objectsLock.Lock(MUTEX_CONTEXT);
+    for (size_t i = 0; (ER_OK == status) && (i < sorted.size()); ++i) {
+        status = RegisterWithParents(*sorted[i]);
+    }
+
+    /*
+     * If the bus is already running schedule call backs to report
+     * that the objects are registered. If the bus is not running
+     * the callbacks will be made later when the client router calls
+     * OnBusConnected().
+     */
+    if (!unannouncedObjects.empty() && bus->GetInternal().GetRouter().IsBusRunning()) {
+        OnBusConnected();
+    }
+
+    objectsLock.Unlock(MUTEX_CONTEXT);
+
+    return status;
+}
+
+QStatus _LocalEndpoint::RegisterWithParents(BusObject& object)
+{
+    QStatus status = ER_OK;
+
+    const char* objPath = object.GetPath();
+
+    QCC_DbgPrintf(("RegisterObject %s", objPath));
 
     /* Register placeholder parents as needed */
     size_t off = 0;
@@ -520,7 +897,7 @@ QStatus _LocalEndpoint::RegisterBusObject(BusObject& object)
                     QCC_LogError(status, ("Failed to register default object for path %s", parentPath.c_str()));
                     break;
                 }
-                defaultObjects.push_back(parent);
+                defaultObjects.insert(parent);
             }
             lastParent = parent;
         }
@@ -531,8 +908,6 @@ QStatus _LocalEndpoint::RegisterBusObject(BusObject& object)
         status = DoRegisterBusObject(object, lastParent, false);
     }
 
-    objectsLock.Unlock(MUTEX_CONTEXT);
-
     return status;
 }
 
@@ -559,19 +934,10 @@ QStatus _LocalEndpoint::DoRegisterBusObject(BusObject& object, BusObject* parent
         }
         /* Add object to list of objects */
         localObjects[object.GetPath()] = &object;
+        unannouncedObjects.insert(&object);
 
         /* Register handler for the object's methods */
         methodTable.AddAll(&object);
-
-        /*
-         * If the bus is already running schedule call backs to report
-         * that the objects are registered. If the bus is not running
-         * the callbacks will be made later when the client router calls
-         * OnBusConnected().
-         */
-        if (bus->GetInternal().GetRouter().IsBusRunning()) {
-            OnBusConnected();
-        }
     }
 
     return status;
@@ -587,6 +953,7 @@ void _LocalEndpoint::UnregisterBusObject(BusObject& object)
     /* Remove from object list */
     objectsLock.Lock(MUTEX_CONTEXT);
     localObjects.erase(object.GetPath());
+    unannouncedObjects.erase(&object);
     objectsLock.Unlock(MUTEX_CONTEXT);
 
     /* Notify object and detach from bus*/
@@ -607,15 +974,8 @@ void _LocalEndpoint::UnregisterBusObject(BusObject& object)
         UnregisterBusObject(*child);
     }
     /* Delete the object if it was a default object */
-    vector<BusObject*>::iterator dit = defaultObjects.begin();
-    while (dit != defaultObjects.end()) {
-        if (*dit == &object) {
-            defaultObjects.erase(dit);
-            delete &object;
-            break;
-        } else {
-            ++dit;
-        }
+    if (defaultObjects.erase(&object)) {
+        delete &object;
     }
     objectsLock.Unlock(MUTEX_CONTEXT);
 }
@@ -628,6 +988,18 @@ BusObject* _LocalEndpoint::FindLocalObject(const char* objectPath) {
     return ret;
 }
 
+bool _LocalEndpoint::HasSerializedMethodCalls(const char* objectPath)
+{
+    bool serialized = false;
+    if (objectPath) {
+        objectsLock.Lock(MUTEX_CONTEXT);
+        unordered_map<const char*, BusObject*, Hash, PathEq>::iterator iter = localObjects.find(objectPath);
+        serialized = (iter != localObjects.end()) && iter->second->HasSerializedMethodCalls();
+        objectsLock.Unlock(MUTEX_CONTEXT);
+    }
+    return serialized;
+}
+
 void _LocalEndpoint::UpdateSerialNumber(Message& msg)
 {
     uint32_t serial = msg->msgHeader.serialNum;
@@ -641,8 +1013,10 @@ void _LocalEndpoint::UpdateSerialNumber(Message& msg)
          */
         if (msg->GetType() == MESSAGE_METHOD_CALL) {
             replyMapLock.Lock(MUTEX_CONTEXT);
-            ReplyContext* rc = RemoveReplyHandler(serial);
-            if (rc) {
+            unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(serial);
+            if (iter != replyMap.end()) {
+                ReplyContext* rc = iter->second;
+                replyMap.erase(iter);
                 rc->serial = msg->msgHeader.serialNum;
                 replyMap[rc->serial] = rc;
             }
@@ -664,18 +1038,16 @@ QStatus _LocalEndpoint::RegisterReplyHandler(MessageReceiver* receiver,
         status = ER_BUS_STOPPING;
         QCC_LogError(status, ("Local transport not running"));
     } else {
-        ReplyContext* rc =  new ReplyContext(LocalEndpoint::wrap(this), receiver, replyHandler, &method, methodCallMsg, context, timeout);
+        ReplyContext* rc =  new ReplyContext(LocalEndpoint::wrap(this), receiver, replyHandler, &method, methodCallMsg, context);
         QCC_DbgPrintf(("LocalEndpoint::RegisterReplyHandler"));
         /*
-         * Add reply context.
+         * Add reply context and set the timeout.
          */
         replyMapLock.Lock(MUTEX_CONTEXT);
         replyMap[methodCallMsg->msgHeader.serialNum] = rc;
+        replyWheel.Insert(*rc, GetTimestamp64() + timeout);
         replyMapLock.Unlock(MUTEX_CONTEXT);
-        /*
-         * Set timeout
-         */
-        status = replyTimer.AddAlarm(rc->alarm);
+        status = ArmReplyWheel();
         if (status != ER_OK) {
             UnregisterReplyHandler(methodCallMsg);
         }
@@ -703,24 +1075,55 @@ _LocalEndpoint::ReplyContext* _LocalEndpoint::RemoveReplyHandler(uint32_t serial
 {
     QCC_DbgPrintf(("LocalEndpoint::RemoveReplyHandler for serial=%u", serial));
     ReplyContext* rc = NULL;
-    map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(serial);
+    unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(serial);
     if (iter != replyMap.end()) {
         rc = iter->second;
         replyMap.erase(iter);
+        replyWheel.Remove(*rc);
         assert(rc->serial == serial);
     }
     return rc;
 }
 
+QStatus _LocalEndpoint::ArmReplyWheel()
+{
+    QStatus status = ER_OK;
+    uint64_t when;
+    replyMapLock.Lock(MUTEX_CONTEXT);
+    bool pending = replyWheel.NextExpiry(when);
+    replyMapLock.Unlock(MUTEX_CONTEXT);
+    if (pending) {
+        wheelAlarmLock.Lock(MUTEX_CONTEXT);
+        /*
+         * An alarm that is already armed for an earlier time will re-arm for this slot when it
+         * fires so only an earlier expiry needs a new alarm.
+         */
+        if (!wheelAlarmTime || (when < wheelAlarmTime)) {
+            if (wheelAlarmTime) {
+                replyTimer.RemoveAlarm(wheelAlarm, false /* don't block if alarm in progress */);
+            }
+            uint64_t now = GetTimestamp64();
+            uint32_t relative = (when > now) ? static_cast<uint32_t>(when - now) : 0;
+            uint32_t zero = 0;
+            AlarmListener* listener = this;
+            wheelAlarm = Alarm(relative, listener, NULL, zero);
+            status = replyTimer.AddAlarm(wheelAlarm);
+            wheelAlarmTime = (status == ER_OK) ? when : 0;
+        }
+        wheelAlarmLock.Unlock(MUTEX_CONTEXT);
+    }
+    return status;
+}
+
 bool _LocalEndpoint::PauseReplyHandlerTimeout(Message& methodCallMsg)
 {
     bool paused = false;
     if (methodCallMsg->GetType() == MESSAGE_METHOD_CALL) {
         replyMapLock.Lock();
-        map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(methodCallMsg->GetCallSerial());
+        unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(methodCallMsg->GetCallSerial());
         if (iter != replyMap.end()) {
             ReplyContext*rc = iter->second;
-            paused = replyTimer.RemoveAlarm(rc->alarm);
+            paused = replyWheel.Remove(*rc);
         }
         replyMapLock.Unlock();
     }
@@ -732,17 +1135,26 @@ bool _LocalEndpoint::ResumeReplyHandlerTimeout(Message& methodCallMsg)
     bool resumed = false;
     if (methodCallMsg->GetType() == MESSAGE_METHOD_CALL) {
         replyMapLock.Lock();
-        map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(methodCallMsg->GetCallSerial());
+        unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.find(methodCallMsg->GetCallSerial());
         if (iter != replyMap.end()) {
             ReplyContext*rc = iter->second;
-            QStatus status = replyTimer.AddAlarm(rc->alarm);
-            if (status == ER_OK) {
+            /*
+             * The original deadline still applies so a call that was paused past its timeout
+             * expires as soon as it is resumed.
+             */
+            if (!rc->IsScheduled()) {
+                replyWheel.Insert(*rc, rc->GetDeadline());
                 resumed = true;
-            } else {
-                QCC_LogError(status, ("Failed to resume reply handler timeout for %s", methodCallMsg->Description().c_str()));
             }
         }
         replyMapLock.Unlock();
+        if (resumed) {
+            QStatus status = ArmReplyWheel();
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Failed to resume reply handler timeout for %s", methodCallMsg->Description().c_str()));
+                resumed = false;
+            }
+        }
     }
     return resumed;
 }
@@ -793,12 +1205,12 @@ QStatus _LocalEndpoint::UnregisterAllHandlers(MessageReceiver* receiver)
      * Remove any reply handlers for this receiver
      */
     replyMapLock.Lock(MUTEX_CONTEXT);
-    for (map<uint32_t, ReplyContext*>::iterator iter = replyMap.begin(); iter != replyMap.end();) {
+    for (unordered_map<uint32_t, ReplyContext*>::iterator iter = replyMap.begin(); iter != replyMap.end();) {
         ReplyContext* rc = iter->second;
         if (rc->receiver == receiver) {
-            replyMap.erase(iter);
+            replyMap.erase(iter++);
+            replyWheel.Remove(*rc);
             delete rc;
-            iter = replyMap.begin();
         } else {
             ++iter;
         }
@@ -812,32 +1224,51 @@ QStatus _LocalEndpoint::UnregisterAllHandlers(MessageReceiver* receiver)
  */
 void _LocalEndpoint::AlarmTriggered(const Alarm& alarm, QStatus reason)
 {
-    ReplyContext* rc = reinterpret_cast<ReplyContext*>(alarm->GetContext());
+    wheelAlarmLock.Lock(MUTEX_CONTEXT);
+    if (alarm == wheelAlarm) {
+        wheelAlarmTime = 0;
+    }
+    wheelAlarmLock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * Collect the serial numbers of the expired calls. The reply contexts themselves are only
+     * safe to touch while holding replyMapLock; a reply that races with the timeout wins.
+     */
+    vector<uint32_t> serials;
+    vector<TimingWheel::Entry*> expired;
     replyMapLock.Lock(MUTEX_CONTEXT);
-    /* Search for the ReplyContext entry in the replyMap */
-    bool found = false;
-    for (map<uint32_t, ReplyContext*>::iterator iter = replyMap.begin(); iter != replyMap.end(); iter++) {
-        if (rc == iter->second) {
-            found = true;
-            break;
-        }
+    if (reason == ER_TIMER_EXITING) {
+        replyWheel.RemoveAll(expired);
+    } else {
+        replyWheel.Advance(GetTimestamp64(), expired);
+    }
+    for (vector<TimingWheel::Entry*>::iterator it = expired.begin(); it != expired.end(); ++it) {
+        ReplyContext* rc = static_cast<ReplyContext*>(*it);
+        /*
+         * Clear the encrypted flag so the error response doesn't get rejected.
+         */
+        rc->callFlags &= ~ALLJOYN_FLAG_ENCRYPTED;
+        serials.push_back(rc->serial);
     }
+    replyMapLock.Unlock(MUTEX_CONTEXT);
 
-    if (found == false) {
-        /* If an entry for the ReplyContext is not found, it might have been deleted due to a MethodReply. */
-        replyMapLock.Unlock(MUTEX_CONTEXT);
-        return;
+    for (vector<uint32_t>::iterator it = serials.begin(); it != serials.end(); ++it) {
+        TimeoutReply(*it, reason);
+    }
+
+    if (reason != ER_TIMER_EXITING) {
+        QStatus status = ArmReplyWheel();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to re-arm reply timeout alarm"));
+        }
     }
-    uint32_t serial = rc->serial;
+}
+
+void _LocalEndpoint::TimeoutReply(uint32_t serial, QStatus reason)
+{
     Message msg(*bus);
     QStatus status = ER_OK;
 
-    /*
-     * Clear the encrypted flag so the error response doesn't get rejected.
-     */
-    rc->callFlags &= ~ALLJOYN_FLAG_ENCRYPTED;
-    replyMapLock.Unlock(MUTEX_CONTEXT);
-
     if (running) {
         QCC_DbgPrintf(("Timed out waiting for METHOD_REPLY with serial %d", serial));
         if (reason == ER_TIMER_EXITING) {
@@ -863,14 +1294,15 @@ void _LocalEndpoint::AlarmTriggered(const Alarm& alarm, QStatus reason)
     }
 }
 
-QStatus _LocalEndpoint::HandleMethodCall(Message& message)
+QStatus _LocalEndpoint::HandleMethodCall(Message& message, uint64_t queuedAt)
 {
     QStatus status = ER_OK;
 
     /* Look up the member */
-    MethodTable::SafeEntry* safeEntry = methodTable.Find(message->GetObjectPath(),
-                                                         message->GetInterface(),
-                                                         message->GetMemberName());
+    const HeaderFields& hdrFields = message->GetHeaderFields();
+    MethodTable::SafeEntry* safeEntry = methodTable.Find(AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_PATH),
+                                                         AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_INTERFACE),
+                                                         AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_MEMBER));
     const MethodTable::Entry* entry = safeEntry ? safeEntry->entry : NULL;
 
     if (entry == NULL) {
@@ -894,7 +1326,13 @@ QStatus _LocalEndpoint::HandleMethodCall(Message& message)
     if (status == ER_OK) {
         /* Call the method handler */
         if (entry) {
-            entry->object->CallMethodHandler(entry->handler, entry->member, message, entry->context);
+            if (handlerProfile.IsEnabled()) {
+                uint64_t start = GetLatencyClock();
+                entry->object->CallMethodHandler(entry->handler, entry->member, message, entry->context);
+                handlerProfile.Record(entry->member, queuedAt, start, GetLatencyClock());
+            } else {
+                entry->object->CallMethodHandler(entry->handler, entry->member, message, entry->context);
+            }
         }
     } else if (message->GetType() == MESSAGE_METHOD_CALL && !(message->GetFlags() & ALLJOYN_FLAG_NO_REPLY_EXPECTED)) {
         /* We are rejecting a method call that expects a response so reply with an error message. */
@@ -946,35 +1384,27 @@ QStatus _LocalEndpoint::HandleMethodCall(Message& message)
     return status;
 }
 
-QStatus _LocalEndpoint::HandleSignal(Message& message)
+QStatus _LocalEndpoint::HandleSignal(Message& message, uint64_t queuedAt)
 {
     QStatus status = ER_OK;
 
-    signalTable.Lock();
-
-    /* Look up the signal */
-    pair<SignalTable::const_iterator, SignalTable::const_iterator> range =
-        signalTable.Find(message->GetObjectPath(), message->GetInterface(), message->GetMemberName());
+    /*
+     * Build a list of all signal handlers for this signal. The signal table lookup doesn't lock so
+     * concurrent dispatcher threads don't contend here.
+     */
+    vector<SignalTable::Entry> callList;
+    signalTable.Find(AtomTable::GetHeaderAtom(message->GetHeaderFields(), ALLJOYN_HDR_FIELD_PATH),
+                     AtomTable::GetHeaderAtom(message->GetHeaderFields(), ALLJOYN_HDR_FIELD_INTERFACE),
+                     AtomTable::GetHeaderAtom(message->GetHeaderFields(), ALLJOYN_HDR_FIELD_MEMBER),
+                     callList);
 
     /*
      * Quick exit if there are no handlers for this signal
      */
-    if (range.first == range.second) {
-        signalTable.Unlock();
+    if (callList.empty()) {
         return ER_OK;
     }
-    /*
-     * Build a list of all signal handlers for this signal
-     */
-    list<SignalTable::Entry> callList;
-    const InterfaceDescription::Member* signal = range.first->second.member;
-    do {
-        callList.push_back(range.first->second);
-    } while (++range.first != range.second);
-    /*
-     * We have our callback list so we can unlock the signal table.
-     */
-    signalTable.Unlock();
+    const InterfaceDescription::Member* signal = callList.front().member;
     /*
      * Validate and unmarshal the signal
      */
@@ -990,9 +1420,15 @@ QStatus _LocalEndpoint::HandleSignal(Message& message)
             status = ER_OK;
         }
     } else {
-        list<SignalTable::Entry>::const_iterator callit;
+        vector<SignalTable::Entry>::const_iterator callit;
+        bool profile = handlerProfile.IsEnabled();
         for (callit = callList.begin(); callit != callList.end(); ++callit) {
+            uint64_t start = profile ? GetLatencyClock() : 0;
             (callit->object->*callit->handler)(callit->member, message->GetObjectPath(), message);
+            if (profile) {
+                /* Later handlers of the same signal also waited for the earlier ones */
+                handlerProfile.Record(callit->member, queuedAt, start, GetLatencyClock());
+            }
         }
     }
     return status;
@@ -1048,34 +1484,29 @@ QStatus _LocalEndpoint::HandleMethodReply(Message& message)
     return status;
 }
 
-void _LocalEndpoint::DeferredCallbacks::AlarmTriggered(const qcc::Alarm& alarm, QStatus reason)
+void _LocalEndpoint::DeferredCallbacks::Run()
 {
-    if (reason == ER_OK) {
-        /*
-         * Allow synchronous method calls from within the object registration callbacks
-         */
-        endpoint->bus->EnableConcurrentCallbacks();
-        /*
-         * Call ObjectRegistered for any unregistered bus objects
-         */
-        endpoint->objectsLock.Lock(MUTEX_CONTEXT);
-        unordered_map<const char*, BusObject*, Hash, PathEq>::iterator iter = endpoint->localObjects.begin();
-        while (endpoint->running && (iter != endpoint->localObjects.end())) {
-            if (!iter->second->isRegistered) {
-                BusObject* bo = iter->second;
-                bo->isRegistered = true;
-                bo->InUseIncrement();
-                endpoint->objectsLock.Unlock(MUTEX_CONTEXT);
-                bo->ObjectRegistered();
-                endpoint->objectsLock.Lock(MUTEX_CONTEXT);
-                bo->InUseDecrement();
-                iter = endpoint->localObjects.begin();
-            } else {
-                ++iter;
-            }
+    /*
+     * Allow synchronous method calls from within the object registration callbacks
+     */
+    endpoint->bus->EnableConcurrentCallbacks();
+    /*
+     * Call ObjectRegistered for any unregistered bus objects
+     */
+    endpoint->objectsLock.Lock(MUTEX_CONTEXT);
+    while (endpoint->running && !endpoint->unannouncedObjects.empty()) {
+        BusObject* bo = *endpoint->unannouncedObjects.begin();
+        endpoint->unannouncedObjects.erase(endpoint->unannouncedObjects.begin());
+        if (!bo->isRegistered) {
+            bo->isRegistered = true;
+            bo->InUseIncrement();
+            endpoint->objectsLock.Unlock(MUTEX_CONTEXT);
+            bo->ObjectRegistered();
+            endpoint->objectsLock.Lock(MUTEX_CONTEXT);
+            bo->InUseDecrement();
         }
-        endpoint->objectsLock.Unlock(MUTEX_CONTEXT);
     }
+    endpoint->objectsLock.Unlock(MUTEX_CONTEXT);
 }
 
 void _LocalEndpoint::OnBusConnected()
@@ -1083,9 +1514,8 @@ void _LocalEndpoint::OnBusConnected()
     /*
      * Use the local endpoint's dispatcher to call back to report the object registrations.
      */
-    uint32_t zero = 0;
     if (dispatcher) {
-        dispatcher->AddAlarm(Alarm(zero, deferredCallbacks));
+        dispatcher->DispatchDeferredCallbacks();
     }
 }
 
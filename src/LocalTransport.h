@@ -26,6 +26,7 @@
 #include <qcc/platform.h>
 
 #include <map>
+#include <set>
 
 #include <qcc/String.h>
 #include <qcc/GUID.h>
@@ -44,8 +45,11 @@
 
 #include "BusEndpoint.h"
 #include "CompressionRules.h"
+#include "HandlerProfile.h"
 #include "MethodTable.h"
 #include "SignalTable.h"
+#include "SignalBatcher.h"
+#include "TimingWheel.h"
 #include "Transport.h"
 
 #include <qcc/STLContainer.h>
@@ -75,7 +79,7 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
     /**
      * Default constructor initializes an invalid endpoint. This allows for the declaration of uninitialized LocalEndpoint variables.
      */
-    _LocalEndpoint() : dispatcher(NULL), deferredCallbacks(NULL), bus(NULL), replyTimer("replyTimer", true) { }
+    _LocalEndpoint() : dispatcher(NULL), deferredCallbacks(NULL), bus(NULL), replyTimer("replyTimer", true), replyWheel(0), wheelAlarmTime(0), signalBatcher(NULL) { }
 
     /**
      * Constructor
@@ -161,6 +165,13 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     void UpdateSerialNumber(Message& msg);
 
+    /**
+     * Get the batcher that packs outgoing signals, see BusAttachment::EnableSignalBatching().
+     *
+     * @return  The signal batcher or NULL for a placeholder endpoint.
+     */
+    SignalBatcher* GetSignalBatcher() { return signalBatcher; }
+
     /**
      * Pause the timeout handler for specified method call. If the reply handler is succesfully
      * paused it must be resumed by calling ResumeReplyHandler later.
@@ -251,6 +262,21 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     QStatus RegisterBusObject(BusObject& obj);
 
+    /**
+     * Register a batch of BusObjects. The objects are registered parents first under a single
+     * acquisition of the objects lock and the ObjectRegistered callbacks of the whole batch are
+     * made by one pass of the dispatcher.
+     *
+     * @param objects      The BusObjects to be registered.
+     * @param numObjects   The number of objects.
+     * @return
+     *      - ER_OK if successful.
+     *      - ER_BUS_BAD_OBJ_PATH for a bad object path, no object is registered in that case
+     *      - Another error from the first object that failed to register, the objects that sort
+     *        before it remain registered
+     */
+    QStatus RegisterBusObjects(BusObject** objects, size_t numObjects);
+
     /**
      * Unregisters an object and its method and signal handlers.
      *
@@ -268,6 +294,14 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     BusObject* FindLocalObject(const char* objectPath);
 
+    /**
+     * Determine if method calls to a local object are serialized per object.
+     *
+     * @param objectPath   Object path.
+     * @return  true if the object exists and has requested per-object serialization.
+     */
+    bool HasSerializedMethodCalls(const char* objectPath);
+
     /**
      * Notify local endpoint that a bus connection has been made.
      */
@@ -363,6 +397,33 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     bool IsReentrantCall();
 
+    /**
+     * Get the profile of the method and signal handlers this endpoint calls. Profiling is
+     * disabled until enabled through the returned profile.
+     *
+     * @return  The handler profile.
+     */
+    HandlerProfile& GetHandlerProfile() { return handlerProfile; }
+
+    /**
+     * Add an alarm to the timer used for method call timeouts. Alarm listeners must not block
+     * since timeouts are delayed while they run.
+     *
+     * @param alarm  The alarm to add.
+     *
+     * @return  ER_OK if the alarm was added.
+     */
+    QStatus AddAlarm(const qcc::Alarm& alarm) { return replyTimer.AddAlarm(alarm); }
+
+    /**
+     * Remove an alarm added by AddAlarm() waiting for it to complete if it is being triggered.
+     *
+     * @param alarm  The alarm to remove.
+     *
+     * @return  true if the alarm was removed before it was triggered.
+     */
+    bool RemoveAlarm(const qcc::Alarm& alarm) { return replyTimer.RemoveAlarm(alarm); }
+
   private:
 
     /**
@@ -380,8 +441,12 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
 
     /**
      * PushMessage worker.
+     *
+     * @param msg        The message.
+     * @param queuedAt   Latency clock time at which the dispatcher queued msg, 0 if it was not
+     *                   queued or handler profiling is disabled.
      */
-    QStatus DoPushMessage(Message& msg);
+    QStatus DoPushMessage(Message& msg, uint64_t queuedAt = 0);
 
     /**
      * Assignment operator is private - LocalEndpoints cannot be assigned.
@@ -412,6 +477,14 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     ReplyContext* RemoveReplyHandler(uint32_t serial);
 
+    /**
+     * Make sure the reply wheel alarm is armed for the next slot that holds a reply timeout.
+     * Must not be called holding replyMapLock.
+     *
+     * @return ER_OK if the alarm is armed or no timeouts are pending.
+     */
+    QStatus ArmReplyWheel();
+
     /**
      * Hash functor
      */
@@ -429,7 +502,12 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
     /**
      * List of contexts for method call replies.
      */
-    std::map<uint32_t, ReplyContext*> replyMap;
+    std::unordered_map<uint32_t, ReplyContext*> replyMap;
+
+    /**
+     * Pending method call timeouts. All timeouts share the single wheelAlarm on replyTimer.
+     */
+    TimingWheel replyWheel;
 
     bool running;                      /**< Is the local endpoint up and running */
     bool isRegistered;                 /**< true iff endpoint has been registered with router */
@@ -441,8 +519,14 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
     qcc::GUID128 guid;                 /**< GUID to uniquely identify a local endpoint */
     qcc::String uniqueName;            /**< Unique name for endpoint */
     qcc::Timer replyTimer;             /**< Timer used to timeout method calls */
+    qcc::Mutex wheelAlarmLock;         /**< Mutex protecting wheelAlarm and wheelAlarmTime */
+    qcc::Alarm wheelAlarm;             /**< Alarm that advances replyWheel */
+    uint64_t wheelAlarmTime;           /**< Absolute time wheelAlarm is armed for or 0 if not armed */
+    SignalBatcher* signalBatcher;      /**< Packs outgoing signals, shares replyTimer for its latency budget */
+    HandlerProfile handlerProfile;     /**< Call counts and timings of the handlers called */
 
-    std::vector<BusObject*> defaultObjects;  /**< Auto-generated, heap allocated parent objects */
+    std::set<BusObject*> defaultObjects;       /**< Auto-generated, heap allocated parent objects */
+    std::set<BusObject*> unannouncedObjects;   /**< Registered objects whose ObjectRegistered callback is pending */
 
     /**
      * Remote object for the standard DBus object and its interfaces
@@ -473,12 +557,12 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
     /**
      * Process an incoming SIGNAL message
      */
-    QStatus HandleSignal(Message& msg);
+    QStatus HandleSignal(Message& msg, uint64_t queuedAt);
 
     /**
      * Process an incoming METHOD_CALL message
      */
-    QStatus HandleMethodCall(Message& msg);
+    QStatus HandleMethodCall(Message& msg, uint64_t queuedAt);
 
     /**
      * Process an incoming METHOD_REPLY or ERROR message
@@ -490,12 +574,28 @@ class _LocalEndpoint : public _BusEndpoint, public qcc::AlarmListener, public Me
      */
     void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
 
+    /**
+     * Deliver a timeout or exiting error reply for a method call.
+     *
+     * @param serial   Serial number of the method call.
+     * @param reason   ER_TIMER_EXITING if the reply timer is shutting down.
+     */
+    void TimeoutReply(uint32_t serial, QStatus reason);
+
     /**
      * Inner utility method used bo RegisterBusObject.
      * Do not call this method externally.
      */
     QStatus DoRegisterBusObject(BusObject& object, BusObject* parent, bool isPlaceholder);
 
+    /**
+     * Inner utility method used by RegisterBusObjects. Registers placeholders for any missing
+     * parents of the object and then the object itself. Must be called with objectsLock held.
+     *
+     * @param object   The object to register.
+     */
+    QStatus RegisterWithParents(BusObject& object);
+
 };
 
 /**
@@ -0,0 +1,55 @@
+/**
+ * @file
+ *
+ * This file implements the LogRateLimit class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/atomic.h>
+#include <qcc/time.h>
+
+#include "LogRateLimit.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+bool LogRateLimit::Allow(uint32_t& suppressed)
+{
+    uint32_t now = GetTimestamp();
+    /* Timestamps can be zero so count distinguishes a fresh limit from one whose period started at 0 */
+    if ((count == 0) || ((now - periodStart) >= PERIOD_MS)) {
+        periodStart = now;
+        count = 0;
+    }
+    if (IncrementAndFetch(&count) > MAX_PER_PERIOD) {
+        IncrementAndFetch(&dropped);
+        return false;
+    }
+    /* Take the suppressed count without losing increments made by other threads */
+    int32_t d = dropped;
+    for (int32_t i = 0; i < d; ++i) {
+        DecrementAndFetch(&dropped);
+    }
+    suppressed = static_cast<uint32_t>(d);
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef _ALLJOYN_LOGRATELIMIT_H
+#define _ALLJOYN_LOGRATELIMIT_H
+/**
+ * @file
+ * LogRateLimit bounds how often an error log site on the message path formats and writes a message.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include LogRateLimit.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <qcc/Debug.h>
+
+namespace ajn {
+
+/**
+ * A log site that fails once per message fails for every message during an outage or an
+ * overload, and formatting each message (Message::Description() builds several strings) adds
+ * load exactly when the daemon has least to spare. A LogRateLimit lets MAX_PER_PERIOD messages
+ * through per PERIOD_MS milliseconds and counts the rest, the next message that gets through
+ * reports how many were suppressed.
+ *
+ * Limits are meant to be function statics, one per log site, see QCC_LogErrorRateLimited(). All
+ * members are zero initialized so a static limit needs no constructor and is ready before any
+ * thread uses it. Allow() is lock free, racing threads can let a message or two more than the
+ * limit through when a period ends.
+ */
+class LogRateLimit {
+  public:
+
+    /** Messages let through in each period */
+    static const int32_t MAX_PER_PERIOD = 10;
+
+    /** Length of a period in milliseconds */
+    static const uint32_t PERIOD_MS = 1000;
+
+    /**
+     * Check whether a log message may be written.
+     *
+     * @param[out] suppressed  Number of messages suppressed since the last one that was let through.
+     *
+     * @return true if the message should be written.
+     */
+    bool Allow(uint32_t& suppressed);
+
+    volatile uint32_t periodStart;   /**< Timestamp at which the current period began */
+    volatile int32_t count;          /**< Messages seen during the current period */
+    volatile int32_t dropped;        /**< Messages suppressed since the last one let through */
+};
+
+}
+
+/**
+ * Log an error like QCC_LogError() but at most LogRateLimit::MAX_PER_PERIOD times per period for
+ * this log site. The message arguments are only evaluated for messages that are written, so they
+ * can be expensive to format.
+ *
+ * @param _status  The status to log.
+ * @param _msg     Parenthesized printf style format and arguments as for QCC_LogError().
+ */
+#define QCC_LogErrorRateLimited(_status, _msg)                                   \
+    do {                                                                        \
+        static ajn::LogRateLimit _limit;                                        \
+        uint32_t _suppressed;                                                   \
+        if (_limit.Allow(_suppressed)) {                                        \
+            if (_suppressed) {                                                  \
+                QCC_LogError(_status, ("Suppressed %u similar errors", _suppressed)); \
+            }                                                                   \
+            QCC_LogError(_status, _msg);                                        \
+        }                                                                       \
+    } while (0)
+
+#endif
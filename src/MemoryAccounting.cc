@@ -0,0 +1,107 @@
+/**
+ * @file
+ * Opt-in accounting of the memory held by the major daemon subsystems.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include "MemoryAccounting.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+volatile bool MemoryAccounting::enabled = false;
+
+MemoryAccounting::Usage MemoryAccounting::usage[MemoryAccounting::NUM_SUBSYSTEMS];
+
+/* One lock per subsystem so subsystems never contend with each other */
+static qcc::Mutex usageLocks[MemoryAccounting::NUM_SUBSYSTEMS];
+
+void MemoryAccounting::Update(Subsystem subsystem, int64_t bytes, int32_t objects)
+{
+    usageLocks[subsystem].Lock(MUTEX_CONTEXT);
+    Usage& u = usage[subsystem];
+    u.bytes += bytes;
+    u.objects += objects;
+    if (u.bytes > u.peakBytes) {
+        u.peakBytes = u.bytes;
+    }
+    usageLocks[subsystem].Unlock(MUTEX_CONTEXT);
+}
+
+void MemoryAccounting::Get(Subsystem subsystem, Usage& u)
+{
+    usageLocks[subsystem].Lock(MUTEX_CONTEXT);
+    u = usage[subsystem];
+    usageLocks[subsystem].Unlock(MUTEX_CONTEXT);
+}
+
+const char* MemoryAccounting::SubsystemText(Subsystem subsystem)
+{
+    switch (subsystem) {
+    case MEM_SESSIONLESS:
+        return "sessionless";
+
+    case MEM_COMPRESSION_RULES:
+        return "compression_rules";
+
+    case MEM_PACKETS:
+        return "packets";
+
+    case MEM_NAME_TABLE:
+        return "name_table";
+
+    case MEM_TX_QUEUES:
+        return "tx_queues";
+
+    case MEM_ENDPOINTS:
+        return "endpoints";
+
+    case MEM_ENDPOINT_BUFFERS:
+        return "endpoint_buffers";
+
+    default:
+        return "unknown";
+    }
+}
+
+qcc::String MemoryAccounting::ToString()
+{
+    qcc::String str;
+    for (int s = 0; s < NUM_SUBSYSTEMS; ++s) {
+        Usage u;
+        Get(static_cast<Subsystem>(s), u);
+        str += SubsystemText(static_cast<Subsystem>(s));
+        str += ": bytes=" + I64ToString(u.bytes);
+        str += " peak=" + I64ToString(u.peakBytes);
+        str += " objects=" + I32ToString(u.objects);
+        if (u.objects > 0) {
+            str += " per_object=" + I64ToString(u.bytes / u.objects);
+        }
+        str += "\n";
+    }
+    return str;
+}
+
+}
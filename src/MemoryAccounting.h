@@ -0,0 +1,134 @@
+#ifndef _ALLJOYN_MEMORYACCOUNTING_H
+#define _ALLJOYN_MEMORYACCOUNTING_H
+/**
+ * @file
+ * Opt-in accounting of the memory held by the major daemon subsystems.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MemoryAccounting.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+
+namespace ajn {
+
+/**
+ * MemoryAccounting keeps a running total of the bytes and objects held by each of the
+ * subsystems most likely to grow in a long-running daemon. The byte counts are estimates made
+ * by the subsystems themselves (payload plus the fixed size of their container entries), not
+ * exact heap usage.
+ *
+ * Accounting is disabled by default; when disabled the only cost is a test of a flag. It can only
+ * be enabled at startup, before the subsystems allocate anything, so that every release that is
+ * accounted matches an accounted allocation.
+ */
+class MemoryAccounting {
+  public:
+
+    /** The subsystems that are accounted */
+    enum Subsystem {
+        MEM_SESSIONLESS,         /**< Sessionless signals stored by SessionlessObj */
+        MEM_COMPRESSION_RULES,   /**< Header compression rules */
+        MEM_PACKETS,             /**< Packets allocated by PacketPools, in use or free */
+        MEM_NAME_TABLE,          /**< Unique, alias and virtual alias names */
+        MEM_TX_QUEUES,           /**< Messages waiting in remote endpoint transmit queues */
+        MEM_ENDPOINTS,           /**< Fixed per-connection state of remote endpoints */
+        MEM_ENDPOINT_BUFFERS,    /**< Transmit queue slots, write batches and validation caches allocated on demand */
+        NUM_SUBSYSTEMS
+    };
+
+    /** Counters of one subsystem */
+    struct Usage {
+        int64_t bytes;       /**< Bytes currently held */
+        int64_t peakBytes;   /**< Largest number of bytes held at once */
+        int32_t objects;     /**< Objects currently held */
+    };
+
+    /**
+     * @return  true if memory is being accounted.
+     */
+    static bool IsEnabled() { return enabled; }
+
+    /**
+     * Enable memory accounting. Must be called before any accounted allocation is made.
+     *
+     * @param enable   true to account memory.
+     */
+    static void Enable(bool enable) { enabled = enable; }
+
+    /**
+     * Account an allocation.
+     *
+     * @param subsystem   The subsystem that holds the memory.
+     * @param bytes       Size of the allocation.
+     */
+    static void Allocated(Subsystem subsystem, size_t bytes)
+    {
+        if (enabled) {
+            Update(subsystem, static_cast<int64_t>(bytes), 1);
+        }
+    }
+
+    /**
+     * Account a release. The size must be the size passed to Allocated().
+     *
+     * @param subsystem   The subsystem that held the memory.
+     * @param bytes       Size of the allocation.
+     */
+    static void Released(Subsystem subsystem, size_t bytes)
+    {
+        if (enabled) {
+            Update(subsystem, -static_cast<int64_t>(bytes), -1);
+        }
+    }
+
+    /**
+     * Get the counters of a subsystem.
+     *
+     * @param subsystem   The subsystem.
+     * @param usage       [OUT] The counters.
+     */
+    static void Get(Subsystem subsystem, Usage& usage);
+
+    /**
+     * @return  The name of a subsystem.
+     */
+    static const char* SubsystemText(Subsystem subsystem);
+
+    /**
+     * Format the counters of every subsystem. The average size of an object is included so the
+     * per-connection overhead can be read off the endpoint lines directly.
+     *
+     * @return  One line of text per subsystem.
+     */
+    static qcc::String ToString();
+
+  private:
+    static void Update(Subsystem subsystem, int64_t bytes, int32_t objects);
+
+    static volatile bool enabled;
+    static Usage usage[NUM_SUBSYSTEMS];
+};
+
+}
+
+#endif
@@ -39,6 +39,8 @@
 
 #include "BusInternal.h"
 #include "BusUtil.h"
+#include "MsgArgArena.h"
+#include "MsgBufPool.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -62,6 +64,7 @@ HeaderFields::HeaderFields(const HeaderFields& other)
 {
     for (size_t i = 0; i < ArraySize(field); ++i) {
         field[i] = other.field[i];
+        atoms[i] = other.atoms[i];
     }
 }
 
@@ -70,6 +73,7 @@ HeaderFields& HeaderFields::operator=(const HeaderFields& other)
     if (this != &other) {
         for (size_t i = 0; i < ArraySize(field); ++i) {
             field[i] = other.field[i];
+            atoms[i] = other.atoms[i];
         }
     }
     return *this;
@@ -303,17 +307,23 @@ QStatus _Message::GetArgs(const char* signature, ...)
 _Message::_Message(BusAttachment& bus) :
     bus(&bus),
     endianSwap(false),
+    sigVerified(false),
+    verifiedArgs(-1),
     _msgBuf(NULL),
     msgBuf(NULL),
     msgArgs(NULL),
     numMsgArgs(0),
+    argArena(NULL),
+    parsingBody(false),
     ttl(0),
+    rxTimestamp(0),
     handles(NULL),
     numHandles(0),
     encrypt(false),
     readState(MESSAGE_NEW),
     countRead(0),
     writeState(MESSAGE_NEW),
+    writePtr(NULL),
     countWrite(0)
 {
     msgHeader.msgType = MESSAGE_INVALID;
@@ -322,8 +332,9 @@ _Message::_Message(BusAttachment& bus) :
 
 _Message::~_Message(void)
 {
-    delete [] _msgBuf;
-    delete [] msgArgs;
+    MsgBufPool::Free(_msgBuf);
+    ClearArgs();
+    delete argArena;
     while (numHandles) {
         qcc::Close(handles[--numHandles]);
     }
@@ -333,11 +344,16 @@ _Message::~_Message(void)
 _Message::_Message(const _Message& other) :
     bus(other.bus),
     endianSwap(other.endianSwap),
+    sigVerified(false),
+    verifiedArgs(other.verifiedArgs),
     msgHeader(other.msgHeader),
     numMsgArgs(other.numMsgArgs),
+    argArena(NULL),
+    parsingBody(false),
     bufSize(other.bufSize),
     ttl(other.ttl),
     timestamp(other.timestamp),
+    rxTimestamp(other.rxTimestamp),
     replySignature(other.replySignature),
     authMechanism(other.authMechanism),
     rcvEndpointName(other.rcvEndpointName),
@@ -346,22 +362,54 @@ _Message::_Message(const _Message& other) :
     readState(other.readState),
     countRead(other.countRead),
     writeState(other.writeState),
-    countWrite(other.countWrite),
-    hdrFields(other.hdrFields)
+    writePtr(other.writePtr),
+    countWrite(other.countWrite)
 {
     if (bufSize > 0) {
         assert(other.msgBuf != NULL);
-        _msgBuf = new uint8_t[bufSize + 7];
-        msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7);
-        bufEOD = ((uint8_t*)msgBuf) + (other.bufEOD - ((uint8_t*)other.msgBuf));
-        bufPos = ((uint8_t*)msgBuf) + (other.bufPos - ((uint8_t*)other.msgBuf));
-        bodyPtr = ((uint8_t*)msgBuf) + (other.bodyPtr - ((uint8_t*)other.msgBuf));
         /*
-         * Copy in buffer and zero fill the pad at the end of the data
+         * The marshaled message is shared with the original, it is copied if either message
+         * needs to modify it (see MakeBufWritable).
+         */
+        _msgBuf = other._msgBuf;
+        MsgBufPool::AddRef(_msgBuf);
+        msgBuf = other.msgBuf;
+        bufEOD = other.bufEOD;
+        bufPos = other.bufPos;
+        bodyPtr = other.bodyPtr;
+        /*
+         * Header strings that point into the shared buffer stay valid for as long as we hold our
+         * reference to it so they can be shared too. Everything else is cloned.
          */
-        ::memcpy(msgBuf, other.msgBuf, bufSize);
-        ::memset(bufEOD, 0, (uint8_t*)msgBuf + bufSize - bufEOD);
+        const char* bufStart = reinterpret_cast<const char*>(msgBuf);
+        const char* bufEnd = reinterpret_cast<const char*>(bufEOD);
+        for (size_t i = 0; i < ArraySize(hdrFields.field); ++i) {
+            const MsgArg& src = other.hdrFields.field[i];
+            const char* str = NULL;
+            size_t len = 0;
+            if ((src.typeId == ALLJOYN_STRING) || (src.typeId == ALLJOYN_OBJECT_PATH)) {
+                str = src.v_string.str;
+                len = src.v_string.len;
+            } else if (src.typeId == ALLJOYN_SIGNATURE) {
+                str = src.v_signature.sig;
+                len = src.v_signature.len;
+            }
+            if (str && (str >= bufStart) && ((str + len) < bufEnd)) {
+                hdrFields.field[i].typeId = src.typeId;
+                if (src.typeId == ALLJOYN_SIGNATURE) {
+                    hdrFields.field[i].v_signature.sig = str;
+                    hdrFields.field[i].v_signature.len = static_cast<uint8_t>(len);
+                } else {
+                    hdrFields.field[i].v_string.str = str;
+                    hdrFields.field[i].v_string.len = static_cast<uint32_t>(len);
+                }
+            } else {
+                hdrFields.field[i] = src;
+            }
+            hdrFields.atoms[i] = other.hdrFields.atoms[i];
+        }
     } else {
+        hdrFields = other.hdrFields;
         assert(other.msgBuf == NULL);
         _msgBuf = NULL;
         msgBuf = NULL;
@@ -387,19 +435,52 @@ _Message::_Message(const _Message& other) :
     }
 }
 
+void _Message::MakeBufWritable(size_t copyLen)
+{
+    if (!_msgBuf || !MsgBufPool::IsShared(_msgBuf)) {
+        return;
+    }
+    uint8_t* oldBuf = reinterpret_cast<uint8_t*>(msgBuf);
+    uint8_t* _newMsgBuf = MsgBufPool::Alloc(bufSize + 7);
+    uint8_t* newBuf = reinterpret_cast<uint8_t*>((uintptr_t)(_newMsgBuf + 7) & ~7);
+    ::memcpy(newBuf, oldBuf, (copyLen < bufSize) ? copyLen : bufSize);
+    bufEOD = newBuf + (bufEOD - oldBuf);
+    if (bufPos) {
+        bufPos = newBuf + (bufPos - oldBuf);
+    }
+    if (bodyPtr) {
+        bodyPtr = newBuf + (bodyPtr - oldBuf);
+    }
+    if ((writePtr >= oldBuf) && (writePtr <= (oldBuf + bufSize))) {
+        writePtr = newBuf + (writePtr - oldBuf);
+    }
+    /*
+     * The header fields and any unmarshaled args may still point into the original buffer so
+     * our reference to it is kept until the new buffer is released.
+     */
+    MsgBufPool::Retain(_newMsgBuf, _msgBuf);
+    _msgBuf = _newMsgBuf;
+    msgBuf = reinterpret_cast<uint64_t*>(newBuf);
+}
 
-QStatus _Message::ReMarshal(const char* senderName)
+QStatus _Message::ReMarshal(const char* senderName, uint32_t changedField)
 {
     if (senderName) {
         hdrFields.field[ALLJOYN_HDR_FIELD_SENDER].Set("s", senderName);
+        changedField = ALLJOYN_HDR_FIELD_SENDER;
     }
 
     /*
      * Remarshal invalidates any unmarshalled message args.
      */
-    delete [] msgArgs;
-    msgArgs = NULL;
-    numMsgArgs = 0;
+    ClearArgs();
+
+    /*
+     * If only one header field changed the others can be copied as they are.
+     */
+    if (ReMarshalHeaderField(changedField)) {
+        return ER_OK;
+    }
 
     /*
      * We delete the current buffer after we have copied the body data
@@ -415,7 +496,7 @@ QStatus _Message::ReMarshal(const char* senderName)
      * message reducing the places where we need to check for bufEOD when unmarshaling the body.
      */
     bufSize = sizeof(msgHeader) + ((((msgHeader.headerLen + 7) & ~7) + msgHeader.bodyLen + 7) & ~7) + 8;
-    _msgBuf = new uint8_t[bufSize + 7];
+    _msgBuf = MsgBufPool::Alloc(bufSize + 7);
     msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
     bufPos = (uint8_t*)msgBuf;
     memcpy(bufPos, &msgHeader, sizeof(msgHeader));
@@ -448,7 +529,7 @@ QStatus _Message::ReMarshal(const char* senderName)
      */
     assert((size_t)(bufEOD - (uint8_t*)msgBuf) < bufSize);
     memset(bufEOD, 0, (uint8_t*)msgBuf + bufSize - bufEOD);
-    delete [] _savBuf;
+    MsgBufPool::Free(_savBuf);
     return ER_OK;
 }
 
@@ -480,6 +561,19 @@ bool _Message::IsExpired(uint32_t* tillExpireMS) const
     return expires == 0;
 }
 
+/*
+ * Free the unmarshaled args - the top level args own nothing in the arena so they are deleted first.
+ */
+void _Message::ClearArgs()
+{
+    delete [] msgArgs;
+    msgArgs = NULL;
+    numMsgArgs = 0;
+    if (argArena) {
+        argArena->Reset();
+    }
+}
+
 /*
  * Clear the header fields - this also frees any data allocated to them.
  */
@@ -489,9 +583,9 @@ void _Message::ClearHeader()
         for (uint32_t fieldId = ALLJOYN_HDR_FIELD_INVALID; fieldId < ArraySize(hdrFields.field); fieldId++) {
             hdrFields.field[fieldId].Clear();
         }
-        delete [] msgArgs;
-        msgArgs = NULL;
-        numMsgArgs = 0;
+        hdrFields.ClearAtoms();
+        ClearArgs();
+        verifiedArgs = -1;
         ttl = 0;
         msgHeader.msgType = MESSAGE_INVALID;
         while (numHandles) {
@@ -0,0 +1,227 @@
+/**
+ * @file
+ * Capture of the complete messages received by endpoints for later replay.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/Debug.h>
+
+#include "MessageCapture.h"
+#include "LatencyHistogram.h"
+#include "RemoteEndpoint.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+volatile bool MessageCapture::enabled = false;
+
+qcc::Mutex MessageCapture::lock;
+
+qcc::FileSink* MessageCapture::sink = NULL;
+
+qcc::String MessageCapture::fileName;
+
+static void PutLE32(uint8_t* buf, uint32_t v)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        buf[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static void PutLE64(uint8_t* buf, uint64_t v)
+{
+    PutLE32(buf, static_cast<uint32_t>(v));
+    PutLE32(buf + 4, static_cast<uint32_t>(v >> 32));
+}
+
+static uint32_t GetLE32(const uint8_t* buf)
+{
+    return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
+           (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+}
+
+static uint64_t GetLE64(const uint8_t* buf)
+{
+    return static_cast<uint64_t>(GetLE32(buf)) | (static_cast<uint64_t>(GetLE32(buf + 4)) << 32);
+}
+
+/* Pull exactly len bytes, returns ER_EOF if there were none left and ER_BUS_BAD_BODY_LEN if there were too few */
+static QStatus PullAll(Source& source, void* buf, size_t len)
+{
+    uint8_t* pos = static_cast<uint8_t*>(buf);
+    size_t total = 0;
+    while (total < len) {
+        size_t pulled = 0;
+        QStatus status = source.PullBytes(pos + total, len - total, pulled);
+        if ((status == ER_EOF) || ((status == ER_OK) && (pulled == 0))) {
+            return (total == 0) ? ER_EOF : ER_BUS_BAD_BODY_LEN;
+        }
+        if (status != ER_OK) {
+            return status;
+        }
+        total += pulled;
+    }
+    return ER_OK;
+}
+
+QStatus MessageCapture::Start(const qcc::String& fileName)
+{
+    /* Captures hold message bodies so only the owner may read them */
+    FileSink* newSink = new FileSink(fileName, FileSink::PRIVATE);
+    QStatus status = newSink->IsValid() ? ER_OK : ER_BUS_WRITE_ERROR;
+    if (status == ER_OK) {
+        uint8_t hdr[8];
+        PutLE32(hdr, MAGIC);
+        PutLE32(hdr + 4, VERSION);
+        size_t pushed;
+        status = newSink->PushBytes(hdr, sizeof(hdr), pushed);
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Cannot write message capture %s", fileName.c_str()));
+        delete newSink;
+        return status;
+    }
+
+    lock.Lock(MUTEX_CONTEXT);
+    delete sink;
+    sink = newSink;
+    MessageCapture::fileName = fileName;
+    enabled = true;
+    lock.Unlock(MUTEX_CONTEXT);
+    QCC_DbgHLPrintf(("Capturing received messages to %s", fileName.c_str()));
+    return ER_OK;
+}
+
+void MessageCapture::Stop()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    enabled = false;
+    delete sink;
+    sink = NULL;
+    fileName.clear();
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+qcc::String MessageCapture::GetFileName()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    qcc::String name = fileName;
+    lock.Unlock(MUTEX_CONTEXT);
+    return name;
+}
+
+void MessageCapture::Record(const Message& msg, uint32_t endpoint)
+{
+    if (!enabled) {
+        return;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(msg->msgBuf);
+    size_t len = msg->bufEOD - bytes;
+    uint8_t hdr[RECORD_HEADER_SIZE];
+    PutLE64(hdr, GetLatencyClock());
+    PutLE32(hdr + 8, endpoint);
+    PutLE32(hdr + 12, static_cast<uint32_t>(len));
+
+    lock.Lock(MUTEX_CONTEXT);
+    if (sink) {
+        size_t pushed;
+        QStatus status = sink->PushBytes(hdr, sizeof(hdr), pushed);
+        if (status == ER_OK) {
+            status = sink->PushBytes(bytes, len, pushed);
+        }
+        if (status != ER_OK) {
+            /* A partial record would make the rest of the file unreadable so stop here */
+            QCC_LogError(status, ("Message capture write failed, capture stopped"));
+            enabled = false;
+            delete sink;
+            sink = NULL;
+            fileName.clear();
+        }
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus MessageCapture::SetSender(Message& msg, const qcc::String& sender)
+{
+    QStatus status = msg->ReMarshal(sender.c_str());
+    if (status == ER_OK) {
+        msg->SetSerialNumber();
+    }
+    return status;
+}
+
+MessageCapture::Reader::Reader(const qcc::String& fileName) : source(fileName), status(ER_OK)
+{
+    if (!source.IsValid()) {
+        status = ER_BUS_READ_ERROR;
+        QCC_LogError(status, ("Cannot read message capture %s", fileName.c_str()));
+        return;
+    }
+    uint8_t hdr[8];
+    status = PullAll(source, hdr, sizeof(hdr));
+    if ((status == ER_OK) && ((GetLE32(hdr) != MAGIC) || (GetLE32(hdr + 4) != VERSION))) {
+        status = ER_BUS_BAD_VALUE;
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("%s is not a supported message capture", fileName.c_str()));
+    }
+}
+
+QStatus MessageCapture::Reader::Read(BusAttachment& bus, RecordHeader& hdr, Message& msg)
+{
+    if (status != ER_OK) {
+        return status;
+    }
+    uint8_t buf[RECORD_HEADER_SIZE];
+    QStatus s = PullAll(source, buf, sizeof(buf));
+    if (s == ER_OK) {
+        hdr.timestamp = GetLE64(buf);
+        hdr.endpoint = GetLE32(buf + 8);
+        hdr.length = GetLE32(buf + 12);
+        vector<uint8_t> bytes(hdr.length);
+        s = hdr.length ? PullAll(source, &bytes[0], hdr.length) : ER_BUS_BAD_HEADER_LEN;
+        if (s == ER_EOF) {
+            s = ER_BUS_BAD_BODY_LEN;
+        }
+        if (s != ER_OK) {
+            /* Records cannot be found again after a short one */
+            status = s;
+            return s;
+        }
+        /* There is no endpoint to unmarshal from, a message is checked as if it came from a new one */
+        msg = Message(bus);
+        RemoteEndpoint noEndpoint;
+        s = msg->LoadBytes(&bytes[0], bytes.size());
+        if (s == ER_OK) {
+            s = msg->Unmarshal(noEndpoint, false);
+        }
+    } else if (s != ER_EOF) {
+        status = s;
+    }
+    return s;
+}
+
+}
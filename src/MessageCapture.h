@@ -0,0 +1,158 @@
+#ifndef _ALLJOYN_MESSAGECAPTURE_H
+#define _ALLJOYN_MESSAGECAPTURE_H
+/**
+ * @file
+ * Capture of the complete messages received by endpoints for later replay.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MessageCapture.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/FileStream.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * MessageCapture writes every message received by a remote or null endpoint to a file while it
+ * is started. Unlike MessageTrace, which keeps a few words per message, a capture holds the
+ * marshaled messages themselves so the traffic can be fed back into a bus later, see Reader and
+ * test/capreplay.
+ *
+ * A capture file is a header (MAGIC and VERSION as little endian 32 bit words) followed by one
+ * record per message: the RecordHeader fields in little endian order and then the marshaled
+ * message exactly as it was received. Capturing serializes every receiving endpoint on one lock
+ * and one write per message, so it is meant for recording a workload and is off by default.
+ */
+class MessageCapture {
+  public:
+
+    static const uint32_t MAGIC = 0x50434a41;   /**< "AJCP" */
+    static const uint32_t VERSION = 1;          /**< Capture file format version */
+
+    /** The fixed part of a capture record */
+    struct RecordHeader {
+        uint64_t timestamp;   /**< Latency clock time in microseconds at which the message was received */
+        uint32_t endpoint;    /**< MessageTrace::NameHash() of the unique name of the receiving endpoint */
+        uint32_t length;      /**< Length of the marshaled message that follows */
+    };
+
+    /** Size of a RecordHeader in a capture file */
+    static const size_t RECORD_HEADER_SIZE = 16;
+
+    /**
+     * @return  true if messages are being captured.
+     */
+    static bool IsEnabled() { return enabled; }
+
+    /**
+     * Start capturing to a file, replacing any capture in progress. The file is truncated.
+     *
+     * @param fileName   The capture file.
+     *
+     * @return  ER_OK, or ER_BUS_WRITE_ERROR if the file cannot be written.
+     */
+    static QStatus Start(const qcc::String& fileName);
+
+    /**
+     * Stop capturing and close the capture file.
+     */
+    static void Stop();
+
+    /**
+     * @return  The file being captured to, empty if capturing is stopped.
+     */
+    static qcc::String GetFileName();
+
+    /**
+     * Record a received message. Does nothing if capturing is stopped.
+     *
+     * @param msg        The message, which must be completely read.
+     * @param endpoint   NameHash() of the unique name of the endpoint that received it.
+     */
+    static void Record(const Message& msg, uint32_t endpoint);
+
+    /**
+     * Make a captured message look like it was sent by another bus name. Clears the serial number
+     * so the endpoint it is pushed to assigns a new one.
+     *
+     * @param msg      A message returned by Reader::Read().
+     * @param sender   The new sender.
+     *
+     * @return  ER_OK, or an error if the message cannot be remarshaled.
+     */
+    static QStatus SetSender(Message& msg, const qcc::String& sender);
+
+    /**
+     * Reads the records of a capture file in order.
+     */
+    class Reader {
+      public:
+
+        /**
+         * Open a capture file and check its header.
+         *
+         * @param fileName   The capture file.
+         */
+        Reader(const qcc::String& fileName);
+
+        /**
+         * @return  ER_OK if the file was opened and has a supported header, otherwise the error.
+         */
+        QStatus GetStatus() const { return status; }
+
+        /**
+         * Read the next record and unmarshal its message header.
+         *
+         * @param bus       The bus the message will be used on.
+         * @param[out] hdr  The fixed part of the record.
+         * @param[out] msg  The message.
+         *
+         * @return
+         *      - #ER_OK if a message was read
+         *      - #ER_EOF at the end of the capture
+         *      - #ER_BUS_BAD_BODY_LEN if the file is truncated
+         *      - An unmarshal error if the record holds a message that cannot be used on bus, in
+         *        which case the next call reads the following record.
+         */
+        QStatus Read(BusAttachment& bus, RecordHeader& hdr, Message& msg);
+
+      private:
+        qcc::FileSource source;
+        QStatus status;
+    };
+
+  private:
+    static volatile bool enabled;
+    static qcc::Mutex lock;
+    static qcc::FileSink* sink;
+    static qcc::String fileName;
+};
+
+}
+
+#endif
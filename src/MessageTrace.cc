@@ -0,0 +1,86 @@
+/**
+ * @file
+ * Always-on binary trace of the messages flowing through remote endpoints.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/atomic.h>
+
+#include "MessageTrace.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+volatile bool MessageTrace::enabled = true;
+
+volatile int32_t MessageTrace::claims = 0;
+
+MessageTrace::Event MessageTrace::ring[MessageTrace::RING_SIZE];
+
+void MessageTrace::Record(Stage stage, uint8_t type, uint32_t serial, const char* sender, const char* destination, uint32_t endpoint)
+{
+    if (!enabled) {
+        return;
+    }
+    uint32_t claim = static_cast<uint32_t>(IncrementAndFetch(&claims)) - 1;
+    Event& ev = ring[claim & (RING_SIZE - 1)];
+    ev.sequence = 0;
+    ev.timestamp = GetLatencyClock();
+    ev.serial = serial;
+    ev.sender = NameHash(sender);
+    ev.destination = NameHash(destination);
+    ev.endpoint = endpoint;
+    ev.type = type;
+    ev.stage = static_cast<uint8_t>(stage);
+    ev.reserved = 0;
+    ev.sequence = claim + 1;
+}
+
+void MessageTrace::Snapshot(vector<Event>& events)
+{
+    uint32_t end = static_cast<uint32_t>(claims);
+    uint32_t num = (end < RING_SIZE) ? end : RING_SIZE;
+    events.clear();
+    events.reserve(num);
+    for (uint32_t claim = end - num; claim != end; ++claim) {
+        const Event& ev = ring[claim & (RING_SIZE - 1)];
+        if (ev.sequence != claim + 1) {
+            /* Still being filled in or already overwritten */
+            continue;
+        }
+        events.push_back(ev);
+        /* Drop the copy if a writer claimed the slot while it was being copied */
+        if (ev.sequence != claim + 1) {
+            events.pop_back();
+        }
+    }
+}
+
+void MessageTrace::Clear()
+{
+    for (uint32_t i = 0; i < RING_SIZE; ++i) {
+        ring[i].sequence = 0;
+    }
+}
+
+}
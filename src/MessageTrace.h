@@ -0,0 +1,136 @@
+#ifndef _ALLJOYN_MESSAGETRACE_H
+#define _ALLJOYN_MESSAGETRACE_H
+/**
+ * @file
+ * Always-on binary trace of the messages flowing through remote endpoints.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MessageTrace.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+namespace ajn {
+
+/**
+ * MessageTrace is a fixed size ring of compact binary events, one per message per stage, shared
+ * by every thread in the process. Recording an event claims a slot with a single atomic
+ * increment and fills in a few words so it is cheap enough to leave on in production; the oldest
+ * events are overwritten once the ring is full. Names are recorded as NameHash() values and are
+ * resolved by whoever decodes a snapshot, normally from the names currently on the bus.
+ *
+ * Snapshot() can run concurrently with recording. An event that is overwritten while being
+ * copied is dropped from the snapshot rather than returned torn.
+ */
+class MessageTrace {
+  public:
+
+    /** Points on the message path at which events are recorded */
+    enum Stage {
+        TRACE_RX = 1,    /**< Unmarshaled by the receiving endpoint */
+        TRACE_ROUTED,    /**< Pushed to the router by the receiving endpoint */
+        TRACE_QUEUED,    /**< Added to the transmit queue of the sending endpoint */
+        TRACE_TX,        /**< Completely written by the sending endpoint */
+        TRACE_DROPPED    /**< Not added to a full transmit queue */
+    };
+
+    /** A trace event */
+    struct Event {
+        uint64_t timestamp;           /**< Latency clock time in microseconds */
+        uint32_t serial;              /**< Message serial number */
+        uint32_t sender;              /**< NameHash() of the sender */
+        uint32_t destination;         /**< NameHash() of the destination, 0 for broadcast signals */
+        uint32_t endpoint;            /**< NameHash() of the unique name of the endpoint recording the event */
+        uint8_t type;                 /**< AllJoynMessageType */
+        uint8_t stage;                /**< Stage */
+        uint16_t reserved;            /**< Pads the event to 32 bytes */
+        volatile uint32_t sequence;   /**< Claim number plus one, 0 while the slot is being filled */
+    };
+
+    /** Number of events held by the ring, must be a power of two */
+    static const uint32_t RING_SIZE = 4096;
+
+    /**
+     * Hash a bus name for a trace event. This is 32 bit FNV-1a so a decoder can compute it
+     * without linking against the daemon.
+     *
+     * @param name   The name, may be NULL.
+     *
+     * @return  The hash, 0 for a NULL or empty name.
+     */
+    static uint32_t NameHash(const char* name)
+    {
+        if (!name || !*name) {
+            return 0;
+        }
+        uint32_t hash = 2166136261U;
+        while (*name) {
+            hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619U;
+        }
+        return hash;
+    }
+
+    /**
+     * @return  true if events are being recorded.
+     */
+    static bool IsEnabled() { return enabled; }
+
+    /**
+     * Enable or disable recording. Recording is enabled by default.
+     *
+     * @param enable   true to record events.
+     */
+    static void Enable(bool enable) { enabled = enable; }
+
+    /**
+     * Record an event. Does nothing if recording is disabled.
+     *
+     * @param stage         The stage.
+     * @param type          The message type.
+     * @param serial        The message serial number.
+     * @param sender        The message sender, may be NULL.
+     * @param destination   The message destination, may be NULL.
+     * @param endpoint      NameHash() of the unique name of the endpoint recording the event.
+     */
+    static void Record(Stage stage, uint8_t type, uint32_t serial, const char* sender, const char* destination, uint32_t endpoint);
+
+    /**
+     * Copy the events currently in the ring.
+     *
+     * @param events   Returns the events, oldest first.
+     */
+    static void Snapshot(std::vector<Event>& events);
+
+    /**
+     * Discard all events.
+     */
+    static void Clear();
+
+  private:
+    static volatile bool enabled;
+    static volatile int32_t claims;
+    static Event ring[RING_SIZE];
+};
+
+}
+
+#endif
@@ -31,6 +31,7 @@
 
 #include <alljoyn/DBusStd.h>
 #include <alljoyn/AllJoynStd.h>
+#include <alljoyn/BusObject.h>
 #include <alljoyn/Message.h>
 #include <alljoyn/MsgArg.h>
 
@@ -42,7 +43,11 @@
 #include "AllJoynCrypto.h"
 #include "AllJoynPeerObj.h"
 #include "SignatureUtils.h"
+#include "EndianSwapArray.h"
 #include "BusInternal.h"
+#include "AtomTable.h"
+#include "MsgBufPool.h"
+#include "BodyCompressor.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -114,6 +119,31 @@ static inline QStatus CheckedArraySize(size_t sz, uint32_t& len)
     }
 }
 
+/*
+ * Check an array element has the array's element signature.  Arrays of basic types and of
+ * dictionary entries with basic keys and values are by far the most common, and for those
+ * comparing type ids gives the same answer as building the element's signature and comparing
+ * strings, which is what MsgArg::HasSignature() has to do in general.
+ */
+static inline bool IsSingleCharType(char c)
+{
+    return SignatureUtils::IsBasicType((AllJoynTypeId)c) || (c == ALLJOYN_VARIANT);
+}
+
+static bool ElementHasSignature(const MsgArg& elem, const char* elemSig)
+{
+    if (IsSingleCharType(elemSig[0]) && (elemSig[1] == 0)) {
+        return elem.typeId == (AllJoynTypeId)elemSig[0];
+    }
+    if ((elemSig[0] == ALLJOYN_DICT_ENTRY_OPEN) && IsSingleCharType(elemSig[1]) && IsSingleCharType(elemSig[2]) &&
+        (elemSig[3] == ALLJOYN_DICT_ENTRY_CLOSE) && (elemSig[4] == 0)) {
+        return (elem.typeId == ALLJOYN_DICT_ENTRY) &&
+               elem.v_dictEntry.key && (elem.v_dictEntry.key->typeId == (AllJoynTypeId)elemSig[1]) &&
+               elem.v_dictEntry.val && (elem.v_dictEntry.val->typeId == (AllJoynTypeId)elemSig[2]);
+    }
+    return elem.HasSignature(elemSig);
+}
+
 QStatus _Message::MarshalArgs(const MsgArg* arg, size_t numArgs)
 {
     QStatus status = ER_OK;
@@ -157,7 +187,7 @@ QStatus _Message::MarshalArgs(const MsgArg* arg, size_t numArgs)
                  * Check elements conform to the expected signature type
                  */
                 for (size_t i = 0; i < arg->v_array.numElements; i++) {
-                    if (!arg->v_array.elements[i].HasSignature(arg->v_array.GetElemSig())) {
+                    if (!ElementHasSignature(arg->v_array.elements[i], arg->v_array.GetElemSig())) {
                         status = ER_BUS_BAD_VALUE;
                         QCC_LogError(status, ("Array element[%d] does not have expected signature \"%s\"", i, arg->v_array.GetElemSig()));
                         break;
@@ -233,9 +263,8 @@ QStatus _Message::MarshalArgs(const MsgArg* arg, size_t numArgs)
             }
             if (endianSwap) {
                 MarshalReversed(&len, 4);
-                for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                    MarshalReversed(&arg->v_scalarArray.v_uint32[i], 4);
-                }
+                EndianSwapArray32(bufPos, arg->v_scalarArray.v_uint32, arg->v_scalarArray.numElements);
+                bufPos += len;
             } else {
                 Marshal4(len);
                 MarshalBytes(arg->v_scalarArray.v_uint32, len);
@@ -257,9 +286,8 @@ QStatus _Message::MarshalArgs(const MsgArg* arg, size_t numArgs)
                 if (endianSwap) {
                     MarshalReversed(&len, 4);
                     MarshalPad(8);
-                    for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                        MarshalReversed(&arg->v_scalarArray.v_uint64[i], 8);
-                    }
+                    EndianSwapArray64(bufPos, arg->v_scalarArray.v_uint64, arg->v_scalarArray.numElements);
+                    bufPos += len;
                 } else {
                     Marshal4(len);
                     MarshalPad(8);
@@ -284,9 +312,8 @@ QStatus _Message::MarshalArgs(const MsgArg* arg, size_t numArgs)
             }
             if (endianSwap) {
                 MarshalReversed(&len, 4);
-                for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                    MarshalReversed(&arg->v_scalarArray.v_uint16[i], 2);
-                }
+                EndianSwapArray16(bufPos, arg->v_scalarArray.v_uint16, arg->v_scalarArray.numElements);
+                bufPos += len;
             } else {
                 Marshal4(len);
                 MarshalBytes(arg->v_scalarArray.v_uint16, len);
@@ -517,7 +544,7 @@ QStatus _Message::Deliver(RemoteEndpoint& endpoint)
     return status;
 }
 
-QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint)
+QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint, uint32_t linkTtl)
 {
     size_t pushed;
     QStatus status = ER_OK;
@@ -561,13 +588,24 @@ QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint)
                 return ER_OK;
             }
         }
+        /*
+         * Large bodies are compressed on links that negotiated it
+         */
+        if ((status == ER_OK) && endpoint->GetFeatures().bodyCompression && IsBodyCompressible() && CompressBody()) {
+            writePtr = reinterpret_cast<uint8_t*>(msgBuf);
+            countWrite = bufEOD - writePtr;
+        }
         writeState = MESSAGE_HEADERFIELDS;
 
     case MESSAGE_HEADERFIELDS:
         if (handles) {
             status = sink.PushBytesAndFds(writePtr, countWrite, pushed, handles, numHandles, endpoint->GetProcessId());
         } else {
-            status = sink.PushBytes(writePtr, countWrite, pushed, (msgHeader.flags & ALLJOYN_FLAG_SESSIONLESS) ? (ttl * 1000) : ttl);
+            uint32_t sinkTtl = (msgHeader.flags & ALLJOYN_FLAG_SESSIONLESS) ? (ttl * 1000) : ttl;
+            if (linkTtl && (!sinkTtl || (linkTtl < sinkTtl))) {
+                sinkTtl = linkTtl;
+            }
+            status = sink.PushBytes(writePtr, countWrite, pushed, sinkTtl);
         }
 
         if (status == ER_OK) {
@@ -617,6 +655,84 @@ static const uint8_t FieldTypeMapping[] = {
     19  /* ALLJOYN_HDR_FIELD_SESSION_ID        */
 };
 
+/*
+ * Marshal one header field. After the field is marshaled any string in the MsgArg points into
+ * the buffer.
+ */
+void _Message::MarshalHeaderField(uint32_t fieldId)
+{
+    MsgArg* field = &hdrFields.field[fieldId];
+    /*
+     * Header fields align on an 8 byte boundary
+     */
+    MarshalPad(8);
+    Marshal1(FieldTypeMapping[fieldId]);
+    /*
+     * We relocate the string pointers in the fields to point to the marshaled versions to
+     * so the lifetime of the message is not bound to the lifetime of values passed in.
+     */
+    const char* tPos;
+    uint32_t tLen;
+    AllJoynTypeId id = field->typeId;
+    switch (id) {
+    case ALLJOYN_SIGNATURE:
+        Marshal1(1);
+        Marshal1((uint8_t)ALLJOYN_SIGNATURE);
+        Marshal1(0);
+        Marshal1(field->v_signature.len);
+        tPos = (char*)bufPos;
+        tLen = field->v_signature.len;
+        MarshalBytes((void*)field->v_signature.sig, field->v_signature.len + 1);
+        field->Clear();
+        field->typeId = ALLJOYN_SIGNATURE;
+        field->v_signature.sig = tPos;
+        field->v_signature.len = tLen;
+        break;
+
+    case ALLJOYN_UINT32:
+        Marshal1(1);
+        Marshal1((uint8_t)ALLJOYN_UINT32);
+        Marshal1(0);
+        if (endianSwap) {
+            MarshalReversed(&field->v_uint32, 4);
+        } else {
+            Marshal4(field->v_uint32);
+        }
+        break;
+
+    case ALLJOYN_OBJECT_PATH:
+    case ALLJOYN_STRING:
+        Marshal1(1);
+        Marshal1((uint8_t)id);
+        Marshal1(0);
+        if (endianSwap) {
+            MarshalReversed(&field->v_string.len, 4);
+        } else {
+            Marshal4(field->v_string.len);
+        }
+        tPos = (char*)bufPos;
+        tLen = field->v_string.len;
+        MarshalBytes((void*)field->v_string.str, field->v_string.len + 1);
+        field->Clear();
+        field->typeId = id;
+        field->v_string.str = tPos;
+        field->v_string.len = tLen;
+        break;
+
+    default:
+        /*
+         * Use standard variant marshaling for the other cases.
+         */
+    {
+        MsgArg variant(ALLJOYN_VARIANT);
+        variant.v_variant.val = field;
+        MarshalArgs(&variant, 1);
+        variant.v_variant.val = NULL;
+    }
+    break;
+    }
+}
+
 /*
  * After the header fields are marshaled all of the strings in the MsgArgs point into the buffer.
  */
@@ -635,81 +751,204 @@ void _Message::MarshalHeaderFields()
                 field->Stabilize();
                 continue;
             }
-            /*
-             * Header fields align on an 8 byte boundary
-             */
-            MarshalPad(8);
-            Marshal1(FieldTypeMapping[fieldId]);
-            /*
-             * We relocate the string pointers in the fields to point to the marshaled versions to
-             * so the lifetime of the message is not bound to the lifetime of values passed in.
-             */
-            const char* tPos;
-            uint32_t tLen;
-            AllJoynTypeId id = field->typeId;
-            switch (id) {
-            case ALLJOYN_SIGNATURE:
-                Marshal1(1);
-                Marshal1((uint8_t)ALLJOYN_SIGNATURE);
-                Marshal1(0);
-                Marshal1(field->v_signature.len);
-                tPos = (char*)bufPos;
-                tLen = field->v_signature.len;
-                MarshalBytes((void*)field->v_signature.sig, field->v_signature.len + 1);
-                field->Clear();
-                field->typeId = ALLJOYN_SIGNATURE;
-                field->v_signature.sig = tPos;
-                field->v_signature.len = tLen;
-                break;
+            MarshalHeaderField(fieldId);
+        }
+    }
+    /*
+     * Header must be zero-padded to end on an 8 byte boundary
+     */
+    MarshalPad(8);
+}
 
-            case ALLJOYN_UINT32:
-                Marshal1(1);
-                Marshal1((uint8_t)ALLJOYN_UINT32);
-                Marshal1(0);
-                if (endianSwap) {
-                    MarshalReversed(&field->v_uint32, 4);
-                } else {
-                    Marshal4(field->v_uint32);
-                }
-                break;
+/*
+ * Size of the marshaled header field at pos or 0 if the field is malformed or has a type that is
+ * not used by any header field.
+ */
+static size_t MarshaledHeaderFieldSize(const uint8_t* pos, const uint8_t* end, bool endianSwap)
+{
+    const uint8_t* p = pos + 4;
+    if ((p > end) || (pos[1] != 1) || (pos[3] != 0)) {
+        return 0;
+    }
+    uint32_t len;
+    switch (pos[2]) {
+    case ALLJOYN_OBJECT_PATH:
+    case ALLJOYN_STRING:
+        p = (const uint8_t*)(((uintptr_t)p + 3) & ~3);
+        if ((p + 4) > end) {
+            return 0;
+        }
+        memcpy(&len, p, 4);
+        if (endianSwap) {
+            len = EndianSwap32(len);
+        }
+        p += 4 + len + 1;
+        break;
 
-            case ALLJOYN_OBJECT_PATH:
-            case ALLJOYN_STRING:
-                Marshal1(1);
-                Marshal1((uint8_t)id);
-                Marshal1(0);
-                if (endianSwap) {
-                    MarshalReversed(&field->v_string.len, 4);
-                } else {
-                    Marshal4(field->v_string.len);
-                }
-                tPos = (char*)bufPos;
-                tLen = field->v_string.len;
-                MarshalBytes((void*)field->v_string.str, field->v_string.len + 1);
-                field->Clear();
-                field->typeId = id;
-                field->v_string.str = tPos;
-                field->v_string.len = tLen;
-                break;
+    case ALLJOYN_SIGNATURE:
+        p += 1 + *p + 1;
+        break;
 
-            default:
-                /*
-                 * Use standard variant marshaling for the other cases.
-                 */
-            {
-                MsgArg variant(ALLJOYN_VARIANT);
-                variant.v_variant.val = field;
-                MarshalArgs(&variant, 1);
-                variant.v_variant.val = NULL;
+    case ALLJOYN_UINT32:
+        p = (const uint8_t*)(((uintptr_t)p + 3) & ~3) + 4;
+        break;
+
+    case ALLJOYN_UINT16:
+        p = (const uint8_t*)(((uintptr_t)p + 1) & ~1) + 2;
+        break;
+
+    default:
+        return 0;
+    }
+    return (p > end) ? 0 : (p - pos);
+}
+
+/*
+ * Check that a header field still has the value marshaled at pos.
+ */
+static bool HeaderFieldMatches(const MsgArg& field, const uint8_t* pos, size_t sz, bool endianSwap)
+{
+    if (pos[2] != (uint8_t)field.typeId) {
+        return false;
+    }
+    const uint8_t* val = pos + sz;
+    switch (field.typeId) {
+    case ALLJOYN_OBJECT_PATH:
+    case ALLJOYN_STRING:
+        return field.v_string.str == (const char*)(val - field.v_string.len - 1);
+
+    case ALLJOYN_SIGNATURE:
+        return field.v_signature.sig == (const char*)(val - field.v_signature.len - 1);
+
+    case ALLJOYN_UINT32:
+    {
+        uint32_t v;
+        memcpy(&v, val - 4, 4);
+        return (endianSwap ? EndianSwap32(v) : v) == field.v_uint32;
+    }
+
+    case ALLJOYN_UINT16:
+    {
+        uint16_t v;
+        memcpy(&v, val - 2, 2);
+        return (endianSwap ? EndianSwap16(v) : v) == field.v_uint16;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/*
+ * Rebuild the header after a single header field has changed. The other fields are copied from
+ * the current buffer as they are rather than being marshaled again. Returns false if the header
+ * cannot be patched, for example because it is compressed, in which case the caller must
+ * marshal the whole header.
+ */
+bool _Message::ReMarshalHeaderField(uint32_t fieldId)
+{
+    if ((fieldId <= ALLJOYN_HDR_FIELD_INVALID) || (fieldId >= ArraySize(hdrFields.field)) || !msgBuf || (msgHeader.flags & ALLJOYN_FLAG_COMPRESSED)) {
+        return false;
+    }
+    uint8_t* oldBuf = (uint8_t*)msgBuf;
+    const uint8_t* pos = oldBuf + sizeof(msgHeader);
+    const uint8_t* end = pos + msgHeader.headerLen;
+    const uint8_t* limit = bodyPtr ? bodyPtr : bufEOD;
+    if (!limit || (end > limit)) {
+        return false;
+    }
+    /*
+     * Find the marshaled fields to keep, every field other than the changed one must be on the
+     * wire exactly once because ReMarshal() would marshal all of them.
+     */
+    const uint8_t* spanPos[ALLJOYN_HDR_FIELD_UNKNOWN];
+    size_t spanLen[ALLJOYN_HDR_FIELD_UNKNOWN];
+    uint32_t spanField[ALLJOYN_HDR_FIELD_UNKNOWN];
+    size_t numSpans = 0;
+    uint32_t seen = 0;
+    while (pos < end) {
+        size_t sz = MarshaledHeaderFieldSize(pos, end, endianSwap);
+        if (sz == 0) {
+            return false;
+        }
+        if (*pos != FieldTypeMapping[fieldId]) {
+            uint32_t id = ALLJOYN_HDR_FIELD_PATH;
+            while ((id < ArraySize(FieldTypeMapping)) && (FieldTypeMapping[id] != *pos)) {
+                ++id;
             }
-            break;
+            if ((id == ArraySize(FieldTypeMapping)) || (seen & (1 << id)) || !HeaderFieldMatches(hdrFields.field[id], pos, sz, endianSwap)) {
+                return false;
             }
+            seen |= (1 << id);
+            spanPos[numSpans] = pos;
+            spanLen[numSpans] = sz;
+            spanField[numSpans] = id;
+            ++numSpans;
+        }
+        pos += ROUNDUP8(sz);
+    }
+    for (uint32_t id = ALLJOYN_HDR_FIELD_PATH; id < ArraySize(hdrFields.field); ++id) {
+        if ((id != fieldId) && (hdrFields.field[id].typeId != ALLJOYN_INVALID) && !(seen & (1 << id))) {
+            return false;
         }
     }
     /*
-     * Header must be zero-padded to end on an 8 byte boundary
+     * The changed field goes after the fields that are kept.
      */
+    MsgArg* field = &hdrFields.field[fieldId];
+    size_t hdrLen = 0;
+    for (size_t i = 0; i < numSpans; ++i) {
+        hdrLen = ROUNDUP8(hdrLen) + spanLen[i];
+    }
+    if (field->typeId != ALLJOYN_INVALID) {
+        hdrLen = ROUNDUP8(hdrLen) + SignatureUtils::GetSize(field, 1, 4);
+    }
+    msgHeader.headerLen = static_cast<uint32_t>(hdrLen);
+
+    uint8_t* _savBuf = _msgBuf;
+    bufSize = sizeof(msgHeader) + ((ROUNDUP8(hdrLen) + msgHeader.bodyLen + 7) & ~7) + 8;
+    _msgBuf = MsgBufPool::Alloc(bufSize + 7);
+    msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
+    bufPos = (uint8_t*)msgBuf;
+    memcpy(bufPos, &msgHeader, sizeof(msgHeader));
+    bufPos += sizeof(msgHeader);
+    if (endianSwap) {
+        MessageHeader* hdr = (MessageHeader*)msgBuf;
+        hdr->bodyLen = EndianSwap32(hdr->bodyLen);
+        hdr->serialNum = EndianSwap32(hdr->serialNum);
+        hdr->headerLen = EndianSwap32(hdr->headerLen);
+    }
+    for (size_t i = 0; i < numSpans; ++i) {
+        MarshalPad(8);
+        /*
+         * Strings in the kept fields move with them
+         */
+        MsgArg& kept = hdrFields.field[spanField[i]];
+        ptrdiff_t delta = bufPos - spanPos[i];
+        if (kept.typeId == ALLJOYN_SIGNATURE) {
+            kept.v_signature.sig += delta;
+        } else if ((kept.typeId == ALLJOYN_STRING) || (kept.typeId == ALLJOYN_OBJECT_PATH)) {
+            kept.v_string.str += delta;
+        }
+        MarshalBytes(spanPos[i], spanLen[i]);
+    }
+    if (field->typeId != ALLJOYN_INVALID) {
+        MarshalHeaderField(fieldId);
+    }
     MarshalPad(8);
+    assert((bufPos - (uint8_t*)msgBuf) == static_cast<ptrdiff_t>(ROUNDUP8(sizeof(msgHeader) + hdrLen)));
+    /*
+     * Copy in the body if there was one
+     */
+    if (msgHeader.bodyLen != 0) {
+        memcpy(bufPos, bodyPtr, msgHeader.bodyLen);
+    }
+    bodyPtr = bufPos;
+    bufPos += msgHeader.bodyLen;
+    bufEOD = bufPos;
+    memset(bufEOD, 0, (uint8_t*)msgBuf + bufSize - bufEOD);
+    MsgBufPool::Free(_savBuf);
+    return true;
 }
 
 
@@ -750,7 +989,18 @@ QStatus _Message::EncryptMessage()
     if (status == ER_OK) {
         size_t argsLen = msgHeader.bodyLen - ajn::Crypto::MACLength;
         size_t hdrLen = ROUNDUP8(sizeof(msgHeader) + msgHeader.headerLen);
-        status = ajn::Crypto::Encrypt(*this, key, (uint8_t*)msgBuf, hdrLen, argsLen);
+        /*
+         * If the buffer is shared only the header is copied, the encryption writes the body into
+         * the new buffer directly from the shared one. The MAC space was reserved when the message
+         * was marshaled so the encryption never needs to grow the buffer.
+         */
+        const uint8_t* plainBody = (uint8_t*)msgBuf + hdrLen;
+        MakeBufWritable(hdrLen);
+        uint8_t* body = (uint8_t*)msgBuf + hdrLen;
+        status = ajn::Crypto::Encrypt(*this, key, (uint8_t*)msgBuf, hdrLen, argsLen, (plainBody != body) ? plainBody : NULL);
+        if ((status != ER_OK) && (plainBody != body)) {
+            memcpy(body, plainBody, msgHeader.bodyLen - ajn::Crypto::MACLength);
+        }
         if (status == ER_OK) {
             QCC_DbgHLPrintf(("EncryptMessage: %s", Description().c_str()));
             /*
@@ -777,6 +1027,50 @@ QStatus _Message::EncryptMessage()
     return status;
 }
 
+bool _Message::IsBodyCompressible() const
+{
+    return (msgHeader.bodyLen >= BodyCompressor::THRESHOLD) && !handles && !(msgHeader.flags & (ALLJOYN_FLAG_ENCRYPTED | ALLJOYN_FLAG_BODY_COMPRESSED));
+}
+
+bool _Message::CompressBody()
+{
+    uint8_t* oldBuf = reinterpret_cast<uint8_t*>(msgBuf);
+    size_t hdrLen = ROUNDUP8(sizeof(msgHeader) + msgHeader.headerLen);
+    uint32_t bodyLen = msgHeader.bodyLen;
+    /*
+     * The compressed body is prefixed by the expanded length. Unless this saves at least an
+     * eighth of the body the message is sent as it is.
+     */
+    uint8_t* _newMsgBuf = MsgBufPool::Alloc(bufSize + 7);
+    uint8_t* newBuf = reinterpret_cast<uint8_t*>((uintptr_t)(_newMsgBuf + 7) & ~7);
+    size_t maxLen = bodyLen - (bodyLen / 8) - sizeof(bodyLen);
+    size_t packedLen = BodyCompressor::Compress(oldBuf + hdrLen, bodyLen, newBuf + hdrLen + sizeof(bodyLen), maxLen);
+    if (packedLen == 0) {
+        MsgBufPool::Free(_newMsgBuf);
+        return false;
+    }
+    QCC_DbgPrintf(("CompressBody: %u bytes compressed to %u", bodyLen, packedLen));
+    memcpy(newBuf, oldBuf, hdrLen);
+    uint32_t expandedLen = endianSwap ? EndianSwap32(bodyLen) : bodyLen;
+    memcpy(newBuf + hdrLen, &expandedLen, sizeof(expandedLen));
+    msgHeader.bodyLen = static_cast<uint32_t>(packedLen + sizeof(bodyLen));
+    msgHeader.flags |= ALLJOYN_FLAG_BODY_COMPRESSED;
+    MessageHeader* hdr = reinterpret_cast<MessageHeader*>(newBuf);
+    hdr->flags |= ALLJOYN_FLAG_BODY_COMPRESSED;
+    hdr->bodyLen = endianSwap ? EndianSwap32(msgHeader.bodyLen) : msgHeader.bodyLen;
+    bodyPtr = newBuf + hdrLen;
+    bufPos = bodyPtr;
+    bufEOD = bodyPtr + msgHeader.bodyLen;
+    memset(bufEOD, 0, newBuf + bufSize - bufEOD);
+    /*
+     * The header fields may point into the original buffer
+     */
+    MsgBufPool::Retain(_newMsgBuf, _msgBuf);
+    _msgBuf = _newMsgBuf;
+    msgBuf = reinterpret_cast<uint64_t*>(newBuf);
+    return true;
+}
+
 QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
                                  const qcc::String& destination,
                                  AllJoynMessageType msgType,
@@ -869,8 +1163,11 @@ QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
             hdrFields.field[ALLJOYN_HDR_FIELD_SIGNATURE].v_signature.sig = signature;
             hdrFields.field[ALLJOYN_HDR_FIELD_SIGNATURE].v_signature.len = (uint8_t)sigLen;
         }
+        /* The signature was built from the args so it is valid */
+        verifiedArgs = static_cast<int32_t>(numArgs);
     } else {
         signature[0] = 0;
+        verifiedArgs = 0;
     }
     /*
      * Check the signature computed from the args matches the expected signature.
@@ -911,7 +1208,7 @@ QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
      * Allocate buffer for entire message.
      */
     bufSize = (hdrLen + msgHeader.bodyLen + 7);
-    _msgBuf = new uint8_t[bufSize + 7];
+    _msgBuf = MsgBufPool::Alloc(bufSize + 7);
     msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
     /*
      * Initialize the buffer and copy in the message header
@@ -962,7 +1259,7 @@ QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
      */
     if (handles) {
         hdrFields.field[ALLJOYN_HDR_FIELD_HANDLES].Set("u", numHandles);
-        status = ReMarshal(NULL);
+        status = ReMarshal(NULL, ALLJOYN_HDR_FIELD_HANDLES);
         if (status != ER_OK) {
             goto ExitMarshalMessage;
         }
@@ -982,14 +1279,15 @@ ExitMarshalMessage:
     /*
      * Don't need the old message buffer any more
      */
-    delete [] _oldMsgBuf;
+    MsgBufPool::Free(_oldMsgBuf);
 
     if (status == ER_OK) {
+        AtomTable::SetHeaderAtoms(hdrFields);
         QCC_DbgHLPrintf(("MarshalMessage: %d+%d %s %s", hdrLen, msgHeader.bodyLen, Description().c_str(), encrypt ? " (encrypted)" : ""));
     } else {
         QCC_LogError(status, ("MarshalMessage: %s", Description().c_str()));
         msgBuf = NULL;
-        delete [] _msgBuf;
+        MsgBufPool::Free(_msgBuf);
         _msgBuf = NULL;
         bodyPtr = NULL;
         bufPos = NULL;
@@ -1217,6 +1515,161 @@ ExitSignalMsg:
     return status;
 }
 
+/*
+ * Copy a marshaled header field moving any string it references from one header buffer to
+ * another. The copy does not own the string.
+ */
+static void RelocateHeaderField(MsgArg& dest, const MsgArg& src, const uint8_t* from, uint8_t* to)
+{
+    dest.Clear();
+    dest.typeId = src.typeId;
+    switch (src.typeId) {
+    case ALLJOYN_SIGNATURE:
+        dest.v_signature.len = src.v_signature.len;
+        dest.v_signature.sig = (const char*)(to + ((const uint8_t*)src.v_signature.sig - from));
+        break;
+
+    case ALLJOYN_OBJECT_PATH:
+    case ALLJOYN_STRING:
+        dest.v_string.len = src.v_string.len;
+        dest.v_string.str = (const char*)(to + ((const uint8_t*)src.v_string.str - from));
+        break;
+
+    case ALLJOYN_UINT16:
+        dest.v_uint16 = src.v_uint16;
+        break;
+
+    default:
+        dest.v_uint32 = src.v_uint32;
+        break;
+    }
+}
+
+QStatus _Message::SignalMsg(SignalTemplate& tmpl, const BusObject* sender, const qcc::String& objPath, const MsgArg* args, size_t numArgs)
+{
+    QStatus status;
+    const qcc::String& senderName = bus->GetInternal().GetLocalEndpoint()->GetUniqueName();
+
+    if (!tmpl.hdr || (tmpl.owner != sender) || (tmpl.endian != outEndian) || (tmpl.sender != senderName)) {
+        /*
+         * Marshal the complete message and save the header for next time.
+         */
+        status = SignalMsg(tmpl.signal.signature, tmpl.destination.c_str(), tmpl.sessionId, objPath,
+                           tmpl.signal.iface->GetName(), tmpl.signal.name, args, numArgs, tmpl.flags, 0);
+        if ((status != ER_OK) || handles || (tmpl.flags & ALLJOYN_FLAG_COMPRESSED)) {
+            return status;
+        }
+        size_t hdrLen = (bodyPtr ? bodyPtr : bufEOD) - (uint8_t*)msgBuf;
+        delete [] tmpl.hdr;
+        tmpl.hdr = new uint64_t[(hdrLen + 7) / 8];
+        tmpl.hdrLen = hdrLen;
+        memcpy(tmpl.hdr, msgBuf, hdrLen);
+        for (size_t fieldId = ALLJOYN_HDR_FIELD_INVALID; fieldId < ArraySize(hdrFields.field); ++fieldId) {
+            RelocateHeaderField(tmpl.hdrFields.field[fieldId], hdrFields.field[fieldId], (const uint8_t*)msgBuf, (uint8_t*)tmpl.hdr);
+            tmpl.hdrFields.atoms[fieldId] = hdrFields.atoms[fieldId];
+        }
+        tmpl.owner = sender;
+        tmpl.endian = outEndian;
+        tmpl.sender = senderName;
+        return ER_OK;
+    }
+
+    if (!bus->IsStarted()) {
+        return ER_BUS_BUS_NOT_STARTED;
+    }
+    /*
+     * The signature in the saved header must match the args.
+     */
+    char signature[256];
+    size_t sigLen = 0;
+    if (numArgs > 0) {
+        status = SignatureUtils::MakeSignature(args, numArgs, signature, sigLen);
+        if (status != ER_OK) {
+            return status;
+        }
+    } else {
+        signature[0] = 0;
+    }
+    if (tmpl.signal.signature != signature) {
+        status = ER_BUS_UNEXPECTED_SIGNATURE;
+        QCC_LogError(status, ("SignalMsg expected signature \"%s\" got \"%s\"", tmpl.signal.signature.c_str(), signature));
+        return status;
+    }
+    size_t argsLen = (numArgs == 0) ? 0 : SignatureUtils::GetSize(args, numArgs);
+    if ((tmpl.hdrLen + argsLen) > ALLJOYN_MAX_PACKET_LEN) {
+        status = ER_BUS_BAD_BODY_LEN;
+        QCC_LogError(status, ("Message size %d exceeds maximum size", tmpl.hdrLen + argsLen));
+        return status;
+    }
+
+    ClearHeader();
+    uint8_t* _oldMsgBuf = _msgBuf;
+    endianSwap = outEndian != myEndian;
+    encrypt = (tmpl.flags & ALLJOYN_FLAG_ENCRYPTED) ? true : false;
+    /*
+     * Recover the message header, it is stored in message endianess.
+     */
+    memcpy(&msgHeader, tmpl.hdr, sizeof(msgHeader));
+    if (endianSwap) {
+        msgHeader.headerLen = EndianSwap32(msgHeader.headerLen);
+    }
+    msgHeader.flags = tmpl.flags;
+    msgHeader.bodyLen = static_cast<uint32_t>(encrypt ? (argsLen + ajn::Crypto::MACLength) : argsLen);
+    msgBuf = NULL;
+    SetSerialNumber();
+    ttl = 0;
+    /*
+     * Copy in the saved header and patch the body length and serial number. The buffer has the
+     * same zeroed tail pad as a buffer that was read in.
+     */
+    bufSize = ((tmpl.hdrLen + msgHeader.bodyLen + 7) & ~7) + 8;
+    _msgBuf = MsgBufPool::Alloc(bufSize + 7);
+    msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
+    memcpy(msgBuf, tmpl.hdr, tmpl.hdrLen);
+    MessageHeader* hdr = (MessageHeader*)msgBuf;
+    hdr->bodyLen = endianSwap ? EndianSwap32(msgHeader.bodyLen) : msgHeader.bodyLen;
+    hdr->serialNum = endianSwap ? EndianSwap32(msgHeader.serialNum) : msgHeader.serialNum;
+    for (size_t fieldId = ALLJOYN_HDR_FIELD_INVALID; fieldId < ArraySize(hdrFields.field); ++fieldId) {
+        RelocateHeaderField(hdrFields.field[fieldId], tmpl.hdrFields.field[fieldId], (const uint8_t*)tmpl.hdr, (uint8_t*)msgBuf);
+        hdrFields.atoms[fieldId] = tmpl.hdrFields.atoms[fieldId];
+    }
+    bufPos = (uint8_t*)msgBuf + tmpl.hdrLen;
+    status = ER_OK;
+    if (msgHeader.bodyLen == 0) {
+        bufEOD = bufPos;
+        bodyPtr = NULL;
+    } else {
+        /*
+         * Marshal the message body
+         */
+        bodyPtr = bufPos;
+        status = MarshalArgs(args, numArgs);
+        if ((status == ER_OK) && handles) {
+            hdrFields.field[ALLJOYN_HDR_FIELD_HANDLES].Set("u", numHandles);
+            status = ReMarshal(NULL, ALLJOYN_HDR_FIELD_HANDLES);
+        }
+        if (status == ER_OK) {
+            bufEOD = bodyPtr + msgHeader.bodyLen;
+        }
+    }
+    MsgBufPool::Free(_oldMsgBuf);
+    if (status == ER_OK) {
+        memset(bufEOD, 0, (uint8_t*)msgBuf + bufSize - bufEOD);
+        AtomTable::SetHeaderAtoms(hdrFields);
+        QCC_DbgHLPrintf(("SignalMsg: %d+%d %s %s", tmpl.hdrLen, msgHeader.bodyLen, Description().c_str(), encrypt ? " (encrypted)" : ""));
+    } else {
+        QCC_LogError(status, ("SignalMsg: %s", Description().c_str()));
+        msgBuf = NULL;
+        MsgBufPool::Free(_msgBuf);
+        _msgBuf = NULL;
+        bodyPtr = NULL;
+        bufPos = NULL;
+        bufEOD = NULL;
+        ClearHeader();
+    }
+    return status;
+}
+
 
 QStatus _Message::ReplyMsg(const Message& call, const MsgArg* args, size_t numArgs)
 {
@@ -1365,8 +1818,9 @@ void _Message::ErrorMsg(QStatus status,
 QStatus _Message::GetExpansion(uint32_t token, MsgArg& replyArg)
 {
     QStatus status = ER_OK;
-    const HeaderFields* expFields = bus->GetInternal().GetCompressionRules()->GetExpansion(token);
-    if (expFields) {
+    HeaderFields expansion;
+    if (bus->GetInternal().GetCompressionRules()->GetExpansion(token, expansion)) {
+        const HeaderFields* expFields = &expansion;
         MsgArg* hdrArray = new MsgArg[ALLJOYN_HDR_FIELD_UNKNOWN];
         size_t numElements = 0;
         /*
@@ -1400,6 +1854,8 @@ QStatus _Message::GetExpansion(uint32_t token, MsgArg& replyArg)
                 break;
             }
             if (val) {
+                /* The expansion is a local copy so the reply must own its strings */
+                val->Stabilize();
                 uint8_t id = FieldTypeMapping[fieldId];
                 hdrArray[numElements].Set("(yv)", id, val);
                 hdrArray[numElements].SetOwnershipFlags(MsgArg::OwnsArgs);
@@ -1418,6 +1874,7 @@ void _Message::SetSerialNumber()
 {
     msgHeader.serialNum = bus->GetInternal().NextSerial();
     if (msgBuf) {
+        MakeBufWritable();
         ((MessageHeader*)msgBuf)->serialNum = endianSwap ? EndianSwap32(msgHeader.serialNum) : msgHeader.serialNum;
     }
 }
@@ -41,7 +41,13 @@
 #include "AllJoynCrypto.h"
 #include "AllJoynPeerObj.h"
 #include "SignatureUtils.h"
+#include "EndianSwapArray.h"
 #include "BusInternal.h"
+#include "AtomTable.h"
+#include "MsgArgArena.h"
+#include "MsgBufPool.h"
+#include "BodyCompressor.h"
+#include "ValidationCache.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -62,6 +68,95 @@ namespace ajn {
 
 #define VALID_HEADER_FIELD(f) (((f) > ALLJOYN_HDR_FIELD_INVALID) && ((f) < ALLJOYN_HDR_FIELD_UNKNOWN))
 
+/*
+ * Skip over one complete type in a signature that is already known to be valid.
+ */
+static inline void SkipVerifiedType(const char*& sigPtr)
+{
+    while (*sigPtr == ALLJOYN_ARRAY) {
+        ++sigPtr;
+    }
+    char c = *sigPtr++;
+    if ((c == ALLJOYN_STRUCT_OPEN) || (c == ALLJOYN_DICT_ENTRY_OPEN)) {
+        uint32_t depth = 1;
+        while (depth) {
+            c = *sigPtr++;
+            if ((c == ALLJOYN_STRUCT_OPEN) || (c == ALLJOYN_DICT_ENTRY_OPEN)) {
+                ++depth;
+            } else if ((c == ALLJOYN_STRUCT_CLOSE) || (c == ALLJOYN_DICT_ENTRY_CLOSE)) {
+                --depth;
+            }
+        }
+    }
+}
+
+/*
+ * Count the members of a struct or dict entry in a signature that is already known to be valid.
+ * On entry sigPtr points just past the opening character, on exit just past the closing one,
+ * which is where SignatureUtils::ParseContainerSignature() would have left it.
+ */
+static inline uint32_t CountVerifiedMembers(const char*& sigPtr)
+{
+    uint32_t members = 0;
+    while ((*sigPtr != ALLJOYN_STRUCT_CLOSE) && (*sigPtr != ALLJOYN_DICT_ENTRY_CLOSE)) {
+        SkipVerifiedType(sigPtr);
+        ++members;
+    }
+    ++sigPtr;
+    return members;
+}
+
+/*
+ * Size in bytes of a basic type that has a fixed size and needs no validation or translation
+ * when unmarshaled, 0 for any other type.
+ */
+static inline size_t FixedTypeSize(char typeId)
+{
+    switch (typeId) {
+    case ALLJOYN_BYTE:
+        return 1;
+
+    case ALLJOYN_INT16:
+    case ALLJOYN_UINT16:
+        return 2;
+
+    case ALLJOYN_INT32:
+    case ALLJOYN_UINT32:
+        return 4;
+
+    case ALLJOYN_INT64:
+    case ALLJOYN_UINT64:
+    case ALLJOYN_DOUBLE:
+        return 8;
+
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Determine if a struct signature such as "(tdd)" only has fixed size members. If it does, every
+ * element of an array of these structs has the same wire layout and returns the unpadded size of
+ * one struct.  The struct itself starts on an 8 byte boundary so member offsets only depend on
+ * the signature.
+ */
+static size_t FixedStructSize(const char* sig, size_t sigLen, uint32_t& numMembers)
+{
+    if ((sigLen < 3) || (sig[0] != ALLJOYN_STRUCT_OPEN) || (sig[sigLen - 1] != ALLJOYN_STRUCT_CLOSE)) {
+        return 0;
+    }
+    size_t size = 0;
+    for (size_t i = 1; i < (sigLen - 1); ++i) {
+        size_t sz = FixedTypeSize(sig[i]);
+        if (sz == 0) {
+            return 0;
+        }
+        size = ((size + sz - 1) & ~(sz - 1)) + sz;
+    }
+    numMembers = (uint32_t)(sigLen - 2);
+    return size;
+}
+
 
 
 QStatus _Message::ParseArray(MsgArg* arg,
@@ -72,10 +167,16 @@ QStatus _Message::ParseArray(MsgArg* arg,
     const char* sigStart = sigPtr;
 
     /*
-     * First check that the array type signature is valid
+     * First check that the array type signature is valid.  If the whole signature has already been
+     * checked we only need to find the end of the element type.
      */
     arg->typeId = ALLJOYN_ARRAY;
-    status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    if (sigVerified) {
+        SkipVerifiedType(sigPtr);
+        status = ER_OK;
+    } else {
+        status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    }
     if (status != ER_OK) {
         arg->typeId = ALLJOYN_INVALID;
         return status;
@@ -119,11 +220,7 @@ QStatus _Message::ParseArray(MsgArg* arg,
             arg->v_scalarArray.numElements = (size_t)(len / 2);
             if (endianSwap) {
                 arg->v_scalarArray.v_uint16 = new uint16_t[arg->v_scalarArray.numElements];
-                uint16_t* p = (uint16_t*)arg->v_scalarArray.v_uint16;
-                uint16_t* n = (uint16_t*)bufPos;
-                for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                    *p++ = EndianSwap16(*n++);
-                }
+                EndianSwapArray16((uint16_t*)arg->v_scalarArray.v_uint16, bufPos, arg->v_scalarArray.numElements);
                 arg->flags = MsgArg::OwnsData;
             } else {
                 arg->v_scalarArray.v_uint16 = (uint16_t*)bufPos;
@@ -176,11 +273,7 @@ QStatus _Message::ParseArray(MsgArg* arg,
             arg->v_scalarArray.numElements = (size_t)(len / 4);
             if (endianSwap) {
                 arg->v_scalarArray.v_uint32 = new uint32_t[arg->v_scalarArray.numElements];
-                uint32_t* p = (uint32_t*)arg->v_scalarArray.v_uint32;
-                uint32_t* n = (uint32_t*)bufPos;
-                for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                    *p++ = EndianSwap32(*n++);
-                }
+                EndianSwapArray32((uint32_t*)arg->v_scalarArray.v_uint32, bufPos, arg->v_scalarArray.numElements);
                 arg->flags = MsgArg::OwnsData;
             } else {
                 arg->v_scalarArray.v_uint32 = (uint32_t*)bufPos;
@@ -201,11 +294,7 @@ QStatus _Message::ParseArray(MsgArg* arg,
             arg->v_scalarArray.v_uint64 = (uint64_t*)bufPos;
             if (endianSwap) {
                 arg->v_scalarArray.v_uint64 = new uint64_t[arg->v_scalarArray.numElements];
-                uint64_t* p = (uint64_t*)arg->v_scalarArray.v_uint64;
-                uint64_t* n = (uint64_t*)bufPos;
-                for (size_t i = 0; i < arg->v_scalarArray.numElements; i++) {
-                    *p++ = EndianSwap64(*n++);
-                }
+                EndianSwapArray64((uint64_t*)arg->v_scalarArray.v_uint64, bufPos, arg->v_scalarArray.numElements);
                 arg->flags = MsgArg::OwnsData;
             } else {
                 arg->v_scalarArray.v_uint64 = (uint64_t*)bufPos;
@@ -223,6 +312,14 @@ QStatus _Message::ParseArray(MsgArg* arg,
          * of the first element.
          */
         bufPos = AlignPtr(bufPos, 8);
+        if ((len > 0) && (elemTypeId == ALLJOYN_STRUCT_OPEN)) {
+            uint32_t numMembers;
+            size_t structSize = FixedStructSize(sigStart, sigPtr - sigStart, numMembers);
+            if (structSize) {
+                status = ParseFixedStructArray(arg, sigStart, sigPtr - sigStart, len, structSize, numMembers);
+                break;
+            }
+        }
 
     /* Falling through */
     default:
@@ -230,6 +327,12 @@ QStatus _Message::ParseArray(MsgArg* arg,
         qcc::String elemSig(sigStart, sigPtr - sigStart);
         size_t numElements = 0;
         MsgArg* elements = NULL;
+        /*
+         * The element signature was checked above so there is no need to check it again for every
+         * element, which for arrays of structs and dictionaries was most of the parsing work.
+         */
+        bool wasVerified = sigVerified;
+        sigVerified = true;
         if (len > 0) {
             /*
              * We know how many bytes there are in the array but not how many elements until we
@@ -238,23 +341,26 @@ QStatus _Message::ParseArray(MsgArg* arg,
             uint8_t* endOfArray = bufPos + len;
             size_t capacity = 8;
             numElements = 0;
-            elements = new MsgArg[capacity];
+            elements = parsingBody ? argArena->Alloc(capacity) : new MsgArg[capacity];
             /*
              * Loop until we have consumed all of the data bytes
              */
             while (bufPos < endOfArray) {
                 if (numElements == capacity) {
                     capacity *= 2;
-                    MsgArg* bigger = new MsgArg[capacity];
+                    MsgArg* bigger = parsingBody ? argArena->Alloc(capacity) : new MsgArg[capacity];
                     memcpy(bigger, elements, numElements * sizeof(MsgArg));
                     /*
-                     * Clear the flags to prevent the destructor from freeing anything other
-                     * than the MsgArgs.
+                     * Invalidate the originals so their destructors don't free anything that
+                     * now belongs to the copies.
                      */
                     for (size_t i = 0; i < numElements; i++) {
+                        elements[i].typeId = ALLJOYN_INVALID;
                         elements[i].flags = 0;
                     }
-                    delete [] elements;
+                    if (!parsingBody) {
+                        delete [] elements;
+                    }
                     elements = bigger;
                 }
                 const char* esig = elemSig.c_str();
@@ -264,10 +370,13 @@ QStatus _Message::ParseArray(MsgArg* arg,
                 }
             }
         }
+        sigVerified = wasVerified;
         if (status == ER_OK) {
             arg->v_array.SetElements(elemSig.c_str(), numElements, elements);
-            arg->flags |= MsgArg::OwnsArgs;
-        } else {
+            if (!parsingBody) {
+                arg->flags |= MsgArg::OwnsArgs;
+            }
+        } else if (!parsingBody) {
             delete [] elements;
         }
     }
@@ -280,6 +389,77 @@ QStatus _Message::ParseArray(MsgArg* arg,
 }
 
 
+/*
+ * Parse an array of structs whose members all have a fixed size, for example "a(tdd)". Every
+ * struct has the same layout so the number of elements follows from the array length and the
+ * whole array is bounds checked once. The members are read directly instead of going through
+ * ParseValue() and are allocated in a single block rather than one allocation per struct.
+ */
+QStatus _Message::ParseFixedStructArray(MsgArg* arg, const char* elemSig, size_t elemSigLen, uint32_t len, size_t structSize, uint32_t numMembers)
+{
+    /*
+     * Elements start on 8 byte boundaries, there is no padding after the last one.
+     */
+    size_t stride = (structSize + 7) & ~7;
+    if ((len < structSize) || (((len - structSize) % stride) != 0) || ((bufPos + len) > bufEOD)) {
+        QCC_LogError(ER_BUS_BAD_LENGTH, ("Array length %ld at pos:%ld is not a whole number of %ld byte structs", len, bufPos - bodyPtr, structSize));
+        return ER_BUS_BAD_LENGTH;
+    }
+    size_t numElements = ((len - structSize) / stride) + 1;
+    MsgArg* elements = parsingBody ? argArena->Alloc(numElements) : new MsgArg[numElements];
+    MsgArg* members = parsingBody ? argArena->Alloc(numElements * numMembers) : new MsgArg[numElements * numMembers];
+    MsgArg* member = members;
+    for (size_t i = 0; i < numElements; ++i) {
+        uint8_t* pos = bufPos + i * stride;
+        elements[i].typeId = ALLJOYN_STRUCT;
+        elements[i].v_struct.numMembers = numMembers;
+        elements[i].v_struct.members = member;
+        for (size_t m = 1; m <= numMembers; ++m, ++member) {
+            char typeId = elemSig[m];
+            size_t sz = FixedTypeSize(typeId);
+            pos = AlignPtr(pos, sz);
+            member->typeId = (AllJoynTypeId)typeId;
+            switch (sz) {
+            case 1:
+                member->v_byte = *pos;
+                break;
+
+            case 2:
+                memcpy(&member->v_uint16, pos, 2);
+                if (endianSwap) {
+                    member->v_uint16 = EndianSwap16(member->v_uint16);
+                }
+                break;
+
+            case 4:
+                memcpy(&member->v_uint32, pos, 4);
+                if (endianSwap) {
+                    member->v_uint32 = EndianSwap32(member->v_uint32);
+                }
+                break;
+
+            default:
+                memcpy(&member->v_uint64, pos, 8);
+                if (endianSwap) {
+                    member->v_uint64 = EndianSwap64(member->v_uint64);
+                }
+                break;
+            }
+            pos += sz;
+        }
+    }
+    bufPos += len;
+    arg->v_array.SetElements(qcc::String(elemSig, elemSigLen).c_str(), numElements, elements);
+    if (!parsingBody) {
+        /*
+         * The first struct owns the block of members so deleting the elements frees all of them.
+         */
+        elements[0].flags = MsgArg::OwnsArgs;
+        arg->flags |= MsgArg::OwnsArgs;
+    }
+    return ER_OK;
+}
+
 /*
  * Parse a STRUCT
  */
@@ -290,7 +470,12 @@ QStatus _Message::ParseStruct(MsgArg* arg, const char*& sigPtr)
      * First check that the struct type signature is valid
      */
     arg->typeId = ALLJOYN_STRUCT;
-    QStatus status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    QStatus status = ER_OK;
+    if (sigVerified) {
+        arg->v_struct.numMembers = CountVerifiedMembers(sigPtr);
+    } else {
+        status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    }
     if (status != ER_OK) {
         QCC_LogError(status, ("ParseStruct error in signature\n"));
         return status;
@@ -302,8 +487,12 @@ QStatus _Message::ParseStruct(MsgArg* arg, const char*& sigPtr)
 
     QCC_DbgPrintf(("ParseStruct at pos:%d", bufPos - bodyPtr));
 
-    arg->v_struct.members = new MsgArg[arg->v_struct.numMembers];
-    arg->flags |= MsgArg::OwnsArgs;
+    if (parsingBody) {
+        arg->v_struct.members = argArena->Alloc(arg->v_struct.numMembers);
+    } else {
+        arg->v_struct.members = new MsgArg[arg->v_struct.numMembers];
+        arg->flags |= MsgArg::OwnsArgs;
+    }
     for (uint32_t i = 0; i < arg->v_struct.numMembers; ++i) {
         status = ParseValue(&arg->v_struct.members[i], memberSig);
         if (status != ER_OK) {
@@ -326,7 +515,12 @@ QStatus _Message::ParseDictEntry(MsgArg* arg,
      * First check that the dict entry type signature is valid
      */
     arg->typeId = ALLJOYN_DICT_ENTRY;
-    QStatus status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    QStatus status = ER_OK;
+    if (sigVerified) {
+        CountVerifiedMembers(sigPtr);
+    } else {
+        status = SignatureUtils::ParseContainerSignature(*arg, sigPtr);
+    }
     if (status != ER_OK) {
         arg->typeId = ALLJOYN_INVALID;
     } else {
@@ -337,9 +531,14 @@ QStatus _Message::ParseDictEntry(MsgArg* arg,
 
         QCC_DbgPrintf(("ParseDictEntry at pos:%d", bufPos - bodyPtr));
 
-        arg->v_dictEntry.key = new MsgArg();
-        arg->v_dictEntry.val = new MsgArg();
-        arg->flags |= MsgArg::OwnsArgs;
+        if (parsingBody) {
+            arg->v_dictEntry.key = argArena->Alloc(2);
+            arg->v_dictEntry.val = arg->v_dictEntry.key + 1;
+        } else {
+            arg->v_dictEntry.key = new MsgArg();
+            arg->v_dictEntry.val = new MsgArg();
+            arg->flags |= MsgArg::OwnsArgs;
+        }
         status = ParseValue(arg->v_dictEntry.key, memberSig);
         if (status == ER_OK) {
             status = ParseValue(arg->v_dictEntry.val, memberSig);
@@ -366,15 +565,28 @@ QStatus _Message::ParseVariant(MsgArg* arg)
     } else if (*bufPos++ != 0) {
         status = ER_BUS_BAD_SIGNATURE;
     } else {
-        arg->v_variant.val = new MsgArg();
-        arg->flags |= MsgArg::OwnsArgs;
+        if (parsingBody) {
+            arg->v_variant.val = argArena->Alloc(1);
+        } else {
+            arg->v_variant.val = new MsgArg();
+            arg->flags |= MsgArg::OwnsArgs;
+        }
+        /*
+         * The variant carries its own signature which has not been checked.
+         */
+        bool wasVerified = sigVerified;
+        sigVerified = false;
         status = ParseValue(arg->v_variant.val, sigPtr);
+        sigVerified = wasVerified;
         if ((status == ER_OK) && (*sigPtr != 0)) {
             status = ER_BUS_BAD_SIGNATURE;
         }
     }
     if (status != ER_OK) {
-        delete arg->v_variant.val;
+        if (!parsingBody) {
+            delete arg->v_variant.val;
+        }
+        arg->flags = 0;
         arg->typeId = ALLJOYN_INVALID;
     }
     return status;
@@ -483,6 +695,8 @@ QStatus _Message::ParseValue(MsgArg* arg, const char*& sigPtr, bool arrayElem)
             status = ER_BUS_BAD_LENGTH;
         } else if (*bufPos++ != 0) {
             status = ER_BUS_NOT_NUL_TERMINATED;
+        } else if (parsingBody && (typeId == ALLJOYN_STRING) && ValidationCache::IsPedantic() && !IsLegalUTF8(arg->v_string.str, arg->v_string.len)) {
+            status = ER_BUS_BAD_VALUE;
         } else {
             arg->typeId = typeId;
         }
@@ -612,7 +826,13 @@ QStatus _Message::UnmarshalArgs(const qcc::String& expectedSignature, const char
          * algorithm adds appends a MAC block to the end of the encrypted data.
          */
         size_t bodyLen = msgHeader.bodyLen;
-        status = ajn::Crypto::Decrypt(*this, key, (uint8_t*)msgBuf, hdrLen, bodyLen);
+        /*
+         * If the buffer is shared only the header is copied, the body is decrypted straight from
+         * the shared buffer into the new one.
+         */
+        const uint8_t* cryptBody = bodyPtr;
+        MakeBufWritable(hdrLen);
+        status = ajn::Crypto::Decrypt(*this, key, (uint8_t*)msgBuf, hdrLen, bodyLen, (cryptBody != bodyPtr) ? cryptBody : NULL);
         if (status != ER_OK) {
             goto ExitUnmarshalArgs;
         }
@@ -620,22 +840,43 @@ QStatus _Message::UnmarshalArgs(const qcc::String& expectedSignature, const char
         authMechanism = key.GetTag();
     }
     /*
-     * Calculate how many arguments there are
+     * Calculate how many arguments there are.  This checks every complete type in the signature so
+     * if we get all the way to the end the containers don't need to be checked again as they are
+     * parsed. If the signature was checked when the message was received or was built by us we
+     * already know.
      */
-    _numMsgArgs = SignatureUtils::CountCompleteTypes(sig);
+    if ((verifiedArgs >= 0) && !ValidationCache::IsPedantic()) {
+        _numMsgArgs = verifiedArgs;
+        sigVerified = true;
+    } else {
+        const char* sigEnd = sig;
+        while (*sigEnd && (SignatureUtils::ParseCompleteType(sigEnd) == ER_OK)) {
+            ++_numMsgArgs;
+        }
+        sigVerified = (*sigEnd == 0);
+    }
     _msgArgs = new MsgArg[_numMsgArgs];
 
     /*
-     * Unmarshal the body values
+     * Unmarshal the body values. Everything nested inside the top level args is allocated from
+     * the arena and freed in one go by ClearArgs().
      */
+    if (!argArena) {
+        argArena = new MsgArgArena();
+    }
+    parsingBody = true;
     bufPos = bodyPtr;
     for (uint8_t i = 0; i < _numMsgArgs; i++) {
         status = ParseValue(&_msgArgs[i], sig);
         if (status != ER_OK) {
             _numMsgArgs = i;
+            sigVerified = false;
+            parsingBody = false;
             goto ExitUnmarshalArgs;
         }
     }
+    sigVerified = false;
+    parsingBody = false;
     if ((bufPos - bodyPtr) != static_cast<ptrdiff_t>(msgHeader.bodyLen)) {
         QCC_DbgHLPrintf(("UnmarshalArgs expected argLen %d got %d", msgHeader.bodyLen, (bufPos - bodyPtr)));
         status = ER_BUS_BAD_SIGNATURE;
@@ -671,6 +912,9 @@ ExitUnmarshalArgs:
         if (_msgArgs) {
             delete [] _msgArgs;
         }
+        if (argArena) {
+            argArena->Reset();
+        }
         QCC_LogError(status, ("UnmarshalArgs failed"));
     }
     return status;
@@ -681,13 +925,16 @@ ExitUnmarshalArgs:
 static QStatus PedanticCheck(const MsgArg* field, uint32_t fieldId)
 {
     /*
-     * Only checking strings
+     * Only checking strings and object paths, the two share the same layout
      */
-    if (field->typeId != ALLJOYN_STRING) {
+    if ((field->typeId != ALLJOYN_STRING) && (field->typeId != ALLJOYN_OBJECT_PATH)) {
         return ER_OK;
     }
     switch (fieldId) {
     case ALLJOYN_HDR_FIELD_PATH:
+        if (field->typeId != ALLJOYN_OBJECT_PATH) {
+            break;
+        }
         if (field->v_string.len > ALLJOYN_MAX_NAME_LEN) {
             return ER_BUS_NAME_TOO_LONG;
         }
@@ -786,7 +1033,7 @@ static const AllJoynFieldType FieldTypeMapping[] = {
 /*
  * Perform consistency checks on the header
  */
-QStatus _Message::HeaderChecks(bool pedantic)
+QStatus _Message::HeaderChecks(bool pedantic, ValidationCache* cache)
 {
     QStatus status = ER_OK;
     switch (msgHeader.msgType) {
@@ -830,10 +1077,45 @@ QStatus _Message::HeaderChecks(bool pedantic)
      */
     if ((ER_OK == status) && pedantic) {
         for (uint32_t fieldId = ALLJOYN_HDR_FIELD_PATH; fieldId < ArraySize(hdrFields.field); fieldId++) {
-            status = PedanticCheck(&hdrFields.field[fieldId], fieldId);
+            const MsgArg* field = &hdrFields.field[fieldId];
+            /* Names this endpoint has sent before have already been checked */
+            uint32_t info;
+            bool cacheable = cache && ((field->typeId == ALLJOYN_STRING) || (field->typeId == ALLJOYN_OBJECT_PATH));
+            if (cacheable && cache->Lookup(fieldId, field->v_string.str, field->v_string.len, info)) {
+                continue;
+            }
+            status = PedanticCheck(field, fieldId);
             if (status != ER_OK) {
                 QCC_LogError(status, ("Invalid header field (fieldId=%d)", fieldId));
+                break;
+            } else if (cacheable) {
+                cache->Insert(fieldId, field->v_string.str, field->v_string.len, 0);
+            }
+        }
+    }
+    /*
+     * Check the body signature now so UnmarshalArgs doesn't have to. Signatures this endpoint has
+     * sent before are looked up with the number of complete types they hold.
+     */
+    if ((ER_OK == status) && cache) {
+        const MsgArg* sigField = &hdrFields.field[ALLJOYN_HDR_FIELD_SIGNATURE];
+        if (sigField->typeId == ALLJOYN_SIGNATURE) {
+            uint32_t numArgs;
+            if (cache->Lookup(ALLJOYN_HDR_FIELD_SIGNATURE, sigField->v_signature.sig, sigField->v_signature.len, numArgs)) {
+                verifiedArgs = static_cast<int32_t>(numArgs);
+            } else {
+                const char* sigEnd = sigField->v_signature.sig;
+                numArgs = 0;
+                while (*sigEnd && (SignatureUtils::ParseCompleteType(sigEnd) == ER_OK)) {
+                    ++numArgs;
+                }
+                if (*sigEnd == 0) {
+                    verifiedArgs = static_cast<int32_t>(numArgs);
+                    cache->Insert(ALLJOYN_HDR_FIELD_SIGNATURE, sigField->v_signature.sig, sigField->v_signature.len, numArgs);
+                }
             }
+        } else {
+            verifiedArgs = 0;
         }
     }
     return status;
@@ -890,7 +1172,7 @@ QStatus _Message::InterpretHeader()
      * message reducing the places where we need to check for bufEOD when unmarshaling the body.
      */
     bufSize = sizeof(msgHeader) + ((pktSize + 7) & ~7) + sizeof(uint64_t);
-    _msgBuf = new uint8_t[bufSize + 7];
+    _msgBuf = MsgBufPool::Alloc(bufSize + 7);
     msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
     /*
      * Copy header into the buffer
@@ -917,6 +1199,60 @@ QStatus _Message::InterpretHeader()
 
 }
 
+QStatus _Message::ExpandBody()
+{
+    uint8_t* oldBuf = (uint8_t*)msgBuf;
+    size_t hdrLen = bodyPtr - oldBuf;
+    uint32_t expandedLen;
+
+    if (msgHeader.bodyLen < sizeof(expandedLen)) {
+        QCC_LogError(ER_BUS_BAD_BODY_LEN, ("Compressed body length %d is invalid", msgHeader.bodyLen));
+        return ER_BUS_BAD_BODY_LEN;
+    }
+    memcpy(&expandedLen, bodyPtr, sizeof(expandedLen));
+    if (endianSwap) {
+        expandedLen = EndianSwap32(expandedLen);
+    }
+    /*
+     * The expanded message is subject to the same limits as one received uncompressed
+     */
+    size_t expandedPktSize = ((msgHeader.headerLen + 7) & ~7) + expandedLen;
+    if ((expandedPktSize > ALLJOYN_MAX_PACKET_LEN) || (expandedLen > ALLJOYN_MAX_PACKET_LEN)) {
+        QCC_LogError(ER_BUS_BAD_BODY_LEN, ("Expanded body length %d is invalid", expandedLen));
+        return ER_BUS_BAD_BODY_LEN;
+    }
+    size_t newSize = sizeof(msgHeader) + ((expandedPktSize + 7) & ~7) + sizeof(uint64_t);
+    uint8_t* _newMsgBuf = MsgBufPool::Alloc(newSize + 7);
+    uint8_t* newBuf = (uint8_t*)((uintptr_t)(_newMsgBuf + 7) & ~7);
+    if (!BodyCompressor::Expand(bodyPtr + sizeof(expandedLen), msgHeader.bodyLen - sizeof(expandedLen), newBuf + hdrLen, expandedLen)) {
+        MsgBufPool::Free(_newMsgBuf);
+        QCC_LogError(ER_BUS_BAD_BODY_LEN, ("Compressed body is corrupt"));
+        return ER_BUS_BAD_BODY_LEN;
+    }
+    memcpy(newBuf, oldBuf, hdrLen);
+    msgHeader.bodyLen = expandedLen;
+    msgHeader.flags &= ~ALLJOYN_FLAG_BODY_COMPRESSED;
+    MessageHeader* hdr = (MessageHeader*)newBuf;
+    hdr->flags &= ~ALLJOYN_FLAG_BODY_COMPRESSED;
+    hdr->bodyLen = endianSwap ? EndianSwap32(expandedLen) : expandedLen;
+    pktSize = expandedPktSize;
+    bufSize = newSize;
+    bodyPtr = newBuf + hdrLen;
+    bufPos = bodyPtr;
+    bufEOD = bodyPtr + expandedLen;
+    /*
+     * Zero fill the pad at the end of the buffer
+     */
+    memset(bufEOD, 0, newBuf + bufSize - bufEOD);
+    /*
+     * The header fields that were just parsed point into the received buffer
+     */
+    MsgBufPool::Retain(_newMsgBuf, _msgBuf);
+    _msgBuf = _newMsgBuf;
+    msgBuf = (uint64_t*)newBuf;
+    return ER_OK;
+}
+
 QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic, uint32_t timeout)
 {
     QStatus status;
@@ -951,8 +1287,11 @@ QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool ped
                 handles = new qcc::SocketFd[numHandles];
                 memcpy(handles, fdList, numHandles * sizeof(qcc::SocketFd));
             }
-        } else {
+        } else if (maxFds > 0) {
             status = source.PullBytes(bufPos, toRead, read, timeout);
+        } else {
+            /* Read ahead so back-to-back messages can be parsed from a single receive */
+            status = endpoint->PullBytes(bufPos, toRead, read, timeout);
         }
         bufPos += read;
         countRead -= read;
@@ -968,7 +1307,12 @@ QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool ped
     case MESSAGE_HEADER_BODY:
         /* Read the rest of the message header and body */
         toRead = (std::min)(countRead, MAX_PULL);
-        status = source.PullBytes(bufPos, toRead, read, timeout);
+        if (maxFds > 0) {
+            status = source.PullBytes(bufPos, toRead, read, timeout);
+        } else {
+            /* Usually the rest of the message is already in the endpoint's read-ahead buffer */
+            status = endpoint->PullBytes(bufPos, toRead, read, timeout);
+        }
         if (status == ER_ALERTED_THREAD) {
             QCC_LogError(status, ("PullBytes ALERTED continuing"));
             status = ER_OK;
@@ -1016,7 +1360,7 @@ QStatus _Message::Read(RemoteEndpoint& endpoint, bool checkSender, bool pedantic
      * Clear out any stale message state
      */
     msgBuf = NULL;
-    delete [] _msgBuf;
+    MsgBufPool::Free(_msgBuf);
     _msgBuf = NULL;
     ClearHeader();
     readState = MESSAGE_NEW;
@@ -1033,6 +1377,35 @@ QStatus _Message::Read(RemoteEndpoint& endpoint, bool checkSender, bool pedantic
     return status;
 }
 
+QStatus _Message::LoadBytes(const uint8_t* buf, size_t len)
+{
+    /*
+     * Clear out any stale message state
+     */
+    msgBuf = NULL;
+    MsgBufPool::Free(_msgBuf);
+    _msgBuf = NULL;
+    ClearHeader();
+    readState = MESSAGE_NEW;
+
+    if (len < sizeof(msgHeader)) {
+        return ER_BUS_BAD_HEADER_LEN;
+    }
+    memcpy(&msgHeader, buf, sizeof(msgHeader));
+    QStatus status = InterpretHeader();
+    if (status != ER_OK) {
+        return status;
+    }
+    if (len != (sizeof(msgHeader) + pktSize)) {
+        QCC_LogError(ER_BUS_BAD_BODY_LEN, ("Message length %u does not match its header", static_cast<uint32_t>(len)));
+        return ER_BUS_BAD_BODY_LEN;
+    }
+    memcpy(bufPos, buf + sizeof(msgHeader), pktSize);
+    readState = MESSAGE_COMPLETE;
+    bufPos = (uint8_t*)msgBuf + sizeof(msgHeader);
+    return ER_OK;
+}
+
 QStatus _Message::Unmarshal(RemoteEndpoint& endpoint, bool checkSender, bool pedantic, uint32_t timeout)
 {
     QStatus status;
@@ -1104,6 +1477,20 @@ QStatus _Message::Unmarshal(RemoteEndpoint& endpoint, bool checkSender, bool ped
      */
     bufPos = AlignPtr(bufPos, 8);
     bodyPtr = bufPos;
+    /*
+     * Compressed bodies are only allowed on links that negotiated body compression
+     */
+    if (msgHeader.flags & ALLJOYN_FLAG_BODY_COMPRESSED) {
+        if (!endpoint->GetFeatures().bodyCompression) {
+            status = ER_BUS_BAD_HEADER_FIELD;
+            QCC_LogError(status, ("Body compression was not negotiated on this connection"));
+            goto ExitUnmarshal;
+        }
+        status = ExpandBody();
+        if (status != ER_OK) {
+            goto ExitUnmarshal;
+        }
+    }
     /*
      * If header is compressed try to expand it*/
     if (msgHeader.flags & ALLJOYN_FLAG_COMPRESSED) {
@@ -1113,26 +1500,21 @@ QStatus _Message::Unmarshal(RemoteEndpoint& endpoint, bool checkSender, bool ped
             status = ER_BUS_MISSING_COMPRESSION_TOKEN;
             goto ExitUnmarshal;
         }
-        const HeaderFields* expFields = bus->GetInternal().GetCompressionRules()->GetExpansion(token);
-        if (!expFields) {
-            QCC_DbgPrintf(("No expansion for token %u", token));
-            status = ER_BUS_CANNOT_EXPAND_MESSAGE;
-            goto ExitUnmarshal;
-        }
         /*
          * Expand the compressed fields. Don't overwrite headers we received in the message.
          */
-        for (size_t id = 0; id < ArraySize(hdrFields.field); id++) {
-            if (HeaderFields::Compressible[id] && (hdrFields.field[id].typeId == ALLJOYN_INVALID)) {
-                hdrFields.field[id] = expFields->field[id];
-            }
+        if (!bus->GetInternal().GetCompressionRules()->Expand(token, hdrFields)) {
+            QCC_DbgPrintf(("No expansion for token %u", token));
+            status = ER_BUS_CANNOT_EXPAND_MESSAGE;
+            goto ExitUnmarshal;
         }
         hdrFields.field[ALLJOYN_HDR_FIELD_COMPRESSION_TOKEN].typeId = ALLJOYN_INVALID;
     }
     /*
      * Check the validity of the message header
      */
-    status = HeaderChecks(pedantic);
+    verifiedArgs = -1;
+    status = HeaderChecks(pedantic, (ValidationCache::IsPedantic() || !endpoint->IsValid()) ? NULL : &endpoint->GetValidationCache());
     /*
      * Check if there are handles accompanying this message and if we expect them.
      */
@@ -1229,6 +1611,7 @@ ExitUnmarshal:
 
     switch (status) {
     case ER_OK:
+        AtomTable::SetHeaderAtoms(hdrFields);
         QCC_DbgHLPrintf(("Received %s via endpoint %s", Description().c_str(), rcvEndpointName.c_str()));
         QCC_DbgPrintf(("\n%s", ToString().c_str()));
         break;
@@ -1270,7 +1653,7 @@ ExitUnmarshal:
          * There was an unrecoverable failure while unmarshaling the message, cleanup before we return.
          */
         msgBuf = NULL;
-        delete [] _msgBuf;
+        MsgBufPool::Free(_msgBuf);
         _msgBuf = NULL;
         ClearHeader();
         if ((status != ER_SOCK_OTHER_END_CLOSED) && (status != ER_STOPPING_THREAD)) {
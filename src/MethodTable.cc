@@ -33,69 +33,217 @@ using namespace std;
 
 namespace ajn {
 
+/* Initial number of hash chains, the table doubles whenever the chains average more than one node */
+static const size_t INITIAL_BUCKETS = 64;
+
+MethodTable::MethodTable() : buckets(new Buckets(INITIAL_BUCKETS)), count(0), epoch(0), updates(0)
+{
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
 MethodTable::~MethodTable()
 {
     lock.Lock(MUTEX_CONTEXT);
-    MapType::iterator iter = hashTable.begin();
-    while (iter != hashTable.end()) {
-        delete iter->second;
+    for (size_t i = 0; i <= buckets->mask; ++i) {
+        Node* n = buckets->heads[i];
+        while (n) {
+            Node* next = n->next;
+            delete n->entry;
+            delete n;
+            n = next;
+        }
     }
-
-    hashTable.clear();
+    delete buckets;
+    buckets = NULL;
+    Synchronize();
+    objectKeys.clear();
     lock.Unlock(MUTEX_CONTEXT);
 }
 
+MethodTable::Entry* MethodTable::Insert(const Key& key, Entry* entry)
+{
+    Hash hash;
+    Equal equal;
+    Node* volatile* link = &buckets->heads[hash(key) & buckets->mask];
+
+    for (Node* volatile* l = link; *l; l = &(*l)->next) {
+        Node* n = *l;
+        if (equal(n->key, key)) {
+            /* Replace the node rather than its entry so lookups never see a half updated node */
+            Node* replacement = new Node(key, entry, n->next);
+            Publish();
+            *l = replacement;
+            retiredNodes.push_back(n);
+            return n->entry;
+        }
+    }
+    Node* node = new Node(key, entry, *link);
+    Publish();
+    *link = node;
+
+    if (++count > (buckets->mask + 1)) {
+        /*
+         * Grow the table. Nodes can't be on two chains at once so the new chains are built from
+         * copies and the old nodes are retired along with the old chain heads.
+         */
+        Buckets* grown = new Buckets((buckets->mask + 1) * 2);
+        for (size_t i = 0; i <= buckets->mask; ++i) {
+            for (Node* n = buckets->heads[i]; n; n = n->next) {
+                Node* volatile* chain = &grown->heads[hash(n->key) & grown->mask];
+                *chain = new Node(n->key, n->entry, *chain);
+                retiredNodes.push_back(n);
+            }
+        }
+        Publish();
+        retiredBuckets.push_back(buckets);
+        buckets = grown;
+    }
+    return NULL;
+}
+
+MethodTable::Entry* MethodTable::Unlink(const Key& key, BusObject* object)
+{
+    Hash hash;
+    Equal equal;
+    for (Node* volatile* l = &buckets->heads[hash(key) & buckets->mask]; *l; l = &(*l)->next) {
+        Node* n = *l;
+        if (equal(n->key, key)) {
+            if (n->entry->object != object) {
+                /* The key has been taken over by another object registered at the same path */
+                return NULL;
+            }
+            /* Lookups that are already at n still find the rest of the chain through n->next */
+            *l = n->next;
+            retiredNodes.push_back(n);
+            --count;
+            return n->entry;
+        }
+    }
+    return NULL;
+}
+
+void MethodTable::Synchronize()
+{
+    if (retiredNodes.empty() && retiredBuckets.empty()) {
+        return;
+    }
+    /*
+     * Lookups that start after the epoch changes count themselves against the other reader count
+     * and can only reach linked nodes so only the lookups counted against the old epoch need to
+     * drain.
+     */
+    int32_t prev = qcc::IncrementAndFetch(&epoch) - 1;
+    while (readers[prev & 1] != 0) {
+        qcc::Sleep(1);
+    }
+    for (vector<Node*>::iterator it = retiredNodes.begin(); it != retiredNodes.end(); ++it) {
+        delete *it;
+    }
+    retiredNodes.clear();
+    for (vector<Buckets*>::iterator it = retiredBuckets.begin(); it != retiredBuckets.end(); ++it) {
+        delete *it;
+    }
+    retiredBuckets.clear();
+}
+
 void MethodTable::Add(BusObject* object,
                       MessageReceiver::MethodHandler func,
                       const InterfaceDescription::Member* member,
                       void* context)
 {
     Entry* entry = new Entry(object, func, member, context);
+    Atom path = AtomTable::Intern(object->GetPath());
+    Atom method = AtomTable::Intern(member->name);
+    Key key(path, AtomTable::Intern(entry->ifaceStr), method);
+    vector<Entry*> replaced;
     lock.Lock(MUTEX_CONTEXT);
-    hashTable[Key(object->GetPath(), entry->ifaceStr.empty() ? NULL : entry->ifaceStr.c_str(), member->name.c_str())] = entry;
+    Entry* old = Insert(key, entry);
+    if (old) {
+        replaced.push_back(old);
+    }
+    objectKeys[object].push_back(key);
 
     /* Method calls don't require an interface so we need to add an entry with a NULL interface */
     if (!entry->ifaceStr.empty()) {
-        hashTable[Key(object->GetPath(), NULL, member->name.c_str())] = new Entry(*entry);
+        Key noIfaceKey(path, ATOM_NONE, method);
+        old = Insert(noIfaceKey, new Entry(*entry));
+        if (old) {
+            replaced.push_back(old);
+        }
+        objectKeys[object].push_back(noIfaceKey);
     }
+    /* Only a replacement or a resize leaves nodes to free */
+    Synchronize();
     lock.Unlock(MUTEX_CONTEXT);
+
+    /* Entry destructors wait for method calls that are still using them */
+    for (vector<Entry*>::iterator it = replaced.begin(); it != replaced.end(); ++it) {
+        delete *it;
+    }
 }
 
 MethodTable::SafeEntry* MethodTable::Find(const char* objectPath,
                                           const char* iface,
                                           const char* methodName)
+{
+    return Find(AtomTable::Find(objectPath), AtomTable::Find(iface), AtomTable::Find(methodName));
+}
+
+MethodTable::SafeEntry* MethodTable::Find(Atom objectPath,
+                                          Atom iface,
+                                          Atom methodName)
 {
     SafeEntry* entry = NULL;
     Key key(objectPath, iface, methodName);
-    lock.Lock(MUTEX_CONTEXT);
-    MapType::iterator iter = hashTable.find(key);
-    if (iter != hashTable.end()) {
-        entry = new SafeEntry();
-        entry->Set(iter->second);
+    Hash hash;
+    Equal equal;
+    /*
+     * Count ourselves as a reader of the current epoch. If the epoch changed while we were doing
+     * that, the writer may not wait for us so retry against the new epoch.
+     */
+    int32_t e;
+    for (;;) {
+        e = epoch;
+        qcc::IncrementAndFetch(&readers[e & 1]);
+        if (e == epoch) {
+            break;
+        }
+        qcc::DecrementAndFetch(&readers[e & 1]);
     }
-    lock.Unlock(MUTEX_CONTEXT);
+    const Buckets* b = buckets;
+    for (const Node* n = b->heads[hash(key) & b->mask]; n; n = n->next) {
+        if (equal(n->key, key)) {
+            entry = new SafeEntry();
+            entry->Set(n->entry);
+            break;
+        }
+    }
+    qcc::DecrementAndFetch(&readers[e & 1]);
     return entry;
 }
 
 void MethodTable::RemoveAll(BusObject* object)
 {
-    MapType::iterator iter;
-    /*
-     * Iterate over all entries deleting all entries that reference the object
-     */
+    vector<Entry*> removed;
     lock.Lock(MUTEX_CONTEXT);
-    iter = hashTable.begin();
-    while (iter != hashTable.end()) {
-        if (iter->second->object == object) {
-            Entry* deleteMe = iter->second;
-            hashTable.erase(iter);
-            delete deleteMe;
-            iter = hashTable.begin();
-        } else {
-            ++iter;
+    unordered_map<BusObject*, vector<Key> >::iterator kit = objectKeys.find(object);
+    if (kit != objectKeys.end()) {
+        for (vector<Key>::const_iterator it = kit->second.begin(); it != kit->second.end(); ++it) {
+            Entry* entry = Unlink(*it, object);
+            if (entry) {
+                removed.push_back(entry);
+            }
         }
+        objectKeys.erase(kit);
     }
+    Synchronize();
     lock.Unlock(MUTEX_CONTEXT);
+
+    /* Entry destructors wait for method calls that are still using them */
+    for (vector<Entry*>::iterator it = removed.begin(); it != removed.end(); ++it) {
+        delete *it;
+    }
 }
 
 void MethodTable::AddAll(BusObject* object)
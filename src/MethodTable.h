@@ -38,10 +38,16 @@
 
 #include <qcc/STLContainer.h>
 
+#include "AtomTable.h"
+
 namespace ajn {
 
 /**
  * %MethodTable is a hash table that maps object paths to BusObject instances.
+ *
+ * Lookups don't take a lock. The table is a chained hash table whose nodes are never modified
+ * once they are linked in: writers link new nodes at the head of a chain, unlink removed nodes and
+ * free them once no lookup can still be traversing them.
  */
 class MethodTable {
 
@@ -101,6 +107,11 @@ class MethodTable {
         const Entry* entry;
     };
 
+    /**
+     * Constructor
+     */
+    MethodTable();
+
     /**
      * Destructor
      */
@@ -130,6 +141,18 @@ class MethodTable {
      */
     SafeEntry* Find(const char* objectPath, const char* iface, const char* methodName);
 
+    /**
+     * Find an Entry based on set of criteria.
+     *
+     * @param objectPath   Atom for the object path.
+     * @param iface        Atom for the interface or ATOM_NONE.
+     * @param methodName   Atom for the method name.
+     * @return
+     *      - Entry that matches objectPath, interface and method
+     *      - NULL if not found
+     */
+    SafeEntry* Find(Atom objectPath, Atom iface, Atom methodName);
+
     /**
      * Remove all hash entries related to the specified object.
      *
@@ -146,17 +169,17 @@ class MethodTable {
 
   private:
 
-    qcc::Mutex lock; /**< Lock protecting the method table */
+    qcc::Mutex lock; /**< Lock serializing updates to the method table */
 
     /**
      * Type definition for method hash table key
      */
     class Key {
       public:
-        const char* objPath;
-        const char* iface;
-        const char* methodName;
-        Key(const char* obj, const char* ifc, const char* method) : objPath(obj), iface((ifc && *ifc) ? ifc : NULL), methodName(method) { }
+        Atom objPath;
+        Atom iface;
+        Atom methodName;
+        Key(Atom obj, Atom ifc, Atom method) : objPath(obj), iface(ifc), methodName(method) { }
     };
 
     /**
@@ -165,19 +188,7 @@ class MethodTable {
     struct Hash {
         /** Calculate hash for Key k  */
         size_t operator()(const Key& k) const {
-            size_t hash = 37;
-            for (const char* p = k.methodName; *p; ++p) {
-                hash = *p + hash * 11;
-            }
-            for (const char* p = k.objPath; *p; ++p) {
-                hash = *p + hash * 5;
-            }
-            if (k.iface) {
-                for (const char* p = k.iface; *p; ++p) {
-                    hash += *p * 7;
-                }
-            }
-            return hash;
+            return (((size_t)k.methodName * 11) + (size_t)k.objPath) * 5 + (size_t)k.iface * 7;
         }
     };
 
@@ -189,17 +200,79 @@ class MethodTable {
          * Return true two keys are equal
          */
         bool operator()(const Key& k1, const Key& k2) const {
-            if ((k1.iface == NULL) || (k2.iface == NULL)) {
-                return (k1.iface == k2.iface) && (strcmp(k1.methodName, k2.methodName) == 0) && (strcmp(k1.objPath, k2.objPath) == 0);
-            } else {
-                return (strcmp(k1.methodName, k2.methodName) == 0) && (strcmp(k1.iface, k2.iface) == 0) && (strcmp(k1.objPath, k2.objPath) == 0);
+            return (k1.methodName == k2.methodName) && (k1.iface == k2.iface) && (k1.objPath == k2.objPath);
+        }
+    };
+
+    /**
+     * A hash chain node. Only next changes after the node is linked in.
+     */
+    struct Node {
+        Key key;
+        Entry* entry;
+        Node* volatile next;
+        Node(const Key& key, Entry* entry, Node* next) : key(key), entry(entry), next(next) { }
+    };
+
+    /**
+     * Hash chain heads. A new array is published when the table grows.
+     */
+    struct Buckets {
+        size_t mask;
+        Node* volatile* heads;
+        Buckets(size_t size) : mask(size - 1), heads(new Node*[size]) {
+            for (size_t i = 0; i < size; ++i) {
+                heads[i] = NULL;
             }
         }
+        ~Buckets() { delete [] heads; }
+      private:
+        Buckets(const Buckets& other);
+        Buckets& operator=(const Buckets& other);
     };
 
-    /** The hash table */
-    typedef std::unordered_map<Key, Entry*, Hash, Equal> MapType;
-    MapType hashTable;
+    /**
+     * Add or replace a node. Must be called with lock held.
+     *
+     * @return  The entry that was replaced or NULL.
+     */
+    Entry* Insert(const Key& key, Entry* entry);
+
+    /**
+     * Unlink the node for a key if it belongs to an object. Must be called with lock held.
+     *
+     * @param key      The key to remove.
+     * @param object   The object the node's entry must belong to.
+     *
+     * @return  The entry the node referred to or NULL if there was no such node.
+     */
+    Entry* Unlink(const Key& key, BusObject* object);
+
+    /**
+     * Wait until no lookup can still be using unlinked nodes or replaced buckets and free them.
+     * Must be called with lock held.
+     */
+    void Synchronize();
+
+    /**
+     * Make sure stores made so far are visible before the stores that follow.
+     */
+    void Publish() { qcc::IncrementAndFetch(&updates); }
+
+    Buckets* volatile buckets;              /**< The published hash chains */
+    size_t count;                           /**< Number of linked nodes */
+    volatile int32_t epoch;                 /**< Selects the reader count new lookups use */
+    volatile int32_t readers[2];            /**< Lookups in progress for each epoch */
+    volatile int32_t updates;               /**< Count of published updates */
+    std::vector<Node*> retiredNodes;        /**< Unlinked nodes waiting for Synchronize() */
+    std::vector<Buckets*> retiredBuckets;   /**< Replaced chain heads waiting for Synchronize() */
+
+    /** Keys of the nodes registered by each object, only used by writers */
+    std::unordered_map<BusObject*, std::vector<Key> > objectKeys;
+
+    /* Copying is not allowed */
+    MethodTable(const MethodTable& other);
+    MethodTable& operator=(const MethodTable& other);
 };
 
 }
@@ -294,6 +294,22 @@ bool MsgArg::HasSignature(const char* signature) const
 
 }
 
+void MsgArg::Swap(MsgArg& other)
+{
+    /*
+     * v_invalid spans the whole value union so swapping it swaps whichever member is in use
+     */
+    AllJoynTypeId tmpType = typeId;
+    uint8_t tmpFlags = flags;
+    AllJoynInvalid tmpVal = v_invalid;
+    typeId = other.typeId;
+    flags = other.flags;
+    v_invalid = other.v_invalid;
+    other.typeId = tmpType;
+    other.flags = tmpFlags;
+    other.v_invalid = tmpVal;
+}
+
 void MsgArg::Stabilize()
 {
     /*
@@ -0,0 +1,86 @@
+/**
+ * @file
+ *
+ * This file implements the MsgArgArena class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <new>
+
+#include <alljoyn/MsgArg.h>
+
+#include "MsgArgArena.h"
+#include "MsgBufPool.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+namespace ajn {
+
+/*
+ * A chunk is a MsgBufPool buffer holding this header followed by the MsgArgs. The MsgArgs
+ * start on an 8 byte boundary because MsgBufPool buffers are not guaranteed to be aligned.
+ */
+struct MsgArgArena::Chunk {
+    uint8_t* buf;       /* The MsgBufPool buffer the chunk lives in */
+    Chunk* next;        /* Next (older) chunk */
+    size_t capacity;    /* Number of MsgArgs the chunk can hold */
+    size_t used;        /* Number of MsgArgs handed out */
+
+    MsgArg* Args() { return reinterpret_cast<MsgArg*>(reinterpret_cast<uint8_t*>(this) + ((sizeof(Chunk) + 7) & ~7)); }
+};
+
+MsgArg* MsgArgArena::Alloc(size_t num)
+{
+    if (!chunks || ((chunks->capacity - chunks->used) < num)) {
+        size_t capacity = (num > nextCapacity) ? num : nextCapacity;
+        uint8_t* buf = MsgBufPool::Alloc(7 + ((sizeof(Chunk) + 7) & ~7) + capacity * sizeof(MsgArg));
+        Chunk* chunk = reinterpret_cast<Chunk*>((uintptr_t)(buf + 7) & ~7);
+        chunk->buf = buf;
+        chunk->next = chunks;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        chunks = chunk;
+        if (nextCapacity < MAX_CHUNK_ARGS) {
+            nextCapacity *= 2;
+        }
+    }
+    MsgArg* args = chunks->Args() + chunks->used;
+    for (size_t i = 0; i < num; ++i) {
+        new (&args[i])MsgArg();
+    }
+    chunks->used += num;
+    return args;
+}
+
+void MsgArgArena::Reset()
+{
+    while (chunks) {
+        Chunk* chunk = chunks;
+        chunks = chunk->next;
+        MsgArg* args = chunk->Args();
+        while (chunk->used) {
+            args[--chunk->used].~MsgArg();
+        }
+        MsgBufPool::Free(chunk->buf);
+    }
+    nextCapacity = MIN_CHUNK_ARGS;
+}
+
+}
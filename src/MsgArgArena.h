@@ -0,0 +1,85 @@
+#ifndef _ALLJOYN_MSGARGARENA_H
+#define _ALLJOYN_MSGARGARENA_H
+/**
+ * @file
+ * MsgArgArena allocates the MsgArgs nested inside the arguments of an unmarshaled message.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MsgArgArena.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <alljoyn/MsgArg.h>
+
+namespace ajn {
+
+/**
+ * A bump allocator for MsgArgs. The members of structs and dict entries, the elements of arrays
+ * and the values of variants in an unmarshaled message body are allocated from the message's
+ * arena rather than individually from the heap. The MsgArgs that reference them do not have the
+ * MsgArg::OwnsArgs flag set; all of them are destroyed together when the arena is reset. Arena
+ * memory comes from MsgBufPool. Arenas are not thread-safe, a message is only unmarshaled by one
+ * thread at a time.
+ */
+class MsgArgArena {
+  public:
+
+    /** Constructor, no memory is allocated until the first call to Alloc() */
+    MsgArgArena() : chunks(NULL), nextCapacity(MIN_CHUNK_ARGS) { }
+
+    /** Destructor */
+    ~MsgArgArena() { Reset(); }
+
+    /**
+     * Allocate an array of contiguous MsgArgs.
+     *
+     * @param num   Number of MsgArgs, must be greater than 0.
+     *
+     * @return  Default constructed MsgArgs that remain valid until Reset() is called.
+     */
+    MsgArg* Alloc(size_t num);
+
+    /**
+     * Destroy every MsgArg allocated from the arena and release its memory.
+     */
+    void Reset();
+
+  private:
+
+    /** Capacity of the first chunk, enough for a typical message */
+    static const size_t MIN_CHUNK_ARGS = 32;
+
+    /** Chunks grow geometrically up to this capacity */
+    static const size_t MAX_CHUNK_ARGS = 1024;
+
+    struct Chunk;
+
+    Chunk* chunks;          /**< Most recently allocated chunk first */
+    size_t nextCapacity;    /**< Capacity of the next chunk */
+
+    /* Private copy constructor and assignment operator to prevent copying */
+    MsgArgArena(const MsgArgArena& other);
+    MsgArgArena& operator=(const MsgArgArena& other);
+};
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file
+ *
+ * This file implements an indexed view for looking up the entries of a dictionary MsgArg by key.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include <alljoyn/MsgArgDictionary.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+
+namespace ajn {
+
+static bool IsStringKey(char keyType)
+{
+    return (keyType == 's') || (keyType == 'o') || (keyType == 'g');
+}
+
+static bool IsIntegerKey(char keyType)
+{
+    return keyType && (strchr("ybnqiuxt", keyType) != NULL);
+}
+
+static void GetStringKey(const MsgArg& key, const char*& str, size_t& len)
+{
+    if (key.typeId == ALLJOYN_SIGNATURE) {
+        str = key.v_signature.sig;
+        len = key.v_signature.len;
+    } else {
+        /* Object paths have the same layout as strings */
+        str = key.v_string.str;
+        len = key.v_string.len;
+    }
+}
+
+static uint64_t GetIntegerKey(const MsgArg& key)
+{
+    switch (key.typeId) {
+    case ALLJOYN_BYTE:    return key.v_byte;
+    case ALLJOYN_BOOLEAN: return key.v_bool ? 1 : 0;
+    case ALLJOYN_INT16:   return static_cast<uint64_t>(static_cast<int64_t>(key.v_int16));
+    case ALLJOYN_UINT16:  return key.v_uint16;
+    case ALLJOYN_INT32:   return static_cast<uint64_t>(static_cast<int64_t>(key.v_int32));
+    case ALLJOYN_UINT32:  return key.v_uint32;
+    case ALLJOYN_INT64:   return static_cast<uint64_t>(key.v_int64);
+    case ALLJOYN_UINT64:  return key.v_uint64;
+    default:              return 0;
+    }
+}
+
+/* FNV-1a */
+static uint32_t HashString(const char* str, size_t len)
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(str[i])) * 16777619U;
+    }
+    return hash;
+}
+
+/* Keys are often small consecutive integers so the bits are mixed before the table is masked */
+static uint32_t HashInteger(uint64_t num)
+{
+    num ^= num >> 33;
+    num *= 0xff51afd7ed558ccdULL;
+    num ^= num >> 33;
+    return static_cast<uint32_t>(num);
+}
+
+static const MsgArg* ResolveVariants(const MsgArg* val)
+{
+    while (val && (val->typeId == ALLJOYN_VARIANT)) {
+        val = val->v_variant.val;
+    }
+    return val;
+}
+
+MsgArgDictionary::MsgArgDictionary(const MsgArg& dict) :
+    dict(dict), keyType(IsDictionary() ? dict.v_array.GetElemSig()[1] : 0), indexed(false)
+{
+}
+
+QStatus MsgArgDictionary::GetStatus() const
+{
+    if (!IsDictionary()) {
+        return ER_BUS_NOT_A_DICTIONARY;
+    }
+    return (IsStringKey(keyType) || IsIntegerKey(keyType)) ? ER_OK : ER_BUS_SIGNATURE_MISMATCH;
+}
+
+size_t MsgArgDictionary::FindSlot(uint32_t hash, const char* str, size_t len, uint64_t num) const
+{
+    const MsgArg* entries = dict.v_array.GetElements();
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    /* The table is never more than half full so there is always an empty slot to stop at */
+    while (slots[slot]) {
+        const MsgArg& key = *entries[slots[slot] - 1].v_dictEntry.key;
+        if (IsStringKey(keyType)) {
+            const char* keyStr;
+            size_t keyLen;
+            GetStringKey(key, keyStr, keyLen);
+            if ((keyLen == len) && (memcmp(keyStr, str, len) == 0)) {
+                break;
+            }
+        } else if (GetIntegerKey(key) == num) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void MsgArgDictionary::Index() const
+{
+    if (indexed) {
+        return;
+    }
+    indexed = true;
+    if (GetStatus() != ER_OK) {
+        return;
+    }
+    size_t numEntries = dict.v_array.GetNumElements();
+    const MsgArg* entries = dict.v_array.GetElements();
+    size_t size = 8;
+    while (size < (2 * numEntries)) {
+        size <<= 1;
+    }
+    slots.assign(size, 0);
+    for (size_t i = 0; i < numEntries; ++i) {
+        const MsgArg& key = *entries[i].v_dictEntry.key;
+        size_t slot;
+        if (IsStringKey(keyType)) {
+            const char* str;
+            size_t len;
+            GetStringKey(key, str, len);
+            slot = FindSlot(HashString(str, len), str, len, 0);
+        } else {
+            uint64_t num = GetIntegerKey(key);
+            slot = FindSlot(HashInteger(num), NULL, 0, num);
+        }
+        /* A duplicate key leaves the first entry in place */
+        if (!slots[slot]) {
+            slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+}
+
+const MsgArg* MsgArgDictionary::Find(const char* key) const
+{
+    if (!key || !IsStringKey(keyType)) {
+        return NULL;
+    }
+    Index();
+    size_t len = strlen(key);
+    uint32_t entry = slots[FindSlot(HashString(key, len), key, len, 0)];
+    return entry ? ResolveVariants(dict.v_array.GetElements()[entry - 1].v_dictEntry.val) : NULL;
+}
+
+const MsgArg* MsgArgDictionary::FindInteger(int64_t key) const
+{
+    if (!IsIntegerKey(keyType)) {
+        return NULL;
+    }
+    Index();
+    uint64_t num = static_cast<uint64_t>(key);
+    uint32_t entry = slots[FindSlot(HashInteger(num), NULL, 0, num)];
+    return entry ? ResolveVariants(dict.v_array.GetElements()[entry - 1].v_dictEntry.val) : NULL;
+}
+
+}
@@ -0,0 +1,330 @@
+/**
+ * @file
+ *
+ * This file implements the MsgBufPool class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
+#include <qcc/atomic.h>
+#include <qcc/Mutex.h>
+#include <qcc/Util.h>
+
+#include "MsgBufPool.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+
+namespace ajn {
+
+/* The oversize class is used for requests larger than the largest size class */
+static const size_t OVERSIZE_CLASS = MsgBufPool::NUM_SIZE_CLASSES;
+
+/* Buffer size of each size class */
+static const size_t classSizes[MsgBufPool::NUM_SIZE_CLASSES] = { 256, 1024, 4096, 16384, 65536, 131072 };
+
+/* Maximum number of free buffers held on the shared free list of each size class */
+static const uint32_t maxPooled[MsgBufPool::NUM_SIZE_CLASSES] = { 256, 128, 64, 32, 8, 4 };
+
+/* Maximum number of free buffers held in each thread's cache, the large classes are only pooled */
+static const uint32_t maxThreadCached[MsgBufPool::NUM_SIZE_CLASSES] = { 16, 16, 8, 4, 0, 0 };
+
+/*
+ * Every buffer is preceded by a header that records its size class and reference count
+ * while the buffer is in use and links it into a free list while it is not.
+ */
+struct BufHeader {
+    union {
+        size_t sizeClass;
+        BufHeader* next;
+    };
+    volatile int32_t refs;
+    uint8_t* retained;
+};
+
+struct FreeList {
+    BufHeader* head;
+    uint32_t count;
+
+    BufHeader* Pop() {
+        BufHeader* hdr = head;
+        if (hdr) {
+            head = hdr->next;
+            --count;
+        }
+        return hdr;
+    }
+
+    void Push(BufHeader* hdr) {
+        hdr->next = head;
+        head = hdr;
+        ++count;
+    }
+};
+
+struct Counters {
+    volatile int32_t allocs;
+    volatile int32_t threadHits;
+    volatile int32_t poolHits;
+    volatile int32_t heapAllocs;
+    volatile int32_t frees;
+    volatile int32_t heapFrees;
+};
+
+static Counters counters[MsgBufPool::NUM_SIZE_CLASSES + 1];
+
+/* Set when the shared pool has been destroyed, after that buffers come from and go to the heap */
+static bool poolShutdown = false;
+
+static void HeapFree(BufHeader* hdr)
+{
+    delete [] reinterpret_cast<uint8_t*>(hdr);
+}
+
+class SharedPool {
+  public:
+    SharedPool();
+    ~SharedPool();
+
+    /* Pop a buffer from the shared free list, returns NULL if the list is empty */
+    BufHeader* Pop(size_t sizeClass) {
+        lock[sizeClass].Lock(MUTEX_CONTEXT);
+        BufHeader* hdr = lists[sizeClass].Pop();
+        lock[sizeClass].Unlock(MUTEX_CONTEXT);
+        return hdr;
+    }
+
+    /* Push a buffer onto the shared free list, returns false if the list is full */
+    bool Push(size_t sizeClass, BufHeader* hdr) {
+        bool pushed = false;
+        lock[sizeClass].Lock(MUTEX_CONTEXT);
+        if (lists[sizeClass].count < maxPooled[sizeClass]) {
+            lists[sizeClass].Push(hdr);
+            pushed = true;
+        }
+        lock[sizeClass].Unlock(MUTEX_CONTEXT);
+        return pushed;
+    }
+
+    qcc::Mutex lock[MsgBufPool::NUM_SIZE_CLASSES];
+    FreeList lists[MsgBufPool::NUM_SIZE_CLASSES];
+};
+
+static SharedPool sharedPool;
+
+struct ThreadCache {
+    FreeList lists[MsgBufPool::NUM_SIZE_CLASSES];
+};
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+static pthread_key_t cacheKey;
+static bool cacheKeyValid = false;
+
+/* Called on thread exit to hand the thread's cached buffers back to the shared pool */
+static void ReleaseThreadCache(void* arg)
+{
+    ThreadCache* cache = reinterpret_cast<ThreadCache*>(arg);
+    for (size_t sc = 0; sc < MsgBufPool::NUM_SIZE_CLASSES; ++sc) {
+        BufHeader* hdr;
+        while ((hdr = cache->lists[sc].Pop()) != NULL) {
+            if (poolShutdown || !sharedPool.Push(sc, hdr)) {
+                HeapFree(hdr);
+            }
+        }
+    }
+    delete cache;
+}
+
+static ThreadCache* GetThreadCache()
+{
+    if (!cacheKeyValid) {
+        return NULL;
+    }
+    ThreadCache* cache = reinterpret_cast<ThreadCache*>(pthread_getspecific(cacheKey));
+    if (!cache) {
+        cache = new ThreadCache;
+        memset(cache, 0, sizeof(ThreadCache));
+        if (pthread_setspecific(cacheKey, cache) != 0) {
+            delete cache;
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+#else
+
+/* Per-thread caches are only implemented for posix, other platforms only use the shared pool */
+static ThreadCache* GetThreadCache()
+{
+    return NULL;
+}
+
+#endif
+
+SharedPool::SharedPool()
+{
+    memset(lists, 0, sizeof(lists));
+#if defined(QCC_OS_GROUP_POSIX)
+    cacheKeyValid = (pthread_key_create(&cacheKey, ReleaseThreadCache) == 0);
+#endif
+}
+
+SharedPool::~SharedPool()
+{
+    /*
+     * The thread cache key is not deleted because threads that are still running may exit
+     * later and must still release their caches.
+     */
+    poolShutdown = true;
+    for (size_t sc = 0; sc < MsgBufPool::NUM_SIZE_CLASSES; ++sc) {
+        BufHeader* hdr;
+        while ((hdr = lists[sc].Pop()) != NULL) {
+            HeapFree(hdr);
+        }
+    }
+}
+
+static inline size_t SizeClass(size_t size)
+{
+    for (size_t sc = 0; sc < MsgBufPool::NUM_SIZE_CLASSES; ++sc) {
+        if (size <= classSizes[sc]) {
+            return sc;
+        }
+    }
+    return OVERSIZE_CLASS;
+}
+
+uint8_t* MsgBufPool::Alloc(size_t size)
+{
+    size_t sc = SizeClass(size);
+    IncrementAndFetch(&counters[sc].allocs);
+
+    BufHeader* hdr = NULL;
+    if ((sc != OVERSIZE_CLASS) && !poolShutdown) {
+        ThreadCache* cache = maxThreadCached[sc] ? GetThreadCache() : NULL;
+        if (cache && cache->lists[sc].count) {
+            hdr = cache->lists[sc].Pop();
+            IncrementAndFetch(&counters[sc].threadHits);
+        } else {
+            hdr = sharedPool.Pop(sc);
+            if (hdr) {
+                IncrementAndFetch(&counters[sc].poolHits);
+            }
+        }
+    }
+    if (!hdr) {
+        size_t bufSize = (sc == OVERSIZE_CLASS) ? size : classSizes[sc];
+        hdr = reinterpret_cast<BufHeader*>(new uint8_t[sizeof(BufHeader) + bufSize]);
+        IncrementAndFetch(&counters[sc].heapAllocs);
+    }
+    hdr->sizeClass = sc;
+    hdr->refs = 1;
+    hdr->retained = NULL;
+    return reinterpret_cast<uint8_t*>(hdr + 1);
+}
+
+void MsgBufPool::AddRef(uint8_t* buf)
+{
+    IncrementAndFetch(&(reinterpret_cast<BufHeader*>(buf) - 1)->refs);
+}
+
+bool MsgBufPool::IsShared(const uint8_t* buf)
+{
+    return (reinterpret_cast<const BufHeader*>(buf) - 1)->refs > 1;
+}
+
+void MsgBufPool::Retain(uint8_t* buf, uint8_t* retained)
+{
+    BufHeader* hdr = reinterpret_cast<BufHeader*>(buf) - 1;
+    if (hdr->retained) {
+        /* Chain the buffers so the older one is released when the retained one is */
+        Retain(retained, hdr->retained);
+    }
+    hdr->retained = retained;
+}
+
+void MsgBufPool::Free(uint8_t* buf)
+{
+    if (!buf) {
+        return;
+    }
+    BufHeader* hdr = reinterpret_cast<BufHeader*>(buf) - 1;
+    if (DecrementAndFetch(&hdr->refs) > 0) {
+        return;
+    }
+    if (hdr->retained) {
+        Free(hdr->retained);
+        hdr->retained = NULL;
+    }
+    size_t sc = hdr->sizeClass;
+    IncrementAndFetch(&counters[sc].frees);
+
+    if ((sc != OVERSIZE_CLASS) && !poolShutdown) {
+        ThreadCache* cache = maxThreadCached[sc] ? GetThreadCache() : NULL;
+        if (cache && (cache->lists[sc].count < maxThreadCached[sc])) {
+            cache->lists[sc].Push(hdr);
+            return;
+        }
+        if (sharedPool.Push(sc, hdr)) {
+            return;
+        }
+    }
+    IncrementAndFetch(&counters[sc].heapFrees);
+    HeapFree(hdr);
+}
+
+size_t MsgBufPool::GetClassSize(size_t sizeClass)
+{
+    return (sizeClass < NUM_SIZE_CLASSES) ? classSizes[sizeClass] : 0;
+}
+
+void MsgBufPool::GetStats(Stats stats[NUM_SIZE_CLASSES + 1])
+{
+    for (size_t sc = 0; sc <= NUM_SIZE_CLASSES; ++sc) {
+        stats[sc].allocs = static_cast<uint32_t>(counters[sc].allocs);
+        stats[sc].threadHits = static_cast<uint32_t>(counters[sc].threadHits);
+        stats[sc].poolHits = static_cast<uint32_t>(counters[sc].poolHits);
+        stats[sc].heapAllocs = static_cast<uint32_t>(counters[sc].heapAllocs);
+        stats[sc].frees = static_cast<uint32_t>(counters[sc].frees);
+        stats[sc].heapFrees = static_cast<uint32_t>(counters[sc].heapFrees);
+    }
+}
+
+void MsgBufPool::ResetStats()
+{
+    for (size_t sc = 0; sc <= NUM_SIZE_CLASSES; ++sc) {
+        counters[sc].allocs = 0;
+        counters[sc].threadHits = 0;
+        counters[sc].poolHits = 0;
+        counters[sc].heapAllocs = 0;
+        counters[sc].frees = 0;
+        counters[sc].heapFrees = 0;
+    }
+}
+
+}
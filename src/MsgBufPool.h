@@ -0,0 +1,128 @@
+#ifndef _ALLJOYN_MSGBUFPOOL_H
+#define _ALLJOYN_MSGBUFPOOL_H
+/**
+ * @file
+ * MsgBufPool is a process-wide pool of size-classed buffers used to hold
+ * marshaled messages.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MsgBufPool.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+namespace ajn {
+
+/**
+ * MsgBufPool recycles message buffers so that marshaling and unmarshaling a message
+ * does not normally touch the heap. Requests are rounded up to one of a small number of
+ * size classes. Freed buffers are kept on a per-thread cache first and then on a shared
+ * per-class free list; requests larger than the biggest size class go straight to the
+ * heap. Buffers are reference counted so that an immutable marshaled message can be
+ * shared by several _Message instances. All methods are thread-safe.
+ */
+class MsgBufPool {
+  public:
+
+    /** Number of size classes */
+    static const size_t NUM_SIZE_CLASSES = 6;
+
+    /**
+     * Allocation counters for one size class. Counters are maintained without locks
+     * and may wrap.
+     */
+    struct Stats {
+        uint32_t allocs;      /**< Total number of buffers allocated */
+        uint32_t threadHits;  /**< Allocations satisfied from the calling thread's cache */
+        uint32_t poolHits;    /**< Allocations satisfied from the shared free list */
+        uint32_t heapAllocs;  /**< Allocations that had to go to the heap */
+        uint32_t frees;       /**< Total number of buffers freed */
+        uint32_t heapFrees;   /**< Frees that returned the buffer to the heap */
+    };
+
+    /**
+     * Allocate a buffer.
+     *
+     * @param size   Minimum number of bytes required.
+     *
+     * @return  A buffer of at least size bytes that must be released with Free().
+     */
+    static uint8_t* Alloc(size_t size);
+
+    /**
+     * Release a reference to a buffer allocated with Alloc(). The buffer is recycled when
+     * the last reference is released.
+     *
+     * @param buf   The buffer to release, may be NULL.
+     */
+    static void Free(uint8_t* buf);
+
+    /**
+     * Add a reference to a buffer allocated with Alloc().
+     *
+     * @param buf   The buffer to share.
+     */
+    static void AddRef(uint8_t* buf);
+
+    /**
+     * Determine if a buffer has more than one reference. A shared buffer must not be
+     * modified.
+     *
+     * @param buf   The buffer.
+     *
+     * @return  true if the buffer is shared.
+     */
+    static bool IsShared(const uint8_t* buf);
+
+    /**
+     * Keep a reference to another buffer for as long as a buffer is in use. This is used when
+     * a buffer is copied and there may still be pointers into the original.
+     *
+     * @param buf       The buffer that now owns the retained reference.
+     * @param retained  The buffer to keep alive, the caller's reference is transferred.
+     */
+    static void Retain(uint8_t* buf, uint8_t* retained);
+
+    /**
+     * Get the buffer size of a size class.
+     *
+     * @param sizeClass   The size class, NUM_SIZE_CLASSES is the class for oversized buffers.
+     *
+     * @return  The size in bytes of buffers in the size class or 0 for the oversize class.
+     */
+    static size_t GetClassSize(size_t sizeClass);
+
+    /**
+     * Get the allocation counters.
+     *
+     * @param stats   [OUT] Counters for each size class followed by the counters for
+     *                oversized buffers.
+     */
+    static void GetStats(Stats stats[NUM_SIZE_CLASSES + 1]);
+
+    /**
+     * Reset all allocation counters to zero.
+     */
+    static void ResetStats();
+};
+
+}
+
+#endif
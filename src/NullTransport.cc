@@ -36,6 +36,8 @@
 #include "RemoteEndpoint.h"
 #include "NullTransport.h"
 #include "AllJoynPeerObj.h"
+#include "MessageCapture.h"
+#include "MessageTrace.h"
 
 #define QCC_MODULE "NULL_TRANSPORT"
 
@@ -183,6 +185,10 @@ QStatus _NullEndpoint::PushMessage(Message& msg)
             }
         }
         if (status == ER_OK) {
+            /* Capture what a remote endpoint would have received, that is after encryption */
+            if (MessageCapture::IsEnabled()) {
+                MessageCapture::Record(msg, MessageTrace::NameHash(uniqueName.c_str()));
+            }
             msg->bus = &daemonBus;
             status = daemonBus.GetInternal().GetRouter().PushMessage(msg, busEndpoint);
             if (status != ER_STOPPING_THREAD) {
@@ -209,7 +215,10 @@ QStatus _NullEndpoint::PushMessage(Message& msg)
         CheckRegisterEndpoint();
         /*
          * We need to clone broadcast signals because each receiving bus attachment must be
-         * able to unmarshal the arg list including decrypting and doing header expansion.
+         * able to unmarshal the arg list including decrypting and doing header expansion. The
+         * clone shares the marshaled buffer and the header strings in it with the original so
+         * only the header fields that are rewritten later get copied. All other messages are
+         * handed over as they are.
          */
         if (msg->IsBroadcastSignal()) {
             Message clone(msg, true /*deep copy*/);
@@ -24,6 +24,11 @@
 #include <algorithm>
 #include <limits>
 
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
+#include <qcc/atomic.h>
 #include <qcc/Debug.h>
 #include <qcc/Crypto.h>
 #include <qcc/time.h>
@@ -86,18 +91,140 @@ bool _PeerState::IsValidSerial(uint32_t serial, bool secure, bool unreliable)
 
 }
 
+/*
+ * Bumped whenever any peer state table removes or remaps a bus name (process wide so a table
+ * allocated at the address of a deleted one cannot match stale cache entries).
+ */
+static volatile int32_t tableGeneration = 0;
+
+/*
+ * Each thread remembers the last few peer states it looked up. A thread sending or receiving
+ * secure messages usually talks to a handful of peers so this avoids the shard lock and the map
+ * lookup for most messages. Entries are only valid for the generation they were looked up in.
+ */
+static const size_t NUM_CACHED_PEERS = 4;
+
+struct PeerCache {
+    struct Entry {
+        const PeerStateTable* table;
+        qcc::String busName;
+        PeerState peerState;
+        Entry() : table(NULL) { }
+    } entries[NUM_CACHED_PEERS];
+    int32_t generation;
+    size_t next;
+
+    PeerCache() : generation(0), next(0) { }
+
+    void Flush(int32_t gen)
+    {
+        for (size_t i = 0; i < NUM_CACHED_PEERS; ++i) {
+            entries[i].table = NULL;
+            entries[i].busName.clear();
+            entries[i].peerState = PeerState();
+        }
+        generation = gen;
+    }
+};
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/* Called on thread exit to release the thread's cached peer states */
+static void ReleasePeerCache(void* arg)
+{
+    delete reinterpret_cast<PeerCache*>(arg);
+}
+
+static pthread_key_t peerCacheKey;
+static bool peerCacheKeyValid = (pthread_key_create(&peerCacheKey, ReleasePeerCache) == 0);
+
+static PeerCache* GetPeerCache()
+{
+    if (!peerCacheKeyValid) {
+        return NULL;
+    }
+    PeerCache* cache = reinterpret_cast<PeerCache*>(pthread_getspecific(peerCacheKey));
+    if (!cache) {
+        cache = new PeerCache;
+        if (pthread_setspecific(peerCacheKey, cache) != 0) {
+            delete cache;
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+#else
+
+/* Per-thread peer caches are only implemented for posix, other platforms always use the table */
+static PeerCache* GetPeerCache()
+{
+    return NULL;
+}
+
+#endif
+
 PeerStateTable::PeerStateTable()
 {
     Clear();
 }
 
+PeerStateTable::Shard& PeerStateTable::GetShard(const qcc::String& busName)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    for (const char* p = busName.c_str(); *p; ++p) {
+        hash = (hash ^ (uint8_t)*p) * 16777619U;
+    }
+    return shards[hash % NUM_SHARDS];
+}
+
+void PeerStateTable::LockAll()
+{
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        shards[i].lock.Lock(MUTEX_CONTEXT);
+    }
+}
+
+void PeerStateTable::UnlockAll()
+{
+    for (size_t i = NUM_SHARDS; i > 0; --i) {
+        shards[i - 1].lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
 PeerState PeerStateTable::GetPeerState(const qcc::String& busName)
 {
-    lock.Lock(MUTEX_CONTEXT);
-    QCC_DbgHLPrintf(("PeerStateTable::GetPeerState() %s state for %s", peerMap.count(busName) ? "got" : "no", busName.c_str()));
-    PeerState result = peerMap[busName];
-    lock.Unlock(MUTEX_CONTEXT);
+    /*
+     * The generation must be read before the table is so a remapping that races with the lookup
+     * leaves the cached entry tagged with an older generation.
+     */
+    int32_t gen = tableGeneration;
+    PeerCache* cache = GetPeerCache();
+    if (cache) {
+        if (cache->generation != gen) {
+            cache->Flush(gen);
+        }
+        for (size_t i = 0; i < NUM_CACHED_PEERS; ++i) {
+            if ((cache->entries[i].table == this) && (cache->entries[i].busName == busName)) {
+                return cache->entries[i].peerState;
+            }
+        }
+    }
+
+    Shard& shard = GetShard(busName);
+    shard.lock.Lock(MUTEX_CONTEXT);
+    QCC_DbgHLPrintf(("PeerStateTable::GetPeerState() %s state for %s", shard.peerMap.count(busName) ? "got" : "no", busName.c_str()));
+    PeerState result = shard.peerMap[busName];
+    shard.lock.Unlock(MUTEX_CONTEXT);
 
+    if (cache) {
+        PeerCache::Entry& entry = cache->entries[cache->next];
+        cache->next = (cache->next + 1) % NUM_CACHED_PEERS;
+        entry.table = this;
+        entry.busName = busName;
+        entry.peerState = result;
+    }
     return result;
 }
 
@@ -105,27 +232,44 @@ PeerState PeerStateTable::GetPeerState(const qcc::String& uniqueName, const qcc:
 {
     assert(uniqueName[0] == ':');
     PeerState result;
-    lock.Lock(MUTEX_CONTEXT);
-    std::map<const qcc::String, PeerState>::iterator iter = peerMap.find(uniqueName);
-    if (iter == peerMap.end()) {
+    Shard& uniqueShard = GetShard(uniqueName);
+    Shard& aliasShard = GetShard(aliasName);
+    /*
+     * Lock both shards in index order so two threads aliasing names in opposite directions cannot
+     * deadlock.
+     */
+    Shard* first = (&uniqueShard < &aliasShard) ? &uniqueShard : &aliasShard;
+    Shard* second = (&uniqueShard < &aliasShard) ? &aliasShard : &uniqueShard;
+    first->lock.Lock(MUTEX_CONTEXT);
+    if (second != first) {
+        second->lock.Lock(MUTEX_CONTEXT);
+    }
+    std::map<const qcc::String, PeerState>::iterator iter = uniqueShard.peerMap.find(uniqueName);
+    if (iter == uniqueShard.peerMap.end()) {
         QCC_DbgHLPrintf(("PeerStateTable::GetPeerState() no state stored for %s aka %s", uniqueName.c_str(), aliasName.c_str()));
-        result = peerMap[aliasName];
-        peerMap[uniqueName] = result;
+        result = aliasShard.peerMap[aliasName];
+        uniqueShard.peerMap[uniqueName] = result;
     } else {
         QCC_DbgHLPrintf(("PeerStateTable::GetPeerState() got state for %s aka %s", uniqueName.c_str(), aliasName.c_str()));
         result = iter->second;
-        peerMap[aliasName] = result;
+        aliasShard.peerMap[aliasName] = result;
     }
-    lock.Unlock(MUTEX_CONTEXT);
+    IncrementAndFetch(&tableGeneration);
+    if (second != first) {
+        second->lock.Unlock(MUTEX_CONTEXT);
+    }
+    first->lock.Unlock(MUTEX_CONTEXT);
     return result;
 }
 
 void PeerStateTable::DelPeerState(const qcc::String& busName)
 {
-    lock.Lock(MUTEX_CONTEXT);
-    QCC_DbgHLPrintf(("PeerStateTable::DelPeerState() %s for %s", peerMap.count(busName) ? "remove state" : "no state to remove", busName.c_str()));
-    peerMap.erase(busName);
-    lock.Unlock(MUTEX_CONTEXT);
+    Shard& shard = GetShard(busName);
+    shard.lock.Lock(MUTEX_CONTEXT);
+    QCC_DbgHLPrintf(("PeerStateTable::DelPeerState() %s for %s", shard.peerMap.count(busName) ? "remove state" : "no state to remove", busName.c_str()));
+    shard.peerMap.erase(busName);
+    IncrementAndFetch(&tableGeneration);
+    shard.lock.Unlock(MUTEX_CONTEXT);
 }
 
 void PeerStateTable::GetGroupKey(qcc::KeyBlob& key)
@@ -144,22 +288,28 @@ void PeerStateTable::GetGroupKey(qcc::KeyBlob& key)
 void PeerStateTable::Clear()
 {
     qcc::KeyBlob key;
-    lock.Lock(MUTEX_CONTEXT);
-    peerMap.clear();
+    LockAll();
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        shards[i].peerMap.clear();
+    }
     PeerState nullPeer;
     QCC_DbgHLPrintf(("Allocating group key"));
     key.Rand(Crypto_AES::AES128_SIZE, KeyBlob::AES);
     key.SetTag("GroupKey", KeyBlob::NO_ROLE);
     nullPeer->SetKey(key, PEER_SESSION_KEY);
-    peerMap[""] = nullPeer;
-    lock.Unlock(MUTEX_CONTEXT);
+    GetShard("").peerMap[""] = nullPeer;
+    IncrementAndFetch(&tableGeneration);
+    UnlockAll();
 }
 
 PeerStateTable::~PeerStateTable()
 {
-    lock.Lock(MUTEX_CONTEXT);
-    peerMap.clear();
-    lock.Unlock(MUTEX_CONTEXT);
+    LockAll();
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        shards[i].peerMap.clear();
+    }
+    IncrementAndFetch(&tableGeneration);
+    UnlockAll();
 }
 
 }
@@ -337,7 +337,8 @@ class PeerStateTable {
     PeerStateTable();
 
     /**
-     * Get the peer state for given a bus name.
+     * Get the peer state for given a bus name. Recent lookups are cached per thread until any bus
+     * name is removed or remapped so repeated lookups for the same peer don't take a lock.
      *
      * @param busName   The bus name for a remote connection
      *
@@ -353,9 +354,10 @@ class PeerStateTable {
      * @return  Returns true if the peer is known.
      */
     bool IsKnownPeer(const qcc::String& busName) {
-        lock.Lock(MUTEX_CONTEXT);
-        bool known = peerMap.count(busName) > 0;
-        lock.Unlock(MUTEX_CONTEXT);
+        Shard& shard = GetShard(busName);
+        shard.lock.Lock(MUTEX_CONTEXT);
+        bool known = shard.peerMap.count(busName) > 0;
+        shard.lock.Unlock(MUTEX_CONTEXT);
         return known;
     }
 
@@ -409,14 +411,35 @@ class PeerStateTable {
   private:
 
     /**
-     * Mapping table from bus names to peer state.
+     * The peer state is looked up for every secure message so the table is split into shards by a
+     * hash of the bus name. Lookups for different peers usually take different locks.
      */
-    std::map<const qcc::String, PeerState> peerMap;
+    static const size_t NUM_SHARDS = 16;
 
     /**
-     * Mutex to protect the peer table
+     * A shard of the peer table.
      */
-    qcc::Mutex lock;
+    struct Shard {
+        std::map<const qcc::String, PeerState> peerMap;  /**< Mapping from bus names to peer state */
+        qcc::Mutex lock;                                 /**< Mutex to protect peerMap */
+    };
+
+    /**
+     * Get the shard that holds the peer state for a bus name.
+     *
+     * @param busName  The bus name
+     *
+     * @return  The shard for the bus name.
+     */
+    Shard& GetShard(const qcc::String& busName);
+
+    /**
+     * Lock or unlock every shard, shards are always locked in index order.
+     */
+    void LockAll();
+    void UnlockAll();
+
+    Shard shards[NUM_SHARDS];
 
 };
 
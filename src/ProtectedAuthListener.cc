@@ -23,6 +23,7 @@
 #include <qcc/String.h>
 #include <qcc/Thread.h>
 #include <qcc/Debug.h>
+#include <qcc/time.h>
 
 #include "ProtectedAuthListener.h"
 
@@ -38,6 +39,9 @@ using namespace qcc;
 
 static const uint32_t ASYNC_AUTH_TIMEOUT = (120 * 1000);
 
+/* Upper bound on the number of remembered credentials */
+static const size_t MAX_VERIFIED = 128;
+
 class AuthContext {
   public:
     AuthContext(AuthListener* listener, AuthListener::Credentials* credentials) : listener(listener), accept(false), credentials(credentials) { }
@@ -187,6 +191,10 @@ void ProtectedAuthListener::Set(AuthListener* listener)
      */
     this->listener = listener;
     lock.Unlock(MUTEX_CONTEXT);
+    /*
+     * What the previous listener accepted says nothing about the new one
+     */
+    ClearVerified();
 }
 
 bool ProtectedAuthListener::RequestCredentials(const char* authMechanism, const char* peerName, uint16_t authCount, const char* userName, uint16_t credMask, Credentials& credentials)
@@ -245,6 +253,77 @@ bool ProtectedAuthListener::VerifyCredentials(const char* authMechanism, const c
     return ok;
 }
 
+uint32_t ProtectedAuthListener::VerifiedCredentialsLifetime(const char* authMechanism, const Credentials& credentials)
+{
+    uint32_t lifetime = 0;
+    lock.Lock(MUTEX_CONTEXT);
+    AuthListener* listener = this->listener;
+    ++refCount;
+    lock.Unlock(MUTEX_CONTEXT);
+    if (listener) {
+        lifetime = listener->VerifiedCredentialsLifetime(authMechanism, credentials);
+    }
+    lock.Lock(MUTEX_CONTEXT);
+    --refCount;
+    lock.Unlock(MUTEX_CONTEXT);
+    return lifetime;
+}
+
+bool ProtectedAuthListener::IsVerified(const char* authMechanism, const qcc::String& digest)
+{
+    bool found = false;
+    qcc::String key = qcc::String(authMechanism) + ":" + digest;
+    uint64_t now = GetTimestamp64();
+    verifiedLock.Lock(MUTEX_CONTEXT);
+    std::map<qcc::String, uint64_t>::iterator it = verified.find(key);
+    if (it != verified.end()) {
+        if (it->second > now) {
+            found = true;
+        } else {
+            verified.erase(it);
+        }
+    }
+    verifiedLock.Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
+void ProtectedAuthListener::AddVerified(const char* authMechanism, const qcc::String& digest, const Credentials& credentials)
+{
+    uint32_t lifetime = VerifiedCredentialsLifetime(authMechanism, credentials);
+    if (lifetime == 0) {
+        return;
+    }
+    uint64_t now = GetTimestamp64();
+    verifiedLock.Lock(MUTEX_CONTEXT);
+    if (verified.size() >= MAX_VERIFIED) {
+        /* Make room by dropping whatever has expired, or failing that the entry closest to expiry */
+        std::map<qcc::String, uint64_t>::iterator soonest = verified.end();
+        std::map<qcc::String, uint64_t>::iterator it = verified.begin();
+        while (it != verified.end()) {
+            if (it->second <= now) {
+                verified.erase(it++);
+            } else {
+                if ((soonest == verified.end()) || (it->second < soonest->second)) {
+                    soonest = it;
+                }
+                ++it;
+            }
+        }
+        if ((verified.size() >= MAX_VERIFIED) && (soonest != verified.end())) {
+            verified.erase(soonest);
+        }
+    }
+    verified[qcc::String(authMechanism) + ":" + digest] = now + static_cast<uint64_t>(lifetime) * 1000;
+    verifiedLock.Unlock(MUTEX_CONTEXT);
+}
+
+void ProtectedAuthListener::ClearVerified()
+{
+    verifiedLock.Lock(MUTEX_CONTEXT);
+    verified.clear();
+    verifiedLock.Unlock(MUTEX_CONTEXT);
+}
+
 void ProtectedAuthListener::SecurityViolation(QStatus status, const Message& msg)
 {
     lock.Lock(MUTEX_CONTEXT);
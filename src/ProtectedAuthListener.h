@@ -31,6 +31,8 @@
 #include <qcc/String.h>
 #include <qcc/Thread.h>
 
+#include <map>
+
 #include <alljoyn/AuthListener.h>
 
 #include <alljoyn/Status.h>
@@ -58,7 +60,8 @@ class ProtectedAuthListener : public AuthListener {
 
     /**
      * Set the listener. If one of internal listener callouts is currently being called this
-     * function will block until the callout returns.
+     * function will block until the callout returns. Credentials remembered for the previous
+     * listener are forgotten.
      */
     void Set(AuthListener* listener);
 
@@ -72,6 +75,35 @@ class ProtectedAuthListener : public AuthListener {
      */
     bool VerifyCredentials(const char* authMechanism, const char* peerName, const Credentials& credentials);
 
+    /**
+     * Simply wraps the call of the same name to the inner AuthListener
+     */
+    uint32_t VerifiedCredentialsLifetime(const char* authMechanism, const Credentials& credentials);
+
+    /**
+     * Check if credentials were verified earlier and are still remembered.
+     *
+     * @param authMechanism  The name of the authentication mechanism checking.
+     * @param digest         A digest of the credentials.
+     *
+     * @return  true if the credentials need not be verified again.
+     */
+    bool IsVerified(const char* authMechanism, const qcc::String& digest);
+
+    /**
+     * Remember credentials that were verified for as long as the listener allows.
+     *
+     * @param authMechanism  The name of the authentication mechanism that verified them.
+     * @param digest         A digest of the credentials.
+     * @param credentials    The credentials, passed to VerifiedCredentialsLifetime().
+     */
+    void AddVerified(const char* authMechanism, const qcc::String& digest, const Credentials& credentials);
+
+    /**
+     * Forget all remembered credentials.
+     */
+    void ClearVerified();
+
     /**
      * Simply wraps the call of the same name to the inner AuthListener
      */
@@ -95,6 +127,13 @@ class ProtectedAuthListener : public AuthListener {
      * Reference count so we know when the inner listener is no longer in use.
      */
     volatile int32_t refCount;
+
+    qcc::Mutex verifiedLock;
+
+    /*
+     * Expiry times of remembered credentials keyed by mechanism name and digest.
+     */
+    std::map<qcc::String, uint64_t> verified;
 };
 
 }
@@ -26,6 +26,10 @@
 #include <vector>
 #include <map>
 
+#if defined(QCC_OS_GROUP_POSIX)
+#include <pthread.h>
+#endif
+
 #include <qcc/Debug.h>
 #include <qcc/String.h>
 #include <qcc/StringSource.h>
@@ -34,6 +38,8 @@
 #include <qcc/Event.h>
 #include <qcc/Mutex.h>
 #include <qcc/ManagedObj.h>
+#include <qcc/atomic.h>
+#include <qcc/STLContainer.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/DBusStd.h>
@@ -46,6 +52,7 @@
 #include "LocalTransport.h"
 #include "AllJoynPeerObj.h"
 #include "BusInternal.h"
+#include "LatencyHistogram.h"
 #include "XmlHelper.h"
 
 #include <alljoyn/Status.h>
@@ -60,16 +67,106 @@ using namespace std;
 
 namespace ajn {
 
+/** Bumped by every RemoveChild() so no path cache can hold on to an object that left its tree */
+static volatile int32_t childRemovals = 0;
+
+struct ChildPathHash {
+    inline size_t operator()(const qcc::String& s) const {
+        return qcc::hash_string(s.c_str());
+    }
+};
+
 struct ProxyBusObject::Components {
 
+    Components() : cachedNode(NULL), cachedRemovals(0) { }
+
     /** The interfaces this object implements */
     map<qcc::StringMapKey, const InterfaceDescription*> ifaces;
 
     /** Names of child objects of this object */
     vector<_ProxyBusObject> children;
 
+    /** Position of each child in children by its object path */
+    unordered_map<qcc::String, size_t, ChildPathHash> childIndex;
+
+    /** Path of the parent of the object found by the last lookup that went more than one level down */
+    qcc::String cachedPath;
+
+    /** The object at cachedPath, only used while cachedRemovals matches childRemovals */
+    ProxyBusObject* cachedNode;
+    int32_t cachedRemovals;
+
     /** List of threads that are waiting in sync method calls */
     vector<Thread*> waitingThreads;
+
+    /** Cached property values by interface, there is an entry for each interface being cached */
+    map<qcc::String, map<qcc::String, MsgArg> > propCache;
+
+    /** Unique name of the remote object's owner, only its PropertiesChanged signals update the cache */
+    qcc::String propCacheOwner;
+
+    /** Find a child by its object path, NULL if there is none */
+    ProxyBusObject* FindChild(const qcc::String& childPath)
+    {
+        unordered_map<qcc::String, size_t, ChildPathHash>::const_iterator it = childIndex.find(childPath);
+        return (it == childIndex.end()) ? NULL : &(*children[it->second]);
+    }
+
+    /** Add a child that is not already a child, returns the added child */
+    ProxyBusObject* AppendChild(const _ProxyBusObject& child)
+    {
+        childIndex[child->GetPath()] = children.size();
+        children.push_back(child);
+        return &(*children.back());
+    }
+
+    /** Remove a child, returns false if there is no such child */
+    bool EraseChild(const qcc::String& childPath)
+    {
+        unordered_map<qcc::String, size_t, ChildPathHash>::iterator it = childIndex.find(childPath);
+        if (it == childIndex.end()) {
+            return false;
+        }
+        /* Children keep their order so the ones after the removed child move down by one */
+        size_t pos = it->second;
+        childIndex.erase(it);
+        children.erase(children.begin() + pos);
+        for (size_t i = pos; i < children.size(); ++i) {
+            childIndex[children[i]->GetPath()] = i;
+        }
+        IncrementAndFetch(&childRemovals);
+        return true;
+    }
+
+    /**
+     * Start a walk down to fullPath at the cached object if the path is below it. Lookups of the
+     * descendants of one object deep in a tree then only look up the last path segment.
+     */
+    void ResumeWalk(const qcc::String& fullPath, size_t& idx, ProxyBusObject*& cur)
+    {
+        if (cachedNode && (cachedRemovals == childRemovals) && (fullPath.size() > (cachedPath.size() + 1)) &&
+            (fullPath[cachedPath.size()] == '/') && (fullPath.compare(0, cachedPath.size(), cachedPath) == 0)) {
+            cur = cachedNode;
+            idx = cachedPath.size() + 1;
+        }
+    }
+
+    /** Remember the parent of the object a walk ended at, obj is the object that started the walk */
+    void EndWalk(ProxyBusObject* obj, const qcc::String& parentPath, ProxyBusObject* parent)
+    {
+        if (parent != obj) {
+            cachedPath = parentPath;
+            cachedNode = parent;
+            cachedRemovals = childRemovals;
+        }
+    }
+
+    /** Forget the cached object, the copy of a tree must not use the objects of the original */
+    void ClearWalkCache()
+    {
+        cachedPath.clear();
+        cachedNode = NULL;
+    }
 };
 
 template <typename _cbType> struct CBContext {
@@ -82,12 +179,242 @@ template <typename _cbType> struct CBContext {
     void* context;
 };
 
+/* Context for an asynchronous compact introspection that may have to be retried with XML */
+struct CompactIntrospectContext {
+    CompactIntrospectContext(ProxyBusObject::Listener* listener, ProxyBusObject::Listener::IntrospectCB callback, void* context, uint32_t timeout)
+        : listener(listener), callback(callback), context(context), timeout(timeout) { }
+
+    ProxyBusObject::Listener* listener;
+    ProxyBusObject::Listener::IntrospectCB callback;
+    void* context;
+    uint32_t timeout;
+};
+
+/* Returns true if an error reply means the remote object is there but doesn't implement compact introspection */
+static bool CompactIntrospectionMissing(const char* errorName)
+{
+    return errorName &&
+           (::strcmp("org.freedesktop.DBus.Error.ServiceUnknown", errorName) != 0) &&
+           (::strcmp("org.alljoyn.Bus.Timeout", errorName) != 0) &&
+           (::strcmp("org.alljoyn.Bus.Exiting", errorName) != 0);
+}
+
+/* Returns true if the owner of a property emits PropertiesChanged when it changes */
+static bool EmitsChanged(const InterfaceDescription* ifc, const char* propName)
+{
+    qcc::String emitsChanged;
+    return ifc && ifc->GetPropertyAnnotation(propName, org::freedesktop::DBus::AnnotateEmitsChanged, emitsChanged) &&
+           ((emitsChanged == "true") || (emitsChanged == "invalidates"));
+}
+
+/* Match rule for the PropertiesChanged signals of an object */
+static qcc::String PropertiesChangedRule(const qcc::String& path)
+{
+    return "type='signal',interface='" + qcc::String(org::freedesktop::DBus::Properties::InterfaceName) +
+           "',member='PropertiesChanged',path='" + path + "'";
+}
+
+bool ProxyBusObject::GetCachedProperty(const char* iface, const char* property, MsgArg& value) const
+{
+    bool found = false;
+    lock->Lock(MUTEX_CONTEXT);
+    map<qcc::String, map<qcc::String, MsgArg> >::const_iterator it = components->propCache.find(iface);
+    if (it != components->propCache.end()) {
+        map<qcc::String, MsgArg>::const_iterator pit = it->second.find(property);
+        if (pit != it->second.end()) {
+            value = pit->second;
+            found = true;
+        }
+    }
+    lock->Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
+void ProxyBusObject::CacheProperty(const char* iface, const char* property, const MsgArg* value) const
+{
+    lock->Lock(MUTEX_CONTEXT);
+    map<qcc::String, map<qcc::String, MsgArg> >::iterator it = components->propCache.find(iface);
+    if (it != components->propCache.end()) {
+        if (!value) {
+            it->second.erase(property);
+        } else if (EmitsChanged(bus->GetInterface(iface), property)) {
+            it->second[property] = *value;
+        }
+    }
+    lock->Unlock(MUTEX_CONTEXT);
+}
+
+bool ProxyBusObject::GetCachedProperties(const InterfaceDescription* ifc, MsgArg& values) const
+{
+    size_t numProps = ifc->GetProperties();
+    vector<const InterfaceDescription::Property*> props(numProps);
+    if (numProps) {
+        ifc->GetProperties(&props[0], numProps);
+    }
+    bool found = false;
+    lock->Lock(MUTEX_CONTEXT);
+    map<qcc::String, map<qcc::String, MsgArg> >::const_iterator it = components->propCache.find(ifc->GetName());
+    if (it != components->propCache.end()) {
+        /* GetAll can only be answered locally if every readable property is cached */
+        vector<MsgArg> entries;
+        entries.reserve(numProps);
+        found = true;
+        for (size_t i = 0; found && (i < numProps); ++i) {
+            if (props[i]->access & PROP_ACCESS_READ) {
+                map<qcc::String, MsgArg>::const_iterator pit = it->second.find(props[i]->name);
+                if (pit == it->second.end()) {
+                    found = false;
+                } else {
+                    const MsgArg* val = (pit->second.typeId == ALLJOYN_VARIANT) ? pit->second.v_variant.val : &pit->second;
+                    entries.push_back(MsgArg("{sv}", props[i]->name.c_str(), val));
+                }
+            }
+        }
+        if (found) {
+            values.Set("a{sv}", entries.size(), entries.empty() ? NULL : &entries[0]);
+            values.Stabilize();
+        }
+    }
+    lock->Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
+QStatus ProxyBusObject::EnablePropertyCache(const char* iface, uint32_t timeout)
+{
+    const InterfaceDescription* valueIface = bus->GetInterface(iface);
+    if (!valueIface) {
+        return ER_BUS_OBJECT_NO_SUCH_INTERFACE;
+    }
+    const InterfaceDescription* propIface = bus->GetInterface(org::freedesktop::DBus::Properties::InterfaceName);
+    if (propIface == NULL) {
+        return ER_BUS_NO_SUCH_INTERFACE;
+    }
+    lock->Lock(MUTEX_CONTEXT);
+    bool enabled = (components->propCache.find(iface) != components->propCache.end());
+    bool first = components->propCache.empty();
+    lock->Unlock(MUTEX_CONTEXT);
+    if (enabled) {
+        return ER_OK;
+    }
+
+    /*
+     * Subscribe before filling the cache so a change made after the GetAll is not missed
+     */
+    QStatus status = ER_OK;
+    if (first) {
+        status = bus->RegisterSignalHandler(this,
+                                            static_cast<MessageReceiver::SignalHandler>(&ProxyBusObject::PropertiesChangedHandler),
+                                            propIface->GetMember("PropertiesChanged"),
+                                            path.c_str());
+        if (status == ER_OK) {
+            status = bus->AddMatch(PropertiesChangedRule(path).c_str());
+            if (status != ER_OK) {
+                bus->UnregisterSignalHandler(this,
+                                             static_cast<MessageReceiver::SignalHandler>(&ProxyBusObject::PropertiesChangedHandler),
+                                             propIface->GetMember("PropertiesChanged"),
+                                             path.c_str());
+            }
+        }
+        if (status != ER_OK) {
+            return status;
+        }
+    }
+    uint8_t flags = 0;
+    if (valueIface->IsSecure()) {
+        flags |= ALLJOYN_FLAG_ENCRYPTED;
+    }
+    Message reply(*bus);
+    MsgArg arg = MsgArg("s", iface);
+    status = MethodCall(*(propIface->GetMember("GetAll")), &arg, 1, reply, timeout, flags);
+    if (status == ER_OK) {
+        MsgArg* entries;
+        size_t numEntries;
+        status = reply->GetArg(0)->Get("a{sv}", &numEntries, &entries);
+        if (status == ER_OK) {
+            lock->Lock(MUTEX_CONTEXT);
+            map<qcc::String, MsgArg>& props = components->propCache[iface];
+            for (size_t i = 0; i < numEntries; ++i) {
+                const char* propName = entries[i].v_dictEntry.key->v_string.str;
+                if (EmitsChanged(valueIface, propName)) {
+                    props[propName] = *entries[i].v_dictEntry.val;
+                }
+            }
+            components->propCacheOwner = reply->GetSender();
+            lock->Unlock(MUTEX_CONTEXT);
+        }
+    }
+    if ((status != ER_OK) && first) {
+        DisablePropertyCache(iface);
+    }
+    return status;
+}
+
+void ProxyBusObject::DisablePropertyCache(const char* iface)
+{
+    lock->Lock(MUTEX_CONTEXT);
+    components->propCache.erase(iface);
+    bool last = components->propCache.empty();
+    if (last) {
+        components->propCacheOwner.clear();
+    }
+    lock->Unlock(MUTEX_CONTEXT);
+    if (last) {
+        const InterfaceDescription* propIface = bus->GetInterface(org::freedesktop::DBus::Properties::InterfaceName);
+        if (propIface) {
+            bus->UnregisterSignalHandler(this,
+                                         static_cast<MessageReceiver::SignalHandler>(&ProxyBusObject::PropertiesChangedHandler),
+                                         propIface->GetMember("PropertiesChanged"),
+                                         path.c_str());
+        }
+        bus->RemoveMatch(PropertiesChangedRule(path).c_str());
+    }
+}
+
+void ProxyBusObject::PropertiesChangedHandler(const InterfaceDescription::Member* member, const char* srcPath, Message& msg)
+{
+    size_t numArgs;
+    const MsgArg* args;
+    msg->GetArgs(numArgs, args);
+    if ((numArgs != 3) || (args[0].typeId != ALLJOYN_STRING)) {
+        return;
+    }
+    const char* ifaceName = args[0].v_string.str;
+    const InterfaceDescription* ifc = bus->GetInterface(ifaceName);
+    MsgArg* changed;
+    size_t numChanged;
+    MsgArg* invalidated;
+    size_t numInvalidated;
+    if ((args[1].Get("a{sv}", &numChanged, &changed) != ER_OK) || (args[2].Get("as", &numInvalidated, &invalidated) != ER_OK)) {
+        return;
+    }
+
+    lock->Lock(MUTEX_CONTEXT);
+    if (components && !isExiting) {
+        map<qcc::String, map<qcc::String, MsgArg> >::iterator it = components->propCache.find(ifaceName);
+        /* Another object at the same path may be emitting the signal */
+        if ((it != components->propCache.end()) && (components->propCacheOwner == msg->GetSender())) {
+            for (size_t i = 0; i < numChanged; ++i) {
+                const char* propName = changed[i].v_dictEntry.key->v_string.str;
+                if (EmitsChanged(ifc, propName)) {
+                    it->second[propName] = *changed[i].v_dictEntry.val;
+                }
+            }
+            for (size_t i = 0; i < numInvalidated; ++i) {
+                it->second.erase(invalidated[i].v_string.str);
+            }
+        }
+    }
+    lock->Unlock(MUTEX_CONTEXT);
+}
+
 QStatus ProxyBusObject::GetAllProperties(const char* iface, MsgArg& value, uint32_t timeout) const
 {
     QStatus status;
     const InterfaceDescription* valueIface = bus->GetInterface(iface);
     if (!valueIface) {
         status = ER_BUS_OBJECT_NO_SUCH_INTERFACE;
+    } else if (GetCachedProperties(valueIface, value)) {
+        status = ER_OK;
     } else {
         uint8_t flags = 0;
         if (valueIface->IsSecure()) {
@@ -173,6 +500,8 @@ QStatus ProxyBusObject::GetProperty(const char* iface, const char* property, Msg
     const InterfaceDescription* valueIface = bus->GetInterface(iface);
     if (!valueIface) {
         status = ER_BUS_OBJECT_NO_SUCH_INTERFACE;
+    } else if (GetCachedProperty(iface, property, value)) {
+        status = ER_OK;
     } else {
         uint8_t flags = 0;
         if (valueIface->IsSecure()) {
@@ -189,12 +518,50 @@ QStatus ProxyBusObject::GetProperty(const char* iface, const char* property, Msg
             status = MethodCall(*(propIface->GetMember("Get")), inArgs, numArgs, reply, timeout, flags);
             if (ER_OK == status) {
                 value = *(reply->GetArg(0));
+                /* Refills a value that was invalidated */
+                CacheProperty(iface, property, &value);
             }
         }
     }
     return status;
 }
 
+QStatus ProxyBusObject::GetProperties(const char* iface, const char** properties, MsgArg* values, QStatus* statuses, size_t numProperties, uint32_t timeout) const
+{
+    const InterfaceDescription* valueIface = bus->GetInterface(iface);
+    if (!valueIface) {
+        return ER_BUS_OBJECT_NO_SUCH_INTERFACE;
+    }
+    const InterfaceDescription* propIface = bus->GetInterface(org::freedesktop::DBus::Properties::InterfaceName);
+    if (propIface == NULL) {
+        return ER_BUS_NO_SUCH_INTERFACE;
+    }
+    uint8_t flags = 0;
+    if (valueIface->IsSecure()) {
+        flags |= ALLJOYN_FLAG_ENCRYPTED;
+    }
+    const InterfaceDescription::Member* getMember = propIface->GetMember("Get");
+    std::vector<MsgArg> inArgs(2 * numProperties);
+    std::vector<BatchedCall> calls;
+    calls.reserve(numProperties);
+    for (size_t i = 0; i < numProperties; ++i) {
+        size_t numArgs = 2;
+        MsgArg::Set(&inArgs[2 * i], numArgs, "ss", iface, properties[i]);
+        calls.push_back(BatchedCall(*bus, *getMember, &inArgs[2 * i], numArgs, flags));
+    }
+    QStatus status = MethodCallBatch(numProperties ? &calls[0] : NULL, numProperties, timeout);
+    for (size_t i = 0; i < calls.size(); ++i) {
+        if (ER_OK == calls[i].status) {
+            values[i] = *(calls[i].replyMsg->GetArg(0));
+            CacheProperty(iface, properties[i], &values[i]);
+        }
+        if (statuses) {
+            statuses[i] = calls[i].status;
+        }
+    }
+    return status;
+}
+
 void ProxyBusObject::GetPropMethodCB(Message& message, void* context)
 {
     CBContext<Listener::GetPropertyCB>* ctx = reinterpret_cast<CBContext<Listener::GetPropertyCB>*>(context);
@@ -276,6 +643,8 @@ QStatus ProxyBusObject::SetProperty(const char* iface, const char* property, Msg
         if (propIface == NULL) {
             status = ER_BUS_NO_SUCH_INTERFACE;
         } else {
+            /* The cached value is refreshed by the PropertiesChanged signal or the next read */
+            CacheProperty(iface, property, NULL);
             status = MethodCall(*(propIface->GetMember("Set")),
                                 inArgs,
                                 numArgs,
@@ -287,6 +656,39 @@ QStatus ProxyBusObject::SetProperty(const char* iface, const char* property, Msg
     return status;
 }
 
+QStatus ProxyBusObject::SetProperties(const char* iface, const char** properties, MsgArg* values, QStatus* statuses, size_t numProperties, uint32_t timeout) const
+{
+    const InterfaceDescription* valueIface = bus->GetInterface(iface);
+    if (!valueIface) {
+        return ER_BUS_OBJECT_NO_SUCH_INTERFACE;
+    }
+    const InterfaceDescription* propIface = bus->GetInterface(org::freedesktop::DBus::Properties::InterfaceName);
+    if (propIface == NULL) {
+        return ER_BUS_NO_SUCH_INTERFACE;
+    }
+    uint8_t flags = 0;
+    if (valueIface->IsSecure()) {
+        flags |= ALLJOYN_FLAG_ENCRYPTED;
+    }
+    const InterfaceDescription::Member* setMember = propIface->GetMember("Set");
+    std::vector<MsgArg> inArgs(3 * numProperties);
+    std::vector<BatchedCall> calls;
+    calls.reserve(numProperties);
+    for (size_t i = 0; i < numProperties; ++i) {
+        size_t numArgs = 3;
+        MsgArg::Set(&inArgs[3 * i], numArgs, "ssv", iface, properties[i], &values[i]);
+        calls.push_back(BatchedCall(*bus, *setMember, &inArgs[3 * i], numArgs, flags));
+        CacheProperty(iface, properties[i], NULL);
+    }
+    QStatus status = MethodCallBatch(numProperties ? &calls[0] : NULL, numProperties, timeout);
+    if (statuses) {
+        for (size_t i = 0; i < calls.size(); ++i) {
+            statuses[i] = calls[i].status;
+        }
+    }
+    return status;
+}
+
 void ProxyBusObject::SetPropMethodCB(Message& message, void* context)
 {
     QStatus status = ER_OK;
@@ -331,6 +733,7 @@ QStatus ProxyBusObject::SetPropertyAsync(const char* iface,
         if (propIface == NULL) {
             status = ER_BUS_NO_SUCH_INTERFACE;
         } else {
+            CacheProperty(iface, property, NULL);
             CBContext<Listener::SetPropertyCB>* ctx = new CBContext<Listener::SetPropertyCB>(this, listener, callback, context);
             status = MethodCallAsync(*(propIface->GetMember("Set")),
                                      this,
@@ -449,28 +852,26 @@ ProxyBusObject* ProxyBusObject::GetChild(const char* inPath)
         return NULL;
     }
 
-    /* Find each path element as a child within the parent's vector of children */
+    /* Find each path element as a child within the parent's index of children */
     size_t idx = path.size() + 1;
     ProxyBusObject* cur = this;
+    ProxyBusObject* parent = this;
+    qcc::String parentPath;
     lock->Lock(MUTEX_CONTEXT);
+    components->ResumeWalk(inPathStr, idx, cur);
     while (idx != qcc::String::npos) {
         size_t end = inPathStr.find_first_of('/', idx);
-        qcc::String item = inPathStr.substr(0, end);
-        vector<_ProxyBusObject>& ch = cur->components->children;
-        vector<_ProxyBusObject>::iterator it = ch.begin();
-        while (it != ch.end()) {
-            if ((*it)->GetPath() == item) {
-                cur = &(*(*it));
-                break;
-            }
-            ++it;
-        }
-        if (it == ch.end()) {
+        ProxyBusObject* next = cur->components->FindChild(inPathStr.substr(0, end));
+        if (!next) {
             lock->Unlock(MUTEX_CONTEXT);
             return NULL;
         }
+        parent = cur;
+        parentPath = inPathStr.substr(0, idx - 1);
+        cur = next;
         idx = ((qcc::String::npos == end) || ((end + 1) == inPathStr.size())) ? qcc::String::npos : end + 1;
     }
+    components->EndWalk(this, parentPath, parent);
     lock->Unlock(MUTEX_CONTEXT);
     return cur;
 }
@@ -488,35 +889,29 @@ void* ProxyBusObject::GetManagedChild(const char* inPath)
         return NULL;
     }
 
-    /* Find each path element as a child within the parent's vector of children */
+    /* Find each path element as a child within the parent's index of children */
     size_t idx = path.size() + 1;
     ProxyBusObject* cur = this;
-    _ProxyBusObject mcur;
+    ProxyBusObject* parent = this;
+    qcc::String parentPath;
     lock->Lock(MUTEX_CONTEXT);
+    components->ResumeWalk(inPathStr, idx, cur);
     while (idx != qcc::String::npos) {
         size_t end = inPathStr.find_first_of('/', idx);
-        qcc::String item = inPathStr.substr(0, end);
-        vector<_ProxyBusObject>& ch = cur->components->children;
-        vector<_ProxyBusObject>::iterator it = ch.begin();
-        while (it != ch.end()) {
-            if ((*it)->GetPath() == item) {
-                cur = &(*(*it));
-                mcur = *(*it);
-                break;
-            }
-            ++it;
-        }
-        if (it == ch.end()) {
+        ProxyBusObject* next = cur->components->FindChild(inPathStr.substr(0, end));
+        if (!next) {
             lock->Unlock(MUTEX_CONTEXT);
             return NULL;
         }
+        parent = cur;
+        parentPath = inPathStr.substr(0, idx - 1);
+        cur = next;
         idx = ((qcc::String::npos == end) || ((end + 1) == inPathStr.size())) ? qcc::String::npos : end + 1;
     }
+    components->EndWalk(this, parentPath, parent);
+    _ProxyBusObject* mcur = new _ProxyBusObject(*cur);
     lock->Unlock(MUTEX_CONTEXT);
-    if (NULL != cur) {
-        return new _ProxyBusObject(mcur);
-    }
-    return NULL;
+    return mcur;
 }
 
 QStatus ProxyBusObject::AddChild(const ProxyBusObject& child)
@@ -530,38 +925,37 @@ QStatus ProxyBusObject::AddChild(const ProxyBusObject& child)
         return ER_BUS_BAD_CHILD_PATH;
     }
 
-    /* Find each path element as a child within the parent's vector of children */
+    /* Find each path element as a child within the parent's index of children */
     /* Add new children as necessary */
     size_t idx = path.size() + 1;
     ProxyBusObject* cur = this;
+    ProxyBusObject* parent = this;
+    qcc::String parentPath;
     lock->Lock(MUTEX_CONTEXT);
+    components->ResumeWalk(childPath, idx, cur);
     while (idx != qcc::String::npos) {
         size_t end = childPath.find_first_of('/', idx);
         qcc::String item = childPath.substr(0, end);
-        vector<_ProxyBusObject>& ch = cur->components->children;
-        vector<_ProxyBusObject>::iterator it = ch.begin();
-        while (it != ch.end()) {
-            if ((*it)->GetPath() == item) {
-                cur = &(*(*it));
-                break;
-            }
-            ++it;
-        }
-        if (it == ch.end()) {
+        ProxyBusObject* next = cur->components->FindChild(item);
+        if (!next) {
             if (childPath == item) {
-                ch.push_back(child);
+                cur->components->AppendChild(child);
+                components->EndWalk(this, childPath.substr(0, idx - 1), cur);
                 lock->Unlock(MUTEX_CONTEXT);
                 return ER_OK;
             } else {
                 const char* tempServiceName = serviceName.c_str();
                 const char* tempPath = item.c_str();
                 _ProxyBusObject ro(*bus, tempServiceName, tempPath, sessionId);
-                ch.push_back(ro);
-                cur = ch.empty() ? NULL : &(*(ch.back()));
+                next = cur->components->AppendChild(ro);
             }
         }
+        parent = cur;
+        parentPath = childPath.substr(0, idx - 1);
+        cur = next;
         idx = ((qcc::String::npos == end) || ((end + 1) == childPath.size())) ? qcc::String::npos : end + 1;
     }
+    components->EndWalk(this, parentPath, parent);
     lock->Unlock(MUTEX_CONTEXT);
     return ER_BUS_OBJ_ALREADY_EXISTS;
 }
@@ -585,30 +979,26 @@ QStatus ProxyBusObject::RemoveChild(const char* inPath)
     size_t idx = path.size() + 1;
     ProxyBusObject* cur = this;
     lock->Lock(MUTEX_CONTEXT);
+    components->ResumeWalk(childPath, idx, cur);
     while (idx != qcc::String::npos) {
         size_t end = childPath.find_first_of('/', idx);
         qcc::String item = childPath.substr(0, end);
-        vector<_ProxyBusObject>& ch = cur->components->children;
-        vector<_ProxyBusObject>::iterator it = ch.begin();
-        while (it != ch.end()) {
-            if ((*it)->GetPath() == item) {
-                if (end == qcc::String::npos) {
-                    ch.erase(it);
-                    lock->Unlock(MUTEX_CONTEXT);
-                    return ER_OK;
-                } else {
-                    cur = &(*(*it));
-                    break;
-                }
+        ProxyBusObject* next = NULL;
+        if (end == qcc::String::npos) {
+            if (cur->components->EraseChild(item)) {
+                lock->Unlock(MUTEX_CONTEXT);
+                return ER_OK;
             }
-            ++it;
+        } else {
+            next = cur->components->FindChild(item);
         }
-        if (it == ch.end()) {
+        if (!next) {
             status = ER_BUS_OBJ_NOT_FOUND;
             lock->Unlock(MUTEX_CONTEXT);
             QCC_LogError(status, ("Cannot find object path %s", item.c_str()));
             return status;
         }
+        cur = next;
         idx = ((qcc::String::npos == end) || ((end + 1) == childPath.size())) ? qcc::String::npos : end + 1;
     }
     /* Shouldn't get here */
@@ -713,11 +1103,70 @@ QStatus ProxyBusObject::MethodCallAsync(const char* ifaceName,
  */
 class SyncReplyContext {
   public:
-    SyncReplyContext(BusAttachment& bus) : replyMsg(bus) { }
+    SyncReplyContext(BusAttachment& bus) : replyMsg(bus), replied(false) { }
     Message replyMsg;
     Event event;
+    /* Set before the event so a spinning caller knows the event is about to be set */
+    volatile bool replied;
 };
 
+#if defined(QCC_OS_GROUP_POSIX)
+
+/*
+ * Each thread keeps the context of its last synchronous method call so the next call does not
+ * have to allocate a context and create an event. A context is only reused once the reply
+ * handler has let go of it, the reply to an aborted call may still be on its way.
+ */
+static void ReleaseSyncReplyContext(void* arg)
+{
+    delete reinterpret_cast<ManagedObj<SyncReplyContext>*>(arg);
+}
+
+static pthread_key_t syncReplyKey;
+static bool syncReplyKeyValid = (pthread_key_create(&syncReplyKey, ReleaseSyncReplyContext) == 0);
+
+static ManagedObj<SyncReplyContext> GetSyncReplyContext(BusAttachment& bus)
+{
+    ManagedObj<SyncReplyContext>* cached = syncReplyKeyValid ? reinterpret_cast<ManagedObj<SyncReplyContext>*>(pthread_getspecific(syncReplyKey)) : NULL;
+    if (cached && (cached->GetRefCount() == 1)) {
+        (*cached)->replied = false;
+        (*cached)->event.ResetEvent();
+        return *cached;
+    }
+    ManagedObj<SyncReplyContext> ctxt(bus);
+    if (syncReplyKeyValid) {
+        ManagedObj<SyncReplyContext>* newCached = new ManagedObj<SyncReplyContext>(ctxt);
+        if (pthread_setspecific(syncReplyKey, newCached) == 0) {
+            delete cached;
+        } else {
+            delete newCached;
+        }
+    }
+    return ctxt;
+}
+
+#else
+
+/* Reusing contexts is only implemented for posix, other platforms allocate one per call */
+static ManagedObj<SyncReplyContext> GetSyncReplyContext(BusAttachment& bus)
+{
+    return ManagedObj<SyncReplyContext>(bus);
+}
+
+#endif
+
+/* Tell the CPU a synchronous caller is spinning so it does not starve the thread delivering the reply */
+static inline void SpinPause()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__ ("pause");
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && (__ARM_ARCH >= 7)))
+    __asm__ __volatile__ ("yield");
+#else
+    qcc::Sleep(0);
+#endif
+}
+
 
 QStatus ProxyBusObject::MethodCall(const InterfaceDescription::Member& method,
                                    const MsgArg* args,
@@ -773,7 +1222,7 @@ QStatus ProxyBusObject::MethodCall(const InterfaceDescription::Member& method,
             status = bus->GetInternal().GetRouter().PushMessage(msg, busEndpoint);
         }
     } else {
-        ManagedObj<SyncReplyContext> ctxt(*bus);
+        ManagedObj<SyncReplyContext> ctxt = GetSyncReplyContext(*bus);
         /*
          * Synchronous calls are really asynchronous calls that block waiting for a builtin
          * reply handler to be called.
@@ -809,6 +1258,14 @@ QStatus ProxyBusObject::MethodCall(const InterfaceDescription::Member& method,
                  * SyncReplyHandler or ProxyBusObject::DestructComponents(in case the
                  * ProxyBusObject is being destroyed) or this thread is stopped.
                  */
+                uint32_t spin = bus->GetInternal().syncReplySpin;
+                if (spin) {
+                    uint64_t spinEnd = GetLatencyClock() + spin;
+                    while (!ctxt->replied && (GetLatencyClock() < spinEnd)) {
+                        SpinPause();
+                    }
+                }
+                /* Returns straight away if the reply arrived while spinning */
                 status = Event::Wait(ctxt->event);
                 lock->Lock(MUTEX_CONTEXT);
 
@@ -823,7 +1280,12 @@ QStatus ProxyBusObject::MethodCall(const InterfaceDescription::Member& method,
         }
 
         if (status == ER_OK) {
+            /*
+             * Leave an empty message in the cached context, keeping the reply or the caller's old
+             * message would hold on to its buffer and handles until the thread's next call.
+             */
             replyMsg = ctxt->replyMsg;
+            ctxt->replyMsg = Message(*bus);
         } else if ((status == ER_ALERTED_THREAD) && (SYNC_METHOD_ALERTCODE_ABORT == thisThread->GetAlertCode())) {
             /*
              * We can't touch anything in this case since the external thread that was waiting
@@ -882,6 +1344,7 @@ void ProxyBusObject::SyncReplyHandler(Message& msg, void* context)
 
     /* Set the reply message */
     (*ctx)->replyMsg = msg;
+    (*ctx)->replied = true;
 
     /* Wake up sync method_call thread */
     QStatus status = (*ctx)->event.SetEvent();
@@ -891,6 +1354,151 @@ void ProxyBusObject::SyncReplyHandler(Message& msg, void* context)
     delete ctx;
 }
 
+/**
+ * Internal context structure shared by the method calls in a batch
+ */
+class BatchReplyContext {
+  public:
+    BatchReplyContext(BusAttachment& bus, size_t numCalls) : replyMsgs(numCalls, Message(bus)), pending(1) { }
+    std::vector<Message> replyMsgs;
+    Event event;
+    /* Calls waiting for a reply plus one held by the caller until all calls are sent */
+    volatile int32_t pending;
+};
+
+/**
+ * Internal context structure for one method call in a batch
+ */
+struct BatchCallContext {
+    BatchCallContext(const ManagedObj<BatchReplyContext>& batch, size_t index) : batch(batch), index(index) { }
+    ManagedObj<BatchReplyContext> batch;
+    size_t index;
+};
+
+QStatus ProxyBusObject::MethodCallBatch(BatchedCall* calls, size_t numCalls, uint32_t timeout) const
+{
+    if (!calls && numCalls) {
+        return ER_BAD_ARG_1;
+    }
+    LocalEndpoint localEndpoint = bus->GetInternal().GetLocalEndpoint();
+    if (!localEndpoint->IsValid()) {
+        return ER_BUS_ENDPOINT_CLOSING;
+    }
+    /*
+     * Same restriction as for blocking method calls
+     */
+    if (localEndpoint->IsReentrantCall()) {
+        return ER_BUS_BLOCKING_CALL_NOT_ALLOWED;
+    }
+
+    /*
+     * Send all the method calls back-to-back. The replies are collected by the builtin batch
+     * reply handler which signals the event when the last one arrives.
+     */
+    ManagedObj<BatchReplyContext> batch(*bus, numCalls);
+    std::vector<bool> awaitingReply(numCalls, false);
+    for (size_t i = 0; i < numCalls; ++i) {
+        BatchedCall& call = calls[i];
+        if (!call.method) {
+            call.status = ER_BAD_ARG_1;
+            continue;
+        }
+        if (call.flags & ALLJOYN_FLAG_NO_REPLY_EXPECTED) {
+            call.status = MethodCallAsync(*call.method, NULL, NULL, call.args, call.numArgs, NULL, 0, call.flags);
+            continue;
+        }
+        BatchCallContext* callCtx = new BatchCallContext(batch, i);
+        IncrementAndFetch(&batch->pending);
+        call.status = MethodCallAsync(*call.method,
+                                      const_cast<MessageReceiver*>(static_cast<const MessageReceiver* const>(this)),
+                                      static_cast<MessageReceiver::ReplyHandler>(&ProxyBusObject::BatchReplyHandler),
+                                      call.args,
+                                      call.numArgs,
+                                      callCtx,
+                                      timeout,
+                                      call.flags);
+        if (call.status == ER_OK) {
+            awaitingReply[i] = true;
+        } else {
+            DecrementAndFetch(&batch->pending);
+            delete callCtx;
+        }
+    }
+
+    QStatus status = ER_OK;
+    if (DecrementAndFetch(&batch->pending) != 0) {
+        Thread* thisThread = Thread::GetThread();
+        lock->Lock(MUTEX_CONTEXT);
+        if (!isExiting) {
+            components->waitingThreads.push_back(thisThread);
+            lock->Unlock(MUTEX_CONTEXT);
+            /*
+             * Timed out calls are completed by the LocalEndpoint replyTimer so wait forever to be
+             * signalled by the last reply or ProxyBusObject::DestructComponents().
+             */
+            status = Event::Wait(batch->event);
+            lock->Lock(MUTEX_CONTEXT);
+
+            std::vector<Thread*>::iterator it = std::find(components->waitingThreads.begin(), components->waitingThreads.end(), thisThread);
+            if (it != components->waitingThreads.end()) {
+                components->waitingThreads.erase(it);
+            }
+        } else {
+            status = ER_BUS_STOPPING;
+        }
+        lock->Unlock(MUTEX_CONTEXT);
+
+        if ((status == ER_ALERTED_THREAD) && (SYNC_METHOD_ALERTCODE_ABORT == thisThread->GetAlertCode())) {
+            /*
+             * We can't touch anything in this case since the external thread that was waiting
+             * can't know whether this object still exists.
+             */
+            return ER_BUS_METHOD_CALL_ABORTED;
+        }
+    }
+
+    /*
+     * Report the outcome of each call. Calls still waiting for a reply if the wait was interrupted
+     * are left to the reply handler which only touches the shared context.
+     */
+    QStatus batchStatus = status;
+    for (size_t i = 0; i < numCalls; ++i) {
+        BatchedCall& call = calls[i];
+        if (awaitingReply[i]) {
+            if (status != ER_OK) {
+                call.status = status;
+            } else {
+                call.replyMsg = batch->replyMsgs[i];
+                if (call.replyMsg->GetType() == MESSAGE_ERROR) {
+                    call.status = ER_BUS_REPLY_IS_ERROR_MESSAGE;
+                } else if (call.replyMsg->GetType() == MESSAGE_INVALID) {
+                    call.status = ER_FAIL;
+                }
+            }
+        }
+        if ((batchStatus == ER_OK) && (call.status != ER_OK)) {
+            batchStatus = call.status;
+        }
+    }
+    return batchStatus;
+}
+
+void ProxyBusObject::BatchReplyHandler(Message& msg, void* context)
+{
+    BatchCallContext* ctx = reinterpret_cast<BatchCallContext*>(context);
+    BatchReplyContext& batch = *ctx->batch;
+
+    /* Set the reply message and wake up the batch method_call thread after the last reply */
+    batch.replyMsgs[ctx->index] = msg;
+    if (DecrementAndFetch(&batch.pending) == 0) {
+        QStatus status = batch.event.SetEvent();
+        if (ER_OK != status) {
+            QCC_LogError(status, ("SetEvent failed"));
+        }
+    }
+    delete ctx;
+}
+
 QStatus ProxyBusObject::SecureConnection(bool forceAuth)
 {
     if (!bus->IsPeerSecurityEnabled()) {
@@ -935,11 +1543,42 @@ QStatus ProxyBusObject::IntrospectRemoteObject(uint32_t timeout)
         AddInterface(*introIntf);
     }
 
+    /* Another proxy to the same object may already have introspected it */
+    qcc::String xml;
+    if (bus->GetInternal().GetCachedIntrospection(serviceName, path, xml)) {
+        QCC_DbgPrintf(("Cached introspection XML for %s %s", serviceName.c_str(), path.c_str()));
+        qcc::String ident = serviceName + " : " + path;
+        return ParseXml(xml.c_str(), ident.c_str());
+    }
+
+    /* Peers that implement it can describe the object with message args which are cheaper than XML */
+    QStatus status;
+    if (bus->GetInternal().SupportsCompactIntrospection(serviceName)) {
+        const InterfaceDescription* compactIntf = GetInterface(org::alljoyn::Bus::Introspectable::InterfaceName);
+        if (!compactIntf) {
+            compactIntf = bus->GetInterface(org::alljoyn::Bus::Introspectable::InterfaceName);
+            assert(compactIntf);
+            AddInterface(*compactIntf);
+        }
+        Message compactReply(*bus);
+        const InterfaceDescription::Member* compactMember = compactIntf->GetMember("IntrospectCompact");
+        assert(compactMember);
+        status = MethodCall(*compactMember, NULL, 0, compactReply, timeout);
+        if (ER_OK == status) {
+            return ParseCompact(compactReply);
+        }
+        if ((ER_BUS_REPLY_IS_ERROR_MESSAGE != status) || !CompactIntrospectionMissing(compactReply->GetErrorName())) {
+            return status;
+        }
+        /* The remote object predates compact introspection, fall back to XML */
+        bus->GetInternal().NoCompactIntrospection(serviceName);
+    }
+
     /* Attempt to retrieve introspection from the remote object using sync call */
     Message reply(*bus);
     const InterfaceDescription::Member* introMember = introIntf->GetMember("Introspect");
     assert(introMember);
-    QStatus status = MethodCall(*introMember, NULL, 0, reply, timeout);
+    status = MethodCall(*introMember, NULL, 0, reply, timeout);
 
     /* Parse the XML reply */
     if (ER_OK == status) {
@@ -948,6 +1587,9 @@ QStatus ProxyBusObject::IntrospectRemoteObject(uint32_t timeout)
         ident += " : ";
         ident += reply->GetObjectPath();
         status = ParseXml(reply->GetArg(0)->v_string.str, ident.c_str());
+        if (ER_OK == status) {
+            bus->GetInternal().CacheIntrospection(serviceName, path, reply->GetArg(0)->v_string.str);
+        }
     }
     return status;
 }
@@ -965,11 +1607,36 @@ QStatus ProxyBusObject::IntrospectRemoteObjectAsync(ProxyBusObject::Listener* li
         AddInterface(*introIntf);
     }
 
+    /* Peers that implement it can describe the object with message args which are cheaper than XML */
+    QStatus status;
+    if (bus->GetInternal().SupportsCompactIntrospection(serviceName)) {
+        const InterfaceDescription* compactIntf = GetInterface(org::alljoyn::Bus::Introspectable::InterfaceName);
+        if (!compactIntf) {
+            compactIntf = bus->GetInterface(org::alljoyn::Bus::Introspectable::InterfaceName);
+            assert(compactIntf);
+            AddInterface(*compactIntf);
+        }
+        const InterfaceDescription::Member* compactMember = compactIntf->GetMember("IntrospectCompact");
+        assert(compactMember);
+        CompactIntrospectContext* compactCtx = new CompactIntrospectContext(listener, callback, context, timeout);
+        status = MethodCallAsync(*compactMember,
+                                 this,
+                                 static_cast<MessageReceiver::ReplyHandler>(&ProxyBusObject::IntrospectCompactMethodCB),
+                                 NULL,
+                                 0,
+                                 reinterpret_cast<void*>(compactCtx),
+                                 timeout);
+        if (ER_OK == status) {
+            return status;
+        }
+        delete compactCtx;
+    }
+
     /* Attempt to retrieve introspection from the remote object using async call */
     const InterfaceDescription::Member* introMember = introIntf->GetMember("Introspect");
     assert(introMember);
     CBContext<Listener::IntrospectCB>* ctx = new CBContext<Listener::IntrospectCB>(this, listener, callback, context);
-    QStatus status = MethodCallAsync(*introMember,
+    status = MethodCallAsync(*introMember,
                                      this,
                                      static_cast<MessageReceiver::ReplyHandler>(&ProxyBusObject::IntrospectMethodCB),
                                      NULL,
@@ -996,6 +1663,9 @@ void ProxyBusObject::IntrospectMethodCB(Message& msg, void* context)
         ident += " : ";
         ident += msg->GetObjectPath();
         status = ParseXml(msg->GetArg(0)->v_string.str, ident.c_str());
+        if (ER_OK == status) {
+            bus->GetInternal().CacheIntrospection(serviceName, path, msg->GetArg(0)->v_string.str);
+        }
     } else if (::strcmp("org.freedesktop.DBus.Error.ServiceUnknown", msg->GetErrorName()) == 0) {
         status = ER_BUS_NO_SUCH_SERVICE;
     } else {
@@ -1007,6 +1677,47 @@ void ProxyBusObject::IntrospectMethodCB(Message& msg, void* context)
     delete ctx;
 }
 
+void ProxyBusObject::IntrospectCompactMethodCB(Message& msg, void* context)
+{
+    QStatus status;
+    CompactIntrospectContext* ctx = reinterpret_cast<CompactIntrospectContext*>(context);
+
+    if (msg->GetType() == MESSAGE_METHOD_RET) {
+        status = ParseCompact(msg);
+    } else if (::strcmp("org.freedesktop.DBus.Error.ServiceUnknown", msg->GetErrorName()) == 0) {
+        status = ER_BUS_NO_SUCH_SERVICE;
+    } else if (!CompactIntrospectionMissing(msg->GetErrorName())) {
+        status = ER_FAIL;
+    } else {
+        /* The remote object predates compact introspection, retry with XML */
+        bus->GetInternal().NoCompactIntrospection(serviceName);
+        status = IntrospectRemoteObjectAsync(ctx->listener, ctx->callback, ctx->context, ctx->timeout);
+        if (ER_OK == status) {
+            delete ctx;
+            return;
+        }
+    }
+
+    /* Call the callback */
+    (ctx->listener->*ctx->callback)(status, this, ctx->context);
+    delete ctx;
+}
+
+QStatus ProxyBusObject::ParseCompact(Message& reply)
+{
+    qcc::String ident = reply->GetSender();
+    ident += " : ";
+    ident += reply->GetObjectPath();
+    size_t numArgs;
+    const MsgArg* args;
+    reply->GetArgs(numArgs, args);
+    if (numArgs != 2) {
+        return ER_BUS_BAD_VALUE;
+    }
+    XmlHelper xmlHelper(bus, ident.c_str());
+    return xmlHelper.AddProxyObjects(*this, args[0], args[1]);
+}
+
 QStatus ProxyBusObject::ParseXml(const char* xml, const char* ident)
 {
     StringSource source(xml);
@@ -1034,6 +1745,7 @@ void ProxyBusObject::DestructComponents()
 {
     if (lock && components) {
         lock->Lock(MUTEX_CONTEXT);
+        bool cached = !components->propCache.empty();
         isExiting = true;
         vector<Thread*>::iterator it = components->waitingThreads.begin();
         while (it != components->waitingThreads.end()) {
@@ -1053,6 +1765,9 @@ void ProxyBusObject::DestructComponents()
         delete components;
         components = NULL;
         lock->Unlock(MUTEX_CONTEXT);
+        if (cached && bus) {
+            bus->RemoveMatch(PropertiesChangedRule(path).c_str());
+        }
     }
 }
 
@@ -1092,6 +1807,10 @@ ProxyBusObject::ProxyBusObject(const ProxyBusObject& other) :
     isExiting(false)
 {
     *components = *other.components;
+    /* The signal handler that keeps a cache coherent is registered for the original only */
+    components->propCache.clear();
+    components->propCacheOwner.clear();
+    components->ClearWalkCache();
 }
 
 ProxyBusObject& ProxyBusObject::operator=(const ProxyBusObject& other)
@@ -1101,6 +1820,9 @@ ProxyBusObject& ProxyBusObject::operator=(const ProxyBusObject& other)
         if (other.components) {
             components = new Components();
             *components = *other.components;
+            components->propCache.clear();
+            components->propCacheOwner.clear();
+            components->ClearWalkCache();
             if (!lock) {
                 lock = new Mutex();
             }
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * ReadySet watches a changing set of sockets for readability with one kqueue.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#if defined(QCC_OS_DARWIN)
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+#include <qcc/Debug.h>
+#include <qcc/Event.h>
+
+#include "ReadySet.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+#if defined(QCC_OS_DARWIN)
+
+/* Number of ready sockets collected per kevent() call */
+static const int READY_BATCH = 64;
+
+bool ReadySet::IsSupported()
+{
+    return true;
+}
+
+ReadySet::ReadySet() : kq(-1), event(NULL)
+{
+}
+
+ReadySet::~ReadySet()
+{
+    delete event;
+    if (kq != -1) {
+        close(kq);
+    }
+}
+
+QStatus ReadySet::Init()
+{
+    if (kq != -1) {
+        return ER_OK;
+    }
+    kq = kqueue();
+    if (kq == -1) {
+        QCC_LogError(ER_OS_ERROR, ("ReadySet::Init(): kqueue failed: %s", strerror(errno)));
+        return ER_OS_ERROR;
+    }
+    fcntl(kq, F_SETFD, FD_CLOEXEC);
+    event = new Event(kq, Event::IO_READ, false);
+    return ER_OK;
+}
+
+QStatus ReadySet::Update(const vector<Entry>& entries)
+{
+    if (kq == -1) {
+        return ER_INIT_FAILED;
+    }
+    map<SocketFd, Watched> next;
+    vector<struct kevent> changes;
+    changes.reserve(entries.size());
+    for (vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        Watched& w = next[it->fd];
+        w.key = it->key;
+        w.token = it->token;
+        /*
+         * A closed descriptor drops out of the kqueue by itself, so a descriptor that was reused
+         * by a new owner has to be added again even though it was never deleted.
+         */
+        map<SocketFd, Watched>::const_iterator wit = watched.find(it->fd);
+        if ((wit == watched.end()) || (wit->second.key != it->key) || (wit->second.token != it->token)) {
+            struct kevent kev;
+            EV_SET(&kev, it->fd, EVFILT_READ, EV_ADD | EV_CLEAR | EV_RECEIPT, 0, 0, it->key);
+            changes.push_back(kev);
+        }
+    }
+    for (map<SocketFd, Watched>::const_iterator wit = watched.begin(); wit != watched.end(); ++wit) {
+        if (next.find(wit->first) == next.end()) {
+            struct kevent kev;
+            EV_SET(&kev, wit->first, EVFILT_READ, EV_DELETE | EV_RECEIPT, 0, 0, NULL);
+            changes.push_back(kev);
+        }
+    }
+
+    QStatus status = ER_OK;
+    if (!changes.empty()) {
+        /* With EV_RECEIPT every change reports its own result and a failure does not stop the rest */
+        vector<struct kevent> results(changes.size());
+        struct timespec zero = { 0, 0 };
+        int n = kevent(kq, &changes[0], static_cast<int>(changes.size()), &results[0], static_cast<int>(results.size()), &zero);
+        if (n == -1) {
+            status = ER_OS_ERROR;
+            QCC_LogError(status, ("ReadySet::Update(): kevent failed: %s", strerror(errno)));
+            next.clear();
+        }
+        for (int i = 0; i < n; ++i) {
+            if ((results[i].flags & EV_ERROR) && (results[i].data != 0)) {
+                SocketFd fd = static_cast<SocketFd>(results[i].ident);
+                map<SocketFd, Watched>::iterator nit = next.find(fd);
+                /* Failing to delete a descriptor that was already closed is expected */
+                if (nit != next.end()) {
+                    status = ER_OS_ERROR;
+                    QCC_LogError(status, ("ReadySet::Update(): cannot watch socket %d: %s", fd, strerror(static_cast<int>(results[i].data))));
+                    next.erase(nit);
+                }
+            }
+        }
+    }
+    watched.swap(next);
+    return status;
+}
+
+void ReadySet::GetReady(vector<void*>& keys)
+{
+    if (kq == -1) {
+        return;
+    }
+    struct kevent ready[READY_BATCH];
+    struct timespec zero = { 0, 0 };
+    while (true) {
+        int n = kevent(kq, NULL, 0, ready, READY_BATCH, &zero);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            QCC_LogError(ER_OS_ERROR, ("ReadySet::GetReady(): kevent failed: %s", strerror(errno)));
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (!(ready[i].flags & EV_ERROR)) {
+                keys.push_back(ready[i].udata);
+            }
+        }
+        if (n < READY_BATCH) {
+            break;
+        }
+    }
+}
+
+#else
+
+bool ReadySet::IsSupported()
+{
+    return false;
+}
+
+ReadySet::ReadySet() : kq(-1), event(NULL)
+{
+}
+
+ReadySet::~ReadySet()
+{
+}
+
+QStatus ReadySet::Init()
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+QStatus ReadySet::Update(const vector<Entry>& entries)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+void ReadySet::GetReady(vector<void*>& keys)
+{
+}
+
+#endif
+
+}
@@ -0,0 +1,122 @@
+#ifndef _ALLJOYN_READYSET_H
+#define _ALLJOYN_READYSET_H
+/**
+ * @file
+ * ReadySet watches a changing set of sockets for readability with one kqueue.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include ReadySet.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/Event.h>
+#include <qcc/Socket.h>
+
+#include <map>
+#include <vector>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * ReadySet registers sockets with a kqueue once instead of handing every socket to each wait.
+ * The kqueue descriptor itself is readable while any registered socket is, so a loop waits on
+ * the single event returned by GetEvent() and then collects the ready sockets in batches.
+ *
+ * Registrations are edge-triggered (EV_CLEAR): a socket is reported again only when more data
+ * arrives, so whoever handles a ready socket must read until it would block.
+ *
+ * ReadySet is only available on Darwin. Elsewhere IsSupported() returns false and callers keep
+ * waiting on the sockets' own events. ReadySet is not thread-safe.
+ */
+class ReadySet {
+  public:
+
+    /**
+     * A socket to watch.
+     */
+    struct Entry {
+        qcc::SocketFd fd;   /**< The socket */
+        void* key;          /**< Returned by GetReady() when the socket is readable */
+        uint64_t token;     /**< Distinguishes a new owner of a reused descriptor and key */
+
+        Entry(qcc::SocketFd fd, void* key, uint64_t token) : fd(fd), key(key), token(token) { }
+    };
+
+    /**
+     * Check if ReadySet is available on this platform.
+     */
+    static bool IsSupported();
+
+    /** Constructor */
+    ReadySet();
+
+    /** Destructor */
+    ~ReadySet();
+
+    /**
+     * Create the kqueue.
+     *
+     * @return  ER_OK if the set can be used.
+     */
+    QStatus Init();
+
+    /**
+     * Make the watched sockets those in entries. Only the differences to the previous call are
+     * passed to the kernel, all in a single kevent() call.
+     *
+     * @param entries   The sockets to watch.
+     *
+     * @return  ER_OK, or an error if a socket could not be registered.
+     */
+    QStatus Update(const std::vector<Entry>& entries);
+
+    /**
+     * Get the event that is set while a watched socket is ready.
+     */
+    qcc::Event& GetEvent() { return *event; }
+
+    /**
+     * Collect the keys of the sockets that became readable since the last call.
+     *
+     * @param keys   [OUT] The keys are appended here.
+     */
+    void GetReady(std::vector<void*>& keys);
+
+  private:
+
+    /* Not copyable */
+    ReadySet(const ReadySet& other);
+    ReadySet& operator=(const ReadySet& other);
+
+    struct Watched {
+        void* key;
+        uint64_t token;
+    };
+
+    int kq;                                        /**< The kqueue */
+    qcc::Event* event;                             /**< Readable event on kq */
+    std::map<qcc::SocketFd, Watched> watched;      /**< Sockets currently registered */
+};
+
+}
+
+#endif
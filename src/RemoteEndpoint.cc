@@ -20,15 +20,22 @@
 #include <qcc/platform.h>
 
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
 
 #include <qcc/Debug.h>
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 #include <qcc/atomic.h>
+#include <qcc/Event.h>
 #include <qcc/Thread.h>
 #include <qcc/SocketStream.h>
 #include <qcc/atomic.h>
 #include <qcc/IODispatch.h>
+#include <qcc/time.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/AllJoynStd.h>
@@ -38,10 +45,16 @@
 #include "LocalTransport.h"
 #include "AllJoynPeerObj.h"
 #include "BusInternal.h"
-
-#ifndef NDEBUG
-#include <qcc/time.h>
-#endif
+#include "TxQueue.h"
+#include "MsgBufPool.h"
+#include "LatencyHistogram.h"
+#include "MessageTrace.h"
+#include "MessageCapture.h"
+#include "ValidationCache.h"
+#include "LinkMonitor.h"
+#include "MemoryAccounting.h"
+#include "SignalBatcher.h"
+#include "LogRateLimit.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -50,17 +63,79 @@ using namespace qcc;
 
 namespace ajn {
 
-#define ENDPOINT_IS_DEAD_ALERTCODE  1
+/** Default maximum number of messages in the transmit queue */
+static const size_t DEFAULT_MAX_TX_QUEUE_SIZE = 30;
+
+/** Maximum number of messages coalesced into a single vectored write */
+static const size_t MAX_TX_BATCH = 16;
+
+/*
+ * Size of the receive read-ahead buffer. Reads at least this big bypass the read-ahead buffer.
+ */
+static const size_t RX_READAHEAD_SIZE = 64 * 1024;
+
+/*
+ * Number of received messages that may wait for the routing workers before reading is paused.
+ * Reading resumes once half of them have been routed.
+ */
+static const uint32_t MAX_RX_STAGED = 64;
+
+/** Shortest time in milliseconds to wait for a ProbeAck however fast the link has answered before */
+static const uint32_t MIN_PROBE_WAIT = 1000;
+
+/*
+ * Transmit settings of a session carried by the endpoint. The rate limit is a token bucket
+ * holding at most one second's worth of bytes. The queue limits and policy only apply to the
+ * session's own messages, the limits of the link as a whole come from the daemon configuration.
+ */
+struct SessionShaping {
+    SessionShaping() : priority(SessionOpts::TXPRIORITY_INTERACTIVE), rateLimit(0), messageTtl(0), credit(0), lastCredit(0),
+        txPolicy(SessionOpts::TXQUEUE_BLOCK), maxMessages(0), maxBytes(0) { }
+    bool IsDefault() const
+    {
+        return (priority == SessionOpts::TXPRIORITY_INTERACTIVE) && (rateLimit == 0) && (messageTtl == 0) &&
+               (txPolicy == SessionOpts::TXQUEUE_BLOCK) && (maxMessages == 0) && (maxBytes == 0);
+    }
+    SessionOpts::TxPriority priority;   /**< Transmit priority of the session's messages */
+    uint32_t rateLimit;                 /**< Bytes per second, 0 means no limit */
+    uint32_t messageTtl;                /**< Time-to-live in ms of the session's messages on the link, 0 means none */
+    int64_t credit;                     /**< Bytes the session may send now, negative if it is in debt */
+    uint32_t lastCredit;                /**< Timestamp when credit was last topped up */
+    SessionOpts::TxQueuePolicy txPolicy; /**< Policy for the session's messages, TXQUEUE_BLOCK defers to the link's */
+    size_t maxMessages;                 /**< Most of the session's messages in the queue, 0 means only the link limit */
+    size_t maxBytes;                    /**< Most bytes of the session's messages in the queue, 0 means only the link limit */
+};
+
+static inline uint32_t GetSessionMessageTtl(const Message& msg, const map<SessionId, SessionShaping>& txSessions)
+{
+    if (txSessions.empty()) {
+        return 0;
+    }
+    map<SessionId, SessionShaping>::const_iterator it = txSessions.find(msg->GetSessionId());
+    return (it != txSessions.end()) ? it->second.messageTtl : 0;
+}
 
 class _RemoteEndpoint::Internal {
     friend class _RemoteEndpoint;
   public:
 
-    Internal(BusAttachment& bus, bool incoming, const qcc::String& connectSpec, Stream* stream, const char* threadName, bool isSocket) :
+    Internal(_RemoteEndpoint* ep, BusAttachment& bus, bool incoming, const qcc::String& connectSpec, Stream* stream, const char* threadName, bool isSocket) :
         bus(bus),
         stream(stream),
-        txQueue(),
-        txWaitQueue(),
+        emptyMsg(bus),
+        txQueue(emptyMsg, DEFAULT_MAX_TX_QUEUE_SIZE),
+        txNotFull(),
+        txDrained(),
+        maxTxBytes(0),
+        txPolicy(SessionOpts::TXQUEUE_BLOCK),
+        txBatchHead(0),
+        txBatchCount(0),
+        txBatchOffset(0),
+        vectoredTx(false),
+        encryptOnPush(true),
+        rxBuf(NULL),
+        rxPos(0),
+        rxEnd(0),
         lock(),
         exitCount(0),
         listener(NULL),
@@ -71,30 +146,67 @@ class _RemoteEndpoint::Internal {
         refCount(0),
         isSocket(isSocket),
         armRxPause(false),
+        rxReadAhead(true),
         idleTimeoutCount(0),
         maxIdleProbes(0),
         idleTimeout(0),
         probeTimeout(0),
+        link(ep),
+        probeSent(0),
+        srtt(0),
+        rttVar(0),
         threadName(threadName),
         started(false),
         currentReadMsg(bus),
         validateSender(incoming),
         hasRxSessionMsg(false),
+        rxStaged(0),
+        rxPaused(false),
         getNextMsg(true),
-        currentWriteMsg(bus),
+        currentWriteMsg(emptyMsg),
+        currentWriteTtl(0),
         stopping(false),
-        sessionId(0)
+        sessionId(0),
+        pendingAuth(NULL),
+        rxMessages(0),
+        rxBytes(0),
+        txMessages(0),
+        txBytes(0),
+        txQueueHighWater(0),
+        txDrops(0),
+        idleTimeouts(0),
+        txWriteStart(0),
+        traceName(0)
     {
+        txDrained.SetEvent();
     }
 
     ~Internal() {
+        MsgBufPool::Free(rxBuf);
+        if (!txBatch.empty()) {
+            MemoryAccounting::Released(MemoryAccounting::MEM_ENDPOINT_BUFFERS, txBatch.size() * sizeof(Message));
+        }
     }
 
     BusAttachment& bus;                      /**< Message bus associated with this endpoint */
     qcc::Stream* stream;                     /**< Stream for this endpoint or NULL if uninitialized */
 
-    std::deque<Message> txQueue;             /**< Transmit message queue */
-    std::deque<qcc::Thread*> txWaitQueue;    /**< Threads waiting for txQueue to become not-full */
+    Message emptyMsg;                        /**< Occupies unused txQueue and txBatch slots and currentWriteMsg while idle */
+    TxQueue txQueue;                         /**< Transmit message queue */
+    qcc::Event txNotFull;                    /**< Set when txQueue has room (or the endpoint is dying) */
+    qcc::Event txDrained;                    /**< Set when txQueue is empty and no message is being written */
+    size_t maxTxBytes;                       /**< Maximum total size of the messages in txQueue (0 means no limit) */
+    SessionOpts::TxQueuePolicy txPolicy;     /**< What to do when a message is pushed onto a full txQueue */
+    std::map<SessionId, SessionShaping> txSessions; /**< Sessions with a non-default priority or a rate limit */
+    std::vector<Message> txBatch;            /**< Messages taken from txQueue to be sent with vectored writes, allocated on first use */
+    size_t txBatchHead;                      /**< Index in txBatch of the first message not completely written */
+    size_t txBatchCount;                     /**< Number of messages in txBatch */
+    size_t txBatchOffset;                    /**< Number of bytes of the txBatchHead message already written */
+    bool vectoredTx;                         /**< True if the subclass implements PushBytesV() */
+    bool encryptOnPush;                      /**< True if secure messages are encrypted by PushMessage() rather than when written */
+    uint8_t* rxBuf;                          /**< Receive read-ahead buffer, only allocated while it holds data */
+    size_t rxPos;                            /**< Offset in rxBuf of the next byte to be pulled */
+    size_t rxEnd;                            /**< Offset in rxBuf of the end of the data read ahead */
     qcc::Mutex lock;                         /**< Mutex that protects the txQueue and timeout values */
     int32_t exitCount;                       /**< Number of sub-threads (rx and tx) that have exited (atomically incremented) */
 
@@ -109,11 +221,16 @@ class _RemoteEndpoint::Internal {
     int32_t refCount;                        /**< Number of active users of this remote endpoint */
     bool isSocket;                           /**< True iff this endpoint contains a SockStream as its 'stream' member */
     bool armRxPause;                         /**< Pause Rx after receiving next METHOD_REPLY message */
+    bool rxReadAhead;                        /**< Pull through rxBuf, false if the stream already buffers whole messages */
 
     uint32_t idleTimeoutCount;               /**< Number of consecutive idle timeouts */
     uint32_t maxIdleProbes;                  /**< Maximum number of missed idle probes before shutdown */
     uint32_t idleTimeout;                    /**< RX idle seconds before sending probe */
     uint32_t probeTimeout;                   /**< Probe timeout in seconds */
+    LinkMonitor::Link link;                  /**< Link timeout state in the bus's LinkMonitor */
+    uint32_t probeSent;                      /**< Timestamp of the last unanswered ProbeReq or 0 */
+    uint32_t srtt;                           /**< Smoothed ProbeReq round trip time in milliseconds, 0 until measured */
+    uint32_t rttVar;                         /**< Round trip time variation in milliseconds */
 
     String uniqueName;                       /**< Obtained from EndpointAuth */
     String remoteName;                       /**< Obtained from EndpointAuth */
@@ -124,12 +241,41 @@ class _RemoteEndpoint::Internal {
     Message currentReadMsg;                  /**< The message currently being read for this endpoint */
     bool validateSender;                     /**< If true, the sender field on incomming messages will be overwritten with actual endpoint name */
     bool hasRxSessionMsg;                    /**< true iff this endpoint has previously processed a non-control message */
+    uint32_t rxStaged;                       /**< Messages handed to the routing workers and not yet routed (protected by lock) */
+    bool rxPaused;                           /**< True while reading is paused for the routing workers (protected by lock) */
     bool getNextMsg;                         /**< If true, read the next message from the txQueue */
     Message currentWriteMsg;                 /**< The message currently being read for this endpoint */
+    uint32_t currentWriteTtl;                /**< Time-to-live the session of currentWriteMsg gives it on the link */
     bool stopping;                           /**< Is this EP stopping? */
     uint32_t sessionId;                      /**< SessionId for BusToBus endpoint. (not used for non-B2B endpoints) */
+    std::map<uint32_t, uint32_t> sessionRoutes;  /**< Route count of each session carried by a BusToBus endpoint (protected by lock) */
+    EndpointAuth* pendingAuth;               /**< Handshake in progress for EstablishNonBlocking() */
+
+    uint32_t rxMessages;                     /**< Messages received (only written by the rx callback) */
+    uint32_t rxBytes;                        /**< Bytes received (only written by the rx callback) */
+    uint32_t txMessages;                     /**< Messages written (only written by the tx callback) */
+    uint32_t txBytes;                        /**< Bytes written (only written by the tx callback) */
+    uint32_t txQueueHighWater;               /**< Deepest txQueue has been (protected by lock) */
+    uint32_t txDrops;                        /**< Messages dropped from or not added to txQueue (protected by lock) */
+    uint32_t idleTimeouts;                   /**< Idle probes sent (protected by lock) */
+    uint64_t txWriteStart;                   /**< Latency clock time the message(s) being written left txQueue, 0 if not recorded */
+    uint32_t traceName;                      /**< MessageTrace::NameHash() of uniqueName */
+    ValidationCache validationCache;         /**< Values already validated on received messages (only used by the rx side) */
 };
 
+/** Number of authentication handshakes run by remote endpoints (atomically incremented) */
+static volatile int32_t authHandshakes = 0;
+
+/** Number of authentication handshakes that failed (atomically incremented) */
+static volatile int32_t authFailures = 0;
+
+
+void _RemoteEndpoint::SetReadAhead(bool readAhead)
+{
+    if (internal) {
+        internal->rxReadAhead = readAhead;
+    }
+}
 
 void _RemoteEndpoint::SetStream(qcc::Stream* s)
 {
@@ -140,6 +286,46 @@ void _RemoteEndpoint::SetStream(qcc::Stream* s)
 }
 
 
+QStatus _RemoteEndpoint::PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    actualBytes = 0;
+    if (internal->rxPos == internal->rxEnd) {
+        /*
+         * Large reads go straight into the caller's buffer. There is no read-ahead while an Rx
+         * pause is armed because the bytes following the reply may belong to a raw session.
+         */
+        if (internal->armRxPause || !internal->rxReadAhead || (reqBytes >= RX_READAHEAD_SIZE)) {
+            return internal->stream->PullBytes(buf, reqBytes, actualBytes, timeout);
+        }
+        if (!internal->rxBuf) {
+            internal->rxBuf = MsgBufPool::Alloc(RX_READAHEAD_SIZE);
+        }
+        size_t pulled = 0;
+        QStatus status = internal->stream->PullBytes(internal->rxBuf, RX_READAHEAD_SIZE, pulled, timeout);
+        if ((status != ER_OK) || (pulled == 0)) {
+            MsgBufPool::Free(internal->rxBuf);
+            internal->rxBuf = NULL;
+            return status;
+        }
+        internal->rxPos = 0;
+        internal->rxEnd = pulled;
+    }
+    actualBytes = (std::min)(reqBytes, internal->rxEnd - internal->rxPos);
+    memcpy(buf, internal->rxBuf + internal->rxPos, actualBytes);
+    internal->rxPos += actualBytes;
+    if (internal->rxPos == internal->rxEnd) {
+        /* Release the buffer so idle endpoints do not hold on to one */
+        MsgBufPool::Free(internal->rxBuf);
+        internal->rxBuf = NULL;
+        internal->rxPos = 0;
+        internal->rxEnd = 0;
+    }
+    return ER_OK;
+}
+
 const qcc::String& _RemoteEndpoint::GetUniqueName() const
 {
     if (internal) {
@@ -149,6 +335,12 @@ const qcc::String& _RemoteEndpoint::GetUniqueName() const
     }
 }
 
+ValidationCache& _RemoteEndpoint::GetValidationCache()
+{
+    assert(internal);
+    return internal->validationCache;
+}
+
 const qcc::String& _RemoteEndpoint::GetRemoteName() const
 {
     if (internal) {
@@ -227,8 +419,12 @@ QStatus _RemoteEndpoint::Establish(const qcc::String& authMechanisms, qcc::Strin
         EndpointAuth auth(internal->bus, rep, internal->incoming);
 
         status = auth.Establish(authMechanisms, authUsed, redirection, listener);
-        if (status == ER_OK) {
+        IncrementAndFetch(&authHandshakes);
+        if (status != ER_OK) {
+            IncrementAndFetch(&authFailures);
+        } else {
             internal->uniqueName = auth.GetUniqueName();
+            internal->traceName = MessageTrace::NameHash(internal->uniqueName.c_str());
             internal->remoteName = auth.GetRemoteName();
             internal->remoteGUID = auth.GetRemoteGUID();
             internal->features.protocolVersion = auth.GetRemoteProtocolVersion();
@@ -239,10 +435,52 @@ QStatus _RemoteEndpoint::Establish(const qcc::String& authMechanisms, qcc::Strin
     return status;
 }
 
+QStatus _RemoteEndpoint::EstablishNonBlocking(const qcc::String& authMechanisms, qcc::String& authUsed, AuthListener* listener)
+{
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    if (!internal->pendingAuth) {
+        RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+        internal->pendingAuth = new EndpointAuth(internal->bus, rep, internal->incoming);
+    }
+    EndpointAuth* auth = internal->pendingAuth;
+    QStatus status = auth->EstablishNonBlocking(authMechanisms, authUsed, listener);
+    if (status == ER_WOULDBLOCK) {
+        return status;
+    }
+    IncrementAndFetch(&authHandshakes);
+    if (status != ER_OK) {
+        IncrementAndFetch(&authFailures);
+    } else {
+        internal->uniqueName = auth->GetUniqueName();
+        internal->traceName = MessageTrace::NameHash(internal->uniqueName.c_str());
+        internal->remoteName = auth->GetRemoteName();
+        internal->remoteGUID = auth->GetRemoteGUID();
+        internal->features.protocolVersion = auth->GetRemoteProtocolVersion();
+        internal->features.trusted = (authUsed != "ANONYMOUS");
+    }
+    AbortEstablish();
+    return status;
+}
+
+void _RemoteEndpoint::AbortEstablish()
+{
+    if (internal && internal->pendingAuth) {
+        /* Deleting the handshake releases its reference to this endpoint */
+        EndpointAuth* auth = internal->pendingAuth;
+        internal->pendingAuth = NULL;
+        delete auth;
+    }
+}
+
 QStatus _RemoteEndpoint::SetLinkTimeout(uint32_t& idleTimeout)
 {
     if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
         internal->idleTimeout = 0;
+        internal->bus.GetInternal().GetLinkMonitor().Unwatch(internal->link);
+        internal->lock.Unlock(MUTEX_CONTEXT);
     }
     return ER_OK;
 }
@@ -256,7 +494,8 @@ _RemoteEndpoint::_RemoteEndpoint(BusAttachment& bus,
                                  bool isSocket) :
     _BusEndpoint(ENDPOINT_TYPE_REMOTE)
 {
-    internal = new Internal(bus, incoming, connectSpec, stream, threadName, isSocket);
+    internal = new Internal(this, bus, incoming, connectSpec, stream, threadName, isSocket);
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_ENDPOINTS, sizeof(_RemoteEndpoint) + sizeof(Internal));
 }
 
 _RemoteEndpoint::~_RemoteEndpoint()
@@ -264,8 +503,10 @@ _RemoteEndpoint::~_RemoteEndpoint()
     if (internal) {
         Stop();
         Join();
+        internal->bus.GetInternal().GetLinkMonitor().Unwatch(internal->link);
         delete internal;
         internal = NULL;
+        MemoryAccounting::Released(MemoryAccounting::MEM_ENDPOINTS, sizeof(_RemoteEndpoint) + sizeof(Internal));
     }
 }
 QStatus _RemoteEndpoint::UntrustedClientStart() {
@@ -290,10 +531,18 @@ QStatus _RemoteEndpoint::SetLinkTimeout(uint32_t idleTimeout, uint32_t probeTime
         internal->idleTimeout = idleTimeout;
         internal->probeTimeout = probeTimeout;
         internal->maxIdleProbes = maxIdleProbes;
-        IODispatch& iodispatch = internal->bus.GetInternal().GetIODispatch();
-        uint32_t timeout = (internal->idleTimeoutCount == 0) ? internal->idleTimeout : internal->probeTimeout;
-
-        QStatus status = iodispatch.EnableTimeoutCallback(internal->stream, timeout);
+        /*
+         * Received traffic keeps the link alive so there is nothing to do per message, the
+         * LinkMonitor only calls back once the link has actually been quiet for the timeout.
+         */
+        QStatus status = ER_OK;
+        LinkMonitor& monitor = internal->bus.GetInternal().GetLinkMonitor();
+        if (!internal->started || internal->stopping || (idleTimeout == 0)) {
+            monitor.Unwatch(internal->link);
+        } else {
+            uint32_t timeout = (internal->idleTimeoutCount == 0) ? internal->idleTimeout * 1000 : ProbeWait();
+            status = monitor.Watch(internal->link, timeout);
+        }
         internal->lock.Unlock(MUTEX_CONTEXT);
         return status;
     } else {
@@ -311,7 +560,7 @@ QStatus _RemoteEndpoint::Start()
     QStatus status;
     internal->started = true;
     Router& router = internal->bus.GetInternal().GetRouter();
-    IODispatch& iodispatch = internal->bus.GetInternal().GetIODispatch();
+    IODispatch& iodispatch = internal->bus.GetInternal().GetIODispatch(internal->stream);
 
     if (internal->features.isBusToBus) {
         endpointType = ENDPOINT_TYPE_BUS2BUS;
@@ -364,7 +613,7 @@ QStatus _RemoteEndpoint::Stop(void)
      * its ultimate demise.
      */
     if (internal->started) {
-        ret = internal->bus.GetInternal().GetIODispatch().StopStream(internal->stream);
+        ret = internal->bus.GetInternal().GetIODispatch(internal->stream).StopStream(internal->stream);
 
     }
     internal->stopping = true;
@@ -376,27 +625,33 @@ QStatus _RemoteEndpoint::Stop(void)
 
 QStatus _RemoteEndpoint::StopAfterTxEmpty(uint32_t maxWaitMs)
 {
-    QStatus status;
     /* Init wait time */
-    uint32_t startTime = maxWaitMs ? GetTimestamp() : 0;
+    uint32_t startTime = GetTimestamp();
 
     /* Ensure the endpoint is valid */
     if (!internal) {
         return ER_BUS_NO_ENDPOINT;
     }
 
-    /* Wait for txqueue to empty before triggering stop */
-    internal->lock.Lock(MUTEX_CONTEXT);
+    /* Wait for txqueue to drain before triggering stop */
     while (true) {
-        if (internal->txQueue.empty() || (maxWaitMs && (qcc::GetTimestamp() > (startTime + maxWaitMs)))) {
-            status = Stop();
-            break;
+        uint32_t waitMs = Event::WAIT_FOREVER;
+        if (maxWaitMs) {
+            uint32_t elapsed = GetTimestamp() - startTime;
+            if (elapsed >= maxWaitMs) {
+                break;
+            }
+            waitMs = maxWaitMs - elapsed;
+        }
+        QStatus status = Event::Wait(internal->txDrained, waitMs);
+        if (status == ER_ALERTED_THREAD) {
+            Thread::GetThread()->GetStopEvent().ResetEvent();
         } else {
-            internal->lock.Unlock(MUTEX_CONTEXT);
-            qcc::Sleep(5);
-            internal->lock.Lock(MUTEX_CONTEXT);
+            break;
         }
     }
+    internal->lock.Lock(MUTEX_CONTEXT);
+    QStatus status = Stop();
     internal->lock.Unlock(MUTEX_CONTEXT);
     return status;
 }
@@ -431,15 +686,7 @@ QStatus _RemoteEndpoint::Join(void)
 
 void _RemoteEndpoint::ThreadExit(Thread* thread)
 {
-    /* This is notification of a txQueue waiter has died. Remove him */
-    internal->lock.Lock(MUTEX_CONTEXT);
-    deque<Thread*>::iterator it = find(internal->txWaitQueue.begin(), internal->txWaitQueue.end(), thread);
-    if (it != internal->txWaitQueue.end()) {
-        (*it)->RemoveAuxListener(this);
-        internal->txWaitQueue.erase(it);
-    }
-    internal->lock.Unlock(MUTEX_CONTEXT);
-
+    /* Threads blocked on a full txQueue wait on an event so there is no per-thread state to clean up */
     return;
 }
 
@@ -453,18 +700,119 @@ static inline bool IsControlMessage(Message& msg)
     return (::strcmp(sender + offset, ".1") == 0) ? true : false;
 }
 
+QStatus _RemoteEndpoint::StageMessage(Message& msg, bool batched, bool& paused)
+{
+    RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+    internal->lock.Lock(MUTEX_CONTEXT);
+    ++internal->rxStaged;
+    internal->lock.Unlock(MUTEX_CONTEXT);
+
+    QStatus status = internal->bus.GetInternal().GetRoutingPool().Push(msg, rep, batched);
+
+    internal->lock.Lock(MUTEX_CONTEXT);
+    if (status != ER_OK) {
+        --internal->rxStaged;
+    } else if (internal->rxStaged >= MAX_RX_STAGED) {
+        /* The routing worker resumes reading once it has caught up, see RouteStaged() */
+        internal->rxPaused = true;
+        internal->bus.GetInternal().GetIODispatch(internal->stream).DisableReadCallback(internal->stream);
+        paused = true;
+    }
+    internal->lock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+void _RemoteEndpoint::RouteStaged(Message& msg, bool batched)
+{
+    QStatus status = RouteMessage(msg, batched);
+    if (status != ER_OK) {
+        /* Same as a receive failure in ReadCallback() */
+        if ((status != ER_BUS_STOPPING) && !internal->stopping) {
+            QCC_LogError(status, ("Endpoint Rx failed (%s)", GetUniqueName().c_str()));
+        }
+        if (disconnectStatus == ER_OK) {
+            disconnectStatus = status;
+        }
+        Stop();
+    }
+
+    internal->lock.Lock(MUTEX_CONTEXT);
+    --internal->rxStaged;
+    if (internal->rxPaused && (internal->rxStaged <= (MAX_RX_STAGED / 2))) {
+        internal->rxPaused = false;
+        if (!internal->stopping) {
+            internal->bus.GetInternal().GetIODispatch(internal->stream).EnableReadCallback(internal->stream, 0);
+        }
+    }
+    internal->lock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus _RemoteEndpoint::RouteMessage(Message& msg, bool batched)
+{
+    const bool bus2bus = ENDPOINT_TYPE_BUS2BUS == GetEndpointType();
+    Router& router = internal->bus.GetInternal().GetRouter();
+    RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+    BusEndpoint bep = BusEndpoint::cast(rep);
+
+    QStatus status = router.PushMessage(msg, bep);
+    if (batched) {
+        /* Signals that arrived in a batch are never retried and never fail the endpoint */
+        if (status != ER_OK) {
+            QCC_DbgHLPrintf(("Discarding %s: %s", msg->Description().c_str(), QCC_StatusText(status)));
+        }
+        internal->hasRxSessionMsg = true;
+        return ER_OK;
+    }
+    if (status != ER_OK) {
+        /*
+         * There are five cases where a failure to push a message to the router is ok:
+         *
+         * 1) The message received did not match the expected signature.
+         * 2) The message was a method reply that did not match up to a method call.
+         * 3) A daemon is pushing the message to a connected client or service.
+         * 4) Pushing a message to an endpoint that has closed.
+         * 5) Pushing the first non-control message of a new session (must wait for route to be fully setup)
+         *
+         */
+
+        if (status == ER_BUS_NO_ROUTE) {
+
+            int retries = 20;
+            while (!internal->stopping && (status == ER_BUS_NO_ROUTE) && !internal->hasRxSessionMsg && retries--) {
+                qcc::Sleep(10);
+                status = router.PushMessage(msg, bep);
+            }
+        }
+        if ((router.IsDaemon() && !bus2bus) || (status == ER_BUS_SIGNATURE_MISMATCH) || (status == ER_BUS_UNMATCHED_REPLY_SERIAL) || (status == ER_BUS_ENDPOINT_CLOSING)) {
+            QCC_DbgHLPrintf(("Discarding %s: %s", msg->Description().c_str(), QCC_StatusText(status)));
+            status = ER_OK;
+        }
+    }
+    MessageTrace::Record(MessageTrace::TRACE_ROUTED, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+    if (msg->rxTimestamp) {
+        LatencyStats::Record(LatencyStats::STAGE_ROUTE, bus2bus, msg->rxTimestamp, GetLatencyClock());
+    }
+    /* Update haxRxSessionMessage */
+    if ((status == ER_OK) && !internal->hasRxSessionMsg && !IsControlMessage(msg)) {
+        internal->hasRxSessionMsg = true;
+    }
+    return status;
+}
+
 void _RemoteEndpoint::ExitCallback() {
     /* Ensure the endpoint is valid */
     if (!internal) {
         return;
     }
-    /* Alert any threads that are on the wait queue */
+    /* Wake up any threads that are waiting for room in the txQueue or for it to drain */
     internal->lock.Lock(MUTEX_CONTEXT);
-    deque<Thread*>::iterator it = internal->txWaitQueue.begin();
-    while (it != internal->txWaitQueue.end()) {
-        (*it++)->Alert(ENDPOINT_IS_DEAD_ALERTCODE);
-    }
-
+    internal->stopping = true;
+    /* Must be unwatched before the router lets go of the endpoint */
+    internal->bus.GetInternal().GetLinkMonitor().Unwatch(internal->link);
+    internal->txQueue.Clear();
+    ClearTxBatch();
+    internal->txNotFull.SetEvent();
+    internal->txDrained.SetEvent();
     internal->lock.Unlock(MUTEX_CONTEXT);
     RemoteEndpoint rep = RemoteEndpoint::wrap(this);
     /* Un-register this remote endpoint from the router */
@@ -504,12 +852,16 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
     if (!internal) {
         return ER_BUS_NO_ENDPOINT;
     }
+    internal->bus.GetInternal().GetIODispatchPool().BindCallbackThread(internal->stream);
 
     QStatus status;
 
     const bool bus2bus = ENDPOINT_TYPE_BUS2BUS == GetEndpointType();
     Router& router = internal->bus.GetInternal().GetRouter();
     RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+    /* Messages are handed to the routing workers except around a pause for an endpoint handoff */
+    const bool stage = internal->bus.GetInternal().GetRoutingPool().IsEnabled() && !internal->armRxPause;
+    bool paused = false;
     if (!isTimedOut) {
         status = ER_OK;
         while (status == ER_OK) {
@@ -522,11 +874,43 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
 
                 switch (status) {
                 case ER_OK:
-                    internal->idleTimeoutCount = 0;
+                    ++internal->rxMessages;
+                    internal->rxBytes += static_cast<uint32_t>(TxQueue::MessageBytes(msg));
+                    internal->link.Alive();
+                    if (internal->idleTimeoutCount) {
+                        /* The link was being probed, anything received means it is back to the idle timeout */
+                        internal->lock.Lock(MUTEX_CONTEXT);
+                        internal->idleTimeoutCount = 0;
+                        if (!internal->stopping && internal->idleTimeout) {
+                            internal->bus.GetInternal().GetLinkMonitor().Watch(internal->link, internal->idleTimeout * 1000);
+                        }
+                        internal->lock.Unlock(MUTEX_CONTEXT);
+                    }
+                    if (LatencyStats::IsEnabled()) {
+                        msg->rxTimestamp = GetLatencyClock();
+                    }
+                    MessageTrace::Record(MessageTrace::TRACE_RX, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+                    MessageCapture::Record(msg, internal->traceName);
                     bool isAck;
                     if (IsProbeMsg(msg, isAck)) {
                         QCC_DbgPrintf(("%s: Received %s\n", GetUniqueName().c_str(), isAck ? "ProbeAck" : "ProbeReq"));
-                        if (!isAck) {
+                        if (isAck) {
+                            /* Jacobson/Karels round trip estimate used to adapt the probe timeout */
+                            internal->lock.Lock(MUTEX_CONTEXT);
+                            if (internal->probeSent) {
+                                uint32_t rtt = GetTimestamp() - internal->probeSent;
+                                if (internal->srtt == 0) {
+                                    internal->srtt = (std::max)(rtt, (uint32_t)1);
+                                    internal->rttVar = rtt / 2;
+                                } else {
+                                    uint32_t delta = (rtt > internal->srtt) ? (rtt - internal->srtt) : (internal->srtt - rtt);
+                                    internal->rttVar = (3 * internal->rttVar + delta) / 4;
+                                    internal->srtt = (std::max)((7 * internal->srtt + rtt) / 8, (uint32_t)1);
+                                }
+                                internal->probeSent = 0;
+                            }
+                            internal->lock.Unlock(MUTEX_CONTEXT);
+                        } else {
                             /* Respond to probe request */
                             Message probeMsg(internal->bus);
                             status = GenProbeMsg(true, probeMsg);
@@ -535,39 +919,24 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                             }
                             QCC_DbgPrintf(("%s: Sent ProbeAck (%s)\n", GetUniqueName().c_str(), QCC_StatusText(status)));
                         }
-                    } else {
-                        BusEndpoint bep  = BusEndpoint::cast(rep);
-
-                        status = router.PushMessage(msg, bep);
+                    } else if (GetFeatures().signalBatching && SignalBatcher::IsBatch(msg)) {
+                        /* Each signal in a batch is handled as though it had arrived on its own */
+                        vector<Message> signals;
+                        status = SignalBatcher::Unpack(msg, rep, (internal->validateSender && !bus2bus), signals);
                         if (status != ER_OK) {
-                            /*
-                             * There are five cases where a failure to push a message to the router is ok:
-                             *
-                             * 1) The message received did not match the expected signature.
-                             * 2) The message was a method reply that did not match up to a method call.
-                             * 3) A daemon is pushing the message to a connected client or service.
-                             * 4) Pushing a message to an endpoint that has closed.
-                             * 5) Pushing the first non-control message of a new session (must wait for route to be fully setup)
-                             *
-                             */
-
-                            if (status == ER_BUS_NO_ROUTE) {
-
-                                int retries = 20;
-                                while (!internal->stopping && (status == ER_BUS_NO_ROUTE) && !internal->hasRxSessionMsg && retries--) {
-                                    qcc::Sleep(10);
-                                    status = router.PushMessage(msg, bep);
-                                }
-                            }
-                            if ((router.IsDaemon() && !bus2bus) || (status == ER_BUS_SIGNATURE_MISMATCH) || (status == ER_BUS_UNMATCHED_REPLY_SERIAL) || (status == ER_BUS_ENDPOINT_CLOSING)) {
-                                QCC_DbgHLPrintf(("Discarding %s: %s", msg->Description().c_str(), QCC_StatusText(status)));
-                                status = ER_OK;
-                            }
+                            QCC_LogErrorRateLimited(status, ("Discarding malformed signal batch %s", msg->Description().c_str()));
+                            status = ER_OK;
                         }
-                        /* Update haxRxSessionMessage */
-                        if ((status == ER_OK) && !internal->hasRxSessionMsg && !IsControlMessage(msg)) {
-                            internal->hasRxSessionMsg = true;
+                        for (size_t i = 0; (status == ER_OK) && (i < signals.size()); ++i) {
+                            status = stage ? StageMessage(signals[i], true, paused) : RouteMessage(signals[i], true);
                         }
+                    } else {
+                        status = stage ? StageMessage(msg, false, paused) : RouteMessage(msg, false);
+                    }
+                    if ((status == ER_OK) && paused) {
+                        /* Reading is paused until the routing workers catch up */
+                        internal->currentReadMsg = Message(internal->bus);
+                        return ER_OK;
                     }
                     break;
 
@@ -578,7 +947,7 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                      */
                     status = internal->bus.GetInternal().GetLocalEndpoint()->GetPeerObj()->RequestHeaderExpansion(msg, rep);
                     if ((status != ER_OK) && router.IsDaemon()) {
-                        QCC_LogError(status, ("Discarding %s", msg->Description().c_str()));
+                        QCC_LogErrorRateLimited(status, ("Discarding %s", msg->Description().c_str()));
                         status = ER_OK;
                     }
                     break;
@@ -602,7 +971,7 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                         QCC_DbgHLPrintf(("Invalid serial discarding %s", msg->Description().c_str()));
                         status = ER_OK;
                     } else {
-                        QCC_LogError(status, ("Invalid serial %s", msg->Description().c_str()));
+                        QCC_LogErrorRateLimited(status, ("Invalid serial %s", msg->Description().c_str()));
                     }
                     break;
 
@@ -617,7 +986,7 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                 /* Check pause condition. Block until stopped */
                 if (internal->armRxPause && internal->started && (msg->GetType() == MESSAGE_METHOD_RET)) {
                     status = ER_BUS_ENDPOINT_CLOSING;
-                    internal->bus.GetInternal().GetIODispatch().DisableReadCallback(internal->stream);
+                    internal->bus.GetInternal().GetIODispatch(internal->stream).DisableReadCallback(internal->stream);
                     return ER_OK;
                 }
                 if (status == ER_OK) {
@@ -626,9 +995,7 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
             }
         }
         if (status == ER_TIMEOUT) {
-            internal->lock.Lock(MUTEX_CONTEXT);
-            internal->bus.GetInternal().GetIODispatch().EnableReadCallback(internal->stream, internal->idleTimeout);
-            internal->lock.Unlock(MUTEX_CONTEXT);
+            internal->bus.GetInternal().GetIODispatch(internal->stream).EnableReadCallback(internal->stream, 0);
         } else {
 
             if ((status != ER_STOPPING_THREAD) && (status != ER_SOCK_OTHER_END_CLOSED) && (status != ER_BUS_STOPPING)) {
@@ -640,38 +1007,74 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
             }
             Invalidate();
             internal->stopping = true;
-            internal->bus.GetInternal().GetIODispatch().StopStream(internal->stream);
+            internal->bus.GetInternal().GetIODispatch(internal->stream).StopStream(internal->stream);
         }
     } else {
-        /* This is a timeout alarm, try to send a probe message if maximum idle
-         * probe attempts has not been reached.
-         */
-        if (internal->idleTimeoutCount++ < internal->maxIdleProbes) {
-            Message probeMsg(internal->bus);
-            status = GenProbeMsg(false, probeMsg);
-            if (status == ER_OK) {
-                PushMessage(probeMsg);
-            }
-            QCC_DbgPrintf(("%s: Sent ProbeReq (%s)\n", GetUniqueName().c_str(), QCC_StatusText(status)));
-            internal->lock.Lock(MUTEX_CONTEXT);
-            uint32_t timeout = (internal->idleTimeoutCount == 0) ? internal->idleTimeout : internal->probeTimeout;
-            internal->bus.GetInternal().GetIODispatch().EnableReadCallback(internal->stream, timeout);
-            internal->lock.Unlock(MUTEX_CONTEXT);
-        } else {
-            QCC_DbgPrintf(("%s: Maximum number of idle probe (%d) attempts reached", GetUniqueName().c_str(), internal->maxIdleProbes));
-            /* On an unexpected disconnect save the status that cause the thread exit */
-            if (disconnectStatus == ER_OK) {
-                disconnectStatus = ER_TIMEOUT;
-            }
+        /* Link timeouts are kept by the LinkMonitor so read timeouts are not expected */
+        LinkIdle();
+        status = ER_OK;
+    }
+    return status;
+}
 
-            QCC_LogError(ER_TIMEOUT, ("Endpoint Rx timed out (%s)", GetUniqueName().c_str()));
-            status = ER_BUS_ENDPOINT_CLOSING;
-            Invalidate();
-            internal->stopping = true;
-            internal->bus.GetInternal().GetIODispatch().StopStream(internal->stream);
+uint32_t _RemoteEndpoint::ProbeWait() const
+{
+    /*
+     * Until a probe has been answered the configured timeout is all we have. After that wait
+     * for a retransmission timeout computed from the measured round trip time, which detects a
+     * dead link much sooner on a fast link but never waits longer than configured.
+     */
+    uint32_t configured = internal->probeTimeout * 1000;
+    if (internal->srtt == 0) {
+        return configured;
+    }
+    uint32_t rto = (std::max)(internal->srtt + 4 * internal->rttVar, MIN_PROBE_WAIT);
+    return (std::min)(rto, configured);
+}
+
+void _RemoteEndpoint::LinkIdle()
+{
+    if (!internal) {
+        return;
+    }
+    internal->lock.Lock(MUTEX_CONTEXT);
+    if (internal->stopping || !internal->idleTimeout) {
+        internal->lock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
+    /*
+     * Try to send a probe message if maximum idle probe attempts has not been reached.
+     */
+    ++internal->idleTimeouts;
+    bool probe = internal->idleTimeoutCount++ < internal->maxIdleProbes;
+    if (probe) {
+        internal->probeSent = GetTimestamp();
+        QStatus status = internal->bus.GetInternal().GetLinkMonitor().Watch(internal->link, ProbeWait());
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to schedule probe timeout for %s", GetUniqueName().c_str()));
         }
     }
-    return status;
+    internal->lock.Unlock(MUTEX_CONTEXT);
+
+    if (probe) {
+        Message probeMsg(internal->bus);
+        QStatus status = GenProbeMsg(false, probeMsg);
+        if (status == ER_OK) {
+            status = PushMessage(probeMsg);
+        }
+        QCC_DbgPrintf(("%s: Sent ProbeReq (%s)\n", GetUniqueName().c_str(), QCC_StatusText(status)));
+    } else {
+        QCC_DbgPrintf(("%s: Maximum number of idle probe (%d) attempts reached", GetUniqueName().c_str(), internal->maxIdleProbes));
+        /* On an unexpected disconnect save the status that cause the thread exit */
+        if (disconnectStatus == ER_OK) {
+            disconnectStatus = ER_TIMEOUT;
+        }
+
+        QCC_LogError(ER_TIMEOUT, ("Endpoint Rx timed out (%s)", GetUniqueName().c_str()));
+        Invalidate();
+        internal->stopping = true;
+        internal->bus.GetInternal().GetIODispatch(internal->stream).StopStream(internal->stream);
+    }
 }
 /* Note: isTimedOut indicates that this is a timeout alarm. This is for future
  * use if SendTimeout functionality is required.
@@ -685,38 +1088,93 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
     if (!internal) {
         return ER_BUS_NO_ENDPOINT;
     }
+    internal->bus.GetInternal().GetIODispatchPool().BindCallbackThread(internal->stream);
 
+    const bool bus2bus = ENDPOINT_TYPE_BUS2BUS == GetEndpointType();
     QStatus status = ER_OK;
     while (status == ER_OK) {
         if (internal->getNextMsg) {
             internal->lock.Lock(MUTEX_CONTEXT);
-            if (!internal->txQueue.empty()) {
-                /* Make a deep copy of the message since there is state information inside the message.
-                 * Each copy of the message could be in different write state.
+            /* Don't send messages whose time-to-live ran out while they were queued */
+            if (internal->txQueue.HasExpirable()) {
+                uint32_t nextExpireMs = (numeric_limits<uint32_t>::max)();
+                size_t expired = internal->txQueue.RemoveExpired(nextExpireMs);
+                if (expired > 0) {
+                    internal->txDrops += static_cast<uint32_t>(expired);
+                    internal->txNotFull.SetEvent();
+                }
+            }
+            if (!internal->txQueue.Empty()) {
+                /* Wake up threads waiting for room in the queue */
+                if (internal->txQueue.Full() || internal->maxTxBytes || !internal->txSessions.empty()) {
+                    internal->txNotFull.SetEvent();
+                }
+                /*
+                 * If several messages at the front of the queue can be written as-is they are
+                 * moved to the batch and sent with vectored writes.
                  */
-                internal->currentWriteMsg = Message(internal->txQueue.back(), true);
-
-                /* Alert next thread on wait queue */
-                if (0 < internal->txWaitQueue.size()) {
-                    Thread* wakeMe = internal->txWaitQueue.back();
-                    internal->txWaitQueue.pop_back();
-                    status = wakeMe->Alert();
-                    if (ER_OK != status) {
-                        QCC_LogError(status, ("Failed to alert thread blocked on full tx queue"));
+                size_t batchable = 0;
+                if (internal->vectoredTx) {
+                    while ((batchable < internal->txQueue.Size()) && (batchable < MAX_TX_BATCH) && IsBatchable(internal->txQueue.At(batchable))) {
+                        ++batchable;
                     }
                 }
+                internal->txWriteStart = 0;
+                if (LatencyStats::IsEnabled()) {
+                    internal->txWriteStart = GetLatencyClock();
+                    for (size_t i = 0; i < (std::max)(batchable, (size_t)1); ++i) {
+                        LatencyStats::Record(LatencyStats::STAGE_QUEUE, bus2bus, internal->txQueue.QueuedAt(i), internal->txWriteStart);
+                    }
+                }
+                if (batchable > 1) {
+                    if (internal->txBatch.empty()) {
+                        internal->txBatch.resize(MAX_TX_BATCH, internal->emptyMsg);
+                        MemoryAccounting::Allocated(MemoryAccounting::MEM_ENDPOINT_BUFFERS, MAX_TX_BATCH * sizeof(Message));
+                    }
+                    for (size_t i = 0; i < batchable; ++i) {
+                        internal->txBatch[i] = internal->txQueue.Front();
+                        internal->txQueue.Pop();
+                    }
+                    internal->txBatchHead = 0;
+                    internal->txBatchCount = batchable;
+                    internal->txBatchOffset = 0;
+                } else {
+                    /* Make a copy of the message since there is state information inside the message.
+                     * Each copy of the message could be in different write state. The copy shares the
+                     * marshaled message buffer so this costs O(header) rather than O(message).
+                     */
+                    internal->currentWriteMsg = Message(internal->txQueue.Front(), true);
+                    internal->currentWriteTtl = GetSessionMessageTtl(internal->currentWriteMsg, internal->txSessions);
+                    internal->txQueue.Pop();
+                }
                 internal->getNextMsg = false;
                 internal->lock.Unlock(MUTEX_CONTEXT);
             } else {
-
-                internal->bus.GetInternal().GetIODispatch().DisableWriteCallback(internal->stream);
+                internal->txDrained.SetEvent();
+                internal->bus.GetInternal().GetIODispatch(internal->stream).DisableWriteCallback(internal->stream);
                 internal->lock.Unlock(MUTEX_CONTEXT);
                 return ER_OK;
             }
         }
-        /* Deliver message */
-        RemoteEndpoint rep = RemoteEndpoint::wrap(this);
-        status = internal->currentWriteMsg->DeliverNonBlocking(rep);
+        const bool batched = (internal->txBatchCount != 0);
+        if (batched) {
+            status = WriteTxBatch(bus2bus);
+        } else {
+            /* Deliver message */
+            RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+            status = internal->currentWriteMsg->DeliverNonBlocking(rep, internal->currentWriteTtl);
+            if (status == ER_OK) {
+                ++internal->txMessages;
+                internal->txBytes += static_cast<uint32_t>(TxQueue::MessageBytes(internal->currentWriteMsg));
+                const Message& msg = internal->currentWriteMsg;
+                MessageTrace::Record(MessageTrace::TRACE_TX, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+                if (internal->txWriteStart) {
+                    uint64_t now = GetLatencyClock();
+                    LatencyStats::Record(LatencyStats::STAGE_WRITE, bus2bus, internal->txWriteStart, now);
+                    LatencyStats::Record(LatencyStats::STAGE_TOTAL, bus2bus, internal->currentWriteMsg->rxTimestamp, now);
+                }
+            }
+        }
         /* Report authorization failure as a security violation */
         if (status == ER_BUS_NOT_AUTHORIZED) {
             internal->bus.GetInternal().GetLocalEndpoint()->GetPeerObj()->HandleSecurityViolation(internal->currentWriteMsg, status);
@@ -730,7 +1188,6 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
             /* Message has been successfully delivered. i.e. PushBytes is complete
              */
             internal->lock.Lock(MUTEX_CONTEXT);
-            internal->txQueue.pop_back();
             internal->getNextMsg = true;
             internal->lock.Unlock(MUTEX_CONTEXT);
         }
@@ -739,7 +1196,7 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
     if (status == ER_TIMEOUT) {
         /* Timed-out in the middle of a message write. */
         internal->lock.Lock(MUTEX_CONTEXT);
-        internal->bus.GetInternal().GetIODispatch().EnableWriteCallback(internal->stream);
+        internal->bus.GetInternal().GetIODispatch(internal->stream).EnableWriteCallback(internal->stream);
         internal->lock.Unlock(MUTEX_CONTEXT);
     } else if (status != ER_OK) {
         /* On an unexpected disconnect save the status that cause the thread exit */
@@ -752,16 +1209,189 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
 
         Invalidate();
         internal->stopping = true;
-        internal->bus.GetInternal().GetIODispatch().StopStream(internal->stream);
+        internal->bus.GetInternal().GetIODispatch(internal->stream).StopStream(internal->stream);
+    }
+    return status;
+}
+
+bool _RemoteEndpoint::IsBatchable(const Message& msg) const
+{
+    /*
+     * Messages that need encryption or compression, carry handles or have a time-to-live need the
+     * per-message processing in DeliverNonBlocking().
+     */
+    if (GetFeatures().bodyCompression && msg->IsBodyCompressible()) {
+        return false;
+    }
+    if (GetSessionMessageTtl(msg, internal->txSessions)) {
+        return false;
+    }
+    return (msg->bufEOD > reinterpret_cast<uint8_t*>(msg->msgBuf)) && !msg->encrypt && !msg->handles && !msg->ttl;
+}
+
+QStatus _RemoteEndpoint::WriteTxBatch(bool bus2bus)
+{
+    QStatus status = ER_OK;
+    while ((status == ER_OK) && (internal->txBatchHead < internal->txBatchCount)) {
+        qcc::IOVec iov[MAX_TX_BATCH];
+        size_t numIov = 0;
+        for (size_t i = internal->txBatchHead; i < internal->txBatchCount; ++i) {
+            Message& msg = internal->txBatch[i];
+            uint8_t* buf = reinterpret_cast<uint8_t*>(msg->msgBuf);
+            size_t len = msg->bufEOD - buf;
+            if (i == internal->txBatchHead) {
+                buf += internal->txBatchOffset;
+                len -= internal->txBatchOffset;
+            }
+            iov[numIov].buf = buf;
+            iov[numIov].len = len;
+            ++numIov;
+        }
+        size_t sent = 0;
+        status = PushBytesV(iov, numIov, sent);
+        if (status == ER_WOULDBLOCK) {
+            /* Same as a timed out PushBytes() the write callback will be re-enabled */
+            status = ER_TIMEOUT;
+        }
+        if (status == ER_OK) {
+            /* Retire the messages that have been completely written */
+            while (sent && (internal->txBatchHead < internal->txBatchCount)) {
+                Message& msg = internal->txBatch[internal->txBatchHead];
+                size_t remaining = (msg->bufEOD - reinterpret_cast<uint8_t*>(msg->msgBuf)) - internal->txBatchOffset;
+                if (sent >= remaining) {
+                    QCC_DbgHLPrintf(("Deliver message %s to %s", msg->Description().c_str(), GetUniqueName().c_str()));
+                    ++internal->txMessages;
+                    internal->txBytes += static_cast<uint32_t>(TxQueue::MessageBytes(msg));
+                    MessageTrace::Record(MessageTrace::TRACE_TX, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+                    if (internal->txWriteStart) {
+                        uint64_t now = GetLatencyClock();
+                        LatencyStats::Record(LatencyStats::STAGE_WRITE, bus2bus, internal->txWriteStart, now);
+                        LatencyStats::Record(LatencyStats::STAGE_TOTAL, bus2bus, msg->rxTimestamp, now);
+                    }
+                    sent -= remaining;
+                    msg = internal->emptyMsg;
+                    ++internal->txBatchHead;
+                    internal->txBatchOffset = 0;
+                } else {
+                    internal->txBatchOffset += sent;
+                    sent = 0;
+                }
+            }
+        }
+    }
+    if (internal->txBatchHead == internal->txBatchCount) {
+        internal->txBatchHead = 0;
+        internal->txBatchCount = 0;
     }
     return status;
 }
 
+void _RemoteEndpoint::ClearTxBatch()
+{
+    for (size_t i = internal->txBatchHead; i < internal->txBatchCount; ++i) {
+        internal->txBatch[i] = internal->emptyMsg;
+    }
+    internal->txBatchHead = 0;
+    internal->txBatchCount = 0;
+    internal->txBatchOffset = 0;
+}
+
+void _RemoteEndpoint::SetVectoredTx(bool enable)
+{
+    if (internal) {
+        internal->vectoredTx = enable;
+    }
+}
+
+void _RemoteEndpoint::SetEncryptOnPush(bool enable)
+{
+    if (internal) {
+        internal->encryptOnPush = enable;
+    }
+}
+
 QStatus _RemoteEndpoint::PushMessage(Message& msg)
 {
     QCC_DbgTrace(("RemoteEndpoint::PushMessage %s (serial=%d)", GetUniqueName().c_str(), msg->GetCallSerial()));
-    static const size_t MAX_TX_QUEUE_SIZE = 30;
 
+    if (!internal || !internal->encryptOnPush || !msg->encrypt) {
+        return QueueMessage(msg);
+    }
+    /*
+     * Encrypt on the pushing thread so the AES work is spread over the threads sending secure
+     * messages instead of being done by the I/O thread that writes for this and other endpoints.
+     * The caller's message is left unencrypted, the copy shares its buffer until it is encrypted.
+     */
+    Message encrypted(msg, true);
+    QStatus status = encrypted->EncryptMessage();
+    if (status == ER_BUS_AUTHENTICATION_PENDING) {
+        /* The message is pushed again when the authentication completes */
+        return ER_OK;
+    }
+    if (status != ER_OK) {
+        QCC_LogErrorRateLimited(status, ("Failed to encrypt message %s", msg->Description().c_str()));
+        return status;
+    }
+    return QueueMessage(encrypted);
+}
+
+/*
+ * Link timeout probes and the name exchange that opens a bus-to-bus link are sent ahead of
+ * everything else so they are never stuck behind application traffic. Other daemon signals keep
+ * their place, e.g. DetachSession must not overtake the session's last messages.
+ */
+static TxQueue::Priority GetTxPriority(const Message& msg, const map<SessionId, SessionShaping>& txSessions)
+{
+    if ((msg->GetType() == MESSAGE_SIGNAL) && (::strcmp(org::alljoyn::Daemon::InterfaceName, msg->GetInterface()) == 0)) {
+        const char* member = msg->GetMemberName();
+        if ((::strcmp(member, "ProbeReq") == 0) || (::strcmp(member, "ProbeAck") == 0) || (::strcmp(member, "ExchangeNames") == 0)) {
+            return TxQueue::PRIORITY_CONTROL;
+        }
+    }
+    if (!txSessions.empty()) {
+        map<SessionId, SessionShaping>::const_iterator it = txSessions.find(msg->GetSessionId());
+        if ((it != txSessions.end()) && (it->second.priority == SessionOpts::TXPRIORITY_BULK)) {
+            return TxQueue::PRIORITY_BULK;
+        }
+    }
+    return TxQueue::PRIORITY_INTERACTIVE;
+}
+
+static inline bool IsRateLimited(const Message& msg, const map<SessionId, SessionShaping>& txSessions)
+{
+    if (txSessions.empty()) {
+        return false;
+    }
+    map<SessionId, SessionShaping>::const_iterator it = txSessions.find(msg->GetSessionId());
+    return (it != txSessions.end()) && (it->second.rateLimit != 0);
+}
+
+/*
+ * Charge a message to its session's rate limit. Returns how many ms the sender must wait before
+ * queueing it to pay off the session's debt.
+ */
+static uint32_t ChargeSessionRate(const Message& msg, size_t msgBytes, map<SessionId, SessionShaping>& txSessions)
+{
+    if (txSessions.empty()) {
+        return 0;
+    }
+    map<SessionId, SessionShaping>::iterator it = txSessions.find(msg->GetSessionId());
+    if ((it == txSessions.end()) || (it->second.rateLimit == 0)) {
+        return 0;
+    }
+    SessionShaping& shaping = it->second;
+    uint32_t now = GetTimestamp();
+    int64_t limit = shaping.rateLimit;
+    /* The bucket is full after a second so there is no point counting further */
+    int64_t elapsed = (std::min)(now - shaping.lastCredit, (uint32_t)1000);
+    shaping.credit = (std::min)(limit, shaping.credit + (limit * elapsed) / 1000);
+    shaping.lastCredit = now;
+    shaping.credit -= static_cast<int64_t>(msgBytes);
+    return (shaping.credit < 0) ? static_cast<uint32_t>((-shaping.credit * 1000) / limit) : 0;
+}
+
+QStatus _RemoteEndpoint::QueueMessage(Message& msg)
+{
     QStatus status = ER_OK;
 
     /* Remote endpoints can be invalid if they were created with the default
@@ -779,70 +1409,91 @@ QStatus _RemoteEndpoint::PushMessage(Message& msg)
     if (internal->stopping) {
         return ER_BUS_ENDPOINT_CLOSING;
     }
+    size_t msgBytes = TxQueue::MessageBytes(msg);
     internal->lock.Lock(MUTEX_CONTEXT);
-    size_t count = internal->txQueue.size();
-    bool wasEmpty = (count == 0);
-    if (MAX_TX_QUEUE_SIZE > count) {
-        internal->txQueue.push_front(msg);
-    } else {
-        while (true) {
-            /* Remove a queue entry whose TTLs is expired if possible */
-            deque<Message>::iterator it = internal->txQueue.begin();
-            uint32_t maxWait = 20 * 1000;
-            while (it != internal->txQueue.end()) {
-                uint32_t expMs;
-                if ((*it)->IsExpired(&expMs)) {
-                    internal->txQueue.erase(it);
-                    break;
-                } else {
-                    ++it;
-                }
-                maxWait = (std::min)(maxWait, expMs);
-            }
-            if (internal->txQueue.size() < MAX_TX_QUEUE_SIZE) {
-                /* Check queue wasn't drained while we were waiting */
-                if (internal->txQueue.size() == 0) {
-                    wasEmpty = true;
-                }
-                internal->txQueue.push_front(msg);
-                status = ER_OK;
-                break;
-            } else {
-                /* This thread will have to wait for room in the queue */
-                Thread* thread = Thread::GetThread();
-                assert(thread);
-
-                thread->AddAuxListener(this);
-                internal->txWaitQueue.push_front(thread);
-                internal->lock.Unlock(MUTEX_CONTEXT);
-                status = Event::Wait(Event::neverSet, maxWait);
-                internal->lock.Lock(MUTEX_CONTEXT);
-
-                /* Reset alert status */
-                if (ER_ALERTED_THREAD == status) {
-                    if (thread->GetAlertCode() == ENDPOINT_IS_DEAD_ALERTCODE) {
-                        status = ER_BUS_ENDPOINT_CLOSING;
-                    }
-                    thread->GetStopEvent().ResetEvent();
-                }
-                /* Remove thread from wait queue. */
-                thread->RemoveAuxListener(this);
-                deque<Thread*>::iterator eit = find(internal->txWaitQueue.begin(), internal->txWaitQueue.end(), thread);
-                if (eit != internal->txWaitQueue.end()) {
-                    internal->txWaitQueue.erase(eit);
-                }
-
-                if ((ER_OK != status) && (ER_ALERTED_THREAD != status) && (ER_TIMEOUT != status)) {
-                    break;
-                }
-
+    /* A session over its rate limit holds up its sender rather than the other sessions on the link */
+    uint32_t rateDelay = ChargeSessionRate(msg, msgBytes, internal->txSessions);
+    while ((rateDelay > 0) && !internal->stopping) {
+        uint32_t nap = (std::min)(rateDelay, (uint32_t)100);
+        internal->lock.Unlock(MUTEX_CONTEXT);
+        qcc::Sleep(nap);
+        internal->lock.Lock(MUTEX_CONTEXT);
+        rateDelay -= nap;
+    }
+    if (internal->stopping) {
+        internal->lock.Unlock(MUTEX_CONTEXT);
+        return ER_BUS_ENDPOINT_CLOSING;
+    }
+    SessionOpts::TxQueuePolicy policy = internal->txPolicy;
+    uint32_t dropSession = 0;
+    if (!internal->txSessions.empty()) {
+        map<SessionId, SessionShaping>::const_iterator it = internal->txSessions.find(msg->GetSessionId());
+        if ((it != internal->txSessions.end()) && (it->second.txPolicy != SessionOpts::TXQUEUE_BLOCK)) {
+            policy = it->second.txPolicy;
+            dropSession = it->first;
+            /* A session may only disconnect a link that carries nothing else, on a shared link it loses its own message */
+            if ((policy == SessionOpts::TXQUEUE_DISCONNECT) && (internal->sessionRoutes.size() > 1)) {
+                policy = SessionOpts::TXQUEUE_DROP_NEWEST;
             }
         }
     }
+    while (TxQueueOverLimit(msg, msgBytes)) {
+        /* Remove queue entries whose TTLs are expired if possible */
+        uint32_t maxWait = 20 * 1000;
+        size_t expired = internal->txQueue.RemoveExpired(maxWait);
+        if (expired > 0) {
+            internal->txDrops += static_cast<uint32_t>(expired);
+            continue;
+        }
+        if (policy == SessionOpts::TXQUEUE_DROP_OLDEST_SIGNAL) {
+            /* Method calls and replies are never dropped, if there are no signals to drop we block */
+            if (internal->txQueue.RemoveOldestSignal(dropSession)) {
+                ++internal->txDrops;
+                continue;
+            }
+        } else if (policy == SessionOpts::TXQUEUE_DROP_NEWEST) {
+            QCC_DbgPrintf(("Tx queue full (%s) dropping message (serial=%d)", GetUniqueName().c_str(), msg->GetCallSerial()));
+            MessageTrace::Record(MessageTrace::TRACE_DROPPED, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+            ++internal->txDrops;
+            status = ER_BUS_WRITE_QUEUE_FULL;
+            break;
+        } else if (policy == SessionOpts::TXQUEUE_DISCONNECT) {
+            QCC_LogError(ER_BUS_WRITE_QUEUE_FULL, ("Tx queue full (%s) disconnecting slow consumer", GetUniqueName().c_str()));
+            Stop();
+            status = ER_BUS_ENDPOINT_CLOSING;
+            break;
+        }
+        /*
+         * This thread will have to wait for room in the queue. The event is reset and set
+         * with the lock held so a wakeup from the tx side cannot be missed.
+         */
+        internal->txNotFull.ResetEvent();
+        internal->lock.Unlock(MUTEX_CONTEXT);
+        status = Event::Wait(internal->txNotFull, maxWait);
+        internal->lock.Lock(MUTEX_CONTEXT);
 
-
-    if (wasEmpty) {
-        internal->bus.GetInternal().GetIODispatch().EnableWriteCallbackNow(internal->stream);
+        if (internal->stopping) {
+            status = ER_BUS_ENDPOINT_CLOSING;
+            break;
+        }
+        if (ER_ALERTED_THREAD == status) {
+            Thread::GetThread()->GetStopEvent().ResetEvent();
+        } else if ((ER_OK != status) && (ER_TIMEOUT != status)) {
+            break;
+        }
+        status = ER_OK;
+    }
+    size_t count = internal->txQueue.Size();
+    if (status == ER_OK) {
+        internal->txQueue.Push(msg, LatencyStats::IsEnabled() ? GetLatencyClock() : 0, GetTxPriority(msg, internal->txSessions));
+        MessageTrace::Record(MessageTrace::TRACE_QUEUED, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+        if ((count + 1) > internal->txQueueHighWater) {
+            internal->txQueueHighWater = static_cast<uint32_t>(count + 1);
+        }
+        if (internal->txDrained.IsSet()) {
+            internal->txDrained.ResetEvent();
+            internal->bus.GetInternal().GetIODispatch(internal->stream).EnableWriteCallbackNow(internal->stream);
+        }
     }
     internal->lock.Unlock(MUTEX_CONTEXT);
 #ifndef NDEBUG
@@ -860,6 +1511,73 @@ QStatus _RemoteEndpoint::PushMessage(Message& msg)
     return status;
 }
 
+QStatus _RemoteEndpoint::PushMessages(Message* msgs, size_t numMsgs, size_t& numPushed)
+{
+    QCC_DbgTrace(("RemoteEndpoint::PushMessages %s (numMsgs=%u)", GetUniqueName().c_str(), numMsgs));
+
+    numPushed = 0;
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    if (internal->stopping) {
+        return ER_BUS_ENDPOINT_CLOSING;
+    }
+    const uint64_t queuedAt = LatencyStats::IsEnabled() ? GetLatencyClock() : 0;
+    internal->lock.Lock(MUTEX_CONTEXT);
+    while ((numPushed < numMsgs) && !(internal->encryptOnPush && msgs[numPushed]->encrypt) && !IsRateLimited(msgs[numPushed], internal->txSessions) && !TxQueueOverLimit(msgs[numPushed], TxQueue::MessageBytes(msgs[numPushed]))) {
+        const Message& msg = msgs[numPushed++];
+        internal->txQueue.Push(msg, queuedAt, GetTxPriority(msg, internal->txSessions));
+        MessageTrace::Record(MessageTrace::TRACE_QUEUED, msg->GetType(), msg->GetCallSerial(), msg->GetSender(), msg->GetDestination(), internal->traceName);
+    }
+    if (internal->txQueue.Size() > internal->txQueueHighWater) {
+        internal->txQueueHighWater = static_cast<uint32_t>(internal->txQueue.Size());
+    }
+    if (numPushed && internal->txDrained.IsSet()) {
+        internal->txDrained.ResetEvent();
+        internal->bus.GetInternal().GetIODispatch(internal->stream).EnableWriteCallbackNow(internal->stream);
+    }
+    internal->lock.Unlock(MUTEX_CONTEXT);
+
+    /*
+     * The queue is full, the next message has to be encrypted or its session is rate limited; the
+     * rest go through PushMessage() one at a time.
+     */
+    QStatus status = ER_OK;
+    while ((status == ER_OK) && (numPushed < numMsgs)) {
+        status = PushMessage(msgs[numPushed]);
+        if (status == ER_OK) {
+            ++numPushed;
+        }
+    }
+    return status;
+}
+
+bool _RemoteEndpoint::TxQueueOverLimit(const Message& msg, size_t msgBytes) const
+{
+    if (internal->txQueue.Full()) {
+        return true;
+    }
+    /* A single message larger than the byte limit is still allowed onto an empty queue */
+    if (internal->maxTxBytes && !internal->txQueue.Empty() && ((internal->txQueue.GetBytes() + msgBytes) > internal->maxTxBytes)) {
+        return true;
+    }
+    if (!internal->txSessions.empty()) {
+        map<SessionId, SessionShaping>::const_iterator it = internal->txSessions.find(msg->GetSessionId());
+        if ((it != internal->txSessions.end()) && (it->second.maxMessages || it->second.maxBytes)) {
+            size_t messages;
+            size_t bytes;
+            internal->txQueue.GetSessionUsage(it->first, messages, bytes);
+            if (it->second.maxMessages && (messages >= it->second.maxMessages)) {
+                return true;
+            }
+            if (it->second.maxBytes && messages && ((bytes + msgBytes) > it->second.maxBytes)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 void _RemoteEndpoint::IncrementRef()
 {
     int refs = IncrementAndFetch(&internal->refCount);
@@ -901,6 +1619,118 @@ QStatus _RemoteEndpoint::GenProbeMsg(bool isAck, Message msg)
     return msg->SignalMsg("", NULL, 0, "/", org::alljoyn::Daemon::InterfaceName, isAck ? "ProbeAck" : "ProbeReq", NULL, 0, 0, 0);
 }
 
+void _RemoteEndpoint::SetMaxTxQueueSize(size_t maxMessages)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        bool wasFull = internal->txQueue.Full();
+        internal->txQueue.SetMaxMessages(maxMessages);
+        if (wasFull && !internal->txQueue.Full()) {
+            internal->txNotFull.SetEvent();
+        }
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+size_t _RemoteEndpoint::GetMaxTxQueueSize() const
+{
+    return internal ? internal->txQueue.GetMaxMessages() : 0;
+}
+
+void _RemoteEndpoint::SetTxQueuePolicy(SessionOpts::TxQueuePolicy policy, size_t maxMessages, size_t maxBytes)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        if (maxMessages) {
+            internal->txQueue.SetMaxMessages(maxMessages);
+        }
+        internal->maxTxBytes = maxBytes;
+        internal->txPolicy = policy;
+        /* Let blocked threads re-evaluate the queue against the new limits and policy */
+        internal->txNotFull.SetEvent();
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+SessionOpts::TxQueuePolicy _RemoteEndpoint::GetTxQueuePolicy() const
+{
+    return internal ? internal->txPolicy : SessionOpts::TXQUEUE_BLOCK;
+}
+
+void _RemoteEndpoint::SetSessionTxShaping(SessionId id, SessionOpts::TxPriority priority, uint32_t rateLimit, uint32_t messageTtl)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        SessionShaping& shaping = internal->txSessions[id];
+        shaping.priority = priority;
+        shaping.messageTtl = messageTtl;
+        if (shaping.rateLimit != rateLimit) {
+            shaping.rateLimit = rateLimit;
+            shaping.credit = rateLimit;
+            shaping.lastCredit = GetTimestamp();
+        }
+        if (shaping.IsDefault()) {
+            internal->txSessions.erase(id);
+        }
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+void _RemoteEndpoint::SetSessionTxQueuePolicy(SessionId id, SessionOpts::TxQueuePolicy policy, size_t maxMessages, size_t maxBytes)
+{
+    if (policy > SessionOpts::TXQUEUE_DISCONNECT) {
+        QCC_LogError(ER_INVALID_DATA, ("Ignoring unknown transmit queue policy %d for session %u", policy, id));
+        policy = SessionOpts::TXQUEUE_BLOCK;
+    }
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        /* The daemon configured limits of the link are the most a session can ask for */
+        if (maxMessages >= internal->txQueue.GetMaxMessages()) {
+            maxMessages = 0;
+        }
+        if (internal->maxTxBytes && (maxBytes >= internal->maxTxBytes)) {
+            maxBytes = 0;
+        }
+        SessionShaping& shaping = internal->txSessions[id];
+        shaping.txPolicy = policy;
+        shaping.maxMessages = maxMessages;
+        shaping.maxBytes = maxBytes;
+        if (shaping.IsDefault()) {
+            internal->txSessions.erase(id);
+        }
+        /* Let blocked threads re-evaluate the queue against the new limits and policy */
+        internal->txNotFull.SetEvent();
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+void _RemoteEndpoint::GetStats(Stats& stats) const
+{
+    if (internal) {
+        stats.rxMessages = internal->rxMessages;
+        stats.rxBytes = internal->rxBytes;
+        stats.txMessages = internal->txMessages;
+        stats.txBytes = internal->txBytes;
+        stats.txQueueDepth = static_cast<uint32_t>(internal->txQueue.Size());
+        stats.txQueueHighWater = internal->txQueueHighWater;
+        stats.txDrops = internal->txDrops;
+        stats.idleTimeouts = internal->idleTimeouts;
+    } else {
+        ::memset(&stats, 0, sizeof(stats));
+    }
+}
+
+void _RemoteEndpoint::GetAuthStats(uint32_t& handshakes, uint32_t& failures)
+{
+    handshakes = static_cast<uint32_t>(authHandshakes);
+    failures = static_cast<uint32_t>(authFailures);
+}
+
+size_t _RemoteEndpoint::GetMaxTxQueueBytes() const
+{
+    return internal ? internal->maxTxBytes : 0;
+}
+
 void _RemoteEndpoint::SetSessionId(uint32_t sessionId) {
     if (internal) {
         internal->sessionId = sessionId;
@@ -915,4 +1745,49 @@ uint32_t _RemoteEndpoint::GetSessionId() {
     }
 }
 
+void _RemoteEndpoint::AddSessionRoute(uint32_t sessionId)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        ++internal->sessionRoutes[sessionId];
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+void _RemoteEndpoint::RemoveSessionRoute(uint32_t sessionId)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        std::map<uint32_t, uint32_t>::iterator it = internal->sessionRoutes.find(sessionId);
+        if ((it != internal->sessionRoutes.end()) && (--it->second == 0)) {
+            internal->sessionRoutes.erase(it);
+            /* The session's transmit settings go with it */
+            internal->txSessions.erase(sessionId);
+        }
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+}
+
+bool _RemoteEndpoint::RoutesSession(uint32_t sessionId)
+{
+    bool routes = false;
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        routes = (internal->sessionRoutes.find(sessionId) != internal->sessionRoutes.end());
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+    return routes;
+}
+
+size_t _RemoteEndpoint::GetSessionCount()
+{
+    size_t count = 0;
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        count = internal->sessionRoutes.size();
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    }
+    return count;
+}
+
 }
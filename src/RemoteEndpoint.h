@@ -29,17 +29,20 @@
 #include <qcc/String.h>
 #include <qcc/GUID.h>
 #include <qcc/Mutex.h>
+#include <qcc/SocketTypes.h>
 #include <qcc/Stream.h>
 #include <qcc/Thread.h>
 
 #include "BusEndpoint.h"
 #include "EndpointAuth.h"
 
+#include <alljoyn/Session.h>
 #include <alljoyn/Status.h>
 
 namespace ajn {
 
 class _RemoteEndpoint;
+class ValidationCache;
 
 /**
  * Managed object type that wraps a remote endpoint
@@ -51,6 +54,8 @@ typedef qcc::ManagedObj<_RemoteEndpoint> RemoteEndpoint;
  * over a stream interface
  */
 class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public qcc::IOReadListener, public qcc::IOWriteListener, public qcc::IOExitListener {
+    friend class LinkMonitor;
+    friend class RoutingPool;
 
   public:
 
@@ -62,26 +67,33 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
 
       public:
 
-        Features() : isBusToBus(false), allowRemote(false), handlePassing(false), ajVersion(0), protocolVersion(0), processId(0), trusted(false)
+        Features() : isBusToBus(false), allowRemote(false), handlePassing(false), bodyCompression(false), signalBatching(false), ajVersion(0), protocolVersion(0), processId(0), trusted(false)
         { }
 
-        bool isBusToBus;       /**< When initiating connection this is an input value indicating if this is a bus-to-bus connection.
+        bool isBusToBus : 1;       /**< When initiating connection this is an input value indicating if this is a bus-to-bus connection.
                                     When accepting a connection this is an output value indicating if this is bus-to-bus connection. */
 
-        bool allowRemote;      /**< When initiating a connection this input value tells the local daemon whether it wants to receive
+        bool allowRemote : 1;      /**< When initiating a connection this input value tells the local daemon whether it wants to receive
                                     messages from remote busses. When accepting a connection, this output indicates whether the connected
                                     endpoint is willing to receive messages from remote busses. */
 
-        bool handlePassing;    /**< Indicates if support for handle passing is enabled for this the endpoint. This is only
+        bool handlePassing : 1;    /**< Indicates if support for handle passing is enabled for this the endpoint. This is only
                                     enabled for endpoints that connect applications on the same device. */
 
+        bool bodyCompression : 1;  /**< When establishing a bus-to-bus connection this is an input value indicating if the transport
+                                    wants large message bodies compressed. After establishment it indicates whether both sides
+                                    agreed to it. */
+
+        bool signalBatching : 1;   /**< Indicates if both sides of a client to daemon connection understand batch containers, see
+                                    SignalBatcher. This is negotiated for every connection that is not bus-to-bus. */
+
         uint32_t ajVersion;        /**< The AllJoyn version negotiated with the remote peer */
 
         uint32_t protocolVersion;  /**< The AllJoyn version negotiated with the remote peer */
 
         uint32_t processId;        /**< Process id optionally obtained from the remote peer */
 
-        bool trusted;              /**< Indicated if the remote client was trusted */
+        bool trusted : 1;          /**< Indicated if the remote client was trusted */
     };
 
     /**
@@ -163,6 +175,21 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     virtual QStatus PushMessage(Message& msg);
 
+    /**
+     * Send several outgoing messages. The messages that fit in the transmit queue are queued
+     * with a single lock acquisition and the writer is woken once so they can be coalesced
+     * into vectored writes. Any remaining messages are sent with PushMessage() and are subject
+     * to the transmit queue policy.
+     *
+     * @param msgs        Messages to be sent, in order.
+     * @param numMsgs     Number of messages in msgs.
+     * @param numPushed   [OUT] Number of messages that were queued.
+     * @return
+     *      - ER_OK if all the messages were queued.
+     *      - An error status otherwise
+     */
+    QStatus PushMessages(Message* msgs, size_t numMsgs, size_t& numPushed);
+
     /**
      * Start the endpoint.
      *
@@ -205,6 +232,16 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     void SetStream(qcc::Stream* s);
 
+    /**
+     * Choose whether PullBytes() reads ahead. Transports whose stream already holds complete
+     * messages, such as a PacketEngineStream, turn read-ahead off so message bytes are copied
+     * from the stream straight into the message buffer instead of through the read-ahead buffer.
+     * Read-ahead is on by default.
+     *
+     * @param readAhead   false to pull directly from the stream.
+     */
+    void SetReadAhead(bool readAhead);
+
     /**
      * Join the endpoint.
      * Block the caller until the endpoint is stopped.
@@ -237,6 +274,14 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     const qcc::String& GetRemoteName() const;
 
+    /**
+     * Get the cache of values already validated on messages received on this endpoint.
+     * Must only be used by the thread that reads from the endpoint.
+     *
+     * @return  The validation cache.
+     */
+    ValidationCache& GetValidationCache();
+
     /**
      * Get the protocol version used by the remote end of this endpoint.
      *
@@ -270,6 +315,32 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     QStatus Establish(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection, AuthListener* listener = NULL);
 
+    /**
+     * Establish an incoming connection without blocking. The first call begins the handshake and
+     * each call consumes the data available from the stream. Call again once the stream is readable
+     * until something other than ER_WOULDBLOCK is returned.
+     *
+     * A handshake in progress holds a reference to this endpoint so it must either run to
+     * completion or be abandoned with AbortEstablish().
+     *
+     * @param authMechanisms  The authentication mechanism(s) to use.
+     * @param authUsed        [OUT]    Returns the name of the authentication method
+     *                                 that was used to establish the connection.
+     * @param listener        Optional authentication listener
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - ER_WOULDBLOCK if the handshake is waiting for data from the remote side.
+     *      - An error status otherwise
+     */
+    QStatus EstablishNonBlocking(const qcc::String& authMechanisms, qcc::String& authUsed, AuthListener* listener = NULL);
+
+    /**
+     * Abandon a handshake started by EstablishNonBlocking(). This is a no-op if there is no
+     * handshake in progress.
+     */
+    void AbortEstablish();
+
     /**
      * Get the GUID of the remote side of a bus-to-bus endpoint.
      *
@@ -306,6 +377,23 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     qcc::Source& GetSource() { return GetStream(); }
 
+    /**
+     * Pull bytes of an incoming message from this endpoint. Bytes are served from a per-endpoint
+     * read-ahead buffer that is refilled with a single large read from the endpoint's source so
+     * that several back-to-back messages can be parsed from one receive, unless read-ahead was
+     * turned off with SetReadAhead(). Messages that carry handles must be read directly from the
+     * source with PullBytesAndFds().
+     *
+     * @param buf          Buffer to store pulled bytes
+     * @param reqBytes     Number of bytes requested to be pulled from the endpoint.
+     * @param actualBytes  Actual number of bytes retrieved from the endpoint.
+     * @param timeout      Timeout in milliseconds, only applies when the read-ahead buffer is empty.
+     *
+     * @return   ER_OK if successful. ER_NONE if no more data. Otherwise the error returned by
+     *           the source.
+     */
+    QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout);
+
     /**
      * Get the data sink for this endpoint
      *
@@ -375,8 +463,175 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     void SetSessionId(uint32_t sessionId);
 
+    /**
+     * Record that a session is routed over this endpoint. Several sessions may share one
+     * BusToBus endpoint and each call must be balanced by a call to RemoveSessionRoute().
+     *
+     * @param sessionId   Id of the session.
+     */
+    void AddSessionRoute(uint32_t sessionId);
+
+    /**
+     * Remove a session route added with AddSessionRoute().
+     *
+     * @param sessionId   Id of the session.
+     */
+    void RemoveSessionRoute(uint32_t sessionId);
+
+    /**
+     * Indicate whether a session is routed over this endpoint.
+     *
+     * @param sessionId   Id of the session.
+     * @return  true iff AddSessionRoute() has been called for sessionId more times than RemoveSessionRoute().
+     */
+    bool RoutesSession(uint32_t sessionId);
+
+    /**
+     * Get the number of distinct sessions routed over this endpoint.
+     *
+     * @return  The number of sessions.
+     */
+    size_t GetSessionCount();
+
+    /**
+     * Set the maximum number of messages that can be queued for transmission on this
+     * endpoint. What happens when the transmit queue is full is set by SetTxQueuePolicy().
+     *
+     * @param maxMessages   Maximum depth of the transmit queue (at least 1).
+     */
+    void SetMaxTxQueueSize(size_t maxMessages);
+
+    /**
+     * Get the maximum number of messages that can be queued for transmission on this endpoint.
+     *
+     * @return  The maximum depth of the transmit queue.
+     */
+    size_t GetMaxTxQueueSize() const;
+
+    /**
+     * Set the limits of the transmit queue and the policy applied by PushMessage() when a
+     * message would exceed them.
+     *
+     * @param policy        Block the sender, drop the oldest queued signal, drop the message
+     *                      being pushed or disconnect this endpoint.
+     * @param maxMessages   Maximum depth of the transmit queue in messages (0 leaves it unchanged).
+     * @param maxBytes      Maximum total size of the queued messages in bytes (0 means no limit).
+     */
+    void SetTxQueuePolicy(SessionOpts::TxQueuePolicy policy, size_t maxMessages, size_t maxBytes);
+
+    /**
+     * Get the policy applied when the transmit queue is full.
+     *
+     * @return  The transmit queue policy.
+     */
+    SessionOpts::TxQueuePolicy GetTxQueuePolicy() const;
+
+    /**
+     * Set the transmit priority, rate limit and message time-to-live of a session's messages on
+     * this endpoint. Messages in the transmit queue keep the priority they were queued with. A
+     * session over its rate limit makes PushMessage() wait until the session is back within it.
+     * The time-to-live is handed to the stream with each of the session's messages, streams that
+     * send packets stop retransmitting a message once it has expired.
+     *
+     * @param id          The session.
+     * @param priority    Priority for messages of the session pushed from now on.
+     * @param rateLimit   Maximum rate in bytes per second (0 means no limit).
+     * @param messageTtl  Time-to-live in milliseconds of the session's messages (0 means none).
+     */
+    void SetSessionTxShaping(SessionId id, SessionOpts::TxPriority priority, uint32_t rateLimit, uint32_t messageTtl);
+
+    /**
+     * Set the transmit queue limits and policy of a session's messages on this endpoint. They
+     * only apply to the session's own messages: the limits of the endpoint as a whole are the
+     * daemon configured ones set by SetTxQueuePolicy() and a session limit at or above them is
+     * ignored. A session that asks to disconnect a slow consumer only gets it if the endpoint
+     * carries no other session, otherwise its newest message is dropped instead. The settings
+     * are forgotten when the session's last route over this endpoint is removed.
+     *
+     * @param id           The session.
+     * @param policy       Policy for the session's messages when a limit is reached, an
+     *                     unknown policy is treated as TXQUEUE_BLOCK which defers to the
+     *                     endpoint's policy.
+     * @param maxMessages  Most of the session's messages that may be queued (0 means no limit
+     *                     beyond the endpoint's).
+     * @param maxBytes     Most bytes of the session's messages that may be queued (0 means no
+     *                     limit beyond the endpoint's).
+     */
+    void SetSessionTxQueuePolicy(SessionId id, SessionOpts::TxQueuePolicy policy, size_t maxMessages, size_t maxBytes);
+
+    /**
+     * Get the maximum total size in bytes of the messages queued for transmission.
+     *
+     * @return  The byte limit of the transmit queue (0 means no limit).
+     */
+    size_t GetMaxTxQueueBytes() const;
+
+    /**
+     * Traffic counters for a remote endpoint. Each counter has a single writer (the rx
+     * callback, the tx callback or a holder of the endpoint lock) so none are locked, they
+     * may be slightly stale when read and may wrap.
+     */
+    struct Stats {
+        uint32_t rxMessages;        /**< Messages received */
+        uint32_t rxBytes;           /**< Bytes of the messages received */
+        uint32_t txMessages;        /**< Messages written */
+        uint32_t txBytes;           /**< Bytes of the messages written */
+        uint32_t txQueueDepth;      /**< Messages in the transmit queue now */
+        uint32_t txQueueHighWater;  /**< Deepest the transmit queue has been in messages */
+        uint32_t txDrops;           /**< Messages dropped by the transmit queue policy or because their TTL expired */
+        uint32_t idleTimeouts;      /**< Idle probes sent because nothing was received */
+    };
+
+    /**
+     * Get the traffic counters of this endpoint.
+     *
+     * @param stats   [OUT] The counters.
+     */
+    void GetStats(Stats& stats) const;
+
+    /**
+     * Get the number of authentication handshakes run by all remote endpoints in this process.
+     *
+     * @param handshakes   [OUT] Number of handshakes that completed or failed.
+     * @param failures     [OUT] Number of handshakes that failed.
+     */
+    static void GetAuthStats(uint32_t& handshakes, uint32_t& failures);
+
   protected:
 
+    /**
+     * Push several buffers to the endpoint's sink with a single vectored write. Transports
+     * whose sink is a socket override this and call SetVectoredTx(true) so that small queued
+     * messages are coalesced into one writev/sendmsg call.
+     *
+     * @param iov        The buffers to write.
+     * @param numIOVec   Number of buffers in iov.
+     * @param numSent    [OUT] Number of bytes written.
+     *
+     * @return
+     *      - #ER_OK if some or all of the bytes were written
+     *      - #ER_WOULDBLOCK if the write would block
+     *      - An error status otherwise
+     */
+    virtual QStatus PushBytesV(const qcc::IOVec* iov, size_t numIOVec, size_t& numSent) { return ER_NOT_IMPLEMENTED; }
+
+    /**
+     * Enable or disable coalescing of queued messages into vectored writes. Only enable
+     * vectored writes if PushBytesV() is implemented.
+     *
+     * @param enable   true to enable vectored writes.
+     */
+    void SetVectoredTx(bool enable);
+
+    /**
+     * Enable or disable encrypting secure messages in PushMessage(). This is enabled by default so
+     * encryption runs on the threads that push the messages. When disabled messages are encrypted
+     * as they are written by the I/O dispatch thread.
+     *
+     * @param enable   true to encrypt messages when they are pushed.
+     */
+    void SetEncryptOnPush(bool enable);
+
     /**
      * Set link timeout params (with knowledge of the underlying transport characteristics)
      *
@@ -420,6 +675,59 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     bool IsProbeMsg(const Message& msg, bool& isAck);
 
+    /**
+     * Called by the bus's LinkMonitor when nothing has been received for the link timeout.
+     * Sends a ProbeReq or, if too many probes went unanswered, shuts the endpoint down.
+     */
+    void LinkIdle();
+
+    /**
+     * Get how long to wait for a ProbeAck. Must be called with the internal lock held.
+     *
+     * @return  The probe timeout in milliseconds.
+     */
+    uint32_t ProbeWait() const;
+
+    /**
+     * Determine if queueing a message would exceed the transmit queue limits. Must be called
+     * with the internal lock held.
+     *
+     * @param msg        The message to be queued, its session may have limits of its own.
+     * @param msgBytes   Size of the message to be queued.
+     * @return  true if the message cannot be queued without exceeding a limit.
+     */
+    bool TxQueueOverLimit(const Message& msg, size_t msgBytes) const;
+
+    /**
+     * Queue a message that is ready to be written applying the transmit queue policy.
+     *
+     * @param msg   The message to queue.
+     * @return  Same as PushMessage().
+     */
+    QStatus QueueMessage(Message& msg);
+
+    /**
+     * Determine if a message can be written as-is as part of a vectored write.
+     *
+     * @param msg   Message to examine.
+     * @return  true if the message can be added to a batch.
+     */
+    bool IsBatchable(const Message& msg) const;
+
+    /**
+     * Write the messages in the transmit batch with vectored writes.
+     *
+     * @param bus2bus   true if this is a bus-to-bus endpoint (for latency statistics).
+     *
+     * @return  ER_OK if the batch was completely written, ER_TIMEOUT if the write would block.
+     */
+    QStatus WriteTxBatch(bool bus2bus);
+
+    /**
+     * Release the messages in the transmit batch.
+     */
+    void ClearTxBatch();
+
     /**
      * Internal callback used to indicate that one of the internal threads (rx or tx) has exited.
      * RemoteEndpoint users should not call this method.
@@ -438,6 +746,38 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     QStatus ReadCallback(qcc::Source& source, bool isTimedOut);
 
+    /**
+     * Push a received message to the router.
+     *
+     * @param msg       A message read and unmarshaled by ReadCallback().
+     * @param batched   true if msg was unpacked from a signal batch.
+     *
+     * @return  ER_OK if the message was routed or may be discarded, otherwise the error that
+     *          makes the endpoint stop reading.
+     */
+    QStatus RouteMessage(Message& msg, bool batched);
+
+    /**
+     * Hand a received message to the bus's RoutingPool, pausing reading if too many messages
+     * are already waiting to be routed.
+     *
+     * @param msg       A message read and unmarshaled by ReadCallback().
+     * @param batched   true if msg was unpacked from a signal batch.
+     * @param paused    [OUT] Set to true if reading was paused.
+     *
+     * @return  ER_OK if the message was handed over.
+     */
+    QStatus StageMessage(Message& msg, bool batched, bool& paused);
+
+    /**
+     * Called by the bus's RoutingPool to route a message handed over by StageMessage(). Resumes
+     * reading once the routing worker has caught up.
+     *
+     * @param msg       The message to route.
+     * @param batched   true if msg was unpacked from a signal batch.
+     */
+    void RouteStaged(Message& msg, bool batched);
+
     /**
      * Internal callback used to indicate that data can be written to File descriptor.
      * RemoteEndpoint users should not call this method.
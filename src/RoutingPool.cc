@@ -0,0 +1,171 @@
+/**
+ * @file
+ *
+ * This file implements the RoutingPool class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/StringUtil.h>
+
+#include "RoutingPool.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+/* Upper bound on the number of routing workers */
+static const uint32_t MAX_ROUTING_THREADS = 64;
+
+RoutingPool::RoutingPool(const char* name) : started(false), stopping(false)
+{
+    Environ* env = Environ::GetAppEnviron();
+    uint32_t numWorkers = StringToU32(env->Find("ALLJOYN_ROUTING_THREADS"), 0, 0);
+    if (numWorkers > MAX_ROUTING_THREADS) {
+        numWorkers = MAX_ROUTING_THREADS;
+    }
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+        workers.push_back(new Worker(name));
+    }
+    QCC_DbgPrintf(("RoutingPool %s: %u workers", name, numWorkers));
+}
+
+RoutingPool::~RoutingPool()
+{
+    Stop();
+    Join();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        delete workers[i];
+    }
+}
+
+QStatus RoutingPool::Push(Message& msg, RemoteEndpoint& ep, bool batched)
+{
+    QStatus status = ER_OK;
+    lock.Lock(MUTEX_CONTEXT);
+    if (stopping) {
+        status = ER_BUS_STOPPING;
+    } else if (!started) {
+        for (size_t i = 0; (status == ER_OK) && (i < workers.size()); ++i) {
+            status = workers[i]->Start();
+        }
+        started = true;
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to start routing workers"));
+        }
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+
+    if (status == ER_OK) {
+        Worker* worker = workers[Shard(ep)];
+        worker->lock.Lock(MUTEX_CONTEXT);
+        worker->queue.push_back(Entry(msg, ep, batched));
+        if (worker->queue.size() == 1) {
+            worker->wakeup.SetEvent();
+        }
+        worker->lock.Unlock(MUTEX_CONTEXT);
+    }
+    return status;
+}
+
+QStatus RoutingPool::Stop()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    bool wasStarted = started;
+    stopping = true;
+    lock.Unlock(MUTEX_CONTEXT);
+    if (wasStarted) {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->Stop();
+        }
+    }
+    return ER_OK;
+}
+
+QStatus RoutingPool::Join()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    bool wasStarted = started;
+    lock.Unlock(MUTEX_CONTEXT);
+    if (wasStarted) {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->Join();
+            /* Drop what was never routed so the endpoints are released */
+            workers[i]->lock.Lock(MUTEX_CONTEXT);
+            workers[i]->queue.clear();
+            workers[i]->wakeup.ResetEvent();
+            workers[i]->lock.Unlock(MUTEX_CONTEXT);
+        }
+    }
+    lock.Lock(MUTEX_CONTEXT);
+    started = false;
+    stopping = false;
+    lock.Unlock(MUTEX_CONTEXT);
+    return ER_OK;
+}
+
+size_t RoutingPool::Shard(const RemoteEndpoint& ep) const
+{
+    if (workers.size() == 1) {
+        return 0;
+    }
+    /* Endpoints are heap allocated so the low bits of the address carry no information */
+    size_t h = reinterpret_cast<size_t>(&(*ep)) >> 4;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6dU;
+    h ^= h >> 12;
+    return h % workers.size();
+}
+
+void RoutingPool::Route(Entry& entry)
+{
+    entry.ep->RouteStaged(entry.msg, entry.batched);
+}
+
+ThreadReturn STDCALL RoutingPool::Worker::Run(void* arg)
+{
+    deque<Entry> batch;
+    while (!IsStopping()) {
+        lock.Lock(MUTEX_CONTEXT);
+        if (queue.empty()) {
+            wakeup.ResetEvent();
+            QStatus status = Event::Wait(wakeup, lock);
+            if ((status == ER_ALERTED_THREAD) && !IsStopping()) {
+                GetStopEvent().ResetEvent();
+            }
+            continue;
+        }
+        /* Take everything that is queued so the endpoints are not contending for the lock */
+        batch.swap(queue);
+        lock.Unlock(MUTEX_CONTEXT);
+        while (!batch.empty() && !IsStopping()) {
+            RoutingPool::Route(batch.front());
+            batch.pop_front();
+        }
+        batch.clear();
+    }
+    return 0;
+}
+
+}
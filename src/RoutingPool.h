@@ -0,0 +1,145 @@
+#ifndef _ALLJOYN_ROUTINGPOOL_H
+#define _ALLJOYN_ROUTINGPOOL_H
+/**
+ * @file
+ * RoutingPool routes received messages on worker threads so the reading I/O threads are never
+ * held up by a blocked PushMessage().
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include RoutingPool.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <deque>
+#include <vector>
+
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+
+#include <alljoyn/Message.h>
+
+#include "RemoteEndpoint.h"
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * RoutingPool owns the routing workers of a bus attachment. A remote endpoint that has read and
+ * unmarshaled a message hands it to the pool and goes on reading; a worker then pushes it to the
+ * router. Each endpoint is pinned by hash to one worker so the messages received on an endpoint
+ * are routed in the order they were read, while messages received on other endpoints are routed
+ * in parallel and are not held up by an endpoint whose destinations are slow.
+ *
+ * The number of workers is read from the ALLJOYN_ROUTING_THREADS environment variable. It
+ * defaults to zero, in which case messages are routed on the I/O thread that read them. The
+ * workers are started when the first message is handed to the pool.
+ */
+class RoutingPool {
+  public:
+
+    /**
+     * Constructor
+     *
+     * @param name   Name for the worker threads.
+     */
+    RoutingPool(const char* name);
+
+    /** Destructor */
+    ~RoutingPool();
+
+    /**
+     * Check if messages should be handed to the pool.
+     *
+     * @return  true if the pool has workers.
+     */
+    bool IsEnabled() const { return !workers.empty(); }
+
+    /**
+     * Hand a received message to the worker the endpoint is pinned to. The worker calls the
+     * endpoint's RouteStaged() for the message.
+     *
+     * @param msg       The unmarshaled message.
+     * @param ep        The endpoint the message was received on.
+     * @param batched   true if msg was unpacked from a signal batch.
+     *
+     * @return
+     *      - ER_OK if the message was queued.
+     *      - ER_BUS_STOPPING if the pool is stopping.
+     *      - Otherwise the status of starting the workers.
+     */
+    QStatus Push(Message& msg, RemoteEndpoint& ep, bool batched);
+
+    /**
+     * Stop the workers. Messages that have not been routed yet are dropped.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Stop();
+
+    /**
+     * Wait for the workers to stop. The pool can be used again once this returns.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus Join();
+
+  private:
+
+    /* Copy constructor and assignment are not allowed */
+    RoutingPool(const RoutingPool& other);
+    RoutingPool& operator=(const RoutingPool& other);
+
+    /** A message waiting to be routed */
+    struct Entry {
+        Entry(const Message& msg, const RemoteEndpoint& ep, bool batched) : msg(msg), ep(ep), batched(batched) { }
+        Message msg;
+        RemoteEndpoint ep;
+        bool batched;
+    };
+
+    class Worker : public qcc::Thread {
+      public:
+        Worker(const char* name) : qcc::Thread(name) { }
+
+        qcc::Mutex lock;             /**< Protects queue */
+        std::deque<Entry> queue;     /**< Messages waiting for this worker */
+        qcc::Event wakeup;           /**< Set when a message is added to an empty queue */
+
+      protected:
+        qcc::ThreadReturn STDCALL Run(void* arg);
+    };
+
+    size_t Shard(const RemoteEndpoint& ep) const;
+
+    /** Called by the workers - RemoteEndpoint::RouteStaged() is only accessible to RoutingPool */
+    static void Route(Entry& entry);
+
+    qcc::Mutex lock;                 /**< Protects started and stopping */
+    std::vector<Worker*> workers;    /**< The routing workers */
+    bool started;                    /**< True once the workers have been started */
+    bool stopping;                   /**< True between Stop() and Join() */
+};
+
+}
+
+#endif
@@ -38,6 +38,13 @@ namespace ajn {
 #define SESSIONOPTS_ISMULTICAST "multi"
 #define SESSIONOPTS_PROXIMITY   "prox"
 #define SESSIONOPTS_TRANSPORTS  "trans"
+#define SESSIONOPTS_TXQ_POLICY  "txqp"
+#define SESSIONOPTS_TXQ_MSGS    "txqm"
+#define SESSIONOPTS_TXQ_BYTES   "txqb"
+#define SESSIONOPTS_TX_PRIORITY "txpri"
+#define SESSIONOPTS_TX_RATE     "txrate"
+#define SESSIONOPTS_TX_TTL      "txttl"
+#define SESSIONOPTS_DIRECT      "direct"
 
 bool SessionOpts::IsCompatible(const SessionOpts& other) const
 {
@@ -82,6 +89,29 @@ QStatus GetSessionOpts(const MsgArg& msgArg, SessionOpts& opts)
                 val->Get("y", &opts.proximity);
             } else if (::strcmp(SESSIONOPTS_TRANSPORTS, key) == 0) {
                 val->Get("q", &opts.transports);
+            } else if (::strcmp(SESSIONOPTS_TXQ_POLICY, key) == 0) {
+                uint8_t tmp = SessionOpts::TXQUEUE_BLOCK;
+                val->Get("y", &tmp);
+                /* The options may come from another daemon, an unknown policy keeps the default */
+                if (tmp <= SessionOpts::TXQUEUE_DISCONNECT) {
+                    opts.txQueuePolicy = static_cast<SessionOpts::TxQueuePolicy>(tmp);
+                }
+            } else if (::strcmp(SESSIONOPTS_TXQ_MSGS, key) == 0) {
+                val->Get("u", &opts.txQueueMaxMessages);
+            } else if (::strcmp(SESSIONOPTS_TXQ_BYTES, key) == 0) {
+                val->Get("u", &opts.txQueueMaxBytes);
+            } else if (::strcmp(SESSIONOPTS_TX_PRIORITY, key) == 0) {
+                uint8_t tmp = SessionOpts::TXPRIORITY_INTERACTIVE;
+                val->Get("y", &tmp);
+                if (tmp <= SessionOpts::TXPRIORITY_BULK) {
+                    opts.txPriority = static_cast<SessionOpts::TxPriority>(tmp);
+                }
+            } else if (::strcmp(SESSIONOPTS_TX_RATE, key) == 0) {
+                val->Get("u", &opts.txRateLimit);
+            } else if (::strcmp(SESSIONOPTS_TX_TTL, key) == 0) {
+                val->Get("u", &opts.txMessageTtl);
+            } else if (::strcmp(SESSIONOPTS_DIRECT, key) == 0) {
+                val->Get("b", &opts.isDirect);
             }
         }
     }
@@ -94,13 +124,43 @@ void SetSessionOpts(const SessionOpts& opts, MsgArg& msgArg)
     MsgArg isMultiArg("b", opts.isMultipoint);
     MsgArg proximityArg("y", opts.proximity);
     MsgArg transportsArg("q", opts.transports);
-
-    MsgArg entries[4];
-    entries[0].Set("{sv}", SESSIONOPTS_TRAFFIC, &trafficArg);
-    entries[1].Set("{sv}", SESSIONOPTS_ISMULTICAST, &isMultiArg);
-    entries[2].Set("{sv}", SESSIONOPTS_PROXIMITY, &proximityArg);
-    entries[3].Set("{sv}", SESSIONOPTS_TRANSPORTS, &transportsArg);
-    QStatus status = msgArg.Set("a{sv}", ArraySize(entries), entries);
+    MsgArg txqPolicyArg("y", opts.txQueuePolicy);
+    MsgArg txqMsgsArg("u", opts.txQueueMaxMessages);
+    MsgArg txqBytesArg("u", opts.txQueueMaxBytes);
+    MsgArg txPriorityArg("y", opts.txPriority);
+    MsgArg txRateArg("u", opts.txRateLimit);
+    MsgArg txTtlArg("u", opts.txMessageTtl);
+    MsgArg directArg("b", opts.isDirect);
+
+    MsgArg entries[11];
+    size_t numEntries = 0;
+    entries[numEntries++].Set("{sv}", SESSIONOPTS_TRAFFIC, &trafficArg);
+    entries[numEntries++].Set("{sv}", SESSIONOPTS_ISMULTICAST, &isMultiArg);
+    entries[numEntries++].Set("{sv}", SESSIONOPTS_PROXIMITY, &proximityArg);
+    entries[numEntries++].Set("{sv}", SESSIONOPTS_TRANSPORTS, &transportsArg);
+    /* Transmit queue settings are only sent if they differ from the defaults */
+    if (opts.txQueuePolicy != SessionOpts::TXQUEUE_BLOCK) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TXQ_POLICY, &txqPolicyArg);
+    }
+    if (opts.txQueueMaxMessages != 0) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TXQ_MSGS, &txqMsgsArg);
+    }
+    if (opts.txQueueMaxBytes != 0) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TXQ_BYTES, &txqBytesArg);
+    }
+    if (opts.txPriority != SessionOpts::TXPRIORITY_INTERACTIVE) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TX_PRIORITY, &txPriorityArg);
+    }
+    if (opts.txRateLimit != 0) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TX_RATE, &txRateArg);
+    }
+    if (opts.txMessageTtl != 0) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_TX_TTL, &txTtlArg);
+    }
+    if (opts.isDirect) {
+        entries[numEntries++].Set("{sv}", SESSIONOPTS_DIRECT, &directArg);
+    }
+    QStatus status = msgArg.Set("a{sv}", numEntries, entries);
     if (status == ER_OK) {
         msgArg.Stabilize();
     } else {
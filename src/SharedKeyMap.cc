@@ -0,0 +1,331 @@
+/**
+ * @file
+ *
+ * This file implements the SharedKeyMap class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <qcc/Crypto.h>
+#include <qcc/Debug.h>
+#include <qcc/Thread.h>
+#include <qcc/atomic.h>
+
+#include "SharedKeyMap.h"
+
+#define QCC_MODULE "ALLJOYN_AUTH"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+static const uint32_t MAP_MAGIC = 0x324D414A;  /* "AJM2" */
+
+static const uint32_t SLOT_USED = 0x1;
+static const uint32_t SLOT_DELETED = 0x2;
+
+/* Tries before ReadSlot() gives up on a slot that stays locked, after SPIN_TRIES it sleeps between tries */
+static const uint32_t READ_TRIES = 200;
+static const uint32_t SPIN_TRIES = 100;
+
+/*
+ * The atomic increment is a full memory barrier on every platform we build for. The counter
+ * itself is private to this process, only the ordering matters.
+ */
+static volatile int32_t barrierCount = 0;
+
+static inline void FullBarrier()
+{
+    IncrementAndFetch(&barrierCount);
+}
+
+/* GUIDs are random so the first bytes are as good a hash as any */
+static uint32_t HashGuid(const GUID128& guid)
+{
+    const uint8_t* b = guid.GetBytes();
+    return (static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+            (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24)) % SharedKeyMap::NUM_SLOTS;
+}
+
+bool SharedKeyMap::Init(void* region, const qcc::GUID128& owner)
+{
+    if (!region) {
+        return false;
+    }
+    /* Records are encrypted with nonces that restart with the slot versions, never reuse an epoch */
+    uint64_t epoch = 0;
+    while (epoch == 0) {
+        if (Crypto_GetRandomBytes(reinterpret_cast<uint8_t*>(&epoch), sizeof(epoch)) != ER_OK) {
+            QCC_LogError(ER_CRYPTO_ERROR, ("Cannot choose an epoch for the shared key map"));
+            return false;
+        }
+    }
+    memset(region, 0, RegionSize());
+    hdr = reinterpret_cast<Header*>(region);
+    slots = reinterpret_cast<Slot*>(reinterpret_cast<uint8_t*>(region) + sizeof(Header));
+    hdr->numSlots = NUM_SLOTS;
+    hdr->epoch = epoch;
+    hdr->maxRecord = MAX_RECORD;
+    memcpy(hdr->owner, owner.GetBytes(), GUID128::SIZE);
+    /* The magic goes last so a process that attaches never sees a half initialized header */
+    FullBarrier();
+    hdr->magic = MAP_MAGIC;
+    return true;
+}
+
+bool SharedKeyMap::Attach(void* region, size_t regionLen, const qcc::GUID128& owner)
+{
+    if (!region || (regionLen < RegionSize())) {
+        return false;
+    }
+    Header* h = reinterpret_cast<Header*>(region);
+    if ((h->magic != MAP_MAGIC) || (h->numSlots != NUM_SLOTS) || (h->maxRecord != MAX_RECORD) ||
+        (memcmp(h->owner, owner.GetBytes(), GUID128::SIZE) != 0)) {
+        return false;
+    }
+    hdr = h;
+    slots = reinterpret_cast<Slot*>(reinterpret_cast<uint8_t*>(region) + sizeof(Header));
+    return true;
+}
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+QStatus SharedKeyMap::Open(const qcc::String& fileName, const qcc::GUID128& owner)
+{
+    Close();
+    /* The records are encrypted but there is still no reason for anyone else to read them */
+    int f = open(fileName.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    if (f < 0) {
+        QCC_LogError(ER_OS_ERROR, ("Cannot open shared key map %s: %s", fileName.c_str(), strerror(errno)));
+        return ER_OS_ERROR;
+    }
+    /* Hold the write lock so two processes opening a new file do not both initialize it */
+    flock(f, LOCK_EX);
+    QStatus status = ER_OK;
+    struct stat st;
+    if ((fstat(f, &st) != 0) || ((static_cast<size_t>(st.st_size) < RegionSize()) && (ftruncate(f, RegionSize()) != 0))) {
+        status = ER_OS_ERROR;
+        QCC_LogError(status, ("Cannot size shared key map %s: %s", fileName.c_str(), strerror(errno)));
+    }
+    void* region = MAP_FAILED;
+    if (status == ER_OK) {
+        region = mmap(NULL, RegionSize(), PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+        if (region == MAP_FAILED) {
+            status = ER_OS_ERROR;
+            QCC_LogError(status, ("Cannot map shared key map %s: %s", fileName.c_str(), strerror(errno)));
+        }
+    }
+    if (status == ER_OK) {
+        if (!Attach(region, RegionSize(), owner)) {
+            QCC_DbgHLPrintf(("Initializing shared key map %s", fileName.c_str()));
+            if (!Init(region, owner)) {
+                /* Leave the old contents alone, the header was not touched */
+                status = ER_CRYPTO_ERROR;
+            }
+        }
+    }
+    if (status == ER_OK) {
+        fd = f;
+        mapped = region;
+    }
+    flock(f, LOCK_UN);
+    if (status != ER_OK) {
+        if (region != MAP_FAILED) {
+            munmap(region, RegionSize());
+        }
+        close(f);
+    }
+    return status;
+}
+
+void SharedKeyMap::Close()
+{
+    if (mapped) {
+        munmap(mapped, RegionSize());
+        mapped = NULL;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    hdr = NULL;
+    slots = NULL;
+}
+
+void SharedKeyMap::LockForWrite()
+{
+    if (fd >= 0) {
+        flock(fd, LOCK_EX);
+    }
+}
+
+void SharedKeyMap::UnlockForWrite()
+{
+    if (fd >= 0) {
+        flock(fd, LOCK_UN);
+    }
+}
+
+#else
+
+QStatus SharedKeyMap::Open(const qcc::String& fileName, const qcc::GUID128& owner)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+void SharedKeyMap::Close()
+{
+    hdr = NULL;
+    slots = NULL;
+}
+
+void SharedKeyMap::LockForWrite()
+{
+}
+
+void SharedKeyMap::UnlockForWrite()
+{
+}
+
+#endif
+
+QStatus SharedKeyMap::ReadSlot(uint32_t slot, uint32_t& version, qcc::GUID128& guid, bool& deleted, std::vector<uint8_t>& record) const
+{
+    const Slot& s = slots[slot];
+    for (uint32_t tries = 0; tries < READ_TRIES; ++tries) {
+        uint32_t v = s.version;
+        if (v == 0) {
+            return ER_BUS_KEY_UNAVAILABLE;
+        }
+        if (v & 1) {
+            if (tries >= SPIN_TRIES) {
+                qcc::Sleep(1);
+            }
+            continue;
+        }
+        /* Do not read the slot before seeing the version that published it */
+        FullBarrier();
+        uint32_t flags = s.flags;
+        guid.SetBytes(s.guid);
+        /* Never trust the length further than the slot, whatever another process wrote */
+        uint32_t len = (s.len < MAX_RECORD) ? s.len : MAX_RECORD;
+        record.assign(s.record, s.record + ((flags & SLOT_DELETED) ? 0 : len));
+        /* Finish copying before checking that nobody wrote the slot meanwhile */
+        FullBarrier();
+        if (s.version == v) {
+            version = v;
+            deleted = (flags & SLOT_DELETED) != 0;
+            return ER_OK;
+        }
+    }
+    return ER_TIMEOUT;
+}
+
+QStatus SharedKeyMap::FindSlot(const qcc::GUID128& guid, uint32_t& slot)
+{
+    if (!IsUsable()) {
+        return ER_BUS_KEYSTORE_NOT_LOADED;
+    }
+    uint32_t start = HashGuid(guid);
+    uint32_t tombstone = NUM_SLOTS;
+    for (uint32_t i = 0; i < NUM_SLOTS; ++i) {
+        uint32_t s = (start + i) % NUM_SLOTS;
+        uint32_t flags = slots[s].flags;
+        if (!(flags & SLOT_USED)) {
+            /* The key is not in the map, a tombstone earlier in the chain is reused */
+            slot = (tombstone < NUM_SLOTS) ? tombstone : s;
+            return ER_OK;
+        }
+        if (memcmp(slots[s].guid, guid.GetBytes(), GUID128::SIZE) == 0) {
+            slot = s;
+            return ER_OK;
+        }
+        if ((flags & SLOT_DELETED) && (tombstone == NUM_SLOTS)) {
+            tombstone = s;
+        }
+    }
+    if (tombstone < NUM_SLOTS) {
+        slot = tombstone;
+        return ER_OK;
+    }
+    SetOverflowed();
+    return ER_RESOURCES;
+}
+
+uint32_t SharedKeyMap::WriteSlot(uint32_t slot, const qcc::GUID128& guid, const uint8_t* record, size_t len)
+{
+    if (record && (len > MAX_RECORD)) {
+        SetOverflowed();
+        return 0;
+    }
+    Slot& s = slots[slot];
+    /* A writer that died while holding the slot left the version odd, carry on from there */
+    uint32_t locked = s.version | 1;
+    s.version = locked;
+    FullBarrier();
+    s.flags = SLOT_USED | (record ? 0 : SLOT_DELETED);
+    memcpy(s.guid, guid.GetBytes(), GUID128::SIZE);
+    s.len = record ? static_cast<uint32_t>(len) : 0;
+    if (record) {
+        memcpy(s.record, record, len);
+    }
+    /* The record must be complete before the version that publishes it */
+    FullBarrier();
+    s.version = locked + 1;
+    hdr->changeCount = hdr->changeCount + 1;
+    FullBarrier();
+    return locked + 1;
+}
+
+uint32_t SharedKeyMap::ReserveRevision(uint32_t revision)
+{
+    if (!hdr) {
+        return revision + 1;
+    }
+    LockForWrite();
+    uint32_t r = ((hdr->fileRevision > revision) ? hdr->fileRevision : revision) + 1;
+    hdr->fileRevision = r;
+    FullBarrier();
+    UnlockForWrite();
+    return r;
+}
+
+void SharedKeyMap::SetOverflowed()
+{
+    if (hdr && !hdr->overflowed) {
+        QCC_DbgHLPrintf(("Shared key map overflowed, falling back to reloading the key store"));
+        hdr->overflowed = 1;
+        hdr->changeCount = hdr->changeCount + 1;
+        FullBarrier();
+    }
+}
+
+}
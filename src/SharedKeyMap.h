@@ -0,0 +1,260 @@
+#ifndef _ALLJOYN_SHAREDKEYMAP_H
+#define _ALLJOYN_SHAREDKEYMAP_H
+/**
+ * @file
+ * SharedKeyMap publishes key store records to the other processes that share a key store.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include SharedKeyMap.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/GUID.h>
+#include <qcc/String.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * A shared key store is normally kept coherent through its file: every change is followed by a
+ * reload that reads and decrypts the whole file in every process. A SharedKeyMap is a region of
+ * shared memory, normally a file mapped by all of the processes, with one slot per key. A
+ * process that changes a key writes the encrypted record to the key's slot and the others copy
+ * just the slots whose version changed since they last looked.
+ *
+ * Each slot is a sequence lock: its version is odd while it is being written and increases by
+ * two with every write. Readers take no lock, they copy a slot and retry if the version changed
+ * underneath them. Writers are serialized with LockForWrite(), which locks the mapped file so
+ * writers in different processes exclude each other. Slots are found by hashing the GUID and
+ * probing linearly. A deleted key leaves a tombstone so other processes see the deletion, the
+ * tombstone is reused by a later key. When the map is full it is marked overflowed and the key
+ * store falls back to reloading the file.
+ *
+ * The map holds records already encrypted by the key store so it never sees a key in the clear.
+ * Every Init() picks a new random epoch, slot versions start again from 0 in a reinitialized map
+ * so the key store includes the epoch in its nonces.
+ */
+class SharedKeyMap {
+  public:
+
+    /** Number of slots, the most keys the map can hold */
+    static const uint32_t NUM_SLOTS = 256;
+
+    /** Largest record in bytes */
+    static const uint32_t MAX_RECORD = 1024;
+
+    /**
+     * @return  The number of bytes of shared memory a map uses.
+     */
+    static size_t RegionSize() { return sizeof(Header) + NUM_SLOTS * sizeof(Slot); }
+
+    /**
+     * Constructor. The map is not usable until Init(), Attach() or Open() succeeds.
+     */
+    SharedKeyMap() : hdr(NULL), slots(NULL), fd(-1), mapped(NULL) { }
+
+    /**
+     * Destructor, unmaps a map opened with Open().
+     */
+    ~SharedKeyMap() { Close(); }
+
+    /**
+     * Initialize a new, empty map in a region.
+     *
+     * @param region  Memory of at least RegionSize() bytes.
+     * @param owner   GUID of the key store the map belongs to.
+     *
+     * @return  true if the map was initialized, false if there is no region or no random epoch.
+     */
+    bool Init(void* region, const qcc::GUID128& owner);
+
+    /**
+     * Attach to a map initialized by another process.
+     *
+     * @param region     The region.
+     * @param regionLen  Size of the region in bytes.
+     * @param owner      GUID of the key store, a map that belongs to another key store is rejected.
+     *
+     * @return  true if the region holds a map for this key store.
+     */
+    bool Attach(void* region, size_t regionLen, const qcc::GUID128& owner);
+
+    /**
+     * Map a file shared by the processes using a key store, creating and initializing it if needed.
+     * Only supported on POSIX platforms.
+     *
+     * @param fileName  The file to map.
+     * @param owner     GUID of the key store, a file left by another key store is reinitialized.
+     *
+     * @return
+     *      - #ER_OK if the map is usable.
+     *      - #ER_NOT_IMPLEMENTED on platforms without shared file mappings.
+     *      - #ER_OS_ERROR if the file could not be opened or mapped.
+     *      - #ER_CRYPTO_ERROR if a new map could not be given a random epoch.
+     */
+    QStatus Open(const qcc::String& fileName, const qcc::GUID128& owner);
+
+    /**
+     * Stop using the map and unmap it if it was opened with Open().
+     */
+    void Close();
+
+    /**
+     * @return  true if the map can be used, false if not set up or it overflowed.
+     */
+    bool IsUsable() const { return hdr && !hdr->overflowed; }
+
+    /**
+     * @return  A counter incremented by every write, readers that see the same value have nothing to copy.
+     */
+    uint32_t GetChangeCount() const { return hdr ? hdr->changeCount : 0; }
+
+    /**
+     * @return  The random value chosen when the map was initialized, 0 if the map is not set up.
+     */
+    uint64_t GetEpoch() const { return hdr ? hdr->epoch : 0; }
+
+    /**
+     * Get the version of a slot without copying it.
+     *
+     * @param slot  Slot index less than NUM_SLOTS.
+     *
+     * @return  The version, 0 if the slot was never written.
+     */
+    uint32_t GetVersion(uint32_t slot) const { return slots[slot].version; }
+
+    /**
+     * Get the version the next WriteSlot() of a slot will give it, so a record can be encrypted
+     * with a nonce that is never used twice. Must be called holding the write lock.
+     *
+     * @param slot  Slot index less than NUM_SLOTS.
+     *
+     * @return  The version of the slot after the next write.
+     */
+    uint32_t GetNextVersion(uint32_t slot) const { return (slots[slot].version | 1) + 1; }
+
+    /**
+     * Copy a slot. Lock free, retries while the slot is being written.
+     *
+     * @param slot          Slot index less than NUM_SLOTS.
+     * @param[out] version  The version of the copy.
+     * @param[out] guid     The GUID of the key.
+     * @param[out] deleted  true if the slot is a tombstone.
+     * @param[out] record   The encrypted record, empty for a tombstone.
+     *
+     * @return
+     *      - #ER_OK if the slot was copied.
+     *      - #ER_BUS_KEY_UNAVAILABLE if the slot was never written.
+     *      - #ER_TIMEOUT if the slot stayed locked, a writer may have died while writing it.
+     */
+    QStatus ReadSlot(uint32_t slot, uint32_t& version, qcc::GUID128& guid, bool& deleted, std::vector<uint8_t>& record) const;
+
+    /**
+     * Lock the map against other writers. Readers are not held up.
+     */
+    void LockForWrite();
+
+    /**
+     * Release the lock taken by LockForWrite().
+     */
+    void UnlockForWrite();
+
+    /**
+     * Find the slot to write a key to. Must be called holding the write lock.
+     *
+     * @param guid        The GUID of the key.
+     * @param[out] slot   The slot the key is in, or the slot to add it to.
+     *
+     * @return
+     *      - #ER_OK if a slot was found.
+     *      - #ER_BUS_KEYSTORE_NOT_LOADED if the map is not usable.
+     *      - #ER_RESOURCES if the map is full, it is marked overflowed.
+     */
+    QStatus FindSlot(const qcc::GUID128& guid, uint32_t& slot);
+
+    /**
+     * Write a slot. Must be called holding the write lock.
+     *
+     * @param slot     The slot returned by FindSlot().
+     * @param guid     The GUID of the key.
+     * @param record   The encrypted record, NULL for a tombstone.
+     * @param len      Length of the record, at most MAX_RECORD.
+     *
+     * @return  The new version of the slot, the one GetNextVersion() returned, or 0 if the record
+     *          is too long and the map was marked overflowed.
+     */
+    uint32_t WriteSlot(uint32_t slot, const qcc::GUID128& guid, const uint8_t* record, size_t len);
+
+    /**
+     * Mark the map overflowed so every process goes back to reloading the key store file.
+     */
+    void SetOverflowed();
+
+    /**
+     * Reserve a revision for storing the key store file. The file is encrypted with its revision
+     * as the nonce, processes that no longer reload the file before storing it take their
+     * revisions from here so no two stores use the same one. Takes the write lock.
+     *
+     * @param revision  The revision of the key store in the calling process.
+     *
+     * @return  A revision greater than revision and than any reserved before.
+     */
+    uint32_t ReserveRevision(uint32_t revision);
+
+  private:
+
+    /* Copy constructor and assignment are not allowed */
+    SharedKeyMap(const SharedKeyMap& other);
+    SharedKeyMap& operator=(const SharedKeyMap& other);
+
+    /** Map header at the start of the region */
+    struct Header {
+        uint32_t magic;                    /**< Identifies an initialized map */
+        uint32_t numSlots;                 /**< NUM_SLOTS of the process that created the map */
+        uint32_t maxRecord;                /**< MAX_RECORD of the process that created the map */
+        volatile uint32_t overflowed;      /**< Set when a key did not fit */
+        volatile uint32_t changeCount;     /**< Incremented by every write */
+        volatile uint32_t fileRevision;    /**< Last revision returned by ReserveRevision() */
+        uint64_t epoch;                    /**< Random value chosen by Init() */
+        uint8_t owner[qcc::GUID128::SIZE]; /**< GUID of the key store */
+    };
+
+    /** One key */
+    struct Slot {
+        volatile uint32_t version;        /**< Sequence lock, odd while being written */
+        uint32_t flags;                   /**< SLOT_USED and SLOT_DELETED */
+        uint8_t guid[qcc::GUID128::SIZE]; /**< GUID of the key */
+        uint32_t len;                     /**< Length of the encrypted record */
+        uint8_t record[MAX_RECORD];       /**< The encrypted record */
+    };
+
+    Header* hdr;
+    Slot* slots;
+    int fd;          /**< Descriptor of the mapped file, -1 if not opened with Open() */
+    void* mapped;    /**< Mapping created by Open() */
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file
+ * Single producer, single consumer byte ring in memory shared between two processes.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <algorithm>
+
+#include <qcc/atomic.h>
+
+#include "ShmRing.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+/*
+ * The atomic increment is a full memory barrier on every platform we build for. The counter
+ * itself is private to this process, only the ordering matters.
+ */
+static volatile int32_t barrierCount = 0;
+
+static inline void FullBarrier()
+{
+    IncrementAndFetch(&barrierCount);
+}
+
+static inline bool IsPowerOfTwo(uint32_t n)
+{
+    return (n != 0) && ((n & (n - 1)) == 0);
+}
+
+bool ShmRing::Init(void* region, uint32_t capacity)
+{
+    if (!region || !IsPowerOfTwo(capacity) || (capacity < MIN_CAPACITY)) {
+        return false;
+    }
+    hdr = reinterpret_cast<Header*>(region);
+    memset(hdr, 0, sizeof(Header));
+    hdr->capacity = capacity;
+    data = reinterpret_cast<uint8_t*>(region) + sizeof(Header);
+    mask = capacity - 1;
+    return true;
+}
+
+bool ShmRing::Attach(void* region, size_t regionLen)
+{
+    if (!region || (regionLen < sizeof(Header))) {
+        return false;
+    }
+    Header* h = reinterpret_cast<Header*>(region);
+    /* Read the capacity once, the peer could change it afterwards */
+    uint32_t capacity = h->capacity;
+    if (!IsPowerOfTwo(capacity) || (capacity < MIN_CAPACITY) || (RegionSize(capacity) > regionLen)) {
+        return false;
+    }
+    hdr = h;
+    data = reinterpret_cast<uint8_t*>(region) + sizeof(Header);
+    mask = capacity - 1;
+    return true;
+}
+
+size_t ShmRing::Readable() const
+{
+    uint32_t avail = hdr->writePos - hdr->readPos;
+    /* Never trust more than a capacity's worth, whatever the peer wrote to the header */
+    return (std::min)(avail, mask + 1);
+}
+
+size_t ShmRing::Writable() const
+{
+    uint32_t used = hdr->writePos - hdr->readPos;
+    return (used >= mask + 1) ? 0 : (mask + 1) - used;
+}
+
+size_t ShmRing::Write(const void* buf, size_t len)
+{
+    uint32_t pos = hdr->writePos;
+    size_t n = (std::min)(len, Writable());
+    if (n > 0) {
+        size_t off = pos & mask;
+        size_t first = (std::min)(n, static_cast<size_t>(mask + 1) - off);
+        memcpy(data + off, buf, first);
+        memcpy(data, reinterpret_cast<const uint8_t*>(buf) + first, n - first);
+        /* The bytes must be visible before the position that publishes them */
+        FullBarrier();
+        hdr->writePos = pos + static_cast<uint32_t>(n);
+    }
+    return n;
+}
+
+size_t ShmRing::Read(void* buf, size_t len)
+{
+    uint32_t pos = hdr->readPos;
+    size_t n = (std::min)(len, Readable());
+    if (n > 0) {
+        /* Do not read the bytes before seeing the position that published them */
+        FullBarrier();
+        size_t off = pos & mask;
+        size_t first = (std::min)(n, static_cast<size_t>(mask + 1) - off);
+        memcpy(buf, data + off, first);
+        memcpy(reinterpret_cast<uint8_t*>(buf) + first, data, n - first);
+        /* Finish reading the bytes before giving the space back */
+        FullBarrier();
+        hdr->readPos = pos + static_cast<uint32_t>(n);
+    }
+    return n;
+}
+
+bool ShmRing::ReaderShouldWait()
+{
+    hdr->readerWaiting = 1;
+    FullBarrier();
+    if ((Readable() > 0) || IsClosed()) {
+        hdr->readerWaiting = 0;
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::WriterShouldWake()
+{
+    FullBarrier();
+    if (hdr->readerWaiting) {
+        hdr->readerWaiting = 0;
+        return true;
+    }
+    return false;
+}
+
+bool ShmRing::WriterShouldWait()
+{
+    hdr->writerWaiting = 1;
+    FullBarrier();
+    if ((Writable() > 0) || IsClosed()) {
+        hdr->writerWaiting = 0;
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::ReaderShouldWake()
+{
+    FullBarrier();
+    if (hdr->writerWaiting) {
+        hdr->writerWaiting = 0;
+        return true;
+    }
+    return false;
+}
+
+void ShmRing::Close()
+{
+    if (hdr) {
+        hdr->closed = 1;
+        FullBarrier();
+    }
+}
+
+}
@@ -0,0 +1,187 @@
+#ifndef _ALLJOYN_SHMRING_H
+#define _ALLJOYN_SHMRING_H
+/**
+ * @file
+ * Single producer, single consumer byte ring in memory shared between two processes.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include ShmRing.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+namespace ajn {
+
+/**
+ * ShmRing is a byte ring with one writer and one reader that may be in different processes. The
+ * ring does no waiting itself. Instead it keeps two "wanted" flags so the two sides can tell
+ * when the other one is about to sleep and needs a wakeup:
+ *
+ * - A reader that finds the ring empty calls ReaderShouldWait(). If it returns true the reader
+ *   may sleep until woken. A writer calls WriterShouldWake() after every Write() and wakes the
+ *   reader if it returns true.
+ * - The same applies in the other direction with WriterShouldWait() and ReaderShouldWake().
+ *
+ * Each side sets its flag before checking the ring, and the other side updates the ring before
+ * checking the flag, with a full barrier in between. So a wakeup cannot be lost and there is no
+ * system call at all while both sides are busy.
+ */
+class ShmRing {
+  public:
+
+    /** Smallest ring capacity */
+    static const uint32_t MIN_CAPACITY = 4096;
+
+    /**
+     * Get the size of the shared memory needed for a ring.
+     *
+     * @param capacity  Ring capacity in bytes, must be a power of two.
+     *
+     * @return  The number of bytes of shared memory the ring uses.
+     */
+    static size_t RegionSize(uint32_t capacity) { return sizeof(Header) + capacity; }
+
+    /**
+     * Constructor. The ring is not usable until Init() or Attach() is called.
+     */
+    ShmRing() : hdr(NULL), data(NULL), mask(0) { }
+
+    /**
+     * Initialize a new ring in a shared memory region. Called by the side that creates the region.
+     *
+     * @param region    Shared memory of at least RegionSize(capacity) bytes.
+     * @param capacity  Ring capacity in bytes, must be a power of two and at least MIN_CAPACITY.
+     *
+     * @return  true if the ring was initialized.
+     */
+    bool Init(void* region, uint32_t capacity);
+
+    /**
+     * Attach to a ring initialized by the other side. The header is checked against the size of
+     * the region so a misbehaving peer cannot make us read or write outside it.
+     *
+     * @param region     The shared memory region.
+     * @param regionLen  Size of the region in bytes.
+     *
+     * @return  true if the region holds a valid ring.
+     */
+    bool Attach(void* region, size_t regionLen);
+
+    /**
+     * Copy bytes into the ring.
+     *
+     * @param buf   The bytes to write.
+     * @param len   Number of bytes to write.
+     *
+     * @return  Number of bytes written, less than len if the ring filled up.
+     */
+    size_t Write(const void* buf, size_t len);
+
+    /**
+     * Copy bytes out of the ring.
+     *
+     * @param buf   Buffer to read into.
+     * @param len   Maximum number of bytes to read.
+     *
+     * @return  Number of bytes read, 0 if the ring is empty.
+     */
+    size_t Read(void* buf, size_t len);
+
+    /**
+     * @return  Number of bytes available to read.
+     */
+    size_t Readable() const;
+
+    /**
+     * @return  Number of bytes that can be written without overwriting unread bytes.
+     */
+    size_t Writable() const;
+
+    /**
+     * Called by a reader that found the ring empty.
+     *
+     * @return  true if the ring is still empty and the reader must wait for a wakeup,
+     *          false if bytes arrived in the meantime.
+     */
+    bool ReaderShouldWait();
+
+    /**
+     * Called by a writer after writing.
+     *
+     * @return  true if the reader is waiting and must be woken up.
+     */
+    bool WriterShouldWake();
+
+    /**
+     * Called by a writer that found the ring full.
+     *
+     * @return  true if the ring is still full and the writer must wait for a wakeup,
+     *          false if space was freed in the meantime.
+     */
+    bool WriterShouldWait();
+
+    /**
+     * Called by a reader after reading.
+     *
+     * @return  true if the writer is waiting for space and must be woken up.
+     */
+    bool ReaderShouldWake();
+
+    /**
+     * Mark the ring as closed. Either side may close the ring.
+     */
+    void Close();
+
+    /**
+     * @return  true if either side has closed the ring.
+     */
+    bool IsClosed() const { return hdr ? (hdr->closed != 0) : true; }
+
+    /**
+     * @return  The ring capacity in bytes, 0 if not initialized.
+     */
+    uint32_t GetCapacity() const { return hdr ? mask + 1 : 0; }
+
+  private:
+
+    /**
+     * Ring header at the start of the shared region. The write and read positions are on
+     * different cache lines so the two sides do not contend for them. Positions increase forever
+     * and wrap naturally at 2^32.
+     */
+    struct Header {
+        volatile uint32_t writePos;     /**< Total bytes written, only changed by the writer */
+        uint8_t pad0[60];
+        volatile uint32_t readPos;      /**< Total bytes read, only changed by the reader */
+        uint8_t pad1[60];
+        volatile uint32_t readerWaiting; /**< Reader is waiting for bytes */
+        volatile uint32_t writerWaiting; /**< Writer is waiting for space */
+        volatile uint32_t closed;       /**< Set when either side closes */
+        uint32_t capacity;              /**< Capacity of the data area, a power of two */
+    };
+
+    Header* hdr;
+    uint8_t* data;
+    uint32_t mask;
+};
+
+}
+
+#endif
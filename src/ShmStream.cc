@@ -0,0 +1,651 @@
+/**
+ * @file
+ * ShmStream carries the bytes of a local connection through a pair of shared memory rings
+ * instead of a socket.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <vector>
+
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+#include <qcc/Debug.h>
+#include <qcc/Event.h>
+#include <qcc/Socket.h>
+#include <qcc/Util.h>
+
+#include "ShmStream.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+#if (defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)) && defined(__NR_memfd_create)
+#define SHM_STREAM_SUPPORTED 1
+#endif
+
+#if defined(SHM_STREAM_SUPPORTED)
+
+/* Older C libraries do not have these yet */
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS (1024 + 9)
+#define F_GET_SEALS (1024 + 10)
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL   0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW   0x0004
+#endif
+
+static const uint32_t SHM_MAGIC = 0x4d48534a;    /**< "JSHM" */
+static const uint16_t SHM_VERSION = 1;
+
+static const char SHM_ACCEPT = 'A';
+static const char SHM_DECLINE = 'D';
+
+static const int SEALS = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+/* The memfd followed by the data and space doorbells of ring A and then of ring B */
+static const size_t NUM_OFFER_FDS = 5;
+
+/*
+ * The offer sent by the client. A ringSize of 0 offers no shared memory, the client sends one
+ * when it could not set up the region but still needs to hand over its credentials.
+ */
+struct ShmOffer {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t ringSize;
+    uint32_t regionLen;
+};
+
+/*
+ * Ring A carries client to daemon traffic and starts at the beginning of the region. Ring B
+ * follows it on a cache line boundary.
+ */
+static size_t RingBOffset(uint32_t ringSize)
+{
+    return (ShmRing::RegionSize(ringSize) + 63) & ~static_cast<size_t>(63);
+}
+
+static size_t RegionLength(uint32_t ringSize)
+{
+    return RingBOffset(ringSize) + ShmRing::RegionSize(ringSize);
+}
+
+static void Ring(int fd)
+{
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) != static_cast<ssize_t>(sizeof(one))) {
+        QCC_DbgHLPrintf(("ShmStream: doorbell write failed: %s", strerror(errno)));
+    }
+}
+
+static void Drain(int fd)
+{
+    /* Reading resets the counter, it fails with EAGAIN if the doorbell was not rung */
+    uint64_t count;
+    while ((read(fd, &count, sizeof(count)) == -1) && (errno == EINTR)) {
+    }
+}
+
+static void CloseFd(int& fd)
+{
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/*
+ * After the rings are attached nothing more is sent on the socket, so anything readable on it
+ * means the peer has closed or is misbehaving. Either way the connection is over.
+ */
+static bool PeerGone(SocketFd sock)
+{
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN | POLLRDHUP;
+    pfd.revents = 0;
+    return (poll(&pfd, 1, 0) != 0);
+}
+
+bool ShmStream::IsSupported()
+{
+    return true;
+}
+
+ShmStream::ShmStream(SocketFd sock) :
+    sock(sock),
+    memFd(-1),
+    region(NULL),
+    regionLen(0),
+    txDataFd(-1),
+    txSpaceFd(-1),
+    rxDataFd(-1),
+    rxSpaceFd(-1),
+    pollFd(-1),
+    sourceEvent(NULL),
+    sinkEvent(NULL),
+    sendTimeout(Event::WAIT_FOREVER)
+{
+}
+
+ShmStream::~ShmStream()
+{
+    Close();
+    Release();
+    if (sock != -1) {
+        qcc::Close(sock);
+    }
+}
+
+static void ReleaseFds(int* fds, size_t numFds)
+{
+    for (size_t i = 0; i < numFds; ++i) {
+        CloseFd(fds[i]);
+    }
+}
+
+void ShmStream::Release()
+{
+    delete sourceEvent;
+    delete sinkEvent;
+    sourceEvent = sinkEvent = NULL;
+    if (region) {
+        munmap(region, regionLen);
+        region = NULL;
+    }
+    CloseFd(memFd);
+    CloseFd(txDataFd);
+    CloseFd(txSpaceFd);
+    CloseFd(rxDataFd);
+    CloseFd(rxSpaceFd);
+    CloseFd(pollFd);
+}
+
+QStatus ShmStream::Attach(bool creator, uint32_t ringSize)
+{
+    region = mmap(NULL, regionLen, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (region == MAP_FAILED) {
+        region = NULL;
+        QCC_LogError(ER_OS_ERROR, ("ShmStream::Attach(): mmap failed: %s", strerror(errno)));
+        return ER_OS_ERROR;
+    }
+    uint8_t* ringA = reinterpret_cast<uint8_t*>(region);
+    uint8_t* ringB = ringA + RingBOffset(ringSize);
+    size_t ringBLen = regionLen - RingBOffset(ringSize);
+    bool ok;
+    if (creator) {
+        ok = txRing.Init(ringA, ringSize) && rxRing.Init(ringB, ringSize);
+    } else {
+        ok = rxRing.Attach(ringA, RingBOffset(ringSize)) && txRing.Attach(ringB, ringBLen) &&
+             (rxRing.GetCapacity() == ringSize) && (txRing.GetCapacity() == ringSize);
+    }
+    if (!ok) {
+        QCC_LogError(ER_BUS_BAD_VALUE, ("ShmStream::Attach(): Invalid ring header"));
+        return ER_BUS_BAD_VALUE;
+    }
+
+    pollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (pollFd == -1) {
+        QCC_LogError(ER_OS_ERROR, ("ShmStream::Attach(): epoll_create1 failed: %s", strerror(errno)));
+        return ER_OS_ERROR;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = rxDataFd;
+    int ret = epoll_ctl(pollFd, EPOLL_CTL_ADD, rxDataFd, &ev);
+    if (ret == 0) {
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = sock;
+        ret = epoll_ctl(pollFd, EPOLL_CTL_ADD, sock, &ev);
+    }
+    if (ret != 0) {
+        QCC_LogError(ER_OS_ERROR, ("ShmStream::Attach(): epoll_ctl failed: %s", strerror(errno)));
+        return ER_OS_ERROR;
+    }
+    sourceEvent = new Event(pollFd, Event::IO_READ, false);
+    sinkEvent = new Event(txSpaceFd, Event::IO_READ, false);
+    return ER_OK;
+}
+
+QStatus ShmStream::Offer(uint32_t ringSize, uint32_t timeout)
+{
+    uint32_t cap = ShmRing::MIN_CAPACITY;
+    while ((cap < ringSize) && (cap < MAX_RING_SIZE)) {
+        cap <<= 1;
+    }
+    regionLen = RegionLength(cap);
+
+    /*
+     * The region is sealed against resizing so the daemon can map it without the risk of the
+     * client truncating it later and faulting the daemon.
+     */
+    QStatus status = ER_OK;
+    memFd = static_cast<int>(syscall(__NR_memfd_create, "alljoyn-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if ((memFd == -1) || (ftruncate(memFd, regionLen) != 0) || (fcntl(memFd, F_ADD_SEALS, SEALS) != 0)) {
+        QCC_DbgHLPrintf(("ShmStream::Offer(): shared memory region not available: %s", strerror(errno)));
+        status = ER_BUS_TRANSPORT_NOT_AVAILABLE;
+    }
+    int* doorbells[] = { &txDataFd, &txSpaceFd, &rxDataFd, &rxSpaceFd };
+    for (size_t i = 0; (status == ER_OK) && (i < ArraySize(doorbells)); ++i) {
+        *doorbells[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (*doorbells[i] == -1) {
+            status = ER_BUS_TRANSPORT_NOT_AVAILABLE;
+        }
+    }
+    if ((status == ER_OK) && (Attach(true, cap) != ER_OK)) {
+        status = ER_BUS_TRANSPORT_NOT_AVAILABLE;
+    }
+    if (status != ER_OK) {
+        Release();
+    }
+    int fds[NUM_OFFER_FDS] = { memFd, txDataFd, txSpaceFd, rxDataFd, rxSpaceFd };
+
+    /*
+     * The offer also carries our credentials, it takes the place of the credentials message
+     * sent on an ordinary unix transport connection.
+     */
+    struct ShmOffer offer;
+    offer.magic = SHM_MAGIC;
+    offer.version = SHM_VERSION;
+    offer.reserved = 0;
+    offer.ringSize = (status == ER_OK) ? cap : 0;
+    offer.regionLen = (status == ER_OK) ? static_cast<uint32_t>(regionLen) : 0;
+
+    struct iovec iov[] = { { &offer, sizeof(offer) } };
+    char cbuf[CMSG_SPACE(sizeof(struct ucred)) + CMSG_SPACE(sizeof(fds))];
+    memset(cbuf, 0, sizeof(cbuf));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = ArraySize(iov);
+    msg.msg_control = cbuf;
+    msg.msg_controllen = (status == ER_OK) ? sizeof(cbuf) : CMSG_SPACE(sizeof(struct ucred));
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_CREDENTIALS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct ucred));
+    struct ucred* cred = reinterpret_cast<struct ucred*>(CMSG_DATA(cmsg));
+    cred->uid = getuid();
+    cred->gid = getgid();
+    cred->pid = getpid();
+    if (status == ER_OK) {
+        cmsg = CMSG_NXTHDR(&msg, cmsg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    }
+
+    if (sendmsg(sock, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(offer))) {
+        QCC_LogError(ER_OS_ERROR, ("ShmStream::Offer(): sendmsg failed: %s", strerror(errno)));
+        qcc::Close(sock);
+        sock = -1;
+        return ER_OS_ERROR;
+    }
+
+    char reply = 0;
+    Event replyEvent(sock, Event::IO_READ, false);
+    QStatus waitStatus = Event::Wait(replyEvent, timeout);
+    if ((waitStatus != ER_OK) || (recv(sock, &reply, 1, 0) != 1) || ((reply != SHM_ACCEPT) && (reply != SHM_DECLINE))) {
+        status = (waitStatus != ER_OK) ? waitStatus : ER_READ_ERROR;
+        QCC_LogError(status, ("ShmStream::Offer(): No answer to the offer"));
+        qcc::Close(sock);
+        sock = -1;
+        return status;
+    }
+    if ((status == ER_OK) && (reply == SHM_DECLINE)) {
+        QCC_DbgHLPrintf(("ShmStream::Offer(): Shared memory declined"));
+        Release();
+        status = ER_BUS_TRANSPORT_NOT_AVAILABLE;
+    }
+    return status;
+}
+
+QStatus ShmStream::Accept(uint32_t& uid, uint32_t& gid, uint32_t& pid, uint32_t timeout)
+{
+    int enableCred = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_PASSCRED, &enableCred, sizeof(enableCred)) == -1) {
+        qcc::Close(sock);
+        sock = -1;
+        return ER_OS_ERROR;
+    }
+
+    struct ShmOffer offer;
+    memset(&offer, 0, sizeof(offer));
+    struct iovec iov[] = { { &offer, sizeof(offer) } };
+    char cbuf[CMSG_SPACE(sizeof(struct ucred)) + CMSG_SPACE(NUM_OFFER_FDS * sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = ArraySize(iov);
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    QStatus status = ER_OK;
+    ssize_t ret;
+    while (true) {
+        ret = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+        if ((ret == -1) && (errno == EWOULDBLOCK)) {
+            Event event(sock, Event::IO_READ, false);
+            status = Event::Wait(event, timeout);
+            if (status != ER_OK) {
+                QCC_LogError(status, ("ShmStream::Accept(): Offer timeout"));
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+
+    int disableCred = 0;
+    setsockopt(sock, SOL_SOCKET, SO_PASSCRED, &disableCred, sizeof(disableCred));
+
+    /* Collect whatever came with the message so nothing leaks on the way out */
+    bool haveCreds = false;
+    int fds[NUM_OFFER_FDS] = { -1, -1, -1, -1, -1 };
+    size_t numFds = 0;
+    bool extraFds = false;
+    if ((status == ER_OK) && (ret > 0)) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET) {
+                continue;
+            }
+            if (cmsg->cmsg_type == SCM_CREDENTIALS) {
+                struct ucred* cred = reinterpret_cast<struct ucred*>(CMSG_DATA(cmsg));
+                uid = cred->uid;
+                gid = cred->gid;
+                pid = cred->pid;
+                haveCreds = true;
+                QCC_DbgHLPrintf(("Received UID: %u  GID: %u  PID %u", cred->uid, cred->gid, cred->pid));
+            } else if (cmsg->cmsg_type == SCM_RIGHTS) {
+                size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const int* rx = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+                for (size_t i = 0; i < n; ++i) {
+                    if (numFds < NUM_OFFER_FDS) {
+                        fds[numFds++] = rx[i];
+                    } else {
+                        close(rx[i]);
+                        extraFds = true;
+                    }
+                }
+            }
+        }
+    }
+
+    if ((status != ER_OK) || (ret != static_cast<ssize_t>(sizeof(offer))) || !haveCreds ||
+        (offer.magic != SHM_MAGIC) || (offer.version != SHM_VERSION)) {
+        ReleaseFds(fds, numFds);
+        qcc::Close(sock);
+        sock = -1;
+        return (status != ER_OK) ? status : ER_READ_ERROR;
+    }
+
+    /*
+     * Everything about the region comes from the client so check all of it before mapping it.
+     * The doorbells are made non-blocking in case the client passed something other than an
+     * eventfd, a doorbell can then misbehave but cannot stall the daemon.
+     */
+    bool ok = (offer.ringSize != 0) && !extraFds && (numFds == NUM_OFFER_FDS) && !(msg.msg_flags & MSG_CTRUNC) &&
+              (offer.ringSize >= ShmRing::MIN_CAPACITY) && (offer.ringSize <= MAX_RING_SIZE) &&
+              ((offer.ringSize & (offer.ringSize - 1)) == 0) && (offer.regionLen == RegionLength(offer.ringSize));
+    if (ok) {
+        struct stat st;
+        ok = (fstat(fds[0], &st) == 0) && S_ISREG(st.st_mode) && (static_cast<size_t>(st.st_size) == offer.regionLen) &&
+             ((fcntl(fds[0], F_GET_SEALS) & SEALS) == SEALS);
+    }
+    for (size_t i = 1; ok && (i < NUM_OFFER_FDS); ++i) {
+        int flags = fcntl(fds[i], F_GETFL);
+        ok = (flags != -1) && (fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) == 0);
+    }
+    if (ok) {
+        memFd = fds[0];
+        rxDataFd = fds[1];
+        rxSpaceFd = fds[2];
+        txDataFd = fds[3];
+        txSpaceFd = fds[4];
+        regionLen = offer.regionLen;
+        ok = (Attach(false, offer.ringSize) == ER_OK);
+        if (!ok) {
+            Release();
+        }
+    } else {
+        ReleaseFds(fds, numFds);
+    }
+    if (!ok) {
+        if (offer.ringSize != 0) {
+            QCC_LogError(ER_BUS_BAD_VALUE, ("ShmStream::Accept(): Declining invalid shared memory offer from pid %u", pid));
+        }
+    }
+
+    char reply = ok ? SHM_ACCEPT : SHM_DECLINE;
+    if (send(sock, &reply, 1, MSG_NOSIGNAL) != 1) {
+        qcc::Close(sock);
+        sock = -1;
+        return ER_OS_ERROR;
+    }
+    return ok ? ER_OK : ER_BUS_TRANSPORT_NOT_AVAILABLE;
+}
+
+QStatus ShmStream::PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    if (!region) {
+        return ER_INIT_FAILED;
+    }
+    while (true) {
+        actualBytes = rxRing.Read(buf, reqBytes);
+        if ((actualBytes > 0) || (reqBytes == 0)) {
+            if (rxRing.ReaderShouldWake()) {
+                Ring(rxSpaceFd);
+            }
+            return ER_OK;
+        }
+        if (rxRing.IsClosed() || PeerGone(sock)) {
+            return ER_SOCK_OTHER_END_CLOSED;
+        }
+        /* Drain before checking so a wakeup rung after the check is not lost */
+        Drain(rxDataFd);
+        if (!rxRing.ReaderShouldWait()) {
+            continue;
+        }
+        if (timeout == 0) {
+            return ER_TIMEOUT;
+        }
+        QStatus status = Event::Wait(*sourceEvent, timeout);
+        if (status != ER_OK) {
+            return status;
+        }
+    }
+}
+
+QStatus ShmStream::PullBytesAndFds(void* buf, size_t reqBytes, size_t& actualBytes, SocketFd* fdList, size_t& numFds, uint32_t timeout)
+{
+    numFds = 0;
+    return PullBytes(buf, reqBytes, actualBytes, timeout);
+}
+
+QStatus ShmStream::PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+{
+    if (!region) {
+        return ER_INIT_FAILED;
+    }
+    while (true) {
+        numSent = txRing.Write(buf, numBytes);
+        if ((numSent > 0) || (numBytes == 0)) {
+            if (txRing.WriterShouldWake()) {
+                Ring(txDataFd);
+            }
+            return ER_OK;
+        }
+        if (txRing.IsClosed() || PeerGone(sock)) {
+            return ER_SOCK_OTHER_END_CLOSED;
+        }
+        Drain(txSpaceFd);
+        if (!txRing.WriterShouldWait()) {
+            continue;
+        }
+        if (sendTimeout == 0) {
+            return ER_TIMEOUT;
+        }
+        /* Also watch the socket so a blocked writer notices the peer going away */
+        Event closeEvent(sock, Event::IO_READ, false);
+        vector<Event*> checkEvents;
+        vector<Event*> signaledEvents;
+        checkEvents.push_back(sinkEvent);
+        checkEvents.push_back(&closeEvent);
+        QStatus status = Event::Wait(checkEvents, signaledEvents, sendTimeout);
+        if (status != ER_OK) {
+            return status;
+        }
+    }
+}
+
+QStatus ShmStream::PushBytesAndFds(const void* buf, size_t numBytes, size_t& numSent, SocketFd* fdList, size_t numFds, uint32_t pid)
+{
+    if (numFds > 0) {
+        QCC_LogError(ER_NOT_IMPLEMENTED, ("ShmStream::PushBytesAndFds(): Cannot pass handles over shared memory"));
+        return ER_NOT_IMPLEMENTED;
+    }
+    return PushBytes(buf, numBytes, numSent);
+}
+
+SocketFd ShmStream::DetachSocket()
+{
+    SocketFd fd = sock;
+    sock = -1;
+    return fd;
+}
+
+void ShmStream::Close()
+{
+    if (region) {
+        txRing.Close();
+        rxRing.Close();
+        Ring(txDataFd);
+        Ring(rxSpaceFd);
+    }
+    /* Shutting down rather than closing also wakes up our own threads waiting on the socket */
+    if (sock != -1) {
+        shutdown(sock, SHUT_RDWR);
+    }
+}
+
+#else
+
+bool ShmStream::IsSupported()
+{
+    return false;
+}
+
+ShmStream::ShmStream(SocketFd sock) :
+    sock(sock),
+    memFd(-1),
+    region(NULL),
+    regionLen(0),
+    txDataFd(-1),
+    txSpaceFd(-1),
+    rxDataFd(-1),
+    rxSpaceFd(-1),
+    pollFd(-1),
+    sourceEvent(NULL),
+    sinkEvent(NULL),
+    sendTimeout(Event::WAIT_FOREVER)
+{
+}
+
+ShmStream::~ShmStream()
+{
+    if (sock != -1) {
+        qcc::Close(sock);
+    }
+}
+
+QStatus ShmStream::Offer(uint32_t ringSize, uint32_t timeout)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+QStatus ShmStream::Accept(uint32_t& uid, uint32_t& gid, uint32_t& pid, uint32_t timeout)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+SocketFd ShmStream::DetachSocket()
+{
+    SocketFd fd = sock;
+    sock = -1;
+    return fd;
+}
+
+QStatus ShmStream::PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+QStatus ShmStream::PullBytesAndFds(void* buf, size_t reqBytes, size_t& actualBytes, SocketFd* fdList, size_t& numFds, uint32_t timeout)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+QStatus ShmStream::PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+QStatus ShmStream::PushBytesAndFds(const void* buf, size_t numBytes, size_t& numSent, SocketFd* fdList, size_t numFds, uint32_t pid)
+{
+    return ER_NOT_IMPLEMENTED;
+}
+
+void ShmStream::Close()
+{
+}
+
+#endif
+
+}
@@ -0,0 +1,271 @@
+#ifndef _ALLJOYN_SHMSTREAM_H
+#define _ALLJOYN_SHMSTREAM_H
+/**
+ * @file
+ * ShmStream carries the bytes of a local connection through a pair of shared memory rings
+ * instead of a socket.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include ShmStream.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/Event.h>
+#include <qcc/Socket.h>
+#include <qcc/Stream.h>
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+
+#include "RemoteEndpoint.h"
+#include "ShmRing.h"
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * ShmStream is set up over a connected AF_UNIX socket. The client creates a sealed shared memory
+ * region holding one ring per direction and four eventfd doorbells and offers them, together
+ * with its credentials, in a single message on the socket. The daemon either attaches to the
+ * region or declines, in which case both sides keep using the socket as an ordinary unix
+ * transport connection.
+ *
+ * Once attached the socket carries no more data. The daemon watches it only to notice that the
+ * client has gone away. A wakeup costs a write to an eventfd and is only needed when the other
+ * side is idle, so a busy connection moves messages without any system calls.
+ *
+ * Unix file descriptors cannot be passed over the rings, so the transports turn handle passing
+ * off on an endpoint once its shared memory connection is established.
+ */
+class ShmStream : public qcc::Stream {
+  public:
+
+    /** Default size of each of the two rings */
+    static const uint32_t DEFAULT_RING_SIZE = 1024 * 1024;
+
+    /** Largest ring size a peer may offer */
+    static const uint32_t MAX_RING_SIZE = 64 * 1024 * 1024;
+
+    /**
+     * Check if shared memory connections are supported on this platform.
+     */
+    static bool IsSupported();
+
+    /**
+     * Constructor
+     *
+     * @param sock   The connected socket used for the offer. The stream owns the socket.
+     */
+    ShmStream(qcc::SocketFd sock);
+
+    /**
+     * Destructor
+     */
+    virtual ~ShmStream();
+
+    /**
+     * Client side. Offer a shared memory connection and wait for the daemon's answer.
+     *
+     * @param ringSize  Size of each ring, rounded up to a power of two.
+     * @param timeout   Time in milliseconds to wait for the answer.
+     *
+     * @return
+     *      - ER_OK if the daemon attached to the rings
+     *      - ER_BUS_TRANSPORT_NOT_AVAILABLE if the daemon declined, the socket is still usable
+     *      - An error status otherwise, the socket has been closed
+     */
+    QStatus Offer(uint32_t ringSize, uint32_t timeout);
+
+    /**
+     * Daemon side. Receive a client's offer and its credentials, and attach to the rings.
+     *
+     * @param uid       Returns the user id of the client.
+     * @param gid       Returns the group id of the client.
+     * @param pid       Returns the process id of the client.
+     * @param timeout   Time in milliseconds to wait for the offer.
+     *
+     * @return
+     *      - ER_OK if attached to the rings
+     *      - ER_BUS_TRANSPORT_NOT_AVAILABLE if the offer was declined, the socket is still usable
+     *      - An error status otherwise, the socket has been closed
+     */
+    QStatus Accept(uint32_t& uid, uint32_t& gid, uint32_t& pid, uint32_t timeout);
+
+    /**
+     * Take back the socket after a declined offer so it can be used as an ordinary socket stream.
+     *
+     * @return  The socket, the stream no longer owns it.
+     */
+    qcc::SocketFd DetachSocket();
+
+    /* qcc::Source */
+    QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = qcc::Event::WAIT_FOREVER);
+    QStatus PullBytesAndFds(void* buf, size_t reqBytes, size_t& actualBytes, qcc::SocketFd* fdList, size_t& numFds, uint32_t timeout = qcc::Event::WAIT_FOREVER);
+    qcc::Event& GetSourceEvent() { return *sourceEvent; }
+
+    /* qcc::Sink */
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent);
+    QStatus PushBytesAndFds(const void* buf, size_t numBytes, size_t& numSent, qcc::SocketFd* fdList, size_t numFds, uint32_t pid = -1);
+    qcc::Event& GetSinkEvent() { return *sinkEvent; }
+    void SetSendTimeout(uint32_t sendTimeout) { this->sendTimeout = sendTimeout; }
+
+    /* qcc::Stream */
+    void Close();
+
+  private:
+
+    /* Not copyable */
+    ShmStream(const ShmStream& other);
+    ShmStream& operator=(const ShmStream& other);
+
+    /**
+     * Map the region and set up the rings and events once the offer has been agreed.
+     */
+    QStatus Attach(bool creator, uint32_t ringSize);
+
+    /**
+     * Unmap the region and close the shared memory handles, leaving only the socket.
+     */
+    void Release();
+
+    qcc::SocketFd sock;          /**< Socket used for the offer, then only for noticing a closed peer */
+    int memFd;                   /**< The shared memory region */
+    void* region;                /**< Mapping of the region */
+    size_t regionLen;            /**< Size of the mapping */
+    ShmRing txRing;              /**< Ring this side writes */
+    ShmRing rxRing;              /**< Ring this side reads */
+    int txDataFd;                /**< Rung by this side when it wrote to an idle peer */
+    int txSpaceFd;               /**< Rung by the peer when it freed space this side is waiting for */
+    int rxDataFd;                /**< Rung by the peer when it wrote to this idle side */
+    int rxSpaceFd;               /**< Rung by this side when it freed space the peer is waiting for */
+    int pollFd;                  /**< Readable when rxDataFd is rung or the socket closes */
+    qcc::Event* sourceEvent;     /**< Event on pollFd */
+    qcc::Event* sinkEvent;       /**< Event on txSpaceFd */
+    uint32_t sendTimeout;        /**< Send timeout in milliseconds */
+};
+
+/**
+ * Endpoint for a local connection that may be carried by a ShmStream or, if the shared memory
+ * offer was declined, by a SocketStream on the socket it was negotiated on.
+ */
+class _ShmEndpoint;
+typedef qcc::ManagedObj<_ShmEndpoint> ShmEndpoint;
+
+class _ShmEndpoint : public _RemoteEndpoint {
+  public:
+
+    /**
+     * Constructor
+     *
+     * @param bus          The bus.
+     * @param incoming     true if this is the daemon side.
+     * @param connectSpec  The connect spec.
+     * @param stream       The stream carrying the connection. The endpoint owns the stream.
+     * @param isShm        true if stream is a ShmStream, false if it is a SocketStream.
+     * @param threadName   Name used for the endpoint's threads.
+     */
+    _ShmEndpoint(BusAttachment& bus, bool incoming, const qcc::String& connectSpec, qcc::Stream* stream, bool isShm, const char* threadName) :
+        _RemoteEndpoint(bus, incoming, connectSpec, stream, threadName, !isShm),
+        userId(-1),
+        groupId(-1),
+        processId(-1),
+        isShm(isShm),
+        stream(stream)
+    {
+    }
+
+    /**
+     * Destructor. The endpoint threads must be gone before the stream they use is deleted.
+     */
+    ~_ShmEndpoint()
+    {
+        Stop();
+        Join();
+        delete stream;
+    }
+
+    /**
+     * Indicates if the connection is carried by shared memory.
+     *
+     * @return  true if the stream is a ShmStream.
+     */
+    bool IsSharedMemory() const { return isShm; }
+
+    /**
+     * Set the user id of the endpoint.
+     *
+     * @param   userId      User ID number.
+     */
+    void SetUserId(uint32_t userId) { this->userId = userId; }
+
+    /**
+     * Set the group id of the endpoint.
+     *
+     * @param   groupId     Group ID number.
+     */
+    void SetGroupId(uint32_t groupId) { this->groupId = groupId; }
+
+    /**
+     * Set the process id of the endpoint.
+     *
+     * @param   processId   Process ID number.
+     */
+    void SetProcessId(uint32_t processId) { this->processId = processId; }
+
+    /**
+     * Return the user id of the endpoint.
+     *
+     * @return  User ID number.
+     */
+    uint32_t GetUserId() const { return userId; }
+
+    /**
+     * Return the group id of the endpoint.
+     *
+     * @return  Group ID number.
+     */
+    uint32_t GetGroupId() const { return groupId; }
+
+    /**
+     * Return the process id of the endpoint.
+     *
+     * @return  Process ID number.
+     */
+    uint32_t GetProcessId() const { return processId; }
+
+    /**
+     * Indicates if the endpoint supports reporting UNIX style user, group, and process IDs.
+     *
+     * @return  'true' if UNIX IDs supported, 'false' if not supported.
+     */
+    bool SupportsUnixIDs() const { return true; }
+
+  private:
+    uint32_t userId;
+    uint32_t groupId;
+    uint32_t processId;
+    bool isShm;
+    qcc::Stream* stream;
+};
+
+}
+
+#endif
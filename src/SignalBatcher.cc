@@ -0,0 +1,289 @@
+/**
+ * @file
+ * SignalBatcher packs small outgoing signals into one container message.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/Timer.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include "RemoteEndpoint.h"
+#include "SignalBatcher.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+const char* SignalBatcher::InterfaceName = "org.alljoyn.Bus.Batch";
+const char* SignalBatcher::MemberName = "Signals";
+const char* SignalBatcher::ObjectPath = "/org/alljoyn/Bus/Batch";
+
+static inline size_t MarshaledBytes(const Message& msg)
+{
+    return msg->bufEOD - reinterpret_cast<uint8_t*>(msg->msgBuf);
+}
+
+SignalBatcher::SignalBatcher(BusAttachment& bus, qcc::Timer& timer) :
+    bus(bus),
+    timer(timer),
+    maxDelay(0),
+    maxBytes(DEFAULT_MAX_BYTES),
+    pendingBytes(0),
+    pendingSessionId(0),
+    alarmArmed(false)
+{
+}
+
+SignalBatcher::~SignalBatcher()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    bool armed = alarmArmed;
+    alarmArmed = false;
+    pending.clear();
+    lock.Unlock(MUTEX_CONTEXT);
+    if (armed) {
+        timer.RemoveAlarm(alarm);
+    }
+}
+
+void SignalBatcher::SetLatencyBudget(uint32_t maxDelay, size_t maxBytes)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    this->maxBytes = maxBytes ? maxBytes : DEFAULT_MAX_BYTES;
+    this->maxDelay = maxDelay;
+    lock.Unlock(MUTEX_CONTEXT);
+    Flush();
+}
+
+bool SignalBatcher::IsBatchable(const Message& msg) const
+{
+    /*
+     * Only small plain signals are worth batching. The container carries the marshaled bytes so
+     * anything that needs per-message work in DeliverNonBlocking() must be sent on its own.
+     */
+    if ((msg->GetType() != MESSAGE_SIGNAL) || msg->encrypt || msg->handles || msg->ttl) {
+        return false;
+    }
+    if (msg->GetFlags() & (ALLJOYN_FLAG_ENCRYPTED | ALLJOYN_FLAG_COMPRESSED | ALLJOYN_FLAG_SESSIONLESS)) {
+        return false;
+    }
+    size_t len = MarshaledBytes(msg);
+    return (len > 0) && (len <= MAX_SIGNAL_BYTES) && !IsBatch(msg);
+}
+
+bool SignalBatcher::MustFlushFor(const Message& msg, RemoteEndpoint& ep, bool batchable) const
+{
+    return !pending.empty() &&
+           (!batchable || (pendingEp != ep) || (pendingSessionId != msg->GetSessionId()) || (pendingDest != msg->GetDestination()) ||
+            ((pendingBytes + MarshaledBytes(msg)) > maxBytes));
+}
+
+bool SignalBatcher::Add(Message& msg, RemoteEndpoint& ep)
+{
+    bool batchable = IsEnabled() && ep->GetFeatures().signalBatching && IsBatchable(msg);
+
+    lock.Lock(MUTEX_CONTEXT);
+    /*
+     * A message that does not join the pending batch must not overtake it. The batch is sent
+     * without lock, another thread may start a new one meanwhile and that has to go too.
+     */
+    while (MustFlushFor(msg, ep, batchable)) {
+        lock.Unlock(MUTEX_CONTEXT);
+        Flush();
+        lock.Lock(MUTEX_CONTEXT);
+    }
+    bool full = false;
+    if (batchable && IsEnabled()) {
+        if (pending.empty()) {
+            pendingEp = ep;
+            pendingDest = msg->GetDestination();
+            pendingSessionId = msg->GetSessionId();
+            uint32_t zero = 0;
+            AlarmListener* listener = this;
+            alarm = Alarm(maxDelay, listener, NULL, zero);
+            alarmArmed = (timer.AddAlarm(alarm) == ER_OK);
+        }
+        pending.push_back(msg);
+        pendingBytes += MarshaledBytes(msg);
+        full = !alarmArmed || (pending.size() >= MAX_SIGNALS) || (pendingBytes >= maxBytes);
+    } else {
+        batchable = false;
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    if (full) {
+        Flush();
+    }
+    return batchable;
+}
+
+QStatus SignalBatcher::Flush()
+{
+    sendLock.Lock(MUTEX_CONTEXT);
+    QStatus status = SendPending();
+    sendLock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+bool SignalBatcher::TakePending(Batch& batch)
+{
+    if (pending.empty()) {
+        return false;
+    }
+    if (alarmArmed) {
+        timer.RemoveAlarm(alarm, false /* don't block if alarm in progress */);
+        alarmArmed = false;
+    }
+    batch.signals.swap(pending);
+    batch.ep = pendingEp;
+    batch.dest = pendingDest;
+    batch.sessionId = pendingSessionId;
+    pending.clear();
+    pendingBytes = 0;
+    pendingEp = RemoteEndpoint();
+    return true;
+}
+
+QStatus SignalBatcher::SendPending()
+{
+    Batch batch;
+    lock.Lock(MUTEX_CONTEXT);
+    bool taken = TakePending(batch);
+    lock.Unlock(MUTEX_CONTEXT);
+    return taken ? Send(batch) : ER_OK;
+}
+
+QStatus SignalBatcher::Pack(BusAttachment& bus, const std::vector<Message>& signals, const qcc::String& destination, SessionId sessionId, Message& container)
+{
+    vector<MsgArg> elems(signals.size());
+    for (size_t i = 0; i < signals.size(); ++i) {
+        elems[i].Set("ay", MarshaledBytes(signals[i]), reinterpret_cast<uint8_t*>(signals[i]->msgBuf));
+    }
+    MsgArg arg;
+    arg.Set("aay", elems.size(), elems.empty() ? NULL : &elems[0]);
+    return container->SignalMsg("aay", destination.c_str(), sessionId, ObjectPath, InterfaceName, MemberName, &arg, 1, 0, 0);
+}
+
+QStatus SignalBatcher::Send(Batch& batch)
+{
+    QStatus status;
+    if (batch.signals.size() == 1) {
+        status = batch.ep->PushMessage(batch.signals[0]);
+    } else {
+        Message container(bus);
+        status = Pack(bus, batch.signals, batch.dest, batch.sessionId, container);
+        if (status == ER_OK) {
+            status = batch.ep->PushMessage(container);
+        }
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to send batch of %u signals to %s", static_cast<uint32_t>(batch.signals.size()), batch.ep->GetUniqueName().c_str()));
+    }
+    return status;
+}
+
+void SignalBatcher::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    /*
+     * The timer also drives method call timeouts so it must not wait behind a sender blocked on
+     * a full transmit queue, the batch is given another latency budget instead.
+     */
+    if (!sendLock.TryLock()) {
+        lock.Lock(MUTEX_CONTEXT);
+        if (alarmArmed && (alarm == this->alarm)) {
+            uint32_t zero = 0;
+            AlarmListener* listener = this;
+            this->alarm = Alarm(maxDelay ? maxDelay : 1, listener, NULL, zero);
+            alarmArmed = (timer.AddAlarm(this->alarm) == ER_OK);
+        }
+        lock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
+    Batch batch;
+    lock.Lock(MUTEX_CONTEXT);
+    /*
+     * A batch that was already flushed may have been replaced by a new one with its own alarm
+     */
+    bool taken = alarmArmed && (alarm == this->alarm) && TakePending(batch);
+    lock.Unlock(MUTEX_CONTEXT);
+    if (taken) {
+        Send(batch);
+    }
+    sendLock.Unlock(MUTEX_CONTEXT);
+}
+
+bool SignalBatcher::IsBatch(const Message& msg)
+{
+    return (msg->GetType() == MESSAGE_SIGNAL) &&
+           (strcmp(msg->GetMemberName(), MemberName) == 0) &&
+           (strcmp(msg->GetInterface(), InterfaceName) == 0);
+}
+
+QStatus SignalBatcher::Unpack(Message& container, RemoteEndpoint& endpoint, bool checkSender, vector<Message>& signals)
+{
+    QStatus status = container->UnmarshalArgs("aay");
+    if (status != ER_OK) {
+        return status;
+    }
+    const MsgArg* arg = container->GetArg(0);
+    if (!arg || (arg->typeId != ALLJOYN_ARRAY)) {
+        return ER_BUS_BAD_SIGNATURE;
+    }
+    const MsgArg* elems = arg->v_array.GetElements();
+    size_t numElems = arg->v_array.GetNumElements();
+    signals.reserve(numElems);
+    for (size_t i = 0; i < numElems; ++i) {
+        if (elems[i].typeId != ALLJOYN_BYTE_ARRAY) {
+            return ER_BUS_BAD_SIGNATURE;
+        }
+        Message msg(*container->bus);
+        QStatus s = msg->LoadBytes(elems[i].v_scalarArray.v_byte, elems[i].v_scalarArray.numElements);
+        if (s == ER_OK) {
+            s = msg->Unmarshal(endpoint, checkSender);
+        }
+        /*
+         * Containers only carry signals and are never nested
+         */
+        if ((s == ER_OK) && ((msg->GetType() != MESSAGE_SIGNAL) || IsBatch(msg))) {
+            s = ER_BUS_BAD_HEADER_FIELD;
+        }
+        if (s == ER_OK) {
+            signals.push_back(msg);
+        } else {
+            QCC_DbgHLPrintf(("Discarding signal %u of batch from %s: %s", static_cast<uint32_t>(i), container->GetSender(), QCC_StatusText(s)));
+        }
+    }
+    return ER_OK;
+}
+
+}
@@ -0,0 +1,250 @@
+#ifndef _ALLJOYN_SIGNALBATCHER_H
+#define _ALLJOYN_SIGNALBATCHER_H
+/**
+ * @file
+ * SignalBatcher packs small outgoing signals into one container message.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include SignalBatcher.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/Timer.h>
+
+#include <alljoyn/Message.h>
+#include <alljoyn/Session.h>
+
+#include "RemoteEndpoint.h"
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * SignalBatcher collects signals a client sends to the same destination and session and sends
+ * them to the daemon as a single org.alljoyn.Bus.Batch.Signals container signal. The container
+ * body is an array of byte arrays, each holding one complete marshaled signal. The endpoint that
+ * receives a container unpacks it and handles each signal exactly as if it had arrived on its own,
+ * so sender checks, routing, rule matching and permissions still apply per signal.
+ *
+ * Containers are only sent on connections that negotiated signal batching while authenticating,
+ * see EndpointAuth. A batch is sent when it reaches the size limit, when the latency budget of its
+ * first signal runs out, or before any message that is not batched so the order in which a thread
+ * sends messages is preserved.
+ *
+ * A batch is taken from the pending list under the batcher lock but pushed to its endpoint without
+ * it, so a sender blocked on a full transmit queue does not hold up threads that are only adding
+ * signals to the next batch. Batches are pushed in the order they were taken.
+ */
+class SignalBatcher : public qcc::AlarmListener {
+
+  public:
+
+    /**
+     * Interface of the container signal
+     */
+    static const char* InterfaceName;
+
+    /**
+     * Member name of the container signal
+     */
+    static const char* MemberName;
+
+    /**
+     * Object path of the container signal
+     */
+    static const char* ObjectPath;
+
+    /**
+     * Default number of bytes of signals collected in one batch.
+     */
+    static const size_t DEFAULT_MAX_BYTES = 16 * 1024;
+
+    /**
+     * Maximum number of signals in one batch. This must stay well below the serial number window
+     * kept per peer since the signals in a container arrive after the container itself.
+     */
+    static const size_t MAX_SIGNALS = 64;
+
+    /**
+     * Signals larger than this are not worth batching.
+     */
+    static const size_t MAX_SIGNAL_BYTES = 1024;
+
+    /**
+     * Create a signal batcher. Batching is disabled until SetLatencyBudget() is called.
+     *
+     * @param bus    The bus attachment that sends the signals.
+     * @param timer  Timer used to send a batch when its latency budget runs out.
+     */
+    SignalBatcher(BusAttachment& bus, qcc::Timer& timer);
+
+    /**
+     * Destructor
+     */
+    ~SignalBatcher();
+
+    /**
+     * Enable or disable batching. Disabling batching sends any pending batch.
+     *
+     * @param maxDelay  Longest time in milliseconds a signal may wait for others to join its
+     *                  batch. Zero disables batching.
+     * @param maxBytes  Maximum number of bytes of signals in one batch, zero for the default.
+     */
+    void SetLatencyBudget(uint32_t maxDelay, size_t maxBytes);
+
+    /**
+     * Quick check so the send path does not take the batcher lock when batching is disabled.
+     */
+    bool IsEnabled() const { return maxDelay != 0; }
+
+    /**
+     * Offer an outgoing message to the batcher. A message that cannot be batched causes any
+     * pending batch to be sent first so the caller can then send the message itself.
+     *
+     * @param msg  A fully marshaled outgoing message.
+     * @param ep   The endpoint the message is about to be pushed to.
+     *
+     * @return  true if the message was added to a batch, false if the caller must send it.
+     */
+    bool Add(Message& msg, RemoteEndpoint& ep);
+
+    /**
+     * Send the pending batch if there is one.
+     *
+     * @return  ER_OK if there was nothing to send or the batch was pushed to its endpoint.
+     */
+    QStatus Flush();
+
+    /**
+     * Build the container signal that carries a batch.
+     *
+     * @param bus          The bus attachment sending the container.
+     * @param signals      The marshaled signals, in the order they will be unpacked.
+     * @param destination  Destination shared by the signals.
+     * @param sessionId    Session id shared by the signals.
+     * @param container    A new message to marshal the container into.
+     *
+     * @return  ER_OK if the container was marshaled.
+     */
+    static QStatus Pack(BusAttachment& bus, const std::vector<Message>& signals, const qcc::String& destination, SessionId sessionId, Message& container);
+
+    /**
+     * Check if a message is a batch container.
+     *
+     * @param msg  The message to check.
+     *
+     * @return  true if msg is an org.alljoyn.Bus.Batch.Signals signal.
+     */
+    static bool IsBatch(const Message& msg);
+
+    /**
+     * Unpack the signals carried by a container received on an endpoint that negotiated signal
+     * batching. Each signal is unmarshaled as though it had been read from the endpoint.
+     *
+     * @param container    The received container.
+     * @param endpoint     The endpoint the container was received on.
+     * @param checkSender  Passed on to Message::Unmarshal() for each signal.
+     * @param signals      [OUT] The signals that were unmarshaled successfully.
+     *
+     * @return  ER_OK if the container body was valid. Signals that fail to unmarshal are dropped.
+     */
+    static QStatus Unpack(Message& container, RemoteEndpoint& endpoint, bool checkSender, std::vector<Message>& signals);
+
+  private:
+
+    /**
+     * Copy constructor and assignment are private - SignalBatchers cannot be copied.
+     */
+    SignalBatcher(const SignalBatcher& other);
+    SignalBatcher& operator=(const SignalBatcher& other);
+
+    /**
+     * Check if a message can be carried in a container.
+     */
+    bool IsBatchable(const Message& msg) const;
+
+    /** A batch taken from the pending list */
+    struct Batch {
+        std::vector<Message> signals;
+        RemoteEndpoint ep;
+        qcc::String dest;
+        SessionId sessionId;
+    };
+
+    /**
+     * Check if a message has to wait for the pending batch to be sent. Must be called holding lock.
+     */
+    bool MustFlushFor(const Message& msg, RemoteEndpoint& ep, bool batchable) const;
+
+    /**
+     * Move the pending batch to batch. Must be called holding lock.
+     *
+     * @return  false if there was nothing pending.
+     */
+    bool TakePending(Batch& batch);
+
+    /**
+     * Take the pending batch and push it. Must be called holding sendLock and not lock.
+     */
+    QStatus SendPending();
+
+    /**
+     * Push a batch to its endpoint, as a container unless it is a single signal.
+     */
+    QStatus Send(Batch& batch);
+
+    /**
+     * The latency budget of the oldest pending signal ran out.
+     */
+    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
+    BusAttachment& bus;
+    qcc::Timer& timer;
+    volatile uint32_t maxDelay;     /**< Latency budget in milliseconds, 0 if batching is disabled */
+    size_t maxBytes;                /**< Maximum bytes of signals in one batch */
+
+    /*
+     * Held while a batch is taken and pushed so batches are pushed in the order they were taken.
+     * Always acquired before lock.
+     */
+    qcc::Mutex sendLock;
+
+    /*
+     * The pending batch. All of its signals share the endpoint, destination and session id.
+     */
+    qcc::Mutex lock;
+    std::vector<Message> pending;
+    size_t pendingBytes;
+    RemoteEndpoint pendingEp;
+    qcc::String pendingDest;
+    SessionId pendingSessionId;
+    qcc::Alarm alarm;
+    bool alarmArmed;
+};
+
+}
+
+#endif
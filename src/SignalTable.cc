@@ -24,6 +24,7 @@
 #include <qcc/platform.h>
 #include <qcc/Debug.h>
 #include <qcc/String.h>
+#include <qcc/atomic.h>
 
 #include <list>
 
@@ -36,6 +37,75 @@ using namespace std;
 
 namespace ajn {
 
+SignalTable::SignalTable() : current(new Index()), readers(0)
+{
+}
+
+SignalTable::~SignalTable()
+{
+    lock.Lock(MUTEX_CONTEXT);
+    for (vector<Index*>::iterator it = retired.begin(); it != retired.end(); ++it) {
+        Release(*it);
+    }
+    retired.clear();
+    Release(current);
+    current = NULL;
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+SignalTable::Index* SignalTable::CopyIndex()
+{
+    Index* index = new Index(*current);
+    for (Index::iterator it = index->begin(); it != index->end(); ++it) {
+        ++it->second->refs;
+    }
+    return index;
+}
+
+void SignalTable::ReplaceBucket(Index& index, const Key& key, Bucket* bucket)
+{
+    Index::iterator it = index.find(key);
+    if (it != index.end()) {
+        /* The published index still refers to the old bucket so this never frees it */
+        --it->second->refs;
+        if (bucket) {
+            it->second = bucket;
+        } else {
+            index.erase(it);
+        }
+    } else if (bucket) {
+        index[key] = bucket;
+    }
+}
+
+void SignalTable::Publish(Index* index)
+{
+    retired.push_back(current);
+    current = index;
+    /*
+     * Joining the readers is a full barrier. If no other reader is active then every Find() that
+     * started before the swap has finished and any that start later will only see the new index.
+     * Otherwise the retired indexes are freed by a later update.
+     */
+    if (qcc::IncrementAndFetch(&readers) == 1) {
+        for (vector<Index*>::iterator it = retired.begin(); it != retired.end(); ++it) {
+            Release(*it);
+        }
+        retired.clear();
+    }
+    qcc::DecrementAndFetch(&readers);
+}
+
+void SignalTable::Release(Index* index)
+{
+    for (Index::iterator it = index->begin(); it != index->end(); ++it) {
+        if (--it->second->refs == 0) {
+            delete it->second;
+        }
+    }
+    delete index;
+}
+
 void SignalTable::Add(MessageReceiver* receiver,
                       MessageReceiver::SignalHandler handler,
                       const InterfaceDescription::Member* member,
@@ -46,9 +116,18 @@ void SignalTable::Add(MessageReceiver* receiver,
                   member->name.c_str(),
                   sourcePath.c_str()));
     Entry entry(handler, receiver, member);
-    Key key(sourcePath, member->iface->GetName(), member->name);
+    Key key(AtomTable::Intern(member->iface->GetName()), AtomTable::Intern(member->name));
+    Atom src = AtomTable::Intern(sourcePath);
     lock.Lock(MUTEX_CONTEXT);
-    hashTable.insert(pair<const Key, Entry>(key, entry));
+    Bucket* bucket = new Bucket();
+    Index::const_iterator it = current->find(key);
+    if (it != current->end()) {
+        bucket->handlers = it->second->handlers;
+    }
+    bucket->handlers.push_back(Handler(src, entry));
+    Index* index = CopyIndex();
+    ReplaceBucket(*index, key, bucket);
+    Publish(index);
     lock.Unlock(MUTEX_CONTEXT);
 }
 
@@ -57,19 +136,29 @@ void SignalTable::Remove(MessageReceiver* receiver,
                          const InterfaceDescription::Member* member,
                          const char* sourcePath)
 {
-    Key key(sourcePath, member->iface->GetName(), member->name.c_str());
-    iterator iter;
-    pair<iterator, iterator> range;
+    Key key(AtomTable::Find(member->iface->GetName()), AtomTable::Find(member->name.c_str()));
+    Atom src = AtomTable::Find(sourcePath);
 
     lock.Lock(MUTEX_CONTEXT);
-    range = hashTable.equal_range(key);
-    iter = range.first;
-    while (iter != range.second) {
-        if ((iter->second.object == receiver) && (iter->second.handler == handler)) {
-            hashTable.erase(iter);
-            break;
-        } else {
-            ++iter;
+    Index::const_iterator it = current->find(key);
+    if (it != current->end()) {
+        const vector<Handler>& handlers = it->second->handlers;
+        for (size_t i = 0; i < handlers.size(); ++i) {
+            const Handler& h = handlers[i];
+            /* An empty source path on either side is treated as don't care */
+            bool pathMatch = (src == ATOM_NONE) || (h.sourcePath == ATOM_NONE) || (h.sourcePath == src);
+            if (pathMatch && (h.entry.object == receiver) && (h.entry.handler == handler)) {
+                Bucket* bucket = NULL;
+                if (handlers.size() > 1) {
+                    bucket = new Bucket();
+                    bucket->handlers = handlers;
+                    bucket->handlers.erase(bucket->handlers.begin() + i);
+                }
+                Index* index = CopyIndex();
+                ReplaceBucket(*index, key, bucket);
+                Publish(index);
+                break;
+            }
         }
     }
     lock.Unlock(MUTEX_CONTEXT);
@@ -77,27 +166,66 @@ void SignalTable::Remove(MessageReceiver* receiver,
 
 void SignalTable::RemoveAll(MessageReceiver* receiver)
 {
-    bool removed;
     lock.Lock(MUTEX_CONTEXT);
-    do {
-        removed = false;
-        for (iterator iter = hashTable.begin(); iter != hashTable.end(); ++iter) {
-            if (iter->second.object == receiver) {
-                hashTable.erase(iter);
-                removed = true;
-                break;
+    Index* index = NULL;
+    for (Index::const_iterator it = current->begin(); it != current->end(); ++it) {
+        const vector<Handler>& handlers = it->second->handlers;
+        vector<Handler> kept;
+        for (vector<Handler>::const_iterator hit = handlers.begin(); hit != handlers.end(); ++hit) {
+            if (hit->entry.object != receiver) {
+                kept.push_back(*hit);
             }
         }
-    } while (removed);
+        if (kept.size() != handlers.size()) {
+            if (!index) {
+                index = CopyIndex();
+            }
+            Bucket* bucket = NULL;
+            if (!kept.empty()) {
+                bucket = new Bucket();
+                bucket->handlers.swap(kept);
+            }
+            ReplaceBucket(*index, it->first, bucket);
+        }
+    }
+    if (index) {
+        Publish(index);
+    }
     lock.Unlock(MUTEX_CONTEXT);
 }
 
-pair<SignalTable::const_iterator, SignalTable::const_iterator> SignalTable::Find(const char* sourcePath,
-                                                                                 const char* iface,
-                                                                                 const char* signalName)
+size_t SignalTable::Find(const char* sourcePath,
+                         const char* iface,
+                         const char* signalName,
+                         vector<Entry>& entries)
 {
-    Key key(sourcePath, iface, signalName);
-    return hashTable.equal_range(key);
+    return Find(AtomTable::Find(sourcePath), AtomTable::Find(iface), AtomTable::Find(signalName), entries);
+}
+
+size_t SignalTable::Find(Atom sourcePath,
+                         Atom iface,
+                         Atom signalName,
+                         vector<Entry>& entries)
+{
+    size_t num = 0;
+    /*
+     * The index can't be freed while we are counted as a reader. Incrementing the count is a full
+     * barrier so the index we load is at least as new as any writer that saw us as idle.
+     */
+    qcc::IncrementAndFetch(&readers);
+    const Index* index = current;
+    Index::const_iterator it = index->find(Key(iface, signalName));
+    if (it != index->end()) {
+        const vector<Handler>& handlers = it->second->handlers;
+        for (vector<Handler>::const_iterator hit = handlers.begin(); hit != handlers.end(); ++hit) {
+            if ((sourcePath == ATOM_NONE) || (hit->sourcePath == ATOM_NONE) || (hit->sourcePath == sourcePath)) {
+                entries.push_back(hit->entry);
+                ++num;
+            }
+        }
+    }
+    qcc::DecrementAndFetch(&readers);
+    return num;
 }
 
 }
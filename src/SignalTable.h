@@ -26,12 +26,10 @@
 #endif
 
 #include <qcc/platform.h>
-#include <qcc/StringMapKey.h>
 
 #include <vector>
 
 #include <qcc/String.h>
-#include <qcc/StringMapKey.h>
 #include <qcc/Mutex.h>
 
 #include <alljoyn/InterfaceDescription.h>
@@ -41,36 +39,22 @@
 
 #include <qcc/STLContainer.h>
 
+#include "AtomTable.h"
+
 namespace ajn {
 
 /**
  * %SignalTable is a multimap that maps interface/signalname and/or source path to SignalHandler instances.
+ *
+ * Handlers are kept in per interface/signal name buckets. Buckets and the table that indexes them
+ * are never modified once published: writers copy the affected bucket and the (small) index, and
+ * swap in the new index. Find() does not take a lock so dispatching a signal never waits for
+ * handler registration or for other dispatcher threads.
  */
 class SignalTable {
 
   public:
 
-    /**
-     * Type definition for signal hash table key
-     */
-    struct Key {
-        qcc::StringMapKey sourcePath;           /**< The object path of the signal sender */
-        qcc::StringMapKey iface;                /**< The Interface name */
-        qcc::StringMapKey signalName;           /**< The signal name */
-
-        /**
-         * Constructor used for lookups only (no storage)
-         */
-        Key(const char* src, const char* ifc, const char* sig)
-            : sourcePath(src), iface(ifc), signalName(sig) { }
-
-        /**
-         * Constructor used for storage into hash table (no dangling char*)
-         */
-        Key(const qcc::String& src, const qcc::String& ifc, const qcc::String& sig)
-            : sourcePath(src), iface(ifc), signalName(sig) { }
-    };
-
     /**
      * Type definition for a signal hash table entry
      */
@@ -93,46 +77,15 @@ class SignalTable {
         Entry(void) : handler(), object(NULL), member(NULL) { }
     };
 
-    /** %Hash functor */
-    struct Hash {
-        /** Calculate hash for Key k */
-        size_t operator()(const Key& k) const {
-            /* source path cannot factor into hash because a key with no sourcepath is considered equal to one that does */
-            size_t hash = 0;
-            for (const char* p = k.signalName.c_str(); *p; ++p) {
-                hash = *p + hash * 11;
-            }
-            for (const char* p = k.iface.c_str(); *p; ++p) {
-                hash += *p * 7;
-            }
-            return hash;
-        }
-    };
-
-    /** Functor for testing 2 keys for equality */
-    struct Equal {
-        /** Return true two keys are equal */
-        bool operator()(const Key& k1, const Key& k2) const {
-            /* If either source path is null, then this field should be treated as don't care */
-            if ((k1.sourcePath.empty()) || (k2.sourcePath.empty())) {
-                return (0 == strcmp(k1.iface.c_str(), k2.iface.c_str())) && (0 == strcmp(k1.signalName.c_str(), k2.signalName.c_str()));
-            } else {
-                return (0 == strcmp(k1.iface.c_str(), k2.iface.c_str())) && \
-                       (0 == strcmp(k1.signalName.c_str(), k2.signalName.c_str())) && \
-                       (0 == strcmp(k1.sourcePath.c_str(), k2.sourcePath.c_str()));
-            }
-        }
-    };
-
     /**
-     * Table iterator
+     * Constructor
      */
-    typedef std::unordered_multimap<Key, Entry, Hash, Equal>::iterator iterator;
+    SignalTable();
 
     /**
-     * Const table iterator
+     * Destructor. There must be no concurrent calls to Find().
      */
-    typedef std::unordered_multimap<Key, Entry, Hash, Equal>::const_iterator const_iterator;
+    ~SignalTable();
 
     /**
      * Add an entry to the signal hash table.
@@ -168,33 +121,115 @@ class SignalTable {
     void RemoveAll(MessageReceiver* receiver);
 
     /**
-     * Find Entries based on set of criteria.
-     * Signal table lock should be held until iterators are no longer in use.
+     * Find Entries based on set of criteria. This does not block.
      *
      * @param sourcePath   The object path of the signal sender.
-     * @param iface    The interface.
+     * @param iface        The interface.
      * @param signalName   The signal name.
+     * @param entries      Matching entries are appended to this vector.
      *
-     * @return   Iterator range of entries with matching criteria.
+     * @return   The number of matching entries.
      */
-    std::pair<const_iterator, const_iterator> Find(const char* sourcePath, const char* iface, const char* signalName);
+    size_t Find(const char* sourcePath, const char* iface, const char* signalName, std::vector<Entry>& entries);
 
     /**
-     * Get the lock that protects the signal table.
+     * Find Entries based on set of criteria. This does not block.
+     *
+     * @param sourcePath   Atom for the object path of the signal sender.
+     * @param iface        Atom for the interface.
+     * @param signalName   Atom for the signal name.
+     * @param entries      Matching entries are appended to this vector.
+     *
+     * @return   The number of matching entries.
      */
-    void Lock(void) { lock.Lock(MUTEX_CONTEXT); }
+    size_t Find(Atom sourcePath, Atom iface, Atom signalName, std::vector<Entry>& entries);
+
+  private:
+
+    /* Copying is not allowed */
+    SignalTable(const SignalTable& other);
+    SignalTable& operator=(const SignalTable& other);
 
     /**
-     * Release the lock that protects the signal table.
+     * Type definition for signal bucket key
      */
-    void Unlock(void) { lock.Unlock(MUTEX_CONTEXT); }
+    struct Key {
+        Atom iface;                /**< The Interface name */
+        Atom signalName;           /**< The signal name */
 
-  private:
+        /**
+         * Constructor
+         */
+        Key(Atom ifc, Atom sig) : iface(ifc), signalName(sig) { }
+    };
+
+    /** %Hash functor */
+    struct Hash {
+        /** Calculate hash for Key k */
+        size_t operator()(const Key& k) const {
+            return (size_t)k.signalName * 11 + (size_t)k.iface * 7;
+        }
+    };
+
+    /** Functor for testing 2 keys for equality */
+    struct Equal {
+        /** Return true two keys are equal */
+        bool operator()(const Key& k1, const Key& k2) const {
+            return (k1.iface == k2.iface) && (k1.signalName == k2.signalName);
+        }
+    };
+
+    /**
+     * A handler and the source path it was registered for. ATOM_NONE matches any source path.
+     */
+    struct Handler {
+        Atom sourcePath;
+        Entry entry;
+        Handler(Atom src, const Entry& entry) : sourcePath(src), entry(entry) { }
+    };
+
+    /**
+     * Handlers for one interface/signal name. A bucket is shared by every index that refers to
+     * it; refs is only touched with lock held.
+     */
+    struct Bucket {
+        std::vector<Handler> handlers;
+        uint32_t refs;
+        Bucket() : refs(1) { }
+    };
+
+    /** Index from interface/signal name to bucket */
+    typedef std::unordered_map<Key, Bucket*, Hash, Equal> Index;
+
+    /**
+     * Make a copy of the current index that shares all of its buckets. Must be called with lock held.
+     */
+    Index* CopyIndex();
 
-    qcc::Mutex lock; /**< Lock protecting the signal table */
+    /**
+     * Replace the bucket for a key in an unpublished index. Must be called with lock held.
+     *
+     * @param index    The index to update.
+     * @param key      The key.
+     * @param bucket   The new bucket or NULL to remove the key.
+     */
+    void ReplaceBucket(Index& index, const Key& key, Bucket* bucket);
+
+    /**
+     * Publish a new index and free any retired indexes that no reader can still be using.
+     * Must be called with lock held.
+     */
+    void Publish(Index* index);
+
+    /**
+     * Free an index and any buckets only it refers to. Must be called with lock held.
+     */
+    void Release(Index* index);
 
-    /**  The hash table */
-    std::unordered_multimap<Key, Entry, Hash, Equal> hashTable;
+    qcc::Mutex lock;               /**< Lock serializing writers */
+    Index* volatile current;       /**< The published index */
+    volatile int32_t readers;      /**< Number of Find() calls in progress */
+    std::vector<Index*> retired;   /**< Replaced indexes that may still be in use by readers */
 };
 
 }
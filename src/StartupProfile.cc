@@ -0,0 +1,103 @@
+/**
+ * @file
+ * Timing of the phases a bus attachment goes through between construction and being connected.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include "LatencyHistogram.h"
+#include "StartupProfile.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+static uint32_t ElapsedSince(uint64_t start)
+{
+    uint64_t now = GetLatencyClock();
+    uint64_t elapsed = (now > start) ? (now - start) : 0;
+    /* Never return 0 so a recorded phase can be told from one that never ran */
+    return (elapsed >= 0xFFFFFFFF) ? 0xFFFFFFFF : ((elapsed == 0) ? 1 : static_cast<uint32_t>(elapsed));
+}
+
+void StartupProfile::Record(Phase phase, uint64_t start)
+{
+    usecs[phase] = ElapsedSince(start);
+}
+
+void StartupProfile::RecordFirstMethodCall(uint64_t start)
+{
+    if (firstMethodCall == 0) {
+        firstMethodCall = ElapsedSince(start);
+    }
+}
+
+uint32_t StartupProfile::GetTotal() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < NUM_PHASES; ++i) {
+        total += usecs[i];
+    }
+    return (total >= 0xFFFFFFFF) ? 0xFFFFFFFF : static_cast<uint32_t>(total);
+}
+
+void StartupProfile::Reset()
+{
+    for (size_t i = 0; i < NUM_PHASES; ++i) {
+        usecs[i] = 0;
+    }
+    firstMethodCall = 0;
+}
+
+const char* StartupProfile::PhaseText(Phase phase)
+{
+    switch (phase) {
+    case INTERFACES:
+        return "interfaces";
+
+    case TRANSPORTS:
+        return "transports";
+
+    case CONNECT:
+        return "connect";
+
+    case SIGNAL_HANDLERS:
+        return "signal_handlers";
+
+    default:
+        return "unknown";
+    }
+}
+
+qcc::String StartupProfile::ToString() const
+{
+    qcc::String str;
+    for (size_t i = 0; i < NUM_PHASES; ++i) {
+        str += PhaseText(static_cast<Phase>(i));
+        str += "=" + U32ToString(usecs[i]) + "us ";
+    }
+    str += "total=" + U32ToString(GetTotal()) + "us ";
+    str += "first_method_call=" + U32ToString(firstMethodCall) + "us";
+    return str;
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef _ALLJOYN_STARTUPPROFILE_H
+#define _ALLJOYN_STARTUPPROFILE_H
+/**
+ * @file
+ * Timing of the phases a bus attachment goes through between construction and being connected.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include StartupProfile.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+
+namespace ajn {
+
+/**
+ * StartupProfile records how long each startup phase of a bus attachment took. Each phase is
+ * recorded once by the thread driving startup so no locking is needed.
+ */
+class StartupProfile {
+  public:
+
+    /** Startup phases in the order they normally happen */
+    enum Phase {
+        INTERFACES = 0,   /**< Creating the standard interfaces in the constructor */
+        TRANSPORTS,       /**< BusAttachment::Start() starting the transports and local endpoint */
+        CONNECT,          /**< Connecting to the daemon */
+        SIGNAL_HANDLERS,  /**< Registering the BusListener signal handlers and match rules */
+        NUM_PHASES
+    };
+
+    /**
+     * Constructor
+     */
+    StartupProfile() { Reset(); }
+
+    /**
+     * Record that a phase has ended.
+     *
+     * @param phase   The phase.
+     * @param start   The GetLatencyClock() time when the phase began.
+     */
+    void Record(Phase phase, uint64_t start);
+
+    /**
+     * @param phase   The phase.
+     *
+     * @return  The time the phase took in microseconds, 0 if the phase has not been recorded.
+     */
+    uint32_t Get(Phase phase) const { return usecs[phase]; }
+
+    /**
+     * Record the completion of the first method call made over the connection.
+     *
+     * @param start   The GetLatencyClock() time when the connect began.
+     */
+    void RecordFirstMethodCall(uint64_t start);
+
+    /**
+     * @return  The time from the start of the connect until the first method call over the
+     *          connection completed in microseconds, 0 if not recorded. When connecting to the
+     *          bundled daemon this includes launching the daemon.
+     */
+    uint32_t GetFirstMethodCall() const { return firstMethodCall; }
+
+    /**
+     * @return  The total time of all recorded phases in microseconds.
+     */
+    uint32_t GetTotal() const;
+
+    /**
+     * Clear all recorded phases.
+     */
+    void Reset();
+
+    /**
+     * @param phase   The phase.
+     *
+     * @return  A short name for the phase.
+     */
+    static const char* PhaseText(Phase phase);
+
+    /**
+     * @return  A one line summary of the recorded phases.
+     */
+    qcc::String ToString() const;
+
+  private:
+
+    uint32_t usecs[NUM_PHASES];
+    uint32_t firstMethodCall;
+};
+
+}
+
+#endif
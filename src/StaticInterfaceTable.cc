@@ -0,0 +1,104 @@
+/**
+ * @file
+ * StaticInterfaceTable is a process-wide cache of the interface descriptions built from statically
+ * defined interface tables.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <map>
+
+#include <qcc/Debug.h>
+#include <qcc/Mutex.h>
+
+#include <alljoyn/InterfaceDescription.h>
+
+#include "StaticInterfaceTable.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+
+namespace ajn {
+
+struct SharedInterface {
+    InterfaceDescription* iface;
+    uint32_t refs;
+};
+
+/*
+ * Keyed by the address of the table so the lookup never touches the strings in the table
+ */
+typedef map<const InterfaceDescription::StaticInterface*, SharedInterface> SharedInterfaceMap;
+
+static qcc::Mutex sharedLock;
+static SharedInterfaceMap sharedIfaces;
+
+QStatus StaticInterfaceTable::Acquire(const InterfaceDescription::StaticInterface& table, const InterfaceDescription*& iface)
+{
+    QStatus status = ER_OK;
+    iface = NULL;
+
+    sharedLock.Lock(MUTEX_CONTEXT);
+    SharedInterfaceMap::iterator it = sharedIfaces.find(&table);
+    if (it != sharedIfaces.end()) {
+        ++it->second.refs;
+        iface = it->second.iface;
+    } else {
+        InterfaceDescription* desc = new InterfaceDescription(table.name, table.secure);
+        for (size_t i = 0; (status == ER_OK) && (i < table.numMembers); ++i) {
+            const InterfaceDescription::StaticMember& m = table.members[i];
+            status = desc->AddMember(m.type, m.name, m.inputSig, m.outSig, m.argNames, m.annotation, m.accessPerms);
+        }
+        for (size_t i = 0; (status == ER_OK) && (i < table.numProperties); ++i) {
+            const InterfaceDescription::StaticProperty& p = table.properties[i];
+            status = desc->AddProperty(p.name, p.signature, p.access);
+        }
+        if (status == ER_OK) {
+            desc->Activate();
+            SharedInterface shared = { desc, 1 };
+            sharedIfaces[&table] = shared;
+            iface = desc;
+        } else {
+            QCC_LogError(status, ("Bad static definition for interface \"%s\"", table.name));
+            delete desc;
+        }
+    }
+    sharedLock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
+void StaticInterfaceTable::Release(const InterfaceDescription* iface)
+{
+    sharedLock.Lock(MUTEX_CONTEXT);
+    for (SharedInterfaceMap::iterator it = sharedIfaces.begin(); it != sharedIfaces.end(); ++it) {
+        if (it->second.iface == iface) {
+            if (--it->second.refs == 0) {
+                delete it->second.iface;
+                sharedIfaces.erase(it);
+            }
+            break;
+        }
+    }
+    sharedLock.Unlock(MUTEX_CONTEXT);
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef _ALLJOYN_STATICINTERFACETABLE_H
+#define _ALLJOYN_STATICINTERFACETABLE_H
+/**
+ * @file
+ * StaticInterfaceTable is a process-wide cache of the interface descriptions built from statically
+ * defined interface tables.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include StaticInterfaceTable.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <alljoyn/InterfaceDescription.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * StaticInterfaceTable builds one activated InterfaceDescription per StaticInterface table and
+ * shares it between all bus attachments in the process. Descriptions are reference counted and
+ * freed when the last bus attachment that acquired them releases them.
+ */
+class StaticInterfaceTable {
+  public:
+
+    /**
+     * Get the shared description for a table, building it on first use.
+     *
+     * @param table       The static interface definition.
+     * @param[out] iface  The shared, activated interface description.
+     *
+     * @return  ER_OK or the error returned while adding a member or property from the table.
+     */
+    static QStatus Acquire(const InterfaceDescription::StaticInterface& table, const InterfaceDescription*& iface);
+
+    /**
+     * Release a description returned by Acquire().
+     *
+     * @param iface  The shared interface description.
+     */
+    static void Release(const InterfaceDescription* iface);
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file
+ *
+ * This file implements the ThreadScheduling class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <qcc/Debug.h>
+
+#include "ThreadScheduling.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+
+namespace ajn {
+
+qcc::Mutex ThreadScheduling::lock;
+
+volatile uint32_t ThreadScheduling::generation = 0;
+
+ThreadScheduling::Policy ThreadScheduling::policy = ThreadScheduling::POLICY_DEFAULT;
+
+int ThreadScheduling::priority = 0;
+
+volatile uint64_t ThreadScheduling::cpus = 0;
+
+#if defined(QCC_OS_GROUP_POSIX)
+
+/* The key holds the generation last applied to the thread */
+static pthread_key_t appliedKey;
+static bool appliedKeyValid = (pthread_key_create(&appliedKey, NULL) == 0);
+
+/* Generation for which a failure was last logged, so a refused policy is reported once rather than by every thread */
+static volatile uint32_t reportedGeneration = 0;
+
+static int OsPolicy(ThreadScheduling::Policy policy)
+{
+    switch (policy) {
+    case ThreadScheduling::POLICY_FIFO: return SCHED_FIFO;
+    case ThreadScheduling::POLICY_RR:   return SCHED_RR;
+    default:                            return SCHED_OTHER;
+    }
+}
+
+QStatus ThreadScheduling::Set(Policy newPolicy, int newPriority, uint64_t cpuMask, bool lockMemory)
+{
+    if (!appliedKeyValid) {
+        return ER_NOT_IMPLEMENTED;
+    }
+    if (newPolicy == POLICY_DEFAULT) {
+        newPriority = 0;
+    } else if ((newPriority < sched_get_priority_min(OsPolicy(newPolicy))) || (newPriority > sched_get_priority_max(OsPolicy(newPolicy)))) {
+        return ER_BAD_ARG_2;
+    }
+#if !defined(QCC_OS_LINUX) && !defined(QCC_OS_ANDROID)
+    if (cpuMask != 0) {
+        return ER_NOT_IMPLEMENTED;
+    }
+#endif
+
+    lock.Lock(MUTEX_CONTEXT);
+    policy = newPolicy;
+    priority = newPriority;
+    cpus = cpuMask;
+    /* Skip 0 on wrap around, it means Set() was never called */
+    generation = (generation == 0xFFFFFFFF) ? 1 : (generation + 1);
+    lock.Unlock(MUTEX_CONTEXT);
+    QCC_DbgHLPrintf(("Dispatch threads scheduled with policy %d priority %d", newPolicy, newPriority));
+
+    if (lockMemory) {
+        /* Page faults on the message path are as bad as being preempted */
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            QCC_LogError(ER_OS_ERROR, ("mlockall failed: %s", strerror(errno)));
+            return ER_OS_ERROR;
+        }
+    }
+    return ER_OK;
+}
+
+void ThreadScheduling::ApplyIfChanged()
+{
+    if (!appliedKeyValid) {
+        return;
+    }
+    uint32_t gen = generation;
+    if (reinterpret_cast<size_t>(pthread_getspecific(appliedKey)) == gen) {
+        return;
+    }
+
+    lock.Lock(MUTEX_CONTEXT);
+    gen = generation;
+    Policy p = policy;
+    int prio = priority;
+    uint64_t mask = cpus;
+    lock.Unlock(MUTEX_CONTEXT);
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = prio;
+    int err = pthread_setschedparam(pthread_self(), OsPolicy(p), &param);
+    if (err != 0) {
+        if (reportedGeneration != gen) {
+            reportedGeneration = gen;
+            QCC_LogError(ER_OS_ERROR, ("Failed to set scheduling policy %d priority %d: %s", p, prio, strerror(err)));
+        }
+    }
+
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+    /* A mask of 0 leaves the affinity the thread inherited (e.g. from taskset or cgroups) alone */
+    if (mask != 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+        for (long cpu = 0; (cpu < numCpus) && (cpu < CPU_SETSIZE) && (cpu < 64); ++cpu) {
+            if (mask & (static_cast<uint64_t>(1) << cpu)) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        /* A mask that names no cpu we have lets the thread run anywhere */
+        if (CPU_COUNT(&cpuSet) == 0) {
+            for (long cpu = 0; (cpu < numCpus) && (cpu < CPU_SETSIZE); ++cpu) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+            if (reportedGeneration != gen) {
+                reportedGeneration = gen;
+                QCC_LogError(ER_OS_ERROR, ("Failed to set cpu affinity: %s", strerror(errno)));
+            }
+        }
+    }
+#endif
+
+    /* Don't retry on failure, the next Set() tries again */
+    pthread_setspecific(appliedKey, reinterpret_cast<void*>(static_cast<size_t>(gen)));
+}
+
+#else
+
+QStatus ThreadScheduling::Set(Policy newPolicy, int newPriority, uint64_t cpuMask, bool lockMemory)
+{
+    return ((newPolicy == POLICY_DEFAULT) && (cpuMask == 0) && !lockMemory) ? ER_OK : ER_NOT_IMPLEMENTED;
+}
+
+void ThreadScheduling::ApplyIfChanged()
+{
+}
+
+#endif
+
+}
@@ -0,0 +1,101 @@
+#ifndef _ALLJOYN_THREADSCHEDULING_H
+#define _ALLJOYN_THREADSCHEDULING_H
+/**
+ * @file
+ * ThreadScheduling gives the threads that dispatch messages a real-time policy and CPU affinity.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include ThreadScheduling.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <qcc/Mutex.h>
+
+#include <alljoyn/Status.h>
+
+namespace ajn {
+
+/**
+ * The local endpoint dispatcher, IODispatch callback and PacketEngine threads are created at
+ * default priority by components that know nothing about each other. Rather than thread the
+ * scheduling through all of them, Set() records one policy for the whole process and each of
+ * those threads calls Apply() from its loop, which changes the calling thread the first time it
+ * runs after Set(). Threads that are blocked pick up a new policy the next time they wake.
+ *
+ * Apply() does nothing until Set() is called. Real-time policies need CAP_SYS_NICE or an
+ * RLIMIT_RTPRIO allowance, a thread that cannot be changed logs an error and keeps running with
+ * the policy it had. Only POSIX platforms are supported, CPU affinity only on Linux and Android.
+ */
+class ThreadScheduling {
+  public:
+
+    /** Scheduling policies */
+    typedef enum {
+        POLICY_DEFAULT = 0,   /**< Time sharing at default priority */
+        POLICY_FIFO = 1,      /**< SCHED_FIFO */
+        POLICY_RR = 2         /**< SCHED_RR */
+    } Policy;
+
+    /**
+     * Set the scheduling of the dispatch threads of the process.
+     *
+     * @param policy      The scheduling policy.
+     * @param priority    Real-time priority for POLICY_FIFO and POLICY_RR, ignored for POLICY_DEFAULT.
+     * @param cpuMask     Bit n set allows the threads to run on cpu n, zero leaves the affinity alone.
+     * @param lockMemory  true to lock all current and future pages of the process into memory.
+     *
+     * @return
+     *      - #ER_OK if the scheduling was recorded.
+     *      - #ER_BAD_ARG_2 if the priority is out of range for the policy.
+     *      - #ER_NOT_IMPLEMENTED if the platform does not support the request.
+     *      - #ER_OS_ERROR if the memory could not be locked. The scheduling is still recorded.
+     */
+    static QStatus Set(Policy policy, int priority, uint64_t cpuMask, bool lockMemory);
+
+    /**
+     * Give the calling thread the scheduling recorded by Set() unless it already has it.
+     */
+    static void Apply()
+    {
+        if (generation != 0) {
+            ApplyIfChanged();
+        }
+    }
+
+    /**
+     * @return  true if Set() restricted the dispatch threads to a set of cpus.
+     */
+    static bool HasAffinity() { return cpus != 0; }
+
+  private:
+
+    static void ApplyIfChanged();
+
+    static qcc::Mutex lock;                 /**< Protects the settings below while they are changed or copied */
+    static volatile uint32_t generation;    /**< Incremented by Set(), 0 if Set() has never been called */
+    static Policy policy;                   /**< Scheduling policy */
+    static int priority;                    /**< Real-time priority */
+    static volatile uint64_t cpus;          /**< Allowed cpus, 0 for any */
+};
+
+}
+
+#endif
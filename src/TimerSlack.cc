@@ -0,0 +1,53 @@
+/**
+ * @file
+ *
+ * This file implements the TimerSlack class.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/time.h>
+
+#include "TimerSlack.h"
+
+using namespace qcc;
+
+namespace ajn {
+
+volatile uint32_t TimerSlack::slack = 0;
+
+uint32_t TimerSlack::Coalesce(uint32_t delayMs)
+{
+    uint32_t s = slack;
+    uint32_t allowance = delayMs / 4;
+    if (allowance > s) {
+        allowance = s;
+    }
+    if (allowance == 0) {
+        return delayMs;
+    }
+    /*
+     * The grid is in absolute time so every timer in the process lines up on the same instants
+     */
+    uint64_t deadline = GetTimestamp64() + delayMs;
+    uint32_t extra = static_cast<uint32_t>((s - (deadline % s)) % s);
+    return (extra <= allowance) ? (delayMs + extra) : delayMs;
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef _ALLJOYN_TIMERSLACK_H
+#define _ALLJOYN_TIMERSLACK_H
+/**
+ * @file
+ * TimerSlack lines up the deadlines of housekeeping timers so they share wakeups.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include TimerSlack.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+namespace ajn {
+
+/**
+ * Timers that reap expired state, retry connections or probe idle links do not need to fire at
+ * an exact time. Their deadlines are passed through Coalesce() which moves a deadline later,
+ * onto a grid of slack sized intervals shared by the whole process, so timers armed
+ * independently by different components and threads expire at the same instant and an idle
+ * process wakes at most once per interval rather than once per timer.
+ *
+ * A deadline is moved by less than the slack and by no more than a quarter of its delay so
+ * short timeouts stay short. The slack is zero, and Coalesce() does nothing, until Set() is
+ * called.
+ */
+class TimerSlack {
+  public:
+
+    /**
+     * Set the slack for the process.
+     *
+     * @param slackMs  Width in milliseconds of the intervals deadlines are moved to the end of,
+     *                 zero to disable coalescing.
+     */
+    static void Set(uint32_t slackMs) { slack = slackMs; }
+
+    /**
+     * @return  The current slack in milliseconds.
+     */
+    static uint32_t Get() { return slack; }
+
+    /**
+     * Coalesce a deadline.
+     *
+     * @param delayMs  Milliseconds from now the timer should fire.
+     *
+     * @return  The delay to arm the timer with, never less than delayMs.
+     */
+    static uint32_t Coalesce(uint32_t delayMs);
+
+  private:
+
+    static volatile uint32_t slack;   /**< Slack in milliseconds, 0 if disabled */
+};
+
+}
+
+#endif
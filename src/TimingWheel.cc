@@ -0,0 +1,166 @@
+/**
+ * @file
+ * Hashed timing wheel used for method call reply timeouts.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <assert.h>
+
+#include "TimingWheel.h"
+
+using namespace std;
+
+namespace ajn {
+
+TimingWheel::TimingWheel(uint64_t now, uint32_t tickMs, size_t numSlots) :
+    tickMs(tickMs ? tickMs : 1),
+    mask(1),
+    currentTick(now / this->tickMs),
+    count(0)
+{
+    while (mask < numSlots) {
+        mask <<= 1;
+    }
+    slots.resize(mask);
+    --mask;
+    for (size_t i = 0; i <= mask; ++i) {
+        slots[i].prev = &slots[i];
+        slots[i].next = &slots[i];
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    vector<Entry*> removed;
+    RemoveAll(removed);
+}
+
+void TimingWheel::Link(Entry& entry)
+{
+    Entry& head = slots[entry.tick & mask];
+    entry.prev = head.prev;
+    entry.next = &head;
+    head.prev->next = &entry;
+    head.prev = &entry;
+    ++count;
+}
+
+void TimingWheel::Unlink(Entry& entry)
+{
+    entry.prev->next = entry.next;
+    entry.next->prev = entry.prev;
+    entry.prev = NULL;
+    entry.next = NULL;
+    --count;
+}
+
+void TimingWheel::Insert(Entry& entry, uint64_t deadline)
+{
+    if (entry.IsScheduled()) {
+        Unlink(entry);
+    }
+    entry.deadline = deadline;
+    /* Round up so an entry never expires before its deadline */
+    entry.tick = (deadline / tickMs) + ((deadline % tickMs) ? 1 : 0);
+    if (entry.tick <= currentTick) {
+        entry.tick = currentTick + 1;
+    }
+    Link(entry);
+}
+
+bool TimingWheel::Remove(Entry& entry)
+{
+    if (entry.IsScheduled()) {
+        Unlink(entry);
+        return true;
+    }
+    return false;
+}
+
+size_t TimingWheel::ExpireSlot(size_t slot, uint64_t nowTick, vector<Entry*>& expired)
+{
+    size_t num = 0;
+    Entry* head = &slots[slot];
+    Entry* e = head->next;
+    while (e != head) {
+        Entry* next = e->next;
+        if (e->tick <= nowTick) {
+            Unlink(*e);
+            expired.push_back(e);
+            ++num;
+        }
+        e = next;
+    }
+    return num;
+}
+
+size_t TimingWheel::Advance(uint64_t now, vector<Entry*>& expired)
+{
+    uint64_t nowTick = now / tickMs;
+    size_t num = 0;
+    if (nowTick <= currentTick) {
+        return 0;
+    }
+    if (count) {
+        if ((nowTick - currentTick) > mask) {
+            /* More than a full revolution has passed so every slot has to be looked at */
+            for (size_t slot = 0; slot <= mask; ++slot) {
+                num += ExpireSlot(slot, nowTick, expired);
+            }
+        } else {
+            for (uint64_t tick = currentTick + 1; tick <= nowTick; ++tick) {
+                num += ExpireSlot(tick & mask, nowTick, expired);
+            }
+        }
+    }
+    currentTick = nowTick;
+    return num;
+}
+
+void TimingWheel::RemoveAll(vector<Entry*>& removed)
+{
+    for (size_t slot = 0; count && (slot <= mask); ++slot) {
+        Entry* head = &slots[slot];
+        while (head->next != head) {
+            Entry* e = head->next;
+            Unlink(*e);
+            removed.push_back(e);
+        }
+    }
+    assert(count == 0);
+}
+
+bool TimingWheel::NextExpiry(uint64_t& when) const
+{
+    if (count == 0) {
+        return false;
+    }
+    for (uint64_t tick = currentTick + 1; tick <= currentTick + mask + 1; ++tick) {
+        const Entry& head = slots[tick & mask];
+        if (head.next != &head) {
+            when = tick * tickMs;
+            return true;
+        }
+    }
+    assert(false);
+    return false;
+}
+
+}
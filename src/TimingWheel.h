@@ -0,0 +1,156 @@
+#ifndef _ALLJOYN_TIMINGWHEEL_H
+#define _ALLJOYN_TIMINGWHEEL_H
+/**
+ * @file
+ * TimingWheel is a hashed timing wheel for large numbers of independent timeouts.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include TimingWheel.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+namespace ajn {
+
+/**
+ * TimingWheel keeps timeouts in a fixed ring of slots, one slot per tick. An entry is linked
+ * into the slot for its expiry tick modulo the number of slots so inserting and removing an
+ * entry are O(1) regardless of how many entries are scheduled. Entries further out than one
+ * revolution share a slot with nearer entries and are skipped until their own tick comes
+ * round. Expiry is never early but may be up to one tick late.
+ *
+ * The wheel does not keep time itself: the owner passes the current time to Advance() and
+ * arms a single timer for NextExpiry(). TimingWheel is not thread-safe.
+ */
+class TimingWheel {
+  public:
+
+    /**
+     * An intrusive wheel entry, normally embedded in the object that owns the timeout.
+     */
+    class Entry {
+        friend class TimingWheel;
+      public:
+        Entry() : deadline(0), tick(0), prev(NULL), next(NULL) { }
+
+        /**
+         * @return  true if the entry is currently linked into a wheel.
+         */
+        bool IsScheduled() const { return prev != NULL; }
+
+        /**
+         * @return  The absolute time in milliseconds passed to the last Insert() call.
+         */
+        uint64_t GetDeadline() const { return deadline; }
+
+      private:
+        uint64_t deadline;
+        uint64_t tick;
+        Entry* prev;
+        Entry* next;
+    };
+
+    /**
+     * Construct a timing wheel.
+     *
+     * @param now       The current time in milliseconds.
+     * @param tickMs    The resolution of the wheel in milliseconds.
+     * @param numSlots  The number of slots, rounded up to a power of two.
+     */
+    TimingWheel(uint64_t now, uint32_t tickMs = 10, size_t numSlots = 1024);
+
+    /**
+     * Destructor. Entries that are still scheduled are unlinked but not otherwise touched.
+     */
+    ~TimingWheel();
+
+    /**
+     * Schedule an entry. An entry that is already scheduled is rescheduled.
+     *
+     * @param entry     The entry to schedule.
+     * @param deadline  Absolute expiry time in milliseconds. Deadlines in the past expire on
+     *                  the next call to Advance().
+     */
+    void Insert(Entry& entry, uint64_t deadline);
+
+    /**
+     * Unschedule an entry.
+     *
+     * @param entry  The entry to unschedule.
+     *
+     * @return  true if the entry was scheduled.
+     */
+    bool Remove(Entry& entry);
+
+    /**
+     * Unschedule every entry whose deadline has been reached.
+     *
+     * @param now      The current time in milliseconds.
+     * @param expired  Expired entries are appended to this vector.
+     *
+     * @return  The number of entries that expired.
+     */
+    size_t Advance(uint64_t now, std::vector<Entry*>& expired);
+
+    /**
+     * Unschedule every entry.
+     *
+     * @param removed  Removed entries are appended to this vector.
+     */
+    void RemoveAll(std::vector<Entry*>& removed);
+
+    /**
+     * Get the time at which Advance() should next be called. The returned time is never later
+     * than the earliest deadline but may be earlier when a slot only holds entries for a
+     * later revolution.
+     *
+     * @param when  Returns the absolute time in milliseconds.
+     *
+     * @return  false if the wheel is empty.
+     */
+    bool NextExpiry(uint64_t& when) const;
+
+    /**
+     * @return  The number of scheduled entries.
+     */
+    size_t Size() const { return count; }
+
+  private:
+
+    /* Copying is not allowed */
+    TimingWheel(const TimingWheel& other);
+    TimingWheel& operator=(const TimingWheel& other);
+
+    void Link(Entry& entry);
+    void Unlink(Entry& entry);
+    size_t ExpireSlot(size_t slot, uint64_t nowTick, std::vector<Entry*>& expired);
+
+    const uint32_t tickMs;      /**< Milliseconds per slot */
+    size_t mask;                /**< Number of slots minus one */
+    std::vector<Entry> slots;   /**< Sentinel list heads, one per slot */
+    uint64_t currentTick;       /**< The last tick that has been processed */
+    size_t count;               /**< Number of scheduled entries */
+};
+
+}
+
+#endif
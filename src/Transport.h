@@ -234,6 +234,15 @@ class Transport {
      */
     virtual void EnableDiscovery(const char* namePrefix) { }
 
+    /**
+     * Ask the network again about names that match a prefix that is already
+     * being discovered.  Names already known are reported from the daemon's
+     * cache straight away; this lets them be refreshed in the background.
+     *
+     * @param namePrefix    Well-known name prefix.
+     */
+    virtual void RefreshDiscovery(const char* namePrefix) { }
+
     /**
      * Stop discovering remotely advertised names that match prefix.
      *
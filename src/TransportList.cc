@@ -32,8 +32,9 @@ using namespace qcc;
 
 namespace ajn {
 
-TransportList::TransportList(BusAttachment& bus, TransportFactoryContainer& factories, IODispatch* m_ioDispatch, uint32_t concurrency)
-    : bus(bus), localTransport(new LocalTransport(bus, concurrency)), m_factories(factories), isStarted(false), isInitialized(false), m_ioDispatch(m_ioDispatch)
+TransportList::TransportList(BusAttachment& bus, TransportFactoryContainer& factories, IODispatchPool* m_ioDispatch, uint32_t concurrency)
+    : bus(bus), localTransport(new LocalTransport(bus, concurrency)), m_factories(factories), isStarted(false), isInitialized(false),
+    deferTransports(false), transportsStarted(false), m_ioDispatch(m_ioDispatch)
 {
 }
 
@@ -166,9 +167,8 @@ QStatus TransportList::Start(const String& transportSpecs)
      * Start all of the transports we determined we selected above.
      */
     QStatus status = localTransport->Start();
-    for (size_t i = 0; i < transportList.size(); ++i) {
-        transportList[i]->SetListener(this);
-        QStatus s = transportList[i]->Start();
+    if (!deferTransports) {
+        QStatus s = StartTransports();
         if (ER_OK == status) {
             status = s;
         }
@@ -183,17 +183,40 @@ QStatus TransportList::Start(const String& transportSpecs)
     return status;
 }
 
+QStatus TransportList::StartTransports()
+{
+    QStatus status = ER_OK;
+    startLock.Lock(MUTEX_CONTEXT);
+    if (!transportsStarted) {
+        QCC_DbgPrintf(("TransportList::StartTransports()"));
+        for (size_t i = 0; i < transportList.size(); ++i) {
+            transportList[i]->SetListener(this);
+            QStatus s = transportList[i]->Start();
+            if (ER_OK == status) {
+                status = s;
+            }
+        }
+        transportsStarted = true;
+    }
+    startLock.Unlock(MUTEX_CONTEXT);
+    return status;
+}
+
 QStatus TransportList::Stop()
 {
     QCC_DbgPrintf(("TransportList::Stop()"));
     isStarted = false;
     QStatus status = localTransport->Stop();
-    for (size_t i = 0; i < transportList.size(); ++i) {
-        QStatus s = transportList[i]->Stop();
-        if (ER_OK == status) {
-            status = s;
+    startLock.Lock(MUTEX_CONTEXT);
+    if (transportsStarted) {
+        for (size_t i = 0; i < transportList.size(); ++i) {
+            QStatus s = transportList[i]->Stop();
+            if (ER_OK == status) {
+                status = s;
+            }
         }
     }
+    startLock.Unlock(MUTEX_CONTEXT);
     /* Stop the iodispatch */
     QStatus s = m_ioDispatch->Stop();
     if (ER_OK == status) {
@@ -207,12 +230,17 @@ QStatus TransportList::Join()
 {
     QStatus status = localTransport->Join();
 
-    for (size_t i = 0; i < transportList.size(); ++i) {
-        QStatus s = transportList[i]->Join();
-        if (ER_OK == status) {
-            status = s;
+    startLock.Lock(MUTEX_CONTEXT);
+    if (transportsStarted) {
+        for (size_t i = 0; i < transportList.size(); ++i) {
+            QStatus s = transportList[i]->Join();
+            if (ER_OK == status) {
+                status = s;
+            }
         }
+        transportsStarted = false;
     }
+    startLock.Unlock(MUTEX_CONTEXT);
     /* Join the iodispatch */
     QStatus s = m_ioDispatch->Join();
     if (ER_OK == status) {
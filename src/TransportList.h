@@ -23,12 +23,13 @@
 
 #include <qcc/platform.h>
 #include <qcc/String.h>
-#include <qcc/IODispatch.h>
+#include <qcc/Mutex.h>
 
 #include <vector>
 
 #include <alljoyn/BusAttachment.h>
 
+#include "IODispatchPool.h"
 #include "LocalTransport.h"
 #include "Transport.h"
 #include "TransportFactory.h"
@@ -45,10 +46,10 @@ class TransportList : public TransportListener {
      *
      * @param bus               The bus associated with this transport list.
      * @param factory           TransportFactoryContainer telling the list how to create its Transports.
-     * @param m_ioDispatch      The IODispatch for this bus.
+     * @param m_ioDispatch      The IODispatch event loops for this bus.
      * @param concurrency       The maximum number of concurrent method and signal handlers locally executing.
      */
-    TransportList(BusAttachment& bus, TransportFactoryContainer& factories, qcc::IODispatch* m_ioDispatch, uint32_t concurrency);
+    TransportList(BusAttachment& bus, TransportFactoryContainer& factories, IODispatchPool* m_ioDispatch, uint32_t concurrency);
 
     /** Destructor  */
     virtual ~TransportList();
@@ -108,6 +109,29 @@ class TransportList : public TransportListener {
      */
     QStatus Start(const qcc::String& transportSpecs);
 
+    /**
+     * Have Start() bring up only the local transport. The other transports are created as usual
+     * but are not started until StartTransports() is called. Must be called before Start().
+     */
+    void DeferTransportStart() { deferTransports = true; }
+
+    /**
+     * Start the transports whose start was deferred by DeferTransportStart(). Does nothing if
+     * the transports have already been started.
+     *
+     * @return
+     *         - ER_OK if successful.
+     *         - An error status if any transport failed to start.
+     */
+    QStatus StartTransports();
+
+    /**
+     * Check if the transports (other than the local transport) have been started.
+     *
+     * @return  true if the transports are running.
+     */
+    bool TransportsStarted() const { return transportsStarted; }
+
     /**
      * Stop all the transports.
      *
@@ -173,7 +197,10 @@ class TransportList : public TransportListener {
     TransportFactoryContainer& m_factories;         /**< container for transport factories */
     bool isStarted;                                 /**< true iff transports are running */
     bool isInitialized;                             /**< true iff transportlist is initialized */
-    qcc::IODispatch* m_ioDispatch;                  /**< pointer to the iodispatch for this bus */
+    bool deferTransports;                           /**< true if Start() leaves transport start to StartTransports() */
+    volatile bool transportsStarted;                /**< true iff the transports other than the local transport are started */
+    qcc::Mutex startLock;                           /**< serializes starting and stopping the transports */
+    IODispatchPool* m_ioDispatch;                   /**< pointer to the iodispatch event loops for this bus */
 };
 
 }  /* namespace */
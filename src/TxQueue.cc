@@ -0,0 +1,285 @@
+/**
+ * @file
+ * TxQueue is the bounded transmit queue used by RemoteEndpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+#include <qcc/time.h>
+
+#include "MemoryAccounting.h"
+#include "TxQueue.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+
+namespace ajn {
+
+/* Number of slots allocated when the first message is queued */
+static const size_t MIN_SLOTS = 4;
+
+/* Bytes of ring storage per slot */
+static const size_t SLOT_BYTES = sizeof(Message) + 2 * sizeof(uint64_t) + sizeof(uint8_t);
+
+TxQueue::TxQueue(const Message& placeholder, size_t maxMessages) :
+    placeholder(placeholder),
+    capacity((std::max)(maxMessages, (size_t)1)),
+    virtualTime(0),
+    barrier(0),
+    head(0),
+    count(0),
+    bytes(0),
+    numExpirable(0),
+    nextExpire(0)
+{
+}
+
+TxQueue::~TxQueue()
+{
+    Clear();
+    Resize(0);
+}
+
+size_t TxQueue::MessageBytes(const Message& msg)
+{
+    return msg->bufEOD - reinterpret_cast<uint8_t*>(msg->msgBuf);
+}
+
+void TxQueue::SetMaxMessages(size_t maxMessages)
+{
+    capacity = (std::max)((std::max)(maxMessages, (size_t)1), count);
+    if (ring.size() > capacity) {
+        Resize(capacity);
+    }
+}
+
+void TxQueue::Resize(size_t slots)
+{
+    if (slots != ring.size()) {
+        if (!ring.empty()) {
+            MemoryAccounting::Released(MemoryAccounting::MEM_ENDPOINT_BUFFERS, ring.size() * SLOT_BYTES);
+        }
+        if (slots) {
+            MemoryAccounting::Allocated(MemoryAccounting::MEM_ENDPOINT_BUFFERS, slots * SLOT_BYTES);
+        }
+        std::vector<Message> newRing(slots, placeholder);
+        std::vector<uint64_t> newQueuedAt(slots, 0);
+        std::vector<uint8_t> newPriority(slots, PRIORITY_INTERACTIVE);
+        std::vector<uint64_t> newFinish(slots, 0);
+        for (size_t i = 0; i < count; ++i) {
+            newRing[i] = ring[Slot(i)];
+            newQueuedAt[i] = queuedAt[Slot(i)];
+            newPriority[i] = priority[Slot(i)];
+            newFinish[i] = finish[Slot(i)];
+        }
+        ring.swap(newRing);
+        queuedAt.swap(newQueuedAt);
+        priority.swap(newPriority);
+        finish.swap(newFinish);
+        head = 0;
+    }
+}
+
+void TxQueue::Move(size_t to, size_t from)
+{
+    ring[Slot(to)] = ring[Slot(from)];
+    queuedAt[Slot(to)] = queuedAt[Slot(from)];
+    priority[Slot(to)] = priority[Slot(from)];
+    finish[Slot(to)] = finish[Slot(from)];
+}
+
+void TxQueue::Push(const Message& msg, uint64_t queuedAt, Priority priority)
+{
+    assert(!Full());
+    if (count == ring.size()) {
+        Resize((std::min)(capacity, (std::max)(2 * ring.size(), MIN_SLOTS)));
+    }
+    /*
+     * A message finishes, in virtual time, its size after the later of the last message of its
+     * session and the last message that is not in a session. Messages in no session or sent by
+     * the daemon itself, e.g. the reply to a join, can't be overtaken by session traffic.
+     */
+    uint32_t sessionId = msg->GetSessionId();
+    uint64_t start = (std::max)(virtualTime, barrier);
+    if (sessionId != 0) {
+        std::map<uint32_t, uint64_t>::iterator it = sessionFinish.find(sessionId);
+        if (it != sessionFinish.end()) {
+            start = (std::max)(start, it->second);
+        }
+    }
+    uint64_t tag = start + MessageBytes(msg);
+    size_t pos = count;
+    if (sessionId != 0) {
+        sessionFinish[sessionId] = tag;
+    } else {
+        barrier = tag;
+    }
+    if ((sessionId != 0) || (priority == PRIORITY_CONTROL)) {
+        /* Lower priority messages and messages that finish later make way */
+        while ((pos > 0) && ((this->priority[Slot(pos - 1)] > priority) || ((this->priority[Slot(pos - 1)] == priority) && (finish[Slot(pos - 1)] > tag)))) {
+            Move(pos, pos - 1);
+            --pos;
+        }
+    }
+    ring[Slot(pos)] = msg;
+    this->queuedAt[Slot(pos)] = queuedAt;
+    this->priority[Slot(pos)] = static_cast<uint8_t>(priority);
+    finish[Slot(pos)] = tag;
+    ++count;
+    bytes += MessageBytes(msg);
+    if (sessionId != 0) {
+        std::pair<size_t, size_t>& usage = sessionUsage[sessionId];
+        ++usage.first;
+        usage.second += MessageBytes(msg);
+    }
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_TX_QUEUES, MessageBytes(msg));
+    if (msg->IsUnreliable()) {
+        uint32_t expMs;
+        msg->IsExpired(&expMs);
+        uint32_t expire = qcc::GetTimestamp() + expMs;
+        /* Timestamps wrap so compare the difference */
+        if ((numExpirable == 0) || (static_cast<int32_t>(expire - nextExpire) < 0)) {
+            nextExpire = expire;
+        }
+        ++numExpirable;
+    }
+}
+
+void TxQueue::Released(const Message& msg)
+{
+    bytes -= MessageBytes(msg);
+    uint32_t sessionId = msg->GetSessionId();
+    if (sessionId != 0) {
+        std::map<uint32_t, std::pair<size_t, size_t> >::iterator it = sessionUsage.find(sessionId);
+        if (it != sessionUsage.end()) {
+            it->second.second -= MessageBytes(msg);
+            if (--it->second.first == 0) {
+                sessionUsage.erase(it);
+            }
+        }
+    }
+    MemoryAccounting::Released(MemoryAccounting::MEM_TX_QUEUES, MessageBytes(msg));
+    /* nextExpire is left alone, it is still no later than the first expiry of those remaining */
+    if (msg->IsUnreliable()) {
+        --numExpirable;
+    }
+}
+
+void TxQueue::GetSessionUsage(uint32_t sessionId, size_t& messages, size_t& bytes) const
+{
+    std::map<uint32_t, std::pair<size_t, size_t> >::const_iterator it = sessionUsage.find(sessionId);
+    messages = (it != sessionUsage.end()) ? it->second.first : 0;
+    bytes = (it != sessionUsage.end()) ? it->second.second : 0;
+}
+
+void TxQueue::Pop()
+{
+    assert(!Empty());
+    Released(ring[head]);
+    ring[head] = placeholder;
+    virtualTime = (std::max)(virtualTime, finish[head]);
+    head = Slot(1);
+    --count;
+    /* Sessions whose messages have all left can't be ahead of the virtual time */
+    if (count == 0) {
+        sessionFinish.clear();
+        /* A ring no bigger than MIN_SLOTS is kept for the next message, one grown by a burst is given back */
+        if (ring.size() > MIN_SLOTS) {
+            Resize(0);
+        }
+    } else if (sessionFinish.size() > 2 * count) {
+        std::map<uint32_t, uint64_t>::iterator it = sessionFinish.begin();
+        while (it != sessionFinish.end()) {
+            if (it->second <= virtualTime) {
+                sessionFinish.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool TxQueue::RemoveOldestSignal(uint32_t sessionId)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if ((ring[Slot(i)]->GetType() == MESSAGE_SIGNAL) && ((sessionId == 0) || (ring[Slot(i)]->GetSessionId() == sessionId))) {
+            Released(ring[Slot(i)]);
+            /* Close the gap preserving the order of the remaining messages */
+            for (size_t j = i + 1; j < count; ++j) {
+                Move(j - 1, j);
+            }
+            ring[Slot(count - 1)] = placeholder;
+            --count;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TxQueue::RemoveExpired(uint32_t& nextExpireMs)
+{
+    if (numExpirable == 0) {
+        return 0;
+    }
+    uint32_t now = qcc::GetTimestamp();
+    int32_t untilExpire = static_cast<int32_t>(nextExpire - now);
+    if (untilExpire > 0) {
+        nextExpireMs = (std::min)(nextExpireMs, static_cast<uint32_t>(untilExpire));
+        return 0;
+    }
+    /* Something may have expired, compact the queue and find the new earliest expiry */
+    uint32_t earliest = (std::numeric_limits<uint32_t>::max)();
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Message& msg = ring[Slot(i)];
+        uint32_t expMs;
+        if (msg->IsExpired(&expMs)) {
+            Released(msg);
+            continue;
+        }
+        earliest = (std::min)(earliest, expMs);
+        if (kept != i) {
+            Move(kept, i);
+        }
+        ++kept;
+    }
+    size_t removed = count - kept;
+    for (size_t i = kept; i < count; ++i) {
+        ring[Slot(i)] = placeholder;
+    }
+    count = kept;
+    if (numExpirable) {
+        nextExpire = now + earliest;
+        nextExpireMs = (std::min)(nextExpireMs, earliest);
+    }
+    return removed;
+}
+
+void TxQueue::Clear()
+{
+    while (!Empty()) {
+        Pop();
+    }
+}
+
+}
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * TxQueue is the bounded transmit queue used by RemoteEndpoint.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _ALLJOYN_TXQUEUE_H
+#define _ALLJOYN_TXQUEUE_H
+
+#include <qcc/platform.h>
+
+#include <map>
+#include <vector>
+
+#include <alljoyn/Message.h>
+
+namespace ajn {
+
+/**
+ * TxQueue is a fixed capacity ring of messages waiting to be transmitted. The ring
+ * storage is allocated up front so queueing a message never allocates. TxQueue is
+ * not thread-safe; the owner is responsible for serializing access to it.
+ *
+ * Each message is queued with a priority. Messages leave the queue in priority order. Within
+ * a priority the messages of different sessions are interleaved so each session gets a fair
+ * share of the bytes sent (self-clocked fair queuing), and the messages of one session stay in
+ * the order they were pushed. Messages that are not part of a session are never overtaken by
+ * anything pushed after them except control messages.
+ *
+ * The ring that holds the messages is only allocated while there is something queued, so an idle
+ * connection costs nothing beyond the queue object itself.
+ *
+ * The queue remembers how many of its messages have a time-to-live and the earliest time one
+ * of them can expire, so checking for expired messages costs nothing until one actually has.
+ */
+class TxQueue {
+  public:
+
+    /**
+     * Transmit priorities, lower values are sent first.
+     */
+    typedef enum {
+        PRIORITY_CONTROL = 0,       /**< Daemon link maintenance such as link timeout probes */
+        PRIORITY_INTERACTIVE = 1,   /**< Default for all other traffic */
+        PRIORITY_BULK = 2           /**< Traffic of sessions that asked to yield to the rest */
+    } Priority;
+
+    /**
+     * Constructor
+     *
+     * @param placeholder   Message used to fill unoccupied slots so they hold no reference
+     *                      to messages that have left the queue.
+     * @param maxMessages   Maximum number of messages the queue can hold (at least 1).
+     */
+    TxQueue(const Message& placeholder, size_t maxMessages);
+
+    /**
+     * Destructor
+     */
+    ~TxQueue();
+
+    /**
+     * Get the number of messages in the queue.
+     */
+    size_t Size() const { return count; }
+
+    /**
+     * Return true if the queue is empty.
+     */
+    bool Empty() const { return count == 0; }
+
+    /**
+     * Return true if the queue is full.
+     */
+    bool Full() const { return count >= capacity; }
+
+    /**
+     * Get the total size in bytes of the marshaled messages in the queue.
+     */
+    size_t GetBytes() const { return bytes; }
+
+    /**
+     * Get the size in bytes of a marshaled message as it is accounted by the queue.
+     *
+     * @param msg   The message.
+     */
+    static size_t MessageBytes(const Message& msg);
+
+    /**
+     * Get the number and total size of the queued messages of one session.
+     *
+     * @param sessionId       The session, not 0.
+     * @param[out] messages   Number of the session's messages in the queue.
+     * @param[out] bytes      Total size of those messages.
+     */
+    void GetSessionUsage(uint32_t sessionId, size_t& messages, size_t& bytes) const;
+
+    /**
+     * Get the maximum number of messages the queue can hold.
+     */
+    size_t GetMaxMessages() const { return capacity; }
+
+    /**
+     * Change the maximum number of messages the queue can hold. The capacity is never
+     * reduced below the number of messages currently queued.
+     *
+     * @param maxMessages   New maximum number of messages (at least 1).
+     */
+    void SetMaxMessages(size_t maxMessages);
+
+    /**
+     * Add a message to the queue at the place its priority and session's share of the queue
+     * entitle it to. The queue must not be full.
+     *
+     * @param msg        Message to add.
+     * @param queuedAt   Latency clock time at which the message was queued, 0 if not recorded.
+     * @param priority   Transmit priority of the message.
+     */
+    void Push(const Message& msg, uint64_t queuedAt = 0, Priority priority = PRIORITY_INTERACTIVE);
+
+    /**
+     * Get the message at the front (oldest end) of the queue. The queue must not be empty.
+     */
+    Message& Front() { return ring[head]; }
+
+    /**
+     * Get the i'th message from the front of the queue. i must be less than Size().
+     */
+    Message& At(size_t i) { return ring[Slot(i)]; }
+
+    /**
+     * Get the latency clock time at which the i'th message from the front was queued. i must be
+     * less than Size().
+     */
+    uint64_t QueuedAt(size_t i) const { return queuedAt[Slot(i)]; }
+
+    /**
+     * Remove the message at the front of the queue. The queue must not be empty.
+     */
+    void Pop();
+
+    /**
+     * Remove the oldest signal from the queue. Method calls, replies and errors are never
+     * removed by this call.
+     *
+     * @param sessionId  Only remove a signal of this session, 0 for a signal of any session.
+     *
+     * @return  true if a signal was removed, false if there are no such signals in the queue.
+     */
+    bool RemoveOldestSignal(uint32_t sessionId = 0);
+
+    /**
+     * Return true if any of the queued messages has a time-to-live.
+     */
+    bool HasExpirable() const { return numExpirable != 0; }
+
+    /**
+     * Remove all messages whose time-to-live has expired. The queue is only scanned if the
+     * earliest expiry time has passed.
+     *
+     * @param nextExpireMs   [IN/OUT] Reduced to the number of ms until the next queued
+     *                       message with a time-to-live expires.
+     *
+     * @return  The number of messages removed.
+     */
+    size_t RemoveExpired(uint32_t& nextExpireMs);
+
+    /**
+     * Remove all messages from the queue.
+     */
+    void Clear();
+
+  private:
+
+    /** Index of the i'th message from the front */
+    size_t Slot(size_t i) const { return (head + i) % ring.size(); }
+
+    /** Reallocate the ring with room for slots messages, keeping the queued ones in order */
+    void Resize(size_t slots);
+
+    /** Account for a message leaving the queue */
+    void Released(const Message& msg);
+
+    /** Move the from'th message from the front to the to'th place, including its bookkeeping */
+    void Move(size_t to, size_t from);
+
+    Message placeholder;          /**< Occupies empty slots */
+    size_t capacity;              /**< Maximum number of messages */
+    std::vector<Message> ring;    /**< Ring storage, grown on demand up to capacity and released when the queue empties */
+    std::vector<uint64_t> queuedAt; /**< Time each message in the ring was queued, parallel to ring */
+    std::vector<uint8_t> priority;  /**< Priority of each message in the ring, parallel to ring */
+    std::vector<uint64_t> finish;   /**< Fair queuing finish tag of each message, parallel to ring */
+    std::map<uint32_t, uint64_t> sessionFinish; /**< Finish tag of the last message pushed for each session */
+    std::map<uint32_t, std::pair<size_t, size_t> > sessionUsage; /**< Messages and bytes queued for each session that has any */
+    uint64_t virtualTime;         /**< Finish tag of the last message to leave the front */
+    uint64_t barrier;             /**< Finish tag of the last message pushed that is not in a session */
+    size_t head;                  /**< Slot of the oldest message */
+    size_t count;                 /**< Number of queued messages */
+    size_t bytes;                 /**< Total size of the queued messages */
+    size_t numExpirable;          /**< Number of queued messages with a time-to-live */
+    uint32_t nextExpire;          /**< Timestamp at or before which the first of those expires */
+};
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file
+ * ValidationCache remembers header strings and body signatures that an endpoint has already
+ * sent and that have been found to be valid.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include <qcc/String.h>
+
+#include "MemoryAccounting.h"
+#include "ValidationCache.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+namespace ajn {
+
+volatile bool ValidationCache::pedantic = false;
+
+ValidationCache::ValidationCache() : entries(NULL)
+{
+}
+
+ValidationCache::~ValidationCache()
+{
+    Clear();
+}
+
+uint32_t ValidationCache::Hash(uint32_t kind, const char* str, size_t len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U ^ kind;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(str[i])) * 16777619U;
+    }
+    return hash;
+}
+
+bool ValidationCache::Lookup(uint32_t kind, const char* str, size_t len, uint32_t& info) const
+{
+    if (!entries) {
+        return false;
+    }
+    uint32_t hash = Hash(kind, str, len);
+    const Entry& entry = entries[hash % NUM_ENTRIES];
+    if ((entry.kind == kind) && (entry.hash == hash) && (entry.value.size() == len) && (::memcmp(entry.value.data(), str, len) == 0)) {
+        info = entry.info;
+        return true;
+    }
+    return false;
+}
+
+void ValidationCache::Insert(uint32_t kind, const char* str, size_t len, uint32_t info)
+{
+    if (!entries) {
+        entries = new Entry[NUM_ENTRIES];
+        for (size_t i = 0; i < NUM_ENTRIES; ++i) {
+            entries[i].kind = 0;
+            entries[i].hash = 0;
+            entries[i].info = 0;
+        }
+        MemoryAccounting::Allocated(MemoryAccounting::MEM_ENDPOINT_BUFFERS, NUM_ENTRIES * sizeof(Entry));
+    }
+    uint32_t hash = Hash(kind, str, len);
+    Entry& entry = entries[hash % NUM_ENTRIES];
+    entry.kind = kind;
+    entry.hash = hash;
+    entry.info = info;
+    entry.value.assign(str, len);
+}
+
+void ValidationCache::Clear()
+{
+    if (entries) {
+        delete [] entries;
+        entries = NULL;
+        MemoryAccounting::Released(MemoryAccounting::MEM_ENDPOINT_BUFFERS, NUM_ENTRIES * sizeof(Entry));
+    }
+}
+
+}
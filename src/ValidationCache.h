@@ -0,0 +1,123 @@
+#ifndef _ALLJOYN_VALIDATIONCACHE_H
+#define _ALLJOYN_VALIDATIONCACHE_H
+/**
+ * @file
+ * ValidationCache remembers header strings and body signatures that an endpoint has already
+ * sent and that have been found to be valid.
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include ValidationCache.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+
+namespace ajn {
+
+/**
+ * Most messages received on an endpoint repeat the same object paths, interface and member
+ * names, bus names and body signatures. Each endpoint keeps a small direct-mapped cache of the
+ * values it has already validated so that a repeated value is checked with a single compare.
+ * The cache is only used by the thread that reads from the endpoint so it is not locked.
+ *
+ * Pedantic validation turns the caches off, and also turns on UTF-8 validation of the strings in
+ * message bodies.
+ */
+class ValidationCache {
+  public:
+
+    /**
+     * Number of entries in the cache.
+     */
+    static const size_t NUM_ENTRIES = 64;
+
+    /**
+     * Constructor. The entries are only allocated once a value is inserted so an endpoint that
+     * never receives anything does not pay for them.
+     */
+    ValidationCache();
+
+    /**
+     * Destructor
+     */
+    ~ValidationCache();
+
+    /**
+     * Look up a value that has been validated before.
+     *
+     * @param kind   What the value is, e.g. the header field id.
+     * @param str    The value.
+     * @param len    The length of the value.
+     * @param info   [OUT] Information stored with the value.
+     *
+     * @return true if the value is in the cache.
+     */
+    bool Lookup(uint32_t kind, const char* str, size_t len, uint32_t& info) const;
+
+    /**
+     * Add a value that has been validated, replacing any value that shares its entry.
+     *
+     * @param kind   What the value is, e.g. the header field id.
+     * @param str    The value.
+     * @param len    The length of the value.
+     * @param info   Information to store with the value.
+     */
+    void Insert(uint32_t kind, const char* str, size_t len, uint32_t info);
+
+    /**
+     * Forget all cached values.
+     */
+    void Clear();
+
+    /**
+     * Turn pedantic validation on or off for the whole process.
+     *
+     * @param enable  true to validate every value of every message.
+     */
+    static void SetPedantic(bool enable) { pedantic = enable; }
+
+    /**
+     * Return true if pedantic validation is on.
+     */
+    static bool IsPedantic() { return pedantic; }
+
+  private:
+
+    struct Entry {
+        uint32_t kind;         /**< What the value is, 0 if the entry is unused */
+        uint32_t hash;         /**< Hash of kind and value */
+        uint32_t info;         /**< Caller's information */
+        qcc::String value;     /**< The validated value */
+    };
+
+    /* Copying is not allowed */
+    ValidationCache(const ValidationCache& other);
+    ValidationCache& operator=(const ValidationCache& other);
+
+    static uint32_t Hash(uint32_t kind, const char* str, size_t len);
+
+    static volatile bool pedantic;
+
+    Entry* entries;            /**< NUM_ENTRIES entries or NULL until the first insert */
+};
+
+}
+
+#endif
@@ -180,35 +180,41 @@ QStatus XmlHelper::ParseInterface(const XmlElement* elem, ProxyBusObject* obj)
     }
     /* Add the interface with all its methods, signals and properties */
     if (ER_OK == status) {
-        InterfaceDescription* newIntf = NULL;
-        status = bus->CreateInterface(intf.GetName(), newIntf);
-        if (ER_OK == status) {
-            /* Assign new interface */
-            *newIntf = intf;
-            newIntf->Activate();
-            if (obj) {
-                obj->AddInterface(*newIntf);
-            }
-        } else if (ER_BUS_IFACE_ALREADY_EXISTS == status) {
-            /* Make sure definition matches existing one */
-            const InterfaceDescription* existingIntf = bus->GetInterface(intf.GetName());
-            if (existingIntf) {
-                if (*existingIntf == intf) {
-                    if (obj) {
-                        obj->AddInterface(*existingIntf);
-                    }
-                    status = ER_OK;
-                } else {
-                    status = ER_BUS_INTERFACE_MISMATCH;
-                    QCC_LogError(status, ("XML interface does not match existing definition for \"%s\"", intf.GetName()));
+        status = AddInterface(intf, obj);
+    }
+    return status;
+}
+
+QStatus XmlHelper::AddInterface(const InterfaceDescription& intf, ProxyBusObject* obj)
+{
+    InterfaceDescription* newIntf = NULL;
+    QStatus status = bus->CreateInterface(intf.GetName(), newIntf);
+    if (ER_OK == status) {
+        /* Assign new interface */
+        *newIntf = intf;
+        newIntf->Activate();
+        if (obj) {
+            obj->AddInterface(*newIntf);
+        }
+    } else if (ER_BUS_IFACE_ALREADY_EXISTS == status) {
+        /* Make sure definition matches existing one */
+        const InterfaceDescription* existingIntf = bus->GetInterface(intf.GetName());
+        if (existingIntf) {
+            if (*existingIntf == intf) {
+                if (obj) {
+                    obj->AddInterface(*existingIntf);
                 }
+                status = ER_OK;
             } else {
-                status = ER_FAIL;
-                QCC_LogError(status, ("Failed to retrieve existing interface \"%s\"", intf.GetName()));
+                status = ER_BUS_INTERFACE_MISMATCH;
+                QCC_LogError(status, ("Introspected interface does not match existing definition for \"%s\"", intf.GetName()));
             }
         } else {
-            QCC_LogError(status, ("Failed to create new inteface \"%s\"", intf.GetName()));
+            status = ER_FAIL;
+            QCC_LogError(status, ("Failed to retrieve existing interface \"%s\"", intf.GetName()));
         }
+    } else {
+        QCC_LogError(status, ("Failed to create new inteface \"%s\"", intf.GetName()));
     }
     return status;
 }
@@ -262,4 +268,155 @@ QStatus XmlHelper::ParseNode(const XmlElement* root, ProxyBusObject* obj)
     return status;
 }
 
+QStatus XmlHelper::ParseCompactInterface(const MsgArg& arg, ProxyBusObject* obj)
+{
+    const char* ifName;
+    size_t numAnnotations;
+    MsgArg* annotations;
+    size_t numMembers;
+    MsgArg* members;
+    size_t numProps;
+    MsgArg* props;
+
+    QStatus status = arg.Get("(sa{ss}a(ysssa{ss})a(ssya{ss}))", &ifName, &numAnnotations, &annotations, &numMembers, &members, &numProps, &props);
+    if (ER_OK != status) {
+        QCC_LogError(status, ("Malformed interface in compact introspection data for %s", ident));
+        return status;
+    }
+    if (!IsLegalInterfaceName(ifName)) {
+        status = ER_BUS_BAD_INTERFACE_NAME;
+        QCC_LogError(status, ("Invalid interface name \"%s\" in compact introspection data for %s", ifName, ident));
+        return status;
+    }
+
+    /* The secure annotation is carried with the other interface annotations */
+    InterfaceDescription intf(ifName, false);
+    for (size_t i = 0; (ER_OK == status) && (i < numAnnotations); ++i) {
+        const char* name;
+        const char* value;
+        status = annotations[i].Get("{ss}", &name, &value);
+        if (ER_OK == status) {
+            status = intf.AddAnnotation(name, value);
+        }
+    }
+
+    /* Methods and signals */
+    for (size_t i = 0; (ER_OK == status) && (i < numMembers); ++i) {
+        uint8_t type;
+        const char* memberName;
+        const char* inSig;
+        const char* outSig;
+        const char* argNames;
+        size_t numMemberAnnotations;
+        MsgArg* memberAnnotations;
+        status = members[i].Get("(ysssa{ss})", &type, &memberName, &inSig, &outSig, &argNames, &numMemberAnnotations, &memberAnnotations);
+        if (ER_OK != status) {
+            break;
+        }
+        if (!IsLegalMemberName(memberName)) {
+            status = ER_BUS_BAD_MEMBER_NAME;
+            QCC_LogError(status, ("Illegal member name \"%s\" compact introspection data for %s", memberName, ident));
+            break;
+        }
+        if ((type != MESSAGE_METHOD_CALL) && (type != MESSAGE_SIGNAL)) {
+            status = ER_BUS_BAD_VALUE;
+            QCC_LogError(status, ("Invalid type for member %s in compact introspection data for %s", memberName, ident));
+            break;
+        }
+        status = intf.AddMember((AllJoynMessageType)type, memberName, inSig, outSig, argNames[0] ? argNames : NULL);
+        for (size_t j = 0; (ER_OK == status) && (j < numMemberAnnotations); ++j) {
+            const char* name;
+            const char* value;
+            status = memberAnnotations[j].Get("{ss}", &name, &value);
+            if (ER_OK == status) {
+                status = intf.AddMemberAnnotation(memberName, name, value);
+            }
+        }
+    }
+
+    /* Properties */
+    for (size_t i = 0; (ER_OK == status) && (i < numProps); ++i) {
+        const char* propName;
+        const char* sig;
+        uint8_t access;
+        size_t numPropAnnotations;
+        MsgArg* propAnnotations;
+        status = props[i].Get("(ssya{ss})", &propName, &sig, &access, &numPropAnnotations, &propAnnotations);
+        if (ER_OK != status) {
+            break;
+        }
+        if (!SignatureUtils::IsCompleteType(sig)) {
+            status = ER_BUS_BAD_SIGNATURE;
+            QCC_LogError(status, ("Invalid signature for property %s in compact introspection data from %s", propName, ident));
+            break;
+        }
+        if (!propName[0]) {
+            status = ER_BUS_BAD_BUS_NAME;
+            QCC_LogError(status, ("Invalid name for property in compact introspection data from %s", ident));
+            break;
+        }
+        status = intf.AddProperty(propName, sig, access & PROP_ACCESS_RW);
+        for (size_t j = 0; (ER_OK == status) && (j < numPropAnnotations); ++j) {
+            const char* name;
+            const char* value;
+            status = propAnnotations[j].Get("{ss}", &name, &value);
+            if (ER_OK == status) {
+                status = intf.AddPropertyAnnotation(propName, name, value);
+            }
+        }
+    }
+
+    if (ER_OK == status) {
+        status = AddInterface(intf, obj);
+    } else {
+        QCC_LogError(status, ("Failed to parse interface \"%s\" in compact introspection data for %s", ifName, ident));
+    }
+    return status;
+}
+
+QStatus XmlHelper::AddProxyObjects(ProxyBusObject& parent, const MsgArg& children, const MsgArg& interfaces)
+{
+    size_t numChildren;
+    MsgArg* childNames;
+    size_t numIfaces;
+    MsgArg* ifaces;
+
+    QStatus status = children.Get("as", &numChildren, &childNames);
+    if (ER_OK == status) {
+        status = interfaces.Get("a(sa{ss}a(ysssa{ss})a(ssya{ss}))", &numIfaces, &ifaces);
+    }
+    if (ER_OK != status) {
+        QCC_LogError(status, ("Malformed compact introspection data for %s", ident));
+        return status;
+    }
+
+    for (size_t i = 0; (ER_OK == status) && (i < numIfaces); ++i) {
+        status = ParseCompactInterface(ifaces[i], &parent);
+    }
+
+    /* The compact form, like shallow introspection XML, only names the children */
+    for (size_t i = 0; (ER_OK == status) && (i < numChildren); ++i) {
+        const char* relativePath;
+        status = childNames[i].Get("s", &relativePath);
+        if (ER_OK != status) {
+            break;
+        }
+        qcc::String childObjPath = parent.GetPath();
+        if (childObjPath.size() > 1) {
+            childObjPath += '/';
+        }
+        childObjPath += relativePath;
+        if (relativePath[0] && IsLegalObjectPath(childObjPath.c_str())) {
+            if (!parent.GetChild(relativePath)) {
+                ProxyBusObject newChild(*bus, parent.GetServiceName().c_str(), childObjPath.c_str(), parent.sessionId);
+                status = parent.AddChild(newChild);
+            }
+        } else {
+            status = ER_FAIL;
+            QCC_LogError(status, ("Illegal child object name \"%s\" specified in introspection for %s", relativePath, ident));
+        }
+    }
+    return status;
+}
+
 } // ajn::
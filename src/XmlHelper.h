@@ -34,6 +34,7 @@
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/ProxyBusObject.h>
 #include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/MsgArg.h>
 
 #include <alljoyn/Status.h>
 
@@ -85,10 +86,25 @@ class XmlHelper {
         }
     }
 
+    /**
+     * Add the children and interfaces from a reply to org.alljoyn.Bus.Introspectable.IntrospectCompact
+     * to a proxy object.
+     *
+     * @param parent      The proxy object that was introspected.
+     * @param children    The array of child object names from the reply.
+     * @param interfaces  The array of interfaces from the reply.
+     *
+     * @return #ER_OK if the reply was well formed and the children and interfaces were added.
+     *         #Other errors indicating the children or interfaces were not succesfully added.
+     */
+    QStatus AddProxyObjects(ProxyBusObject& parent, const MsgArg& children, const MsgArg& interfaces);
+
   private:
 
     QStatus ParseNode(const qcc::XmlElement* elem, ProxyBusObject* obj);
     QStatus ParseInterface(const qcc::XmlElement* elem, ProxyBusObject* obj);
+    QStatus ParseCompactInterface(const MsgArg& arg, ProxyBusObject* obj);
+    QStatus AddInterface(const InterfaceDescription& intf, ProxyBusObject* obj);
 
     BusAttachment* bus;
     const char* ident;
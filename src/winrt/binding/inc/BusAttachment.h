@@ -29,6 +29,7 @@
 #include <qcc/Mutex.h>
 #include <Status_CPP0x.h>
 #include <map>
+#include <vector>
 
 namespace AllJoyn {
 
@@ -221,6 +222,24 @@ ref class __BusAttachment {
     property uint32_t Timestamp;
 };
 
+ref class __CallbackBatch {
+  private:
+    friend class _BusAttachment;
+    __CallbackBatch(Windows::UI::Core::CoreDispatcher ^ dispatcher, uint32_t maxLatency);
+    ~__CallbackBatch();
+
+    // Queue a callback, the first callback of a batch schedules the dispatcher hop
+    void Add(Windows::UI::Core::DispatchedHandler ^ callback);
+    // Run the queued callbacks, called on the dispatcher thread
+    void Drain();
+
+    Windows::UI::Core::CoreDispatcher ^ _dispatcher;
+    uint32_t _maxLatency;
+    bool _scheduled;
+    std::vector<Windows::UI::Core::DispatchedHandler ^> _callbacks;
+    qcc::Mutex _mutex;
+};
+
 class _BusAttachment : protected ajn::BusAttachment, protected ajn::BusAttachment::JoinSessionAsyncCB, protected ajn::BusAttachment::SetLinkTimeoutAsyncCB {
   protected:
     friend class qcc::ManagedObj<_BusAttachment>;
@@ -242,12 +261,15 @@ class _BusAttachment : protected ajn::BusAttachment, protected ajn::BusAttachmen
     void JoinSessionCB(::QStatus s, ajn::SessionId sessionId, const ajn::SessionOpts& opts, void* context);
     void SetLinkTimeoutCB(::QStatus s, uint32_t timeout, void* context);
     void DispatchCallback(Windows::UI::Core::DispatchedHandler ^ callback);
+    void DispatchBatchedCallback(Windows::UI::Core::DispatchedHandler ^ callback);
+    bool NeedsDispatcherHop();
     bool IsOriginSTA();
 
     __BusAttachment ^ _eventsAndProperties;
     KeyStoreListener ^ _keyStoreListener;
     AuthListener ^ _authListener;
     Windows::UI::Core::CoreDispatcher ^ _dispatcher;
+    __CallbackBatch ^ _callbackBatch;
     bool _originSTA;
     std::map<void*, void*> _busObjectMap;
     std::map<void*, void*> _signalHandlerMap;
@@ -283,6 +305,20 @@ public ref class BusAttachment sealed {
     /// </summary>
     void EnableConcurrentCallbacks();
 
+    /// <summary>
+    /// Deliver signals and name and session notifications to the dispatcher thread in batches.
+    /// </summary>
+    /// <remarks>
+    /// By default each callback makes its own hop to the dispatcher thread of the STA that created
+    /// the bus attachment and the AllJoyn thread waits for it to finish. With batching on, these
+    /// callbacks are queued and run together in a single hop no later than maxLatency ms after the
+    /// first of them arrived, and the AllJoyn thread does not wait. Method calls and callbacks that
+    /// return a value are never batched but do run after any callbacks queued before them.
+    /// Has no effect when the bus attachment was not created on a UI thread.
+    /// </remarks>
+    /// <param name="maxLatency">Longest time in ms a callback may wait for its batch, 0 turns batching off.</param>
+    void EnableBatchedCallbacks(uint32_t maxLatency);
+
     /// <summary>
     /// Create an interface description with a given name.
     /// </summary>
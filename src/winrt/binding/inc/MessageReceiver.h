@@ -181,9 +181,11 @@ class _MessageReceiver : protected ajn::MessageReceiver {
                     status = ER_OUT_OF_MEMORY;
                     break;
                 }
-                Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                       _eventsAndProperties->SignalHandler(imember, strSrcPath, message);
-                                                                                                   }));
+                // Signals may be delivered in a batch after this returns so capture by value
+                __MessageReceiver ^ eventsAndProperties = _eventsAndProperties;
+                Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, imember, strSrcPath, message]() {
+                                                                                                              eventsAndProperties->SignalHandler(imember, strSrcPath, message);
+                                                                                                          }));
                 break;
             }
 
@@ -172,6 +172,16 @@ void BusAttachment::EnableConcurrentCallbacks()
     _busAttachment->EnableConcurrentCallbacks();
 }
 
+void BusAttachment::EnableBatchedCallbacks(uint32_t maxLatency)
+{
+    // Callbacks already queued run in the hop of the batch they were queued on
+    if ((0 == maxLatency) || (nullptr == _busAttachment->_dispatcher)) {
+        _busAttachment->_callbackBatch = nullptr;
+    } else {
+        _busAttachment->_callbackBatch = ref new __CallbackBatch(_busAttachment->_dispatcher, maxLatency);
+    }
+}
+
 void BusAttachment::CreateInterface(Platform::String ^ name, Platform::WriteOnlyArray<AllJoyn::InterfaceDescription ^> ^ iface, bool secure)
 {
     ::QStatus status = ER_OK;
@@ -1820,7 +1830,7 @@ uint32_t BusAttachment::Timestamp::get()
 
 _BusAttachment::_BusAttachment(const char* applicationName, bool allowRemoteMessages, uint32_t concurrency)
     : BusAttachment(applicationName, allowRemoteMessages, concurrency), ajn::BusAttachment::JoinSessionAsyncCB(),
-    _keyStoreListener(nullptr), _authListener(nullptr), _dispatcher(nullptr), _originSTA(false)
+    _keyStoreListener(nullptr), _authListener(nullptr), _dispatcher(nullptr), _callbackBatch(nullptr), _originSTA(false)
 {
     ::QStatus status = ER_OK;
 
@@ -1853,6 +1863,7 @@ _BusAttachment::~_BusAttachment()
     _eventsAndProperties = nullptr;
     _keyStoreListener = nullptr;
     _authListener = nullptr;
+    _callbackBatch = nullptr;
     // Clear out the bus object map
     ClearObjectMap(&(this->_mutex), &(this->_busObjectMap));
     // Clear out the signal handler map
@@ -1920,17 +1931,27 @@ void _BusAttachment::SetLinkTimeoutCB(::QStatus s, uint32_t timeout, void* conte
     setLinkTimeoutResult->Complete();
 }
 
-void _BusAttachment::DispatchCallback(Windows::UI::Core::DispatchedHandler ^ callback)
+bool _BusAttachment::NeedsDispatcherHop()
 {
     Windows::UI::Core::CoreWindow ^ window = Windows::UI::Core::CoreWindow::GetForCurrentThread();
     Windows::UI::Core::CoreDispatcher ^ dispatcher = nullptr;
     if (nullptr != window) {
         dispatcher = window->Dispatcher;
     }
-    if (_originSTA && nullptr != _dispatcher && _dispatcher != dispatcher) {
+    return _originSTA && nullptr != _dispatcher && _dispatcher != dispatcher;
+}
+
+void _BusAttachment::DispatchCallback(Windows::UI::Core::DispatchedHandler ^ callback)
+{
+    if (NeedsDispatcherHop()) {
         // Our origin was STA and the thread dispatcher doesn't match up. Move execution to the origin dispatcher thread.
+        __CallbackBatch ^ batch = _callbackBatch;
         Windows::Foundation::IAsyncAction ^ op = _dispatcher->RunAsync(Windows::UI::Core::CoreDispatcherPriority::Normal,
-                                                                       ref new Windows::UI::Core::DispatchedHandler([this, callback] () {
+                                                                       ref new Windows::UI::Core::DispatchedHandler([this, batch, callback] () {
+                                                                                                                        // Callbacks batched before this one run first
+                                                                                                                        if (nullptr != batch) {
+                                                                                                                            batch->Drain();
+                                                                                                                        }
                                                                                                                         callback();
                                                                                                                     }));
         // Since we are now queued up, enable concurrency to prevent any unnecessary blocking (this turns whatever callback does into a no op)
@@ -1945,6 +1966,16 @@ void _BusAttachment::DispatchCallback(Windows::UI::Core::DispatchedHandler ^ cal
     }
 }
 
+void _BusAttachment::DispatchBatchedCallback(Windows::UI::Core::DispatchedHandler ^ callback)
+{
+    __CallbackBatch ^ batch = _callbackBatch;
+    if (nullptr != batch && NeedsDispatcherHop()) {
+        batch->Add(callback);
+    } else {
+        DispatchCallback(callback);
+    }
+}
+
 bool _BusAttachment::IsOriginSTA()
 {
     APTTYPE aptType;
@@ -1961,6 +1992,53 @@ bool _BusAttachment::IsOriginSTA()
     return false;
 }
 
+__CallbackBatch::__CallbackBatch(Windows::UI::Core::CoreDispatcher ^ dispatcher, uint32_t maxLatency) :
+    _dispatcher(dispatcher), _maxLatency(maxLatency), _scheduled(false)
+{
+}
+
+__CallbackBatch::~__CallbackBatch()
+{
+    _dispatcher = nullptr;
+    _callbacks.clear();
+}
+
+void __CallbackBatch::Add(Windows::UI::Core::DispatchedHandler ^ callback)
+{
+    _mutex.Lock();
+    _callbacks.push_back(callback);
+    bool schedule = !_scheduled;
+    _scheduled = true;
+    _mutex.Unlock();
+    if (schedule) {
+        // The first callback of a batch waits at most the max latency, the rest ride along with it
+        Windows::Foundation::TimeSpan delay;
+        delay.Duration = (int64_t)_maxLatency * 10000;
+        Windows::System::Threading::ThreadPoolTimer::CreateTimer(ref new Windows::System::Threading::TimerElapsedHandler([this] (Windows::System::Threading::ThreadPoolTimer ^ timer) {
+                                                                                                                              _dispatcher->RunAsync(Windows::UI::Core::CoreDispatcherPriority::Normal,
+                                                                                                                                                    ref new Windows::UI::Core::DispatchedHandler([this] () {
+                                                                                                                                                                                                     Drain();
+                                                                                                                                                                                                 }));
+                                                                                                                          }), delay);
+    }
+}
+
+void __CallbackBatch::Drain()
+{
+    std::vector<Windows::UI::Core::DispatchedHandler ^> callbacks;
+    _mutex.Lock();
+    callbacks.swap(_callbacks);
+    _scheduled = false;
+    _mutex.Unlock();
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+        // A throwing handler must not keep the rest of the batch from being delivered
+        try {
+            callbacks[i]();
+        } catch (...) {
+        }
+    }
+}
+
 __BusAttachment::__BusAttachment()
 {
     DBusProxyBusObject = nullptr;
@@ -462,9 +462,10 @@ void _BusListener::FoundAdvertisedName(const char* name, ajn::TransportMask tran
             break;
         }
         // Call FoundAdvertisedName through the dispatcher
-        _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                     _eventsAndProperties->FoundAdvertisedName(strName, (TransportMaskType)(int)transport, strNamePrefix);
-                                                                                                                 }));
+        __BusListener ^ eventsAndProperties = _eventsAndProperties;
+        eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, strName, transport, strNamePrefix]() {
+                                                                                                                           eventsAndProperties->FoundAdvertisedName(strName, (TransportMaskType)(int)transport, strNamePrefix);
+                                                                                                                       }));
         break;
     }
 
@@ -494,9 +495,10 @@ void _BusListener::LostAdvertisedName(const char* name, ajn::TransportMask trans
             break;
         }
         // Call LostAdvertisedName through the dispatcher
-        _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                     _eventsAndProperties->LostAdvertisedName(strName, (TransportMaskType)(int)transport, strNamePrefix);
-                                                                                                                 }));
+        __BusListener ^ eventsAndProperties = _eventsAndProperties;
+        eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, strName, transport, strNamePrefix]() {
+                                                                                                                           eventsAndProperties->LostAdvertisedName(strName, (TransportMaskType)(int)transport, strNamePrefix);
+                                                                                                                       }));
         break;
     }
 
@@ -533,9 +535,10 @@ void _BusListener::NameOwnerChanged(const char* busName, const char* previousOwn
             break;
         }
         // Call NameOwnerChanged through the dispatcher
-        _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                     _eventsAndProperties->NameOwnerChanged(strBusName, strPreviousOwner, strNewOwner);
-                                                                                                                 }));
+        __BusListener ^ eventsAndProperties = _eventsAndProperties;
+        eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, strBusName, strPreviousOwner, strNewOwner]() {
+                                                                                                                           eventsAndProperties->NameOwnerChanged(strBusName, strPreviousOwner, strNewOwner);
+                                                                                                                       }));
         break;
     }
 
@@ -248,9 +248,10 @@ void _SessionListener::DefaultSessionListenerSessionMemberRemovedHandler(ajn::Se
 void _SessionListener::SessionLost(ajn::SessionId sessionId)
 {
     // Call the SessionLost handler through the dispatcher
-    _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                 _eventsAndProperties->SessionLost(sessionId);
-                                                                                                             }));
+    __SessionListener ^ eventsAndProperties = _eventsAndProperties;
+    eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, sessionId]() {
+                                                                                                                       eventsAndProperties->SessionLost(sessionId);
+                                                                                                                   }));
 }
 
 void _SessionListener::SessionMemberAdded(ajn::SessionId sessionId,  const char* uniqueName)
@@ -266,9 +267,10 @@ void _SessionListener::SessionMemberAdded(ajn::SessionId sessionId,  const char*
             break;
         }
         // Call the SessionMemberAdded handler through the dispatcher
-        _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                     _eventsAndProperties->SessionMemberAdded(sessionId, strUniqueName);
-                                                                                                                 }));
+        __SessionListener ^ eventsAndProperties = _eventsAndProperties;
+        eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, sessionId, strUniqueName]() {
+                                                                                                                           eventsAndProperties->SessionMemberAdded(sessionId, strUniqueName);
+                                                                                                                       }));
         break;
     }
 
@@ -291,9 +293,10 @@ void _SessionListener::SessionMemberRemoved(ajn::SessionId sessionId,  const cha
             break;
         }
         // Call the SessionMemberRemoved handler through the dispatcher
-        _eventsAndProperties->Bus->_busAttachment->DispatchCallback(ref new Windows::UI::Core::DispatchedHandler([&]() {
-                                                                                                                     _eventsAndProperties->SessionMemberRemoved(sessionId, strUniqueName);
-                                                                                                                 }));
+        __SessionListener ^ eventsAndProperties = _eventsAndProperties;
+        eventsAndProperties->Bus->_busAttachment->DispatchBatchedCallback(ref new Windows::UI::Core::DispatchedHandler([eventsAndProperties, sessionId, strUniqueName]() {
+                                                                                                                           eventsAndProperties->SessionMemberRemoved(sessionId, strUniqueName);
+                                                                                                                       }));
         break;
     }
 
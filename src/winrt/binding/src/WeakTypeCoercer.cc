@@ -362,6 +362,62 @@ template <class T> Platform::Array<T> ^ ToArray(IPropertyValue ^ prop, bool &suc
     return retObj;
 }
 
+// Convert the elements of a typed array directly, without boxing each element as ToArray has to
+template <class T, class S> bool ConvertElements(Platform::Array<S> ^ src, Platform::Array<T> ^ dst, TypeConvertTo to, T min, T max)
+{
+    for (uint32 index = 0; index < src->Length; index++) {
+        if (to == CONVERT_TO_INTEGER) {
+            int64 tmpVal = (int64)src[index];
+            if (tmpVal < min || tmpVal > max) {
+                return false;
+            }
+            dst[index] = (T)tmpVal;
+        } else {
+            dst[index] = (T)src[index];
+        }
+    }
+    return true;
+}
+
+#define CONVERT_NUMERIC_ARRAY(PROP_TYPE, ELEM_TYPE)                          \
+    case Windows::Foundation::PropertyType::PROP_TYPE ## Array:             \
+    {                                                                       \
+        Platform::Array<ELEM_TYPE> ^ src = nullptr;                         \
+        prop->Get ## PROP_TYPE ## Array(&src);                              \
+        if (nullptr != src) {                                               \
+            vals = ref new Platform::Array<T>(src->Length);                 \
+            success = ConvertElements<T, ELEM_TYPE>(src, vals, to, min, max); \
+        }                                                                   \
+    }                                                                       \
+    break
+
+// Convert a numeric array of one element type to another in a single pass
+template <class T> Platform::Array<T> ^ NumericArrayToArray(IPropertyValue ^ prop, bool &success, TypeConvertTo to, T min = 0, T max = 0)
+{
+    Platform::Array<T> ^ vals = nullptr;
+    success = false;
+    if (nullptr == prop) {
+        return vals;
+    }
+    switch (prop->Type) {
+        CONVERT_NUMERIC_ARRAY(UInt8, uint8);
+        CONVERT_NUMERIC_ARRAY(Int16, int16);
+        CONVERT_NUMERIC_ARRAY(UInt16, uint16);
+        CONVERT_NUMERIC_ARRAY(Int32, int32);
+        CONVERT_NUMERIC_ARRAY(UInt32, uint32);
+        CONVERT_NUMERIC_ARRAY(Int64, int64);
+        CONVERT_NUMERIC_ARRAY(UInt64, uint64);
+        CONVERT_NUMERIC_ARRAY(Single, float32);
+        CONVERT_NUMERIC_ARRAY(Double, float64);
+
+    default:
+        break;
+    }
+    return success ? vals : nullptr;
+}
+
+#undef CONVERT_NUMERIC_ARRAY
+
 Platform::Array<Platform::Boolean> ^ ToBooleanArray(IPropertyValue ^ prop, bool &success)
 {
     Platform::Array<Platform::Boolean> ^ retObj = nullptr;
@@ -646,6 +702,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = doubleArr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<float64> ^ doubleArr = NumericArrayToArray<float64>(prop, success, CONVERT_TO_DOUBLE);
+            if (success) {
+                retObj = doubleArr;
+            }
         }
     }
     break;
@@ -660,6 +722,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = int32Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<int32> ^ int32Arr = NumericArrayToArray<int32>(prop, success, CONVERT_TO_INTEGER, INT32_MIN, INT32_MAX);
+            if (success) {
+                retObj = int32Arr;
+            }
         }
     }
     break;
@@ -674,6 +742,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = int16Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<int16> ^ int16Arr = NumericArrayToArray<int16>(prop, success, CONVERT_TO_INTEGER, INT16_MIN, INT16_MAX);
+            if (success) {
+                retObj = int16Arr;
+            }
         }
     }
     break;
@@ -688,6 +762,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = uint16Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<uint16> ^ uint16Arr = NumericArrayToArray<uint16>(prop, success, CONVERT_TO_INTEGER, 0, UINT16_MAX);
+            if (success) {
+                retObj = uint16Arr;
+            }
         }
     }
     break;
@@ -702,6 +782,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = uint64Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<uint64> ^ uint64Arr = NumericArrayToArray<uint64>(prop, success, CONVERT_TO_UINT64);
+            if (success) {
+                retObj = uint64Arr;
+            }
         }
     }
     break;
@@ -716,6 +802,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = uint32Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<uint32> ^ uint32Arr = NumericArrayToArray<uint32>(prop, success, CONVERT_TO_INTEGER, 0, UINT32_MAX);
+            if (success) {
+                retObj = uint32Arr;
+            }
         }
     }
     break;
@@ -730,6 +822,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = int64Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<int64> ^ int64Arr = NumericArrayToArray<int64>(prop, success, CONVERT_TO_INTEGER, INT64_MIN, INT64_MAX);
+            if (success) {
+                retObj = int64Arr;
+            }
         }
     }
     break;
@@ -744,6 +842,12 @@ Platform::Object ^ WeakTypeCoercer::Coerce(Platform::Object ^ obj, ajn::AllJoynT
             if (success) {
                 retObj = uint8Arr;
             }
+        } else {
+            bool success = false;
+            Platform::Array<uint8> ^ uint8Arr = NumericArrayToArray<uint8>(prop, success, CONVERT_TO_INTEGER, 0, UINT8_MAX);
+            if (success) {
+                retObj = uint8Arr;
+            }
         }
     }
     break;
@@ -0,0 +1,572 @@
+/**
+ * @file
+ *
+ * Reproducible throughput and latency benchmarks with machine readable results
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_WINDOWS)
+#include <windows.h>
+#elif defined(QCC_OS_DARWIN)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/BusObject.h>
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/version.h>
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+using namespace ajn;
+
+/** Benchmark constants */
+namespace org {
+namespace alljoyn {
+namespace bench {
+const char* InterfaceName = "org.alljoyn.bench";
+const char* ObjectPath = "/org/alljoyn/bench";
+const char* MatchRule = "type='signal',interface='org.alljoyn.bench',member='Tick'";
+const char* Password = "bbbench";
+}
+}
+}
+
+static volatile sig_atomic_t g_interrupt = false;
+
+static void SigIntHandler(int sig)
+{
+    g_interrupt = true;
+}
+
+/*
+ * Monotonic clock in microseconds. All attachments live in this process so one clock suffices
+ * for one way signal latencies.
+ */
+static uint64_t NowMicros()
+{
+#if defined(QCC_OS_GROUP_WINDOWS)
+    static LARGE_INTEGER freq = { 0 };
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>((now.QuadPart / freq.QuadPart) * 1000000 + ((now.QuadPart % freq.QuadPart) * 1000000) / freq.QuadPart);
+#elif defined(QCC_OS_DARWIN)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return ((mach_absolute_time() * timebase.numer) / timebase.denom) / 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/** Summary statistics of a set of latency samples */
+struct Summary {
+    size_t count;
+    uint32_t min;
+    uint32_t mean;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+};
+
+static uint32_t Percentile(const vector<uint32_t>& sorted, uint32_t permille)
+{
+    size_t rank = (sorted.size() * permille + 999) / 1000;
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+static Summary Summarize(vector<uint32_t>& samples)
+{
+    Summary s;
+    memset(&s, 0, sizeof(s));
+    s.count = samples.size();
+    if (s.count) {
+        sort(samples.begin(), samples.end());
+        uint64_t total = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            total += samples[i];
+        }
+        s.min = samples.front();
+        s.max = samples.back();
+        s.mean = static_cast<uint32_t>(total / s.count);
+        s.p50 = Percentile(samples, 500);
+        s.p90 = Percentile(samples, 900);
+        s.p99 = Percentile(samples, 990);
+    }
+    return s;
+}
+
+/** Writes one result row per benchmark run as CSV or JSON */
+class Reporter {
+  public:
+    Reporter(FILE* out, bool json, const String& transport, bool encrypted) :
+        out(out), json(json), transport(transport), encrypted(encrypted), rows(0)
+    {
+        if (json) {
+            fprintf(out, "[\n");
+        } else {
+            fprintf(out, "benchmark,transport,encrypted,size,subscribers,sent,received,min_us,mean_us,p50_us,p90_us,p99_us,max_us,msgs_per_sec,bytes_per_sec\n");
+        }
+    }
+
+    ~Reporter()
+    {
+        if (json) {
+            fprintf(out, "%s]\n", rows ? "\n" : "");
+        }
+        fflush(out);
+    }
+
+    void Report(const char* benchmark, size_t size, size_t subscribers, size_t sent, const Summary& s, uint64_t elapsedUs)
+    {
+        double rate = elapsedUs ? (s.count * 1000000.0) / elapsedUs : 0.0;
+        if (json) {
+            fprintf(out, "%s  {\"benchmark\": \"%s\", \"transport\": \"%s\", \"encrypted\": %s, \"size\": %u, \"subscribers\": %u, "
+                    "\"sent\": %u, \"received\": %u, \"min_us\": %u, \"mean_us\": %u, \"p50_us\": %u, \"p90_us\": %u, \"p99_us\": %u, "
+                    "\"max_us\": %u, \"msgs_per_sec\": %.1f, \"bytes_per_sec\": %.1f}",
+                    rows ? ",\n" : "", benchmark, transport.c_str(), encrypted ? "true" : "false", (unsigned)size, (unsigned)subscribers,
+                    (unsigned)sent, (unsigned)s.count, s.min, s.mean, s.p50, s.p90, s.p99, s.max, rate, rate * size);
+        } else {
+            fprintf(out, "%s,%s,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.1f,%.1f\n",
+                    benchmark, transport.c_str(), encrypted ? 1 : 0, (unsigned)size, (unsigned)subscribers,
+                    (unsigned)sent, (unsigned)s.count, s.min, s.mean, s.p50, s.p90, s.p99, s.max, rate, rate * size);
+        }
+        fflush(out);
+        ++rows;
+    }
+
+  private:
+    FILE* out;
+    bool json;
+    String transport;
+    bool encrypted;
+    size_t rows;
+};
+
+/** Every attachment creates the same interface, secure if the run is encrypted */
+static QStatus CreateBenchInterface(BusAttachment& bus, bool encrypted)
+{
+    InterfaceDescription* ifc = NULL;
+    QStatus status = bus.CreateInterface(::org::alljoyn::bench::InterfaceName, ifc, encrypted);
+    if (status == ER_OK) {
+        ifc->AddMethod("Echo", "ay", "ay", "in,out", 0);
+        ifc->AddSignal("Tick", "tay", "timestamp,payload", 0);
+        ifc->Activate();
+    }
+    return status;
+}
+
+/** Both ends of an encrypted benchmark use SRP key exchange with a fixed password */
+class BenchAuthListener : public AuthListener {
+    bool RequestCredentials(const char* authMechanism, const char* authPeer, uint16_t authCount, const char* userId, uint16_t credMask, Credentials& creds)
+    {
+        if (credMask & AuthListener::CRED_PASSWORD) {
+            creds.SetPassword(::org::alljoyn::bench::Password);
+        }
+        return true;
+    }
+
+    void AuthenticationComplete(const char* authMechanism, const char* authPeer, bool success)
+    {
+        if (!success) {
+            QCC_LogError(ER_AUTH_FAIL, ("Authentication with %s failed", authPeer));
+        }
+    }
+};
+
+/** The object under test: Echo replies with its argument, Tick is emitted as a broadcast signal */
+class BenchObject : public BusObject {
+  public:
+    BenchObject(BusAttachment& bus) : BusObject(::org::alljoyn::bench::ObjectPath), tick(NULL)
+    {
+        const InterfaceDescription* ifc = bus.GetInterface(::org::alljoyn::bench::InterfaceName);
+        AddInterface(*ifc);
+        AddMethodHandler(ifc->GetMember("Echo"), static_cast<MessageReceiver::MethodHandler>(&BenchObject::Echo));
+        tick = ifc->GetMember("Tick");
+    }
+
+    void Echo(const InterfaceDescription::Member* member, Message& msg)
+    {
+        MethodReply(msg, msg->GetArg(0), 1);
+    }
+
+    QStatus EmitTick(const MsgArg& payload)
+    {
+        MsgArg args[2];
+        args[0].Set("t", NowMicros());
+        args[1] = payload;
+        return Signal(NULL, 0, *tick, args, 2);
+    }
+
+  private:
+    const InterfaceDescription::Member* tick;
+};
+
+/** A bus attachment that subscribes to Tick and records one way latencies */
+class Subscriber : public MessageReceiver {
+  public:
+    Subscriber(size_t index) : bus(("bbbench-sub" + U32ToString((uint32_t)index)).c_str(), true) { }
+
+    QStatus Init(const String& connectSpec, bool encrypted, AuthListener* authListener)
+    {
+        QStatus status = CreateBenchInterface(bus, encrypted);
+        if (status == ER_OK) {
+            status = bus.Start();
+        }
+        if ((status == ER_OK) && encrypted) {
+            status = bus.EnablePeerSecurity("ALLJOYN_SRP_KEYX", authListener);
+            bus.ClearKeyStore();
+        }
+        if (status == ER_OK) {
+            status = connectSpec.empty() ? bus.Connect() : bus.Connect(connectSpec.c_str());
+        }
+        if (status == ER_OK) {
+            const InterfaceDescription* ifc = bus.GetInterface(::org::alljoyn::bench::InterfaceName);
+            status = bus.RegisterSignalHandler(this, static_cast<MessageReceiver::SignalHandler>(&Subscriber::Tick), ifc->GetMember("Tick"), NULL);
+        }
+        if (status == ER_OK) {
+            status = bus.AddMatch(::org::alljoyn::bench::MatchRule);
+        }
+        return status;
+    }
+
+    /* One method call so an encrypted run has exchanged keys before anything is timed */
+    QStatus Handshake(const String& serviceName)
+    {
+        ProxyBusObject proxy(bus, serviceName.c_str(), ::org::alljoyn::bench::ObjectPath, 0);
+        proxy.AddInterface(*bus.GetInterface(::org::alljoyn::bench::InterfaceName));
+        MsgArg arg("ay", 0, NULL);
+        Message reply(bus);
+        return proxy.MethodCall(::org::alljoyn::bench::InterfaceName, "Echo", &arg, 1, reply);
+    }
+
+    void Tick(const InterfaceDescription::Member* member, const char* srcPath, Message& msg)
+    {
+        uint64_t now = NowMicros();
+        uint64_t sent;
+        if (msg->GetArg(0)->Get("t", &sent) == ER_OK) {
+            lock.Lock(MUTEX_CONTEXT);
+            samples.push_back(static_cast<uint32_t>(now - sent));
+            lock.Unlock(MUTEX_CONTEXT);
+        }
+    }
+
+    size_t Received()
+    {
+        lock.Lock(MUTEX_CONTEXT);
+        size_t num = samples.size();
+        lock.Unlock(MUTEX_CONTEXT);
+        return num;
+    }
+
+    void TakeSamples(vector<uint32_t>& all)
+    {
+        lock.Lock(MUTEX_CONTEXT);
+        all.insert(all.end(), samples.begin(), samples.end());
+        samples.clear();
+        lock.Unlock(MUTEX_CONTEXT);
+    }
+
+  private:
+    BusAttachment bus;
+    Mutex lock;
+    vector<uint32_t> samples;
+};
+
+static void ParseList(const char* arg, vector<size_t>& list)
+{
+    list.clear();
+    const char* p = arg;
+    while (*p) {
+        char* end;
+        list.push_back(strtoul(p, &end, 10));
+        p = (*end == ',') ? end + 1 : end + strlen(end);
+    }
+}
+
+/** Method round trip times for each payload size */
+static QStatus RunRtt(BusAttachment& client, const String& serviceName, const vector<size_t>& sizes, size_t iterations, size_t warmup, Reporter& reporter)
+{
+    ProxyBusObject proxy(client, serviceName.c_str(), ::org::alljoyn::bench::ObjectPath, 0);
+    proxy.AddInterface(*client.GetInterface(::org::alljoyn::bench::InterfaceName));
+
+    QStatus status = ER_OK;
+    for (size_t s = 0; (status == ER_OK) && (s < sizes.size()) && !g_interrupt; ++s) {
+        vector<uint8_t> payload(sizes[s] ? sizes[s] : 1, 0xA5);
+        MsgArg arg("ay", sizes[s], &payload[0]);
+        vector<uint32_t> samples;
+        samples.reserve(iterations);
+        uint64_t begin = 0;
+        for (size_t i = 0; (status == ER_OK) && (i < warmup + iterations) && !g_interrupt; ++i) {
+            if (i == warmup) {
+                begin = NowMicros();
+            }
+            Message reply(client);
+            uint64_t t0 = NowMicros();
+            status = proxy.MethodCall(::org::alljoyn::bench::InterfaceName, "Echo", &arg, 1, reply);
+            if ((status == ER_OK) && (i >= warmup)) {
+                samples.push_back(static_cast<uint32_t>(NowMicros() - t0));
+            }
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Echo failed (size=%u)", (unsigned)sizes[s]));
+            break;
+        }
+        uint64_t elapsed = NowMicros() - begin;
+        Summary summary = Summarize(samples);
+        reporter.Report("rtt", sizes[s], 1, iterations, summary, elapsed);
+    }
+    return status;
+}
+
+/** One way latency of broadcast signals delivered to each of N subscribers */
+static QStatus RunFanout(BenchObject& obj, const String& serviceName, const String& connectSpec, bool encrypted, AuthListener* authListener,
+                         const vector<size_t>& sizes, const vector<size_t>& fanouts, size_t iterations, Reporter& reporter)
+{
+    QStatus status = ER_OK;
+    for (size_t f = 0; (status == ER_OK) && (f < fanouts.size()) && !g_interrupt; ++f) {
+        vector<Subscriber*> subs;
+        for (size_t i = 0; (status == ER_OK) && (i < fanouts[f]); ++i) {
+            subs.push_back(new Subscriber(i));
+            status = subs.back()->Init(connectSpec, encrypted, authListener);
+            if (status == ER_OK) {
+                status = subs.back()->Handshake(serviceName);
+            }
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to set up %u subscribers", (unsigned)fanouts[f]));
+        }
+        for (size_t s = 0; (status == ER_OK) && (s < sizes.size()) && !g_interrupt; ++s) {
+            vector<uint8_t> payload(sizes[s] ? sizes[s] : 1, 0x5A);
+            MsgArg arg("ay", sizes[s], &payload[0]);
+            uint64_t begin = NowMicros();
+            for (size_t i = 0; (status == ER_OK) && (i < iterations) && !g_interrupt; ++i) {
+                status = obj.EmitTick(arg);
+            }
+            if (status != ER_OK) {
+                QCC_LogError(status, ("Failed to emit Tick (size=%u)", (unsigned)sizes[s]));
+                break;
+            }
+            /* Wait until every subscriber has everything or deliveries stop arriving */
+            size_t expected = iterations * subs.size();
+            size_t received = 0;
+            size_t lastReceived = 0;
+            uint64_t lastProgress = NowMicros();
+            while (!g_interrupt) {
+                received = 0;
+                for (size_t i = 0; i < subs.size(); ++i) {
+                    received += subs[i]->Received();
+                }
+                if (received >= expected) {
+                    break;
+                }
+                if (received != lastReceived) {
+                    lastReceived = received;
+                    lastProgress = NowMicros();
+                } else if ((NowMicros() - lastProgress) > 5000000) {
+                    break;
+                }
+                qcc::Sleep(1);
+            }
+            uint64_t elapsed = NowMicros() - begin;
+            vector<uint32_t> samples;
+            samples.reserve(expected);
+            for (size_t i = 0; i < subs.size(); ++i) {
+                subs[i]->TakeSamples(samples);
+            }
+            Summary summary = Summarize(samples);
+            reporter.Report("fanout", sizes[s], subs.size(), expected, summary, elapsed);
+        }
+        for (size_t i = 0; i < subs.size(); ++i) {
+            delete subs[i];
+        }
+    }
+    return status;
+}
+
+static void usage(void)
+{
+    printf("Usage: bbbench [-h] [-c <connect spec>] [-t <transport label>] [-b rtt|fanout|all] [-s <sizes>] [-N <subscribers>]\n"
+           "               [-n #] [-w #] [-e] [-f csv|json] [-o <file>]\n\n");
+    printf("Options:\n");
+    printf("   -h                    = Print this help message\n");
+    printf("   -c <connect spec>     = Daemon to connect to, e.g. unix:abstract=alljoyn, tcp:addr=127.0.0.1,port=9955 or\n");
+    printf("                           null: for a bundled daemon (default BUS_ADDRESS or the platform default)\n");
+    printf("   -t <transport label>  = Transport name written to the results (default the connect spec type)\n");
+    printf("   -b rtt|fanout|all     = Benchmarks to run (default all)\n");
+    printf("   -s <sizes>            = Comma separated payload sizes in bytes (default 0,64,1024,16384,65536)\n");
+    printf("   -N <subscribers>      = Comma separated signal fan-out subscriber counts (default 1,4,16)\n");
+    printf("   -n #                  = Timed method calls or signals per size (default 1000)\n");
+    printf("   -w #                  = Untimed warm up method calls per size (default 50)\n");
+    printf("   -e                    = Use secure interfaces (SRP key exchange)\n");
+    printf("   -f csv|json           = Result format (default csv)\n");
+    printf("   -o <file>             = Write results to a file instead of stdout\n");
+    printf("\n");
+}
+
+/** Main entry point */
+int main(int argc, char** argv)
+{
+    QStatus status = ER_OK;
+    String connectSpec = Environ::GetAppEnviron()->Find("BUS_ADDRESS");
+    String transport;
+    bool runRtt = true;
+    bool runFanout = true;
+    bool encrypted = false;
+    bool json = false;
+    size_t iterations = 1000;
+    size_t warmup = 50;
+    vector<size_t> sizes;
+    vector<size_t> fanouts;
+    FILE* out = stdout;
+
+    ParseList("0,64,1024,16384,65536", sizes);
+    ParseList("1,4,16", fanouts);
+
+    /* Install SIGINT handler */
+    signal(SIGINT, SigIntHandler);
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        const char* opt = argv[i];
+        bool hasParam = (0 == strcmp("-c", opt)) || (0 == strcmp("-t", opt)) || (0 == strcmp("-b", opt)) || (0 == strcmp("-s", opt)) ||
+                        (0 == strcmp("-N", opt)) || (0 == strcmp("-n", opt)) || (0 == strcmp("-w", opt)) || (0 == strcmp("-f", opt)) ||
+                        (0 == strcmp("-o", opt));
+        if (hasParam && (++i == argc)) {
+            printf("option %s requires a parameter\n", opt);
+            usage();
+            exit(1);
+        }
+        if (0 == strcmp("-c", opt)) {
+            connectSpec = argv[i];
+        } else if (0 == strcmp("-t", opt)) {
+            transport = argv[i];
+        } else if (0 == strcmp("-b", opt)) {
+            runRtt = (0 == strcmp("rtt", argv[i])) || (0 == strcmp("all", argv[i]));
+            runFanout = (0 == strcmp("fanout", argv[i])) || (0 == strcmp("all", argv[i]));
+        } else if (0 == strcmp("-s", opt)) {
+            ParseList(argv[i], sizes);
+        } else if (0 == strcmp("-N", opt)) {
+            ParseList(argv[i], fanouts);
+        } else if (0 == strcmp("-n", opt)) {
+            iterations = strtoul(argv[i], NULL, 10);
+        } else if (0 == strcmp("-w", opt)) {
+            warmup = strtoul(argv[i], NULL, 10);
+        } else if (0 == strcmp("-f", opt)) {
+            json = (0 == strcmp("json", argv[i]));
+        } else if (0 == strcmp("-o", opt)) {
+            out = fopen(argv[i], "w");
+            if (!out) {
+                printf("Failed to open %s for writing\n", argv[i]);
+                exit(1);
+            }
+        } else if (0 == strcmp("-e", opt)) {
+            encrypted = true;
+        } else if (0 == strcmp("-h", opt)) {
+            usage();
+            exit(0);
+        } else {
+            printf("Unknown option %s\n", opt);
+            usage();
+            exit(1);
+        }
+    }
+    if (transport.empty()) {
+        transport = connectSpec.empty() ? String("default") : connectSpec.substr(0, connectSpec.find_first_of(':'));
+    }
+
+    fprintf(stderr, "AllJoyn Library version: %s\n", ajn::GetVersion());
+    fprintf(stderr, "AllJoyn Library build info: %s\n", ajn::GetBuildInfo());
+
+    BenchAuthListener authListener;
+    BusAttachment service("bbbench-service", true);
+    BusAttachment client("bbbench-client", true);
+    BusAttachment* buses[] = { &service, &client };
+
+    for (size_t i = 0; (status == ER_OK) && (i < ArraySize(buses)); ++i) {
+        status = CreateBenchInterface(*buses[i], encrypted);
+        if (status == ER_OK) {
+            status = buses[i]->Start();
+        }
+        if ((status == ER_OK) && encrypted) {
+            status = buses[i]->EnablePeerSecurity("ALLJOYN_SRP_KEYX", &authListener);
+            buses[i]->ClearKeyStore();
+        }
+        if (status == ER_OK) {
+            status = connectSpec.empty() ? buses[i]->Connect() : buses[i]->Connect(connectSpec.c_str());
+        }
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to connect to \"%s\"", connectSpec.c_str()));
+        return (int)status;
+    }
+
+    BenchObject obj(service);
+    service.RegisterBusObject(obj);
+    String serviceName = service.GetUniqueName();
+
+    {
+        Reporter reporter(out, json, transport, encrypted);
+        if (runRtt) {
+            status = RunRtt(client, serviceName, sizes, iterations, warmup, reporter);
+        }
+        if ((status == ER_OK) && runFanout) {
+            status = RunFanout(obj, serviceName, connectSpec, encrypted, &authListener, sizes, fanouts, iterations, reporter);
+        }
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    service.UnregisterBusObject(obj);
+
+    fprintf(stderr, "%s exiting with status %d (%s)\n", argv[0], status, QCC_StatusText(status));
+
+    return (int) status;
+}
@@ -37,6 +37,9 @@
 #include <alljoyn/MsgArg.h>
 #include <alljoyn/version.h>
 
+#include "../src/LatencyHistogram.h"
+#include "../src/ThreadScheduling.h"
+
 #include <alljoyn/Status.h>
 
 
@@ -139,6 +142,9 @@ class PingThread : public qcc::Thread, BusObject {
 
         QCC_SyncPrintf("Start ping thread\n");
 
+        /* The calling thread is scheduled like the dispatch threads so it does not add jitter of its own */
+        ThreadScheduling::Apply();
+
         while (!IsStopping()) {
 
             // Wait until alerted
@@ -163,12 +169,10 @@ class PingThread : public qcc::Thread, BusObject {
                 return (qcc::ThreadReturn)status;
             }
 
-            const uint32_t bucketSize = 5;
-            const uint32_t numBuckets = 200;
-            uint32_t histogram[numBuckets];
-            uint32_t avg = 0;
-
-            memset(histogram, 0, sizeof(histogram));
+            /* Round trip times in microseconds */
+            LatencyHistogram roundTrip;
+            uint64_t total = 0;
+            uint32_t minRt = 0xFFFFFFFF;
 
             /* Let all the joining etc. settle down before we start */
             qcc::Sleep(2000);
@@ -176,39 +180,36 @@ class PingThread : public qcc::Thread, BusObject {
             for (size_t i = 0; i < iterations; ++i) {
                 Message reply(*g_msgBus);
                 MsgArg arg("u", g_msgBus->GetTimestamp());
+                uint64_t start = GetLatencyClock();
                 status = remoteObj.MethodCall(::org::alljoyn::jitter_test::Interface, "TimedPing", &arg, 1, reply);
+                uint64_t end = GetLatencyClock();
                 if (status != ER_OK) {
                     String errMsg;
                     const char* errName = reply->GetErrorName(&errMsg);
                     QCC_LogError(status, ("TimedPing returned ERROR_MESSAGE (error=%s, \"%s\")", errName, errMsg.c_str()));
                     break;
                 }
-                uint32_t timestamp;
-                reply->GetArgs("u", &timestamp);
-                uint32_t rt = g_msgBus->GetTimestamp() - timestamp;
-                avg += rt;
-                uint32_t bucket = rt / bucketSize;
-                if (bucket >= numBuckets) {
-                    bucket = numBuckets - 1;
+                uint32_t rt = static_cast<uint32_t>(end - start);
+                roundTrip.Record(rt);
+                total += rt;
+                if (rt < minRt) {
+                    minRt = rt;
                 }
-                histogram[bucket] += 1;
                 qcc::Sleep(delay);
             }
-            avg /= iterations;
-            QCC_SyncPrintf("Round trip avg=%u\n", avg);
-            QCC_SyncPrintf("\n=================================\n");
-            size_t last = numBuckets - 1;
-            while ((last > 0) && (histogram[last] == 0)) {
-                --last;
-            }
-            for (size_t i = 0; i <= last; ++i) {
-                QCC_SyncPrintf("%3u ", (i + 1) * bucketSize);
-            }
-            QCC_SyncPrintf("\n");
-            for (size_t i = 0; i <= last; ++i) {
-                QCC_SyncPrintf("%3u ", histogram[i]);
+            if (roundTrip.GetCount() == 0) {
+                continue;
             }
+            /* Jitter is how far the tail is from the typical round trip */
+            uint32_t p50 = roundTrip.GetPercentile(500);
+            uint32_t p999 = roundTrip.GetPercentile(999);
             QCC_SyncPrintf("\n=================================\n");
+            QCC_SyncPrintf("Round trips %u  min %u  avg %u (us)\n", roundTrip.GetCount(), minRt,
+                           static_cast<uint32_t>(total / roundTrip.GetCount()));
+            QCC_SyncPrintf("p50 %u  p90 %u  p99 %u  p99.9 %u  max %u (us)\n", p50, roundTrip.GetPercentile(900),
+                           roundTrip.GetPercentile(990), p999, roundTrip.GetMax());
+            QCC_SyncPrintf("Jitter p99.9-p50 %u  max-p50 %u (us)\n", p999 - p50, roundTrip.GetMax() - p50);
+            QCC_SyncPrintf("=================================\n");
 
         }
 
@@ -318,6 +319,10 @@ static void usage(void)
     printf("   -f <prefix>          = FindAdvertisedName prefix\n");
     printf("   -b                   = Advertise over Bluetooth (enables selective advertising)\n");
     printf("   -t                   = Advertise over TCP (enables selective advertising)\n");
+    printf("   -r <fifo|rr>         = Run the dispatch threads with a real-time scheduling policy\n");
+    printf("   -p <priority>        = Real-time priority for -r (default 50)\n");
+    printf("   -a <mask>            = Hexadecimal mask of the cpus the dispatch threads may run on\n");
+    printf("   -m                   = Lock the process into memory\n");
 }
 
 /** Main entry point */
@@ -327,6 +332,10 @@ int main(int argc, char** argv)
     uint32_t transportOpts = 0;
     uint32_t iterations = 500;
     uint32_t delay = 100;
+    BusAttachment::SchedulingPolicy schedPolicy = BusAttachment::SCHEDULING_DEFAULT;
+    int schedPriority = 50;
+    uint64_t cpuMask = 0;
+    bool lockMemory = false;
 
     printf("AllJoyn Library version: %s\n", ajn::GetVersion());
     printf("AllJoyn Library build info: %s\n", ajn::GetBuildInfo());
@@ -375,6 +384,26 @@ int main(int argc, char** argv)
             transportOpts |= TRANSPORT_BLUETOOTH;
         } else if (0 == strcmp("-t", argv[i])) {
             transportOpts |= TRANSPORT_WLAN;
+        } else if ((0 == strcmp("-r", argv[i])) || (0 == strcmp("-p", argv[i])) || (0 == strcmp("-a", argv[i]))) {
+            if (++i == argc) {
+                printf("option %s requires a parameter\n", argv[i - 1]);
+                usage();
+                exit(1);
+            } else if (0 == strcmp("-p", argv[i - 1])) {
+                schedPriority = strtol(argv[i], NULL, 0);
+            } else if (0 == strcmp("-a", argv[i - 1])) {
+                cpuMask = strtoull(argv[i], NULL, 16);
+            } else if (0 == strcmp("fifo", argv[i])) {
+                schedPolicy = BusAttachment::SCHEDULING_FIFO;
+            } else if (0 == strcmp("rr", argv[i])) {
+                schedPolicy = BusAttachment::SCHEDULING_RR;
+            } else {
+                printf("option %s requires fifo or rr\n", argv[i - 1]);
+                usage();
+                exit(1);
+            }
+        } else if (0 == strcmp("-m", argv[i])) {
+            lockMemory = true;
         } else {
             status = ER_FAIL;
             printf("Unknown option %s\n", argv[i]);
@@ -399,6 +428,15 @@ int main(int argc, char** argv)
     /* Create message bus */
     g_msgBus = new BusAttachment("bbjitter", true);
 
+    /* Set before the bus starts so every dispatch thread is scheduled from its first message */
+    if ((schedPolicy != BusAttachment::SCHEDULING_DEFAULT) || (cpuMask != 0) || lockMemory) {
+        status = g_msgBus->SetDispatchScheduling(schedPolicy, schedPriority, cpuMask, lockMemory);
+        if (ER_OK != status) {
+            QCC_LogError(status, ("SetDispatchScheduling failed"));
+            exit(1);
+        }
+    }
+
     /* Start the msg bus */
     if (ER_OK == status) {
         status = g_msgBus->Start();
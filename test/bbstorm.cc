@@ -0,0 +1,727 @@
+/**
+ * @file
+ *
+ * Connection and session storm load generator
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_WINDOWS)
+#include <windows.h>
+#elif defined(QCC_OS_DARWIN)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(QCC_OS_GROUP_POSIX)
+#include <dirent.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/ProxyBusObject.h>
+#include <alljoyn/version.h>
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+using namespace ajn;
+
+/** Storm constants */
+namespace org {
+namespace alljoyn {
+namespace storm {
+const char* DefaultWellKnownName = "org.alljoyn.storm";
+const SessionPort SessionPort = 42;
+const char* Password = "bbstorm";
+}
+}
+}
+
+static volatile sig_atomic_t g_interrupt = false;
+
+static void SigIntHandler(int sig)
+{
+    g_interrupt = true;
+}
+
+static uint64_t NowMicros()
+{
+#if defined(QCC_OS_GROUP_WINDOWS)
+    static LARGE_INTEGER freq = { 0 };
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>((now.QuadPart / freq.QuadPart) * 1000000 + ((now.QuadPart % freq.QuadPart) * 1000000) / freq.QuadPart);
+#elif defined(QCC_OS_DARWIN)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return ((mach_absolute_time() * timebase.numer) / timebase.denom) / 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/** The phases of a client's life that are timed */
+enum Phase {
+    PHASE_CONNECT,    /**< BusAttachment::Start() and Connect(), includes authenticating with the daemon */
+    PHASE_AUTH,       /**< Peer authentication with the session host */
+    PHASE_JOIN,       /**< JoinSession() */
+    PHASE_TEARDOWN,   /**< LeaveSession(), Disconnect(), Stop() and Join() */
+    NUM_PHASES
+};
+
+static const char* phaseNames[NUM_PHASES] = { "connect", "auth", "join", "teardown" };
+
+/**
+ * Collects the latencies and failures of every phase. In a child process each sample is also
+ * written as a line of text to the pipe read by the parent (lines shorter than PIPE_BUF are
+ * written atomically so several children can share one pipe).
+ */
+class Recorder {
+  public:
+    Recorder() : pipeFd(-1)
+    {
+        memset(failures, 0, sizeof(failures));
+    }
+
+    void SetPipe(int fd) { pipeFd = fd; }
+
+    void Success(Phase phase, uint64_t usecs)
+    {
+        if (pipeFd >= 0) {
+            WriteLine("s " + U32ToString(phase) + " " + U64ToString(usecs) + "\n");
+        } else {
+            lock.Lock(MUTEX_CONTEXT);
+            samples[phase].push_back(static_cast<uint32_t>(usecs));
+            lock.Unlock(MUTEX_CONTEXT);
+        }
+    }
+
+    void Failure(Phase phase, QStatus status)
+    {
+        if (pipeFd >= 0) {
+            WriteLine("f " + U32ToString(phase) + "\n");
+        } else {
+            lock.Lock(MUTEX_CONTEXT);
+            ++failures[phase];
+            lock.Unlock(MUTEX_CONTEXT);
+        }
+        QCC_DbgPrintf(("%s failed: %s", phaseNames[phase], QCC_StatusText(status)));
+    }
+
+    /* Parse a line written by a child */
+    void ParseLine(const char* line)
+    {
+        char kind;
+        unsigned phase;
+        unsigned long long usecs = 0;
+        int n = sscanf(line, "%c %u %llu", &kind, &phase, &usecs);
+        if ((n >= 2) && (phase < NUM_PHASES)) {
+            lock.Lock(MUTEX_CONTEXT);
+            if ((kind == 's') && (n == 3)) {
+                samples[phase].push_back(static_cast<uint32_t>(usecs));
+            } else if (kind == 'f') {
+                ++failures[phase];
+            }
+            lock.Unlock(MUTEX_CONTEXT);
+        }
+    }
+
+    void Report(FILE* out, bool json, size_t clients, size_t processes, size_t threads, double rampRate)
+    {
+        if (json) {
+            fprintf(out, "[\n");
+        } else {
+            fprintf(out, "phase,clients,processes,threads,ramp_per_sec,count,failures,min_us,mean_us,p50_us,p90_us,p99_us,max_us\n");
+        }
+        for (int p = 0; p < NUM_PHASES; ++p) {
+            vector<uint32_t>& s = samples[p];
+            sort(s.begin(), s.end());
+            uint64_t total = 0;
+            for (size_t i = 0; i < s.size(); ++i) {
+                total += s[i];
+            }
+            uint32_t mean = s.empty() ? 0 : static_cast<uint32_t>(total / s.size());
+            const char* fmt = json ?
+                              "  {\"phase\": \"%s\", \"clients\": %u, \"processes\": %u, \"threads\": %u, \"ramp_per_sec\": %.1f, \"count\": %u, "
+                              "\"failures\": %u, \"min_us\": %u, \"mean_us\": %u, \"p50_us\": %u, \"p90_us\": %u, \"p99_us\": %u, \"max_us\": %u}%s\n" :
+                              "%s,%u,%u,%u,%.1f,%u,%u,%u,%u,%u,%u,%u,%u%s\n";
+            fprintf(out, fmt, phaseNames[p], (unsigned)clients, (unsigned)processes, (unsigned)threads, rampRate, (unsigned)s.size(),
+                    (unsigned)failures[p], s.empty() ? 0 : s.front(), mean, Percentile(s, 500), Percentile(s, 900), Percentile(s, 990),
+                    s.empty() ? 0 : s.back(), (json && (p + 1 < NUM_PHASES)) ? "," : "");
+        }
+        if (json) {
+            fprintf(out, "]\n");
+        }
+        fflush(out);
+    }
+
+  private:
+    static uint32_t Percentile(const vector<uint32_t>& sorted, uint32_t permille)
+    {
+        if (sorted.empty()) {
+            return 0;
+        }
+        size_t rank = (sorted.size() * permille + 999) / 1000;
+        return sorted[(rank > 0) ? (rank - 1) : 0];
+    }
+
+    void WriteLine(const String& line)
+    {
+#if defined(QCC_OS_GROUP_POSIX)
+        if (write(pipeFd, line.data(), line.size()) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("Failed to write sample: %s", strerror(errno)));
+        }
+#endif
+    }
+
+    Mutex lock;
+    int pipeFd;
+    vector<uint32_t> samples[NUM_PHASES];
+    size_t failures[NUM_PHASES];
+};
+
+/** Settings shared by every client */
+struct StormConfig {
+    String connectSpec;
+    String hostName;
+    bool join;
+    bool secure;
+    uint32_t holdMs;
+    size_t clients;           /**< Clients started by this process */
+    double rampRate;          /**< Clients started per second by this process, 0 for as fast as possible */
+    uint64_t startTime;
+};
+
+/** Both ends of a secure storm use SRP key exchange with a fixed password */
+class StormAuthListener : public AuthListener {
+    bool RequestCredentials(const char* authMechanism, const char* authPeer, uint16_t authCount, const char* userId, uint16_t credMask, Credentials& creds)
+    {
+        if (credMask & AuthListener::CRED_PASSWORD) {
+            creds.SetPassword(::org::alljoyn::storm::Password);
+        }
+        return true;
+    }
+
+    void AuthenticationComplete(const char* authMechanism, const char* authPeer, bool success) { }
+};
+
+static StormAuthListener g_authListener;
+
+/** One simulated client */
+class StormClient {
+  public:
+    StormClient(size_t index) :
+        bus(("bbstorm" + U32ToString((uint32_t)index)).c_str(), true),
+        sessionId(0),
+        expires(0)
+    {
+    }
+
+    bool Run(const StormConfig& config, Recorder& recorder)
+    {
+        uint64_t t0 = NowMicros();
+        QStatus status = bus.Start();
+        if ((status == ER_OK) && config.secure) {
+            status = bus.EnablePeerSecurity("ALLJOYN_SRP_KEYX", &g_authListener);
+            bus.ClearKeyStore();
+        }
+        if (status == ER_OK) {
+            status = config.connectSpec.empty() ? bus.Connect() : bus.Connect(config.connectSpec.c_str());
+        }
+        if (status != ER_OK) {
+            recorder.Failure(PHASE_CONNECT, status);
+            return false;
+        }
+        recorder.Success(PHASE_CONNECT, NowMicros() - t0);
+
+        if (config.join) {
+            SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+            t0 = NowMicros();
+            status = bus.JoinSession(config.hostName.c_str(), ::org::alljoyn::storm::SessionPort, NULL, sessionId, opts);
+            if (status != ER_OK) {
+                recorder.Failure(PHASE_JOIN, status);
+                return false;
+            }
+            recorder.Success(PHASE_JOIN, NowMicros() - t0);
+
+            if (config.secure) {
+                ProxyBusObject host(bus, config.hostName.c_str(), "/", sessionId);
+                t0 = NowMicros();
+                status = host.SecureConnection(true);
+                if (status != ER_OK) {
+                    recorder.Failure(PHASE_AUTH, status);
+                    return false;
+                }
+                recorder.Success(PHASE_AUTH, NowMicros() - t0);
+            }
+        }
+        expires = NowMicros() + config.holdMs * 1000;
+        return true;
+    }
+
+    void Teardown(Recorder& recorder)
+    {
+        uint64_t t0 = NowMicros();
+        if (sessionId) {
+            bus.LeaveSession(sessionId);
+        }
+        QStatus status = ER_OK;
+        if (bus.IsConnected()) {
+            status = bus.Disconnect();
+        }
+        bus.Stop();
+        bus.Join();
+        if (status == ER_OK) {
+            recorder.Success(PHASE_TEARDOWN, NowMicros() - t0);
+        } else {
+            recorder.Failure(PHASE_TEARDOWN, status);
+        }
+    }
+
+    uint64_t Expires() const { return expires; }
+
+  private:
+    BusAttachment bus;
+    SessionId sessionId;
+    uint64_t expires;
+};
+
+/**
+ * A storm thread starts clients at its share of the ramp rate and holds each one for the hold
+ * time so one thread can keep many clients connected at once.
+ */
+class StormThread : public Thread {
+  public:
+    StormThread(const StormConfig& config, Recorder& recorder, size_t first, size_t stride) :
+        Thread("StormThread"), config(config), recorder(recorder), next(first), stride(stride) { }
+
+  private:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        list<StormClient*> live;
+        while (!g_interrupt && !IsStopping() && ((next < config.clients) || !live.empty())) {
+            uint64_t now = NowMicros();
+            bool busy = false;
+            if (next < config.clients) {
+                uint64_t due = config.startTime + (config.rampRate > 0 ? static_cast<uint64_t>((next * 1000000.0) / config.rampRate) : 0);
+                if (now >= due) {
+                    StormClient* client = new StormClient(next);
+                    if (client->Run(config, recorder)) {
+                        live.push_back(client);
+                    } else {
+                        client->Teardown(recorder);
+                        delete client;
+                    }
+                    next += stride;
+                    busy = true;
+                }
+            }
+            while (!live.empty() && (live.front()->Expires() <= now)) {
+                live.front()->Teardown(recorder);
+                delete live.front();
+                live.pop_front();
+                busy = true;
+            }
+            if (!busy) {
+                qcc::Sleep(1);
+            }
+        }
+        while (!live.empty()) {
+            live.front()->Teardown(recorder);
+            delete live.front();
+            live.pop_front();
+        }
+        return 0;
+    }
+
+    const StormConfig& config;
+    Recorder& recorder;
+    size_t next;
+    size_t stride;
+};
+
+/**
+ * Samples the resource usage of the daemon from /proc. Only implemented for Linux; on other
+ * platforms no samples are taken.
+ */
+class ResourceSampler : public Thread {
+  public:
+    ResourceSampler(uint32_t pid, FILE* out) : Thread("ResourceSampler"), pid(pid), out(out) { }
+
+  private:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+#if defined(QCC_OS_LINUX)
+        fprintf(out, "time_s,rss_kb,threads,fds,cpu_pct\n");
+        String dir = "/proc/" + U32ToString(pid);
+        long ticksPerSec = sysconf(_SC_CLK_TCK);
+        uint64_t start = NowMicros();
+        uint64_t lastTime = start;
+        unsigned long long lastTicks = 0;
+        bool first = true;
+        while (!IsStopping()) {
+            unsigned long rssKb = 0;
+            unsigned long threads = 0;
+            FILE* f = fopen((dir + "/status").c_str(), "r");
+            if (!f) {
+                QCC_LogError(ER_OS_ERROR, ("Daemon process %u has gone", pid));
+                break;
+            }
+            char line[256];
+            while (fgets(line, sizeof(line), f)) {
+                sscanf(line, "VmRSS: %lu", &rssKb);
+                sscanf(line, "Threads: %lu", &threads);
+            }
+            fclose(f);
+
+            unsigned long long ticks = 0;
+            f = fopen((dir + "/stat").c_str(), "r");
+            if (f) {
+                /* utime and stime are fields 14 and 15, after the parenthesized command name */
+                char buf[1024];
+                size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+                buf[len] = 0;
+                const char* p = strrchr(buf, ')');
+                unsigned long utime = 0;
+                unsigned long stime = 0;
+                if (p && (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) == 2)) {
+                    ticks = utime + stime;
+                }
+                fclose(f);
+            }
+
+            size_t fds = 0;
+            DIR* d = opendir((dir + "/fd").c_str());
+            if (d) {
+                while (readdir(d)) {
+                    ++fds;
+                }
+                closedir(d);
+                fds = (fds > 2) ? fds - 2 : 0;  /* . and .. */
+            }
+
+            uint64_t now = NowMicros();
+            double cpu = 0.0;
+            if (!first && (now > lastTime)) {
+                cpu = (100.0 * (ticks - lastTicks) / ticksPerSec) / ((now - lastTime) / 1000000.0);
+            }
+            fprintf(out, "%.1f,%lu,%lu,%u,%.1f\n", (now - start) / 1000000.0, rssKb, threads, (unsigned)fds, cpu);
+            fflush(out);
+            first = false;
+            lastTime = now;
+            lastTicks = ticks;
+            Event::Wait(Event::neverSet, 1000);
+        }
+#else
+        QCC_LogError(ER_NOT_IMPLEMENTED, ("Daemon resource sampling is only supported on Linux"));
+#endif
+        return 0;
+    }
+
+    uint32_t pid;
+    FILE* out;
+};
+
+/** The session host: accepts every joiner */
+class HostListener : public SessionPortListener {
+    bool AcceptSessionJoiner(SessionPort sessionPort, const char* joiner, const SessionOpts& opts) { return true; }
+};
+
+static int RunHost(const String& connectSpec, const String& name, bool secure)
+{
+    BusAttachment bus("bbstorm-host", true);
+    HostListener listener;
+    QStatus status = bus.Start();
+    if ((status == ER_OK) && secure) {
+        status = bus.EnablePeerSecurity("ALLJOYN_SRP_KEYX", &g_authListener);
+        bus.ClearKeyStore();
+    }
+    if (status == ER_OK) {
+        status = connectSpec.empty() ? bus.Connect() : bus.Connect(connectSpec.c_str());
+    }
+    if (status == ER_OK) {
+        SessionPort port = ::org::alljoyn::storm::SessionPort;
+        SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+        status = bus.BindSessionPort(port, opts, listener);
+    }
+    if (status == ER_OK) {
+        status = bus.RequestName(name.c_str(), DBUS_NAME_FLAG_REPLACE_EXISTING | DBUS_NAME_FLAG_DO_NOT_QUEUE);
+    }
+    if (status == ER_OK) {
+        status = bus.AdvertiseName(name.c_str(), TRANSPORT_ANY);
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to set up session host %s", name.c_str()));
+        return (int)status;
+    }
+    fprintf(stderr, "bbstorm host %s ready\n", name.c_str());
+    while (!g_interrupt) {
+        qcc::Sleep(100);
+    }
+    return 0;
+}
+
+/** Find the session host so JoinSession works through a remote daemon too */
+class FindListener : public BusListener {
+  public:
+    void FoundAdvertisedName(const char* name, TransportMask transport, const char* namePrefix) { found.SetEvent(); }
+    Event found;
+};
+
+static void FindHost(const StormConfig& config)
+{
+    BusAttachment bus("bbstorm-find", true);
+    FindListener listener;
+    bus.RegisterBusListener(listener);
+    if ((bus.Start() == ER_OK) && ((config.connectSpec.empty() ? bus.Connect() : bus.Connect(config.connectSpec.c_str())) == ER_OK)) {
+        if (bus.FindAdvertisedName(config.hostName.c_str()) == ER_OK) {
+            if (Event::Wait(listener.found, 10000) != ER_OK) {
+                fprintf(stderr, "Session host %s not found, joins will probably fail\n", config.hostName.c_str());
+            }
+        }
+    }
+    bus.UnregisterBusListener(listener);
+}
+
+static void RunStorm(StormConfig& config, size_t numThreads, Recorder& recorder)
+{
+    if (config.join) {
+        FindHost(config);
+    }
+    config.startTime = NowMicros();
+    vector<StormThread*> threads;
+    for (size_t i = 0; i < numThreads; ++i) {
+        threads.push_back(new StormThread(config, recorder, i, numThreads));
+        threads.back()->Start();
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->Join();
+        delete threads[i];
+    }
+}
+
+static void usage(void)
+{
+    printf("Usage: bbstorm [-h] [-host] [-c <connect spec>] [-n <name>] [-C #] [-r #] [-t #] [-p #] [-d #] [-j] [-e]\n"
+           "               [-D <daemon pid>] [-R <file>] [-f csv|json] [-o <file>]\n\n");
+    printf("Options:\n");
+    printf("   -h                  = Print this help message\n");
+    printf("   -host               = Run as the session host instead of generating load\n");
+    printf("   -c <connect spec>   = Daemon to connect to (default BUS_ADDRESS or the platform default)\n");
+    printf("   -n <name>           = Well-known name of the session host (default %s)\n", ::org::alljoyn::storm::DefaultWellKnownName);
+    printf("   -C #                = Total number of clients (default 1000)\n");
+    printf("   -r #                = Total clients started per second, 0 for as fast as possible (default 100)\n");
+    printf("   -t #                = Threads per process (default 8)\n");
+    printf("   -p #                = Processes (default 1, POSIX only)\n");
+    printf("   -d #                = Milliseconds each client stays connected (default 5000)\n");
+    printf("   -j                  = Join a session with the host after connecting\n");
+    printf("   -e                  = Authenticate with the host (SRP key exchange), requires -j\n");
+    printf("   -D <daemon pid>     = Sample the daemon's memory, threads, fds and CPU once a second (Linux only)\n");
+    printf("   -R <file>           = Write daemon resource samples to a file (default stderr)\n");
+    printf("   -f csv|json         = Result format (default csv)\n");
+    printf("   -o <file>           = Write latency results to a file instead of stdout\n");
+    printf("\n");
+}
+
+/** Main entry point */
+int main(int argc, char** argv)
+{
+    StormConfig config;
+    config.connectSpec = Environ::GetAppEnviron()->Find("BUS_ADDRESS");
+    config.hostName = ::org::alljoyn::storm::DefaultWellKnownName;
+    config.join = false;
+    config.secure = false;
+    config.holdMs = 5000;
+    config.clients = 1000;
+    config.rampRate = 100;
+    config.startTime = 0;
+    bool host = false;
+    bool json = false;
+    size_t numThreads = 8;
+    size_t numProcesses = 1;
+    uint32_t daemonPid = 0;
+    FILE* out = stdout;
+    FILE* resourceOut = stderr;
+
+    /* Install SIGINT handler */
+    signal(SIGINT, SigIntHandler);
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        const char* opt = argv[i];
+        bool hasParam = (0 == strcmp("-c", opt)) || (0 == strcmp("-n", opt)) || (0 == strcmp("-C", opt)) || (0 == strcmp("-r", opt)) ||
+                        (0 == strcmp("-t", opt)) || (0 == strcmp("-p", opt)) || (0 == strcmp("-d", opt)) || (0 == strcmp("-D", opt)) ||
+                        (0 == strcmp("-R", opt)) || (0 == strcmp("-f", opt)) || (0 == strcmp("-o", opt));
+        if (hasParam && (++i == argc)) {
+            printf("option %s requires a parameter\n", opt);
+            usage();
+            exit(1);
+        }
+        if (0 == strcmp("-host", opt)) {
+            host = true;
+        } else if (0 == strcmp("-c", opt)) {
+            config.connectSpec = argv[i];
+        } else if (0 == strcmp("-n", opt)) {
+            config.hostName = argv[i];
+        } else if (0 == strcmp("-C", opt)) {
+            config.clients = strtoul(argv[i], NULL, 10);
+        } else if (0 == strcmp("-r", opt)) {
+            config.rampRate = strtod(argv[i], NULL);
+        } else if (0 == strcmp("-t", opt)) {
+            numThreads = (std::max)(strtoul(argv[i], NULL, 10), 1UL);
+        } else if (0 == strcmp("-p", opt)) {
+            numProcesses = (std::max)(strtoul(argv[i], NULL, 10), 1UL);
+        } else if (0 == strcmp("-d", opt)) {
+            config.holdMs = strtoul(argv[i], NULL, 10);
+        } else if (0 == strcmp("-D", opt)) {
+            daemonPid = strtoul(argv[i], NULL, 10);
+        } else if (0 == strcmp("-R", opt)) {
+            resourceOut = fopen(argv[i], "w");
+            if (!resourceOut) {
+                printf("Failed to open %s for writing\n", argv[i]);
+                exit(1);
+            }
+        } else if (0 == strcmp("-f", opt)) {
+            json = (0 == strcmp("json", argv[i]));
+        } else if (0 == strcmp("-o", opt)) {
+            out = fopen(argv[i], "w");
+            if (!out) {
+                printf("Failed to open %s for writing\n", argv[i]);
+                exit(1);
+            }
+        } else if (0 == strcmp("-j", opt)) {
+            config.join = true;
+        } else if (0 == strcmp("-e", opt)) {
+            config.secure = true;
+        } else if (0 == strcmp("-h", opt)) {
+            usage();
+            exit(0);
+        } else {
+            printf("Unknown option %s\n", opt);
+            usage();
+            exit(1);
+        }
+    }
+
+    fprintf(stderr, "AllJoyn Library version: %s\n", ajn::GetVersion());
+    fprintf(stderr, "AllJoyn Library build info: %s\n", ajn::GetBuildInfo());
+
+    if (host) {
+        return RunHost(config.connectSpec, config.hostName, config.secure);
+    }
+
+    Recorder recorder;
+    ResourceSampler* sampler = NULL;
+    if (daemonPid) {
+        sampler = new ResourceSampler(daemonPid, resourceOut);
+        sampler->Start();
+    }
+
+    const size_t totalClients = config.clients;
+    const double totalRate = config.rampRate;
+#if defined(QCC_OS_GROUP_POSIX)
+    if (numProcesses > 1) {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            printf("pipe failed: %s\n", strerror(errno));
+            exit(1);
+        }
+        vector<pid_t> children;
+        for (size_t p = 0; p < numProcesses; ++p) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                /* Each child takes an equal share of the clients and the ramp rate */
+                close(fds[0]);
+                recorder.SetPipe(fds[1]);
+                config.clients = (totalClients / numProcesses) + ((p < (totalClients % numProcesses)) ? 1 : 0);
+                config.rampRate = totalRate / numProcesses;
+                RunStorm(config, numThreads, recorder);
+                close(fds[1]);
+                _exit(0);
+            } else if (pid > 0) {
+                children.push_back(pid);
+            } else {
+                printf("fork failed: %s\n", strerror(errno));
+            }
+        }
+        close(fds[1]);
+        FILE* samples = fdopen(fds[0], "r");
+        char line[128];
+        while (samples && fgets(line, sizeof(line), samples)) {
+            recorder.ParseLine(line);
+        }
+        if (samples) {
+            fclose(samples);
+        }
+        for (size_t p = 0; p < children.size(); ++p) {
+            waitpid(children[p], NULL, 0);
+        }
+    } else
+#endif
+    {
+        numProcesses = 1;
+        RunStorm(config, numThreads, recorder);
+    }
+
+    if (sampler) {
+        sampler->Stop();
+        sampler->Join();
+        delete sampler;
+    }
+    recorder.Report(out, json, totalClients, numProcesses, numThreads, totalRate);
+    if (out != stdout) {
+        fclose(out);
+    }
+    if (resourceOut != stderr) {
+        fclose(resourceOut);
+    }
+    return 0;
+}
@@ -15,8 +15,11 @@
  ******************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <vector>
 #include <qcc/BigNum.h>
+#include <qcc/time.h>
 
 using namespace qcc;
 
@@ -97,8 +100,62 @@ static const char* Primes[] = {
 
 static const uint8_t zeroes[256] = { 0 };
 
-int main()
+/*
+ * Time the modular exponentiations an SRP exchange is made of: g^x mod N with the generator as
+ * base and a random base, for the 1024 and 1536 bit SRP groups and exponents of the size the SRP
+ * implementation draws.
+ */
+static void Benchmark(int iterations)
 {
+    static const struct {
+        const char* name;
+        const uint8_t* prime;
+        size_t len;
+    } groups[] = {
+        { "srp-1024", Prime1024, sizeof(Prime1024) },
+        { "srp-1536", Prime1536, sizeof(Prime1536) }
+    };
+    static const size_t EXPONENT_BYTES = 32;
+
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    printf("%-10s  %-10s  %10s  %12s\n", "group", "base", "ops", "ms/op");
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); ++g) {
+        BigNum N;
+        N.set_bytes(groups[g].prime, groups[g].len);
+        for (int random = 0; random < 2; ++random) {
+            BigNum base = 2;
+            if (random) {
+                base.gen_rand(groups[g].len);
+                base = base % N;
+            }
+            std::vector<BigNum> exponents(iterations);
+            for (int i = 0; i < iterations; ++i) {
+                exponents[i].gen_rand(EXPONENT_BYTES);
+            }
+            BigNum result;
+            uint64_t start = GetTimestamp64();
+            for (int i = 0; i < iterations; ++i) {
+                result = base.mod_exp(exponents[i], N);
+            }
+            uint64_t elapsed = GetTimestamp64() - start;
+            CHECK(result < N);
+            printf("%-10s  %-10s  %10d  %12.3f\n", groups[g].name, random ? "random" : "generator",
+                   iterations, static_cast<double>(elapsed) / iterations);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    /* -b [iterations] only runs the benchmark */
+    if ((argc > 1) && (strcmp(argv[1], "-b") == 0)) {
+        Benchmark((argc > 2) ? atoi(argv[2]) : 100);
+        return 0;
+    }
+
     BigNum M;
     BigNum E;
     BigNum bn1;
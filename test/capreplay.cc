@@ -0,0 +1,208 @@
+/**
+ * @file
+ *
+ * Replay a message capture into a running daemon and report how fast it was accepted
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/version.h>
+
+#include "../src/BusInternal.h"
+#include "../src/LatencyHistogram.h"
+#include "../src/MessageCapture.h"
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+using namespace ajn;
+
+static void usage(void)
+{
+    printf("Usage: capreplay [-h] -f <file> [-s #] [-n #] [-c]\n\n");
+    printf("Options:\n");
+    printf("   -h         = Print this help message\n");
+    printf("   -f <file>  = Message capture to replay\n");
+    printf("   -s #       = Replay # times faster than captured, 0 replays as fast as possible (default 1)\n");
+    printf("   -n #       = Stop after replaying # messages\n");
+    printf("   -c         = Also replay method calls that expect a reply, the replies are discarded\n");
+    printf("\n");
+}
+
+static void PrintLatency(const char* what, const LatencyHistogram& hist)
+{
+    printf("%-12s  p50 %8u  p90 %8u  p99 %8u  max %8u  (us)\n", what,
+           hist.GetPercentile(500), hist.GetPercentile(900), hist.GetPercentile(990), hist.GetMax());
+}
+
+/** Main entry point */
+int main(int argc, char** argv)
+{
+    QStatus status = ER_OK;
+    const char* fileName = NULL;
+    uint32_t speedup = 1;
+    size_t maxMessages = 0;
+    bool withCalls = false;
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        if ((0 == strcmp("-f", argv[i])) || (0 == strcmp("-s", argv[i])) || (0 == strcmp("-n", argv[i]))) {
+            ++i;
+            if (i == argc) {
+                printf("option %s requires a parameter\n", argv[i - 1]);
+                usage();
+                exit(1);
+            } else if (0 == strcmp("-f", argv[i - 1])) {
+                fileName = argv[i];
+            } else if (0 == strcmp("-s", argv[i - 1])) {
+                speedup = strtoul(argv[i], NULL, 10);
+            } else {
+                maxMessages = strtoul(argv[i], NULL, 10);
+            }
+        } else if (0 == strcmp("-c", argv[i])) {
+            withCalls = true;
+        } else if (0 == strcmp("-h", argv[i])) {
+            usage();
+            exit(0);
+        } else {
+            printf("Unknown option %s\n", argv[i]);
+            usage();
+            exit(1);
+        }
+    }
+    if (!fileName) {
+        printf("A capture file is required\n");
+        usage();
+        exit(1);
+    }
+
+    MessageCapture::Reader reader(fileName);
+    if (reader.GetStatus() != ER_OK) {
+        return (int)reader.GetStatus();
+    }
+
+    qcc::String connectArgs = Environ::GetAppEnviron()->Find("BUS_ADDRESS");
+
+    BusAttachment bus("capreplay", true);
+    status = bus.Start();
+    if (status == ER_OK) {
+        status = connectArgs.empty() ? bus.Connect() : bus.Connect(connectArgs.c_str());
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to connect to the daemon"));
+        return (int)status;
+    }
+
+    /*
+     * Messages are pushed through the router of the bus attachment as if the application had sent
+     * them, so they reach the daemon over one endpoint in the order they were captured. Replies and
+     * errors are skipped since nothing is waiting for them, and encrypted messages because the keys
+     * they were sealed with belong to the original peers.
+     */
+    Router& router = bus.GetInternal().GetRouter();
+    BusEndpoint localEp = BusEndpoint::cast(bus.GetInternal().GetLocalEndpoint());
+    qcc::String sender = bus.GetUniqueName();
+
+    LatencyHistogram pushLatency;
+    LatencyHistogram lag;
+    size_t replayed = 0;
+    size_t skipped = 0;
+    size_t unusable = 0;
+    uint64_t bytes = 0;
+    uint64_t firstCaptured = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+
+    while ((maxMessages == 0) || (replayed < maxMessages)) {
+        MessageCapture::RecordHeader hdr;
+        Message msg(bus);
+        status = reader.Read(bus, hdr, msg);
+        if ((status == ER_EOF) || (reader.GetStatus() != ER_OK)) {
+            break;
+        }
+        if (status != ER_OK) {
+            ++unusable;
+            continue;
+        }
+        AllJoynMessageType type = msg->GetType();
+        if ((type == MESSAGE_METHOD_RET) || (type == MESSAGE_ERROR) || msg->IsEncrypted() ||
+            ((type == MESSAGE_METHOD_CALL) && !withCalls && !(msg->GetFlags() & ALLJOYN_FLAG_NO_REPLY_EXPECTED))) {
+            ++skipped;
+            continue;
+        }
+        if (MessageCapture::SetSender(msg, sender) != ER_OK) {
+            ++unusable;
+            continue;
+        }
+
+        uint64_t now = GetLatencyClock();
+        if (start == 0) {
+            start = now;
+            firstCaptured = hdr.timestamp;
+        }
+        if (speedup) {
+            uint64_t due = start + (hdr.timestamp - firstCaptured) / speedup;
+            if (due > now) {
+                qcc::Sleep(static_cast<uint32_t>((due - now) / 1000));
+                now = GetLatencyClock();
+            }
+            lag.Record(static_cast<uint32_t>((now > due) ? (now - due) : 0));
+        }
+        status = router.PushMessage(msg, localEp);
+        end = GetLatencyClock();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Replay of %s failed", msg->Description().c_str()));
+            ++unusable;
+            continue;
+        }
+        pushLatency.Record(static_cast<uint32_t>(end - now));
+        bytes += hdr.length;
+        ++replayed;
+    }
+    if ((reader.GetStatus() != ER_OK) && (reader.GetStatus() != ER_EOF)) {
+        QCC_LogError(reader.GetStatus(), ("Capture is truncated, stopped early"));
+    }
+
+    uint64_t usecs = (end > start) ? (end - start) : 1;
+    printf("replayed %u messages (%s bytes) in %s us, skipped %u, unusable %u\n",
+           static_cast<uint32_t>(replayed), U64ToString(bytes).c_str(), U64ToString(usecs).c_str(),
+           static_cast<uint32_t>(skipped), static_cast<uint32_t>(unusable));
+    printf("%s msgs/s  %s bytes/s\n",
+           U64ToString((static_cast<uint64_t>(replayed) * 1000000) / usecs).c_str(),
+           U64ToString((bytes * 1000000) / usecs).c_str());
+    PrintLatency("push", pushLatency);
+    if (speedup) {
+        PrintLatency("schedule lag", lag);
+    }
+    return 0;
+}
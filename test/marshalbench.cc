@@ -0,0 +1,465 @@
+/**
+ * @file
+ *
+ * Microbenchmarks for MsgArg construction and message marshaling and unmarshaling
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(QCC_OS_GROUP_WINDOWS)
+#include <windows.h>
+#elif defined(QCC_OS_DARWIN)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include <new>
+#include <vector>
+
+#include <qcc/Debug.h>
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+#include <qcc/ManagedObj.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/version.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for benchmarking */
+#include <RemoteEndpoint.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+using namespace std;
+using namespace ajn;
+
+/*
+ * Every operator new in the process is counted. The benchmarks are single threaded and the bus
+ * is never started so the only allocations are the ones made by the operation being measured.
+ * Buffers that come straight from malloc (such as message buffers) are not counted.
+ */
+static size_t g_allocs = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocs;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+static uint64_t NowNanos()
+{
+#if defined(QCC_OS_GROUP_WINDOWS)
+    static LARGE_INTEGER freq = { 0 };
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>((now.QuadPart / freq.QuadPart) * 1000000000 + ((now.QuadPart % freq.QuadPart) * 1000000000) / freq.QuadPart);
+#elif defined(QCC_OS_DARWIN)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (mach_absolute_time() * timebase.numer) / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** Accumulates the time and allocations of the measured sections of a benchmark loop */
+class Meter {
+  public:
+    Meter() : nanos(0), allocs(0), startNanos(0), startAllocs(0) { }
+
+    void Start()
+    {
+        startAllocs = g_allocs;
+        startNanos = NowNanos();
+    }
+
+    void Stop()
+    {
+        nanos += NowNanos() - startNanos;
+        allocs += g_allocs - startAllocs;
+    }
+
+    uint64_t nanos;
+    size_t allocs;
+
+  private:
+    uint64_t startNanos;
+    size_t startAllocs;
+};
+
+/** Exposes the marshaling internals of _Message */
+class _BenchMessage : public _Message {
+  public:
+    _BenchMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus Marshal(const MsgArg* args, size_t numArgs, uint8_t flags)
+    {
+        return CallMsg(MsgArg::Signature(args, numArgs), "org.alljoyn.bench", 0, "/org/alljoyn/bench", "org.alljoyn.bench", "Op", args, numArgs, flags);
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep) { return _Message::Deliver(ep); }
+
+    QStatus Receive(RemoteEndpoint& ep)
+    {
+        QStatus status = _Message::Read(ep, false);
+        if (status == ER_OK) {
+            status = _Message::Unmarshal(ep, false);
+        }
+        if (status == ER_OK) {
+            status = UnmarshalArgs("*");
+        }
+        return status;
+    }
+};
+
+typedef qcc::ManagedObj<_BenchMessage> BenchMessage;
+
+/*
+ * A benchmark case. Build() constructs the argument with MsgArg::Set() referencing static data
+ * the way an application normally would; Extract() takes it apart again with MsgArg::Get().
+ */
+struct Case {
+    const char* name;
+    void (*Build)(MsgArg& arg);
+    QStatus (*Extract)(const MsgArg& arg);
+};
+
+static const size_t DICT_ENTRIES = 16;
+static const char* dictKeys[DICT_ENTRIES] = {
+    "Name", "Id", "Manufacturer", "Model", "Version", "Enabled", "Temperature", "Humidity",
+    "Latitude", "Longitude", "Description", "Location", "Owner", "Serial", "Uptime", "Status"
+};
+static MsgArg dictValues[DICT_ENTRIES];
+static MsgArg dictEntries[DICT_ENTRIES];
+
+static void BuildDict(MsgArg& arg)
+{
+    for (size_t i = 0; i < DICT_ENTRIES; ++i) {
+        switch (i % 4) {
+        case 0:
+            dictValues[i].Set("s", "a string property value");
+            break;
+
+        case 1:
+            dictValues[i].Set("u", (uint32_t)i);
+            break;
+
+        case 2:
+            dictValues[i].Set("d", i * 0.25);
+            break;
+
+        default:
+            dictValues[i].Set("b", (i & 1) != 0);
+            break;
+        }
+        dictEntries[i].Set("{sv}", dictKeys[i], &dictValues[i]);
+    }
+    arg.Set("a{sv}", DICT_ENTRIES, dictEntries);
+}
+
+static QStatus ExtractDict(const MsgArg& arg)
+{
+    size_t num;
+    MsgArg* entries;
+    QStatus status = arg.Get("a{sv}", &num, &entries);
+    for (size_t i = 0; (status == ER_OK) && (i < num); ++i) {
+        const char* key;
+        MsgArg* val;
+        status = entries[i].Get("{sv}", &key, &val);
+        if ((status == ER_OK) && (val->typeId == ALLJOYN_UINT32)) {
+            uint32_t u;
+            status = val->Get("u", &u);
+        }
+    }
+    return status;
+}
+
+static const size_t BLOB_SIZE = 64 * 1024;
+static uint8_t blob[BLOB_SIZE];
+
+static void BuildBlob(MsgArg& arg)
+{
+    arg.Set("ay", BLOB_SIZE, blob);
+}
+
+static QStatus ExtractBlob(const MsgArg& arg)
+{
+    size_t num;
+    uint8_t* data;
+    return arg.Get("ay", &num, &data);
+}
+
+static const size_t NUM_STRUCTS = 256;
+static MsgArg structs[NUM_STRUCTS];
+
+static void BuildStructs(MsgArg& arg)
+{
+    for (size_t i = 0; i < NUM_STRUCTS; ++i) {
+        structs[i].Set("(iids)", (int32_t)i, -(int32_t)i, i * 0.5, "struct member");
+    }
+    arg.Set("a(iids)", NUM_STRUCTS, structs);
+}
+
+static QStatus ExtractStructs(const MsgArg& arg)
+{
+    size_t num;
+    MsgArg* elems;
+    QStatus status = arg.Get("a(iids)", &num, &elems);
+    for (size_t i = 0; (status == ER_OK) && (i < num); ++i) {
+        int32_t a, b;
+        double d;
+        const char* s;
+        status = elems[i].Get("(iids)", &a, &b, &d, &s);
+    }
+    return status;
+}
+
+static const size_t NUM_VARIANTS = 16;
+static MsgArg variantLeaves[NUM_VARIANTS];
+static MsgArg variantInner[NUM_VARIANTS];
+static MsgArg variantOuter[NUM_VARIANTS];
+
+static void BuildVariants(MsgArg& arg)
+{
+    for (size_t i = 0; i < NUM_VARIANTS; ++i) {
+        variantLeaves[i].Set("(is)", (int32_t)i, "leaf");
+        variantInner[i].Set("v", &variantLeaves[i]);
+        variantOuter[i].Set("v", &variantInner[i]);
+    }
+    arg.Set("av", NUM_VARIANTS, variantOuter);
+}
+
+static QStatus ExtractVariants(const MsgArg& arg)
+{
+    size_t num;
+    MsgArg* elems;
+    QStatus status = arg.Get("av", &num, &elems);
+    for (size_t i = 0; (status == ER_OK) && (i < num); ++i) {
+        MsgArg* inner;
+        MsgArg* leaf;
+        int32_t n;
+        const char* s;
+        status = elems[i].Get("v", &inner);
+        if (status == ER_OK) {
+            status = inner->Get("v", &leaf);
+        }
+        if (status == ER_OK) {
+            status = leaf->Get("(is)", &n, &s);
+        }
+    }
+    return status;
+}
+
+static const Case cases[] = {
+    { "a{sv}",   BuildDict,     ExtractDict },
+    { "ay64k",   BuildBlob,     ExtractBlob },
+    { "a(iids)", BuildStructs,  ExtractStructs },
+    { "avv",     BuildVariants, ExtractVariants }
+};
+
+static const char* ops[] = {
+    "set", "get", "stabilize", "marshal", "unmarshal", "marshal_compressed", "unmarshal_compressed"
+};
+
+static QStatus RunOp(BusAttachment& bus, RemoteEndpoint& ep, const Case& c, size_t op, size_t iterations, Meter& meter)
+{
+    QStatus status = ER_OK;
+    MsgArg arg;
+    c.Build(arg);
+    BenchMessage tx(bus);
+    BenchMessage rx(bus);
+    const uint8_t flags = (op >= 5) ? ALLJOYN_FLAG_COMPRESSED : 0;
+
+    for (size_t i = 0; (status == ER_OK) && (i < iterations); ++i) {
+        switch (op) {
+        case 0:
+            meter.Start();
+            c.Build(arg);
+            meter.Stop();
+            break;
+
+        case 1:
+            meter.Start();
+            status = c.Extract(arg);
+            meter.Stop();
+            break;
+
+        case 2:
+            {
+                MsgArg tmp;
+                c.Build(tmp);
+                meter.Start();
+                tmp.Stabilize();
+                meter.Stop();
+            }
+            break;
+
+        case 3:
+        case 5:
+            meter.Start();
+            status = tx->Marshal(&arg, 1, flags);
+            meter.Stop();
+            break;
+
+        default:
+            status = tx->Marshal(&arg, 1, flags);
+            if (status == ER_OK) {
+                status = tx->Deliver(ep);
+            }
+            if (status == ER_OK) {
+                meter.Start();
+                status = rx->Receive(ep);
+                meter.Stop();
+            }
+            break;
+        }
+    }
+    return status;
+}
+
+static void usage(void)
+{
+    printf("Usage: marshalbench [-h] [-n #] [-f csv|json]\n\n");
+    printf("Options:\n");
+    printf("   -h            = Print this help message\n");
+    printf("   -n #          = Iterations per case and operation (default 2000)\n");
+    printf("   -f csv|json   = Result format (default csv)\n");
+    printf("\n");
+}
+
+/** Main entry point */
+int main(int argc, char** argv)
+{
+    QStatus status = ER_OK;
+    size_t iterations = 2000;
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-n", argv[i])) {
+            ++i;
+            if (i == argc) {
+                printf("option %s requires a parameter\n", argv[i - 1]);
+                usage();
+                exit(1);
+            } else {
+                iterations = strtoul(argv[i], NULL, 10);
+            }
+        } else if (0 == strcmp("-f", argv[i])) {
+            ++i;
+            if (i == argc) {
+                printf("option %s requires a parameter\n", argv[i - 1]);
+                usage();
+                exit(1);
+            } else {
+                json = (0 == strcmp("json", argv[i]));
+            }
+        } else if (0 == strcmp("-h", argv[i])) {
+            usage();
+            exit(0);
+        } else {
+            printf("Unknown option %s\n", argv[i]);
+            usage();
+            exit(1);
+        }
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    memset(blob, 0xA5, sizeof(blob));
+
+    fprintf(stderr, "AllJoyn Library version: %s\n", ajn::GetVersion());
+    fprintf(stderr, "AllJoyn Library build info: %s\n", ajn::GetBuildInfo());
+
+    BusAttachment bus("marshalbench");
+    qcc::Pipe stream;
+    qcc::Pipe* pStream = &stream;
+    const bool incoming = false;
+    RemoteEndpoint ep(bus, incoming, String::Empty, pStream);
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("case,op,iterations,ns_per_op,allocs_per_op\n");
+    }
+    size_t rows = 0;
+    for (size_t c = 0; (status == ER_OK) && (c < ArraySize(cases)); ++c) {
+        for (size_t op = 0; (status == ER_OK) && (op < ArraySize(ops)); ++op) {
+            /* An untimed pass first so lazily created state is not charged to the first case */
+            Meter warmup;
+            status = RunOp(bus, ep, cases[c], op, (iterations / 10) + 1, warmup);
+            Meter meter;
+            if (status == ER_OK) {
+                status = RunOp(bus, ep, cases[c], op, iterations, meter);
+            }
+            if (status != ER_OK) {
+                QCC_LogError(status, ("%s %s failed", cases[c].name, ops[op]));
+                break;
+            }
+            double nsPerOp = (double)meter.nanos / iterations;
+            double allocsPerOp = (double)meter.allocs / iterations;
+            if (json) {
+                printf("%s  {\"case\": \"%s\", \"op\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f}",
+                       rows ? ",\n" : "", cases[c].name, ops[op], (unsigned)iterations, nsPerOp, allocsPerOp);
+            } else {
+                printf("%s,%s,%u,%.1f,%.2f\n", cases[c].name, ops[op], (unsigned)iterations, nsPerOp, allocsPerOp);
+            }
+            ++rows;
+        }
+    }
+    if (json) {
+        printf("%s]\n", rows ? "\n" : "");
+    }
+
+    return (int) status;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file
+ *
+ * Dump and decode the message trace ring of a running daemon
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include <qcc/Debug.h>
+#include <qcc/Environ.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/DBusStd.h>
+#include <alljoyn/version.h>
+
+#include <alljoyn/Status.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace std;
+using namespace qcc;
+using namespace ajn;
+
+static const char* STATS_INTERFACE = "org.alljoyn.Bus.Debug.Stats";
+
+/* Must match MessageTrace::NameHash() in the daemon */
+static uint32_t NameHash(const char* name)
+{
+    if (!name || !*name) {
+        return 0;
+    }
+    uint32_t hash = 2166136261U;
+    while (*name) {
+        hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619U;
+    }
+    return hash;
+}
+
+/* Must match MessageTrace::Stage in the daemon */
+static const char* StageText(uint8_t stage)
+{
+    static const char* stages[] = { "?", "rx", "routed", "queued", "tx", "dropped" };
+    return (stage < ArraySize(stages)) ? stages[stage] : stages[0];
+}
+
+static const char* TypeText(uint8_t type)
+{
+    static const char* types[] = { "?", "call", "reply", "error", "signal" };
+    return (type < ArraySize(types)) ? types[type] : types[0];
+}
+
+static String Decode(const map<uint32_t, String>& names, uint32_t hash)
+{
+    if (hash == 0) {
+        return "-";
+    }
+    map<uint32_t, String>::const_iterator it = names.find(hash);
+    if (it != names.end()) {
+        return it->second;
+    }
+    return "#" + U32ToString(hash, 16, 8, '0');
+}
+
+static void usage(void)
+{
+    printf("Usage: tracedump [-h] [-n #] [-on | -off]\n\n");
+    printf("Options:\n");
+    printf("   -h      = Print this help message\n");
+    printf("   -n #    = Only print the last # events\n");
+    printf("   -on     = Turn trace recording on and exit\n");
+    printf("   -off    = Turn trace recording off and exit\n");
+    printf("\n");
+}
+
+/** Main entry point */
+int main(int argc, char** argv)
+{
+    QStatus status = ER_OK;
+    size_t maxEvents = 0;
+    int recording = -1;
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-n", argv[i])) {
+            ++i;
+            if (i == argc) {
+                printf("option %s requires a parameter\n", argv[i - 1]);
+                usage();
+                exit(1);
+            } else {
+                maxEvents = strtoul(argv[i], NULL, 10);
+            }
+        } else if (0 == strcmp("-on", argv[i])) {
+            recording = 1;
+        } else if (0 == strcmp("-off", argv[i])) {
+            recording = 0;
+        } else if (0 == strcmp("-h", argv[i])) {
+            usage();
+            exit(0);
+        } else {
+            printf("Unknown option %s\n", argv[i]);
+            usage();
+            exit(1);
+        }
+    }
+
+    qcc::String connectArgs = Environ::GetAppEnviron()->Find("BUS_ADDRESS");
+
+    BusAttachment bus("tracedump", true);
+
+    InterfaceDescription* statsIntf = NULL;
+    status = bus.CreateInterface(STATS_INTERFACE, statsIntf);
+    if (status == ER_OK) {
+        statsIntf->AddProperty("Trace", "a(tuuuuyy)", PROP_ACCESS_READ);
+        statsIntf->AddProperty("TraceRecording", "b", PROP_ACCESS_RW);
+        statsIntf->Activate();
+        status = bus.Start();
+    }
+    if (status == ER_OK) {
+        status = connectArgs.empty() ? bus.Connect() : bus.Connect(connectArgs.c_str());
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to connect to the daemon"));
+        return (int)status;
+    }
+
+    ProxyBusObject dbgObj = bus.GetAllJoynDebugObj();
+    dbgObj.AddInterface(*statsIntf);
+
+    if (recording >= 0) {
+        MsgArg val("b", recording == 1);
+        status = dbgObj.SetProperty(STATS_INTERFACE, "TraceRecording", val);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to set TraceRecording (is this a debug build of the daemon?)"));
+        }
+        return (int)status;
+    }
+
+    /* Snapshot the trace first so names of endpoints that leave meanwhile are still listed */
+    MsgArg trace;
+    status = dbgObj.GetProperty(STATS_INTERFACE, "Trace", trace);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to get Trace (is this a debug build of the daemon?)"));
+        return (int)status;
+    }
+
+    map<uint32_t, String> names;
+    Message reply(bus);
+    status = bus.GetDBusProxyObj().MethodCall(org::freedesktop::DBus::InterfaceName, "ListNames", NULL, 0, reply);
+    if (status == ER_OK) {
+        size_t numNames;
+        MsgArg* nameArgs;
+        if (reply->GetArg(0)->Get("as", &numNames, &nameArgs) == ER_OK) {
+            for (size_t i = 0; i < numNames; ++i) {
+                names[NameHash(nameArgs[i].v_string.str)] = nameArgs[i].v_string.str;
+            }
+        }
+    } else {
+        QCC_LogError(status, ("ListNames failed, names will not be decoded"));
+    }
+
+    size_t numEvents;
+    MsgArg* events;
+    status = trace.Get("a(tuuuuyy)", &numEvents, &events);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Unexpected Trace signature"));
+        return (int)status;
+    }
+    size_t first = (maxEvents && (numEvents > maxEvents)) ? (numEvents - maxEvents) : 0;
+    uint64_t start = 0;
+
+    printf("     time(us)  stage    type    serial  sender                    destination               endpoint\n");
+    for (size_t i = first; i < numEvents; ++i) {
+        uint64_t timestamp;
+        uint32_t serial, sender, destination, endpoint;
+        uint8_t type, stage;
+        events[i].Get("(tuuuuyy)", &timestamp, &serial, &sender, &destination, &endpoint, &type, &stage);
+        if (i == first) {
+            start = timestamp;
+        }
+        printf("%13s  %-7s  %-6s  %6u  %-24s  %-24s  %s\n",
+               U64ToString(timestamp - start).c_str(), StageText(stage), TypeText(type), serial,
+               Decode(names, sender).c_str(), Decode(names, destination).c_str(), Decode(names, endpoint).c_str());
+    }
+    return 0;
+}
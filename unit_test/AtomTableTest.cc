@@ -0,0 +1,121 @@
+/**
+ * @file
+ *
+ * This file tests the interned string atom table
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+#include <qcc/String.h>
+#include <qcc/Thread.h>
+
+#include <alljoyn/Message.h>
+#include "AtomTable.h"
+
+#include <gtest/gtest.h>
+
+using namespace qcc;
+using namespace ajn;
+
+TEST(AtomTableTest, intern_and_find) {
+    EXPECT_EQ(ATOM_NONE, AtomTable::Intern(""));
+    EXPECT_EQ(ATOM_NONE, AtomTable::Intern((const char*)NULL));
+    EXPECT_EQ(ATOM_NONE, AtomTable::Find(""));
+
+    Atom a = AtomTable::Intern("org.alljoyn.test.AtomTable");
+    EXPECT_NE(ATOM_NONE, a);
+    EXPECT_NE(ATOM_UNKNOWN, a);
+    EXPECT_EQ(a, AtomTable::Intern(qcc::String("org.alljoyn.test.AtomTable")));
+    EXPECT_EQ(a, AtomTable::Find("org.alljoyn.test.AtomTable"));
+
+    Atom b = AtomTable::Intern("org.alljoyn.test.AtomTable2");
+    EXPECT_NE(a, b);
+}
+
+TEST(AtomTableTest, find_does_not_intern) {
+    EXPECT_EQ(ATOM_UNKNOWN, AtomTable::Find("org.alljoyn.test.NeverInterned"));
+    EXPECT_EQ(ATOM_UNKNOWN, AtomTable::Find("org.alljoyn.test.NeverInterned"));
+}
+
+/* Interns a string on a thread other than the test's */
+class InternThread : public qcc::Thread {
+  public:
+    InternThread(const char* str) : Thread("InternThread"), str(str), atom(ATOM_NONE) { }
+
+    const char* str;
+    Atom atom;
+
+  protected:
+    qcc::ThreadReturn STDCALL Run(void* arg)
+    {
+        atom = AtomTable::Intern(str);
+        return 0;
+    }
+};
+
+TEST(AtomTableTest, cached_lookups) {
+    Atom a = AtomTable::Intern("org.alljoyn.test.Cached");
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(a, AtomTable::Find("org.alljoyn.test.Cached"));
+    }
+
+    /* A miss remembered by this thread does not hide a string another thread interns */
+    EXPECT_EQ(ATOM_UNKNOWN, AtomTable::Find("org.alljoyn.test.CachedLater"));
+    InternThread thread("org.alljoyn.test.CachedLater");
+    ASSERT_EQ(ER_OK, thread.Start());
+    ASSERT_EQ(ER_OK, thread.Join());
+    EXPECT_NE(ATOM_NONE, thread.atom);
+    EXPECT_EQ(thread.atom, AtomTable::Find("org.alljoyn.test.CachedLater"));
+
+    /* Atoms found before are still found after the misses are dropped */
+    EXPECT_EQ(a, AtomTable::Find("org.alljoyn.test.Cached"));
+}
+
+TEST(AtomTableTest, header_atoms) {
+    HeaderFields hdrFields;
+    Atom iface = AtomTable::Intern("org.alljoyn.test.Header");
+    hdrFields.field[ALLJOYN_HDR_FIELD_INTERFACE].Set("s", "org.alljoyn.test.Header");
+    hdrFields.field[ALLJOYN_HDR_FIELD_MEMBER].Set("s", "NotInterned");
+
+    /* Atoms are looked up on demand before they are cached */
+    EXPECT_EQ(iface, AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_INTERFACE));
+    EXPECT_EQ(ATOM_NONE, AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_PATH));
+
+    AtomTable::SetHeaderAtoms(hdrFields);
+    EXPECT_EQ(iface, hdrFields.atoms[ALLJOYN_HDR_FIELD_INTERFACE]);
+    EXPECT_EQ(ATOM_UNKNOWN, AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_MEMBER));
+
+    HeaderFields copy(hdrFields);
+    EXPECT_EQ(iface, copy.atoms[ALLJOYN_HDR_FIELD_INTERFACE]);
+}
+
+TEST(AtomTableTest, unknown_header_atom_resolved_after_intern) {
+    HeaderFields hdrFields;
+    hdrFields.field[ALLJOYN_HDR_FIELD_MEMBER].Set("s", "InternedLater");
+    AtomTable::SetHeaderAtoms(hdrFields);
+    EXPECT_EQ(ATOM_UNKNOWN, hdrFields.atoms[ALLJOYN_HDR_FIELD_MEMBER]);
+    EXPECT_EQ(ATOM_UNKNOWN, AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_MEMBER));
+
+    /* A handler registered after the message was received interns the member */
+    Atom member = AtomTable::Intern("InternedLater");
+    EXPECT_EQ(member, AtomTable::GetHeaderAtom(hdrFields, ALLJOYN_HDR_FIELD_MEMBER));
+
+    /* Caching again picks up the new atom */
+    AtomTable::SetHeaderAtoms(hdrFields);
+    EXPECT_EQ(member, hdrFields.atoms[ALLJOYN_HDR_FIELD_MEMBER]);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * This file tests the message body compressor
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+
+#include <qcc/platform.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "BodyCompressor.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+static void RoundTrip(const std::vector<uint8_t>& in, size_t& compressedLen)
+{
+    std::vector<uint8_t> packed(in.size() + in.size() / 255 + 16);
+    compressedLen = BodyCompressor::Compress(in.empty() ? NULL : &in[0], in.size(), &packed[0], packed.size());
+    ASSERT_NE(0U, compressedLen);
+    std::vector<uint8_t> out(in.size() + 1);
+    ASSERT_TRUE(BodyCompressor::Expand(&packed[0], compressedLen, &out[0], in.size()));
+    EXPECT_TRUE(memcmp(&in[0], &out[0], in.size()) == 0);
+    /* The expanded length must match exactly */
+    EXPECT_FALSE(BodyCompressor::Expand(&packed[0], compressedLen, &out[0], in.size() + 1));
+}
+
+TEST(BodyCompressorTest, json_compresses) {
+    std::vector<uint8_t> in;
+    for (int i = 0; i < 100; ++i) {
+        char record[128];
+        snprintf(record, sizeof(record), "{\"sensor\":\"temperature\",\"unit\":\"celsius\",\"index\":%d,\"value\":%d},", i, 20 + (i % 7));
+        in.insert(in.end(), record, record + strlen(record));
+    }
+    size_t compressedLen;
+    RoundTrip(in, compressedLen);
+    EXPECT_LT(compressedLen * 4, in.size());
+}
+
+TEST(BodyCompressorTest, long_runs_and_literals) {
+    std::vector<uint8_t> in(70000, 0x55);
+    uint32_t lcg = 1;
+    for (size_t i = 30000; i < 31000; ++i) {
+        lcg = lcg * 1103515245 + 12345;
+        in[i] = static_cast<uint8_t>(lcg >> 16);
+    }
+    size_t compressedLen;
+    RoundTrip(in, compressedLen);
+    EXPECT_LT(compressedLen, 2000U);
+}
+
+TEST(BodyCompressorTest, short_input) {
+    const char* text = "hello";
+    std::vector<uint8_t> in(text, text + strlen(text));
+    size_t compressedLen;
+    RoundTrip(in, compressedLen);
+}
+
+TEST(BodyCompressorTest, incompressible_does_not_fit) {
+    std::vector<uint8_t> in(1024);
+    uint32_t lcg = 7;
+    for (size_t i = 0; i < in.size(); ++i) {
+        lcg = lcg * 1103515245 + 12345;
+        in[i] = static_cast<uint8_t>(lcg >> 16);
+    }
+    std::vector<uint8_t> packed(in.size());
+    EXPECT_EQ(0U, BodyCompressor::Compress(&in[0], in.size(), &packed[0], packed.size() - 8));
+}
+
+TEST(BodyCompressorTest, rejects_corrupt_input) {
+    std::vector<uint8_t> in(4096);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<uint8_t>(i % 61);
+    }
+    std::vector<uint8_t> packed(in.size());
+    size_t len = BodyCompressor::Compress(&in[0], in.size(), &packed[0], packed.size());
+    ASSERT_NE(0U, len);
+    std::vector<uint8_t> out(in.size());
+    /* A truncated stream or one whose offsets point before the start must fail */
+    EXPECT_FALSE(BodyCompressor::Expand(&packed[0], len - 1, &out[0], out.size()));
+    for (size_t i = 0; i < len; ++i) {
+        std::vector<uint8_t> bad(packed.begin(), packed.begin() + len);
+        bad[i] ^= 0xFF;
+        BodyCompressor::Expand(&bad[0], bad.size(), &out[0], out.size());
+    }
+}
@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 
 #include <qcc/String.h>
@@ -532,3 +533,144 @@ TEST_F(BusAttachmentTest, GetDBusProxyObj) {
     replyMsg->GetArg(0)->Get("u", &requestNameResponce);
     EXPECT_EQ(DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER, requestNameResponce);
 }
+
+TEST_F(BusAttachmentTest, AddMatches) {
+    const char* rules[] = {
+        "type='signal',interface='org.alljoyn.test.BusAttachment',member='a'",
+        "type='bogus'",
+        "type='signal',interface='org.alljoyn.test.BusAttachment',member='b'"
+    };
+    QStatus statuses[3];
+    QStatus status = bus.AddMatches(rules, 3, statuses);
+    EXPECT_EQ(ER_FAIL, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(ER_OK, statuses[0]) << "  Actual Status: " << QCC_StatusText(statuses[0]);
+    EXPECT_EQ(ER_FAIL, statuses[1]) << "  Actual Status: " << QCC_StatusText(statuses[1]);
+    EXPECT_EQ(ER_OK, statuses[2]) << "  Actual Status: " << QCC_StatusText(statuses[2]);
+
+    /* A replacement with a bad rule changes nothing */
+    status = bus.ReplaceMatches(rules, 3);
+    EXPECT_EQ(ER_FAIL, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    status = bus.ReplaceMatches(rules, 1);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    const char* removeRules[] = { rules[0], rules[2] };
+    status = bus.RemoveMatches(removeRules, 2);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    status = bus.ReplaceMatches(NULL, 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+}
+
+class Arg0NamespaceListener : public BusListener {
+  public:
+    Arg0NamespaceListener() : sawMatch(false), sawOther(false) { }
+    void NameOwnerChanged(const char* busName, const char* previousOwner, const char* newOwner) {
+        if (strncmp(busName, "org.alljoyn.test.Arg0.", strlen("org.alljoyn.test.Arg0.")) == 0) {
+            sawMatch = true;
+        } else {
+            sawOther = true;
+        }
+    }
+    volatile bool sawMatch;
+    volatile bool sawOther;
+};
+
+TEST_F(BusAttachmentTest, Arg0NamespaceMatch) {
+    Arg0NamespaceListener listener;
+    bus.RegisterBusListener(listener);
+
+    /* Swap the catch-all rule added by Connect for one that only wants names in the namespace */
+    const char* rule = "type='signal',interface='org.freedesktop.DBus',member='NameOwnerChanged',arg0namespace='org.alljoyn.test.Arg0'";
+    QStatus status = bus.ReplaceMatches(&rule, 1);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    BusAttachment otherBus("BusAttachmentTestOther", false);
+    status = otherBus.Start();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = otherBus.Connect(getConnectArg().c_str());
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    uint32_t flags = DBUS_NAME_FLAG_REPLACE_EXISTING | DBUS_NAME_FLAG_DO_NOT_QUEUE;
+    status = otherBus.RequestName("org.alljoyn.test.Arg0x", flags);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = otherBus.RequestName("org.alljoyn.test.Arg0.a", flags);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    for (size_t i = 0; !listener.sawMatch && (i < 200); ++i) {
+        qcc::Sleep(5);
+    }
+    /* Signals arrive in order so anything that got past the rule would have been seen first */
+    EXPECT_TRUE(listener.sawMatch);
+    EXPECT_FALSE(listener.sawOther);
+
+    const char* connectRule = "type='signal',interface='org.freedesktop.DBus'";
+    status = bus.ReplaceMatches(&connectRule, 1);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    bus.UnregisterBusListener(listener);
+
+    otherBus.Stop();
+    otherBus.Join();
+}
+
+TEST_F(BusAttachmentTest, NameOwnerCache) {
+    QStatus status = ER_OK;
+    BusAttachment otherBus("BusAttachmentTestOther", false);
+    status = otherBus.Start();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = otherBus.Connect(getConnectArg().c_str());
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    uint32_t flags = DBUS_NAME_FLAG_REPLACE_EXISTING | DBUS_NAME_FLAG_DO_NOT_QUEUE;
+    status = otherBus.RequestName("org.alljoyn.test.NameOwnerCache.a", flags);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    qcc::String owner;
+    EXPECT_FALSE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.a", owner));
+    status = bus.AddNameOwnerCache("org.alljoyn.test.NameOwnerCache.");
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* Names that were owned before the cache was added are filled in */
+    EXPECT_TRUE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.a", owner));
+    EXPECT_STREQ(otherBus.GetUniqueName().c_str(), owner.c_str());
+    EXPECT_TRUE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.b", owner));
+    EXPECT_TRUE(owner.empty());
+    EXPECT_FALSE(bus.GetCachedNameOwner("org.alljoyn.test.Other", owner));
+
+    /* Later changes arrive with NameOwnerChanged */
+    status = otherBus.RequestName("org.alljoyn.test.NameOwnerCache.b", flags);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = otherBus.ReleaseName("org.alljoyn.test.NameOwnerCache.a");
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    for (size_t i = 0; i < 200; ++i) {
+        bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.a", owner);
+        if (owner.empty()) {
+            break;
+        }
+        qcc::Sleep(5);
+    }
+    EXPECT_TRUE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.a", owner));
+    EXPECT_TRUE(owner.empty());
+    EXPECT_TRUE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.b", owner));
+    EXPECT_STREQ(otherBus.GetUniqueName().c_str(), owner.c_str());
+
+    bus.RemoveNameOwnerCache("org.alljoyn.test.NameOwnerCache.");
+    EXPECT_FALSE(bus.GetCachedNameOwner("org.alljoyn.test.NameOwnerCache.b", owner));
+
+    otherBus.Stop();
+    otherBus.Join();
+}
+
+TEST_F(BusAttachmentTest, SetDispatchScheduling)
+{
+    QStatus status = bus.SetDispatchScheduling(static_cast<BusAttachment::SchedulingPolicy>(7), 0);
+    EXPECT_EQ(ER_BAD_ARG_1, status) << "  Actual Status: " << QCC_StatusText(status);
+#if defined(QCC_OS_GROUP_POSIX)
+    status = bus.SetDispatchScheduling(BusAttachment::SCHEDULING_FIFO, 1000);
+    EXPECT_EQ(ER_BAD_ARG_2, status) << "  Actual Status: " << QCC_StatusText(status);
+#endif
+    /* Messages are still delivered by threads that pick up a new setting */
+    status = bus.SetDispatchScheduling(BusAttachment::SCHEDULING_DEFAULT, 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = bus.RequestName("org.alljoyn.test.SetDispatchScheduling", DBUS_NAME_FLAG_DO_NOT_QUEUE);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+}
@@ -14,6 +14,7 @@
  *    limitations under the License.
  ******************************************************************************/
 #include <gtest/gtest.h>
+#include <vector>
 #include "ajTestCommon.h"
 #include <alljoyn/Message.h>
 #include <alljoyn/BusAttachment.h>
@@ -23,7 +24,10 @@
 #include <alljoyn/InterfaceDescription.h>
 #include <alljoyn/DBusStd.h>
 #include <qcc/Debug.h>
+#include <qcc/Mutex.h>
 #include <qcc/Thread.h>
+#include <qcc/Util.h>
+#include <qcc/atomic.h>
 
 using namespace ajn;
 using namespace qcc;
@@ -83,3 +87,196 @@ TEST_F(BusObjectTest, DISABLED_ObjectRegisteredUnregistered) {
     EXPECT_TRUE(testObj.wasRegistered);
     EXPECT_TRUE(testObj.wasUnregistered);
 }
+
+TEST_F(BusObjectTest, SerializedMethodCalls) {
+    BusObjectTestBusObject testObj(bus, OBJECT_PATH);
+    EXPECT_FALSE(testObj.HasSerializedMethodCalls());
+    testObj.SetSerializedMethodCalls(true);
+    EXPECT_TRUE(testObj.HasSerializedMethodCalls());
+
+    status = bus.RegisterBusObject(testObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_TRUE(testObj.HasSerializedMethodCalls());
+    bus.UnregisterBusObject(testObj);
+}
+
+static const char* SERIALIZED_INTERFACE = "org.alljoyn.test.BusObjectTest.Serialized";
+
+/* Records the order of the calls it handles and whether two handlers ever ran at once */
+class SerializedCallsObject : public BusObject {
+  public:
+    SerializedCallsObject(const char* path, const InterfaceDescription& intf) : BusObject(path), active(0), overlapped(false)
+    {
+        AddInterface(intf);
+        const MethodEntry methodEntries[] = {
+            { intf.GetMember("call"), static_cast<MessageReceiver::MethodHandler>(&SerializedCallsObject::Call) }
+        };
+        AddMethodHandlers(methodEntries, ArraySize(methodEntries));
+    }
+
+    void Call(const InterfaceDescription::Member* member, Message& msg)
+    {
+        if (IncrementAndFetch(&active) > 1) {
+            overlapped = true;
+        }
+        uint32_t seq = 0;
+        msg->GetArgs("u", &seq);
+        lock.Lock(MUTEX_CONTEXT);
+        order.push_back(seq);
+        lock.Unlock(MUTEX_CONTEXT);
+        /* Give a concurrent handler (there should be none) time to start */
+        qcc::Sleep(2);
+        DecrementAndFetch(&active);
+        MethodReply(msg, msg->GetArg(0), 1);
+    }
+
+    volatile int32_t active;
+    volatile bool overlapped;
+    qcc::Mutex lock;
+    std::vector<uint32_t> order;
+};
+
+/* Several threads calling the same object, sequence numbers are assigned in the order the calls are sent */
+class SerializedCaller : public qcc::Thread, public MessageReceiver {
+  public:
+    SerializedCaller(ProxyBusObject& proxy, const InterfaceDescription::Member& call, qcc::Mutex& sendLock, uint32_t& nextSeq, volatile int32_t& replies) :
+        Thread("SerializedCaller"), proxy(proxy), call(call), sendLock(sendLock), nextSeq(nextSeq), replies(replies) { }
+
+    static const size_t CALLS = 25;
+
+    void ReplyHandler(Message& msg, void* context)
+    {
+        if (msg->GetType() == MESSAGE_METHOD_RET) {
+            IncrementAndFetch(&replies);
+        }
+    }
+
+  protected:
+    qcc::ThreadReturn STDCALL Run(void* arg)
+    {
+        for (size_t i = 0; i < CALLS; ++i) {
+            sendLock.Lock(MUTEX_CONTEXT);
+            MsgArg seq("u", nextSeq++);
+            QStatus status = proxy.MethodCallAsync(call, this, static_cast<MessageReceiver::ReplyHandler>(&SerializedCaller::ReplyHandler), &seq, 1);
+            sendLock.Unlock(MUTEX_CONTEXT);
+            EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            qcc::Sleep(i % 3);
+        }
+        return 0;
+    }
+
+  private:
+    ProxyBusObject& proxy;
+    const InterfaceDescription::Member& call;
+    qcc::Mutex& sendLock;
+    uint32_t& nextSeq;
+    volatile int32_t& replies;
+};
+
+TEST_F(BusObjectTest, SerializedMethodCallsConcurrentCallers) {
+    status = bus.Start();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = bus.Connect(ajn::getConnectArg().c_str());
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* intf = NULL;
+    status = bus.CreateInterface(SERIALIZED_INTERFACE, intf, false);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = intf->AddMember(MESSAGE_METHOD_CALL, "call", "u", "u", "in,out", 0);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    intf->Activate();
+
+    /* The dispatcher has more than one thread so unserialized handlers could overlap */
+    ASSERT_GT(bus.GetConcurrency(), 1U);
+    SerializedCallsObject testObj(OBJECT_PATH, *intf);
+    testObj.SetSerializedMethodCalls(true);
+    status = bus.RegisterBusObject(testObj);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    BusAttachment client("BusObjectTestClient", false);
+    status = client.Start();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = client.Connect(ajn::getConnectArg().c_str());
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    ProxyBusObject proxy(client, bus.GetUniqueName().c_str(), OBJECT_PATH, 0);
+    status = proxy.IntrospectRemoteObject();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    const InterfaceDescription::Member* call = proxy.GetInterface(SERIALIZED_INTERFACE)->GetMember("call");
+    ASSERT_TRUE(call != NULL);
+
+    static const size_t NUM_CALLERS = 4;
+    qcc::Mutex sendLock;
+    uint32_t nextSeq = 0;
+    volatile int32_t replies = 0;
+    std::vector<SerializedCaller*> callers;
+    for (size_t i = 0; i < NUM_CALLERS; ++i) {
+        callers.push_back(new SerializedCaller(proxy, *call, sendLock, nextSeq, replies));
+        EXPECT_EQ(ER_OK, callers.back()->Start());
+    }
+
+    const int32_t total = static_cast<int32_t>(NUM_CALLERS * SerializedCaller::CALLS);
+    for (int i = 0; (i < 1000) && (replies < total); ++i) {
+        qcc::Sleep(10);
+    }
+    for (size_t i = 0; i < NUM_CALLERS; ++i) {
+        callers[i]->Join();
+    }
+    EXPECT_EQ(total, replies);
+
+    /* Never two handlers at once and every call handled in the order it was sent */
+    EXPECT_FALSE(testObj.overlapped);
+    testObj.lock.Lock(MUTEX_CONTEXT);
+    ASSERT_EQ(static_cast<size_t>(total), testObj.order.size());
+    for (size_t i = 0; i < testObj.order.size(); ++i) {
+        EXPECT_EQ(i, testObj.order[i]) << "  Call " << i << " out of order";
+    }
+    testObj.lock.Unlock(MUTEX_CONTEXT);
+
+    client.Disconnect(ajn::getConnectArg().c_str());
+    client.Stop();
+    client.Join();
+    for (size_t i = 0; i < NUM_CALLERS; ++i) {
+        delete callers[i];
+    }
+    bus.UnregisterBusObject(testObj);
+}
+
+TEST_F(BusObjectTest, RegisterBusObjects) {
+    BusObjectTestBusObject leaf(bus, "/org/alljoyn/test/BusObjectTest/a/b");
+    BusObjectTestBusObject root(bus, OBJECT_PATH);
+    BusObjectTestBusObject child(bus, "/org/alljoyn/test/BusObjectTest/a");
+    BusObjectTestBusObject bad(bus, "/org/alljoyn/test//bad");
+
+    /* One bad path rejects the whole batch */
+    BusObject* withBad[] = { &leaf, &bad, &root };
+    status = bus.RegisterBusObjects(withBad, ArraySize(withBad));
+    EXPECT_EQ(ER_BUS_BAD_OBJ_PATH, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* Children may come before their parents */
+    BusObject* tree[] = { &leaf, &root, &child };
+    status = bus.RegisterBusObjects(tree, ArraySize(tree));
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    status = bus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = bus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    for (int i = 0; i < 500; ++i) {
+        if (leaf.wasRegistered && root.wasRegistered && child.wasRegistered) {
+            break;
+        }
+        qcc::Sleep(10);
+    }
+    EXPECT_TRUE(leaf.wasRegistered);
+    EXPECT_TRUE(root.wasRegistered);
+    EXPECT_TRUE(child.wasRegistered);
+    EXPECT_FALSE(bad.wasRegistered);
+
+    /* Unregistering the root takes its children with it */
+    bus.UnregisterBusObject(root);
+    EXPECT_TRUE(root.wasUnregistered);
+    EXPECT_TRUE(child.wasUnregistered);
+    EXPECT_TRUE(leaf.wasUnregistered);
+}
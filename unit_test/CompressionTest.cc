@@ -34,6 +34,7 @@
 #include <alljoyn/Status.h>
 
 /* Private files included for unit testing */
+#include <CompressionRules.h>
 #include <RemoteEndpoint.h>
 
 #include <gtest/gtest.h>
@@ -196,3 +197,64 @@ TEST(CompressionTest, Compression) {
         ASSERT_EQ(sig, msg2.GetMemberName()) << "FAILD 6." << 1;
     }
 }
+
+class EvictionListener : public CompressionRulesListener {
+  public:
+    std::vector<uint32_t> evicted;
+
+    void CompressionRuleEvicted(uint32_t token) { evicted.push_back(token); }
+};
+
+static void SetMember(HeaderFields& hdrFields, const char* member)
+{
+    hdrFields.field[ALLJOYN_HDR_FIELD_INTERFACE].Set("s", "foo.bar");
+    hdrFields.field[ALLJOYN_HDR_FIELD_MEMBER].Set("s", member);
+}
+
+TEST(CompressionTest, LRUEviction) {
+    _CompressionRules rules;
+    EvictionListener listener;
+    rules.SetListener(&listener);
+    rules.SetMaxRules(2);
+
+    HeaderFields hdr1;
+    HeaderFields hdr2;
+    HeaderFields hdr3;
+    SetMember(hdr1, "one");
+    SetMember(hdr2, "two");
+    SetMember(hdr3, "three");
+
+    uint32_t tok1 = rules.GetToken(hdr1);
+    uint32_t tok2 = rules.GetToken(hdr2);
+    ASSERT_NE(tok1, tok2);
+
+    /* Use tok1 so that tok2 is the least recently used rule */
+    ASSERT_EQ(tok1, rules.GetToken(hdr1));
+
+    uint32_t tok3 = rules.GetToken(hdr3);
+    ASSERT_EQ(1U, listener.evicted.size());
+    EXPECT_EQ(tok2, listener.evicted[0]);
+
+    HeaderFields expansion;
+    EXPECT_FALSE(rules.GetExpansion(tok2, expansion));
+    ASSERT_TRUE(rules.GetExpansion(tok1, expansion));
+    EXPECT_STREQ("one", expansion.field[ALLJOYN_HDR_FIELD_MEMBER].v_string.str);
+    ASSERT_TRUE(rules.GetExpansion(tok3, expansion));
+    EXPECT_STREQ("three", expansion.field[ALLJOYN_HDR_FIELD_MEMBER].v_string.str);
+
+    _CompressionRules::Stats stats;
+    rules.GetStats(stats);
+    EXPECT_EQ(2U, stats.numRules);
+    EXPECT_EQ(1U, stats.tokenHits);
+    EXPECT_EQ(3U, stats.tokenMisses);
+    EXPECT_EQ(2U, stats.expansionHits);
+    EXPECT_EQ(1U, stats.expansionMisses);
+    EXPECT_EQ(1U, stats.evictions);
+
+    /* Shrinking the table evicts the least recently used rule */
+    rules.SetMaxRules(1);
+    ASSERT_EQ(2U, listener.evicted.size());
+    EXPECT_EQ(tok1, listener.evicted[1]);
+
+    rules.SetListener(NULL);
+}
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+/* Private files included for unit testing */
+#include "CongestionController.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+/* A CUBIC controller on a clock the test advances */
+class SimulatedCubic : public CubicCongestionController {
+  public:
+    SimulatedCubic(uint16_t maxWindow) : CubicCongestionController(maxWindow), now(1000) { }
+
+    uint64_t now;
+
+  protected:
+    uint64_t Now() const { return now; }
+};
+
+TEST(CongestionControllerTest, from_string) {
+    EXPECT_EQ(CONGESTION_CONTROL_RENO, CongestionControlFromString("reno", CONGESTION_CONTROL_CUBIC));
+    EXPECT_EQ(CONGESTION_CONTROL_CUBIC, CongestionControlFromString("cubic", CONGESTION_CONTROL_RENO));
+    EXPECT_EQ(CONGESTION_CONTROL_CUBIC, CongestionControlFromString("", CONGESTION_CONTROL_CUBIC));
+    EXPECT_EQ(CONGESTION_CONTROL_RENO, CongestionControlFromString("vegas", CONGESTION_CONTROL_RENO));
+
+    CongestionController* cc = CongestionController::Create(CONGESTION_CONTROL_CUBIC, 32);
+    EXPECT_EQ(CONGESTION_CONTROL_CUBIC, cc->GetType());
+    delete cc;
+    cc = CongestionController::Create(CONGESTION_CONTROL_RENO, 32);
+    EXPECT_EQ(CONGESTION_CONTROL_RENO, cc->GetType());
+    delete cc;
+}
+
+TEST(CongestionControllerTest, reno_slow_start) {
+    RenoCongestionController reno(64);
+    EXPECT_EQ(1, reno.GetWindow());
+    EXPECT_EQ(64, reno.GetSlowStartThresh());
+
+    /* Acking a whole window doubles it */
+    for (uint16_t expect = 2; expect <= 64; expect *= 2) {
+        reno.OnAck(reno.GetWindow(), 10);
+        EXPECT_EQ(expect, reno.GetWindow());
+        EXPECT_FALSE(reno.IsPastSlowStart());
+    }
+
+    /* Never beyond the channel window */
+    reno.OnAck(1000, 10);
+    EXPECT_EQ(64, reno.GetWindow());
+}
+
+TEST(CongestionControllerTest, reno_loss_backoff) {
+    RenoCongestionController reno(64);
+    reno.OnAck(63, 10);
+    ASSERT_EQ(64, reno.GetWindow());
+
+    /* Every retransmit halves the window */
+    reno.OnRetransmit();
+    EXPECT_EQ(32, reno.GetWindow());
+    EXPECT_EQ(32, reno.GetSlowStartThresh());
+    reno.OnRetransmit();
+    EXPECT_EQ(16, reno.GetWindow());
+    EXPECT_EQ(16, reno.GetSlowStartThresh());
+
+    /* At the threshold the window grows by one per window of acks */
+    reno.OnAck(16, 10);
+    EXPECT_EQ(16, reno.GetWindow());
+    reno.OnAck(1, 10);
+    EXPECT_EQ(17, reno.GetWindow());
+    EXPECT_TRUE(reno.IsPastSlowStart());
+
+    /* The threshold does not drop below 2 and the window not below 1 */
+    for (int i = 0; i < 10; ++i) {
+        reno.OnRetransmit();
+    }
+    EXPECT_EQ(1, reno.GetWindow());
+    EXPECT_EQ(2, reno.GetSlowStartThresh());
+}
+
+TEST(CongestionControllerTest, cubic_slow_start) {
+    SimulatedCubic cubic(128);
+    EXPECT_EQ(1, cubic.GetWindow());
+    for (uint16_t expect = 2; expect <= 128; expect *= 2) {
+        cubic.now += 50;
+        cubic.OnAck(cubic.GetWindow(), 50);
+        EXPECT_EQ(expect, cubic.GetWindow());
+    }
+    cubic.OnAck(1000, 50);
+    EXPECT_EQ(128, cubic.GetWindow());
+}
+
+TEST(CongestionControllerTest, cubic_loss_backoff) {
+    SimulatedCubic cubic(100);
+    cubic.OnAck(99, 50);
+    ASSERT_EQ(100, cubic.GetWindow());
+
+    /* A loss takes the window to beta * window */
+    cubic.now += 50;
+    cubic.OnRetransmit();
+    EXPECT_EQ(70, cubic.GetWindow());
+    EXPECT_EQ(70, cubic.GetSlowStartThresh());
+
+    /* More losses within the same round trip belong to the same congestion event */
+    cubic.now += 20;
+    cubic.OnRetransmit();
+    cubic.now += 20;
+    cubic.OnRetransmit();
+    EXPECT_EQ(70, cubic.GetWindow());
+
+    /* A loss a round trip later reduces again */
+    cubic.now += 20;
+    cubic.OnRetransmit();
+    EXPECT_EQ(49, cubic.GetWindow());
+    EXPECT_EQ(49, cubic.GetSlowStartThresh());
+}
+
+TEST(CongestionControllerTest, cubic_growth) {
+    /* A long round trip so the cubic function, not the Reno estimate, drives the growth */
+    static const uint32_t RTT = 500;
+    SimulatedCubic cubic(200);
+    cubic.OnAck(99, RTT);
+    ASSERT_EQ(100, cubic.GetWindow());
+    cubic.now += RTT;
+    cubic.OnRetransmit();
+    ASSERT_EQ(70, cubic.GetWindow());
+
+    /* K = cbrt((wMax - beta * wMax) / C) = cbrt(30 / 0.4), a little over 4.2 seconds */
+    const uint64_t lossTime = cubic.now;
+    uint16_t last = cubic.GetWindow();
+    uint16_t firstStep = 0;
+    uint16_t nearK = 0;
+    uint16_t after = 0;
+    while (cubic.now - lossTime < 8000) {
+        cubic.now += RTT;
+        cubic.OnAck(cubic.GetWindow(), RTT);
+        uint16_t w = cubic.GetWindow();
+        uint64_t elapsed = cubic.now - lossTime;
+
+        /* The window never shrinks without a loss and never exceeds the channel window */
+        EXPECT_GE(w, last);
+        EXPECT_LE(w, 200);
+        if (firstStep == 0) {
+            firstStep = w - last;
+        }
+
+        /* Concave region: it approaches but does not pass the window at the loss before K */
+        if (elapsed + RTT < 4200) {
+            EXPECT_LT(w, 100) << "  at " << elapsed << "ms";
+        }
+        if (elapsed == 4000) {
+            nearK = w;
+        }
+        if (elapsed == 8000) {
+            after = w;
+        }
+        last = w;
+    }
+
+    /* Growth is fast just after the loss and flattens out near the old maximum */
+    EXPECT_GE(firstStep, 5);
+    EXPECT_GE(nearK, 95);
+    EXPECT_LE(nearK, 100);
+
+    /* Convex region: past K it probes beyond the old maximum */
+    EXPECT_GT(after, 105);
+}
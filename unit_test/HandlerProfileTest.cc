@@ -0,0 +1,86 @@
+/**
+ * @file
+ *
+ * This file tests the method and signal handler profile
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/InterfaceDescription.h>
+
+#include "HandlerProfile.h"
+#include "LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(HandlerProfileTest, records_per_member) {
+    BusAttachment bus("HandlerProfileTest", false);
+    InterfaceDescription* intf = NULL;
+    ASSERT_EQ(ER_OK, bus.CreateInterface("org.alljoyn.test.HandlerProfile", intf));
+    ASSERT_EQ(ER_OK, intf->AddMethod("Slow", "s", "s", "in,out", 0));
+    ASSERT_EQ(ER_OK, intf->AddSignal("Tick", "u", "count", 0));
+    intf->Activate();
+    const InterfaceDescription::Member* slow = intf->GetMember("Slow");
+    const InterfaceDescription::Member* tick = intf->GetMember("Tick");
+    ASSERT_TRUE(slow != NULL);
+    ASSERT_TRUE(tick != NULL);
+
+    HandlerProfile profile;
+    EXPECT_FALSE(profile.IsEnabled());
+    profile.Enable(true);
+    EXPECT_TRUE(profile.IsEnabled());
+
+    uint64_t now = GetLatencyClock();
+    profile.Record(slow, now - 3000, now - 2000, now);
+    profile.Record(slow, now - 1000, now - 1000, now);
+    /* A signal delivered without queueing has no queueing delay */
+    profile.Record(tick, 0, now - 10, now);
+
+    std::vector<HandlerProfile::Stats> stats;
+    profile.Get(stats);
+    ASSERT_EQ(2U, stats.size());
+    EXPECT_STREQ("Slow", stats[0].member.c_str());
+    EXPECT_STREQ("org.alljoyn.test.HandlerProfile", stats[0].iface.c_str());
+    EXPECT_FALSE(stats[0].isSignal);
+    EXPECT_EQ(2U, stats[0].calls);
+    EXPECT_EQ(static_cast<uint64_t>(3000), stats[0].handlerUsecs);
+    EXPECT_EQ(2000U, stats[0].handlerMax);
+    EXPECT_EQ(1000U, stats[0].queueMax);
+
+    EXPECT_STREQ("Tick", stats[1].member.c_str());
+    EXPECT_TRUE(stats[1].isSignal);
+    EXPECT_EQ(1U, stats[1].calls);
+    EXPECT_EQ(0U, stats[1].queueMax);
+
+    /* The member with the most handler time comes first */
+    qcc::String str = profile.ToString();
+    EXPECT_EQ(0U, str.find("org.alljoyn.test.HandlerProfile.Slow:"));
+    EXPECT_NE(qcc::String::npos, str.find("Tick (signal): calls=1"));
+
+    profile.Reset();
+    profile.Get(stats);
+    EXPECT_TRUE(stats.empty());
+}
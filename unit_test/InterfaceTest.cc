@@ -525,3 +525,50 @@ TEST_F(InterfaceTest, ArgNamesTest) {
     EXPECT_TRUE(member != NULL);
     EXPECT_STREQ(",arg1", member->argNames.c_str());
 }
+
+static const InterfaceDescription::StaticMember staticMembers[] = {
+    { MESSAGE_METHOD_CALL, "Ping",  "s", "s",  "in,out", 0, NULL },
+    { MESSAGE_SIGNAL,      "Chirp", "s", NULL, "msg",    0, NULL }
+};
+
+static const InterfaceDescription::StaticProperty staticProperties[] = {
+    { "Level", "u", PROP_ACCESS_RW }
+};
+
+static const InterfaceDescription::StaticInterface staticIntf = {
+    "org.alljoyn.staticTest", false,
+    staticMembers, sizeof(staticMembers) / sizeof(staticMembers[0]),
+    staticProperties, sizeof(staticProperties) / sizeof(staticProperties[0])
+};
+
+TEST_F(InterfaceTest, StaticInterfaceIsShared) {
+    const InterfaceDescription* iface = NULL;
+    QStatus status = g_msgBus->CreateInterface(staticIntf, iface);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(iface != NULL);
+    EXPECT_EQ(iface, g_msgBus->GetInterface("org.alljoyn.staticTest"));
+
+    const InterfaceDescription::Member* member = iface->GetMember("Chirp");
+    ASSERT_TRUE(member != NULL);
+    EXPECT_EQ(MESSAGE_SIGNAL, member->memberType);
+    EXPECT_STREQ("msg", member->argNames.c_str());
+    EXPECT_TRUE(iface->HasProperty("Level"));
+
+    /* The interface is already activated and cannot be added twice or replaced */
+    const InterfaceDescription* again = NULL;
+    status = g_msgBus->CreateInterface(staticIntf, again);
+    EXPECT_EQ(ER_BUS_IFACE_ALREADY_EXISTS, status) << "  Actual Status: " << QCC_StatusText(status);
+    InterfaceDescription* dynamic = NULL;
+    status = g_msgBus->CreateInterface("org.alljoyn.staticTest", dynamic);
+    EXPECT_EQ(ER_BUS_IFACE_ALREADY_EXISTS, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* A second bus attachment shares the same description */
+    BusAttachment otherBus("staticTest", false);
+    const InterfaceDescription* otherIface = NULL;
+    status = otherBus.CreateInterface(staticIntf, otherIface);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(iface, otherIface);
+
+    /* The standard interfaces are shared too */
+    EXPECT_EQ(g_msgBus->GetInterface(org::freedesktop::DBus::InterfaceName), otherBus.GetInterface(org::freedesktop::DBus::InterfaceName));
+}
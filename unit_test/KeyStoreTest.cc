@@ -27,6 +27,7 @@
 
 #include <qcc/Crypto.h>
 #include <qcc/Debug.h>
+#include <qcc/Environ.h>
 #include <qcc/FileStream.h>
 #include <qcc/KeyBlob.h>
 #include <qcc/Pipe.h>
@@ -229,3 +230,49 @@ TEST(KeyStoreTest, keystore_store_load_merge) {
     DeleteFile("keystore_test");
 }
 
+
+TEST(KeyStoreTest, shared_map_changes_seen_without_store) {
+    qcc::GUID128 guid1;
+    qcc::GUID128 guid2;
+    KeyBlob key;
+    QStatus status;
+
+    Environ::GetAppEnviron()->Add("ALLJOYN_KEYSTORE_SHARED_MAP", "1");
+    {
+        KeyStore keyStore1("keystore_shm_test");
+        keyStore1.Init(NULL, true);
+        keyStore1.Clear();
+
+        KeyStore keyStore2("keystore_shm_test");
+        keyStore2.Init(NULL, true);
+        EXPECT_FALSE(keyStore2.HasKey(guid1));
+
+        /* An added key is visible to the other key store before either one stores */
+        key.Rand(Crypto_AES::AES128_SIZE, KeyBlob::AES);
+        keyStore1.AddKey(guid1, key);
+        KeyBlob got;
+        status = keyStore2.GetKey(guid1, got);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status) << " guid1 not shared";
+        EXPECT_EQ(key.GetSize(), got.GetSize());
+        EXPECT_EQ(0, memcmp(key.GetData(), got.GetData(), key.GetSize()));
+
+        /* Changes flow both ways, and so do deletions */
+        key.Rand(620, KeyBlob::GENERIC);
+        keyStore2.AddKey(guid2, key);
+        EXPECT_TRUE(keyStore1.HasKey(guid2));
+        keyStore1.DelKey(guid1);
+        EXPECT_FALSE(keyStore2.HasKey(guid1));
+
+        status = keyStore2.Store();
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status) << " Failed to store keystore";
+    }
+    /* The file holds the merged keys */
+    {
+        KeyStore keyStore("keystore_shm_test");
+        keyStore.Init(NULL, true);
+        EXPECT_FALSE(keyStore.HasKey(guid1));
+        EXPECT_TRUE(keyStore.HasKey(guid2));
+        keyStore.Clear();
+    }
+    Environ::GetAppEnviron()->Add("ALLJOYN_KEYSTORE_SHARED_MAP", "0");
+}
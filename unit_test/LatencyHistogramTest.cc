@@ -0,0 +1,92 @@
+/**
+ * @file
+ *
+ * This file tests the latency histograms used for message routing statistics
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include "LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(LatencyHistogramTest, percentiles_within_bucket_resolution) {
+    LatencyHistogram h;
+    EXPECT_EQ(0U, h.GetCount());
+    EXPECT_EQ(0U, h.GetPercentile(500));
+
+    for (uint32_t v = 1; v <= 1000; ++v) {
+        h.Record(v);
+    }
+    EXPECT_EQ(1000U, h.GetCount());
+    EXPECT_EQ(1000U, h.GetMax());
+
+    /* Percentiles are bucket upper bounds so never low and at most 1/8 high */
+    uint32_t p50 = h.GetPercentile(500);
+    EXPECT_GE(p50, 500U);
+    EXPECT_LE(p50, 500U + 500U / LatencyHistogram::SUB_BUCKETS);
+    uint32_t p90 = h.GetPercentile(900);
+    EXPECT_GE(p90, 900U);
+    EXPECT_LE(p90, 900U + 900U / LatencyHistogram::SUB_BUCKETS);
+
+    /* Never more than the largest value recorded */
+    EXPECT_EQ(1000U, h.GetPercentile(990));
+    EXPECT_EQ(1000U, h.GetPercentile(1000));
+
+    h.Reset();
+    EXPECT_EQ(0U, h.GetCount());
+    EXPECT_EQ(0U, h.GetMax());
+}
+
+TEST(LatencyHistogramTest, small_and_extreme_values) {
+    LatencyHistogram h;
+
+    /* Values below SUB_BUCKETS are counted exactly */
+    h.Record(0);
+    h.Record(3);
+    h.Record(3);
+    h.Record(7);
+    EXPECT_EQ(0U, h.GetPercentile(250));
+    EXPECT_EQ(3U, h.GetPercentile(500));
+    EXPECT_EQ(7U, h.GetPercentile(1000));
+
+    h.Record(0xFFFFFFFF);
+    EXPECT_EQ(0xFFFFFFFFU, h.GetMax());
+    EXPECT_EQ(0xFFFFFFFFU, h.GetPercentile(1000));
+}
+
+TEST(LatencyHistogramTest, stats_ignore_unrecorded_start) {
+    LatencyStats::Reset();
+    LatencyStats::Record(LatencyStats::STAGE_QUEUE, true, 0, 500);
+    EXPECT_EQ(0U, LatencyStats::Get(LatencyStats::STAGE_QUEUE, LatencyStats::ENDPOINT_BUS2BUS).GetCount());
+
+    LatencyStats::Record(LatencyStats::STAGE_QUEUE, true, 100, 150);
+    LatencyStats::Record(LatencyStats::STAGE_QUEUE, false, 100, 90);
+    EXPECT_EQ(1U, LatencyStats::Get(LatencyStats::STAGE_QUEUE, LatencyStats::ENDPOINT_BUS2BUS).GetCount());
+    EXPECT_EQ(50U, LatencyStats::Get(LatencyStats::STAGE_QUEUE, LatencyStats::ENDPOINT_BUS2BUS).GetMax());
+    EXPECT_EQ(0U, LatencyStats::Get(LatencyStats::STAGE_QUEUE, LatencyStats::ENDPOINT_CLIENT).GetMax());
+    EXPECT_EQ(0U, LatencyStats::Get(LatencyStats::STAGE_ROUTE, LatencyStats::ENDPOINT_BUS2BUS).GetCount());
+
+    uint64_t t0 = GetLatencyClock();
+    EXPECT_NE(0U, t0);
+    EXPECT_GE(GetLatencyClock(), t0);
+    LatencyStats::Reset();
+}
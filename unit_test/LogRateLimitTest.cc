@@ -0,0 +1,67 @@
+/**
+ * @file
+ *
+ * This file tests the rate limiting of error log sites
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/Thread.h>
+
+#include "LogRateLimit.h"
+
+#include <gtest/gtest.h>
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace ajn;
+
+TEST(LogRateLimitTest, suppresses_and_counts) {
+    LogRateLimit limit = LogRateLimit();
+    uint32_t suppressed = 1;
+    for (int32_t i = 0; i < LogRateLimit::MAX_PER_PERIOD; ++i) {
+        EXPECT_TRUE(limit.Allow(suppressed));
+        EXPECT_EQ(0U, suppressed);
+    }
+    for (int i = 0; i < 25; ++i) {
+        EXPECT_FALSE(limit.Allow(suppressed));
+    }
+    /* The first message of the next period reports what was suppressed */
+    qcc::Sleep(LogRateLimit::PERIOD_MS + 50);
+    EXPECT_TRUE(limit.Allow(suppressed));
+    EXPECT_EQ(25U, suppressed);
+    EXPECT_TRUE(limit.Allow(suppressed));
+    EXPECT_EQ(0U, suppressed);
+}
+
+static uint32_t formatted = 0;
+
+static const char* Format()
+{
+    ++formatted;
+    return "expensive";
+}
+
+TEST(LogRateLimitTest, arguments_evaluated_only_when_logged) {
+    formatted = 0;
+    for (int i = 0; i < 100; ++i) {
+        QCC_LogErrorRateLimited(ER_BUS_NO_ROUTE, ("Discarding %s", Format()));
+    }
+    EXPECT_EQ(static_cast<uint32_t>(LogRateLimit::MAX_PER_PERIOD), formatted);
+}
@@ -297,6 +297,96 @@ TEST(MarshalTest, TestMsgUnpack) {
     delete bus;
 }
 
+TEST(MarshalTest, BackToBackMessages) {
+    QStatus status = ER_OK;
+
+    BusAttachment*bus = new BusAttachment("BackToBackMessages", false);
+    bus->Start();
+
+    TestPipe stream;
+    TestPipe* pStream = &stream;
+    static const bool falsiness = false;
+    RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+
+    /* Several messages queued in the stream are parsed out of the endpoint's read-ahead buffer */
+    for (uint32_t n = 0; n < 3; ++n) {
+        MyMessage msg(*bus);
+        MsgArg arg("u", n);
+        status = msg.Signal("a.b.c", "/foo/bar", "foo.bar", "test", &arg, 1);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        status = msg.Deliver(ep);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+
+    for (uint32_t n = 0; n < 3; ++n) {
+        MyMessage msg(*bus);
+        status = msg.Read(ep, ":88.88");
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        status = msg.Unmarshal(ep, ":88.88");
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        status = msg.UnmarshalBody();
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+        uint32_t val;
+        status = msg.GetArgs("u", &val);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        EXPECT_EQ(n, val);
+    }
+    delete bus;
+}
+
+TEST(MarshalTest, FixedStructArray) {
+    QStatus status = ER_OK;
+
+    BusAttachment*bus = new BusAttachment("FixedStructArray", false);
+    bus->Start();
+
+    TestPipe stream;
+    TestPipe* pStream = &stream;
+    static const bool falsiness = false;
+    RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+
+    /* Arrays of structs with only fixed size members are unmarshaled in a single pass */
+    const size_t numSamples = 100;
+    MsgArg* samples = new MsgArg[numSamples];
+    for (size_t k = 0; k < numSamples; ++k) {
+        samples[k].Set("(tdyd)", (uint64_t)k, k * 0.5, (uint8_t)k, -(double)k);
+    }
+    MyMessage msg(*bus);
+    MsgArg arg("a(tdyd)", numSamples, samples);
+    status = msg.Signal("a.b.c", "/foo/bar", "foo.bar", "test", &arg, 1);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = msg.Deliver(ep);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    MyMessage rx(*bus);
+    status = rx.Read(ep, ":88.88");
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = rx.Unmarshal(ep, ":88.88");
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = rx.UnmarshalBody();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    size_t num;
+    MsgArg* elems;
+    status = rx.GetArgs("a(tdyd)", &num, &elems);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_EQ(numSamples, num);
+    for (size_t k = 0; k < num; ++k) {
+        uint64_t t;
+        double d1, d2;
+        uint8_t y;
+        status = elems[k].Get("(tdyd)", &t, &d1, &y, &d2);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        EXPECT_EQ((uint64_t)k, t);
+        EXPECT_EQ(k * 0.5, d1);
+        EXPECT_EQ((uint8_t)k, y);
+        EXPECT_EQ(-(double)k, d2);
+    }
+    delete [] samples;
+    delete bus;
+}
+
 /*--------------------------FUZZING TEST CODE---------------------------------*/
 static bool fuzzing = false;
 static bool nobig = false;
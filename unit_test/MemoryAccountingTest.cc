@@ -0,0 +1,62 @@
+/**
+ * @file
+ *
+ * This file tests the per-subsystem memory accounting
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include "MemoryAccounting.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(MemoryAccountingTest, disabled_by_default) {
+    MemoryAccounting::Usage before, after;
+    EXPECT_FALSE(MemoryAccounting::IsEnabled());
+    MemoryAccounting::Get(MemoryAccounting::MEM_NAME_TABLE, before);
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_NAME_TABLE, 100);
+    MemoryAccounting::Get(MemoryAccounting::MEM_NAME_TABLE, after);
+    EXPECT_EQ(before.bytes, after.bytes);
+    EXPECT_EQ(before.objects, after.objects);
+}
+
+TEST(MemoryAccountingTest, tracks_bytes_objects_and_peak) {
+    MemoryAccounting::Usage base, u;
+    MemoryAccounting::Enable(true);
+    MemoryAccounting::Get(MemoryAccounting::MEM_TX_QUEUES, base);
+
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_TX_QUEUES, 1000);
+    MemoryAccounting::Allocated(MemoryAccounting::MEM_TX_QUEUES, 500);
+    MemoryAccounting::Released(MemoryAccounting::MEM_TX_QUEUES, 1000);
+    MemoryAccounting::Get(MemoryAccounting::MEM_TX_QUEUES, u);
+    EXPECT_EQ(base.bytes + 500, u.bytes);
+    EXPECT_EQ(base.objects + 1, u.objects);
+    EXPECT_GE(u.peakBytes, base.bytes + 1500);
+
+    /* Other subsystems are unaffected */
+    MemoryAccounting::Usage other;
+    MemoryAccounting::Get(MemoryAccounting::MEM_PACKETS, other);
+    EXPECT_EQ(0, other.bytes);
+
+    MemoryAccounting::Released(MemoryAccounting::MEM_TX_QUEUES, 500);
+    MemoryAccounting::Enable(false);
+    EXPECT_NE(qcc::String::npos, MemoryAccounting::ToString().find("tx_queues: bytes="));
+}
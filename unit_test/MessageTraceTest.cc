@@ -0,0 +1,74 @@
+/**
+ * @file
+ *
+ * This file tests the binary message trace ring
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include "MessageTrace.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(MessageTraceTest, records_in_order) {
+    std::vector<MessageTrace::Event> events;
+    MessageTrace::Clear();
+    MessageTrace::Record(MessageTrace::TRACE_RX, 1, 10, ":a.1", "org.test", MessageTrace::NameHash(":a.1"));
+    MessageTrace::Record(MessageTrace::TRACE_TX, 4, 11, ":a.1", NULL, MessageTrace::NameHash(":b.2"));
+    MessageTrace::Snapshot(events);
+
+    ASSERT_EQ(2U, events.size());
+    EXPECT_EQ(10U, events[0].serial);
+    EXPECT_EQ(MessageTrace::TRACE_RX, events[0].stage);
+    EXPECT_EQ(1U, events[0].type);
+    EXPECT_EQ(MessageTrace::NameHash(":a.1"), events[0].sender);
+    EXPECT_EQ(MessageTrace::NameHash("org.test"), events[0].destination);
+    EXPECT_EQ(11U, events[1].serial);
+    EXPECT_EQ(0U, events[1].destination);
+    EXPECT_EQ(MessageTrace::NameHash(":b.2"), events[1].endpoint);
+    EXPECT_LE(events[0].timestamp, events[1].timestamp);
+
+    /* Nothing is recorded while disabled */
+    MessageTrace::Enable(false);
+    MessageTrace::Record(MessageTrace::TRACE_RX, 1, 12, NULL, NULL, 0);
+    MessageTrace::Enable(true);
+    MessageTrace::Snapshot(events);
+    EXPECT_EQ(2U, events.size());
+}
+
+TEST(MessageTraceTest, keeps_newest_when_full) {
+    const uint32_t ringSize = MessageTrace::RING_SIZE;
+    std::vector<MessageTrace::Event> events;
+    MessageTrace::Clear();
+    for (uint32_t serial = 1; serial <= ringSize + 100; ++serial) {
+        MessageTrace::Record(MessageTrace::TRACE_QUEUED, 4, serial, NULL, NULL, 0);
+    }
+    MessageTrace::Snapshot(events);
+    ASSERT_EQ(ringSize, events.size());
+    EXPECT_EQ(101U, events.front().serial);
+    EXPECT_EQ(ringSize + 100, events.back().serial);
+
+    MessageTrace::Clear();
+    MessageTrace::Snapshot(events);
+    EXPECT_TRUE(events.empty());
+}
@@ -0,0 +1,119 @@
+/**
+ * @file
+ *
+ * This file tests the size-classed message buffer pool
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include "MsgBufPool.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(MsgBufPoolTest, class_sizes) {
+    for (size_t sc = 1; sc < MsgBufPool::NUM_SIZE_CLASSES; ++sc) {
+        EXPECT_LT(MsgBufPool::GetClassSize(sc - 1), MsgBufPool::GetClassSize(sc));
+    }
+    EXPECT_EQ(0U, MsgBufPool::GetClassSize(MsgBufPool::NUM_SIZE_CLASSES));
+}
+
+TEST(MsgBufPoolTest, buffers_are_recycled) {
+    MsgBufPool::Stats stats[MsgBufPool::NUM_SIZE_CLASSES + 1];
+
+    /* Prime the pool with a buffer from the smallest size class */
+    MsgBufPool::Free(MsgBufPool::Alloc(100));
+    MsgBufPool::ResetStats();
+
+    for (size_t i = 0; i < 100; ++i) {
+        uint8_t* buf = MsgBufPool::Alloc(100);
+        ASSERT_TRUE(buf != NULL);
+        memset(buf, 0xA5, MsgBufPool::GetClassSize(0));
+        MsgBufPool::Free(buf);
+    }
+
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(100U, stats[0].allocs);
+    EXPECT_EQ(100U, stats[0].frees);
+    EXPECT_EQ(100U, stats[0].threadHits + stats[0].poolHits);
+    EXPECT_EQ(0U, stats[0].heapAllocs);
+    EXPECT_EQ(0U, stats[0].heapFrees);
+}
+
+TEST(MsgBufPoolTest, oversize_buffers) {
+    MsgBufPool::Stats stats[MsgBufPool::NUM_SIZE_CLASSES + 1];
+    size_t largest = MsgBufPool::GetClassSize(MsgBufPool::NUM_SIZE_CLASSES - 1);
+
+    MsgBufPool::ResetStats();
+    uint8_t* buf = MsgBufPool::Alloc(largest + 1);
+    ASSERT_TRUE(buf != NULL);
+    memset(buf, 0, largest + 1);
+    MsgBufPool::Free(buf);
+
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(1U, stats[MsgBufPool::NUM_SIZE_CLASSES].allocs);
+    EXPECT_EQ(1U, stats[MsgBufPool::NUM_SIZE_CLASSES].heapAllocs);
+    EXPECT_EQ(1U, stats[MsgBufPool::NUM_SIZE_CLASSES].heapFrees);
+}
+
+TEST(MsgBufPoolTest, free_null) {
+    MsgBufPool::Free(NULL);
+}
+
+TEST(MsgBufPoolTest, shared_buffers) {
+    MsgBufPool::Stats stats[MsgBufPool::NUM_SIZE_CLASSES + 1];
+
+    MsgBufPool::ResetStats();
+    uint8_t* buf = MsgBufPool::Alloc(100);
+    EXPECT_FALSE(MsgBufPool::IsShared(buf));
+    MsgBufPool::AddRef(buf);
+    EXPECT_TRUE(MsgBufPool::IsShared(buf));
+
+    /* Releasing one reference does not free the buffer */
+    MsgBufPool::Free(buf);
+    EXPECT_FALSE(MsgBufPool::IsShared(buf));
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(0U, stats[0].frees);
+
+    MsgBufPool::Free(buf);
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(1U, stats[0].frees);
+}
+
+TEST(MsgBufPoolTest, retained_buffers) {
+    MsgBufPool::Stats stats[MsgBufPool::NUM_SIZE_CLASSES + 1];
+
+    MsgBufPool::ResetStats();
+    uint8_t* orig = MsgBufPool::Alloc(100);
+    uint8_t* copy1 = MsgBufPool::Alloc(100);
+    uint8_t* copy2 = MsgBufPool::Alloc(100);
+
+    /* Each copy keeps the buffer it was copied from alive */
+    MsgBufPool::Retain(copy1, orig);
+    MsgBufPool::Retain(copy2, copy1);
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(0U, stats[0].frees);
+
+    MsgBufPool::Free(copy2);
+    MsgBufPool::GetStats(stats);
+    EXPECT_EQ(3U, stats[0].frees);
+}
@@ -282,3 +282,26 @@ TEST(NamesTest, name_list) {
     EXPECT_FALSE(IsLegalErrorName(str));
     EXPECT_FALSE(IsLegalMemberName(str));
 }
+
+TEST(NamesTest, UTF8) {
+    EXPECT_TRUE(IsLegalUTF8("", 0));
+    EXPECT_TRUE(IsLegalUTF8("plain ascii text that is longer than a word", 43));
+    EXPECT_TRUE(IsLegalUTF8("h\xc3\xa9llo", 6));
+    EXPECT_TRUE(IsLegalUTF8("\xe2\x82\xac euro", 8));
+    EXPECT_TRUE(IsLegalUTF8("\xf0\x9f\x98\x80 and some more ascii", 24));
+    EXPECT_TRUE(IsLegalUTF8("\xed\x9f\xbf", 3));
+
+    /* Overlong encodings */
+    EXPECT_FALSE(IsLegalUTF8("\xc0\x80", 2));
+    EXPECT_FALSE(IsLegalUTF8("\xe0\x80\x80", 3));
+    /* Surrogates and code points beyond U+10FFFF */
+    EXPECT_FALSE(IsLegalUTF8("\xed\xa0\x80", 3));
+    EXPECT_FALSE(IsLegalUTF8("\xf4\x90\x80\x80", 4));
+    /* Truncated and stray bytes */
+    EXPECT_FALSE(IsLegalUTF8("\xc3", 1));
+    EXPECT_FALSE(IsLegalUTF8("\x80", 1));
+    EXPECT_FALSE(IsLegalUTF8("abcdefgh\xff", 9));
+    /* Embedded nul, both inside and after a run of ASCII words */
+    EXPECT_FALSE(IsLegalUTF8("abc\0", 4));
+    EXPECT_FALSE(IsLegalUTF8("abcdefghij\0klmnopqrstu", 22));
+}
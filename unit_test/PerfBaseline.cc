@@ -0,0 +1,164 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include "PerfBaseline.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#include <qcc/Environ.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+using namespace std;
+using namespace qcc;
+
+namespace ajn {
+
+struct BuiltInBaseline {
+    const char* platform;
+    const char* metric;
+    double value;
+};
+
+/*
+ * Ceilings (floors for rates) that a debug build on a busy build machine is expected to stay
+ * well within. Record real baselines with AJ_PERF_RECORD to gate on smaller regressions.
+ */
+static const BuiltInBaseline builtInBaselines[] = {
+    { "linux",   "local_method_rtt_us",     5000 },
+    { "linux",   "signal_rate_per_s",       1000 },
+    { "linux",   "marshal_ns_per_op",       50000 },
+    { "linux",   "auth_handshake_ms",       2000 },
+    { "linux",   "daemon_bytes_per_client", 262144 },
+    { "android", "local_method_rtt_us",     20000 },
+    { "android", "signal_rate_per_s",       200 },
+    { "android", "marshal_ns_per_op",       200000 },
+    { "android", "auth_handshake_ms",       10000 },
+    { "android", "daemon_bytes_per_client", 262144 },
+    { "darwin",  "local_method_rtt_us",     5000 },
+    { "darwin",  "signal_rate_per_s",       1000 },
+    { "darwin",  "marshal_ns_per_op",       50000 },
+    { "darwin",  "auth_handshake_ms",       2000 },
+    { "darwin",  "daemon_bytes_per_client", 262144 },
+    { "windows", "local_method_rtt_us",     10000 },
+    { "windows", "signal_rate_per_s",       500 },
+    { "windows", "marshal_ns_per_op",       50000 },
+    { "windows", "auth_handshake_ms",       4000 },
+    { "windows", "daemon_bytes_per_client", 262144 }
+};
+
+PerfBaseline::PerfBaseline() : tolerance(0.25)
+{
+}
+
+const char* PerfBaseline::GetPlatform()
+{
+#if defined(QCC_OS_ANDROID)
+    return "android";
+#elif defined(QCC_OS_LINUX)
+    return "linux";
+#elif defined(QCC_OS_DARWIN)
+    return "darwin";
+#elif defined(QCC_OS_GROUP_WINRT)
+    return "winrt";
+#elif defined(QCC_OS_GROUP_WINDOWS)
+    return "windows";
+#else
+    return "unknown";
+#endif
+}
+
+PerfBaseline& PerfBaseline::GetPerfBaseline()
+{
+    static PerfBaseline* perfBaseline = NULL;
+    if (!perfBaseline) {
+        perfBaseline = new PerfBaseline();
+        const char* platform = GetPlatform();
+        for (size_t i = 0; i < ArraySize(builtInBaselines); ++i) {
+            if (strcmp(builtInBaselines[i].platform, platform) == 0) {
+                perfBaseline->SetBaseline(builtInBaselines[i].metric, builtInBaselines[i].value);
+            }
+        }
+        Environ* env = Environ::GetAppEnviron();
+        qcc::String file = env->Find("AJ_PERF_BASELINE");
+        if (!file.empty()) {
+            perfBaseline->Load(file);
+        }
+        qcc::String percent = env->Find("AJ_PERF_TOLERANCE");
+        if (!percent.empty()) {
+            perfBaseline->SetTolerance(StringToU32(percent, 10, 25));
+        }
+        perfBaseline->recordFile = env->Find("AJ_PERF_RECORD");
+    }
+    return *perfBaseline;
+}
+
+void PerfBaseline::Load(const qcc::String& fileName)
+{
+    FILE* f = fopen(fileName.c_str(), "r");
+    if (!f) {
+        printf("Cannot read performance baselines from %s, using the built-in baselines\n", fileName.c_str());
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char metric[128];
+        double value;
+        if ((line[0] != '#') && (sscanf(line, "%127s %lf", metric, &value) == 2)) {
+            SetBaseline(metric, value);
+        }
+    }
+    fclose(f);
+}
+
+::testing::AssertionResult PerfBaseline::Check(const char* metric, double value, Direction direction)
+{
+    printf("%s %s = %.1f\n", GetPlatform(), metric, value);
+    if (!recordFile.empty()) {
+        FILE* f = fopen(recordFile.c_str(), "a");
+        if (f) {
+            fprintf(f, "%s %.1f\n", metric, value);
+            fclose(f);
+        }
+    }
+
+    std::map<qcc::String, double>::const_iterator it = baselines.find(metric);
+    if (it == baselines.end()) {
+        return ::testing::AssertionSuccess() << metric << " has no baseline on " << GetPlatform();
+    }
+    double baseline = it->second;
+    double limit = (direction == LOWER_IS_BETTER) ? baseline * (1.0 + tolerance) : baseline * (1.0 - tolerance);
+    bool regressed = (direction == LOWER_IS_BETTER) ? (value > limit) : (value < limit);
+    if (regressed) {
+        return ::testing::AssertionFailure() << metric << " regressed: measured " << value << ", baseline " << baseline
+                                             << " on " << GetPlatform() << ", limit " << limit;
+    }
+    return ::testing::AssertionSuccess();
+}
+
+double PerfBaseline::Median(std::vector<double> samples)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t mid = samples.size() / 2;
+    return (samples.size() & 1) ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+}
+
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#ifndef _TEST_PerfBaseline_H
+#define _TEST_PerfBaseline_H
+
+#include <qcc/platform.h>
+
+#include <map>
+#include <vector>
+
+#include <qcc/String.h>
+
+#include <gtest/gtest.h>
+
+namespace ajn {
+
+/**
+ * Baselines for the performance regression tests. Each metric has a baseline per platform and a
+ * measurement fails if it is worse than the baseline by more than the tolerance.
+ *
+ * The baselines built into the tests are deliberately generous so that they only catch gross
+ * regressions on a loaded build machine. A machine that runs the tests regularly should record
+ * its own baselines and point the tests at them:
+ *
+ *   - AJ_PERF_RECORD=<file>     appends "<metric> <value>" for every measurement to the file
+ *   - AJ_PERF_BASELINE=<file>   reads "<metric> <value>" lines that replace the built-in baselines
+ *   - AJ_PERF_TOLERANCE=<pct>   how much worse than the baseline a measurement may be (default 25)
+ *
+ * Lines of a baseline file that start with '#' are comments.
+ */
+class PerfBaseline {
+  public:
+
+    /** Whether smaller or larger measurements are better */
+    enum Direction {
+        LOWER_IS_BETTER,
+        HIGHER_IS_BETTER
+    };
+
+    /**
+     * @return  The baselines of the platform the tests are running on.
+     */
+    static PerfBaseline& GetPerfBaseline();
+
+    /**
+     * @return  The name of the platform the tests were built for, e.g. "linux".
+     */
+    static const char* GetPlatform();
+
+    /**
+     * Check a measurement against the baseline of a metric. The measurement is printed and
+     * recorded if recording was requested. A metric without a baseline always passes.
+     *
+     * @param metric     Name of the metric.
+     * @param value      The measurement.
+     * @param direction  Whether smaller or larger measurements are better.
+     *
+     * @return  Failure if the measurement is worse than the baseline by more than the tolerance.
+     */
+    ::testing::AssertionResult Check(const char* metric, double value, Direction direction);
+
+    /**
+     * Set the baseline of a metric.
+     *
+     * @param metric  Name of the metric.
+     * @param value   The baseline.
+     */
+    void SetBaseline(const char* metric, double value) { baselines[metric] = value; }
+
+    /**
+     * @return  The tolerance as a fraction of the baseline.
+     */
+    double GetTolerance() const { return tolerance; }
+
+    /**
+     * Set the tolerance.
+     *
+     * @param percent  How much worse than the baseline a measurement may be, in percent.
+     */
+    void SetTolerance(uint32_t percent) { tolerance = percent / 100.0; }
+
+    /**
+     * Get the median of a number of runs, which is less sensitive to a single run that was
+     * descheduled than the mean.
+     *
+     * @param samples  The measurements of each run.
+     *
+     * @return  The median, or 0 if there are no samples.
+     */
+    static double Median(std::vector<double> samples);
+
+    /** Construct without any baselines and the default tolerance */
+    PerfBaseline();
+
+  private:
+    void Load(const qcc::String& fileName);
+
+    std::map<qcc::String, double> baselines;
+    double tolerance;
+    qcc::String recordFile;
+};
+
+}
+
+#endif
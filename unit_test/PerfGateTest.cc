@@ -0,0 +1,337 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/atomic.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/BusObject.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/ProxyBusObject.h>
+
+#include "LatencyHistogram.h"
+#include "PerfBaseline.h"
+#include "ajTestCommon.h"
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace qcc;
+using namespace ajn;
+
+/*
+ * Performance regression gates. Each test measures one metric a few times and checks the median
+ * against the baseline of the platform, see PerfBaseline.h.
+ */
+
+static const char* PERF_INTERFACE = "org.alljoyn.test.PerfGate";
+static const char* PERF_PATH = "/org/alljoyn/test/PerfGate";
+
+static const size_t NUM_RUNS = 5;
+
+class PerfGateObject : public BusObject {
+  public:
+    PerfGateObject(const InterfaceDescription& intf) : BusObject(PERF_PATH), tick(intf.GetMember("Tick"))
+    {
+        AddInterface(intf);
+        AddMethodHandler(intf.GetMember("Ping"), static_cast<MessageReceiver::MethodHandler>(&PerfGateObject::Ping));
+    }
+
+    void Ping(const InterfaceDescription::Member* member, Message& msg)
+    {
+        MethodReply(msg, msg->GetArg(0), 1);
+    }
+
+    QStatus Tick(const char* destination, uint32_t n)
+    {
+        MsgArg arg("u", n);
+        return Signal(destination, 0, *tick, &arg, 1);
+    }
+
+  private:
+    const InterfaceDescription::Member* tick;
+};
+
+class PerfGatePasswordListener : public AuthListener {
+    bool RequestCredentials(const char* authMechanism, const char* peerName, uint16_t authCount, const char* userName, uint16_t credMask, Credentials& credentials)
+    {
+        if (credMask & AuthListener::CRED_PASSWORD) {
+            credentials.SetPassword("271828");
+        }
+        return true;
+    }
+
+    void AuthenticationComplete(const char* authMechanism, const char* peerName, bool success)
+    {
+        EXPECT_TRUE(success);
+    }
+};
+
+/* Exposes marshaling without delivery */
+class PerfGateMessage : public _Message {
+  public:
+    PerfGateMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus MethodCall(const char* destination, const char* objPath, const char* iface, const char* methodName, const MsgArg* argList, size_t numArgs)
+    {
+        return CallMsg(MsgArg::Signature(argList, numArgs), destination, 0, objPath, iface, methodName, argList, numArgs, 0);
+    }
+};
+
+class PerfGateTest : public testing::Test, public MessageReceiver {
+  public:
+    PerfGateTest() :
+        serviceBus("PerfGateService", false),
+        clientBus("PerfGateClient", false),
+        service(NULL),
+        ticks(0)
+    { }
+
+    virtual void SetUp()
+    {
+        InterfaceDescription* intf = NULL;
+        ASSERT_EQ(ER_OK, serviceBus.CreateInterface(PERF_INTERFACE, intf));
+        intf->AddMethod("Ping", "s", "s", "in,out");
+        intf->AddSignal("Tick", "u", "n");
+        intf->Activate();
+        service = new PerfGateObject(*intf);
+        ASSERT_EQ(ER_OK, serviceBus.RegisterBusObject(*service));
+
+        ASSERT_EQ(ER_OK, serviceBus.Start());
+        ASSERT_EQ(ER_OK, serviceBus.Connect(getConnectArg().c_str()));
+        ASSERT_EQ(ER_OK, clientBus.Start());
+        ASSERT_EQ(ER_OK, clientBus.Connect(getConnectArg().c_str()));
+    }
+
+    virtual void TearDown()
+    {
+        clientBus.Stop();
+        clientBus.Join();
+        serviceBus.UnregisterBusObject(*service);
+        serviceBus.Stop();
+        serviceBus.Join();
+        delete service;
+    }
+
+    void TickHandler(const InterfaceDescription::Member* member, const char* srcPath, Message& msg)
+    {
+        IncrementAndFetch(&ticks);
+    }
+
+    ProxyBusObject GetServiceProxy()
+    {
+        ProxyBusObject proxy(clientBus, serviceBus.GetUniqueName().c_str(), PERF_PATH, 0);
+        QStatus status = proxy.IntrospectRemoteObject();
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        return proxy;
+    }
+
+    BusAttachment serviceBus;
+    BusAttachment clientBus;
+    PerfGateObject* service;
+    volatile int32_t ticks;
+};
+
+TEST(PerfBaselineTest, tolerance_and_direction) {
+    PerfBaseline baseline;
+    baseline.SetTolerance(10);
+    baseline.SetBaseline("lower", 100);
+    baseline.SetBaseline("higher", 100);
+
+    EXPECT_TRUE(baseline.Check("lower", 109, PerfBaseline::LOWER_IS_BETTER));
+    EXPECT_FALSE(baseline.Check("lower", 111, PerfBaseline::LOWER_IS_BETTER));
+    EXPECT_TRUE(baseline.Check("higher", 91, PerfBaseline::HIGHER_IS_BETTER));
+    EXPECT_FALSE(baseline.Check("higher", 89, PerfBaseline::HIGHER_IS_BETTER));
+    /* Metrics without a baseline are only reported */
+    EXPECT_TRUE(baseline.Check("unknown", 1e9, PerfBaseline::LOWER_IS_BETTER));
+
+    vector<double> samples;
+    EXPECT_EQ(0, PerfBaseline::Median(samples));
+    samples.push_back(9);
+    samples.push_back(1);
+    samples.push_back(5);
+    EXPECT_EQ(5, PerfBaseline::Median(samples));
+    samples.push_back(7);
+    EXPECT_EQ(6, PerfBaseline::Median(samples));
+}
+
+TEST_F(PerfGateTest, local_method_rtt) {
+    ProxyBusObject proxy = GetServiceProxy();
+    MsgArg arg("s", "ping");
+    Message reply(clientBus);
+    /* Warm up the route and the reply handling before measuring */
+    for (size_t i = 0; i < 20; ++i) {
+        ASSERT_EQ(ER_OK, proxy.MethodCall(PERF_INTERFACE, "Ping", &arg, 1, reply));
+    }
+    vector<double> runs;
+    for (size_t r = 0; r < NUM_RUNS; ++r) {
+        static const size_t CALLS = 200;
+        uint64_t start = GetLatencyClock();
+        for (size_t i = 0; i < CALLS; ++i) {
+            ASSERT_EQ(ER_OK, proxy.MethodCall(PERF_INTERFACE, "Ping", &arg, 1, reply));
+        }
+        runs.push_back(static_cast<double>(GetLatencyClock() - start) / CALLS);
+    }
+    EXPECT_TRUE(PerfBaseline::GetPerfBaseline().Check("local_method_rtt_us", PerfBaseline::Median(runs), PerfBaseline::LOWER_IS_BETTER));
+}
+
+TEST_F(PerfGateTest, signal_throughput) {
+    ProxyBusObject proxy = GetServiceProxy();
+    const InterfaceDescription* intf = proxy.GetInterface(PERF_INTERFACE);
+    ASSERT_TRUE(intf != NULL);
+    ASSERT_EQ(ER_OK, clientBus.RegisterSignalHandler(this, static_cast<MessageReceiver::SignalHandler>(&PerfGateTest::TickHandler),
+                                                     intf->GetMember("Tick"), PERF_PATH));
+    qcc::String client = clientBus.GetUniqueName();
+
+    vector<double> runs;
+    for (size_t r = 0; r < NUM_RUNS; ++r) {
+        static const int32_t SIGNALS = 1000;
+        ticks = 0;
+        uint64_t start = GetLatencyClock();
+        for (int32_t i = 0; i < SIGNALS; ++i) {
+            ASSERT_EQ(ER_OK, service->Tick(client.c_str(), i));
+        }
+        for (size_t wait = 0; (ticks < SIGNALS) && (wait < 1000); ++wait) {
+            qcc::Sleep(10);
+        }
+        uint64_t usecs = GetLatencyClock() - start;
+        ASSERT_EQ(SIGNALS, static_cast<int32_t>(ticks));
+        runs.push_back((SIGNALS * 1000000.0) / (usecs ? usecs : 1));
+    }
+    EXPECT_TRUE(PerfBaseline::GetPerfBaseline().Check("signal_rate_per_s", PerfBaseline::Median(runs), PerfBaseline::HIGHER_IS_BETTER));
+}
+
+TEST_F(PerfGateTest, marshal) {
+    /* A property dictionary and a string, typical of what the bus carries */
+    MsgArg entries[8];
+    MsgArg values[8];
+    char keys[8][8];
+    for (size_t i = 0; i < ArraySize(entries); ++i) {
+        snprintf(keys[i], sizeof(keys[i]), "key%u", static_cast<uint32_t>(i));
+        values[i].Set("u", static_cast<uint32_t>(i));
+        entries[i].Set("{sv}", keys[i], &values[i]);
+    }
+    MsgArg args[2];
+    args[0].Set("a{sv}", ArraySize(entries), entries);
+    args[1].Set("s", "The quick brown fox jumps over the lazy dog");
+
+    PerfGateMessage msg(clientBus);
+    vector<double> runs;
+    for (size_t r = 0; r < NUM_RUNS; ++r) {
+        static const size_t OPS = 2000;
+        uint64_t start = GetLatencyClock();
+        for (size_t i = 0; i < OPS; ++i) {
+            ASSERT_EQ(ER_OK, msg.MethodCall("org.alljoyn.test.dest", PERF_PATH, PERF_INTERFACE, "Ping", args, ArraySize(args)));
+        }
+        runs.push_back(static_cast<double>(GetLatencyClock() - start) * 1000.0 / OPS);
+    }
+    EXPECT_TRUE(PerfBaseline::GetPerfBaseline().Check("marshal_ns_per_op", PerfBaseline::Median(runs), PerfBaseline::LOWER_IS_BETTER));
+}
+
+TEST_F(PerfGateTest, auth_handshake) {
+    PerfGatePasswordListener serviceListener;
+    PerfGatePasswordListener clientListener;
+    ASSERT_EQ(ER_OK, serviceBus.EnablePeerSecurity("ALLJOYN_SRP_KEYX", &serviceListener));
+    serviceBus.ClearKeyStore();
+    ASSERT_EQ(ER_OK, clientBus.EnablePeerSecurity("ALLJOYN_SRP_KEYX", &clientListener));
+    clientBus.ClearKeyStore();
+
+    ProxyBusObject proxy(clientBus, serviceBus.GetUniqueName().c_str(), PERF_PATH, 0);
+    vector<double> runs;
+    for (size_t r = 0; r < NUM_RUNS; ++r) {
+        /* Forcing authentication discards the keys of the previous run */
+        uint64_t start = GetLatencyClock();
+        QStatus status = proxy.SecureConnection(true);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        runs.push_back(static_cast<double>(GetLatencyClock() - start) / 1000.0);
+    }
+    EXPECT_TRUE(PerfBaseline::GetPerfBaseline().Check("auth_handshake_ms", PerfBaseline::Median(runs), PerfBaseline::LOWER_IS_BETTER));
+
+    clientBus.ClearKeyStore();
+    serviceBus.ClearKeyStore();
+    clientBus.EnablePeerSecurity(NULL, NULL);
+    serviceBus.EnablePeerSecurity(NULL, NULL);
+}
+
+/* Sum of the bytes held by every subsystem the daemon accounts, false if it does not publish them */
+static bool GetDaemonMemory(BusAttachment& bus, int64_t& bytes)
+{
+    static const char* STATS_INTERFACE = "org.alljoyn.Bus.Debug.Stats";
+    const InterfaceDescription* statsIntf = bus.GetInterface(STATS_INTERFACE);
+    if (!statsIntf) {
+        InterfaceDescription* newIntf = NULL;
+        if (bus.CreateInterface(STATS_INTERFACE, newIntf) != ER_OK) {
+            return false;
+        }
+        newIntf->AddProperty("Memory", "a(sxxi)", PROP_ACCESS_READ);
+        newIntf->Activate();
+        statsIntf = newIntf;
+    }
+    ProxyBusObject dbgObj = bus.GetAllJoynDebugObj();
+    dbgObj.AddInterface(*statsIntf);
+    MsgArg memory;
+    if (dbgObj.GetProperty(STATS_INTERFACE, "Memory", memory) != ER_OK) {
+        return false;
+    }
+    MsgArg* subsystems;
+    size_t numSubsystems;
+    if ((memory.Get("a(sxxi)", &numSubsystems, &subsystems) != ER_OK) || (numSubsystems == 0)) {
+        return false;
+    }
+    bytes = 0;
+    for (size_t i = 0; i < numSubsystems; ++i) {
+        const char* name;
+        int64_t held;
+        int64_t peak;
+        int32_t objects;
+        if (subsystems[i].Get("(sxxi)", &name, &held, &peak, &objects) == ER_OK) {
+            bytes += held;
+        }
+    }
+    return true;
+}
+
+TEST_F(PerfGateTest, daemon_memory_per_client) {
+    int64_t before;
+    if (!GetDaemonMemory(clientBus, before)) {
+        printf("The daemon does not account memory (a debug daemon with limit memory_accounting is needed), not measured\n");
+        return;
+    }
+    static const size_t CLIENTS = 10;
+    vector<BusAttachment*> clients;
+    for (size_t i = 0; i < CLIENTS; ++i) {
+        BusAttachment* bus = new BusAttachment("PerfGateIdleClient", false);
+        clients.push_back(bus);
+        ASSERT_EQ(ER_OK, bus->Start());
+        ASSERT_EQ(ER_OK, bus->Connect(getConnectArg().c_str()));
+    }
+    /* Let the daemon finish the name table updates for the new clients */
+    qcc::Sleep(200);
+    int64_t after = before;
+    EXPECT_TRUE(GetDaemonMemory(clientBus, after));
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i]->Stop();
+        clients[i]->Join();
+        delete clients[i];
+    }
+    double perClient = static_cast<double>(after - before) / CLIENTS;
+    EXPECT_TRUE(PerfBaseline::GetPerfBaseline().Check("daemon_bytes_per_client", perClient, PerfBaseline::LOWER_IS_BETTER));
+}
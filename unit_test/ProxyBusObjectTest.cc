@@ -22,6 +22,10 @@
 #include <alljoyn/InterfaceDescription.h>
 #include <alljoyn/DBusStd.h>
 #include <qcc/Thread.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+#include <vector>
 
 using namespace ajn;
 using namespace qcc;
@@ -440,3 +444,382 @@ TEST_F(ProxyBusObjectTest, AddChild_regressionTest) {
     //if ALLJOYN-1908 were not fixed this would return 1
     EXPECT_EQ((size_t)2, numChildren);
 }
+
+TEST_F(ProxyBusObjectTest, AddChild_ManyChildren) {
+    QStatus status = ER_FAIL;
+    ProxyBusObject proxyObj(bus, "org.alljoyn.test.ProxyBusObjectTest", "/", 0);
+
+    /* Siblings deep in the tree, their parents are created on the way down */
+    static const size_t NUM_CHILDREN = 2000;
+    for (size_t i = 0; i < NUM_CHILDREN; ++i) {
+        qcc::String childPath = "/org/alljoyn/test/Child" + qcc::U32ToString(static_cast<uint32_t>(i));
+        ProxyBusObject child(bus, "org.alljoyn.test.ProxyBusObjectTest", childPath.c_str(), 0);
+        status = proxyObj.AddChild(child);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+    ProxyBusObject dup(bus, "org.alljoyn.test.ProxyBusObjectTest", "/org/alljoyn/test/Child7", 0);
+    EXPECT_EQ(ER_BUS_OBJ_ALREADY_EXISTS, proxyObj.AddChild(dup));
+
+    ProxyBusObject* parent = proxyObj.GetChild("org/alljoyn/test");
+    ASSERT_TRUE(parent != NULL);
+    EXPECT_EQ(NUM_CHILDREN, parent->GetChildren());
+
+    ProxyBusObject* child = proxyObj.GetChild("/org/alljoyn/test/Child1234");
+    ASSERT_TRUE(child != NULL);
+    EXPECT_STREQ("/org/alljoyn/test/Child1234", child->GetPath().c_str());
+    EXPECT_TRUE(parent->GetChild("Child1999") != NULL);
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/test/Child2000") == NULL);
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/tes/Child1") == NULL);
+
+    /* Removal keeps the order of the remaining children and is seen by later lookups */
+    status = proxyObj.RemoveChild("/org/alljoyn/test/Child1");
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/test/Child1") == NULL);
+    EXPECT_EQ(NUM_CHILDREN - 1, parent->GetChildren());
+    ProxyBusObject* children[3];
+    ASSERT_EQ((size_t)3, parent->GetChildren(children, 3));
+    EXPECT_STREQ("/org/alljoyn/test/Child0", children[0]->GetPath().c_str());
+    EXPECT_STREQ("/org/alljoyn/test/Child2", children[1]->GetPath().c_str());
+    EXPECT_STREQ("/org/alljoyn/test/Child3", children[2]->GetPath().c_str());
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/test/Child2") == children[1]);
+
+    /* Removing a parent drops its subtree */
+    status = proxyObj.RemoveChild("/org/alljoyn/test");
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/test/Child2") == NULL);
+    ProxyBusObject again(bus, "org.alljoyn.test.ProxyBusObjectTest", "/org/alljoyn/test/Child2", 0);
+    EXPECT_EQ(ER_OK, proxyObj.AddChild(again));
+    EXPECT_TRUE(proxyObj.GetChild("/org/alljoyn/test/Child2") != NULL);
+}
+
+TEST_F(ProxyBusObjectTest, IntrospectCompact) {
+    status = servicebus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* testIntf = NULL;
+    status = servicebus.CreateInterface("org.alljoyn.test.ProxyBusObjectTest.Compact", testIntf, true);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddMember(MESSAGE_METHOD_CALL, "ping", "s", "s", "in,out", 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddMember(MESSAGE_SIGNAL, "chirp", "s", NULL, "chirp", 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddMemberAnnotation("ping", "org.freedesktop.DBus.Deprecated", "true");
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddProperty("volume", "u", PROP_ACCESS_RW);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    testIntf->Activate();
+
+    BusObject parentObj("/org/alljoyn/test/Compact");
+    BusObject childObj("/org/alljoyn/test/Compact/child");
+    status = parentObj.AddInterface(*testIntf);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.RegisterBusObject(parentObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.RegisterBusObject(childObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* The compact form is used in preference to XML */
+    ProxyBusObject proxy(bus, servicebus.GetUniqueName().c_str(), "/org/alljoyn/test/Compact", 0);
+    status = proxy.IntrospectRemoteObject();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    EXPECT_TRUE(proxy.ImplementsInterface("org.alljoyn.Bus.Introspectable"));
+    const InterfaceDescription* remoteIntf = proxy.GetInterface("org.alljoyn.test.ProxyBusObjectTest.Compact");
+    ASSERT_TRUE(remoteIntf);
+    EXPECT_TRUE(remoteIntf->IsSecure());
+    EXPECT_TRUE(*remoteIntf == *testIntf);
+    EXPECT_STREQ(testIntf->Introspect().c_str(), remoteIntf->Introspect().c_str());
+
+    ProxyBusObject* child = proxy.GetChild("child");
+    ASSERT_TRUE(child);
+    EXPECT_STREQ("/org/alljoyn/test/Compact/child", child->GetPath().c_str());
+
+    servicebus.UnregisterBusObject(childObj);
+    servicebus.UnregisterBusObject(parentObj);
+}
+
+class ProxyBusObjectBatchTestBusObject : public BusObject {
+  public:
+    ProxyBusObjectBatchTestBusObject(const char* path, const InterfaceDescription& intf) : BusObject(path)
+    {
+        QStatus status = AddInterface(intf);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        const MethodEntry methodEntries[] = {
+            { intf.GetMember("ping"), static_cast<MessageReceiver::MethodHandler>(&ProxyBusObjectBatchTestBusObject::Ping) }
+        };
+        status = AddMethodHandlers(methodEntries, sizeof(methodEntries) / sizeof(methodEntries[0]));
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+
+    void Ping(const InterfaceDescription::Member* member, Message& msg)
+    {
+        const MsgArg* arg = msg->GetArg(0);
+        if (::strcmp(arg->v_string.str, "fail") == 0) {
+            MethodReply(msg, ER_FAIL);
+        } else {
+            MethodReply(msg, arg, 1);
+        }
+    }
+};
+
+TEST_F(ProxyBusObjectTest, MethodCallBatch) {
+    status = servicebus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* testIntf = NULL;
+    status = servicebus.CreateInterface(INTERFACE_NAME, testIntf, false);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddMember(MESSAGE_METHOD_CALL, "ping", "s", "s", "in,out", 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    testIntf->Activate();
+
+    ProxyBusObjectBatchTestBusObject testObj(OBJECT_PATH, *testIntf);
+    status = servicebus.RegisterBusObject(testObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    ProxyBusObject proxy(bus, servicebus.GetUniqueName().c_str(), OBJECT_PATH, 0);
+    status = proxy.IntrospectRemoteObject();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    const InterfaceDescription::Member* ping = proxy.GetInterface(INTERFACE_NAME)->GetMember("ping");
+    ASSERT_TRUE(ping);
+
+    static const size_t NUM_CALLS = 50;
+    std::vector<MsgArg> args(NUM_CALLS);
+    std::vector<qcc::String> strs(NUM_CALLS);
+    std::vector<ProxyBusObject::BatchedCall> calls;
+    for (size_t i = 0; i < NUM_CALLS; ++i) {
+        strs[i] = (i == 7) ? qcc::String("fail") : qcc::U32ToString(i);
+        args[i].Set("s", strs[i].c_str());
+        calls.push_back(ProxyBusObject::BatchedCall(bus, *ping, &args[i], 1));
+    }
+
+    status = proxy.MethodCallBatch(&calls[0], calls.size());
+    EXPECT_EQ(ER_BUS_REPLY_IS_ERROR_MESSAGE, status) << "  Actual Status: " << QCC_StatusText(status);
+    for (size_t i = 0; i < NUM_CALLS; ++i) {
+        if (i == 7) {
+            EXPECT_EQ(ER_BUS_REPLY_IS_ERROR_MESSAGE, calls[i].status) << "  Actual Status: " << QCC_StatusText(calls[i].status);
+        } else {
+            EXPECT_EQ(ER_OK, calls[i].status) << "  Actual Status: " << QCC_StatusText(calls[i].status);
+            EXPECT_STREQ(strs[i].c_str(), calls[i].replyMsg->GetArg(0)->v_string.str);
+        }
+    }
+
+    servicebus.UnregisterBusObject(testObj);
+}
+
+TEST_F(ProxyBusObjectTest, MethodCallRepeated) {
+    status = servicebus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* testIntf = NULL;
+    status = servicebus.CreateInterface(INTERFACE_NAME, testIntf, false);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = testIntf->AddMember(MESSAGE_METHOD_CALL, "ping", "s", "s", "in,out", 0);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    testIntf->Activate();
+
+    ProxyBusObjectBatchTestBusObject testObj(OBJECT_PATH, *testIntf);
+    status = servicebus.RegisterBusObject(testObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    ProxyBusObject proxy(bus, servicebus.GetUniqueName().c_str(), OBJECT_PATH, 0);
+    status = proxy.IntrospectRemoteObject();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* Calls made one after another on a thread must each get their own reply, spinning or not */
+    for (uint32_t spin = 0; spin <= 1000; spin += 1000) {
+        bus.EnableMethodCallSpin(spin);
+        Message reply(bus);
+        for (size_t i = 0; i < 20; ++i) {
+            qcc::String str = (i == 7) ? qcc::String("fail") : qcc::U32ToString(i);
+            MsgArg arg("s", str.c_str());
+            status = proxy.MethodCall(INTERFACE_NAME, "ping", &arg, 1, reply);
+            if (i == 7) {
+                EXPECT_EQ(ER_BUS_REPLY_IS_ERROR_MESSAGE, status) << "  Actual Status: " << QCC_StatusText(status);
+            } else {
+                EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+                EXPECT_STREQ(str.c_str(), reply->GetArg(0)->v_string.str);
+            }
+        }
+    }
+    bus.EnableMethodCallSpin(0);
+
+    servicebus.UnregisterBusObject(testObj);
+}
+
+class ProxyBusObjectPropsTestBusObject : public BusObject {
+  public:
+    ProxyBusObjectPropsTestBusObject(const char* path, const InterfaceDescription& intf) : BusObject(path)
+    {
+        QStatus status = AddInterface(intf);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        values[0] = 1;
+        values[1] = 2;
+        values[2] = 3;
+    }
+
+    QStatus Get(const char* ifcName, const char* propName, MsgArg& val)
+    {
+        int i = PropIndex(propName);
+        return (i < 0) ? ER_BUS_NO_SUCH_PROPERTY : val.Set("u", values[i]);
+    }
+
+    QStatus Set(const char* ifcName, const char* propName, MsgArg& val)
+    {
+        int i = PropIndex(propName);
+        return (i < 0) ? ER_BUS_NO_SUCH_PROPERTY : val.Get("u", &values[i]);
+    }
+
+    int PropIndex(const char* propName)
+    {
+        if (::strcmp(propName, "a") == 0) {
+            return 0;
+        } else if (::strcmp(propName, "b") == 0) {
+            return 1;
+        } else if (::strcmp(propName, "c") == 0) {
+            return 2;
+        }
+        return -1;
+    }
+
+    uint32_t values[3];
+};
+
+TEST_F(ProxyBusObjectTest, GetSetProperties) {
+    status = servicebus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* testIntf = NULL;
+    status = servicebus.CreateInterface(INTERFACE_NAME, testIntf, false);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    testIntf->AddProperty("a", "u", PROP_ACCESS_RW);
+    testIntf->AddProperty("b", "u", PROP_ACCESS_RW);
+    testIntf->AddProperty("c", "u", PROP_ACCESS_READ);
+    testIntf->Activate();
+
+    ProxyBusObjectPropsTestBusObject testObj(OBJECT_PATH, *testIntf);
+    status = servicebus.RegisterBusObject(testObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    ProxyBusObject proxy(bus, servicebus.GetUniqueName().c_str(), OBJECT_PATH, 0);
+    status = proxy.IntrospectRemoteObject();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    const char* names[] = { "a", "b", "c" };
+    MsgArg values[3];
+    QStatus statuses[3];
+    status = proxy.GetProperties(INTERFACE_NAME, names, values, statuses, ArraySize(names));
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    for (size_t i = 0; i < ArraySize(names); ++i) {
+        EXPECT_EQ(ER_OK, statuses[i]) << "  Actual Status: " << QCC_StatusText(statuses[i]);
+        uint32_t v = 0;
+        EXPECT_EQ(ER_OK, values[i].Get("u", &v));
+        EXPECT_EQ((uint32_t)(i + 1), v);
+    }
+
+    /* "c" is read-only so only the first two are set */
+    values[0].Set("u", 10);
+    values[1].Set("u", 20);
+    values[2].Set("u", 30);
+    status = proxy.SetProperties(INTERFACE_NAME, names, values, statuses, ArraySize(names));
+    EXPECT_NE(ER_OK, status);
+    EXPECT_EQ(ER_OK, statuses[0]) << "  Actual Status: " << QCC_StatusText(statuses[0]);
+    EXPECT_EQ(ER_OK, statuses[1]) << "  Actual Status: " << QCC_StatusText(statuses[1]);
+    EXPECT_NE(ER_OK, statuses[2]);
+    EXPECT_EQ((uint32_t)10, testObj.values[0]);
+    EXPECT_EQ((uint32_t)20, testObj.values[1]);
+    EXPECT_EQ((uint32_t)3, testObj.values[2]);
+
+    servicebus.UnregisterBusObject(testObj);
+}
+
+static void CreatePropertyCacheInterface(BusAttachment& bus, InterfaceDescription*& intf)
+{
+    QStatus status = bus.CreateInterface(INTERFACE_NAME, intf, false);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    intf->AddProperty("a", "u", PROP_ACCESS_RW);
+    intf->AddPropertyAnnotation("a", org::freedesktop::DBus::AnnotateEmitsChanged, "true");
+    intf->AddProperty("b", "u", PROP_ACCESS_RW);
+    intf->AddPropertyAnnotation("b", org::freedesktop::DBus::AnnotateEmitsChanged, "invalidates");
+    intf->AddProperty("c", "u", PROP_ACCESS_READ);
+    intf->Activate();
+}
+
+static uint32_t GetU32Property(ProxyBusObject& proxy, const char* name)
+{
+    MsgArg val;
+    uint32_t v = 0;
+    QStatus status = proxy.GetProperty(INTERFACE_NAME, name, val);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    val.Get("u", &v);
+    return v;
+}
+
+TEST_F(ProxyBusObjectTest, PropertyCache) {
+    status = servicebus.Start();
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = servicebus.Connect(ajn::getConnectArg().c_str());
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    InterfaceDescription* serviceIntf = NULL;
+    CreatePropertyCacheInterface(servicebus, serviceIntf);
+    ProxyBusObjectPropsTestBusObject testObj(OBJECT_PATH, *serviceIntf);
+    status = servicebus.RegisterBusObject(testObj);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    /* The client needs the annotations to know which properties can be cached */
+    InterfaceDescription* clientIntf = NULL;
+    CreatePropertyCacheInterface(bus, clientIntf);
+    ProxyBusObject proxy(bus, servicebus.GetUniqueName().c_str(), OBJECT_PATH, 0);
+    status = proxy.AddInterface(*clientIntf);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    status = proxy.EnablePropertyCache(INTERFACE_NAME);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ((uint32_t)1, GetU32Property(proxy, "a"));
+    EXPECT_EQ((uint32_t)2, GetU32Property(proxy, "b"));
+
+    /* A change that is not signalled is only seen for the property that is never cached */
+    testObj.values[0] = 10;
+    testObj.values[2] = 30;
+    EXPECT_EQ((uint32_t)1, GetU32Property(proxy, "a"));
+    EXPECT_EQ((uint32_t)30, GetU32Property(proxy, "c"));
+
+    /* A signalled change updates the cache */
+    MsgArg val("u", 10);
+    testObj.EmitPropChanged(INTERFACE_NAME, "a", val, 0);
+    for (size_t i = 0; i < 200; ++i) {
+        if (GetU32Property(proxy, "a") == 10) {
+            break;
+        }
+        qcc::Sleep(5);
+    }
+    EXPECT_EQ((uint32_t)10, GetU32Property(proxy, "a"));
+
+    /* An invalidated property is read from the remote object again */
+    testObj.values[1] = 20;
+    val.Set("u", 20);
+    testObj.EmitPropChanged(INTERFACE_NAME, "b", val, 0);
+    for (size_t i = 0; i < 200; ++i) {
+        if (GetU32Property(proxy, "b") == 20) {
+            break;
+        }
+        qcc::Sleep(5);
+    }
+    EXPECT_EQ((uint32_t)20, GetU32Property(proxy, "b"));
+
+    /* Once disabled every read goes to the remote object */
+    proxy.DisablePropertyCache(INTERFACE_NAME);
+    testObj.values[0] = 100;
+    EXPECT_EQ((uint32_t)100, GetU32Property(proxy, "a"));
+
+    servicebus.UnregisterBusObject(testObj);
+}
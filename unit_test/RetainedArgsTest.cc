@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <vector>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <RemoteEndpoint.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+static const char* TEST_PATH = "/org/alljoyn/test/retained";
+static const char* TEST_INTERFACE = "org.alljoyn.test.Retained";
+
+class RetainedTestMessage : public _Message {
+  public:
+    RetainedTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus Signal(const MsgArg* args, size_t numArgs)
+    {
+        return SignalMsg(MsgArg::Signature(args, numArgs), "", 0, TEST_PATH, TEST_INTERFACE, "Data", args, numArgs, 0, 0);
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep) { return _Message::Deliver(ep); }
+
+    QStatus Receive(RemoteEndpoint& ep)
+    {
+        QStatus status = _Message::Read(ep, false);
+        if (status == ER_OK) {
+            status = _Message::Unmarshal(ep, false);
+        }
+        if (status == ER_OK) {
+            status = _Message::UnmarshalArgs("*");
+        }
+        return status;
+    }
+};
+
+typedef ManagedObj<RetainedTestMessage> RetainedTestMsg;
+
+/* What a signal handler does with the args it wants to keep */
+static void RetainingHandler(Message& msg, vector<RetainedArgs>& kept)
+{
+    kept.push_back(RetainedArgs(msg));
+}
+
+class RetainedArgsTest : public testing::Test {
+  public:
+    RetainedArgsTest() : bus("RetainedArgsTest", false), ep(bus, false, String::Empty, &stream) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, bus.Start());
+    }
+
+    virtual void TearDown()
+    {
+        bus.Stop();
+        bus.Join();
+    }
+
+    /*
+     * Send a signal with a string, a byte array, a string array and an integer all derived from
+     * seed through the pipe and read it back. Every seed gives a message of the same size.
+     */
+    QStatus SendAndReceive(uint32_t seed, Message& rx)
+    {
+        char str[] = "string-0";
+        str[7] = static_cast<char>('0' + seed % 10);
+        uint8_t bytes[16];
+        memset(bytes, static_cast<uint8_t>(seed), sizeof(bytes));
+        char elem0[] = "first-0";
+        char elem1[] = "second-0";
+        elem0[6] = elem1[7] = static_cast<char>('0' + seed % 10);
+        const char* strs[] = { elem0, elem1 };
+
+        MsgArg args[4];
+        args[0].Set("s", str);
+        args[1].Set("ay", sizeof(bytes), bytes);
+        args[2].Set("as", ArraySize(strs), strs);
+        args[3].Set("u", seed);
+
+        RetainedTestMsg tx(bus);
+        QStatus status = tx->Signal(args, ArraySize(args));
+        if (status == ER_OK) {
+            status = tx->Deliver(ep);
+        }
+        if (status == ER_OK) {
+            RetainedTestMsg in(bus);
+            status = in->Receive(ep);
+            rx = Message::cast(in);
+        }
+        return status;
+    }
+
+    void ExpectArgs(const RetainedArgs& retained, uint32_t seed)
+    {
+        ASSERT_EQ(4U, retained.GetNumArgs());
+        ASSERT_TRUE(retained.GetArgs() != NULL);
+        EXPECT_EQ(retained.GetArgs(), retained.GetArg(0));
+        EXPECT_TRUE(retained.GetArg(4) == NULL);
+
+        char digit = static_cast<char>('0' + seed % 10);
+        const char* str = NULL;
+        ASSERT_EQ(ER_OK, retained.GetArg(0)->Get("s", &str));
+        EXPECT_STREQ((String("string-") + digit).c_str(), str);
+
+        size_t numBytes = 0;
+        const uint8_t* bytes = NULL;
+        ASSERT_EQ(ER_OK, retained.GetArg(1)->Get("ay", &numBytes, &bytes));
+        ASSERT_EQ(16U, numBytes);
+        for (size_t i = 0; i < numBytes; ++i) {
+            EXPECT_EQ(static_cast<uint8_t>(seed), bytes[i]);
+        }
+
+        size_t numStrs = 0;
+        const MsgArg* strs = NULL;
+        ASSERT_EQ(ER_OK, retained.GetArg(2)->Get("as", &numStrs, &strs));
+        ASSERT_EQ(2U, numStrs);
+        EXPECT_STREQ((String("first-") + digit).c_str(), strs[0].v_string.str);
+        EXPECT_STREQ((String("second-") + digit).c_str(), strs[1].v_string.str);
+
+        uint32_t val = 0;
+        ASSERT_EQ(ER_OK, retained.GetArg(3)->Get("u", &val));
+        EXPECT_EQ(seed, val);
+    }
+
+    BusAttachment bus;
+    Pipe stream;
+    RemoteEndpoint ep;
+};
+
+TEST_F(RetainedArgsTest, args_outlive_handler_and_message) {
+    vector<RetainedArgs> kept;
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+        Message rx(bus);
+        ASSERT_EQ(ER_OK, SendAndReceive(seed, rx));
+        RetainingHandler(rx, kept);
+        /* The args point into the received buffer, nothing was copied */
+        EXPECT_EQ(rx->GetArg(0), kept.back().GetArg(0));
+        EXPECT_EQ(&(*rx), &(*kept.back().GetMessage()));
+    }
+
+    /*
+     * Every reference but the retained ones is gone. Receiving more messages of the same size
+     * would get the released buffers back from the pool and overwrite the args if the retained
+     * ones did not keep their buffers alive.
+     */
+    for (uint32_t seed = 7; seed <= 9; ++seed) {
+        Message rx(bus);
+        ASSERT_EQ(ER_OK, SendAndReceive(seed, rx));
+    }
+
+    ASSERT_EQ(3U, kept.size());
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+        ExpectArgs(kept[seed - 1], seed);
+    }
+}
+
+TEST_F(RetainedArgsTest, copies_share_the_message) {
+    RetainedArgs* original = NULL;
+    {
+        Message rx(bus);
+        ASSERT_EQ(ER_OK, SendAndReceive(5, rx));
+        original = new RetainedArgs(rx);
+    }
+    RetainedArgs copy(*original);
+    EXPECT_EQ(original->GetArgs(), copy.GetArgs());
+    EXPECT_EQ(&(*original->GetMessage()), &(*copy.GetMessage()));
+
+    /* Only the copy is left holding the message */
+    delete original;
+    Message reuse(bus);
+    ASSERT_EQ(ER_OK, SendAndReceive(6, reuse));
+    ExpectArgs(copy, 5);
+}
@@ -35,6 +35,7 @@
 /* Header files included for Google Test Framework */
 #include <gtest/gtest.h>
 #include "ajTestCommon.h"
+#include "SessionInternal.h"
 
 using namespace std;
 using namespace qcc;
@@ -379,3 +380,100 @@ TEST_F(SessionTest, SessionJoined) {
     " should be the same as " << busB.GetUniqueName().c_str();;
 }
 
+
+TEST_F(SessionTest, SessionOptsTxQueueMarshal) {
+    SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+    opts.txQueuePolicy = SessionOpts::TXQUEUE_DROP_OLDEST_SIGNAL;
+    opts.txQueueMaxMessages = 100;
+    opts.txQueueMaxBytes = 65536;
+
+    MsgArg arg;
+    SetSessionOpts(opts, arg);
+    SessionOpts out;
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_TRUE(out == opts);
+    EXPECT_EQ(SessionOpts::TXQUEUE_DROP_OLDEST_SIGNAL, out.txQueuePolicy);
+    EXPECT_EQ(100U, out.txQueueMaxMessages);
+    EXPECT_EQ(65536U, out.txQueueMaxBytes);
+
+    /* Default transmit queue settings are not marshaled */
+    SessionOpts defOpts;
+    SetSessionOpts(defOpts, arg);
+    size_t numEntries;
+    MsgArg* entries;
+    EXPECT_EQ(ER_OK, arg.Get("a{sv}", &numEntries, &entries));
+    EXPECT_EQ(4U, numEntries);
+}
+
+TEST_F(SessionTest, SessionOptsTxQueueOutOfRange) {
+    /* Hand build the options a misbehaving peer might send */
+    MsgArg policyArg("y", 0x7F);
+    MsgArg priorityArg("y", 0x7F);
+    MsgArg entries[2];
+    entries[0].Set("{sv}", "txqp", &policyArg);
+    entries[1].Set("{sv}", "txpri", &priorityArg);
+    MsgArg arg;
+    EXPECT_EQ(ER_OK, arg.Set("a{sv}", 2, entries));
+
+    SessionOpts out;
+    out.txQueuePolicy = SessionOpts::TXQUEUE_DROP_NEWEST;
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_EQ(SessionOpts::TXQUEUE_DROP_NEWEST, out.txQueuePolicy);
+    EXPECT_EQ(SessionOpts::TXPRIORITY_INTERACTIVE, out.txPriority);
+}
+
+TEST_F(SessionTest, SessionOptsDirectMarshal) {
+    SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+    opts.isDirect = true;
+
+    MsgArg arg;
+    SetSessionOpts(opts, arg);
+    SessionOpts out;
+    EXPECT_FALSE(out.isDirect);
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_TRUE(out.isDirect);
+    size_t numEntries;
+    MsgArg* entries;
+    EXPECT_EQ(ER_OK, arg.Get("a{sv}", &numEntries, &entries));
+    EXPECT_EQ(5U, numEntries);
+}
+
+TEST_F(SessionTest, SessionOptsTxPriorityMarshal) {
+    SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+    opts.txPriority = SessionOpts::TXPRIORITY_BULK;
+
+    MsgArg arg;
+    SetSessionOpts(opts, arg);
+    SessionOpts out;
+    EXPECT_EQ(SessionOpts::TXPRIORITY_INTERACTIVE, out.txPriority);
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_EQ(SessionOpts::TXPRIORITY_BULK, out.txPriority);
+    EXPECT_EQ(0U, out.txRateLimit);
+    size_t numEntries;
+    MsgArg* entries;
+    EXPECT_EQ(ER_OK, arg.Get("a{sv}", &numEntries, &entries));
+    EXPECT_EQ(5U, numEntries);
+
+    opts.txRateLimit = 250000;
+    SetSessionOpts(opts, arg);
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_EQ(250000U, out.txRateLimit);
+    EXPECT_EQ(ER_OK, arg.Get("a{sv}", &numEntries, &entries));
+    EXPECT_EQ(6U, numEntries);
+}
+
+TEST_F(SessionTest, SessionOptsTxMessageTtlMarshal) {
+    SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
+    opts.txMessageTtl = 40;
+
+    MsgArg arg;
+    SetSessionOpts(opts, arg);
+    SessionOpts out;
+    EXPECT_EQ(0U, out.txMessageTtl);
+    EXPECT_EQ(ER_OK, GetSessionOpts(arg, out));
+    EXPECT_EQ(40U, out.txMessageTtl);
+    size_t numEntries;
+    MsgArg* entries;
+    EXPECT_EQ(ER_OK, arg.Get("a{sv}", &numEntries, &entries));
+    EXPECT_EQ(5U, numEntries);
+}
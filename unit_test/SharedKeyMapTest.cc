@@ -0,0 +1,207 @@
+/**
+ * @file
+ *
+ * This file tests the shared memory map through which processes share key store changes
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <vector>
+
+#include <qcc/FileStream.h>
+#include <qcc/GUID.h>
+
+#include "SharedKeyMap.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(SharedKeyMapTest, attach_checks_owner) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    qcc::GUID128 other;
+    SharedKeyMap creator;
+    ASSERT_TRUE(creator.Init(&region[0], owner));
+    SharedKeyMap map;
+    EXPECT_FALSE(map.Attach(&region[0], region.size() - 1, owner));
+    EXPECT_FALSE(map.Attach(&region[0], region.size(), other));
+    EXPECT_TRUE(map.Attach(&region[0], region.size(), owner));
+    EXPECT_TRUE(map.IsUsable());
+}
+
+TEST(SharedKeyMapTest, write_is_seen_by_other_map) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    SharedKeyMap writer;
+    SharedKeyMap reader;
+    ASSERT_TRUE(writer.Init(&region[0], owner));
+    ASSERT_TRUE(reader.Attach(&region[0], region.size(), owner));
+
+    qcc::GUID128 guid;
+    const uint8_t record[] = "sealed key record";
+    uint32_t changes = reader.GetChangeCount();
+    writer.LockForWrite();
+    uint32_t slot;
+    ASSERT_EQ(ER_OK, writer.FindSlot(guid, slot));
+    uint32_t next = writer.GetNextVersion(slot);
+    EXPECT_EQ(next, writer.WriteSlot(slot, guid, record, sizeof(record)));
+    writer.UnlockForWrite();
+    EXPECT_NE(changes, reader.GetChangeCount());
+
+    uint32_t version;
+    qcc::GUID128 readGuid;
+    bool deleted = true;
+    std::vector<uint8_t> readRecord;
+    ASSERT_EQ(ER_OK, reader.ReadSlot(slot, version, readGuid, deleted, readRecord));
+    EXPECT_EQ(next, version);
+    EXPECT_TRUE(readGuid == guid);
+    EXPECT_FALSE(deleted);
+    ASSERT_EQ(sizeof(record), readRecord.size());
+    EXPECT_EQ(0, memcmp(record, &readRecord[0], sizeof(record)));
+
+    /* A deletion leaves a tombstone with a newer version in the same slot */
+    writer.LockForWrite();
+    uint32_t again;
+    ASSERT_EQ(ER_OK, writer.FindSlot(guid, again));
+    EXPECT_EQ(slot, again);
+    writer.WriteSlot(slot, guid, NULL, 0);
+    writer.UnlockForWrite();
+    ASSERT_EQ(ER_OK, reader.ReadSlot(slot, version, readGuid, deleted, readRecord));
+    EXPECT_GT(version, next);
+    EXPECT_TRUE(deleted);
+    EXPECT_TRUE(readRecord.empty());
+}
+
+TEST(SharedKeyMapTest, never_written_slot_is_unavailable) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    SharedKeyMap map;
+    ASSERT_TRUE(map.Init(&region[0], owner));
+    uint32_t version;
+    qcc::GUID128 guid;
+    bool deleted;
+    std::vector<uint8_t> record;
+    EXPECT_EQ(ER_BUS_KEY_UNAVAILABLE, map.ReadSlot(0, version, guid, deleted, record));
+}
+
+TEST(SharedKeyMapTest, tombstones_are_reused_and_full_map_overflows) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    SharedKeyMap map;
+    ASSERT_TRUE(map.Init(&region[0], owner));
+    const uint8_t record[] = "r";
+    std::vector<qcc::GUID128> guids(SharedKeyMap::NUM_SLOTS);
+    for (size_t i = 0; i < guids.size(); ++i) {
+        uint32_t slot;
+        ASSERT_EQ(ER_OK, map.FindSlot(guids[i], slot));
+        ASSERT_NE(0U, map.WriteSlot(slot, guids[i], record, sizeof(record)));
+    }
+    /* Deleting a key frees its slot for another */
+    uint32_t freed;
+    ASSERT_EQ(ER_OK, map.FindSlot(guids[7], freed));
+    map.WriteSlot(freed, guids[7], NULL, 0);
+    qcc::GUID128 newGuid;
+    uint32_t slot;
+    ASSERT_EQ(ER_OK, map.FindSlot(newGuid, slot));
+    EXPECT_EQ(freed, slot);
+    map.WriteSlot(slot, newGuid, record, sizeof(record));
+    EXPECT_TRUE(map.IsUsable());
+
+    qcc::GUID128 oneTooMany;
+    EXPECT_EQ(ER_RESOURCES, map.FindSlot(oneTooMany, slot));
+    EXPECT_FALSE(map.IsUsable());
+}
+
+TEST(SharedKeyMapTest, oversized_record_overflows) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    SharedKeyMap map;
+    ASSERT_TRUE(map.Init(&region[0], owner));
+    std::vector<uint8_t> record(SharedKeyMap::MAX_RECORD + 1);
+    qcc::GUID128 guid;
+    uint32_t slot;
+    ASSERT_EQ(ER_OK, map.FindSlot(guid, slot));
+    EXPECT_EQ(0U, map.WriteSlot(slot, guid, &record[0], record.size()));
+    EXPECT_FALSE(map.IsUsable());
+}
+
+/*
+ * A map is reinitialized when its file is lost or damaged and the slot versions start again, the
+ * key store nonces are only unique because the epoch changes with them.
+ */
+static uint32_t WriteRecord(SharedKeyMap& map, const qcc::GUID128& guid, uint32_t& slot)
+{
+    const uint8_t record[] = "sealed key record";
+    map.LockForWrite();
+    uint32_t version = (map.FindSlot(guid, slot) == ER_OK) ? map.WriteSlot(slot, guid, record, sizeof(record)) : 0;
+    map.UnlockForWrite();
+    return version;
+}
+
+TEST(SharedKeyMapTest, reinitialized_map_gets_new_epoch) {
+    std::vector<uint8_t> region(SharedKeyMap::RegionSize());
+    qcc::GUID128 owner;
+    qcc::GUID128 guid;
+    SharedKeyMap map;
+    ASSERT_TRUE(map.Init(&region[0], owner));
+    uint64_t epoch = map.GetEpoch();
+    EXPECT_NE(0U, epoch);
+    uint32_t slot;
+    uint32_t version = WriteRecord(map, guid, slot);
+    ASSERT_NE(0U, version);
+
+    SharedKeyMap again;
+    ASSERT_TRUE(again.Init(&region[0], owner));
+    uint32_t slotAgain;
+    EXPECT_EQ(version, WriteRecord(again, guid, slotAgain));
+    EXPECT_EQ(slot, slotAgain);
+    EXPECT_NE(epoch, again.GetEpoch());
+}
+
+#if defined(QCC_OS_GROUP_POSIX)
+TEST(SharedKeyMapTest, recreated_file_gets_new_epoch) {
+    const qcc::String fileName = "sharedkeymap_test";
+    qcc::DeleteFile(fileName);
+    qcc::GUID128 owner;
+    qcc::GUID128 guid;
+    SharedKeyMap map;
+    ASSERT_EQ(ER_OK, map.Open(fileName, owner));
+    uint64_t epoch = map.GetEpoch();
+    uint32_t slot;
+    uint32_t version = WriteRecord(map, guid, slot);
+    map.Close();
+
+    /* Reopening the same file keeps the map and its epoch */
+    ASSERT_EQ(ER_OK, map.Open(fileName, owner));
+    EXPECT_EQ(epoch, map.GetEpoch());
+    map.Close();
+
+    /* A deleted file is recreated under a new epoch, the same slot and version now make a different nonce */
+    qcc::DeleteFile(fileName);
+    ASSERT_EQ(ER_OK, map.Open(fileName, owner));
+    uint32_t slotAgain;
+    EXPECT_EQ(version, WriteRecord(map, guid, slotAgain));
+    EXPECT_EQ(slot, slotAgain);
+    EXPECT_NE(epoch, map.GetEpoch());
+    map.Close();
+    qcc::DeleteFile(fileName);
+}
+#endif
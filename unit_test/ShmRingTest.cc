@@ -0,0 +1,152 @@
+/**
+ * @file
+ *
+ * This file tests the shared memory ring used by the shm transport
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+#include <vector>
+
+#include "ShmRing.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+static const uint32_t CAPACITY = ShmRing::MIN_CAPACITY;
+
+TEST(ShmRingTest, rejects_bad_capacity) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(2 * CAPACITY));
+    ShmRing ring;
+    EXPECT_FALSE(ring.Init(&region[0], CAPACITY + 1));
+    EXPECT_FALSE(ring.Init(&region[0], CAPACITY / 2));
+    EXPECT_FALSE(ring.Init(NULL, CAPACITY));
+    EXPECT_TRUE(ring.Init(&region[0], CAPACITY));
+    EXPECT_EQ(CAPACITY, ring.GetCapacity());
+}
+
+TEST(ShmRingTest, attach_checks_region_size) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing writer;
+    ASSERT_TRUE(writer.Init(&region[0], CAPACITY));
+
+    ShmRing reader;
+    EXPECT_FALSE(reader.Attach(&region[0], region.size() - 1));
+    EXPECT_TRUE(reader.Attach(&region[0], region.size()));
+    EXPECT_EQ(CAPACITY, reader.GetCapacity());
+
+    /* A header claiming a ring larger than the region must be refused */
+    ShmRing big;
+    std::vector<uint8_t> bigRegion(ShmRing::RegionSize(2 * CAPACITY));
+    ASSERT_TRUE(big.Init(&bigRegion[0], 2 * CAPACITY));
+    EXPECT_FALSE(reader.Attach(&bigRegion[0], region.size()));
+}
+
+TEST(ShmRingTest, write_and_read_wrap_around) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing writer;
+    ShmRing reader;
+    ASSERT_TRUE(writer.Init(&region[0], CAPACITY));
+    ASSERT_TRUE(reader.Attach(&region[0], region.size()));
+
+    std::vector<uint8_t> out(1000);
+    std::vector<uint8_t> in(1000);
+    uint8_t next = 0;
+    uint8_t expect = 0;
+    for (int i = 0; i < 100; ++i) {
+        for (size_t j = 0; j < out.size(); ++j) {
+            out[j] = next++;
+        }
+        ASSERT_EQ(out.size(), writer.Write(&out[0], out.size()));
+        EXPECT_EQ(out.size(), reader.Readable());
+        ASSERT_EQ(in.size(), reader.Read(&in[0], in.size()));
+        for (size_t j = 0; j < in.size(); ++j) {
+            ASSERT_EQ(expect++, in[j]);
+        }
+    }
+    EXPECT_EQ(0U, reader.Read(&in[0], in.size()));
+}
+
+TEST(ShmRingTest, write_stops_when_full) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing ring;
+    ASSERT_TRUE(ring.Init(&region[0], CAPACITY));
+
+    std::vector<uint8_t> buf(CAPACITY + 100, 0x5a);
+    EXPECT_EQ(CAPACITY, ring.Write(&buf[0], buf.size()));
+    EXPECT_EQ(0U, ring.Writable());
+    EXPECT_EQ(0U, ring.Write(&buf[0], 1));
+    EXPECT_EQ(100U, ring.Read(&buf[0], 100));
+    EXPECT_EQ(100U, ring.Writable());
+}
+
+TEST(ShmRingTest, reader_wakeup_is_not_lost) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing writer;
+    ShmRing reader;
+    ASSERT_TRUE(writer.Init(&region[0], CAPACITY));
+    ASSERT_TRUE(reader.Attach(&region[0], region.size()));
+
+    /* No one is waiting so a writer has nobody to wake */
+    uint8_t byte = 1;
+    EXPECT_EQ(1U, writer.Write(&byte, 1));
+    EXPECT_FALSE(writer.WriterShouldWake());
+
+    /* The reader must not sleep while there are bytes in the ring */
+    EXPECT_FALSE(reader.ReaderShouldWait());
+    EXPECT_EQ(1U, reader.Read(&byte, 1));
+
+    /* Once the reader decides to sleep the next write must wake it, exactly once */
+    EXPECT_TRUE(reader.ReaderShouldWait());
+    EXPECT_EQ(1U, writer.Write(&byte, 1));
+    EXPECT_TRUE(writer.WriterShouldWake());
+    EXPECT_FALSE(writer.WriterShouldWake());
+}
+
+TEST(ShmRingTest, writer_wakeup_is_not_lost) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing writer;
+    ShmRing reader;
+    ASSERT_TRUE(writer.Init(&region[0], CAPACITY));
+    ASSERT_TRUE(reader.Attach(&region[0], region.size()));
+
+    std::vector<uint8_t> buf(CAPACITY);
+    EXPECT_EQ(CAPACITY, writer.Write(&buf[0], buf.size()));
+    EXPECT_TRUE(writer.WriterShouldWait());
+    EXPECT_EQ(10U, reader.Read(&buf[0], 10));
+    EXPECT_TRUE(reader.ReaderShouldWake());
+    EXPECT_FALSE(reader.ReaderShouldWake());
+    EXPECT_FALSE(writer.WriterShouldWait());
+}
+
+TEST(ShmRingTest, close_is_seen_by_both_sides) {
+    std::vector<uint8_t> region(ShmRing::RegionSize(CAPACITY));
+    ShmRing writer;
+    ShmRing reader;
+    ASSERT_TRUE(writer.Init(&region[0], CAPACITY));
+    ASSERT_TRUE(reader.Attach(&region[0], region.size()));
+
+    EXPECT_FALSE(reader.IsClosed());
+    writer.Close();
+    EXPECT_TRUE(reader.IsClosed());
+    /* A closed ring never puts the reader to sleep */
+    EXPECT_FALSE(reader.ReaderShouldWait());
+}
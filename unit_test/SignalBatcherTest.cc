@@ -0,0 +1,275 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+#include <qcc/Timer.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <RemoteEndpoint.h>
+#include <SignalBatcher.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+static const char* TEST_PATH = "/org/alljoyn/test/batch";
+static const char* TEST_INTERFACE = "org.alljoyn.test.Batch";
+
+class BatchTestMessage : public _Message {
+  public:
+    BatchTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus Signal(const char* path, const char* iface, const char* member, const MsgArg* args, size_t numArgs)
+    {
+        return SignalMsg(MsgArg::Signature(args, numArgs), "", 0, path, iface, member, args, numArgs, 0, 0);
+    }
+
+    QStatus MethodCall(const char* member, const MsgArg* args, size_t numArgs)
+    {
+        return CallMsg(MsgArg::Signature(args, numArgs), "", 0, TEST_PATH, TEST_INTERFACE, member, args, numArgs, 0);
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep) { return _Message::Deliver(ep); }
+
+    QStatus Receive(RemoteEndpoint& ep)
+    {
+        QStatus status = _Message::Read(ep, false);
+        if (status == ER_OK) {
+            status = _Message::Unmarshal(ep, false);
+        }
+        return status;
+    }
+
+    /* Unpack() makes plain messages so reach their UnmarshalArgs() through a pointer to the base member */
+    static QStatus UnmarshalBody(Message& msg, const char* signature)
+    {
+        QStatus (_Message::* unmarshal)(const qcc::String&, const char*) = &BatchTestMessage::UnmarshalArgs;
+        return ((*msg).*unmarshal)(signature, NULL);
+    }
+};
+
+typedef ManagedObj<BatchTestMessage> BatchTestMsg;
+
+/* An endpoint that keeps what is pushed to it instead of writing it */
+class _RecordingEndpoint : public _RemoteEndpoint {
+  public:
+    _RecordingEndpoint(BusAttachment& bus, Stream* stream) : _RemoteEndpoint(bus, false, String::Empty, stream, "recording", false) { }
+
+    QStatus PushMessage(Message& msg)
+    {
+        pushed.push_back(msg);
+        return ER_OK;
+    }
+
+    vector<Message> pushed;
+};
+
+typedef ManagedObj<_RecordingEndpoint> RecordingEndpoint;
+
+class SignalBatcherTest : public testing::Test {
+  public:
+    SignalBatcherTest() : bus("SignalBatcherTest", false), ep(bus, false, String::Empty, &stream) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, bus.Start());
+    }
+
+    virtual void TearDown()
+    {
+        bus.Stop();
+        bus.Join();
+    }
+
+    Message MakeSignal(const char* member, uint32_t val)
+    {
+        BatchTestMsg msg(bus);
+        MsgArg arg("u", val);
+        EXPECT_EQ(ER_OK, msg->Signal(TEST_PATH, TEST_INTERFACE, member, &arg, 1));
+        return Message::cast(msg);
+    }
+
+    /* A message to pack a container into that RoundTrip() can send */
+    Message NewContainer()
+    {
+        BatchTestMsg msg(bus);
+        return Message::cast(msg);
+    }
+
+    /* Send a message made by this test through the pipe and read it back as the receiving endpoint would */
+    QStatus RoundTrip(Message& msg, Message& rx)
+    {
+        BatchTestMsg out = BatchTestMsg::cast(msg);
+        QStatus status = out->Deliver(ep);
+        if (status == ER_OK) {
+            BatchTestMsg in(bus);
+            status = in->Receive(ep);
+            rx = Message::cast(in);
+        }
+        return status;
+    }
+
+    void ExpectSignal(Message& msg, const char* member, uint32_t val)
+    {
+        EXPECT_STREQ(member, msg->GetMemberName());
+        EXPECT_STREQ(TEST_INTERFACE, msg->GetInterface());
+        ASSERT_EQ(ER_OK, BatchTestMessage::UnmarshalBody(msg, "u"));
+        uint32_t got = 0;
+        EXPECT_EQ(ER_OK, msg->GetArgs("u", &got));
+        EXPECT_EQ(val, got);
+    }
+
+    BusAttachment bus;
+    Pipe stream;
+    RemoteEndpoint ep;
+};
+
+TEST_F(SignalBatcherTest, pack_unpack_round_trip) {
+    vector<Message> signals;
+    signals.push_back(MakeSignal("First", 1));
+    signals.push_back(MakeSignal("Second", 2));
+    signals.push_back(MakeSignal("Third", 3));
+
+    Message container = NewContainer();
+    ASSERT_EQ(ER_OK, SignalBatcher::Pack(bus, signals, String::Empty, 0, container));
+    EXPECT_TRUE(SignalBatcher::IsBatch(container));
+
+    Message rx(bus);
+    ASSERT_EQ(ER_OK, RoundTrip(container, rx));
+    EXPECT_TRUE(SignalBatcher::IsBatch(rx));
+    vector<Message> unpacked;
+    ASSERT_EQ(ER_OK, SignalBatcher::Unpack(rx, ep, false, unpacked));
+    ASSERT_EQ(3U, unpacked.size());
+    ExpectSignal(unpacked[0], "First", 1);
+    ExpectSignal(unpacked[1], "Second", 2);
+    ExpectSignal(unpacked[2], "Third", 3);
+}
+
+TEST_F(SignalBatcherTest, malformed_container) {
+    /* A container with the wrong body signature is rejected */
+    BatchTestMsg wrongBody(bus);
+    MsgArg str("s", "not a batch");
+    ASSERT_EQ(ER_OK, wrongBody->Signal(SignalBatcher::ObjectPath, SignalBatcher::InterfaceName, SignalBatcher::MemberName, &str, 1));
+    Message msg = Message::cast(wrongBody);
+    Message rx(bus);
+    ASSERT_EQ(ER_OK, RoundTrip(msg, rx));
+    vector<Message> unpacked;
+    EXPECT_NE(ER_OK, SignalBatcher::Unpack(rx, ep, false, unpacked));
+    EXPECT_TRUE(unpacked.empty());
+
+    /* Elements that are not marshaled messages are dropped, the rest are still delivered */
+    Message good = MakeSignal("Good", 7);
+    Pipe scratch;
+    RemoteEndpoint scratchEp(bus, false, String::Empty, &scratch);
+    ASSERT_EQ(ER_OK, BatchTestMsg::cast(good)->Deliver(scratchEp));
+    uint8_t goodBytes[1024];
+    size_t goodLen;
+    ASSERT_EQ(ER_OK, scratch.PullBytes(goodBytes, sizeof(goodBytes), goodLen));
+    BatchTestMsg garbage(bus);
+    static const uint8_t junk[] = { 'l', 4, 1, 1, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+    MsgArg elems[2];
+    elems[0].Set("ay", sizeof(junk), junk);
+    elems[1].Set("ay", goodLen, goodBytes);
+    MsgArg aay("aay", ArraySize(elems), elems);
+    ASSERT_EQ(ER_OK, garbage->Signal(SignalBatcher::ObjectPath, SignalBatcher::InterfaceName, SignalBatcher::MemberName, &aay, 1));
+    msg = Message::cast(garbage);
+    ASSERT_EQ(ER_OK, RoundTrip(msg, rx));
+    ASSERT_EQ(ER_OK, SignalBatcher::Unpack(rx, ep, false, unpacked));
+    ASSERT_EQ(1U, unpacked.size());
+    ExpectSignal(unpacked[0], "Good", 7);
+}
+
+TEST_F(SignalBatcherTest, nested_container_rejected) {
+    vector<Message> inner;
+    inner.push_back(MakeSignal("InnerOne", 1));
+    inner.push_back(MakeSignal("InnerTwo", 2));
+    Message innerContainer = NewContainer();
+    ASSERT_EQ(ER_OK, SignalBatcher::Pack(bus, inner, String::Empty, 0, innerContainer));
+
+    vector<Message> outer;
+    outer.push_back(MakeSignal("Outer", 3));
+    outer.push_back(innerContainer);
+    Message container = NewContainer();
+    ASSERT_EQ(ER_OK, SignalBatcher::Pack(bus, outer, String::Empty, 0, container));
+
+    Message rx(bus);
+    ASSERT_EQ(ER_OK, RoundTrip(container, rx));
+    vector<Message> unpacked;
+    ASSERT_EQ(ER_OK, SignalBatcher::Unpack(rx, ep, false, unpacked));
+    ASSERT_EQ(1U, unpacked.size());
+    ExpectSignal(unpacked[0], "Outer", 3);
+}
+
+TEST_F(SignalBatcherTest, non_batchable_message_flushes_batch_first) {
+    Timer timer("SignalBatcherTest");
+    ASSERT_EQ(ER_OK, timer.Start());
+    Pipe recordingStream;
+    RecordingEndpoint recorder(bus, &recordingStream);
+    RemoteEndpoint rep = RemoteEndpoint::cast(recorder);
+    rep->GetFeatures().signalBatching = true;
+
+    SignalBatcher batcher(bus, timer);
+    /* Long enough that only the method call can cause the batch to be sent */
+    batcher.SetLatencyBudget(60000, 0);
+
+    Message first = MakeSignal("First", 1);
+    Message second = MakeSignal("Second", 2);
+    EXPECT_TRUE(batcher.Add(first, rep));
+    EXPECT_TRUE(batcher.Add(second, rep));
+    EXPECT_TRUE(recorder->pushed.empty());
+
+    BatchTestMsg call(bus);
+    MsgArg arg("u", 3);
+    ASSERT_EQ(ER_OK, call->MethodCall("Call", &arg, 1));
+    Message callMsg = Message::cast(call);
+    EXPECT_FALSE(batcher.Add(callMsg, rep));
+
+    /*
+     * The batch was pushed before Add() returned, so before the caller pushes the method call.
+     * The container is built by Pack(), pack_unpack_round_trip checks the order inside it.
+     */
+    ASSERT_EQ(1U, recorder->pushed.size());
+    EXPECT_TRUE(SignalBatcher::IsBatch(recorder->pushed[0]));
+
+    /* A batch of one is sent as the signal itself, still ahead of the message that flushed it */
+    Message third = MakeSignal("Third", 3);
+    EXPECT_TRUE(batcher.Add(third, rep));
+    EXPECT_EQ(1U, recorder->pushed.size());
+    EXPECT_FALSE(batcher.Add(callMsg, rep));
+    ASSERT_EQ(2U, recorder->pushed.size());
+    EXPECT_EQ(&(*third), &(*recorder->pushed[1]));
+
+    /* Nothing is left behind for the alarm */
+    EXPECT_EQ(ER_OK, batcher.Flush());
+    EXPECT_EQ(2U, recorder->pushed.size());
+
+    timer.Stop();
+    timer.Join();
+}
@@ -0,0 +1,217 @@
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/BusObject.h>
+#include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <BusInternal.h>
+#include <LocalTransport.h>
+#include <RemoteEndpoint.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+static const char* TEST_PATH = "/org/alljoyn/test/template";
+static const char* TEST_INTERFACE = "org.alljoyn.test.Template";
+
+/*
+ * BusObject::Signal(SignalTemplate&) marshals the signal with _Message::SignalMsg() and pushes it
+ * to the router. The marshaling is what the template changes so the test drives it directly.
+ */
+class TemplateTestMessage : public _Message {
+  public:
+    TemplateTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus Emit(SignalTemplate& tmpl, const BusObject* sender, const MsgArg* args, size_t numArgs)
+    {
+        return SignalMsg(tmpl, sender, TEST_PATH, args, numArgs);
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep) { return _Message::Deliver(ep); }
+
+    QStatus Receive(RemoteEndpoint& ep)
+    {
+        QStatus status = _Message::Read(ep, false);
+        if (status == ER_OK) {
+            status = _Message::Unmarshal(ep, false);
+        }
+        if (status == ER_OK) {
+            status = _Message::UnmarshalArgs("*");
+        }
+        return status;
+    }
+};
+
+class TemplateTestObject : public BusObject {
+  public:
+    TemplateTestObject() : BusObject(TEST_PATH) { }
+};
+
+class SignalTemplateTest : public testing::Test {
+  public:
+    SignalTemplateTest() : bus("SignalTemplateTest", false), ep(bus, false, String::Empty, &stream), tick(NULL) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, bus.Start());
+        InterfaceDescription* iface = NULL;
+        ASSERT_EQ(ER_OK, bus.CreateInterface(TEST_INTERFACE, iface));
+        ASSERT_EQ(ER_OK, iface->AddSignal("Tick", "u", "value"));
+        iface->Activate();
+        tick = iface->GetMember("Tick");
+        ASSERT_TRUE(tick != NULL);
+    }
+
+    virtual void TearDown()
+    {
+        _Message::SetEndianess(0);
+        bus.Stop();
+        bus.Join();
+    }
+
+    /* Emit value through the template, send it through the pipe and read it back */
+    QStatus EmitAndReceive(SignalTemplate& tmpl, const BusObject& sender, uint32_t value, ManagedObj<TemplateTestMessage>& rx, char& wireEndian)
+    {
+        ManagedObj<TemplateTestMessage> tx(bus);
+        MsgArg arg("u", value);
+        QStatus status = tx->Emit(tmpl, &sender, &arg, 1);
+        if (status == ER_OK) {
+            status = tx->Deliver(ep);
+        }
+        /* Peek at the endianess byte of the marshaled message then put the bytes back */
+        uint8_t buf[512];
+        size_t len = 0;
+        if (status == ER_OK) {
+            status = stream.PullBytes(buf, sizeof(buf), len);
+        }
+        if (status == ER_OK) {
+            wireEndian = static_cast<char>(buf[0]);
+            size_t pushed;
+            status = stream.PushBytes(buf, len, pushed);
+        }
+        if (status == ER_OK) {
+            status = rx->Receive(ep);
+        }
+        return status;
+    }
+
+    void ExpectTick(ManagedObj<TemplateTestMessage>& rx, uint32_t value, const qcc::String& sender)
+    {
+        EXPECT_STREQ("Tick", rx->GetMemberName());
+        EXPECT_STREQ(TEST_INTERFACE, rx->GetInterface());
+        EXPECT_STREQ(TEST_PATH, rx->GetObjectPath());
+        EXPECT_STREQ(sender.c_str(), rx->GetSender());
+        uint32_t got = 0;
+        EXPECT_EQ(ER_OK, rx->GetArgs("u", &got));
+        EXPECT_EQ(value, got);
+    }
+
+    BusAttachment bus;
+    Pipe stream;
+    RemoteEndpoint ep;
+    const InterfaceDescription::Member* tick;
+};
+
+TEST_F(SignalTemplateTest, repeated_emits) {
+    TemplateTestObject obj;
+    SignalTemplate tmpl(*tick);
+    qcc::String sender = bus.GetInternal().GetLocalEndpoint()->GetUniqueName();
+
+    /* The first emit marshals the header, the others reuse it */
+    uint32_t lastSerial = 0;
+    for (uint32_t i = 1; i <= 4; ++i) {
+        ManagedObj<TemplateTestMessage> rx(bus);
+        char endian = 0;
+        ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, i * 1000, rx, endian));
+        ExpectTick(rx, i * 1000, sender);
+        if (i > 1) {
+            EXPECT_GT(rx->GetCallSerial(), lastSerial);
+        }
+        lastSerial = rx->GetCallSerial();
+    }
+}
+
+TEST_F(SignalTemplateTest, header_rebuilt_for_new_unique_name) {
+    TemplateTestObject obj;
+    SignalTemplate tmpl(*tick);
+    LocalEndpoint& local = bus.GetInternal().GetLocalEndpoint();
+    qcc::String original = local->GetUniqueName();
+
+    ManagedObj<TemplateTestMessage> rx(bus);
+    char endian = 0;
+    ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 1, rx, endian));
+    ExpectTick(rx, 1, original);
+
+    /* As after reconnecting to a different daemon */
+    local->SetUniqueName(":template.2");
+    ManagedObj<TemplateTestMessage> renamed(bus);
+    ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 2, renamed, endian));
+    ExpectTick(renamed, 2, ":template.2");
+
+    ManagedObj<TemplateTestMessage> again(bus);
+    ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 3, again, endian));
+    ExpectTick(again, 3, ":template.2");
+
+    local->SetUniqueName(original);
+}
+
+TEST_F(SignalTemplateTest, header_rebuilt_for_new_endianess) {
+    TemplateTestObject obj;
+    SignalTemplate tmpl(*tick);
+    qcc::String sender = bus.GetInternal().GetLocalEndpoint()->GetUniqueName();
+#if (QCC_TARGET_ENDIAN == QCC_LITTLE_ENDIAN)
+    const char native = ALLJOYN_LITTLE_ENDIAN;
+    const char other = ALLJOYN_BIG_ENDIAN;
+#else
+    const char native = ALLJOYN_BIG_ENDIAN;
+    const char other = ALLJOYN_LITTLE_ENDIAN;
+#endif
+
+    ManagedObj<TemplateTestMessage> rx(bus);
+    char endian = 0;
+    ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 0x01020304, rx, endian));
+    EXPECT_EQ(native, endian);
+    ExpectTick(rx, 0x01020304, sender);
+
+    /* A stale header would announce the old endianess for a body marshaled in the new one */
+    _Message::SetEndianess(other);
+    for (uint32_t i = 0; i < 2; ++i) {
+        ManagedObj<TemplateTestMessage> swapped(bus);
+        ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 0x0A0B0C0D + i, swapped, endian));
+        EXPECT_EQ(other, endian);
+        ExpectTick(swapped, 0x0A0B0C0D + i, sender);
+    }
+
+    _Message::SetEndianess(native);
+    ManagedObj<TemplateTestMessage> back(bus);
+    ASSERT_EQ(ER_OK, EmitAndReceive(tmpl, obj, 7, back, endian));
+    EXPECT_EQ(native, endian);
+    ExpectTick(back, 7, sender);
+}
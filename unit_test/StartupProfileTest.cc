@@ -0,0 +1,71 @@
+/**
+ * @file
+ *
+ * This file tests the bus attachment startup phase timings
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+
+#include "LatencyHistogram.h"
+#include "StartupProfile.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(StartupProfileTest, records_each_phase) {
+    StartupProfile profile;
+    for (int p = 0; p < StartupProfile::NUM_PHASES; ++p) {
+        EXPECT_EQ(0U, profile.Get(static_cast<StartupProfile::Phase>(p)));
+    }
+    EXPECT_EQ(0U, profile.GetTotal());
+
+    uint64_t now = GetLatencyClock();
+    profile.Record(StartupProfile::CONNECT, now - 2500);
+    profile.Record(StartupProfile::INTERFACES, now);
+    EXPECT_GE(profile.Get(StartupProfile::CONNECT), 2500U);
+    /* A phase that took no measurable time is still distinguishable from one that never ran */
+    EXPECT_GE(profile.Get(StartupProfile::INTERFACES), 1U);
+    EXPECT_EQ(0U, profile.Get(StartupProfile::TRANSPORTS));
+    EXPECT_EQ(profile.Get(StartupProfile::CONNECT) + profile.Get(StartupProfile::INTERFACES), profile.GetTotal());
+
+    qcc::String str = profile.ToString();
+    EXPECT_NE(qcc::String::npos, str.find("connect="));
+    EXPECT_NE(qcc::String::npos, str.find("total="));
+
+    profile.Reset();
+    EXPECT_EQ(0U, profile.GetTotal());
+}
+
+TEST(StartupProfileTest, first_method_call_recorded_once) {
+    StartupProfile profile;
+    EXPECT_EQ(0U, profile.GetFirstMethodCall());
+
+    uint64_t now = GetLatencyClock();
+    profile.RecordFirstMethodCall(now - 4000);
+    uint32_t first = profile.GetFirstMethodCall();
+    EXPECT_GE(first, 4000U);
+    profile.RecordFirstMethodCall(now - 9000);
+    EXPECT_EQ(first, profile.GetFirstMethodCall());
+    /* Not a phase so not part of the total */
+    EXPECT_EQ(0U, profile.GetTotal());
+    EXPECT_NE(qcc::String::npos, profile.ToString().find("first_method_call="));
+}
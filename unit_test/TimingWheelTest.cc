@@ -0,0 +1,92 @@
+/**
+ * @file
+ *
+ * This file tests the hashed timing wheel used for reply timeouts
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include "TimingWheel.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(TimingWheelTest, expires_in_order_and_never_early) {
+    TimingWheel wheel(1000, 10, 16);
+    TimingWheel::Entry a, b, c;
+    std::vector<TimingWheel::Entry*> expired;
+
+    wheel.Insert(a, 1025);
+    wheel.Insert(b, 1050);
+    wheel.Insert(c, 1000 + 10 * 16 * 3);  /* Three revolutions out */
+    EXPECT_EQ(3U, wheel.Size());
+
+    uint64_t when = 0;
+    ASSERT_TRUE(wheel.NextExpiry(when));
+    EXPECT_LE(when, 1030U);
+    EXPECT_GE(when, 1025U);
+
+    EXPECT_EQ(0U, wheel.Advance(1024, expired));
+    EXPECT_EQ(1U, wheel.Advance(1030, expired));
+    ASSERT_EQ(1U, expired.size());
+    EXPECT_EQ(&a, expired[0]);
+    EXPECT_FALSE(a.IsScheduled());
+
+    /* c shares slots with nearer ticks but must not expire until its own revolution */
+    expired.clear();
+    EXPECT_EQ(1U, wheel.Advance(1200, expired));
+    EXPECT_EQ(&b, expired[0]);
+    EXPECT_TRUE(c.IsScheduled());
+
+    expired.clear();
+    EXPECT_EQ(1U, wheel.Advance(1480, expired));
+    EXPECT_EQ(&c, expired[0]);
+    EXPECT_EQ(0U, wheel.Size());
+    EXPECT_FALSE(wheel.NextExpiry(when));
+}
+
+TEST(TimingWheelTest, remove_and_reinsert) {
+    TimingWheel wheel(0, 10, 8);
+    TimingWheel::Entry a, b;
+    std::vector<TimingWheel::Entry*> expired;
+
+    wheel.Insert(a, 100);
+    wheel.Insert(b, 100);
+    EXPECT_TRUE(wheel.Remove(a));
+    EXPECT_FALSE(wheel.Remove(a));
+    EXPECT_EQ(1U, wheel.Size());
+
+    /* Reinserting with a deadline in the past expires on the next advance */
+    EXPECT_EQ(1U, wheel.Advance(200, expired));
+    wheel.Insert(a, a.GetDeadline());
+    EXPECT_EQ(100U, a.GetDeadline());
+    expired.clear();
+    EXPECT_EQ(1U, wheel.Advance(210, expired));
+    EXPECT_EQ(&a, expired[0]);
+
+    wheel.Insert(a, 500);
+    wheel.Insert(b, 5000);
+    expired.clear();
+    wheel.RemoveAll(expired);
+    EXPECT_EQ(2U, expired.size());
+    EXPECT_EQ(0U, wheel.Size());
+}
@@ -0,0 +1,77 @@
+/**
+ * @file
+ *
+ * This file tests the per-endpoint cache of validated header names and signatures
+ */
+
+/******************************************************************************
+ * Copyright 2013, Qualcomm Innovation Center, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ValidationCache.h"
+
+#include <gtest/gtest.h>
+
+using namespace ajn;
+
+TEST(ValidationCacheTest, lookup_after_insert) {
+    ValidationCache cache;
+    uint32_t info = 0;
+    const char* sig = "a{sv}";
+    EXPECT_FALSE(cache.Lookup(8, sig, strlen(sig), info));
+    cache.Insert(8, sig, strlen(sig), 1);
+    EXPECT_TRUE(cache.Lookup(8, sig, strlen(sig), info));
+    EXPECT_EQ(1U, info);
+}
+
+TEST(ValidationCacheTest, kind_and_value_must_match) {
+    ValidationCache cache;
+    uint32_t info;
+    cache.Insert(1, "/org/alljoyn", 12, 0);
+    /* Same value for a different header field */
+    EXPECT_FALSE(cache.Lookup(2, "/org/alljoyn", 12, info));
+    /* Prefix and extension of the cached value */
+    EXPECT_FALSE(cache.Lookup(1, "/org/alljoy", 11, info));
+    EXPECT_FALSE(cache.Lookup(1, "/org/alljoyn/Bus", 16, info));
+    EXPECT_TRUE(cache.Lookup(1, "/org/alljoyn", 12, info));
+}
+
+TEST(ValidationCacheTest, clear_forgets_everything) {
+    ValidationCache cache;
+    uint32_t info;
+    char name[32];
+    for (int i = 0; i < 200; ++i) {
+        snprintf(name, sizeof(name), "member%d", i);
+        cache.Insert(3, name, strlen(name), i);
+    }
+    /* The most recent insert is always found */
+    EXPECT_TRUE(cache.Lookup(3, name, strlen(name), info));
+    EXPECT_EQ(199U, info);
+    cache.Clear();
+    EXPECT_FALSE(cache.Lookup(3, name, strlen(name), info));
+}
+
+TEST(ValidationCacheTest, pedantic_flag) {
+    EXPECT_FALSE(ValidationCache::IsPedantic());
+    ValidationCache::SetPedantic(true);
+    EXPECT_TRUE(ValidationCache::IsPedantic());
+    ValidationCache::SetPedantic(false);
+    EXPECT_FALSE(ValidationCache::IsPedantic());
+}
@@ -15,7 +15,14 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 
+#include <vector>
+
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
 #include <alljoyn/MsgArg.h>
+#include <alljoyn/MsgArgs.h>
+#include <alljoyn/MsgArgDictionary.h>
 #include <alljoyn/Status.h>
 /* Header files included for Google Test Framework */
 #include <gtest/gtest.h>
@@ -435,3 +442,195 @@ TEST(MsgArgTest, InvalidValues)
     status = arg.Set("g", "a{si)"); //dictionaries must end in '}'
     ASSERT_EQ(ER_BUS_BAD_SIGNATURE, status) << "  Actual Status: " << QCC_StatusText(status);
 }
+
+TEST(MsgArgTest, Swap)
+{
+    const char* str = "swapped string";
+    MsgArg a("(si)", str, 42);
+    a.Stabilize();
+    MsgArg b("u", 7);
+
+    /* The nested members move with the swap, nothing is copied */
+    const MsgArg* members = a.v_struct.members;
+    a.Swap(b);
+    ASSERT_EQ(ALLJOYN_UINT32, a.typeId);
+    ASSERT_EQ(7U, a.v_uint32);
+    ASSERT_EQ(ALLJOYN_STRUCT, b.typeId);
+    ASSERT_EQ(members, b.v_struct.members);
+
+    char* s;
+    int32_t i;
+    QStatus status = b.Get("(si)", &s, &i);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_STREQ(str, s);
+    ASSERT_NE(str, s);
+    ASSERT_EQ(42, i);
+}
+
+#if defined(ALLJOYN_HAS_MOVE_SEMANTICS)
+TEST(MsgArgTest, Move)
+{
+    std::vector<MsgArg> args;
+    MsgArg arg("(su)", "moved", 1);
+    arg.Stabilize();
+    const MsgArg* members = arg.v_struct.members;
+    args.push_back(std::move(arg));
+    ASSERT_EQ(ALLJOYN_INVALID, arg.typeId);
+    ASSERT_EQ(members, args[0].v_struct.members);
+
+    /* A moved arg is as stable as a copy, referenced data it did not own is copied */
+    char buf[] = "temporary";
+    MsgArg ref("s", buf);
+    MsgArg moved(std::move(ref));
+    buf[0] = 'T';
+    ASSERT_STREQ("temporary", moved.v_string.str);
+}
+#endif
+
+TEST(MsgArgTest, TypedPack)
+{
+    qcc::String sig = MsgArgs::Signature<int32_t, qcc::String, std::vector<double> >();
+    ASSERT_STREQ("isad", sig.c_str());
+    sig = MsgArgs::Signature<std::vector<std::vector<qcc::String> >, std::vector<bool> >();
+    ASSERT_STREQ("aasab", sig.c_str());
+
+    std::vector<double> d;
+    d.push_back(1.5);
+    d.push_back(-2.25);
+    std::vector<qcc::String> as;
+    as.push_back("one");
+    as.push_back("two");
+
+    MsgArg args[4];
+    size_t numArgs = ArraySize(args);
+    QStatus status = MsgArgs::Pack(args, numArgs, int32_t(-7), qcc::String("hello"), d, as);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_EQ(4U, numArgs);
+    ASSERT_STREQ("isadas", MsgArg::Signature(args, numArgs).c_str());
+
+    /* The packed args are the same as the ones built from a signature */
+    const char* strs[] = { "one", "two" };
+    MsgArg expect[4];
+    size_t numExpect = ArraySize(expect);
+    status = MsgArg::Set(expect, numExpect, "isadas", -7, "hello", d.size(), &d[0], ArraySize(strs), strs);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    for (size_t i = 0; i < numArgs; ++i) {
+        ASSERT_TRUE(args[i] == expect[i]);
+    }
+
+    /* Scalar arrays reference the vector rather than copying it */
+    ASSERT_EQ(&d[0], args[2].v_scalarArray.v_double);
+
+    int32_t i;
+    qcc::String str;
+    std::vector<double> dOut;
+    std::vector<qcc::String> asOut;
+    status = MsgArgs::Unpack(expect, numExpect, i, str, dOut, asOut);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_EQ(-7, i);
+    ASSERT_STREQ("hello", str.c_str());
+    ASSERT_TRUE(dOut == d);
+    ASSERT_EQ(2U, asOut.size());
+    ASSERT_STREQ("two", asOut[1].c_str());
+
+    /* Too few args to pack into */
+    numArgs = 2;
+    status = MsgArgs::Pack(args, numArgs, int32_t(1), int32_t(2), int32_t(3));
+    ASSERT_EQ(ER_BUS_TRUNCATED, status) << "  Actual Status: " << QCC_StatusText(status);
+}
+
+TEST(MsgArgTest, TypedUnpackMismatch)
+{
+    MsgArg arg("u", 42);
+    int32_t i;
+    uint32_t u;
+    QStatus status = MsgArgs::Unpack(arg, i);
+    ASSERT_EQ(ER_BUS_SIGNATURE_MISMATCH, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = MsgArgs::Unpack(arg, u);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_EQ(42U, u);
+
+    /* Empty arrays are checked against the element signature */
+    MsgArg empty("as", 0, NULL);
+    std::vector<std::vector<int32_t> > aai;
+    status = MsgArgs::Unpack(empty, aai);
+    ASSERT_EQ(ER_BUS_SIGNATURE_MISMATCH, status) << "  Actual Status: " << QCC_StatusText(status);
+    std::vector<std::string> strs;
+    status = MsgArgs::Unpack(empty, strs);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(strs.empty());
+
+    /* Booleans round trip through a copied array */
+    std::vector<bool> b(3, true);
+    b[1] = false;
+    status = MsgArgs::Pack(arg, b);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    std::vector<bool> bOut;
+    status = MsgArgs::Unpack(arg, bOut);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(bOut == b);
+}
+
+TEST(MsgArgTest, DictionaryView)
+{
+    const size_t numEntries = 200;
+    std::vector<qcc::String> names(numEntries);
+    MsgArg* entries = new MsgArg[numEntries];
+    for (size_t i = 0; i < numEntries; ++i) {
+        names[i] = "key" + qcc::U32ToString(static_cast<uint32_t>(i));
+        entries[i].Set("{sv}", names[i].c_str(), new MsgArg("u", static_cast<uint32_t>(i)));
+    }
+    MsgArg dict(ALLJOYN_ARRAY);
+    QStatus status = dict.v_array.SetElements("{sv}", numEntries, entries);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    dict.SetOwnershipFlags(MsgArg::OwnsArgs, true);
+
+    MsgArgDictionary view(dict);
+    ASSERT_EQ(ER_OK, view.GetStatus()) << "  Actual Status: " << QCC_StatusText(view.GetStatus());
+    ASSERT_EQ(numEntries, view.Size());
+    for (size_t i = 0; i < numEntries; ++i) {
+        uint32_t val = 0;
+        status = view.Get(names[i].c_str(), val);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        ASSERT_EQ(i, val);
+        /* The value inside the variant is returned, not a copy */
+        const MsgArg* v = view.Find(names[i].c_str());
+        ASSERT_TRUE(v != NULL);
+        ASSERT_EQ(entries[i].v_dictEntry.val->v_variant.val, v);
+    }
+    uint32_t val;
+    status = view.Get("key200", val);
+    ASSERT_EQ(ER_BUS_ELEMENT_NOT_FOUND, status) << "  Actual Status: " << QCC_StatusText(status);
+    qcc::String str;
+    status = view.Get("key7", str);
+    ASSERT_EQ(ER_BUS_SIGNATURE_MISMATCH, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(view.FindInteger(7) == NULL);
+
+    /* Integer keys, signed ones sign extended */
+    MsgArg* intEntries = new MsgArg[3];
+    intEntries[0].Set("{is}", -1, "minus one");
+    intEntries[1].Set("{is}", 0, "zero");
+    intEntries[2].Set("{is}", 1 << 20, "big");
+    MsgArg intDict(ALLJOYN_ARRAY);
+    status = intDict.v_array.SetElements("{is}", 3, intEntries);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    intDict.SetOwnershipFlags(MsgArg::OwnsArgs);
+
+    MsgArgDictionary intView(intDict);
+    const char* s = NULL;
+    status = intView.GetInteger(-1, s);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_STREQ("minus one", s);
+    status = intView.GetInteger(1 << 20, s);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_STREQ("big", s);
+    status = intView.GetInteger(2, s);
+    ASSERT_EQ(ER_BUS_ELEMENT_NOT_FOUND, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(intView.Find("zero") == NULL);
+
+    MsgArg notDict("u", 5);
+    MsgArgDictionary notView(notDict);
+    ASSERT_EQ(ER_BUS_NOT_A_DICTIONARY, notView.GetStatus());
+    status = notView.Get("key0", val);
+    ASSERT_EQ(ER_BUS_NOT_A_DICTIONARY, status) << "  Actual Status: " << QCC_StatusText(status);
+}